@@ -23,6 +23,7 @@
  ****************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 #include <audioutils/fmsynth.h>
 
 /****************************************************************************
@@ -93,6 +94,132 @@ static int sound_modulate(FAR fmsynth_sound_t *snd)
   return out * snd->volume / FMSYNTH_MAX_VOLUME;
 }
 
+/****************************************************************************
+ * name: sound_blockable
+ ****************************************************************************/
+
+static int sound_blockable(FAR fmsynth_sound_t *snd)
+{
+  FAR fmsynth_op_t *op;
+
+  for (; snd != NULL; snd = snd->next_sound)
+    {
+      for (op = snd->operators; op != NULL; op = op->parallelop)
+        {
+          if (!fmsynthop_blockable(op))
+            {
+              return 0;
+            }
+        }
+    }
+
+  return 1;
+}
+
+/****************************************************************************
+ * name: sound_modulate_block
+ *
+ * Description:
+ *   Same as n calls of sound_modulate(), adding the samples to out.
+ *
+ ****************************************************************************/
+
+static void sound_modulate_block(FAR fmsynth_sound_t *snd, FAR int *out,
+                                 int n)
+{
+  int buf[FMSYNTH_BLOCKSIZE];
+  int sum[FMSYNTH_BLOCKSIZE];
+  FAR fmsynth_op_t *op;
+  int reset = -1;
+  int i;
+
+  if (snd->operators == NULL)
+    {
+      return;
+    }
+
+  /* The phase restarts when phase_time wraps, at most once in a block */
+
+  if (snd->phase_time == 0)
+    {
+      reset = 0;
+    }
+  else if (max_phase_time - snd->phase_time < n)
+    {
+      reset = max_phase_time - snd->phase_time;
+    }
+
+  fetch_feedback(snd->operators);
+
+  memset(sum, 0, n * sizeof(int));
+  for (op = snd->operators; op != NULL; op = op->parallelop)
+    {
+      fmsynthop_operate_block(op, reset, buf, n);
+      for (i = 0; i < n; i++)
+        {
+          sum[i] += buf[i];
+        }
+    }
+
+  snd->phase_time += n;
+  if (snd->phase_time >= max_phase_time)
+    {
+      snd->phase_time -= max_phase_time;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      out[i] += sum[i] * snd->volume / FMSYNTH_MAX_VOLUME;
+    }
+}
+
+/****************************************************************************
+ * name: rendering_block
+ *
+ * Description:
+ *   Render the frames FMSYNTH_BLOCKSIZE at a time, each operator running
+ *   over a whole block so that the calls and the recursion through the
+ *   sub operators are paid once per block instead of once per sample.
+ *
+ ****************************************************************************/
+
+static int rendering_block(FAR fmsynth_sound_t *snd,
+                           FAR int16_t *sample, int sample_num, int chnum)
+{
+  int out[FMSYNTH_BLOCKSIZE];
+  int nframes = sample_num / chnum;
+  FAR fmsynth_sound_t *itr;
+  int frame;
+  int n;
+  int i;
+  int ch;
+
+  for (frame = 0; frame < nframes; frame += n)
+    {
+      n = nframes - frame;
+      if (n > FMSYNTH_BLOCKSIZE)
+        {
+          n = FMSYNTH_BLOCKSIZE;
+        }
+
+      memset(out, 0, n * sizeof(int));
+      for (itr = snd; itr != NULL; itr = itr->next_sound)
+        {
+          sound_modulate_block(itr, out, n);
+        }
+
+      for (i = 0; i < n; i++)
+        {
+          for (ch = 0; ch < chnum; ch++)
+            {
+              *sample++ = (int16_t)out[i];
+            }
+        }
+    }
+
+  return nframes * chnum * sizeof(int16_t);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -238,6 +365,13 @@ int fmsynth_rendering(FAR fmsynth_sound_t *snd,
   int out;
   FAR fmsynth_sound_t *itr;
 
+  /* A tick callback may change the sounds between two frames */
+
+  if (cb == NULL && sound_blockable(snd))
+    {
+      return rendering_block(snd, sample, sample_num, chnum);
+    }
+
   for (i = 0; i < sample_num; i += chnum)
     {
       out = 0;
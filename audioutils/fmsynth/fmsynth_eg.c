@@ -205,3 +205,81 @@ int fmsyntheg_operate(FAR fmsynth_eg_t *eg)
 
   return val;
 }
+
+/****************************************************************************
+ * name: fmsyntheg_operate_block
+ *
+ * Description:
+ *   Same as n calls of fmsyntheg_operate().  Within a state, the level
+ *   diff2next * counter / period is stepped with its quotient and
+ *   remainder instead of a division per sample.
+ *
+ ****************************************************************************/
+
+void fmsyntheg_operate_block(FAR fmsynth_eg_t *eg, FAR int *out, int n)
+{
+  FAR fmsynth_egparam_t *param;
+  int run;
+  int num;
+  int q;
+  int r;
+  int dq;
+  int dr;
+  int i = 0;
+  int j;
+
+  while (i < n)
+    {
+      param = &eg->state_params[eg->state];
+
+      if (eg->state == EGSTATE_RELEASED)
+        {
+          for (; i < n; i++)
+            {
+              out[i] = param->initval;
+            }
+
+          break;
+        }
+
+      if (eg->state_counter >= param->period)
+        {
+          /* The first sample of the next state */
+
+          out[i++] = fmsyntheg_operate(eg);
+          continue;
+        }
+
+      run = param->period - eg->state_counter;
+      if (run > n - i)
+        {
+          run = n - i;
+        }
+
+      num = param->diff2next * eg->state_counter;
+      q   = num / param->period;
+      r   = num % param->period;
+      dq  = param->diff2next / param->period;
+      dr  = param->diff2next % param->period;
+
+      for (j = 0; j < run; j++)
+        {
+          out[i++] = param->initval + q;
+
+          q += dq;
+          r += dr;
+          if (r >= param->period)
+            {
+              r -= param->period;
+              q++;
+            }
+          else if (r <= -param->period)
+            {
+              r += param->period;
+              q--;
+            }
+        }
+
+      eg->state_counter += run;
+    }
+}
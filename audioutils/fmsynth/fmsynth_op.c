@@ -22,7 +22,9 @@
  * Included Files
  ****************************************************************************/
 
+#include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <audioutils/fmsynth_op.h>
 
 /****************************************************************************
@@ -212,6 +214,40 @@ static int square_wave(int theta)
   return theta < FMSYNTH_PI ? SHRT_MAX : -SHRT_MAX;
 }
 
+/****************************************************************************
+ * name: wave_block
+ *
+ * Description:
+ *   Advance the phase of an operator over a block and apply its waveform,
+ *   modulated by mod.  Called with a constant wavegen, it is inlined so
+ *   that the loop has no indirect call.  The phase accumulation is a
+ *   dependency chain: it is kept in the same loop as the waveform so that
+ *   both overlap.
+ *
+ ****************************************************************************/
+
+static inline void wave_block(opfunc_t wavegen, FAR fmsynth_op_t *op,
+                              int reset, FAR const int *mod,
+                              FAR int *out, int n)
+{
+  float current = op->current_phase;
+  int fb = op->feedback_val;
+  int val;
+  int i;
+
+  for (i = 0; i < n; i++)
+    {
+      current = i == reset ? 0.f : current + op->delta_phase;
+      val     = (int)current;
+      current = current - (float)((val / (2 * FMSYNTH_PI))
+                                  * (2 * FMSYNTH_PI));
+
+      out[i] = out[i] * wavegen(val + fb + mod[i]) / FMSYNTH_MAX_EGLEVEL;
+    }
+
+  op->current_phase = current;
+}
+
 /****************************************************************************
  * name: update_parameters
  ****************************************************************************/
@@ -544,3 +580,126 @@ int fmsynthop_operate(FAR fmsynth_op_t *op, int phase_time)
 
   return op->last_sigval;
 }
+
+/****************************************************************************
+ * name: fmsynthop_blockable
+ *
+ * Description:
+ *   Whether the operator and its sub operators can be rendered by
+ *   fmsynthop_operate_block(): a feedback must come from the operator
+ *   itself, the previous sample of another one is not known in a block.
+ *
+ ****************************************************************************/
+
+int fmsynthop_blockable(FAR fmsynth_op_t *op)
+{
+  FAR fmsynth_op_t *tmp;
+
+  if (op->feedback_ref && op->feedback_ref != &op->last_sigval)
+    {
+      return 0;
+    }
+
+  for (tmp = op->cascadeop; tmp != NULL; tmp = tmp->parallelop)
+    {
+      if (!fmsynthop_blockable(tmp))
+        {
+          return 0;
+        }
+    }
+
+  return 1;
+}
+
+/****************************************************************************
+ * name: fmsynthop_operate_block
+ *
+ * Description:
+ *   Same as n calls of fmsynthop_operate(), one stage at a time over the
+ *   block: the phases, the modulation by the sub operators, the envelope
+ *   and the waveform.  The phase restarts from 0 at sample reset, -1 for
+ *   none.  The feedback of the first sample must have been fetched with
+ *   fmsynthop_update_feedback().
+ *
+ ****************************************************************************/
+
+void fmsynthop_operate_block(FAR fmsynth_op_t *op, int reset,
+                             FAR int *out, int n)
+{
+  int mod[FMSYNTH_BLOCKSIZE];
+  int sub[FMSYNTH_BLOCKSIZE];
+  FAR fmsynth_op_t *subop;
+  float current;
+  int val;
+  int fb;
+  int i;
+
+  assert(n > 0 && n <= FMSYNTH_BLOCKSIZE);
+
+  subop = op->cascadeop;
+  if (subop == NULL)
+    {
+      memset(mod, 0, n * sizeof(int));
+    }
+  else
+    {
+      fmsynthop_operate_block(subop, reset, mod, n);
+      for (subop = subop->parallelop; subop; subop = subop->parallelop)
+        {
+          fmsynthop_operate_block(subop, reset, sub, n);
+          for (i = 0; i < n; i++)
+            {
+              mod[i] += sub[i];
+            }
+        }
+    }
+
+  fmsyntheg_operate_block(op->eg, out, n);
+
+  if (op->feedback_ref)
+    {
+      /* The feedback of each sample depends on the previous one */
+
+      current = op->current_phase;
+      fb      = op->feedback_val;
+      for (i = 0; i < n; i++)
+        {
+          current = i == reset ? 0.f : current + op->delta_phase;
+          val     = (int)current;
+          current = current - (float)((val / (2 * FMSYNTH_PI))
+                                      * (2 * FMSYNTH_PI));
+
+          out[i] = out[i] * op->wavegen(val + fb + mod[i])
+                 / FMSYNTH_MAX_EGLEVEL;
+          if (i < n - 1)
+            {
+              fb = out[i] * op->feedbackrate / FMSYNTH_MAX_EGLEVEL;
+            }
+        }
+
+      op->current_phase = current;
+      op->feedback_val  = fb;
+    }
+  else if (op->wavegen == pseudo_sin256)
+    {
+      wave_block(pseudo_sin256, op, reset, mod, out, n);
+    }
+  else if (op->wavegen == triangle_wave)
+    {
+      wave_block(triangle_wave, op, reset, mod, out, n);
+    }
+  else if (op->wavegen == sawtooth_wave)
+    {
+      wave_block(sawtooth_wave, op, reset, mod, out, n);
+    }
+  else if (op->wavegen == square_wave)
+    {
+      wave_block(square_wave, op, reset, mod, out, n);
+    }
+  else
+    {
+      wave_block(op->wavegen, op, reset, mod, out, n);
+    }
+
+  op->last_sigval = out[n - 1];
+}
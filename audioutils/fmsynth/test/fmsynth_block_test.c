@@ -0,0 +1,151 @@
+/****************************************************************************
+ * apps/audioutils/fmsynth/test/fmsynth_block_test.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <audioutils/fmsynth_eg.h>
+#include <audioutils/fmsynth_op.h>
+#include <audioutils/fmsynth.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* A low rate, so that the phase time wraps during the test */
+
+#define FS (800)
+#define CHNUM (2)
+#define TEST_LENGTH (FS * 25 * CHNUM + 7)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static int16_t g_sample[TEST_LENGTH];
+static int16_t g_block[TEST_LENGTH];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * name: tick
+ ****************************************************************************/
+
+static void tick(unsigned long arg)
+{
+}
+
+/****************************************************************************
+ * name: render
+ *
+ * Description:
+ *   Render a sound made of a modulated carrier with a self feedback
+ *   modulator, and a second sound mixing two waveforms.
+ *
+ ****************************************************************************/
+
+static int render(FAR int16_t *out, fmsynth_tickcb_t cb)
+{
+  fmsynth_eglevels_t levels =
+    {
+      { 1.f, 50 }, { 0.7f, 100 }, { 0.5f, 200 }, { 0.5f, 0 }, { 0.f, 300 }
+    };
+
+  fmsynth_sound_t *snd1;
+  fmsynth_sound_t *snd2;
+  fmsynth_op_t *ops[5];
+  int ret;
+  int i;
+
+  fmsynth_initialize(FS);
+
+  for (i = 0; i < 5; i++)
+    {
+      ops[i] = fmsynthop_create();
+      fmsynthop_set_envelope(ops[i], &levels);
+      fmsynthop_select_opfunc(ops[i], i % FMSYNTH_OPFUNC_NUM);
+    }
+
+  fmsynthop_select_opfunc(ops[1], FMSYNTH_OPFUNC_SIN);
+  fmsynthop_bind_feedback(ops[1], ops[1], 0.6f);
+  fmsynthop_cascade_subop(ops[0], ops[1]);
+  fmsynthop_parallel_subop(ops[1], ops[2]);
+  fmsynthop_set_soundfreqrate(ops[2], 2.f);
+  fmsynthop_parallel_subop(ops[3], ops[4]);
+
+  snd1 = fmsynthsnd_create();
+  snd2 = fmsynthsnd_create();
+  fmsynthsnd_set_operator(snd1, ops[0]);
+  fmsynthsnd_set_operator(snd2, ops[3]);
+  fmsynthsnd_set_volume(snd2, 0.5f);
+  fmsynthsnd_add_subsound(snd1, snd2);
+  fmsynthsnd_set_soundfreq(snd1, 110.f);
+  fmsynthsnd_set_soundfreq(snd2, 165.f);
+
+  ret = fmsynth_rendering(snd1, out, TEST_LENGTH / 2, CHNUM, cb, 0);
+  fmsynthsnd_stop(snd1);
+  ret += fmsynth_rendering(snd1, out + ret / sizeof(int16_t),
+                           TEST_LENGTH / 2, CHNUM, cb, 0);
+
+  for (i = 0; i < 5; i++)
+    {
+      fmsynthop_delete(ops[i]);
+    }
+
+  fmsynthsnd_delete(snd1);
+  fmsynthsnd_delete(snd2);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * name: main
+ ****************************************************************************/
+
+int main(void)
+{
+  int len1;
+  int len2;
+
+  /* A tick callback forces the rendering one sample at a time */
+
+  len1 = render(g_sample, tick);
+  len2 = render(g_block, NULL);
+
+  if (len1 != len2 || memcmp(g_sample, g_block, len1) != 0)
+    {
+      printf("NG: block rendering differs (%d/%d bytes)\n", len1, len2);
+      return 1;
+    }
+
+  printf("OK: %d bytes\n", len1);
+  return 0;
+}
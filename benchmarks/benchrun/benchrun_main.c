@@ -0,0 +1,1070 @@
+/****************************************************************************
+ * apps/benchmarks/benchrun/benchrun_main.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/utsname.h>
+#include <sys/wait.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_TCP)
+#  include <sys/socket.h>
+#  include <netinet/in.h>
+#  include <arpa/inet.h>
+#  define BENCHRUN_STREAM 1
+#endif
+
+#include "builtin/builtin.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCHRUN_MAXARGS     16
+#define BENCHRUN_MAXSINKS    3
+#define BENCHRUN_LINELEN     256
+#define BENCHRUN_NAMELEN     64
+#define BENCHRUN_UNITLEN     16
+
+/* The first 16 hex digits of the SHA-256 of the .config, from the build */
+
+#ifndef BENCHRUN_CONFIG_HASH
+#  define BENCHRUN_CONFIG_HASH "unknown"
+#endif
+
+#ifdef CONFIG_ARCH_BOARD_CUSTOM_NAME
+#  define BENCHRUN_BOARD     CONFIG_ARCH_BOARD_CUSTOM_NAME
+#elif defined(CONFIG_ARCH_BOARD)
+#  define BENCHRUN_BOARD     CONFIG_ARCH_BOARD
+#else
+#  define BENCHRUN_BOARD     "unknown"
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The statistics of a metric over the runs of a command */
+
+struct benchrun_metric_s
+{
+  char         name[BENCHRUN_NAMELEN];
+  char         unit[BENCHRUN_UNITLEN];
+  unsigned int n;
+  double       mean;
+  double       m2;                    /* Sum of squared deviations */
+  double       min;
+  double       max;
+};
+
+struct benchrun_s
+{
+  FAR struct benchrun_metric_s *metrics;
+  int                           nmetrics;
+  int                           capacity;
+
+  /* State of the parser, the section of the output being read */
+
+  char                          section[BENCHRUN_NAMELEN];
+
+  FAR FILE                     *sinks[BENCHRUN_MAXSINKS];
+  int                           nsinks;
+  FAR const char               *board;
+  struct utsname                uts;
+};
+
+/* A benchmark of benchmarks/: its program name, the arguments it runs
+ * with in the default suite (NULL if it needs a target or input chosen by
+ * the user) and the parser of one line of its output.
+ */
+
+struct benchrun_tool_s
+{
+  FAR const char *name;
+  FAR const char *args;
+  CODE void     (*parse)(FAR struct benchrun_s *br, FAR char *line);
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void benchrun_coremark(FAR struct benchrun_s *br, FAR char *line);
+static void benchrun_dhrystone(FAR struct benchrun_s *br, FAR char *line);
+static void benchrun_osperf(FAR struct benchrun_s *br, FAR char *line);
+static void benchrun_ramspeed(FAR struct benchrun_s *br, FAR char *line);
+static void benchrun_cachespeed(FAR struct benchrun_s *br, FAR char *line);
+static void benchrun_spinlock(FAR struct benchrun_s *br, FAR char *line);
+static void benchrun_superpi(FAR struct benchrun_s *br, FAR char *line);
+static void benchrun_fio(FAR struct benchrun_s *br, FAR char *line);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct benchrun_tool_s g_tools[] =
+{
+#ifdef CONFIG_BENCHMARK_COREMARK
+  { CONFIG_COREMARK_PROGNAME, "", benchrun_coremark },
+#endif
+#ifdef CONFIG_BENCHMARK_DHRYSTONE
+  { CONFIG_BENCHMARK_DHRYSTONE_PROGNAME, "", benchrun_dhrystone },
+#endif
+#ifdef CONFIG_BENCHMARK_OSPERF
+  { "osperf", "-f json", benchrun_osperf },
+#endif
+#ifdef CONFIG_BENCHMARK_RAMSPEED
+  { CONFIG_BENCHMARK_RAMSPEED_PROGNAME, "-a -s 65536 -n 100",
+    benchrun_ramspeed },
+#endif
+#ifdef CONFIG_BENCHMARK_CACHESPEED
+  { CONFIG_BENCHMARK_CACHESPEED_PROGNAME, "-m -l", benchrun_cachespeed },
+#endif
+#ifdef CONFIG_BENCHMARK_SPINLOCK
+  { CONFIG_SPINLOCK_PROGNAME, "", benchrun_spinlock },
+#endif
+#ifdef CONFIG_BENCHMARK_SUPERPI
+  { CONFIG_BENCHMARK_SUPERPI_PROGNAME, NULL, benchrun_superpi },
+#endif
+#ifdef CONFIG_BENCHMARK_FIO
+  { "fio", NULL, benchrun_fio },
+#endif
+#ifdef CONFIG_BENCHMARK_IOZONE
+  { CONFIG_BENCHMARK_IOZONE_PROGNAME, NULL, NULL },
+#endif
+};
+
+#define BENCHRUN_NTOOLS (sizeof(g_tools) / sizeof(g_tools[0]))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: benchrun_now
+ ****************************************************************************/
+
+static uint64_t benchrun_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: benchrun_metric
+ *
+ * Description:
+ *   Add a sample of a metric of the current command.  The name is built
+ *   from a format and made safe for JSON.  The mean and the variance are
+ *   updated with Welford's method.
+ *
+ ****************************************************************************/
+
+static void benchrun_metric(FAR struct benchrun_s *br, FAR const char *unit,
+                            double value, FAR const char *fmt, ...)
+{
+  FAR struct benchrun_metric_s *m;
+  char name[BENCHRUN_NAMELEN];
+  va_list ap;
+  double delta;
+  int i;
+
+  va_start(ap, fmt);
+  vsnprintf(name, sizeof(name), fmt, ap);
+  va_end(ap);
+
+  for (i = 0; name[i] != '\0'; i++)
+    {
+      if (!isalnum((unsigned char)name[i]) &&
+          strchr("._-@", name[i]) == NULL)
+        {
+          name[i] = '_';
+        }
+    }
+
+  for (i = 0; i < br->nmetrics; i++)
+    {
+      if (strcmp(br->metrics[i].name, name) == 0)
+        {
+          break;
+        }
+    }
+
+  if (i == br->nmetrics)
+    {
+      if (br->nmetrics == br->capacity)
+        {
+          int capacity = br->capacity > 0 ? br->capacity * 2 : 16;
+
+          m = realloc(br->metrics, capacity * sizeof(*m));
+          if (m == NULL)
+            {
+              return;
+            }
+
+          br->metrics  = m;
+          br->capacity = capacity;
+        }
+
+      m = &br->metrics[br->nmetrics++];
+      memset(m, 0, sizeof(*m));
+      strlcpy(m->name, name, sizeof(m->name));
+      strlcpy(m->unit, unit, sizeof(m->unit));
+      m->min = value;
+      m->max = value;
+    }
+
+  m = &br->metrics[i];
+  m->n++;
+  delta    = value - m->mean;
+  m->mean += delta / m->n;
+  m->m2   += delta * (value - m->mean);
+
+  if (value < m->min)
+    {
+      m->min = value;
+    }
+
+  if (value > m->max)
+    {
+      m->max = value;
+    }
+}
+
+/****************************************************************************
+ * Name: benchrun_coremark
+ *
+ * Description:
+ *   "Iterations/Sec   : 1234.567890"
+ *
+ ****************************************************************************/
+
+static void benchrun_coremark(FAR struct benchrun_s *br, FAR char *line)
+{
+  FAR char *p = strstr(line, "Iterations/Sec");
+
+  if (p != NULL && (p = strchr(p, ':')) != NULL)
+    {
+      benchrun_metric(br, "iter/s", strtod(p + 1, NULL),
+                      "iterations_per_sec");
+    }
+}
+
+/****************************************************************************
+ * Name: benchrun_dhrystone
+ *
+ * Description:
+ *   "This machine benchmarks at 1234567 dhrystones/second" from dry.c, or
+ *   "Dhrystones per Second: 1234567" from dhry_1.c.  The DMIPS are the
+ *   dhrystones per second of the VAX 11/780, 1757.
+ *
+ ****************************************************************************/
+
+static void benchrun_dhrystone(FAR struct benchrun_s *br, FAR char *line)
+{
+  FAR char *p;
+  double value;
+
+  if ((p = strstr(line, "benchmarks at")) != NULL)
+    {
+      p += strlen("benchmarks at");
+    }
+  else if ((p = strstr(line, "Dhrystones per Second:")) != NULL)
+    {
+      p += strlen("Dhrystones per Second:");
+    }
+  else
+    {
+      return;
+    }
+
+  value = strtod(p, NULL);
+  benchrun_metric(br, "1/s", value, "dhrystones_per_sec");
+  benchrun_metric(br, "DMIPS", value / 1757, "dmips");
+}
+
+/****************************************************************************
+ * Name: benchrun_osperf
+ *
+ * Description:
+ *   The results of "osperf -f json", one per line:
+ *   {"name": "pthread-create", "max": 1, "min": 1, "avg": 1, "p50": 1,
+ *   "p99": 1, "jitter": 0}
+ *
+ ****************************************************************************/
+
+static void benchrun_osperf(FAR struct benchrun_s *br, FAR char *line)
+{
+  char name[BENCHRUN_NAMELEN - 8];
+  double max;
+  double min;
+  double avg;
+  double p50;
+  double p99;
+  FAR char *p = strstr(line, "{\"name\"");
+
+  if (p != NULL &&
+      sscanf(p, "{\"name\": \"%55[^\"]\", \"max\": %lf, \"min\": %lf, "
+             "\"avg\": %lf, \"p50\": %lf, \"p99\": %lf",
+             name, &max, &min, &avg, &p50, &p99) == 6)
+    {
+      benchrun_metric(br, "ns", avg, "%s.avg", name);
+      benchrun_metric(br, "ns", p99, "%s.p99", name);
+    }
+}
+
+/****************************************************************************
+ * Name: benchrun_ramspeed
+ *
+ * Description:
+ *   "______Perform 32 Bytes access ______" starts the results of a size,
+ *   "RAM Speed: libc memcpy():\t Rate = 123456 KB/s\t[cost: 10ms]" is the
+ *   rate of a kernel and "RAM Speed: libc memcpy() 0/CPU0:\t1.234 GB/s"
+ *   the rate of a kernel on a thread.
+ *
+ ****************************************************************************/
+
+static void benchrun_ramspeed(FAR struct benchrun_s *br, FAR char *line)
+{
+  char kernel[16];
+  char op[16];
+  char who[16];
+  char unit[8];
+  unsigned long size;
+  double value;
+  FAR char *p;
+
+  if (sscanf(line, "______Perform %lu %7s", &size, unit) == 2)
+    {
+      snprintf(br->section, sizeof(br->section), "%lu%s", size,
+               strcmp(unit, "KBytes") == 0 ? "KB" : "B");
+      return;
+    }
+
+  if (strncmp(line, "RAM Speed: ", 11) != 0)
+    {
+      return;
+    }
+
+  p = line + 11;
+  if (strstr(p, "Rate =") != NULL &&
+      sscanf(p, "%15s %15[^(]():\t Rate = %lf", kernel, op, &value) == 3)
+    {
+      benchrun_metric(br, "KB/s", value, "%s.%s.%s", op, kernel,
+                      br->section);
+    }
+  else if (strstr(p, "GB/s") != NULL &&
+           sscanf(p, "%15s %15[^(]() %15[^:]:%lf", kernel, op, who,
+                  &value) == 4)
+    {
+      benchrun_metric(br, "GB/s", value, "%s.%s.%s", op, kernel, who);
+    }
+}
+
+/****************************************************************************
+ * Name: benchrun_cachespeed
+ *
+ * Description:
+ *   "** dcache clean [rate, avg, cost] in nanoseconds(bytes/nesc) align **"
+ *   or "** pointer chase [latency] in nanoseconds, 64 bytes stride **"
+ *   starts a test, followed by "1024 Bytes: 12.345, 83, 8300" (rate in
+ *   bytes per ns, average and total cost) or "1024 Bytes: 1.23 ns".
+ *
+ ****************************************************************************/
+
+static void benchrun_cachespeed(FAR struct benchrun_s *br, FAR char *line)
+{
+  char what[24];
+  unsigned long value;
+  double rate;
+  FAR char *p;
+  int len;
+
+  /* The results end with "\n\r", the '\r' starts the next line */
+
+  line += strspn(line, "\r");
+  if (strncmp(line, "** ", 3) == 0 && (p = strstr(line, " [")) != NULL)
+    {
+      len = p - line - 3;
+      if (strstr(p, " unalign **") != NULL)
+        {
+          snprintf(br->section, sizeof(br->section), "%.*s.unalign",
+                   len, line + 3);
+        }
+      else if (strstr(p, " align **") != NULL)
+        {
+          snprintf(br->section, sizeof(br->section), "%.*s.align",
+                   len, line + 3);
+        }
+      else
+        {
+          snprintf(br->section, sizeof(br->section), "%.*s", len,
+                   line + 3);
+        }
+
+      return;
+    }
+
+  if (sscanf(line, "%lu %23[^:]: %lf", &value, what, &rate) != 3)
+    {
+      return;
+    }
+
+  p = strchr(line, ':');
+  if (strchr(p, ',') != NULL)
+    {
+      benchrun_metric(br, "B/ns", rate, "%s.%lu", br->section, value);
+    }
+  else if (strstr(p, " ns") != NULL)
+    {
+      benchrun_metric(br, "ns", rate, "%s.%lu_%s", br->section, value,
+                      what);
+    }
+}
+
+/****************************************************************************
+ * Name: benchrun_spinlock
+ *
+ * Description:
+ *   "ticket          4     0      1234567     300000     310000  99.9%",
+ *   the lock, threads, critical section length and total acquisitions per
+ *   second.
+ *
+ ****************************************************************************/
+
+static void benchrun_spinlock(FAR struct benchrun_s *br, FAR char *line)
+{
+  char lock[16];
+  int threads;
+  int work;
+  double total;
+
+  if (sscanf(line, "%15s %d %d %lf", lock, &threads, &work, &total) == 4)
+    {
+      benchrun_metric(br, "acq/s", total, "%s.t%d.w%d", lock, threads,
+                      work);
+    }
+}
+
+/****************************************************************************
+ * Name: benchrun_superpi
+ *
+ * Description:
+ *   "12.345 sec. (real time)" at the end of the calculation.
+ *
+ ****************************************************************************/
+
+static void benchrun_superpi(FAR struct benchrun_s *br, FAR char *line)
+{
+  if (strstr(line, "sec. (real time)") != NULL)
+    {
+      benchrun_metric(br, "s", strtod(line, NULL), "time");
+    }
+}
+
+/****************************************************************************
+ * Name: benchrun_fio
+ *
+ * Description:
+ *   "   READ: bw=12.3MiB/s (12.9MB/s), ..." in the summary of the run and
+ *   "  read: IOPS=3150, BW=12.3MiB/s ..." in the results of a job.  The
+ *   bandwidths are converted to KiB/s.
+ *
+ ****************************************************************************/
+
+static void benchrun_fio(FAR struct benchrun_s *br, FAR char *line)
+{
+  static const char * const ops[] =
+  {
+    "read", "write", "trim"
+  };
+
+  char key[16];
+  FAR char *end;
+  FAR char *p;
+  double value;
+  size_t i;
+
+  for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+    {
+      size_t j;
+
+      /* The summary, with the operation in upper case */
+
+      for (j = 0; ops[i][j] != '\0'; j++)
+        {
+          key[j] = toupper(ops[i][j]);
+        }
+
+      strlcpy(key + j, ": bw=", sizeof(key) - j);
+      p = strstr(line, key);
+      if (p != NULL)
+        {
+          value = strtod(p + strlen(key), &end);
+          switch (*end)
+            {
+              case 'G':
+                value *= 1024;
+
+                /* Fall through */
+
+              case 'M':
+                value *= 1024;
+                break;
+
+              case 'B':
+                value /= 1024;
+                break;
+
+              default:
+                break;
+            }
+
+          benchrun_metric(br, "KiB/s", value, "%s.bw", ops[i]);
+          return;
+        }
+
+      snprintf(key, sizeof(key), "%s: IOPS=", ops[i]);
+      p = strstr(line, key);
+      if (p != NULL)
+        {
+          value = strtod(p + strlen(key), &end);
+          if (*end == 'k')
+            {
+              value *= 1000;
+            }
+
+          benchrun_metric(br, "IOPS", value, "%s.iops", ops[i]);
+          return;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: benchrun_tool
+ ****************************************************************************/
+
+static FAR const struct benchrun_tool_s *
+benchrun_tool(FAR const char *name)
+{
+  size_t i;
+
+  for (i = 0; i < BENCHRUN_NTOOLS; i++)
+    {
+      if (strcmp(g_tools[i].name, name) == 0)
+        {
+          return &g_tools[i];
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: benchrun_putstr
+ *
+ * Description:
+ *   Write a string as a JSON string.
+ *
+ ****************************************************************************/
+
+static void benchrun_putstr(FAR FILE *out, FAR const char *str)
+{
+  fputc('"', out);
+  for (; *str != '\0'; str++)
+    {
+      if (*str == '"' || *str == '\\')
+        {
+          fputc('\\', out);
+          fputc(*str, out);
+        }
+      else if ((unsigned char)*str < 0x20)
+        {
+          fprintf(out, "\\u%04x", *str);
+        }
+      else
+        {
+          fputc(*str, out);
+        }
+    }
+
+  fputc('"', out);
+}
+
+/****************************************************************************
+ * Name: benchrun_report
+ *
+ * Description:
+ *   Write the metrics of a command, one JSON object per line so that the
+ *   results can be streamed and appended:
+ *
+ *   {"board": "sim", "config": "0123456789abcdef", "version": "...",
+ *    "bench": "coremark", "command": "coremark", "metric":
+ *    "iterations_per_sec", "unit": "iter/s", "value": 1234.5,
+ *    "variance": 1.5, "min": 1233, "max": 1236, "runs": 5}
+ *
+ *   The value is the mean of the runs and the variance their sample
+ *   variance.
+ *
+ ****************************************************************************/
+
+static void benchrun_report(FAR struct benchrun_s *br, FAR const char *bench,
+                            FAR const char *command)
+{
+  FAR struct benchrun_metric_s *m;
+  FAR FILE *out;
+  int i;
+  int j;
+
+  for (i = 0; i < br->nsinks; i++)
+    {
+      out = br->sinks[i];
+
+      for (j = 0; j < br->nmetrics; j++)
+        {
+          m = &br->metrics[j];
+
+          fputs("{\"board\": ", out);
+          benchrun_putstr(out, br->board);
+          fputs(", \"config\": \"" BENCHRUN_CONFIG_HASH "\", "
+                "\"version\": ", out);
+          benchrun_putstr(out, br->uts.version);
+          fputs(", \"bench\": ", out);
+          benchrun_putstr(out, bench);
+          fputs(", \"command\": ", out);
+          benchrun_putstr(out, command);
+          fprintf(out, ", \"metric\": \"%s\", \"unit\": \"%s\", "
+                  "\"value\": %.9g, \"variance\": %.9g, \"min\": %.9g, "
+                  "\"max\": %.9g, \"runs\": %u}\n",
+                  m->name, m->unit, m->mean,
+                  m->n > 1 ? m->m2 / (m->n - 1) : 0.0,
+                  m->min, m->max, m->n);
+        }
+
+      fflush(out);
+    }
+}
+
+/****************************************************************************
+ * Name: benchrun_exec
+ *
+ * Description:
+ *   Run a command once with its output redirected to the scratch file,
+ *   then feed the output to the parser of the benchmark if parse is true.
+ *
+ * Returned Value:
+ *   Zero (OK) on success, a negated errno value if the command could not
+ *   be started and -EIO if it failed.
+ *
+ ****************************************************************************/
+
+static int benchrun_exec(FAR struct benchrun_s *br,
+                         FAR const struct benchrun_tool_s *tool,
+                         FAR char * const *argv, bool parse)
+{
+  char line[BENCHRUN_LINELEN];
+  uint64_t start;
+  uint64_t elapsed;
+  FAR FILE *fp;
+  pid_t pid;
+  int status;
+
+  start = benchrun_now();
+  pid = exec_builtin(argv[0], argv, CONFIG_BENCHMARK_BENCHRUN_OUTPUT,
+                     O_WRONLY | O_CREAT | O_TRUNC);
+  if (pid < 0)
+    {
+      return -errno;
+    }
+
+  if (waitpid(pid, &status, 0) < 0)
+    {
+      return -errno;
+    }
+
+  elapsed = benchrun_now() - start;
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+      return -EIO;
+    }
+
+  if (!parse)
+    {
+      return OK;
+    }
+
+  benchrun_metric(br, "ms", elapsed / 1000000.0, "elapsed");
+
+  if (tool == NULL || tool->parse == NULL)
+    {
+      return OK;
+    }
+
+  fp = fopen(CONFIG_BENCHMARK_BENCHRUN_OUTPUT, "r");
+  if (fp == NULL)
+    {
+      return -errno;
+    }
+
+  br->section[0] = '\0';
+  while (fgets(line, sizeof(line), fp) != NULL)
+    {
+      tool->parse(br, line);
+    }
+
+  fclose(fp);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: benchrun_command
+ *
+ * Description:
+ *   Run a command of the suite warmup + runs times and report the metrics
+ *   of the runs after the warmup.
+ *
+ ****************************************************************************/
+
+static int benchrun_command(FAR struct benchrun_s *br,
+                            FAR const char *command, int runs, int warmup)
+{
+  FAR const struct benchrun_tool_s *tool;
+  FAR char *argv[BENCHRUN_MAXARGS + 1];
+  FAR char *saveptr;
+  FAR char *copy;
+  FAR char *arg;
+  int argc = 0;
+  int failed = 0;
+  int ret = OK;
+  int i;
+
+  copy = strdup(command);
+  if (copy == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  for (arg = strtok_r(copy, " \t", &saveptr);
+       arg != NULL && argc < BENCHRUN_MAXARGS;
+       arg = strtok_r(NULL, " \t", &saveptr))
+    {
+      argv[argc++] = arg;
+    }
+
+  argv[argc] = NULL;
+  if (argc == 0)
+    {
+      free(copy);
+      return OK;
+    }
+
+  tool = benchrun_tool(argv[0]);
+  br->nmetrics = 0;
+
+  for (i = 0; i < warmup + runs; i++)
+    {
+      fprintf(stderr, "benchrun: %s, %s %d/%d\n", command,
+              i < warmup ? "warmup" : "run",
+              i < warmup ? i + 1 : i - warmup + 1,
+              i < warmup ? warmup : runs);
+
+      ret = benchrun_exec(br, tool, argv, i >= warmup);
+      if (ret == -EIO)
+        {
+          fprintf(stderr, "benchrun: %s failed, see %s\n", command,
+                  CONFIG_BENCHMARK_BENCHRUN_OUTPUT);
+          failed++;
+        }
+      else if (ret < 0)
+        {
+          fprintf(stderr, "benchrun: can't run %s: %d\n", argv[0], ret);
+          break;
+        }
+    }
+
+  if (ret >= 0 || ret == -EIO)
+    {
+      benchrun_report(br, argv[0], command);
+      ret = failed > 0 ? -EIO : OK;
+    }
+
+  free(copy);
+  return ret;
+}
+
+#ifdef BENCHRUN_STREAM
+/****************************************************************************
+ * Name: benchrun_connect
+ *
+ * Description:
+ *   Connect to a collector at "a.b.c.d:port" receiving the results over
+ *   TCP, for example "nc -l 5555 >> results.json" on the host.
+ *
+ ****************************************************************************/
+
+static FAR FILE *benchrun_connect(FAR const char *dest)
+{
+  struct sockaddr_in addr;
+  char host[INET_ADDRSTRLEN];
+  FAR const char *port;
+  FAR FILE *out;
+  int sd;
+
+  port = strchr(dest, ':');
+  if (port == NULL || port - dest >= (ptrdiff_t)sizeof(host))
+    {
+      return NULL;
+    }
+
+  memcpy(host, dest, port - dest);
+  host[port - dest] = '\0';
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port   = htons(atoi(port + 1));
+  if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+    {
+      return NULL;
+    }
+
+  sd = socket(AF_INET, SOCK_STREAM, 0);
+  if (sd < 0)
+    {
+      return NULL;
+    }
+
+  if (connect(sd, (FAR struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+      close(sd);
+      return NULL;
+    }
+
+  out = fdopen(sd, "w");
+  if (out == NULL)
+    {
+      close(sd);
+    }
+
+  return out;
+}
+#endif
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname)
+{
+  size_t i;
+
+  printf("Usage: %s [-r runs] [-w warmup] [-b board] [-o file]"
+#ifdef BENCHRUN_STREAM
+         " [-s addr:port]"
+#endif
+         " [\"command\" ...]\n", progname);
+  printf("  -r  Runs of each command (default %d)\n",
+         CONFIG_BENCHMARK_BENCHRUN_RUNS);
+  printf("  -w  Runs before, not measured (default %d)\n",
+         CONFIG_BENCHMARK_BENCHRUN_WARMUP);
+  printf("  -b  Board name in the results (default %s)\n",
+         BENCHRUN_BOARD);
+  printf("  -o  Append the results to a file\n");
+#ifdef BENCHRUN_STREAM
+  printf("  -s  Send the results to a TCP collector\n");
+#endif
+  printf("The results go to stdout without -o or -s, one JSON object per "
+         "metric and line.\nThe commands default to the suite configured, "
+         "or else:\n");
+  for (i = 0; i < BENCHRUN_NTOOLS; i++)
+    {
+      if (g_tools[i].args != NULL)
+        {
+          printf("  \"%s %s\"\n", g_tools[i].name, g_tools[i].args);
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct benchrun_s br;
+  char command[BENCHRUN_LINELEN];
+  FAR const char *suite = CONFIG_BENCHMARK_BENCHRUN_SUITE;
+  FAR char *saveptr;
+  FAR char *copy;
+  FAR char *cmd;
+  int runs = CONFIG_BENCHMARK_BENCHRUN_RUNS;
+  int warmup = CONFIG_BENCHMARK_BENCHRUN_WARMUP;
+  int failed = 0;
+  size_t i;
+  int opt;
+
+  memset(&br, 0, sizeof(br));
+  br.board = BENCHRUN_BOARD;
+  uname(&br.uts);
+
+  while ((opt = getopt(argc, argv, "r:w:b:o:s:h")) != -1)
+    {
+      switch (opt)
+        {
+          case 'r':
+            runs = atoi(optarg);
+            break;
+
+          case 'w':
+            warmup = atoi(optarg);
+            break;
+
+          case 'b':
+            br.board = optarg;
+            break;
+
+          case 'o':
+            if (br.nsinks < BENCHRUN_MAXSINKS)
+              {
+                br.sinks[br.nsinks] = fopen(optarg, "a");
+                if (br.sinks[br.nsinks] == NULL)
+                  {
+                    fprintf(stderr, "benchrun: can't open %s: %d\n",
+                            optarg, errno);
+                    goto errout;
+                  }
+
+                br.nsinks++;
+              }
+            break;
+
+#ifdef BENCHRUN_STREAM
+          case 's':
+            if (br.nsinks < BENCHRUN_MAXSINKS)
+              {
+                br.sinks[br.nsinks] = benchrun_connect(optarg);
+                if (br.sinks[br.nsinks] == NULL)
+                  {
+                    fprintf(stderr, "benchrun: can't connect to %s\n",
+                            optarg);
+                    goto errout;
+                  }
+
+                br.nsinks++;
+              }
+            break;
+#endif
+
+          case 'h':
+            show_usage(argv[0]);
+            return EXIT_SUCCESS;
+
+          default:
+            show_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (runs < 1 || warmup < 0)
+    {
+      show_usage(argv[0]);
+      goto errout;
+    }
+
+  if (br.nsinks == 0)
+    {
+      br.sinks[br.nsinks++] = stdout;
+    }
+
+  if (optind < argc)
+    {
+      for (; optind < argc; optind++)
+        {
+          failed += benchrun_command(&br, argv[optind], runs, warmup) < 0;
+        }
+    }
+  else if (*suite != '\0')
+    {
+      copy = strdup(suite);
+      if (copy == NULL)
+        {
+          goto errout;
+        }
+
+      for (cmd = strtok_r(copy, ";", &saveptr); cmd != NULL;
+           cmd = strtok_r(NULL, ";", &saveptr))
+        {
+          failed += benchrun_command(&br, cmd, runs, warmup) < 0;
+        }
+
+      free(copy);
+    }
+  else
+    {
+      for (i = 0; i < BENCHRUN_NTOOLS; i++)
+        {
+          if (g_tools[i].args != NULL)
+            {
+              snprintf(command, sizeof(command), "%s%s%s", g_tools[i].name,
+                       *g_tools[i].args != '\0' ? " " : "", g_tools[i].args);
+              failed += benchrun_command(&br, command, runs, warmup) < 0;
+            }
+        }
+    }
+
+  for (i = 0; i < (size_t)br.nsinks; i++)
+    {
+      if (br.sinks[i] != stdout)
+        {
+          fclose(br.sinks[i]);
+        }
+    }
+
+  free(br.metrics);
+  return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+
+errout:
+  for (i = 0; i < (size_t)br.nsinks; i++)
+    {
+      fclose(br.sinks[i]);
+    }
+
+  return EXIT_FAILURE;
+}
@@ -29,9 +29,13 @@
 
 #include <inttypes.h>
 #include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -40,6 +44,26 @@
 #define CACHESPEED_PREFIX "CACHE Speed: "
 #define REPEAT_NUM 1000
 
+/* Dependent loads timed per working set size */
+
+#define CHASE_LOADS (1 << 20)
+
+/* Passes over the buffer per stride, and the largest stride: well past a
+ * page, where the prefetchers give up.
+ */
+
+#define STRIDE_REPEAT 8
+#define STRIDE_MAX 16384
+
+/* Increments of each thread in the false sharing test */
+
+#define SHARE_LOOPS 1000000
+
+#define CACHESPEED_MAINT  (1 << 0)
+#define CACHESPEED_CHASE  (1 << 1)
+#define CACHESPEED_STRIDE (1 << 2)
+#define CACHESPEED_SHARE  (1 << 3)
+
 #ifdef CACHESPEED_PERFTIME
   #define TIME uint64_t
 
@@ -81,6 +105,14 @@ struct cachespeed_s
   size_t alloc;
 };
 
+#ifdef CONFIG_SMP
+struct cachespeed_share_s
+{
+  FAR volatile uintptr_t *counter;
+  FAR sem_t *start;
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -205,6 +237,320 @@ static void test_skeleton(FAR struct cachespeed_s *cs,
     }
 }
 
+/****************************************************************************
+ * Name: report_access
+ *
+ * Description:
+ *   Print the average time of one of count accesses, in ns with two
+ *   decimals.
+ *
+ ****************************************************************************/
+
+static void report_access(FAR const char *what, size_t value, TIME cost,
+                          size_t count)
+{
+  uint64_t ps;
+
+  CONVERT(cost);
+  ps = (uint64_t)cost * 1000 / count;
+  printf("%zu %s: %" PRIu64 ".%02" PRIu64 " ns\n", value, what,
+         ps / 1000, ps % 1000 / 10);
+}
+
+/****************************************************************************
+ * Name: chase_build
+ *
+ * Description:
+ *   Link nodes lines of the buffer into one random cycle, so that every
+ *   load depends on the one before and no prefetcher can guess the next
+ *   line.  The second word of each node holds its place in the cycle while
+ *   it is shuffled (Sattolo's algorithm, which only makes single cycles).
+ *
+ ****************************************************************************/
+
+static FAR void *chase_build(uintptr_t base, size_t nodes, size_t line)
+{
+  uint32_t seed = 2463534242u;
+  uintptr_t tmp;
+  size_t i;
+  size_t j;
+
+#define NODE(i) ((FAR uintptr_t *)(base + (i) * line))
+
+  for (i = 0; i < nodes; i++)
+    {
+      NODE(i)[1] = i;
+    }
+
+  for (i = nodes - 1; i > 0; i--)
+    {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+
+      j = seed % i;
+      tmp        = NODE(i)[1];
+      NODE(i)[1] = NODE(j)[1];
+      NODE(j)[1] = tmp;
+    }
+
+  for (i = 0; i < nodes; i++)
+    {
+      NODE(NODE(i)[1])[0] = (uintptr_t)NODE(NODE((i + 1) % nodes)[1]);
+    }
+
+#undef NODE
+
+  return (FAR void *)base;
+}
+
+/****************************************************************************
+ * Name: chase_test
+ *
+ * Description:
+ *   Load to use latency over growing working sets.  The steps in the curve
+ *   are the cache levels, their height the miss penalty of each.
+ *
+ *   Interrupts are left on: with a millisecond tick at the largest sizes
+ *   the run could not be timed otherwise, and the few interrupts only
+ *   move the result by a fraction of a percent.
+ *
+ ****************************************************************************/
+
+static void chase_test(FAR struct cachespeed_s *cs)
+{
+  size_t line = GET_DCACHE_LINE;
+  FAR void *volatile sink;
+  FAR void **ptr;
+  size_t nodes;
+  size_t bytes;
+  size_t i;
+  TIME start;
+  TIME end;
+
+  if (line < 2 * sizeof(uintptr_t))
+    {
+      line = 2 * sizeof(uintptr_t);
+    }
+
+  printf("** pointer chase [latency] in nanoseconds, %zu bytes stride **\n",
+         line);
+
+  for (bytes = 1024; bytes <= cs->alloc; bytes *= 2)
+    {
+      nodes = bytes / line;
+      ptr   = chase_build(cs->addr, nodes, line);
+
+      /* Walk the cycle once so that what fits is in the cache */
+
+      for (i = 0; i < nodes; i++)
+        {
+          ptr = *ptr;
+        }
+
+      TIMESTAMP(start);
+      for (i = 0; i < CHASE_LOADS; i++)
+        {
+          ptr = *ptr;
+        }
+
+      TIMESTAMP(end);
+
+      sink = ptr;
+      UNUSED(sink);
+      report_access("Bytes", bytes, end - start, CHASE_LOADS);
+    }
+}
+
+/****************************************************************************
+ * Name: stride_test
+ *
+ * Description:
+ *   Time one load per stride over the whole, uncached buffer.  The time
+ *   per load grows until the stride reaches the line size, every load is
+ *   a miss from there on; where it keeps falling or stays flat below the
+ *   full miss latency, the prefetcher is keeping up.
+ *
+ ****************************************************************************/
+
+static void stride_test(FAR struct cachespeed_s *cs)
+{
+  FAR volatile uintptr_t *ptr;
+  size_t stride;
+  size_t count;
+  size_t i;
+  TIME start;
+  TIME end;
+  TIME cost;
+  int r;
+
+  printf("** stride sweep [latency] in nanoseconds, %zu bytes line **\n",
+         GET_DCACHE_LINE);
+
+  for (stride = sizeof(uintptr_t);
+       stride <= STRIDE_MAX && stride * 16 <= cs->alloc; stride *= 2)
+    {
+      count = cs->alloc / stride;
+      cost  = 0;
+
+      for (r = 0; r < STRIDE_REPEAT; r++)
+        {
+          up_flush_dcache_all();
+          ptr = (FAR volatile uintptr_t *)cs->addr;
+
+          TIMESTAMP(start);
+          for (i = 0; i < count; i++)
+            {
+              (void)*ptr;
+              ptr = (FAR volatile uintptr_t *)((uintptr_t)ptr + stride);
+            }
+
+          TIMESTAMP(end);
+          cost += end - start;
+        }
+
+      report_access("Bytes stride", stride, cost, count * STRIDE_REPEAT);
+    }
+}
+
+#ifdef CONFIG_SMP
+/****************************************************************************
+ * Name: share_thread
+ ****************************************************************************/
+
+static FAR void *share_thread(FAR void *arg)
+{
+  FAR struct cachespeed_share_s *share = arg;
+  int i;
+
+  sem_wait(share->start);
+  for (i = 0; i < SHARE_LOOPS; i++)
+    {
+      (*share->counter)++;
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: share_run
+ *
+ * Description:
+ *   Increment two counters offset bytes apart from CPU0 and CPU1 at the
+ *   same time, and return how long it took.
+ *
+ ****************************************************************************/
+
+static int share_run(uintptr_t base, size_t offset, FAR TIME *cost)
+{
+  struct cachespeed_share_s share[2];
+  pthread_attr_t attr;
+  pthread_t tid[2];
+  cpu_set_t cpuset;
+  sem_t start;
+  TIME begin;
+  TIME end;
+  int ret = 0;
+  int n;
+  int i;
+
+  sem_init(&start, 0, 0);
+
+  for (n = 0; n < 2; n++)
+    {
+      share[n].counter  = (FAR volatile uintptr_t *)(base + n * offset);
+      share[n].start    = &start;
+      *share[n].counter = 0;
+
+      CPU_ZERO(&cpuset);
+      CPU_SET(n, &cpuset);
+      pthread_attr_init(&attr);
+      pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+      ret = pthread_create(&tid[n], &attr, share_thread, &share[n]);
+      pthread_attr_destroy(&attr);
+      if (ret != 0)
+        {
+          break;
+        }
+    }
+
+  TIMESTAMP(begin);
+  for (i = 0; i < n; i++)
+    {
+      sem_post(&start);
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      pthread_join(tid[i], NULL);
+    }
+
+  TIMESTAMP(end);
+  sem_destroy(&start);
+
+  *cost = end - begin;
+  return -ret;
+}
+
+/****************************************************************************
+ * Name: share_test
+ *
+ * Description:
+ *   False sharing: the same two counters in one line, then two lines
+ *   apart (the adjacent line may be fetched along with its neighbour).
+ *
+ ****************************************************************************/
+
+static void share_test(FAR struct cachespeed_s *cs)
+{
+  size_t line = GET_DCACHE_LINE;
+  uintptr_t base = (cs->addr + line - 1) & ~(uintptr_t)(line - 1);
+  size_t offset[2];
+  TIME cost;
+  int ret;
+  int i;
+
+  printf("** false sharing [per increment] in nanoseconds, CPU0 and CPU1 "
+         "**\n");
+
+  offset[0] = sizeof(uintptr_t);
+  offset[1] = 2 * line;
+
+  for (i = 0; i < 2; i++)
+    {
+      ret = share_run(base, offset[i], &cost);
+      if (ret < 0)
+        {
+          printf(CACHESPEED_PREFIX "Unable to start the threads: %d\n",
+                 ret);
+          return;
+        }
+
+      report_access("Bytes apart", offset[i], cost, SHARE_LOOPS);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname)
+{
+  printf("Usage: %s [-m] [-l] [-s]"
+#ifdef CONFIG_SMP
+         " [-f]"
+#endif
+         " [-a]\n", progname);
+  printf("  -m  Cache maintenance operations (default)\n");
+  printf("  -l  Pointer chasing load latency over working set sizes\n");
+  printf("  -s  Stride sweep, shows line size and prefetching\n");
+#ifdef CONFIG_SMP
+  printf("  -f  False sharing between CPU0 and CPU1\n");
+#endif
+  printf("  -a  All of the above\n");
+}
+
 /****************************************************************************
  * Name: cachespeed_common
  ****************************************************************************/
@@ -245,8 +591,68 @@ int main(int argc, FAR char *argv[])
       .alloc = 0
     };
 
+  int tests = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "mlsfah")) != -1)
+    {
+      switch (opt)
+        {
+          case 'm':
+            tests |= CACHESPEED_MAINT;
+            break;
+          case 'l':
+            tests |= CACHESPEED_CHASE;
+            break;
+          case 's':
+            tests |= CACHESPEED_STRIDE;
+            break;
+#ifdef CONFIG_SMP
+          case 'f':
+            tests |= CACHESPEED_SHARE;
+            break;
+#endif
+          case 'a':
+            tests = ~0;
+            break;
+          case 'h':
+            show_usage(argv[0]);
+            return 0;
+          default:
+            show_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (tests == 0)
+    {
+      tests = CACHESPEED_MAINT;
+    }
+
   setup(&cs);
-  cachespeed_common(&cs);
+
+  if (tests & CACHESPEED_MAINT)
+    {
+      cachespeed_common(&cs);
+    }
+
+  if (tests & CACHESPEED_CHASE)
+    {
+      chase_test(&cs);
+    }
+
+  if (tests & CACHESPEED_STRIDE)
+    {
+      stride_test(&cs);
+    }
+
+#ifdef CONFIG_SMP
+  if (tests & CACHESPEED_SHARE)
+    {
+      share_test(&cs);
+    }
+#endif
+
   teardown(&cs);
   return 0;
 }
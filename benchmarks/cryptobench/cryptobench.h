@@ -0,0 +1,125 @@
+/****************************************************************************
+ * apps/benchmarks/cryptobench/cryptobench.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_BENCHMARKS_CRYPTOBENCH_CRYPTOBENCH_H
+#define __APPS_BENCHMARKS_CRYPTOBENCH_CRYPTOBENCH_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Room after the output of the bulk algorithms for an IV or a tag */
+
+#define CRYPTOBENCH_OVERHEAD 32
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+enum cryptobench_alg_e
+{
+  CRYPTOBENCH_AES_CBC = 0,          /* AES-128-CBC encryption */
+  CRYPTOBENCH_AES_GCM,              /* AES-128-GCM encryption and tag */
+  CRYPTOBENCH_CHACHAPOLY,           /* ChaCha20-Poly1305 (IETF) */
+  CRYPTOBENCH_SHA256,               /* SHA-256 */
+  CRYPTOBENCH_HMAC,                 /* HMAC-SHA-256 */
+  CRYPTOBENCH_NBULK,                /* Above: KB/s, below: ops/s */
+  CRYPTOBENCH_ECDSA_SIGN = CRYPTOBENCH_NBULK,
+  CRYPTOBENCH_ECDSA_VERIFY,         /* ECDSA P-256 of a SHA-256 digest */
+  CRYPTOBENCH_X25519,               /* X25519 shared secret */
+  CRYPTOBENCH_NALGS
+};
+
+/* One operation: process len bytes of in into out (bulk algorithms), or
+ * one public key operation on the keys made by init (in and len unused).
+ * out has len + CRYPTOBENCH_OVERHEAD bytes.  Returns 0 on success.
+ */
+
+typedef CODE int (*cryptobench_op_t)(FAR const uint8_t *in,
+                                     FAR uint8_t *out, size_t len);
+
+struct cryptobench_lib_s
+{
+  FAR const char *name;
+
+  /* Prepare the keys and the contexts of all of the operations, so that
+   * only the operations themselves are timed.  May be NULL.
+   */
+
+  CODE int (*init)(void);
+  CODE void (*deinit)(void);
+
+  /* The operations, NULL if not supported by the library */
+
+  cryptobench_op_t op[CRYPTOBENCH_NALGS];
+};
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/* Keys and nonces shared by all of the libraries */
+
+extern const uint8_t g_cryptobench_key[32];
+extern const uint8_t g_cryptobench_iv[16];
+
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_MBEDTLS
+extern const struct cryptobench_lib_s g_cryptobench_mbedtls;
+#endif
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_WOLFSSL
+extern const struct cryptobench_lib_s g_cryptobench_wolfssl;
+#endif
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_TINYCRYPT
+extern const struct cryptobench_lib_s g_cryptobench_tinycrypt;
+#endif
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_LIBSODIUM
+extern const struct cryptobench_lib_s g_cryptobench_sodium;
+#endif
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_LIBTOMCRYPT
+extern const struct cryptobench_lib_s g_cryptobench_tomcrypt;
+#endif
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_CRYPTODEV
+extern const struct cryptobench_lib_s g_cryptobench_dev;
+#endif
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: cryptobench_rng
+ *
+ * Description:
+ *   Fill buf with random bytes, for the key generation and the signatures.
+ *
+ ****************************************************************************/
+
+void cryptobench_rng(FAR void *buf, size_t len);
+
+#endif /* __APPS_BENCHMARKS_CRYPTOBENCH_CRYPTOBENCH_H */
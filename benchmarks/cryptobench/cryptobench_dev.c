@@ -0,0 +1,178 @@
+/****************************************************************************
+ * apps/benchmarks/cryptobench/cryptobench_dev.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <crypto/cryptodev.h>
+
+#include "cryptobench.h"
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static int g_fd = -1;
+static uint32_t g_cbc;
+static uint32_t g_sha256;
+static uint32_t g_hmac;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int dev_bench_session(int cipher, int mac, FAR uint32_t *ses)
+{
+  struct session_op session;
+
+  memset(&session, 0, sizeof(session));
+  session.cipher = cipher;
+  session.mac    = mac;
+  if (cipher != 0)
+    {
+      session.key    = (caddr_t)g_cryptobench_key;
+      session.keylen = 16;
+    }
+  else if (mac == CRYPTO_SHA2_256_HMAC)
+    {
+      session.mackey    = (caddr_t)g_cryptobench_key;
+      session.mackeylen = sizeof(g_cryptobench_key);
+    }
+
+  if (ioctl(g_fd, CIOCGSESSION, &session) < 0)
+    {
+      return -1;
+    }
+
+  *ses = session.ses;
+  return 0;
+}
+
+static int dev_bench_crypt(uint32_t ses, int flags, FAR const uint8_t *in,
+                           FAR uint8_t *out, FAR uint8_t *mac, size_t len)
+{
+  struct crypt_op cryp;
+  uint8_t iv[16];
+
+  memcpy(iv, g_cryptobench_iv, sizeof(iv));
+  memset(&cryp, 0, sizeof(cryp));
+  cryp.ses   = ses;
+  cryp.op    = COP_ENCRYPT;
+  cryp.flags = flags;
+  cryp.src   = (caddr_t)in;
+  cryp.dst   = (caddr_t)out;
+  cryp.mac   = (caddr_t)mac;
+  cryp.len   = len;
+  cryp.iv    = out != NULL ? (caddr_t)iv : NULL;
+
+  return ioctl(g_fd, CIOCCRYPT, &cryp) < 0 ? -1 : 0;
+}
+
+static int dev_bench_cbc(FAR const uint8_t *in, FAR uint8_t *out,
+                         size_t len)
+{
+  return dev_bench_crypt(g_cbc, 0, in, out, NULL, len);
+}
+
+static int dev_bench_sha256(FAR const uint8_t *in, FAR uint8_t *out,
+                            size_t len)
+{
+  int ret;
+
+  ret = dev_bench_crypt(g_sha256, COP_FLAG_UPDATE, in, NULL, NULL, len);
+  if (ret == 0)
+    {
+      ret = dev_bench_crypt(g_sha256, 0, NULL, NULL, out, 0);
+    }
+
+  return ret;
+}
+
+static int dev_bench_hmac(FAR const uint8_t *in, FAR uint8_t *out,
+                          size_t len)
+{
+  return dev_bench_crypt(g_hmac, 0, in, NULL, out, len);
+}
+
+static void dev_bench_deinit(void)
+{
+  ioctl(g_fd, CIOCFSESSION, &g_cbc);
+  ioctl(g_fd, CIOCFSESSION, &g_sha256);
+  ioctl(g_fd, CIOCFSESSION, &g_hmac);
+  close(g_fd);
+  g_fd = -1;
+}
+
+static int dev_bench_init(void)
+{
+  int devfd;
+  int ret;
+
+  devfd = open("/dev/crypto", O_RDWR);
+  if (devfd < 0)
+    {
+      return -1;
+    }
+
+  ret = ioctl(devfd, CRIOGET, &g_fd);
+  close(devfd);
+  if (ret < 0)
+    {
+      return -1;
+    }
+
+  /* The sessions stay open, only the operations are timed */
+
+  ret  = dev_bench_session(CRYPTO_AES_CBC, 0, &g_cbc);
+  ret |= dev_bench_session(0, CRYPTO_SHA2_256, &g_sha256);
+  ret |= dev_bench_session(0, CRYPTO_SHA2_256_HMAC, &g_hmac);
+  if (ret < 0)
+    {
+      dev_bench_deinit();
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/* /dev/crypto has no AEAD cipher and no public key operation */
+
+const struct cryptobench_lib_s g_cryptobench_dev =
+{
+  "/dev/crypto",
+  dev_bench_init,
+  dev_bench_deinit,
+  {
+    [CRYPTOBENCH_AES_CBC]      = dev_bench_cbc,
+    [CRYPTOBENCH_SHA256]       = dev_bench_sha256,
+    [CRYPTOBENCH_HMAC]         = dev_bench_hmac,
+  }
+};
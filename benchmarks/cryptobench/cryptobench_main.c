@@ -0,0 +1,298 @@
+/****************************************************************************
+ * apps/benchmarks/cryptobench/cryptobench_main.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cryptobench.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define CRYPTOBENCH_PREFIX "cryptobench: "
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static FAR const struct cryptobench_lib_s *g_libs[] =
+{
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_MBEDTLS
+  &g_cryptobench_mbedtls,
+#endif
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_WOLFSSL
+  &g_cryptobench_wolfssl,
+#endif
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_TINYCRYPT
+  &g_cryptobench_tinycrypt,
+#endif
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_LIBSODIUM
+  &g_cryptobench_sodium,
+#endif
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_LIBTOMCRYPT
+  &g_cryptobench_tomcrypt,
+#endif
+#ifdef CONFIG_BENCHMARK_CRYPTOBENCH_CRYPTODEV
+  &g_cryptobench_dev,
+#endif
+  NULL
+};
+
+static FAR const char *g_alg_names[CRYPTOBENCH_NALGS] =
+{
+  "aes-128-cbc",
+  "aes-128-gcm",
+  "chacha20-poly",
+  "sha256",
+  "hmac-sha256",
+  "ecdsa-sign",
+  "ecdsa-verify",
+  "x25519"
+};
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+const uint8_t g_cryptobench_key[32] =
+{
+  0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe,
+  0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+  0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7,
+  0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4
+};
+
+const uint8_t g_cryptobench_iv[16] =
+{
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+  0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: get_time_ms
+ ****************************************************************************/
+
+static uint32_t get_time_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname, int exitcode)
+{
+  printf("\nUsage: %s [-s <size>] [-t <ms>]\n", progname);
+  printf("\nWhere:\n");
+  printf("  -s <size> bytes processed by each bulk operation "
+         "(default %d).\n", CONFIG_BENCHMARK_CRYPTOBENCH_BUFSIZE);
+  printf("  -t <ms> duration of each measure (default 1000).\n");
+  exit(exitcode);
+}
+
+/****************************************************************************
+ * Name: measure
+ *
+ * Description:
+ *   Repeat an operation for the given duration and return its rate, in
+ *   KB/s for the bulk algorithms or in ops/s, or -1 on failure.
+ *
+ ****************************************************************************/
+
+static int32_t measure(cryptobench_op_t op, int alg, FAR const uint8_t *in,
+                       FAR uint8_t *out, size_t len, uint32_t duration)
+{
+  uint32_t start;
+  uint32_t elapsed;
+  uint64_t count = 0;
+
+  start = get_time_ms();
+  do
+    {
+      if (op(in, out, len) != 0)
+        {
+          return -1;
+        }
+
+      count++;
+      elapsed = get_time_ms() - start;
+    }
+  while (elapsed < duration);
+
+  if (elapsed == 0)
+    {
+      elapsed = 1;
+    }
+
+  if (alg < CRYPTOBENCH_NBULK)
+    {
+      return count * len * 1000 / 1024 / elapsed;
+    }
+
+  return count * 1000 / elapsed;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: cryptobench_rng
+ ****************************************************************************/
+
+void cryptobench_rng(FAR void *buf, size_t len)
+{
+  arc4random_buf(buf, len);
+}
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  int32_t rate[CRYPTOBENCH_NALGS][nitems(g_libs)];
+  uint32_t duration = 1000;
+  size_t len = CONFIG_BENCHMARK_CRYPTOBENCH_BUFSIZE;
+  FAR uint8_t *in;
+  FAR uint8_t *out;
+  int option;
+  int alg;
+  int i;
+
+  while ((option = getopt(argc, argv, "s:t:h")) != ERROR)
+    {
+      switch (option)
+        {
+          case 's':
+            len = strtoul(optarg, NULL, 0);
+            break;
+          case 't':
+            duration = strtoul(optarg, NULL, 0);
+            break;
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+          default:
+            show_usage(argv[0], EXIT_FAILURE);
+            break;
+        }
+    }
+
+  /* AES-CBC needs whole blocks */
+
+  len = (len + 15) & ~15;
+  if (len == 0 || g_libs[0] == NULL)
+    {
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  in  = malloc(len);
+  out = malloc(len + CRYPTOBENCH_OVERHEAD);
+  if (in == NULL || out == NULL)
+    {
+      printf(CRYPTOBENCH_PREFIX "Out of memory\n");
+      free(in);
+      free(out);
+      return EXIT_FAILURE;
+    }
+
+  cryptobench_rng(in, len);
+
+  for (i = 0; g_libs[i] != NULL; i++)
+    {
+      FAR const struct cryptobench_lib_s *lib = g_libs[i];
+      bool ready = lib->init == NULL || lib->init() == 0;
+
+      printf(CRYPTOBENCH_PREFIX "%s%s\n", lib->name,
+             ready ? "" : ": init failed");
+
+      for (alg = 0; alg < CRYPTOBENCH_NALGS; alg++)
+        {
+          rate[alg][i] = lib->op[alg] == NULL ? INT32_MIN :
+                         !ready ? -1 :
+                         measure(lib->op[alg], alg, in, out, len, duration);
+        }
+
+      if (ready && lib->deinit != NULL)
+        {
+          lib->deinit();
+        }
+    }
+
+  /* One row per algorithm, one column per library */
+
+  printf("\n%-14s", "");
+  for (i = 0; g_libs[i] != NULL; i++)
+    {
+      printf(" %11.11s", g_libs[i]->name);
+    }
+
+  printf("\n");
+  for (alg = 0; alg < CRYPTOBENCH_NALGS; alg++)
+    {
+      printf("%-14s", g_alg_names[alg]);
+      for (i = 0; g_libs[i] != NULL; i++)
+        {
+          if (rate[alg][i] == INT32_MIN)
+            {
+              printf(" %11s", "-");
+            }
+          else if (rate[alg][i] < 0)
+            {
+              printf(" %11s", "error");
+            }
+          else
+            {
+              printf(" %11" PRId32, rate[alg][i]);
+            }
+        }
+
+      printf(" %s\n", alg < CRYPTOBENCH_NBULK ? "KB/s" : "ops/s");
+    }
+
+  printf("\n%zu bytes per bulk operation\n", len);
+
+  free(in);
+  free(out);
+  return EXIT_SUCCESS;
+}
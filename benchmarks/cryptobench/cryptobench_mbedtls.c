@@ -0,0 +1,263 @@
+/****************************************************************************
+ * apps/benchmarks/cryptobench/cryptobench_mbedtls.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <string.h>
+
+#include <mbedtls/aes.h>
+#include <mbedtls/chachapoly.h>
+#include <mbedtls/ecdh.h>
+#include <mbedtls/ecdsa.h>
+#include <mbedtls/gcm.h>
+#include <mbedtls/md.h>
+#include <mbedtls/sha256.h>
+
+#include "cryptobench.h"
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_CIPHER_MODE_CBC)
+static mbedtls_aes_context g_aes;
+#endif
+#ifdef MBEDTLS_GCM_C
+static mbedtls_gcm_context g_gcm;
+#endif
+#ifdef MBEDTLS_CHACHAPOLY_C
+static mbedtls_chachapoly_context g_chachapoly;
+#endif
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+static mbedtls_ecdsa_context g_ecdsa;
+static unsigned char g_sig[MBEDTLS_ECDSA_MAX_LEN];
+static size_t g_siglen;
+#endif
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
+static mbedtls_ecp_group g_x25519;
+static mbedtls_mpi g_secret;
+static mbedtls_mpi g_shared;
+static mbedtls_ecp_point g_peer;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int mbedtls_bench_rng(FAR void *arg, FAR unsigned char *buf,
+                             size_t len)
+{
+  cryptobench_rng(buf, len);
+  return 0;
+}
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_CIPHER_MODE_CBC)
+static int mbedtls_bench_cbc(FAR const uint8_t *in, FAR uint8_t *out,
+                             size_t len)
+{
+  unsigned char iv[16];
+
+  memcpy(iv, g_cryptobench_iv, sizeof(iv));
+  return mbedtls_aes_crypt_cbc(&g_aes, MBEDTLS_AES_ENCRYPT, len, iv,
+                               in, out);
+}
+#endif
+
+#ifdef MBEDTLS_GCM_C
+static int mbedtls_bench_gcm(FAR const uint8_t *in, FAR uint8_t *out,
+                             size_t len)
+{
+  return mbedtls_gcm_crypt_and_tag(&g_gcm, MBEDTLS_GCM_ENCRYPT, len,
+                                   g_cryptobench_iv, 12, NULL, 0,
+                                   in, out, 16, out + len);
+}
+#endif
+
+#ifdef MBEDTLS_CHACHAPOLY_C
+static int mbedtls_bench_chachapoly(FAR const uint8_t *in,
+                                    FAR uint8_t *out, size_t len)
+{
+  return mbedtls_chachapoly_encrypt_and_tag(&g_chachapoly, len,
+                                            g_cryptobench_iv, NULL, 0,
+                                            in, out, out + len);
+}
+#endif
+
+#ifdef MBEDTLS_SHA256_C
+static int mbedtls_bench_sha256(FAR const uint8_t *in, FAR uint8_t *out,
+                                size_t len)
+{
+  return mbedtls_sha256(in, len, out, 0);
+}
+#endif
+
+#if defined(MBEDTLS_MD_C) && defined(MBEDTLS_SHA256_C)
+static int mbedtls_bench_hmac(FAR const uint8_t *in, FAR uint8_t *out,
+                              size_t len)
+{
+  return mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                         g_cryptobench_key, sizeof(g_cryptobench_key),
+                         in, len, out);
+}
+#endif
+
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+static int mbedtls_bench_sign(FAR const uint8_t *in, FAR uint8_t *out,
+                              size_t len)
+{
+  size_t siglen;
+
+  return mbedtls_ecdsa_write_signature(&g_ecdsa, MBEDTLS_MD_SHA256,
+                                       g_cryptobench_key, 32, out,
+                                       len + CRYPTOBENCH_OVERHEAD, &siglen,
+                                       mbedtls_bench_rng, NULL);
+}
+
+static int mbedtls_bench_verify(FAR const uint8_t *in, FAR uint8_t *out,
+                                size_t len)
+{
+  return mbedtls_ecdsa_read_signature(&g_ecdsa, g_cryptobench_key, 32,
+                                      g_sig, g_siglen);
+}
+#endif
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
+static int mbedtls_bench_x25519(FAR const uint8_t *in, FAR uint8_t *out,
+                                size_t len)
+{
+  return mbedtls_ecdh_compute_shared(&g_x25519, &g_shared, &g_peer,
+                                     &g_secret, mbedtls_bench_rng, NULL);
+}
+#endif
+
+static int mbedtls_bench_init(void)
+{
+  int ret = 0;
+
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_CIPHER_MODE_CBC)
+  mbedtls_aes_init(&g_aes);
+  ret |= mbedtls_aes_setkey_enc(&g_aes, g_cryptobench_key, 128);
+#endif
+
+#ifdef MBEDTLS_GCM_C
+  mbedtls_gcm_init(&g_gcm);
+  ret |= mbedtls_gcm_setkey(&g_gcm, MBEDTLS_CIPHER_ID_AES,
+                            g_cryptobench_key, 128);
+#endif
+
+#ifdef MBEDTLS_CHACHAPOLY_C
+  mbedtls_chachapoly_init(&g_chachapoly);
+  ret |= mbedtls_chachapoly_setkey(&g_chachapoly, g_cryptobench_key);
+#endif
+
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+  /* The key stands in for the SHA-256 digest to sign */
+
+  mbedtls_ecdsa_init(&g_ecdsa);
+  ret |= mbedtls_ecdsa_genkey(&g_ecdsa, MBEDTLS_ECP_DP_SECP256R1,
+                              mbedtls_bench_rng, NULL);
+  ret |= mbedtls_ecdsa_write_signature(&g_ecdsa, MBEDTLS_MD_SHA256,
+                                       g_cryptobench_key, 32, g_sig,
+                                       sizeof(g_sig), &g_siglen,
+                                       mbedtls_bench_rng, NULL);
+#endif
+
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
+  {
+    mbedtls_mpi peer;
+
+    mbedtls_ecp_group_init(&g_x25519);
+    mbedtls_mpi_init(&g_secret);
+    mbedtls_mpi_init(&g_shared);
+    mbedtls_mpi_init(&peer);
+    mbedtls_ecp_point_init(&g_peer);
+
+    ret |= mbedtls_ecp_group_load(&g_x25519, MBEDTLS_ECP_DP_CURVE25519);
+    ret |= mbedtls_ecp_gen_privkey(&g_x25519, &g_secret,
+                                   mbedtls_bench_rng, NULL);
+    ret |= mbedtls_ecdh_gen_public(&g_x25519, &peer, &g_peer,
+                                   mbedtls_bench_rng, NULL);
+    mbedtls_mpi_free(&peer);
+  }
+#endif
+
+  return ret;
+}
+
+static void mbedtls_bench_deinit(void)
+{
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_CIPHER_MODE_CBC)
+  mbedtls_aes_free(&g_aes);
+#endif
+#ifdef MBEDTLS_GCM_C
+  mbedtls_gcm_free(&g_gcm);
+#endif
+#ifdef MBEDTLS_CHACHAPOLY_C
+  mbedtls_chachapoly_free(&g_chachapoly);
+#endif
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+  mbedtls_ecdsa_free(&g_ecdsa);
+#endif
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
+  mbedtls_ecp_group_free(&g_x25519);
+  mbedtls_mpi_free(&g_secret);
+  mbedtls_mpi_free(&g_shared);
+  mbedtls_ecp_point_free(&g_peer);
+#endif
+}
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+const struct cryptobench_lib_s g_cryptobench_mbedtls =
+{
+  "mbedtls",
+  mbedtls_bench_init,
+  mbedtls_bench_deinit,
+  {
+#if defined(MBEDTLS_AES_C) && defined(MBEDTLS_CIPHER_MODE_CBC)
+    [CRYPTOBENCH_AES_CBC]      = mbedtls_bench_cbc,
+#endif
+#ifdef MBEDTLS_GCM_C
+    [CRYPTOBENCH_AES_GCM]      = mbedtls_bench_gcm,
+#endif
+#ifdef MBEDTLS_CHACHAPOLY_C
+    [CRYPTOBENCH_CHACHAPOLY]   = mbedtls_bench_chachapoly,
+#endif
+#ifdef MBEDTLS_SHA256_C
+    [CRYPTOBENCH_SHA256]       = mbedtls_bench_sha256,
+#endif
+#if defined(MBEDTLS_MD_C) && defined(MBEDTLS_SHA256_C)
+    [CRYPTOBENCH_HMAC]         = mbedtls_bench_hmac,
+#endif
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+    [CRYPTOBENCH_ECDSA_SIGN]   = mbedtls_bench_sign,
+    [CRYPTOBENCH_ECDSA_VERIFY] = mbedtls_bench_verify,
+#endif
+#if defined(MBEDTLS_ECDH_C) && defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
+    [CRYPTOBENCH_X25519]       = mbedtls_bench_x25519,
+#endif
+  }
+};
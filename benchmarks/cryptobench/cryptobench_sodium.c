@@ -0,0 +1,104 @@
+/****************************************************************************
+ * apps/benchmarks/cryptobench/cryptobench_sodium.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sodium.h>
+
+#include "cryptobench.h"
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static unsigned char g_secret[crypto_scalarmult_SCALARBYTES];
+static unsigned char g_peer[crypto_scalarmult_BYTES];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int sodium_bench_chachapoly(FAR const uint8_t *in, FAR uint8_t *out,
+                                   size_t len)
+{
+  unsigned long long outlen;
+
+  return crypto_aead_chacha20poly1305_ietf_encrypt(out, &outlen, in, len,
+                                                   NULL, 0, NULL,
+                                                   g_cryptobench_iv,
+                                                   g_cryptobench_key);
+}
+
+static int sodium_bench_sha256(FAR const uint8_t *in, FAR uint8_t *out,
+                               size_t len)
+{
+  return crypto_hash_sha256(out, in, len);
+}
+
+static int sodium_bench_hmac(FAR const uint8_t *in, FAR uint8_t *out,
+                             size_t len)
+{
+  return crypto_auth_hmacsha256(out, in, len, g_cryptobench_key);
+}
+
+static int sodium_bench_x25519(FAR const uint8_t *in, FAR uint8_t *out,
+                               size_t len)
+{
+  return crypto_scalarmult(out, g_secret, g_peer);
+}
+
+static int sodium_bench_init(void)
+{
+  unsigned char secret[crypto_scalarmult_SCALARBYTES];
+
+  if (sodium_init() < 0)
+    {
+      return -1;
+    }
+
+  randombytes_buf(g_secret, sizeof(g_secret));
+  randombytes_buf(secret, sizeof(secret));
+  return crypto_scalarmult_base(g_peer, secret);
+}
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/* Libsodium only has AES-256-GCM, on CPUs with AES instructions, and
+ * Ed25519 signatures rather than ECDSA.
+ */
+
+const struct cryptobench_lib_s g_cryptobench_sodium =
+{
+  "libsodium",
+  sodium_bench_init,
+  NULL,
+  {
+    [CRYPTOBENCH_CHACHAPOLY]   = sodium_bench_chachapoly,
+    [CRYPTOBENCH_SHA256]       = sodium_bench_sha256,
+    [CRYPTOBENCH_HMAC]         = sodium_bench_hmac,
+    [CRYPTOBENCH_X25519]       = sodium_bench_x25519,
+  }
+};
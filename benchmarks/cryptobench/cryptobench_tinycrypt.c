@@ -0,0 +1,179 @@
+/****************************************************************************
+ * apps/benchmarks/cryptobench/cryptobench_tinycrypt.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <tinycrypt/aes.h>
+#include <tinycrypt/cbc_mode.h>
+#include <tinycrypt/constants.h>
+#include <tinycrypt/ecc.h>
+#include <tinycrypt/ecc_dsa.h>
+#include <tinycrypt/hmac.h>
+#include <tinycrypt/sha256.h>
+
+#include "cryptobench.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if defined(CONFIG_TINYCRYPT_AES) && defined(CONFIG_TINYCRYPT_AES_CBC)
+#  define TINYCRYPT_BENCH_CBC
+#endif
+
+#if defined(CONFIG_TINYCRYPT_SHA256) && defined(CONFIG_TINYCRYPT_SHA256_HMAC)
+#  define TINYCRYPT_BENCH_HMAC
+#endif
+
+/* TinyCrypt returns TC_CRYPTO_SUCCESS (1) on success */
+
+#define TC_RESULT(r) ((r) == TC_CRYPTO_SUCCESS ? 0 : -1)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef TINYCRYPT_BENCH_CBC
+static struct tc_aes_key_sched_struct g_sched;
+#endif
+#ifdef TINYCRYPT_BENCH_HMAC
+static struct tc_hmac_state_struct g_hmac;
+#endif
+#ifdef CONFIG_TINYCRYPT_ECC_DSA
+static uint8_t g_public[2 * NUM_ECC_BYTES];
+static uint8_t g_private[NUM_ECC_BYTES];
+static uint8_t g_sig[2 * NUM_ECC_BYTES];
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef TINYCRYPT_BENCH_CBC
+static int tinycrypt_bench_cbc(FAR const uint8_t *in, FAR uint8_t *out,
+                               size_t len)
+{
+  /* The output starts with the IV, which uses TC_AES_BLOCK_SIZE of the
+   * overhead.
+   */
+
+  return TC_RESULT(tc_cbc_mode_encrypt(out, len + TC_AES_BLOCK_SIZE, in,
+                                       len, g_cryptobench_iv, &g_sched));
+}
+#endif
+
+#ifdef CONFIG_TINYCRYPT_SHA256
+static int tinycrypt_bench_sha256(FAR const uint8_t *in, FAR uint8_t *out,
+                                  size_t len)
+{
+  struct tc_sha256_state_struct s;
+
+  tc_sha256_init(&s);
+  tc_sha256_update(&s, in, len);
+  return TC_RESULT(tc_sha256_final(out, &s));
+}
+#endif
+
+#ifdef TINYCRYPT_BENCH_HMAC
+static int tinycrypt_bench_hmac(FAR const uint8_t *in, FAR uint8_t *out,
+                                size_t len)
+{
+  tc_hmac_init(&g_hmac);
+  tc_hmac_update(&g_hmac, in, len);
+  return TC_RESULT(tc_hmac_final(out, TC_SHA256_DIGEST_SIZE, &g_hmac));
+}
+#endif
+
+#ifdef CONFIG_TINYCRYPT_ECC_DSA
+static int tinycrypt_bench_rng(FAR uint8_t *dest, unsigned int size)
+{
+  cryptobench_rng(dest, size);
+  return 1;
+}
+
+static int tinycrypt_bench_sign(FAR const uint8_t *in, FAR uint8_t *out,
+                                size_t len)
+{
+  return TC_RESULT(uECC_sign(g_private, g_cryptobench_key, 32, out,
+                             uECC_secp256r1()));
+}
+
+static int tinycrypt_bench_verify(FAR const uint8_t *in, FAR uint8_t *out,
+                                  size_t len)
+{
+  return TC_RESULT(uECC_verify(g_public, g_cryptobench_key, 32, g_sig,
+                               uECC_secp256r1()));
+}
+#endif
+
+static int tinycrypt_bench_init(void)
+{
+  int ret = 0;
+
+#ifdef TINYCRYPT_BENCH_CBC
+  ret |= TC_RESULT(tc_aes128_set_encrypt_key(&g_sched, g_cryptobench_key));
+#endif
+
+#ifdef TINYCRYPT_BENCH_HMAC
+  ret |= TC_RESULT(tc_hmac_set_key(&g_hmac, g_cryptobench_key,
+                                   sizeof(g_cryptobench_key)));
+#endif
+
+#ifdef CONFIG_TINYCRYPT_ECC_DSA
+  /* The key stands in for the SHA-256 digest to sign */
+
+  uECC_set_rng(tinycrypt_bench_rng);
+  ret |= TC_RESULT(uECC_make_key(g_public, g_private, uECC_secp256r1()));
+  ret |= TC_RESULT(uECC_sign(g_private, g_cryptobench_key, 32, g_sig,
+                             uECC_secp256r1()));
+#endif
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+const struct cryptobench_lib_s g_cryptobench_tinycrypt =
+{
+  "tinycrypt",
+  tinycrypt_bench_init,
+  NULL,
+  {
+#ifdef TINYCRYPT_BENCH_CBC
+    [CRYPTOBENCH_AES_CBC]      = tinycrypt_bench_cbc,
+#endif
+#ifdef CONFIG_TINYCRYPT_SHA256
+    [CRYPTOBENCH_SHA256]       = tinycrypt_bench_sha256,
+#endif
+#ifdef TINYCRYPT_BENCH_HMAC
+    [CRYPTOBENCH_HMAC]         = tinycrypt_bench_hmac,
+#endif
+#ifdef CONFIG_TINYCRYPT_ECC_DSA
+    [CRYPTOBENCH_ECDSA_SIGN]   = tinycrypt_bench_sign,
+    [CRYPTOBENCH_ECDSA_VERIFY] = tinycrypt_bench_verify,
+#endif
+  }
+};
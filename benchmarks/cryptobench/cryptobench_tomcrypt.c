@@ -0,0 +1,189 @@
+/****************************************************************************
+ * apps/benchmarks/cryptobench/cryptobench_tomcrypt.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <tomcrypt.h>
+
+#include "cryptobench.h"
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static symmetric_CBC g_cbc;
+static ecc_key g_ecc;
+static unsigned char g_sig[2 * 32 + 16];
+static unsigned long g_siglen;
+static int g_aes;
+static int g_sha256;
+static int g_prng;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int tomcrypt_bench_cbc(FAR const uint8_t *in, FAR uint8_t *out,
+                              size_t len)
+{
+  int ret;
+
+  ret = cbc_setiv(g_cryptobench_iv, 16, &g_cbc);
+  if (ret == CRYPT_OK)
+    {
+      ret = cbc_encrypt(in, out, len, &g_cbc);
+    }
+
+  return ret;
+}
+
+static int tomcrypt_bench_gcm(FAR const uint8_t *in, FAR uint8_t *out,
+                              size_t len)
+{
+  unsigned long taglen = 16;
+
+  return gcm_memory(g_aes, g_cryptobench_key, 16, g_cryptobench_iv, 12,
+                    NULL, 0, (FAR unsigned char *)in, len, out, out + len,
+                    &taglen, GCM_ENCRYPT);
+}
+
+static int tomcrypt_bench_chachapoly(FAR const uint8_t *in,
+                                     FAR uint8_t *out, size_t len)
+{
+  unsigned long taglen = 16;
+
+  return chacha20poly1305_memory(g_cryptobench_key, 32, g_cryptobench_iv,
+                                 12, NULL, 0, in, len, out, out + len,
+                                 &taglen, CHACHA20POLY1305_ENCRYPT);
+}
+
+static int tomcrypt_bench_sha256(FAR const uint8_t *in, FAR uint8_t *out,
+                                 size_t len)
+{
+  unsigned long outlen = 32;
+
+  return hash_memory(g_sha256, in, len, out, &outlen);
+}
+
+static int tomcrypt_bench_hmac(FAR const uint8_t *in, FAR uint8_t *out,
+                               size_t len)
+{
+  unsigned long outlen = 32;
+
+  return hmac_memory(g_sha256, g_cryptobench_key, 32, in, len,
+                     out, &outlen);
+}
+
+static int tomcrypt_bench_sign(FAR const uint8_t *in, FAR uint8_t *out,
+                               size_t len)
+{
+  unsigned long siglen = len + CRYPTOBENCH_OVERHEAD;
+
+  return ecc_sign_hash(g_cryptobench_key, 32, out, &siglen, NULL,
+                       g_prng, &g_ecc);
+}
+
+static int tomcrypt_bench_verify(FAR const uint8_t *in, FAR uint8_t *out,
+                                 size_t len)
+{
+  int valid = 0;
+  int ret;
+
+  ret = ecc_verify_hash(g_sig, g_siglen, g_cryptobench_key, 32, &valid,
+                        &g_ecc);
+  return ret != CRYPT_OK ? ret : !valid;
+}
+
+static int tomcrypt_bench_init(void)
+{
+  int ret;
+
+  ltc_mp = ltm_desc;
+  register_cipher(&aes_desc);
+  register_hash(&sha256_desc);
+  register_prng(&sprng_desc);
+
+  g_aes    = find_cipher("aes");
+  g_sha256 = find_hash("sha256");
+  g_prng   = find_prng("sprng");
+  if (g_aes < 0 || g_sha256 < 0 || g_prng < 0)
+    {
+      return -1;
+    }
+
+  ret = cbc_start(g_aes, g_cryptobench_iv, g_cryptobench_key, 16, 0,
+                  &g_cbc);
+  if (ret != CRYPT_OK)
+    {
+      return ret;
+    }
+
+  /* A 32 bytes key is P-256, the AES key stands in for its digest */
+
+  ret = ecc_make_key(NULL, g_prng, 32, &g_ecc);
+  if (ret != CRYPT_OK)
+    {
+      cbc_done(&g_cbc);
+      return ret;
+    }
+
+  g_siglen = sizeof(g_sig);
+  ret = ecc_sign_hash(g_cryptobench_key, 32, g_sig, &g_siglen, NULL,
+                      g_prng, &g_ecc);
+  if (ret != CRYPT_OK)
+    {
+      ecc_free(&g_ecc);
+      cbc_done(&g_cbc);
+    }
+
+  return ret;
+}
+
+static void tomcrypt_bench_deinit(void)
+{
+  ecc_free(&g_ecc);
+  cbc_done(&g_cbc);
+}
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/* LibTomCrypt 1.18 has no X25519 */
+
+const struct cryptobench_lib_s g_cryptobench_tomcrypt =
+{
+  "libtomcrypt",
+  tomcrypt_bench_init,
+  tomcrypt_bench_deinit,
+  {
+    [CRYPTOBENCH_AES_CBC]      = tomcrypt_bench_cbc,
+    [CRYPTOBENCH_AES_GCM]      = tomcrypt_bench_gcm,
+    [CRYPTOBENCH_CHACHAPOLY]   = tomcrypt_bench_chachapoly,
+    [CRYPTOBENCH_SHA256]       = tomcrypt_bench_sha256,
+    [CRYPTOBENCH_HMAC]         = tomcrypt_bench_hmac,
+    [CRYPTOBENCH_ECDSA_SIGN]   = tomcrypt_bench_sign,
+    [CRYPTOBENCH_ECDSA_VERIFY] = tomcrypt_bench_verify,
+  }
+};
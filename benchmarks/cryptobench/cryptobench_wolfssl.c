@@ -0,0 +1,260 @@
+/****************************************************************************
+ * apps/benchmarks/cryptobench/cryptobench_wolfssl.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <wolfssl/wolfcrypt/settings.h>
+#include <wolfssl/wolfcrypt/aes.h>
+#include <wolfssl/wolfcrypt/chacha20_poly1305.h>
+#include <wolfssl/wolfcrypt/curve25519.h>
+#include <wolfssl/wolfcrypt/ecc.h>
+#include <wolfssl/wolfcrypt/hmac.h>
+#include <wolfssl/wolfcrypt/random.h>
+#include <wolfssl/wolfcrypt/sha256.h>
+
+#include "cryptobench.h"
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static WC_RNG g_rng;
+
+#if !defined(NO_AES) && defined(HAVE_AES_CBC)
+static Aes g_aes;
+#endif
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+static Aes g_gcm;
+#endif
+#if !defined(NO_HMAC) && !defined(NO_SHA256)
+static Hmac g_hmac;
+#endif
+#ifdef HAVE_ECC
+static ecc_key g_ecc;
+static byte g_sig[ECC_MAX_SIG_SIZE];
+static word32 g_siglen;
+#endif
+#ifdef HAVE_CURVE25519
+static curve25519_key g_secret;
+static curve25519_key g_peer;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#if !defined(NO_AES) && defined(HAVE_AES_CBC)
+static int wolfssl_bench_cbc(FAR const uint8_t *in, FAR uint8_t *out,
+                             size_t len)
+{
+  int ret;
+
+  ret = wc_AesSetIV(&g_aes, g_cryptobench_iv);
+  if (ret == 0)
+    {
+      ret = wc_AesCbcEncrypt(&g_aes, out, in, len);
+    }
+
+  return ret;
+}
+#endif
+
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+static int wolfssl_bench_gcm(FAR const uint8_t *in, FAR uint8_t *out,
+                             size_t len)
+{
+  return wc_AesGcmEncrypt(&g_gcm, out, in, len, g_cryptobench_iv, 12,
+                          out + len, 16, NULL, 0);
+}
+#endif
+
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+static int wolfssl_bench_chachapoly(FAR const uint8_t *in,
+                                    FAR uint8_t *out, size_t len)
+{
+  return wc_ChaCha20Poly1305_Encrypt(g_cryptobench_key, g_cryptobench_iv,
+                                     NULL, 0, in, len, out, out + len);
+}
+#endif
+
+#ifndef NO_SHA256
+static int wolfssl_bench_sha256(FAR const uint8_t *in, FAR uint8_t *out,
+                                size_t len)
+{
+  return wc_Sha256Hash(in, len, out);
+}
+#endif
+
+#if !defined(NO_HMAC) && !defined(NO_SHA256)
+static int wolfssl_bench_hmac(FAR const uint8_t *in, FAR uint8_t *out,
+                              size_t len)
+{
+  int ret;
+
+  /* wc_HmacFinal() leaves the context keyed for the next message */
+
+  ret = wc_HmacUpdate(&g_hmac, in, len);
+  if (ret == 0)
+    {
+      ret = wc_HmacFinal(&g_hmac, out);
+    }
+
+  return ret;
+}
+#endif
+
+#ifdef HAVE_ECC
+static int wolfssl_bench_sign(FAR const uint8_t *in, FAR uint8_t *out,
+                              size_t len)
+{
+  word32 siglen = len + CRYPTOBENCH_OVERHEAD;
+
+  return wc_ecc_sign_hash(g_cryptobench_key, 32, out, &siglen, &g_rng,
+                          &g_ecc);
+}
+
+static int wolfssl_bench_verify(FAR const uint8_t *in, FAR uint8_t *out,
+                                size_t len)
+{
+  int valid = 0;
+  int ret;
+
+  ret = wc_ecc_verify_hash(g_sig, g_siglen, g_cryptobench_key, 32,
+                           &valid, &g_ecc);
+  return ret != 0 ? ret : !valid;
+}
+#endif
+
+#ifdef HAVE_CURVE25519
+static int wolfssl_bench_x25519(FAR const uint8_t *in, FAR uint8_t *out,
+                                size_t len)
+{
+  word32 outlen = CURVE25519_KEYSIZE;
+
+  return wc_curve25519_shared_secret(&g_secret, &g_peer, out, &outlen);
+}
+#endif
+
+static int wolfssl_bench_init(void)
+{
+  int ret;
+
+  ret = wc_InitRng(&g_rng);
+
+#if !defined(NO_AES) && defined(HAVE_AES_CBC)
+  ret |= wc_AesInit(&g_aes, NULL, INVALID_DEVID);
+  ret |= wc_AesSetKey(&g_aes, g_cryptobench_key, 16, g_cryptobench_iv,
+                      AES_ENCRYPTION);
+#endif
+
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+  ret |= wc_AesInit(&g_gcm, NULL, INVALID_DEVID);
+  ret |= wc_AesGcmSetKey(&g_gcm, g_cryptobench_key, 16);
+#endif
+
+#if !defined(NO_HMAC) && !defined(NO_SHA256)
+  ret |= wc_HmacInit(&g_hmac, NULL, INVALID_DEVID);
+  ret |= wc_HmacSetKey(&g_hmac, WC_SHA256, g_cryptobench_key,
+                       sizeof(g_cryptobench_key));
+#endif
+
+#ifdef HAVE_ECC
+  /* The key stands in for the SHA-256 digest to sign */
+
+  g_siglen = sizeof(g_sig);
+  ret |= wc_ecc_init(&g_ecc);
+  ret |= wc_ecc_make_key_ex(&g_rng, 32, &g_ecc, ECC_SECP256R1);
+#ifdef ECC_TIMING_RESISTANT
+  ret |= wc_ecc_set_rng(&g_ecc, &g_rng);
+#endif
+  ret |= wc_ecc_sign_hash(g_cryptobench_key, 32, g_sig, &g_siglen,
+                          &g_rng, &g_ecc);
+#endif
+
+#ifdef HAVE_CURVE25519
+  ret |= wc_curve25519_init(&g_secret);
+  ret |= wc_curve25519_init(&g_peer);
+  ret |= wc_curve25519_make_key(&g_rng, CURVE25519_KEYSIZE, &g_secret);
+  ret |= wc_curve25519_make_key(&g_rng, CURVE25519_KEYSIZE, &g_peer);
+#endif
+
+  return ret;
+}
+
+static void wolfssl_bench_deinit(void)
+{
+#if !defined(NO_AES) && defined(HAVE_AES_CBC)
+  wc_AesFree(&g_aes);
+#endif
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+  wc_AesFree(&g_gcm);
+#endif
+#if !defined(NO_HMAC) && !defined(NO_SHA256)
+  wc_HmacFree(&g_hmac);
+#endif
+#ifdef HAVE_ECC
+  wc_ecc_free(&g_ecc);
+#endif
+#ifdef HAVE_CURVE25519
+  wc_curve25519_free(&g_secret);
+  wc_curve25519_free(&g_peer);
+#endif
+
+  wc_FreeRng(&g_rng);
+}
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+const struct cryptobench_lib_s g_cryptobench_wolfssl =
+{
+  "wolfssl",
+  wolfssl_bench_init,
+  wolfssl_bench_deinit,
+  {
+#if !defined(NO_AES) && defined(HAVE_AES_CBC)
+    [CRYPTOBENCH_AES_CBC]      = wolfssl_bench_cbc,
+#endif
+#if !defined(NO_AES) && defined(HAVE_AESGCM)
+    [CRYPTOBENCH_AES_GCM]      = wolfssl_bench_gcm,
+#endif
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+    [CRYPTOBENCH_CHACHAPOLY]   = wolfssl_bench_chachapoly,
+#endif
+#ifndef NO_SHA256
+    [CRYPTOBENCH_SHA256]       = wolfssl_bench_sha256,
+#endif
+#if !defined(NO_HMAC) && !defined(NO_SHA256)
+    [CRYPTOBENCH_HMAC]         = wolfssl_bench_hmac,
+#endif
+#ifdef HAVE_ECC
+    [CRYPTOBENCH_ECDSA_SIGN]   = wolfssl_bench_sign,
+    [CRYPTOBENCH_ECDSA_VERIFY] = wolfssl_bench_verify,
+#endif
+#ifdef HAVE_CURVE25519
+    [CRYPTOBENCH_X25519]       = wolfssl_bench_x25519,
+#endif
+  }
+};
@@ -0,0 +1,541 @@
+/****************************************************************************
+ * apps/benchmarks/nnbench/nnbench_main.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nnablart/network.h>
+#include <nnablart/runtime.h>
+
+#include "runtime_internal.h"
+
+#ifdef CONFIG_NNABLA_RT_PLANNER
+#  include "mlearning/nnablart_planner.h"
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct nnbench_s
+{
+  FAR rt_context_t *context;
+  FAR clock_t *layers;       /* Time spent in each layer over all runs */
+  FAR clock_t *runs;         /* Time of each run */
+  size_t base;               /* Heap used before the context is created */
+  size_t peak;               /* Heap used at most during the inferences */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nnbench_heapused
+ ****************************************************************************/
+
+static size_t nnbench_heapused(void)
+{
+  struct mallinfo info = mallinfo();
+
+  return info.uordblks;
+}
+
+/****************************************************************************
+ * Name: nnbench_usec
+ ****************************************************************************/
+
+static unsigned long nnbench_usec(clock_t elapsed)
+{
+  struct timespec ts;
+
+  perf_convert(elapsed, &ts);
+  return ts.tv_sec * 1000000ul + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: nnbench_load
+ *
+ * Description:
+ *   Read a whole file.  An .nnb model is used as is by the runtime, which
+ *   relocates its offsets in place.
+ *
+ ****************************************************************************/
+
+static FAR void *nnbench_load(FAR const char *path, FAR size_t *size)
+{
+  FAR uint8_t *buf;
+  ssize_t nread;
+  off_t len;
+  size_t pos;
+  int fd;
+
+  fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    {
+      return NULL;
+    }
+
+  len = lseek(fd, 0, SEEK_END);
+  if (len <= 0 || lseek(fd, 0, SEEK_SET) < 0)
+    {
+      close(fd);
+      errno = EINVAL;
+      return NULL;
+    }
+
+  buf = malloc(len);
+  if (buf == NULL)
+    {
+      close(fd);
+      return NULL;
+    }
+
+  for (pos = 0; pos < len; pos += nread)
+    {
+      nread = read(fd, buf + pos, len - pos);
+      if (nread <= 0)
+        {
+          if (nread < 0 && errno == EINTR)
+            {
+              nread = 0;
+              continue;
+            }
+
+          free(buf);
+          close(fd);
+          errno = nread < 0 ? errno : EINVAL;
+          return NULL;
+        }
+    }
+
+  close(fd);
+  *size = len;
+  return buf;
+}
+
+/****************************************************************************
+ * Name: nnbench_elemsize
+ ****************************************************************************/
+
+static size_t nnbench_elemsize(nn_data_type_t type)
+{
+  switch (type)
+    {
+      case NN_DATA_TYPE_FLOAT:
+        return sizeof(float);
+
+      case NN_DATA_TYPE_INT16:
+        return sizeof(int16_t);
+
+      default:
+        return sizeof(int8_t);
+    }
+}
+
+/****************************************************************************
+ * Name: nnbench_input
+ *
+ * Description:
+ *   Fill the inputs of the network, the first one from a recorded raw
+ *   file if given, the others with pseudo random values.
+ *
+ ****************************************************************************/
+
+static int nnbench_input(rt_context_pointer context, FAR const char *path)
+{
+  FAR rt_variable_t *var;
+  FAR uint8_t *data;
+  size_t elemsize;
+  size_t count;
+  size_t size;
+  size_t i;
+  int n;
+
+  srand(1);
+  for (n = 0; n < rt_num_of_input(context); n++)
+    {
+      var      = rt_input_variable(context, n);
+      count    = rt_input_size(context, n);
+      elemsize = nnbench_elemsize(var->type);
+
+      if (n == 0 && path != NULL)
+        {
+          data = nnbench_load(path, &size);
+          if (data == NULL)
+            {
+              fprintf(stderr, "nnbench: cannot read %s: %d\n", path, errno);
+              return -1;
+            }
+
+          if (size != count * elemsize)
+            {
+              fprintf(stderr, "nnbench: %s has %zu bytes, %zu expected\n",
+                      path, size, count * elemsize);
+              free(data);
+              return -1;
+            }
+
+          memcpy(var->data, data, size);
+          free(data);
+          continue;
+        }
+
+      for (i = 0; i < count; i++)
+        {
+          switch (var->type)
+            {
+              case NN_DATA_TYPE_FLOAT:
+                ((FAR float *)var->data)[i] = (float)rand() / RAND_MAX;
+                break;
+
+              case NN_DATA_TYPE_INT16:
+                ((FAR int16_t *)var->data)[i] = rand() & 0x7fff;
+                break;
+
+              default:
+                ((FAR int8_t *)var->data)[i] = rand() & 0x7f;
+                break;
+            }
+        }
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: nnbench_forward
+ *
+ * Description:
+ *   Same as rt_forward(), with each function of the network timed.
+ *
+ ****************************************************************************/
+
+static int nnbench_forward(FAR struct nnbench_s *bench, FAR clock_t *total)
+{
+  FAR rt_context_t *c = bench->context;
+  rt_return_value_t ret;
+  clock_t start;
+  clock_t elapsed;
+  size_t used;
+  int i;
+
+  *total = 0;
+  for (i = 0; i < c->num_of_functions; i++)
+    {
+      start   = perf_gettime();
+      ret     = c->functions[i].exec_func(&c->functions[i].func);
+      elapsed = perf_gettime() - start;
+
+      if (ret != RT_RET_NOERROR)
+        {
+          fprintf(stderr, "nnbench: layer %d failed: %d\n", i, ret);
+          return -1;
+        }
+
+      if (bench->layers != NULL)
+        {
+          bench->layers[i] += elapsed;
+        }
+
+      *total += elapsed;
+
+      used = nnbench_heapused();
+      if (used > bench->peak)
+        {
+          bench->peak = used;
+        }
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: nnbench_compare
+ ****************************************************************************/
+
+static int nnbench_compare(FAR const void *a, FAR const void *b)
+{
+  clock_t x = *(FAR const clock_t *)a;
+  clock_t y = *(FAR const clock_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+/****************************************************************************
+ * Name: nnbench_report
+ ****************************************************************************/
+
+static void nnbench_report(FAR struct nnbench_s *bench, int runs,
+                           size_t ctxsize, bool csv)
+{
+  FAR rt_context_t *c = bench->context;
+  uint64_t sum = 0;
+  clock_t avg;
+  int i;
+
+  qsort(bench->runs, runs, sizeof(clock_t), nnbench_compare);
+  for (i = 0; i < c->num_of_functions; i++)
+    {
+      sum += bench->layers[i];
+    }
+
+  if (csv)
+    {
+      printf("layer,type,cycles,us\n");
+      for (i = 0; i < c->num_of_functions; i++)
+        {
+          avg = bench->layers[i] / runs;
+          printf("%d,%d,%" PRIu64 ",%lu\n", i, c->functions[i].info->type,
+                 (uint64_t)avg, nnbench_usec(avg));
+        }
+
+      return;
+    }
+
+  printf("Context memory:  %zu bytes\n", ctxsize);
+  printf("Peak heap:       %zu bytes above the model\n",
+         bench->peak - bench->base);
+  printf("Latency (us):    min %lu p50 %lu p90 %lu p99 %lu max %lu\n\n",
+         nnbench_usec(bench->runs[0]),
+         nnbench_usec(bench->runs[runs / 2]),
+         nnbench_usec(bench->runs[runs * 90 / 100]),
+         nnbench_usec(bench->runs[runs * 99 / 100]),
+         nnbench_usec(bench->runs[runs - 1]));
+
+  printf("%5s %5s %12s %10s %6s\n", "Layer", "Type", "Cycles", "us", "%");
+  for (i = 0; i < c->num_of_functions; i++)
+    {
+      avg = bench->layers[i] / runs;
+      printf("%5d %5d %12" PRIu64 " %10lu %5" PRIu64 "%%\n",
+             i, c->functions[i].info->type, (uint64_t)avg,
+             nnbench_usec(avg),
+             sum ? (uint64_t)bench->layers[i] * 100 / sum : 0);
+    }
+}
+
+/****************************************************************************
+ * Name: nnbench_usage
+ ****************************************************************************/
+
+static void nnbench_usage(FAR const char *progname)
+{
+  fprintf(stderr, "Usage: %s [-n runs] [-w warmup] [-i input] [-c] [-p] "
+          "model.nnb\n", progname);
+  fprintf(stderr, "  -n  Number of measured inferences (default %d)\n",
+          CONFIG_BENCHMARK_NNBENCH_RUNS);
+  fprintf(stderr, "  -w  Number of warm-up inferences (default %d)\n",
+          CONFIG_BENCHMARK_NNBENCH_WARMUP);
+  fprintf(stderr, "  -i  Raw data for the first input "
+          "(default pseudo random)\n");
+  fprintf(stderr, "  -c  Print the layers as CSV, to compare builds\n");
+#ifdef CONFIG_NNABLA_RT_PLANNER
+  fprintf(stderr, "  -p  Plan the activation buffers before running\n");
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct nnbench_s bench;
+  rt_context_pointer context = NULL;
+  FAR const char *input = NULL;
+  FAR nn_network_t *network;
+  int warmup = CONFIG_BENCHMARK_NNBENCH_WARMUP;
+  int runs = CONFIG_BENCHMARK_NNBENCH_RUNS;
+  bool csv = false;
+  bool planner = false;
+  size_t ctxsize;
+  size_t size;
+  int ret = EXIT_FAILURE;
+  int opt;
+  int i;
+
+  while ((opt = getopt(argc, argv, "n:w:i:cph")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'n':
+            runs = atoi(optarg);
+            break;
+
+          case 'w':
+            warmup = atoi(optarg);
+            break;
+
+          case 'i':
+            input = optarg;
+            break;
+
+          case 'c':
+            csv = true;
+            break;
+
+          case 'p':
+            planner = true;
+            break;
+
+          default:
+            nnbench_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (optind != argc - 1 || runs <= 0 || warmup < 0)
+    {
+      nnbench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  network = nnbench_load(argv[optind], &size);
+  if (network == NULL)
+    {
+      fprintf(stderr, "nnbench: cannot read %s: %d\n", argv[optind], errno);
+      return EXIT_FAILURE;
+    }
+
+  if (planner)
+    {
+#ifdef CONFIG_NNABLA_RT_PLANNER
+      struct nnablart_plan_s plan;
+
+      ret = nnablart_plan(network, &plan);
+      if (ret < 0)
+        {
+          fprintf(stderr, "nnbench: planning failed: %d\n", ret);
+          free(network);
+          return EXIT_FAILURE;
+        }
+
+      if (!csv)
+        {
+          printf("Planned buffers: %d of %d, size %zu of %zu\n",
+                 plan.planned_buffers, plan.nbuffers, plan.planned_size,
+                 plan.size);
+        }
+
+      ret = EXIT_FAILURE;
+#else
+      fprintf(stderr, "nnbench: CONFIG_NNABLA_RT_PLANNER is disabled\n");
+      free(network);
+      return EXIT_FAILURE;
+#endif
+    }
+
+  memset(&bench, 0, sizeof(bench));
+  bench.base = nnbench_heapused();
+
+  if (rt_allocate_context(&context) != RT_RET_NOERROR ||
+      rt_initialize_context(context, network) != RT_RET_NOERROR)
+    {
+      fprintf(stderr, "nnbench: cannot initialize the runtime\n");
+      goto out;
+    }
+
+  ctxsize       = nnbench_heapused() - bench.base;
+  bench.context = context;
+  bench.layers  = calloc(bench.context->num_of_functions, sizeof(clock_t));
+  bench.runs    = malloc(runs * sizeof(clock_t));
+  if (bench.layers == NULL || bench.runs == NULL)
+    {
+      fprintf(stderr, "nnbench: out of memory\n");
+      goto out;
+    }
+
+  /* The measure buffers are allocated now, so that they are counted in
+   * the baseline and not in the peak of the runtime.
+   */
+
+  bench.base = nnbench_heapused();
+  bench.peak = bench.base;
+
+  if (nnbench_input(context, input) < 0)
+    {
+      goto out;
+    }
+
+  if (!csv)
+    {
+      printf("Model:           %s, %zu bytes, %d layers\n", argv[optind],
+             size, bench.context->num_of_functions);
+      printf("Inferences:      %d, after %d warm-up\n", runs, warmup);
+    }
+
+  /* Warm up without accounting the layers */
+
+  for (i = 0; i < warmup; i++)
+    {
+      FAR clock_t *layers = bench.layers;
+
+      bench.layers = NULL;
+      ret = nnbench_forward(&bench, &bench.runs[0]);
+      bench.layers = layers;
+      if (ret < 0)
+        {
+          ret = EXIT_FAILURE;
+          goto out;
+        }
+    }
+
+  for (i = 0; i < runs; i++)
+    {
+      if (nnbench_forward(&bench, &bench.runs[i]) < 0)
+        {
+          ret = EXIT_FAILURE;
+          goto out;
+        }
+    }
+
+  nnbench_report(&bench, runs, ctxsize, csv);
+  ret = EXIT_SUCCESS;
+
+out:
+  free(bench.runs);
+  free(bench.layers);
+  if (context != NULL)
+    {
+      rt_free_context(&context);
+    }
+
+  free(network);
+  return ret;
+}
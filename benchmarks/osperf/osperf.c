@@ -22,11 +22,18 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
 #include <limits.h>
+#include <mqueue.h>
 #include <pthread.h>
 #include <sched.h>
 #include <semaphore.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -35,13 +42,42 @@
 #include <string.h>
 #include <sys/param.h>
 #include <sys/poll.h>
+#include <unistd.h>
+
+#ifdef CONFIG_EVENT_FD
+#  include <sys/eventfd.h>
+#endif
 
 #include <nuttx/sched.h>
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define PERFORMANCE_THRESHOLD 10 /* Default regression threshold in percent */
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+enum performance_format_e
+{
+  PERFORMANCE_TEXT,
+  PERFORMANCE_JSON,
+  PERFORMANCE_CSV
+};
+
+struct performance_result_s
+{
+  bool valid;
+  size_t max;
+  size_t min;
+  size_t avg;
+  size_t p50;
+  size_t p99;
+  size_t jitter;
+};
+
 struct performance_time_s
 {
   clock_t start;
@@ -54,6 +90,13 @@ struct performance_thread_s
   struct performance_time_s time;
 };
 
+struct performance_cond_s
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int turn;
+};
+
 struct performance_entry_s
 {
   const char name[NAME_MAX];
@@ -71,6 +114,16 @@ static size_t hpwork_performance(void);
 static size_t poll_performance(void);
 static size_t semwait_performance(void);
 static size_t sempost_performance(void);
+static size_t mqueue_performance(void);
+#ifdef CONFIG_EVENT_FD
+static size_t eventfd_performance(void);
+#endif
+static size_t signal_performance(void);
+static size_t pipe_performance(void);
+static size_t condvar_performance(void);
+#ifdef CONFIG_SMP
+static size_t crosscpu_performance(void);
+#endif
 
 /****************************************************************************
  * Private Data
@@ -85,6 +138,16 @@ static const struct performance_entry_s g_entry_list[] =
   {"poll-write", poll_performance},
   {"semwait", semwait_performance},
   {"sempost", sempost_performance},
+  {"mqueue-wake", mqueue_performance},
+#ifdef CONFIG_EVENT_FD
+  {"eventfd-wake", eventfd_performance},
+#endif
+  {"signal-wake", signal_performance},
+  {"pipe-roundtrip", pipe_performance},
+  {"condvar-pingpong", condvar_performance},
+#ifdef CONFIG_SMP
+  {"crosscpu-wake", crosscpu_performance},
+#endif
 };
 
 /****************************************************************************
@@ -325,6 +388,285 @@ static size_t sempost_performance(void)
   return performance_gettime(&result);
 }
 
+/****************************************************************************
+ * mqueue performance
+ ****************************************************************************/
+
+static FAR void *mqueue_task(FAR void *arg)
+{
+  FAR void **argv = arg;
+  FAR struct performance_time_s *time = argv[0];
+  mqd_t mq = (mqd_t)(uintptr_t)argv[1];
+  char msg;
+
+  mq_receive(mq, &msg, sizeof(msg), NULL);
+  performance_end(time);
+  return NULL;
+}
+
+static size_t mqueue_performance(void)
+{
+  struct performance_time_s result;
+  struct mq_attr attr;
+  FAR void *argv[2];
+  mqd_t mq;
+  int tid;
+
+  memset(&attr, 0, sizeof(attr));
+  attr.mq_maxmsg  = 1;
+  attr.mq_msgsize = 1;
+  mq = mq_open("osperf", O_RDWR | O_CREAT, 0644, &attr);
+  DEBUGASSERT(mq != (mqd_t)-1);
+
+  argv[0] = &result;
+  argv[1] = (FAR void *)(uintptr_t)mq;
+  tid = performance_thread_create(mqueue_task, argv,
+                                  CONFIG_BENCHMARK_OSPERF_PRIORITY + 1);
+
+  performance_start(&result);
+  mq_send(mq, "a", 1, 0);
+  pthread_join(tid, NULL);
+
+  mq_close(mq);
+  mq_unlink("osperf");
+  return performance_gettime(&result);
+}
+
+/****************************************************************************
+ * eventfd performance
+ ****************************************************************************/
+
+#ifdef CONFIG_EVENT_FD
+static FAR void *eventfd_task(FAR void *arg)
+{
+  FAR void **argv = arg;
+  FAR struct performance_time_s *time = argv[0];
+  int fd = (int)(uintptr_t)argv[1];
+  eventfd_t value;
+
+  eventfd_read(fd, &value);
+  performance_end(time);
+  return NULL;
+}
+
+static size_t eventfd_performance(void)
+{
+  struct performance_time_s result;
+  FAR void *argv[2];
+  int tid;
+  int fd;
+
+  fd = eventfd(0, 0);
+  DEBUGASSERT(fd >= 0);
+
+  argv[0] = &result;
+  argv[1] = (FAR void *)(uintptr_t)fd;
+  tid = performance_thread_create(eventfd_task, argv,
+                                  CONFIG_BENCHMARK_OSPERF_PRIORITY + 1);
+
+  performance_start(&result);
+  eventfd_write(fd, 1);
+  pthread_join(tid, NULL);
+
+  close(fd);
+  return performance_gettime(&result);
+}
+#endif
+
+/****************************************************************************
+ * signal performance
+ ****************************************************************************/
+
+static FAR void *signal_task(FAR void *arg)
+{
+  FAR struct performance_time_s *time = arg;
+  sigset_t set;
+
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  sigwaitinfo(&set, NULL);
+  performance_end(time);
+  return NULL;
+}
+
+static size_t signal_performance(void)
+{
+  struct performance_time_s result;
+  sigset_t oldset;
+  sigset_t set;
+  int tid;
+
+  /* The thread inherits the blocked mask, so the signal is kept for its
+   * sigwaitinfo() even if it comes first.
+   */
+
+  sigemptyset(&set);
+  sigaddset(&set, SIGUSR1);
+  pthread_sigmask(SIG_BLOCK, &set, &oldset);
+
+  tid = performance_thread_create(signal_task, &result,
+                                  CONFIG_BENCHMARK_OSPERF_PRIORITY + 1);
+
+  performance_start(&result);
+  pthread_kill(tid, SIGUSR1);
+  pthread_join(tid, NULL);
+
+  pthread_sigmask(SIG_SETMASK, &oldset, NULL);
+  return performance_gettime(&result);
+}
+
+/****************************************************************************
+ * pipe round trip performance
+ ****************************************************************************/
+
+static FAR void *pipe_task(FAR void *arg)
+{
+  FAR int *fds = arg;
+  char c;
+
+  read(fds[0], &c, 1);
+  write(fds[1], &c, 1);
+  return NULL;
+}
+
+static size_t pipe_performance(void)
+{
+  struct performance_time_s result;
+  int request[2];
+  int reply[2];
+  int fds[2];
+  int ret;
+  char c = 'a';
+
+  ret = pipe(request);
+  DEBUGASSERT(ret == 0);
+  ret = pipe(reply);
+  DEBUGASSERT(ret == 0);
+
+  fds[0] = request[0];
+  fds[1] = reply[1];
+  ret = performance_thread_create(pipe_task, fds,
+                                  CONFIG_BENCHMARK_OSPERF_PRIORITY + 1);
+
+  performance_start(&result);
+  write(request[1], &c, 1);
+  read(reply[0], &c, 1);
+  performance_end(&result);
+
+  pthread_join(ret, NULL);
+  close(request[0]);
+  close(request[1]);
+  close(reply[0]);
+  close(reply[1]);
+  return performance_gettime(&result);
+}
+
+/****************************************************************************
+ * condvar ping-pong performance
+ ****************************************************************************/
+
+static FAR void *condvar_task(FAR void *arg)
+{
+  FAR struct performance_cond_s *pc = arg;
+
+  pthread_mutex_lock(&pc->mutex);
+  while (pc->turn != 1)
+    {
+      pthread_cond_wait(&pc->cond, &pc->mutex);
+    }
+
+  pc->turn = 2;
+  pthread_cond_signal(&pc->cond);
+  pthread_mutex_unlock(&pc->mutex);
+  return NULL;
+}
+
+static size_t condvar_performance(void)
+{
+  struct performance_time_s result;
+  struct performance_cond_s pc;
+  int tid;
+
+  pthread_mutex_init(&pc.mutex, NULL);
+  pthread_cond_init(&pc.cond, NULL);
+  pc.turn = 0;
+
+  tid = performance_thread_create(condvar_task, &pc,
+                                  CONFIG_BENCHMARK_OSPERF_PRIORITY + 1);
+
+  performance_start(&result);
+  pthread_mutex_lock(&pc.mutex);
+  pc.turn = 1;
+  pthread_cond_signal(&pc.cond);
+  while (pc.turn != 2)
+    {
+      pthread_cond_wait(&pc.cond, &pc.mutex);
+    }
+
+  pthread_mutex_unlock(&pc.mutex);
+  performance_end(&result);
+
+  pthread_join(tid, NULL);
+  pthread_cond_destroy(&pc.cond);
+  pthread_mutex_destroy(&pc.mutex);
+  return performance_gettime(&result);
+}
+
+/****************************************************************************
+ * cross-CPU wake performance
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+static FAR void *crosscpu_task(FAR void *arg)
+{
+  FAR struct performance_thread_s *perf = arg;
+
+  sem_wait(&perf->sem);
+  performance_end(&perf->time);
+  return NULL;
+}
+
+static size_t crosscpu_performance(void)
+{
+  struct performance_thread_s perf;
+  struct sched_param param;
+  pthread_attr_t attr;
+  cpu_set_t oldset;
+  cpu_set_t cpuset;
+  pthread_t tid;
+
+  /* The poster on CPU0, the waiter on CPU1 */
+
+  sched_getaffinity(0, sizeof(oldset), &oldset);
+  CPU_ZERO(&cpuset);
+  CPU_SET(0, &cpuset);
+  sched_setaffinity(0, sizeof(cpuset), &cpuset);
+
+  sem_init(&perf.sem, 0, 0);
+  param.sched_priority = CONFIG_BENCHMARK_OSPERF_PRIORITY + 1;
+  pthread_attr_init(&attr);
+  pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+  pthread_attr_setschedparam(&attr, &param);
+  CPU_ZERO(&cpuset);
+  CPU_SET(1, &cpuset);
+  pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+  pthread_create(&tid, &attr, crosscpu_task, &perf);
+  pthread_attr_destroy(&attr);
+
+  /* Let it get to sem_wait() on the other CPU */
+
+  usleep(1000);
+
+  performance_start(&perf.time);
+  sem_post(&perf.sem);
+  pthread_join(tid, NULL);
+
+  sem_destroy(&perf.sem);
+  sched_setaffinity(0, sizeof(oldset), &oldset);
+  return performance_gettime(&perf.time);
+}
+#endif
+
 /****************************************************************************
  * performance_help
  ****************************************************************************/
@@ -333,49 +675,240 @@ static void performance_help(void)
 {
   printf("Usage: performance [OPTIONS] [name]\n\n");
   printf("OPTIONS:\n");
-  printf("\t-c, \tNumber of times to run each test\n");
-  printf("\t-d, \tShow detail of each test\n");
-  printf("\t-h, \tShow this help message\n");
-  printf("\t-l, \tList all tests\n");
+  printf("\t-c, --count N\tNumber of times to run each test\n");
+  printf("\t-d, --detail\tShow detail of each test\n");
+  printf("\t-f, --format F\tOutput as text (default), json or csv\n");
+  printf("\t-C, --compare FILE\n"
+         "\t\tCompare with a baseline saved with -f json, fail if the\n"
+         "\t\taverage or the P99 of a test got slower than the threshold\n");
+  printf("\t-t, --threshold PCT\n"
+         "\t\tRegression threshold in percent (default %d)\n",
+         PERFORMANCE_THRESHOLD);
+  printf("\t-h, --help\tShow this help message\n");
+  printf("\t-l, --list\tList all tests\n");
+  printf("\nTimes are in ns, the jitter is their standard deviation.\n");
+}
+
+/****************************************************************************
+ * performance_compare
+ ****************************************************************************/
+
+static int performance_compare(FAR const void *a, FAR const void *b)
+{
+  size_t x = *(FAR const size_t *)a;
+  size_t y = *(FAR const size_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+/****************************************************************************
+ * performance_sqrt
+ ****************************************************************************/
+
+static uint64_t performance_sqrt(uint64_t value)
+{
+  uint64_t root = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+
+  while (bit > value)
+    {
+      bit >>= 2;
+    }
+
+  while (bit != 0)
+    {
+      if (value >= root + bit)
+        {
+          value -= root + bit;
+          root   = (root >> 1) + bit;
+        }
+      else
+        {
+          root >>= 1;
+        }
+
+      bit >>= 2;
+    }
+
+  return root;
 }
 
 /****************************************************************************
  * performance_run
+ *
+ *   Run a test count times and collect the distribution of its times: an
+ *   average hides the worst cases, which matter more for real time.  The
+ *   jitter is the standard deviation.
+ *
  ****************************************************************************/
 
-static void performance_run(const FAR struct performance_entry_s *item,
-                            size_t count, bool detail)
+static int performance_run(const FAR struct performance_entry_s *item,
+                           size_t count, bool detail,
+                           FAR struct performance_result_s *result)
 {
+  FAR size_t *samples;
+  uint64_t variance = 0;
   size_t total = 0;
-  size_t max = 0;
-  size_t min = 0;
+  size_t avg;
   size_t i;
 
+  samples = malloc(count * sizeof(*samples));
+  if (samples == NULL)
+    {
+      fprintf(stderr, "%s: no memory for %zu samples\n", item->name, count);
+      return -ENOMEM;
+    }
+
   for (i = 0; i < count; i++)
     {
       irq_t flags = enter_critical_section();
       size_t time = item->entry();
       leave_critical_section(flags);
 
+      samples[i] = time;
       total += time;
-      if (time > max)
-        {
-          max = time;
-        }
 
-      if (time < min || min == 0)
+      if (detail)
         {
-          min = time;
+          printf("\t%zu: %zu\n", i, time);
         }
+    }
 
-      if (detail)
+  avg = total / count;
+  for (i = 0; i < count; i++)
+    {
+      int64_t delta = (int64_t)samples[i] - (int64_t)avg;
+      variance += delta * delta;
+    }
+
+  qsort(samples, count, sizeof(*samples), performance_compare);
+
+  /* Nearest rank percentiles */
+
+  result->valid  = true;
+  result->max    = samples[count - 1];
+  result->min    = samples[0];
+  result->avg    = avg;
+  result->p50    = samples[(count * 50 + 99) / 100 - 1];
+  result->p99    = samples[(count * 99 + 99) / 100 - 1];
+  result->jitter = (size_t)performance_sqrt(variance / count);
+
+  free(samples);
+  return OK;
+}
+
+/****************************************************************************
+ * performance_header
+ ****************************************************************************/
+
+static void performance_header(enum performance_format_e format,
+                               size_t count, bool detail)
+{
+  switch (format)
+    {
+      case PERFORMANCE_TEXT:
+        printf("OS performance args: count:%zu, detail:%s\n", count,
+               detail ? "true" : "false");
+        printf("======================================================"
+               "========\n");
+        printf("%-*s %10s %10s %10s %10s %10s %10s\n", NAME_MAX,
+               "Describe", "Max", "Min", "Avg", "P50", "P99", "Jitter");
+        break;
+
+      case PERFORMANCE_JSON:
+        printf("{\n  \"count\": %zu,\n  \"results\": [", count);
+        break;
+
+      case PERFORMANCE_CSV:
+        printf("name,max,min,avg,p50,p99,jitter\n");
+        break;
+    }
+}
+
+/****************************************************************************
+ * performance_print
+ *
+ *   Print the result of a test.  JSON results are one per line, which is
+ *   what performance_load() expects of a baseline.
+ *
+ ****************************************************************************/
+
+static void performance_print(enum performance_format_e format,
+                              FAR const char *name, bool first,
+                              FAR const struct performance_result_s *result)
+{
+  switch (format)
+    {
+      case PERFORMANCE_TEXT:
+        printf("%-*s %10zu %10zu %10zu %10zu %10zu %10zu\n", NAME_MAX,
+               name, result->max, result->min, result->avg, result->p50,
+               result->p99, result->jitter);
+        break;
+
+      case PERFORMANCE_JSON:
+        printf("%s\n    {\"name\": \"%s\", \"max\": %zu, \"min\": %zu, "
+               "\"avg\": %zu, \"p50\": %zu, \"p99\": %zu, "
+               "\"jitter\": %zu}", first ? "" : ",", name, result->max,
+               result->min, result->avg, result->p50, result->p99,
+               result->jitter);
+        break;
+
+      case PERFORMANCE_CSV:
+        printf("%s,%zu,%zu,%zu,%zu,%zu,%zu\n", name, result->max,
+               result->min, result->avg, result->p50, result->p99,
+               result->jitter);
+        break;
+    }
+}
+
+/****************************************************************************
+ * performance_field
+ *
+ *   Find "key": in a line of JSON and return the position after the colon.
+ *
+ ****************************************************************************/
+
+static FAR const char *performance_field(FAR const char *line,
+                                         FAR const char *key)
+{
+  size_t len = strlen(key);
+  FAR const char *ptr = line;
+
+  while ((ptr = strchr(ptr, '"')) != NULL)
+    {
+      ptr++;
+      if (strncmp(ptr, key, len) == 0 && ptr[len] == '"')
         {
-          printf("\t%zu: %zu\n", i, time);
+          ptr += len + 1;
+          while (*ptr == ' ' || *ptr == '\t')
+            {
+              ptr++;
+            }
+
+          return *ptr == ':' ? ptr + 1 : NULL;
         }
     }
 
-  printf("%-*s %10zu %10zu %10zu\n", NAME_MAX, item->name, max, min,
-         total / count);
+  return NULL;
+}
+
+/****************************************************************************
+ * performance_number
+ ****************************************************************************/
+
+static bool performance_number(FAR const char *line, FAR const char *key,
+                               FAR size_t *value)
+{
+  FAR const char *ptr = performance_field(line, key);
+  FAR char *end;
+
+  if (ptr == NULL)
+    {
+      return false;
+    }
+
+  *value = strtoul(ptr, &end, 10);
+  return end != ptr;
 }
 
 /****************************************************************************
@@ -408,19 +941,146 @@ void performance_list(void)
     }
 }
 
+/****************************************************************************
+ * performance_load
+ *
+ *   Read a baseline written with -f json into base, which is indexed like
+ *   g_entry_list.  Tests the baseline does not know are left invalid.
+ *
+ ****************************************************************************/
+
+static int performance_load(FAR const char *path,
+                            FAR struct performance_result_s *base)
+{
+  const FAR struct performance_entry_s *item;
+  FAR struct performance_result_s *result;
+  FAR const char *name;
+  FAR char *end;
+  char line[256];
+  int nload = 0;
+  FAR FILE *fp;
+
+  fp = fopen(path, "r");
+  if (fp == NULL)
+    {
+      return -errno;
+    }
+
+  while (fgets(line, sizeof(line), fp) != NULL)
+    {
+      name = performance_field(line, "name");
+      if (name == NULL || (name = strchr(name, '"')) == NULL ||
+          (end = strchr(++name, '"')) == NULL)
+        {
+          continue;
+        }
+
+      *end = '\0';
+      item = find_entry(name);
+      *end = '"';
+      if (item == NULL)
+        {
+          continue;
+        }
+
+      result = &base[item - g_entry_list];
+      if (performance_number(line, "max", &result->max) &&
+          performance_number(line, "min", &result->min) &&
+          performance_number(line, "avg", &result->avg) &&
+          performance_number(line, "p50", &result->p50) &&
+          performance_number(line, "p99", &result->p99) &&
+          performance_number(line, "jitter", &result->jitter))
+        {
+          result->valid = true;
+          nload++;
+        }
+    }
+
+  fclose(fp);
+  return nload > 0 ? OK : -EINVAL;
+}
+
+/****************************************************************************
+ * performance_check
+ *
+ *   Compare the average and the P99 of each test that ran with the
+ *   baseline.  Returns the number of regressions beyond threshold percent.
+ *
+ ****************************************************************************/
+
+static int performance_check(FAR FILE *out,
+                             FAR const struct performance_result_s *results,
+                             FAR const struct performance_result_s *base,
+                             unsigned long threshold)
+{
+  FAR const struct performance_result_s *now;
+  FAR const struct performance_result_s *old;
+  int nregress = 0;
+  size_t i;
+
+  fprintf(out, "Regressions beyond %lu%%:\n", threshold);
+
+  for (i = 0; i < nitems(g_entry_list); i++)
+    {
+      now = &results[i];
+      old = &base[i];
+      if (!now->valid || !old->valid)
+        {
+          continue;
+        }
+
+      if ((uint64_t)now->avg * 100 > (uint64_t)old->avg * (100 + threshold))
+        {
+          fprintf(out, "  %s avg %zu -> %zu ns\n", g_entry_list[i].name,
+                  old->avg, now->avg);
+          nregress++;
+        }
+
+      if ((uint64_t)now->p99 * 100 > (uint64_t)old->p99 * (100 + threshold))
+        {
+          fprintf(out, "  %s p99 %zu -> %zu ns\n", g_entry_list[i].name,
+                  old->p99, now->p99);
+          nregress++;
+        }
+    }
+
+  fprintf(out, nregress > 0 ? "%d found\n" : "None\n", nregress);
+  return nregress;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
 int main(int argc, FAR char *argv[])
 {
+  struct performance_result_s results[nitems(g_entry_list)];
+  struct performance_result_s base[nitems(g_entry_list)];
   const FAR struct performance_entry_s *item = NULL;
+  enum performance_format_e format = PERFORMANCE_TEXT;
+  unsigned long threshold = PERFORMANCE_THRESHOLD;
+  FAR const char *baseline = NULL;
   bool detail = false;
+  bool first = true;
   size_t count = 100;
   size_t i;
+  int ret;
   int opt;
 
-  while ((opt = getopt(argc, argv, "dc:hl")) != -1)
+  struct option options[] =
+    {
+      {"count", 1, NULL, 'c'},
+      {"detail", 0, NULL, 'd'},
+      {"format", 1, NULL, 'f'},
+      {"compare", 1, NULL, 'C'},
+      {"threshold", 1, NULL, 't'},
+      {"help", 0, NULL, 'h'},
+      {"list", 0, NULL, 'l'},
+      {NULL, 0, NULL, 0}
+    };
+
+  while ((opt = getopt_long(argc, argv, "dc:f:C:t:hl", options, NULL))
+         != -1)
     {
       switch (opt)
         {
@@ -429,6 +1089,38 @@ int main(int argc, FAR char *argv[])
             break;
           case 'c':
             count = strtoul(optarg, NULL, 0);
+            if (count == 0)
+              {
+                performance_help();
+                return EXIT_FAILURE;
+              }
+
+            break;
+          case 'f':
+            if (strcmp(optarg, "text") == 0)
+              {
+                format = PERFORMANCE_TEXT;
+              }
+            else if (strcmp(optarg, "json") == 0)
+              {
+                format = PERFORMANCE_JSON;
+              }
+            else if (strcmp(optarg, "csv") == 0)
+              {
+                format = PERFORMANCE_CSV;
+              }
+            else
+              {
+                performance_help();
+                return EXIT_FAILURE;
+              }
+
+            break;
+          case 'C':
+            baseline = optarg;
+            break;
+          case 't':
+            threshold = strtoul(optarg, NULL, 0);
             break;
           case 'h':
             performance_help();
@@ -447,27 +1139,57 @@ int main(int argc, FAR char *argv[])
       item = find_entry(argv[optind]);
       if (item == NULL)
         {
-          printf("Can't find %s\n", argv[optind]);
+          fprintf(stderr, "Can't find %s\n", argv[optind]);
           return EXIT_FAILURE;
         }
     }
 
-  printf("OS performance args: count:%zu, detail:%s\n", count,
-         detail ? "true" : "false");
-
-  printf("==============================================================\n");
-  printf("%-*s %10s %10s %10s\n", NAME_MAX, "Describe", "Max", "Min", "Avg");
+  memset(results, 0, sizeof(results));
+  memset(base, 0, sizeof(base));
 
-  if (item != NULL)
+  if (baseline != NULL)
     {
-      performance_run(item, count, detail);
-      return EXIT_SUCCESS;
+      ret = performance_load(baseline, base);
+      if (ret < 0)
+        {
+          fprintf(stderr, "Can't load baseline %s: %d\n", baseline, ret);
+          return EXIT_FAILURE;
+        }
     }
 
+  /* The samples are only listed in text, they would break the others */
+
+  performance_header(format, count, detail);
+  detail = detail && format == PERFORMANCE_TEXT;
+
   for (i = 0; i < nitems(g_entry_list); i++)
     {
-      item = &g_entry_list[i];
-      performance_run(item, count, detail);
+      if (item != NULL && item != &g_entry_list[i])
+        {
+          continue;
+        }
+
+      if (performance_run(&g_entry_list[i], count, detail, &results[i]) ==
+          OK)
+        {
+          performance_print(format, g_entry_list[i].name, first,
+                            &results[i]);
+          first = false;
+        }
+    }
+
+  if (format == PERFORMANCE_JSON)
+    {
+      printf("\n  ]\n}\n");
+    }
+
+  /* Keep the report off a machine readable stdout */
+
+  if (baseline != NULL &&
+      performance_check(format == PERFORMANCE_TEXT ? stdout : stderr,
+                        results, base, threshold) > 0)
+    {
+      return EXIT_FAILURE;
     }
 
   return EXIT_SUCCESS;
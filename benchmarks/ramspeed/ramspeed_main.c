@@ -24,14 +24,45 @@
 
 #include <nuttx/config.h>
 #include <nuttx/irq.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/param.h>
 #include <time.h>
 #include <unistd.h>
 #include <inttypes.h>
 
+#if defined(__ARM_FEATURE_MVE)
+#  include <arm_mve.h>
+#  define RAMSPEED_SIMD128 "helium"
+#elif defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define RAMSPEED_SIMD128 "neon"
+#endif
+
+#if defined(__riscv_v_intrinsic) && __riscv_v_intrinsic >= 11000
+#  include <riscv_vector.h>
+#  define RAMSPEED_RVV
+#endif
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  include <immintrin.h>
+#  define RAMSPEED_AVX
+#endif
+
+/* LDM/STM with eight high and low registers, not in Thumb-1 */
+
+#if defined(__arm__) && (defined(__thumb2__) || !defined(__thumb__))
+#  define RAMSPEED_LDM
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -52,6 +83,11 @@
 #define SET8(x) *d8 = x; d8++;
 #define REPEAT8(expr) expr expr expr expr expr expr expr expr
 
+/* Each point of the bandwidth curve runs at least this long */
+
+#define CURVE_MIN_US    20000
+#define CURVE_MIN_SIZE  64
+
 #define OPTARG_TO_VALUE(value, type, base) \
   do \
   { \
@@ -68,6 +104,14 @@
  * Private Types
  ****************************************************************************/
 
+struct ramspeed_kernel_s
+{
+  FAR const char *name;
+  CODE void *(*copy)(FAR void *dst, FAR const void *src, size_t len);
+  CODE void (*set)(FAR void *dst, uint8_t v, size_t len);
+  CODE bool (*supported)(void);   /* NULL if the build decides */
+};
+
 struct ramspeed_s
 {
   FAR void *dest;
@@ -76,12 +120,100 @@ struct ramspeed_s
   uint8_t value;
   uint32_t repeat_num;
   bool irq_disable;
+  bool curve;
+  bool shared;                    /* All threads on the same buffers */
+  uint32_t nthreads;              /* 0 for the single thread tests */
+  FAR const char *kernel;         /* NULL for all */
+};
+
+struct ramspeed_thread_s
+{
+  FAR struct ramspeed_s *info;
+  FAR const struct ramspeed_kernel_s *kernel;
+  FAR pthread_barrier_t *barrier;
+  FAR void *dest;
+  FAR const void *src;
+  bool copy;
+  int cpu;
+  uint64_t start;
+  uint64_t end;
 };
 
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void *internal_memcpy(FAR void *dst, FAR const void *src,
+                             size_t len);
+static void internal_memset(FAR void *dst, uint8_t v, size_t len);
+static void system_memset(FAR void *dst, uint8_t v, size_t len);
+
+#ifdef RAMSPEED_LDM
+static void *ldm_memcpy(FAR void *dst, FAR const void *src, size_t len);
+static void ldm_memset(FAR void *dst, uint8_t v, size_t len);
+#endif
+
+#ifdef RAMSPEED_SIMD128
+static void *simd128_memcpy(FAR void *dst, FAR const void *src,
+                            size_t len);
+static void simd128_memset(FAR void *dst, uint8_t v, size_t len);
+#endif
+
+#ifdef __aarch64__
+static void *stnp_memcpy(FAR void *dst, FAR const void *src, size_t len);
+static void stnp_memset(FAR void *dst, uint8_t v, size_t len);
+#endif
+
+#ifdef RAMSPEED_RVV
+static void *rvv_memcpy(FAR void *dst, FAR const void *src, size_t len);
+static void rvv_memset(FAR void *dst, uint8_t v, size_t len);
+#endif
+
+#ifdef __SSE2__
+static void *sse2nt_memcpy(FAR void *dst, FAR const void *src,
+                           size_t len);
+static void sse2nt_memset(FAR void *dst, uint8_t v, size_t len);
+#endif
+
+#ifdef RAMSPEED_AVX
+static void *avx_memcpy(FAR void *dst, FAR const void *src, size_t len);
+static void avx_memset(FAR void *dst, uint8_t v, size_t len);
+static bool avx_supported(void);
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
+/* The kernels to compare.  "-nt" ones use non-temporal stores, which
+ * bypass the cache on the way to memory.
+ */
+
+static const struct ramspeed_kernel_s g_ramspeed_kernels[] =
+{
+  {"system",   memcpy,          system_memset,  NULL},
+  {"internal", internal_memcpy, internal_memset, NULL},
+#ifdef RAMSPEED_LDM
+  {"ldm",      ldm_memcpy,      ldm_memset,     NULL},
+#endif
+#ifdef RAMSPEED_SIMD128
+  {RAMSPEED_SIMD128, simd128_memcpy, simd128_memset, NULL},
+#endif
+#ifdef __aarch64__
+  {"neon-nt",  stnp_memcpy,     stnp_memset,    NULL},
+#endif
+#ifdef RAMSPEED_RVV
+  {"rvv",      rvv_memcpy,      rvv_memset,     NULL},
+#endif
+#ifdef __SSE2__
+  {"sse2-nt",  sse2nt_memcpy,   sse2nt_memset,  NULL},
+#endif
+#ifdef RAMSPEED_AVX
+  {"avx",      avx_memcpy,      avx_memset,     avx_supported},
+#endif
+  {NULL,       NULL,            NULL,           NULL}
+};
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -92,8 +224,11 @@ struct ramspeed_s
 
 static void show_usage(FAR const char *progname, int exitcode)
 {
+  FAR const struct ramspeed_kernel_s *k;
+
   printf("\nUsage: %s -a -r <hex-address> -w <hex-address> -s <decimal-size>"
-         " -v <hex-value>[0x00] -n <decimal-repeat number>[100] -i\n",
+         " -v <hex-value>[0x00] -n <decimal-repeat number>[100] -i"
+         " -k <kernel> -c -t <threads> -x\n",
          progname);
   printf("\nWhere:\n");
   printf("  -a allocate RW buffers on heap. Overwrites -r and -w option.\n");
@@ -106,9 +241,78 @@ static void show_usage(FAR const char *progname, int exitcode)
          " [default value: 100].\n");
   printf("  -i turn off interrupts while testing"
          " [default value: false].\n");
+  printf("  -k <kernel> only test this kernel [default: all of them].\n");
+  printf("  -c print the bandwidth (MB/s) of %d bytes to <size>, each\n"
+         "     size run long enough to measure (-n is ignored).\n",
+         CURVE_MIN_SIZE);
+  printf("  -t <threads> run the kernels on this many threads at once, each\n"
+         "     on its own CPU and <size> buffers, and print their\n"
+         "     bandwidth and the total.  -r/-w must have room for\n"
+         "     <threads> * <size> bytes.\n");
+  printf("  -x with -t, all threads on the same buffers.\n");
+  printf("\nKernels:");
+  for (k = g_ramspeed_kernels; k->name != NULL; k++)
+    {
+      if (k->supported == NULL || k->supported())
+        {
+          printf(" %s", k->name);
+        }
+    }
+
+  printf("\n");
   exit(exitcode);
 }
 
+/****************************************************************************
+ * Name: find_kernel
+ ****************************************************************************/
+
+static FAR const struct ramspeed_kernel_s *find_kernel(FAR const char *name)
+{
+  FAR const struct ramspeed_kernel_s *k;
+
+  for (k = g_ramspeed_kernels; k->name != NULL; k++)
+    {
+      if (strcmp(k->name, name) == 0)
+        {
+          return k->supported == NULL || k->supported() ? k : NULL;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: next_kernel
+ *
+ * Description:
+ *   Iterate over the kernels selected by -k, starting from NULL.
+ *
+ ****************************************************************************/
+
+static FAR const struct ramspeed_kernel_s *
+next_kernel(FAR struct ramspeed_s *info,
+            FAR const struct ramspeed_kernel_s *k)
+{
+  k = k == NULL ? g_ramspeed_kernels : k + 1;
+  for (; k->name != NULL; k++)
+    {
+      if (info->kernel != NULL)
+        {
+          if (strcmp(k->name, info->kernel) == 0)
+            {
+              return k;
+            }
+        }
+      else if (k->supported == NULL || k->supported())
+        {
+          return k;
+        }
+    }
+
+  return NULL;
+}
+
 /****************************************************************************
  * Name: parse_commandline
  ****************************************************************************/
@@ -128,7 +332,7 @@ static void parse_commandline(int argc, FAR char **argv,
       show_usage(argv[0], EXIT_FAILURE);
     }
 
-  while ((ch = getopt(argc, argv, "r:w:s:v:n:ia")) != ERROR)
+  while ((ch = getopt(argc, argv, "r:w:s:v:n:iak:ct:x")) != ERROR)
     {
       switch (ch)
         {
@@ -165,6 +369,24 @@ static void parse_commandline(int argc, FAR char **argv,
           case 'i':
             info->irq_disable = true;
             break;
+          case 'k':
+            info->kernel = optarg;
+            if (find_kernel(optarg) == NULL)
+              {
+                printf(RAMSPEED_PREFIX "Unknown kernel: %s\n", optarg);
+                show_usage(argv[0], EXIT_FAILURE);
+              }
+
+            break;
+          case 'c':
+            info->curve = true;
+            break;
+          case 't':
+            OPTARG_TO_VALUE(info->nthreads, uint32_t, 10);
+            break;
+          case 'x':
+            info->shared = true;
+            break;
           case '?':
             printf(RAMSPEED_PREFIX "Unknown option: %c\n", (char)optopt);
             show_usage(argv[0], EXIT_FAILURE);
@@ -174,8 +396,15 @@ static void parse_commandline(int argc, FAR char **argv,
 
   if (allocate_rw_address)
     {
-      info->dest = malloc(info->size);
-      info->src = malloc(info->size);
+      size_t total = info->size;
+
+      if (info->nthreads > 0 && !info->shared)
+        {
+          total *= info->nthreads;
+        }
+
+      info->dest = malloc(total);
+      info->src = malloc(total);
     }
 
   if (info->dest == NULL || info->src == NULL || info->size == 0)
@@ -221,6 +450,18 @@ static uint32_t get_time_elaps(uint32_t prev_time)
   return prev_time;
 }
 
+/****************************************************************************
+ * Name: get_time_us
+ ****************************************************************************/
+
+static uint64_t get_time_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 /****************************************************************************
  * Name: internal_memcpy
  ****************************************************************************/
@@ -344,12 +585,365 @@ static void internal_memset(FAR void *dst, uint8_t v, size_t len)
     }
 }
 
+/****************************************************************************
+ * Name: system_memset
+ ****************************************************************************/
+
+static void system_memset(FAR void *dst, uint8_t v, size_t len)
+{
+  memset(dst, v, len);
+}
+
+/****************************************************************************
+ * Name: ldm_memcpy/ldm_memset
+ *
+ * Description:
+ *   32 byte LDM/STM bursts.  r7 and r11 are left alone, they may be the
+ *   frame pointer.
+ *
+ ****************************************************************************/
+
+#ifdef RAMSPEED_LDM
+static void *ldm_memcpy(FAR void *dst, FAR const void *src, size_t len)
+{
+  FAR uint8_t *d = dst;
+  FAR const uint8_t *s = src;
+  size_t n = len & ~31;
+
+  if ((((uintptr_t)d | (uintptr_t)s) & 3) != 0 || n == 0)
+    {
+      return internal_memcpy(dst, src, len);
+    }
+
+  __asm__ __volatile__
+  (
+    "1:\n"
+    "ldmia %1!, {r3, r4, r5, r6, r8, r9, r10, r12}\n"
+    "stmia %0!, {r3, r4, r5, r6, r8, r9, r10, r12}\n"
+    "subs  %2, %2, #32\n"
+    "bne   1b\n"
+    : "+r"(d), "+r"(s), "+r"(n)
+    :
+    : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc", "memory"
+  );
+
+  internal_memcpy(d, s, len & 31);
+  return dst;
+}
+
+static void ldm_memset(FAR void *dst, uint8_t v, size_t len)
+{
+  FAR uint8_t *d = dst;
+  uint32_t v32 = v * 0x01010101u;
+  size_t n = len & ~31;
+
+  if (((uintptr_t)d & 3) != 0 || n == 0)
+    {
+      internal_memset(dst, v, len);
+      return;
+    }
+
+  __asm__ __volatile__
+  (
+    "mov   r3, %2\n"
+    "mov   r4, %2\n"
+    "mov   r5, %2\n"
+    "mov   r6, %2\n"
+    "mov   r8, %2\n"
+    "mov   r9, %2\n"
+    "mov   r10, %2\n"
+    "mov   r12, %2\n"
+    "1:\n"
+    "stmia %0!, {r3, r4, r5, r6, r8, r9, r10, r12}\n"
+    "subs  %1, %1, #32\n"
+    "bne   1b\n"
+    : "+r"(d), "+r"(n)
+    : "r"(v32)
+    : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc", "memory"
+  );
+
+  internal_memset(d, v, len & 31);
+}
+#endif
+
+/****************************************************************************
+ * Name: simd128_memcpy/simd128_memset
+ *
+ * Description:
+ *   64 bytes per iteration in four 128-bit NEON or Helium (MVE) registers;
+ *   the intrinsics are named the same for both.
+ *
+ ****************************************************************************/
+
+#ifdef RAMSPEED_SIMD128
+static void *simd128_memcpy(FAR void *dst, FAR const void *src, size_t len)
+{
+  FAR uint8_t *d = dst;
+  FAR const uint8_t *s = src;
+  uint8x16_t q0;
+  uint8x16_t q1;
+  uint8x16_t q2;
+  uint8x16_t q3;
+
+  for (; len >= 64; len -= 64, d += 64, s += 64)
+    {
+      q0 = vld1q_u8(s);
+      q1 = vld1q_u8(s + 16);
+      q2 = vld1q_u8(s + 32);
+      q3 = vld1q_u8(s + 48);
+      vst1q_u8(d, q0);
+      vst1q_u8(d + 16, q1);
+      vst1q_u8(d + 32, q2);
+      vst1q_u8(d + 48, q3);
+    }
+
+  internal_memcpy(d, s, len);
+  return dst;
+}
+
+static void simd128_memset(FAR void *dst, uint8_t v, size_t len)
+{
+  FAR uint8_t *d = dst;
+  uint8x16_t q = vdupq_n_u8(v);
+
+  for (; len >= 64; len -= 64, d += 64)
+    {
+      vst1q_u8(d, q);
+      vst1q_u8(d + 16, q);
+      vst1q_u8(d + 32, q);
+      vst1q_u8(d + 48, q);
+    }
+
+  internal_memset(d, v, len);
+}
+#endif
+
+/****************************************************************************
+ * Name: stnp_memcpy/stnp_memset
+ *
+ * Description:
+ *   AArch64 non-temporal pair stores of 128-bit registers.
+ *
+ ****************************************************************************/
+
+#ifdef __aarch64__
+static void *stnp_memcpy(FAR void *dst, FAR const void *src, size_t len)
+{
+  FAR uint8_t *d = dst;
+  FAR const uint8_t *s = src;
+  size_t n = len & ~63;
+
+  if (n > 0)
+    {
+      __asm__ __volatile__
+      (
+        "1:\n"
+        "ldp  q0, q1, [%1], #32\n"
+        "ldp  q2, q3, [%1], #32\n"
+        "stnp q0, q1, [%0]\n"
+        "stnp q2, q3, [%0, #32]\n"
+        "add  %0, %0, #64\n"
+        "subs %2, %2, #64\n"
+        "b.ne 1b\n"
+        : "+r"(d), "+r"(s), "+r"(n)
+        :
+        : "v0", "v1", "v2", "v3", "cc", "memory"
+      );
+    }
+
+  internal_memcpy(d, s, len & 63);
+  return dst;
+}
+
+static void stnp_memset(FAR void *dst, uint8_t v, size_t len)
+{
+  FAR uint8_t *d = dst;
+  size_t n = len & ~63;
+
+  if (n > 0)
+    {
+      __asm__ __volatile__
+      (
+        "dup  v0.16b, %w2\n"
+        "1:\n"
+        "stnp q0, q0, [%0]\n"
+        "stnp q0, q0, [%0, #32]\n"
+        "add  %0, %0, #64\n"
+        "subs %1, %1, #64\n"
+        "b.ne 1b\n"
+        : "+r"(d), "+r"(n)
+        : "r"((uint32_t)v)
+        : "v0", "cc", "memory"
+      );
+    }
+
+  internal_memset(d, v, len & 63);
+}
+#endif
+
+/****************************************************************************
+ * Name: rvv_memcpy/rvv_memset
+ *
+ * Description:
+ *   RISC-V vector, strip-mined at the widest LMUL.
+ *
+ ****************************************************************************/
+
+#ifdef RAMSPEED_RVV
+static void *rvv_memcpy(FAR void *dst, FAR const void *src, size_t len)
+{
+  FAR uint8_t *d = dst;
+  FAR const uint8_t *s = src;
+  size_t vl;
+
+  for (; len > 0; len -= vl, d += vl, s += vl)
+    {
+      vl = __riscv_vsetvl_e8m8(len);
+      __riscv_vse8_v_u8m8(d, __riscv_vle8_v_u8m8(s, vl), vl);
+    }
+
+  return dst;
+}
+
+static void rvv_memset(FAR void *dst, uint8_t v, size_t len)
+{
+  FAR uint8_t *d = dst;
+  size_t vl = __riscv_vsetvlmax_e8m8();
+  vuint8m8_t vv = __riscv_vmv_v_x_u8m8(v, vl);
+
+  for (; len > 0; len -= vl, d += vl)
+    {
+      vl = __riscv_vsetvl_e8m8(len);
+      __riscv_vse8_v_u8m8(d, vv, vl);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: sse2nt_memcpy/sse2nt_memset
+ *
+ * Description:
+ *   SSE2 streaming (non-temporal) stores, which need 16 byte alignment.
+ *
+ ****************************************************************************/
+
+#ifdef __SSE2__
+static void *sse2nt_memcpy(FAR void *dst, FAR const void *src, size_t len)
+{
+  FAR uint8_t *d = dst;
+  FAR const uint8_t *s = src;
+  size_t head = -(uintptr_t)d & 15;
+
+  if (head > len)
+    {
+      head = len;
+    }
+
+  internal_memcpy(d, s, head);
+  d   += head;
+  s   += head;
+  len -= head;
+
+  for (; len >= 64; len -= 64, d += 64, s += 64)
+    {
+      __m128i x0 = _mm_loadu_si128((FAR const __m128i *)s);
+      __m128i x1 = _mm_loadu_si128((FAR const __m128i *)(s + 16));
+      __m128i x2 = _mm_loadu_si128((FAR const __m128i *)(s + 32));
+      __m128i x3 = _mm_loadu_si128((FAR const __m128i *)(s + 48));
+      _mm_stream_si128((FAR __m128i *)d, x0);
+      _mm_stream_si128((FAR __m128i *)(d + 16), x1);
+      _mm_stream_si128((FAR __m128i *)(d + 32), x2);
+      _mm_stream_si128((FAR __m128i *)(d + 48), x3);
+    }
+
+  _mm_sfence();
+  internal_memcpy(d, s, len);
+  return dst;
+}
+
+static void sse2nt_memset(FAR void *dst, uint8_t v, size_t len)
+{
+  FAR uint8_t *d = dst;
+  size_t head = -(uintptr_t)d & 15;
+  __m128i x = _mm_set1_epi8(v);
+
+  if (head > len)
+    {
+      head = len;
+    }
+
+  internal_memset(d, v, head);
+  d   += head;
+  len -= head;
+
+  for (; len >= 64; len -= 64, d += 64)
+    {
+      _mm_stream_si128((FAR __m128i *)d, x);
+      _mm_stream_si128((FAR __m128i *)(d + 16), x);
+      _mm_stream_si128((FAR __m128i *)(d + 32), x);
+      _mm_stream_si128((FAR __m128i *)(d + 48), x);
+    }
+
+  _mm_sfence();
+  internal_memset(d, v, len);
+}
+#endif
+
+/****************************************************************************
+ * Name: avx_memcpy/avx_memset
+ *
+ * Description:
+ *   256-bit AVX, built for any x86 and only offered if the CPU has it.
+ *
+ ****************************************************************************/
+
+#ifdef RAMSPEED_AVX
+__attribute__((target("avx")))
+static void *avx_memcpy(FAR void *dst, FAR const void *src, size_t len)
+{
+  FAR uint8_t *d = dst;
+  FAR const uint8_t *s = src;
+
+  for (; len >= 64; len -= 64, d += 64, s += 64)
+    {
+      __m256i y0 = _mm256_loadu_si256((FAR const __m256i *)s);
+      __m256i y1 = _mm256_loadu_si256((FAR const __m256i *)(s + 32));
+      _mm256_storeu_si256((FAR __m256i *)d, y0);
+      _mm256_storeu_si256((FAR __m256i *)(d + 32), y1);
+    }
+
+  internal_memcpy(d, s, len);
+  return dst;
+}
+
+__attribute__((target("avx")))
+static void avx_memset(FAR void *dst, uint8_t v, size_t len)
+{
+  FAR uint8_t *d = dst;
+  __m256i y = _mm256_set1_epi8(v);
+
+  for (; len >= 64; len -= 64, d += 64)
+    {
+      _mm256_storeu_si256((FAR __m256i *)d, y);
+      _mm256_storeu_si256((FAR __m256i *)(d + 32), y);
+    }
+
+  internal_memset(d, v, len);
+}
+
+static bool avx_supported(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx");
+}
+#endif
+
 /****************************************************************************
  * Name: print_rate
  ****************************************************************************/
 
-static void print_rate(FAR const char *name, uint64_t bytes,
-                       uint32_t cost_time)
+static void print_rate(FAR const char *name, FAR const char *op,
+                       uint64_t bytes, uint32_t cost_time)
 {
   uint32_t rate;
   if (cost_time == 0)
@@ -362,21 +956,19 @@ static void print_rate(FAR const char *name, uint64_t bytes,
 
   rate = bytes * 1000 / cost_time / 1024;
   printf(RAMSPEED_PREFIX
-         "%s Rate = %" PRIu32 " KB/s\t[cost: %" PRIu32 "ms]\n",
-         name, rate, cost_time);
+         "%s %s():\t Rate = %" PRIu32 " KB/s\t[cost: %" PRIu32 "ms]\n",
+         name, op, rate, cost_time);
 }
 
 /****************************************************************************
  * Name: memcpy_speed_test
  ****************************************************************************/
 
-static void memcpy_speed_test(FAR void *dest, FAR const void *src,
-                              size_t size, uint32_t repeat_cnt,
-                              bool irq_disable)
+static void memcpy_speed_test(FAR struct ramspeed_s *info)
 {
+  FAR const struct ramspeed_kernel_s *k;
   uint32_t start_time;
-  uint32_t cost_time_system;
-  uint32_t cost_time_internal;
+  uint32_t cost_time;
   uint32_t cnt;
   uint32_t step;
   uint64_t total_size;
@@ -384,9 +976,9 @@ static void memcpy_speed_test(FAR void *dest, FAR const void *src,
 
   printf("______memcpy performance______\n");
 
-  for (step = 32; step <= size; step <<= 1)
+  for (step = 32; step <= info->size; step <<= 1)
     {
-      total_size = (uint64_t)step * (uint64_t)repeat_cnt;
+      total_size = (uint64_t)step * (uint64_t)info->repeat_num;
 
       if (step < 1024)
         {
@@ -398,36 +990,29 @@ static void memcpy_speed_test(FAR void *dest, FAR const void *src,
                  step / 1024);
         }
 
-      if (irq_disable)
+      for (k = next_kernel(info, NULL); k != NULL; k = next_kernel(info, k))
         {
-          flags = enter_critical_section();
-        }
+          if (info->irq_disable)
+            {
+              flags = enter_critical_section();
+            }
 
-      start_time = get_timestamp();
+          start_time = get_timestamp();
 
-      for (cnt = 0; cnt < repeat_cnt; cnt++)
-        {
-          memcpy(dest, src, step);
-        }
+          for (cnt = 0; cnt < info->repeat_num; cnt++)
+            {
+              k->copy(info->dest, info->src, step);
+            }
 
-      cost_time_system = get_time_elaps(start_time);
+          cost_time = get_time_elaps(start_time);
 
-      start_time = get_timestamp();
+          if (info->irq_disable)
+            {
+              leave_critical_section(flags);
+            }
 
-      for (cnt = 0; cnt < repeat_cnt; cnt++)
-        {
-          internal_memcpy(dest, src, step);
+          print_rate(k->name, "memcpy", total_size, cost_time);
         }
-
-      cost_time_internal = get_time_elaps(start_time);
-
-      if (irq_disable)
-        {
-          leave_critical_section(flags);
-        }
-
-      print_rate("system memcpy():\t", total_size, cost_time_system);
-      print_rate("internal memcpy():\t", total_size, cost_time_internal);
     }
 }
 
@@ -435,13 +1020,11 @@ static void memcpy_speed_test(FAR void *dest, FAR const void *src,
  * Name: memset_speed_test
  ****************************************************************************/
 
-static void memset_speed_test(FAR void *dest, uint8_t value,
-                              size_t size, uint32_t repeat_num,
-                              bool irq_disable)
+static void memset_speed_test(FAR struct ramspeed_s *info)
 {
+  FAR const struct ramspeed_kernel_s *k;
   uint32_t start_time;
-  uint32_t cost_time_system;
-  uint32_t cost_time_internal;
+  uint32_t cost_time;
   uint32_t cnt;
   uint32_t step;
   uint64_t total_size;
@@ -449,9 +1032,9 @@ static void memset_speed_test(FAR void *dest, uint8_t value,
 
   printf("______memset performance______\n");
 
-  for (step = 32; step <= size; step <<= 1)
+  for (step = 32; step <= info->size; step <<= 1)
     {
-      total_size = (uint64_t)step * (uint64_t)repeat_num;
+      total_size = (uint64_t)step * (uint64_t)info->repeat_num;
 
       if (step < 1024)
         {
@@ -463,37 +1046,296 @@ static void memset_speed_test(FAR void *dest, uint8_t value,
                  step / 1024);
         }
 
-      if (irq_disable)
+      for (k = next_kernel(info, NULL); k != NULL; k = next_kernel(info, k))
+        {
+          if (info->irq_disable)
+            {
+              flags = enter_critical_section();
+            }
+
+          start_time = get_timestamp();
+
+          for (cnt = 0; cnt < info->repeat_num; cnt++)
+            {
+              k->set(info->dest, info->value, step);
+            }
+
+          cost_time = get_time_elaps(start_time);
+
+          if (info->irq_disable)
+            {
+              leave_critical_section(flags);
+            }
+
+          print_rate(k->name, "memset", total_size, cost_time);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: curve_point
+ *
+ * Description:
+ *   Bandwidth in MB/s of one kernel at one size, doubling the number of
+ *   repetitions until the run is long enough to time.
+ *
+ ****************************************************************************/
+
+static uint32_t curve_point(FAR struct ramspeed_s *info,
+                            FAR const struct ramspeed_kernel_s *k,
+                            bool copy, size_t size)
+{
+  irqstate_t flags = 0;
+  uint64_t elapsed;
+  uint64_t start;
+  uint32_t repeat;
+  uint32_t cnt;
+
+  for (repeat = 1; ; repeat <<= 1)
+    {
+      if (info->irq_disable)
         {
           flags = enter_critical_section();
         }
 
-      start_time = get_timestamp();
+      start = get_time_us();
+      for (cnt = 0; cnt < repeat; cnt++)
+        {
+          if (copy)
+            {
+              k->copy(info->dest, info->src, size);
+            }
+          else
+            {
+              k->set(info->dest, info->value, size);
+            }
+        }
+
+      elapsed = get_time_us() - start;
 
-      for (cnt = 0; cnt < repeat_num; cnt++)
+      if (info->irq_disable)
         {
-          memset(dest, value, step);
+          leave_critical_section(flags);
         }
 
-      cost_time_system = get_time_elaps(start_time);
+      if (elapsed >= CURVE_MIN_US || repeat >= UINT32_MAX / 2)
+        {
+          break;
+        }
+    }
+
+  /* Bytes per microsecond are MB/s */
+
+  return (uint64_t)size * repeat / (elapsed > 0 ? elapsed : 1);
+}
+
+/****************************************************************************
+ * Name: curve_test
+ *
+ * Description:
+ *   Print one row per size and one column per kernel.  A rate well below
+ *   the one at the size before is marked with '*': that is where the
+ *   buffers stopped fitting into a cache level or a faster memory.
+ *
+ ****************************************************************************/
 
-      start_time = get_timestamp();
+static void curve_test(FAR struct ramspeed_s *info, bool copy)
+{
+  FAR const struct ramspeed_kernel_s *k;
+  uint32_t prev[nitems(g_ramspeed_kernels)];
+  uint32_t rate;
+  size_t size;
+  int i;
+
+  printf("______%s bandwidth (MB/s)______\n", copy ? "memcpy" : "memset");
+  printf("%10s", "size");
+  for (k = next_kernel(info, NULL); k != NULL; k = next_kernel(info, k))
+    {
+      printf(" %10s", k->name);
+    }
+
+  printf("\n");
+
+  memset(prev, 0, sizeof(prev));
+  for (size = CURVE_MIN_SIZE; size <= info->size; size <<= 1)
+    {
+      if (size < 1024)
+        {
+          printf("%9zuB", size);
+        }
+      else if (size < 1024 * 1024)
+        {
+          printf("%8zuKB", size / 1024);
+        }
+      else
+        {
+          printf("%8zuMB", size / 1024 / 1024);
+        }
 
-      for (cnt = 0; cnt < repeat_num; cnt++)
+      for (k = next_kernel(info, NULL); k != NULL; k = next_kernel(info, k))
         {
-          internal_memset(dest, value, step);
+          i    = k - g_ramspeed_kernels;
+          rate = curve_point(info, k, copy, size);
+          printf(" %9" PRIu32 "%c", rate,
+                 rate < prev[i] - prev[i] / 4 ? '*' : ' ');
+          prev[i] = rate;
         }
 
-      cost_time_internal = get_time_elaps(start_time);
+      printf("\n");
+    }
+}
+
+/****************************************************************************
+ * Name: thread_main
+ ****************************************************************************/
+
+static FAR void *thread_main(FAR void *arg)
+{
+  FAR struct ramspeed_thread_s *t = arg;
+  FAR struct ramspeed_s *info = t->info;
+  uint32_t cnt;
+
+#ifdef CONFIG_SMP
+  cpu_set_t cpuset;
 
-      if (irq_disable)
+  CPU_ZERO(&cpuset);
+  CPU_SET(t->cpu, &cpuset);
+  if (sched_setaffinity(0, sizeof(cpuset), &cpuset) < 0)
+    {
+      printf(RAMSPEED_PREFIX "Can't run on CPU%d\n", t->cpu);
+    }
+#endif
+
+  /* Start together, so that all of them are accessing memory at once */
+
+  pthread_barrier_wait(t->barrier);
+
+  t->start = get_time_us();
+  for (cnt = 0; cnt < info->repeat_num; cnt++)
+    {
+      if (t->copy)
         {
-          leave_critical_section(flags);
+          t->kernel->copy(t->dest, t->src, info->size);
+        }
+      else
+        {
+          t->kernel->set(t->dest, info->value, info->size);
+        }
+    }
+
+  t->end = get_time_us();
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: print_gbps
+ ****************************************************************************/
+
+static void print_gbps(FAR const char *name, FAR const char *op,
+                       FAR const char *who, uint64_t bytes,
+                       uint64_t elapsed)
+{
+  uint32_t rate = bytes / (elapsed > 0 ? elapsed : 1);
+
+  /* Bytes per microsecond are MB/s */
+
+  printf(RAMSPEED_PREFIX "%s %s() %s:\t%" PRIu32 ".%03" PRIu32 " GB/s\n",
+         name, op, who, rate / 1000, rate % 1000);
+}
+
+/****************************************************************************
+ * Name: threads_test
+ *
+ * Description:
+ *   Run a kernel on info->nthreads threads pinned to different CPUs at the
+ *   same time.  Compared with what one thread gets alone, the per-thread
+ *   rates show how much the bus and the memory banks are shared.
+ *
+ ****************************************************************************/
+
+static void threads_test(FAR struct ramspeed_s *info, bool copy)
+{
+  FAR const struct ramspeed_kernel_s *k;
+  FAR struct ramspeed_thread_s *threads;
+  FAR const char *op = copy ? "memcpy" : "memset";
+  pthread_barrier_t barrier;
+  FAR pthread_t *tids;
+  uint64_t start;
+  uint64_t end;
+  uint64_t bytes;
+  char who[24];
+  uint32_t i;
+  int ret;
+
+  threads = calloc(info->nthreads, sizeof(*threads));
+  tids    = calloc(info->nthreads, sizeof(*tids));
+  if (threads == NULL || tids == NULL)
+    {
+      printf(RAMSPEED_PREFIX "Out of memory\n");
+      goto out;
+    }
+
+  printf("______%s on %" PRIu32 " threads, %s buffers______\n", op,
+         info->nthreads, info->shared ? "shared" : "separate");
+
+  bytes = (uint64_t)info->size * info->repeat_num;
+  for (k = next_kernel(info, NULL); k != NULL; k = next_kernel(info, k))
+    {
+      pthread_barrier_init(&barrier, NULL, info->nthreads);
+
+      for (i = 0; i < info->nthreads; i++)
+        {
+          size_t offset = info->shared ? 0 : i * info->size;
+
+          threads[i].info    = info;
+          threads[i].kernel  = k;
+          threads[i].barrier = &barrier;
+          threads[i].dest    = (FAR uint8_t *)info->dest + offset;
+          threads[i].src     = (FAR const uint8_t *)info->src + offset;
+          threads[i].copy    = copy;
+#ifdef CONFIG_SMP
+          threads[i].cpu     = i % CONFIG_SMP_NCPUS;
+#endif
+
+          ret = pthread_create(&tids[i], NULL, thread_main, &threads[i]);
+          if (ret != 0)
+            {
+              /* The barrier would never open */
+
+              printf(RAMSPEED_PREFIX "pthread_create failed: %d\n", ret);
+              exit(EXIT_FAILURE);
+            }
+        }
+
+      start = UINT64_MAX;
+      end   = 0;
+      for (i = 0; i < info->nthreads; i++)
+        {
+          pthread_join(tids[i], NULL);
+          start = MIN(start, threads[i].start);
+          end   = MAX(end, threads[i].end);
         }
 
-      print_rate("system memset():\t", total_size, cost_time_system);
-      print_rate("internal memset():\t", total_size, cost_time_internal);
+      pthread_barrier_destroy(&barrier);
+
+      for (i = 0; i < info->nthreads; i++)
+        {
+#ifdef CONFIG_SMP
+          snprintf(who, sizeof(who), "%" PRIu32 "/CPU%d", i,
+                   threads[i].cpu);
+#else
+          snprintf(who, sizeof(who), "%" PRIu32, i);
+#endif
+          print_gbps(k->name, op, who, bytes,
+                     threads[i].end - threads[i].start);
+        }
+
+      print_gbps(k->name, op, "total", bytes * info->nthreads, end - start);
     }
+
+out:
+  free(threads);
+  free(tids);
 }
 
 /****************************************************************************
@@ -510,13 +1352,21 @@ int main(int argc, FAR char *argv[])
 
   parse_commandline(argc, argv, &ramspeed);
 
-  memcpy_speed_test(ramspeed.dest, ramspeed.src,
-                    ramspeed.size, ramspeed.repeat_num,
-                    ramspeed.irq_disable);
-
-  memset_speed_test(ramspeed.dest, ramspeed.value,
-                    ramspeed.size, ramspeed.repeat_num,
-                    ramspeed.irq_disable);
+  if (ramspeed.nthreads > 0)
+    {
+      threads_test(&ramspeed, true);
+      threads_test(&ramspeed, false);
+    }
+  else if (ramspeed.curve)
+    {
+      curve_test(&ramspeed, true);
+      curve_test(&ramspeed, false);
+    }
+  else
+    {
+      memcpy_speed_test(&ramspeed);
+      memset_speed_test(&ramspeed);
+    }
 
   return EXIT_SUCCESS;
 }
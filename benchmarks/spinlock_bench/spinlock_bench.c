@@ -22,9 +22,22 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include <stdio.h>
 #include <assert.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <unistd.h>
 #include <nuttx/spinlock.h>
 #include <time.h>
 
@@ -32,79 +45,564 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
-#define TEST_NUM CONFIG_SPINLOCK_MULTITHREAD
 #define THREAD_NUM CONFIG_SPINLOCK_MULTITHREAD
 
+#ifndef CONFIG_SPINLOCK_DURATION
+#  define CONFIG_SPINLOCK_DURATION 100
+#endif
+
+#ifdef CONFIG_SMP
+#  define CPU_NUM CONFIG_SMP_NCPUS
+#else
+#  define CPU_NUM 1
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+/* A queue lock: each waiter spins on its own node, so a release touches
+ * only the line of the next owner rather than that of every waiter.
+ */
+
+struct mcs_node_s
+{
+  _Atomic(struct mcs_node_s *) next;
+  atomic_int locked;
+};
+
+typedef _Atomic(struct mcs_node_s *) mcs_lock_t;
+
+struct bench_s;
+struct thread_parmeter_s;
+
+struct lock_ops_s
+{
+  FAR const char *name;
+  bool work;                   /* Has a critical section to lengthen */
+  bool reader;                 /* Shares the lock, must not write */
+  CODE void (*lock)(FAR struct bench_s *bench,
+                    FAR struct thread_parmeter_s *para);
+  CODE void (*unlock)(FAR struct bench_s *bench,
+                      FAR struct thread_parmeter_s *para);
+};
+
+struct bench_s
+{
+  spinlock_t lock;
+#ifdef CONFIG_RW_SPINLOCK
+  rwlock_t rwlock;
+#endif
+  rspinlock_t rlock;
+  mcs_lock_t mcs;
+  pthread_mutex_t mutex;
+  atomic_ulong counter;
+  volatile unsigned long shared;
+  volatile bool stop;
+  int work;
+  sem_t start;
+  FAR const struct lock_ops_s *ops;
+};
+
 struct thread_parmeter_s
 {
-  FAR int *result;
-  FAR spinlock_t *lock;
+  FAR struct bench_s *bench;
+  struct mcs_node_s node;
+  irqstate_t flags;
+  unsigned long count;
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void bench_spin_lock(FAR struct bench_s *bench,
+                            FAR struct thread_parmeter_s *para);
+static void bench_spin_unlock(FAR struct bench_s *bench,
+                              FAR struct thread_parmeter_s *para);
+#ifdef CONFIG_RW_SPINLOCK
+static void bench_read_lock(FAR struct bench_s *bench,
+                            FAR struct thread_parmeter_s *para);
+static void bench_read_unlock(FAR struct bench_s *bench,
+                              FAR struct thread_parmeter_s *para);
+static void bench_write_lock(FAR struct bench_s *bench,
+                             FAR struct thread_parmeter_s *para);
+static void bench_write_unlock(FAR struct bench_s *bench,
+                               FAR struct thread_parmeter_s *para);
+#endif
+static void bench_rspin_lock(FAR struct bench_s *bench,
+                             FAR struct thread_parmeter_s *para);
+static void bench_rspin_unlock(FAR struct bench_s *bench,
+                               FAR struct thread_parmeter_s *para);
+static void bench_mcs_lock(FAR struct bench_s *bench,
+                           FAR struct thread_parmeter_s *para);
+static void bench_mcs_unlock(FAR struct bench_s *bench,
+                             FAR struct thread_parmeter_s *para);
+static void bench_mutex_lock(FAR struct bench_s *bench,
+                             FAR struct thread_parmeter_s *para);
+static void bench_mutex_unlock(FAR struct bench_s *bench,
+                               FAR struct thread_parmeter_s *para);
+static void bench_atomic(FAR struct bench_s *bench,
+                         FAR struct thread_parmeter_s *para);
+static void bench_none(FAR struct bench_s *bench,
+                       FAR struct thread_parmeter_s *para);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The atomic increment is the whole critical section, there is nothing to
+ * lengthen.
+ */
+
+static const struct lock_ops_s g_lock_ops[] =
+{
+  {"spinlock", true, false, bench_spin_lock, bench_spin_unlock},
+#ifdef CONFIG_RW_SPINLOCK
+  {"rwlock-read", true, true, bench_read_lock, bench_read_unlock},
+  {"rwlock-write", true, false, bench_write_lock, bench_write_unlock},
+#endif
+  {"rspinlock", true, false, bench_rspin_lock, bench_rspin_unlock},
+  {"mcs", true, false, bench_mcs_lock, bench_mcs_unlock},
+  {"mutex", true, false, bench_mutex_lock, bench_mutex_unlock},
+  {"atomic", false, false, bench_atomic, bench_none},
+};
+
+/* Critical section lengths, in accesses to the shared data */
+
+static const int g_work[] =
+{
+  0, 16, 256
 };
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
-static FAR void *thread_spinlock(FAR void *parameter)
+static void bench_spin_lock(FAR struct bench_s *bench,
+                            FAR struct thread_parmeter_s *para)
+{
+  spin_lock(&bench->lock);
+}
+
+static void bench_spin_unlock(FAR struct bench_s *bench,
+                              FAR struct thread_parmeter_s *para)
+{
+  spin_unlock(&bench->lock);
+}
+
+#ifdef CONFIG_RW_SPINLOCK
+static void bench_read_lock(FAR struct bench_s *bench,
+                            FAR struct thread_parmeter_s *para)
+{
+  read_lock(&bench->rwlock);
+}
+
+static void bench_read_unlock(FAR struct bench_s *bench,
+                              FAR struct thread_parmeter_s *para)
+{
+  read_unlock(&bench->rwlock);
+}
+
+static void bench_write_lock(FAR struct bench_s *bench,
+                             FAR struct thread_parmeter_s *para)
+{
+  write_lock(&bench->rwlock);
+}
+
+static void bench_write_unlock(FAR struct bench_s *bench,
+                               FAR struct thread_parmeter_s *para)
+{
+  write_unlock(&bench->rwlock);
+}
+#endif
+
+static void bench_rspin_lock(FAR struct bench_s *bench,
+                             FAR struct thread_parmeter_s *para)
+{
+  para->flags = rspin_lock_irqsave(&bench->rlock);
+}
+
+static void bench_rspin_unlock(FAR struct bench_s *bench,
+                               FAR struct thread_parmeter_s *para)
+{
+  rspin_unlock_irqrestore(&bench->rlock, para->flags);
+}
+
+static void bench_mcs_lock(FAR struct bench_s *bench,
+                           FAR struct thread_parmeter_s *para)
+{
+  FAR struct mcs_node_s *node = &para->node;
+  FAR struct mcs_node_s *prev;
+
+  atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+  atomic_store_explicit(&node->locked, 1, memory_order_relaxed);
+
+  prev = atomic_exchange_explicit(&bench->mcs, node, memory_order_acq_rel);
+  if (prev != NULL)
+    {
+      atomic_store_explicit(&prev->next, node, memory_order_release);
+      while (atomic_load_explicit(&node->locked, memory_order_acquire))
+        {
+        }
+    }
+}
+
+static void bench_mcs_unlock(FAR struct bench_s *bench,
+                             FAR struct thread_parmeter_s *para)
+{
+  FAR struct mcs_node_s *node = &para->node;
+  FAR struct mcs_node_s *next;
+  FAR struct mcs_node_s *expect = node;
+
+  next = atomic_load_explicit(&node->next, memory_order_acquire);
+  if (next == NULL)
+    {
+      if (atomic_compare_exchange_strong_explicit(&bench->mcs, &expect,
+                                                  NULL,
+                                                  memory_order_release,
+                                                  memory_order_relaxed))
+        {
+          return;
+        }
+
+      /* A waiter is linking itself in */
+
+      while ((next = atomic_load_explicit(&node->next,
+                                          memory_order_acquire)) == NULL)
+        {
+        }
+    }
+
+  atomic_store_explicit(&next->locked, 0, memory_order_release);
+}
+
+static void bench_mutex_lock(FAR struct bench_s *bench,
+                             FAR struct thread_parmeter_s *para)
+{
+  pthread_mutex_lock(&bench->mutex);
+}
+
+static void bench_mutex_unlock(FAR struct bench_s *bench,
+                               FAR struct thread_parmeter_s *para)
+{
+  pthread_mutex_unlock(&bench->mutex);
+}
+
+static void bench_atomic(FAR struct bench_s *bench,
+                         FAR struct thread_parmeter_s *para)
+{
+  atomic_fetch_add_explicit(&bench->counter, 1, memory_order_relaxed);
+}
+
+static void bench_none(FAR struct bench_s *bench,
+                       FAR struct thread_parmeter_s *para)
 {
-  FAR int *result = ((FAR struct thread_parmeter_s *)parameter)->result;
-  FAR spinlock_t *lock = ((FAR struct thread_parmeter_s *)parameter)->lock;
+}
 
+static FAR void *thread_spinlock(FAR void *parameter)
+{
+  FAR struct thread_parmeter_s *para = parameter;
+  FAR struct bench_s *bench = para->bench;
+  FAR const struct lock_ops_s *ops = bench->ops;
+  unsigned long sum = 0;
   int i;
 
-  for (i = 0; i < TEST_NUM; i++)
+  sem_wait(&bench->start);
+
+  while (!bench->stop)
     {
-      spin_lock(lock);
-      (*result)++;
-      spin_unlock(lock);
+      ops->lock(bench, para);
+
+      if (ops->reader)
+        {
+          for (i = 0; i < bench->work; i++)
+            {
+              sum += bench->shared;
+            }
+        }
+      else
+        {
+          for (i = 0; i < bench->work; i++)
+            {
+              bench->shared++;
+            }
+        }
+
+      ops->unlock(bench, para);
+      para->count++;
     }
 
+  UNUSED(sum);
   return NULL;
 }
 
 /****************************************************************************
- * Public Functions
+ * Name: bench_run
+ *
+ * Description:
+ *   Let nthreads threads take the lock for duration milliseconds and print
+ *   the acquisitions per second and how evenly they were shared.  The
+ *   threads are spread over the CPUs, round robin below the priority of
+ *   this task, so that oversubscribed runs show what a preempted holder
+ *   costs.
+ *
  ****************************************************************************/
 
-void main(void)
+static int bench_run(FAR struct bench_s *bench,
+                     FAR struct thread_parmeter_s *para,
+                     FAR pthread_t *thread, int nthreads, int duration)
 {
-  spinlock_t lock = SP_UNLOCKED;
-  int result = 0;
-  pthread_t thread[THREAD_NUM];
-  struct thread_parmeter_s para;
-  clock_t start;
-  clock_t end;
-
-  int status;
+  struct sched_param param;
+  struct timespec start;
+  struct timespec end;
+  pthread_attr_t attr;
+#ifdef CONFIG_SMP
+  cpu_set_t cpuset;
+#endif
+  unsigned long total = 0;
+  unsigned long min = ULONG_MAX;
+  unsigned long max = 0;
+  double square = 0;
+  uint64_t msec;
+  int status = 0;
+  int n;
   int i;
 
-  para.result = &result;
-  para.lock = &lock;
+  bench->stop = false;
+  atomic_store(&bench->mcs, NULL);
+  sem_init(&bench->start, 0, 0);
 
-  start = perf_gettime();
-  for (i = 0; i < THREAD_NUM; ++i)
+  sched_getparam(0, &param);
+  if (param.sched_priority > SCHED_PRIORITY_MIN)
     {
-      status = pthread_create(&thread[i], NULL,
-                              thread_spinlock, &para);
+      param.sched_priority--;
+    }
+
+  for (n = 0; n < nthreads; n++)
+    {
+      para[n].bench = bench;
+      para[n].count = 0;
+
+      pthread_attr_init(&attr);
+      pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy(&attr, SCHED_RR);
+      pthread_attr_setschedparam(&attr, &param);
+#ifdef CONFIG_SMP
+      CPU_ZERO(&cpuset);
+      CPU_SET(n % CPU_NUM, &cpuset);
+      pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+#endif
+
+      status = pthread_create(&thread[n], &attr, thread_spinlock, &para[n]);
+      pthread_attr_destroy(&attr);
       if (status != 0)
         {
           printf("spinlock_test: ERROR pthread_create failed, status=%d\n",
                  status);
-          ASSERT(false);
+          break;
         }
     }
 
-  for (i = 0; i < THREAD_NUM; ++i)
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < n; i++)
+    {
+      sem_post(&bench->start);
+    }
+
+  if (status == 0)
+    {
+      usleep(duration * 1000);
+    }
+
+  bench->stop = true;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  for (i = 0; i < n; i++)
     {
       pthread_join(thread[i], NULL);
     }
 
-  end = perf_gettime();
-  assert(result == THREAD_NUM * TEST_NUM);
+  sem_destroy(&bench->start);
+  if (status != 0)
+    {
+      return -status;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      total  += para[i].count;
+      square += (double)para[i].count * para[i].count;
+      min     = MIN(min, para[i].count);
+      max     = MAX(max, para[i].count);
+    }
+
+  msec = (end.tv_sec - start.tv_sec) * 1000 +
+         (end.tv_nsec - start.tv_nsec) / 1000000;
+  if (msec == 0)
+    {
+      msec = 1;
+    }
+
+  /* Jain's fairness index: 100% when every thread got the same share,
+   * 100 / nthreads when one got it all.
+   */
+
+  printf("%-12s %4d %5d %12" PRIu64 " %10" PRIu64 " %10" PRIu64
+         " %5.1f%%\n", bench->ops->name, nthreads, bench->work,
+         (uint64_t)total * 1000 / msec, (uint64_t)min * 1000 / msec,
+         (uint64_t)max * 1000 / msec,
+         square > 0 ? 100.0 * total * total / (n * square) : 0.0);
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname)
+{
+  size_t i;
+
+  printf("Usage: %s [-n threads] [-d msec] [-w work] [-l lock]\n",
+         progname);
+  printf("  -n  Most threads, runs 1, 2, 4... up to it (default %d)\n",
+         THREAD_NUM);
+  printf("  -d  Time of each run in milliseconds (default %d)\n",
+         CONFIG_SPINLOCK_DURATION);
+  printf("  -w  Only this critical section length, in shared accesses\n");
+  printf("  -l  Only this lock:");
+  for (i = 0; i < nitems(g_lock_ops); i++)
+    {
+      printf(" %s", g_lock_ops[i].name);
+    }
+
+  printf("\n");
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR struct thread_parmeter_s *para;
+  FAR const char *name = NULL;
+  FAR struct bench_s *bench;
+  FAR pthread_t *thread;
+  int duration = CONFIG_SPINLOCK_DURATION;
+  int nthreads = THREAD_NUM;
+  int work = -1;
+  int ret = 0;
+  int opt;
+  size_t i;
+  size_t j;
+  int n;
+
+  while ((opt = getopt(argc, argv, "n:d:w:l:h")) != -1)
+    {
+      switch (opt)
+        {
+          case 'n':
+            nthreads = atoi(optarg);
+            break;
+          case 'd':
+            duration = atoi(optarg);
+            break;
+          case 'w':
+            work = atoi(optarg);
+            break;
+          case 'l':
+            name = optarg;
+            break;
+          case 'h':
+            show_usage(argv[0]);
+            return EXIT_SUCCESS;
+          default:
+            show_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (nthreads <= 0 || duration <= 0)
+    {
+      show_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  /* All of the locks are unlocked when zeroed */
+
+  bench  = calloc(1, sizeof(*bench));
+  para   = calloc(nthreads, sizeof(*para));
+  thread = malloc(nthreads * sizeof(*thread));
+  if (bench == NULL || para == NULL || thread == NULL)
+    {
+      printf("spinlock_test: ERROR no memory for %d threads\n", nthreads);
+      ret = -ENOMEM;
+      goto out;
+    }
+
+  pthread_mutex_init(&bench->mutex, NULL);
+
+  printf("%d CPUs, %s spinlock, acquisitions per second\n", CPU_NUM,
+#ifdef CONFIG_TICKET_SPINLOCK
+         "ticket"
+#else
+         "test and set"
+#endif
+        );
+  printf("%-12s %4s %5s %12s %10s %10s %6s\n", "lock", "thr", "work",
+         "total", "min", "max", "fair");
+
+  for (i = 0; i < nitems(g_lock_ops) && ret == 0; i++)
+    {
+      if (name != NULL && strcmp(name, g_lock_ops[i].name) != 0)
+        {
+          continue;
+        }
+
+      bench->ops = &g_lock_ops[i];
+
+      for (j = 0; j < nitems(g_work) && ret == 0; j++)
+        {
+          if (work >= 0)
+            {
+              /* Just the one length asked for */
+
+              if (j > 0)
+                {
+                  break;
+                }
+
+              bench->work = work;
+            }
+          else
+            {
+              bench->work = g_work[j];
+            }
+
+          if (!bench->ops->work && bench->work > 0)
+            {
+              continue;
+            }
+
+          for (n = 1; ret == 0; n = MIN(n * 2, nthreads))
+            {
+              ret = bench_run(bench, para, thread, n, duration);
+              if (n == nthreads)
+                {
+                  break;
+                }
+            }
+        }
+    }
+
+  pthread_mutex_destroy(&bench->mutex);
 
-  printf("total_time: %lu\n", end - start);
+out:
+  free(thread);
+  free(para);
+  free(bench);
+  return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -0,0 +1,413 @@
+/****************************************************************************
+ * apps/benchmarks/wasmbench/wasmbench_main.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "builtin/builtin.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define WASMBENCH_MAXARGS  8
+#define WASMBENCH_PATHLEN  64
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A wasm engine and the arguments placed before the module */
+
+struct wasmbench_engine_s
+{
+  FAR const char *name;
+  FAR const char *opts;
+};
+
+/* A workload: a module and the arguments running it for n iterations */
+
+struct wasmbench_workload_s
+{
+  FAR const char *name;
+  FAR const char *args;      /* Arguments, %u is replaced by n */
+  unsigned int    iters;     /* Default number of iterations */
+};
+
+/* The best result of the runs of a workload on an engine */
+
+struct wasmbench_result_s
+{
+  uint64_t startup;          /* Run with 1 iteration, in ns */
+  uint64_t elapsed;          /* Run with n iterations, in ns */
+  size_t   peak;             /* Heap used above the baseline, in bytes */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct wasmbench_engine_s g_engines[] =
+{
+#ifdef CONFIG_INTERPRETERS_IWASM_TASK
+  { "iwasm",   NULL     },
+#endif
+#ifdef CONFIG_INTERPRETERS_WASM3
+  { "wasm3",   NULL     },
+#endif
+#ifdef CONFIG_INTERPRETERS_TOYWASM
+  { "toywasm", "--wasi" },
+#endif
+};
+
+/* CoreMark takes its seeds before the number of iterations, 0 iterations
+ * would let it calibrate itself to run for 10 seconds.
+ */
+
+static const struct wasmbench_workload_s g_workloads[] =
+{
+  { "coremark",    "0x0 0x0 0x66 %u", 2000   },
+  { "wb_sha256",   "%u",              1000   },
+  { "wb_json",     "%u",              500    },
+  { "wb_control",  "%u",              100000 },
+};
+
+#define WASMBENCH_NENGINES   (sizeof(g_engines) / sizeof(g_engines[0]))
+#define WASMBENCH_NWORKLOADS (sizeof(g_workloads) / sizeof(g_workloads[0]))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wasmbench_now
+ ****************************************************************************/
+
+static uint64_t wasmbench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: wasmbench_heapused
+ ****************************************************************************/
+
+static size_t wasmbench_heapused(void)
+{
+  struct mallinfo info = mallinfo();
+
+  return info.uordblks;
+}
+
+/****************************************************************************
+ * Name: wasmbench_run
+ *
+ * Description:
+ *   Run one workload for n iterations on an engine.  The output of the
+ *   workload is discarded, the heap usage is sampled until it exits.
+ *
+ * Returned Value:
+ *   Zero (OK) on success, a negated errno value if the engine could not be
+ *   started and -EIO if the workload failed.
+ *
+ ****************************************************************************/
+
+static int wasmbench_run(FAR const struct wasmbench_engine_s *engine,
+                         FAR const struct wasmbench_workload_s *workload,
+                         FAR const char *dir, unsigned int n,
+                         FAR uint64_t *elapsed, FAR size_t *peak)
+{
+  FAR char *argv[WASMBENCH_MAXARGS + 1];
+  char module[WASMBENCH_PATHLEN];
+  char args[32];
+  FAR char *saveptr;
+  FAR char *arg;
+  uint64_t start;
+  size_t base;
+  size_t used;
+  pid_t pid;
+  int status;
+  int argc = 0;
+
+  argv[argc++] = (FAR char *)engine->name;
+  if (engine->opts != NULL)
+    {
+      argv[argc++] = (FAR char *)engine->opts;
+    }
+
+  snprintf(module, sizeof(module), "%s/%s.wasm", dir, workload->name);
+  argv[argc++] = module;
+
+  snprintf(args, sizeof(args), workload->args, n);
+  for (arg = strtok_r(args, " ", &saveptr);
+       arg != NULL && argc < WASMBENCH_MAXARGS;
+       arg = strtok_r(NULL, " ", &saveptr))
+    {
+      argv[argc++] = arg;
+    }
+
+  argv[argc] = NULL;
+
+  base  = wasmbench_heapused();
+  *peak = 0;
+  start = wasmbench_now();
+
+  pid = exec_builtin(engine->name, argv, "/dev/null", O_WRONLY);
+  if (pid < 0)
+    {
+      return -errno;
+    }
+
+  while (waitpid(pid, &status, WNOHANG) == 0)
+    {
+      used = wasmbench_heapused();
+      if (used > base && used - base > *peak)
+        {
+          *peak = used - base;
+        }
+
+      usleep(CONFIG_BENCHMARK_WASMBENCH_SAMPLE_MS * 1000);
+    }
+
+  *elapsed = wasmbench_now() - start;
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+      return -EIO;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: wasmbench_measure
+ *
+ * Description:
+ *   Keep the best of the runs.  The run with one iteration gives the
+ *   startup time (load, parse and instantiation), which is subtracted from
+ *   the run with n iterations to get the execution speed.
+ *
+ ****************************************************************************/
+
+static int wasmbench_measure(FAR const struct wasmbench_engine_s *engine,
+                             FAR const struct wasmbench_workload_s *workload,
+                             FAR const char *dir, unsigned int n, int runs,
+                             FAR struct wasmbench_result_s *result)
+{
+  uint64_t elapsed;
+  size_t peak;
+  int ret;
+  int i;
+
+  result->startup = UINT64_MAX;
+  result->elapsed = UINT64_MAX;
+  result->peak    = 0;
+
+  for (i = 0; i < runs; i++)
+    {
+      ret = wasmbench_run(engine, workload, dir, 1, &elapsed, &peak);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      if (elapsed < result->startup)
+        {
+          result->startup = elapsed;
+        }
+
+      ret = wasmbench_run(engine, workload, dir, n, &elapsed, &peak);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      if (elapsed < result->elapsed)
+        {
+          result->elapsed = elapsed;
+        }
+
+      if (peak > result->peak)
+        {
+          result->peak = peak;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname)
+{
+  size_t i;
+
+  printf("Usage: %s [-d dir] [-n iterations] [-r runs] [workload ...]\n",
+         progname);
+  printf("  -d  Directory of the wasm modules (default %s)\n",
+         CONFIG_BENCHMARK_WASMBENCH_PATH);
+  printf("  -n  Iterations of each workload (default per workload)\n");
+  printf("  -r  Runs of each measure, the best is kept (default %d)\n",
+         CONFIG_BENCHMARK_WASMBENCH_RUNS);
+  printf("Workloads:");
+  for (i = 0; i < WASMBENCH_NWORKLOADS; i++)
+    {
+      printf(" %s", g_workloads[i].name);
+    }
+
+  printf("\n");
+}
+
+/****************************************************************************
+ * Name: wasmbench_selected
+ ****************************************************************************/
+
+static bool wasmbench_selected(FAR const char *name, int first, int argc,
+                               FAR char *argv[])
+{
+  int i;
+
+  if (first >= argc)
+    {
+      return true;
+    }
+
+  for (i = first; i < argc; i++)
+    {
+      if (strcmp(argv[i], name) == 0)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR const struct wasmbench_workload_s *workload;
+  FAR const struct wasmbench_engine_s *engine;
+  FAR const char *dir = CONFIG_BENCHMARK_WASMBENCH_PATH;
+  struct wasmbench_result_s result;
+  int runs = CONFIG_BENCHMARK_WASMBENCH_RUNS;
+  unsigned int iters = 0;
+  unsigned int n;
+  uint64_t exec;
+  size_t i;
+  size_t j;
+  int opt;
+  int ret;
+
+  while ((opt = getopt(argc, argv, "d:n:r:h")) != -1)
+    {
+      switch (opt)
+        {
+          case 'd':
+            dir = optarg;
+            break;
+          case 'n':
+            iters = strtoul(optarg, NULL, 0);
+            break;
+          case 'r':
+            runs = atoi(optarg);
+            break;
+          case 'h':
+            show_usage(argv[0]);
+            return 0;
+          default:
+            show_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (runs < 1 || (iters > 0 && iters < 2))
+    {
+      show_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  printf("%-8s %-12s %12s %10s %12s\n",
+         "engine", "workload", "startup(us)", "peak(KB)", "iter/s");
+
+  for (i = 0; i < WASMBENCH_NWORKLOADS; i++)
+    {
+      workload = &g_workloads[i];
+      if (!wasmbench_selected(workload->name, optind, argc, argv))
+        {
+          continue;
+        }
+
+      n = iters > 0 ? iters : workload->iters;
+
+      for (j = 0; j < WASMBENCH_NENGINES; j++)
+        {
+          engine = &g_engines[j];
+
+          ret = wasmbench_measure(engine, workload, dir, n, runs, &result);
+          if (ret < 0)
+            {
+              printf("%-8s %-12s failed: %d\n",
+                     engine->name, workload->name, ret);
+              continue;
+            }
+
+          /* 0 iter/s if n is too small to be measured */
+
+          exec = result.elapsed > result.startup ?
+                 result.elapsed - result.startup : 0;
+
+          printf("%-8s %-12s %12llu %10zu %12llu\n",
+                 engine->name, workload->name,
+                 (unsigned long long)(result.startup / 1000),
+                 (result.peak + 1023) / 1024,
+                 exec > 0 ? (n - 1) * 1000000000ull / exec : 0ull);
+        }
+    }
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+/****************************************************************************
+ * apps/benchmarks/wasmbench/workloads/wb_control.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define WB_DT          0.001f    /* Control period, 1 kHz */
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Direct form II transposed biquad */
+
+struct wb_biquad_s
+{
+  float b0;
+  float b1;
+  float b2;
+  float a1;
+  float a2;
+  float z1;
+  float z2;
+};
+
+struct wb_pid_s
+{
+  float kp;
+  float ki;
+  float kd;
+  float integ;
+  float prev;
+  float limit;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wb_biquad
+ ****************************************************************************/
+
+static float wb_biquad(struct wb_biquad_s *f, float x)
+{
+  float y = f->b0 * x + f->z1;
+
+  f->z1 = f->b1 * x - f->a1 * y + f->z2;
+  f->z2 = f->b2 * x - f->a2 * y;
+  return y;
+}
+
+/****************************************************************************
+ * Name: wb_pid
+ ****************************************************************************/
+
+static float wb_pid(struct wb_pid_s *pid, float error)
+{
+  float out;
+
+  pid->integ += pid->ki * error * WB_DT;
+  if (pid->integ > pid->limit)
+    {
+      pid->integ = pid->limit;
+    }
+  else if (pid->integ < -pid->limit)
+    {
+      pid->integ = -pid->limit;
+    }
+
+  out = pid->kp * error + pid->integ +
+        pid->kd * (error - pid->prev) / WB_DT;
+  pid->prev = error;
+
+  if (out > pid->limit)
+    {
+      out = pid->limit;
+    }
+  else if (out < -pid->limit)
+    {
+      out = -pid->limit;
+    }
+
+  return out;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ *
+ * Description:
+ *   Run n steps of a motor speed loop: a PID controller drives a first
+ *   order plant whose measurement goes through a 2nd order low-pass
+ *   filter, the setpoint is a square wave.
+ *
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1;
+  struct wb_biquad_s filter =
+    {
+      /* Butterworth low-pass, fc = 100 Hz at 1 kHz */
+
+      .b0 = 0.0675f,
+      .b1 = 0.1349f,
+      .b2 = 0.0675f,
+      .a1 = -1.1430f,
+      .a2 = 0.4128f,
+    };
+
+  struct wb_pid_s pid =
+    {
+      .kp    = 0.8f,
+      .ki    = 20.0f,
+      .kd    = 0.0005f,
+      .limit = 12.0f,
+    };
+
+  float speed = 0.0f;
+  float error = 0.0f;
+  float setpoint;
+  float meas;
+  float volt;
+  unsigned long i;
+
+  for (i = 0; i < n; i++)
+    {
+      setpoint = (i / 500) & 1 ? 100.0f : 50.0f;
+      meas     = wb_biquad(&filter, speed);
+      volt     = wb_pid(&pid, setpoint - meas);
+
+      /* Plant: tau = 50 ms, gain = 10 rad/s per V */
+
+      speed   += (10.0f * volt - speed) * (WB_DT / 0.05f);
+      error   += setpoint > meas ? setpoint - meas : meas - setpoint;
+    }
+
+  printf("control: %lu steps, speed %d, mean error %d\n",
+         n, (int)speed, (int)(error / (n > 0 ? n : 1)));
+  return 0;
+}
@@ -0,0 +1,272 @@
+/****************************************************************************
+ * apps/benchmarks/wasmbench/workloads/wb_json.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct wb_parser_s
+{
+  const char *p;
+  unsigned long values;
+  long long sum;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* A typical telemetry document */
+
+static const char g_document[] =
+  "{\"device\":{\"id\":\"sensor-0042\",\"fw\":\"1.4.2\",\"uptime\":86400,"
+  "\"online\":true,\"tags\":[\"outdoor\",\"roof\",\"north\"]},"
+  "\"readings\":["
+  "{\"t\":1700000000,\"temp\":21.5,\"hum\":48,\"press\":1013.2},"
+  "{\"t\":1700000060,\"temp\":21.7,\"hum\":47,\"press\":1013.1},"
+  "{\"t\":1700000120,\"temp\":21.6,\"hum\":47,\"press\":1013.0},"
+  "{\"t\":1700000180,\"temp\":-3.25e1,\"hum\":46,\"press\":1012.9}],"
+  "\"alarms\":[],\"config\":{\"period\":60,\"unit\":\"C\\u00b0\","
+  "\"limits\":{\"low\":-10,\"high\":45},\"debug\":false,\"note\":null}}";
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static bool wb_value(struct wb_parser_s *ps);
+
+/****************************************************************************
+ * Name: wb_skip
+ ****************************************************************************/
+
+static void wb_skip(struct wb_parser_s *ps)
+{
+  while (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\n' ||
+         *ps->p == '\r')
+    {
+      ps->p++;
+    }
+}
+
+/****************************************************************************
+ * Name: wb_string
+ ****************************************************************************/
+
+static bool wb_string(struct wb_parser_s *ps)
+{
+  int i;
+
+  ps->p++;
+  while (*ps->p != '"')
+    {
+      if (*ps->p == '\0')
+        {
+          return false;
+        }
+
+      if (*ps->p++ == '\\')
+        {
+          if (*ps->p == 'u')
+            {
+              for (i = 1; i <= 4; i++)
+                {
+                  if (ps->p[i] == '\0')
+                    {
+                      return false;
+                    }
+                }
+
+              ps->p += 4;
+            }
+
+          ps->p++;
+        }
+    }
+
+  ps->p++;
+  return true;
+}
+
+/****************************************************************************
+ * Name: wb_number
+ ****************************************************************************/
+
+static bool wb_number(struct wb_parser_s *ps)
+{
+  char *end;
+  double value = strtod(ps->p, &end);
+
+  if (end == ps->p)
+    {
+      return false;
+    }
+
+  ps->p    = end;
+  ps->sum += (long long)value;
+  return true;
+}
+
+/****************************************************************************
+ * Name: wb_literal
+ ****************************************************************************/
+
+static bool wb_literal(struct wb_parser_s *ps, const char *word)
+{
+  while (*word != '\0')
+    {
+      if (*ps->p++ != *word++)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: wb_container
+ *
+ * Description:
+ *   Parse an object ('{' ... '}') or an array ('[' ... ']').
+ *
+ ****************************************************************************/
+
+static bool wb_container(struct wb_parser_s *ps, char close)
+{
+  ps->p++;
+  wb_skip(ps);
+  if (*ps->p == close)
+    {
+      ps->p++;
+      return true;
+    }
+
+  for (; ; )
+    {
+      if (close == '}')
+        {
+          wb_skip(ps);
+          if (*ps->p != '"' || !wb_string(ps))
+            {
+              return false;
+            }
+
+          wb_skip(ps);
+          if (*ps->p++ != ':')
+            {
+              return false;
+            }
+        }
+
+      if (!wb_value(ps))
+        {
+          return false;
+        }
+
+      wb_skip(ps);
+      if (*ps->p == close)
+        {
+          ps->p++;
+          return true;
+        }
+
+      if (*ps->p++ != ',')
+        {
+          return false;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: wb_value
+ ****************************************************************************/
+
+static bool wb_value(struct wb_parser_s *ps)
+{
+  wb_skip(ps);
+  ps->values++;
+
+  switch (*ps->p)
+    {
+      case '{':
+        return wb_container(ps, '}');
+      case '[':
+        return wb_container(ps, ']');
+      case '"':
+        return wb_string(ps);
+      case 't':
+        return wb_literal(ps, "true");
+      case 'f':
+        return wb_literal(ps, "false");
+      case 'n':
+        return wb_literal(ps, "null");
+      default:
+        return wb_number(ps);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ *
+ * Description:
+ *   Parse the document n times, counting the values and summing the
+ *   numbers.
+ *
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1;
+  struct wb_parser_s ps;
+  unsigned long values = 0;
+  long long sum = 0;
+  unsigned long i;
+
+  for (i = 0; i < n; i++)
+    {
+      ps.p      = g_document;
+      ps.values = 0;
+      ps.sum    = 0;
+
+      if (!wb_value(&ps))
+        {
+          printf("json: parse error at %d\n", (int)(ps.p - g_document));
+          return EXIT_FAILURE;
+        }
+
+      values += ps.values;
+      sum    += ps.sum;
+    }
+
+  printf("json: %lu documents, %lu values, sum %lld\n", n, values, sum);
+  return 0;
+}
@@ -0,0 +1,184 @@
+/****************************************************************************
+ * apps/benchmarks/wasmbench/workloads/wb_sha256.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define WB_BLOCKSIZE   1024
+
+#define ROR(x, n)      (((x) >> (n)) | ((x) << (32 - (n))))
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const uint32_t g_k[64] =
+{
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint8_t g_block[WB_BLOCKSIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wb_transform
+ ****************************************************************************/
+
+static void wb_transform(uint32_t state[8], const uint8_t *data)
+{
+  uint32_t w[64];
+  uint32_t a[8];
+  uint32_t t1;
+  uint32_t t2;
+  int i;
+
+  for (i = 0; i < 16; i++)
+    {
+      w[i] = (uint32_t)data[4 * i] << 24 | (uint32_t)data[4 * i + 1] << 16 |
+             (uint32_t)data[4 * i + 2] << 8 | data[4 * i + 3];
+    }
+
+  for (; i < 64; i++)
+    {
+      w[i] = w[i - 16] + w[i - 7] +
+             (ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3)) +
+             (ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+    }
+
+  memcpy(a, state, sizeof(a));
+
+  for (i = 0; i < 64; i++)
+    {
+      t1 = a[7] + (ROR(a[4], 6) ^ ROR(a[4], 11) ^ ROR(a[4], 25)) +
+           ((a[4] & a[5]) ^ (~a[4] & a[6])) + g_k[i] + w[i];
+      t2 = (ROR(a[0], 2) ^ ROR(a[0], 13) ^ ROR(a[0], 22)) +
+           ((a[0] & a[1]) ^ (a[0] & a[2]) ^ (a[1] & a[2]));
+
+      memmove(&a[1], &a[0], 7 * sizeof(uint32_t));
+      a[4] += t1;
+      a[0]  = t1 + t2;
+    }
+
+  for (i = 0; i < 8; i++)
+    {
+      state[i] += a[i];
+    }
+}
+
+/****************************************************************************
+ * Name: wb_sha256
+ ****************************************************************************/
+
+static void wb_sha256(const uint8_t *data, size_t len, uint8_t digest[32])
+{
+  uint32_t state[8] =
+  {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+  uint8_t last[128];
+  size_t rest;
+  size_t i;
+
+  for (i = 0; i + 64 <= len; i += 64)
+    {
+      wb_transform(state, data + i);
+    }
+
+  rest = len - i;
+  memset(last, 0, sizeof(last));
+  memcpy(last, data + i, rest);
+  last[rest] = 0x80;
+
+  rest = rest < 56 ? 64 : 128;
+  for (i = 0; i < 8; i++)
+    {
+      last[rest - 1 - i] = (uint8_t)((uint64_t)len * 8 >> (8 * i));
+    }
+
+  wb_transform(state, last);
+  if (rest == 128)
+    {
+      wb_transform(state, last + 64);
+    }
+
+  for (i = 0; i < 32; i++)
+    {
+      digest[i] = (uint8_t)(state[i / 4] >> (24 - 8 * (i % 4)));
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ *
+ * Description:
+ *   Hash a 1 KiB block n times, each digest is folded into the block.
+ *
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  unsigned long n = argc > 1 ? strtoul(argv[1], NULL, 0) : 1;
+  uint8_t digest[32];
+  unsigned long i;
+
+  for (i = 0; i < WB_BLOCKSIZE; i++)
+    {
+      g_block[i] = (uint8_t)(i * 131 + 7);
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      wb_sha256(g_block, WB_BLOCKSIZE, digest);
+      memcpy(&g_block[(i * 32) % WB_BLOCKSIZE], digest, 32);
+    }
+
+  printf("sha256: %lu blocks, %02x%02x%02x%02x\n",
+         n, digest[0], digest[1], digest[2], digest[3]);
+  return 0;
+}
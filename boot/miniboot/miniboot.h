@@ -0,0 +1,56 @@
+/****************************************************************************
+ * apps/boot/miniboot/miniboot.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_BOOT_MINIBOOT_MINIBOOT_H
+#define __APPS_BOOT_MINIBOOT_MINIBOOT_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef CONFIG_MINIBOOT_VERIFY
+
+/****************************************************************************
+ * Name: miniboot_verify
+ *
+ * Description:
+ *   Check the image in the slot against the SHA-256 digest of its trailer,
+ *   unless the cache says that this image was already verified.
+ *
+ * Input Parameters:
+ *   path - The path to the slot device
+ *
+ * Returned Value:
+ *   Zero (OK) if the image may be booted.  A negated errno value on
+ *   failure: -EBADMSG if the image does not match its digest.
+ *
+ ****************************************************************************/
+
+int miniboot_verify(FAR const char *path);
+
+#endif
+
+#endif /* __APPS_BOOT_MINIBOOT_MINIBOOT_H */
@@ -25,10 +25,13 @@
 #include <nuttx/config.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <syslog.h>
 
 #include <sys/boardctl.h>
 
+#include "miniboot.h"
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -44,6 +47,9 @@
 int main(int argc, FAR char *argv[])
 {
   struct boardioc_boot_info_s info;
+#ifdef CONFIG_MINIBOOT_VERIFY
+  int ret;
+#endif
 
   syslog(LOG_INFO, "*** miniboot ***\n");
 
@@ -57,6 +63,17 @@ int main(int argc, FAR char *argv[])
   boardctl(BOARDIOC_FINALINIT, 0);
 #endif
 
+#ifdef CONFIG_MINIBOOT_VERIFY
+  /* Do not boot an image that does not match its digest */
+
+  ret = miniboot_verify(CONFIG_MINIBOOT_SLOT_PATH);
+  if (ret < 0)
+    {
+      syslog(LOG_ERR, "Image verification failed: %d\n", ret);
+      return EXIT_FAILURE;
+    }
+#endif
+
   /* Call board specific image boot */
 
   info.path        = CONFIG_MINIBOOT_SLOT_PATH;
@@ -0,0 +1,436 @@
+/****************************************************************************
+ * apps/boot/miniboot/miniboot_verify.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nuttx/compiler.h>
+
+#include "netutils/sha256.h"
+
+#include "miniboot.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MINIBOOT_TRAILER_MAGIC 0x5254424d    /* "MBTR" */
+#define MINIBOOT_CACHE_MAGIC   0x4843424d    /* "MBCH" */
+
+/* Burst buffers are aligned on a cache line for the DMA of the driver */
+
+#define MINIBOOT_BURST_ALIGN   64
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The trailer at the end of the slot, and the cache record */
+
+begin_packed_struct struct miniboot_trailer_s
+{
+  uint32_t magic;
+  uint32_t size;                         /* Bytes hashed from offset 0 */
+  uint8_t  digest[SHA256_DIGEST_SIZE];
+} end_packed_struct;
+
+#ifdef CONFIG_MINIBOOT_VERIFY_PIPELINE
+/* Two bursts are in flight: one read by the reader thread, one hashed */
+
+struct miniboot_reader_s
+{
+  int fd;
+  size_t size;
+  FAR uint8_t *buf[2];
+  ssize_t len[2];
+  sem_t empty;
+  sem_t full;
+  volatile bool abort;
+};
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: miniboot_read
+ *
+ * Description:
+ *   Read exactly len bytes, a short read is an error.
+ *
+ ****************************************************************************/
+
+static ssize_t miniboot_read(int fd, FAR uint8_t *buf, size_t len)
+{
+  size_t ntotal = 0;
+  ssize_t nbytes;
+
+  while (ntotal < len)
+    {
+      nbytes = read(fd, buf + ntotal, len - ntotal);
+      if (nbytes < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+      else if (nbytes == 0)
+        {
+          return -EIO;
+        }
+
+      ntotal += nbytes;
+    }
+
+  return ntotal;
+}
+
+#ifndef CONFIG_MINIBOOT_VERIFY_XIP
+#ifdef CONFIG_MINIBOOT_VERIFY_PIPELINE
+/****************************************************************************
+ * Name: miniboot_reader
+ ****************************************************************************/
+
+static FAR void *miniboot_reader(FAR void *arg)
+{
+  FAR struct miniboot_reader_s *rd = arg;
+  size_t remaining = rd->size;
+  size_t n;
+  int i;
+
+  for (i = 0; remaining > 0; i ^= 1)
+    {
+      sem_wait(&rd->empty);
+      if (rd->abort)
+        {
+          break;
+        }
+
+      n = MIN(remaining, CONFIG_MINIBOOT_VERIFY_BURST);
+      rd->len[i] = miniboot_read(rd->fd, rd->buf[i], n);
+      sem_post(&rd->full);
+
+      if (rd->len[i] < 0)
+        {
+          break;
+        }
+
+      remaining -= n;
+    }
+
+  return NULL;
+}
+#endif
+
+/****************************************************************************
+ * Name: miniboot_hash
+ *
+ * Description:
+ *   Hash the first size bytes of the slot, in bursts.  With the pipeline,
+ *   the reader thread fills one buffer while the other one is hashed.
+ *
+ ****************************************************************************/
+
+static int miniboot_hash(int fd, size_t size,
+                         FAR struct sha256_context_s *ctx)
+{
+#ifdef CONFIG_MINIBOOT_VERIFY_PIPELINE
+  struct miniboot_reader_s rd;
+  pthread_t thread;
+  FAR uint8_t *buf;
+  size_t remaining = size;
+  int ret = OK;
+  int i;
+
+  buf = memalign(MINIBOOT_BURST_ALIGN, 2 * CONFIG_MINIBOOT_VERIFY_BURST);
+  if (buf == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  rd.fd     = fd;
+  rd.size   = size;
+  rd.buf[0] = buf;
+  rd.buf[1] = buf + CONFIG_MINIBOOT_VERIFY_BURST;
+  rd.abort  = false;
+  sem_init(&rd.empty, 0, 2);
+  sem_init(&rd.full, 0, 0);
+
+  ret = pthread_create(&thread, NULL, miniboot_reader, &rd);
+  if (ret != 0)
+    {
+      ret = -ret;
+      goto out;
+    }
+
+  for (i = 0; remaining > 0; i ^= 1)
+    {
+      sem_wait(&rd.full);
+      if (rd.len[i] < 0)
+        {
+          ret = rd.len[i];
+          break;
+        }
+
+      sha256_update(ctx, rd.buf[i], rd.len[i]);
+      remaining -= rd.len[i];
+      sem_post(&rd.empty);
+    }
+
+  /* Release the reader if it is waiting for a buffer */
+
+  rd.abort = true;
+  sem_post(&rd.empty);
+  pthread_join(thread, NULL);
+
+out:
+  sem_destroy(&rd.empty);
+  sem_destroy(&rd.full);
+  free(buf);
+  return ret;
+#else
+  FAR uint8_t *buf;
+  ssize_t nbytes;
+  int ret = OK;
+
+  buf = memalign(MINIBOOT_BURST_ALIGN, CONFIG_MINIBOOT_VERIFY_BURST);
+  if (buf == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  while (size > 0)
+    {
+      nbytes = miniboot_read(fd, buf,
+                             MIN(size, CONFIG_MINIBOOT_VERIFY_BURST));
+      if (nbytes < 0)
+        {
+          ret = nbytes;
+          break;
+        }
+
+      sha256_update(ctx, buf, nbytes);
+      size -= nbytes;
+    }
+
+  free(buf);
+  return ret;
+#endif
+}
+#endif /* !CONFIG_MINIBOOT_VERIFY_XIP */
+
+#ifdef CONFIG_MINIBOOT_VERIFY_CACHE
+/****************************************************************************
+ * Name: miniboot_cache_check
+ *
+ * Description:
+ *   Return true if the image of this trailer was already verified.
+ *
+ ****************************************************************************/
+
+static bool miniboot_cache_check(FAR const struct miniboot_trailer_s *tr)
+{
+  struct miniboot_trailer_s rec;
+  ssize_t nbytes;
+  int fd;
+
+  fd = open(CONFIG_MINIBOOT_VERIFY_CACHE_PATH, O_RDONLY);
+  if (fd < 0)
+    {
+      return false;
+    }
+
+  nbytes = miniboot_read(fd, (FAR uint8_t *)&rec, sizeof(rec));
+  close(fd);
+
+  return nbytes == sizeof(rec) && rec.magic == MINIBOOT_CACHE_MAGIC &&
+         rec.size == tr->size &&
+         memcmp(rec.digest, tr->digest, sizeof(rec.digest)) == 0;
+}
+
+/****************************************************************************
+ * Name: miniboot_cache_update
+ *
+ * Description:
+ *   Record the trailer of a verified image, or clear the record.
+ *
+ ****************************************************************************/
+
+static void miniboot_cache_update(FAR const struct miniboot_trailer_s *tr)
+{
+  struct miniboot_trailer_s rec;
+  int fd;
+
+  memset(&rec, 0, sizeof(rec));
+  if (tr != NULL)
+    {
+      rec        = *tr;
+      rec.magic  = MINIBOOT_CACHE_MAGIC;
+    }
+
+  fd = open(CONFIG_MINIBOOT_VERIFY_CACHE_PATH, O_WRONLY);
+  if (fd < 0)
+    {
+      syslog(LOG_WARNING, "Cannot open %s: %d\n",
+             CONFIG_MINIBOOT_VERIFY_CACHE_PATH, errno);
+      return;
+    }
+
+  if (write(fd, &rec, sizeof(rec)) != sizeof(rec))
+    {
+      syslog(LOG_WARNING, "Cannot write %s: %d\n",
+             CONFIG_MINIBOOT_VERIFY_CACHE_PATH, errno);
+    }
+
+  close(fd);
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: miniboot_verify
+ ****************************************************************************/
+
+int miniboot_verify(FAR const char *path)
+{
+  struct sha256_context_s ctx;
+  struct miniboot_trailer_s tr;
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  struct timespec start;
+  struct timespec end;
+  off_t slotsize;
+  ssize_t nbytes;
+  int ret;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  /* The trailer occupies the end of the slot */
+
+  slotsize = lseek(fd, -(off_t)sizeof(tr), SEEK_END);
+  if (slotsize < 0)
+    {
+      ret = -errno;
+      goto out;
+    }
+
+  nbytes = miniboot_read(fd, (FAR uint8_t *)&tr, sizeof(tr));
+  if (nbytes < 0)
+    {
+      ret = nbytes;
+      goto out;
+    }
+
+  if (tr.magic != MINIBOOT_TRAILER_MAGIC || tr.size == 0 ||
+      tr.size > slotsize)
+    {
+      syslog(LOG_ERR, "No valid image trailer in %s\n", path);
+      ret = -ENOENT;
+      goto out;
+    }
+
+#ifdef CONFIG_MINIBOOT_VERIFY_CACHE
+  if (miniboot_cache_check(&tr))
+    {
+      syslog(LOG_INFO, "Image already verified\n");
+      ret = OK;
+      goto out;
+    }
+#endif
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  sha256_init(&ctx);
+
+#ifdef CONFIG_MINIBOOT_VERIFY_XIP
+  sha256_update(&ctx, (FAR const void *)CONFIG_MINIBOOT_VERIFY_XIP_BASE,
+                tr.size);
+  ret = OK;
+#else
+  if (lseek(fd, 0, SEEK_SET) < 0)
+    {
+      ret = -errno;
+    }
+  else
+    {
+      ret = miniboot_hash(fd, tr.size, &ctx);
+    }
+#endif
+
+  /* Always finish the hash, to release a /dev/crypto session */
+
+  sha256_final(digest, &ctx);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  if (memcmp(digest, tr.digest, sizeof(digest)) != 0)
+    {
+      syslog(LOG_ERR, "Image digest mismatch\n");
+#ifdef CONFIG_MINIBOOT_VERIFY_CACHE
+      miniboot_cache_update(NULL);
+#endif
+      ret = -EBADMSG;
+      goto out;
+    }
+
+  syslog(LOG_INFO, "Image of %" PRIu32 " bytes verified in %ld ms\n",
+         tr.size, (long)((end.tv_sec - start.tv_sec) * 1000 +
+                         (end.tv_nsec - start.tv_nsec) / 1000000));
+
+#ifdef CONFIG_MINIBOOT_VERIFY_CACHE
+  miniboot_cache_update(&tr);
+#endif
+
+out:
+  close(fd);
+  return ret;
+}
@@ -28,9 +28,58 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <debug.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <nuttx/lib/builtin.h>
 
 #include "builtin/builtin.h"
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef BUILTIN_LIST_SORTED
+/****************************************************************************
+ * Name: builtin_compare
+ ****************************************************************************/
+
+static int builtin_compare(FAR const void *name, FAR const void *member)
+{
+  FAR const struct builtin_s *builtin = member;
+
+  return strcmp(name, builtin->name);
+}
+
+/****************************************************************************
+ * Name: builtin_lookup
+ *
+ * Description:
+ *   Find an application in g_builtins[], which the build sorts by name.
+ *   Returns the index of the application or a negated errno value.
+ *
+ ****************************************************************************/
+
+static int builtin_lookup(FAR const char *appname)
+{
+  FAR const struct builtin_s *builtin;
+  int count = g_builtin_count;
+
+  /* Leave out the NULL terminator */
+
+  if (count > 0 && g_builtins[count - 1].name == NULL)
+    {
+      count--;
+    }
+
+  builtin = bsearch(appname, g_builtins, count, sizeof(struct builtin_s),
+                    builtin_compare);
+  return builtin != NULL ? builtin - g_builtins : -ENOENT;
+}
+#else
+#  define builtin_lookup(appname) builtin_isavail(appname)
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -71,7 +120,7 @@ int exec_builtin(FAR const char *appname, FAR char * const *argv,
 
   /* Verify that an application with this name exists */
 
-  index = builtin_isavail(appname);
+  index = builtin_lookup(appname);
   if (index < 0)
     {
       ret = ENOENT;
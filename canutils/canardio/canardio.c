@@ -0,0 +1,788 @@
+/****************************************************************************
+ * apps/canutils/canardio/canardio.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+
+#ifdef CONFIG_NET_CAN
+#  include <net/if.h>
+#  include <netpacket/can.h>
+#endif
+
+#ifdef CONFIG_CAN
+#  include <nuttx/can/can.h>
+#endif
+
+#include "canutils/canardio.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Cyphal/CAN identifier fields */
+
+#define CYPHAL_SERVICE       (1u << 25)
+#define CYPHAL_RESERVED23    (1u << 23)
+#define CYPHAL_RESERVED07    (1u << 7)
+#define CYPHAL_SUBJECT_SHIFT 8
+#define CYPHAL_SUBJECT_MASK  0x1fffu
+#define CYPHAL_DEST_SHIFT    7
+
+/* DroneCAN identifier fields */
+
+#define DRONECAN_SERVICE     (1u << 7)
+#define DRONECAN_TYPE_SHIFT  8
+#define DRONECAN_TYPE_MASK   0xffffu
+#define DRONECAN_DEST_SHIFT  8
+
+#define CANARDIO_NODE_MASK   0x7fu
+
+#ifdef CONFIG_NET_CAN_RAW_FILTER_MAX
+#  define CANARDIO_SOCKFILTERS CONFIG_NET_CAN_RAW_FILTER_MAX
+#else
+#  define CANARDIO_SOCKFILTERS 16
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint64_t canardio_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int canardio_popcount(uint32_t x)
+{
+  int n = 0;
+
+  for (; x != 0; x &= x - 1)
+    {
+      n++;
+    }
+
+  return n;
+}
+
+/****************************************************************************
+ * Name: canardio_read
+ *
+ * Description:
+ *   Read one frame into frame.  Returns 1 for an extended data frame, 0 for
+ *   a frame to skip and a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static int canardio_read(FAR struct canardio_s *io,
+                         FAR struct canardio_frame_s *frame)
+{
+  ssize_t nbytes;
+
+#ifdef CONFIG_NET_CAN
+  if (io->sock)
+    {
+      struct canfd_frame cf;
+
+      nbytes = read(io->fd, &cf, sizeof(cf));
+      if (nbytes < 0)
+        {
+          return -errno;
+        }
+
+      if ((nbytes != CAN_MTU && nbytes != CANFD_MTU) ||
+          (cf.can_id & CAN_EFF_FLAG) == 0 ||
+          (cf.can_id & (CAN_RTR_FLAG | CAN_ERR_FLAG)) != 0 ||
+          cf.len > CANARDIO_MAXDATA)
+        {
+          return 0;
+        }
+
+      frame->id  = cf.can_id & CAN_EFF_MASK;
+      frame->len = cf.len;
+      memcpy(frame->data, cf.data, cf.len);
+    }
+#endif
+
+#if defined(CONFIG_CAN) && defined(CONFIG_CAN_EXTID)
+  if (!io->sock)
+    {
+      struct can_msg_s msg;
+      size_t len;
+
+      nbytes = read(io->fd, &msg, sizeof(msg));
+      if (nbytes < 0)
+        {
+          return -errno;
+        }
+
+      if (nbytes < CAN_MSGLEN(0) || !msg.cm_hdr.ch_extid ||
+#ifdef CONFIG_CAN_ERRORS
+          msg.cm_hdr.ch_error ||
+#endif
+          msg.cm_hdr.ch_rtr)
+        {
+          return 0;
+        }
+
+#ifdef CONFIG_CAN_FD
+      len = can_dlc2bytes(msg.cm_hdr.ch_dlc);
+#else
+      len = msg.cm_hdr.ch_dlc;
+#endif
+      if (len > CANARDIO_MAXDATA || nbytes < CAN_MSGLEN(len))
+        {
+          return 0;
+        }
+
+      frame->id  = msg.cm_hdr.ch_id;
+      frame->len = len;
+      memcpy(frame->data, msg.cm_data, len);
+    }
+#endif
+
+  frame->timestamp = canardio_now();
+  return 1;
+}
+
+/****************************************************************************
+ * Name: canardio_reader
+ *
+ * Description:
+ *   Read the frames straight into the free slot at the head of the ring.
+ *   The consumer is only woken up when it waits for a frame.
+ *
+ ****************************************************************************/
+
+static FAR void *canardio_reader(FAR void *arg)
+{
+  FAR struct canardio_s *io = arg;
+  struct canardio_frame_s scratch;
+  FAR struct canardio_frame_s *frame;
+  unsigned int head;
+  bool full;
+  int ret;
+
+  for (; ; )
+    {
+      head  = atomic_load_explicit(&io->head, memory_order_relaxed);
+      full  = head - atomic_load_explicit(&io->tail, memory_order_acquire) >=
+              io->depth;
+      frame = full ? &scratch : &io->ring[head & (io->depth - 1)];
+
+      ret = canardio_read(io, frame);
+      if (ret < 0)
+        {
+          if (ret == -EINTR || ret == -EAGAIN)
+            {
+              continue;
+            }
+
+          break;
+        }
+
+      if (ret == 0)
+        {
+          continue;
+        }
+
+      if (full)
+        {
+          atomic_fetch_add_explicit(&io->dropped, 1, memory_order_relaxed);
+          continue;
+        }
+
+      /* Sequentially consistent, against the flag stored by the waiting
+       * consumer before it checks the head again.
+       */
+
+      atomic_store(&io->head, head + 1);
+      if (atomic_exchange(&io->waiting, false))
+        {
+          sem_post(&io->sem);
+        }
+    }
+
+  return NULL;
+}
+
+#if defined(CONFIG_CAN) && defined(CONFIG_CAN_EXTID)
+static void canardio_delhwfilters(FAR struct canardio_s *io)
+{
+  while (io->nhwfilters > 0)
+    {
+      ioctl(io->fd, CANIOC_DEL_EXTFILTER,
+            (unsigned long)io->hwfilters[--io->nhwfilters]);
+    }
+}
+
+static int canardio_sethwfilters(FAR struct canardio_s *io,
+                                 FAR const struct canardio_filter_s *filters,
+                                 int nfilters)
+{
+  FAR struct canardio_filter_s *tmp;
+  struct canioc_extfilter_s xf;
+  int ret = 0;
+  int i;
+
+  canardio_delhwfilters(io);
+  if (nfilters == 0)
+    {
+      return 0;
+    }
+
+  /* Consolidate a copy, the caller keeps its exact filters */
+
+  tmp = malloc(nfilters * sizeof(*tmp));
+  if (tmp == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  memcpy(tmp, filters, nfilters * sizeof(*tmp));
+  nfilters = canardio_consolidate(tmp, nfilters,
+                                  CONFIG_CANUTILS_CANARDIO_HWFILTERS);
+
+  for (i = 0; i < nfilters; i++)
+    {
+      xf.xf_id1  = tmp[i].id;
+      xf.xf_id2  = tmp[i].mask;
+      xf.xf_type = CAN_FILTER_MASK;
+      xf.xf_prio = CAN_MSGPRIO_HIGH;
+
+      ret = ioctl(io->fd, CANIOC_ADD_EXTFILTER, (unsigned long)&xf);
+      if (ret < 0)
+        {
+          ret = -errno;
+          canardio_delhwfilters(io);
+          break;
+        }
+
+      io->hwfilters[io->nhwfilters++] = ret;
+      ret = 0;
+    }
+
+  free(tmp);
+  return ret;
+}
+#endif
+
+#ifdef CONFIG_NET_CAN
+static int
+canardio_setsockfilters(FAR struct canardio_s *io,
+                        FAR const struct canardio_filter_s *filters,
+                        int nfilters)
+{
+  FAR struct canardio_filter_s *tmp;
+  FAR struct can_filter *rf;
+  int ret = 0;
+  int i;
+
+  /* No filter accepts every frame, as after socket() */
+
+  if (nfilters == 0)
+    {
+      struct can_filter all =
+        {
+          0, 0
+        };
+
+      if (setsockopt(io->fd, SOL_CAN_RAW, CAN_RAW_FILTER,
+                     &all, sizeof(all)) < 0)
+        {
+          return -errno;
+        }
+
+      return 0;
+    }
+
+  tmp = malloc(nfilters * (sizeof(*tmp) + sizeof(*rf)));
+  if (tmp == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  memcpy(tmp, filters, nfilters * sizeof(*tmp));
+  nfilters = canardio_consolidate(tmp, nfilters, CANARDIO_SOCKFILTERS);
+  rf = (FAR struct can_filter *)(tmp + nfilters);
+
+  for (i = 0; i < nfilters; i++)
+    {
+      rf[i].can_id   = tmp[i].id | CAN_EFF_FLAG;
+      rf[i].can_mask = tmp[i].mask | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    }
+
+  if (setsockopt(io->fd, SOL_CAN_RAW, CAN_RAW_FILTER, rf,
+                 nfilters * sizeof(*rf)) < 0)
+    {
+      ret = -errno;
+    }
+
+  free(tmp);
+  return ret;
+}
+
+static int canardio_opensock(FAR struct canardio_s *io,
+                             FAR const char *dev)
+{
+  struct sockaddr_can addr;
+#ifdef CONFIG_NET_CAN_CANFD
+  const int on = 1;
+#endif
+
+  io->fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (io->fd < 0)
+    {
+      return -errno;
+    }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family  = AF_CAN;
+  addr.can_ifindex = if_nametoindex(dev);
+  if (addr.can_ifindex == 0)
+    {
+      return -ENODEV;
+    }
+
+#ifdef CONFIG_NET_CAN_CANFD
+  if (setsockopt(io->fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES,
+                 &on, sizeof(on)) < 0)
+    {
+      return -errno;
+    }
+#endif
+
+  if (bind(io->fd, (FAR struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+      return -errno;
+    }
+
+  io->sock = true;
+  return 0;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: canardio_cyphal_subject
+ ****************************************************************************/
+
+struct canardio_filter_s canardio_cyphal_subject(uint16_t subject)
+{
+  struct canardio_filter_s filter;
+
+  filter.id   = (uint32_t)(subject & CYPHAL_SUBJECT_MASK) <<
+                CYPHAL_SUBJECT_SHIFT;
+  filter.mask = CYPHAL_SERVICE | CYPHAL_RESERVED07 |
+                CYPHAL_SUBJECT_MASK << CYPHAL_SUBJECT_SHIFT;
+  return filter;
+}
+
+/****************************************************************************
+ * Name: canardio_cyphal_services
+ ****************************************************************************/
+
+struct canardio_filter_s canardio_cyphal_services(uint8_t node)
+{
+  struct canardio_filter_s filter;
+
+  filter.id   = CYPHAL_SERVICE |
+                (uint32_t)(node & CANARDIO_NODE_MASK) << CYPHAL_DEST_SHIFT;
+  filter.mask = CYPHAL_SERVICE | CYPHAL_RESERVED23 |
+                CANARDIO_NODE_MASK << CYPHAL_DEST_SHIFT;
+  return filter;
+}
+
+/****************************************************************************
+ * Name: canardio_dronecan_message
+ ****************************************************************************/
+
+struct canardio_filter_s canardio_dronecan_message(uint16_t dtid)
+{
+  struct canardio_filter_s filter;
+
+  filter.id   = (uint32_t)dtid << DRONECAN_TYPE_SHIFT;
+  filter.mask = DRONECAN_SERVICE |
+                DRONECAN_TYPE_MASK << DRONECAN_TYPE_SHIFT;
+  return filter;
+}
+
+/****************************************************************************
+ * Name: canardio_dronecan_services
+ ****************************************************************************/
+
+struct canardio_filter_s canardio_dronecan_services(uint8_t node)
+{
+  struct canardio_filter_s filter;
+
+  filter.id   = DRONECAN_SERVICE |
+                (uint32_t)(node & CANARDIO_NODE_MASK) << DRONECAN_DEST_SHIFT;
+  filter.mask = DRONECAN_SERVICE |
+                CANARDIO_NODE_MASK << DRONECAN_DEST_SHIFT;
+  return filter;
+}
+
+/****************************************************************************
+ * Name: canardio_consolidate
+ ****************************************************************************/
+
+int canardio_consolidate(FAR struct canardio_filter_s *filters,
+                         int nfilters, int max)
+{
+  uint32_t mask;
+  int bestbits;
+  int besti;
+  int bestj;
+  int bits;
+  int i;
+  int j;
+
+  if (max < 1)
+    {
+      max = 1;
+    }
+
+  /* Merge the pair that keeps the most mask bits, that is the pair whose
+   * merge lets the fewest unwanted identifiers through.
+   */
+
+  while (nfilters > max)
+    {
+      bestbits = -1;
+      besti    = 0;
+      bestj    = 1;
+
+      for (i = 0; i < nfilters - 1; i++)
+        {
+          for (j = i + 1; j < nfilters; j++)
+            {
+              mask = filters[i].mask & filters[j].mask &
+                     ~(filters[i].id ^ filters[j].id);
+              bits = canardio_popcount(mask);
+              if (bits > bestbits)
+                {
+                  bestbits = bits;
+                  besti    = i;
+                  bestj    = j;
+                }
+            }
+        }
+
+      mask = filters[besti].mask & filters[bestj].mask &
+             ~(filters[besti].id ^ filters[bestj].id);
+      filters[besti].mask = mask;
+      filters[besti].id  &= mask;
+      filters[bestj] = filters[--nfilters];
+    }
+
+  return nfilters;
+}
+
+/****************************************************************************
+ * Name: canardio_match
+ ****************************************************************************/
+
+bool canardio_match(FAR const struct canardio_filter_s *filters,
+                    int nfilters, uint32_t id)
+{
+  int i;
+
+  for (i = 0; i < nfilters; i++)
+    {
+      if ((id & filters[i].mask) == filters[i].id)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: canardio_open
+ ****************************************************************************/
+
+int canardio_open(FAR struct canardio_s *io, FAR const char *dev,
+                  unsigned int depth)
+{
+  struct sched_param param;
+  pthread_attr_t attr;
+  int ret;
+
+  memset(io, 0, sizeof(*io));
+  io->fd = -1;
+
+  if (depth == 0)
+    {
+      depth = CONFIG_CANUTILS_CANARDIO_RXDEPTH;
+    }
+
+  io->depth = 1;
+  while (io->depth < depth)
+    {
+      io->depth <<= 1;
+    }
+
+  io->ring = malloc(io->depth * sizeof(*io->ring));
+  if (io->ring == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  if (dev[0] == '/')
+    {
+#if defined(CONFIG_CAN) && defined(CONFIG_CAN_EXTID)
+      io->fd = open(dev, O_RDWR | O_CLOEXEC);
+      ret = io->fd < 0 ? -errno : 0;
+#else
+      ret = -ENOSYS;
+#endif
+    }
+  else
+    {
+#ifdef CONFIG_NET_CAN
+      ret = canardio_opensock(io, dev);
+#else
+      ret = -ENOSYS;
+#endif
+    }
+
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  sem_init(&io->sem, 0, 0);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_CANUTILS_CANARDIO_STACKSIZE);
+  param.sched_priority = CONFIG_CANUTILS_CANARDIO_PRIORITY;
+  pthread_attr_setschedparam(&attr, &param);
+
+  ret = -pthread_create(&io->reader, &attr, canardio_reader, io);
+  pthread_attr_destroy(&attr);
+  if (ret < 0)
+    {
+      sem_destroy(&io->sem);
+      goto errout;
+    }
+
+  pthread_setname_np(io->reader, "canardio");
+  return 0;
+
+errout:
+  if (io->fd >= 0)
+    {
+      close(io->fd);
+    }
+
+  free(io->ring);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: canardio_setfilters
+ ****************************************************************************/
+
+int canardio_setfilters(FAR struct canardio_s *io,
+                        FAR const struct canardio_filter_s *filters,
+                        int nfilters)
+{
+#ifdef CONFIG_NET_CAN
+  if (io->sock)
+    {
+      return canardio_setsockfilters(io, filters, nfilters);
+    }
+#endif
+
+#if defined(CONFIG_CAN) && defined(CONFIG_CAN_EXTID)
+  return canardio_sethwfilters(io, filters, nfilters);
+#else
+  return -ENOSYS;
+#endif
+}
+
+/****************************************************************************
+ * Name: canardio_receive
+ ****************************************************************************/
+
+int canardio_receive(FAR struct canardio_s *io,
+                     FAR struct canardio_frame_s *frame, int timeout)
+{
+  struct timespec abstime;
+  unsigned int tail;
+  int ret;
+
+  if (timeout > 0)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &abstime);
+      abstime.tv_sec  += timeout / 1000;
+      abstime.tv_nsec += (timeout % 1000) * 1000000;
+      if (abstime.tv_nsec >= 1000000000)
+        {
+          abstime.tv_sec++;
+          abstime.tv_nsec -= 1000000000;
+        }
+    }
+
+  tail = atomic_load_explicit(&io->tail, memory_order_relaxed);
+
+  for (; ; )
+    {
+      if (atomic_load_explicit(&io->head, memory_order_acquire) != tail)
+        {
+          *frame = io->ring[tail & (io->depth - 1)];
+          atomic_store_explicit(&io->tail, tail + 1, memory_order_release);
+          return 0;
+        }
+
+      if (timeout == 0)
+        {
+          return -ETIMEDOUT;
+        }
+
+      /* Check the ring again once the reader can see the flag, so that a
+       * frame queued in between is not slept over.  A post that comes
+       * after the frame was taken only makes the next wait return early.
+       */
+
+      atomic_store(&io->waiting, true);
+      if (atomic_load(&io->head) != tail)
+        {
+          atomic_store(&io->waiting, false);
+          continue;
+        }
+
+      if (timeout < 0)
+        {
+          ret = sem_wait(&io->sem);
+        }
+      else
+        {
+          ret = sem_clockwait(&io->sem, CLOCK_MONOTONIC, &abstime);
+        }
+
+      if (ret < 0 && errno == ETIMEDOUT)
+        {
+          atomic_store(&io->waiting, false);
+          timeout = 0;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: canardio_send
+ ****************************************************************************/
+
+int canardio_send(FAR struct canardio_s *io, uint32_t id,
+                  FAR const void *data, size_t len)
+{
+  ssize_t nbytes = -1;
+
+  if (len > CANARDIO_MAXDATA)
+    {
+      return -EINVAL;
+    }
+
+#ifdef CONFIG_NET_CAN
+  if (io->sock)
+    {
+      struct canfd_frame cf;
+
+      memset(&cf, 0, sizeof(cf));
+      cf.can_id = (id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+      cf.len    = len;
+      memcpy(cf.data, data, len);
+
+      nbytes = write(io->fd, &cf, len > CAN_MAX_DLEN ? CANFD_MTU : CAN_MTU);
+    }
+#endif
+
+#if defined(CONFIG_CAN) && defined(CONFIG_CAN_EXTID)
+  if (!io->sock)
+    {
+      struct can_msg_s msg;
+
+      memset(&msg, 0, sizeof(msg));
+      msg.cm_hdr.ch_id    = id;
+      msg.cm_hdr.ch_extid = 1;
+#ifdef CONFIG_CAN_FD
+      msg.cm_hdr.ch_dlc   = can_bytes2dlc(len);
+      msg.cm_hdr.ch_edl   = len > 8;
+      memcpy(msg.cm_data, data, len);
+      len = can_dlc2bytes(msg.cm_hdr.ch_dlc);
+#else
+      msg.cm_hdr.ch_dlc   = len;
+      memcpy(msg.cm_data, data, len);
+#endif
+
+      nbytes = write(io->fd, &msg, CAN_MSGLEN(len));
+    }
+#endif
+
+  return nbytes < 0 ? -errno : 0;
+}
+
+/****************************************************************************
+ * Name: canardio_dropped
+ ****************************************************************************/
+
+unsigned int canardio_dropped(FAR struct canardio_s *io)
+{
+  return atomic_load_explicit(&io->dropped, memory_order_relaxed);
+}
+
+/****************************************************************************
+ * Name: canardio_close
+ ****************************************************************************/
+
+void canardio_close(FAR struct canardio_s *io)
+{
+  pthread_cancel(io->reader);
+  pthread_join(io->reader, NULL);
+
+#if defined(CONFIG_CAN) && defined(CONFIG_CAN_EXTID)
+  if (!io->sock)
+    {
+      canardio_delhwfilters(io);
+    }
+#endif
+
+  close(io->fd);
+  sem_destroy(&io->sem);
+  free(io->ring);
+}
@@ -0,0 +1,207 @@
+/****************************************************************************
+ * apps/canutils/canardio/canardio_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include "canutils/canardio.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_MAXFILTERS 32
+
+#ifdef CONFIG_NET_CAN
+#  define BENCH_DEFDEV   "can0"
+#else
+#  define BENCH_DEFDEV   "/dev/can0"
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint64_t bench_now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Take the frames arriving for secs seconds and reject the unwanted ones
+ * in software, as libcanard does on reception.
+ */
+
+static void bench_run(FAR struct canardio_s *io, FAR const char *name,
+                      FAR const struct canardio_filter_s *filters,
+                      int nfilters, int secs)
+{
+  struct canardio_frame_s frame;
+  unsigned long wanted = 0;
+  unsigned long total = 0;
+  unsigned int dropped;
+  uint64_t start;
+  uint64_t end;
+  uint64_t us;
+
+  dropped = canardio_dropped(io);
+  start   = bench_now_us();
+  end     = start + (uint64_t)secs * 1000000;
+
+  while (bench_now_us() < end)
+    {
+      if (canardio_receive(io, &frame, 100) < 0)
+        {
+          continue;
+        }
+
+      total++;
+      if (canardio_match(filters, nfilters, frame.id))
+        {
+          wanted++;
+        }
+    }
+
+  us = bench_now_us() - start;
+  printf("%-10s %8lu frames %8lu/s, %8lu wanted %8lu/s, "
+         "%lu rejected, %u dropped\n",
+         name, total, (unsigned long)(total * 1000000 / us),
+         wanted, (unsigned long)(wanted * 1000000 / us),
+         total - wanted, canardio_dropped(io) - dropped);
+}
+
+static void bench_usage(FAR const char *progname)
+{
+  fprintf(stderr, "Usage: %s [-d dev] [-t secs] [-q depth] "
+          "[-S subject]... [-D dtid]... [-c node] [-n node]\n"
+          "  -S: Cyphal/CAN subject, -c: Cyphal/CAN services of node\n"
+          "  -D: DroneCAN data type, -n: DroneCAN services of node\n",
+          progname);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: canardio_bench_main
+ *
+ * Description:
+ *   Measure the frames a subscriber processes on a busy bus, first with
+ *   every frame accepted and rejected in software, then with the
+ *   subscriptions programmed as acceptance filters.
+ *
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct canardio_filter_s filters[BENCH_MAXFILTERS];
+  FAR const char *dev = BENCH_DEFDEV;
+  struct canardio_s io;
+  unsigned int depth = 0;
+  int nfilters = 0;
+  int secs = 5;
+  int ret;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:t:q:S:D:c:n:h")) != -1)
+    {
+      if (nfilters >= BENCH_MAXFILTERS && strchr("SDcn", opt) != NULL)
+        {
+          fprintf(stderr, "Too many filters\n");
+          return EXIT_FAILURE;
+        }
+
+      switch (opt)
+        {
+          case 'd':
+            dev = optarg;
+            break;
+
+          case 't':
+            secs = atoi(optarg);
+            break;
+
+          case 'q':
+            depth = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'S':
+            filters[nfilters++] = canardio_cyphal_subject(atoi(optarg));
+            break;
+
+          case 'c':
+            filters[nfilters++] = canardio_cyphal_services(atoi(optarg));
+            break;
+
+          case 'D':
+            filters[nfilters++] = canardio_dronecan_message(atoi(optarg));
+            break;
+
+          case 'n':
+            filters[nfilters++] = canardio_dronecan_services(atoi(optarg));
+            break;
+
+          default:
+            bench_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (nfilters == 0 || secs < 1)
+    {
+      bench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  ret = canardio_open(&io, dev, depth);
+  if (ret < 0)
+    {
+      fprintf(stderr, "canardio_open %s failed: %d\n", dev, ret);
+      return EXIT_FAILURE;
+    }
+
+  bench_run(&io, "software", filters, nfilters, secs);
+
+  ret = canardio_setfilters(&io, filters, nfilters);
+  if (ret < 0)
+    {
+      fprintf(stderr, "canardio_setfilters failed: %d\n", ret);
+    }
+  else
+    {
+      bench_run(&io, "filtered", filters, nfilters, secs);
+    }
+
+  canardio_close(&io);
+  return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
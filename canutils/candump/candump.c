@@ -60,6 +60,7 @@
 #include <sys/ioctl.h>
 #include <sys/uio.h>
 #include <net/if.h>
+#include <poll.h>
 
 #include <nuttx/can.h>
 #include <netpacket/can.h>
@@ -67,6 +68,10 @@
 #include "terminal.h"
 #include "lib.h"
 
+#ifdef CONFIG_CANUTILS_CANDUMP_FASTCAPTURE
+#include "candump_blog.h"
+#endif
+
 /* for hardware timestamps - since Linux 2.6.30 */
 #ifndef SO_TIMESTAMPING
 #define SO_TIMESTAMPING 37
@@ -82,6 +87,7 @@
 #define MAXCOL 6      /* number of different colors for colorized output */
 #define ANYDEV "any"  /* name of interface to receive from any CAN interface */
 #define ANL "\r\n"    /* newline in ASC mode */
+#define CTRLMSGSZ CMSG_SPACE(sizeof(struct timeval) + 3*sizeof(struct timespec) + sizeof(__u32))
 
 #define SILENT_INI 42 /* detect user setting on commandline */
 #define SILENT_OFF 0  /* no silent mode */
@@ -128,6 +134,9 @@ static void print_usage(char *prg)
 	fprintf(stderr, "         -s <level>  (silent mode - %d: off (default) %d: animation %d: silent)\n", SILENT_OFF, SILENT_ANI, SILENT_ON);
 	fprintf(stderr, "         -l          (log CAN-frames into file. Sets '-s %d' by default)\n", SILENT_ON);
 	fprintf(stderr, "         -L          (use log file format on stdout)\n");
+#ifdef CONFIG_CANUTILS_CANDUMP_FASTCAPTURE
+	fprintf(stderr, "         -b          (fast capture of CAN-frames into a binary file, see canlog2asc)\n");
+#endif
 	fprintf(stderr, "         -n <count>  (terminate after reception of <count> CAN frames)\n");
 	fprintf(stderr, "         -r <size>   (set socket receive buffer to <size>)\n");
 	fprintf(stderr, "         -D          (Don't exit if a \"detected\" can device goes down.\n");
@@ -212,6 +221,152 @@ int idx2dindex(int ifidx, int socket) {
 	return i;
 }
 
+/* get the receive timestamp and the drop counter of a received frame */
+static void get_rxinfo(struct msghdr *msg, struct timeval *tv, __u32 *drops)
+{
+	struct cmsghdr *cmsg;
+
+	for (cmsg = CMSG_FIRSTHDR(msg);
+	     cmsg && (cmsg->cmsg_level == SOL_SOCKET);
+	     cmsg = CMSG_NXTHDR(msg,cmsg)) {
+		if (cmsg->cmsg_type == SO_TIMESTAMP) {
+			memcpy(tv, CMSG_DATA(cmsg), sizeof(*tv));
+		} else if (cmsg->cmsg_type == SO_TIMESTAMPING) {
+
+			struct timespec *stamp = (struct timespec *)CMSG_DATA(cmsg);
+
+			/*
+			 * stamp[0] is the software timestamp
+			 * stamp[1] is deprecated
+			 * stamp[2] is the raw hardware timestamp
+			 * See chapter 2.1.2 Receive timestamps in
+			 * linux/Documentation/networking/timestamping.txt
+			 */
+			tv->tv_sec = stamp[2].tv_sec;
+			tv->tv_usec = stamp[2].tv_nsec/1000;
+		} else if (cmsg->cmsg_type == SO_RXQ_OVFL)
+			memcpy(drops, CMSG_DATA(cmsg), sizeof(__u32));
+	}
+}
+
+#ifdef CONFIG_CANUTILS_CANDUMP_FASTCAPTURE
+
+#define BATCH CONFIG_CANUTILS_CANDUMP_BATCH
+
+static struct canfd_frame bframe[BATCH];
+static struct sockaddr_can baddr[BATCH];
+static char bctrlmsg[BATCH][CTRLMSGSZ];
+static struct iovec biov[BATCH];
+static struct mmsghdr bmsg[BATCH];
+
+/*
+ * Fast capture: up to BATCH frames are received per syscall and stored
+ * as binary records, formatting is left to canlog2asc.
+ */
+static int fast_capture(int *s, int currmax, int count, int down_causes_exit,
+			int timeout_ms, struct candump_blog_s *blog)
+{
+	struct pollfd pfd[MAXSOCK];
+	struct timeval tv = { 0, 0 };
+	int logged[MAXIFNAMES];
+	int i, j, n, idx;
+
+	memset(logged, 0, sizeof(logged));
+
+	for (i=0; i<currmax; i++) {
+		pfd[i].fd = s[i];
+		pfd[i].events = POLLIN;
+	}
+
+	/* these settings are static and can be held out of the hot path */
+	for (j=0; j<BATCH; j++) {
+		biov[j].iov_base = &bframe[j];
+		bmsg[j].msg_hdr.msg_name = &baddr[j];
+		bmsg[j].msg_hdr.msg_iov = &biov[j];
+		bmsg[j].msg_hdr.msg_iovlen = 1;
+		bmsg[j].msg_hdr.msg_control = &bctrlmsg[j];
+	}
+
+	while (running) {
+
+		if (poll(pfd, currmax, timeout_ms) <= 0) {
+			running = 0;
+			continue;
+		}
+
+		for (i=0; i<currmax && running; i++) {
+
+			if (!pfd[i].revents)
+				continue;
+
+			/* these settings may be modified by recvmmsg() */
+			for (j=0; j<BATCH; j++) {
+				biov[j].iov_len = sizeof(bframe[j]);
+				bmsg[j].msg_hdr.msg_namelen = sizeof(baddr[j]);
+				bmsg[j].msg_hdr.msg_controllen = sizeof(bctrlmsg[j]);
+				bmsg[j].msg_hdr.msg_flags = 0;
+			}
+
+			n = recvmmsg(s[i], bmsg, BATCH, MSG_DONTWAIT, NULL);
+			if (n < 0) {
+				if (errno == EAGAIN || errno == EINTR)
+					continue;
+				if ((errno == ENETDOWN) && !down_causes_exit) {
+					fprintf(stderr, "%s: interface down\n", cmdlinename[i]);
+					continue;
+				}
+				perror("recvmmsg");
+				return 1;
+			}
+
+			for (j=0; j<n && running; j++) {
+
+				struct canfd_frame *cf = &bframe[j];
+				unsigned char type;
+
+				if (bmsg[j].msg_len == CAN_MTU)
+					type = CANDUMP_BLOG_CAN;
+				else if (bmsg[j].msg_len == CANFD_MTU)
+					type = CANDUMP_BLOG_CANFD;
+				else {
+					fprintf(stderr, "read: incomplete CAN frame\n");
+					return 1;
+				}
+
+				get_rxinfo(&bmsg[j].msg_hdr, &tv, &dropcnt[i]);
+
+				idx = idx2dindex(baddr[j].can_ifindex, s[i]);
+				if (logged[idx] != dindex[idx]) {
+					/* new interface index cache entry */
+					candump_blog_add(blog, CANDUMP_BLOG_IFNAME, idx, &tv, 0, 0,
+							 devname[idx], strlen(devname[idx]));
+					logged[idx] = dindex[idx];
+				}
+
+				if (dropcnt[i] != last_dropcnt[i]) {
+					candump_blog_add(blog, CANDUMP_BLOG_DROP, idx, &tv,
+							 dropcnt[i], 0, NULL, 0);
+					last_dropcnt[i] = dropcnt[i];
+				}
+
+				if (candump_blog_add(blog, type, idx, &tv, cf->can_id,
+						     (type == CANDUMP_BLOG_CANFD) ? cf->flags : 0,
+						     cf->data, cf->len) < 0) {
+					fprintf(stderr, "binary log: write error\n");
+					return 1;
+				}
+
+				if (count && (--count == 0))
+					running = 0;
+			}
+		}
+	}
+
+	return 0;
+}
+
+#endif /* CONFIG_CANUTILS_CANDUMP_FASTCAPTURE */
+
 int main(int argc, char **argv)
 {
 	fd_set rdfs;
@@ -227,6 +382,7 @@ int main(int argc, char **argv)
 	unsigned char view = 0;
 	unsigned char log = 0;
 	unsigned char logfrmt = 0;
+	unsigned char binlog = 0;
 	int count = 0;
 	int rcvbuf_size = 0;
 	int opt, ret;
@@ -234,10 +390,9 @@ int main(int argc, char **argv)
 	int join_filter;
 	char *ptr, *nptr;
 	struct sockaddr_can addr;
-	char ctrlmsg[CMSG_SPACE(sizeof(struct timeval) + 3*sizeof(struct timespec) + sizeof(__u32))];
+	char ctrlmsg[CTRLMSGSZ];
 	struct iovec iov;
 	struct msghdr msg;
-	struct cmsghdr *cmsg;
 	struct can_filter *rfilter;
 	can_err_mask_t err_mask;
 	struct canfd_frame frame;
@@ -246,6 +401,9 @@ int main(int argc, char **argv)
 	struct timeval tv, last_tv;
 	struct timeval timeout, timeout_config = { 0, 0 }, *timeout_current = NULL;
 	FILE *logfile = NULL;
+#ifdef CONFIG_CANUTILS_CANDUMP_FASTCAPTURE
+	struct candump_blog_s blog;
+#endif
 
 #if 0 /* NuttX doesn't support these signals */
 	signal(SIGTERM, sigterm);
@@ -256,7 +414,7 @@ int main(int argc, char **argv)
 	last_tv.tv_sec  = 0;
 	last_tv.tv_usec = 0;
 
-	while ((opt = getopt(argc, argv, "t:HciaSs:lDdxLn:r:heT:?")) != -1) {
+	while ((opt = getopt(argc, argv, "t:HciaSs:lbDdxLn:r:heT:?")) != -1) {
 		switch (opt) {
 		case 't':
 			timestamp = optarg[0];
@@ -304,6 +462,12 @@ int main(int argc, char **argv)
 			log = 1;
 			break;
 
+#ifdef CONFIG_CANUTILS_CANDUMP_FASTCAPTURE
+		case 'b':
+			binlog = 1;
+			break;
+#endif
+
 		case 'D':
 			down_causes_exit = 0;
 			break;
@@ -364,8 +528,13 @@ int main(int argc, char **argv)
 		exit(0);
 	}
 
+	if (binlog && (log || logfrmt)) {
+		fprintf(stderr, "Binary log selected: Please disable -l and -L options!\n");
+		exit(0);
+	}
+
 	if (silent == SILENT_INI) {
-		if (log) {
+		if (log || binlog) {
 			fprintf(stderr, "Disabled standard output while logging.\n");
 			silent = SILENT_ON; /* disable output on stdout */
 		} else
@@ -530,7 +699,7 @@ int main(int argc, char **argv)
 			}
 		}
 
-		if (timestamp || log || logfrmt) {
+		if (timestamp || log || logfrmt || binlog) {
 
 			if (hwtimestamp) {
 				const int timestamping_flags = (SOF_TIMESTAMPING_SOFTWARE | \
@@ -602,6 +771,52 @@ int main(int argc, char **argv)
 		}
 	}
 
+#ifdef CONFIG_CANUTILS_CANDUMP_FASTCAPTURE
+	if (binlog) {
+		time_t currtime;
+		struct tm now;
+		char fname[83]; /* suggested by -Wformat-overflow= */
+
+		if (time(&currtime) == (time_t)-1) {
+			perror("time");
+			return 1;
+		}
+
+		localtime_r(&currtime, &now);
+
+		sprintf(fname, "candump-%04d-%02d-%02d_%02d%02d%02d.bin",
+			now.tm_year + 1900,
+			now.tm_mon + 1,
+			now.tm_mday,
+			now.tm_hour,
+			now.tm_min,
+			now.tm_sec);
+
+		fprintf(stderr, "Enabling binary log '%s'\n", fname);
+
+		ret = candump_blog_open(&blog, fname);
+		if (ret < 0) {
+			errno = -ret;
+			perror("binary log");
+			return 1;
+		}
+
+		ret = fast_capture(s, currmax, count, down_causes_exit,
+				   timeout_current ? timeout_config.tv_sec * 1000 +
+				   timeout_config.tv_usec / 1000 : -1, &blog);
+
+		for (i=0; i<currmax; i++)
+			close(s[i]);
+
+		if (candump_blog_close(&blog) < 0) {
+			fprintf(stderr, "binary log: write error\n");
+			ret = 1;
+		}
+
+		return ret;
+	}
+#endif
+
 	/* these settings are static and can be held out of the hot path */
 	iov.iov_base = &frame;
 	msg.msg_name = &addr;
@@ -660,27 +875,7 @@ int main(int argc, char **argv)
 				if (count && (--count == 0))
 					running = 0;
 
-				for (cmsg = CMSG_FIRSTHDR(&msg);
-				     cmsg && (cmsg->cmsg_level == SOL_SOCKET);
-				     cmsg = CMSG_NXTHDR(&msg,cmsg)) {
-					if (cmsg->cmsg_type == SO_TIMESTAMP) {
-						memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
-					} else if (cmsg->cmsg_type == SO_TIMESTAMPING) {
-
-						struct timespec *stamp = (struct timespec *)CMSG_DATA(cmsg);
-
-						/*
-						 * stamp[0] is the software timestamp
-						 * stamp[1] is deprecated
-						 * stamp[2] is the raw hardware timestamp
-						 * See chapter 2.1.2 Receive timestamps in
-						 * linux/Documentation/networking/timestamping.txt
-						 */
-						tv.tv_sec = stamp[2].tv_sec;
-						tv.tv_usec = stamp[2].tv_nsec/1000;
-					} else if (cmsg->cmsg_type == SO_RXQ_OVFL)
-						memcpy(&dropcnt[i], CMSG_DATA(cmsg), sizeof(__u32));
-				}
+				get_rxinfo(&msg, &tv, &dropcnt[i]);
 
 				/* check for (unlikely) dropped frames on this specific socket */
 				if (dropcnt[i] != last_dropcnt[i]) {
@@ -0,0 +1,299 @@
+/****************************************************************************
+ * apps/canutils/candump/candump_blog.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "candump_blog.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BLOG_BUFSIZE  CONFIG_CANUTILS_CANDUMP_BLOG_BUFSIZE
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: candump_blog_write
+ ****************************************************************************/
+
+static int candump_blog_write(int fd, FAR const uint8_t *buf, size_t len)
+{
+  ssize_t n;
+
+  while (len > 0)
+    {
+      n = write(fd, buf, len);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      buf += n;
+      len -= n;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: candump_blog_thread
+ *
+ * Description:
+ *   Write the full buffers until the log is closed.
+ *
+ ****************************************************************************/
+
+static FAR void *candump_blog_thread(FAR void *arg)
+{
+  FAR struct candump_blog_s *blog = (FAR struct candump_blog_s *)arg;
+  int ret;
+  int i;
+
+  pthread_mutex_lock(&blog->lock);
+  for (; ; )
+    {
+      /* When both are full, the buffer not being filled is the oldest */
+
+      i = !blog->fill;
+      if (!blog->full[i])
+        {
+          i = blog->fill;
+        }
+
+      if (!blog->full[i])
+        {
+          if (blog->stop)
+            {
+              break;
+            }
+
+          pthread_cond_wait(&blog->cond, &blog->lock);
+          continue;
+        }
+
+      pthread_mutex_unlock(&blog->lock);
+      ret = candump_blog_write(blog->fd, blog->buf[i], blog->len[i]);
+      pthread_mutex_lock(&blog->lock);
+
+      if (ret < 0 && blog->error == 0)
+        {
+          blog->error = ret;
+        }
+
+      blog->len[i]  = 0;
+      blog->full[i] = false;
+      pthread_cond_broadcast(&blog->cond);
+    }
+
+  pthread_mutex_unlock(&blog->lock);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: candump_blog_swap
+ *
+ * Description:
+ *   Hand the buffer being filled to the writer thread and wait for the
+ *   other one to be written.
+ *
+ ****************************************************************************/
+
+static int candump_blog_swap(FAR struct candump_blog_s *blog)
+{
+  int next = !blog->fill;
+  int ret;
+
+  pthread_mutex_lock(&blog->lock);
+
+  blog->full[blog->fill] = true;
+  pthread_cond_broadcast(&blog->cond);
+
+  while (blog->full[next])
+    {
+      pthread_cond_wait(&blog->cond, &blog->lock);
+    }
+
+  blog->fill = next;
+  ret        = blog->error;
+  pthread_mutex_unlock(&blog->lock);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: candump_blog_open
+ ****************************************************************************/
+
+int candump_blog_open(FAR struct candump_blog_s *blog, FAR const char *path)
+{
+  struct candump_blog_file_s hdr;
+  int ret;
+
+  memset(blog, 0, sizeof(*blog));
+
+  blog->buf[0] = malloc(2 * BLOG_BUFSIZE);
+  if (blog->buf[0] == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  blog->buf[1] = blog->buf[0] + BLOG_BUFSIZE;
+
+  blog->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (blog->fd < 0)
+    {
+      ret = -errno;
+      goto errout;
+    }
+
+  memcpy(hdr.magic, CANDUMP_BLOG_MAGIC, sizeof(hdr.magic));
+  hdr.order = CANDUMP_BLOG_ORDER;
+
+  ret = candump_blog_write(blog->fd, (FAR const uint8_t *)&hdr,
+                           sizeof(hdr));
+  if (ret < 0)
+    {
+      goto errout_with_fd;
+    }
+
+  pthread_mutex_init(&blog->lock, NULL);
+  pthread_cond_init(&blog->cond, NULL);
+
+  ret = -pthread_create(&blog->thread, NULL, candump_blog_thread, blog);
+  if (ret < 0)
+    {
+      pthread_cond_destroy(&blog->cond);
+      pthread_mutex_destroy(&blog->lock);
+      goto errout_with_fd;
+    }
+
+  return 0;
+
+errout_with_fd:
+  close(blog->fd);
+errout:
+  free(blog->buf[0]);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: candump_blog_add
+ ****************************************************************************/
+
+int candump_blog_add(FAR struct candump_blog_s *blog, uint8_t type,
+                     uint8_t idx, FAR const struct timeval *tv,
+                     uint32_t can_id, uint8_t flags,
+                     FAR const void *data, uint8_t len)
+{
+  struct candump_blog_rec_s rec;
+  FAR uint8_t *dest;
+  int ret;
+
+  if (blog->len[blog->fill] > 0 &&
+      (blog->len[blog->fill] + sizeof(rec) + len > BLOG_BUFSIZE ||
+       (uint32_t)tv->tv_sec != blog->sec))
+    {
+      ret = candump_blog_swap(blog);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  rec.type   = type;
+  rec.idx    = idx;
+  rec.len    = len;
+  rec.flags  = flags;
+  rec.sec    = tv->tv_sec;
+  rec.usec   = tv->tv_usec;
+  rec.can_id = can_id;
+
+  if (blog->len[blog->fill] == 0)
+    {
+      blog->sec = rec.sec;
+    }
+
+  dest = blog->buf[blog->fill] + blog->len[blog->fill];
+  memcpy(dest, &rec, sizeof(rec));
+  if (len > 0)
+    {
+      memcpy(dest + sizeof(rec), data, len);
+    }
+
+  blog->len[blog->fill] += sizeof(rec) + len;
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: candump_blog_close
+ ****************************************************************************/
+
+int candump_blog_close(FAR struct candump_blog_s *blog)
+{
+  int ret;
+
+  pthread_mutex_lock(&blog->lock);
+
+  if (blog->len[blog->fill] > 0)
+    {
+      blog->full[blog->fill] = true;
+    }
+
+  blog->stop = true;
+  pthread_cond_broadcast(&blog->cond);
+  pthread_mutex_unlock(&blog->lock);
+
+  pthread_join(blog->thread, NULL);
+
+  ret = blog->error;
+  if (close(blog->fd) < 0 && ret == 0)
+    {
+      ret = -errno;
+    }
+
+  pthread_cond_destroy(&blog->cond);
+  pthread_mutex_destroy(&blog->lock);
+  free(blog->buf[0]);
+  return ret;
+}
@@ -0,0 +1,138 @@
+/****************************************************************************
+ * apps/canutils/candump/candump_blog.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+
+#ifndef __APPS_CANUTILS_CANDUMP_CANDUMP_BLOG_H
+#define __APPS_CANUTILS_CANDUMP_CANDUMP_BLOG_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/time.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include <nuttx/can.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* A binary log starts with a candump_blog_file_s and is followed by
+ * records, each a candump_blog_rec_s and len bytes of data, not aligned.
+ * Values are in the byte order of the target, given by the order field.
+ */
+
+#define CANDUMP_BLOG_MAGIC    "CANBLOG1"
+#define CANDUMP_BLOG_ORDER    0x01020304
+
+#define CANDUMP_BLOG_CAN      0  /* CAN frame, data is frame data */
+#define CANDUMP_BLOG_CANFD    1  /* CAN FD frame, data is frame data */
+#define CANDUMP_BLOG_IFNAME   2  /* Name of interface idx, data is name */
+#define CANDUMP_BLOG_DROP     3  /* can_id is the total of dropped frames */
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct candump_blog_file_s
+{
+  char     magic[8];
+  uint32_t order;
+};
+
+struct candump_blog_rec_s
+{
+  uint8_t  type;    /* CANDUMP_BLOG_* */
+  uint8_t  idx;     /* Interface */
+  uint8_t  len;     /* Bytes of data after the record */
+  uint8_t  flags;   /* CAN FD flags */
+  uint32_t sec;     /* Receive time */
+  uint32_t usec;
+  uint32_t can_id;
+};
+
+/* Records are added to one buffer while the writer thread writes the
+ * other one to the file.
+ */
+
+struct candump_blog_s
+{
+  int             fd;
+  pthread_t       thread;
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+  FAR uint8_t    *buf[2];
+  size_t          len[2];
+  bool            full[2];
+  int             fill;      /* Buffer receiving the records */
+  uint32_t        sec;       /* Time of the first record in fill */
+  bool            stop;
+  int             error;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: candump_blog_open
+ *
+ * Description:
+ *   Create the binary log file path and start its writer thread.
+ *
+ * Returned Value:
+ *   Zero on success, a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int candump_blog_open(FAR struct candump_blog_s *blog, FAR const char *path);
+
+/****************************************************************************
+ * Name: candump_blog_add
+ *
+ * Description:
+ *   Add a record.  The buffer is handed to the writer thread when it is
+ *   full or holds records of more than one second.  Waits for the writer
+ *   thread if both buffers are full.
+ *
+ ****************************************************************************/
+
+int candump_blog_add(FAR struct candump_blog_s *blog, uint8_t type,
+                     uint8_t idx, FAR const struct timeval *tv,
+                     uint32_t can_id, uint8_t flags,
+                     FAR const void *data, uint8_t len);
+
+/****************************************************************************
+ * Name: candump_blog_close
+ *
+ * Description:
+ *   Write the remaining records, stop the writer thread and close the
+ *   file.
+ *
+ ****************************************************************************/
+
+int candump_blog_close(FAR struct candump_blog_s *blog);
+
+#endif /* __APPS_CANUTILS_CANDUMP_CANDUMP_BLOG_H */
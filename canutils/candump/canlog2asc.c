@@ -0,0 +1,161 @@
+/****************************************************************************
+ * apps/canutils/candump/canlog2asc.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <net/if.h>
+
+#include "candump_blog.h"
+#include "lib.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MAXIFNAMES 256
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ *
+ * Description:
+ *   Convert a binary log of candump -b to the log file format of
+ *   candump -l.
+ *
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  static char ifname[MAXIFNAMES][IFNAMSIZ + 1];
+  static uint32_t drops[MAXIFNAMES];
+  struct candump_blog_file_s hdr;
+  struct candump_blog_rec_s rec;
+  struct canfd_frame frame;
+  char buf[CL_CFSZ];
+  FAR FILE *in;
+  FAR FILE *out = stdout;
+  int ret = EXIT_FAILURE;
+  int width = 0;
+  int len;
+
+  if (argc < 2 || argc > 3)
+    {
+      fprintf(stderr, "Usage: %s <binary log> [<log file>]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  in = fopen(argv[1], "rb");
+  if (in == NULL)
+    {
+      perror(argv[1]);
+      return EXIT_FAILURE;
+    }
+
+  if (fread(&hdr, sizeof(hdr), 1, in) != 1 ||
+      memcmp(hdr.magic, CANDUMP_BLOG_MAGIC, sizeof(hdr.magic)) != 0 ||
+      hdr.order != CANDUMP_BLOG_ORDER)
+    {
+      fprintf(stderr, "%s: not a binary log of this target\n", argv[1]);
+      goto errout;
+    }
+
+  if (argc == 3)
+    {
+      out = fopen(argv[2], "w");
+      if (out == NULL)
+        {
+          perror(argv[2]);
+          goto errout;
+        }
+    }
+
+  while (fread(&rec, sizeof(rec), 1, in) == 1)
+    {
+      memset(&frame, 0, sizeof(frame));
+      if (rec.len > sizeof(frame.data) ||
+          fread(frame.data, 1, rec.len, in) != rec.len)
+        {
+          fprintf(stderr, "%s: truncated record\n", argv[1]);
+          goto errout_with_out;
+        }
+
+      switch (rec.type)
+        {
+          case CANDUMP_BLOG_IFNAME:
+            len = rec.len < IFNAMSIZ ? rec.len : IFNAMSIZ;
+            memcpy(ifname[rec.idx], frame.data, len);
+            ifname[rec.idx][len] = '\0';
+            if (width < len)
+              {
+                width = len;
+              }
+            break;
+
+          case CANDUMP_BLOG_DROP:
+            fprintf(out, "DROPCOUNT: dropped %" PRIu32 " CAN frame%s on "
+                    "'%s' socket (total drops %" PRIu32 ")\n",
+                    rec.can_id - drops[rec.idx],
+                    rec.can_id - drops[rec.idx] > 1 ? "s" : "",
+                    ifname[rec.idx], rec.can_id);
+            drops[rec.idx] = rec.can_id;
+            break;
+
+          case CANDUMP_BLOG_CAN:
+          case CANDUMP_BLOG_CANFD:
+            frame.can_id = rec.can_id;
+            frame.len    = rec.len;
+            frame.flags  = rec.flags;
+            sprint_canframe(buf, &frame, 0,
+                            rec.type == CANDUMP_BLOG_CAN ?
+                            CAN_MAX_DLEN : CANFD_MAX_DLEN);
+            fprintf(out, "(%010" PRIu32 ".%06" PRIu32 ") %*s %s\n",
+                    rec.sec, rec.usec, width, ifname[rec.idx], buf);
+            break;
+
+          default:
+            break;
+        }
+    }
+
+  ret = EXIT_SUCCESS;
+
+errout_with_out:
+  if (out != stdout)
+    {
+      fclose(out);
+    }
+
+errout:
+  fclose(in);
+  return ret;
+}
@@ -0,0 +1,712 @@
+/****************************************************************************
+ * apps/canutils/lely-canopen/lely_rt.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <netpacket/can.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include <lely/co/obj.h>
+#include <lely/co/type.h>
+
+#include "canutils/lely_rt.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define LELY_RT_NPDO         512      /* PDOs of each direction in a node */
+#define LELY_RT_MAXSYNCTYPE  240      /* Last synchronous transmission type */
+
+#define LELY_RT_COBID_INVALID (UINT32_C(1) << 31)
+#define LELY_RT_COBID_PRODUCE (UINT32_C(1) << 30)
+#define LELY_RT_COBID_FRAME   (UINT32_C(1) << 29)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A mapping entry resolved to the value it maps.  val is NULL for the
+ * dummy entries, which only take room in the frame.
+ */
+
+struct lely_rt_entry_s
+{
+  FAR void *val;
+  uint8_t   size;                     /* Bytes of the value */
+  uint8_t   offset;                   /* Bit offset in the frame */
+  uint8_t   len;                      /* Bits in the frame */
+};
+
+struct lely_rt_pdo_s
+{
+  canid_t  id;                        /* SocketCAN identifier */
+  uint8_t  type;                      /* Transmission type */
+  uint8_t  count;                     /* SYNCs until the next TPDO */
+  uint8_t  dlc;
+  uint8_t  nentries;
+  bool     fresh;                     /* RPDO received since the SYNC */
+  bool     seen;                      /* RPDO received at least once */
+  uint16_t first;                     /* First entry */
+  uint8_t  data[8];                   /* Last RPDO received */
+};
+
+struct lely_rt_s
+{
+  int          sock;
+  pthread_t    thread;
+  bool         producer;              /* This node produces SYNC */
+  canid_t      syncid;
+  uint32_t     period;                /* Communication cycle period, us */
+  CODE void  (*cycle)(FAR void *arg);
+  FAR void    *arg;
+
+  int          nrpdo;
+  int          ntpdo;
+  int          nentries;
+  struct lely_rt_pdo_s   rpdo[CONFIG_CANUTILS_LELYCANOPEN_RT_MAXPDO];
+  struct lely_rt_pdo_s   tpdo[CONFIG_CANUTILS_LELYCANOPEN_RT_MAXPDO];
+  struct lely_rt_entry_s entries[CONFIG_CANUTILS_LELYCANOPEN_RT_MAXENTRIES];
+
+  /* Statistics, written by the fast path thread under a sequence count
+   * and copied by lely_rt_stats() until the count did not change.
+   */
+
+  atomic_uint  seq;
+  atomic_bool  reset;
+  uint64_t     last;                  /* Time of the previous SYNC */
+  uint64_t     period_sum;
+  uint64_t     latency_sum;
+  struct lely_rt_stats_s stats;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint64_t lely_rt_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t lely_rt_load(FAR const void *val, uint8_t size)
+{
+  switch (size)
+    {
+      case 1:
+        return *(FAR const uint8_t *)val;
+
+      case 2:
+        return *(FAR const uint16_t *)val;
+
+      case 4:
+        return *(FAR const uint32_t *)val;
+
+      default:
+        return *(FAR const uint64_t *)val;
+    }
+}
+
+static void lely_rt_store(FAR void *val, uint8_t size, uint64_t v)
+{
+  switch (size)
+    {
+      case 1:
+        *(FAR uint8_t *)val = v;
+        break;
+
+      case 2:
+        *(FAR uint16_t *)val = v;
+        break;
+
+      case 4:
+        *(FAR uint32_t *)val = v;
+        break;
+
+      default:
+        *(FAR uint64_t *)val = v;
+        break;
+    }
+}
+
+/* PDO data is little endian and bit packed; most entries are whole
+ * bytes at a byte offset and take the fast branch.
+ */
+
+static void lely_rt_pack(FAR uint8_t *data,
+                         FAR const struct lely_rt_entry_s *e, uint64_t v)
+{
+  unsigned int i;
+
+  if ((e->offset & 7) == 0 && (e->len & 7) == 0)
+    {
+      for (i = 0; i < e->len / 8; i++, v >>= 8)
+        {
+          data[e->offset / 8 + i] = v;
+        }
+
+      return;
+    }
+
+  for (i = 0; i < e->len; i++, v >>= 1)
+    {
+      unsigned int bit = e->offset + i;
+
+      data[bit / 8] = (data[bit / 8] & ~(1 << (bit & 7))) |
+                      (v & 1) << (bit & 7);
+    }
+}
+
+static uint64_t lely_rt_unpack(FAR const uint8_t *data,
+                               FAR const struct lely_rt_entry_s *e)
+{
+  uint64_t v = 0;
+  unsigned int i;
+
+  if ((e->offset & 7) == 0 && (e->len & 7) == 0)
+    {
+      for (i = e->len / 8; i-- > 0; )
+        {
+          v = v << 8 | data[e->offset / 8 + i];
+        }
+
+      return v;
+    }
+
+  for (i = e->len; i-- > 0; )
+    {
+      unsigned int bit = e->offset + i;
+
+      v = v << 1 | ((data[bit / 8] >> (bit & 7)) & 1);
+    }
+
+  return v;
+}
+
+/****************************************************************************
+ * Name: lely_rt_resolve
+ *
+ * Description:
+ *   Add the synchronous PDOs with the communication parameter objects at
+ *   comm and the mapping parameter objects at map (1400h/1600h for the
+ *   RPDOs, 1800h/1A00h for the TPDOs).
+ *
+ ****************************************************************************/
+
+static int lely_rt_resolve(FAR struct lely_rt_s *rt, FAR co_dev_t *dev,
+                           co_unsigned16_t comm, co_unsigned16_t map,
+                           FAR struct lely_rt_pdo_s *pdos, FAR int *npdo)
+{
+  FAR struct lely_rt_pdo_s *pdo;
+  FAR struct lely_rt_entry_s *e;
+  FAR co_sub_t *sub;
+  co_unsigned32_t cobid;
+  co_unsigned32_t entry;
+  co_unsigned8_t type;
+  co_unsigned8_t n;
+  unsigned int bits;
+  int i;
+  int j;
+
+  for (i = 0; i < LELY_RT_NPDO; i++)
+    {
+      if (co_dev_find_sub(dev, comm + i, 1) == NULL)
+        {
+          continue;
+        }
+
+      cobid = co_dev_get_val_u32(dev, comm + i, 1);
+      type  = co_dev_get_val_u8(dev, comm + i, 2);
+      if ((cobid & LELY_RT_COBID_INVALID) != 0 ||
+          type > LELY_RT_MAXSYNCTYPE)
+        {
+          continue;
+        }
+
+      if (*npdo >= CONFIG_CANUTILS_LELYCANOPEN_RT_MAXPDO)
+        {
+          return -E2BIG;
+        }
+
+      pdo = &pdos[(*npdo)++];
+      memset(pdo, 0, sizeof(*pdo));
+
+      if ((cobid & LELY_RT_COBID_FRAME) != 0)
+        {
+          pdo->id = (cobid & CAN_EFF_MASK) | CAN_EFF_FLAG;
+        }
+      else
+        {
+          pdo->id = cobid & CAN_SFF_MASK;
+        }
+
+      pdo->type  = type;
+      pdo->count = type;
+      pdo->first = rt->nentries;
+
+      n    = co_dev_get_val_u8(dev, map + i, 0);
+      bits = 0;
+
+      for (j = 1; j <= n; j++)
+        {
+          if (rt->nentries >= CONFIG_CANUTILS_LELYCANOPEN_RT_MAXENTRIES)
+            {
+              return -E2BIG;
+            }
+
+          entry     = co_dev_get_val_u32(dev, map + i, j);
+          e         = &rt->entries[rt->nentries++];
+          e->offset = bits;
+          e->len    = entry & 0xff;
+          e->val    = NULL;
+          e->size   = 0;
+
+          bits += e->len;
+          if (e->len == 0 || bits > 64)
+            {
+              return -EINVAL;
+            }
+
+          /* Entries of the data type area are dummies */
+
+          if ((entry >> 16) < 0x1000)
+            {
+              continue;
+            }
+
+          sub = co_dev_find_sub(dev, entry >> 16, (entry >> 8) & 0xff);
+          if (sub == NULL)
+            {
+              return -ENOENT;
+            }
+
+          e->size = co_type_sizeof(co_sub_get_type(sub));
+          e->val  = co_sub_addressof_val(sub);
+          if ((e->size != 1 && e->size != 2 && e->size != 4 &&
+               e->size != 8) || e->len > e->size * 8 || e->val == NULL)
+            {
+              return -EINVAL;
+            }
+        }
+
+      pdo->nentries = n;
+      pdo->dlc      = (bits + 7) / 8;
+    }
+
+  return 0;
+}
+
+static void lely_rt_rx(FAR struct lely_rt_s *rt,
+                       FAR const struct can_frame *frame)
+{
+  FAR struct lely_rt_pdo_s *pdo;
+  int i;
+
+  for (i = 0; i < rt->nrpdo; i++)
+    {
+      pdo = &rt->rpdo[i];
+      if (pdo->id == frame->can_id &&
+          frame->can_dlc >= pdo->dlc)
+        {
+          memcpy(pdo->data, frame->data, pdo->dlc);
+          pdo->fresh = true;
+          pdo->seen  = true;
+          return;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: lely_rt_sync
+ *
+ * Description:
+ *   Run one cycle: write the RPDOs received before the SYNC to the object
+ *   dictionary, call the application and send the TPDOs due.
+ *
+ ****************************************************************************/
+
+static void lely_rt_sync(FAR struct lely_rt_s *rt, uint64_t now)
+{
+  FAR struct lely_rt_stats_s *st = &rt->stats;
+  FAR struct lely_rt_entry_s *e;
+  FAR struct lely_rt_pdo_s *pdo;
+  struct can_frame frame;
+  uint32_t missed = 0;
+  uint32_t period;
+  uint32_t latency;
+  uint32_t jitter;
+  int i;
+  int j;
+
+  for (i = 0; i < rt->nrpdo; i++)
+    {
+      pdo = &rt->rpdo[i];
+      if (!pdo->fresh)
+        {
+          missed += pdo->seen;
+          continue;
+        }
+
+      pdo->fresh = false;
+      for (j = 0; j < pdo->nentries; j++)
+        {
+          e = &rt->entries[pdo->first + j];
+          if (e->val != NULL)
+            {
+              lely_rt_store(e->val, e->size, lely_rt_unpack(pdo->data, e));
+            }
+        }
+    }
+
+  if (rt->cycle != NULL)
+    {
+      rt->cycle(rt->arg);
+    }
+
+  /* Type 0 (acyclic synchronous) is sent on every SYNC, as lely cannot
+   * tell the fast path about the events that would trigger it.
+   */
+
+  for (i = 0; i < rt->ntpdo; i++)
+    {
+      pdo = &rt->tpdo[i];
+      if (pdo->type > 1 && --pdo->count > 0)
+        {
+          continue;
+        }
+
+      pdo->count = pdo->type;
+
+      memset(&frame, 0, sizeof(frame));
+      frame.can_id  = pdo->id;
+      frame.can_dlc = pdo->dlc;
+
+      for (j = 0; j < pdo->nentries; j++)
+        {
+          e = &rt->entries[pdo->first + j];
+          if (e->val != NULL)
+            {
+              lely_rt_pack(frame.data, e, lely_rt_load(e->val, e->size));
+            }
+        }
+
+      write(rt->sock, &frame, sizeof(frame));
+    }
+
+  latency = lely_rt_now() - now;
+  period  = now - rt->last;
+
+  /* Update the statistics under an odd sequence count */
+
+  atomic_fetch_add_explicit(&rt->seq, 1, memory_order_acq_rel);
+
+  if (atomic_exchange(&rt->reset, false) || rt->last == 0)
+    {
+      memset(st, 0, sizeof(*st));
+      st->period_min  = UINT32_MAX;
+      rt->period_sum  = 0;
+      rt->latency_sum = 0;
+    }
+  else
+    {
+      jitter = period > rt->period ? period - rt->period :
+                                     rt->period - period;
+
+      st->cycles++;
+      st->rpdo_missed += missed;
+      st->overruns    += period > rt->period + rt->period / 2;
+      st->period_min   = MIN(st->period_min, period);
+      st->period_max   = MAX(st->period_max, period);
+      st->jitter_max   = MAX(st->jitter_max, jitter);
+      st->latency_max  = MAX(st->latency_max, latency);
+      rt->period_sum  += period;
+      rt->latency_sum += latency;
+      st->period_avg   = rt->period_sum / st->cycles;
+      st->latency_avg  = rt->latency_sum / st->cycles;
+    }
+
+  atomic_fetch_add_explicit(&rt->seq, 1, memory_order_release);
+  rt->last = now;
+}
+
+static FAR void *lely_rt_thread(FAR void *arg)
+{
+  FAR struct lely_rt_s *rt = arg;
+  struct can_frame frame;
+  struct timespec next;
+  ssize_t nbytes;
+
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  for (; ; )
+    {
+      if (rt->producer)
+        {
+          /* Sleep to the absolute SYNC time, so that the period does not
+           * drift with the time a cycle takes, then take the RPDOs that
+           * arrived during the previous cycle.
+           */
+
+          next.tv_nsec += rt->period * 1000;
+          while (next.tv_nsec >= 1000000000)
+            {
+              next.tv_sec++;
+              next.tv_nsec -= 1000000000;
+            }
+
+          clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+          while (recv(rt->sock, &frame, sizeof(frame), MSG_DONTWAIT) > 0)
+            {
+              lely_rt_rx(rt, &frame);
+            }
+
+          memset(&frame, 0, sizeof(frame));
+          frame.can_id = rt->syncid;
+          write(rt->sock, &frame, sizeof(frame));
+
+          lely_rt_sync(rt, lely_rt_now());
+          continue;
+        }
+
+      nbytes = read(rt->sock, &frame, sizeof(frame));
+      if (nbytes < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          break;
+        }
+
+      if (nbytes != sizeof(frame))
+        {
+          continue;
+        }
+
+      if (frame.can_id == rt->syncid)
+        {
+          lely_rt_sync(rt, lely_rt_now());
+        }
+      else
+        {
+          lely_rt_rx(rt, &frame);
+        }
+    }
+
+  return NULL;
+}
+
+static int lely_rt_opensock(FAR struct lely_rt_s *rt,
+                            FAR const char *ifname)
+{
+  struct can_filter filters[CONFIG_CANUTILS_LELYCANOPEN_RT_MAXPDO + 1];
+  struct sockaddr_can addr;
+  int nfilters = 0;
+  int i;
+
+  rt->sock = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (rt->sock < 0)
+    {
+      return -errno;
+    }
+
+  /* Only SYNC and the synchronous RPDOs reach this socket */
+
+  if (!rt->producer)
+    {
+      filters[nfilters].can_id     = rt->syncid;
+      filters[nfilters++].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG |
+                                     CAN_RTR_FLAG;
+    }
+
+  for (i = 0; i < rt->nrpdo; i++)
+    {
+      filters[nfilters].can_id     = rt->rpdo[i].id;
+      filters[nfilters++].can_mask = (rt->rpdo[i].id & CAN_EFF_FLAG ?
+                                      CAN_EFF_MASK : CAN_SFF_MASK) |
+                                     CAN_EFF_FLAG | CAN_RTR_FLAG;
+    }
+
+  if (setsockopt(rt->sock, SOL_CAN_RAW, CAN_RAW_FILTER, filters,
+                 nfilters * sizeof(filters[0])) < 0)
+    {
+      return -errno;
+    }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family  = AF_CAN;
+  addr.can_ifindex = if_nametoindex(ifname);
+  if (addr.can_ifindex == 0)
+    {
+      return -ENODEV;
+    }
+
+  if (bind(rt->sock, (FAR struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+      return -errno;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: lely_rt_start
+ ****************************************************************************/
+
+int lely_rt_start(FAR const struct lely_rt_config_s *cfg,
+                  FAR struct lely_rt_s **rtp)
+{
+  FAR struct lely_rt_s *rt;
+  struct sched_param param;
+  pthread_attr_t attr;
+  co_unsigned32_t cobid;
+  int ret;
+
+  rt = zalloc(sizeof(*rt));
+  if (rt == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  rt->sock   = -1;
+  rt->cycle  = cfg->cycle;
+  rt->arg    = cfg->arg;
+
+  cobid        = co_dev_get_val_u32(cfg->dev, 0x1005, 0);
+  rt->syncid   = cobid & CAN_SFF_MASK;
+  rt->producer = (cobid & LELY_RT_COBID_PRODUCE) != 0;
+  rt->period   = co_dev_get_val_u32(cfg->dev, 0x1006, 0);
+
+  if (rt->producer && rt->period == 0)
+    {
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  ret = lely_rt_resolve(rt, cfg->dev, 0x1400, 0x1600,
+                        rt->rpdo, &rt->nrpdo);
+  if (ret >= 0)
+    {
+      ret = lely_rt_resolve(rt, cfg->dev, 0x1800, 0x1a00,
+                            rt->tpdo, &rt->ntpdo);
+    }
+
+  if (ret >= 0)
+    {
+      ret = lely_rt_opensock(rt, cfg->ifname);
+    }
+
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr,
+                            CONFIG_CANUTILS_LELYCANOPEN_RT_STACKSIZE);
+  pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+  param.sched_priority = CONFIG_CANUTILS_LELYCANOPEN_RT_PRIORITY;
+  pthread_attr_setschedparam(&attr, &param);
+  pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+
+  ret = -pthread_create(&rt->thread, &attr, lely_rt_thread, rt);
+  pthread_attr_destroy(&attr);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  pthread_setname_np(rt->thread, "lely_rt");
+  *rtp = rt;
+  return 0;
+
+errout:
+  if (rt->sock >= 0)
+    {
+      close(rt->sock);
+    }
+
+  free(rt);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: lely_rt_stats
+ ****************************************************************************/
+
+void lely_rt_stats(FAR struct lely_rt_s *rt,
+                   FAR struct lely_rt_stats_s *stats, bool reset)
+{
+  unsigned int seq;
+
+  do
+    {
+      seq = atomic_load_explicit(&rt->seq, memory_order_acquire);
+      memcpy(stats, &rt->stats, sizeof(*stats));
+      atomic_thread_fence(memory_order_acquire);
+    }
+  while ((seq & 1) != 0 ||
+         atomic_load_explicit(&rt->seq, memory_order_relaxed) != seq);
+
+  if (stats->cycles == 0)
+    {
+      stats->period_min = 0;
+    }
+
+  if (reset)
+    {
+      atomic_store(&rt->reset, true);
+    }
+}
+
+/****************************************************************************
+ * Name: lely_rt_stop
+ ****************************************************************************/
+
+void lely_rt_stop(FAR struct lely_rt_s *rt)
+{
+  pthread_cancel(rt->thread);
+  pthread_join(rt->thread, NULL);
+  close(rt->sock);
+  free(rt);
+}
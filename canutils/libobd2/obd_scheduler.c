@@ -0,0 +1,696 @@
+/****************************************************************************
+ * apps/canutils/libobd2/obd_scheduler.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <nuttx/can/can.h>
+
+#include "canutils/obd.h"
+#include "canutils/obd_pid.h"
+#include "canutils/obd_frame.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Mode 01 PIDs in one single frame request: PCI, mode and 6 PIDs */
+
+#define OBD_SCHED_MAXPIDS      6
+
+/* ECUs 0-7 and the functional address */
+
+#define OBD_SCHED_NECUS        8
+#define OBD_SCHED_NTARGETS     (OBD_SCHED_NECUS + 1)
+#define OBD_SCHED_TARGET(ecu)  \
+  ((ecu) == OBD_ECU_ALL ? OBD_SCHED_NECUS : (ecu))
+
+/* Largest response reassembled, 6 PIDs of 4 bytes take 31 bytes */
+
+#define OBD_SCHED_RXSIZE       64
+
+/* Physical request addresses, the flow control frames go there too */
+
+#define OBD_STD_PHYS_REQUEST(n) (0x7e0 + (n))
+#define OBD_EXT_PHYS_REQUEST(n) (0x18da00f1 | ((0x10 + (n)) << 8))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The request in flight for one target */
+
+struct obd_req_s
+{
+  uint32_t sent;                     /* Time it was sent                    */
+  uint8_t  npids;                    /* Number of PIDs requested            */
+  uint8_t  left;                     /* PIDs not answered yet               */
+  uint8_t  batch;                    /* Most PIDs per request accepted      */
+  bool     active;                   /* Waiting for the answer              */
+  bool     answered;                 /* Some PID was answered               */
+};
+
+/* Reassembly of the multi-frame response of one ECU */
+
+struct obd_rx_s
+{
+  uint16_t len;                      /* Length announced, 0 if idle         */
+  uint16_t pos;                      /* Bytes received                      */
+  uint8_t  sn;                       /* Next sequence number                */
+  uint8_t  buf[OBD_SCHED_RXSIZE];
+};
+
+struct obd_sched_s
+{
+  FAR struct obd_dev_s *dev;
+  FAR struct obd_poll_s *polls;
+  int npolls;
+  obd_value_t cb;
+  FAR void *arg;
+  struct can_msg_s msg;
+  struct obd_req_s req[OBD_SCHED_NTARGETS];
+  struct obd_rx_s rx[OBD_SCHED_NECUS];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Data bytes of the mode 01 PIDs, 0 where it varies or is unknown */
+
+static const uint8_t g_pidlen[] =
+{
+  4, 4, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1,   /* 0x00 */
+  2, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2,   /* 0x10 */
+  4, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 1, 1, 1, 1,   /* 0x20 */
+  1, 2, 2, 1, 4, 4, 4, 4, 4, 4, 4, 4, 2, 2, 2, 2,   /* 0x30 */
+  4, 4, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 4,   /* 0x40 */
+  4, 1, 1, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 1,   /* 0x50 */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: obd_sched_now
+ ****************************************************************************/
+
+static uint32_t obd_sched_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/****************************************************************************
+ * Name: obd_sched_pidlen
+ *
+ * Description:
+ *   Return the data length of a PID, 0 if it can only be requested alone.
+ *
+ ****************************************************************************/
+
+static uint8_t obd_sched_pidlen(uint8_t pid)
+{
+  if ((pid & 0x1f) == 0)
+    {
+      return 4; /* PIDs supported */
+    }
+
+  return pid < sizeof(g_pidlen) ? g_pidlen[pid] : 0;
+}
+
+/****************************************************************************
+ * Name: obd_sched_write
+ *
+ * Description:
+ *   Send a frame of up to 8 bytes, padded, to the physical address of ecu
+ *   or to the functional address.
+ *
+ ****************************************************************************/
+
+static int obd_sched_write(FAR struct obd_sched_s *sched, uint8_t ecu,
+                           FAR const uint8_t *data, int len)
+{
+  FAR struct can_msg_s *msg = &sched->msg;
+  int msgsize = CAN_MSGLEN(8);
+  int nbytes;
+
+  memset(msg, 0, sizeof(*msg));
+
+#ifdef CONFIG_CAN_EXTID
+  if (sched->dev->can_mode == CAN_EXT)
+    {
+      msg->cm_hdr.ch_id = ecu == OBD_ECU_ALL ? OBD_PID_EXT_REQUEST :
+                          OBD_EXT_PHYS_REQUEST(ecu);
+      msg->cm_hdr.ch_extid = true;
+    }
+  else
+#endif
+    {
+      msg->cm_hdr.ch_id = ecu == OBD_ECU_ALL ? OBD_PID_STD_REQUEST :
+                          OBD_STD_PHYS_REQUEST(ecu);
+    }
+
+  msg->cm_hdr.ch_dlc = 8;
+  memcpy(msg->cm_data, data, len);
+
+  nbytes = write(sched->dev->can_fd, msg, msgsize);
+  if (nbytes != msgsize)
+    {
+      return nbytes < 0 ? -errno : -EAGAIN;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: obd_sched_request
+ *
+ * Description:
+ *   Request the due PIDs of a target in one message.  A PID of unknown
+ *   length is always requested alone, its answer could not be split.
+ *
+ ****************************************************************************/
+
+static int obd_sched_request(FAR struct obd_sched_s *sched, int target,
+                             uint32_t now)
+{
+  FAR struct obd_req_s *req = &sched->req[target];
+  FAR struct obd_poll_s *poll;
+  uint8_t data[2 + OBD_SCHED_MAXPIDS];
+  int npids = 0;
+  int i;
+  int j;
+
+  for (i = 0; i < sched->npolls && npids < req->batch; i++)
+    {
+      poll = &sched->polls[i];
+      if (OBD_SCHED_TARGET(poll->ecu) != target || poll->pending ||
+          (int32_t)(now - poll->due) < 0)
+        {
+          continue;
+        }
+
+      if (npids > 0 && obd_sched_pidlen(poll->pid) == 0)
+        {
+          continue;
+        }
+
+      poll->pending = true;
+      poll->due    += poll->period;
+
+      /* Don't try to catch up after a stall */
+
+      if ((int32_t)(now - poll->due) >= 0)
+        {
+          poll->due = now + poll->period;
+        }
+
+      /* The same PID may be polled twice, for different owners */
+
+      for (j = 0; j < npids; j++)
+        {
+          if (data[2 + j] == poll->pid)
+            {
+              break;
+            }
+        }
+
+      req->left++;
+      if (j == npids)
+        {
+          data[2 + npids++] = poll->pid;
+          if (obd_sched_pidlen(poll->pid) == 0)
+            {
+              break;
+            }
+        }
+    }
+
+  if (npids == 0)
+    {
+      return OK;
+    }
+
+  data[0]       = OBD_SINGLE_FRAME | OBD_SF_DATA_LEN((1 + npids));
+  data[1]       = OBD_SHOW_DATA;
+  req->sent     = now;
+  req->npids    = npids;
+  req->active   = true;
+  req->answered = false;
+
+  return obd_sched_write(sched,
+                         target == OBD_SCHED_NECUS ? OBD_ECU_ALL : target,
+                         data, 2 + npids);
+}
+
+/****************************************************************************
+ * Name: obd_sched_expire
+ *
+ * Description:
+ *   Give up the requests not answered in time.  A target that answered
+ *   nothing to several PIDs is asked one PID at a time from then on.
+ *
+ ****************************************************************************/
+
+static void obd_sched_expire(FAR struct obd_sched_s *sched, uint32_t now)
+{
+  FAR struct obd_req_s *req;
+  bool single;
+  int target;
+  int i;
+
+  for (target = 0; target < OBD_SCHED_NTARGETS; target++)
+    {
+      req = &sched->req[target];
+      if (!req->active ||
+          (int32_t)(now - req->sent) < CONFIG_LIBOBD2_SCHED_TIMEOUT)
+        {
+          continue;
+        }
+
+      single = req->npids > 1 && !req->answered;
+      for (i = 0; i < sched->npolls; i++)
+        {
+          if (OBD_SCHED_TARGET(sched->polls[i].ecu) != target ||
+              !sched->polls[i].pending)
+            {
+              continue;
+            }
+
+          sched->polls[i].pending = false;
+          if (single)
+            {
+              sched->polls[i].due = now;
+            }
+        }
+
+      if (single)
+        {
+          req->batch = 1;
+        }
+
+      req->active = false;
+      req->left   = 0;
+    }
+}
+
+/****************************************************************************
+ * Name: obd_sched_value
+ *
+ * Description:
+ *   Report the value of a PID from an ECU and complete the requests that
+ *   waited for it.
+ *
+ ****************************************************************************/
+
+static void obd_sched_value(FAR struct obd_sched_s *sched, uint8_t ecu,
+                            uint8_t pid, FAR const uint8_t *data,
+                            uint8_t len)
+{
+  FAR struct obd_poll_s *poll;
+  FAR struct obd_req_s *req;
+  bool match = false;
+  int i;
+
+  for (i = 0; i < sched->npolls; i++)
+    {
+      poll = &sched->polls[i];
+      if (poll->pid != pid || (poll->ecu != ecu && poll->ecu != OBD_ECU_ALL))
+        {
+          continue;
+        }
+
+      match = true;
+      if (poll->pending)
+        {
+          poll->pending = false;
+          req = &sched->req[OBD_SCHED_TARGET(poll->ecu)];
+          req->answered = true;
+          if (req->left > 0 && --req->left == 0)
+            {
+              req->active = false;
+            }
+        }
+    }
+
+  if (match)
+    {
+      sched->cb(sched->arg, ecu, pid, data, len);
+    }
+}
+
+/****************************************************************************
+ * Name: obd_sched_response
+ *
+ * Description:
+ *   Split a mode 01 response in its PIDs.
+ *
+ ****************************************************************************/
+
+static void obd_sched_response(FAR struct obd_sched_s *sched, uint8_t ecu,
+                               FAR const uint8_t *buf, int len)
+{
+  uint8_t plen;
+  int i = 1;
+
+  if (len < 2 || buf[0] != OBD_SHOW_DATA + OBD_RESP_BASE)
+    {
+      return;
+    }
+
+  while (i + 1 < len)
+    {
+      plen = obd_sched_pidlen(buf[i]);
+      if (plen == 0)
+        {
+          plen = len - i - 1;
+        }
+
+      if (i + 1 + plen > len)
+        {
+          break;
+        }
+
+      obd_sched_value(sched, ecu, buf[i], &buf[i + 1], plen);
+      i += 1 + plen;
+    }
+}
+
+/****************************************************************************
+ * Name: obd_sched_receive
+ *
+ * Description:
+ *   Handle a frame from an ECU, reassembling the multi-frame responses
+ *   that several PIDs need.
+ *
+ ****************************************************************************/
+
+static int obd_sched_receive(FAR struct obd_sched_s *sched,
+                             FAR const struct can_msg_s *msg)
+{
+  static const uint8_t flowctrl[3] =
+  {
+    OBD_FLWCTRL_FRAME, 0, 0 /* Continue, no block size, no delay */
+  };
+
+  FAR const uint8_t *data = msg->cm_data;
+  FAR struct obd_rx_s *rx;
+  uint32_t ecu;
+  int dlc = msg->cm_hdr.ch_dlc;
+  int len;
+
+  if (sched->dev->can_mode == CAN_EXT)
+    {
+      ecu = msg->cm_hdr.ch_id - OBD_PID_EXT_RESPONSE;
+    }
+  else
+    {
+      ecu = msg->cm_hdr.ch_id - OBD_PID_STD_RESPONSE;
+    }
+
+  if (ecu >= OBD_SCHED_NECUS || dlc < 2 || dlc > 8)
+    {
+      return OK;
+    }
+
+  rx = &sched->rx[ecu];
+  switch (OBD_FRAME_TYPE(data[0]))
+    {
+      case OBD_SINGLE_FRAME:
+        len = OBD_SF_DATA_LEN(data[0]);
+        if (len > 0 && len < dlc)
+          {
+            obd_sched_response(sched, ecu, &data[1], len);
+          }
+        break;
+
+      case OBD_FIRST_FRAME:
+        len = OBD_FF_DATA_LEN_D0(data[0]) | OBD_FF_DATA_LEN_D1(data[1]);
+        rx->len = 0;
+        if (dlc < 8 || len < 8 || len > OBD_SCHED_RXSIZE)
+          {
+            break;
+          }
+
+        memcpy(rx->buf, &data[2], 6);
+        rx->len = len;
+        rx->pos = 6;
+        rx->sn  = 1;
+        return obd_sched_write(sched, ecu, flowctrl, sizeof(flowctrl));
+
+      case OBD_CONSEC_FRAME:
+        if (rx->len == 0 || OBD_CF_SEQ_NUM(data[0]) != rx->sn)
+          {
+            rx->len = 0;
+            break;
+          }
+
+        len = rx->len - rx->pos;
+        if (len > dlc - 1)
+          {
+            len = dlc - 1;
+          }
+
+        memcpy(&rx->buf[rx->pos], &data[1], len);
+        rx->pos += len;
+        rx->sn   = (rx->sn + 1) & 0xf;
+        if (rx->pos == rx->len)
+          {
+            rx->len = 0;
+            obd_sched_response(sched, ecu, rx->buf, rx->pos);
+          }
+        break;
+
+      default:
+        break;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: obd_sched_wait
+ *
+ * Description:
+ *   Return the milliseconds until the next request is due or expires.
+ *
+ ****************************************************************************/
+
+static int obd_sched_wait(FAR struct obd_sched_s *sched, uint32_t now)
+{
+  FAR struct obd_poll_s *poll;
+  int32_t wait = INT32_MAX;
+  int32_t delta;
+  int i;
+
+  for (i = 0; i < OBD_SCHED_NTARGETS; i++)
+    {
+      if (sched->req[i].active)
+        {
+          delta = sched->req[i].sent + CONFIG_LIBOBD2_SCHED_TIMEOUT - now;
+          wait  = delta < wait ? delta : wait;
+        }
+    }
+
+  for (i = 0; i < sched->npolls; i++)
+    {
+      poll = &sched->polls[i];
+      if (!poll->pending &&
+          !sched->req[OBD_SCHED_TARGET(poll->ecu)].active)
+        {
+          delta = poll->due - now;
+          wait  = delta < wait ? delta : wait;
+        }
+    }
+
+  return wait < 0 ? 0 : wait;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: obd_sched_init
+ ****************************************************************************/
+
+FAR struct obd_sched_s *obd_sched_init(FAR struct obd_dev_s *dev,
+                                       FAR struct obd_poll_s *polls,
+                                       int npolls, obd_value_t cb,
+                                       FAR void *arg)
+{
+  FAR struct obd_sched_s *sched;
+  uint32_t now;
+  int i;
+
+#ifndef CONFIG_CAN_EXTID
+  if (dev->can_mode == CAN_EXT)
+    {
+      printf("ERROR: Extended mode needs CONFIG_CAN_EXTID!\n");
+      return NULL;
+    }
+#endif
+
+  for (i = 0; i < npolls; i++)
+    {
+      if (polls[i].ecu >= OBD_SCHED_NECUS && polls[i].ecu != OBD_ECU_ALL)
+        {
+          printf("ERROR: Invalid ECU %u for PID %02x!\n",
+                 polls[i].ecu, polls[i].pid);
+          return NULL;
+        }
+    }
+
+  sched = zalloc(sizeof(struct obd_sched_s));
+  if (!sched)
+    {
+      printf("ERROR: Failed to alloc memory for obd_sched!\n");
+      return NULL;
+    }
+
+  sched->dev    = dev;
+  sched->polls  = polls;
+  sched->npolls = npolls;
+  sched->cb     = cb;
+  sched->arg    = arg;
+
+  for (i = 0; i < OBD_SCHED_NTARGETS; i++)
+    {
+      sched->req[i].batch = OBD_SCHED_MAXPIDS;
+    }
+
+  /* Everything is due now */
+
+  now = obd_sched_now();
+  for (i = 0; i < npolls; i++)
+    {
+      polls[i].due     = now;
+      polls[i].pending = false;
+    }
+
+  return sched;
+}
+
+/****************************************************************************
+ * Name: obd_sched_run
+ ****************************************************************************/
+
+int obd_sched_run(FAR struct obd_sched_s *sched, int timeout)
+{
+  struct pollfd pfd;
+  uint32_t start;
+  uint32_t now;
+  int elapsed;
+  int wait;
+  int ret;
+  int i;
+
+  start = obd_sched_now();
+  for (; ; )
+    {
+      now = obd_sched_now();
+      obd_sched_expire(sched, now);
+
+      /* One request in flight per target, to different ECUs at once */
+
+      for (i = 0; i < OBD_SCHED_NTARGETS; i++)
+        {
+          if (!sched->req[i].active)
+            {
+              ret = obd_sched_request(sched, i, now);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+            }
+        }
+
+      wait = obd_sched_wait(sched, now);
+      if (timeout >= 0)
+        {
+          elapsed = now - start;
+          if (elapsed >= timeout)
+            {
+              return OK;
+            }
+
+          wait = wait < timeout - elapsed ? wait : timeout - elapsed;
+        }
+
+      pfd.fd      = sched->dev->can_fd;
+      pfd.events  = POLLIN;
+      pfd.revents = 0;
+
+      ret = poll(&pfd, 1, wait == INT32_MAX ? -1 : wait);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      if (ret == 0)
+        {
+          continue;
+        }
+
+      ret = read(sched->dev->can_fd, &sched->dev->can_rxmsg,
+                 sizeof(struct can_msg_s));
+      if (ret < CAN_MSGLEN(0))
+        {
+          return ret < 0 ? -errno : -EIO;
+        }
+
+      ret = obd_sched_receive(sched, &sched->dev->can_rxmsg);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: obd_sched_free
+ ****************************************************************************/
+
+void obd_sched_free(FAR struct obd_sched_s *sched)
+{
+  free(sched);
+}
@@ -24,6 +24,7 @@
 
 #include <nuttx/config.h>
 
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -58,6 +59,22 @@
 #define DEFAULT_PRIORITY 100
 #define DEFAULT_STACK_SIZE 2048
 
+/* Longest command: D, 29 bit id, DLC, 64 data bytes */
+
+#define SLCAN_LINE_MAX     (1 + 8 + 1 + 2 * 64)
+
+#define SLCAN_RXBUFSIZE    CONFIG_CANUTILS_SLCAN_RXBUFSIZE
+#define SLCAN_TXBUFSIZE    CONFIG_CANUTILS_SLCAN_TXBUFSIZE
+#define SLCAN_BATCH        CONFIG_CANUTILS_SLCAN_BATCH
+
+#if SLCAN_RXBUFSIZE <= SLCAN_LINE_MAX
+#  error CONFIG_CANUTILS_SLCAN_RXBUFSIZE is too small for a CAN FD frame
+#endif
+
+#if SLCAN_TXBUFSIZE <= SLCAN_LINE_MAX
+#  error CONFIG_CANUTILS_SLCAN_TXBUFSIZE is too small for a CAN FD frame
+#endif
+
 #ifdef CONFIG_SLCAN_TRACE
 #  define DEBUG 1
 #else
@@ -72,6 +89,36 @@
     } \
   while (0)
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct slcan_s
+{
+  int fd;                         /* UART slcan channel */
+  int s;                          /* CAN socket */
+  int mode;                       /* 0: closed, 1: open, 100: exit */
+  FAR const char *candev;
+
+  /* Frames in each direction and frames lost since the last stats
+   * command, drops since the last status flags command.
+   */
+
+  uint32_t rxframes;              /* CAN to serial */
+  uint32_t txframes;              /* Serial to CAN */
+  uint32_t rxdrops;
+  uint32_t txdrops;
+  uint8_t flags;                  /* SLCAN_* status flags */
+  struct timespec since;
+
+  /* Serial input not parsed yet and serial output not written yet */
+
+  size_t rxlen;
+  size_t txlen;
+  char rxbuf[SLCAN_RXBUFSIZE];
+  char txbuf[SLCAN_TXBUFSIZE];
+};
+
 /****************************************************************************
  * private data
  ****************************************************************************/
@@ -82,91 +129,580 @@ static char opening[] = "starting slcan\n";
 static char opening[] = "";
 #endif
 
-static void ok_return(int fd)
+
+static const char g_hex[] = "0123456789ABCDEF";
+
+static const uint8_t g_dlc2len[16] =
+{
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Write the serial output, the frames it holds are lost on error */
+
+static void slcan_flush(FAR struct slcan_s *priv, int frames)
+{
+  size_t pos = 0;
+  ssize_t n;
+
+  while (pos < priv->txlen)
+    {
+      n = write(priv->fd, &priv->txbuf[pos], priv->txlen - pos);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          syslog(LOG_ERR, "serial write error %d\n", errno);
+          priv->rxdrops += frames;
+          priv->flags   |= SLCAN_DATA_OVERRUN;
+          break;
+        }
+
+      pos += n;
+    }
+
+  priv->txlen = 0;
+}
+
+/* Queue serial output, written when the buffer is full or when all
+ * input available was handled.
+ */
+
+static void slcan_put(FAR struct slcan_s *priv, FAR const char *data,
+                      size_t len)
 {
-  write(fd, "\r", 1);
+  if (priv->txlen + len > SLCAN_TXBUFSIZE)
+    {
+      slcan_flush(priv, 0);
+    }
+
+  memcpy(&priv->txbuf[priv->txlen], data, len);
+  priv->txlen += len;
 }
 
-static void fail_return(int fd)
+static void ok_return(FAR struct slcan_s *priv)
 {
-  write(fd, "\a", 1); /* BELL return for error */
+  slcan_put(priv, "\r", 1);
 }
 
-static int readlinebuffer(int fd, char *buf, int maxlen)
+static void fail_return(FAR struct slcan_s *priv)
 {
-  size_t n;
-  int meslen = 0;
-  int noeol  = 1;
-  uint8_t ch;
+  slcan_put(priv, "\a", 1); /* BELL return for error */
+}
 
-  while ((meslen < maxlen) && noeol)
+static int slcan_hex(FAR const char *str, int digits, FAR uint32_t *val)
+{
+  int c;
+
+  *val = 0;
+  while (digits-- > 0)
     {
-      n = read(fd, &ch, 1);
-      if (n > 0)
+      c = tolower(*str++);
+      if (c >= '0' && c <= '9')
+        {
+          c -= '0';
+        }
+      else if (c >= 'a' && c <= 'f')
+        {
+          c -= 'a' - 10;
+        }
+      else
         {
-          /* valid input */
+          return -1;
+        }
+
+      *val = (*val << 4) | c;
+    }
+
+  return 0;
+}
 
-          if (ch == '\r')
+/* tiiiL / TiiiiiiiiL [dd]* for CAN 2.0 data frames, r / R for remote
+ * frames, d / D and b / B (bit rate switch) for CAN FD frames where L is
+ * the DLC code.
+ */
+
+static size_t slcan_frame2line(FAR const struct canfd_frame *frame,
+                               int mtu, FAR char *line)
+{
+  canid_t id = frame->can_id;
+  char type = (id & CAN_RTR_FLAG) ? 'r' : 't';
+  int dlc = frame->len;
+  size_t n = 0;
+  int idlen;
+  int i;
+
+#ifdef CONFIG_NET_CAN_CANFD
+  if (mtu == CANFD_MTU)
+    {
+      type = (frame->flags & CANFD_BRS) ? 'b' : 'd';
+      dlc  = 0;
+      while (dlc < 15 && g_dlc2len[dlc] < frame->len)
+        {
+          dlc++;
+        }
+    }
+#endif
+
+  if (id & CAN_EFF_FLAG)
+    {
+      type  = toupper(type);
+      id   &= CAN_EFF_MASK;
+      idlen = 8;
+    }
+  else
+    {
+      id   &= CAN_SFF_MASK;
+      idlen = 3;
+    }
+
+  line[n++] = type;
+  for (i = idlen - 1; i >= 0; i--)
+    {
+      line[n++] = g_hex[(id >> (4 * i)) & 0xf];
+    }
+
+  line[n++] = g_hex[dlc & 0xf];
+
+  if (!(frame->can_id & CAN_RTR_FLAG))
+    {
+      for (i = 0; i < frame->len; i++)
+        {
+          line[n++] = g_hex[frame->data[i] >> 4];
+          line[n++] = g_hex[frame->data[i] & 0xf];
+        }
+    }
+
+  line[n++] = '\r';
+  return n;
+}
+
+/* Parse a transmit command, returns the MTU of the frame or -1 */
+
+static int slcan_line2frame(FAR const char *line, size_t len,
+                            FAR struct canfd_frame *frame)
+{
+  int idlen = isupper(line[0]) ? 8 : 3;
+  int type = tolower(line[0]);
+  int mtu = CAN_MTU;
+  uint32_t val;
+  size_t pos;
+  int i;
+
+  memset(frame, 0, sizeof(*frame));
+
+  switch (type)
+    {
+    case 't':
+    case 'r':
+      break;
+#ifdef CONFIG_NET_CAN_CANFD
+    case 'b':
+      frame->flags = CANFD_BRS;
+
+      /* Fall through */
+
+    case 'd':
+      mtu = CANFD_MTU;
+      break;
+#endif
+    default:
+      return -1;
+    }
+
+  if (len < (size_t)(2 + idlen) || slcan_hex(&line[1], idlen, &val) < 0)
+    {
+      return -1;
+    }
+
+  frame->can_id = val;
+  if (idlen == 8)
+    {
+      frame->can_id = (val & CAN_EFF_MASK) | CAN_EFF_FLAG;
+    }
+  else
+    {
+      frame->can_id = val & CAN_SFF_MASK;
+    }
+
+  if (type == 'r')
+    {
+      frame->can_id |= CAN_RTR_FLAG;
+    }
+
+  /* DLC code, the data length for CAN FD */
+
+  pos = 1 + idlen;
+  if (slcan_hex(&line[pos++], 1, &val) < 0 ||
+      (mtu == CAN_MTU && val > CAN_MAX_DLEN))
+    {
+      return -1;
+    }
+
+  frame->len = g_dlc2len[val];
+
+  if (type != 'r')
+    {
+      if (len < pos + 2 * frame->len)
+        {
+          return -1;
+        }
+
+      for (i = 0; i < frame->len; i++, pos += 2)
+        {
+          if (slcan_hex(&line[pos], 2, &val) < 0)
             {
-              noeol = 0;
-              *buf  = '\0';
+              return -1;
             }
-          else
+
+          frame->data[i] = val;
+        }
+    }
+
+  return mtu;
+}
+
+/* Status flags, drops are reported once */
+
+static void slcan_flags(FAR struct slcan_s *priv)
+{
+  char sbuf[8];
+
+  snprintf(sbuf, sizeof(sbuf), "F%02X\r", priv->flags);
+  slcan_put(priv, sbuf, 4);
+  priv->flags = 0;
+}
+
+/* Frames/s in each direction and drops since the last stats command:
+ * X<CAN to serial> <serial to CAN> <CAN to serial drops> <serial to CAN
+ * drops>
+ */
+
+static void slcan_stats(FAR struct slcan_s *priv)
+{
+  struct timespec now;
+  char sbuf[64];
+  uint64_t ms;
+  int n;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  ms = (uint64_t)(now.tv_sec - priv->since.tv_sec) * 1000 +
+       (now.tv_nsec - priv->since.tv_nsec) / 1000000;
+  if (ms == 0)
+    {
+      ms = 1;
+    }
+
+  n = snprintf(sbuf, sizeof(sbuf), "X%" PRIu32 " %" PRIu32 " %" PRIu32
+               " %" PRIu32 "\r",
+               (uint32_t)(priv->rxframes * 1000ull / ms),
+               (uint32_t)(priv->txframes * 1000ull / ms),
+               priv->rxdrops, priv->txdrops);
+  slcan_put(priv, sbuf, n);
+
+  priv->rxframes = 0;
+  priv->txframes = 0;
+  priv->rxdrops  = 0;
+  priv->txdrops  = 0;
+  priv->since    = now;
+}
+
+static void slcan_speed(FAR struct slcan_s *priv, char code)
+{
+  int canspeed = 1000000; /* default to 1MBps */
+  struct ifreq ifr;
+
+  switch (code)
+    {
+    case '0':
+      canspeed = 10000;
+      break;
+    case '1':
+      canspeed = 20000;
+      break;
+    case '2':
+      canspeed = 50000;
+      break;
+    case '3':
+      canspeed = 100000;
+      break;
+    case '4':
+      canspeed = 125000;
+      break;
+    case '5':
+      canspeed = 250000;
+      break;
+    case '6':
+      canspeed = 500000;
+      break;
+    case '7':
+      canspeed = 800000;
+      break;
+    case '8': /* set speed to 1Mbps */
+      canspeed = 1000000;
+      break;
+    default:
+      break;
+    }
+
+  /* set the device name */
+
+  strlcpy(ifr.ifr_name, priv->candev, IFNAMSIZ);
+
+  ifr.ifr_ifru.ifru_can_data.arbi_bitrate =
+    canspeed / 1000; /* Convert bit/s to kbit/s */
+  ifr.ifr_ifru.ifru_can_data.arbi_samplep = 80;
+
+  if (ioctl(priv->s, SIOCSCANBITRATE, &ifr) < 0)
+    {
+      syslog(LOG_ERR, "set speed %d failed\n", canspeed);
+      fail_return(priv);
+    }
+  else
+    {
+      debug_print("set speed %d\n", canspeed);
+      ok_return(priv);
+    }
+}
+
+/* Handle one command line received on the serial port */
+
+static void slcan_command(FAR struct slcan_s *priv, FAR char *buf,
+                          size_t n)
+{
+  struct canfd_frame frame;
+  int mtu;
+
+  if (n == 0)
+    {
+      return;
+    }
+
+  if (buf[0] == 'F')
+    {
+      /* return status flags */
+
+      slcan_flags(priv);
+      return;
+    }
+  else if (buf[0] == 'X')
+    {
+      /* return statistics */
+
+      slcan_stats(priv);
+      return;
+    }
+
+  switch (priv->mode)
+    {
+    case 0: /* CAN channel not open */
+      if (buf[0] == 'O')
+        {
+          /* open CAN interface */
+
+          priv->mode = 1;
+          debug_print("Open interface\n");
+          ok_return(priv);
+        }
+      else if (buf[0] == 'S')
+        {
+          /* set CAN interface speed */
+
+          slcan_speed(priv, buf[1]);
+        }
+      else
+        {
+          /* whatever */
+
+          ok_return(priv);
+        }
+      break;
+    case 1: /* CAN task running open interface */
+      if (buf[0] == 'C')
+        {
+          /* close interface */
+
+          priv->mode = 0;
+          debug_print("Close interface\n");
+          ok_return(priv);
+        }
+      else if (strchr("tTrRdDbB", buf[0]) != NULL)
+        {
+          /* Transmit a CAN or CAN FD frame */
+
+          mtu = slcan_line2frame(buf, n, &frame);
+          if (mtu < 0)
             {
-              *buf++ = ch;
-              meslen++;
+              fail_return(priv);
+              break;
             }
+
+          debug_print("Transmitt: 0x%" PRIx32 " len %d\n",
+                      frame.can_id, frame.len);
+
+          if (write(priv->s, &frame, mtu) != mtu)
+            {
+              syslog(LOG_ERR, "transmitt error\n");
+              priv->txdrops++;
+              priv->flags |= SLCAN_SND_FIFO_FULL;
+              fail_return(priv);
+              break;
+            }
+
+          priv->txframes++;
+          ok_return(priv);
         }
       else
         {
-          return (meslen);
+          /* whatever */
+
+          ok_return(priv);
+        }
+      break;
+    default: /* should not happen */
+      priv->mode = 100;
+      break;
+    }
+}
+
+/* Read what the serial port has and handle all of the complete lines */
+
+static void slcan_serialrecv(FAR struct slcan_s *priv)
+{
+  FAR char *eol;
+  size_t pos = 0;
+  ssize_t n;
+
+  n = read(priv->fd, &priv->rxbuf[priv->rxlen],
+           SLCAN_RXBUFSIZE - priv->rxlen);
+  if (n <= 0)
+    {
+      return;
+    }
+
+  priv->rxlen += n;
+
+  while ((eol = memchr(&priv->rxbuf[pos], '\r', priv->rxlen - pos)) != NULL)
+    {
+      *eol = '\0';
+      slcan_command(priv, &priv->rxbuf[pos], eol - &priv->rxbuf[pos]);
+      pos = eol - priv->rxbuf + 1;
+    }
+
+  if (pos == 0 && priv->rxlen == SLCAN_RXBUFSIZE)
+    {
+      /* No command is that long */
+
+      syslog(LOG_ERR, "line too long\n");
+      fail_return(priv);
+      priv->rxlen = 0;
+    }
+  else
+    {
+      /* Keep the start of the next line */
+
+      priv->rxlen -= pos;
+      memmove(priv->rxbuf, &priv->rxbuf[pos], priv->rxlen);
+    }
+}
+
+/* Forward the frames waiting in the CAN socket to the serial port */
+
+static void slcan_canrecv(FAR struct slcan_s *priv)
+{
+  struct canfd_frame frame;
+  char line[SLCAN_LINE_MAX + 1];
+  int frames = 0;
+  int nbytes;
+
+  while (frames < SLCAN_BATCH)
+    {
+      nbytes = recv(priv->s, &frame, sizeof(frame), MSG_DONTWAIT);
+      if (nbytes < 0)
+        {
+          break;
+        }
+
+      if ((nbytes != CAN_MTU && nbytes != CANFD_MTU) ||
+          (frame.can_id & CAN_ERR_FLAG))
+        {
+          continue;
         }
+
+      priv->rxframes++;
+      debug_print("R%" PRIu32 ", Id:0x%" PRIx32 "\n",
+                  priv->rxframes, frame.can_id);
+
+      if (priv->txlen + SLCAN_LINE_MAX + 1 > SLCAN_TXBUFSIZE)
+        {
+          slcan_flush(priv, frames);
+          frames = 0;
+        }
+
+      slcan_put(priv, line, slcan_frame2line(&frame, nbytes, line));
+      frames++;
     }
-  return (meslen);
+
+  slcan_flush(priv, frames);
 }
 
-static int caninit(char *candev, int *s, struct sockaddr_can *addr,
-                   char *ctrlmsg, struct canfd_frame *frame,
-                   struct msghdr *msg, struct iovec *iov)
+static int caninit(FAR const char *candev)
 {
+  struct sockaddr_can addr;
   struct ifreq ifr;
+  int s;
+#ifdef CONFIG_NET_CAN_CANFD
+  const int canfd_on = 1;
+#endif
 
   debug_print("slcanBus\n");
-  if ((*s = socket(PF_CAN, SOCK_RAW, CAN_RAW)) < 0)
+  if ((s = socket(PF_CAN, SOCK_RAW, CAN_RAW)) < 0)
     {
       syslog(LOG_ERR, "Error opening CAN socket\n");
       return -1;
     }
+
   strncpy(ifr.ifr_name, candev, 4);
   ifr.ifr_name[4] = '\0';
   ifr.ifr_ifindex = if_nametoindex(ifr.ifr_name);
   if (!ifr.ifr_ifindex)
     {
       syslog(LOG_ERR, "error finding index %s\n", candev);
+      close(s);
       return -1;
     }
-  memset(addr, 0, sizeof(struct sockaddr));
-  addr->can_family  = AF_CAN;
-  addr->can_ifindex = ifr.ifr_ifindex;
-  setsockopt(*s, SOL_CAN_RAW, CAN_RAW_FILTER, NULL, 0);
 
-  if (bind(*s, (struct sockaddr *)addr, sizeof(struct sockaddr)) < 0)
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family  = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  setsockopt(s, SOL_CAN_RAW, CAN_RAW_FILTER, NULL, 0);
+
+#ifdef CONFIG_NET_CAN_CANFD
+  if (setsockopt(s, SOL_CAN_RAW, CAN_RAW_FD_FRAMES,
+                 &canfd_on, sizeof(canfd_on)) < 0)
+    {
+      syslog(LOG_ERR, "CAN FD frames not supported\n");
+    }
+#endif
+
+  if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) < 0)
     {
       syslog(LOG_ERR, "bind error\n");
+      close(s);
       return -1;
     }
 
-  iov->iov_base    = frame;
-  msg->msg_name    = addr;
-  msg->msg_iov     = iov;
-  msg->msg_iovlen  = 1;
-  msg->msg_control = ctrlmsg;
-
   /* CAN interface ready to be used */
 
   debug_print("CAN socket open\n");
 
-  return 0;
+  return s;
 }
 
 /****************************************************************************
@@ -179,30 +715,9 @@ static int caninit(char *candev, int *s, struct sockaddr_can *addr,
 
 int main(int argc, char *argv[])
 {
-  /* UART */
-
-  char buf[31];
-  int mode = 0;
-  size_t n;
-  int canspeed = 1000000; /* default to 1MBps */
-  int fd;                 /* UART slcan channel */
-
-  /* CAN */
-
-  int s;
-  int nbytes;
-  int i;
-  int ret;
-  int reccount = 0;
-  struct sockaddr_can addr;
-  struct canfd_frame frame;
-  struct msghdr msg;
-  struct iovec iov;
+  FAR struct slcan_s *priv;
   fd_set rdfs;
-  char ctrlmsg[CMSG_SPACE(sizeof(struct timeval) +
-                          3 * sizeof(struct timespec) + sizeof(int))];
-  char sbuf[40];
-  char *sbp;
+  int maxfd;
 
   if (argc != 3)
     {
@@ -214,301 +729,75 @@ int main(int argc, char *argv[])
   char *chrdev = argv[2];
   char *candev = argv[1];
 
+  priv = zalloc(sizeof(struct slcan_s));
+  if (priv == NULL)
+    {
+      syslog(LOG_ERR, "Out of memory\n");
+      return -1;
+    }
+
+  priv->candev = candev;
+  clock_gettime(CLOCK_MONOTONIC, &priv->since);
+
   debug_print("Starting slcan on NuttX\n");
-  fd = open(chrdev, O_RDWR);
-  if (fd < 0)
+  priv->fd = open(chrdev, O_RDWR);
+  if (priv->fd < 0)
     {
       syslog(LOG_ERR, "Failed to open serial channel %s\n", chrdev);
+      free(priv);
       return -1;
     }
-  else
+
+  /* Create CAN socket */
+
+  priv->s = caninit(candev);
+  if (priv->s < 0)
     {
-      /* Create CAN socket */
+      syslog(LOG_ERR, "Failed to open CAN socket %s\n", candev);
+      close(priv->fd);
+      free(priv);
+      return -1;
+    }
 
-      if (caninit(candev, &s, &addr, &ctrlmsg[0], &frame, &msg, &iov) < 0)
-        {
-          syslog(LOG_ERR, "Failed to open CAN socket %s\n", candev);
-          close(fd);
-          return -1;
-        }
+  /* serial interface active */
 
-      /* serial interface active */
+  debug_print("Serial interface open %s\n", chrdev);
+  write(priv->fd, opening, (sizeof(opening) - 1));
 
-      debug_print("Serial interface open %s\n", chrdev);
-      write(fd, opening, (sizeof(opening) - 1));
+  maxfd = priv->s > priv->fd ? priv->s : priv->fd;
 
-      while (mode < 100)
-        {
-          /* Setup ooll */
+  while (priv->mode < 100)
+    {
+      /* Setup poll */
 
-          FD_ZERO(&rdfs);
-          FD_SET(s, &rdfs);  /* CAN Socket */
-          FD_SET(fd, &rdfs); /* UART */
+      FD_ZERO(&rdfs);
+      FD_SET(priv->s, &rdfs);  /* CAN Socket */
+      FD_SET(priv->fd, &rdfs); /* UART */
 
-          if ((ret = select(s + 1, &rdfs, NULL, NULL, NULL)) <= 0)
-            {
-              continue;
-            }
+      if (select(maxfd + 1, &rdfs, NULL, NULL, NULL) <= 0)
+        {
+          continue;
+        }
 
-          if (FD_ISSET(s, &rdfs))
-            {
-              /* CAN received new message in socketCAN input */
-
-              iov.iov_len        = sizeof(frame);
-              msg.msg_namelen    = sizeof(addr);
-              msg.msg_controllen = sizeof(ctrlmsg);
-              msg.msg_flags      = 0;
-              nbytes             = recvmsg(s, &msg, 0);
-
-              if (nbytes == CAN_MTU)
-                {
-                  reccount++;
-                  debug_print("R%d, Id:0x%" PRIx32 "\n",
-                              reccount, frame.can_id);
-                  if (frame.can_id & CAN_EFF_FLAG)
-                    {
-                      /* 29 bit address */
-
-                      frame.can_id = frame.can_id & ~CAN_EFF_FLAG;
-                      snprintf(sbuf, sizeof(sbuf), "T%08" PRIx32 "%d",
-                               frame.can_id, frame.len);
-                      sbp = &sbuf[10];
-                    }
-                  else
-                    {
-                      /* 11 bit address */
-
-                      snprintf(sbuf, sizeof(sbuf), "t%03" PRIx32 "%d",
-                               frame.can_id, frame.len);
-                      sbp = &sbuf[5];
-                    }
-
-                  for (i = 0; i < frame.len; i++)
-                    {
-                      snprintf(sbp, sizeof(sbuf) - (sbp - sbuf),
-                               "%02X", frame.data[i]);
-                      sbp += 2;
-                    }
-
-                  *sbp++ = '\r';
-                  *sbp   = '\0';
-                  write(fd, sbuf, strlen(sbuf));
-                }
-            }
+      if (FD_ISSET(priv->s, &rdfs))
+        {
+          /* CAN received new messages in socketCAN input */
 
-          if (FD_ISSET(fd, &rdfs))
-            {
-              /* UART receive */
-
-              n = readlinebuffer(fd, buf, 30);
-
-              switch (mode)
-                {
-                case 0: /* CAN channel not open */
-                  if (n > 0)
-                    {
-                      if (buf[0] == 'F')
-                        {
-                          /* return clear flags */
-
-                          write(fd, "F00\r", 4);
-                        }
-                      else if (buf[0] == 'O')
-                        {
-                          /* open CAN interface */
-
-                          mode = 1;
-                          debug_print("Open interface\n");
-                          ok_return(fd);
-                        }
-                      else if (buf[0] == 'S')
-                        {
-                          /* set CAN interface speed */
-
-                          switch (buf[1])
-                            {
-                            case '0':
-                              canspeed = 10000;
-                              break;
-                            case '1':
-                              canspeed = 20000;
-                              break;
-                            case '2':
-                              canspeed = 50000;
-                              break;
-                            case '3':
-                              canspeed = 100000;
-                              break;
-                            case '4':
-                              canspeed = 125000;
-                              break;
-                            case '5':
-                              canspeed = 250000;
-                              break;
-                            case '6':
-                              canspeed = 500000;
-                              break;
-                            case '7':
-                              canspeed = 800000;
-                              break;
-                            case '8': /* set speed to 1Mbps */
-                              canspeed = 1000000;
-                              break;
-                            default:
-                              break;
-                            }
-
-                          struct ifreq ifr;
-
-                          /* set the device name */
-
-                          strlcpy(ifr.ifr_name, argv[1], IFNAMSIZ);
-
-                          ifr.ifr_ifru.ifru_can_data.arbi_bitrate =
-                            canspeed / 1000; /* Convert bit/s to kbit/s */
-                          ifr.ifr_ifru.ifru_can_data.arbi_samplep = 80;
-
-                          if (ioctl(s, SIOCSCANBITRATE, &ifr) < 0)
-                            {
-                              syslog(LOG_ERR, "set speed %d failed\n",
-                                     canspeed);
-                              fail_return(fd);
-                            }
-                          else
-                            {
-                              debug_print("set speed %d\n", canspeed);
-                              ok_return(fd);
-                            }
-                        }
-                      else
-                        {
-                          /* whatever */
-
-                          ok_return(fd);
-                        }
-                    }
-                  break;
-                case 1: /* CAN task running open interface */
-                  if (n > 0)
-                    {
-                      if (buf[0] == 'C')
-                        {
-                          /* close interface */
-
-                          mode = 0;
-                          debug_print("Close interface\n");
-                          ok_return(fd);
-                        }
-                      else if (buf[0] == 'T')
-                        {
-                          /* Transmit an extended 29 bit CAN frame */
-
-                          char tbuf[9];
-                          int idval;
-                          int val;
-
-                          /* get 29bit CAN ID */
-
-                          strncpy(tbuf, &buf[1], 8);
-                          tbuf[8] = '\0';
-                          sscanf(tbuf, "%x", &idval);
-
-                          frame.len = buf[9] - '0'; /* get byte count */
-
-                          /* get canmessage */
-
-                          for (i = 0; i < frame.len; i++)
-                            {
-                              tbuf[0] = buf[10 + (2 * i)];
-                              tbuf[1] = buf[11 + (2 * i)];
-                              tbuf[2] = '\0';
-                              sscanf(tbuf, "%x", &val);
-                              frame.data[i] = val & 0xff;
-                            }
-
-                          debug_print("Transmitt: 0x%X ", idval);
-                          for (i = 0; i < frame.len; i++)
-                            {
-                              debug_print("0x%02X ", frame.data[i]);
-                            }
-
-                          debug_print("\n");
-
-                          frame.can_id = idval | CAN_EFF_FLAG; /* 29 bit */
-
-                          if (write(s, &frame, CAN_MTU) != CAN_MTU)
-                            {
-                              syslog(LOG_ERR, "transmitt error\n");
-
-                              /* TODO update error flags */
-                            }
-
-                          ok_return(fd);
-                        }
-                      else if (buf[0] == 't')
-                        {
-                          /* Transmit an 11 bit CAN frame */
-
-                          char tbuf[9];
-                          int idval;
-                          int val;
-
-                          /* get 11bit CAN ID */
-
-                          strncpy(tbuf, &buf[1], 3);
-                          tbuf[3] = '\0';
-                          sscanf(tbuf, "%x", &idval);
-
-                          frame.len = buf[4] - '0'; /* get byte count */
-
-                          /* get canmessage */
-
-                          for (i = 0; i < frame.len; i++)
-                            {
-                              tbuf[0] = buf[5 + (2 * i)];
-                              tbuf[1] = buf[6 + (2 * i)];
-                              tbuf[2] = '\0';
-                              sscanf(tbuf, "%x", &val);
-                              frame.data[i] = val & 0xff;
-                            }
-
-                          debug_print("Transmitt: 0x%X ", idval);
-                          for (i = 0; i < frame.len; i++)
-                            {
-                              debug_print("0x%02X ", frame.data[i]);
-                            }
-
-                          debug_print("\n");
-
-                          frame.can_id = idval; /* 11 bit address command */
-
-                          if (write(s, &frame, CAN_MTU) != CAN_MTU)
-                            {
-                              syslog(LOG_ERR, "transmitt error\n");
-
-                              /* TODO update error flags */
-                            }
-
-                          ok_return(fd);
-                        }
-                      else
-                        {
-                          /* whatever */
-
-                          ok_return(fd);
-                        }
-                    }
-                  break;
-                default: /* should not happen */
-                  mode = 100;
-                  break;
-                }
-            }
+          slcan_canrecv(priv);
         }
 
-      close(fd);
-      close(s);
+      if (FD_ISSET(priv->fd, &rdfs))
+        {
+          /* UART receive, the answers are written together */
+
+          slcan_serialrecv(priv);
+          slcan_flush(priv, 0);
+        }
     }
 
+  close(priv->fd);
+  close(priv->s);
+  free(priv);
+
   return 0;
 }
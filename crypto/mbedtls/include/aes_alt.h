@@ -36,6 +36,7 @@ typedef struct mbedtls_aes_context
 {
   cryptodev_context_t dev;
   unsigned char key[MAX_KEY_SIZE];
+  int cipher;                      /* Cipher of the open session, or 0 */
 }
 mbedtls_aes_context;
 
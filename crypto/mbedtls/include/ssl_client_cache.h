@@ -0,0 +1,102 @@
+/****************************************************************************
+ * apps/crypto/mbedtls/include/ssl_client_cache.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ ****************************************************************************/
+
+
+#ifndef __APPS_CRYPTO_MBEDTLS_INCLUDE_SSL_CLIENT_CACHE_H
+#define __APPS_CRYPTO_MBEDTLS_INCLUDE_SSL_CLIENT_CACHE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include "mbedtls/ssl.h"
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* A process wide cache of TLS client sessions, keyed by server, so that
+ * all of the clients of a process (webclient TLS ops, MQTT-C, ...) resume
+ * the sessions of each other instead of doing a full handshake.
+ *
+ * Usage, around the handshake of a client connection:
+ *
+ *   mbedtls_ssl_setup(&ssl, &conf);
+ *   ssl_client_cache_set(&ssl, host, port);
+ *   mbedtls_ssl_handshake(&ssl);
+ *   ssl_client_cache_save(&ssl, host, port);
+ *
+ * With TLS 1.3 the ticket arrives after the handshake, so save the session
+ * again before closing the connection.
+ */
+
+/****************************************************************************
+ * Name: ssl_client_cache_set
+ *
+ * Description:
+ *   Offer the cached session of the server, if any, for resumption by the
+ *   next handshake of ssl.  The server may refuse it, in which case the
+ *   handshake is a full one.
+ *
+ * Returned Value:
+ *   Zero if a session was offered, MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND
+ *   if none is cached, another mbedtls error code on failure.
+ *
+ ****************************************************************************/
+
+int ssl_client_cache_set(FAR mbedtls_ssl_context *ssl,
+                         FAR const char *host, FAR const char *port);
+
+/****************************************************************************
+ * Name: ssl_client_cache_save
+ *
+ * Description:
+ *   Save the session of the established connection ssl, replacing the
+ *   session cached for the server or the least recently used one.
+ *
+ * Returned Value:
+ *   Zero on success, an mbedtls error code on failure.
+ *
+ ****************************************************************************/
+
+int ssl_client_cache_save(FAR mbedtls_ssl_context *ssl,
+                          FAR const char *host, FAR const char *port);
+
+/****************************************************************************
+ * Name: ssl_client_cache_remove
+ *
+ * Description:
+ *   Forget the session of a server, e.g. after its certificate changed.
+ *
+ ****************************************************************************/
+
+void ssl_client_cache_remove(FAR const char *host, FAR const char *port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_CRYPTO_MBEDTLS_INCLUDE_SSL_CLIENT_CACHE_H */
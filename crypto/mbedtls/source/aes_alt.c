@@ -33,6 +33,58 @@
 #define ECB_BLOCK_SIZE    16
 #define NONCE_LENGTH      4
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aes_alt_close
+ *
+ * Description:
+ *   Release the session kept open by the previous operation, if any.
+ *
+ ****************************************************************************/
+
+static void aes_alt_close(FAR mbedtls_aes_context *ctx)
+{
+  if (ctx->cipher != 0)
+    {
+      cryptodev_free_session(&ctx->dev);
+      ctx->cipher = 0;
+    }
+}
+
+/****************************************************************************
+ * Name: aes_alt_session
+ *
+ * Description:
+ *   Get a session for the cipher and the current key.  The session stays
+ *   open until the key or the mode changes: GCM, CCM and CMAC encrypt one
+ *   ECB block at a time and a TLS record is many blocks, so opening and
+ *   closing a session for each block would cost more than the cipher.
+ *
+ ****************************************************************************/
+
+static int aes_alt_session(FAR mbedtls_aes_context *ctx, int cipher)
+{
+  int ret;
+
+  if (ctx->cipher == cipher)
+    {
+      return 0;
+    }
+
+  aes_alt_close(ctx);
+  ctx->dev.session.cipher = cipher;
+  ret = cryptodev_get_session(&ctx->dev);
+  if (ret == 0)
+    {
+      ctx->cipher = cipher;
+    }
+
+  return ret;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -40,10 +92,12 @@
 void mbedtls_aes_init(FAR mbedtls_aes_context *ctx)
 {
   cryptodev_init(&ctx->dev);
+  ctx->cipher = 0;
 }
 
 void mbedtls_aes_free(FAR mbedtls_aes_context *ctx)
 {
+  aes_alt_close(ctx);
   cryptodev_free(&ctx->dev);
 }
 
@@ -51,6 +105,7 @@ int mbedtls_aes_setkey_enc(FAR mbedtls_aes_context *ctx,
                            FAR const unsigned char *key,
                            unsigned int keybits)
 {
+  aes_alt_close(ctx);
   memcpy(ctx->key, key, keybits / 8);
   ctx->dev.session.key = (caddr_t)ctx->key;
   ctx->dev.session.keylen = keybits / 8;
@@ -74,8 +129,7 @@ int mbedtls_aes_crypt_ecb(FAR mbedtls_aes_context *ctx,
   int ret;
   unsigned char iv[16];
 
-  ctx->dev.session.cipher = CRYPTO_AES_CBC;
-  ret = cryptodev_get_session(&ctx->dev);
+  ret = aes_alt_session(ctx, CRYPTO_AES_CBC);
   if (ret != 0)
     {
       return ret;
@@ -90,7 +144,6 @@ int mbedtls_aes_crypt_ecb(FAR mbedtls_aes_context *ctx,
   ctx->dev.crypt.dst = (caddr_t)output;
   ctx->dev.crypt.iv = (caddr_t)iv;
   ret = cryptodev_crypt(&ctx->dev);
-  cryptodev_free_session(&ctx->dev);
   return ret;
 }
 
@@ -107,8 +160,7 @@ int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
 {
   int ret;
 
-  ctx->dev.session.cipher = CRYPTO_AES_CBC;
-  ret = cryptodev_get_session(&ctx->dev);
+  ret = aes_alt_session(ctx, CRYPTO_AES_CBC);
   if (ret != 0)
     {
       return ret;
@@ -122,7 +174,6 @@ int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
   ctx->dev.crypt.dst = (caddr_t)output;
   ctx->dev.crypt.iv = (caddr_t)iv;
   ret = cryptodev_crypt(&ctx->dev);
-  cryptodev_free_session(&ctx->dev);
   return ret;
 }
 #endif /* MBEDTLS_CIPHER_MODE_CBC */
@@ -141,6 +192,7 @@ int mbedtls_aes_crypt_ctr(FAR mbedtls_aes_context *ctx,
 {
   int ret;
 
+  aes_alt_close(ctx);
   ctx->dev.session.cipher = CRYPTO_AES_CTR;
   memcpy(ctx->key + ctx->dev.session.keylen,
          nonce_counter, NONCE_LENGTH);
@@ -203,8 +255,7 @@ int mbedtls_aes_crypt_xts(FAR mbedtls_aes_xts_context *ctx,
   int ret;
   unsigned char iv[16];
 
-  ctx->dev.session.cipher = CRYPTO_AES_XTS;
-  ret = cryptodev_get_session(&ctx->dev);
+  ret = aes_alt_session(ctx, CRYPTO_AES_XTS);
   if (ret != 0)
     {
       return ret;
@@ -219,7 +270,6 @@ int mbedtls_aes_crypt_xts(FAR mbedtls_aes_xts_context *ctx,
   ctx->dev.crypt.dst = (caddr_t)output;
   ctx->dev.crypt.iv = (caddr_t)iv;
   ret = cryptodev_crypt(&ctx->dev);
-  cryptodev_free_session(&ctx->dev);
   return ret;
 }
 #endif /* MBEDTLS_CIPHER_MODE_XTS */
@@ -238,8 +288,7 @@ int mbedtls_aes_crypt_cfb128(FAR mbedtls_aes_context *ctx,
 {
   int ret;
 
-  ctx->dev.session.cipher = CRYPTO_AES_CFB_128;
-  ret = cryptodev_get_session(&ctx->dev);
+  ret = aes_alt_session(ctx, CRYPTO_AES_CFB_128);
   if (ret != 0)
     {
       return ret;
@@ -258,7 +307,6 @@ int mbedtls_aes_crypt_cfb128(FAR mbedtls_aes_context *ctx,
       *iv_off = length % ECB_BLOCK_SIZE;
     }
 
-  cryptodev_free_session(&ctx->dev);
   return ret;
 }
 
@@ -273,8 +321,7 @@ int mbedtls_aes_crypt_cfb8(FAR mbedtls_aes_context *ctx,
 {
   int ret;
 
-  ctx->dev.session.cipher = CRYPTO_AES_CFB_8;
-  ret = cryptodev_get_session(&ctx->dev);
+  ret = aes_alt_session(ctx, CRYPTO_AES_CFB_8);
   if (ret != 0)
     {
       return ret;
@@ -288,7 +335,6 @@ int mbedtls_aes_crypt_cfb8(FAR mbedtls_aes_context *ctx,
   ctx->dev.crypt.dst = (caddr_t)output;
   ctx->dev.crypt.iv = (caddr_t)iv;
   ret = cryptodev_crypt(&ctx->dev);
-  cryptodev_free_session(&ctx->dev);
   return ret;
 }
 #endif /* MBEDTLS_CIPHER_MODE_CFB */
@@ -306,8 +352,7 @@ int mbedtls_aes_crypt_ofb(FAR mbedtls_aes_context *ctx,
 {
   int ret;
 
-  ctx->dev.session.cipher = CRYPTO_AES_OFB;
-  ret = cryptodev_get_session(&ctx->dev);
+  ret = aes_alt_session(ctx, CRYPTO_AES_OFB);
   if (ret != 0)
     {
       return ret;
@@ -325,7 +370,6 @@ int mbedtls_aes_crypt_ofb(FAR mbedtls_aes_context *ctx,
       *iv_off = length % ECB_BLOCK_SIZE;
     }
 
-  cryptodev_free_session(&ctx->dev);
   return ret;
 }
 #endif /* MBEDTLS_CIPHER_MODE_OFB */
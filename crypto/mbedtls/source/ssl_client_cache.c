@@ -0,0 +1,267 @@
+/****************************************************************************
+ * apps/crypto/mbedtls/source/ssl_client_cache.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "mbedtls/platform_util.h"
+#include "mbedtls/ssl.h"
+#include "ssl_client_cache.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define CACHE_ENTRIES  CONFIG_MBEDTLS_SSL_CLIENT_CACHE_ENTRIES
+#define CACHE_SIZE     CONFIG_MBEDTLS_SSL_CLIENT_CACHE_SIZE
+#define CACHE_TIMEOUT  CONFIG_MBEDTLS_SSL_CLIENT_CACHE_TIMEOUT
+#define CACHE_KEYLEN   96
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A serialized session and the server it belongs to */
+
+struct ssl_client_entry_s
+{
+  char key[CACHE_KEYLEN];           /* "host:port", empty if unused */
+  time_t stamp;                     /* Last use */
+  time_t created;                   /* Save time, for the timeout */
+  size_t len;
+  unsigned char data[CACHE_SIZE];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static pthread_mutex_t g_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct ssl_client_entry_s g_cache[CACHE_ENTRIES];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: cache_now
+ ****************************************************************************/
+
+static time_t cache_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+/****************************************************************************
+ * Name: cache_find
+ *
+ * Description:
+ *   Return the live entry of the server, or NULL.  Expired entries are
+ *   released on the way.  Called with the cache locked.
+ *
+ ****************************************************************************/
+
+static FAR struct ssl_client_entry_s *cache_find(FAR const char *key)
+{
+  FAR struct ssl_client_entry_s *entry;
+  time_t now = cache_now();
+  int i;
+
+  for (i = 0; i < CACHE_ENTRIES; i++)
+    {
+      entry = &g_cache[i];
+      if (entry->key[0] == '\0')
+        {
+          continue;
+        }
+
+      if (CACHE_TIMEOUT > 0 && now - entry->created > CACHE_TIMEOUT)
+        {
+          mbedtls_platform_zeroize(entry, sizeof(*entry));
+          continue;
+        }
+
+      if (strcmp(entry->key, key) == 0)
+        {
+          return entry;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: cache_key
+ ****************************************************************************/
+
+static void cache_key(FAR char *key, FAR const char *host,
+                      FAR const char *port)
+{
+  snprintf(key, CACHE_KEYLEN, "%s:%s", host, port != NULL ? port : "");
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ssl_client_cache_set
+ ****************************************************************************/
+
+int ssl_client_cache_set(FAR mbedtls_ssl_context *ssl,
+                         FAR const char *host, FAR const char *port)
+{
+  FAR struct ssl_client_entry_s *entry;
+  mbedtls_ssl_session session;
+  char key[CACHE_KEYLEN];
+  int ret = MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+
+  cache_key(key, host, port);
+  mbedtls_ssl_session_init(&session);
+
+  pthread_mutex_lock(&g_cache_lock);
+  entry = cache_find(key);
+  if (entry != NULL)
+    {
+      entry->stamp = cache_now();
+      ret = mbedtls_ssl_session_load(&session, entry->data, entry->len);
+      if (ret != 0)
+        {
+          /* Saved by another version or configuration */
+
+          mbedtls_platform_zeroize(entry, sizeof(*entry));
+        }
+    }
+
+  pthread_mutex_unlock(&g_cache_lock);
+
+  if (ret == 0)
+    {
+      ret = mbedtls_ssl_set_session(ssl, &session);
+    }
+
+  mbedtls_ssl_session_free(&session);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ssl_client_cache_save
+ ****************************************************************************/
+
+int ssl_client_cache_save(FAR mbedtls_ssl_context *ssl,
+                          FAR const char *host, FAR const char *port)
+{
+  FAR struct ssl_client_entry_s *entry;
+  mbedtls_ssl_session session;
+  char key[CACHE_KEYLEN];
+  size_t len;
+  int ret;
+  int i;
+
+  cache_key(key, host, port);
+  mbedtls_ssl_session_init(&session);
+
+  ret = mbedtls_ssl_get_session(ssl, &session);
+  if (ret != 0)
+    {
+      goto out;
+    }
+
+  pthread_mutex_lock(&g_cache_lock);
+
+  /* Reuse the entry of the server, else a free or the oldest one */
+
+  entry = cache_find(key);
+  for (i = 0; entry == NULL && i < CACHE_ENTRIES; i++)
+    {
+      if (g_cache[i].key[0] == '\0')
+        {
+          entry = &g_cache[i];
+        }
+    }
+
+  if (entry == NULL)
+    {
+      entry = &g_cache[0];
+      for (i = 1; i < CACHE_ENTRIES; i++)
+        {
+          if (g_cache[i].stamp < entry->stamp)
+            {
+              entry = &g_cache[i];
+            }
+        }
+    }
+
+  ret = mbedtls_ssl_session_save(&session, entry->data,
+                                 sizeof(entry->data), &len);
+  if (ret == 0)
+    {
+      strlcpy(entry->key, key, sizeof(entry->key));
+      entry->len     = len;
+      entry->stamp   = cache_now();
+      entry->created = entry->stamp;
+    }
+  else
+    {
+      /* Too large: MBEDTLS_SSL_KEEP_PEER_CERTIFICATE keeps the whole
+       * certificate of the server in the session.
+       */
+
+      mbedtls_platform_zeroize(entry, sizeof(*entry));
+    }
+
+  pthread_mutex_unlock(&g_cache_lock);
+
+out:
+  mbedtls_ssl_session_free(&session);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ssl_client_cache_remove
+ ****************************************************************************/
+
+void ssl_client_cache_remove(FAR const char *host, FAR const char *port)
+{
+  FAR struct ssl_client_entry_s *entry;
+  char key[CACHE_KEYLEN];
+
+  cache_key(key, host, port);
+
+  pthread_mutex_lock(&g_cache_lock);
+  entry = cache_find(key);
+  if (entry != NULL)
+    {
+      mbedtls_platform_zeroize(entry, sizeof(*entry));
+    }
+
+  pthread_mutex_unlock(&g_cache_lock);
+}
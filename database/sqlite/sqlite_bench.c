@@ -0,0 +1,237 @@
+/****************************************************************************
+ * apps/database/sqlite/sqlite_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sqlite_nuttx.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint64_t bench_now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void bench_usage(FAR const char *progname)
+{
+  fprintf(stderr,
+          "Usage: %s [-n rows] [-b rows_per_commit] [-q queries] <db>\n",
+          progname);
+}
+
+static int bench_exec(FAR sqlite3 *db, FAR const char *sql)
+{
+  FAR char *errmsg = NULL;
+  int ret;
+
+  ret = sqlite3_exec(db, sql, NULL, NULL, &errmsg);
+  if (ret != SQLITE_OK)
+    {
+      fprintf(stderr, "ERROR: %s: %s\n", sql, errmsg);
+      sqlite3_free(errmsg);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR sqlite3_stmt *stmt = NULL;
+  FAR sqlite3 *db;
+  uint64_t commitmax = 0;
+  uint64_t querymax = 0;
+  uint64_t start;
+  uint64_t total;
+  uint64_t t;
+  int nrows = 1000;
+  int batch = 1;
+  int nqueries = 1000;
+  int ret;
+  int opt;
+  int i;
+
+  while ((opt = getopt(argc, argv, "n:b:q:")) != -1)
+    {
+      switch (opt)
+        {
+          case 'n':
+            nrows = atoi(optarg);
+            break;
+
+          case 'b':
+            batch = atoi(optarg);
+            break;
+
+          case 'q':
+            nqueries = atoi(optarg);
+            break;
+
+          default:
+            bench_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (optind + 1 != argc || nrows <= 0 || batch <= 0 || nqueries < 0)
+    {
+      bench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  ret = sqlite_nuttx_open(argv[optind], &db);
+  if (ret != SQLITE_OK)
+    {
+      fprintf(stderr, "ERROR: open %s: %s\n", argv[optind],
+              sqlite3_errstr(ret));
+      return EXIT_FAILURE;
+    }
+
+  ret = bench_exec(db, "DROP TABLE IF EXISTS bench;"
+                       "CREATE TABLE bench(id INTEGER PRIMARY KEY,"
+                       " ts INTEGER, value INTEGER, tag TEXT);");
+  if (ret != SQLITE_OK)
+    {
+      goto out;
+    }
+
+  ret = sqlite3_prepare_v2(db, "INSERT INTO bench(ts, value, tag) "
+                               "VALUES(?, ?, 'event')", -1, &stmt, NULL);
+  if (ret != SQLITE_OK)
+    {
+      goto out;
+    }
+
+  /* Inserts, batch rows per transaction.  The commit latency is what
+   * stalls a logger that writes an event per transaction.
+   */
+
+  start = bench_now_us();
+  for (i = 0; i < nrows && ret == SQLITE_OK; i++)
+    {
+      if (i % batch == 0)
+        {
+          ret = bench_exec(db, "BEGIN");
+        }
+
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64)bench_now_us());
+      sqlite3_bind_int(stmt, 2, i);
+      if (sqlite3_step(stmt) != SQLITE_DONE)
+        {
+          ret = sqlite3_errcode(db);
+        }
+
+      sqlite3_reset(stmt);
+
+      if ((i + 1) % batch == 0 || i + 1 == nrows)
+        {
+          t = bench_now_us();
+          if (bench_exec(db, "COMMIT") != SQLITE_OK && ret == SQLITE_OK)
+            {
+              ret = sqlite3_errcode(db);
+            }
+
+          t = bench_now_us() - t;
+          if (t > commitmax)
+            {
+              commitmax = t;
+            }
+        }
+    }
+
+  total = bench_now_us() - start;
+  sqlite3_finalize(stmt);
+  stmt = NULL;
+
+  if (ret != SQLITE_OK)
+    {
+      goto out;
+    }
+
+  printf("insert: %d rows in %llu ms, %llu rows/s, commit max %llu us\n",
+         nrows, (unsigned long long)(total / 1000),
+         (unsigned long long)(nrows * 1000000ull / (total ? total : 1)),
+         (unsigned long long)commitmax);
+
+  /* Point queries on random rowids. */
+
+  ret = sqlite3_prepare_v2(db, "SELECT value FROM bench WHERE id = ?",
+                           -1, &stmt, NULL);
+  if (ret != SQLITE_OK)
+    {
+      goto out;
+    }
+
+  start = bench_now_us();
+  for (i = 0; i < nqueries; i++)
+    {
+      t = bench_now_us();
+      sqlite3_bind_int(stmt, 1, 1 + rand() % nrows);
+      if (sqlite3_step(stmt) != SQLITE_ROW)
+        {
+          ret = sqlite3_errcode(db);
+          break;
+        }
+
+      sqlite3_reset(stmt);
+      t = bench_now_us() - t;
+      if (t > querymax)
+        {
+          querymax = t;
+        }
+    }
+
+  total = bench_now_us() - start;
+
+  if (ret == SQLITE_OK && nqueries > 0)
+    {
+      printf("query: %d lookups, avg %llu us, max %llu us\n", nqueries,
+             (unsigned long long)(total / nqueries),
+             (unsigned long long)querymax);
+    }
+
+out:
+  if (ret != SQLITE_OK)
+    {
+      fprintf(stderr, "ERROR: %s\n", sqlite3_errmsg(db));
+    }
+
+  sqlite3_finalize(stmt);
+  sqlite3_close(db);
+  return ret == SQLITE_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
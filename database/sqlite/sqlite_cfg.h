@@ -1,6 +1,8 @@
 /* sqlite_cfg.h.  Generated from sqlite_cfg.h.in by configure.  */
 /* sqlite_cfg.h.in.  Generated from configure.ac by autoheader.  */
 
+#include <nuttx/config.h>
+
 /* Define to 1 if you have the <dlfcn.h> header file. */
 #define HAVE_DLFCN_H 1
 
@@ -143,3 +145,19 @@
 
 /* Define for large files, on AIX-style hosts. */
 /* #undef _LARGE_FILES */
+
+/* NuttX tuning, see database/sqlite/Kconfig. */
+
+#define SQLITE_DEFAULT_PAGE_SIZE CONFIG_LIB_SQLITE_PAGESIZE
+#define SQLITE_DEFAULT_SECTOR_SIZE CONFIG_LIB_SQLITE_SECTOR_SIZE
+#define SQLITE_MAX_MMAP_SIZE CONFIG_LIB_SQLITE_MMAP_SIZE
+#define SQLITE_DEFAULT_MMAP_SIZE CONFIG_LIB_SQLITE_MMAP_SIZE
+#define SQLITE_DEFAULT_WAL_AUTOCHECKPOINT CONFIG_LIB_SQLITE_WAL_AUTOCHECKPOINT
+#define SQLITE_DEFAULT_JOURNAL_SIZE_LIMIT CONFIG_LIB_SQLITE_JOURNAL_SIZE_LIMIT
+
+/* In WAL mode a commit only appends to the WAL; it is enough to sync it at
+ * checkpoints.  A power loss may lose the last commits but never corrupts
+ * the database.
+ */
+
+#define SQLITE_DEFAULT_WAL_SYNCHRONOUS 1
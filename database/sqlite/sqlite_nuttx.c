@@ -0,0 +1,108 @@
+/****************************************************************************
+ * apps/database/sqlite/sqlite_nuttx.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <nuttx/compiler.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sqlite_nuttx.h"
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#if CONFIG_LIB_SQLITE_PAGECACHE_SIZE > 0
+static uint64_t g_sqlite_pagecache[CONFIG_LIB_SQLITE_PAGECACHE_SIZE / 8]
+#  ifdef CONFIG_LIB_SQLITE_PAGECACHE_USE_SECTION
+  locate_data(CONFIG_LIB_SQLITE_PAGECACHE_SECTION)
+#  endif
+  ;
+#endif
+
+static const char g_sqlite_pragmas[] =
+  "PRAGMA locking_mode=EXCLUSIVE;"
+  "PRAGMA journal_mode=WAL;"
+  "PRAGMA synchronous=NORMAL;";
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sqlite_nuttx_init
+ ****************************************************************************/
+
+int sqlite_nuttx_init(void)
+{
+#if CONFIG_LIB_SQLITE_PAGECACHE_SIZE > 0
+  int hdrsz;
+  int slotsz;
+
+  /* A slot holds a page and its header, whose size depends on the build.
+   * sqlite3_config() fails with SQLITE_MISUSE once SQLite is initialized,
+   * which is what makes a second call harmless.
+   */
+
+  if (sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &hdrsz) == SQLITE_OK)
+    {
+      slotsz = (CONFIG_LIB_SQLITE_PAGESIZE + hdrsz + 7) & ~7;
+      sqlite3_config(SQLITE_CONFIG_PAGECACHE, g_sqlite_pagecache, slotsz,
+                     (int)(sizeof(g_sqlite_pagecache) / slotsz));
+    }
+#endif
+
+  return sqlite3_initialize();
+}
+
+/****************************************************************************
+ * Name: sqlite_nuttx_open
+ ****************************************************************************/
+
+int sqlite_nuttx_open(FAR const char *path, FAR sqlite3 **db)
+{
+  int ret;
+
+  ret = sqlite_nuttx_init();
+  if (ret != SQLITE_OK)
+    {
+      *db = NULL;
+      return ret;
+    }
+
+  ret = sqlite3_open(path, db);
+  if (ret == SQLITE_OK)
+    {
+      ret = sqlite3_exec(*db, g_sqlite_pragmas, NULL, NULL, NULL);
+    }
+
+  if (ret != SQLITE_OK)
+    {
+      sqlite3_close(*db);
+      *db = NULL;
+    }
+
+  return ret;
+}
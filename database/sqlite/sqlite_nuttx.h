@@ -0,0 +1,82 @@
+/****************************************************************************
+ * apps/database/sqlite/sqlite_nuttx.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_DATABASE_SQLITE_SQLITE_NUTTX_H
+#define __APPS_DATABASE_SQLITE_SQLITE_NUTTX_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sqlite3.h>
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: sqlite_nuttx_init
+ *
+ * Description:
+ *   Configure and initialize SQLite for NuttX: hand it the page cache pool
+ *   of CONFIG_LIB_SQLITE_PAGECACHE_SIZE bytes, if any.  It has to run
+ *   before any other SQLite call, which would initialize SQLite with the
+ *   defaults; calling it again is harmless.
+ *
+ * Returned Value:
+ *   SQLITE_OK on success; an SQLite error code on failure.
+ *
+ ****************************************************************************/
+
+int sqlite_nuttx_init(void);
+
+/****************************************************************************
+ * Name: sqlite_nuttx_open
+ *
+ * Description:
+ *   Open the database path like sqlite3_open() and set it up for flash
+ *   media: WAL journal with exclusive locking, so that the WAL index lives
+ *   in memory instead of in a mmap()ed -shm file, and synchronous=NORMAL,
+ *   so that a commit appends to the WAL without a sync.
+ *
+ * Returned Value:
+ *   SQLITE_OK on success; an SQLite error code on failure, in which case
+ *   *db is closed and set to NULL.
+ *
+ ****************************************************************************/
+
+int sqlite_nuttx_open(FAR const char *path, FAR sqlite3 **db);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_DATABASE_SQLITE_SQLITE_NUTTX_H */
@@ -277,6 +277,17 @@ static void foc_fixed16_nxscope(FAR struct foc_nxscope_s *nxs,
   ptr = svm3_tmp;
   nxscope_put_vb16(&nxs->nxs, i++, ptr, 4);
 #endif
+#if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_VOBS)
+  i++;  /* Not supported for fixed16 */
+#endif
+#if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_AOBS)
+  i++;  /* Not supported for fixed16 */
+#endif
+#if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_PROF)
+  nxscope_put_vuint32(&nxs->nxs, i++,
+                      (FAR uint32_t *)foc_prof_last(&motor->handler.prof),
+                      FOC_PROF_STAGES);
+#endif
 
   nxscope_unlock(&nxs->nxs);
 }
@@ -508,6 +519,9 @@ int foc_fixed16_thr(FAR struct foc_ctrl_env_s *envp)
       if (dev.perf.max_changed)
         {
           PRINTF_PERF("max=%" PRId32 "\n", dev.perf.max);
+#  ifdef CONFIG_INDUSTRY_FOC_PROF
+          foc_perf_prof_print(&motor.handler.prof);
+#  endif
         }
 #endif
     }
@@ -288,6 +288,11 @@ static void foc_float_nxscope(FAR struct foc_nxscope_s *nxs,
   ptr = (FAR float *)&motor->angle_obs;
   nxscope_put_vfloat(&nxs->nxs, i++, ptr, 1);
 #endif
+#if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_PROF)
+  nxscope_put_vuint32(&nxs->nxs, i++,
+                      (FAR uint32_t *)foc_prof_last(&motor->handler.prof),
+                      FOC_PROF_STAGES);
+#endif
 
 #ifndef CONFIG_EXAMPLES_FOC_NXSCOPE_CONTROL
   nxscope_unlock(&nxs->nxs);
@@ -521,6 +526,9 @@ int foc_float_thr(FAR struct foc_ctrl_env_s *envp)
       if (dev.perf.max_changed)
         {
           PRINTF_PERF("max=%" PRId32 "\n", dev.perf.max);
+#  ifdef CONFIG_INDUSTRY_FOC_PROF
+          foc_perf_prof_print(&motor.handler.prof);
+#  endif
         }
 #endif
     }
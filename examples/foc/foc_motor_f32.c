@@ -1812,12 +1812,16 @@ int foc_motor_get(FAR struct foc_motor_f32_s *motor)
 
   /* Get motor angle */
 
+  FOC_PROF_MARK(&motor->handler);
+
   ret = foc_motor_ang_get(motor);
   if (ret < 0)
     {
       goto errout;
     }
 
+  FOC_PROF_STAGE(&motor->handler, FOC_PROF_ANGLE);
+
 #ifdef CONFIG_EXAMPLES_FOC_HAVE_VEL
   /* Get motor velocity */
 
@@ -33,6 +33,7 @@
 #include "foc_thr.h"
 
 #include "industry/foc/foc_common.h"
+#include "industry/foc/foc_prof.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -42,6 +43,11 @@
 #  error CONFIG_LOGGING_NXSCOPE_DISABLE_PUTLOCK must be set to proper operation.
 #endif
 
+#if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_PROF) && \
+    !defined(CONFIG_INDUSTRY_FOC_PROF)
+#  error CONFIG_INDUSTRY_FOC_PROF must be set for FOC_NXSCOPE_PROF
+#endif
+
 #if defined(CONFIG_LOGGING_NXSCOPE_INTF_SERIAL) && !defined(CONFIG_SERIAL_RTT)
 #  ifndef CONFIG_SERIAL_TERMIOS
 #    error CONFIG_SERIAL_TERMIOS must be set to proper operation.
@@ -245,6 +251,10 @@ int foc_nxscope_init(FAR struct foc_nxscope_s *nxs)
 #if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_AOBS)
       nxscope_chan_init(&nxs->nxs, i++, "aobs", u.u8, 1, 0);
 #endif
+#if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_PROF)
+      u.s.dtype = NXSCOPE_TYPE_UINT32;
+      nxscope_chan_init(&nxs->nxs, i++, "prof", u.u8, FOC_PROF_STAGES, 0);
+#endif
 
       if (i > CONFIG_EXAMPLES_FOC_NXSCOPE_CHANNELS)
         {
@@ -25,7 +25,9 @@
 #include <nuttx/config.h>
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 #include <nuttx/clock.h>
@@ -72,3 +74,28 @@ void foc_perf_end(struct foc_perf_s *p)
       p->max_changed = true;
     }
 }
+
+#ifdef CONFIG_INDUSTRY_FOC_PROF
+/****************************************************************************
+ * Name: foc_perf_prof_print
+ ****************************************************************************/
+
+void foc_perf_prof_print(FAR struct foc_prof_s *prof)
+{
+  static FAR const char *names[FOC_PROF_STAGES] =
+  {
+    "angle", "current", "input", "control", "modulation"
+  };
+
+  struct foc_prof_stat_s stat[FOC_PROF_STAGES];
+  int                    i;
+
+  foc_prof_stats(prof, stat);
+
+  for (i = 0; i < FOC_PROF_STAGES; i++)
+    {
+      PRINTF_PERF("  %-10s min=%" PRIu32 " max=%" PRIu32 " avg=%" PRIu32
+                  "\n", names[i], stat[i].min, stat[i].max, stat[i].avg);
+    }
+}
+#endif
@@ -27,6 +27,11 @@
 
 #include <nuttx/config.h>
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "industry/foc/foc_prof.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -51,5 +56,8 @@ struct foc_perf_s
 int foc_perf_init(struct foc_perf_s *p);
 void foc_perf_start(struct foc_perf_s *p);
 void foc_perf_end(struct foc_perf_s *p);
+#ifdef CONFIG_INDUSTRY_FOC_PROF
+void foc_perf_prof_print(FAR struct foc_prof_s *prof);
+#endif
 
 #endif /* __APPS_EXAMPLES_FOC_FOC_PERF_H */
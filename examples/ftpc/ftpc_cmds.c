@@ -273,10 +273,13 @@ int cmd_rget(SESSION handle, int argc, char **argv)
   FAR const char *rname;
   FAR const char *lname = NULL;
   int xfrmode = FTPC_XFRMODE_ASCII;
+#ifdef CONFIG_FTPC_SEGMENTED
+  int nsegments = 0;
+#endif
   int option;
   bool badarg = false;
 
-  while ((option = getopt(argc, argv, "ab")) != ERROR)
+  while ((option = getopt(argc, argv, "abs:")) != ERROR)
     {
       if (option == 'a')
         {
@@ -286,6 +289,12 @@ int cmd_rget(SESSION handle, int argc, char **argv)
         {
           xfrmode = FTPC_XFRMODE_BINARY;
         }
+#ifdef CONFIG_FTPC_SEGMENTED
+      else if (option == 's')
+        {
+          nsegments = atoi(optarg);
+        }
+#endif
       else
         {
           fprintf(stderr, "%s: Unrecognized option: '%c'\n", "rget", option);
@@ -323,6 +332,15 @@ int cmd_rget(SESSION handle, int argc, char **argv)
 
   /* Perform the transfer */
 
+#ifdef CONFIG_FTPC_SEGMENTED
+  if (nsegments > 0)
+    {
+      /* Segmented transfers are always binary */
+
+      return ftpc_getsegments(handle, rname, lname, nsegments);
+    }
+#endif
+
   return ftpc_getfile(handle, rname, lname, FTPC_GET_NORMAL, xfrmode);
 }
 
@@ -71,7 +71,11 @@ static const struct cmdmap_s g_cmdmap[] =
 {
   { "cd",       cmd_rchdir,  2, 2, "<directory>" },
   { "chmod",    cmd_rchmod,  3, 3, "<permissions> <path>" },
+#ifdef CONFIG_FTPC_SEGMENTED
+  { "get",      cmd_rget,    2, 6, "[-a|b] [-s <n>] <rname> [<lname>]" },
+#else
   { "get",      cmd_rget,    2, 4, "[-a|b] <rname> [<lname>]" },
+#endif
   { "help",     cmd_lhelp,   1, 2, "" },
   { "idle",     cmd_ridle,   1, 2, "[<idletime>]" },
   { "login",    cmd_rlogin,  2, 3, "<uname> [<password>]" },
@@ -0,0 +1,336 @@
+/****************************************************************************
+ * apps/examples/nng_test/nngbench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nng/nng.h>
+#include <nng/protocol/pubsub0/pub.h>
+#include <nng/protocol/pubsub0/sub.h>
+#include <nng/protocol/reqrep0/rep.h>
+#include <nng/protocol/reqrep0/req.h>
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct nngbench_s
+{
+  nng_socket sock;      /* Socket of the peer thread */
+  int        count;     /* Messages expected by the subscriber */
+  int        received;
+  uint64_t   total;     /* Sum of the latencies (us) */
+  uint64_t   max;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint64_t nngbench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void nngbench_report(FAR const char *name,
+                            FAR struct nngbench_s *bench, int sent,
+                            uint64_t elapsed)
+{
+  printf("%s: %d/%d msgs in %" PRIu64 " ms, %" PRIu64 " msgs/s, "
+         "latency avg %" PRIu64 " us max %" PRIu64 " us\n",
+         name, bench->received, sent, elapsed / 1000,
+         bench->received * UINT64_C(1000000) / (elapsed ? elapsed : 1),
+         bench->total / (bench->received ? bench->received : 1),
+         bench->max);
+}
+
+static void nngbench_latency(FAR struct nngbench_s *bench, uint64_t us)
+{
+  bench->received++;
+  bench->total += us;
+  if (us > bench->max)
+    {
+      bench->max = us;
+    }
+}
+
+/* The messages are handed over with nng_sendmsg() and nng_recvmsg(): the
+ * transports pass the nng_msg itself, so the payload is never copied on
+ * inproc and the replier sends back the very message it received.
+ */
+
+static FAR void *nngbench_rep(pthread_addr_t arg)
+{
+  FAR struct nngbench_s *bench = arg;
+  FAR nng_msg *msg;
+
+  while (nng_recvmsg(bench->sock, &msg, 0) == 0)
+    {
+      if (nng_sendmsg(bench->sock, msg, 0) != 0)
+        {
+          nng_msg_free(msg);
+          break;
+        }
+    }
+
+  return NULL;
+}
+
+static FAR void *nngbench_sub(pthread_addr_t arg)
+{
+  FAR struct nngbench_s *bench = arg;
+  FAR nng_msg *msg;
+  uint64_t stamp;
+
+  while (bench->received < bench->count &&
+         nng_recvmsg(bench->sock, &msg, 0) == 0)
+    {
+      memcpy(&stamp, nng_msg_body(msg), sizeof(stamp));
+      nngbench_latency(bench, nngbench_now() - stamp);
+      nng_msg_free(msg);
+    }
+
+  return NULL;
+}
+
+static int nngbench_reqrep(FAR const char *url, int count, size_t size)
+{
+  struct nngbench_s bench;
+  FAR nng_msg *msg;
+  nng_socket req;
+  pthread_t tid;
+  uint64_t start;
+  uint64_t t;
+  int ret;
+  int i;
+
+  memset(&bench, 0, sizeof(bench));
+
+  if ((ret = nng_rep0_open(&bench.sock)) != 0)
+    {
+      return ret;
+    }
+
+  if ((ret = nng_req0_open(&req)) != 0)
+    {
+      nng_close(bench.sock);
+      return ret;
+    }
+
+  if ((ret = nng_listen(bench.sock, url, NULL, 0)) != 0 ||
+      (ret = nng_dial(req, url, NULL, 0)) != 0)
+    {
+      goto out;
+    }
+
+  pthread_create(&tid, NULL, nngbench_rep, &bench);
+
+  start = nngbench_now();
+  for (i = 0; i < count; i++)
+    {
+      if ((ret = nng_msg_alloc(&msg, size)) != 0)
+        {
+          break;
+        }
+
+      t = nngbench_now();
+      if ((ret = nng_sendmsg(req, msg, 0)) != 0)
+        {
+          nng_msg_free(msg);
+          break;
+        }
+
+      if ((ret = nng_recvmsg(req, &msg, 0)) != 0)
+        {
+          break;
+        }
+
+      nngbench_latency(&bench, nngbench_now() - t);
+      nng_msg_free(msg);
+    }
+
+  nngbench_report("req/rep", &bench, count, nngbench_now() - start);
+
+  nng_close(bench.sock);
+  pthread_join(tid, NULL);
+  nng_close(req);
+  return ret;
+
+out:
+  nng_close(bench.sock);
+  nng_close(req);
+  return ret;
+}
+
+static int nngbench_pubsub(FAR const char *url, int count, size_t size)
+{
+  struct nngbench_s bench;
+  FAR nng_msg *msg;
+  nng_socket pub;
+  pthread_t tid;
+  uint64_t start;
+  uint64_t stamp;
+  int ret;
+  int i;
+
+  memset(&bench, 0, sizeof(bench));
+  bench.count = count;
+
+  if ((ret = nng_pub0_open(&pub)) != 0)
+    {
+      return ret;
+    }
+
+  if ((ret = nng_sub0_open(&bench.sock)) != 0)
+    {
+      nng_close(pub);
+      return ret;
+    }
+
+  /* A publisher drops what a slow subscriber cannot queue; give it room
+   * and stop waiting a second after the last message.
+   */
+
+  nng_socket_set(bench.sock, NNG_OPT_SUB_SUBSCRIBE, "", 0);
+  nng_socket_set_int(bench.sock, NNG_OPT_RECVBUF, 1024);
+  nng_socket_set_ms(bench.sock, NNG_OPT_RECVTIMEO, 1000);
+
+  if ((ret = nng_listen(pub, url, NULL, 0)) != 0 ||
+      (ret = nng_dial(bench.sock, url, NULL, 0)) != 0)
+    {
+      goto out;
+    }
+
+  /* Let the pipe come up, or the first messages go nowhere. */
+
+  usleep(100 * 1000);
+  pthread_create(&tid, NULL, nngbench_sub, &bench);
+
+  start = nngbench_now();
+  for (i = 0; i < count; i++)
+    {
+      if ((ret = nng_msg_alloc(&msg, size)) != 0)
+        {
+          break;
+        }
+
+      stamp = nngbench_now();
+      memcpy(nng_msg_body(msg), &stamp, sizeof(stamp));
+
+      if ((ret = nng_sendmsg(pub, msg, 0)) != 0)
+        {
+          nng_msg_free(msg);
+          break;
+        }
+    }
+
+  pthread_join(tid, NULL);
+  nngbench_report("pub/sub", &bench, i, nngbench_now() - start);
+
+out:
+  nng_close(bench.sock);
+  nng_close(pub);
+  return ret;
+}
+
+static void nngbench_usage(FAR const char *progname)
+{
+  fprintf(stderr,
+          "Usage: %s [-u url] [-n count] [-s size]\n"
+          "  -u  Base URL, inproc://nngbench or ipc:///tmp/nngbench ...\n"
+          "  -n  Messages per test (default 10000)\n"
+          "  -s  Message size in bytes, at least 8 (default 64)\n",
+          progname);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR const char *base = "inproc://nngbench";
+  char url[128];
+  size_t size = 64;
+  int count = 10000;
+  int ret;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "u:n:s:")) != -1)
+    {
+      switch (opt)
+        {
+          case 'u':
+            base = optarg;
+            break;
+
+          case 'n':
+            count = atoi(optarg);
+            break;
+
+          case 's':
+            size = strtoul(optarg, NULL, 0);
+            break;
+
+          default:
+            nngbench_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (count <= 0 || size < sizeof(uint64_t))
+    {
+      nngbench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  snprintf(url, sizeof(url), "%s.rr", base);
+  ret = nngbench_reqrep(url, count, size);
+  if (ret != 0)
+    {
+      fprintf(stderr, "req/rep: %s\n", nng_strerror(ret));
+      return EXIT_FAILURE;
+    }
+
+  snprintf(url, sizeof(url), "%s.ps", base);
+  ret = nngbench_pubsub(url, count, size);
+  if (ret != 0)
+    {
+      fprintf(stderr, "pub/sub: %s\n", nng_strerror(ret));
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
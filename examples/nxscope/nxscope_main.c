@@ -519,6 +519,16 @@ int main(int argc, FAR char *argv[])
   nxs_cfg.cribuf_len    = CONFIG_EXAMPLES_NXSCOPE_CRIBUF_LEN;
 #endif
   nxs_cfg.rx_padding    = CONFIG_EXAMPLES_NXSCOPE_RX_PADDING;
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+  nxs_cfg.blockbuf_len  = CONFIG_EXAMPLES_NXSCOPE_STREAMBUF_LEN;
+#endif
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+  nxs_cfg.rings         = 0;
+  nxs_cfg.ring_len      = 0;
+#endif
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+  nxs_cfg.trigbuf_len   = 0;
+#endif
 
   ret = nxscope_init(&nxs, &nxs_cfg);
   if (ret < 0)
@@ -52,6 +52,7 @@
     .endpoint_block_send = false, \
     .endpoint_recv_avail_from_start = true, \
     .endpoint_recv_avail = 4, \
+    .endpoint_echo = false, \
   }
 
 /* Test case macros */
@@ -129,6 +130,7 @@ struct usrsocktest_daemon_conf_s
   bool endpoint_block_connect:1;
   bool endpoint_block_send:1;
   bool endpoint_recv_avail_from_start:1;
+  bool endpoint_echo:1;         /* Sent data becomes available to recv */
   uint8_t endpoint_recv_avail:8;
   const char *endpoint_addr;
   uint16_t endpoint_port;
@@ -193,4 +195,8 @@ bool usrsocktest_send_delayed_command(char cmd, unsigned int delay_msec);
 
 int usrsocktest_daemon_pause_usrsock_handling(bool pause);
 
+#ifdef CONFIG_EXAMPLES_USRSOCKTEST_BENCH
+int usrsocktest_bench(int argc, FAR char *argv[]);
+#endif
+
 #endif /* __APPS_EXAMPLES_USRSOCKTEST_DEFINES_H */
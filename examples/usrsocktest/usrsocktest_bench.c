@@ -0,0 +1,364 @@
+/****************************************************************************
+ * apps/examples/usrsocktest/usrsocktest_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "defines.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_MINSIZE 16
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Round-trip times of one request type, in microseconds */
+
+struct bench_stat_s
+{
+  FAR const char *name;
+  unsigned long min;
+  unsigned long max;
+  unsigned long long sum;
+  unsigned int count;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct usrsocktest_daemon_conf_s g_bench_conf;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void bench_start(FAR struct timespec *start)
+{
+  clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+static unsigned long bench_usec(FAR const struct timespec *start)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000ul +
+         (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+static void bench_add(FAR struct bench_stat_s *stat,
+                      FAR const struct timespec *start)
+{
+  unsigned long usec = bench_usec(start);
+
+  if (stat->count == 0 || usec < stat->min)
+    {
+      stat->min = usec;
+    }
+
+  if (usec > stat->max)
+    {
+      stat->max = usec;
+    }
+
+  stat->sum += usec;
+  stat->count++;
+}
+
+static void bench_print(FAR const struct bench_stat_s *stat)
+{
+  if (stat->count == 0)
+    {
+      printf("  %-12s failed\n", stat->name);
+      return;
+    }
+
+  printf("  %-12s %8llu %8lu %8lu\n", stat->name,
+         stat->sum / stat->count, stat->min, stat->max);
+}
+
+static int bench_connect(int sd)
+{
+  struct sockaddr_in addr;
+
+  memset(&addr, 0, sizeof(addr));
+  inet_pton(AF_INET, g_bench_conf.endpoint_addr, &addr.sin_addr.s_addr);
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(g_bench_conf.endpoint_port);
+  return connect(sd, (FAR const struct sockaddr *)&addr, sizeof(addr));
+}
+
+/****************************************************************************
+ * Name: bench_latency
+ *
+ * Description:
+ *   Time each request type that goes through the daemon.  connect() needs
+ *   a fresh socket every time, so it is measured on sockets that are
+ *   opened and closed outside of its timing.
+ *
+ ****************************************************************************/
+
+static int bench_latency(unsigned int iterations)
+{
+  struct bench_stat_s stats[] =
+    {
+      { "socket" }, { "close" }, { "connect" }, { "setsockopt" },
+      { "getsockopt" }, { "getsockname" }, { "send" }, { "recv" },
+    };
+
+  struct sockaddr_in addr;
+  struct timespec start;
+  socklen_t addrlen;
+  unsigned int i;
+  int value;
+  char byte;
+  int sd;
+
+  for (i = 0; i < iterations; i++)
+    {
+      bench_start(&start);
+      sd = socket(AF_INET, SOCK_STREAM, 0);
+      if (sd < 0)
+        {
+          return -errno;
+        }
+
+      bench_add(&stats[0], &start);
+
+      bench_start(&start);
+      if (bench_connect(sd) == 0)
+        {
+          bench_add(&stats[2], &start);
+        }
+
+      value = 1;
+      bench_start(&start);
+      if (setsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &value,
+                     sizeof(value)) == 0)
+        {
+          bench_add(&stats[3], &start);
+        }
+
+      addrlen = sizeof(value);
+      bench_start(&start);
+      if (getsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &value, &addrlen) == 0)
+        {
+          bench_add(&stats[4], &start);
+        }
+
+      addrlen = sizeof(addr);
+      bench_start(&start);
+      if (getsockname(sd, (FAR struct sockaddr *)&addr, &addrlen) == 0)
+        {
+          bench_add(&stats[5], &start);
+        }
+
+      /* The daemon echoes the byte, so that recv() does not wait. */
+
+      byte = 'a';
+      bench_start(&start);
+      if (send(sd, &byte, 1, 0) == 1)
+        {
+          bench_add(&stats[6], &start);
+        }
+
+      bench_start(&start);
+      if (recv(sd, &byte, 1, 0) == 1)
+        {
+          bench_add(&stats[7], &start);
+        }
+
+      bench_start(&start);
+      close(sd);
+      bench_add(&stats[1], &start);
+    }
+
+  printf("Round trip, usec   %8s %8s %8s\n", "avg", "min", "max");
+  for (i = 0; i < nitems(stats); i++)
+    {
+      bench_print(&stats[i]);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bench_throughput
+ *
+ * Description:
+ *   Send CONFIG_EXAMPLES_USRSOCKTEST_BENCH_BYTES in chunks of each size,
+ *   then receive them back from the daemon in chunks of the same size.
+ *
+ ****************************************************************************/
+
+static int bench_throughput(void)
+{
+  struct timespec start;
+  unsigned long sendus;
+  unsigned long recvus;
+  FAR uint8_t *buf;
+  size_t total;
+  size_t size;
+  ssize_t ret;
+  int sd;
+
+  buf = malloc(CONFIG_EXAMPLES_USRSOCKTEST_BENCH_MAXSIZE);
+  if (buf == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  memset(buf, 'a', CONFIG_EXAMPLES_USRSOCKTEST_BENCH_MAXSIZE);
+
+  sd = socket(AF_INET, SOCK_STREAM, 0);
+  if (sd < 0 || bench_connect(sd) < 0)
+    {
+      ret = -errno;
+      goto errout;
+    }
+
+  printf("Throughput, KiB/s  %8s %8s\n", "send", "recv");
+
+  for (size = BENCH_MINSIZE;
+       size <= CONFIG_EXAMPLES_USRSOCKTEST_BENCH_MAXSIZE;
+       size *= 2)
+    {
+      bench_start(&start);
+      for (total = 0; total < CONFIG_EXAMPLES_USRSOCKTEST_BENCH_BYTES;
+           total += ret)
+        {
+          ret = send(sd, buf, size, 0);
+          if (ret <= 0)
+            {
+              ret = -errno;
+              goto errout;
+            }
+        }
+
+      sendus = bench_usec(&start);
+
+      bench_start(&start);
+      while (total > 0)
+        {
+          ret = recv(sd, buf, MIN(size, total), 0);
+          if (ret <= 0)
+            {
+              ret = -errno;
+              goto errout;
+            }
+
+          total -= ret;
+        }
+
+      recvus = bench_usec(&start);
+
+      printf("  %-5zu bytes     %8lu %8lu\n", size,
+             (unsigned long)(CONFIG_EXAMPLES_USRSOCKTEST_BENCH_BYTES *
+                             1000000ull / 1024 / MAX(sendus, 1)),
+             (unsigned long)(CONFIG_EXAMPLES_USRSOCKTEST_BENCH_BYTES *
+                             1000000ull / 1024 / MAX(recvus, 1)));
+    }
+
+  ret = OK;
+
+errout:
+  if (sd >= 0)
+    {
+      close(sd);
+    }
+
+  free(buf);
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: usrsocktest_bench
+ *
+ * Description:
+ *   Measure the cost of the usrsock hop: the test daemon answers every
+ *   request at once and echoes the data sent to it, so that the results
+ *   are the overhead of /dev/usrsock and of the daemon loop alone, the
+ *   floor under every usrsock modem driver.
+ *
+ *   usrsocktest bench [iterations]
+ *
+ ****************************************************************************/
+
+int usrsocktest_bench(int argc, FAR char *argv[])
+{
+  unsigned int iterations = CONFIG_EXAMPLES_USRSOCKTEST_BENCH_ITERATIONS;
+  int ret;
+
+  if (argc > 1)
+    {
+      iterations = strtoul(argv[1], NULL, 0);
+    }
+
+  g_bench_conf = usrsocktest_daemon_defconf;
+  g_bench_conf.endpoint_recv_avail_from_start = false;
+  g_bench_conf.endpoint_recv_avail = 0;
+  g_bench_conf.endpoint_echo = true;
+
+  ret = usrsocktest_daemon_start(&g_bench_conf);
+  if (ret < 0)
+    {
+      printf("Failed to start the daemon: %d\n", ret);
+      return EXIT_FAILURE;
+    }
+
+  ret = bench_latency(iterations);
+  if (ret >= 0)
+    {
+      ret = bench_throughput();
+    }
+
+  if (ret < 0)
+    {
+      printf("Benchmark failed: %d\n", ret);
+    }
+
+  usrsocktest_daemon_stop();
+  return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -714,7 +714,26 @@ static int sendto_request(int fd, FAR struct daemon_priv_s *priv,
     {
       /* Check if request has data. */
 
-      if (req->buflen > 0)
+      if (req->buflen > 0 && priv->conf->endpoint_echo)
+        {
+          uint8_t drain[64];
+
+          /* Take all of the data, the content does not matter. */
+
+          while (sendbuflen < req->buflen)
+            {
+              rlen = MIN(req->buflen - sendbuflen, sizeof(drain));
+              rlen = read(fd, drain, rlen);
+              if (rlen <= 0)
+                {
+                  ret = -EFAULT;
+                  goto prepare;
+                }
+
+              sendbuflen += rlen;
+            }
+        }
+      else if (req->buflen > 0)
         {
           sendbuflen = req->buflen;
           if (sendbuflen > sizeof(sendbuf))
@@ -812,7 +831,19 @@ prepare:
         }
     }
 
-  if (!tsock->block_send)
+  if (priv->conf->endpoint_echo && ret > 0)
+    {
+      /* The echoed data can be received now. */
+
+      tsock->recv_avail_bytes += ret;
+      wlen = tsock_send_event(fd, priv, tsock, USRSOCK_EVENT_SENDTO_READY |
+                                               USRSOCK_EVENT_RECVFROM_AVAIL);
+      if (wlen < 0)
+        {
+          return wlen;
+        }
+    }
+  else if (!tsock->block_send)
     {
       /* Let kernel-side know that there is space for more send data. */
 
@@ -832,7 +863,9 @@ static int recvfrom_request(int fd, FAR struct daemon_priv_s *priv,
   FAR struct usrsock_request_recvfrom_s *req = hdrbuf;
   FAR struct test_socket_s *tsock;
   ssize_t wlen;
+  size_t len;
   size_t i;
+  size_t j;
   int ret = 0;
   size_t outbuflen;
   struct sockaddr_in endpointaddr;
@@ -970,24 +1003,30 @@ prepare:
     {
       /* Send buffer */
 
-      for (i = 0; i < resp.reqack.result; i++)
+      for (i = 0; i < resp.reqack.result; i += len)
         {
-          char tmp = 'a' + i;
+          char tmp[64];
+
+          len = MIN(resp.reqack.result - i, sizeof(tmp));
+          for (j = 0; j < len; j++)
+            {
+              tmp[j] = 'a' + i + j;
+            }
 
           /* Check if MSG_PEEK flag is specified. */
 
           if ((req->flags & MSG_PEEK) != MSG_PEEK)
             {
-              tsock->recv_avail_bytes--;
+              tsock->recv_avail_bytes -= len;
             }
 
-          wlen = write(fd, &tmp, 1);
+          wlen = write(fd, tmp, len);
           if (wlen < 0)
             {
               return -errno;
             }
 
-          if (wlen != 1)
+          if (wlen != (ssize_t)len)
             {
               return -ENOSPC;
             }
@@ -1917,7 +1956,12 @@ static FAR void *usrsocktest_daemon(FAR void *param)
             }
         }
 
-      usleep(1);
+      /* Yield to the tests, unless the latency is being measured. */
+
+      if (!priv->conf->endpoint_echo)
+        {
+          usleep(1);
+        }
     }
   while (!stopped);
 
@@ -233,6 +233,13 @@ int main(int argc, FAR char *argv[])
   struct mallinfo mem_before;
   struct mallinfo mem_after;
 
+#ifdef CONFIG_EXAMPLES_USRSOCKTEST_BENCH
+  if (argc > 1 && strcmp(argv[1], "bench") == 0)
+    {
+      return usrsocktest_bench(argc - 1, argv + 1);
+    }
+#endif
+
   memset(&overall, 0, sizeof(overall));
 
   printf("Starting unit-tests...\n");
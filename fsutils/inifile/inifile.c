@@ -24,8 +24,13 @@
 
 #include <nuttx/config.h>
 
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <debug.h>
 
@@ -75,6 +80,30 @@ struct inifile_var_s
   FAR char *value;
 };
 
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+/* One variable of the index.  The strings point into the file image. */
+
+struct inifile_entry_s
+{
+  uint32_t hash;
+  uint32_t section;
+  FAR char *variable;
+  FAR char *value;
+};
+
+/* The state of one instance: the whole file read in memory, its sections
+ * and a hash table of the variables.
+ */
+
+struct inifile_state_s
+{
+  FAR char *image;
+  FAR char **sections;
+  FAR struct inifile_entry_s *entries;
+  uint32_t nsections;
+  uint32_t tablemask;           /* Size of entries - 1, a power of two */
+};
+#else
 /* A structure describes the state of one instance of the INI file parser */
 
 struct inifile_state_s
@@ -83,6 +112,7 @@ struct inifile_state_s
   int   nextch;
   char  line[CONFIG_FSUTILS_INIFILE_MAXLINE + 1];
 };
+#endif
 
 /****************************************************************************
  * Private Data
@@ -92,6 +122,7 @@ struct inifile_state_s
  * Private Function Prototypes
  ****************************************************************************/
 
+#ifndef CONFIG_FSUTILS_INIFILE_INDEX
 static bool inifile_next_line(FAR struct inifile_state_s *priv);
 static int  inifile_read_line(FAR struct inifile_state_s *priv);
 static int  inifile_read_noncomment_line(FAR struct inifile_state_s *priv);
@@ -102,6 +133,7 @@ static bool inifile_read_variable(FAR struct inifile_state_s *priv,
 static FAR char *
             inifile_find_section_variable(FAR struct inifile_state_s *priv,
               FAR const char *variable);
+#endif
 static FAR char *
             inifile_find_variable(FAR struct inifile_state_s *priv,
               FAR const char *section, FAR const char *variable);
@@ -110,6 +142,244 @@ static FAR char *
  * Private Functions
  ****************************************************************************/
 
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+/****************************************************************************
+ * Name:  inifile_hash
+ *
+ * Description:
+ *   Case insensitive FNV-1a hash of a variable name within a section.
+ *
+ ****************************************************************************/
+
+static uint32_t inifile_hash(uint32_t section, FAR const char *name)
+{
+  uint32_t hash = 2166136261u ^ section;
+
+  while (*name != '\0')
+    {
+      hash ^= (uint8_t)tolower(*name++);
+      hash *= 16777619u;
+    }
+
+  return hash;
+}
+
+/****************************************************************************
+ * Name:  inifile_next_line
+ *
+ * Description:
+ *   Turn the line at *pos into a NUL terminated string in place, the same
+ *   way inifile_read_line() does: carriage returns and leading whitespace
+ *   are dropped and the line is truncated to the maximum line length.
+ *   Returns the line and advances *pos to the next one.
+ *
+ ****************************************************************************/
+
+static FAR char *inifile_next_line(FAR char **pos, FAR const char *end)
+{
+  FAR char *line = *pos;
+  FAR char *src = *pos;
+  FAR char *dest = *pos;
+  int nbytes = 0;
+
+  while (src < end && *src != '\n')
+    {
+      if (*src != '\r' && nbytes < CONFIG_FSUTILS_INIFILE_MAXLINE &&
+          (nbytes || (*src != ' ' && *src != '\t')))
+        {
+          *dest++ = *src;
+          nbytes++;
+        }
+
+      src++;
+    }
+
+  /* The image has room for the terminator of a last line without newline,
+   * otherwise it replaces the newline or an earlier character.
+   */
+
+  *dest = '\0';
+  *pos = src + 1;
+  return line;
+}
+
+/****************************************************************************
+ * Name:  inifile_add_variable
+ *
+ * Description:
+ *   Add a variable to the hash table, unless an earlier one of the section
+ *   has the same name.
+ *
+ ****************************************************************************/
+
+static void inifile_add_variable(FAR struct inifile_state_s *priv,
+                                 uint32_t section, FAR char *variable,
+                                 FAR char *value)
+{
+  FAR struct inifile_entry_s *entry;
+  uint32_t hash = inifile_hash(section, variable);
+  uint32_t i;
+
+  for (i = hash & priv->tablemask; ; i = (i + 1) & priv->tablemask)
+    {
+      entry = &priv->entries[i];
+      if (entry->variable == NULL)
+        {
+          entry->hash     = hash;
+          entry->section  = section;
+          entry->variable = variable;
+          entry->value    = value;
+          return;
+        }
+
+      if (entry->hash == hash && entry->section == section &&
+          strcasecmp(entry->variable, variable) == 0)
+        {
+          return;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name:  inifile_build_index
+ *
+ * Description:
+ *   Parse the file image once.  Only the first section of a given name is
+ *   indexed, and a section ends at the first empty line or line starting
+ *   with a bracket, as when the file is scanned for each lookup.
+ *
+ ****************************************************************************/
+
+static int inifile_build_index(FAR struct inifile_state_s *priv,
+                               size_t size)
+{
+  FAR const char *end = priv->image + size;
+  FAR char *pos;
+  FAR char *line;
+  FAR char *ptr;
+  uint32_t nlines = 1;
+  uint32_t section = 0;
+  uint32_t tablesize;
+  bool insection = false;
+  uint32_t i;
+
+  for (pos = priv->image; pos < end; pos++)
+    {
+      nlines += *pos == '\n';
+    }
+
+  /* Each line is at most one section or one variable */
+
+  for (tablesize = 2; tablesize < 2 * nlines; tablesize <<= 1);
+
+  priv->tablemask = tablesize - 1;
+  priv->entries   = calloc(tablesize, sizeof(struct inifile_entry_s));
+  priv->sections  = malloc(nlines * sizeof(FAR char *));
+  if (priv->entries == NULL || priv->sections == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  for (pos = priv->image; pos < end; )
+    {
+      line = inifile_next_line(&pos, end);
+      if (line[0] == ';')
+        {
+          continue;
+        }
+
+      if (line[0] == '[' && strlen(line) >= 3)
+        {
+          ptr = strchr(&line[1], ']');
+          if (ptr)
+            {
+              *ptr = '\0';
+            }
+
+          for (i = 0; i < priv->nsections; i++)
+            {
+              if (strcasecmp(priv->sections[i], &line[1]) == 0)
+                {
+                  break;
+                }
+            }
+
+          insection = i == priv->nsections;
+          if (insection)
+            {
+              section = priv->nsections++;
+              priv->sections[section] = &line[1];
+            }
+        }
+      else if (line[0] == '\0' || line[0] == '[')
+        {
+          insection = false;
+        }
+      else if (insection && (ptr = strchr(&line[1], '=')) != NULL)
+        {
+          *ptr = '\0';
+          inifile_add_variable(priv, section, line, ptr + 1);
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name:  inifile_find_variable
+ *
+ * Description:
+ *   Obtains the specified string value for the specified variable name
+ *   within the specified section of the INI file.
+ *
+ ****************************************************************************/
+
+static FAR char *inifile_find_variable(FAR struct inifile_state_s *priv,
+                                       FAR const char *section,
+                                       FAR const char *variable)
+{
+  FAR struct inifile_entry_s *entry;
+  uint32_t hash;
+  uint32_t i;
+
+  iniinfo("section=\"%s\" variable=\"%s\"\n", section, variable);
+
+  for (i = 0; i < priv->nsections; i++)
+    {
+      if (strcasecmp(priv->sections[i], section) == 0)
+        {
+          break;
+        }
+    }
+
+  if (i == priv->nsections)
+    {
+      inidbg("ERROR: Section \"%s\" not found\n", section);
+      return NULL;
+    }
+
+  hash = inifile_hash(i, variable);
+  for (entry = &priv->entries[hash & priv->tablemask];
+       entry->variable != NULL;
+       entry = &priv->entries[(entry - priv->entries + 1) &
+                              priv->tablemask])
+    {
+      if (entry->hash == hash && entry->section == i &&
+          strcasecmp(entry->variable, variable) == 0)
+        {
+          /* An empty value is the same as no value */
+
+          iniinfo("Returning \"%s\"\n", entry->value);
+          return *entry->value ? entry->value : NULL;
+        }
+    }
+
+  iniinfo("Returning NULL\n");
+  return NULL;
+}
+
+#else /* CONFIG_FSUTILS_INIFILE_INDEX */
+
 /****************************************************************************
  * Name:  inifile_next_line
  *
@@ -463,6 +733,7 @@ static FAR char *inifile_find_variable(FAR struct inifile_state_s *priv,
   iniinfo("Returning 0x%p\n", ret);
   return ret;
 }
+#endif /* CONFIG_FSUTILS_INIFILE_INDEX */
 
 /****************************************************************************
  * Public Functions
@@ -478,6 +749,43 @@ static FAR char *inifile_find_variable(FAR struct inifile_state_s *priv,
 
 INIHANDLE inifile_initialize(FAR const char *inifile_name)
 {
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+  FAR struct inifile_state_s *priv;
+  FAR FILE *stream;
+  long size;
+
+  priv = zalloc(sizeof(struct inifile_state_s));
+  if (!priv)
+    {
+      inidbg("ERROR: Failed to allocate state structure\n");
+      return NULL;
+    }
+
+  /* Read the whole INI file in one go, with room for a final terminator */
+
+  stream = fopen(inifile_name, "r");
+  if (!stream)
+    {
+      inidbg("ERROR: Could not open \"%s\"\n", inifile_name);
+      free(priv);
+      return NULL;
+    }
+
+  if (fseek(stream, 0, SEEK_END) < 0 || (size = ftell(stream)) < 0 ||
+      fseek(stream, 0, SEEK_SET) < 0 ||
+      (priv->image = malloc(size + 1)) == NULL ||
+      fread(priv->image, 1, size, stream) != (size_t)size ||
+      inifile_build_index(priv, size) < 0)
+    {
+      inidbg("ERROR: Could not index \"%s\"\n", inifile_name);
+      fclose(stream);
+      inifile_uninitialize(priv);
+      return NULL;
+    }
+
+  fclose(stream);
+  return (INIHANDLE)priv;
+#else
   /* Allocate an INI file parser state structure */
 
   FAR struct inifile_state_s *priv =
@@ -506,6 +814,7 @@ INIHANDLE inifile_initialize(FAR const char *inifile_name)
       free(priv);
       return NULL;
     }
+#endif
 }
 
 /****************************************************************************
@@ -522,12 +831,20 @@ void inifile_uninitialize(INIHANDLE handle)
 
   if (priv)
     {
+#ifdef CONFIG_FSUTILS_INIFILE_INDEX
+      /* Release the file image and its index */
+
+      free(priv->image);
+      free(priv->sections);
+      free(priv->entries);
+#else
       /* Close the INI file stream */
 
       if (priv->instream)
         {
           fclose(priv->instream);
         }
+#endif
 
       /* Release the state structure */
 
@@ -34,6 +34,7 @@
 #include <unistd.h>
 
 #include <nuttx/fs/fs.h>
+#include <nuttx/mtd/mtd.h>
 
 #include "fsutils/mkfatfs.h"
 #include "fat32.h"
@@ -54,6 +55,33 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: mkfatfs_discard
+ *
+ * Description:
+ *   Erase the whole media if its driver supports it.  Nothing needs to be
+ *   cleared afterwards if it then reads as zeros.
+ *
+ ****************************************************************************/
+
+static void mkfatfs_discard(FAR struct fat_var_s *var)
+{
+  uint8_t erasestate;
+
+  if (ioctl(var->fv_fd, MTDIOC_BULKERASE, 0) < 0)
+    {
+      finfo("Media erase not supported: %d\n", errno);
+      return;
+    }
+
+  if (ioctl(var->fv_fd, MTDIOC_ERASESTATE,
+            (unsigned long)((uintptr_t)&erasestate)) >= 0 &&
+      erasestate == 0)
+    {
+      var->fv_erased = true;
+    }
+}
+
 /****************************************************************************
  * Name: fat_systime2fattime
  *
@@ -362,6 +390,29 @@ int mkfatfs(FAR const char *pathname, FAR struct fat_format_s *fmt)
 
   /* Write the filesystem to media */
 
+  /* And a zeroed buffer for large writes of the empty FAT and directory
+   * sectors, which are most of them.  Fall back to the sector buffer if
+   * there is not enough memory.
+   */
+
+  var.fv_nzero = CONFIG_MKFATFS_WRITE_SECTORS;
+  var.fv_zero  = (FAR uint8_t *)
+    fat_buffer_alloc(var.fv_nzero << var.fv_sectshift);
+  if (var.fv_zero != NULL)
+    {
+      memset(var.fv_zero, 0, var.fv_nzero << var.fv_sectshift);
+    }
+  else
+    {
+      var.fv_nzero = 0;
+    }
+
+  var.fv_erased = (fmt->ff_flags & MKFATFS_FLAG_ERASED) != 0;
+  if ((fmt->ff_flags & MKFATFS_FLAG_DISCARD) != 0)
+    {
+      mkfatfs_discard(&var);
+    }
+
   ret = mkfatfs_writefatfs(fmt, &var);
 
 errout_with_driver:
@@ -379,6 +430,11 @@ errout:
       free(var.fv_sect);
     }
 
+  if (var.fv_zero)
+    {
+      free(var.fv_zero);
+    }
+
   /* Return any reported errors */
 
   if (ret < 0)
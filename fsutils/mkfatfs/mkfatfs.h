@@ -26,6 +26,7 @@
  ****************************************************************************/
 
 #include <nuttx/config.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /****************************************************************************
@@ -72,6 +73,9 @@ struct fat_var_s
   uint32_t       fv_nfatsects;      /* Number of sectors in each FAT */
   uint32_t       fv_nclusters;      /* Number of clusters */
   uint8_t       *fv_sect;           /* Allocated working sector buffer */
+  uint8_t       *fv_zero;           /* Zeroed buffer of fv_nzero sectors */
+  uint32_t       fv_nzero;          /* 0 if it could not be allocated */
+  bool           fv_erased;         /* Media reads as zeros, skip them */
   uint8_t        fv_bootcodepatch;  /* FAT16/FAT32 Bootcode offset patch */
   const uint8_t *fv_bootcodeblob;   /* Points to boot code to put into MBR */
 };
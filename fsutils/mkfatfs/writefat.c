@@ -24,6 +24,7 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <sys/types.h>
 #include <inttypes.h>
 #include <stdint.h>
@@ -43,11 +44,10 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: mkfatfs_devwrite
+ * Name: mkfatfs_rawwrite
  *
  * Description:
- *   Write the content of the dedicate sector buffer beginning to the
- *   specified sector
+ *   Write nsectors sectors from buffer beginning at the specified sector
  *
  * Input:
  *    fmt  - User specified format parameters
@@ -58,23 +58,27 @@
  *
  ****************************************************************************/
 
-static int mkfatfs_devwrite(FAR const struct fat_format_s *fmt,
-                            FAR const struct fat_var_s *var, off_t sector)
+static int mkfatfs_rawwrite(FAR const struct fat_format_s *fmt,
+                            FAR const struct fat_var_s *var,
+                            FAR const uint8_t *buffer, off_t sector,
+                            uint32_t nsectors)
 {
   ssize_t nwritten;
   off_t seekpos;
   off_t fpos;
+  size_t size;
   int ret;
 
   /* Convert the sector number to a byte offset */
 
-  if (sector < 0 || sector >= (off_t)fmt->ff_nsectors)
+  if (sector < 0 || sector + nsectors > (off_t)fmt->ff_nsectors)
     {
       ferr("sector out of range: %ju\n", (intmax_t)sector);
       return -ESPIPE;
     }
 
   fpos = sector << var->fv_sectshift;
+  size = (size_t)nsectors << var->fv_sectshift;
 
   /* Seek to that offset */
 
@@ -92,26 +96,101 @@ static int mkfatfs_devwrite(FAR const struct fat_format_s *fmt,
       return -EINVAL;
     }
 
-  /* Write the sector to that offset.  Partial writes are not expected. */
+  /* Write the sectors to that offset.  Partial writes are not expected. */
 
-  nwritten = write(var->fv_fd, var->fv_sect, var->fv_sectorsize);
+  nwritten = write(var->fv_fd, buffer, size);
   if (nwritten < 0)
     {
       ret = -errno;
-      ferr("ERROR:  write failed: size=%" PRIu32 " pos=%jd error=%d\n",
-           var->fv_sectorsize, (intmax_t)fpos, ret);
+      ferr("ERROR:  write failed: size=%zu pos=%jd error=%d\n",
+           size, (intmax_t)fpos, ret);
       return ret;
     }
-  else if (nwritten != (ssize_t)var->fv_sectorsize)
+  else if (nwritten != (ssize_t)size)
     {
-      ferr("ERROR:  Partial write: size=%" PRIu32 " written=%zd\n",
-           var->fv_sectorsize, nwritten);
+      ferr("ERROR:  Partial write: size=%zu written=%zd\n",
+           size, nwritten);
       return -ENODATA;
     }
 
   return OK;
 }
 
+/****************************************************************************
+ * Name: mkfatfs_devwrite
+ *
+ * Description:
+ *   Write the content of the dedicate sector buffer beginning to the
+ *   specified sector
+ *
+ * Input:
+ *    fmt  - User specified format parameters
+ *    var  - Other format parameters that are not user specifiable
+ *
+ * Return:
+ *    None; caller is responsible for providing valid parameters.
+ *
+ ****************************************************************************/
+
+static int mkfatfs_devwrite(FAR const struct fat_format_s *fmt,
+                            FAR const struct fat_var_s *var, off_t sector)
+{
+  return mkfatfs_rawwrite(fmt, var, var->fv_sect, sector, 1);
+}
+
+/****************************************************************************
+ * Name: mkfatfs_zerowrite
+ *
+ * Description:
+ *   Clear nsectors sectors beginning at the specified sector, with writes
+ *   of up to fv_nzero sectors.  Nothing is written if the media is known
+ *   to already read as zeros.
+ *
+ * Input:
+ *    fmt  - User specified format parameters
+ *    var  - Other format parameters that are not user specifiable
+ *
+ * Return:
+ *    Zero on success; negated errno on failure
+ *
+ ****************************************************************************/
+
+static int mkfatfs_zerowrite(FAR const struct fat_format_s *fmt,
+                             FAR struct fat_var_s *var, off_t sector,
+                             uint32_t nsectors)
+{
+  uint32_t nwrite;
+  int ret = OK;
+
+  if (var->fv_erased)
+    {
+      return OK;
+    }
+
+  if (var->fv_nzero == 0)
+    {
+      /* No large buffer, go through the sector buffer */
+
+      memset(var->fv_sect, 0, var->fv_sectorsize);
+      for (; nsectors > 0 && ret >= 0; nsectors--)
+        {
+          ret = mkfatfs_devwrite(fmt, var, sector++);
+        }
+
+      return ret;
+    }
+
+  while (nsectors > 0 && ret >= 0)
+    {
+      nwrite = MIN(nsectors, var->fv_nzero);
+      ret = mkfatfs_rawwrite(fmt, var, var->fv_zero, sector, nwrite);
+      sector += nwrite;
+      nsectors -= nwrite;
+    }
+
+  return ret;
+}
+
 /****************************************************************************
  * Name: mkfatfs_initmbr
  *
@@ -410,7 +489,6 @@ static inline void mkfatfs_initrootdir(FAR struct fat_format_s *fmt,
 static inline int mkfatfs_writembr(FAR struct fat_format_s *fmt,
                                    FAR struct fat_var_s *var)
 {
-  int sectno;
   int ret;
 
   /* Create an image of the configured master boot record */
@@ -423,10 +501,9 @@ static inline int mkfatfs_writembr(FAR struct fat_format_s *fmt,
 
   /* Write all of the reserved sectors */
 
-  memset(var->fv_sect, 0, var->fv_sectorsize);
-  for (sectno = 1; sectno < fmt->ff_rsvdseccount && ret >= 0; sectno++)
+  if (ret >= 0 && fmt->ff_rsvdseccount > 1)
     {
-      ret = mkfatfs_devwrite(fmt, var, sectno);
+      ret = mkfatfs_zerowrite(fmt, var, 1, fmt->ff_rsvdseccount - 1);
     }
 
   /* Write FAT32-specific sectors */
@@ -485,75 +562,70 @@ static inline int mkfatfs_writefat(FAR struct fat_format_s *fmt,
 {
   off_t offset = fmt->ff_rsvdseccount;
   uint8_t fatno;
-  uint32_t sectno;
   int ret;
 
   /* Loop for each FAT copy */
 
   for (fatno = 0; fatno < fmt->ff_nfats; fatno++)
     {
-      /* Loop for each sector in the FAT */
+      /* Mark cluster allocations in sector one of each FAT */
 
-      for (sectno = 0; sectno < var->fv_nfatsects; sectno++)
+      memset(var->fv_sect, 0, var->fv_sectorsize);
+      switch (fmt->ff_fattype)
         {
-          memset(var->fv_sect, 0, var->fv_sectorsize);
-
-          /* Mark cluster allocations in sector one of each FAT */
+          case 12:
+            /* Mark the first two full FAT entries -- 24 bits,
+             * 3 bytes total
+             */
 
-          if (sectno == 0)
-            {
-              memset(var->fv_sect, 0, var->fv_sectorsize);
-              switch (fmt->ff_fattype)
-                {
-                  case 12:
-                    /* Mark the first two full FAT entries -- 24 bits,
-                     * 3 bytes total
-                     */
+            memset(var->fv_sect, 0xff, 3);
+            break;
 
-                    memset(var->fv_sect, 0xff, 3);
-                    break;
+          case 16:
+            /* Mark the first two full FAT entries -- 32 bits,
+             * 4 bytes total
+             */
 
-                  case 16:
-                    /* Mark the first two full FAT entries -- 32 bits,
-                     * 4 bytes total
-                     */
+            memset(var->fv_sect, 0xff, 4);
+            break;
 
-                    memset(var->fv_sect, 0xff, 4);
-                    break;
+          case 32:
+          default: /* Shouldn't happen */
 
-                  case 32:
-                  default: /* Shouldn't happen */
+            /* Mark the first two full FAT entries -- 64 bits,
+             * 8 bytes total
+             */
 
-                    /* Mark the first two full FAT entries -- 64 bits,
-                     * 8 bytes total
-                     */
+            memset(var->fv_sect, 0xff, 8);
 
-                    memset(var->fv_sect, 0xff, 8);
+            /* Cluster 2 is used as the root directory.
+             * Mark as EOF
+             */
 
-                    /* Cluster 2 is used as the root directory.
-                     * Mark as EOF
-                     */
-
-                    var->fv_sect[8] =  0xf8;
-                    memset(&var->fv_sect[9], 0xff, 3);
-                    break;
-                }
+            var->fv_sect[8] =  0xf8;
+            memset(&var->fv_sect[9], 0xff, 3);
+            break;
+        }
 
-              /* Save the media type in the first byte of the FAT */
+      /* Save the media type in the first byte of the FAT */
 
-              var->fv_sect[0] = FAT_DEFAULT_MEDIA_TYPE;
-            }
+      var->fv_sect[0] = FAT_DEFAULT_MEDIA_TYPE;
 
-          /* Write the FAT sector */
+      /* Write the first FAT sector, then clear the rest of the FAT */
 
-          ret = mkfatfs_devwrite(fmt, var, offset);
-          if (ret < 0)
-            {
-              return ret;
-            }
+      ret = mkfatfs_devwrite(fmt, var, offset);
+      if (ret < 0)
+        {
+          return ret;
+        }
 
-          offset++;
+      ret = mkfatfs_zerowrite(fmt, var, offset + 1, var->fv_nfatsects - 1);
+      if (ret < 0)
+        {
+          return ret;
         }
+
+      offset += var->fv_nfatsects;
     }
 
   return OK;
@@ -579,30 +651,22 @@ static inline int mkfatfs_writerootdir(FAR struct fat_format_s *fmt,
 {
   off_t offset = fmt->ff_rsvdseccount + fmt->ff_nfats * var->fv_nfatsects;
   int ret;
-  int i;
 
   /* Write the root directory after the last FAT. This is the root directory
-   * area for FAT12/16, and the first cluster on FAT32.
+   * area for FAT12/16, and the first cluster on FAT32.  Only its first
+   * sector holds data, the volume label.
    */
 
-  for (i = 0; i < var->fv_nrootdirsects; i++)
-    {
-      /* Format the next sector of the root directory */
-
-      mkfatfs_initrootdir(fmt, var, i);
-
-      /* Write the next sector of the root directory */
-
-      ret = mkfatfs_devwrite(fmt, var, offset);
-      if (ret < 0)
-        {
-          return ret;
-        }
+  mkfatfs_initrootdir(fmt, var, 0);
 
-      offset++;
+  ret = mkfatfs_devwrite(fmt, var, offset);
+  if (ret < 0)
+    {
+      return ret;
     }
 
-  return 0;
+  return mkfatfs_zerowrite(fmt, var, offset + 1,
+                           var->fv_nrootdirsects - 1);
 }
 
 /****************************************************************************
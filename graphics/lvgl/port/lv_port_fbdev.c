@@ -31,7 +31,16 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <time.h>
+#if defined(CONFIG_LV_PORT_FBDEV_ASYNC_FLUSH)
+#  include <pthread.h>
+#  include <semaphore.h>
+#endif
+#if defined(CONFIG_LV_PORT_FBDEV_STATS_MQUEUE)
+#  include <mqueue.h>
+#endif
 #include "lv_port_fbdev.h"
+#include "lv_port_gpu.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -43,6 +52,17 @@
 #  define FBDEV_UPDATE_AREA(obj, area)
 #endif
 
+#if defined(CONFIG_LV_PORT_FBDEV_STATS)
+#  define FBDEV_STATS_NOW()                   fbdev_now_us()
+#  define FBDEV_STATS_COPY(obj, area)         fbdev_stats_copy(obj, area)
+#  define FBDEV_STATS_FLUSH(obj, start, last) \
+     fbdev_stats_flush(obj, start, last)
+#else
+#  define FBDEV_STATS_NOW()                   0
+#  define FBDEV_STATS_COPY(obj, area)
+#  define FBDEV_STATS_FLUSH(obj, start, last) UNUSED(start)
+#endif
+
 /****************************************************************************
  * Private Type Declarations
  ****************************************************************************/
@@ -65,6 +85,32 @@ struct fbdev_obj_s
   struct fb_planeinfo_s pinfo;
 
   bool double_buffer;
+
+#if defined(CONFIG_LV_PORT_FBDEV_STATS)
+  struct lv_port_fbdev_stats_s stats;  /* Last complete frame */
+  struct lv_port_fbdev_stats_s frame;  /* Frame in progress */
+  uint32_t render_start;
+#endif
+
+#if defined(CONFIG_LV_PORT_FBDEV_STATS_MQUEUE)
+  mqd_t stats_mq;                      /* Receives render_us per frame */
+#endif
+
+#if defined(CONFIG_LV_PORT_FBDEV_STATS_OVERLAY)
+  FAR lv_obj_t *overlay;
+#endif
+
+#if defined(CONFIG_LV_PORT_FBDEV_ASYNC_FLUSH)
+  /* Area handed to the flush thread */
+
+  pthread_t flush_thread;
+  sem_t flush_sem;
+  sem_t wait_sem;
+  lv_area_t flush_area;
+  FAR lv_color_t *flush_color;
+  lv_area_t update_area;
+  bool flush_last;
+#endif
 };
 
 /****************************************************************************
@@ -79,6 +125,92 @@ struct fbdev_obj_s
  * Private Functions
  ****************************************************************************/
 
+#if defined(CONFIG_LV_PORT_FBDEV_STATS)
+
+/****************************************************************************
+ * Name: fbdev_now_us
+ ****************************************************************************/
+
+static uint32_t fbdev_now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: fbdev_stats_copy
+ ****************************************************************************/
+
+static void fbdev_stats_copy(FAR struct fbdev_obj_s *fbdev_obj,
+                             FAR const lv_area_t *area_p)
+{
+  fbdev_obj->frame.copy_bytes += lv_area_get_size(area_p) *
+                                 sizeof(lv_color_t);
+  fbdev_obj->frame.copy_areas++;
+}
+
+/****************************************************************************
+ * Name: fbdev_stats_flush
+ *
+ * Description:
+ *   Account a flush that began at start, and publish the frame after the
+ *   last one.
+ *
+ ****************************************************************************/
+
+static void fbdev_stats_flush(FAR struct fbdev_obj_s *fbdev_obj,
+                              uint32_t start, bool last)
+{
+  uint32_t now = fbdev_now_us();
+
+  fbdev_obj->frame.flush_us += now - start;
+
+  if (last)
+    {
+      fbdev_obj->frame.render_us = now - fbdev_obj->render_start;
+      fbdev_obj->frame.frames = fbdev_obj->stats.frames + 1;
+      fbdev_obj->stats = fbdev_obj->frame;
+
+#if defined(CONFIG_LV_PORT_FBDEV_STATS_MQUEUE)
+      /* Never wait for the reader: frames it misses are just dropped */
+
+      if (fbdev_obj->stats_mq != (mqd_t)-1)
+        {
+          mq_send(fbdev_obj->stats_mq,
+                  (FAR const char *)&fbdev_obj->stats.render_us,
+                  sizeof(fbdev_obj->stats.render_us), 0);
+        }
+#endif
+    }
+}
+
+#if defined(CONFIG_LV_PORT_FBDEV_STATS_OVERLAY)
+
+/****************************************************************************
+ * Name: fbdev_stats_overlay_cb
+ ****************************************************************************/
+
+static void fbdev_stats_overlay_cb(FAR lv_timer_t *timer)
+{
+  FAR struct fbdev_obj_s *fbdev_obj = timer->user_data;
+  FAR struct lv_port_fbdev_stats_s *stats = &fbdev_obj->stats;
+  FAR lv_obj_t *label = fbdev_obj->overlay;
+
+  lv_label_set_text_fmt(label,
+                        "render %" PRIu32 " us\n"
+                        "flush %" PRIu32 " us\n"
+                        "sync %" PRIu32 " us\n"
+                        "copy %" PRIu32 " B / %u (-%u)",
+                        stats->render_us, stats->flush_us, stats->sync_us,
+                        stats->copy_bytes, stats->copy_areas,
+                        stats->merged_areas);
+}
+
+#endif /* CONFIG_LV_PORT_FBDEV_STATS_OVERLAY */
+#endif /* CONFIG_LV_PORT_FBDEV_STATS */
+
 #if defined(CONFIG_FB_UPDATE)
 
 /****************************************************************************
@@ -224,6 +356,95 @@ static bool fbdev_check_inv_area_covered(FAR lv_disp_t *disp_refr,
   return false;
 }
 
+/****************************************************************************
+ * Name: fbdev_merge_areas
+ *
+ * Description:
+ *   Reduce the number of sync copies.  Areas nearly as wide as the screen
+ *   are widened to whole rows, which are contiguous in the buffers, and
+ *   two areas are merged when their bounding box costs no more than
+ *   CONFIG_LV_PORT_FBDEV_MERGE_COST pixels over the two copies.
+ *
+ * Returned Value:
+ *   The number of areas left.
+ *
+ ****************************************************************************/
+
+static int fbdev_merge_areas(FAR lv_area_t *areas, int len,
+                             lv_coord_t hor_res)
+{
+  lv_area_t merged;
+  bool again;
+  int i;
+  int j;
+
+  for (i = 0; i < len; i++)
+    {
+      if (lv_area_get_width(&areas[i]) * 4 >= hor_res * 3)
+        {
+          areas[i].x1 = 0;
+          areas[i].x2 = hor_res - 1;
+        }
+    }
+
+  do
+    {
+      again = false;
+
+      for (i = 0; i < len; i++)
+        {
+          for (j = i + 1; j < len; j++)
+            {
+              _lv_area_join(&merged, &areas[i], &areas[j]);
+
+              if (lv_area_get_size(&merged) >
+                  lv_area_get_size(&areas[i]) +
+                  lv_area_get_size(&areas[j]) +
+                  CONFIG_LV_PORT_FBDEV_MERGE_COST)
+                {
+                  continue;
+                }
+
+              areas[i] = merged;
+              areas[j--] = areas[--len];
+              again = true;
+            }
+        }
+    }
+  while (again);
+
+  return len;
+}
+
+/****************************************************************************
+ * Name: fbdev_sync_area
+ ****************************************************************************/
+
+static void fbdev_sync_area(FAR struct fbdev_obj_s *fbdev_obj,
+                            FAR lv_draw_ctx_t *draw_ctx,
+                            lv_coord_t hor_res,
+                            FAR const lv_area_t *area_p)
+{
+#if !defined(CONFIG_LV_PORT_USE_GPU)
+  /* Whole rows are a single block */
+
+  if (lv_area_get_width(area_p) == hor_res)
+    {
+      size_t offset = area_p->y1 * hor_res * sizeof(lv_color_t);
+
+      lv_memcpy((FAR uint8_t *)fbdev_obj->act_buffer + offset,
+                (FAR uint8_t *)fbdev_obj->last_buffer + offset,
+                lv_area_get_size(area_p) * sizeof(lv_color_t));
+      return;
+    }
+#endif
+
+  draw_ctx->buffer_copy(
+    draw_ctx,
+    fbdev_obj->act_buffer, hor_res, area_p,
+    fbdev_obj->last_buffer, hor_res, area_p);
+}
+
 /****************************************************************************
  * Name: fbdev_render_start
  ****************************************************************************/
@@ -234,8 +455,15 @@ static void fbdev_render_start(FAR lv_disp_drv_t *disp_drv)
   FAR lv_disp_t *disp_refr;
   FAR lv_draw_ctx_t *draw_ctx;
   lv_coord_t hor_res;
+  uint32_t start;
+  int len = 0;
   int i;
 
+#if defined(CONFIG_LV_PORT_FBDEV_STATS)
+  memset(&fbdev_obj->frame, 0, sizeof(fbdev_obj->frame));
+  fbdev_obj->render_start = fbdev_now_us();
+#endif
+
   /* No need sync buffer when inv_areas_len == 0 */
 
   if (fbdev_obj->inv_areas_len == 0)
@@ -246,10 +474,13 @@ static void fbdev_render_start(FAR lv_disp_drv_t *disp_drv)
 
   LV_LOG_TRACE("Start sync %d areas...", fbdev_obj->inv_areas_len);
 
+  start = FBDEV_STATS_NOW();
   disp_refr = _lv_refr_get_disp_refreshing();
   draw_ctx = disp_drv->draw_ctx;
   hor_res = disp_drv->hor_res;
 
+  /* Keep the areas of the previous frame that this one won't redraw */
+
   for (i = 0; i < fbdev_obj->inv_areas_len; i++)
     {
       FAR const lv_area_t *last_area = &fbdev_obj->inv_areas[i];
@@ -266,16 +497,33 @@ static void fbdev_render_start(FAR lv_disp_drv_t *disp_drv)
           continue;
         }
 
-      /* Sync the inv area of ​​the previous frame */
+      fbdev_obj->inv_areas[len++] = *last_area;
+    }
 
-      draw_ctx->buffer_copy(
-        draw_ctx,
-        fbdev_obj->act_buffer, hor_res, last_area,
-        fbdev_obj->last_buffer, hor_res, last_area);
+  i = len;
+  len = fbdev_merge_areas(fbdev_obj->inv_areas, len, hor_res);
 
-      LV_LOG_TRACE("Copied");
+#if defined(CONFIG_LV_PORT_FBDEV_STATS)
+  fbdev_obj->frame.merged_areas = i - len;
+#endif
+
+  /* Sync the inv area of ​​the previous frame */
+
+  for (i = 0; i < len; i++)
+    {
+      fbdev_sync_area(fbdev_obj, draw_ctx, hor_res,
+                      &fbdev_obj->inv_areas[i]);
+      FBDEV_STATS_COPY(fbdev_obj, &fbdev_obj->inv_areas[i]);
     }
 
+  LV_LOG_TRACE("Copied %d areas", len);
+
+#if defined(CONFIG_LV_PORT_FBDEV_STATS)
+  fbdev_obj->frame.sync_us = fbdev_now_us() - start;
+#else
+  UNUSED(start);
+#endif
+
   fbdev_obj->inv_areas_len = 0;
 }
 
@@ -288,6 +536,7 @@ static void fbdev_flush_direct(FAR lv_disp_drv_t *disp_drv,
                                FAR lv_color_t *color_p)
 {
   FAR struct fbdev_obj_s *fbdev_obj = disp_drv->user_data;
+  uint32_t start;
 
   /* Commit the buffer after the last flush */
 
@@ -297,9 +546,11 @@ static void fbdev_flush_direct(FAR lv_disp_drv_t *disp_drv,
       return;
     }
 
+  start = FBDEV_STATS_NOW();
   fbdev_switch_buffer(fbdev_obj);
 
   FBDEV_UPDATE_AREA(fbdev_obj, area_p);
+  FBDEV_STATS_FLUSH(fbdev_obj, start, true);
 
   /* Tell the flushing is ready */
 
@@ -348,15 +599,13 @@ static void fbdev_update_part(FAR struct fbdev_obj_s *fbdev_obj,
 }
 
 /****************************************************************************
- * Name: fbdev_flush_normal
+ * Name: fbdev_copy_area
  ****************************************************************************/
 
-static void fbdev_flush_normal(FAR lv_disp_drv_t *disp_drv,
-                               FAR const lv_area_t *area_p,
-                               FAR lv_color_t *color_p)
+static void fbdev_copy_area(FAR struct fbdev_obj_s *fbdev_obj,
+                            FAR const lv_area_t *area_p,
+                            FAR lv_color_t *color_p)
 {
-  FAR struct fbdev_obj_s *fbdev_obj = disp_drv->user_data;
-
   int x1 = area_p->x1;
   int y1 = area_p->y1;
   int y2 = area_p->y2;
@@ -368,6 +617,17 @@ static void fbdev_flush_normal(FAR lv_disp_drv_t *disp_drv,
   int hor_size = w * sizeof(lv_color_t);
   FAR lv_color_t *cur_pos = fbp + y1 * fb_xres + x1;
 
+  FBDEV_STATS_COPY(fbdev_obj, area_p);
+
+#if defined(CONFIG_LV_PORT_USE_GPU)
+  if (lv_port_gpu_blit(cur_pos, fb_xres, color_p, w, w,
+                       lv_area_get_height(area_p)) >= 0)
+    {
+      lv_port_gpu_wait();
+      return;
+    }
+#endif
+
   LV_LOG_TRACE("start copy");
 
   for (y = y1; y <= y2; y++)
@@ -378,10 +638,115 @@ static void fbdev_flush_normal(FAR lv_disp_drv_t *disp_drv,
     }
 
   LV_LOG_TRACE("end copy");
+}
+
+/****************************************************************************
+ * Name: fbdev_flush_normal
+ ****************************************************************************/
+
+static void fbdev_flush_normal(FAR lv_disp_drv_t *disp_drv,
+                               FAR const lv_area_t *area_p,
+                               FAR lv_color_t *color_p)
+{
+  FAR struct fbdev_obj_s *fbdev_obj = disp_drv->user_data;
+  uint32_t start = FBDEV_STATS_NOW();
+  bool last = lv_disp_flush_is_last(disp_drv);
 
+  fbdev_copy_area(fbdev_obj, area_p, color_p);
   fbdev_update_part(fbdev_obj, disp_drv, area_p);
+  FBDEV_STATS_FLUSH(fbdev_obj, start, last);
 }
 
+#if defined(CONFIG_LV_PORT_FBDEV_ASYNC_FLUSH)
+
+/****************************************************************************
+ * Name: fbdev_flush_thread
+ *
+ * Description:
+ *   Copy the flushed areas to the framebuffer while LVGL renders the next
+ *   area in the other draw buffer.
+ *
+ ****************************************************************************/
+
+static FAR void *fbdev_flush_thread(FAR void *arg)
+{
+  FAR struct fbdev_obj_s *fbdev_obj = arg;
+  uint32_t start;
+
+  for (; ; )
+    {
+      if (sem_wait(&fbdev_obj->flush_sem) < 0)
+        {
+          continue;
+        }
+
+      start = FBDEV_STATS_NOW();
+      fbdev_copy_area(fbdev_obj, &fbdev_obj->flush_area,
+                      fbdev_obj->flush_color);
+
+      if (fbdev_obj->flush_last)
+        {
+          FBDEV_UPDATE_AREA(fbdev_obj, &fbdev_obj->update_area);
+        }
+
+      FBDEV_STATS_FLUSH(fbdev_obj, start, fbdev_obj->flush_last);
+
+      sem_post(&fbdev_obj->wait_sem);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: fbdev_flush_async
+ ****************************************************************************/
+
+static void fbdev_flush_async(FAR lv_disp_drv_t *disp_drv,
+                              FAR const lv_area_t *area_p,
+                              FAR lv_color_t *color_p)
+{
+  FAR struct fbdev_obj_s *fbdev_obj = disp_drv->user_data;
+  FAR lv_area_t *final_area = &fbdev_obj->final_area;
+
+  if (final_area->x1 < 0)
+    {
+      *final_area = *area_p;
+    }
+  else
+    {
+      _lv_area_join(final_area, final_area, area_p);
+    }
+
+  fbdev_obj->flush_area = *area_p;
+  fbdev_obj->flush_color = color_p;
+  fbdev_obj->flush_last = lv_disp_flush_is_last(disp_drv);
+
+  if (fbdev_obj->flush_last)
+    {
+      fbdev_obj->update_area = *final_area;
+      final_area->x1 = -1;
+    }
+
+  sem_post(&fbdev_obj->flush_sem);
+}
+
+/****************************************************************************
+ * Name: fbdev_flush_wait
+ ****************************************************************************/
+
+static void fbdev_flush_wait(FAR lv_disp_drv_t *disp_drv)
+{
+  FAR struct fbdev_obj_s *fbdev_obj = disp_drv->user_data;
+
+  sem_wait(&fbdev_obj->wait_sem);
+
+  /* Tell the flushing is ready */
+
+  lv_disp_flush_ready(disp_drv);
+}
+
+#endif /* CONFIG_LV_PORT_FBDEV_ASYNC_FLUSH */
+
 /****************************************************************************
  * Name: fbdev_get_pinfo
  ****************************************************************************/
@@ -502,6 +867,10 @@ static FAR lv_disp_t *fbdev_init(FAR struct fbdev_obj_s *state)
   disp_drv->hor_res = fb_xres;
   disp_drv->ver_res = fb_yres;
 
+#if defined(CONFIG_LV_PORT_USE_GPU)
+  lv_port_gpu_drv_init(disp_drv);
+#endif
+
   if (fbdev_obj->double_buffer)
     {
       LV_LOG_INFO("Double buffer mode");
@@ -528,6 +897,40 @@ static FAR lv_disp_t *fbdev_init(FAR struct fbdev_obj_s *state)
         }
 
       disp_drv->flush_cb = fbdev_flush_normal;
+#if defined(CONFIG_LV_PORT_FBDEV_STATS)
+      disp_drv->render_start_cb = fbdev_render_start;
+#endif
+
+#if defined(CONFIG_LV_PORT_FBDEV_ASYNC_FLUSH)
+      /* Render in one buffer while the other one is copied */
+
+      buf2 = malloc(fb_size * sizeof(lv_color_t));
+      if (buf2 != NULL)
+        {
+          sem_init(&fbdev_obj->flush_sem, 0, 0);
+          sem_init(&fbdev_obj->wait_sem, 0, 0);
+
+          if (pthread_create(&fbdev_obj->flush_thread, NULL,
+                             fbdev_flush_thread, fbdev_obj) == 0)
+            {
+              LV_LOG_INFO("Asynchronous flush");
+              disp_drv->flush_cb = fbdev_flush_async;
+              disp_drv->wait_cb = fbdev_flush_wait;
+            }
+          else
+            {
+              sem_destroy(&fbdev_obj->flush_sem);
+              sem_destroy(&fbdev_obj->wait_sem);
+              free(buf2);
+              buf2 = NULL;
+            }
+        }
+
+      if (buf2 == NULL)
+        {
+          LV_LOG_WARN("Asynchronous flush not available");
+        }
+#endif
     }
 
   lv_disp_draw_buf_init(&(fbdev_obj->disp_draw_buf), buf1, buf2, fb_size);
@@ -546,6 +949,35 @@ static FAR lv_disp_t *fbdev_init(FAR struct fbdev_obj_s *state)
     }
 #endif
 
+#if defined(CONFIG_LV_PORT_FBDEV_STATS_MQUEUE)
+  fbdev_obj->stats_mq = (mqd_t)-1;
+  if (CONFIG_LV_PORT_FBDEV_STATS_MQUEUE[0] != '\0')
+    {
+      struct mq_attr attr;
+
+      memset(&attr, 0, sizeof(attr));
+      attr.mq_maxmsg  = 32;
+      attr.mq_msgsize = sizeof(uint32_t);
+      fbdev_obj->stats_mq = mq_open(CONFIG_LV_PORT_FBDEV_STATS_MQUEUE,
+                                    O_WRONLY | O_CREAT | O_NONBLOCK,
+                                    0666, &attr);
+      if (fbdev_obj->stats_mq == (mqd_t)-1)
+        {
+          LV_LOG_WARN("frame time queue open failed: %d", errno);
+        }
+    }
+#endif
+
+#if defined(CONFIG_LV_PORT_FBDEV_STATS_OVERLAY)
+  fbdev_obj->overlay =
+    lv_label_create(lv_disp_get_layer_sys(fbdev_obj->disp));
+  lv_obj_set_style_bg_opa(fbdev_obj->overlay, LV_OPA_50, 0);
+  lv_obj_set_style_bg_color(fbdev_obj->overlay, lv_color_black(), 0);
+  lv_obj_set_style_text_color(fbdev_obj->overlay, lv_color_white(), 0);
+  lv_obj_align(fbdev_obj->overlay, LV_ALIGN_TOP_RIGHT, 0, 0);
+  lv_timer_create(fbdev_stats_overlay_cb, 1000, fbdev_obj);
+#endif
+
   return fbdev_obj->disp;
 
 failed:
@@ -673,3 +1105,25 @@ FAR lv_disp_t *lv_port_fbdev_init(FAR const char *dev_path)
 
   return disp;
 }
+
+#if defined(CONFIG_LV_PORT_FBDEV_STATS)
+/****************************************************************************
+ * Name: lv_port_fbdev_get_stats
+ *
+ * Description:
+ *   Get the measurements of the last frame.
+ *
+ * Input Parameters:
+ *   disp  - Display returned by lv_port_fbdev_init().
+ *   stats - Measurements.
+ *
+ ****************************************************************************/
+
+void lv_port_fbdev_get_stats(FAR lv_disp_t *disp,
+                             FAR struct lv_port_fbdev_stats_s *stats)
+{
+  FAR struct fbdev_obj_s *fbdev_obj = disp->driver->user_data;
+
+  *stats = fbdev_obj->stats;
+}
+#endif
@@ -38,6 +38,23 @@
  * Type Definitions
  ****************************************************************************/
 
+#if defined(CONFIG_LV_PORT_FBDEV_STATS)
+
+/* Measurements of the last frame, times in microseconds */
+
+struct lv_port_fbdev_stats_s
+{
+  uint32_t frames;       /* Frames flushed since init */
+  uint32_t render_us;    /* Render start to last flush */
+  uint32_t flush_us;     /* Flushes, framebuffer copies included */
+  uint32_t sync_us;      /* Back buffer sync of double buffering */
+  uint32_t copy_bytes;   /* Bytes copied by flushes and sync */
+  uint16_t copy_areas;   /* Copies made by flushes and sync */
+  uint16_t merged_areas; /* Sync areas removed by merging */
+};
+
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -70,6 +87,23 @@ extern "C"
 
 FAR lv_disp_t *lv_port_fbdev_init(FAR const char *dev_path);
 
+#if defined(CONFIG_LV_PORT_FBDEV_STATS)
+/****************************************************************************
+ * Name: lv_port_fbdev_get_stats
+ *
+ * Description:
+ *   Get the measurements of the last frame.
+ *
+ * Input Parameters:
+ *   disp  - Display returned by lv_port_fbdev_init().
+ *   stats - Measurements.
+ *
+ ****************************************************************************/
+
+void lv_port_fbdev_get_stats(FAR lv_disp_t *disp,
+                             FAR struct lv_port_fbdev_stats_s *stats);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
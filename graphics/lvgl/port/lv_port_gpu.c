@@ -0,0 +1,263 @@
+/****************************************************************************
+ * apps/graphics/lvgl/port/lv_port_gpu.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <errno.h>
+#include <pthread.h>
+#include "lv_port_gpu.h"
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static FAR const struct lv_port_gpu_ops_s *g_gpu_ops;
+
+/* The render loop and the flush worker of a display port share the
+ * accelerator.
+ */
+
+static pthread_mutex_t g_gpu_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: gpu_fill
+ ****************************************************************************/
+
+static int gpu_fill(FAR lv_color_t *dst, lv_coord_t dst_stride,
+                    lv_coord_t w, lv_coord_t h,
+                    lv_color_t color, lv_opa_t opa)
+{
+  int ret = -ENOTSUP;
+
+  if (g_gpu_ops->fill != NULL)
+    {
+      pthread_mutex_lock(&g_gpu_lock);
+      ret = g_gpu_ops->fill(g_gpu_ops->priv, dst, dst_stride, w, h,
+                            color, opa);
+      pthread_mutex_unlock(&g_gpu_lock);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: gpu_blit
+ ****************************************************************************/
+
+static int gpu_blit(FAR lv_color_t *dst, lv_coord_t dst_stride,
+                    FAR const lv_color_t *src, lv_coord_t src_stride,
+                    lv_coord_t w, lv_coord_t h, lv_opa_t opa)
+{
+  int ret = -ENOTSUP;
+
+  if (g_gpu_ops->blit != NULL)
+    {
+      pthread_mutex_lock(&g_gpu_lock);
+      ret = g_gpu_ops->blit(g_gpu_ops->priv, dst, dst_stride, src,
+                            src_stride, w, h, opa);
+      pthread_mutex_unlock(&g_gpu_lock);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: gpu_blend
+ *
+ * Description:
+ *   Blend without mask on the accelerator, anything else in software.
+ *
+ ****************************************************************************/
+
+static void gpu_blend(FAR lv_draw_ctx_t *draw_ctx,
+                      FAR const lv_draw_sw_blend_dsc_t *dsc)
+{
+  FAR lv_color_t *dest_buf;
+  FAR const lv_color_t *src_buf;
+  lv_coord_t dest_stride;
+  lv_coord_t src_stride;
+  lv_area_t blend_area;
+  int ret = -ENOTSUP;
+
+  if (!_lv_area_intersect(&blend_area, dsc->blend_area,
+                          draw_ctx->clip_area))
+    {
+      return;
+    }
+
+  if (dsc->mask_buf == NULL && dsc->opa > LV_OPA_MIN &&
+      dsc->blend_mode == LV_BLEND_MODE_NORMAL &&
+      lv_area_get_size(&blend_area) >= CONFIG_LV_PORT_GPU_MIN_AREA)
+    {
+      dest_stride = lv_area_get_width(draw_ctx->buf_area);
+      dest_buf = (FAR lv_color_t *)draw_ctx->buf +
+                 dest_stride * (blend_area.y1 - draw_ctx->buf_area->y1) +
+                 (blend_area.x1 - draw_ctx->buf_area->x1);
+
+      if (dsc->src_buf != NULL)
+        {
+          src_stride = lv_area_get_width(dsc->blend_area);
+          src_buf = dsc->src_buf +
+                    src_stride * (blend_area.y1 - dsc->blend_area->y1) +
+                    (blend_area.x1 - dsc->blend_area->x1);
+
+          ret = gpu_blit(dest_buf, dest_stride, src_buf, src_stride,
+                         lv_area_get_width(&blend_area),
+                         lv_area_get_height(&blend_area), dsc->opa);
+        }
+      else
+        {
+          ret = gpu_fill(dest_buf, dest_stride,
+                         lv_area_get_width(&blend_area),
+                         lv_area_get_height(&blend_area),
+                         dsc->color, dsc->opa);
+        }
+    }
+
+  if (ret < 0)
+    {
+      /* The software renderer must not race the accelerator */
+
+      lv_port_gpu_wait();
+      lv_draw_sw_blend_basic(draw_ctx, dsc);
+    }
+}
+
+/****************************************************************************
+ * Name: gpu_buffer_copy
+ ****************************************************************************/
+
+static void gpu_buffer_copy(FAR lv_draw_ctx_t *draw_ctx,
+                            FAR void *dest_buf, lv_coord_t dest_stride,
+                            FAR const lv_area_t *dest_area,
+                            FAR void *src_buf, lv_coord_t src_stride,
+                            FAR const lv_area_t *src_area)
+{
+  FAR lv_color_t *dest = dest_buf;
+  FAR const lv_color_t *src = src_buf;
+
+  dest += dest_stride * dest_area->y1 + dest_area->x1;
+  src += src_stride * src_area->y1 + src_area->x1;
+
+  if (gpu_blit(dest, dest_stride, src, src_stride,
+               lv_area_get_width(dest_area),
+               lv_area_get_height(dest_area), LV_OPA_COVER) < 0)
+    {
+      lv_port_gpu_wait();
+      lv_draw_sw_buffer_copy(draw_ctx, dest_buf, dest_stride, dest_area,
+                             src_buf, src_stride, src_area);
+    }
+}
+
+/****************************************************************************
+ * Name: gpu_wait_for_finish
+ ****************************************************************************/
+
+static void gpu_wait_for_finish(FAR lv_draw_ctx_t *draw_ctx)
+{
+  lv_port_gpu_wait();
+  lv_draw_sw_wait_for_finish(draw_ctx);
+}
+
+/****************************************************************************
+ * Name: gpu_draw_ctx_init
+ ****************************************************************************/
+
+static void gpu_draw_ctx_init(FAR lv_disp_drv_t *disp_drv,
+                              FAR lv_draw_ctx_t *draw_ctx)
+{
+  FAR lv_draw_sw_ctx_t *sw_ctx = (FAR lv_draw_sw_ctx_t *)draw_ctx;
+
+  lv_draw_sw_init_ctx(disp_drv, draw_ctx);
+
+  sw_ctx->blend = gpu_blend;
+  sw_ctx->base_draw.buffer_copy = gpu_buffer_copy;
+  sw_ctx->base_draw.wait_for_finish = gpu_wait_for_finish;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: lv_port_gpu_register
+ ****************************************************************************/
+
+void lv_port_gpu_register(FAR const struct lv_port_gpu_ops_s *ops)
+{
+  g_gpu_ops = ops;
+}
+
+/****************************************************************************
+ * Name: lv_port_gpu_drv_init
+ ****************************************************************************/
+
+void lv_port_gpu_drv_init(FAR lv_disp_drv_t *disp_drv)
+{
+  if (g_gpu_ops == NULL)
+    {
+      return;
+    }
+
+  LV_LOG_INFO("2D accelerator enabled");
+
+  disp_drv->draw_ctx_init = gpu_draw_ctx_init;
+  disp_drv->draw_ctx_deinit = lv_draw_sw_deinit_ctx;
+  disp_drv->draw_ctx_size = sizeof(lv_draw_sw_ctx_t);
+}
+
+/****************************************************************************
+ * Name: lv_port_gpu_blit
+ ****************************************************************************/
+
+int lv_port_gpu_blit(FAR lv_color_t *dst, lv_coord_t dst_stride,
+                     FAR const lv_color_t *src, lv_coord_t src_stride,
+                     lv_coord_t w, lv_coord_t h)
+{
+  if (g_gpu_ops == NULL)
+    {
+      return -ENOSYS;
+    }
+
+  return gpu_blit(dst, dst_stride, src, src_stride, w, h, LV_OPA_COVER);
+}
+
+/****************************************************************************
+ * Name: lv_port_gpu_wait
+ ****************************************************************************/
+
+void lv_port_gpu_wait(void)
+{
+  if (g_gpu_ops == NULL || g_gpu_ops->wait == NULL)
+    {
+      return;
+    }
+
+  pthread_mutex_lock(&g_gpu_lock);
+  g_gpu_ops->wait(g_gpu_ops->priv);
+  pthread_mutex_unlock(&g_gpu_lock);
+}
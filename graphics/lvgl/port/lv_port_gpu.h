@@ -0,0 +1,147 @@
+/****************************************************************************
+ * apps/graphics/lvgl/port/lv_port_gpu.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_GRAPHICS_LVGL_PORT_LV_PORT_GPU_H
+#define __APPS_GRAPHICS_LVGL_PORT_LV_PORT_GPU_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <lvgl/lvgl.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if defined(CONFIG_LV_PORT_USE_GPU)
+
+/****************************************************************************
+ * Type Definitions
+ ****************************************************************************/
+
+/* 2D accelerator operations, provided by the board (DMA2D, PXP, ...).
+ * Strides are in pixels.  An operation may return before it is complete,
+ * wait() must then block until all of the started operations are done.
+ * An operation returns a negated errno value, -ENOTSUP for example, to
+ * leave the request to the software renderer.
+ */
+
+struct lv_port_gpu_ops_s
+{
+  /* Fill w x h pixels with color, blended with opa */
+
+  CODE int (*fill)(FAR void *priv, FAR lv_color_t *dst,
+                   lv_coord_t dst_stride, lv_coord_t w, lv_coord_t h,
+                   lv_color_t color, lv_opa_t opa);
+
+  /* Copy w x h pixels, blended with opa */
+
+  CODE int (*blit)(FAR void *priv, FAR lv_color_t *dst,
+                   lv_coord_t dst_stride, FAR const lv_color_t *src,
+                   lv_coord_t src_stride, lv_coord_t w, lv_coord_t h,
+                   lv_opa_t opa);
+
+  /* Wait for the started operations, NULL if they are synchronous */
+
+  CODE void (*wait)(FAR void *priv);
+
+  FAR void *priv;
+};
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: lv_port_gpu_register
+ *
+ * Description:
+ *   Register the 2D accelerator.  It must be called before the display
+ *   port is initialized.
+ *
+ * Input Parameters:
+ *   ops - Accelerator operations, NULL to render in software only
+ *
+ ****************************************************************************/
+
+void lv_port_gpu_register(FAR const struct lv_port_gpu_ops_s *ops);
+
+/****************************************************************************
+ * Name: lv_port_gpu_drv_init
+ *
+ * Description:
+ *   Make a display driver draw its fills and blits with the accelerator.
+ *   Nothing is changed if no accelerator is registered.
+ *
+ * Input Parameters:
+ *   disp_drv - Display driver, initialized by lv_disp_drv_init()
+ *
+ ****************************************************************************/
+
+void lv_port_gpu_drv_init(FAR lv_disp_drv_t *disp_drv);
+
+/****************************************************************************
+ * Name: lv_port_gpu_blit
+ *
+ * Description:
+ *   Copy an area with the accelerator, for the display ports.
+ *
+ * Returned Value:
+ *   Zero when the copy is started; a negated errno value if the caller
+ *   must copy in software.
+ *
+ ****************************************************************************/
+
+int lv_port_gpu_blit(FAR lv_color_t *dst, lv_coord_t dst_stride,
+                     FAR const lv_color_t *src, lv_coord_t src_stride,
+                     lv_coord_t w, lv_coord_t h);
+
+/****************************************************************************
+ * Name: lv_port_gpu_wait
+ *
+ * Description:
+ *   Wait until the started accelerator operations are complete.
+ *
+ ****************************************************************************/
+
+void lv_port_gpu_wait(void);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_LV_PORT_USE_GPU */
+
+#endif /* __APPS_GRAPHICS_LVGL_PORT_LV_PORT_GPU_H */
@@ -33,6 +33,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include "lv_port_lcddev.h"
+#include "lv_port_gpu.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -189,6 +190,10 @@ static FAR lv_disp_t *lcddev_init(int fd,
 #endif
   lcddev_obj->disp_drv.wait_cb = lcddev_wait;
 
+#if defined(CONFIG_LV_PORT_USE_GPU)
+  lv_port_gpu_drv_init(&(lcddev_obj->disp_drv));
+#endif
+
   /* Initialize the mutexes for buffer flushing synchronization */
 
   sem_init(&lcddev_obj->flush_sem, 0, 0);
@@ -23,12 +23,33 @@
  ****************************************************************************/
 
 #include <nuttx/mm/mm.h>
+#include <malloc.h>
+#include <string.h>
 #include "lv_port_mem.h"
 
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
+#define LV_MEM_REGION_SIZE    (CONFIG_LV_PORT_MEM_CUSTOM_SIZE * 1024)
+
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+
+/* Size classes of 16, 32, 64 and 128 bytes, each one in its own slice
+ * of the region, so that a block's class is found from its address.
+ */
+
+#  define LV_POOL_CLASSES     4
+#  define LV_POOL_MIN_SHIFT   4
+#  define LV_POOL_MAX_SIZE    (1 << (LV_POOL_MIN_SHIFT + LV_POOL_CLASSES - 1))
+#  define LV_POOL_SLICE       (CONFIG_LV_PORT_MEM_POOL_SIZE * 1024)
+#  define LV_POOL_TOTAL       (LV_POOL_SLICE * LV_POOL_CLASSES)
+
+#  if LV_POOL_TOTAL >= LV_MEM_REGION_SIZE
+#    error "LV_PORT_MEM_POOL_SIZE leaves no room for the heap"
+#  endif
+#endif
+
 /****************************************************************************
  * Private Type Declarations
  ****************************************************************************/
@@ -39,6 +60,14 @@ typedef CODE void *(*realloc_func_t)(FAR struct mm_heap_s *heap,
 typedef CODE void *(*memalign_func_t)(FAR struct mm_heap_s *heap,
                                       size_t alignment, size_t size);
 
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+struct lv_pool_s
+{
+  FAR void *free;          /* First free block, linked through the blocks */
+  size_t used;             /* Blocks allocated */
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -58,6 +87,15 @@ static malloc_func_t g_malloc_func = malloc_first;
 static realloc_func_t g_realloc_func = realloc_first;
 static memalign_func_t g_memalign_func = memalign_first;
 
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+static FAR uint8_t *g_lv_pool_base;
+static struct lv_pool_s g_lv_pools[LV_POOL_CLASSES];
+#endif
+
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+static struct lv_port_mem_stats_s g_lv_mem_stats;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -72,10 +110,48 @@ static memalign_func_t g_memalign_func = memalign_first;
 
 static void lv_port_mem_init(void)
 {
-  static uint32_t heap_buf[CONFIG_LV_PORT_MEM_CUSTOM_SIZE
-                           * 1024 / sizeof(uint32_t)];
+#if CONFIG_LV_PORT_MEM_CUSTOM_ADDR != 0
+  FAR uint8_t *heap_buf = (FAR uint8_t *)CONFIG_LV_PORT_MEM_CUSTOM_ADDR;
+#else
+  static uint32_t heap_buf[LV_MEM_REGION_SIZE / sizeof(uint32_t)];
+#endif
+  FAR uint8_t *heap_start = (FAR uint8_t *)heap_buf;
+  size_t heap_size = LV_MEM_REGION_SIZE;
+
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+  FAR void **block;
+  size_t bsize;
+  int i;
+
+  /* The pools take the beginning of the region, the heap the rest */
+
+  g_lv_pool_base = heap_start;
+
+  for (i = 0; i < LV_POOL_CLASSES; i++)
+    {
+      bsize = 1 << (LV_POOL_MIN_SHIFT + i);
+      g_lv_pools[i].free = NULL;
+
+      for (block = (FAR void **)(heap_start + LV_POOL_SLICE - bsize);
+           (FAR uint8_t *)block >= heap_start;
+           block = (FAR void **)((FAR uint8_t *)block - bsize))
+        {
+          *block = g_lv_pools[i].free;
+          g_lv_pools[i].free = block;
+        }
+
+      heap_start += LV_POOL_SLICE;
+    }
+
+  heap_size -= LV_POOL_TOTAL;
+#endif
+
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+  g_lv_mem_stats.total = LV_MEM_REGION_SIZE;
+#endif
+
   g_lv_heap = mm_initialize(CONFIG_LV_PORT_MEM_CUSTOM_NAME,
-                            heap_buf, sizeof(heap_buf));
+                            heap_start, heap_size);
   LV_ASSERT_NULL(g_lv_heap);
   if (g_lv_heap == NULL)
     {
@@ -132,6 +208,130 @@ static FAR void *memalign_first(FAR struct mm_heap_s *heap,
   return g_memalign_func(g_lv_heap, alignment, size);
 }
 
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+
+/****************************************************************************
+ * Name: pool_class
+ *
+ * Description:
+ *   Get the size class of a block, or -1 if it is not from a pool.
+ *
+ ****************************************************************************/
+
+static int pool_class(FAR void *mem)
+{
+  FAR uint8_t *ptr = mem;
+
+  if (g_lv_pool_base == NULL || ptr < g_lv_pool_base ||
+      ptr >= g_lv_pool_base + LV_POOL_TOTAL)
+    {
+      return -1;
+    }
+
+  return (ptr - g_lv_pool_base) / LV_POOL_SLICE;
+}
+
+/****************************************************************************
+ * Name: pool_alloc
+ *
+ * Description:
+ *   Allocate a block of the smallest class that fits, NULL if size is
+ *   too large or the class is empty.
+ *
+ ****************************************************************************/
+
+static FAR void *pool_alloc(size_t size)
+{
+  FAR struct lv_pool_s *pool;
+  FAR void **block;
+  int i = 0;
+
+  if (size == 0 || size > LV_POOL_MAX_SIZE)
+    {
+      return NULL;
+    }
+
+  if (g_lv_heap == NULL)
+    {
+      lv_port_mem_init();
+    }
+
+  while ((size_t)1 << (LV_POOL_MIN_SHIFT + i) < size)
+    {
+      i++;
+    }
+
+  pool = &g_lv_pools[i];
+  block = pool->free;
+  if (block == NULL)
+    {
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+      g_lv_mem_stats.pool_miss++;
+#endif
+      return NULL;
+    }
+
+  pool->free = *block;
+  pool->used++;
+  return block;
+}
+
+/****************************************************************************
+ * Name: pool_free
+ ****************************************************************************/
+
+static void pool_free(FAR void *mem, int i)
+{
+  FAR void **block = mem;
+
+  *block = g_lv_pools[i].free;
+  g_lv_pools[i].free = block;
+  g_lv_pools[i].used--;
+}
+
+#endif /* CONFIG_LV_PORT_MEM_POOL */
+
+/****************************************************************************
+ * Name: mem_block_size
+ ****************************************************************************/
+
+static size_t mem_block_size(FAR void *mem)
+{
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+  int i = pool_class(mem);
+
+  if (i >= 0)
+    {
+      return (size_t)1 << (LV_POOL_MIN_SHIFT + i);
+    }
+#endif
+
+  return mm_malloc_size(g_lv_heap, mem);
+}
+
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+
+/****************************************************************************
+ * Name: mem_stats_update
+ ****************************************************************************/
+
+static void mem_stats_update(size_t freed, FAR void *mem)
+{
+  g_lv_mem_stats.used -= freed;
+
+  if (mem != NULL)
+    {
+      g_lv_mem_stats.used += mem_block_size(mem);
+    }
+
+  if (g_lv_mem_stats.used > g_lv_mem_stats.max_used)
+    {
+      g_lv_mem_stats.max_used = g_lv_mem_stats.used;
+    }
+}
+
+#endif /* CONFIG_LV_PORT_MEM_STATS */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -142,7 +342,21 @@ static FAR void *memalign_first(FAR struct mm_heap_s *heap,
 
 FAR void *lv_port_mem_alloc(size_t size)
 {
-  return g_malloc_func(g_lv_heap, size);
+  FAR void *mem = NULL;
+
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+  mem = pool_alloc(size);
+  if (mem == NULL)
+#endif
+    {
+      mem = g_malloc_func(g_lv_heap, size);
+    }
+
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+  mem_stats_update(0, mem);
+#endif
+
+  return mem;
 }
 
 /****************************************************************************
@@ -151,6 +365,28 @@ FAR void *lv_port_mem_alloc(size_t size)
 
 void lv_port_mem_free(FAR void *mem)
 {
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+  int i;
+#endif
+
+  if (mem == NULL)
+    {
+      return;
+    }
+
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+  mem_stats_update(mem_block_size(mem), NULL);
+#endif
+
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+  i = pool_class(mem);
+  if (i >= 0)
+    {
+      pool_free(mem, i);
+      return;
+    }
+#endif
+
   mm_free(g_lv_heap, mem);
 }
 
@@ -160,7 +396,57 @@ void lv_port_mem_free(FAR void *mem)
 
 FAR void *lv_port_mem_realloc(FAR void *oldmem, size_t size)
 {
-  return g_realloc_func(g_lv_heap, oldmem, size);
+  FAR void *mem;
+  size_t oldsize = 0;
+
+  if (oldmem == NULL)
+    {
+      return lv_port_mem_alloc(size);
+    }
+
+  if (size == 0)
+    {
+      lv_port_mem_free(oldmem);
+      return NULL;
+    }
+
+#if defined(CONFIG_LV_PORT_MEM_STATS) || defined(CONFIG_LV_PORT_MEM_POOL)
+  oldsize = mem_block_size(oldmem);
+#endif
+
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+  /* A pool block is kept while it fits, and moved otherwise */
+
+  if (pool_class(oldmem) >= 0)
+    {
+      if (size <= oldsize)
+        {
+          return oldmem;
+        }
+
+      mem = lv_port_mem_alloc(size);
+      if (mem != NULL)
+        {
+          memcpy(mem, oldmem, oldsize);
+          lv_port_mem_free(oldmem);
+        }
+
+      return mem;
+    }
+#endif
+
+  mem = g_realloc_func(g_lv_heap, oldmem, size);
+
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+  if (mem != NULL)
+    {
+      mem_stats_update(oldsize, mem);
+    }
+#else
+  UNUSED(oldsize);
+#endif
+
+  return mem;
 }
 
 /****************************************************************************
@@ -169,5 +455,43 @@ FAR void *lv_port_mem_realloc(FAR void *oldmem, size_t size)
 
 FAR void *lv_mem_custom_memalign(size_t alignment, size_t size)
 {
-  return g_memalign_func(g_lv_heap, alignment, size);
+  FAR void *mem = g_memalign_func(g_lv_heap, alignment, size);
+
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+  mem_stats_update(0, mem);
+#endif
+
+  return mem;
+}
+
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+/****************************************************************************
+ * Name: lv_port_mem_get_stats
+ ****************************************************************************/
+
+void lv_port_mem_get_stats(FAR struct lv_port_mem_stats_s *stats)
+{
+  struct mallinfo info;
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+  int i;
+#endif
+
+  *stats = g_lv_mem_stats;
+  stats->total = LV_MEM_REGION_SIZE;
+
+  if (g_lv_heap != NULL)
+    {
+      info = mm_mallinfo(g_lv_heap);
+      stats->heap_free = info.fordblks;
+      stats->heap_max_free = info.mxordblk;
+    }
+
+#if defined(CONFIG_LV_PORT_MEM_POOL)
+  stats->pool_used = 0;
+  for (i = 0; i < LV_POOL_CLASSES; i++)
+    {
+      stats->pool_used += g_lv_pools[i].used << (LV_POOL_MIN_SHIFT + i);
+    }
+#endif
 }
+#endif
@@ -42,6 +42,23 @@
  * Type Definitions
  ****************************************************************************/
 
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+
+/* LVGL heap usage, in bytes */
+
+struct lv_port_mem_stats_s
+{
+  size_t total;         /* Size of the region, pools included */
+  size_t used;          /* Allocated, block overhead included */
+  size_t max_used;      /* High-water mark of used */
+  size_t pool_used;     /* Allocated from the size class pools */
+  size_t pool_miss;     /* Small requests the pools could not serve */
+  size_t heap_free;     /* Free in the heap */
+  size_t heap_max_free; /* Largest free heap block */
+};
+
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -82,6 +99,19 @@ FAR void *lv_port_mem_realloc(FAR void *oldmem, size_t size);
 
 FAR void *lv_port_mem_memalign(size_t alignment, size_t size);
 
+#if defined(CONFIG_LV_PORT_MEM_STATS)
+/****************************************************************************
+ * Name: lv_port_mem_get_stats
+ *
+ * Description:
+ *   Get the usage and the high-water mark of the LVGL heap.  Comparing
+ *   heap_max_free with heap_free shows the fragmentation.
+ *
+ ****************************************************************************/
+
+void lv_port_mem_get_stats(FAR struct lv_port_mem_stats_s *stats);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -0,0 +1,171 @@
+/****************************************************************************
+ * apps/graphics/nxwidgets/src/cglyphcache.cxx
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "graphics/nxwidgets/nxconfig.hxx"
+#include "graphics/nxwidgets/cnxfont.hxx"
+#include "graphics/nxwidgets/cglyphcache.hxx"
+
+#ifdef CONFIG_NXWIDGETS_GLYPHCACHE
+
+/****************************************************************************
+ * Method Implementations
+ ****************************************************************************/
+
+using namespace NXWidgets;
+
+/**
+ * Constructor.
+ */
+
+CGlyphCache::CGlyphCache(void)
+{
+  for (int i = 0; i < CONFIG_NXWIDGETS_GLYPHCACHE_ENTRIES; i++)
+    {
+      m_glyphs[i].font = (const CNxFont *)NULL;
+      m_glyphs[i].size = 0;
+      m_glyphs[i].data = (FAR nxwidget_pixel_t *)NULL;
+    }
+
+  m_clock = 0;
+  pthread_mutex_init(&m_lock, NULL);
+}
+
+/**
+ * Destructor.
+ */
+
+CGlyphCache::~CGlyphCache(void)
+{
+  for (int i = 0; i < CONFIG_NXWIDGETS_GLYPHCACHE_ENTRIES; i++)
+    {
+      delete[] m_glyphs[i].data;
+    }
+
+  pthread_mutex_destroy(&m_lock);
+}
+
+/**
+ * Get a glyph, or the memory to render it into.
+ *
+ * @param font The font of the glyph.
+ * @param letter The character.
+ * @param background The background color.
+ * @param width The width of the glyph in pixels.
+ * @param height The height of the glyph in rows.
+ * @param hit Set to true if the glyph was already rendered.
+ * @return The glyph memory, or NULL if there is no memory for it.
+ */
+
+FAR nxwidget_pixel_t *CGlyphCache::get(const CNxFont *font,
+                                       nxwidget_char_t letter,
+                                       nxgl_mxpixel_t background,
+                                       nxgl_coord_t width,
+                                       nxgl_coord_t height, bool &hit)
+{
+  nxgl_mxpixel_t color = font->getColor();
+  struct SGlyph *victim = &m_glyphs[0];
+
+  m_clock++;
+
+  for (int i = 0; i < CONFIG_NXWIDGETS_GLYPHCACHE_ENTRIES; i++)
+    {
+      struct SGlyph *glyph = &m_glyphs[i];
+
+      if (glyph->font == font && glyph->letter == letter &&
+          glyph->color == color && glyph->background == background &&
+          glyph->width == width && glyph->height == height)
+        {
+          glyph->lastUse = m_clock;
+          hit = true;
+          return glyph->data;
+        }
+
+      // Prefer a free entry, then the least recently used one
+
+      if (victim->font != NULL &&
+          (glyph->font == NULL ||
+           (uint32_t)(m_clock - glyph->lastUse) >
+           (uint32_t)(m_clock - victim->lastUse)))
+        {
+          victim = glyph;
+        }
+    }
+
+  // Reuse the memory of the entry if the new glyph fits in it
+
+  size_t size = (size_t)width * height;
+  if (size > victim->size)
+    {
+      delete[] victim->data;
+      victim->data = new nxwidget_pixel_t[size];
+      victim->size = victim->data != NULL ? size : 0;
+    }
+
+  if (victim->data == NULL)
+    {
+      victim->font = (const CNxFont *)NULL;
+      return (FAR nxwidget_pixel_t *)NULL;
+    }
+
+  victim->font       = font;
+  victim->letter     = letter;
+  victim->color      = color;
+  victim->background = background;
+  victim->width      = width;
+  victim->height     = height;
+  victim->lastUse    = m_clock;
+
+  hit = false;
+  return victim->data;
+}
+
+/**
+ * Forget the glyphs of a font.
+ *
+ * @param font The font.
+ */
+
+void CGlyphCache::invalidate(const CNxFont *font)
+{
+  lock();
+
+  for (int i = 0; i < CONFIG_NXWIDGETS_GLYPHCACHE_ENTRIES; i++)
+    {
+      if (m_glyphs[i].font == font)
+        {
+          m_glyphs[i].font = (const CNxFont *)NULL;
+        }
+    }
+
+  unlock();
+}
+
+#endif // CONFIG_NXWIDGETS_GLYPHCACHE
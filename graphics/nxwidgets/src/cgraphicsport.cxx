@@ -61,6 +61,7 @@
 #include <sys/types.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <cassert>
 #include <cerrno>
 #include <debug.h>
 
@@ -75,6 +76,7 @@
 #include "graphics/nxwidgets/cgraphicsport.hxx"
 #include "graphics/nxwidgets/cwidgetstyle.hxx"
 #include "graphics/nxwidgets/cbitmap.hxx"
+#include "graphics/nxwidgets/cglyphcache.hxx"
 #include "graphics/nxwidgets/singletons.hxx"
 
 /****************************************************************************
@@ -98,13 +100,21 @@ using namespace NXWidgets;
 #ifdef CONFIG_NX_WRITEONLY
 CGraphicsPort::CGraphicsPort(INxWindow *pNxWnd, nxgl_mxpixel_t backColor)
 {
-  m_pNxWnd    = pNxWnd;
-  m_backColor = backColor;
+  m_pNxWnd     = pNxWnd;
+  m_backColor  = backColor;
+#ifdef CONFIG_NXWIDGETS_BATCH
+  m_nBatch     = 0;
+  m_batchDepth = 0;
+#endif
 }
 #else
 CGraphicsPort::CGraphicsPort(INxWindow *pNxWnd)
 {
-  m_pNxWnd = pNxWnd;
+  m_pNxWnd     = pNxWnd;
+#ifdef CONFIG_NXWIDGETS_BATCH
+  m_nBatch     = 0;
+  m_batchDepth = 0;
+#endif
 }
 #endif
 
@@ -161,6 +171,8 @@ void CGraphicsPort::drawPixel(nxgl_coord_t x, nxgl_coord_t y,
   struct nxgl_point_s pos;
   pos.x = x;
   pos.y = y;
+
+  flushBatch();
   m_pNxWnd->setPixel(&pos, color);
 }
 
@@ -187,10 +199,7 @@ void CGraphicsPort::drawHorizLine(nxgl_coord_t x, nxgl_coord_t y,
 
   // Draw the line
 
-  if (!m_pNxWnd->fill(&dest, color))
-    {
-      gerr("ERROR: INxWindow::fill failed\n");
-    }
+  fillRect(&dest, color);
 }
 
 /**
@@ -217,10 +226,7 @@ void CGraphicsPort::drawVertLine(nxgl_coord_t x, nxgl_coord_t y,
 
   // Draw the line
 
-  if (!m_pNxWnd->fill(&dest, color))
-    {
-      gerr("ERROR: INxWindow::fill failed\n");
-    }
+  fillRect(&dest, color);
 }
 
 /**
@@ -246,6 +252,7 @@ void CGraphicsPort::drawLine(nxgl_coord_t x1, nxgl_coord_t y1,
   vector.pt2.x = x2;
   vector.pt2.y = y2;
 
+  flushBatch();
   if (!m_pNxWnd->drawLine(&vector, 1, color, caps))
     {
       gerr("ERROR: INxWindow::drawLine failed\n");
@@ -271,7 +278,7 @@ void CGraphicsPort::drawFilledRect(nxgl_coord_t x, nxgl_coord_t y,
   rect.pt1.y = y;
   rect.pt2.x = x + width - 1;
   rect.pt2.y = y + height - 1;
-  m_pNxWnd->fill(&rect, color);
+  fillRect(&rect, color);
 }
 
 /**
@@ -354,6 +361,7 @@ void CGraphicsPort::drawBitmap(nxgl_coord_t x, nxgl_coord_t y,
 
   // Blit the bitmap
 
+  flushBatch();
   m_pNxWnd->bitmap(&dest, (FAR const void *)bitmap->data, &origin, bitmap->stride);
 }
 
@@ -379,6 +387,8 @@ void CGraphicsPort::drawBitmap(nxgl_coord_t x, nxgl_coord_t y,
                                int bitmapX, int  bitmapY,
                                nxgl_mxpixel_t transparentColor)
 {
+  flushBatch();
+
   // Get the starting position in the image, offset by bitmapX and bitmapY into the image.
 
   FAR uint8_t *srcLine = (uint8_t *)bitmap->data +
@@ -515,6 +525,8 @@ void CGraphicsPort::drawBitmapGreyScale(nxgl_coord_t x, nxgl_coord_t y,
                                         const struct SBitmap *bitmap,
                                         int bitmapX, int bitmapY)
 {
+  flushBatch();
+
   // Working buffer.  Holds one converted row from the bitmap
 
   FAR nxwidget_pixel_t *run = new nxwidget_pixel_t[width];
@@ -694,6 +706,8 @@ void CGraphicsPort::_drawText(struct nxgl_point_s *pos, CRect *bound,
                               nxgl_mxpixel_t background,
                               bool transparent)
 {
+  flushBatch();
+
   // Verify index and length
 
   int stringLength = string.getLength();
@@ -783,11 +797,34 @@ void CGraphicsPort::_drawText(struct nxgl_point_s *pos, CRect *bound,
 
           if (!nxgl_nullrect(&intersection))
             {
+              bool rendered = false;
+
+#ifdef CONFIG_NXWIDGETS_GLYPHCACHE
+              // On an opaque background the glyph does not depend on the
+              // display, so it can be rendered once and reused.
+
+              FAR nxwidget_pixel_t *cached = (FAR nxwidget_pixel_t *)NULL;
+              if (!transparent && g_glyphCache)
+                {
+                  g_glyphCache->lock();
+                  cached = g_glyphCache->get(font, letter, background,
+                                             fontWidth, bmHeight, rendered);
+                  if (cached)
+                    {
+                      bitmap.data = (FAR const nxgl_mxpixel_t *)cached;
+                    }
+                }
+#endif
+
               // If we have been given a background color, use it to fill the array.
               // Otherwise initialize the bitmap memory by reading from the display.
               // The font renderer always renders the fonts on a transparent background.
 
-              if (!transparent)
+              if (rendered)
+                {
+                  // Taken from the cache, nothing to render
+                }
+              else if (!transparent)
                 {
                   // Set the glyph memory to the background color
 
@@ -807,7 +844,10 @@ void CGraphicsPort::_drawText(struct nxgl_point_s *pos, CRect *bound,
 
               // Render the font into the initialized bitmap
 
-              font->drawChar(&bitmap, letter);
+              if (!rendered)
+                {
+                  font->drawChar(&bitmap, letter);
+                }
 
               // Then put the font on the display
 
@@ -816,6 +856,14 @@ void CGraphicsPort::_drawText(struct nxgl_point_s *pos, CRect *bound,
                 {
                   ginfo("nx_bitmapwindow failed: %d\n", errno);
                 }
+
+#ifdef CONFIG_NXWIDGETS_GLYPHCACHE
+              if (!transparent && g_glyphCache)
+                {
+                  bitmap.data = (FAR const nxgl_mxpixel_t *)glyph;
+                  g_glyphCache->unlock();
+                }
+#endif
             }
         }
 
@@ -843,6 +891,8 @@ void CGraphicsPort::copy(nxgl_coord_t sourceX, nxgl_coord_t sourceY,
                          nxgl_coord_t destX, nxgl_coord_t destY,
                          nxgl_coord_t width, nxgl_coord_t height)
 {
+  flushBatch();
+
   struct nxgl_rect_s rect;
   struct nxgl_point_s offset;
 
@@ -872,6 +922,8 @@ void CGraphicsPort::move(nxgl_coord_t x, nxgl_coord_t y,
                          nxgl_coord_t deltaX, nxgl_coord_t deltaY,
                          nxgl_coord_t width, nxgl_coord_t height)
 {
+  flushBatch();
+
   struct nxgl_rect_s rect;
   rect.pt1.x = x;
   rect.pt1.y = y;
@@ -897,6 +949,8 @@ void CGraphicsPort::move(nxgl_coord_t x, nxgl_coord_t y,
 void CGraphicsPort::greyScale(nxgl_coord_t x, nxgl_coord_t y,
                               nxgl_coord_t width, nxgl_coord_t height)
 {
+  flushBatch();
+
   // Allocate memory to hold one row of graphics data
 
   unsigned int stride    = ((unsigned int)width * CONFIG_NXWIDGETS_BPP + 7) >> 3;
@@ -980,6 +1034,8 @@ void CGraphicsPort::greyScale(nxgl_coord_t x, nxgl_coord_t y,
 void CGraphicsPort::invert(nxgl_coord_t x, nxgl_coord_t y,
                            nxgl_coord_t width, nxgl_coord_t height)
 {
+  flushBatch();
+
   // Allocate memory to hold one row of graphics data
 
   unsigned int stride    = ((unsigned int)width * CONFIG_NXWIDGETS_BPP + 7) >> 3;
@@ -1040,3 +1096,118 @@ void CGraphicsPort::invert(nxgl_coord_t x, nxgl_coord_t y,
 
   delete[] rowBuffer;
 };
+
+/**
+ * Fill a rectangle, or record it while batching.
+ *
+ * @param rect The window-relative area to fill.
+ * @param color The fill color.
+ */
+
+void CGraphicsPort::fillRect(FAR const struct nxgl_rect_s *rect,
+                             nxgl_mxpixel_t color)
+{
+#ifdef CONFIG_NXWIDGETS_BATCH
+  if (m_batchDepth > 0)
+    {
+      if (rect->pt1.x > rect->pt2.x || rect->pt1.y > rect->pt2.y)
+        {
+          return;
+        }
+
+      // Drop the pending fills that this one hides.  Nothing else was
+      // drawn since they were recorded, so they would not be visible.
+
+      int nkept = 0;
+      for (int i = 0; i < m_nBatch; i++)
+        {
+          FAR struct nxgl_rect_s *old = &m_batch[i].rect;
+          if (old->pt1.x < rect->pt1.x || old->pt2.x > rect->pt2.x ||
+              old->pt1.y < rect->pt1.y || old->pt2.y > rect->pt2.y)
+            {
+              m_batch[nkept++] = m_batch[i];
+            }
+        }
+
+      m_nBatch = nkept;
+
+      // Merge with the last fill if together they form a rectangle of the
+      // same color, like the rows of a background or a bevel.
+
+      if (m_nBatch > 0)
+        {
+          FAR struct SFillCmd *last = &m_batch[m_nBatch - 1];
+          FAR struct nxgl_rect_s *old = &last->rect;
+
+          if (last->color == color &&
+              ((old->pt1.y == rect->pt1.y && old->pt2.y == rect->pt2.y &&
+                rect->pt1.x <= old->pt2.x + 1 &&
+                rect->pt2.x + 1 >= old->pt1.x) ||
+               (old->pt1.x == rect->pt1.x && old->pt2.x == rect->pt2.x &&
+                rect->pt1.y <= old->pt2.y + 1 &&
+                rect->pt2.y + 1 >= old->pt1.y)))
+            {
+              nxgl_rectunion(old, old, rect);
+              return;
+            }
+        }
+
+      if (m_nBatch >= CONFIG_NXWIDGETS_BATCH_SIZE)
+        {
+          submitBatch();
+        }
+
+      m_batch[m_nBatch].rect  = *rect;
+      m_batch[m_nBatch].color = color;
+      m_nBatch++;
+      return;
+    }
+#endif
+
+  if (!m_pNxWnd->fill(rect, color))
+    {
+      gerr("ERROR: INxWindow::fill failed\n");
+    }
+}
+
+#ifdef CONFIG_NXWIDGETS_BATCH
+/**
+ * Submit the pending fills to the window.
+ */
+
+void CGraphicsPort::submitBatch(void)
+{
+  for (int i = 0; i < m_nBatch; i++)
+    {
+      if (!m_pNxWnd->fill(&m_batch[i].rect, m_batch[i].color))
+        {
+          gerr("ERROR: INxWindow::fill failed\n");
+        }
+    }
+
+  m_nBatch = 0;
+}
+
+/**
+ * Start recording the fills instead of sending each one to the window.
+ */
+
+void CGraphicsPort::beginBatch(void)
+{
+  m_batchDepth++;
+}
+
+/**
+ * Stop recording and submit the pending fills.
+ */
+
+void CGraphicsPort::endBatch(void)
+{
+  DEBUGASSERT(m_batchDepth > 0);
+
+  if (--m_batchDepth == 0)
+    {
+      flushBatch();
+    }
+}
+#endif
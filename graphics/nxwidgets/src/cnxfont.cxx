@@ -37,6 +37,8 @@
 #include "graphics/nxwidgets/cstringiterator.hxx"
 #include "graphics/nxwidgets/cnxfont.hxx"
 #include "graphics/nxwidgets/cbitmap.hxx"
+#include "graphics/nxwidgets/cglyphcache.hxx"
+#include "graphics/nxwidgets/singletons.hxx"
 
 /****************************************************************************
  * Pre-Processor Definitions
@@ -67,6 +69,21 @@ CNxFont::CNxFont(enum nx_fontid_e fontid, nxgl_mxpixel_t fontColor,
   m_transparentColor = transparentColor;
 }
 
+#ifdef CONFIG_NXWIDGETS_GLYPHCACHE
+/**
+ * CNxFont Destructor.  Its glyphs are removed from the cache so that they
+ * are not used for a new font allocated at the same address.
+ */
+
+CNxFont::~CNxFont()
+{
+  if (g_glyphCache)
+    {
+      g_glyphCache->invalidate(this);
+    }
+}
+#endif
+
 /**
  * Checks if supplied character is blank in the current font.
  *
@@ -473,6 +473,12 @@ void CNxWidget::redraw(void)
 
       CGraphicsPort *port = m_widgetControl->getGraphicsPort();
 
+#ifdef CONFIG_NXWIDGETS_BATCH
+      // Send the fills of the widget and its children together
+
+      port->beginBatch();
+#endif
+
       // Draw the Widget
 
       drawBorder(port);
@@ -485,6 +491,10 @@ void CNxWidget::redraw(void)
       // Draw the children of the widget
 
       drawChildren();
+
+#ifdef CONFIG_NXWIDGETS_BATCH
+      port->endBatch();
+#endif
     }
 }
 
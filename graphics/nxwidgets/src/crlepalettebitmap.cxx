@@ -61,6 +61,7 @@
 #include <cstdint>
 #include <cstdbool>
 #include <cstring>
+#include <sched.h>
 
 #include <nuttx/nx/nxglib.h>
 
@@ -71,6 +72,16 @@
  * Pre-Processor Definitions
  ****************************************************************************/
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_NXWIDGETS_RLECACHE
+// Memory used by all of the decoded images
+
+static size_t g_rleCacheUsed;
+#endif
+
 /****************************************************************************
  * Method Implementations
  ****************************************************************************/
@@ -87,9 +98,30 @@ CRlePaletteBitmap::CRlePaletteBitmap(const struct SRlePaletteBitmap *bitmap)
 {
   m_bitmap      = bitmap;
   m_lut         = bitmap->lut[0];
+#ifdef CONFIG_NXWIDGETS_RLECACHE
+  m_decoded     = (FAR uint8_t *)NULL;
+#endif
   startOfImage();
 }
 
+#ifdef CONFIG_NXWIDGETS_RLECACHE
+/**
+ * Destructor.
+ */
+
+CRlePaletteBitmap::~CRlePaletteBitmap(void)
+{
+  if (m_decoded)
+    {
+      sched_lock();
+      g_rleCacheUsed -= (size_t)m_bitmap->width * m_bitmap->height;
+      sched_unlock();
+
+      delete[] m_decoded;
+    }
+}
+#endif
+
 /**
  * Get the bitmap's color format.
  *
@@ -180,6 +212,31 @@ bool CRlePaletteBitmap::getRun(nxgl_coord_t x, nxgl_coord_t y, nxgl_coord_t widt
   if (((unsigned int)x           <  (unsigned int)m_bitmap->width) &&
       ((unsigned int)(x + width) <= (unsigned int)m_bitmap->width))
     {
+#ifdef CONFIG_NXWIDGETS_RLECACHE
+      // Look up the colors of the decoded pixels, if the image fits in
+      // the cache
+
+      if (m_decoded || decodeImage())
+        {
+          if ((unsigned int)y >= (unsigned int)m_bitmap->height)
+            {
+              return false;
+            }
+
+          FAR const nxwidget_pixel_t *nxlut =
+            (FAR const nxwidget_pixel_t *)m_lut;
+          FAR const uint8_t *src = &m_decoded[y * m_bitmap->width + x];
+          FAR nxwidget_pixel_t *dest = (FAR nxwidget_pixel_t *)data;
+
+          for (int i = 0; i < width; i++)
+            {
+              *dest++ = nxlut[*src++];
+            }
+
+          return true;
+        }
+#endif
+
       // Seek to the requested row
 
       if (!seekRow(y))
@@ -205,6 +262,62 @@ bool CRlePaletteBitmap::getRun(nxgl_coord_t x, nxgl_coord_t y, nxgl_coord_t widt
   return false;
 }
 
+#ifdef CONFIG_NXWIDGETS_RLECACHE
+/**
+ * Decode the whole image into m_decoded.  The LUT indices are kept rather
+ * than the colors so that setSelected() does not invalidate them.
+ *
+ * @return True if the image is decoded.
+ */
+
+bool CRlePaletteBitmap::decodeImage(void)
+{
+  size_t size = (size_t)m_bitmap->width * m_bitmap->height;
+
+  // Reserve the memory in the cache
+
+  sched_lock();
+  if (g_rleCacheUsed + size > CONFIG_NXWIDGETS_RLECACHE_MAXSIZE)
+    {
+      sched_unlock();
+      return false;
+    }
+
+  g_rleCacheUsed += size;
+  sched_unlock();
+
+  FAR uint8_t *decoded = new uint8_t[size];
+  if (!decoded)
+    {
+      sched_lock();
+      g_rleCacheUsed -= size;
+      sched_unlock();
+      return false;
+    }
+
+  // Expand each run
+
+  FAR const struct SRlePaletteBitmapEntry *rle = m_bitmap->data;
+  size_t pos = 0;
+
+  while (pos < size)
+    {
+      size_t npixels = rle->npixels;
+      if (npixels > size - pos)
+        {
+          npixels = size - pos;
+        }
+
+      memset(&decoded[pos], rle->lookup, npixels);
+      pos += npixels;
+      rle++;
+    }
+
+  m_decoded = decoded;
+  return true;
+}
+#endif
+
 /**
  * Reset to the beginning of the image
  */
@@ -75,6 +75,11 @@ CScaledBitmap::CScaledBitmap(IBitmap *bitmap, struct nxgl_size_s &newSize)
   m_rowCache[0] = new uint8_t[stride];
   m_rowCache[1] = new uint8_t[stride];
 
+#ifdef CONFIG_NXWIDGETS_SCALED_ROWCACHE
+  m_scaledRow[0] = new struct rgbcolor_s[newSize.w];
+  m_scaledRow[1] = new struct rgbcolor_s[newSize.w];
+#endif
+
   // Read the first two rows into the cache
 
   m_row = m_bitmap->getWidth(); // Set to an impossible value
@@ -99,6 +104,11 @@ CScaledBitmap::~CScaledBitmap(void)
       delete m_rowCache[1];
    }
 
+#ifdef CONFIG_NXWIDGETS_SCALED_ROWCACHE
+  delete[] m_scaledRow[0];
+  delete[] m_scaledRow[1];
+#endif
+
   // We are also responsible for deleting the contained IBitmap
 
   if (m_bitmap)
@@ -195,9 +205,9 @@ bool CScaledBitmap::getRun(nxgl_coord_t x, nxgl_coord_t y,
 
   // Check ranges.  Casts to unsigned int are ugly but permit one-sided comparisons
 
-  if (((unsigned int)x           >=  (unsigned int)m_size.w) &&
-      ((unsigned int)(x + width) > (unsigned int)m_size.w) &&
-      ((unsigned int)y           <= (unsigned int)m_size.h))
+  if (((unsigned int)x           >= (unsigned int)m_size.w) ||
+      ((unsigned int)(x + width) >  (unsigned int)m_size.w) ||
+      ((unsigned int)y           >= (unsigned int)m_size.h))
     {
       return false;
     }
@@ -224,6 +234,12 @@ bool CScaledBitmap::getRun(nxgl_coord_t x, nxgl_coord_t y,
 
   for (int i = 0; i < width; i++, x++)
     {
+#ifdef CONFIG_NXWIDGETS_SCALED_ROWCACHE
+      // The rows are already scaled horizontally
+
+      struct rgbcolor_s color1 = m_scaledRow[0][x];
+      struct rgbcolor_s color2 = m_scaledRow[1][x];
+#else
       // Get the column number in the unscaled row corresponding to the
       // requested x position.  This must be either the exact column or the
       // closest column just before the requested position
@@ -247,6 +263,7 @@ bool CScaledBitmap::getRun(nxgl_coord_t x, nxgl_coord_t y,
           gerr("ERROR: rowColor failed for the second row\n");
           return false;
         }
+#endif
 
       // Check for transparent colors
 
@@ -362,6 +379,12 @@ bool CScaledBitmap::cacheRows(unsigned int row)
       m_rowCache[0] = m_rowCache[1];
       m_rowCache[1] = saveRow;
 
+#ifdef CONFIG_NXWIDGETS_SCALED_ROWCACHE
+      FAR struct rgbcolor_s *saveScaled = m_scaledRow[0];
+      m_scaledRow[0] = m_scaledRow[1];
+      m_scaledRow[1] = saveScaled;
+#endif
+
       // Save number of the first row that we have in the cache
 
       m_row = row;
@@ -378,6 +401,13 @@ bool CScaledBitmap::cacheRows(unsigned int row)
           gerr("ERROR: Failed to read bitmap row %d\n", row);
           return false;
         }
+
+#ifdef CONFIG_NXWIDGETS_SCALED_ROWCACHE
+      if (!scaleRow(m_rowCache[1], m_scaledRow[1]))
+        {
+          return false;
+        }
+#endif
     }
 
   // Do we need to read two new rows?  Or do we already have the
@@ -398,6 +428,13 @@ bool CScaledBitmap::cacheRows(unsigned int row)
           return false;
         }
 
+#ifdef CONFIG_NXWIDGETS_SCALED_ROWCACHE
+      if (!scaleRow(m_rowCache[0], m_scaledRow[0]))
+        {
+          return false;
+        }
+#endif
+
       // Save number of the first row that we have in the cache
 
       m_row = row;
@@ -414,10 +451,44 @@ bool CScaledBitmap::cacheRows(unsigned int row)
           gerr("ERROR: Failed to read bitmap row %d\n", row);
           return false;
         }
+
+#ifdef CONFIG_NXWIDGETS_SCALED_ROWCACHE
+      if (!scaleRow(m_rowCache[1], m_scaledRow[1]))
+        {
+          return false;
+        }
+#endif
+    }
+
+  return true;
+}
+
+#ifdef CONFIG_NXWIDGETS_SCALED_ROWCACHE
+/**
+ * Scale a cached row horizontally to the width of the scaled image.
+ * The source column advances by m_xScale from one pixel to the next, so
+ * the whole row is produced without any multiplication of coordinates.
+ *
+ * @param row - The pointer to the row in the row cache to use
+ * @param scaled - The returned row of m_size.w colors
+ */
+
+bool CScaledBitmap::scaleRow(FAR uint8_t *row, FAR struct rgbcolor_s *scaled)
+{
+  b16_t column = 0;
+
+  for (nxgl_coord_t x = 0; x < m_size.w; x++, column += m_xScale)
+    {
+      if (!rowColor(row, column, scaled[x]))
+        {
+          gerr("ERROR: rowColor failed for column %d\n", x);
+          return false;
+        }
     }
 
   return true;
 }
+#endif
 
 /**
  * Given an two RGB colors and a fractional value, return the scaled
@@ -578,14 +649,14 @@ bool CScaledBitmap::rowColor(FAR uint8_t *row, b16_t column,
       if (fraction < b16HALF)
         {
           outcolor.r = color1.r;
-          outcolor.g = color1.b;
           outcolor.g = color1.g;
+          outcolor.b = color1.b;
         }
       else
         {
           outcolor.r = color2.r;
-          outcolor.g = color2.b;
           outcolor.g = color2.g;
+          outcolor.b = color2.b;
         }
 
       return true;
@@ -69,6 +69,7 @@
 #include "graphics/nxwidgets/cnxstring.hxx"
 #include "graphics/nxwidgets/cwidgetstyle.hxx"
 #include "graphics/nxwidgets/cnxfont.hxx"
+#include "graphics/nxwidgets/cglyphcache.hxx"
 #include "graphics/nxwidgets/singletons.hxx"
 
 /****************************************************************************
@@ -84,6 +85,9 @@ using namespace NXWidgets;
 CWidgetStyle        *NXWidgets::g_defaultWidgetStyle; /**< The default widget style */
 CNxString           *NXWidgets::g_nullString;         /**< The reusable empty string */
 TNxArray<CNxTimer*> *NXWidgets::g_nxTimers;           /**< An array of all timers */
+#ifdef CONFIG_NXWIDGETS_GLYPHCACHE
+CGlyphCache         *NXWidgets::g_glyphCache;         /**< Rendered glyphs */
+#endif
 
 /****************************************************************************
  * Method Implementations
@@ -145,6 +149,15 @@ void NXWidgets::instantiateSingletons(void)
       g_nxTimers = new TNxArray<CNxTimer*>();
     }
 
+#ifdef CONFIG_NXWIDGETS_GLYPHCACHE
+  // Create the glyph cache shared by all of the windows
+
+  if (!g_glyphCache)
+    {
+      g_glyphCache = new CGlyphCache();
+    }
+#endif
+
   sched_unlock();
 }
 
@@ -183,4 +196,14 @@ void NXWidgets::freeSingletons(void)
       g_nxTimers = NULL;
     }
 
+#ifdef CONFIG_NXWIDGETS_GLYPHCACHE
+  // Free the glyph cache, after the default font
+
+  if (g_glyphCache)
+    {
+      delete g_glyphCache;
+      g_glyphCache = NULL;
+    }
+#endif
+
 }
@@ -758,7 +758,7 @@ NXWidgets::CNxWindow *CTaskbar::openRawWindow(void)
   // Get an (uninitialized) instance of the background window as a class
   // that derives from INxWindow.
 
-  NXWidgets::CNxWindow *window = createRawWindow(control);
+  NXWidgets::CNxWindow *window = createRawWindow(control, NXWM_WINDOW_FLAGS);
   if (!window)
     {
       delete control;
@@ -795,7 +795,8 @@ NXWidgets::CNxTkWindow *CTaskbar::openFramedWindow(void)
   // Get an (uninitialized) instance of the framed window as a class
   // that derives from INxWindow.
 
-  NXWidgets::CNxTkWindow *window = createFramedWindow(control);
+  NXWidgets::CNxTkWindow *window = createFramedWindow(control,
+                                                       NXWM_WINDOW_FLAGS);
   if (!window)
     {
       delete control;
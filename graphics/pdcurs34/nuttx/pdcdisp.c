@@ -856,13 +856,13 @@ static void PDC_transform_line_term(FAR SCREEN *s, int lineno, int x,
 
       if (*srcp & A_ALTCHARSET)
         {
-          write(termstate->out_fd, "\x1b(0", 3);
-          write(termstate->out_fd, buffer, i);
-          write(termstate->out_fd, "\x1b(B", 3);
+          termcurses_write(termstate->tcurs, "\x1b(0", 3);
+          termcurses_write(termstate->tcurs, buffer, i);
+          termcurses_write(termstate->tcurs, "\x1b(B", 3);
         }
       else
         {
-          write(termstate->out_fd, buffer, i);
+          termcurses_write(termstate->tcurs, buffer, i);
         }
 
       srcp += i;
@@ -988,6 +988,32 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
   PDC_update(fbstate, lineno, x, nextx - x);
 }
 
+/****************************************************************************
+ * Name: PDC_flush
+ *
+ * Description:
+ *   Called by doupdate() when the screen update is complete.  Terminal
+ *   output is collected by termcurses and is sent here with a single
+ *   write.
+ *
+ ****************************************************************************/
+
+void PDC_flush(void)
+{
+#ifdef CONFIG_SYSTEM_TERMCURSES
+#ifdef CONFIG_PDCURSES_MULTITHREAD
+  FAR struct pdc_context_s *ctx = PDC_ctx();
+#endif
+  FAR struct pdc_termscreen_s *termscreen;
+
+  if (!graphic_screen)
+    {
+      termscreen = (FAR struct pdc_termscreen_s *)SP;
+      termcurses_flush(termscreen->termstate.tcurs);
+    }
+#endif
+}
+
 /****************************************************************************
  * Name: PDC_clear_screen
  *
@@ -273,6 +273,7 @@ int doupdate(void)
   SP->cursrow = curscr->_cury;
   SP->curscol = curscr->_curx;
 
+  PDC_flush();
   return OK;
 }
 
@@ -30,6 +30,7 @@
 #include <stdarg.h>
 #include <stdbool.h>
 #include <string.h>
+#include <sched.h>
 #include <semaphore.h>
 #include <errno.h>
 
@@ -53,6 +54,32 @@
 #  define CONFIG_SCREENSHOT_FORMAT FB_FMT_RGB16_565
 #endif
 
+#ifndef CONFIG_SCREENSHOT_ROWS_PER_STRIP
+#  define CONFIG_SCREENSHOT_ROWS_PER_STRIP 16
+#endif
+
+#ifndef CONFIG_SCREENSHOT_IOBUFSIZE
+#  define CONFIG_SCREENSHOT_IOBUFSIZE 4096
+#endif
+
+#ifndef CONFIG_SCREENSHOT_PRIORITY
+#  define CONFIG_SCREENSHOT_PRIORITY 0
+#endif
+
+/* Bits per pixel of the format read from the display */
+
+#if CONFIG_SCREENSHOT_FORMAT == FB_FMT_Y1
+#  define SCREENSHOT_BPP 1
+#elif CONFIG_SCREENSHOT_FORMAT == FB_FMT_Y4
+#  define SCREENSHOT_BPP 4
+#elif CONFIG_SCREENSHOT_FORMAT == FB_FMT_Y8
+#  define SCREENSHOT_BPP 8
+#elif CONFIG_SCREENSHOT_FORMAT == FB_FMT_RGB16_565
+#  define SCREENSHOT_BPP 16
+#else
+#  define SCREENSHOT_BPP 24
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -69,27 +96,6 @@
  * Private Functions
  ****************************************************************************/
 
-static void replace_extension(FAR const char *filename,
-                              FAR const char *newext,
-                              FAR char *dest, size_t size)
-{
-  FAR char *p = strrchr(filename, '.');
-  int len = strlen(filename);
-
-  if (p != NULL)
-    {
-      len = p - filename;
-    }
-
-  if (len > size)
-    {
-      len = size - strlen(newext);
-    }
-
-  strlcpy(dest, filename, size);
-  strlcpy(dest + len, newext, size - len);
-}
-
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -117,17 +123,20 @@ int save_screenshot(FAR const char *filename)
 #ifdef CONFIG_VNCSERVER
   struct boardioc_vncstart_s vnc;
 #endif
+  struct nxgl_rect_s rect;
+#if CONFIG_SCREENSHOT_PRIORITY > 0
+  struct sched_param param;
+#endif
+  FAR uint8_t *frame;
   FAR uint8_t *strip;
   NXHANDLE server;
   NXWINDOW window;
-  char tempf1[64];
-  char tempf2[64];
+  size_t stride;
+  int rps = CONFIG_SCREENSHOT_ROWS_PER_STRIP;
+  int nrows;
   int row;
   int ret;
 
-  replace_extension(filename, ".tm1", tempf1, sizeof(tempf1));
-  replace_extension(filename, ".tm2", tempf2, sizeof(tempf2));
-
   /* Connect to NX server */
 
   server = nx_connect();
@@ -173,18 +182,69 @@ int save_screenshot(FAR const char *filename)
 
   nx_setsize(window, &size);
 
+  memset(&info, 0, sizeof(struct tiff_info_s));
+
+  /* Read the whole display at once, rounded up to whole strips, so that
+   * the server is only busy for a single request.
+   */
+
+  if (rps > size.h)
+    {
+      rps = size.h;
+    }
+
+  stride = (size.w * SCREENSHOT_BPP + 7) >> 3;
+  nrows  = (size.h + rps - 1) / rps * rps;
+  frame  = malloc(stride * nrows);
+  strip  = NULL;
+
+  rect.pt1.x = 0;
+  rect.pt1.y = 0;
+  rect.pt2.x = size.w - 1;
+  rect.pt2.y = size.h - 1;
+
+  if (frame != NULL)
+    {
+      memset(frame + stride * size.h, 0, stride * (nrows - size.h));
+      nx_getrectangle(window, &rect, 0, frame, stride);
+    }
+  else
+    {
+      /* Not enough memory, read each strip before writing it */
+
+      strip = zalloc(stride * rps);
+      if (strip == NULL)
+        {
+          printf("Failed to allocate the strip buffer\n");
+          goto errout;
+        }
+    }
+
+#if CONFIG_SCREENSHOT_PRIORITY > 0
+  /* Encode in the background of the graphics tasks */
+
+  param.sched_priority = CONFIG_SCREENSHOT_PRIORITY;
+  sched_setparam(0, &param);
+#endif
+
   /* Configure the TIFF structure */
 
-  memset(&info, 0, sizeof(struct tiff_info_s));
   info.outfile   = filename;
-  info.tmpfile1  = tempf1;
-  info.tmpfile2  = tempf2;
   info.colorfmt  = CONFIG_SCREENSHOT_FORMAT;
-  info.rps       = 1;
+  info.rps       = rps;
   info.imgwidth  = size.w;
   info.imgheight = size.h;
-  info.iobuffer  = (uint8_t *)malloc(300);
-  info.iosize    = 300;
+  info.iobuffer  = (uint8_t *)malloc(CONFIG_SCREENSHOT_IOBUFSIZE);
+  info.iosize    = CONFIG_SCREENSHOT_IOBUFSIZE;
+#ifdef CONFIG_SCREENSHOT_PACKBITS
+  info.compress  = TAG_COMP_PACKBITS;
+#endif
+
+  if (info.iobuffer == NULL)
+    {
+      printf("Failed to allocate the I/O buffer\n");
+      goto errout;
+    }
 
   /* Initialize the TIFF library */
 
@@ -192,37 +252,37 @@ int save_screenshot(FAR const char *filename)
   if (ret < 0)
     {
       printf("tiff_initialize() failed: %d\n", ret);
-      return 1;
+      goto errout;
     }
 
   /* Add each strip to the TIFF file */
 
-  strip = malloc(size.w * 3);
-
-  for (row = 0; row < size.h; row++)
+  for (row = 0; row < size.h; row += rps)
     {
-      struct nxgl_rect_s rect =
-      {
+      if (frame != NULL)
         {
-          0, row
-        },
+          ret = tiff_addstrip(&info, frame + row * stride);
+        }
+      else
         {
-          size.w - 1, row
+          rect.pt1.y = row;
+          rect.pt2.y = row + rps - 1;
+          if (rect.pt2.y >= size.h)
+            {
+              rect.pt2.y = size.h - 1;
+            }
+
+          nx_getrectangle(window, &rect, 0, strip, stride);
+          ret = tiff_addstrip(&info, strip);
         }
-      };
-
-      nx_getrectangle(window, &rect, 0, strip, 0);
 
-      ret = tiff_addstrip(&info, strip);
       if (ret < 0)
         {
-          printf("tiff_addstrip() #%d failed: %d\n", row, ret);
-          break;
+          printf("tiff_addstrip() #%d failed: %d\n", row / rps, ret);
+          goto errout;
         }
     }
 
-  free(strip);
-
   /* Then finalize the TIFF file */
 
   ret = tiff_finalize(&info);
@@ -231,6 +291,9 @@ int save_screenshot(FAR const char *filename)
       printf("tiff_finalize() failed: %d\n", ret);
     }
 
+errout:
+  free(strip);
+  free(frame);
   free(info.iobuffer);
   nx_closewindow(window);
   nx_disconnect(server);
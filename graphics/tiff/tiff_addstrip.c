@@ -53,86 +53,138 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: tiff_addstrip
+ * Name: tiff_convstrip
  *
  * Description:
- *   Convert an RGB565 strip to an RGB888 strip and write it to tmpfile2.
- *
- *   Add an image data strip.  The size of the strip in pixels must be equal
- *   to the RowsPerStrip x ImageWidth values that were provided to
- *   tiff_initialize().
+ *   Convert an RGB565 strip to an RGB888 strip and append it to the
+ *   outfile.  The pixels are converted in place in the I/O buffer.
  *
  * Input Parameters:
  *   info    - A pointer to the caller allocated parameter passing/TIFF state instance.
- *   buffer  - A buffer containing a single row of data.
+ *   strip   - The strip data.
  *
  * Returned Value:
  *   Zero (OK) on success.  A negated errno value on failure.
  *
  ****************************************************************************/
-int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
+
+static int tiff_convstrip(FAR struct tiff_info_s *info,
+                          FAR const uint8_t *strip)
 {
-#ifdef CONFIG_DEBUG_GRAPHICS
-  size_t ntotal;
-#endif
-  size_t nbytes;
-  FAR uint16_t *src;
+  FAR const uint16_t *src;
   FAR uint8_t *dest;
   uint16_t rgb565;
   int ret;
   int i;
 
-  DEBUGASSERT(info->iobuffer != NULL);
+  DEBUGASSERT(info->iobuffer != NULL && info->iosize >= 3);
 
   /* Convert each RGB565 pixel to RGB888 */
 
-  src    = (FAR uint16_t *)strip;
-  dest   = info->iobuffer;
-  nbytes = 0;
-#ifdef CONFIG_DEBUG_GRAPHICS
-  ntotal = 0;
-#endif
-
+  src = (FAR const uint16_t *)strip;
   for (i = 0; i < info->pps; i++)
     {
+      /* Flush the I/O buffer when the next pixel does not fit */
+
+      if (info->iohead + info->iolen > info->iosize - 3)
+        {
+          ret = tiff_flush(info);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+
       /* Convert RGB565 to RGB888 */
 
+      dest    = &info->iobuffer[info->iohead + info->iolen];
       rgb565  = *src++;
       *dest++ = (rgb565 >> (11-3)) & 0xf8; /* Move bits 11-15 to 3-7 */
       *dest++ = (rgb565 >> ( 5-2)) & 0xfc; /* Move bits  5-10 to 2-7 */
       *dest++ = (rgb565 << (   3)) & 0xf8; /* Move bits  0- 4 to 3-7 */
 
-      /* Update the byte count */
+      info->iolen += 3;
+    }
+
+  info->outsize += info->bps;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: tiff_packstrip
+ *
+ * Description:
+ *   Compress a strip with PackBits, row by row, and append it to the
+ *   outfile.  RGB565 rows are converted to RGB888 first, in the head of the
+ *   I/O buffer.  The compressed rows are collected after it.
+ *
+ * Input Parameters:
+ *   info   - A pointer to the caller allocated parameter passing/TIFF state
+ *            instance.
+ *   strip  - The strip data.
+ *   nbytes - The location to return the size of the compressed strip.
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static int tiff_packstrip(FAR struct tiff_info_s *info,
+                          FAR const uint8_t *strip, FAR size_t *nbytes)
+{
+  size_t rowbytes = info->iohead;
+  size_t maxsize  = TIFF_PACKBITS_MAXSIZE(rowbytes);
+  size_t avail    = info->iosize - info->iohead;
+  FAR const uint8_t *row;
+  FAR const uint16_t *src;
+  FAR uint8_t *dest;
+  size_t n;
+  int ret;
+  int i;
+  int j;
+
+  *nbytes = 0;
+  for (i = 0; i < info->rps; i++)
+    {
+      if (info->colorfmt == FB_FMT_RGB16_565)
+        {
+          /* Convert RGB565 to RGB888 in the head of the I/O buffer */
 
-      nbytes += 3;
-#ifdef CONFIG_DEBUG_GRAPHICS
-      ntotal += 3;
-#endif
+          src  = (FAR const uint16_t *)strip + i * info->imgwidth;
+          dest = info->iobuffer;
+          for (j = 0; j < info->imgwidth; j++, src++)
+            {
+              *dest++ = (*src >> (11-3)) & 0xf8;
+              *dest++ = (*src >> ( 5-2)) & 0xfc;
+              *dest++ = (*src << (   3)) & 0xf8;
+            }
+
+          row = info->iobuffer;
+        }
+      else
+        {
+          row = strip + i * rowbytes;
+        }
 
-      /* Flush the conversion buffer to tmpfile2 when it becomes full */
+      /* Flush the compressed data if the next row may not fit */
 
-      if (nbytes > (info->iosize-3))
+      if (avail - info->iolen < maxsize)
         {
-          ret = tiff_write(info->tmp2fd, info->iobuffer, nbytes);
+          ret = tiff_flush(info);
           if (ret < 0)
             {
               return ret;
             }
-
-          /* Reset to refill the conversion buffer */
-
-          dest   = info->iobuffer;
-          nbytes = 0;
         }
-    }
 
-  /* Flush any buffer data to tmpfile2 */
+      n = tiff_packbits(row, rowbytes,
+                        info->iobuffer + info->iohead + info->iolen);
+      info->iolen += n;
+      *nbytes     += n;
+    }
 
-  ret = tiff_write(info->tmp2fd, info->iobuffer, nbytes);
-#ifdef CONFIG_DEBUG_GRAPHICS
-  DEBUGASSERT(ntotal == info->bps);
-#endif
-  return ret;
+  info->outsize += *nbytes;
+  return OK;
 }
 
 /****************************************************************************
@@ -147,6 +199,9 @@ int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
  *   to the RowsPerStrip x ImageWidth values that were provided to
  *   tiff_initialize().
  *
+ *   The strip is appended to the outfile through the I/O buffer and its
+ *   offset and size are recorded in the strip tables in memory.
+ *
  * Input Parameters:
  *   info    - A pointer to the caller allocated parameter passing/TIFF state instance.
  *   buffer  - A buffer containing a single row of data.
@@ -158,14 +213,28 @@ int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
 
 int tiff_addstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
 {
-  ssize_t newsize;
+  uint32_t zero = 0;
+  uint32_t offset;
+  size_t nbytes = info->bps;
   int ret;
 
+  if (info->nstrips >= info->maxstrips)
+    {
+      gerr("ERROR: More than %d strips\n", info->maxstrips);
+      ret = -E2BIG;
+      goto errout;
+    }
+
   /* Add the new strip based on the color format.  For FB_FMT_RGB16_565,
    * will have to perform a conversion to RGB888.
    */
 
-  if (info->colorfmt == FB_FMT_RGB16_565)
+  offset = info->outsize;
+  if (info->compress == TAG_COMP_PACKBITS)
+    {
+      ret = tiff_packstrip(info, strip, &nbytes);
+    }
+  else if (info->colorfmt == FB_FMT_RGB16_565)
     {
       ret = tiff_convstrip(info, strip);
     }
@@ -174,7 +243,7 @@ int tiff_addstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
 
   else
     {
-      ret = tiff_write(info->tmp2fd, strip, info->bps);
+      ret = tiff_putdata(info, strip, info->bps);
     }
 
   if (ret < 0)
@@ -182,35 +251,19 @@ int tiff_addstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
       goto errout;
     }
 
-  /* Write the byte count to the outfile and the offset to tmpfile1 */
+  /* Record the byte count and the offset of the strip */
 
-  ret = tiff_putint32(info->outfd, info->bps);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  info->outsize += 4;
+  tiff_put32(&info->striptab[4 * info->nstrips], nbytes);
+  tiff_put32(&info->striptab[4 * (info->maxstrips + info->nstrips)],
+             offset);
 
-  ret = tiff_putint32(info->tmp1fd, info->tmp2size);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  info->tmp1size += 4;
+  /* Pad as necessary achieve word alignment of the next strip */
 
-  /* Increment the size of tmp2file. */
-
-  info->tmp2size += info->bps;
-
-  /* Pad tmpfile2 as necessary achieve word alignment */
-
-  newsize = tiff_wordalign(info->tmp2fd, info->tmp2size);
-  if (newsize < 0)
+  ret = tiff_putdata(info, &zero, (4 - (info->outsize & 3)) & 3);
+  if (ret < 0)
     {
-      ret = (int)newsize;
       goto errout;
     }
-  info->tmp2size = (size_t)newsize;
 
   /* Increment the number of strips in the TIFF file */
 
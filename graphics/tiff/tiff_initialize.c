@@ -24,6 +24,7 @@
 
 #include <nuttx/config.h>
 
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -187,6 +188,10 @@
 #define TIFF_RGB_DATEOFFSET     226
 #define TIFF_RGB_STRIPBCOFFSET  248
 
+/* Size of the largest header, up to the StripByteCounts values */
+
+#define TIFF_MAXHDRSIZE         TIFF_RGB_STRIPBCOFFSET
+
 /* Debug *******************************************************************/
 /* CONFIG_DEBUG_TIFFOFFSETS may be defined (along with CONFIG_DEBUG_FEATURES and
  * CONFIG_DEBUG_GRAPHICS) in order to verify the pre-determined TIFF file
@@ -198,10 +203,8 @@
 #endif
 
 #ifdef CONFIG_DEBUG_TIFFOFFSETS
-#  define tiff_offset(o,l)      (o) += (l)
 #  define tiff_checkoffs(o,x)   DEBUGASSERT((o) == (x))
 #else
-#  define tiff_offset(o,l)
 #  define tiff_checkoffs(o,x)
 #endif
 
@@ -264,115 +267,126 @@ static const struct tiff_filefmt_s g_rgbinfo =
  * Name: tiff_putheader
  *
  * Description:
- *   Setup to create a new TIFF file.
+ *   Put the TIFF header in the header buffer.
  *
  * Input Parameters:
- *   info - A pointer to the caller allocated parameter passing/TIFF state
- *          instance.
+ *   dest - The location of the header in the header buffer
  *
  * Returned Value:
- *   Zero (OK) on success.  A negated errno value on failure.
+ *   The location that follows the header and its padding.
  *
  ****************************************************************************/
 
-static inline int tiff_putheader(FAR struct tiff_info_s *info)
+static FAR uint8_t *tiff_putheader(FAR uint8_t *dest)
 {
-  struct tiff_header_s hdr;
-  int ret;
+  FAR struct tiff_header_s *hdr = (FAR struct tiff_header_s *)dest;
 
   /* 0-1: Byte order */
 
 #ifdef CONFIG_ENDIAN_BIG
-  hdr.order[0] = 'M';  /* "MM"=big endian */
-  hdr.order[1] = 'M';
+  hdr->order[0] = 'M';  /* "MM"=big endian */
+  hdr->order[1] = 'M';
 #else
-  hdr.order[0] = 'I';  /* "II"=little endian */
-  hdr.order[1] = 'I';
+  hdr->order[0] = 'I';  /* "II"=little endian */
+  hdr->order[1] = 'I';
 #endif
 
   /* 2-3: 42 in appropriate byte order */
 
-  tiff_put16(hdr.magic, 42);
+  tiff_put16(hdr->magic, 42);
 
   /* 4-7: Offset to the first IFD */
 
-  tiff_put32(hdr.offset, TIFF_IFD_OFFSET);
-
-  /* Write the header to the output file */
-
-  ret = tiff_write(info->outfd, &hdr, SIZEOF_TIFF_HEADER);
-  if (ret != OK)
-    {
-      return ret;
-    }
+  tiff_put32(hdr->offset, TIFF_IFD_OFFSET);
 
   /* Two pad bytes following the header */
 
-  ret = tiff_putint16(info->outfd, 0);
-  return ret;
+  tiff_put16(dest + SIZEOF_TIFF_HEADER, 0);
+  return dest + TIFF_IFD_OFFSET;
 }
 
 /****************************************************************************
  * Name: tiff_putifdentry
  *
  * Description:
- *   Write an IFD entry to outfile
+ *   Put an IFD entry in the header buffer
  *
  * Input Parameters:
- *   info   - A pointer to the caller allocated parameter passing/TIFF state
- *            instance.
+ *   dest   - The location of the entry in the header buffer
  *   tag    - The value for the IFD tag field
  *   type   - The value for the IFD type field
  *   count  - The value for the IFD count field
  *   offset - The value for the IFD offset field
  *
  * Returned Value:
- *   Zero (OK) on success.  A negated errno value on failure.
+ *   The location that follows the IFD entry.
  *
  ****************************************************************************/
 
-static int tiff_putifdentry(FAR struct tiff_info_s *info, uint16_t tag,
-                           uint16_t type, uint32_t count, uint32_t offset)
+static FAR uint8_t *tiff_putifdentry(FAR uint8_t *dest, uint16_t tag,
+                                     uint16_t type, uint32_t count,
+                                     uint32_t offset)
 {
-  struct tiff_ifdentry_s ifd;
-  tiff_put16(ifd.tag, tag);
-  tiff_put16(ifd.type, type);
-  tiff_put32(ifd.count, count);
-  tiff_put32(ifd.offset, offset);
-  return tiff_write(info->outfd, &ifd, SIZEOF_IFD_ENTRY);
+  FAR struct tiff_ifdentry_s *ifd = (FAR struct tiff_ifdentry_s *)dest;
+
+  tiff_put16(ifd->tag, tag);
+  tiff_put16(ifd->type, type);
+  tiff_put32(ifd->count, count);
+  tiff_put32(ifd->offset, offset);
+  return dest + SIZEOF_IFD_ENTRY;
 }
 
 /****************************************************************************
- * Name: tiff_putifdentry
+ * Name: tiff_putifdentry16
  *
  * Description:
- *   Write an IFD with a 16-bit immediate value
+ *   Put an IFD with a 16-bit immediate value in the header buffer
  *
  * Input Parameters:
- *   info - A pointer to the caller allocated parameter passing/TIFF state
- *          instance.
+ *   dest   - The location of the entry in the header buffer
  *   tag    - The value for the IFD tag field
  *   type   - The value for the IFD type field
  *   count  - The value for the IFD count field
  *   value  - The 16-bit immediate value
  *
  * Returned Value:
- *   Zero (OK) on success.  A negated errno value on failure.
+ *   The location that follows the IFD entry.
+ *
+ ****************************************************************************/
+
+static FAR uint8_t *tiff_putifdentry16(FAR uint8_t *dest, uint16_t tag,
+                                       uint16_t type, uint32_t count,
+                                       uint16_t value)
+{
+  FAR struct tiff_ifdentry_s *ifd = (FAR struct tiff_ifdentry_s *)dest;
+
+  tiff_putifdentry(dest, tag, type, count, 0);
+  tiff_put16(ifd->offset, value);
+  return dest + SIZEOF_IFD_ENTRY;
+}
+
+/****************************************************************************
+ * Name: tiff_putrational
+ *
+ * Description:
+ *   Put a RATIONAL value in the header buffer
+ *
+ * Input Parameters:
+ *   dest  - The location of the value in the header buffer
+ *   num   - The numerator
+ *   denom - The denominator
+ *
+ * Returned Value:
+ *   The location that follows the value.
  *
  ****************************************************************************/
 
-static int tiff_putifdentry16(FAR struct tiff_info_s *info, uint16_t tag,
-                             uint16_t type, uint32_t count, uint16_t value)
+static FAR uint8_t *tiff_putrational(FAR uint8_t *dest, uint32_t num,
+                                     uint32_t denom)
 {
-  union
-  {
-    uint8_t  b[4];
-    uint32_t w;
-  } u;
-
-  u.w = 0;
-  tiff_put16(u.b, value);
-  return tiff_putifdentry(info, tag, type, count, u.w);
+  tiff_put32(dest, num);
+  tiff_put32(dest + 4, denom);
+  return dest + 8;
 }
 
 /****************************************************************************
@@ -434,16 +448,16 @@ static int tiff_datetime(FAR char *timbuf, unsigned int buflen)
 
 int tiff_initialize(FAR struct tiff_info_s *info)
 {
+  uint8_t hdr[TIFF_MAXHDRSIZE];
+  FAR uint8_t *ptr;
+  uint32_t dataoffs;
   uint16_t val16;
-#ifdef CONFIG_DEBUG_TIFFOFFSETS
-  off_t offset = 0;
-#endif
   char timbuf[TIFF_DATETIME_STRLEN + 8];
   int ret = -EINVAL;
 
-  DEBUGASSERT(info && info->outfile && info->tmpfile1 && info->tmpfile2);
+  DEBUGASSERT(info && info->outfile && info->rps > 0);
 
-  /* Open all output files */
+  /* Open the output file */
 
   info->outfd = open(info->outfile, O_RDWR|O_CREAT|O_TRUNC, 0666);
   if (info->outfd < 0)
@@ -453,22 +467,6 @@ int tiff_initialize(FAR struct tiff_info_s *info)
       goto errout;
     }
 
-  info->tmp1fd = open(info->tmpfile1, O_RDWR|O_CREAT|O_TRUNC, 0666);
-  if (info->tmp1fd < 0)
-    {
-      gerr("ERROR: Failed to open %s for reading/writing: %d\n",
-           info->tmpfile1, errno);
-      goto errout;
-    }
-
-  info->tmp2fd = open(info->tmpfile2, O_RDWR|O_CREAT|O_TRUNC, 0666);
-  if (info->tmp2fd < 0)
-    {
-      gerr("ERROR: Failed to open %s for reading/writing: %d\n",
-           info->tmpfile2, errno);
-      goto errout;
-    }
-
   /* Make some decisions using the color format.  Only the following are
    * supported:
    */
@@ -511,7 +509,44 @@ int tiff_initialize(FAR struct tiff_info_s *info)
         return -EINVAL;
     }
 
-  /* Write the TIFF header data to the outfile:
+  /* PackBits compresses each row separately, in the I/O buffer after the
+   * row itself.
+   */
+
+  if (info->compress == TAG_COMP_PACKBITS)
+    {
+      size_t rowbytes = info->bps / info->rps;
+
+      if (info->bps % info->rps != 0 ||
+          info->iosize < rowbytes + TIFF_PACKBITS_MAXSIZE(rowbytes))
+        {
+          gerr("ERROR: PackBits needs byte rows and %zu byte buffer\n",
+               rowbytes + TIFF_PACKBITS_MAXSIZE(rowbytes));
+          goto errout;
+        }
+    }
+  else if (info->compress != 0 && info->compress != TAG_COMP_NONE)
+    {
+      gerr("ERROR: Unsupported compression: %d\n", info->compress);
+      goto errout;
+    }
+
+  /* The number of strips follows from the image height, so the strip
+   * tables can be kept in memory and the strip data can be written
+   * directly after them.
+   */
+
+  info->maxstrips = (info->imgheight + info->rps - 1) / info->rps;
+  info->striptab  = (FAR uint8_t *)malloc(8 * info->maxstrips);
+  if (info->striptab == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  dataoffs = info->filefmt->sbcoffset + 8 * info->maxstrips;
+
+  /* Build the whole header in memory:
    *
    * Header:    0    Byte Order                  "II" or "MM"
    *            2    Magic Number                42
@@ -519,63 +554,41 @@ int tiff_initialize(FAR struct tiff_info_s *info)
    *            8    [2 bytes padding]
    */
 
-  ret = tiff_putheader(info);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, TIFF_IFD_OFFSET);
+  ptr = tiff_putheader(hdr);
+  tiff_checkoffs(ptr - hdr, TIFF_IFD_OFFSET);
 
-  /* Write the Number of directory entries
+  /* Put the Number of directory entries
    *
    * All formats: Offset 10 Number of Directory Entries 12
    */
 
-  ret = tiff_putint16(info->outfd, info->filefmt->nifdentries);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, 2);
+  tiff_put16(ptr, info->filefmt->nifdentries);
+  ptr += 2;
 
-  /* Write the NewSubfileType IFD entry
+  /* Put the NewSubfileType IFD entry
    *
    * All formats: Offset 12 NewSubfileType
    */
 
-  ret = tiff_putifdentry16(info, IFD_TAG_NEWSUBFILETYPE, IFD_FIELD_LONG, 1, 0);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, SIZEOF_IFD_ENTRY);
+  ptr = tiff_putifdentry16(ptr, IFD_TAG_NEWSUBFILETYPE, IFD_FIELD_LONG, 1, 0);
 
-  /* Write ImageWidth and ImageLength
+  /* Put ImageWidth and ImageLength
    *
    * All formats: Offset 24 ImageWidth  Number of columns is a user parameter
    *                     36 ImageLength Number of rows is a user parameter
    */
 
-  ret = tiff_putifdentry16(info, IFD_TAG_IMAGEWIDTH, IFD_FIELD_SHORT, 1, info->imgwidth);
-  if (ret == OK)
-    {
-      ret= tiff_putifdentry16(info, IFD_TAG_IMAGELENGTH, IFD_FIELD_SHORT, 1, info->imgheight);
-    }
-
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, 2*SIZEOF_IFD_ENTRY);
+  ptr = tiff_putifdentry16(ptr, IFD_TAG_IMAGEWIDTH, IFD_FIELD_SHORT, 1, info->imgwidth);
+  ptr = tiff_putifdentry16(ptr, IFD_TAG_IMAGELENGTH, IFD_FIELD_SHORT, 1, info->imgheight);
 
-  /* Write BitsPerSample
+  /* Put BitsPerSample
    *
    * Bi-level Images: None
    * Greyscale:       Offset 48 BitsPerSample (4 or 8)
    * RGB:             Offset 48 BitsPerSample (8,8,8)
    */
 
-  tiff_checkoffs(offset, 48);
+  tiff_checkoffs(ptr - hdr, 48);
   if (IMGFLAGS_ISGREY(info->imgflags))
     {
       if (IMGFLAGS_ISGREY8(info->imgflags))
@@ -587,38 +600,25 @@ int tiff_initialize(FAR struct tiff_info_s *info)
           val16 = 4;
         }
 
-      ret = tiff_putifdentry16(info, IFD_TAG_BITSPERSAMPLE, IFD_FIELD_SHORT, 1, val16);
-      if (ret < 0)
-        {
-          goto errout;
-        }
-      tiff_offset(offset, SIZEOF_IFD_ENTRY);
+      ptr = tiff_putifdentry16(ptr, IFD_TAG_BITSPERSAMPLE, IFD_FIELD_SHORT, 1, val16);
     }
   else if (IMGFLAGS_ISRGB(info->imgflags))
     {
-      ret = tiff_putifdentry(info, IFD_TAG_BITSPERSAMPLE, IFD_FIELD_SHORT, 3, TIFF_RGB_BPSOFFSET);
-      if (ret < 0)
-        {
-          goto errout;
-        }
-      tiff_offset(offset, SIZEOF_IFD_ENTRY);
+      ptr = tiff_putifdentry(ptr, IFD_TAG_BITSPERSAMPLE, IFD_FIELD_SHORT, 3, TIFF_RGB_BPSOFFSET);
     }
 
-  /* Write Compression:
+  /* Put Compression:
    *
-   * Bi-level Images: Offset 48 Hard-coded no compression (for now)
-   * Greyscale:       Offset 60  "  " "   " "" "          " " " " "
-   * RGB:             Offset 60 "  " "   " "" "          " " " " "
+   * Bi-level Images: Offset 48 No compression or PackBits
+   * Greyscale:       Offset 60  "  " "         " "" "      "
+   * RGB:             Offset 60  "  " "         " "" "      "
    */
 
-  ret = tiff_putifdentry16(info, IFD_TAG_COMPRESSION, IFD_FIELD_SHORT, 1, TAG_COMP_NONE);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, SIZEOF_IFD_ENTRY);
+  ptr = tiff_putifdentry16(ptr, IFD_TAG_COMPRESSION, IFD_FIELD_SHORT, 1,
+                           info->compress == TAG_COMP_PACKBITS ?
+                           TAG_COMP_PACKBITS : TAG_COMP_NONE);
 
-  /* Write PhotometricInterpretation:
+  /* Put PhotometricInterpretation:
    *
    * Bi-level Images: Offset 48 Hard-coded BlackIsZero
    * Greyscale:       Offset 72 Hard-coded BlackIsZero
@@ -634,29 +634,23 @@ int tiff_initialize(FAR struct tiff_info_s *info)
       val16 = TAG_PMI_BLACK;
     }
 
-  ret = tiff_putifdentry16(info, IFD_TAG_PMI, IFD_FIELD_SHORT, 1, val16);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, SIZEOF_IFD_ENTRY);
+  ptr = tiff_putifdentry16(ptr, IFD_TAG_PMI, IFD_FIELD_SHORT, 1, val16);
 
-  /* Write StripOffsets:
+  /* Put StripOffsets.  The number of strips is known from the image height
+   * and the table follows the StripByteCounts values.  A single offset is
+   * stored in the entry itself.
    *
-   * Bi-level Images: Offset 72 Value determined by switch statement above
-   * Greyscale:       Offset 84 Value determined by switch statement above
-   * RGB:             Offset 84 Value determined by switch statement above
+   * Bi-level Images: Offset 72
+   * Greyscale:       Offset 84
+   * RGB:             Offset 84
    */
 
-  tiff_checkoffs(offset, info->filefmt->soifdoffset);
-  ret = tiff_putifdentry(info, IFD_TAG_STRIPOFFSETS, IFD_FIELD_LONG, 0, 0);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, SIZEOF_IFD_ENTRY);
+  tiff_checkoffs(ptr - hdr, info->filefmt->soifdoffset);
+  ptr = tiff_putifdentry(ptr, IFD_TAG_STRIPOFFSETS, IFD_FIELD_LONG,
+                         info->maxstrips, info->maxstrips == 1 ? dataoffs :
+                         info->filefmt->sbcoffset + 4 * info->maxstrips);
 
-  /* Write SamplesPerPixel
+  /* Put SamplesPerPixel
    *
    * Bi-level Images: N/A
    * Greyscale:       N/A
@@ -665,105 +659,69 @@ int tiff_initialize(FAR struct tiff_info_s *info)
 
   if (IMGFLAGS_ISRGB(info->imgflags))
     {
-      ret = tiff_putifdentry16(info, IFD_TAG_SAMPLESPERPIXEL, IFD_FIELD_SHORT, 1, 3);
-      if (ret < 0)
-        {
-          goto errout;
-        }
-      tiff_offset(offset, SIZEOF_IFD_ENTRY);
+      ptr = tiff_putifdentry16(ptr, IFD_TAG_SAMPLESPERPIXEL, IFD_FIELD_SHORT, 1, 3);
     }
 
-  /* Write RowsPerStrip:
+  /* Put RowsPerStrip:
    *
    * Bi-level Images: Offset  84 Value is a user parameter
    * Greyscale:       Offset  96 Value is a user parameter
    * RGB:             Offset 108 Value is a user parameter
    */
 
-  ret = tiff_putifdentry16(info, IFD_TAG_ROWSPERSTRIP, IFD_FIELD_SHORT, 1, info->rps);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, SIZEOF_IFD_ENTRY);
+  ptr = tiff_putifdentry16(ptr, IFD_TAG_ROWSPERSTRIP, IFD_FIELD_SHORT, 1, info->rps);
 
-  /* Write StripByteCounts:
+  /* Put StripByteCounts.  A single count is stored in the entry itself
+   * by tiff_finalize().
    *
-   * Bi-level Images: Offset  96 Count determined as strips added, Value offset = 216
-   * Greyscale:       Offset 108 Count determined as strips added, Value offset = 228
-   * RGB:             Offset 120 Count determined as strips added, Value offset = 248
+   * Bi-level Images: Offset  96 Value offset = 216
+   * Greyscale:       Offset 108 Value offset = 228
+   * RGB:             Offset 120 Value offset = 248
    */
 
-  tiff_checkoffs(offset, info->filefmt->sbcifdoffset);
-  ret = tiff_putifdentry(info, IFD_TAG_STRIPCOUNTS, IFD_FIELD_LONG, 0, info->filefmt->sbcoffset);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, SIZEOF_IFD_ENTRY);
+  tiff_checkoffs(ptr - hdr, info->filefmt->sbcifdoffset);
+  ptr = tiff_putifdentry(ptr, IFD_TAG_STRIPCOUNTS, IFD_FIELD_LONG,
+                         info->maxstrips, info->maxstrips == 1 ? 0 :
+                         info->filefmt->sbcoffset);
 
-  /* Write XResolution and YResolution:
+  /* Put XResolution and YResolution:
    *
    * Bi-level Images: Offset 108 and 120, Values are a user parameters
    * Greyscale:       Offset 120 and 132, Values are a user parameters
    * RGB:             Offset 132 and 144, Values are a user parameters
    */
 
-  ret = tiff_putifdentry(info, IFD_TAG_XRESOLUTION, IFD_FIELD_RATIONAL, 1, info->filefmt->xresoffset);
-  if (ret == OK)
-    {
-      ret = tiff_putifdentry(info, IFD_TAG_YRESOLUTION, IFD_FIELD_RATIONAL, 1, info->filefmt->yresoffset);
-    }
-
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, 2*SIZEOF_IFD_ENTRY);
+  ptr = tiff_putifdentry(ptr, IFD_TAG_XRESOLUTION, IFD_FIELD_RATIONAL, 1, info->filefmt->xresoffset);
+  ptr = tiff_putifdentry(ptr, IFD_TAG_YRESOLUTION, IFD_FIELD_RATIONAL, 1, info->filefmt->yresoffset);
 
-  /* Write ResolutionUnit:
+  /* Put ResolutionUnit:
    *
    * Bi-level Images: Offset 132, Hard-coded to "inches"
    * Greyscale:       Offset 144, Hard-coded to "inches"
    * RGB:             Offset 156, Hard-coded to "inches"
    */
 
-  ret = tiff_putifdentry16(info, IFD_TAG_RESUNIT, IFD_FIELD_SHORT, 1, TAG_RESUNIT_INCH);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, SIZEOF_IFD_ENTRY);
+  ptr = tiff_putifdentry16(ptr, IFD_TAG_RESUNIT, IFD_FIELD_SHORT, 1, TAG_RESUNIT_INCH);
 
-  /* Write Software:
+  /* Put Software:
    *
    * Bi-level Images: Offset 144 Count, Hard-coded "NuttX"
    * Greyscale:       Offset 156 Count, Hard-coded "NuttX"
    * RGB:             Offset 168 Count, Hard-coded "NuttX"
    */
 
-  ret = tiff_putifdentry(info, IFD_TAG_SOFTWARE, IFD_FIELD_ASCII, TIFF_SOFTWARE_STRLEN, info->filefmt->swoffset);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, SIZEOF_IFD_ENTRY);
+  ptr = tiff_putifdentry(ptr, IFD_TAG_SOFTWARE, IFD_FIELD_ASCII, TIFF_SOFTWARE_STRLEN, info->filefmt->swoffset);
 
-  /* Write DateTime:
+  /* Put DateTime:
    *
    * Bi-level Images: Offset 156 Count, Format "YYYY:MM:DD HH:MM:SS"
    * Greyscale:       Offset 168 Count, Format "YYYY:MM:DD HH:MM:SS"
    * RGB:             Offset 180 Count, Format "YYYY:MM:DD HH:MM:SS"
    */
 
-  ret = tiff_putifdentry(info, IFD_TAG_DATETIME, IFD_FIELD_ASCII, TIFF_DATETIME_STRLEN, info->filefmt->dateoffset);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, SIZEOF_IFD_ENTRY);
+  ptr = tiff_putifdentry(ptr, IFD_TAG_DATETIME, IFD_FIELD_ASCII, TIFF_DATETIME_STRLEN, info->filefmt->dateoffset);
 
-  /* Write Next IFD Offset and 2 bytes of padding:
+  /* Put Next IFD Offset and 2 bytes of padding:
    *
    * Bi-level Images: Offset 168, Next IFD offset
    *                  Offset 170, [2 bytes padding]
@@ -773,18 +731,14 @@ int tiff_initialize(FAR struct tiff_info_s *info)
    *                  Offset 194, [2 bytes padding]
    */
 
-  ret = tiff_putint32(info->outfd, 0);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, 4);
+  tiff_put32(ptr, 0);
+  ptr += 4;
 
   /* Now we begin the value section of the file */
 
-  tiff_checkoffs(offset, info->filefmt->valoffset);
+  tiff_checkoffs(ptr - hdr, info->filefmt->valoffset);
 
-  /* Write the XResolution and YResolution data:
+  /* Put the XResolution and YResolution data:
    *
    * Bi-level Images: Offset 172 Count, Hard-coded to 300/1
    *                  Offset 180 Count, Hard-coded to 300/1
@@ -794,33 +748,13 @@ int tiff_initialize(FAR struct tiff_info_s *info)
    *                  Offset 204 Count, Hard-coded to 300/1
    */
 
-  tiff_checkoffs(offset, info->filefmt->xresoffset);
-  ret = tiff_putint32(info->outfd, 300);
-  if (ret == OK)
-    {
-      ret = tiff_putint32(info->outfd, 1);
-    }
+  tiff_checkoffs(ptr - hdr, info->filefmt->xresoffset);
+  ptr = tiff_putrational(ptr, 300, 1);
 
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, 8);
-
-  tiff_checkoffs(offset, info->filefmt->yresoffset);
-  ret = tiff_putint32(info->outfd, 300);
-  if (ret == OK)
-    {
-      ret = tiff_putint32(info->outfd, 1);
-    }
-
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, 8);
+  tiff_checkoffs(ptr - hdr, info->filefmt->yresoffset);
+  ptr = tiff_putrational(ptr, 300, 1);
 
-  /* Write RGB BitsPerSample Data:
+  /* Put RGB BitsPerSample Data:
    *
    * Bi-level Images: N/A
    * Greyscale:       N/A
@@ -830,15 +764,15 @@ int tiff_initialize(FAR struct tiff_info_s *info)
 
   if (IMGFLAGS_ISRGB(info->imgflags))
     {
-      tiff_checkoffs(offset, TIFF_RGB_BPSOFFSET);
-      tiff_putint16(info->outfd, 8);
-      tiff_putint16(info->outfd, 8);
-      tiff_putint16(info->outfd, 8);
-      tiff_putint16(info->outfd, 0);
-      tiff_offset(offset, 8);
+      tiff_checkoffs(ptr - hdr, TIFF_RGB_BPSOFFSET);
+      tiff_put16(ptr, 8);
+      tiff_put16(ptr + 2, 8);
+      tiff_put16(ptr + 4, 8);
+      tiff_put16(ptr + 6, 0);
+      ptr += 8;
     }
 
-  /* Write the Software string:
+  /* Put the Software string:
    *
    *
    * Bi-level Images: Offset 188, Hard-coded "NuttX"
@@ -846,15 +780,11 @@ int tiff_initialize(FAR struct tiff_info_s *info)
    * RGB:             Offset 220, Hard-coded "NuttX"
    */
 
-  tiff_checkoffs(offset, info->filefmt->swoffset);
-  ret = tiff_putstring(info->outfd, TIFF_SOFTWARE_STRING, TIFF_SOFTWARE_STRLEN);
-  if (ret < 0)
-    {
-      goto errout;
-    }
-  tiff_offset(offset, TIFF_SOFTWARE_STRLEN);
+  tiff_checkoffs(ptr - hdr, info->filefmt->swoffset);
+  memcpy(ptr, TIFF_SOFTWARE_STRING, TIFF_SOFTWARE_STRLEN);
+  ptr += TIFF_SOFTWARE_STRLEN;
 
-  /* Write the DateTime string:
+  /* Put the DateTime string and two bytes of padding:
    *
    *
    * Bi-level Images: Offset 188, Format "YYYY:MM:DD HH:MM:SSS"
@@ -862,33 +792,60 @@ int tiff_initialize(FAR struct tiff_info_s *info)
    * RGB:             Offset 220, Hard-coded "NuttX"
    */
 
-  tiff_checkoffs(offset, info->filefmt->dateoffset);
+  tiff_checkoffs(ptr - hdr, info->filefmt->dateoffset);
   ret = tiff_datetime(timbuf, TIFF_DATETIME_STRLEN + 8);
   if (ret < 0)
     {
       goto errout;
     }
 
-  ret = tiff_putstring(info->outfd, timbuf, TIFF_DATETIME_STRLEN);
+  memcpy(ptr, timbuf, TIFF_DATETIME_STRLEN);
+  ptr += TIFF_DATETIME_STRLEN;
+
+  tiff_put16(ptr, 0);
+  ptr += 2;
+
+  /* And that should do it! */
+
+  tiff_checkoffs(ptr - hdr, info->filefmt->sbcoffset);
+
+  /* Write the header, then reserve the space of the strip tables.  The
+   * strip data follows and the tables are written by tiff_finalize().
+   */
+
+  info->iohead  = 0;
+  info->iolen   = 0;
+  info->outsize = 0;
+
+  ret = tiff_putdata(info, hdr, info->filefmt->sbcoffset);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  memset(info->striptab, 0, 8 * info->maxstrips);
+  ret = tiff_putdata(info, info->striptab, 8 * info->maxstrips);
   if (ret < 0)
     {
       goto errout;
     }
-  tiff_offset(offset, TIFF_DATETIME_STRLEN);
 
-  /* Add two bytes of padding */
+  /* PackBits keeps the row being compressed at the head of the I/O buffer,
+   * after the data still waiting to be written.
+   */
 
-  ret = tiff_putint16(info->outfd, 0);
+  ret = tiff_flush(info);
   if (ret < 0)
     {
       goto errout;
     }
-  tiff_offset(offset, 2);
 
-  /* And that should do it! */
+  if (info->compress == TAG_COMP_PACKBITS)
+    {
+      info->iohead = info->bps / info->rps;
+    }
 
-  tiff_checkoffs(offset, info->filefmt->sbcoffset);
-  info->outsize = info->filefmt->sbcoffset;
+  DEBUGASSERT(info->outsize == dataoffs);
   return OK;
 
 errout:
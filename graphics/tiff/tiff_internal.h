@@ -62,6 +62,12 @@
 #define IMGFLAGS_ISRGB(f) \
   (((f) & IMGFLAGS_FMT_RGB24) != 0)
 
+/* PackBits *****************************************************************/
+
+/* Worst case size of a row of n bytes: one header per 128 literal bytes */
+
+#define TIFF_PACKBITS_MAXSIZE(n) ((n) + ((n) + 127) / 128)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -121,73 +127,62 @@ ssize_t tiff_read(int fd, FAR void *buffer, size_t count);
 int tiff_write(int fd, FAR const void *buffer, size_t count);
 
 /****************************************************************************
- * Name: tiff_putint16
- *
- * Description:
- *   Write two bytes to the outfile.
- *
- * Input Parameters:
- *   fd - File descriptor to be used.
- *   value - The 2-byte, uint16_t value to write
- *
- * Returned Value:
- *   Zero (OK) on success.  A negated errno value on failure.
- *
- ****************************************************************************/
-
-int tiff_putint16(int fd, uint16_t value);
-
-/****************************************************************************
- * Name: tiff_putint32
+ * Name: tiff_putdata
  *
  * Description:
- *   Write four bytes to the outfile.
+ *   Append data to the outfile through the I/O buffer.  The buffer is only
+ *   written when it is full, so that many small pieces (rows, strips and
+ *   padding) result in a few large writes.
  *
  * Input Parameters:
- *   fd - File descriptor to be used.
- *   value - The 4-byte, uint32_t value to write
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.
+ *   data - The data to append
+ *   len  - The number of bytes to append
  *
  * Returned Value:
  *   Zero (OK) on success.  A negated errno value on failure.
  *
  ****************************************************************************/
 
-int tiff_putint32(int fd, uint32_t value);
+int tiff_putdata(FAR struct tiff_info_s *info, FAR const void *data,
+                 size_t len);
 
 /****************************************************************************
- * Name: tiff_putstring
+ * Name: tiff_flush
  *
  * Description:
- *  Write a string of fixed length to the outfile.
+ *   Write the data pending in the I/O buffer to the outfile.
  *
  * Input Parameters:
- *   fd - File descriptor to be used.
- *   string - A pointer to the memory containing the string
- *   len - The length of the string (including the NUL terminator)
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.
  *
  * Returned Value:
  *   Zero (OK) on success.  A negated errno value on failure.
  *
  ****************************************************************************/
 
-int tiff_putstring(int fd, FAR const char *string, int len);
+int tiff_flush(FAR struct tiff_info_s *info);
 
 /****************************************************************************
- * Name: tiff_wordalign
+ * Name: tiff_packbits
  *
  * Description:
- *  Pad a file with zeros as necessary to achieve word alignament.
+ *   Compress one row with the PackBits scheme.  dest must hold at least
+ *   TIFF_PACKBITS_MAXSIZE(len) bytes.
  *
  * Input Parameters:
- *   fd - File descriptor to be used.
- *   size - The current size of the file
+ *   src  - The row to compress
+ *   len  - The size of the row in bytes
+ *   dest - The location to return the compressed row
  *
  * Returned Value:
- *   The new size of the file on success.  A negated errno value on failure.
+ *   The size of the compressed row.
  *
  ****************************************************************************/
 
-ssize_t tiff_wordalign(int fd, size_t size);
+size_t tiff_packbits(FAR const uint8_t *src, size_t len, FAR uint8_t *dest);
 
 #undef EXTERN
 #if defined(__cplusplus)
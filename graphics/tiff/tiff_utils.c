@@ -254,113 +254,144 @@ int tiff_write(int fd, FAR const void *buffer, size_t count)
 }
 
 /****************************************************************************
- * Name: tiff_putint16
+ * Name: tiff_putdata
  *
  * Description:
- *   Write two bytes to the outfile.
+ *   Append data to the outfile through the I/O buffer.  The buffer is only
+ *   written when it is full, so that many small pieces (rows, strips and
+ *   padding) result in a few large writes.
  *
  * Input Parameters:
- *   fd - File descriptor to be used.
- *   value - The 2-byte, uint16_t value to write
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.
+ *   data - The data to append
+ *   len  - The number of bytes to append
  *
  * Returned Value:
  *   Zero (OK) on success.  A negated errno value on failure.
  *
  ****************************************************************************/
 
-int tiff_putint16(int fd, uint16_t value)
+int tiff_putdata(FAR struct tiff_info_s *info, FAR const void *data,
+                 size_t len)
 {
-  uint8_t bytes[2];
+  FAR const uint8_t *src = (FAR const uint8_t *)data;
+  size_t avail = info->iosize - info->iohead;
+  size_t nbytes;
+  int ret;
 
-  /* Write the two bytes to the output file */
+  info->outsize += len;
 
-  tiff_put16(bytes, value);
-  return tiff_write(fd, bytes, 2);
-}
+  /* Data larger than the buffer is written in place */
 
-/****************************************************************************
- * Name: tiff_putint32
- *
- * Description:
- *   Write four bytes to the outfile.
- *
- * Input Parameters:
- *   fd - File descriptor to be used.
- *   value - The 4-byte, uint32_t value to write
- *
- * Returned Value:
- *   Zero (OK) on success.  A negated errno value on failure.
- *
- ****************************************************************************/
+  if (info->iolen == 0 && len >= avail)
+    {
+      return tiff_write(info->outfd, src, len);
+    }
 
-int tiff_putint32(int fd, uint32_t value)
-{
-  uint8_t bytes[4];
+  while (len > 0)
+    {
+      nbytes = avail - info->iolen;
+      if (nbytes > len)
+        {
+          nbytes = len;
+        }
 
-  /* Write the four bytes to the output file */
+      memcpy(info->iobuffer + info->iohead + info->iolen, src, nbytes);
+      info->iolen += nbytes;
+      src         += nbytes;
+      len         -= nbytes;
 
-  tiff_put32(bytes, value);
-  return tiff_write(fd, bytes, 4);
+      if (info->iolen == avail)
+        {
+          ret = tiff_flush(info);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  return OK;
 }
 
 /****************************************************************************
- * Name: tiff_putstring
+ * Name: tiff_flush
  *
  * Description:
- *  Write a string of fixed length to the outfile.
+ *   Write the data pending in the I/O buffer to the outfile.
  *
  * Input Parameters:
- *   fd - File descriptor to be used.
- *   string - A pointer to the memory containing the string
- *   len - The length of the string (including the NUL terminator)
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.
  *
  * Returned Value:
  *   Zero (OK) on success.  A negated errno value on failure.
  *
  ****************************************************************************/
 
-int tiff_putstring(int fd, FAR const char *string, int len)
+int tiff_flush(FAR struct tiff_info_s *info)
 {
-#ifdef CONFIG_DEBUG_GRAPHICS
-  int actual = strlen(string);
+  size_t nbytes = info->iolen;
 
-  DEBUGASSERT(len = actual+1);
-#endif
-  return tiff_write(fd, string, len);
+  info->iolen = 0;
+  return tiff_write(info->outfd, info->iobuffer + info->iohead, nbytes);
 }
 
 /****************************************************************************
- * Name: tiff_wordalign
+ * Name: tiff_packbits
  *
  * Description:
- *  Pad a file with zeros as necessary to achieve word alignament.
+ *   Compress one row with the PackBits scheme.  A header byte n is followed
+ *   either by n + 1 literal bytes (0 <= n <= 127) or by one byte repeated
+ *   1 - n times (-127 <= n <= -1).
  *
  * Input Parameters:
- *   fd - File descriptor to be used.
- *   size - The current size of the file
+ *   src  - The row to compress
+ *   len  - The size of the row in bytes
+ *   dest - The location to return the compressed row
  *
  * Returned Value:
- *   The new size of the file on success.  A negated errno value on failure.
+ *   The size of the compressed row.
  *
  ****************************************************************************/
 
-ssize_t tiff_wordalign(int fd, size_t size)
+size_t tiff_packbits(FAR const uint8_t *src, size_t len, FAR uint8_t *dest)
 {
-  unsigned int remainder;
-  int ret;
+  FAR uint8_t *out = dest;
+  size_t start;
+  size_t run;
+  size_t i = 0;
 
-  remainder = size & 3;
-  if (remainder > 0)
+  while (i < len)
     {
-      unsigned int nbytes = 4 - remainder;
-      uint32_t value      = 0;
+      /* Measure the run of identical bytes at the current position */
 
-      ret = tiff_write(fd, &value, nbytes);
-      if (ret < 0)
+      for (run = 1; i + run < len && run < 128 && src[i + run] == src[i];
+           run++);
+
+      if (run >= 2)
         {
-          return (ssize_t)ret;
+          *out++ = (uint8_t)(257 - run);
+          *out++ = src[i];
+          i     += run;
+          continue;
         }
-      size += nbytes;
+
+      /* Take literal bytes up to the start of a run of three */
+
+      for (start = i; i < len && i - start < 128; i++)
+        {
+          if (i + 2 < len && src[i] == src[i + 1] && src[i] == src[i + 2])
+            {
+              break;
+            }
+        }
+
+      *out++ = (uint8_t)(i - start - 1);
+      memcpy(out, &src[start], i - start);
+      out += i - start;
     }
-  return size;
+
+  return out - dest;
 }
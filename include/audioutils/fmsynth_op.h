@@ -39,6 +39,12 @@
 #define FMSYNTH_OPFUNC_SQUARE   (3)
 #define FMSYNTH_OPFUNC_NUM      (4)
 
+/* Maximum number of samples rendered by fmsynthop_operate_block() */
+
+#ifndef FMSYNTH_BLOCKSIZE
+#  define FMSYNTH_BLOCKSIZE     (32)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -94,6 +100,9 @@ void fmsynthop_set_soundfreqrate(FAR fmsynth_op_t *op, float rate);
 void fmsynthop_start(FAR fmsynth_op_t *op);
 void fmsynthop_stop(FAR fmsynth_op_t *op);
 int fmsynthop_operate(FAR fmsynth_op_t *op, int phase_time);
+int fmsynthop_blockable(FAR fmsynth_op_t *op);
+void fmsynthop_operate_block(FAR fmsynth_op_t *op, int reset,
+                             FAR int *out, int n);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,268 @@
+/****************************************************************************
+ * apps/include/canutils/canardio.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_CANUTILS_CANARDIO_H
+#define __APPS_INCLUDE_CANUTILS_CANARDIO_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if defined(CONFIG_NET_CAN_CANFD) || defined(CONFIG_CAN_FD)
+#  define CANARDIO_MAXDATA   64
+#else
+#  define CANARDIO_MAXDATA   8
+#endif
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* An acceptance filter on 29-bit identifiers: a frame is accepted if
+ * (frame id & mask) == id.
+ */
+
+struct canardio_filter_s
+{
+  uint32_t id;
+  uint32_t mask;
+};
+
+/* A received extended frame.  Standard and remote frames are dropped by
+ * the reader, as neither DroneCAN nor Cyphal/CAN uses them.
+ */
+
+struct canardio_frame_s
+{
+  uint64_t timestamp;                 /* Monotonic reception time, us */
+  uint32_t id;                        /* 29-bit identifier */
+  uint8_t  len;                       /* Data bytes */
+  uint8_t  data[CANARDIO_MAXDATA];
+};
+
+/* A CAN bus read by a thread of its own into a single producer, single
+ * consumer ring, so that the thread running libcanard takes frames
+ * without a system call while the ring is not empty, and the frames keep
+ * being read while it is busy.
+ *
+ * The members are private to canardio.c.
+ */
+
+struct canardio_s
+{
+  int          fd;                    /* Socket or character device */
+  bool         sock;                  /* fd is a SocketCAN socket */
+  pthread_t    reader;
+  sem_t        sem;                   /* Posted when a frame is queued */
+  atomic_bool  waiting;               /* The consumer waits on sem */
+  atomic_uint  head;                  /* Written by the reader */
+  atomic_uint  tail;                  /* Written by the consumer */
+  atomic_uint  dropped;               /* Frames lost to a full ring */
+  unsigned int depth;                 /* Ring slots, a power of two */
+  FAR struct canardio_frame_s *ring;
+  int          nhwfilters;            /* Controller filters in use */
+  int          hwfilters[CONFIG_CANUTILS_CANARDIO_HWFILTERS];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: canardio_cyphal_subject
+ *
+ * Description:
+ *   Return the filter accepting the messages of a Cyphal/CAN subject.
+ *
+ ****************************************************************************/
+
+struct canardio_filter_s canardio_cyphal_subject(uint16_t subject);
+
+/****************************************************************************
+ * Name: canardio_cyphal_services
+ *
+ * Description:
+ *   Return the filter accepting the Cyphal/CAN service transfers addressed
+ *   to node.
+ *
+ ****************************************************************************/
+
+struct canardio_filter_s canardio_cyphal_services(uint8_t node);
+
+/****************************************************************************
+ * Name: canardio_dronecan_message
+ *
+ * Description:
+ *   Return the filter accepting the DroneCAN messages of a data type.
+ *
+ ****************************************************************************/
+
+struct canardio_filter_s canardio_dronecan_message(uint16_t dtid);
+
+/****************************************************************************
+ * Name: canardio_dronecan_services
+ *
+ * Description:
+ *   Return the filter accepting the DroneCAN service transfers addressed
+ *   to node.
+ *
+ ****************************************************************************/
+
+struct canardio_filter_s canardio_dronecan_services(uint8_t node);
+
+/****************************************************************************
+ * Name: canardio_consolidate
+ *
+ * Description:
+ *   Merge the closest filters of the array until at most max remain.  The
+ *   merged filters accept every frame the original ones accepted, and
+ *   some more that the software filter of libcanard still rejects.
+ *
+ * Returned Value:
+ *   The number of filters left at the start of the array.
+ *
+ ****************************************************************************/
+
+int canardio_consolidate(FAR struct canardio_filter_s *filters,
+                         int nfilters, int max);
+
+/****************************************************************************
+ * Name: canardio_match
+ *
+ * Description:
+ *   Return true if id is accepted by one of the filters.
+ *
+ ****************************************************************************/
+
+bool canardio_match(FAR const struct canardio_filter_s *filters,
+                    int nfilters, uint32_t id);
+
+/****************************************************************************
+ * Name: canardio_open
+ *
+ * Description:
+ *   Open a SocketCAN interface ("can0") or a CAN character device (a path
+ *   starting with '/') and start its reader thread.  depth is the number
+ *   of frames the ring holds, rounded up to a power of two; zero selects
+ *   CONFIG_CANUTILS_CANARDIO_RXDEPTH.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int canardio_open(FAR struct canardio_s *io, FAR const char *dev,
+                  unsigned int depth);
+
+/****************************************************************************
+ * Name: canardio_setfilters
+ *
+ * Description:
+ *   Accept only the frames matched by filters, normally one for each
+ *   subject or data type subscribed to and one for the services of the
+ *   node, so that the other frames never reach the reader thread.  A
+ *   character device gets them consolidated to
+ *   CONFIG_CANUTILS_CANARDIO_HWFILTERS acceptance filters of the
+ *   controller.  A SocketCAN socket gets them as CAN_RAW_FILTER, which the
+ *   network stack applies before queueing a frame to the socket.
+ *   nfilters == 0 accepts every frame again.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure, in which case
+ *   every frame is accepted.
+ *
+ ****************************************************************************/
+
+int canardio_setfilters(FAR struct canardio_s *io,
+                        FAR const struct canardio_filter_s *filters,
+                        int nfilters);
+
+/****************************************************************************
+ * Name: canardio_receive
+ *
+ * Description:
+ *   Take the oldest received frame, waiting up to timeout milliseconds
+ *   for one (-1 waits forever).
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ETIMEDOUT if no frame arrived.
+ *
+ ****************************************************************************/
+
+int canardio_receive(FAR struct canardio_s *io,
+                     FAR struct canardio_frame_s *frame, int timeout);
+
+/****************************************************************************
+ * Name: canardio_send
+ *
+ * Description:
+ *   Send an extended frame.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int canardio_send(FAR struct canardio_s *io, uint32_t id,
+                  FAR const void *data, size_t len);
+
+/****************************************************************************
+ * Name: canardio_dropped
+ *
+ * Description:
+ *   Return the number of frames lost because the ring was full.
+ *
+ ****************************************************************************/
+
+unsigned int canardio_dropped(FAR struct canardio_s *io);
+
+/****************************************************************************
+ * Name: canardio_close
+ ****************************************************************************/
+
+void canardio_close(FAR struct canardio_s *io);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_CANUTILS_CANARDIO_H */
@@ -0,0 +1,139 @@
+/****************************************************************************
+ * apps/include/canutils/lely_rt.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_CANUTILS_LELY_RT_H
+#define __APPS_INCLUDE_CANUTILS_LELY_RT_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <lely/co/dev.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* The SYNC/PDO fast path.  A thread of its own, at a real-time priority,
+ * produces or receives SYNC and exchanges the synchronous PDOs of the
+ * object dictionary (transmission types 0 to 240), while the lely event
+ * loop keeps the SDO, NMT, EMCY and event driven PDO traffic.  The lely
+ * SYNC service is left out of the build (CANUTILS_LELYCANOPEN_SYNC), so
+ * that lely never handles a synchronous PDO itself.
+ *
+ * The PDO mappings are resolved to pointers to the mapped values when the
+ * fast path starts, so that a cycle does no object dictionary lookup.
+ * It must be restarted after the PDO communication or mapping parameters
+ * were changed, normally on the transition to NMT operational.
+ */
+
+struct lely_rt_s;
+
+struct lely_rt_config_s
+{
+  FAR const char *ifname;             /* SocketCAN interface, "can0" */
+  FAR co_dev_t   *dev;                /* Object dictionary */
+
+  /* Called in every cycle, after the received PDOs were written to the
+   * object dictionary and before the PDOs to send are read from it.  It
+   * runs on the fast path thread and must not block.
+   */
+
+  CODE void (*cycle)(FAR void *arg);
+  FAR void *arg;
+};
+
+/* Timing of the cycles, in microseconds.  The period is measured between
+ * two SYNCs, the jitter is its deviation from the communication cycle
+ * period (object 1006h) and the latency is the time from the SYNC to the
+ * last PDO sent in the cycle.
+ */
+
+struct lely_rt_stats_s
+{
+  uint32_t cycles;
+  uint32_t overruns;                  /* Periods over 1.5 cycle periods */
+  uint32_t period_min;
+  uint32_t period_max;
+  uint32_t period_avg;
+  uint32_t jitter_max;
+  uint32_t latency_avg;
+  uint32_t latency_max;
+  uint32_t rpdo_missed;               /* Synchronous RPDOs not received */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: lely_rt_start
+ *
+ * Description:
+ *   Resolve the synchronous PDOs of cfg->dev and start the fast path
+ *   thread.  The node produces SYNC if bit 30 of object 1005h is set.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.  -EINVAL
+ *   means a mapping that cannot be resolved, such as an entry longer than
+ *   its object or a mapped object that is not a basic type.
+ *
+ ****************************************************************************/
+
+int lely_rt_start(FAR const struct lely_rt_config_s *cfg,
+                  FAR struct lely_rt_s **rt);
+
+/****************************************************************************
+ * Name: lely_rt_stats
+ *
+ * Description:
+ *   Copy the timing statistics, and clear them if reset is true.  This
+ *   never blocks the fast path thread.
+ *
+ ****************************************************************************/
+
+void lely_rt_stats(FAR struct lely_rt_s *rt,
+                   FAR struct lely_rt_stats_s *stats, bool reset);
+
+/****************************************************************************
+ * Name: lely_rt_stop
+ ****************************************************************************/
+
+void lely_rt_stop(FAR struct lely_rt_s *rt);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_CANUTILS_LELY_RT_H */
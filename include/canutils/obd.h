@@ -28,6 +28,8 @@
 #include <nuttx/config.h>
 
 #include <sys/ioctl.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <fcntl.h>
@@ -35,6 +37,18 @@
 
 #include <nuttx/can/can.h>
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_LIBOBD2_SCHEDULER
+/* Target of a polled PID: an ECU index 0-7 (physical request to 0x7e0 + n,
+ * answered from 0x7e8 + n) or all ECUs (functional request).
+ */
+
+#  define OBD_ECU_ALL          0xff
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -63,6 +77,29 @@ struct obd_dev_s
 #endif
 };
 
+#ifdef CONFIG_LIBOBD2_SCHEDULER
+/* A PID polled by the scheduler at its own period */
+
+struct obd_poll_s
+{
+  uint8_t  pid;                      /* Mode 01 PID                         */
+  uint8_t  ecu;                      /* ECU index 0-7 or OBD_ECU_ALL        */
+  uint16_t period;                   /* Polling period in milliseconds      */
+
+  /* Private to the scheduler */
+
+  uint32_t due;                      /* Time of the next request            */
+  bool     pending;                  /* Requested, not answered yet         */
+};
+
+/* Called for each PID value received, data holds the bytes A, B, ... */
+
+typedef CODE void (*obd_value_t)(FAR void *arg, uint8_t ecu, uint8_t pid,
+                                 FAR const uint8_t *data, uint8_t len);
+
+struct obd_sched_s;
+#endif
+
 /****************************************************************************
  * Name: obd_init
  *
@@ -114,4 +151,48 @@ int obd_wait_response(FAR struct obd_dev_s *dev, uint8_t opmode, uint8_t pid,
 
 FAR char *obd_decode_pid(FAR struct obd_dev_s *dev, uint8_t pid);
 
+#ifdef CONFIG_LIBOBD2_SCHEDULER
+/****************************************************************************
+ * Name: obd_sched_init
+ *
+ * Description:
+ *   Create a scheduler that polls the npolls PIDs of polls, which must stay
+ *   valid while it runs.  Due PIDs for the same target are requested
+ *   together, up to 6 per message, and each target has its own request in
+ *   flight.
+ *
+ *   Returns the scheduler or NULL if error.
+ *
+ ****************************************************************************/
+
+FAR struct obd_sched_s *obd_sched_init(FAR struct obd_dev_s *dev,
+                                       FAR struct obd_poll_s *polls,
+                                       int npolls, obd_value_t cb,
+                                       FAR void *arg);
+
+/****************************************************************************
+ * Name: obd_sched_run
+ *
+ * Description:
+ *   Send the requests and dispatch the responses for timeout milliseconds,
+ *   or forever if timeout is negative.
+ *
+ *   It will return OK once the time elapsed or an error if the CAN device
+ *   fails.
+ *
+ ****************************************************************************/
+
+int obd_sched_run(FAR struct obd_sched_s *sched, int timeout);
+
+/****************************************************************************
+ * Name: obd_sched_free
+ *
+ * Description:
+ *   Free a scheduler created by obd_sched_init().
+ *
+ ****************************************************************************/
+
+void obd_sched_free(FAR struct obd_sched_s *sched);
+#endif
+
 #endif /*__APPS_INCLUDE_CANUTILS_OBD_H */
@@ -42,6 +42,12 @@
 #define MKFATFS_DEFAULT_HIDSEC       0     /* No hidden sectors */
 #define MKFATFS_DEFAULT_VOLUMEID     0     /* No volume ID */
 #define MKFATFS_DEFAULT_NSECTORS     0     /* 0: Use all sectors on device */
+#define MKFATFS_DEFAULT_FLAGS        0     /* No MKFATFS_FLAG_* */
+
+/* Values of ff_flags */
+
+#define MKFATFS_FLAG_ERASED          (1 << 0) /* Media already reads as zeros */
+#define MKFATFS_FLAG_DISCARD         (1 << 1) /* Erase the whole media first */
 
 #define FAT_FORMAT_INITIALIZER \
 { \
@@ -54,7 +60,8 @@
   MKFATFS_DEFAULT_RSVDSECCOUNT, \
   MKFATFS_DEFAULT_HIDSEC, \
   MKFATFS_DEFAULT_VOLUMEID, \
-  MKFATFS_DEFAULT_NSECTORS \
+  MKFATFS_DEFAULT_NSECTORS, \
+  MKFATFS_DEFAULT_FLAGS \
 }
 
 /****************************************************************************
@@ -77,6 +84,7 @@ struct fat_format_s
   uint32_t ff_hidsec;          /* Count of hidden sectors preceding fat */
   uint32_t ff_volumeid;        /* FAT volume id */
   uint32_t ff_nsectors;        /* Number of sectors from device to use: 0: Use all */
+  uint8_t  ff_flags;           /* MKFATFS_FLAG_* */
 };
 
 /****************************************************************************
@@ -0,0 +1,147 @@
+/****************************************************************************
+ * apps/include/graphics/nxwidgets/cglyphcache.hxx
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_GRAPHICS_NXWIDGETS_CGLYPHCACHE_HXX
+#define __APPS_INCLUDE_GRAPHICS_NXWIDGETS_CGLYPHCACHE_HXX
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include <nuttx/nx/nxglib.h>
+
+#include "graphics/nxwidgets/nxconfig.hxx"
+
+#ifdef CONFIG_NXWIDGETS_GLYPHCACHE
+
+/****************************************************************************
+ * Implementation Classes
+ ****************************************************************************/
+
+#if defined(__cplusplus)
+
+namespace NXWidgets
+{
+  class CNxFont;
+
+  /**
+   * Cache of glyphs rendered on an opaque background, ready to be sent to
+   * a window as bitmaps.  A glyph is identified by its font, its letter,
+   * the font color and the background color.  The least recently used
+   * glyph is replaced when the cache is full.
+   *
+   * The cache is shared by all of the graphics ports.  lock() must be held
+   * from get() until the glyph is not used any more.
+   */
+
+  class CGlyphCache
+  {
+  private:
+    /**
+     * A cached glyph.
+     */
+
+    struct SGlyph
+    {
+      const CNxFont    *font;       /**< Font, NULL if the entry is free */
+      nxwidget_char_t   letter;     /**< Character */
+      nxgl_mxpixel_t    color;      /**< Font color */
+      nxgl_mxpixel_t    background; /**< Background color */
+      nxgl_coord_t      width;      /**< Width in pixels */
+      nxgl_coord_t      height;     /**< Height in rows */
+      uint32_t          lastUse;    /**< Value of m_clock when last used */
+      size_t            size;       /**< Allocated pixels */
+      nxwidget_pixel_t *data;       /**< Rendered glyph */
+    };
+
+    struct SGlyph   m_glyphs[CONFIG_NXWIDGETS_GLYPHCACHE_ENTRIES];
+    uint32_t        m_clock;        /**< Incremented on each access */
+    pthread_mutex_t m_lock;         /**< Protects the cache */
+
+  public:
+    /**
+     * Constructor.
+     */
+
+    CGlyphCache(void);
+
+    /**
+     * Destructor.
+     */
+
+    ~CGlyphCache(void);
+
+    /**
+     * Lock the cache.
+     */
+
+    inline void lock(void)
+    {
+      pthread_mutex_lock(&m_lock);
+    }
+
+    /**
+     * Unlock the cache.
+     */
+
+    inline void unlock(void)
+    {
+      pthread_mutex_unlock(&m_lock);
+    }
+
+    /**
+     * Get a glyph.  If it is not in the cache, the least recently used
+     * entry is given to it and the caller must render the glyph into the
+     * returned memory.
+     *
+     * @param font The font of the glyph.
+     * @param letter The character.
+     * @param background The background color.
+     * @param width The width of the glyph in pixels.
+     * @param height The height of the glyph in rows.
+     * @param hit Set to true if the glyph was already rendered.
+     * @return The glyph memory, width * height pixels, or NULL if there
+     *   is no memory for it.
+     */
+
+    FAR nxwidget_pixel_t *get(const CNxFont *font, nxwidget_char_t letter,
+                              nxgl_mxpixel_t background,
+                              nxgl_coord_t width, nxgl_coord_t height,
+                              bool &hit);
+
+    /**
+     * Forget the glyphs of a font, when it is deleted.
+     *
+     * @param font The font.
+     */
+
+    void invalidate(const CNxFont *font);
+  };
+}
+
+#endif // __cplusplus
+#endif // CONFIG_NXWIDGETS_GLYPHCACHE
+#endif // __APPS_INCLUDE_GRAPHICS_NXWIDGETS_CGLYPHCACHE_HXX
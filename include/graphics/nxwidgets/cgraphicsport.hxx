@@ -93,10 +93,58 @@ namespace NXWidgets
   class CGraphicsPort
   {
   private:
+#ifdef CONFIG_NXWIDGETS_BATCH
+    /**
+     * A fill recorded while batching.
+     */
+
+    struct SFillCmd
+    {
+      struct nxgl_rect_s rect;   /**< Window-relative area */
+      nxgl_mxpixel_t     color;  /**< Fill color */
+    };
+#endif
+
     INxWindow     *m_pNxWnd;     /**< NX window interface. */
 #ifdef CONFIG_NX_WRITEONLY
     nxgl_mxpixel_t m_backColor;  /**< The background color to use */
 #endif
+#ifdef CONFIG_NXWIDGETS_BATCH
+    struct SFillCmd m_batch[CONFIG_NXWIDGETS_BATCH_SIZE]; /**< Fills */
+    uint16_t       m_nBatch;     /**< Number of pending fills */
+    uint8_t        m_batchDepth; /**< Nesting of beginBatch() */
+
+    /**
+     * Submit the pending fills to the window.  Drawing operations other
+     * than fills call this first so that the drawing order is kept.
+     */
+
+    void submitBatch(void);
+#endif
+
+    /**
+     * Fill a rectangle, or record it while batching.
+     *
+     * @param rect The window-relative area to fill.
+     * @param color The fill color.
+     */
+
+    void fillRect(FAR const struct nxgl_rect_s *rect, nxgl_mxpixel_t color);
+
+    /**
+     * Submit the pending fills before a drawing operation that is not a
+     * fill.
+     */
+
+    inline void flushBatch(void)
+    {
+#ifdef CONFIG_NXWIDGETS_BATCH
+      if (m_nBatch > 0)
+        {
+          submitBatch();
+        }
+#endif
+    }
 
     /**
      * The underlying implementation for drawText functions
@@ -291,6 +339,7 @@ namespace NXWidgets
     inline void drawFilledCircle(struct nxgl_point_s *center, nxgl_coord_t radius,
                                  nxgl_mxpixel_t color)
     {
+      flushBatch();
       m_pNxWnd->drawFilledCircle(center, radius, color);
     }
 
@@ -468,6 +517,24 @@ namespace NXWidgets
     void invert(nxgl_coord_t x, nxgl_coord_t y,
                 nxgl_coord_t width, nxgl_coord_t height);
 
+#ifdef CONFIG_NXWIDGETS_BATCH
+    /**
+     * Start recording the fills instead of sending each one to the
+     * window.  Consecutive fills of the same color that form a rectangle
+     * are merged and fills hidden by a later fill are dropped, so that a
+     * widget redraw sends far fewer requests to the NX server.  Calls may
+     * be nested, the fills are submitted by the outermost endBatch().
+     */
+
+    void beginBatch(void);
+
+    /**
+     * Stop recording and submit the pending fills.
+     */
+
+    void endBatch(void);
+#endif
+
   };
 }
 
@@ -81,7 +81,11 @@ namespace NXWidgets
      * CNxFont Destructor.
      */
 
+#ifdef CONFIG_NXWIDGETS_GLYPHCACHE
+    ~CNxFont();
+#else
     ~CNxFont() { }
+#endif
 
     /**
      * Checks if supplied character is blank in the current font.
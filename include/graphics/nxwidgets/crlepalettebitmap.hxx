@@ -99,6 +99,20 @@ namespace NXWidgets
     uint8_t          m_remaining; /**< Number of bytes remaining in current entry */
     FAR const void  *m_lut;       /**< The selected LUT */
     FAR const struct SRlePaletteBitmapEntry *m_rle; /**< RLE entry being processed */
+#ifdef CONFIG_NXWIDGETS_RLECACHE
+    FAR uint8_t     *m_decoded;   /**< LUT index of each pixel, if decoded */
+#endif
+
+#ifdef CONFIG_NXWIDGETS_RLECACHE
+    /**
+     * Decode the whole image into m_decoded, unless the decoded images
+     * would use more than CONFIG_NXWIDGETS_RLECACHE_MAXSIZE bytes.
+     *
+     * @return True if the image is decoded.
+     */
+
+    bool decodeImage(void);
+#endif
 
     /**
      * Reset to the beginning of the image
@@ -179,7 +193,11 @@ namespace NXWidgets
      * Destructor.
      */
 
+#ifdef CONFIG_NXWIDGETS_RLECACHE
+    ~CRlePaletteBitmap(void);
+#else
     inline ~CRlePaletteBitmap(void) {}
+#endif
 
     /**
      * Get the bitmap's color format.
@@ -63,6 +63,9 @@ namespace NXWidgets
     unsigned int       m_row;         /**< Row number of the first cached row */
     b16_t              m_xScale;      /**< X scale factor */
     b16_t              m_yScale;      /**< Y scale factor */
+#ifdef CONFIG_NXWIDGETS_SCALED_ROWCACHE
+    FAR struct rgbcolor_s *m_scaledRow[2]; /**< Cached rows, scaled in X */
+#endif
 
     /**
      * Read two rows into the row cache
@@ -72,6 +75,18 @@ namespace NXWidgets
 
     bool cacheRows(unsigned int row);
 
+#ifdef CONFIG_NXWIDGETS_SCALED_ROWCACHE
+    /**
+     * Scale a cached row horizontally to the width of the scaled image,
+     * so that getRun() only has to interpolate between two rows.
+     *
+     * @param row - The pointer to the row in the row cache to use
+     * @param scaled - The returned row of m_size.w colors
+     */
+
+    bool scaleRow(FAR uint8_t *row, FAR struct rgbcolor_s *scaled);
+#endif
+
     /**
      * Given an two RGB colors and a fractional value, return the scaled
      * value between the two colors.
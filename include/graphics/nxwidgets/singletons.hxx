@@ -86,6 +86,7 @@ namespace NXWidgets
 
   class CWidgetStyle;
   class CNxString;
+  class CGlyphCache;
 
   /**
    * Global singleton instances
@@ -94,6 +95,9 @@ namespace NXWidgets
   extern CWidgetStyle        *g_defaultWidgetStyle; /**< The default widget style */
   extern CNxString           *g_nullString;         /**< The reusable empty string */
   extern TNxArray<CNxTimer*> *g_nxTimers;           /**< An array of all timers */
+#ifdef CONFIG_NXWIDGETS_GLYPHCACHE
+  extern CGlyphCache         *g_glyphCache;         /**< Rendered glyphs */
+#endif
 
   /**
    * Setup misc singleton instances.
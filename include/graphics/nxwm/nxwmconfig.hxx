@@ -28,6 +28,7 @@
 #include <nuttx/config.h>
 
 #include <nuttx/input/touchscreen.h>
+#include <nuttx/nx/nxbe.h>
 
 #include "graphics/nxwidgets/nxconfig.hxx"
 #include "graphics/nxwidgets/crlepalettebitmap.hxx"
@@ -83,6 +84,16 @@
 #  warning "on_exit() support may be needed (CONFIG_LIBC_MAX_EXITFUNS)"
 #endif
 
+/**
+ * Flags of the taskbar and application windows
+ */
+
+#ifdef CONFIG_NXWM_RAMBACKED
+#  define NXWM_WINDOW_FLAGS NXBE_WINDOW_RAMBACKED
+#else
+#  define NXWM_WINDOW_FLAGS 0
+#endif
+
 /**
  * Default font ID
  */
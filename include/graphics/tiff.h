@@ -249,14 +249,6 @@ struct tiff_ifdentry_s
  * also structures used only internally by the TIFF file creation library).
  */
 
-/* This structure describes on strip in tmpfile2 */
-
-struct tiff_strip_s
-{
-  uint32_t offset; /* Offset to the strip data in tmpfile1 */
-  uint32_t count;  /* Count of pixels in the strip */
-};
-
 /* This structure is used only internally by the TIFF file creation library
  * to manage file offsets.
  */
@@ -283,10 +275,10 @@ struct tiff_info_s
   /* The first fields are used to pass information to the TIFF file creation
    * logic via tiff_initialize().
    *
-   * Filenames.  Three file names are required.  (1) path to the final
-   * output file and (2) two paths to temporary files.  One temporary file
-   * (tmpfile1) will be used to hold the strip image data and the other
-   * (tmpfile2) will be used to hold strip offset and count information.
+   * Filenames.  The path to the output file is required.  The two paths
+   * to temporary files are no longer used:  the strip data is written
+   * directly to the output file and the strip offsets and counts are kept
+   * in memory until tiff_finalize().
    *
    * colorfmt  - Specifies the form of the color data that will be provided
    *             in the strip data.  These are the FB_FMT_* definitions
@@ -302,20 +294,24 @@ struct tiff_info_s
    * rps       - TIFF RowsPerStrip
    * imgwidth  - TIFF ImageWidth, Number of columns in the image
    * imgheight - TIFF ImageLength, Number of rows in the image
+   * compress  - TIFF Compression, TAG_COMP_NONE (or zero) or
+   *             TAG_COMP_PACKBITS.  PackBits needs rows of whole bytes
+   *             and an I/O buffer of at least twice the size of a row.
    */
 
   FAR const char *outfile;  /* Full path to the final output file name */
-  FAR const char *tmpfile1; /* Full path to first temporary file */
-  FAR const char *tmpfile2; /* Full path to second temporary file */
+  FAR const char *tmpfile1; /* Unused */
+  FAR const char *tmpfile2; /* Unused */
 
   uint8_t      colorfmt;    /* See FB_FMT_* definitions in include/nuttx/video/fb.h */
   nxgl_coord_t rps;         /* TIFF RowsPerStrip */
   nxgl_coord_t imgwidth;    /* TIFF ImageWidth, Number of columns in the image */
   nxgl_coord_t imgheight;   /* TIFF ImageLength, Number of rows in the image */
+  uint16_t     compress;    /* TIFF Compression */
 
   /* The caller must provide an I/O buffer as well.  This I/O buffer will
-   * used for color conversions and as the intermediate buffer for copying
-   * files.  The larger the buffer, the better the performance.
+   * used for color conversions and to collect the data written to the
+   * output file.  The larger the buffer, the better the performance.
    */
 
   FAR uint8_t *iobuffer;    /* IO buffer allocated by the caller */
@@ -330,15 +326,18 @@ struct tiff_info_s
    */
 
   uint8_t      imgflags;    /* Bit-encoded image flags */
-  nxgl_coord_t nstrips;     /* Number of strips in tmpfile3 */
+  nxgl_coord_t nstrips;     /* Number of strips added */
+  nxgl_coord_t maxstrips;   /* Number of strips in the image */
   size_t       pps;         /* Pixels per strip */
   size_t       bps;         /* Bytes per strip */
+  size_t       iohead;      /* Scratch bytes at the head of iobuffer */
+  size_t       iolen;       /* Bytes waiting in iobuffer after iohead */
   int          outfd;       /* outfile file descriptor */
-  int          tmp1fd;      /* tmpfile1 file descriptor */
-  int          tmp2fd;      /* tmpfile2 file descriptor */
-  off_t        outsize;     /* Current size of outfile */
-  off_t        tmp1size;    /* Current size of tmpfile1 */
-  off_t        tmp2size;    /* Current size of tmpfile2 */
+  off_t        outsize;     /* Size of outfile, with the pending bytes */
+
+  /* StripByteCounts then StripOffsets, in the file byte order */
+
+  FAR uint8_t *striptab;
 
   /* Points to an internal constant structure of file offsets */
 
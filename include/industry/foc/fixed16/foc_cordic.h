@@ -49,4 +49,18 @@ int foc_cordic_dqsat_b16(int fd, FAR dq_frame_b16_t *dq_ref, b16_t mag_max);
 int foc_cordic_angle_b16(int fd, FAR phase_angle_b16_t *angle, b16_t a);
 #endif
 
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_LUT
+/****************************************************************************
+ * Name: foc_lut_init_b16
+ ****************************************************************************/
+
+void foc_lut_init_b16(void);
+
+/****************************************************************************
+ * Name: foc_lut_angle_b16
+ ****************************************************************************/
+
+void foc_lut_angle_b16(FAR phase_angle_b16_t *angle, b16_t a);
+#endif
+
 #endif /* __INDUSTRY_FOC_FIXED16_FOC_CORDIC_H */
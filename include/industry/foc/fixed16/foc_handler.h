@@ -29,10 +29,17 @@
 
 #include <dspb16.h>
 
-#ifdef CONFIG_INDUSTRY_FOC_CORDIC
+#if defined(CONFIG_INDUSTRY_FOC_CORDIC) || \
+    defined(CONFIG_INDUSTRY_FOC_ANGLE_LUT)
 #  include "industry/foc/fixed16/foc_cordic.h"
 #endif
 
+#ifdef CONFIG_INDUSTRY_FOC_DSP
+#  include "industry/foc/fixed16/foc_dsp.h"
+#endif
+
+#include "industry/foc/foc_prof.h"
+
 /****************************************************************************
  * Public Type Definition
  ****************************************************************************/
@@ -176,6 +183,9 @@ struct foc_handler_b16_s
   struct foc_handler_ops_b16_s  ops;           /* Handler operations */
   FAR void                     *modulation;    /* Modulation data */
   FAR void                     *control;       /* Controller data */
+#ifdef CONFIG_INDUSTRY_FOC_PROF
+  struct foc_prof_s             prof;          /* Stages profiling */
+#endif
 };
 
 /* Modulation configuration */
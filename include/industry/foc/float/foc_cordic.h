@@ -49,4 +49,18 @@ int foc_cordic_dqsat_f32(int fd, FAR dq_frame_f32_t *dq_ref, float mag_max);
 int foc_cordic_angle_f32(int fd, FAR phase_angle_f32_t *angle, float a);
 #endif
 
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_LUT
+/****************************************************************************
+ * Name: foc_lut_init_f32
+ ****************************************************************************/
+
+void foc_lut_init_f32(void);
+
+/****************************************************************************
+ * Name: foc_lut_angle_f32
+ ****************************************************************************/
+
+void foc_lut_angle_f32(FAR phase_angle_f32_t *angle, float a);
+#endif
+
 #endif /* __INDUSTRY_FOC_FLOAT_FOC_CORDIC_H */
@@ -29,10 +29,13 @@
 
 #include <dsp.h>
 
-#ifdef CONFIG_INDUSTRY_FOC_CORDIC
+#if defined(CONFIG_INDUSTRY_FOC_CORDIC) || \
+    defined(CONFIG_INDUSTRY_FOC_ANGLE_LUT)
 #  include "industry/foc/float/foc_cordic.h"
 #endif
 
+#include "industry/foc/foc_prof.h"
+
 /****************************************************************************
  * Public Type Definition
  ****************************************************************************/
@@ -177,6 +180,9 @@ struct foc_handler_f32_s
   struct foc_handler_ops_f32_s  ops;           /* Handler operations */
   FAR void                     *modulation;    /* Modulation data */
   FAR void                     *control;       /* Controller data */
+#ifdef CONFIG_INDUSTRY_FOC_PROF
+  struct foc_prof_s             prof;          /* Stages profiling */
+#endif
 };
 
 /* Modulation configuration */
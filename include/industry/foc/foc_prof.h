@@ -0,0 +1,156 @@
+/****************************************************************************
+ * apps/include/industry/foc/foc_prof.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INDUSTRY_FOC_FOC_PROF_H
+#define __INDUSTRY_FOC_FOC_PROF_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+
+#include <nuttx/clock.h>
+
+#ifdef CONFIG_INDUSTRY_FOC_PROF
+
+/****************************************************************************
+ * Public Type Definition
+ ****************************************************************************/
+
+/* Profiled stages of a control cycle */
+
+enum foc_prof_stage_e
+{
+  FOC_PROF_ANGLE      = 0,      /* Angle observer, set by the caller */
+  FOC_PROF_CURRENT    = 1,      /* Current correction and base voltage */
+  FOC_PROF_INPUT      = 2,      /* Controller input: Clarke and Park */
+  FOC_PROF_CONTROL    = 3,      /* Controller: PI and inverse Park */
+  FOC_PROF_MODULATION = 4,      /* Modulation */
+  FOC_PROF_STAGES     = 5
+};
+
+/* Statistics of a stage over the samples in the ring buffer */
+
+struct foc_prof_stat_s
+{
+  uint32_t min;
+  uint32_t max;
+  uint32_t avg;
+};
+
+/* Stage durations in perf_gettime() ticks, CPU cycles with the DWT cycle
+ * counter of Cortex-M.  The last CONFIG_INDUSTRY_FOC_PROF_SAMPLES cycles
+ * are kept in a ring buffer.
+ */
+
+struct foc_prof_s
+{
+  uint32_t mark;                             /* End of the last stage */
+  uint32_t cycle[FOC_PROF_STAGES];           /* Cycle in progress */
+  uint32_t ring[CONFIG_INDUSTRY_FOC_PROF_SAMPLES][FOC_PROF_STAGES];
+  uint16_t head;                             /* Next sample */
+  uint16_t count;                            /* Valid samples */
+};
+
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_prof_mark
+ *
+ * Description:
+ *   Start timing a stage
+ *
+ ****************************************************************************/
+
+static inline void foc_prof_mark(FAR struct foc_prof_s *prof)
+{
+  prof->mark = perf_gettime();
+}
+
+/****************************************************************************
+ * Name: foc_prof_stage
+ *
+ * Description:
+ *   Store the time since the last mark as the duration of a stage of the
+ *   cycle in progress, and start timing the next stage
+ *
+ ****************************************************************************/
+
+static inline void foc_prof_stage(FAR struct foc_prof_s *prof, int stage)
+{
+  uint32_t now = perf_gettime();
+
+  prof->cycle[stage] = now - prof->mark;
+  prof->mark         = now;
+}
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_prof_init
+ ****************************************************************************/
+
+void foc_prof_init(FAR struct foc_prof_s *prof);
+
+/****************************************************************************
+ * Name: foc_prof_commit
+ ****************************************************************************/
+
+void foc_prof_commit(FAR struct foc_prof_s *prof);
+
+/****************************************************************************
+ * Name: foc_prof_last
+ ****************************************************************************/
+
+FAR const uint32_t *foc_prof_last(FAR struct foc_prof_s *prof);
+
+/****************************************************************************
+ * Name: foc_prof_stats
+ ****************************************************************************/
+
+void foc_prof_stats(FAR struct foc_prof_s *prof,
+                    FAR struct foc_prof_stat_s *stat);
+
+#endif /* CONFIG_INDUSTRY_FOC_PROF */
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Profiling of a FOC handler, nothing if disabled */
+
+#ifdef CONFIG_INDUSTRY_FOC_PROF
+#  define FOC_PROF_MARK(h)      foc_prof_mark(&(h)->prof)
+#  define FOC_PROF_STAGE(h, s)  foc_prof_stage(&(h)->prof, (s))
+#  define FOC_PROF_COMMIT(h)    foc_prof_commit(&(h)->prof)
+#else
+#  define FOC_PROF_MARK(h)
+#  define FOC_PROF_STAGE(h, s)
+#  define FOC_PROF_COMMIT(h)
+#endif
+
+#endif /* __INDUSTRY_FOC_FOC_PROF_H */
@@ -0,0 +1,159 @@
+/****************************************************************************
+ * apps/include/inertial/madgwick.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_INERTIAL_MADGWICK_H
+#define __APPS_INCLUDE_INERTIAL_MADGWICK_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <fixedmath.h>
+
+#include <nuttx/sensors/sensor.h>
+
+#include "Fusion/Fusion.h"
+
+#ifdef CONFIG_LIB_MADGWICK
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+#ifdef CONFIG_LIB_MADGWICK_FIXED
+/* Madgwick IMU filter in fixed point, for parts without FPU.  The
+ * quaternion and the per-sample gyroscope increments are kept in Q30,
+ * which keeps the resolution at kHz sample rates where a gyroscope
+ * step is only a few micro-radians.
+ */
+
+struct madgwick_q_s
+{
+  int32_t q[4];                 /* Quaternion w, x, y, z in Q30 */
+  int32_t dt;                   /* Sample period in seconds, Q30 */
+  int32_t beta_dt;              /* Gain times sample period, Q30 */
+};
+#endif
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: madgwick_update_fifo
+ *
+ * Description:
+ *   Feed a block of samples read from the FIFO of an IMU to the Fusion
+ *   AHRS.  The samples are in uORB units (rad/s and m/s^2) and the time
+ *   step of each one is taken from its timestamp.
+ *
+ * Input Parameters:
+ *   ahrs  - The Fusion AHRS
+ *   gyro  - n gyroscope samples
+ *   accel - n accelerometer samples, taken with the gyroscope ones
+ *   n     - Number of samples
+ *   last  - Timestamp of the previous sample, 0 to use the nominal
+ *           period for the first sample, updated on return
+ *   dt    - Nominal sample period in seconds
+ *
+ ****************************************************************************/
+
+void madgwick_update_fifo(FAR FusionAhrs *ahrs,
+                          FAR const struct sensor_gyro *gyro,
+                          FAR const struct sensor_accel *accel,
+                          size_t n, FAR uint64_t *last, float dt);
+
+#ifdef CONFIG_LIB_MADGWICK_FIXED
+/****************************************************************************
+ * Name: madgwick_q_init
+ *
+ * Description:
+ *   Initialize the fixed-point filter to the identity orientation.
+ *
+ * Input Parameters:
+ *   filter - The filter
+ *   beta   - Filter gain (0.1 is typical)
+ *   rate   - Sample rate in Hz
+ *
+ ****************************************************************************/
+
+void madgwick_q_init(FAR struct madgwick_q_s *filter, b16_t beta,
+                     uint32_t rate);
+
+/****************************************************************************
+ * Name: madgwick_q_update
+ *
+ * Description:
+ *   Update the filter with one sample.
+ *
+ * Input Parameters:
+ *   filter - The filter
+ *   gyro   - Angular rate in rad/s
+ *   accel  - Acceleration in any unit, or all zero to use the gyroscope
+ *            only
+ *
+ ****************************************************************************/
+
+void madgwick_q_update(FAR struct madgwick_q_s *filter,
+                       FAR const b16_t *gyro, FAR const b16_t *accel);
+
+/****************************************************************************
+ * Name: madgwick_q_update_batch
+ *
+ * Description:
+ *   Update the filter with n samples stored as x, y, z triplets.
+ *
+ ****************************************************************************/
+
+void madgwick_q_update_batch(FAR struct madgwick_q_s *filter,
+                             FAR const b16_t *gyro, FAR const b16_t *accel,
+                             size_t n);
+
+/****************************************************************************
+ * Name: madgwick_q_quaternion
+ *
+ * Description:
+ *   Get the orientation as a b16 quaternion w, x, y, z.
+ *
+ ****************************************************************************/
+
+void madgwick_q_quaternion(FAR const struct madgwick_q_s *filter,
+                           FAR b16_t *q);
+#endif
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_LIB_MADGWICK */
+#endif /* __APPS_INCLUDE_INERTIAL_MADGWICK_H */
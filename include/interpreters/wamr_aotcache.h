@@ -0,0 +1,141 @@
+/****************************************************************************
+ * apps/include/interpreters/wamr_aotcache.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_INTERPRETERS_WAMR_AOTCACHE_H
+#define __APPS_INCLUDE_INTERPRETERS_WAMR_AOTCACHE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef CONFIG_INTERPRETERS_WAMR_AOT_CACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The key of an artifact is the SHA-256 of its wasm module in hex */
+
+#define WAMR_AOTCACHE_KEYLEN 64
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* An AOT artifact mapped from the cache */
+
+struct wamr_aotcache_s
+{
+  FAR uint8_t *data;         /* Start of the artifact */
+  size_t       size;         /* Size of the artifact in bytes */
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wamr_aotcache_key
+ *
+ * Description:
+ *   Compute the cache key of a wasm module.
+ *
+ * Input Parameters:
+ *   wasm - The wasm module
+ *   len  - The size of the module in bytes
+ *   key  - The location to return the key, WAMR_AOTCACHE_KEYLEN + 1 bytes
+ *
+ ****************************************************************************/
+
+void wamr_aotcache_key(FAR const uint8_t *wasm, size_t len, FAR char *key);
+
+/****************************************************************************
+ * Name: wamr_aotcache_open
+ *
+ * Description:
+ *   Map the AOT artifact of a wasm module from the cache.  The artifact is
+ *   mapped read-only in place when the file system supports it (e.g. ROMFS
+ *   on a memory mapped flash), so that an XIP artifact executes directly
+ *   from flash and no copy is made.  The result may be passed to
+ *   wasm_runtime_load() instead of the wasm module.
+ *
+ * Input Parameters:
+ *   wasm - The wasm module
+ *   len  - The size of the module in bytes
+ *   aot  - The location to return the mapped artifact
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ENOENT if the module is not in the cache.
+ *   Otherwise, a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int wamr_aotcache_open(FAR const uint8_t *wasm, size_t len,
+                       FAR struct wamr_aotcache_s *aot);
+
+/****************************************************************************
+ * Name: wamr_aotcache_close
+ *
+ * Description:
+ *   Release an artifact returned by wamr_aotcache_open().  It must not be
+ *   released before the module loaded from it is unloaded.
+ *
+ ****************************************************************************/
+
+void wamr_aotcache_close(FAR struct wamr_aotcache_s *aot);
+
+/****************************************************************************
+ * Name: wamr_aotcache_store
+ *
+ * Description:
+ *   Add the AOT artifact of a wasm module to the cache, e.g. when it is
+ *   received with an update.  The artifact is written to a temporary file
+ *   and renamed, so a reader never sees a partial artifact.
+ *
+ * Input Parameters:
+ *   wasm    - The wasm module
+ *   len     - The size of the module in bytes
+ *   data    - The AOT artifact compiled from the module by wamrc
+ *   datalen - The size of the artifact in bytes
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int wamr_aotcache_store(FAR const uint8_t *wasm, size_t len,
+                        FAR const void *data, size_t datalen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_INTERPRETERS_WAMR_AOT_CACHE */
+#endif /* __APPS_INCLUDE_INTERPRETERS_WAMR_AOTCACHE_H */
@@ -0,0 +1,298 @@
+/****************************************************************************
+ * apps/include/logging/embedlog_async.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_LOGGING_EMBEDLOG_ASYNC_H
+#define __APPS_INCLUDE_LOGGING_EMBEDLOG_ASYNC_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <nuttx/compiler.h>
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <logging/embedlog.h>
+
+#ifdef CONFIG_EMBEDLOG_ASYNC
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* What to do when the queue is full */
+
+enum el_async_policy_e
+{
+  EL_ASYNC_DROP  = 0,           /* Drop the record and count it */
+  EL_ASYNC_BLOCK = 1            /* Wait for the writer to free a slot */
+};
+
+/* Record types */
+
+enum el_async_type_e
+{
+  EL_ASYNC_TEXT     = 0,        /* Formatted by the caller */
+  EL_ASYNC_BINARY   = 1,        /* Raw data for el_opbinary() */
+  EL_ASYNC_DEFERRED = 2         /* Format address and raw arguments */
+};
+
+/* Queue slot.  seq implements the per-slot handshake that makes the
+ * queue lock-free for many producers and one consumer.
+ */
+
+struct el_async_slot_s
+{
+  atomic_size_t   seq;
+  struct timespec ts;
+  uint16_t        len;
+  uint8_t         level;
+  uint8_t         type;
+  char            data[CONFIG_EMBEDLOG_ASYNC_RECORD_MAX];
+};
+
+/* Asynchronous logger configuration */
+
+struct el_async_cfg_s
+{
+  FAR struct el *el;            /* Embedlog object the writer prints to */
+  size_t         records;       /* Queue length, a power of two */
+  size_t         batch_len;     /* Size of a single write */
+  uint32_t       period_ms;     /* Max delay of a queued record */
+  uint8_t        policy;        /* enum el_async_policy_e */
+  uint8_t        level;         /* Records above this level are discarded */
+  int            priority;      /* Writer task priority */
+  int            stacksize;     /* Writer task stack size */
+#ifdef CONFIG_EMBEDLOG_ASYNC_DEFERRED
+  bool           offline;       /* Leave deferred records to el_decode.py */
+#endif
+};
+
+/* Asynchronous logger statistics */
+
+struct el_async_stats_s
+{
+  size_t queued;                /* Records waiting for the writer */
+  size_t written;               /* Records written */
+  size_t dropped;               /* Records dropped on a full queue */
+  size_t batches;               /* Writes issued by the writer */
+};
+
+/* Asynchronous logger */
+
+struct el_async_s
+{
+  struct el_async_cfg_s       cfg;
+
+  /* Queue */
+
+  FAR struct el_async_slot_s *slots;
+  size_t                      mask;
+  atomic_size_t               head;
+  atomic_size_t               tail;
+
+  /* Writer */
+
+  FAR char                   *batch;
+  size_t                      batch_i;
+  pthread_t                   thread;
+  sem_t                       wake;
+  sem_t                       space;
+  sem_t                       flushed;
+  atomic_bool                 sleeping;
+  atomic_bool                 exit;
+  atomic_size_t               waiters;
+  atomic_size_t               flushers;
+
+  /* Statistics */
+
+  atomic_size_t               written;
+  atomic_size_t               dropped;
+  atomic_size_t               batches;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: el_async_init
+ *
+ * Description:
+ *   Initialize an asynchronous logger and start its writer task
+ *
+ * Input Parameters:
+ *   a   - a pointer to an asynchronous logger
+ *   cfg - a pointer to the logger configuration
+ *
+ ****************************************************************************/
+
+int el_async_init(FAR struct el_async_s *a,
+                  FAR const struct el_async_cfg_s *cfg);
+
+/****************************************************************************
+ * Name: el_async_deinit
+ *
+ * Description:
+ *   Write all queued records, stop the writer task and free the logger
+ *
+ * Input Parameters:
+ *   a - a pointer to an asynchronous logger
+ *
+ ****************************************************************************/
+
+void el_async_deinit(FAR struct el_async_s *a);
+
+/****************************************************************************
+ * Name: el_async_print
+ *
+ * Description:
+ *   Format a message and queue it.  No I/O is done in the caller context,
+ *   the writer task prefixes the capture timestamp and level.
+ *
+ * Input Parameters:
+ *   a     - a pointer to an asynchronous logger
+ *   level - log level (enum el_level)
+ *   fmt   - printf-like format
+ *
+ * Returned Value:
+ *   Zero on success, -EAGAIN if the record was dropped.
+ *
+ ****************************************************************************/
+
+int el_async_print(FAR struct el_async_s *a, int level,
+                   FAR const char *fmt, ...) printf_like(3, 4);
+
+/****************************************************************************
+ * Name: el_async_vprint
+ *
+ * Description:
+ *   va_list version of el_async_print()
+ *
+ ****************************************************************************/
+
+int el_async_vprint(FAR struct el_async_s *a, int level,
+                    FAR const char *fmt, va_list ap);
+
+#ifdef CONFIG_EMBEDLOG_ENABLE_BINARY_LOGS
+/****************************************************************************
+ * Name: el_async_binary
+ *
+ * Description:
+ *   Queue a binary record, the writer passes it to el_opbinary()
+ *
+ * Input Parameters:
+ *   a     - a pointer to an asynchronous logger
+ *   level - log level (enum el_level)
+ *   data  - record data
+ *   len   - record length
+ *
+ ****************************************************************************/
+
+int el_async_binary(FAR struct el_async_s *a, int level,
+                    FAR const void *data, size_t len);
+#endif
+
+#ifdef CONFIG_EMBEDLOG_ASYNC_DEFERRED
+/****************************************************************************
+ * Name: el_async_dprint
+ *
+ * Description:
+ *   Queue the format address and the raw arguments, formatting is done
+ *   by the writer task.  With cfg->offline set, the writer stores the
+ *   record unformatted with el_opbinary() and el_decode.py formats it on
+ *   the host, looking the format up in the ELF file of the firmware.
+ *
+ *   fmt must be a string literal.  %s arguments are copied, %n is not
+ *   supported.  If the arguments do not fit a record the format itself is
+ *   logged and -E2BIG returned.
+ *
+ * Input Parameters:
+ *   a     - a pointer to an asynchronous logger
+ *   level - log level (enum el_level)
+ *   fmt   - printf-like format
+ *
+ ****************************************************************************/
+
+int el_async_dprint(FAR struct el_async_s *a, int level,
+                    FAR const char *fmt, ...) printf_like(3, 4);
+
+/****************************************************************************
+ * Name: el_async_vdprint
+ *
+ * Description:
+ *   va_list version of el_async_dprint()
+ *
+ ****************************************************************************/
+
+int el_async_vdprint(FAR struct el_async_s *a, int level,
+                     FAR const char *fmt, va_list ap);
+#endif
+
+/****************************************************************************
+ * Name: el_async_flush
+ *
+ * Description:
+ *   Wait until everything queued so far is written
+ *
+ * Input Parameters:
+ *   a - a pointer to an asynchronous logger
+ *
+ ****************************************************************************/
+
+int el_async_flush(FAR struct el_async_s *a);
+
+/****************************************************************************
+ * Name: el_async_stats
+ *
+ * Description:
+ *   Get the logger statistics
+ *
+ * Input Parameters:
+ *   a     - a pointer to an asynchronous logger
+ *   stats - returned statistics
+ *
+ ****************************************************************************/
+
+void el_async_stats(FAR struct el_async_s *a,
+                    FAR struct el_async_stats_s *stats);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_EMBEDLOG_ASYNC */
+#endif /* __APPS_INCLUDE_LOGGING_EMBEDLOG_ASYNC_H */
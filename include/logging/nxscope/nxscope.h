@@ -31,6 +31,10 @@
 #include <pthread.h>
 #include <stdint.h>
 
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+#  include <stdatomic.h>
+#endif
+
 #include <logging/nxscope/nxscope_chan.h>
 #include <logging/nxscope/nxscope_intf.h>
 #include <logging/nxscope/nxscope_proto.h>
@@ -47,6 +51,10 @@
 
 #define NXSCOPE_IS_CRICHAN(chtype) (chtype & 0x80)
 
+/* Channel not bound to a producer ring */
+
+#define NXSCOPE_RING_NONE     (0xff)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -83,11 +91,15 @@ enum nxscope_hdr_id_e
   NXSCOPE_HDRID_ENABLE  = 6,             /* Snable/disable channels */
   NXSCOPE_HDRID_DIV     = 7,             /* Channels divider */
 
+  /* Stream frames */
+
+  NXSCOPE_HDRID_BLOCK   = 8,             /* Block of samples of one channel */
+
   /* User defined frames.
    * Must be alway the last element.
    */
 
-  NXSCOPE_HDRID_USER   = 8
+  NXSCOPE_HDRID_USER   = 9
 };
 
 /* Nxscope flags */
@@ -96,7 +108,7 @@ enum nxscope_info_flags_e
 {
   NXSCOPE_FLAGS_DIVIDER_SUPPORT   = (1 << 0),
   NXSCOPE_FLAGS_ACK_SUPPORT       = (1 << 1),
-  NXSCOPE_FLAGS_RES2              = (1 << 2),
+  NXSCOPE_FLAGS_BLOCK_SUPPORT     = (1 << 2),
   NXSCOPE_FLAGS_RES3              = (1 << 3),
   NXSCOPE_FLAGS_RES4              = (1 << 4),
   NXSCOPE_FLAGS_RES5              = (1 << 5),
@@ -108,9 +120,73 @@ enum nxscope_info_flags_e
 
 enum nxscope_stream_flags_s
 {
-  NXSCOPE_STREAM_FLAGS_OVERFLOW = (1 << 0)
+  NXSCOPE_STREAM_FLAGS_OVERFLOW = (1 << 0),
+  NXSCOPE_STREAM_FLAGS_TRIGGER  = (1 << 1)  /* Frame starts a trigger window */
 };
 
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+/* Nxscope trigger mode */
+
+enum nxscope_trig_mode_e
+{
+  NXSCOPE_TRIG_OFF     = 0,             /* Continuous stream */
+  NXSCOPE_TRIG_RISING  = 1,             /* Rising edge through level */
+  NXSCOPE_TRIG_FALLING = 2,             /* Falling edge through level */
+  NXSCOPE_TRIG_ABOVE   = 3,             /* Sample >= level */
+  NXSCOPE_TRIG_BELOW   = 4,             /* Sample <= level */
+  NXSCOPE_TRIG_EXT     = 5              /* nxscope_trig_fire() */
+};
+
+/* Nxscope trigger state */
+
+enum nxscope_trig_state_e
+{
+  NXSCOPE_TRIG_STATE_IDLE      = 0,     /* Off or window already sent */
+  NXSCOPE_TRIG_STATE_ARMED     = 1,     /* Filling the pre-trigger window */
+  NXSCOPE_TRIG_STATE_TRIGGERED = 2,     /* Capturing post-trigger samples */
+  NXSCOPE_TRIG_STATE_DONE      = 3      /* Window captured, being sent */
+};
+
+/* Nxscope trigger configuration.
+ *
+ * pre and post count samples of the trigger channel; the samples of the
+ * other channels in between are captured with them.
+ */
+
+struct nxscope_trig_cfg_s
+{
+  uint8_t  mode;                        /* enum nxscope_trig_mode_e */
+  uint8_t  chan;                        /* Trigger channel */
+  uint8_t  idx;                         /* Vector element to compare */
+  float    level;                       /* Trigger level */
+  uint16_t pre;                         /* Samples before the trigger */
+  uint16_t post;                        /* Samples after the trigger */
+  bool     rearm;                       /* Re-arm after each window */
+};
+
+/* Nxscope trigger data */
+
+struct nxscope_trig_s
+{
+  struct nxscope_trig_cfg_s cfg;
+
+  /* Capture buffer, records in the same format as the producer rings */
+
+  FAR uint8_t              *buf;
+  size_t                    mask;
+  size_t                    head;
+  size_t                    tail;
+
+  uint8_t                   state;
+  bool                      fire;       /* External event pending */
+  bool                      first;      /* Next frame starts a window */
+  bool                      prev_valid;
+  float                     prev;       /* Last trigger channel value */
+  uint16_t                  pre_n;
+  uint16_t                  post_n;
+};
+#endif
+
 /* Nxscope start frame data */
 
 begin_packed_struct struct nxscope_start_data_s
@@ -222,6 +298,29 @@ struct nxscope_sample_s
                                          /* m bytes: Metadata */
 };
 
+/* Nxscope block data (NXSCOPE_HDRID_BLOCK frame):
+ *
+ *   +-------+---------+--------+--------+-------------+
+ *   | flags | channel | n      | ts     | sample data |
+ *   +-------+---------+--------+--------+-------------+
+ *   | 1B    | 1B      | 2B [1] | 4B [1] | n * m [2]   |
+ *   +-------+---------+--------+--------+-------------+
+ *
+ *   [1] - always little-endian, ts is the time of the first sample in us
+ *   [2] - m = sizeof(channel_type) * channel_vdim, no metadata
+ *         NOTE: sample data always little-endian !
+ *
+ */
+
+struct nxscope_block_s
+{
+  uint8_t  flags;                        /* 1 byte: stream flags */
+  uint8_t  chan;                         /* 1 byte: Channel id */
+  uint16_t n;                            /* 2 bytes: Number of samples */
+  uint32_t ts;                           /* 4 bytes: Timestamp */
+                                         /* n * m bytes: Data */
+};
+
 /* Nxscope stream data:
  *
  *   +----------+--------------+
@@ -253,6 +352,22 @@ struct nxscope_callbacks_s
   CODE int (*start)(FAR void *priv, bool start);
 };
 
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+/* Nxscope single-producer sample ring.
+ *
+ * head is only written by the producer and tail only by nxscope_stream().
+ * Both run freely and are masked on access.
+ */
+
+struct nxscope_ring_s
+{
+  FAR uint8_t   *buf;
+  size_t         mask;                   /* Ring length - 1 */
+  atomic_size_t  head;
+  atomic_size_t  tail;
+};
+#endif
+
 /* Nxscope general configuration */
 
 struct nxscope_cfg_s
@@ -319,6 +434,34 @@ struct nxscope_cfg_s
    */
 
   uint8_t rx_padding;
+
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+  /* Trigger capture buffer len, a power of two.  It must hold the whole
+   * pre and post trigger window of all enabled channels.
+   */
+
+  size_t trigbuf_len;
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+  /* Block buffer len.
+   *
+   * Each nxscope_put_block_XXXX() call takes a whole frame from this
+   * buffer: proto_stream->hdrlen + 8 + n * vdim * type_size +
+   * proto_stream->footlen.
+   */
+
+  size_t blockbuf_len;
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+  /* Number of producer rings and the length of each ring.
+   * The length must be a power of two.
+   */
+
+  uint8_t rings;
+  size_t  ring_len;
+#endif
 };
 
 /* Nxscope data */
@@ -369,6 +512,30 @@ struct nxscope_s
   size_t                       cribuf_len;
 #endif
 
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+  /* Trigger */
+
+  struct nxscope_trig_s        trig;
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+  /* Block frames, finalized and waiting for nxscope_stream() */
+
+  FAR uint8_t                 *blockbuf;
+  size_t                       blockbuf_len;
+  size_t                       block_i;
+  uint8_t                      block_flags;
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+  /* Producer rings, the ring of each channel and overrun counters */
+
+  FAR struct nxscope_ring_s   *rings;
+  uint8_t                      rings_n;
+  FAR uint8_t                 *chring;
+  FAR uint32_t                *overrun;
+#endif
+
   /* RX data buffer */
 
   FAR uint8_t                 *rxbuf;
@@ -486,4 +653,62 @@ int nxscope_recv(FAR struct nxscope_s *s);
 
 int nxscope_stream_start(FAR struct nxscope_s *s, bool start);
 
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+/****************************************************************************
+ * Name: nxscope_trig_set
+ *
+ * Description:
+ *   Configure and arm the trigger.  While a trigger is set, the buffered
+ *   channels are only streamed in windows around the trigger event.
+ *   Producer rings and block frames are not affected.
+ *
+ * Input Parameters:
+ *   s   - a pointer to a nxscope instance
+ *   cfg - a pointer to the trigger configuration
+ *
+ ****************************************************************************/
+
+int nxscope_trig_set(FAR struct nxscope_s *s,
+                     FAR const struct nxscope_trig_cfg_s *cfg);
+
+/****************************************************************************
+ * Name: nxscope_trig_arm
+ *
+ * Description:
+ *   Re-arm a trigger that captured its window
+ *
+ * Input Parameters:
+ *   s - a pointer to a nxscope instance
+ *
+ ****************************************************************************/
+
+int nxscope_trig_arm(FAR struct nxscope_s *s);
+
+/****************************************************************************
+ * Name: nxscope_trig_fire
+ *
+ * Description:
+ *   Signal the external event of a NXSCOPE_TRIG_EXT trigger
+ *
+ * Input Parameters:
+ *   s - a pointer to a nxscope instance
+ *
+ ****************************************************************************/
+
+void nxscope_trig_fire(FAR struct nxscope_s *s);
+
+/****************************************************************************
+ * Name: nxscope_trig_state
+ *
+ * Description:
+ *   Get the trigger state (enum nxscope_trig_state_e)
+ *
+ * Input Parameters:
+ *   s - a pointer to a nxscope instance
+ *
+ ****************************************************************************/
+
+int nxscope_trig_state(FAR struct nxscope_s *s);
+#endif
+
 #endif  /* __APPS_INCLUDE_LOGGING_NXSCOPE_NXSCOPE_H */
@@ -160,6 +160,38 @@ int nxscope_chan_div(FAR struct nxscope_s *s, uint8_t chan, uint8_t div);
 
 int nxscope_chan_all_en(FAR struct nxscope_s *s, bool en);
 
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+/****************************************************************************
+ * Name: nxscope_chan_ring
+ *
+ * Description:
+ *   Bind a channel to a producer ring.  Puts on the channel then go to
+ *   the ring without locking.  Critical channels can't be bound.
+ *
+ * Input Parameters:
+ *   s    - a pointer to a nxscope instance
+ *   ch   - a channel id
+ *   ring - a ring id or NXSCOPE_RING_NONE to unbind
+ *
+ ****************************************************************************/
+
+int nxscope_chan_ring(FAR struct nxscope_s *s, uint8_t ch, uint8_t ring);
+
+/****************************************************************************
+ * Name: nxscope_chan_overrun
+ *
+ * Description:
+ *   Get the number of samples dropped because the channel ring was full
+ *
+ * Input Parameters:
+ *   s  - a pointer to a nxscope instance
+ *   ch - a channel id
+ *
+ ****************************************************************************/
+
+uint32_t nxscope_chan_overrun(FAR struct nxscope_s *s, uint8_t ch);
+#endif
+
 /****************************************************************************
  * Name: nxscope_put_vXXXX_m
  *
@@ -398,4 +430,56 @@ int nxscope_put_ub32(FAR struct nxscope_s *s, uint8_t ch, ub32_t val);
 int nxscope_put_b32(FAR struct nxscope_s *s, uint8_t ch, b32_t val);
 int nxscope_put_char(FAR struct nxscope_s *s, uint8_t ch, char val);
 
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+/****************************************************************************
+ * Name: nxscope_put_block_XXXX
+ *
+ * Description:
+ *   Put n consecutive samples of one channel on the block buffer.  The
+ *   samples share one frame header and one timestamp.  Channels with
+ *   metadata can't use blocks.
+ *
+ * Input Parameters:
+ *   s   - a pointer to a nxscope instance
+ *   ch  - a channel id
+ *   val - a pointer to n sample vectors, one after another
+ *   d   - a dimmention of sample data vector
+ *   n   - number of samples
+ *
+ ****************************************************************************/
+
+int nxscope_put_block_uint8(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR uint8_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_int8(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR int8_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_uint16(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint16_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_int16(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int16_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_uint32(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint32_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_int32(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int32_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_uint64(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint64_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_int64(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int64_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_float(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR float *val, uint8_t d, uint16_t n);
+int nxscope_put_block_double(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR double *val, uint8_t d, uint16_t n);
+int nxscope_put_block_ub8(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR ub8_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_b8(FAR struct nxscope_s *s, uint8_t ch,
+                         FAR b8_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_ub16(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR ub16_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_b16(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR b16_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_ub32(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR ub32_t *val, uint8_t d, uint16_t n);
+int nxscope_put_block_b32(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR b32_t *val, uint8_t d, uint16_t n);
+#endif
+
 #endif  /* __APPS_INCLUDE_LOGGING_NXSCOPE_NXSCOPE_CHAN_H */
@@ -89,6 +89,30 @@ struct nxscope_ser_cfg_s
 };
 #endif
 
+#ifdef CONFIG_LOGGING_NXSCOPE_INTF_UDP
+/* Nxscope UDP interface configuration */
+
+struct nxscope_udp_cfg_s
+{
+  uint16_t  port;               /* Local port */
+  FAR char *raddr;              /* Remote IPv4 address.
+                                 * NULL - send to the last request sender
+                                 */
+  uint16_t  rport;              /* Remote port, used with raddr */
+  size_t    txbuf_len;          /* Size of each TX buffer, one datagram */
+};
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_INTF_USB
+/* Nxscope USB bulk interface configuration */
+
+struct nxscope_usb_cfg_s
+{
+  FAR char *path;               /* Bulk device path, e.g. /dev/ttyACM0 */
+  size_t    txbuf_len;          /* Size of each TX buffer */
+};
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -123,4 +147,34 @@ int nxscope_ser_init(FAR struct nxscope_intf_s *intf,
 void nxscope_ser_deinit(FAR struct nxscope_intf_s *intf);
 #endif
 
+#ifdef CONFIG_LOGGING_NXSCOPE_INTF_UDP
+/****************************************************************************
+ * Name: nxscope_udp_init
+ ****************************************************************************/
+
+int nxscope_udp_init(FAR struct nxscope_intf_s *intf,
+                     FAR struct nxscope_udp_cfg_s *cfg);
+
+/****************************************************************************
+ * Name: nxscope_udp_deinit
+ ****************************************************************************/
+
+void nxscope_udp_deinit(FAR struct nxscope_intf_s *intf);
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_INTF_USB
+/****************************************************************************
+ * Name: nxscope_usb_init
+ ****************************************************************************/
+
+int nxscope_usb_init(FAR struct nxscope_intf_s *intf,
+                     FAR struct nxscope_usb_cfg_s *cfg);
+
+/****************************************************************************
+ * Name: nxscope_usb_deinit
+ ****************************************************************************/
+
+void nxscope_usb_deinit(FAR struct nxscope_intf_s *intf);
+#endif
+
 #endif  /* __APPS_INCLUDE_LOGGING_NXSCOPE_NXSCOPE_INTF_H */
@@ -0,0 +1,94 @@
+/****************************************************************************
+ * apps/include/mlearning/nnablart_planner.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_MLEARNING_NNABLART_PLANNER_H
+#define __APPS_INCLUDE_MLEARNING_NNABLART_PLANNER_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+
+#include <nnablart/network.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* The result of the planning, in the size unit of the .nnb buffer list */
+
+struct nnablart_plan_s
+{
+  int    nbuffers;           /* Activation buffers of the model */
+  int    planned_buffers;    /* Buffers once those not alive together
+                              * are merged */
+  size_t size;               /* Sum of the buffer sizes of the model */
+  size_t planned_size;       /* Sum of the planned buffer sizes */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: nnablart_plan
+ *
+ * Description:
+ *   Compute the lifetime of each activation buffer of a network, from the
+ *   first to the last function that uses it, and let the buffers whose
+ *   lifetimes do not overlap share the same memory.  The buffer list and
+ *   the variables of the network are rewritten in place, so this must be
+ *   called before rt_initialize_context(), which then allocates only the
+ *   planned buffers.
+ *
+ *   The inputs and outputs of the network are kept alive for the whole
+ *   inference, so that they can be written before and read after
+ *   rt_forward().
+ *
+ * Input Parameters:
+ *   network - The network loaded from an .nnb file
+ *   plan    - Returns the buffer sizes before and after planning, may be
+ *             NULL
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int nnablart_plan(FAR nn_network_t *network,
+                  FAR struct nnablart_plan_s *plan);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_MLEARNING_NNABLART_PLANNER_H */
@@ -107,6 +107,35 @@ typedef enum
     MB_TMODE_CONVERT_DELAY          /* Master sent broadcast ,then delay sometime.*/
 }eMBMasterTimerMode;
 
+#ifdef CONFIG_MB_MASTER_SCHEDULER
+/* Register table of a scheduler tag. */
+
+typedef enum
+{
+    MB_SCHED_REG_HOLDING,           /* Holding registers. */
+    MB_SCHED_REG_INPUT              /* Input registers. */
+} eMBMasterSchedRegType;
+
+/* Registers polled by the scheduler.  The application sets the first
+ * five fields, the others belong to the scheduler.
+ */
+
+typedef struct
+{
+    uint8_t ucSlaveAddr;            /* Slave address. */
+    eMBMasterSchedRegType eRegType; /* Register table. */
+    uint16_t usRegAddr;             /* Start address, as in requests. */
+    uint16_t usNRegs;               /* Number of registers. */
+    uint32_t ulPeriodMs;            /* Polling period. */
+
+    uint16_t usBlock;               /* Merged request of the tag. */
+    uint32_t ulDueMs;               /* Time of the next poll. */
+    uint32_t ulUpdateMs;            /* Time of the last good response. */
+    eMBMasterReqErrCode eStatus;    /* Result of the last poll. */
+    bool xValid;                    /* Cached values are available. */
+} xMBMasterSchedTag;
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -460,6 +489,20 @@ eMBMasterErrorEventType eMBMasterGetErrorType(void);
 void vMBMasterSetErrorType(eMBMasterErrorEventType errorType);
 eMBMasterReqErrCode eMBMasterWaitRequestFinish(void);
 
+#ifdef CONFIG_MB_MASTER_SCHEDULER
+/* Polling scheduler, see modbus/mbsched_m.c */
+
+eMBMasterReqErrCode eMBMasterSchedInit(xMBMasterSchedTag *pxTags,
+  uint16_t usNTags);
+void vMBMasterSchedClose(void);
+uint32_t ulMBMasterSchedPoll(void);
+eMBMasterReqErrCode eMBMasterSchedGet(const xMBMasterSchedTag *pxTag,
+  uint16_t *pusRegs, uint32_t *pulAgeMs);
+void vMBMasterSchedUpdate(uint8_t ucSlaveAddr,
+  eMBMasterSchedRegType eRegType, uint16_t usRegAddr, uint16_t usNRegs,
+  const uint8_t *pucRegBuffer);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
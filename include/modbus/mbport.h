@@ -114,6 +114,17 @@ extern bool(*pxMBMasterFrameCBByteReceived)(void);
 extern bool(*pxMBMasterFrameCBTransmitterEmpty)(void);
 extern bool(*pxMBMasterPortCBTimerExpired)(void);
 
+#ifdef CONFIG_MB_RTU_FRAME_RX
+/* Callback function for a port that receives whole RTU frames, after the
+ * line was silent for t3.5.  It replaces the byte callback and the t3.5
+ * timer.  NULL if the current mode needs the characters one at a time.
+ */
+
+extern bool(*pxMBFrameCBFrameReceived)(uint8_t *pucFrame, uint16_t usLen);
+extern bool(*pxMBMasterFrameCBFrameReceived)(uint8_t *pucFrame,
+                                             uint16_t usLen);
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
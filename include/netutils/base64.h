@@ -58,6 +58,24 @@
 
 #include <nuttx/config.h>
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* State of a streaming encode or decode */
+
+struct base64_context_s
+{
+  unsigned char buf[4];  /* Partial block: bytes to encode, decoded values */
+  uint8_t len;           /* Number of entries of buf in use */
+  bool websafe;          /* Web safe alphabet */
+  bool done;             /* Decode: padding seen, the rest is ignored */
+};
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -78,6 +96,17 @@ FAR void *base64w_encode(FAR const void *src, size_t len, FAR void *dst,
                          FAR size_t *out_len);
 FAR void *base64w_decode(FAR const void *src, size_t len, FAR void *dst,
                          FAR size_t *out_len);
+
+void   base64_encode_init(FAR struct base64_context_s *ctx, bool websafe);
+size_t base64_encode_update(FAR struct base64_context_s *ctx,
+                            FAR const void *src, size_t len,
+                            FAR void *dst);
+size_t base64_encode_final(FAR struct base64_context_s *ctx, FAR void *dst);
+void   base64_decode_init(FAR struct base64_context_s *ctx, bool websafe);
+size_t base64_decode_update(FAR struct base64_context_s *ctx,
+                            FAR const void *src, size_t len,
+                            FAR void *dst);
+size_t base64_decode_final(FAR struct base64_context_s *ctx, FAR void *dst);
 #endif /* CONFIG_CODECS_BASE64 */
 
 #ifdef __cplusplus
@@ -0,0 +1,121 @@
+/****************************************************************************
+ * apps/include/netutils/cjson_arena.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_NETUTILS_CJSON_ARENA_H
+#define __APPS_INCLUDE_NETUTILS_CJSON_ARENA_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "netutils/cJSON.h"
+
+#ifdef CONFIG_NETUTILS_CJSON_ARENA
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* All of the nodes and strings of the documents parsed into an arena are
+ * carved from one block, and released together by cjson_arena_reset() or
+ * cjson_arena_free().  cJSON_Delete() must not be used on them.
+ */
+
+struct cjson_arena_s
+{
+  FAR uint8_t *base;   /* Start of the block */
+  size_t size;         /* Size of the block */
+  size_t used;         /* Bytes handed out */
+  size_t peak;         /* Largest value of used */
+  bool allocated;      /* The block was allocated by cjson_arena_init() */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************
+ * Name: cjson_arena_init
+ *
+ * Description:
+ *   Set up an arena in buf, or in a block of size bytes allocated here if
+ *   buf is NULL.  A size of 0 selects CONFIG_NETUTILS_CJSON_ARENA_SIZE.
+ *
+ * Returned Value:
+ *   OK, or -ENOMEM if the block can't be allocated.
+ *
+ ****************************************************************************/
+
+int cjson_arena_init(FAR struct cjson_arena_s *arena, FAR void *buf,
+                     size_t size);
+
+/****************************************************************************
+ * Name: cjson_arena_parse
+ *
+ * Description:
+ *   cJSON_Parse() with every allocation made in the arena.  Other threads
+ *   keep using the heap while the parse runs.
+ *
+ * Returned Value:
+ *   The document, or NULL if the text is invalid or the arena is full.  A
+ *   failed parse gives its memory back to the arena.
+ *
+ ****************************************************************************/
+
+FAR cJSON *cjson_arena_parse(FAR struct cjson_arena_s *arena,
+                             FAR const char *value);
+
+/****************************************************************************
+ * Name: cjson_arena_reset
+ *
+ * Description:
+ *   Release all of the documents parsed into the arena at once.
+ *
+ ****************************************************************************/
+
+void cjson_arena_reset(FAR struct cjson_arena_s *arena);
+
+/****************************************************************************
+ * Name: cjson_arena_free
+ *
+ * Description:
+ *   Release the documents and the block allocated by cjson_arena_init().
+ *
+ ****************************************************************************/
+
+void cjson_arena_free(FAR struct cjson_arena_s *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_NETUTILS_CJSON_ARENA */
+#endif /* __APPS_INCLUDE_NETUTILS_CJSON_ARENA_H */
@@ -0,0 +1,93 @@
+/****************************************************************************
+ * apps/include/netutils/coap_notify.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_NETUTILS_COAP_NOTIFY_H
+#define __APPS_INCLUDE_NETUTILS_COAP_NOTIFY_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <coap3/coap.h>
+
+#ifdef CONFIG_NETUTILS_LIBCOAP_NOTIFY
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************
+ * Name: coap_notify_resource
+ *
+ * Description:
+ *   Create and add to ctx an observable resource at path whose
+ *   representation is set with coap_notify_publish().  All of the GET
+ *   responses and notifications send the same copy of the last published
+ *   payload, in blocks (RFC 7959) if it doesn't fit the MTU.  This
+ *   enables the block-wise transfers handled by libcoap on ctx.
+ *
+ * Input Parameters:
+ *   ctx        - The context
+ *   path       - URI path of the resource
+ *   media_type - Content-Format of the payload, COAP_MEDIATYPE_*
+ *   maxage     - Max-Age of the responses, or -1 for none
+ *
+ * Returned Value:
+ *   The resource, or NULL if it can't be allocated.
+ *
+ ****************************************************************************/
+
+FAR coap_resource_t *coap_notify_resource(FAR coap_context_t *ctx,
+                                          FAR const char *path,
+                                          uint16_t media_type, int maxage);
+
+/****************************************************************************
+ * Name: coap_notify_publish
+ *
+ * Description:
+ *   Replace the representation of a resource created with
+ *   coap_notify_resource() and notify its observers.  The payload is
+ *   copied once, then shared by the responses until they are all sent.
+ *   Like the rest of libcoap, this must run in the thread of the context.
+ *
+ * Returned Value:
+ *   OK, or -ENOMEM.
+ *
+ ****************************************************************************/
+
+int coap_notify_publish(FAR coap_resource_t *resource,
+                        FAR const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_NETUTILS_LIBCOAP_NOTIFY */
+#endif /* __APPS_INCLUDE_NETUTILS_COAP_NOTIFY_H */
@@ -0,0 +1,172 @@
+/****************************************************************************
+ * apps/include/netutils/cwebsocket_frame.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_NETUTILS_CWEBSOCKET_FRAME_H
+#define __APPS_INCLUDE_NETUTILS_CWEBSOCKET_FRAME_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Largest client frame header: 2 bytes, 8 bytes of length, 4 of mask */
+
+#define CWEBSOCKET_HDRLEN_MAX 14
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct _cwebsocket;
+
+/* A transmit queue coalesces small frames, such as telemetry samples, into
+ * one write of up to size bytes.  Queued frames go out when the buffer is
+ * full, on cwebsocket_txq_flush(), or on the first cwebsocket_txq_write()
+ * or cwebsocket_txq_poll() at least interval milliseconds after the oldest
+ * of them was queued.
+ */
+
+struct cwebsocket_txq_s
+{
+  FAR struct _cwebsocket *websocket;
+  FAR uint8_t *buf;
+  size_t size;
+  size_t len;
+  unsigned int interval;        /* Flush interval in milliseconds */
+  struct timespec first;        /* When the oldest queued frame was queued */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: cwebsocket_mask
+ *
+ * Description:
+ *   Copy len bytes from src to dst masked with key, word by word (sixteen
+ *   bytes at a time with NEON).  offset is the position of src in the
+ *   payload, so that a payload can be masked in pieces.  dst may be src.
+ *
+ ****************************************************************************/
+
+void cwebsocket_mask(FAR uint8_t *dst, FAR const uint8_t *src, size_t len,
+                     FAR const uint8_t *key, uint64_t offset);
+
+/****************************************************************************
+ * Name: cwebsocket_client_write_frame
+ *
+ * Description:
+ *   Write a frame of opcode code with the masking key key.  The payload is
+ *   masked in a single pass into a buffer of CONFIG_CWEBSOCKET_TXBUFSIZE
+ *   bytes that also holds the header, so a frame that fits costs a single
+ *   write and a larger one never needs a buffer of its size.
+ *   cwebsocket_client_write_data() sends through this function.
+ *
+ * Returned Value:
+ *   The number of bytes written, header included; -1 on failure.
+ *
+ ****************************************************************************/
+
+int cwebsocket_client_write_frame(FAR struct _cwebsocket *websocket,
+                                  FAR const char *data, uint64_t len,
+                                  int code, FAR const uint8_t *key);
+
+/****************************************************************************
+ * Name: cwebsocket_txq_init
+ *
+ * Description:
+ *   Initialize a transmit queue that coalesces the frames written to
+ *   websocket in the size bytes of buf and flushes them after interval
+ *   milliseconds.  An interval of zero only coalesces until the next
+ *   cwebsocket_txq_flush().
+ *
+ ****************************************************************************/
+
+void cwebsocket_txq_init(FAR struct cwebsocket_txq_s *txq,
+                         FAR struct _cwebsocket *websocket,
+                         FAR uint8_t *buf, size_t size,
+                         unsigned int interval);
+
+/****************************************************************************
+ * Name: cwebsocket_txq_write
+ *
+ * Description:
+ *   Queue a frame.  A frame that does not fit in the buffer is written
+ *   directly after the queued ones.
+ *
+ * Returned Value:
+ *   len on success; -1 on failure.
+ *
+ ****************************************************************************/
+
+int cwebsocket_txq_write(FAR struct cwebsocket_txq_s *txq,
+                         FAR const char *data, size_t len, int code);
+
+/****************************************************************************
+ * Name: cwebsocket_txq_poll
+ *
+ * Description:
+ *   Flush the queue if its oldest frame has waited for the interval.  Call
+ *   it periodically when frames may stop arriving.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -1 on failure.
+ *
+ ****************************************************************************/
+
+int cwebsocket_txq_poll(FAR struct cwebsocket_txq_s *txq);
+
+/****************************************************************************
+ * Name: cwebsocket_txq_flush
+ *
+ * Description:
+ *   Write all the queued frames.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -1 on failure.
+ *
+ ****************************************************************************/
+
+int cwebsocket_txq_flush(FAR struct cwebsocket_txq_s *txq);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_NETUTILS_CWEBSOCKET_FRAME_H */
@@ -73,6 +73,10 @@
 #  define CONFIG_FTP_SIGNAL SIGUSR1
 #endif
 
+#ifndef CONFIG_FTPC_PUT_RETRIES
+#  define CONFIG_FTPC_PUT_RETRIES 0
+#endif
+
 /* Interface arguments ******************************************************/
 
 /* These definitions describe how a put operation should be performed */
@@ -207,6 +211,10 @@ int ftpc_getfile(SESSION handle, FAR const char *rname,
                  FAR const char *lname, uint8_t how, uint8_t xfrmode);
 int ftp_putfile(SESSION handle, FAR const char *lname,
                 FAR const char *rname, uint8_t how, uint8_t xfrmode);
+#ifdef CONFIG_FTPC_SEGMENTED
+int ftpc_getsegments(SESSION handle, FAR const char *rname,
+                     FAR const char *lname, int nsegments);
+#endif
 
 /* FTP response *************************************************************/
 
@@ -72,6 +72,9 @@ struct ping6_info_s
   uint16_t datalen;         /* Number of bytes to be sent */
   uint16_t delay;           /* Deciseconds to delay between pings */
   uint16_t timeout;         /* Deciseconds to wait response before timeout */
+  uint32_t interval;        /* Microseconds between pings, overrides delay
+                             * if not zero.  Zero in both sends each ping
+                             * as soon as the previous reply arrives. */
   FAR void *priv;           /* Private context for callback */
   void (*callback)(FAR const struct ping6_result_s *result);
 };
@@ -0,0 +1,123 @@
+/****************************************************************************
+ * apps/include/netutils/lwm2m_batch.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_NETUTILS_LWM2M_BATCH_H
+#define __APPS_INCLUDE_NETUTILS_LWM2M_BATCH_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <time.h>
+
+#include <liblwm2m.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* A batch collects the value changes that an application reports and hands
+ * them to Wakaama together, once per window.  The notifications of all the
+ * observations they trigger then leave in the same lwm2m_step(), so the
+ * radio wakes up once per window instead of once per change, and changes
+ * to several resources of an instance observed as a whole become a single
+ * notification.  Keep the window below the smallest pmax of the server and
+ * at or above its pmin: a shorter window only adds wakeups that Wakaama
+ * would hold back until pmin anyway.
+ */
+
+struct lwm2m_batch_s
+{
+  FAR lwm2m_context_t *ctx;
+  time_t window;                /* Seconds */
+  time_t first;                 /* When the oldest pending change came */
+  int count;                    /* Pending changes */
+  lwm2m_uri_t uris[CONFIG_WAKAAMA_BATCH_SIZE];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: lwm2m_batch_init
+ *
+ * Description:
+ *   Initialize a batch that reports the changes to ctx every window
+ *   seconds.
+ *
+ ****************************************************************************/
+
+void lwm2m_batch_init(FAR struct lwm2m_batch_s *batch,
+                      FAR lwm2m_context_t *ctx, time_t window);
+
+/****************************************************************************
+ * Name: lwm2m_batch_changed
+ *
+ * Description:
+ *   Record a change of uri, in place of lwm2m_resource_value_changed().
+ *   A change already covered by a pending one, for example of a resource
+ *   of a pending instance, is merged into it.  The batch is flushed when
+ *   it is full.
+ *
+ ****************************************************************************/
+
+void lwm2m_batch_changed(FAR struct lwm2m_batch_s *batch,
+                         FAR const lwm2m_uri_t *uri);
+
+/****************************************************************************
+ * Name: lwm2m_batch_step
+ *
+ * Description:
+ *   Flush the batch if its window has elapsed, and lower *timeout, as
+ *   passed to and returned by lwm2m_step(), to the end of the window.
+ *   Call it right before lwm2m_step().
+ *
+ ****************************************************************************/
+
+void lwm2m_batch_step(FAR struct lwm2m_batch_s *batch,
+                      FAR time_t *timeout);
+
+/****************************************************************************
+ * Name: lwm2m_batch_flush
+ *
+ * Description:
+ *   Hand all the pending changes to Wakaama now.
+ *
+ ****************************************************************************/
+
+void lwm2m_batch_flush(FAR struct lwm2m_batch_s *batch);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_NETUTILS_LWM2M_BATCH_H */
@@ -80,6 +80,10 @@ struct md5_context_s
   uint32_t buf[4];
   uint32_t bits[2];
   uint8_t in[64];
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  int fd;                    /* /dev/crypto session, -1 in software */
+  uint32_t ses;
+#endif
 };
 
 typedef struct md5_context_s MD5_CTX;
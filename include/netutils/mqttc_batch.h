@@ -0,0 +1,86 @@
+/****************************************************************************
+ * apps/include/netutils/mqttc_batch.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_NETUTILS_MQTTC_BATCH_H
+#define __APPS_INCLUDE_NETUTILS_MQTTC_BATCH_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mqtt.h>
+
+#ifdef CONFIG_NETUTILS_MQTTC_BATCH
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* A QoS 0 message to publish */
+
+struct mqttc_pubmsg_s
+{
+  FAR const char *topic;    /* Topic name */
+  FAR const void *payload;  /* Application message */
+  size_t len;               /* Length of the application message */
+  uint8_t flags;            /* MQTT_PUBLISH_RETAIN or 0 */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************
+ * Name: mqttc_publish_batch
+ *
+ * Description:
+ *   Publish nmsgs QoS 0 messages with as few socket writes as possible.
+ *   Unlike mqtt_publish(), the messages are not copied to the send buffer
+ *   of the client and are sent before returning: the headers and the
+ *   small payloads are packed together, payloads of
+ *   CONFIG_NETUTILS_MQTTC_ZEROCOPY_THRESHOLD bytes or more are written
+ *   from the buffer of the caller.  Messages already queued on the client
+ *   are sent first.
+ *
+ * Returned Value:
+ *   MQTT_OK on success, or an MQTTErrors value.
+ *
+ ****************************************************************************/
+
+enum MQTTErrors mqttc_publish_batch(FAR struct mqtt_client *client,
+                                    FAR const struct mqttc_pubmsg_s *msgs,
+                                    int nmsgs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_NETUTILS_MQTTC_BATCH */
+#endif /* __APPS_INCLUDE_NETUTILS_MQTTC_BATCH_H */
@@ -102,6 +102,27 @@ extern "C"
 
 int netinit_bringup(void);
 
+/****************************************************************************
+ * Name: netinit_wait
+ *
+ * Description:
+ *   Wait until the network brought up by the netinit thread is usable:
+ *   the interface is up and has its addresses, from DHCP, from the cached
+ *   lease of the last boot, or from the configuration.  Applications that
+ *   need the network call this instead of delaying the whole boot.
+ *
+ * Input Parameters:
+ *   timeout_ms - Maximum time to wait, negative to wait forever.
+ *
+ * Returned Value:
+ *   Zero (OK) when the network is usable; -ETIMEDOUT on timeout.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETINIT_THREAD
+int netinit_wait(int timeout_ms);
+#endif
+
 /****************************************************************************
  * Name: netinit_associate
  ****************************************************************************/
@@ -148,6 +148,51 @@ struct url_s
 };
 #endif
 
+#ifdef CONFIG_NETUTILS_NETLIB_TCPSERVER
+/* Threading models of netlib_tcpserver_start() */
+
+enum netlib_tcpserver_model_e
+{
+  NETLIB_TCPSERVER_POOL  = 0,     /* Blocking handler on a thread pool */
+  NETLIB_TCPSERVER_EVENT = 1      /* Callbacks from epoll event loops */
+};
+
+struct netlib_tcpserver_s;        /* Opaque server */
+struct netlib_tcpconn_s;          /* Opaque event model connection */
+
+/* Describes a server to netlib_tcpserver_start().  The callbacks of the
+ * event model return a negative value to close the connection.
+ */
+
+struct netlib_tcpserver_cfg_s
+{
+  uint16_t portno;                /* Port to listen on (network order) */
+  uint8_t  model;                 /* enum netlib_tcpserver_model_e */
+  uint8_t  nthreads;              /* Pool threads or event loops, 0 for
+                                   * one per CPU */
+  int      stacksize;             /* Thread stack size, 0 for default */
+  int      maxconns;              /* Connections accepted at once, 0 for
+                                   * no limit.  Further connections wait
+                                   * in the listen backlog. */
+  unsigned int idle_ms;           /* Event model: timer armed on accept
+                                   * and on each read, 0 for none */
+  FAR void *arg;                  /* Passed to the callbacks */
+
+  /* NETLIB_TCPSERVER_POOL: serve a connection, the socket is closed on
+   * return
+   */
+
+  CODE void (*handler)(int sd, FAR void *arg);
+
+  /* NETLIB_TCPSERVER_EVENT: on_read is required */
+
+  CODE int  (*on_open)(FAR struct netlib_tcpconn_s *conn, FAR void *arg);
+  CODE int  (*on_read)(FAR struct netlib_tcpconn_s *conn, FAR void *arg);
+  CODE int  (*on_timer)(FAR struct netlib_tcpconn_s *conn, FAR void *arg);
+  CODE void (*on_close)(FAR struct netlib_tcpconn_s *conn, FAR void *arg);
+};
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -340,10 +385,15 @@ enum nf_inet_hooks;  /* Forward reference */
 
 FAR struct ipt_replace *netlib_ipt_prepare(FAR const char *table);
 int netlib_ipt_commit(FAR const struct ipt_replace *repl);
+int netlib_ipt_clear(FAR struct ipt_replace *repl, enum nf_inet_hooks hook);
 int netlib_ipt_flush(FAR const char *table, enum nf_inet_hooks hook);
 int netlib_ipt_append(FAR struct ipt_replace **repl,
                       FAR const struct ipt_entry *entry,
                       enum nf_inet_hooks hook);
+int netlib_ipt_append_entries(FAR struct ipt_replace **repl,
+                              FAR const void *entries, size_t size,
+                              unsigned int nentries,
+                              enum nf_inet_hooks hook);
 int netlib_ipt_insert(FAR struct ipt_replace **repl,
                       FAR const struct ipt_entry *entry,
                       enum nf_inet_hooks hook, int rulenum);
@@ -371,6 +421,20 @@ int netlib_listenon(uint16_t portno);
 void netlib_server(uint16_t portno, pthread_startroutine_t handler,
                    int stacksize);
 
+#ifdef CONFIG_NETUTILS_NETLIB_TCPSERVER
+/* Server framework with a choice of threading models */
+
+FAR struct netlib_tcpserver_s *
+netlib_tcpserver_start(FAR const struct netlib_tcpserver_cfg_s *cfg);
+void netlib_tcpserver_stop(FAR struct netlib_tcpserver_s *srv);
+int netlib_tcpconn_fd(FAR struct netlib_tcpconn_s *conn);
+FAR void *netlib_tcpconn_priv(FAR struct netlib_tcpconn_s *conn);
+void netlib_tcpconn_setpriv(FAR struct netlib_tcpconn_s *conn,
+                            FAR void *priv);
+void netlib_tcpconn_settimer(FAR struct netlib_tcpconn_s *conn,
+                             unsigned int ms);
+#endif
+
 int netlib_getifstatus(FAR const char *ifname, FAR uint8_t *flags);
 int netlib_ifup(FAR const char *ifname);
 int netlib_ifdown(FAR const char *ifname);
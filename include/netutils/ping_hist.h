@@ -0,0 +1,86 @@
+/****************************************************************************
+ * apps/include/netutils/ping_hist.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_NETUTILS_PING_HIST_H
+#define __APPS_INCLUDE_NETUTILS_PING_HIST_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* 1 us buckets below 16 us, then 8 buckets per power of two (12.5%
+ * resolution) up to the full 32 bit range.
+ */
+
+#define PING_HIST_BUCKETS  240
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Round trip time histogram in microseconds */
+
+struct ping_hist_s
+{
+  uint32_t count;                      /* Round trips recorded */
+  uint32_t bucket[PING_HIST_BUCKETS];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#undef EXTERN
+#if defined(__cplusplus)
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/* Record one round trip time */
+
+void ping_hist_add(FAR struct ping_hist_s *hist, uint32_t usec);
+
+/* Round trip time in microseconds below which permille of the round trips
+ * fall, as the upper bound of its bucket
+ */
+
+uint32_t ping_hist_percentile(FAR const struct ping_hist_s *hist,
+                              unsigned int permille);
+
+/* Print the percentiles, and the non-empty buckets if verbose */
+
+void ping_hist_print(FAR const struct ping_hist_s *hist, bool verbose);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_NETUTILS_PING_HIST_H */
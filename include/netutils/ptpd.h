@@ -33,6 +33,27 @@
  * Public Types
  ****************************************************************************/
 
+/* PTPD start options for ptpd_start_config() */
+
+struct ptpd_config_s
+{
+  /* Name of the network interface to bind to, e.g. "eth0" */
+
+  FAR const char *interface;
+
+  /* IPv4 address of the server to request unicast messages from
+   * (CONFIG_NETUTILS_PTPD_UNICAST), or NULL to use multicast.
+   */
+
+  FAR const char *unicast_server;
+
+  /* Interface of the second, master port of a boundary clock
+   * (CONFIG_NETUTILS_PTPD_BOUNDARY), or NULL for an ordinary clock.
+   */
+
+  FAR const char *master_port;
+};
+
 /* PTPD status information structure */
 
 struct ptpd_status_s
@@ -126,6 +147,23 @@ extern "C"
 
 int ptpd_start(FAR const char *interface);
 
+/****************************************************************************
+ * Name: ptpd_start_config
+ *
+ * Description:
+ *   Start the PTP daemon with unicast or boundary clock options.
+ *
+ * Input Parameters:
+ *   config - Start options, only needed during the call
+ *
+ * Returned Value:
+ *   On success, the non-negative task ID of the PTP daemon is returned;
+ *   On failure, a negated errno value is returned.
+ *
+ ****************************************************************************/
+
+int ptpd_start_config(FAR const struct ptpd_config_s *config);
+
 /****************************************************************************
  * Name: ptpd_status
  *
@@ -0,0 +1,79 @@
+/****************************************************************************
+ * apps/include/netutils/sha1.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_NETUTILS_SHA1_H
+#define __APPS_INCLUDE_NETUTILS_SHA1_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef CONFIG_CODECS_HASH_SHA1
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define SHA1_DIGEST_SIZE 20
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct sha1_context_s
+{
+  uint32_t state[5];
+  uint64_t count;            /* Bytes hashed so far */
+  uint8_t  buffer[64];       /* Partial block */
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  int      fd;               /* /dev/crypto session, -1 in software */
+  uint32_t ses;
+#endif
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+void sha1_init(FAR struct sha1_context_s *ctx);
+void sha1_update(FAR struct sha1_context_s *ctx, FAR const void *buf,
+                 size_t len);
+void sha1_final(FAR uint8_t digest[SHA1_DIGEST_SIZE],
+                FAR struct sha1_context_s *ctx);
+
+void sha1_sum(FAR const uint8_t *addr, size_t len, FAR uint8_t *mac);
+int  sha1_file(FAR const char *path, FAR uint8_t *mac);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_CODECS_HASH_SHA1 */
+#endif /* __APPS_INCLUDE_NETUTILS_SHA1_H */
@@ -51,6 +51,15 @@
  * Type Definitions
  ****************************************************************************/
 
+/* A file attached to a message by smtp_send_attachments() */
+
+struct smtp_attachment_s
+{
+  FAR const char *path;  /* File to send */
+  FAR const char *name;  /* Name given to the receiver, NULL: basename */
+  FAR const char *type;  /* MIME type, NULL: application/octet-stream */
+};
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -73,6 +82,14 @@ void  smtp_configure(FAR void *handle, FAR const char *hostname,
 int   smtp_send(FAR void *handle, FAR const char *to, FAR const char *cc,
                 FAR const char *from, FAR const char *subject,
                 FAR const char *msg, int msglen);
+int   smtp_send_attachments(FAR void *handle, FAR const char *to,
+                            FAR const char *cc, FAR const char *from,
+                            FAR const char *subject, FAR const char *msg,
+                            int msglen,
+                            FAR const struct smtp_attachment_s *attach,
+                            int nattach);
+int   smtp_connect(FAR void *handle);
+void  smtp_disconnect(FAR void *handle);
 void  smtp_close(FAR void *handle);
 
 #undef EXTERN
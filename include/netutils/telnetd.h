@@ -52,6 +52,12 @@ struct telnetd_config_s
   main_t            t_entry;     /* The entrypoint of the task to spawn when a new
                                   * connection is accepted. */
 #endif
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+  main_t            t_session;   /* The entrypoint run by the pooled session
+                                  * tasks for each connection.  It must
+                                  * return at the end of the session.  The
+                                  * pool is not used if NULL. */
+#endif
 #ifdef CONFIG_LIBC_EXECFUNCS
   FAR const char   *t_path;      /* The binary path of the task to spawn when a new
                                   * connection is accepted. */
@@ -51,6 +51,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -120,6 +121,21 @@
  */
 #define WEBCLIENT_FLAG_TUNNEL 2U
 
+/* WEBCLIENT_FLAG_GZIP: Accept a compressed response body
+ *
+ * If WEBCLIENT_FLAG_GZIP is set, the request advertises
+ * "Accept-Encoding: gzip, deflate" and a response body with such a
+ * Content-Encoding is inflated before it is handed to the sink, in pieces
+ * of a few hundred bytes.  The sink callback can't swap the buffer of
+ * such pieces.  Requires CONFIG_WEBCLIENT_GZIP.
+ *
+ * To upload a compressed body, deflate it with the zstream_*() API of
+ * apps/include/system/zstream.h (ZSTREAM_DEFLATE | ZSTREAM_GZIP) and add
+ * a "Content-Encoding: gzip" header.
+ */
+
+#define WEBCLIENT_FLAG_GZIP 4U
+
 /* The following WEBCLIENT_FLAG_xxx constants are for
  * webclient_poll_info::flags.
  */
@@ -127,6 +143,21 @@
 #define WEBCLIENT_POLL_INFO_WANT_READ  1U
 #define WEBCLIENT_POLL_INFO_WANT_WRITE 2U
 
+/* The following WEBCLIENT_MULTI_FLAG_xxx constants are for
+ * webclient_multi_init().
+ */
+
+/* WEBCLIENT_MULTI_FLAG_PIPELINE: Queue requests per server
+ *
+ * If this flag is set, requests to the same scheme, host and port are
+ * performed one after another instead of in parallel.  With
+ * CONFIG_WEBCLIENT_CONNPOOL, each of them is sent on the persistent
+ * HTTP/1.1 connection used by its predecessor, so that a batch of
+ * requests to one server costs a single connection.
+ */
+
+#define WEBCLIENT_MULTI_FLAG_PIPELINE 1U
+
 /****************************************************************************
  * Public types
  ****************************************************************************/
@@ -437,6 +468,18 @@ struct webclient_context
    *                       NULL means no https support.
    *   tls_ctx           - A user pointer to be passed to tls_ops as it is.
    *   flags             - OR'ed WEBCLIENT_FLAG_xxx values.
+   *   body_iov          - The request body as a list of buffers that are
+   *                       sent as they are.  Set with
+   *                       webclient_set_iov_body().
+   *   body_iovcnt       - The number of elements in body_iov.
+   *   body_fd           - A file descriptor to read the request body
+   *                       from, starting at its current position.  Set
+   *                       with webclient_set_fd_body().  For plain http,
+   *                       the body is sent with sendfile().
+   *   sink_fd           - If not negative, the response body is written
+   *                       to this file descriptor as it is received and
+   *                       sink_callback/callback are not used.  The
+   *                       default is -1.
    */
 
   FAR char *buffer;
@@ -451,6 +494,10 @@ struct webclient_context
   FAR const struct webclient_tls_ops *tls_ops;
   FAR void *tls_ctx;
   unsigned int flags;
+  FAR const struct iovec *body_iov;
+  unsigned int body_iovcnt;
+  int body_fd;
+  int sink_fd;
 
   /* results
    *
@@ -489,6 +536,38 @@ struct webclient_poll_info
   unsigned int flags; /* OR'ed WEBCLIENT_POLL_INFO_xxx flags */
 };
 
+#ifdef CONFIG_WEBCLIENT_MULTI
+/* webclient_multi_run() calls a user provided function of the following
+ * type when a request has finished.  result is the return value of the
+ * final webclient_perform() call, or -ETIMEDOUT if the request did not
+ * finish within webclient_context::timeout_sec.  The context is no
+ * longer owned by the engine and may be reused or added again.
+ */
+
+typedef CODE void (*webclient_multi_done_t)(
+    FAR struct webclient_context *ctx, int result, FAR void *arg);
+
+struct webclient_multi_entry_s
+{
+  FAR struct webclient_context *ctx; /* NULL if the slot is free */
+  webclient_multi_done_t done;
+  FAR void *arg;
+  uint32_t seqno;                    /* Order of webclient_multi_add() */
+  uint32_t deadline;                 /* Monotonic msec, if timeout_sec */
+  bool started;
+};
+
+/* A set of requests driven by a single thread with webclient_multi_run() */
+
+struct webclient_multi_s
+{
+  unsigned int flags;                /* WEBCLIENT_MULTI_FLAG_xxx */
+  unsigned int nentries;
+  uint32_t seqno;
+  struct webclient_multi_entry_s entries[CONFIG_WEBCLIENT_MULTI_MAX];
+};
+#endif
+
 struct webclient_conn_s
 {
   bool tls;
@@ -564,6 +643,11 @@ void webclient_abort(FAR struct webclient_context *ctx);
 void webclient_set_static_body(FAR struct webclient_context *ctx,
                                FAR const void *body,
                                size_t bodylen);
+void webclient_set_iov_body(FAR struct webclient_context *ctx,
+                            FAR const struct iovec *iov,
+                            unsigned int iovcnt);
+void webclient_set_fd_body(FAR struct webclient_context *ctx,
+                           int fd, size_t bodylen);
 int webclient_get_poll_info(FAR struct webclient_context *ctx,
                             FAR struct webclient_poll_info *info);
 void webclient_get_tunnel(FAR struct webclient_context *ctx,
@@ -576,6 +660,22 @@ ssize_t webclient_conn_recv(FAR struct webclient_conn_s *conn,
 void webclient_conn_close(FAR struct webclient_conn_s *conn);
 void webclient_conn_free(FAR struct webclient_conn_s *conn);
 
+#ifdef CONFIG_WEBCLIENT_CONNPOOL
+void webclient_pool_flush(void);
+#endif
+
+#ifdef CONFIG_WEBCLIENT_MULTI
+void webclient_multi_init(FAR struct webclient_multi_s *multi,
+                          unsigned int flags);
+int webclient_multi_add(FAR struct webclient_multi_s *multi,
+                        FAR struct webclient_context *ctx,
+                        webclient_multi_done_t done, FAR void *arg);
+void webclient_multi_remove(FAR struct webclient_multi_s *multi,
+                            FAR struct webclient_context *ctx);
+int webclient_multi_run(FAR struct webclient_multi_s *multi,
+                        int timeout_ms);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -96,6 +96,7 @@ struct xmlrpc_s
   int   argsize;
   int   arg;
   char  response[MAX_RESPONSE];
+  int   responselen;
   int   error;
 };
 
@@ -147,6 +147,26 @@ int nsh_consolemain(int argc, FAR char *argv[]);
 
 int nsh_telnetmain(int argc, FAR char *argv[]);
 
+/****************************************************************************
+ * Name: nsh_telnetsession
+ *
+ * Description:
+ *   Like nsh_telnetmain() but returns at the end of the session, also when
+ *   the session ends with the exit command or a failed login.  This is the
+ *   t_session entry point of the Telnet daemon session pool.
+ *
+ * Input Parameters:
+ *   Standard task start-up arguments.
+ *
+ * Returned Values:
+ *   The exit status of the session.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+int nsh_telnetsession(int argc, FAR char *argv[]);
+#endif
+
 /****************************************************************************
  * Name: nsh_telnetstart
  *
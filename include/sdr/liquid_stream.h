@@ -0,0 +1,130 @@
+/****************************************************************************
+ * apps/include/sdr/liquid_stream.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_SDR_LIQUID_STREAM_H
+#define __APPS_INCLUDE_SDR_LIQUID_STREAM_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <liquid.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Block callback, called from the worker thread for each captured buffer.
+ *
+ *   in     - nin frames of 16-bit samples as written by the capture DMA,
+ *            interleaved I/Q when the capture device has two channels
+ *   out    - The playback buffer to fill in place with up to maxout frames,
+ *            or NULL when the stream has no output device
+ *
+ * Returns the number of frames written to out, or a negative value to
+ * stop the stream.  Both buffers are lent to the callback and go back to
+ * the drivers when it returns, they must not be kept.
+ */
+
+typedef CODE int (*liquid_stream_cb_t)(FAR void *arg,
+                                       FAR const int16_t *in, size_t nin,
+                                       FAR int16_t *out, size_t maxout);
+
+struct liquid_stream_config_s
+{
+  FAR const char *indev;        /* Capture device, e.g. /dev/audio/pcm0c */
+  uint32_t inrate;              /* Capture sample rate */
+  uint8_t inchannels;           /* 2 for complex baseband */
+
+  FAR const char *outdev;       /* Playback device or NULL */
+  uint32_t outrate;             /* Playback sample rate */
+  uint8_t outchannels;
+
+  liquid_stream_cb_t process;
+  FAR void *arg;
+};
+
+struct liquid_stream_s;
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************
+ * Name: liquid_stream_start
+ *
+ * Description:
+ *   Open and configure the devices, queue the driver allocated buffers and
+ *   start the worker thread running the callback.
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int liquid_stream_start(FAR struct liquid_stream_s **stream,
+                        FAR const struct liquid_stream_config_s *config);
+
+/****************************************************************************
+ * Name: liquid_stream_stop
+ *
+ * Description:
+ *   Stop the devices, wait for the worker thread and release everything.
+ *
+ ****************************************************************************/
+
+int liquid_stream_stop(FAR struct liquid_stream_s *stream);
+
+/****************************************************************************
+ * Name: liquid_stream_s16tocf
+ *
+ * Description:
+ *   Convert n interleaved 16-bit I/Q frames to complex samples in [-1, 1).
+ *
+ ****************************************************************************/
+
+void liquid_stream_s16tocf(FAR const int16_t *in,
+                           FAR liquid_float_complex *out, size_t n);
+
+/****************************************************************************
+ * Name: liquid_stream_ftos16
+ *
+ * Description:
+ *   Convert n real samples in [-1, 1] to saturated 16-bit samples.
+ *
+ ****************************************************************************/
+
+void liquid_stream_ftos16(FAR const float *in, FAR int16_t *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_SDR_LIQUID_STREAM_H */
@@ -0,0 +1,148 @@
+/****************************************************************************
+ * apps/include/system/fdtidx.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_SYSTEM_FDTIDX_H
+#define __APPS_INCLUDE_SYSTEM_FDTIDX_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* An index of a flattened device tree, built in one pass over the blob:
+ * the nodes in blob order with their parents and properties, a hash
+ * table of the nodes by parent and name, and the phandles sorted.  The
+ * lookups then cost a hash probe per path component or a binary search
+ * instead of a scan of the blob from the root.
+ *
+ * The offsets taken and returned are the libfdt ones, so the results can
+ * be mixed with libfdt calls.  The index describes the blob as it was
+ * when it was built; it must be dropped with fdtidx_put() before the blob
+ * is modified.
+ */
+
+struct fdtidx_s;
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: fdtidx_get
+ *
+ * Description:
+ *   Return the index of the blob fdt, building it on the first call for
+ *   this blob.  The index is shared by the callers until fdtidx_put().
+ *
+ * Returned Value:
+ *   The index; NULL if the blob is invalid or memory ran out.
+ *
+ ****************************************************************************/
+
+FAR struct fdtidx_s *fdtidx_get(FAR const void *fdt);
+
+/****************************************************************************
+ * Name: fdtidx_put
+ *
+ * Description:
+ *   Free the index of the blob fdt, so that the next fdtidx_get() builds
+ *   it again.  Call it before modifying or freeing the blob.
+ *
+ ****************************************************************************/
+
+void fdtidx_put(FAR const void *fdt);
+
+/****************************************************************************
+ * Name: fdtidx_path_offset
+ *
+ * Description:
+ *   Same as fdt_path_offset(): a path from the root or starting with an
+ *   alias.  A component without unit address matches the first node with
+ *   that name and any unit address.
+ *
+ ****************************************************************************/
+
+int fdtidx_path_offset(FAR struct fdtidx_s *idx, FAR const char *path);
+
+/****************************************************************************
+ * Name: fdtidx_subnode_offset
+ *
+ * Description:
+ *   Same as fdt_subnode_offset().
+ *
+ ****************************************************************************/
+
+int fdtidx_subnode_offset(FAR struct fdtidx_s *idx, int parentoffset,
+                          FAR const char *name);
+
+/****************************************************************************
+ * Name: fdtidx_parent_offset
+ *
+ * Description:
+ *   Same as fdt_parent_offset(), which scans the blob from the root.
+ *
+ ****************************************************************************/
+
+int fdtidx_parent_offset(FAR struct fdtidx_s *idx, int nodeoffset);
+
+/****************************************************************************
+ * Name: fdtidx_node_offset_by_phandle
+ *
+ * Description:
+ *   Same as fdt_node_offset_by_phandle().
+ *
+ ****************************************************************************/
+
+int fdtidx_node_offset_by_phandle(FAR struct fdtidx_s *idx,
+                                  uint32_t phandle);
+
+/****************************************************************************
+ * Name: fdtidx_getprop
+ *
+ * Description:
+ *   Same as fdt_getprop(), from the properties of the node recorded in
+ *   the index.
+ *
+ ****************************************************************************/
+
+FAR const void *fdtidx_getprop(FAR struct fdtidx_s *idx, int nodeoffset,
+                               FAR const char *name, FAR int *lenp);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_SYSTEM_FDTIDX_H */
@@ -0,0 +1,181 @@
+/****************************************************************************
+ * apps/include/system/lzfstream.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_SYSTEM_LZFSTREAM_H
+#define __APPS_INCLUDE_SYSTEM_LZFSTREAM_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <lzf.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define LZF_STREAM_COMPRESS    0
+#define LZF_STREAM_DECOMPRESS  1
+
+/* Largest block size of the lzf block format */
+
+#define LZF_STREAM_MAXBLOCK    65535
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* State of a stream.  The members are private to lzf_stream.c.
+ *
+ * A stream turns data pushed with lzf_stream_push() into data pulled with
+ * lzf_stream_pull(), in the block format of the lzf tool.  Compressed
+ * streams can be decompressed with 'lzf -d' and vice versa.
+ */
+
+struct lzf_stream_s
+{
+  uint8_t  mode;                /* LZF_STREAM_COMPRESS/DECOMPRESS */
+  bool     alloc;               /* mem was allocated by lzf_stream_init() */
+  bool     flush;               /* lzf_stream_finish() was called */
+  bool     eof;                 /* End of stream marker seen */
+  int      error;               /* Sticky negated errno value */
+  size_t   blocksize;
+
+  FAR void *mem;
+  FAR lzf_state_t *htab;        /* Compressor hash table */
+  FAR uint8_t *inbuf;           /* Input block being collected */
+  size_t   inlen;
+  size_t   inneed;              /* Decompressor: bytes of the block */
+  FAR uint8_t *outbuf;
+  FAR uint8_t *outptr;          /* Output not pulled yet */
+  size_t   outlen;
+
+  /* Decompressor: header of the block being collected */
+
+  uint8_t  hdr[LZF_MAX_HDR_SIZE];
+  uint8_t  hdrlen;
+  uint16_t cs;                  /* Compressed size, 0 if stored */
+  uint16_t us;                  /* Uncompressed size */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: lzf_stream_memsize
+ *
+ * Description:
+ *   Return the number of bytes of memory a stream uses.  This is all the
+ *   memory it ever uses.
+ *
+ ****************************************************************************/
+
+size_t lzf_stream_memsize(int mode, size_t blocksize);
+
+/****************************************************************************
+ * Name: lzf_stream_init
+ *
+ * Description:
+ *   Initialize a stream.  blocksize is the size of the blocks that are
+ *   compressed, or the largest block that can be decompressed.  mem is
+ *   lzf_stream_memsize() bytes that the stream uses, or NULL to have them
+ *   allocated.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int lzf_stream_init(FAR struct lzf_stream_s *stream, int mode,
+                    size_t blocksize, FAR void *mem);
+
+/****************************************************************************
+ * Name: lzf_stream_push
+ *
+ * Description:
+ *   Feed input to the stream.  Less than len bytes are taken if output is
+ *   waiting to be pulled.
+ *
+ * Returned Value:
+ *   The number of bytes taken; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t lzf_stream_push(FAR struct lzf_stream_s *stream,
+                        FAR const void *buf, size_t len);
+
+/****************************************************************************
+ * Name: lzf_stream_pull
+ *
+ * Description:
+ *   Take output from the stream.
+ *
+ * Returned Value:
+ *   The number of bytes copied to buf, zero if more input is needed (or,
+ *   after lzf_stream_finish(), at the end of the stream); a negated errno
+ *   value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t lzf_stream_pull(FAR struct lzf_stream_s *stream,
+                        FAR void *buf, size_t len);
+
+/****************************************************************************
+ * Name: lzf_stream_finish
+ *
+ * Description:
+ *   Mark the end of the input.  The compressor then emits its partial
+ *   block on the following lzf_stream_pull() calls.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -EINVAL if the input of the decompressor ended
+ *   within a block.
+ *
+ ****************************************************************************/
+
+int lzf_stream_finish(FAR struct lzf_stream_s *stream);
+
+/****************************************************************************
+ * Name: lzf_stream_deinit
+ ****************************************************************************/
+
+void lzf_stream_deinit(FAR struct lzf_stream_s *stream);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_SYSTEM_LZFSTREAM_H */
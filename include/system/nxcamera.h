@@ -70,6 +70,13 @@ struct nxcamera_s
   size_t                nbuffers;                    /* Number of buffers */
   FAR size_t            *buf_sizes;                  /* Buffer lengths */
   FAR uint8_t           **bufs;                      /* Buffer pointers */
+  FAR uint8_t           *convbuf;                    /* Conversion buffer */
+#ifdef CONFIG_NXCAMERA_ZEROCOPY
+  bool                  zerocopy;                    /* Capturing into the
+                                                      * framebuffer */
+  size_t                fbpages;                     /* Framebuffer pages */
+  int                   displayed;                   /* Buffer on screen */
+#endif
 };
 
 struct video_msg_s
@@ -29,6 +29,9 @@
 
 #include <mqueue.h>
 #include <pthread.h>
+#include <semaphore.h>
+
+#include <nuttx/audio/audio.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -67,6 +70,24 @@ struct nxlooper_s
 #ifndef CONFIG_AUDIO_EXCLUDE_VOLUME
   uint16_t        volume;                      /* Volume as a whole percentage (0-100) */
 #endif
+
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+  uint32_t        period;                      /* Requested period in frames,
+                                                * 0 for the driver's */
+  uint8_t         nbuffers;                    /* Requested periods queued */
+  uint8_t         nchannels;                   /* Configured channels */
+  uint8_t         bpsamp;                      /* Configured bits per sample */
+  uint8_t         framesize;                   /* Bytes per frame */
+  uint32_t        samprate;                    /* Configured sample rate */
+  struct ap_buffer_info_s recordinfo;          /* Negotiated record buffers */
+  struct ap_buffer_info_s playinfo;            /* Negotiated play buffers */
+#endif
+
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+  int             latency_state;               /* Measurement in progress */
+  int32_t         latency;                     /* Result in usec or -errno */
+  sem_t           latency_sem;                 /* Posted with the result */
+#endif
 };
 
 /****************************************************************************
@@ -187,6 +208,51 @@ int nxlooper_loopback(FAR struct nxlooper_s *plooper, int format,
                       uint8_t nchannels, uint8_t bpsamp,
                       uint32_t samprate, uint8_t chmap);
 
+/****************************************************************************
+ * Name: nxlooper_setperiod
+ *
+ *   Sets the period, in frames, and the number of periods queued on each
+ *   device that the next loopback asks the devices for.  A device that
+ *   does not accept the period gets the next larger power of two multiple
+ *   of it that it does accept.
+ *
+ * Input Parameters:
+ *   plooper   - Pointer to the context
+ *   frames    - Period in frames, 0 to use the drivers' defaults
+ *   nbuffers  - Number of periods queued on each device, at least 2
+ *
+ * Returned Value:
+ *   OK, or -EBUSY if a loopback is running.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+int nxlooper_setperiod(FAR struct nxlooper_s *plooper, uint32_t frames,
+                       uint8_t nbuffers);
+#endif
+
+/****************************************************************************
+ * Name: nxlooper_latency
+ *
+ *   Measures the round-trip latency of the running loopback: from handing
+ *   a pulse to the play device to getting it back from the record device.
+ *
+ * Input Parameters:
+ *   plooper   - Pointer to the context
+ *   usec      - Returned latency in microseconds
+ *
+ * Returned Value:
+ *   OK         Latency measured
+ *   -EAGAIN    The loopback is not running
+ *   -ENOSYS    The sample format is not supported
+ *   -ETIMEDOUT The pulse was not detected
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+int nxlooper_latency(FAR struct nxlooper_s *plooper, FAR uint32_t *usec);
+#endif
+
 /****************************************************************************
  * Name: nxlooper_stop
  *
@@ -553,6 +553,26 @@ int nxplayer_fill_mp3(int fd, FAR struct ap_buffer_s *apb);
 
 int nxplayer_fill_common(int fd, FAR struct ap_buffer_s *apb);
 
+/****************************************************************************
+ * Name: nxplayer_openstream
+ *
+ *   Starts receiving a connected http stream through the jitter buffer on
+ *   its own thread.  The player is held, rather than stopped, while the
+ *   buffer refills after the network falls behind.
+ *
+ * Input Parameters:
+ *   sockfd    The connection, positioned after the response header.  It is
+ *             closed when the stream ends.
+ *
+ * Returned Value:
+ *   The read end of a pipe carrying the stream; -1 on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXPLAYER_HTTP_JITTER_BUFFER
+int nxplayer_openstream(int sockfd);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -0,0 +1,179 @@
+/****************************************************************************
+ * apps/include/system/psmq_shm.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_SYSTEM_PSMQ_SHM_H
+#define __APPS_INCLUDE_SYSTEM_PSMQ_SHM_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* A payload pool is a ring of fixed size slots in a shared memory object.
+ * The publisher writes a payload once into a slot and publishes only its
+ * descriptor, with psmq or any other queue; each subscriber reads the
+ * payload in place.  A slot is never reused while a subscriber holds it,
+ * otherwise slots are reused in ring order, so that a subscriber that
+ * falls more than a ring behind gets -ESTALE instead of old data, as with
+ * any sensor topic where only recent samples matter.
+ */
+
+struct psmq_shm_hdr_s;
+
+struct psmq_shm_s
+{
+  FAR struct psmq_shm_hdr_s *hdr;   /* Mapped shared memory object */
+  FAR uint8_t *slots;               /* First slot */
+  size_t       size;                /* Size of the mapping */
+};
+
+/* What is sent to the subscribers in place of the payload.  It is 12
+ * bytes, so that it fits with a short topic in the default PSMQ_MSG_MAX.
+ */
+
+struct psmq_shm_desc_s
+{
+  uint32_t slot;                    /* Slot index */
+  uint32_t seq;                     /* Publish number of the payload */
+  uint32_t len;                     /* Payload length */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: psmq_shm_create
+ *
+ * Description:
+ *   Create the shared memory object name (as for shm_open()) holding
+ *   nslots slots of slotsize bytes, and map it.  The ring should have
+ *   more slots than the descriptors that can be queued for a subscriber.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int psmq_shm_create(FAR struct psmq_shm_s *shm, FAR const char *name,
+                    unsigned int nslots, size_t slotsize);
+
+/****************************************************************************
+ * Name: psmq_shm_open
+ *
+ * Description:
+ *   Map a pool created by psmq_shm_create(), in a subscriber.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int psmq_shm_open(FAR struct psmq_shm_s *shm, FAR const char *name);
+
+/****************************************************************************
+ * Name: psmq_shm_close
+ *
+ * Description:
+ *   Unmap the pool.  The creator removes it with shm_unlink().
+ *
+ ****************************************************************************/
+
+void psmq_shm_close(FAR struct psmq_shm_s *shm);
+
+/****************************************************************************
+ * Name: psmq_shm_slotsize
+ ****************************************************************************/
+
+size_t psmq_shm_slotsize(FAR const struct psmq_shm_s *shm);
+
+/****************************************************************************
+ * Name: psmq_shm_alloc
+ *
+ * Description:
+ *   Take the next free slot of the ring for writing.  desc->slot is set;
+ *   the payload is written to the returned memory, psmq_shm_slotsize()
+ *   bytes, and then released with psmq_shm_commit().
+ *
+ * Returned Value:
+ *   The slot memory; NULL if every slot is being read (errno is EBUSY).
+ *
+ ****************************************************************************/
+
+FAR void *psmq_shm_alloc(FAR struct psmq_shm_s *shm,
+                         FAR struct psmq_shm_desc_s *desc);
+
+/****************************************************************************
+ * Name: psmq_shm_commit
+ *
+ * Description:
+ *   Make the len bytes written to the slot of desc readable.  desc is then
+ *   complete and can be published.
+ *
+ ****************************************************************************/
+
+void psmq_shm_commit(FAR struct psmq_shm_s *shm,
+                     FAR struct psmq_shm_desc_s *desc, size_t len);
+
+/****************************************************************************
+ * Name: psmq_shm_get
+ *
+ * Description:
+ *   Take a reference on the payload of a received descriptor.  The slot is
+ *   not reused until the reference is dropped with psmq_shm_put().
+ *
+ * Returned Value:
+ *   The payload, desc->len bytes; NULL if the slot was already reused
+ *   (errno is ESTALE) or desc is invalid (EINVAL).
+ *
+ ****************************************************************************/
+
+FAR const void *psmq_shm_get(FAR struct psmq_shm_s *shm,
+                             FAR const struct psmq_shm_desc_s *desc);
+
+/****************************************************************************
+ * Name: psmq_shm_put
+ ****************************************************************************/
+
+void psmq_shm_put(FAR struct psmq_shm_s *shm,
+                  FAR const struct psmq_shm_desc_s *desc);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_SYSTEM_PSMQ_SHM_H */
@@ -142,6 +142,19 @@ FAR const struct extmatch_vtable_s *
   readline_extmatch(FAR const struct extmatch_vtable_s *vtbl);
 #endif
 
+/****************************************************************************
+ * Name: readline_history_save
+ *
+ *   Write the command line history to CONFIG_READLINE_CMD_HISTORY_FILE if
+ *   it has changed since it was last saved.  Call this before a power
+ *   cycle or reboot so that the last commands are not lost.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_READLINE_CMD_HISTORY_PERSIST
+void readline_history_save(void);
+#endif
+
 /****************************************************************************
  * Name: readline_fd
  *
@@ -0,0 +1,211 @@
+/****************************************************************************
+ * apps/include/system/serxfer.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_SYSTEM_SERXFER_H
+#define __APPS_INCLUDE_SYSTEM_SERXFER_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <time.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Values of serxfer_esc_s::map[] other than the escaped value */
+
+#define SERXFER_ESC_NONE   0  /* Not escaped */
+#define SERXFER_ESC_LEAD   1  /* Escaped as ch ^ 0x40, only after lead */
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Statistics of a transfer.  The protocol counts its own retries. */
+
+struct serxfer_stats_s
+{
+  size_t       rxbytes;         /* Bytes read from the line */
+  size_t       txbytes;         /* Bytes written to the line */
+  unsigned int rxcalls;         /* read() calls that returned data */
+  unsigned int txcalls;         /* write() calls */
+  unsigned int timeouts;        /* Reads that timed out */
+  unsigned int retries;         /* Retransmissions */
+  struct timespec start;        /* When serxfer_init() was called */
+};
+
+/* The line of one transfer.  The members are private to serxfer.c, only
+ * stats may be updated by the protocol.
+ */
+
+struct serxfer_s
+{
+  int          rxfd;            /* Read from the remote end */
+  int          txfd;            /* Written to the remote end */
+  FAR uint8_t *buf;             /* Read-ahead buffer, may be NULL */
+  size_t       bufsize;
+  size_t       head;            /* Next buffered byte */
+  size_t       tail;            /* End of the buffered bytes */
+  struct serxfer_stats_s stats;
+};
+
+/* Escaping of a byte stream.  map[ch] is the value that follows the escape
+ * character in place of ch, or one of SERXFER_ESC_NONE/LEAD.
+ */
+
+struct serxfer_esc_s
+{
+  uint8_t      esc;             /* The escape character */
+  uint8_t      lead;            /* See SERXFER_ESC_LEAD, 7 bits */
+  uint8_t      last;            /* Last unescaped character put */
+  uint8_t      map[256];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: serxfer_init
+ *
+ * Description:
+ *   Initialize the line of a transfer and start its statistics.  If buf is
+ *   not NULL, reads smaller than bufsize fetch all the data available into
+ *   buf, so that short protocol reads do not cost a read() each.
+ *
+ ****************************************************************************/
+
+void serxfer_init(FAR struct serxfer_s *xfer, int rxfd, int txfd,
+                  FAR uint8_t *buf, size_t bufsize);
+
+/****************************************************************************
+ * Name: serxfer_read
+ *
+ * Description:
+ *   Read up to len bytes, waiting at most timeout milliseconds (a negative
+ *   timeout waits forever) for the first one.
+ *
+ * Returned Value:
+ *   The number of bytes read, zero at end of file; -ETIMEDOUT if nothing
+ *   arrived in time, or another negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t serxfer_read(FAR struct serxfer_s *xfer, FAR void *buf, size_t len,
+                     int timeout);
+
+/****************************************************************************
+ * Name: serxfer_readall
+ *
+ * Description:
+ *   Read exactly len bytes, waiting at most timeout milliseconds for each
+ *   piece.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ETIMEDOUT, -ENOTCONN at end of file, or another
+ *   negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int serxfer_readall(FAR struct serxfer_s *xfer, FAR void *buf, size_t len,
+                    int timeout);
+
+/****************************************************************************
+ * Name: serxfer_write
+ *
+ * Description:
+ *   Write all of buf to the remote end.
+ *
+ * Returned Value:
+ *   len on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t serxfer_write(FAR struct serxfer_s *xfer, FAR const void *buf,
+                      size_t len);
+
+/****************************************************************************
+ * Name: serxfer_discard
+ *
+ * Description:
+ *   Drop the buffered input and flush the line, after an error.
+ *
+ ****************************************************************************/
+
+void serxfer_discard(FAR struct serxfer_s *xfer);
+
+/****************************************************************************
+ * Name: serxfer_dumpstats
+ *
+ * Description:
+ *   Log the statistics of the transfer so far.
+ *
+ ****************************************************************************/
+
+void serxfer_dumpstats(FAR struct serxfer_s *xfer, FAR const char *name);
+
+/****************************************************************************
+ * Name: serxfer_escinit
+ *
+ * Description:
+ *   Initialize esc with nothing escaped.  The caller then fills in map[].
+ *
+ ****************************************************************************/
+
+void serxfer_escinit(FAR struct serxfer_esc_s *esc, uint8_t escch,
+                     uint8_t lead);
+
+/****************************************************************************
+ * Name: serxfer_escape
+ *
+ * Description:
+ *   Escape src into dest.  Runs of characters that need no escaping are
+ *   copied in one go.  Escaping stops when dest is full.
+ *
+ * Returned Value:
+ *   The number of bytes put into dest.  If nused is not NULL, the number
+ *   of bytes of src taken is returned there.
+ *
+ ****************************************************************************/
+
+size_t serxfer_escape(FAR struct serxfer_esc_s *esc, FAR uint8_t *dest,
+                      size_t destlen, FAR const uint8_t *src, size_t len,
+                      FAR size_t *nused);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_SYSTEM_SERXFER_H */
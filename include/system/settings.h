@@ -73,6 +73,14 @@ typedef struct
   int (*save_fn)(FAR char *file);
 } storage_t;
 
+/* A setting looked up with settings_gethandle() */
+
+typedef struct
+{
+  uint16_t idx;           /* Position in the settings map */
+  uint16_t gen;           /* Validity, changed by settings_clear() */
+} settings_handle_t;
+
 struct notify_s
 {
   pid_t pid;
@@ -83,6 +91,7 @@ enum storage_type_e
 {
   STORAGE_BINARY = 0,
   STORAGE_TEXT,
+  STORAGE_LOG,          /* Append-only, needs CONFIG_SYSTEM_SETTINGS_LOG */
 };
 
 /****************************************************************************
@@ -302,5 +311,65 @@ int settings_set(FAR char *key, FAR enum settings_type_e type, ...);
 
 int settings_iterate(int idx, FAR setting_t *setting);
 
+/****************************************************************************
+ * Name: settings_gethandle
+ *
+ * Description:
+ *    Looks up a setting once, for use with settings_hget() and
+ *    settings_hset().  These do not need to search for the key, which makes
+ *    them the fastest way to access a setting repeatedly.
+ *
+ *    The handle stays valid until settings_clear() is called.
+ *
+ * Input Parameters:
+ *    key         - the key of the setting.
+ *    handle      - pointer to return the handle
+ *
+ * Returned Value:
+ *    Success or negated failure code
+ *
+ ****************************************************************************/
+
+int settings_gethandle(FAR char *key, FAR settings_handle_t *handle);
+
+/****************************************************************************
+ * Name: settings_hget
+ *
+ * Description:
+ *    Gets the value of a setting by handle.  Same as settings_get().
+ *
+ * Input Parameters:
+ *    handle      - the handle of the setting.
+ *    type        - the type of the setting
+ *    ...         - pointer to store the setting value plus, if a string
+ *                  setting, the length of the string to get
+ *
+ * Returned Value:
+ *    Success or negated failure code.  -ESTALE if the settings have been
+ *    cleared since the handle was obtained.
+ *
+ ****************************************************************************/
+
+int settings_hget(settings_handle_t handle, enum settings_type_e type, ...);
+
+/****************************************************************************
+ * Name: settings_hset
+ *
+ * Description:
+ *    Sets the value of a setting by handle.  Same as settings_set().
+ *
+ * Input Parameters:
+ *    handle      - the handle of the setting.
+ *    type        - the type of the setting
+ *    ...         - the new value of the setting.
+ *
+ * Returned Value:
+ *    Success or negated failure code.  -ESTALE if the settings have been
+ *    cleared since the handle was obtained.
+ *
+ ****************************************************************************/
+
+int settings_hset(settings_handle_t handle, enum settings_type_e type, ...);
+
 #endif /* UTILS_SETTINGS_H_ */
 
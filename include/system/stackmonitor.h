@@ -0,0 +1,82 @@
+/****************************************************************************
+ * apps/include/system/stackmonitor.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_SYSTEM_STACKMONITOR_H
+#define __APPS_INCLUDE_SYSTEM_STACKMONITOR_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SYSTEM_STACKMONITOR_MAXTASKS
+#  define CONFIG_SYSTEM_STACKMONITOR_MAXTASKS 32
+#endif
+
+#ifndef CONFIG_SYSTEM_STACKMONITOR_SHM_NAME
+#  define CONFIG_SYSTEM_STACKMONITOR_SHM_NAME "stackmonitor"
+#endif
+
+/****************************************************************************
+ * Public Type Declarations
+ ****************************************************************************/
+
+/* Stack usage of one task, as last sampled */
+
+struct stackmonitor_entry_s
+{
+  pid_t    pid;                 /* 0: unused entry */
+  uint32_t size;                /* Stack size in bytes */
+  uint32_t used;                /* Stack high-water mark in bytes */
+  uint8_t  percent;             /* used * 100 / size */
+  uint8_t  alerted;             /* The alert threshold has been crossed */
+#if CONFIG_TASK_NAME_SIZE > 0
+  char     name[CONFIG_TASK_NAME_SIZE + 1];
+#endif
+};
+
+/* The table that the stack monitor daemon publishes in the shared memory
+ * object CONFIG_SYSTEM_STACKMONITOR_SHM_NAME.  seq is odd while the daemon
+ * updates the table: a reader copies the table and retries if seq was odd
+ * or changed in the meantime.
+ *
+ * A task that writes its pid to watcher receives the signal
+ * CONFIG_SYSTEM_STACKMONITOR_SIGNO with the pid of the task as value each
+ * time a task crosses the alert threshold.
+ */
+
+struct stackmonitor_table_s
+{
+  volatile uint32_t seq;        /* Update sequence number */
+  uint32_t interval;            /* Current sample interval in msec */
+  uint8_t  alert_percent;       /* Alert threshold */
+  volatile pid_t watcher;       /* Task to signal on alerts, 0: none */
+  struct stackmonitor_entry_s entries[CONFIG_SYSTEM_STACKMONITOR_MAXTASKS];
+};
+
+#endif /* __APPS_INCLUDE_SYSTEM_STACKMONITOR_H */
@@ -25,6 +25,7 @@
  * Included Files
  ****************************************************************************/
 
+#include <stddef.h>
 #include <stdint.h>
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/fs/fs.h>
@@ -114,6 +115,15 @@ struct termcurses_ops_s
   /* Terminate  */
 
   CODE int (*terminate)(FAR struct termcurses_s *dev);
+
+  /* Queue text to be displayed at the cursor position */
+
+  CODE int (*write)(FAR struct termcurses_s *dev, FAR const char *buffer,
+                    size_t len);
+
+  /* Send all of the queued output to the terminal */
+
+  CODE int (*flush)(FAR struct termcurses_s *dev);
 };
 
 struct termcurses_dev_s
@@ -239,6 +249,29 @@ int termcurses_getkeycode(FAR struct termcurses_s *term, FAR int *specialkey,
 
 bool termcurses_checkkey(FAR struct termcurses_s *term);
 
+/****************************************************************************
+ * Name: termcurses_write
+ *
+ * Description:
+ *   Queue text to be displayed at the cursor position.  Output, including
+ *   the cursor moves, colors and attributes, may be held until
+ *   termcurses_flush() so that a whole screen update is sent at once.
+ *
+ ****************************************************************************/
+
+int termcurses_write(FAR struct termcurses_s *term, FAR const char *buffer,
+                     size_t len);
+
+/****************************************************************************
+ * Name: termcurses_flush
+ *
+ * Description:
+ *   Send all of the queued output to the terminal.
+ *
+ ****************************************************************************/
+
+int termcurses_flush(FAR struct termcurses_s *term);
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -95,13 +95,21 @@
  * notification is needed to support interruption of the file transfer by
  * the remote receiver.
  *
- * This capapability is not yet supported.  There are only incomplete hooks
- * in the code now!
+ * It is also needed to stream ZCRCG data subpackets.
+ * CONFIG_SYSTEM_ZMODEM_WINDOW is then the number of bytes that may be sent
+ * without acknowledgement, zero meaning no limit.
+ */
+
+#ifndef CONFIG_SYSTEM_ZMODEM_WINDOW
+#  define CONFIG_SYSTEM_ZMODEM_WINDOW 0
+#endif
+
+/* The largest number of file data bytes in one data subpacket.  Subpackets
+ * are also limited by CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE.
  */
 
-#ifdef CONFIG_SYSTEM_ZMODEM_RCVSAMPLE
-#  warning CONFIG_SYSTEM_ZMODEM_RCVSAMPLE not yet supported
-#  undef CONFIG_SYSTEM_ZMODEM_RCVSAMPLE
+#ifndef CONFIG_SYSTEM_ZMODEM_SUBPKTSIZE
+#  define CONFIG_SYSTEM_ZMODEM_SUBPKTSIZE 1024
 #endif
 
 /* CONFIG_SYSTEM_ZMODEM_SENDATTN indicates that the local sender retains
@@ -0,0 +1,204 @@
+/****************************************************************************
+ * apps/include/system/zstream.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_SYSTEM_ZSTREAM_H
+#define __APPS_INCLUDE_SYSTEM_ZSTREAM_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define ZSTREAM_DEFLATE        0
+#define ZSTREAM_INFLATE        1
+
+/* OR'ed with ZSTREAM_DEFLATE: write a gzip instead of a zlib wrapper.  The
+ * inflater always accepts both.
+ */
+
+#define ZSTREAM_GZIP           2
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* State of a stream.  The members are private to zstream.c.
+ *
+ * A stream turns data pushed with zstream_push() into data pulled with
+ * zstream_pull(), like lzf_stream_s but in the zlib or gzip format, so
+ * that it can be used for HTTP Content-Encoding or to produce .gz files.
+ * zlib allocates its state from the memory given to zstream_init(), so
+ * that a stream never touches the heap after its creation.
+ */
+
+struct zstream_s
+{
+  uint8_t  mode;                /* ZSTREAM_DEFLATE/INFLATE | ZSTREAM_GZIP */
+  bool     alloc;               /* mem was allocated by zstream_init() */
+  bool     sync;                /* zstream_flush() output pending */
+  bool     finish;              /* zstream_finish() was called */
+  bool     eof;                 /* End of the compressed stream */
+  int      error;               /* Sticky negated errno value */
+
+  FAR void *mem;
+  FAR void *strm;               /* z_stream of zlib */
+  FAR uint8_t *arena;           /* Memory handed out to zlib */
+  size_t   arenasize;
+  size_t   arenaused;
+  FAR uint8_t *outbuf;
+  FAR uint8_t *outptr;          /* Output not pulled yet */
+  size_t   outlen;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: zstream_memsize
+ *
+ * Description:
+ *   Return the number of bytes of memory a stream uses.  This is all the
+ *   memory it ever uses: about 32 KiB plus the output buffer to inflate,
+ *   which needs the largest window, and much less to deflate with the
+ *   window and memory level of the configuration.
+ *
+ ****************************************************************************/
+
+size_t zstream_memsize(int mode);
+
+/****************************************************************************
+ * Name: zstream_init
+ *
+ * Description:
+ *   Initialize a stream.  mem is zstream_memsize() bytes that the stream
+ *   uses, or NULL to have them allocated.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int zstream_init(FAR struct zstream_s *stream, int mode, FAR void *mem);
+
+/****************************************************************************
+ * Name: zstream_push
+ *
+ * Description:
+ *   Feed input to the stream.  Less than len bytes are taken if output is
+ *   waiting to be pulled.  Input after the end of a compressed stream is
+ *   ignored.
+ *
+ * Returned Value:
+ *   The number of bytes taken; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t zstream_push(FAR struct zstream_s *stream,
+                     FAR const void *buf, size_t len);
+
+/****************************************************************************
+ * Name: zstream_pull
+ *
+ * Description:
+ *   Take output from the stream.
+ *
+ * Returned Value:
+ *   The number of bytes copied to buf, zero if more input is needed (or,
+ *   after zstream_finish(), at the end of the stream); a negated errno
+ *   value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t zstream_pull(FAR struct zstream_s *stream,
+                     FAR void *buf, size_t len);
+
+/****************************************************************************
+ * Name: zstream_flush
+ *
+ * Description:
+ *   Make the compressor emit all of the input pushed so far on the
+ *   following zstream_pull() calls, so that the receiver can decompress it
+ *   without waiting for more.  This is meant for logs and other slow
+ *   producers; each flush costs a few bytes of compression ratio.
+ *
+ ****************************************************************************/
+
+int zstream_flush(FAR struct zstream_s *stream);
+
+/****************************************************************************
+ * Name: zstream_finish
+ *
+ * Description:
+ *   Mark the end of the input.  The compressor then emits the rest of the
+ *   stream on the following zstream_pull() calls.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -EINVAL if the input of the decompressor ended
+ *   before the end of the compressed stream.
+ *
+ ****************************************************************************/
+
+int zstream_finish(FAR struct zstream_s *stream);
+
+/****************************************************************************
+ * Name: zstream_deinit
+ ****************************************************************************/
+
+void zstream_deinit(FAR struct zstream_s *stream);
+
+/****************************************************************************
+ * Name: zstream_gzip_file
+ *
+ * Description:
+ *   Compress the file src to the gzip file dst, for example a log that was
+ *   just rotated.  src is left in place.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure, in which case
+ *   dst is removed.
+ *
+ ****************************************************************************/
+
+int zstream_gzip_file(FAR const char *src, FAR const char *dst);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_SYSTEM_ZSTREAM_H */
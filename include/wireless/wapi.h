@@ -56,6 +56,7 @@
 #include <netinet/in.h>
 #include <sys/socket.h>
 #include <net/ethernet.h>
+#include <time.h>
 #include <nuttx/wireless/wireless.h>
 
 /****************************************************************************
@@ -210,6 +211,19 @@ struct wapi_scan_info_s
   int rssi;
   int has_encode;
   int encode;
+  time_t seen;    /* Last scan that saw the BSS, set by the scan cache */
+};
+
+/* Scan results kept across scans, one entry per BSSID.  A scan, even one
+ * limited to a few channels, updates the BSSs it saw in place and entries
+ * that no scan has seen for maxage seconds are dropped, so that roaming
+ * decisions can look up the cache instead of waiting for a full scan.
+ */
+
+struct wapi_scan_cache_s
+{
+  FAR struct wapi_scan_info_s *head;
+  unsigned int maxage;  /* Seconds; zero keeps entries forever */
 };
 
 /* Linked list container for routing table rows. */
@@ -772,6 +786,93 @@ int wapi_scan_coll(int sock, FAR const char *ifname,
 
 void wapi_scan_coll_free(FAR struct wapi_list_s *aps);
 
+/****************************************************************************
+ * Name: wapi_scan_cache_init
+ *
+ * Description:
+ *   Initialize an empty scan cache whose entries expire after maxage
+ *   seconds.
+ *
+ ****************************************************************************/
+
+void wapi_scan_cache_init(FAR struct wapi_scan_cache_s *cache,
+                          unsigned int maxage);
+
+/****************************************************************************
+ * Name: wapi_scan_cache_update
+ *
+ * Description:
+ *   Merge the results of wapi_scan_coll() into the cache and drop the
+ *   expired entries.  The entries of aps are moved to the cache or freed,
+ *   leaving aps empty.
+ *
+ * Returned Value:
+ *   The number of entries in the cache; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int wapi_scan_cache_update(FAR struct wapi_scan_cache_s *cache,
+                           FAR struct wapi_list_s *aps);
+
+/****************************************************************************
+ * Name: wapi_scan_cache_refresh
+ *
+ * Description:
+ *   Merge the results of a scan started with wapi_escan_channel_init() or
+ *   another wapi_*scan*_init() if it has completed, without waiting.  Call
+ *   it from the main loop of the caller after starting a scan, until it
+ *   stops returning 1.
+ *
+ * Returned Value:
+ *   The number of entries in the cache; 1 if the scan is still running; a
+ *   negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int wapi_scan_cache_refresh(int sock, FAR const char *ifname,
+                            FAR struct wapi_scan_cache_s *cache);
+
+/****************************************************************************
+ * Name: wapi_scan_cache_best
+ *
+ * Description:
+ *   Return the unexpired entry with the strongest signal for essid, or any
+ *   ESSID if essid is NULL.  The entry is valid until the next update.
+ *
+ ****************************************************************************/
+
+FAR const struct wapi_scan_info_s *
+wapi_scan_cache_best(FAR const struct wapi_scan_cache_s *cache,
+                     FAR const char *essid);
+
+/****************************************************************************
+ * Name: wapi_scan_cache_channels
+ *
+ * Description:
+ *   Fill channels with the channels on which the cache has seen essid, or
+ *   any ESSID if essid is NULL, for a partial scan with
+ *   wapi_escan_channel_init() that refreshes the roaming candidates in a
+ *   fraction of the time of a full scan.
+ *
+ * Returned Value:
+ *   The number of channels stored, at most nchannels.
+ *
+ ****************************************************************************/
+
+int wapi_scan_cache_channels(FAR const struct wapi_scan_cache_s *cache,
+                             FAR const char *essid,
+                             FAR uint8_t *channels, int nchannels);
+
+/****************************************************************************
+ * Name: wapi_scan_cache_free
+ *
+ * Description:
+ *   Free all the entries of the cache.
+ *
+ ****************************************************************************/
+
+void wapi_scan_cache_free(FAR struct wapi_scan_cache_s *cache);
+
 /****************************************************************************
  * Name: wapi_set_country
  *
@@ -30,13 +30,39 @@
 #include <fcntl.h>
 #include <debug.h>
 #include <errno.h>
+#include <math.h>
+#include <stdbool.h>
 
-#include <nuttx/math/cordic.h>
-#include <nuttx/math/math_ioctl.h>
+#ifdef CONFIG_INDUSTRY_FOC_CORDIC
+#  include <nuttx/math/cordic.h>
+#  include <nuttx/math/math_ioctl.h>
+#endif
 
 #include "industry/foc/foc_log.h"
 #include "industry/foc/fixed16/foc_cordic.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_LUT
+#  define FOC_LUT_SIZE     (1 << CONFIG_INDUSTRY_FOC_ANGLE_LUT_BITS)
+#  define FOC_LUT_QUARTER  (FOC_LUT_SIZE / 4)
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_LUT
+/* One period of sine and a quarter more, so that cosine is read at
+ * idx + FOC_LUT_QUARTER and the interpolation at idx + 1 never wraps.
+ */
+
+static b16_t g_foc_lut_b16[FOC_LUT_SIZE + FOC_LUT_QUARTER + 1];
+static bool  g_foc_lut_b16_ready;
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -181,3 +207,76 @@ int foc_cordic_angle_b16(int fd, FAR phase_angle_b16_t *angle, b16_t a)
   return OK;
 }
 #endif  /* CONFIG_INDUSTRY_FOC_CORDIC_ANGLE */
+
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_LUT
+
+/****************************************************************************
+ * Name: foc_lut_init_b16
+ *
+ * Description:
+ *   Fill the sine table (fixed16)
+ *
+ ****************************************************************************/
+
+void foc_lut_init_b16(void)
+{
+  int i;
+
+  if (g_foc_lut_b16_ready)
+    {
+      return;
+    }
+
+  for (i = 0; i < FOC_LUT_SIZE + FOC_LUT_QUARTER + 1; i++)
+    {
+      g_foc_lut_b16[i] = ftob16(sinf(2.0f * M_PI_F * i / FOC_LUT_SIZE));
+    }
+
+  g_foc_lut_b16_ready = true;
+}
+
+/****************************************************************************
+ * Name: foc_lut_angle_b16
+ *
+ * Description:
+ *   Table angle update (fixed16).  Sine and cosine are interpolated
+ *   linearly from the same table position.
+ *
+ * Input Parameter:
+ *   angle - phase angle data
+ *   a     - phase angle in rad
+ *
+ ****************************************************************************/
+
+void foc_lut_angle_b16(FAR phase_angle_b16_t *angle, b16_t a)
+{
+  const b16_t scale = ftob16(FOC_LUT_SIZE / (2.0f * M_PI_F));
+  b16_t       pos   = 0;
+  b16_t       frac  = 0;
+  uint32_t    idx   = 0;
+
+  DEBUGASSERT(angle);
+  DEBUGASSERT(g_foc_lut_b16_ready);
+
+  /* Normalize angle to [0, 2PI] */
+
+  angle_norm_2pi_b16(&a, 0, b16muli(b16PI, 2));
+
+  /* Table position, 2PI wraps to the first entry */
+
+  pos  = b16mulb16(a, scale);
+  idx  = b16toi(pos);
+  frac = pos & 0xffff;
+  idx &= (FOC_LUT_SIZE - 1);
+
+  /* Fill phase angle struct */
+
+  angle->angle = a;
+  angle->sin   = g_foc_lut_b16[idx] +
+                 b16mulb16(frac, g_foc_lut_b16[idx + 1] -
+                                 g_foc_lut_b16[idx]);
+  angle->cos   = g_foc_lut_b16[idx + FOC_LUT_QUARTER] +
+                 b16mulb16(frac, g_foc_lut_b16[idx + FOC_LUT_QUARTER + 1] -
+                                 g_foc_lut_b16[idx + FOC_LUT_QUARTER]);
+}
+#endif  /* CONFIG_INDUSTRY_FOC_ANGLE_LUT */
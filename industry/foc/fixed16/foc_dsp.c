@@ -0,0 +1,114 @@
+/****************************************************************************
+ * apps/industry/foc/fixed16/foc_dsp.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+
+#ifdef __ARM_FEATURE_DSP
+#  include <arm_acle.h>
+#endif
+
+#include "industry/foc/fixed16/foc_dsp.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if CONFIG_MOTOR_FOC_PHASES != 3
+#  error
+#endif
+
+/* Clarke transform constants */
+
+#define FOC_DSP_ONE_BY_SQRT3  ftob16(0.57735026919f)
+#define FOC_DSP_TWO_BY_SQRT3  ftob16(1.15470053838f)
+
+/* Sums of products.  With the DSP extension they saturate in a single
+ * QADD/QSUB instead of wrapping, the result is the same for all values
+ * that don't overflow.
+ */
+
+#ifdef __ARM_FEATURE_DSP
+#  define FOC_DSP_ADD(a, b)   __qadd((a), (b))
+#  define FOC_DSP_SUB(a, b)   __qsub((a), (b))
+#else
+#  define FOC_DSP_ADD(a, b)   ((a) + (b))
+#  define FOC_DSP_SUB(a, b)   ((a) - (b))
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_dsp_iabc_update_b16
+ *
+ * Description:
+ *   Update the phase currents of the FOC controller, as
+ *   foc_iabc_update_b16() but with the Clarke and Park transforms fused:
+ *   the alpha-beta currents stay in registers and each product is
+ *   computed once (fixed16)
+ *
+ * Input Parameter:
+ *   foc   - pointer to FOC data
+ *   angle - phase angle used by the Park transform
+ *   i_abc - phase currents
+ *
+ ****************************************************************************/
+
+void foc_dsp_iabc_update_b16(FAR struct foc_data_b16_s *foc,
+                             FAR phase_angle_b16_t *angle,
+                             FAR abc_frame_b16_t *i_abc)
+{
+  b16_t alpha;
+  b16_t beta;
+  b16_t s;
+  b16_t c;
+
+  DEBUGASSERT(foc);
+  DEBUGASSERT(angle);
+  DEBUGASSERT(i_abc);
+
+  s = angle->sin;
+  c = angle->cos;
+
+  /* Clarke transform */
+
+  alpha = i_abc->a;
+  beta  = FOC_DSP_ADD(b16mulb16(i_abc->a, FOC_DSP_ONE_BY_SQRT3),
+                      b16mulb16(i_abc->b, FOC_DSP_TWO_BY_SQRT3));
+
+  /* Park transform */
+
+  foc->i_dq.d = FOC_DSP_ADD(b16mulb16(c, alpha), b16mulb16(s, beta));
+  foc->i_dq.q = FOC_DSP_SUB(b16mulb16(c, beta), b16mulb16(s, alpha));
+
+  foc->i_ab.a = alpha;
+  foc->i_ab.b = beta;
+
+  foc->i_abc.a = i_abc->a;
+  foc->i_abc.b = i_abc->b;
+  foc->i_abc.c = i_abc->c;
+}
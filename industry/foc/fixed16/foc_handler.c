@@ -119,6 +119,18 @@ int foc_handler_init_b16(FAR foc_handler_b16_t *h,
     }
 #endif
 
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_LUT
+  /* Fill the sine table */
+
+  foc_lut_init_b16();
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_PROF
+  /* Initialize profiler */
+
+  foc_prof_init(&h->prof);
+#endif
+
 errout:
   return ret;
 }
@@ -227,6 +239,8 @@ int foc_handler_run_b16(FAR foc_handler_b16_t *h,
       goto errout;
     }
 
+  FOC_PROF_MARK(h);
+
   /* Correct current samples according to modulation state */
 
   h->ops.mod->current(h, in->current);
@@ -235,10 +249,14 @@ int foc_handler_run_b16(FAR foc_handler_b16_t *h,
 
   h->ops.mod->vbase_get(h, in->vbus, &vbase);
 
+  FOC_PROF_STAGE(h, FOC_PROF_CURRENT);
+
   /* Feed controller with phase currents */
 
   h->ops.ctrl->input_set(h, in->current, vbase, in->angle);
 
+  FOC_PROF_STAGE(h, FOC_PROF_INPUT);
+
   /* Call controller */
 
   switch (in->mode)
@@ -289,10 +307,15 @@ int foc_handler_run_b16(FAR foc_handler_b16_t *h,
         }
     }
 
+  FOC_PROF_STAGE(h, FOC_PROF_CONTROL);
+
   /* Duty cycle modulation */
 
   h->ops.mod->run(h, &v_ab_mod, out->duty);
 
+  FOC_PROF_STAGE(h, FOC_PROF_MODULATION);
+  FOC_PROF_COMMIT(h);
+
   return ret;
 
 errout:
@@ -219,7 +219,11 @@ static void foc_control_input_set_b16(FAR foc_handler_b16_t *h,
   i_abc.b = current[1];
   i_abc.c = current[2];
 
+#ifndef CONFIG_INDUSTRY_FOC_DSP
   foc_iabc_update_b16(&foc->data, &i_abc);
+#else
+  foc_dsp_iabc_update_b16(&foc->data, &foc->angle, &i_abc);
+#endif
 
   /* Update base voltage only if changed */
 
@@ -236,10 +240,12 @@ static void foc_control_input_set_b16(FAR foc_handler_b16_t *h,
 
   /* Update phase angle */
 
-#ifndef CONFIG_INDUSTRY_FOC_CORDIC_ANGLE
-  phase_angle_update_b16(&foc->angle, angle);
-#else
+#if defined(CONFIG_INDUSTRY_FOC_CORDIC_ANGLE)
   foc_cordic_angle_b16(h->fd, &foc->angle, angle);
+#elif defined(CONFIG_INDUSTRY_FOC_ANGLE_LUT)
+  foc_lut_angle_b16(&foc->angle, angle);
+#else
+  phase_angle_update_b16(&foc->angle, angle);
 #endif
 
   /* Feed the controller with phase angle */
@@ -30,13 +30,39 @@
 #include <fcntl.h>
 #include <debug.h>
 #include <errno.h>
+#include <math.h>
+#include <stdbool.h>
 
-#include <nuttx/math/cordic.h>
-#include <nuttx/math/math_ioctl.h>
+#ifdef CONFIG_INDUSTRY_FOC_CORDIC
+#  include <nuttx/math/cordic.h>
+#  include <nuttx/math/math_ioctl.h>
+#endif
 
 #include "industry/foc/foc_log.h"
 #include "industry/foc/float/foc_cordic.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_LUT
+#  define FOC_LUT_SIZE     (1 << CONFIG_INDUSTRY_FOC_ANGLE_LUT_BITS)
+#  define FOC_LUT_QUARTER  (FOC_LUT_SIZE / 4)
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_LUT
+/* One period of sine and a quarter more, so that cosine is read at
+ * idx + FOC_LUT_QUARTER and the interpolation at idx + 1 never wraps.
+ */
+
+static float g_foc_lut_f32[FOC_LUT_SIZE + FOC_LUT_QUARTER + 1];
+static bool  g_foc_lut_f32_ready;
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -181,3 +207,75 @@ int foc_cordic_angle_f32(int fd, FAR phase_angle_f32_t *angle, float a)
   return OK;
 }
 #endif  /* CONFIG_INDUSTRY_FOC_CORDIC_ANGLE */
+
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_LUT
+
+/****************************************************************************
+ * Name: foc_lut_init_f32
+ *
+ * Description:
+ *   Fill the sine table (float32)
+ *
+ ****************************************************************************/
+
+void foc_lut_init_f32(void)
+{
+  int i;
+
+  if (g_foc_lut_f32_ready)
+    {
+      return;
+    }
+
+  for (i = 0; i < FOC_LUT_SIZE + FOC_LUT_QUARTER + 1; i++)
+    {
+      g_foc_lut_f32[i] = sinf(2.0f * M_PI_F * i / FOC_LUT_SIZE);
+    }
+
+  g_foc_lut_f32_ready = true;
+}
+
+/****************************************************************************
+ * Name: foc_lut_angle_f32
+ *
+ * Description:
+ *   Table angle update (float32).  Sine and cosine are interpolated
+ *   linearly from the same table position.
+ *
+ * Input Parameter:
+ *   angle - phase angle data
+ *   a     - phase angle in rad
+ *
+ ****************************************************************************/
+
+void foc_lut_angle_f32(FAR phase_angle_f32_t *angle, float a)
+{
+  const float scale = (FOC_LUT_SIZE / (2.0f * M_PI_F));
+  float       pos   = 0.0f;
+  float       frac  = 0.0f;
+  uint32_t    idx   = 0;
+
+  DEBUGASSERT(angle);
+  DEBUGASSERT(g_foc_lut_f32_ready);
+
+  /* Normalize angle to [0, 2PI] */
+
+  angle_norm_2pi(&a, 0.0f, 2.0f * M_PI_F);
+
+  /* Table position, 2PI wraps to the first entry */
+
+  pos  = a * scale;
+  idx  = (uint32_t)pos;
+  frac = pos - idx;
+  idx &= (FOC_LUT_SIZE - 1);
+
+  /* Fill phase angle struct */
+
+  angle->angle = a;
+  angle->sin   = g_foc_lut_f32[idx] +
+                 frac * (g_foc_lut_f32[idx + 1] - g_foc_lut_f32[idx]);
+  angle->cos   = g_foc_lut_f32[idx + FOC_LUT_QUARTER] +
+                 frac * (g_foc_lut_f32[idx + FOC_LUT_QUARTER + 1] -
+                         g_foc_lut_f32[idx + FOC_LUT_QUARTER]);
+}
+#endif  /* CONFIG_INDUSTRY_FOC_ANGLE_LUT */
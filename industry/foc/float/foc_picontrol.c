@@ -236,10 +236,12 @@ static void foc_control_input_set_f32(FAR foc_handler_f32_t *h,
 
   /* Update phase angle */
 
-#ifndef CONFIG_INDUSTRY_FOC_CORDIC_ANGLE
-  phase_angle_update(&foc->angle, angle);
-#else
+#if defined(CONFIG_INDUSTRY_FOC_CORDIC_ANGLE)
   foc_cordic_angle_f32(h->fd, &foc->angle, angle);
+#elif defined(CONFIG_INDUSTRY_FOC_ANGLE_LUT)
+  foc_lut_angle_f32(&foc->angle, angle);
+#else
+  phase_angle_update(&foc->angle, angle);
 #endif
 
   /* Feed the controller with phase angle */
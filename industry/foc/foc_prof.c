@@ -0,0 +1,163 @@
+/****************************************************************************
+ * apps/industry/foc/foc_prof.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include "industry/foc/foc_prof.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_prof_init
+ *
+ * Description:
+ *   Initialize the profiler
+ *
+ * Input Parameter:
+ *   prof - pointer to profiler data
+ *
+ ****************************************************************************/
+
+void foc_prof_init(FAR struct foc_prof_s *prof)
+{
+  DEBUGASSERT(prof);
+
+  memset(prof, 0, sizeof(struct foc_prof_s));
+}
+
+/****************************************************************************
+ * Name: foc_prof_commit
+ *
+ * Description:
+ *   Store the cycle in progress in the ring buffer and start a new one
+ *
+ * Input Parameter:
+ *   prof - pointer to profiler data
+ *
+ ****************************************************************************/
+
+void foc_prof_commit(FAR struct foc_prof_s *prof)
+{
+  DEBUGASSERT(prof);
+
+  memcpy(prof->ring[prof->head], prof->cycle, sizeof(prof->cycle));
+  memset(prof->cycle, 0, sizeof(prof->cycle));
+
+  if (++prof->head >= CONFIG_INDUSTRY_FOC_PROF_SAMPLES)
+    {
+      prof->head = 0;
+    }
+
+  if (prof->count < CONFIG_INDUSTRY_FOC_PROF_SAMPLES)
+    {
+      prof->count++;
+    }
+}
+
+/****************************************************************************
+ * Name: foc_prof_last
+ *
+ * Description:
+ *   Get the stages of the last complete cycle
+ *
+ * Input Parameter:
+ *   prof - pointer to profiler data
+ *
+ * Returned Value:
+ *   FOC_PROF_STAGES durations, zeros before the first cycle
+ *
+ ****************************************************************************/
+
+FAR const uint32_t *foc_prof_last(FAR struct foc_prof_s *prof)
+{
+  DEBUGASSERT(prof);
+
+  if (prof->head == 0)
+    {
+      return prof->ring[CONFIG_INDUSTRY_FOC_PROF_SAMPLES - 1];
+    }
+
+  return prof->ring[prof->head - 1];
+}
+
+/****************************************************************************
+ * Name: foc_prof_stats
+ *
+ * Description:
+ *   Get the minimum, maximum and average duration of each stage over the
+ *   cycles in the ring buffer
+ *
+ * Input Parameter:
+ *   prof - pointer to profiler data
+ *   stat - (out) FOC_PROF_STAGES statistics
+ *
+ ****************************************************************************/
+
+void foc_prof_stats(FAR struct foc_prof_s *prof,
+                    FAR struct foc_prof_stat_s *stat)
+{
+  uint64_t sum;
+  uint32_t val;
+  int      i;
+  int      j;
+
+  DEBUGASSERT(prof);
+  DEBUGASSERT(stat);
+
+  memset(stat, 0, FOC_PROF_STAGES * sizeof(struct foc_prof_stat_s));
+
+  if (prof->count == 0)
+    {
+      return;
+    }
+
+  for (j = 0; j < FOC_PROF_STAGES; j++)
+    {
+      stat[j].min = UINT32_MAX;
+      sum         = 0;
+
+      for (i = 0; i < prof->count; i++)
+        {
+          val = prof->ring[i][j];
+          sum += val;
+
+          if (val < stat[j].min)
+            {
+              stat[j].min = val;
+            }
+
+          if (val > stat[j].max)
+            {
+              stat[j].max = val;
+            }
+        }
+
+      stat[j].avg = sum / prof->count;
+    }
+}
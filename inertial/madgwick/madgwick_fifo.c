@@ -0,0 +1,86 @@
+/****************************************************************************
+ * apps/inertial/madgwick/madgwick_fifo.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+
+#include "inertial/madgwick.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Fusion takes the gyroscope in deg/s and the accelerometer in g */
+
+#define MADGWICK_RAD2DEG  57.29577951f
+#define MADGWICK_MS2G     (1.0f / 9.80665f)
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: madgwick_update_fifo
+ ****************************************************************************/
+
+void madgwick_update_fifo(FAR FusionAhrs *ahrs,
+                          FAR const struct sensor_gyro *gyro,
+                          FAR const struct sensor_accel *accel,
+                          size_t n, FAR uint64_t *last, float dt)
+{
+  FusionVector g;
+  FusionVector a;
+  uint64_t prev;
+  float step;
+  size_t i;
+
+  DEBUGASSERT(ahrs != NULL && last != NULL);
+  DEBUGASSERT(n == 0 || (gyro != NULL && accel != NULL));
+
+  prev = *last;
+  for (i = 0; i < n; i++)
+    {
+      /* The FIFO timestamps absorb the jitter of the IMU clock */
+
+      step = dt;
+      if (prev != 0 && gyro[i].timestamp > prev)
+        {
+          step = (gyro[i].timestamp - prev) * 1e-6f;
+        }
+
+      prev = gyro[i].timestamp;
+
+      g.axis.x = gyro[i].x * MADGWICK_RAD2DEG;
+      g.axis.y = gyro[i].y * MADGWICK_RAD2DEG;
+      g.axis.z = gyro[i].z * MADGWICK_RAD2DEG;
+      a.axis.x = accel[i].x * MADGWICK_MS2G;
+      a.axis.y = accel[i].y * MADGWICK_MS2G;
+      a.axis.z = accel[i].z * MADGWICK_MS2G;
+
+      FusionAhrsUpdateNoMagnetometer(ahrs, g, a, step);
+    }
+
+  *last = prev;
+}
@@ -0,0 +1,254 @@
+/****************************************************************************
+ * apps/inertial/madgwick/madgwick_fixed.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include "inertial/madgwick.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define Q30_ONE        (1 << 30)
+
+/* Product of two Q30 values, the operands may be wider than Q30 */
+
+#define MUL30(a, b)    (((int64_t)(a) * (b)) >> 30)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: madgwick_q_isqrt
+ *
+ * Description:
+ *   Integer square root of a 64-bit value.
+ *
+ ****************************************************************************/
+
+static uint32_t madgwick_q_isqrt(uint64_t x)
+{
+  uint64_t bit = (uint64_t)1 << 62;
+  uint64_t res = 0;
+
+  while (bit > x)
+    {
+      bit >>= 2;
+    }
+
+  while (bit != 0)
+    {
+      if (x >= res + bit)
+        {
+          x   -= res + bit;
+          res  = (res >> 1) + bit;
+        }
+      else
+        {
+          res >>= 1;
+        }
+
+      bit >>= 2;
+    }
+
+  return (uint32_t)res;
+}
+
+/****************************************************************************
+ * Name: madgwick_q_normalize
+ *
+ * Description:
+ *   Scale a vector of n values in any Q format to unit length in Q30.
+ *
+ * Returned Value:
+ *   false if the vector is zero and was left unchanged.
+ *
+ ****************************************************************************/
+
+static bool madgwick_q_normalize(FAR int32_t *v, int n)
+{
+  uint64_t sum = 0;
+  uint32_t norm;
+  int i;
+
+  for (i = 0; i < n; i++)
+    {
+      sum += (uint64_t)((int64_t)v[i] * v[i]);
+    }
+
+  norm = madgwick_q_isqrt(sum);
+  if (norm == 0)
+    {
+      return false;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      v[i] = (int32_t)(((int64_t)v[i] << 30) / norm);
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: madgwick_q_init
+ ****************************************************************************/
+
+void madgwick_q_init(FAR struct madgwick_q_s *filter, b16_t beta,
+                     uint32_t rate)
+{
+  DEBUGASSERT(filter != NULL && rate > 0);
+
+  filter->q[0]    = Q30_ONE;
+  filter->q[1]    = 0;
+  filter->q[2]    = 0;
+  filter->q[3]    = 0;
+  filter->dt      = Q30_ONE / rate;
+  filter->beta_dt = ((int64_t)beta * filter->dt) >> 16;
+}
+
+/****************************************************************************
+ * Name: madgwick_q_update
+ ****************************************************************************/
+
+void madgwick_q_update(FAR struct madgwick_q_s *filter,
+                       FAR const b16_t *gyro, FAR const b16_t *accel)
+{
+  FAR int32_t *q = filter->q;
+  int32_t qdot[4];
+  int32_t g[3];
+  int32_t a[3];
+  int32_t s[4];
+  int32_t q0q0;
+  int32_t q1q1;
+  int32_t q2q2;
+  int32_t q3q3;
+  int i;
+
+  /* Gyroscope rotation over one sample period, in Q30 radians */
+
+  for (i = 0; i < 3; i++)
+    {
+      g[i] = ((int64_t)gyro[i] * filter->dt) >> 16;
+    }
+
+  /* Quaternion change from the gyroscope */
+
+  qdot[0] = (-MUL30(q[1], g[0]) - MUL30(q[2], g[1]) -
+             MUL30(q[3], g[2])) >> 1;
+  qdot[1] = (MUL30(q[0], g[0]) + MUL30(q[2], g[2]) -
+             MUL30(q[3], g[1])) >> 1;
+  qdot[2] = (MUL30(q[0], g[1]) - MUL30(q[1], g[2]) +
+             MUL30(q[3], g[0])) >> 1;
+  qdot[3] = (MUL30(q[0], g[2]) + MUL30(q[1], g[1]) -
+             MUL30(q[2], g[0])) >> 1;
+
+  /* Gradient descent correction from the accelerometer.  The step is
+   * computed in Q24, its terms go up to 36 before normalization.
+   */
+
+  a[0] = accel[0];
+  a[1] = accel[1];
+  a[2] = accel[2];
+
+  if (madgwick_q_normalize(a, 3))
+    {
+      q0q0 = MUL30(q[0], q[0]);
+      q1q1 = MUL30(q[1], q[1]);
+      q2q2 = MUL30(q[2], q[2]);
+      q3q3 = MUL30(q[3], q[3]);
+
+      s[0] = (4 * MUL30(q[0], q2q2) + 2 * MUL30(q[2], a[0]) +
+              4 * MUL30(q[0], q1q1) - 2 * MUL30(q[1], a[1])) >> 6;
+      s[1] = (4 * MUL30(q[1], q3q3) - 2 * MUL30(q[3], a[0]) +
+              4 * MUL30(q0q0, q[1]) - 2 * MUL30(q[0], a[1]) -
+              4 * (int64_t)q[1] + 8 * MUL30(q[1], q1q1) +
+              8 * MUL30(q[1], q2q2) + 4 * MUL30(q[1], a[2])) >> 6;
+      s[2] = (4 * MUL30(q0q0, q[2]) + 2 * MUL30(q[0], a[0]) +
+              4 * MUL30(q[2], q3q3) - 2 * MUL30(q[3], a[1]) -
+              4 * (int64_t)q[2] + 8 * MUL30(q[2], q1q1) +
+              8 * MUL30(q[2], q2q2) + 4 * MUL30(q[2], a[2])) >> 6;
+      s[3] = (4 * MUL30(q1q1, q[3]) - 2 * MUL30(q[1], a[0]) +
+              4 * MUL30(q2q2, q[3]) - 2 * MUL30(q[2], a[1])) >> 6;
+
+      if (madgwick_q_normalize(s, 4))
+        {
+          for (i = 0; i < 4; i++)
+            {
+              qdot[i] -= MUL30(filter->beta_dt, s[i]);
+            }
+        }
+    }
+
+  /* Integrate and renormalize */
+
+  for (i = 0; i < 4; i++)
+    {
+      q[i] += qdot[i];
+    }
+
+  madgwick_q_normalize(q, 4);
+}
+
+/****************************************************************************
+ * Name: madgwick_q_update_batch
+ ****************************************************************************/
+
+void madgwick_q_update_batch(FAR struct madgwick_q_s *filter,
+                             FAR const b16_t *gyro, FAR const b16_t *accel,
+                             size_t n)
+{
+  size_t i;
+
+  DEBUGASSERT(filter != NULL);
+  DEBUGASSERT(n == 0 || (gyro != NULL && accel != NULL));
+
+  for (i = 0; i < n; i++)
+    {
+      madgwick_q_update(filter, &gyro[3 * i], &accel[3 * i]);
+    }
+}
+
+/****************************************************************************
+ * Name: madgwick_q_quaternion
+ ****************************************************************************/
+
+void madgwick_q_quaternion(FAR const struct madgwick_q_s *filter,
+                           FAR b16_t *q)
+{
+  int i;
+
+  for (i = 0; i < 4; i++)
+    {
+      q[i] = filter->q[i] >> 14;
+    }
+}
@@ -42,6 +42,7 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <math.h>
+#include <string.h>
 #include <strings.h>
 #include <time.h>
 #include <unistd.h>
@@ -60,6 +61,10 @@
  ****************************************************************************/
 
 #define DIRECTMODE (g_pc.line== -1)
+
+/* Array indices evaluated without allocating memory */
+
+#define LVALUE_NIDX 4
 #define _(String) String
 
 /****************************************************************************
@@ -193,37 +198,49 @@ static struct Value *lvalue(struct Value *value)
       struct Pc idxpc;
       unsigned int dim;
       unsigned int capacity;
+      int idxbuf[LVALUE_NIDX];
       int *idx;
 
+      /* Array elements are accessed in the inner loops of most programs,
+       * so the indices go on the stack unless there are too many of them.
+       */
+
       g_pc.token += 2;
       dim = 0;
-      capacity = 0;
-      idx = (int *)0;
+      capacity = LVALUE_NIDX;
+      idx = idxbuf;
       while (1)
         {
           if (dim == capacity && g_pass == INTERPRET)     /* enlarge idx */
             {
               int *more;
 
-              more =
-                realloc(idx,
-                        sizeof(unsigned int) *
-                        (capacity ? (capacity *= 2) : (capacity = 3)));
+              more = malloc(sizeof(int) * capacity * 2);
               if (!more)
                 {
-                  if (capacity)
-                    free(idx);
+                  if (idx != idxbuf)
+                    {
+                      free(idx);
+                    }
+
                   return Value_new_ERROR(value, OUTOFMEMORY);
                 }
 
+              memcpy(more, idx, sizeof(int) * dim);
+              if (idx != idxbuf)
+                {
+                  free(idx);
+                }
+
               idx = more;
+              capacity *= 2;
             }
 
           idxpc = g_pc;
           if (eval(value, _("index"))->type == V_ERROR ||
               VALUE_RETYPE(value, V_INTEGER)->type == V_ERROR)
             {
-              if (capacity)
+              if (idx != idxbuf)
                 {
                   free(idx);
                 }
@@ -269,7 +286,11 @@ static struct Value *lvalue(struct Value *value)
                 g_pc = lvpc;
               }
 
-            free(idx);
+            if (idx != idxbuf)
+              {
+                free(idx);
+              }
+
             return value;
           }
 
@@ -35,3 +35,18 @@ $(LUAMODLIST): $(DEPCONFIG) Makefile
 
 register:: $(LUAMODLIST)
 endif
+
+# Lua scripts listed in LUASCRIPTS are compiled to bytecode and embedded in
+# the interpreter when CONFIG_INTERPRETER_LUA_BYTECODE is enabled.  They can
+# be loaded with require() and run by name by luad, a script foo.lua is
+# registered as "foo".
+
+ifneq ($(LUASCRIPTS),)
+register::
+	$(Q) for script in $(LUASCRIPTS); do \
+		name=$$(basename $$script .lua); \
+		echo Register Lua Script: $$name; \
+		echo $(CURDIR)$(DELIM)$$script > "$(LUAMOD_REGISTRY)$(DELIM)$$name.sdat"; \
+	done
+	$(Q) touch "$(LUAMOD_REGISTRY)$(DELIM).updated"
+endif
@@ -0,0 +1,400 @@
+/****************************************************************************
+ * apps/interpreters/lua/luad.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <lua.h>
+#include <lualib.h>
+#include <lauxlib.h>
+
+#include "nuttx_lua.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define LUAD_PATH     CONFIG_INTERPRETER_LUAD_PATH
+#define LUAD_MAXREQ   CONFIG_INTERPRETER_LUAD_MAXREQ
+#define LUAD_MAXARGS  16
+#define LUAD_MSGSIZE  128
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A pre-initialized Lua state and the thread that runs scripts in it */
+
+struct luad_state_s
+{
+  pthread_t  thread;
+  lua_State *L;
+  int        listensd;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct luad_state_s g_luad_pool[CONFIG_INTERPRETER_LUAD_NSTATES];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: luad_address
+ ****************************************************************************/
+
+static socklen_t luad_address(FAR struct sockaddr_un *addr)
+{
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_LOCAL;
+  strlcpy(addr->sun_path, LUAD_PATH, sizeof(addr->sun_path));
+  return sizeof(sa_family_t) + strlen(addr->sun_path) + 1;
+}
+
+/****************************************************************************
+ * Name: luad_load
+ *
+ * Description:
+ *   Load a script: an embedded bytecode script if the name has no '/' and
+ *   there is one, a file (source or luac bytecode) otherwise.
+ *
+ ****************************************************************************/
+
+static int luad_load(FAR lua_State *L, FAR const char *name)
+{
+  FAR const struct nuttx_luascript_s *script;
+
+  if (strchr(name, '/') == NULL &&
+      (script = nuttx_luascript_find(name)) != NULL)
+    {
+      return luaL_loadbufferx(L, (FAR const char *)script->data,
+                              script->size, name, "b");
+    }
+
+  return luaL_loadfilex(L, name, NULL);
+}
+
+/****************************************************************************
+ * Name: luad_run
+ *
+ * Description:
+ *   Run a script in a state of the pool.  The script gets its own global
+ *   environment, which falls back to the shared globals, so that it does
+ *   not leak globals to the next script.  Modules loaded with require()
+ *   stay loaded for the next scripts.
+ *
+ ****************************************************************************/
+
+static int luad_run(FAR lua_State *L, int argc, FAR char *argv[],
+                    FAR char *msg)
+{
+  int top = lua_gettop(L);
+  int ret;
+  int i;
+
+  ret = luad_load(L, argv[0]);
+  if (ret == LUA_OK)
+    {
+      /* _ENV of the chunk: { arg = {...} } with __index = _G */
+
+      lua_newtable(L);
+      lua_createtable(L, 0, 1);
+      lua_pushglobaltable(L);
+      lua_setfield(L, -2, "__index");
+      lua_setmetatable(L, -2);
+
+      lua_createtable(L, argc - 1, 1);
+      for (i = 0; i < argc; i++)
+        {
+          lua_pushstring(L, argv[i]);
+          lua_rawseti(L, -2, i);
+        }
+
+      lua_setfield(L, -2, "arg");
+      if (lua_setupvalue(L, -2, 1) == NULL)
+        {
+          lua_pop(L, 1);
+        }
+
+      for (i = 1; i < argc; i++)
+        {
+          lua_pushstring(L, argv[i]);
+        }
+
+      ret = lua_pcall(L, argc - 1, 0, 0);
+    }
+
+  if (ret != LUA_OK)
+    {
+      strlcpy(msg, lua_isstring(L, -1) ? lua_tostring(L, -1) :
+              "(error object is not a string)", LUAD_MSGSIZE);
+    }
+
+  lua_settop(L, top);
+  lua_gc(L, LUA_GCCOLLECT, 0);
+  return ret == LUA_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/****************************************************************************
+ * Name: luad_serve
+ *
+ * Description:
+ *   Serve one request: the script name and its arguments, each one
+ *   terminated by a NUL and the list by an empty string.  The reply is the
+ *   exit status of the script in an int32_t followed by the error message.
+ *
+ ****************************************************************************/
+
+static void luad_serve(FAR struct luad_state_s *state, int sd)
+{
+  FAR char *argv[LUAD_MAXARGS];
+  char req[LUAD_MAXREQ];
+  char msg[LUAD_MSGSIZE];
+  size_t len = 0;
+  ssize_t nbytes;
+  int32_t status;
+  int argc = 0;
+  size_t i;
+
+  while (len < 2 || req[len - 1] != '\0' || req[len - 2] != '\0')
+    {
+      nbytes = recv(sd, &req[len], sizeof(req) - len, 0);
+      if (nbytes <= 0 || (len += nbytes) == sizeof(req))
+        {
+          return;
+        }
+    }
+
+  for (i = 0; req[i] != '\0' && argc < LUAD_MAXARGS; i += strlen(&req[i]) + 1)
+    {
+      argv[argc++] = &req[i];
+    }
+
+  msg[0] = '\0';
+  status = luad_run(state->L, argc, argv, msg);
+
+  send(sd, &status, sizeof(status), 0);
+  send(sd, msg, strlen(msg), 0);
+}
+
+/****************************************************************************
+ * Name: luad_worker
+ ****************************************************************************/
+
+static FAR void *luad_worker(FAR void *arg)
+{
+  FAR struct luad_state_s *state = arg;
+  int sd;
+
+  for (; ; )
+    {
+      sd = accept(state->listensd, NULL, NULL);
+      if (sd < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          break;
+        }
+
+      luad_serve(state, sd);
+      close(sd);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: luad_daemon
+ ****************************************************************************/
+
+static int luad_daemon(void)
+{
+  FAR struct luad_state_s *state;
+  struct sockaddr_un addr;
+  pthread_attr_t attr;
+  socklen_t addrlen;
+  int listensd;
+  int i;
+
+  listensd = socket(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listensd < 0)
+    {
+      perror("luad: socket");
+      return EXIT_FAILURE;
+    }
+
+  addrlen = luad_address(&addr);
+  unlink(LUAD_PATH);
+  if (bind(listensd, (FAR struct sockaddr *)&addr, addrlen) < 0 ||
+      listen(listensd, CONFIG_INTERPRETER_LUAD_NSTATES) < 0)
+    {
+      perror("luad: bind");
+      close(listensd);
+      return EXIT_FAILURE;
+    }
+
+  /* Initialize all the states before serving, so that no request pays
+   * for it.
+   */
+
+  for (i = 0; i < CONFIG_INTERPRETER_LUAD_NSTATES; i++)
+    {
+      state = &g_luad_pool[i];
+      state->listensd = listensd;
+      state->L = luaL_newstate();
+      if (state->L == NULL)
+        {
+          fprintf(stderr, "luad: cannot create state %d\n", i);
+          return EXIT_FAILURE;
+        }
+
+      luaL_openlibs(state->L);
+    }
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_INTERPRETER_LUAD_STACKSIZE);
+
+  for (i = 1; i < CONFIG_INTERPRETER_LUAD_NSTATES; i++)
+    {
+      state = &g_luad_pool[i];
+      if (pthread_create(&state->thread, &attr, luad_worker, state) != 0)
+        {
+          fprintf(stderr, "luad: cannot create worker %d\n", i);
+          break;
+        }
+    }
+
+  pthread_attr_destroy(&attr);
+
+  /* The main thread runs the first state */
+
+  luad_worker(&g_luad_pool[0]);
+  return EXIT_FAILURE;
+}
+
+/****************************************************************************
+ * Name: luad_client
+ *
+ * Description:
+ *   Run a script in the daemon and return its exit status.
+ *
+ ****************************************************************************/
+
+static int luad_client(int argc, FAR char *argv[])
+{
+  struct sockaddr_un addr;
+  char msg[LUAD_MSGSIZE];
+  socklen_t addrlen;
+  int32_t status;
+  ssize_t nbytes;
+  size_t len = 0;
+  int sd;
+  int i;
+
+  sd = socket(AF_LOCAL, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (sd < 0)
+    {
+      perror("luad: socket");
+      return EXIT_FAILURE;
+    }
+
+  addrlen = luad_address(&addr);
+  if (connect(sd, (FAR struct sockaddr *)&addr, addrlen) < 0)
+    {
+      perror("luad: connect");
+      close(sd);
+      return EXIT_FAILURE;
+    }
+
+  for (i = 0; i < argc; i++)
+    {
+      send(sd, argv[i], strlen(argv[i]) + 1, 0);
+    }
+
+  if (send(sd, "", 1, 0) < 0 ||
+      recv(sd, &status, sizeof(status), MSG_WAITALL) != sizeof(status))
+    {
+      perror("luad: request");
+      close(sd);
+      return EXIT_FAILURE;
+    }
+
+  while ((nbytes = recv(sd, &msg[len], sizeof(msg) - 1 - len, 0)) > 0)
+    {
+      len += nbytes;
+    }
+
+  msg[len] = '\0';
+  if (len > 0)
+    {
+      fprintf(stderr, "luad: %s\n", msg);
+    }
+
+  close(sd);
+  return status;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  if (argc == 2 && strcmp(argv[1], "-d") == 0)
+    {
+      return luad_daemon();
+    }
+
+  if (argc < 2 || argc > LUAD_MAXARGS || argv[1][0] == '-')
+    {
+      fprintf(stderr, "Usage: %s -d\n", argv[0]);
+      fprintf(stderr, "       %s <script> [args...]\n", argv[0]);
+      fprintf(stderr, "  -d  Run the daemon with %d Lua states\n",
+              CONFIG_INTERPRETER_LUAD_NSTATES);
+      fprintf(stderr, "  script  A script file, or the name of a script "
+                      "embedded as bytecode\n");
+      return EXIT_FAILURE;
+    }
+
+  return luad_client(argc - 1, &argv[1]);
+}
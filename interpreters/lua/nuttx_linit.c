@@ -23,6 +23,7 @@
  ****************************************************************************/
 
 #include <stddef.h>
+#include <string.h>
 
 #include <lua.h>
 #include <lualib.h>
@@ -31,6 +32,11 @@
 #include <nuttx/config.h>
 
 #include "luamod_proto.h"
+#include "nuttx_lua.h"
+
+#ifdef CONFIG_INTERPRETER_LUA_BYTECODE
+#  include "luascript_data.h"
+#endif
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -40,6 +46,10 @@
 #  define LUA_GNAME "_G"
 #endif
 
+#ifndef LUA_PRELOAD_TABLE
+#  define LUA_PRELOAD_TABLE "_PRELOAD"
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -53,6 +63,46 @@ static const luaL_Reg g_loadedlibs[] =
   {NULL, NULL},
 };
 
+static const struct nuttx_luascript_s g_luascripts[] =
+{
+#ifdef CONFIG_INTERPRETER_LUA_BYTECODE
+#include "luascript_list.h"
+#endif
+  {NULL, NULL, 0},
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#if defined(CONFIG_INTERPRETER_LUA_BYTECODE) && \
+    defined(CONFIG_INTERPRETER_LUA_CORELIBS)
+
+/****************************************************************************
+ * Name: nuttx_luascript_loader
+ *
+ *   package.preload loader of an embedded script, the bytecode is only
+ *   undumped when the script is required.
+ *
+ ****************************************************************************/
+
+static int nuttx_luascript_loader(lua_State *L)
+{
+  const struct nuttx_luascript_s *script =
+    lua_touserdata(L, lua_upvalueindex(1));
+
+  if (luaL_loadbufferx(L, (const char *)script->data, script->size,
+                       script->name, "b") != LUA_OK)
+    {
+      return lua_error(L);
+    }
+
+  lua_pushvalue(L, 1);
+  lua_call(L, 1, 1);
+  return 1;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -68,9 +118,48 @@ static const luaL_Reg g_loadedlibs[] =
 void luaL_openlibs(lua_State *L)
 {
   const luaL_Reg *lib;
+#if defined(CONFIG_INTERPRETER_LUA_BYTECODE) && \
+    defined(CONFIG_INTERPRETER_LUA_CORELIBS)
+  const struct nuttx_luascript_s *script;
+#endif
+
   for (lib = g_loadedlibs; lib->func; lib++)
     {
       luaL_requiref(L, lib->name, lib->func, 1);
       lua_pop(L, 1);
     }
+
+#if defined(CONFIG_INTERPRETER_LUA_BYTECODE) && \
+    defined(CONFIG_INTERPRETER_LUA_CORELIBS)
+  /* Make the embedded scripts available to require() */
+
+  luaL_getsubtable(L, LUA_REGISTRYINDEX, LUA_PRELOAD_TABLE);
+  for (script = g_luascripts; script->name; script++)
+    {
+      lua_pushlightuserdata(L, (void *)script);
+      lua_pushcclosure(L, nuttx_luascript_loader, 1);
+      lua_setfield(L, -2, script->name);
+    }
+
+  lua_pop(L, 1);
+#endif
+}
+
+/****************************************************************************
+ * Name: nuttx_luascript_find
+ ****************************************************************************/
+
+const struct nuttx_luascript_s *nuttx_luascript_find(const char *name)
+{
+  const struct nuttx_luascript_s *script;
+
+  for (script = g_luascripts; script->name; script++)
+    {
+      if (strcmp(script->name, name) == 0)
+        {
+          return script;
+        }
+    }
+
+  return NULL;
 }
@@ -0,0 +1,63 @@
+/****************************************************************************
+ * apps/interpreters/lua/nuttx_lua.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INTERPRETERS_LUA_NUTTX_LUA_H
+#define __APPS_INTERPRETERS_LUA_NUTTX_LUA_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* A Lua script embedded as bytecode, see LUASCRIPTS in Module.mk */
+
+struct nuttx_luascript_s
+{
+  FAR const char          *name;
+  FAR const unsigned char *data;
+  size_t                   size;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nuttx_luascript_find
+ *
+ * Description:
+ *   Find an embedded script by name.
+ *
+ * Returned Value:
+ *   The script, or NULL if there is no script with this name.
+ *
+ ****************************************************************************/
+
+FAR const struct nuttx_luascript_s *
+nuttx_luascript_find(FAR const char *name);
+
+#endif /* __APPS_INTERPRETERS_LUA_NUTTX_LUA_H */
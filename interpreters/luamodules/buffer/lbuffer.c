@@ -0,0 +1,587 @@
+/****************************************************************************
+ * apps/interpreters/luamodules/buffer/lbuffer.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define LBUFFER_NAME  "buffer"
+
+/* A slice keeps its parent alive with a user value, Lua 5.2 and 5.3 have a
+ * single one that must be a table in 5.2.
+ */
+
+#if LUA_VERSION_NUM < 504
+#  define lua_newuserdatauv(L, s, n) lua_newuserdata(L, s)
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A buffer owns its bytes, stored right after this header, a slice refers
+ * to the bytes of the buffer it was taken from.
+ */
+
+struct lbuffer_s
+{
+  uint8_t *data;
+  size_t   size;
+};
+
+/* Accessor types, the upvalue of the get and set closures */
+
+enum lbuffer_type_e
+{
+  LBUFFER_U8 = 0,
+  LBUFFER_I8,
+  LBUFFER_U16,
+  LBUFFER_I16,
+  LBUFFER_U32,
+  LBUFFER_I32,
+  LBUFFER_I64,
+  LBUFFER_F32,
+  LBUFFER_F64,
+  LBUFFER_NTYPES
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int lbuffer_new(lua_State *L);
+static int lbuffer_from(lua_State *L);
+static int lbuffer_len(lua_State *L);
+static int lbuffer_slice(lua_State *L);
+static int lbuffer_tostring(lua_State *L);
+static int lbuffer_fill(lua_State *L);
+static int lbuffer_copy(lua_State *L);
+static int lbuffer_read(lua_State *L);
+static int lbuffer_write(lua_State *L);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const char *const g_lbuffer_types[LBUFFER_NTYPES] =
+{
+  "u8", "i8", "u16", "i16", "u32", "i32", "i64", "f32", "f64"
+};
+
+static const uint8_t g_lbuffer_sizes[LBUFFER_NTYPES] =
+{
+  1, 1, 2, 2, 4, 4, 8, 4, 8
+};
+
+static const luaL_Reg g_lbuffer_funcs[] =
+{
+  {"new", lbuffer_new},
+  {"from", lbuffer_from},
+  {NULL, NULL},
+};
+
+static const luaL_Reg g_lbuffer_methods[] =
+{
+  {"len", lbuffer_len},
+  {"slice", lbuffer_slice},
+  {"tostring", lbuffer_tostring},
+  {"fill", lbuffer_fill},
+  {"copy", lbuffer_copy},
+  {"read", lbuffer_read},
+  {"write", lbuffer_write},
+  {NULL, NULL},
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: lbuffer_check
+ ****************************************************************************/
+
+static struct lbuffer_s *lbuffer_check(lua_State *L, int arg)
+{
+  return luaL_checkudata(L, arg, LBUFFER_NAME);
+}
+
+/****************************************************************************
+ * Name: lbuffer_range
+ *
+ *   Get the byte range [i, j] from the optional arguments arg and arg + 1,
+ *   with the conventions of string.sub(): positions start at 1, negative
+ *   positions count from the end and the default is the whole buffer.
+ *
+ ****************************************************************************/
+
+static void lbuffer_range(lua_State *L, struct lbuffer_s *buf, int arg,
+                          size_t *off, size_t *len)
+{
+  lua_Integer size = (lua_Integer)buf->size;
+  lua_Integer i = luaL_optinteger(L, arg, 1);
+  lua_Integer j = luaL_optinteger(L, arg + 1, -1);
+
+  if (i < 0)
+    {
+      i = size + i + 1;
+    }
+
+  if (j < 0)
+    {
+      j = size + j + 1;
+    }
+
+  if (i < 1)
+    {
+      i = 1;
+    }
+
+  if (i > size + 1)
+    {
+      i = size + 1;
+    }
+
+  if (j > size)
+    {
+      j = size;
+    }
+
+  *off = (size_t)(i - 1);
+  *len = i <= j ? (size_t)(j - i + 1) : 0;
+}
+
+/****************************************************************************
+ * Name: lbuffer_pos
+ *
+ *   Check that n bytes at position arg are inside the buffer.
+ *
+ ****************************************************************************/
+
+static size_t lbuffer_pos(lua_State *L, struct lbuffer_s *buf, int arg,
+                          size_t n)
+{
+  lua_Integer pos = luaL_checkinteger(L, arg);
+
+  luaL_argcheck(L, pos >= 1 && (size_t)pos - 1 + n <= buf->size, arg,
+                "out of range");
+  return (size_t)pos - 1;
+}
+
+/****************************************************************************
+ * Name: lbuffer_alloc
+ ****************************************************************************/
+
+static struct lbuffer_s *lbuffer_alloc(lua_State *L, size_t size)
+{
+  struct lbuffer_s *buf;
+
+  buf = lua_newuserdatauv(L, sizeof(struct lbuffer_s) + size, 1);
+  buf->data = (uint8_t *)(buf + 1);
+  buf->size = size;
+  luaL_setmetatable(L, LBUFFER_NAME);
+  return buf;
+}
+
+/****************************************************************************
+ * Name: lbuffer_new
+ *
+ *   buffer.new(size [, byte]): a new buffer of size bytes, zeroed or set
+ *   to byte.
+ *
+ ****************************************************************************/
+
+static int lbuffer_new(lua_State *L)
+{
+  lua_Integer size = luaL_checkinteger(L, 1);
+  int byte = (int)luaL_optinteger(L, 2, 0);
+  struct lbuffer_s *buf;
+
+  luaL_argcheck(L, size >= 0, 1, "negative size");
+  buf = lbuffer_alloc(L, (size_t)size);
+  memset(buf->data, byte, buf->size);
+  return 1;
+}
+
+/****************************************************************************
+ * Name: lbuffer_from
+ *
+ *   buffer.from(string): a new buffer holding a copy of the string.
+ *
+ ****************************************************************************/
+
+static int lbuffer_from(lua_State *L)
+{
+  size_t len;
+  const char *str = luaL_checklstring(L, 1, &len);
+  struct lbuffer_s *buf = lbuffer_alloc(L, len);
+
+  memcpy(buf->data, str, len);
+  return 1;
+}
+
+/****************************************************************************
+ * Name: lbuffer_len
+ ****************************************************************************/
+
+static int lbuffer_len(lua_State *L)
+{
+  lua_pushinteger(L, (lua_Integer)lbuffer_check(L, 1)->size);
+  return 1;
+}
+
+/****************************************************************************
+ * Name: lbuffer_slice
+ *
+ *   buf:slice([i [, j]]): a view of the bytes i to j, which shares them
+ *   with buf.  Writes through one are seen through the other.
+ *
+ ****************************************************************************/
+
+static int lbuffer_slice(lua_State *L)
+{
+  struct lbuffer_s *buf = lbuffer_check(L, 1);
+  struct lbuffer_s *slice;
+  size_t off;
+  size_t len;
+
+  lbuffer_range(L, buf, 2, &off, &len);
+
+  slice = lua_newuserdatauv(L, sizeof(struct lbuffer_s), 1);
+  slice->data = buf->data + off;
+  slice->size = len;
+  luaL_setmetatable(L, LBUFFER_NAME);
+
+#if LUA_VERSION_NUM < 504
+  lua_createtable(L, 1, 0);
+  lua_pushvalue(L, 1);
+  lua_rawseti(L, -2, 1);
+  lua_setuservalue(L, -2);
+#else
+  lua_pushvalue(L, 1);
+  lua_setiuservalue(L, -2, 1);
+#endif
+  return 1;
+}
+
+/****************************************************************************
+ * Name: lbuffer_tostring
+ *
+ *   buf:tostring([i [, j]]): the bytes i to j as a string.
+ *
+ ****************************************************************************/
+
+static int lbuffer_tostring(lua_State *L)
+{
+  struct lbuffer_s *buf = lbuffer_check(L, 1);
+  size_t off;
+  size_t len;
+
+  lbuffer_range(L, buf, 2, &off, &len);
+  lua_pushlstring(L, (const char *)buf->data + off, len);
+  return 1;
+}
+
+/****************************************************************************
+ * Name: lbuffer_fill
+ *
+ *   buf:fill(byte [, i [, j]])
+ *
+ ****************************************************************************/
+
+static int lbuffer_fill(lua_State *L)
+{
+  struct lbuffer_s *buf = lbuffer_check(L, 1);
+  int byte = (int)luaL_checkinteger(L, 2);
+  size_t off;
+  size_t len;
+
+  lbuffer_range(L, buf, 3, &off, &len);
+  memset(buf->data + off, byte, len);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: lbuffer_copy
+ *
+ *   buf:copy(pos, src [, i [, j]]): copy the bytes i to j of src, a buffer
+ *   or a string, at position pos.  src may overlap buf.
+ *
+ ****************************************************************************/
+
+static int lbuffer_copy(lua_State *L)
+{
+  struct lbuffer_s *buf = lbuffer_check(L, 1);
+  struct lbuffer_s tmp;
+  struct lbuffer_s *src;
+  size_t off;
+  size_t len;
+  size_t pos;
+
+  src = luaL_testudata(L, 3, LBUFFER_NAME);
+  if (src == NULL)
+    {
+      tmp.data = (uint8_t *)luaL_checklstring(L, 3, &tmp.size);
+      src      = &tmp;
+    }
+
+  lbuffer_range(L, src, 4, &off, &len);
+  pos = lbuffer_pos(L, buf, 2, len);
+  memmove(buf->data + pos, src->data + off, len);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: lbuffer_get
+ *
+ *   buf:get_<type>(pos [, bigendian]), the type is the upvalue.
+ *
+ ****************************************************************************/
+
+static int lbuffer_get(lua_State *L)
+{
+  int type = (int)lua_tointeger(L, lua_upvalueindex(1));
+  struct lbuffer_s *buf = lbuffer_check(L, 1);
+  size_t n = g_lbuffer_sizes[type];
+  size_t pos = lbuffer_pos(L, buf, 2, n);
+  int be = lua_toboolean(L, 3);
+  uint64_t value = 0;
+  size_t k;
+  union
+    {
+      uint32_t u32;
+      uint64_t u64;
+      float    f32;
+      double   f64;
+    } conv;
+
+  for (k = 0; k < n; k++)
+    {
+      value |= (uint64_t)buf->data[pos + (be ? n - 1 - k : k)] << (8 * k);
+    }
+
+  switch (type)
+    {
+      case LBUFFER_I8:
+        lua_pushinteger(L, (int8_t)value);
+        break;
+      case LBUFFER_I16:
+        lua_pushinteger(L, (int16_t)value);
+        break;
+      case LBUFFER_I32:
+        lua_pushinteger(L, (int32_t)value);
+        break;
+      case LBUFFER_I64:
+        lua_pushinteger(L, (lua_Integer)(int64_t)value);
+        break;
+      case LBUFFER_F32:
+        conv.u32 = (uint32_t)value;
+        lua_pushnumber(L, conv.f32);
+        break;
+      case LBUFFER_F64:
+        conv.u64 = value;
+        lua_pushnumber(L, (lua_Number)conv.f64);
+        break;
+      default:
+        lua_pushinteger(L, (lua_Integer)value);
+        break;
+    }
+
+  return 1;
+}
+
+/****************************************************************************
+ * Name: lbuffer_set
+ *
+ *   buf:set_<type>(pos, value [, bigendian]), the type is the upvalue.
+ *
+ ****************************************************************************/
+
+static int lbuffer_set(lua_State *L)
+{
+  int type = (int)lua_tointeger(L, lua_upvalueindex(1));
+  struct lbuffer_s *buf = lbuffer_check(L, 1);
+  size_t n = g_lbuffer_sizes[type];
+  size_t pos = lbuffer_pos(L, buf, 2, n);
+  int be = lua_toboolean(L, 4);
+  uint64_t value;
+  size_t k;
+  union
+    {
+      uint32_t u32;
+      uint64_t u64;
+      float    f32;
+      double   f64;
+    } conv;
+
+  switch (type)
+    {
+      case LBUFFER_F32:
+        conv.f32 = (float)luaL_checknumber(L, 3);
+        value    = conv.u32;
+        break;
+      case LBUFFER_F64:
+        conv.f64 = (double)luaL_checknumber(L, 3);
+        value    = conv.u64;
+        break;
+      default:
+        value = (uint64_t)luaL_checkinteger(L, 3);
+        break;
+    }
+
+  for (k = 0; k < n; k++)
+    {
+      buf->data[pos + (be ? n - 1 - k : k)] = (uint8_t)(value >> (8 * k));
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: lbuffer_io
+ *
+ *   buf:read(file [, i [, j]]) and buf:write(file [, i [, j]]): read into
+ *   or write the bytes i to j directly, with no intermediate string.  file
+ *   is an io file or a file descriptor, e.g. from luv (uv.fs_open() or
+ *   uv.fileno()).  Return the number of bytes transferred, 0 at the end of
+ *   the file, or nil, message and errno.
+ *
+ ****************************************************************************/
+
+static int lbuffer_io(lua_State *L, int out)
+{
+  struct lbuffer_s *buf = lbuffer_check(L, 1);
+  luaL_Stream *stream = luaL_testudata(L, 2, LUA_FILEHANDLE);
+  size_t off;
+  size_t len;
+  ssize_t ret;
+
+  lbuffer_range(L, buf, 3, &off, &len);
+
+  if (stream != NULL)
+    {
+      luaL_argcheck(L, stream->closef != NULL, 2, "attempt to use a "
+                    "closed file");
+
+      ret = out ? fwrite(buf->data + off, 1, len, stream->f) :
+                    fread(buf->data + off, 1, len, stream->f);
+      if (ret == 0 && len > 0 && ferror(stream->f))
+        {
+          return luaL_fileresult(L, 0, NULL);
+        }
+    }
+  else
+    {
+      int fd = (int)luaL_checkinteger(L, 2);
+
+      ret = out ? write(fd, buf->data + off, len) :
+                    read(fd, buf->data + off, len);
+      if (ret < 0)
+        {
+          return luaL_fileresult(L, 0, NULL);
+        }
+    }
+
+  lua_pushinteger(L, (lua_Integer)ret);
+  return 1;
+}
+
+/****************************************************************************
+ * Name: lbuffer_read/write
+ ****************************************************************************/
+
+static int lbuffer_read(lua_State *L)
+{
+  return lbuffer_io(L, 0);
+}
+
+static int lbuffer_write(lua_State *L)
+{
+  return lbuffer_io(L, 1);
+}
+
+/****************************************************************************
+ * Name: lbuffer_tostr
+ ****************************************************************************/
+
+static int lbuffer_tostr(lua_State *L)
+{
+  struct lbuffer_s *buf = lbuffer_check(L, 1);
+
+  lua_pushfstring(L, LBUFFER_NAME ": %p (%d bytes)", buf->data,
+                  (int)buf->size);
+  return 1;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: luaopen_buffer
+ *
+ *   Open the "buffer" Lua module.
+ *
+ ****************************************************************************/
+
+int luaopen_buffer(lua_State *L)
+{
+  char name[8];
+  int type;
+
+  luaL_newmetatable(L, LBUFFER_NAME);
+  lua_pushcfunction(L, lbuffer_len);
+  lua_setfield(L, -2, "__len");
+  lua_pushcfunction(L, lbuffer_tostr);
+  lua_setfield(L, -2, "__tostring");
+
+  luaL_newlib(L, g_lbuffer_methods);
+  for (type = 0; type < LBUFFER_NTYPES; type++)
+    {
+      lua_pushinteger(L, type);
+      lua_pushcclosure(L, lbuffer_get, 1);
+      snprintf(name, sizeof(name), "get_%s", g_lbuffer_types[type]);
+      lua_setfield(L, -2, name);
+
+      lua_pushinteger(L, type);
+      lua_pushcclosure(L, lbuffer_set, 1);
+      snprintf(name, sizeof(name), "set_%s", g_lbuffer_types[type]);
+      lua_setfield(L, -2, name);
+    }
+
+  lua_setfield(L, -2, "__index");
+  lua_pop(L, 1);
+
+  luaL_newlib(L, g_lbuffer_funcs);
+  return 1;
+}
@@ -33,6 +33,8 @@
 #include <fcntl.h>
 #include <time.h>
 #include <malloc.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <quickjs.h>
 #include <cutils.h>
@@ -43,6 +45,18 @@
 
 #define MALLOC_OVERHEAD 8
 
+#ifndef CONFIG_INTERPRETERS_QUICKJS_MEMORY_LIMIT
+#  define CONFIG_INTERPRETERS_QUICKJS_MEMORY_LIMIT 0
+#endif
+
+#ifndef CONFIG_INTERPRETERS_QUICKJS_GC_THRESHOLD
+#  define CONFIG_INTERPRETERS_QUICKJS_GC_THRESHOLD 0
+#endif
+
+#ifndef CONFIG_INTERPRETERS_QUICKJS_GC_PERIOD
+#  define CONFIG_INTERPRETERS_QUICKJS_GC_PERIOD 0
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -52,6 +66,14 @@ struct trace_malloc_data
   uint8_t *base;
 };
 
+/* Periodic garbage collection, run from the interrupt handler */
+
+struct gc_data
+{
+  unsigned int period;       /* In milliseconds, 0 to disable */
+  struct timespec last;
+};
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -70,7 +92,11 @@ static void qjs_help(void)
          "-e  --eval EXPR    evaluate EXPR\n"
          "-T  --trace        trace memory allocation\n"
          "-d  --dump         dump the memory usage stats\n"
+         "-b  --bytecode     the file is bytecode (default for *.jsbc)\n"
+         "-c  --compile FILE compile the file to bytecode in FILE\n"
          "    --memory-limit n       limit the memory usage to 'n' bytes\n"
+         "    --gc-threshold n       run the GC every 'n' bytes allocated\n"
+         "    --gc-period n          also run the GC every 'n' ms\n"
          "    --stack-size n         limit the stack size to 'n' bytes\n"
          "    --unhandled-rejection  dump unhandled promise rejections\n"
          "-q  --quit         just instantiate the interpreter and quit\n");
@@ -416,6 +442,215 @@ static int js_eval_file(JSContext *ctx, const char *filename, int module)
   return ret;
 }
 
+/****************************************************************************
+ * Name: js_map_file
+ *
+ * Description:
+ *   Map a file read-only.  On a memory mapped flash (e.g. ROMFS) the file
+ *   is used in place and not copied to RAM.
+ *
+ ****************************************************************************/
+
+static uint8_t *js_map_file(const char *filename, size_t *pbuf_len)
+{
+  struct stat st;
+  void *buf;
+  int fd;
+
+  fd = open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    {
+      return NULL;
+    }
+
+  if (fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+      close(fd);
+      errno = EINVAL;
+      return NULL;
+    }
+
+  buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (buf == MAP_FAILED)
+    {
+      return NULL;
+    }
+
+  *pbuf_len = st.st_size;
+  return buf;
+}
+
+/****************************************************************************
+ * Name: js_eval_binary
+ *
+ * Description:
+ *   Run bytecode written by JS_WriteObject() ("qjs -c"), which skips
+ *   parsing and compiling the source.
+ *
+ ****************************************************************************/
+
+static int js_eval_binary(JSContext *ctx, const uint8_t *buf,
+                          size_t buf_len)
+{
+  JSValue obj;
+  JSValue val;
+
+  obj = JS_ReadObject(ctx, buf, buf_len, JS_READ_OBJ_BYTECODE);
+  if (JS_IsException(obj))
+    {
+      js_std_dump_error(ctx);
+      return -1;
+    }
+
+  if (JS_VALUE_GET_TAG(obj) == JS_TAG_MODULE &&
+      JS_ResolveModule(ctx, obj) < 0)
+    {
+      JS_FreeValue(ctx, obj);
+      js_std_dump_error(ctx);
+      return -1;
+    }
+
+  val = JS_EvalFunction(ctx, obj);
+  if (JS_IsException(val))
+    {
+      js_std_dump_error(ctx);
+      return -1;
+    }
+
+  JS_FreeValue(ctx, val);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: js_eval_bytecode_file
+ ****************************************************************************/
+
+static int js_eval_bytecode_file(JSContext *ctx, const char *filename)
+{
+  uint8_t *buf;
+  size_t buf_len;
+  int ret;
+
+  buf = js_map_file(filename, &buf_len);
+  if (!buf)
+    {
+      perror(filename);
+      return -1;
+    }
+
+  ret = js_eval_binary(ctx, buf, buf_len);
+  munmap(buf, buf_len);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: js_compile_file
+ *
+ * Description:
+ *   Compile a source file and write its bytecode to outname.
+ *
+ ****************************************************************************/
+
+static int js_compile_file(JSContext *ctx, const char *filename,
+                           const char *outname)
+{
+  uint8_t *buf;
+  uint8_t *out;
+  size_t buf_len;
+  size_t out_len;
+  JSValue obj;
+  FILE *f;
+  int eval_flags;
+  int ret = -1;
+
+  buf = js_load_file(ctx, &buf_len, filename);
+  if (!buf)
+    {
+      perror(filename);
+      return -1;
+    }
+
+  if (has_suffix(filename, ".mjs") ||
+      JS_DetectModule((const char *)buf, buf_len))
+    {
+      eval_flags = JS_EVAL_TYPE_MODULE;
+    }
+  else
+    {
+      eval_flags = JS_EVAL_TYPE_GLOBAL;
+    }
+
+  obj = JS_Eval(ctx, (const char *)buf, buf_len, filename,
+                eval_flags | JS_EVAL_FLAG_COMPILE_ONLY);
+  js_free(ctx, buf);
+  if (JS_IsException(obj))
+    {
+      js_std_dump_error(ctx);
+      return -1;
+    }
+
+  out = JS_WriteObject(ctx, &out_len, obj, JS_WRITE_OBJ_BYTECODE);
+  JS_FreeValue(ctx, obj);
+  if (!out)
+    {
+      js_std_dump_error(ctx);
+      return -1;
+    }
+
+  f = fopen(outname, "wb");
+  if (f)
+    {
+      if (fwrite(out, 1, out_len, f) == out_len)
+        {
+          ret = 0;
+        }
+
+      if (fclose(f) != 0)
+        {
+          ret = -1;
+        }
+    }
+
+  if (ret < 0)
+    {
+      perror(outname);
+    }
+
+  js_free(ctx, out);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: js_gc_interrupt
+ *
+ * Description:
+ *   Interrupt handler, called regularly while JS code runs.  Run a cycle
+ *   collection when the GC period has elapsed, so that the cycles are
+ *   collected in small pauses instead of a long one when the allocation
+ *   threshold is reached.
+ *
+ ****************************************************************************/
+
+static int js_gc_interrupt(JSRuntime *rt, void *opaque)
+{
+  struct gc_data *gc = opaque;
+  struct timespec now;
+  long long elapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  elapsed = (now.tv_sec - gc->last.tv_sec) * 1000ll +
+            (now.tv_nsec - gc->last.tv_nsec) / 1000000;
+
+  if (elapsed >= gc->period)
+    {
+      JS_RunGC(rt);
+      clock_gettime(CLOCK_MONOTONIC, &gc->last);
+    }
+
+  return 0;
+}
+
 static JSValue js_print(JSContext *ctx, JSValueConst this_val,
                         int argc, JSValueConst *argv)
 {
@@ -485,11 +720,18 @@ int main(int argc, char *argv[])
 
   int argi;
   char *expr = NULL;
+  char *compile = NULL;
   int dump_memory = 0;
   int trace_memory = 0;
   int empty_run = 0;
-  size_t memory_limit = 0;
+  int bytecode = 0;
+  size_t memory_limit = CONFIG_INTERPRETERS_QUICKJS_MEMORY_LIMIT;
+  size_t gc_threshold = CONFIG_INTERPRETERS_QUICKJS_GC_THRESHOLD;
   size_t stack_size = 0;
+  struct gc_data gc_data =
+  {
+    CONFIG_INTERPRETERS_QUICKJS_GC_PERIOD
+  };
 
   argi = 1;
   while (argi < argc && *argv[argi] == '-')
@@ -546,6 +788,30 @@ int main(int argc, char *argv[])
               continue;
             }
 
+          if (opt == 'b' || !strcmp(longopt, "bytecode"))
+            {
+              bytecode++;
+              continue;
+            }
+
+          if (opt == 'c' || !strcmp(longopt, "compile"))
+            {
+              if (*arg)
+                {
+                  compile = arg;
+                  break;
+                }
+
+              if (argi < argc)
+                {
+                  compile = argv[argi++];
+                  break;
+                }
+
+              fprintf(stderr, "qjs: missing output file for -c\n");
+              exit(2);
+            }
+
           if (opt == 'T' || !strcmp(longopt, "trace"))
             {
               trace_memory++;
@@ -570,6 +836,30 @@ int main(int argc, char *argv[])
               continue;
             }
 
+          if (!strcmp(longopt, "gc-threshold"))
+            {
+              if (argi >= argc)
+                {
+                  fprintf(stderr, "expecting GC threshold");
+                  exit(1);
+                }
+
+              gc_threshold = (size_t)strtod(argv[argi++], NULL);
+              continue;
+            }
+
+          if (!strcmp(longopt, "gc-period"))
+            {
+              if (argi >= argc)
+                {
+                  fprintf(stderr, "expecting GC period");
+                  exit(1);
+                }
+
+              gc_data.period = (unsigned int)strtoul(argv[argi++], NULL, 0);
+              continue;
+            }
+
           if (!strcmp(longopt, "stack-size"))
             {
               if (argi >= argc)
@@ -613,9 +903,17 @@ int main(int argc, char *argv[])
 
   if (memory_limit != 0)
     JS_SetMemoryLimit(rt, memory_limit);
+  if (gc_threshold != 0)
+    JS_SetGCThreshold(rt, gc_threshold);
   if (stack_size != 0)
     JS_SetMaxStackSize(rt, stack_size);
 
+  if (gc_data.period != 0)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &gc_data.last);
+      JS_SetInterruptHandler(rt, js_gc_interrupt, &gc_data);
+    }
+
   ctx = JS_NewContext(rt);
 
   if (!ctx)
@@ -647,7 +945,21 @@ int main(int argc, char *argv[])
         {
           const char *filename;
           filename = argv[argi];
-          if (js_eval_file(ctx, filename, 1))
+          if (compile)
+            {
+              if (js_compile_file(ctx, filename, compile))
+                {
+                  goto fail;
+                }
+            }
+          else if (bytecode || has_suffix(filename, ".jsbc"))
+            {
+              if (js_eval_bytecode_file(ctx, filename))
+                {
+                  goto fail;
+                }
+            }
+          else if (js_eval_file(ctx, filename, 1))
             {
               goto fail;
             }
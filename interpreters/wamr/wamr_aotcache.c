@@ -0,0 +1,207 @@
+/****************************************************************************
+ * apps/interpreters/wamr/wamr_aotcache.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "netutils/sha256.h"
+#include "interpreters/wamr_aotcache.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define WAMR_AOTCACHE_PATH  CONFIG_INTERPRETERS_WAMR_AOT_CACHE_PATH
+
+/* <path>/<key>.aot and <path>/<key>.tmp */
+
+#define WAMR_AOTCACHE_PATHLEN \
+  (sizeof(WAMR_AOTCACHE_PATH) + WAMR_AOTCACHE_KEYLEN + 5)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wamr_aotcache_path
+ ****************************************************************************/
+
+static void wamr_aotcache_path(FAR const uint8_t *wasm, size_t len,
+                               FAR const char *ext, FAR char *path)
+{
+  char key[WAMR_AOTCACHE_KEYLEN + 1];
+
+  wamr_aotcache_key(wasm, len, key);
+  snprintf(path, WAMR_AOTCACHE_PATHLEN, "%s/%s.%s",
+           WAMR_AOTCACHE_PATH, key, ext);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wamr_aotcache_key
+ ****************************************************************************/
+
+void wamr_aotcache_key(FAR const uint8_t *wasm, size_t len, FAR char *key)
+{
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  int i;
+
+  sha256_sum(wasm, len, digest);
+
+  for (i = 0; i < SHA256_DIGEST_SIZE; i++)
+    {
+      snprintf(&key[2 * i], 3, "%02x", digest[i]);
+    }
+}
+
+/****************************************************************************
+ * Name: wamr_aotcache_open
+ ****************************************************************************/
+
+int wamr_aotcache_open(FAR const uint8_t *wasm, size_t len,
+                       FAR struct wamr_aotcache_s *aot)
+{
+  char path[WAMR_AOTCACHE_PATHLEN];
+  struct stat st;
+  FAR void *data;
+  int ret = OK;
+  int fd;
+
+  wamr_aotcache_path(wasm, len, "aot", path);
+
+  fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  if (fstat(fd, &st) < 0)
+    {
+      ret = -errno;
+      goto out;
+    }
+
+  if (st.st_size == 0)
+    {
+      ret = -ENOENT;
+      goto out;
+    }
+
+  /* The artifact stays in place on an XIP file system */
+
+  data = mmap(NULL, st.st_size, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED)
+    {
+      ret = -errno;
+      goto out;
+    }
+
+  aot->data = data;
+  aot->size = st.st_size;
+
+out:
+  close(fd);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: wamr_aotcache_close
+ ****************************************************************************/
+
+void wamr_aotcache_close(FAR struct wamr_aotcache_s *aot)
+{
+  munmap(aot->data, aot->size);
+  aot->data = NULL;
+  aot->size = 0;
+}
+
+/****************************************************************************
+ * Name: wamr_aotcache_store
+ ****************************************************************************/
+
+int wamr_aotcache_store(FAR const uint8_t *wasm, size_t len,
+                        FAR const void *data, size_t datalen)
+{
+  char path[WAMR_AOTCACHE_PATHLEN];
+  char tmp[WAMR_AOTCACHE_PATHLEN];
+  FAR const uint8_t *src = data;
+  ssize_t nbytes;
+  int ret = OK;
+  int fd;
+
+  wamr_aotcache_path(wasm, len, "aot", path);
+  wamr_aotcache_path(wasm, len, "tmp", tmp);
+
+  fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  while (datalen > 0)
+    {
+      nbytes = write(fd, src, datalen);
+      if (nbytes < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          ret = -errno;
+          break;
+        }
+
+      src     += nbytes;
+      datalen -= nbytes;
+    }
+
+  if (ret == OK && fsync(fd) < 0)
+    {
+      ret = -errno;
+    }
+
+  close(fd);
+
+  if (ret == OK && rename(tmp, path) < 0)
+    {
+      ret = -errno;
+    }
+
+  if (ret < 0)
+    {
+      unlink(tmp);
+    }
+
+  return ret;
+}
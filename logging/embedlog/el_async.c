@@ -0,0 +1,1271 @@
+/****************************************************************************
+ * apps/logging/embedlog/el_async.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/types.h>
+
+#include <logging/embedlog_async.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Room for "[sssssssssss.uuuuuu] l " in front of a text record */
+
+#define EL_ASYNC_PREFIX_MAX (32)
+
+/* Version of the deferred record frame, see el_decode.py */
+
+#define EL_ASYNC_FRAME_VERSION (1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_EMBEDLOG_ASYNC_DEFERRED
+/* Argument classes of a conversion */
+
+enum el_async_arg_e
+{
+  EL_ASYNC_ARG_NONE   = 0,      /* %% */
+  EL_ASYNC_ARG_INT    = 1,      /* 4 or 8 byte integer */
+  EL_ASYNC_ARG_DOUBLE = 2,      /* double */
+  EL_ASYNC_ARG_PTR    = 3,      /* uintptr_t */
+  EL_ASYNC_ARG_STR    = 4       /* Null terminated copy */
+};
+
+/* Parsed conversion specification */
+
+struct el_async_spec_s
+{
+  FAR const char *start;        /* '%' */
+  FAR const char *lmod;         /* Length modifier */
+  FAR const char *end;          /* Past the conversion */
+  uint8_t         lmod_len;
+  uint8_t         stars;        /* '*' width and precision */
+  uint8_t         arg;          /* enum el_async_arg_e */
+  uint8_t         size;         /* Packed size of the argument */
+  char            conv;
+};
+
+/* Deferred record frame for the host decoder, little-endian.  The
+ * payload is the format address followed by the packed arguments.
+ */
+
+begin_packed_struct struct el_async_frame_s
+{
+  uint8_t  magic[2];            /* "EL" */
+  uint8_t  version;             /* EL_ASYNC_FRAME_VERSION */
+  uint8_t  ptrsize;             /* sizeof(uintptr_t) on the target */
+  uint8_t  level;
+  uint8_t  reserved;
+  uint16_t len;                 /* Payload length */
+  uint32_t sec;                 /* Capture timestamp */
+  uint32_t usec;
+} end_packed_struct;
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Level markers, indexed by enum el_level */
+
+static const char g_el_async_levels[] = "facewnid";
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: el_async_wake
+ *
+ * Description:
+ *   Wake the writer if it sleeps.  Only the first producer that finds it
+ *   asleep posts the semaphore.
+ *
+ ****************************************************************************/
+
+static void el_async_wake(FAR struct el_async_s *a)
+{
+  if (atomic_exchange(&a->sleeping, false))
+    {
+      sem_post(&a->wake);
+    }
+}
+
+/****************************************************************************
+ * Name: el_async_reserve
+ *
+ * Description:
+ *   Claim the next free slot.  Returns NULL if the queue is full.
+ *
+ ****************************************************************************/
+
+static FAR struct el_async_slot_s *
+el_async_reserve(FAR struct el_async_s *a, FAR size_t *pos)
+{
+  FAR struct el_async_slot_s *slot = NULL;
+  size_t                      seq  = 0;
+  intptr_t                    diff = 0;
+
+  *pos = atomic_load_explicit(&a->head, memory_order_relaxed);
+
+  for (; ; )
+    {
+      slot = &a->slots[*pos & a->mask];
+      seq  = atomic_load_explicit(&slot->seq, memory_order_acquire);
+      diff = (intptr_t)(seq - *pos);
+
+      if (diff == 0)
+        {
+          /* Slot is free, try to claim it */
+
+          if (atomic_compare_exchange_weak_explicit(&a->head, pos,
+                                                    *pos + 1,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed))
+            {
+              return slot;
+            }
+        }
+      else if (diff < 0)
+        {
+          /* The writer has not released this slot yet */
+
+          return NULL;
+        }
+      else
+        {
+          /* Another producer claimed it, retry with the new head */
+
+          *pos = atomic_load_explicit(&a->head, memory_order_relaxed);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: el_async_get
+ *
+ * Description:
+ *   Claim a slot according to the overflow policy
+ *
+ ****************************************************************************/
+
+static FAR struct el_async_slot_s *
+el_async_get(FAR struct el_async_s *a, FAR size_t *pos)
+{
+  FAR struct el_async_slot_s *slot = NULL;
+  size_t                      fill = 0;
+
+  for (; ; )
+    {
+      slot = el_async_reserve(a, pos);
+      if (slot != NULL)
+        {
+          /* Wake the writer early when the queue is half full,
+           * otherwise it batches records until its period expires.
+           */
+
+          fill = *pos + 1 - atomic_load_explicit(&a->tail,
+                                                 memory_order_relaxed);
+          if (fill > (a->mask >> 1))
+            {
+              el_async_wake(a);
+            }
+
+          return slot;
+        }
+
+      el_async_wake(a);
+
+      if (a->cfg.policy == EL_ASYNC_DROP)
+        {
+          atomic_fetch_add_explicit(&a->dropped, 1, memory_order_relaxed);
+          return NULL;
+        }
+
+      /* Wait for the writer to release slots */
+
+      atomic_fetch_add(&a->waiters, 1);
+      sem_wait(&a->space);
+    }
+}
+
+/****************************************************************************
+ * Name: el_async_commit
+ ****************************************************************************/
+
+static void el_async_commit(FAR struct el_async_slot_s *slot, size_t pos)
+{
+  atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+}
+
+/****************************************************************************
+ * Name: el_async_write
+ *
+ * Description:
+ *   Write the batch buffer with a single embedlog call
+ *
+ ****************************************************************************/
+
+static void el_async_write(FAR struct el_async_s *a)
+{
+  if (a->batch_i == 0)
+    {
+      return;
+    }
+
+  a->batch[a->batch_i] = '\0';
+  el_oputs(a->cfg.el, a->batch);
+
+  a->batch_i = 0;
+  atomic_fetch_add_explicit(&a->batches, 1, memory_order_relaxed);
+}
+
+/****************************************************************************
+ * Name: el_async_text
+ *
+ * Description:
+ *   Append a text record to the batch buffer
+ *
+ ****************************************************************************/
+
+static void el_async_text(FAR struct el_async_s *a,
+                          FAR struct el_async_slot_s *slot,
+                          FAR const char *data, size_t len)
+{
+  char hdr[EL_ASYNC_PREFIX_MAX];
+  int  n = 0;
+
+  n = snprintf(hdr, sizeof(hdr), "[%lld.%06ld] %c ",
+               (long long)slot->ts.tv_sec, slot->ts.tv_nsec / 1000,
+               g_el_async_levels[MIN(slot->level, 7)]);
+  n = MIN(n, (int)sizeof(hdr) - 1);
+
+  /* Prefix, message, new line and the terminating null */
+
+  if (a->batch_i + n + len + 2 > a->cfg.batch_len)
+    {
+      el_async_write(a);
+    }
+
+  memcpy(&a->batch[a->batch_i], hdr, n);
+  a->batch_i += n;
+  memcpy(&a->batch[a->batch_i], data, len);
+  a->batch_i += len;
+  a->batch[a->batch_i++] = '\n';
+}
+
+#ifdef CONFIG_EMBEDLOG_ASYNC_DEFERRED
+/****************************************************************************
+ * Name: el_async_spec
+ *
+ * Description:
+ *   Parse the conversion specification at fmt ('%').  Returns a pointer
+ *   past it, or NULL if the conversion is not supported.
+ *
+ ****************************************************************************/
+
+static FAR const char *el_async_spec(FAR const char *fmt,
+                                     FAR struct el_async_spec_s *spec)
+{
+  FAR const char *p = fmt + 1;
+
+  memset(spec, 0, sizeof(struct el_async_spec_s));
+  spec->start = fmt;
+
+  /* Flags, width and precision */
+
+  while (*p != '\0' && strchr("-+ #0'", *p) != NULL)
+    {
+      p++;
+    }
+
+  if (*p == '*')
+    {
+      spec->stars++;
+      p++;
+    }
+
+  while (isdigit(*p))
+    {
+      p++;
+    }
+
+  if (*p == '.')
+    {
+      p++;
+      if (*p == '*')
+        {
+          spec->stars++;
+          p++;
+        }
+
+      while (isdigit(*p))
+        {
+          p++;
+        }
+    }
+
+  /* Length modifier */
+
+  spec->lmod = p;
+  while (*p != '\0' && strchr("hljztLq", *p) != NULL)
+    {
+      p++;
+    }
+
+  spec->lmod_len = p - spec->lmod;
+
+  switch (*p)
+    {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'o':
+      case 'x':
+      case 'X':
+      case 'c':
+        {
+          spec->arg = EL_ASYNC_ARG_INT;
+
+          /* long, size_t and ptrdiff_t follow the pointer size,
+           * long long and intmax_t are 64-bit, the rest is promoted to int.
+           */
+
+          if (spec->lmod_len == 0 || spec->lmod[0] == 'h')
+            {
+              spec->size = 4;
+            }
+          else if ((spec->lmod[0] == 'l' && spec->lmod_len == 1) ||
+                   spec->lmod[0] == 'z' || spec->lmod[0] == 't')
+            {
+              spec->size = sizeof(uintptr_t);
+            }
+          else
+            {
+              spec->size = 8;
+            }
+
+          break;
+        }
+
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+        {
+          spec->arg  = EL_ASYNC_ARG_DOUBLE;
+          spec->size = sizeof(double);
+          break;
+        }
+
+      case 'p':
+        {
+          spec->arg  = EL_ASYNC_ARG_PTR;
+          spec->size = sizeof(uintptr_t);
+          break;
+        }
+
+      case 's':
+        {
+          spec->arg = EL_ASYNC_ARG_STR;
+          break;
+        }
+
+      case '%':
+        {
+          spec->arg = EL_ASYNC_ARG_NONE;
+          break;
+        }
+
+      default:
+        {
+          /* %n and unknown conversions */
+
+          return NULL;
+        }
+    }
+
+  spec->conv = *p;
+  spec->end  = p + 1;
+
+  return spec->end;
+}
+
+/****************************************************************************
+ * Name: el_async_put
+ ****************************************************************************/
+
+static int el_async_put(FAR char *buf, size_t size, FAR size_t *i,
+                        FAR const void *val, size_t len)
+{
+  if (*i + len > size)
+    {
+      return -E2BIG;
+    }
+
+  memcpy(&buf[*i], val, len);
+  *i += len;
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: el_async_pack
+ *
+ * Description:
+ *   Store the format address and the raw arguments in buf.  Strings are
+ *   copied, they may not outlive the call.  Returns the packed length.
+ *
+ ****************************************************************************/
+
+static int el_async_pack(FAR char *buf, size_t size, FAR const char *fmt,
+                         va_list ap)
+{
+  struct el_async_spec_s spec;
+  FAR const char        *str   = NULL;
+  uintptr_t              addr  = (uintptr_t)fmt;
+  long long              ival  = 0;
+  int32_t                i32   = 0;
+  int64_t                i64   = 0;
+  double                 dval  = 0.0;
+  size_t                 i     = 0;
+  size_t                 len   = 0;
+  int                    ret   = OK;
+  int                    j     = 0;
+
+  ret = el_async_put(buf, size, &i, &addr, sizeof(addr));
+
+  while (ret == OK && (fmt = strchr(fmt, '%')) != NULL)
+    {
+      fmt = el_async_spec(fmt, &spec);
+      if (fmt == NULL)
+        {
+          return -EINVAL;
+        }
+
+      for (j = 0; j < spec.stars && ret == OK; j++)
+        {
+          i32 = va_arg(ap, int);
+          ret = el_async_put(buf, size, &i, &i32, sizeof(i32));
+        }
+
+      switch (spec.arg)
+        {
+          case EL_ASYNC_ARG_INT:
+            {
+              /* va_arg must see the promoted type of the argument */
+
+              if (spec.lmod_len == 0 || spec.lmod[0] == 'h')
+                {
+                  ival = va_arg(ap, int);
+                }
+              else if (spec.lmod[0] == 'l' && spec.lmod_len == 1)
+                {
+                  ival = va_arg(ap, long);
+                }
+              else if (spec.lmod[0] == 'j')
+                {
+                  ival = va_arg(ap, intmax_t);
+                }
+              else if (spec.lmod[0] == 'z')
+                {
+                  ival = va_arg(ap, ssize_t);
+                }
+              else if (spec.lmod[0] == 't')
+                {
+                  ival = va_arg(ap, ptrdiff_t);
+                }
+              else
+                {
+                  ival = va_arg(ap, long long);
+                }
+
+              if (spec.size == 4)
+                {
+                  i32 = (int32_t)ival;
+                  ret = el_async_put(buf, size, &i, &i32, sizeof(i32));
+                }
+              else
+                {
+                  i64 = (int64_t)ival;
+                  ret = el_async_put(buf, size, &i, &i64, sizeof(i64));
+                }
+
+              break;
+            }
+
+          case EL_ASYNC_ARG_DOUBLE:
+            {
+              if (spec.lmod_len > 0 && spec.lmod[0] == 'L')
+                {
+                  dval = (double)va_arg(ap, long double);
+                }
+              else
+                {
+                  dval = va_arg(ap, double);
+                }
+
+              ret = el_async_put(buf, size, &i, &dval, sizeof(dval));
+              break;
+            }
+
+          case EL_ASYNC_ARG_PTR:
+            {
+              addr = (uintptr_t)va_arg(ap, FAR void *);
+              ret  = el_async_put(buf, size, &i, &addr, sizeof(addr));
+              break;
+            }
+
+          case EL_ASYNC_ARG_STR:
+            {
+              str = va_arg(ap, FAR const char *);
+              if (str == NULL)
+                {
+                  str = "(null)";
+                }
+
+              /* Truncate long strings, the rest of the record still fits
+               * if the format does.
+               */
+
+              len = strnlen(str, size > i ? size - i - 1 : 0);
+              ret = el_async_put(buf, size, &i, str, len);
+              if (ret == OK)
+                {
+                  ret = el_async_put(buf, size, &i, "", 1);
+                }
+
+              break;
+            }
+
+          default:
+            {
+              break;
+            }
+        }
+    }
+
+  return ret < 0 ? ret : (int)i;
+}
+
+/****************************************************************************
+ * Name: el_async_read
+ ****************************************************************************/
+
+static bool el_async_read(FAR const char *data, size_t len, FAR size_t *i,
+                          FAR void *val, size_t size)
+{
+  if (*i + size > len)
+    {
+      return false;
+    }
+
+  memcpy(val, &data[*i], size);
+  *i += size;
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: el_async_unpack
+ *
+ * Description:
+ *   Format a deferred record into out.  Returns the formatted length.
+ *
+ ****************************************************************************/
+
+static size_t el_async_unpack(FAR const char *data, size_t len,
+                              FAR char *out, size_t size)
+{
+  struct el_async_spec_s spec;
+  FAR const char        *fmt   = NULL;
+  FAR const char        *next  = NULL;
+  FAR const char        *str   = NULL;
+  char                   sp[32];
+  uintptr_t              addr  = 0;
+  int32_t                st[2];
+  int32_t                i32   = 0;
+  int64_t                i64   = 0;
+  double                 dval  = 0.0;
+  size_t                 i     = 0;
+  size_t                 o     = 0;
+  size_t                 n     = 0;
+  int                    ret   = 0;
+  int                    j     = 0;
+
+  if (!el_async_read(data, len, &i, &addr, sizeof(addr)))
+    {
+      return 0;
+    }
+
+  fmt = (FAR const char *)addr;
+
+  while (o < size - 1 && (next = strchr(fmt, '%')) != NULL)
+    {
+      /* Literal text up to the conversion */
+
+      n = MIN((size_t)(next - fmt), size - 1 - o);
+      memcpy(&out[o], fmt, n);
+      o += n;
+
+      fmt = el_async_spec(next, &spec);
+      if (fmt == NULL || spec.stars > 2)
+        {
+          fmt = next;
+          break;
+        }
+
+      if (spec.arg == EL_ASYNC_ARG_NONE)
+        {
+          out[o++] = '%';
+          continue;
+        }
+
+      for (j = 0; j < spec.stars; j++)
+        {
+          if (!el_async_read(data, len, &i, &st[j], sizeof(st[j])))
+            {
+              goto truncated;
+            }
+        }
+
+      /* Rebuild the specification with the length modifier of the packed
+       * argument.
+       */
+
+      n = MIN((size_t)(spec.lmod - spec.start), sizeof(sp) - 4);
+      memcpy(sp, spec.start, n);
+      if (spec.arg == EL_ASYNC_ARG_INT)
+        {
+          if (spec.size == 8)
+            {
+              sp[n++] = 'l';
+              sp[n++] = 'l';
+            }
+          else if (spec.lmod_len > 0 && spec.lmod[0] == 'h')
+            {
+              sp[n++] = 'h';
+              if (spec.lmod_len > 1)
+                {
+                  sp[n++] = 'h';
+                }
+            }
+        }
+
+      sp[n++] = spec.conv;
+      sp[n]   = '\0';
+
+#define EL_ASYNC_FORMAT(v)                                               \
+      (spec.stars == 0 ? snprintf(&out[o], size - o, sp, v) :            \
+       spec.stars == 1 ? snprintf(&out[o], size - o, sp, st[0], v) :     \
+       snprintf(&out[o], size - o, sp, st[0], st[1], v))
+
+      switch (spec.arg)
+        {
+          case EL_ASYNC_ARG_INT:
+            {
+              if (spec.size == 4)
+                {
+                  if (!el_async_read(data, len, &i, &i32, sizeof(i32)))
+                    {
+                      goto truncated;
+                    }
+
+                  ret = EL_ASYNC_FORMAT((int)i32);
+                }
+              else
+                {
+                  if (!el_async_read(data, len, &i, &i64, sizeof(i64)))
+                    {
+                      goto truncated;
+                    }
+
+                  ret = EL_ASYNC_FORMAT((long long)i64);
+                }
+
+              break;
+            }
+
+          case EL_ASYNC_ARG_DOUBLE:
+            {
+              if (!el_async_read(data, len, &i, &dval, sizeof(dval)))
+                {
+                  goto truncated;
+                }
+
+              ret = EL_ASYNC_FORMAT(dval);
+              break;
+            }
+
+          case EL_ASYNC_ARG_PTR:
+            {
+              if (!el_async_read(data, len, &i, &addr, sizeof(addr)))
+                {
+                  goto truncated;
+                }
+
+              ret = EL_ASYNC_FORMAT((FAR void *)addr);
+              break;
+            }
+
+          case EL_ASYNC_ARG_STR:
+            {
+              str = &data[i];
+              n   = strnlen(str, len - i);
+              if (i + n >= len)
+                {
+                  goto truncated;
+                }
+
+              i  += n + 1;
+              ret = EL_ASYNC_FORMAT(str);
+              break;
+            }
+
+          default:
+            {
+              ret = 0;
+              break;
+            }
+        }
+
+#undef EL_ASYNC_FORMAT
+
+      o += MIN((size_t)MAX(ret, 0), size - 1 - o);
+    }
+
+  /* Trailing literal text */
+
+  if (fmt != NULL)
+    {
+      n = MIN(strlen(fmt), size - 1 - o);
+      memcpy(&out[o], fmt, n);
+      o += n;
+    }
+
+  return o;
+
+truncated:
+  return o;
+}
+
+/****************************************************************************
+ * Name: el_async_deferred
+ *
+ * Description:
+ *   Format a deferred record, or pass it on for the host decoder
+ *
+ ****************************************************************************/
+
+static void el_async_deferred(FAR struct el_async_s *a,
+                              FAR struct el_async_slot_s *slot)
+{
+  char   line[CONFIG_EMBEDLOG_ASYNC_RECORD_MAX];
+  size_t n = 0;
+
+#ifdef CONFIG_EMBEDLOG_ENABLE_BINARY_LOGS
+  if (a->cfg.offline)
+    {
+      struct el_async_frame_s frame;
+      char buf[sizeof(struct el_async_frame_s) +
+               CONFIG_EMBEDLOG_ASYNC_RECORD_MAX];
+
+      frame.magic[0] = 'E';
+      frame.magic[1] = 'L';
+      frame.version  = EL_ASYNC_FRAME_VERSION;
+      frame.ptrsize  = sizeof(uintptr_t);
+      frame.level    = slot->level;
+      frame.reserved = 0;
+      frame.len      = slot->len;
+      frame.sec      = slot->ts.tv_sec;
+      frame.usec     = slot->ts.tv_nsec / 1000;
+
+      memcpy(buf, &frame, sizeof(frame));
+      memcpy(&buf[sizeof(frame)], slot->data, slot->len);
+
+      /* Keep the records in order */
+
+      el_async_write(a);
+      el_opbinary(slot->level, a->cfg.el, buf, sizeof(frame) + slot->len);
+      return;
+    }
+#endif
+
+  n = el_async_unpack(slot->data, slot->len, line, sizeof(line));
+  el_async_text(a, slot, line, n);
+}
+#endif
+
+/****************************************************************************
+ * Name: el_async_drain
+ *
+ * Description:
+ *   Write all published records
+ *
+ ****************************************************************************/
+
+static void el_async_drain(FAR struct el_async_s *a)
+{
+  FAR struct el_async_slot_s *slot  = NULL;
+  size_t                      tail  = 0;
+  size_t                      seq   = 0;
+  size_t                      n     = 0;
+
+  tail = atomic_load_explicit(&a->tail, memory_order_relaxed);
+
+  for (; ; )
+    {
+      slot = &a->slots[tail & a->mask];
+      seq  = atomic_load_explicit(&slot->seq, memory_order_acquire);
+      if (seq != tail + 1)
+        {
+          break;
+        }
+
+      switch (slot->type)
+        {
+          case EL_ASYNC_TEXT:
+            {
+              el_async_text(a, slot, slot->data, slot->len);
+              break;
+            }
+
+#ifdef CONFIG_EMBEDLOG_ASYNC_DEFERRED
+          case EL_ASYNC_DEFERRED:
+            {
+              el_async_deferred(a, slot);
+              break;
+            }
+#endif
+
+#ifdef CONFIG_EMBEDLOG_ENABLE_BINARY_LOGS
+          case EL_ASYNC_BINARY:
+            {
+              /* Keep the records in order */
+
+              el_async_write(a);
+              el_opbinary(slot->level, a->cfg.el, slot->data, slot->len);
+              break;
+            }
+#endif
+
+          default:
+            {
+              DEBUGASSERT(0);
+              break;
+            }
+        }
+
+      /* Release the slot for the next lap */
+
+      atomic_store_explicit(&slot->seq, tail + a->mask + 1,
+                            memory_order_release);
+      tail += 1;
+      atomic_store_explicit(&a->tail, tail, memory_order_relaxed);
+      atomic_fetch_add_explicit(&a->written, 1, memory_order_relaxed);
+
+      /* Resume blocked producers */
+
+      if (atomic_load_explicit(&a->waiters, memory_order_relaxed) > 0)
+        {
+          n = atomic_exchange(&a->waiters, 0);
+          while (n-- > 0)
+            {
+              sem_post(&a->space);
+            }
+        }
+    }
+
+  el_async_write(a);
+}
+
+/****************************************************************************
+ * Name: el_async_thread
+ ****************************************************************************/
+
+static FAR void *el_async_thread(FAR void *arg)
+{
+  FAR struct el_async_s *a       = (FAR struct el_async_s *)arg;
+  struct timespec        abstime;
+  size_t                 flush   = 0;
+
+  while (!atomic_load(&a->exit))
+    {
+      /* Sleep for the batching period unless producers wake us */
+
+      clock_gettime(CLOCK_REALTIME, &abstime);
+      abstime.tv_sec  += a->cfg.period_ms / 1000;
+      abstime.tv_nsec += (a->cfg.period_ms % 1000) * 1000000;
+      if (abstime.tv_nsec >= 1000000000)
+        {
+          abstime.tv_sec  += 1;
+          abstime.tv_nsec -= 1000000000;
+        }
+
+      atomic_store(&a->sleeping, true);
+      sem_timedwait(&a->wake, &abstime);
+      atomic_store(&a->sleeping, false);
+
+      /* Take the flush requests before draining, so everything queued by
+       * the requesters is written when they are released.
+       */
+
+      flush = atomic_exchange(&a->flushers, 0);
+
+      el_async_drain(a);
+
+      if (flush > 0)
+        {
+          el_oflush(a->cfg.el);
+
+          while (flush-- > 0)
+            {
+              sem_post(&a->flushed);
+            }
+        }
+    }
+
+  el_async_drain(a);
+  el_oflush(a->cfg.el);
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: el_async_init
+ ****************************************************************************/
+
+int el_async_init(FAR struct el_async_s *a,
+                  FAR const struct el_async_cfg_s *cfg)
+{
+  pthread_attr_t     attr;
+  struct sched_param param;
+  size_t             i   = 0;
+  int                ret = OK;
+
+  DEBUGASSERT(a);
+  DEBUGASSERT(cfg);
+  DEBUGASSERT(cfg->el);
+  DEBUGASSERT(cfg->records > 1);
+  DEBUGASSERT((cfg->records & (cfg->records - 1)) == 0);
+
+  /* A batch must hold at least one full record */
+
+  DEBUGASSERT(cfg->batch_len >= EL_ASYNC_PREFIX_MAX +
+              CONFIG_EMBEDLOG_ASYNC_RECORD_MAX + 2);
+
+  memset(a, 0, sizeof(struct el_async_s));
+  memcpy(&a->cfg, cfg, sizeof(struct el_async_cfg_s));
+
+  a->mask  = cfg->records - 1;
+  a->slots = malloc(cfg->records * sizeof(struct el_async_slot_s));
+  a->batch = malloc(cfg->batch_len);
+  if (a->slots == NULL || a->batch == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  for (i = 0; i < cfg->records; i++)
+    {
+      atomic_init(&a->slots[i].seq, i);
+    }
+
+  sem_init(&a->wake, 0, 0);
+  sem_init(&a->space, 0, 0);
+  sem_init(&a->flushed, 0, 0);
+
+  /* The writer runs at a low priority, the callers never wait for it */
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, cfg->stacksize);
+  param.sched_priority = cfg->priority;
+  pthread_attr_setschedparam(&attr, &param);
+
+  ret = pthread_create(&a->thread, &attr, el_async_thread, a);
+  pthread_attr_destroy(&attr);
+  if (ret != 0)
+    {
+      ret = -ret;
+      sem_destroy(&a->flushed);
+      sem_destroy(&a->space);
+      sem_destroy(&a->wake);
+      goto errout;
+    }
+
+  pthread_setname_np(a->thread, "el_async");
+
+  return OK;
+
+errout:
+  free(a->batch);
+  free(a->slots);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: el_async_deinit
+ ****************************************************************************/
+
+void el_async_deinit(FAR struct el_async_s *a)
+{
+  DEBUGASSERT(a);
+
+  atomic_store(&a->exit, true);
+  sem_post(&a->wake);
+  pthread_join(a->thread, NULL);
+
+  sem_destroy(&a->flushed);
+  sem_destroy(&a->space);
+  sem_destroy(&a->wake);
+
+  free(a->batch);
+  free(a->slots);
+}
+
+/****************************************************************************
+ * Name: el_async_vprint
+ ****************************************************************************/
+
+int el_async_vprint(FAR struct el_async_s *a, int level,
+                    FAR const char *fmt, va_list ap)
+{
+  FAR struct el_async_slot_s *slot = NULL;
+  size_t                      pos  = 0;
+  int                         ret  = 0;
+
+  DEBUGASSERT(a);
+  DEBUGASSERT(fmt);
+
+  if (level > a->cfg.level)
+    {
+      return OK;
+    }
+
+  slot = el_async_get(a, &pos);
+  if (slot == NULL)
+    {
+      return -EAGAIN;
+    }
+
+  clock_gettime(CLOCK_REALTIME, &slot->ts);
+
+  ret = vsnprintf(slot->data, sizeof(slot->data), fmt, ap);
+  ret = MAX(ret, 0);
+
+  slot->len   = MIN(ret, (int)sizeof(slot->data) - 1);
+  slot->level = level;
+  slot->type  = EL_ASYNC_TEXT;
+
+  el_async_commit(slot, pos);
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: el_async_print
+ ****************************************************************************/
+
+int el_async_print(FAR struct el_async_s *a, int level,
+                   FAR const char *fmt, ...)
+{
+  va_list ap;
+  int     ret;
+
+  va_start(ap, fmt);
+  ret = el_async_vprint(a, level, fmt, ap);
+  va_end(ap);
+
+  return ret;
+}
+
+#ifdef CONFIG_EMBEDLOG_ENABLE_BINARY_LOGS
+/****************************************************************************
+ * Name: el_async_binary
+ ****************************************************************************/
+
+int el_async_binary(FAR struct el_async_s *a, int level,
+                    FAR const void *data, size_t len)
+{
+  FAR struct el_async_slot_s *slot = NULL;
+  size_t                      pos  = 0;
+
+  DEBUGASSERT(a);
+  DEBUGASSERT(data);
+
+  if (len > sizeof(slot->data))
+    {
+      return -E2BIG;
+    }
+
+  if (level > a->cfg.level)
+    {
+      return OK;
+    }
+
+  slot = el_async_get(a, &pos);
+  if (slot == NULL)
+    {
+      return -EAGAIN;
+    }
+
+  clock_gettime(CLOCK_REALTIME, &slot->ts);
+  memcpy(slot->data, data, len);
+
+  slot->len   = len;
+  slot->level = level;
+  slot->type  = EL_ASYNC_BINARY;
+
+  el_async_commit(slot, pos);
+
+  return OK;
+}
+#endif
+
+#ifdef CONFIG_EMBEDLOG_ASYNC_DEFERRED
+/****************************************************************************
+ * Name: el_async_vdprint
+ ****************************************************************************/
+
+int el_async_vdprint(FAR struct el_async_s *a, int level,
+                     FAR const char *fmt, va_list ap)
+{
+  FAR struct el_async_slot_s *slot = NULL;
+  size_t                      pos  = 0;
+  int                         ret  = 0;
+
+  DEBUGASSERT(a);
+  DEBUGASSERT(fmt);
+
+  if (level > a->cfg.level)
+    {
+      return OK;
+    }
+
+  slot = el_async_get(a, &pos);
+  if (slot == NULL)
+    {
+      return -EAGAIN;
+    }
+
+  clock_gettime(CLOCK_REALTIME, &slot->ts);
+
+  slot->level = level;
+  slot->type  = EL_ASYNC_DEFERRED;
+
+  ret = el_async_pack(slot->data, sizeof(slot->data), fmt, ap);
+  if (ret < 0)
+    {
+      /* Arguments do not fit or cannot be deferred, log the format */
+
+      slot->len  = MIN(strlen(fmt), sizeof(slot->data));
+      slot->type = EL_ASYNC_TEXT;
+      memcpy(slot->data, fmt, slot->len);
+    }
+  else
+    {
+      slot->len = ret;
+    }
+
+  el_async_commit(slot, pos);
+
+  return ret < 0 ? ret : OK;
+}
+
+/****************************************************************************
+ * Name: el_async_dprint
+ ****************************************************************************/
+
+int el_async_dprint(FAR struct el_async_s *a, int level,
+                    FAR const char *fmt, ...)
+{
+  va_list ap;
+  int     ret;
+
+  va_start(ap, fmt);
+  ret = el_async_vdprint(a, level, fmt, ap);
+  va_end(ap);
+
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: el_async_flush
+ ****************************************************************************/
+
+int el_async_flush(FAR struct el_async_s *a)
+{
+  DEBUGASSERT(a);
+
+  atomic_fetch_add(&a->flushers, 1);
+  sem_post(&a->wake);
+
+  while (sem_wait(&a->flushed) < 0)
+    {
+      if (errno != EINTR)
+        {
+          return -errno;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: el_async_stats
+ ****************************************************************************/
+
+void el_async_stats(FAR struct el_async_s *a,
+                    FAR struct el_async_stats_s *stats)
+{
+  DEBUGASSERT(a);
+  DEBUGASSERT(stats);
+
+  stats->queued  = (atomic_load(&a->head) - atomic_load(&a->tail));
+  stats->written = atomic_load(&a->written);
+  stats->dropped = atomic_load(&a->dropped);
+  stats->batches = atomic_load(&a->batches);
+}
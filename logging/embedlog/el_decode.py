@@ -0,0 +1,204 @@
+#!/usr/bin/env python3
+# apps/logging/embedlog/el_decode.py
+#
+# Licensed to the Apache Software Foundation (ASF) under one or more
+# contributor license agreements.  See the NOTICE file distributed with
+# this work for additional information regarding copyright ownership.  The
+# ASF licenses this file to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance with the
+# License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+# License for the specific language governing permissions and limitations
+# under the License.
+#
+"""Decode deferred embedlog records (el_async_dprint() with cfg->offline)
+stored in a binary log, looking the format strings up in the firmware ELF.
+
+  el_decode.py nuttx log.bin           # print decoded records
+  el_decode.py nuttx log.bin -o log.txt
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b"EL"
+VERSION = 1
+HEADER = struct.Struct("<2sBBBBHII")
+LEVELS = "facewnid"
+
+SPEC = re.compile(
+    rb"%([-+ #0']*)(\*|\d+)?(?:\.(\*|\d*))?"
+    rb"(hh|h|ll|l|j|z|t|L|q)?([diuoxXceEfFgGaAps%])"
+)
+
+
+class Elf:
+    """Minimal ELF reader, enough to read strings from loaded sections."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+        is64 = self.data[4] == 2
+        end = "<" if self.data[5] == 1 else ">"
+        if is64:
+            shoff, shentsize, shnum = struct.unpack_from(
+                end + "Q10xHH", self.data, 40
+            )
+            sh = struct.Struct(end + "IIQQQQ")
+        else:
+            shoff, shentsize, shnum = struct.unpack_from(
+                end + "I10xHH", self.data, 32
+            )
+            sh = struct.Struct(end + "IIIIII")
+        self.sections = []
+        for i in range(shnum):
+            _, stype, _, addr, offset, size = sh.unpack_from(
+                self.data, shoff + i * shentsize
+            )
+            # Skip NOBITS (.bss) and sections not loaded to memory
+            if addr != 0 and stype != 8:
+                self.sections.append((addr, offset, size))
+
+    def string(self, addr):
+        for start, offset, size in self.sections:
+            if start <= addr < start + size:
+                pos = offset + addr - start
+                return self.data[pos : self.data.index(b"\0", pos)]
+        return None
+
+
+def format_record(fmt, args, ptrsize):
+    """printf the packed arguments the same way el_async_unpack() does."""
+    out = b""
+    pos = 0
+    i = 0
+
+    def take(size, kind):
+        nonlocal i
+        value = struct.unpack_from("<" + kind, args, i)[0]
+        i += size
+        return value
+
+    for m in SPEC.finditer(fmt):
+        out += fmt[pos : m.start()]
+        pos = m.end()
+        flags, width, prec, lmod, conv = m.groups()
+        conv = conv.decode()
+        if conv == "%":
+            out += b"%"
+            continue
+        if width == b"*":
+            width = b"%d" % take(4, "i")
+        if prec == b"*":
+            prec = b"%d" % take(4, "i")
+        spec = "%" + (flags or b"").decode() + (width or b"").decode()
+        if prec is not None:
+            spec += "." + prec.decode()
+
+        if conv in "diuoxXc":
+            if not lmod or lmod.startswith(b"h"):
+                size = 4
+            elif lmod in (b"l", b"z", b"t"):
+                size = ptrsize
+            else:
+                size = 8
+            value = take(size, "i" if size == 4 else "q")
+            if conv == "c":
+                out += ((spec + "c") % chr(value & 0xFF)).encode()
+                continue
+            if conv in "uoxX":
+                value &= (1 << (8 * size)) - 1
+            out += ((spec + ("d" if conv in "iu" else conv)) % value).encode()
+        elif conv in "eEfFgGaA":
+            value = take(8, "d")
+            if conv in "aA":
+                out += value.hex().encode()
+            else:
+                out += ((spec + conv) % value).encode()
+        elif conv == "p":
+            value = take(ptrsize, "I" if ptrsize == 4 else "Q")
+            out += ((spec + "s") % ("0x%x" % value)).encode()
+        else:
+            end = args.index(b"\0", i)
+            out += ((spec + "s") % args[i:end].decode(errors="replace")).encode()
+            i = end + 1
+
+    return out + fmt[pos:]
+
+
+def decode(elf, data, out):
+    records = 0
+    skipped = 0
+    pos = 0
+
+    while True:
+        start = data.find(MAGIC, pos)
+        if start < 0 or start + HEADER.size > len(data):
+            break
+        _, version, ptrsize, level, _, length, sec, usec = HEADER.unpack_from(
+            data, start
+        )
+        payload = data[start + HEADER.size : start + HEADER.size + length]
+        if (
+            version != VERSION
+            or ptrsize not in (4, 8)
+            or level >= len(LEVELS)
+            or len(payload) != length
+            or length < ptrsize
+        ):
+            pos = start + 1
+            continue
+
+        # Anything between frames is embedlog's own binary metadata
+        skipped += start - pos
+        pos = start + HEADER.size + length
+
+        addr = struct.unpack_from("<I" if ptrsize == 4 else "<Q", payload)[0]
+        fmt = elf.string(addr)
+        if fmt is None:
+            msg = b"<unknown format 0x%x>" % addr
+        else:
+            try:
+                msg = format_record(fmt, payload[ptrsize:], ptrsize)
+            except (struct.error, ValueError):
+                msg = fmt + b" <bad arguments>"
+
+        prefix = b"[%d.%06d] %c " % (sec, usec, ord(LEVELS[level]))
+        out.write(prefix + msg + b"\n")
+        records += 1
+
+    return records, skipped
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF file with the format strings")
+    parser.add_argument("log", help="binary log file")
+    parser.add_argument("-o", "--output", help="write to file instead of stdout")
+    args = parser.parse_args()
+
+    elf = Elf(args.elf)
+    with open(args.log, "rb") as f:
+        data = f.read()
+
+    out = open(args.output, "wb") if args.output else sys.stdout.buffer
+    try:
+        records, skipped = decode(elf, data, out)
+    finally:
+        if args.output:
+            out.close()
+
+    print("%d records, %d bytes skipped" % (records, skipped), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
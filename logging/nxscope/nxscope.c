@@ -30,6 +30,10 @@
 #include <string.h>
 #include <stdlib.h>
 
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+#  include <stdatomic.h>
+#endif
+
 #include <logging/nxscope/nxscope.h>
 
 #include "nxscope_internals.h"
@@ -497,6 +501,115 @@ static bool nxscope_stream_empty(FAR struct nxscope_s *s)
     }
 }
 
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+/****************************************************************************
+ * Name: nxscope_rings_merge
+ *
+ * Description:
+ *   Move the samples from the producer rings to the stream buffer.
+ *   Returns true if some samples are left because the stream buffer is
+ *   full.
+ *
+ * NOTE: This function assumes that we have exclusive access to the nxscope
+ *       instance
+ *
+ ****************************************************************************/
+
+static bool nxscope_rings_merge(FAR struct nxscope_s *s)
+{
+  FAR struct nxscope_ring_s *ring    = NULL;
+  bool                       pending = false;
+  size_t                     head    = 0;
+  size_t                     tail    = 0;
+  size_t                     size    = 0;
+  size_t                     len     = 0;
+  size_t                     off     = 0;
+  int                        i       = 0;
+
+  DEBUGASSERT(s);
+
+  for (i = 0; i < s->rings_n; i++)
+    {
+      ring = &s->rings[i];
+      len  = ring->mask + 1;
+      tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+      head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+      while (tail != head)
+        {
+          off = tail & ring->mask;
+
+          /* Unused end of the ring */
+
+          if (len - off < NXSCOPE_RING_HDR)
+            {
+              tail += len - off;
+              continue;
+            }
+
+          size = ring->buf[off] | (ring->buf[off + 1] << 8);
+          if (size == NXSCOPE_RING_SKIP)
+            {
+              tail += len - off;
+              continue;
+            }
+
+          if (s->stream_i + size + s->proto_stream->footlen >
+              s->streambuf_len)
+            {
+              pending = true;
+              break;
+            }
+
+          memcpy(&s->streambuf[s->stream_i],
+                 &ring->buf[off + NXSCOPE_RING_HDR], size);
+          s->stream_i += size;
+          tail += NXSCOPE_RING_HDR + size;
+        }
+
+      /* Release the space to the producer */
+
+      atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+  return pending;
+}
+
+/****************************************************************************
+ * Name: nxscope_rings_free
+ ****************************************************************************/
+
+static void nxscope_rings_free(FAR struct nxscope_s *s)
+{
+  int i = 0;
+
+  DEBUGASSERT(s);
+
+  if (s->rings != NULL)
+    {
+      for (i = 0; i < s->rings_n; i++)
+        {
+          if (s->rings[i].buf != NULL)
+            {
+              free(s->rings[i].buf);
+            }
+        }
+
+      free(s->rings);
+    }
+
+  if (s->chring != NULL)
+    {
+      free(s->chring);
+    }
+
+  if (s->overrun != NULL)
+    {
+      free(s->overrun);
+    }
+}
+#endif
+
 #ifdef CONFIG_LOGGING_NXSCOPE_ACKFRAMES
 /****************************************************************************
  * Name: nxscope_ack
@@ -844,6 +957,93 @@ int nxscope_init(FAR struct nxscope_s *s, FAR struct nxscope_cfg_s *cfg)
     }
 #endif
 
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+  /* Allocate the trigger capture buffer (optional) */
+
+  if (cfg->trigbuf_len > 0)
+    {
+      DEBUGASSERT((cfg->trigbuf_len & (cfg->trigbuf_len - 1)) == 0);
+
+      s->trig.buf = zalloc(cfg->trigbuf_len);
+      if (s->trig.buf == NULL)
+        {
+          ret = -errno;
+          _err("ERROR: trig.buf zalloc failed %d\n", ret);
+          goto errout;
+        }
+
+      s->trig.mask = cfg->trigbuf_len - 1;
+    }
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+  /* Allocate memory for block frames */
+
+  DEBUGASSERT(cfg->blockbuf_len > 0);
+
+  s->blockbuf_len = cfg->blockbuf_len;
+  s->blockbuf = zalloc(s->blockbuf_len);
+  if (s->blockbuf == NULL)
+    {
+      ret = -errno;
+      _err("ERROR: blockbuf zalloc failed %d\n", ret);
+      goto errout;
+    }
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+  /* Allocate producer rings.  All channels start unbound. */
+
+  s->chring = malloc(cfg->channels);
+  if (s->chring == NULL)
+    {
+      ret = -errno;
+      _err("ERROR: chring malloc failed %d\n", ret);
+      goto errout;
+    }
+
+  memset(s->chring, NXSCOPE_RING_NONE, cfg->channels);
+
+  s->overrun = zalloc(cfg->channels * sizeof(uint32_t));
+  if (s->overrun == NULL)
+    {
+      ret = -errno;
+      _err("ERROR: overrun zalloc failed %d\n", ret);
+      goto errout;
+    }
+
+  if (cfg->rings > 0)
+    {
+      DEBUGASSERT(cfg->ring_len > NXSCOPE_RING_HDR);
+      DEBUGASSERT((cfg->ring_len & (cfg->ring_len - 1)) == 0);
+
+      s->rings = zalloc(cfg->rings * sizeof(struct nxscope_ring_s));
+      if (s->rings == NULL)
+        {
+          ret = -errno;
+          _err("ERROR: rings zalloc failed %d\n", ret);
+          goto errout;
+        }
+
+      s->rings_n = cfg->rings;
+
+      for (i = 0; i < cfg->rings; i++)
+        {
+          s->rings[i].buf = zalloc(cfg->ring_len);
+          if (s->rings[i].buf == NULL)
+            {
+              ret = -errno;
+              _err("ERROR: ring zalloc failed %d\n", ret);
+              goto errout;
+            }
+
+          s->rings[i].mask = cfg->ring_len - 1;
+          atomic_init(&s->rings[i].head, 0);
+          atomic_init(&s->rings[i].tail, 0);
+        }
+    }
+#endif
+
   /* Initialize lock */
 
   ret = pthread_mutex_init(&s->lock, NULL);
@@ -868,6 +1068,9 @@ int nxscope_init(FAR struct nxscope_s *s, FAR struct nxscope_cfg_s *cfg)
 #ifdef CONFIG_LOGGING_NXSCOPE_ACKFRAMES
   s->cmninfo.flags |= NXSCOPE_FLAGS_ACK_SUPPORT;
 #endif
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+  s->cmninfo.flags |= NXSCOPE_FLAGS_BLOCK_SUPPORT;
+#endif
 
   s->cmninfo.rx_padding = cfg->rx_padding;
 
@@ -916,6 +1119,24 @@ errout:
     }
 #endif
 
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+  if (s->blockbuf != NULL)
+    {
+      free(s->blockbuf);
+    }
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+  if (s->trig.buf != NULL)
+    {
+      free(s->trig.buf);
+    }
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+  nxscope_rings_free(s);
+#endif
+
   return ret;
 }
 
@@ -968,6 +1189,24 @@ void nxscope_deinit(FAR struct nxscope_s *s)
     {
       free(s->txbuf);
     }
+
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+  if (s->blockbuf != NULL)
+    {
+      free(s->blockbuf);
+    }
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+  if (s->trig.buf != NULL)
+    {
+      free(s->trig.buf);
+    }
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+  nxscope_rings_free(s);
+#endif
 }
 
 /****************************************************************************
@@ -1021,7 +1260,8 @@ void nxscope_unlock(FAR struct nxscope_s *s)
 
 int nxscope_stream(FAR struct nxscope_s *s)
 {
-  int ret = OK;
+  bool pending = false;
+  int  ret     = OK;
 
   DEBUGASSERT(s);
 
@@ -1035,25 +1275,65 @@ int nxscope_stream(FAR struct nxscope_s *s)
       goto errout;
     }
 
-  /* Do nothing if no data */
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+  /* Send block frames, they are already finalized */
 
-  if (nxscope_stream_empty(s))
+  if (s->block_i > 0)
     {
-      goto errout;
-    }
+      ret = INTF_SEND(s, s->intf_stream, s->blockbuf, s->block_i);
+      if (ret < 0)
+        {
+          _err("ERROR: INTF_SEND failed %d\n", ret);
+          goto errout;
+        }
 
-  /* Send stream data */
+      s->block_i = 0;
+    }
+#endif
 
-  ret = nxscope_stream_send(s, s->streambuf, &s->stream_i);
-  if (ret < 0)
+  do
     {
-      _err("ERROR: nxscope_stream_send failed %d\n", ret);
-      goto errout;
-    }
+      /* Merge the producer rings and a captured trigger window unless
+       * a finalized frame waits for retransmission.
+       */
 
-  /* Reset stream buffer */
+      pending = false;
 
-  nxscope_stream_reset(s);
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+      if (!s->stream_retry)
+        {
+          pending |= nxscope_rings_merge(s);
+        }
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+      if (!s->stream_retry)
+        {
+          pending |= nxscope_trig_drain(s);
+        }
+#endif
+
+      /* Do nothing if no data */
+
+      if (nxscope_stream_empty(s))
+        {
+          goto errout;
+        }
+
+      /* Send stream data */
+
+      ret = nxscope_stream_send(s, s->streambuf, &s->stream_i);
+      if (ret < 0)
+        {
+          _err("ERROR: nxscope_stream_send failed %d\n", ret);
+          goto errout;
+        }
+
+      /* Reset stream buffer */
+
+      nxscope_stream_reset(s);
+    }
+  while (pending);
 
 errout:
   nxscope_unlock(s);
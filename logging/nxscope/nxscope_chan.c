@@ -31,6 +31,15 @@
 #include <string.h>
 #include <stdlib.h>
 
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+#  include <stdatomic.h>
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+#  include <time.h>
+#  include <nuttx/clock.h>
+#endif
+
 #include <logging/nxscope/nxscope.h>
 
 #include "nxscope_internals.h"
@@ -105,14 +114,19 @@ static void nxscope_stream_overflow(FAR struct nxscope_s *s)
  ****************************************************************************/
 
 static int nxscope_ch_validate(FAR struct nxscope_s *s, uint8_t ch,
-                               uint8_t type, uint8_t d, uint8_t mlen)
+                               uint8_t type, uint8_t d, uint8_t mlen,
+                               FAR size_t *size)
 {
   union nxscope_chinfo_type_u utype;
+#if defined(CONFIG_LOGGING_NXSCOPE_CRICHANNELS) && \
+    defined(CONFIG_DEBUG_FEATURES)
   size_t                      next_i    = 0;
+#endif
   int                         ret       = OK;
   size_t                      type_size = 0;
 
   DEBUGASSERT(s);
+  DEBUGASSERT(size);
 
   /* Do nothing if stream not started */
 
@@ -199,6 +213,10 @@ static int nxscope_ch_validate(FAR struct nxscope_s *s, uint8_t ch,
       type_size = g_type_size[utype.s.dtype];
     }
 
+  /* Sample size: channel id, data and metadata */
+
+  *size = 1 + type_size * d + mlen;
+
 #ifdef CONFIG_LOGGING_NXSCOPE_CRICHANNELS
   if (utype.s.cri)
     {
@@ -226,19 +244,32 @@ static int nxscope_ch_validate(FAR struct nxscope_s *s, uint8_t ch,
     }
 #endif
 
-  next_i = (s->stream_i + 1 + type_size * d + mlen +
-            s->proto_stream->footlen);
+errout:
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxscope_stream_space
+ *
+ * NOTE: This function assumes that we have exclusive access to the nxscope
+ *       stream buffer
+ *
+ ****************************************************************************/
+
+static int nxscope_stream_space(FAR struct nxscope_s *s, size_t size)
+{
+  size_t next_i = 0;
+
+  next_i = s->stream_i + size + s->proto_stream->footlen;
 
   if (next_i > s->streambuf_len)
     {
       _err("ERROR: no space for data %zu\n", s->stream_i);
       nxscope_stream_overflow(s);
-      ret = -ENOBUFS;
-      goto errout;
+      return -ENOBUFS;
     }
 
-errout:
-  return ret;
+  return OK;
 }
 
 /****************************************************************************
@@ -439,6 +470,79 @@ static void nxscope_put_sample(FAR uint8_t *buff, FAR size_t *buff_i,
   *buff_i += i;
 }
 
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+/****************************************************************************
+ * Name: nxscope_ring_put
+ *
+ * NOTE: Only the producer of the ring may call this function.  The ring
+ *       is shared with nxscope_stream() through head and tail only.
+ *
+ ****************************************************************************/
+
+static int nxscope_ring_put(FAR struct nxscope_s *s, uint8_t type,
+                            uint8_t ch, FAR void *val, uint8_t d,
+                            FAR uint8_t *meta, uint8_t mlen)
+{
+  FAR struct nxscope_ring_s *ring = &s->rings[s->chring[ch]];
+  size_t                     len  = ring->mask + 1;
+  size_t                     size = 0;
+  size_t                     skip = 0;
+  size_t                     head = 0;
+  size_t                     tail = 0;
+  size_t                     off  = 0;
+  size_t                     i    = 0;
+  int                        ret  = OK;
+
+  /* Validate data */
+
+  ret = nxscope_ch_validate(s, ch, type, d, mlen, &size);
+  if (ret != OK)
+    {
+      return ret;
+    }
+
+  head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  off  = head & ring->mask;
+
+  /* Records are contiguous, so a record that doesn't fit before the end
+   * of the ring leaves the rest of it unused.
+   */
+
+  if (len - off < NXSCOPE_RING_HDR + size)
+    {
+      skip = len - off;
+    }
+
+  if (head + skip + NXSCOPE_RING_HDR + size - tail > len)
+    {
+      s->overrun[ch] += 1;
+      return -ENOBUFS;
+    }
+
+  if (skip >= NXSCOPE_RING_HDR)
+    {
+      ring->buf[off]     = NXSCOPE_RING_SKIP & 0xff;
+      ring->buf[off + 1] = NXSCOPE_RING_SKIP >> 8;
+    }
+
+  off = (head + skip) & ring->mask;
+
+  ring->buf[off]     = size & 0xff;
+  ring->buf[off + 1] = size >> 8;
+
+  i = off + NXSCOPE_RING_HDR;
+  nxscope_put_sample(ring->buf, &i, type, ch, val, d, meta, mlen);
+
+  /* Publish the record */
+
+  atomic_store_explicit(&ring->head, head + skip + NXSCOPE_RING_HDR + size,
+                        memory_order_release);
+
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: nxscope_put_common_m
  ****************************************************************************/
@@ -449,21 +553,34 @@ static int nxscope_put_common_m(FAR struct nxscope_s *s, uint8_t type,
 {
   FAR uint8_t                 *buff   = NULL;
   FAR size_t                  *buff_i = NULL;
+  size_t                       size   = 0;
   int                          ret    = OK;
-#ifdef CONFIG_LOGGING_NXSCOPE_CRICHANNELS
+#if defined(CONFIG_LOGGING_NXSCOPE_CRICHANNELS) || \
+    defined(CONFIG_LOGGING_NXSCOPE_TRIGGER)
   size_t                       tmp    = 0;
+#endif
+#ifdef CONFIG_LOGGING_NXSCOPE_CRICHANNELS
   union nxscope_chinfo_type_u  utype;
 #endif
 
   DEBUGASSERT(s);
 
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+  /* Channels bound to a ring never take the lock */
+
+  if (ch < s->cmninfo.chmax && s->chring[ch] != NXSCOPE_RING_NONE)
+    {
+      return nxscope_ring_put(s, type, ch, val, d, meta, mlen);
+    }
+#endif
+
 #ifndef CONFIG_LOGGING_NXSCOPE_DISABLE_PUTLOCK
   nxscope_lock(s);
 #endif
 
   /* Validate data */
 
-  ret = nxscope_ch_validate(s, ch, type, d, mlen);
+  ret = nxscope_ch_validate(s, ch, type, d, mlen, &size);
   if (ret != OK)
     {
       goto errout;
@@ -483,8 +600,33 @@ static int nxscope_put_common_m(FAR struct nxscope_s *s, uint8_t type,
   else
 #endif
     {
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+      /* Capture buffer while a trigger is set */
+
+      if (s->trig.cfg.mode != NXSCOPE_TRIG_OFF)
+        {
+          buff = nxscope_trig_reserve(s, ch, size);
+          if (buff == NULL)
+            {
+              ret = -ENOBUFS;
+              goto errout;
+            }
+
+          tmp = 0;
+          nxscope_put_sample(buff, &tmp, type, ch, val, d, meta, mlen);
+          nxscope_trig_check(s, type, ch, val);
+          goto errout;
+        }
+#endif
+
       /* Common stream buffer */
 
+      ret = nxscope_stream_space(s, size);
+      if (ret != OK)
+        {
+          goto errout;
+        }
+
       buff   = s->streambuf;
       buff_i = &s->stream_i;
     }
@@ -515,6 +657,117 @@ errout:
   return ret;
 }
 
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+/****************************************************************************
+ * Name: nxscope_put_block_common
+ *
+ * Description:
+ *   Put a complete block frame on the block buffer.  The frame is
+ *   finalized here, so nxscope_stream() sends the buffer as it is.
+ *
+ ****************************************************************************/
+
+static int nxscope_put_block_common(FAR struct nxscope_s *s, uint8_t type,
+                                    uint8_t ch, FAR void *val, uint8_t d,
+                                    uint16_t n)
+{
+  FAR uint8_t     *buff = NULL;
+  struct timespec  ts;
+  uint32_t         us   = 0;
+  size_t           size = 0;
+  size_t           i    = 0;
+  int              ret  = OK;
+  int              j    = 0;
+
+  DEBUGASSERT(s);
+  DEBUGASSERT(val);
+
+#ifndef CONFIG_LOGGING_NXSCOPE_DISABLE_PUTLOCK
+  nxscope_lock(s);
+#endif
+
+  /* Validate data */
+
+  ret = nxscope_ch_validate(s, ch, type, d, 0, &size);
+  if (ret != OK)
+    {
+      goto errout;
+    }
+
+  if (s->chinfo[ch].mlen != 0)
+    {
+      _err("ERROR: block on channel with metadata %d\n", ch);
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  /* The validated size includes the channel id, which a block carries
+   * once in its header.
+   */
+
+  size = (s->proto_stream->hdrlen + NXSCOPE_BLOCK_HDR_LEN +
+          (size - 1) * n + s->proto_stream->footlen);
+
+  if (size > UINT16_MAX)
+    {
+      ret = -E2BIG;
+      goto errout;
+    }
+
+  if (s->block_i + size > s->blockbuf_len)
+    {
+      _err("ERROR: no space for block %zu\n", s->block_i);
+      s->block_flags |= NXSCOPE_STREAM_FLAGS_OVERFLOW;
+      ret = -ENOBUFS;
+      goto errout;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  us = ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+
+  /* Block header - always little-endian */
+
+  buff = &s->blockbuf[s->block_i];
+  i    = s->proto_stream->hdrlen;
+
+  buff[i++] = s->block_flags;
+  buff[i++] = ch;
+  buff[i++] = (n >> 0) & 0xff;
+  buff[i++] = (n >> 8) & 0xff;
+  buff[i++] = (us >> 0) & 0xff;
+  buff[i++] = (us >> 8) & 0xff;
+  buff[i++] = (us >> 16) & 0xff;
+  buff[i++] = (us >> 24) & 0xff;
+
+  /* Samples back to back */
+
+  for (j = 0; j < n; j++)
+    {
+      i += nxscope_put_vector(&buff[i], type,
+                              (FAR uint8_t *)val +
+                              j * d * g_type_size[type], d);
+    }
+
+  ret = PROTO_FRAME_FINAL(s, s->proto_stream, NXSCOPE_HDRID_BLOCK,
+                          buff, &i);
+  if (ret < 0)
+    {
+      _err("ERROR: PROTO_FRAME_FINAL failed %d\n", ret);
+      goto errout;
+    }
+
+  s->block_i     += i;
+  s->block_flags  = 0;
+
+errout:
+#ifndef CONFIG_LOGGING_NXSCOPE_DISABLE_PUTLOCK
+  nxscope_unlock(s);
+#endif
+
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -694,6 +947,84 @@ int nxscope_chan_all_en(FAR struct nxscope_s *s, bool en)
   return ret;
 }
 
+#ifdef CONFIG_LOGGING_NXSCOPE_RINGS
+/****************************************************************************
+ * Name: nxscope_chan_ring
+ *
+ * Description:
+ *   Bind a channel to a producer ring
+ *
+ * Input Parameters:
+ *   s    - a pointer to a nxscope instance
+ *   ch   - a channel id
+ *   ring - a ring id or NXSCOPE_RING_NONE to unbind
+ *
+ ****************************************************************************/
+
+int nxscope_chan_ring(FAR struct nxscope_s *s, uint8_t ch, uint8_t ring)
+{
+  int ret = OK;
+
+  DEBUGASSERT(s);
+
+  nxscope_lock(s);
+
+  if (ch >= s->cmninfo.chmax)
+    {
+      _err("ERROR: invalid channel %d\n", ch);
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  if (ring != NXSCOPE_RING_NONE && ring >= s->rings_n)
+    {
+      _err("ERROR: invalid ring %d\n", ring);
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  if (NXSCOPE_IS_CRICHAN(s->chinfo[ch].type.u8))
+    {
+      _err("ERROR: critical channel can't use a ring %d\n", ch);
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  _info("chan_ring=%d %d\n", ch, ring);
+
+  s->chring[ch] = ring;
+
+errout:
+  nxscope_unlock(s);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxscope_chan_overrun
+ *
+ * Description:
+ *   Get the number of samples dropped because the channel ring was full
+ *
+ * Input Parameters:
+ *   s  - a pointer to a nxscope instance
+ *   ch - a channel id
+ *
+ ****************************************************************************/
+
+uint32_t nxscope_chan_overrun(FAR struct nxscope_s *s, uint8_t ch)
+{
+  DEBUGASSERT(s);
+
+  if (ch >= s->cmninfo.chmax)
+    {
+      return 0;
+    }
+
+  return s->overrun[ch];
+}
+#endif
+
 /****************************************************************************
  * Name: nxscope_put_vXXXX_m
  *
@@ -1507,3 +1838,180 @@ int nxscope_put_char(FAR struct nxscope_s *s, uint8_t ch, char val)
 {
   return nxscope_put_vchar(s, ch, &val, 1);
 }
+
+#ifdef CONFIG_LOGGING_NXSCOPE_BLOCKS
+/****************************************************************************
+ * Name: nxscope_put_block_XXXX
+ *
+ * Description:
+ *   Put n consecutive samples of one channel on the block buffer
+ *
+ * Input Parameters:
+ *   s   - a pointer to a nxscope instance
+ *   ch  - a channel id
+ *   val - a pointer to n sample vectors, one after another
+ *   d   - a dimmention of sample data vector
+ *   n   - number of samples
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_put_block_uint8
+ ****************************************************************************/
+
+int nxscope_put_block_uint8(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR uint8_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UINT8, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_int8
+ ****************************************************************************/
+
+int nxscope_put_block_int8(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR int8_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_INT8, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_uint16
+ ****************************************************************************/
+
+int nxscope_put_block_uint16(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint16_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UINT16, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_int16
+ ****************************************************************************/
+
+int nxscope_put_block_int16(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int16_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_INT16, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_uint32
+ ****************************************************************************/
+
+int nxscope_put_block_uint32(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint32_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UINT32, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_int32
+ ****************************************************************************/
+
+int nxscope_put_block_int32(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int32_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_INT32, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_uint64
+ ****************************************************************************/
+
+int nxscope_put_block_uint64(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint64_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UINT64, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_int64
+ ****************************************************************************/
+
+int nxscope_put_block_int64(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int64_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_INT64, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_float
+ ****************************************************************************/
+
+int nxscope_put_block_float(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR float *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_FLOAT, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_double
+ ****************************************************************************/
+
+int nxscope_put_block_double(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR double *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_DOUBLE, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_ub8
+ ****************************************************************************/
+
+int nxscope_put_block_ub8(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR ub8_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UB8, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_b8
+ ****************************************************************************/
+
+int nxscope_put_block_b8(FAR struct nxscope_s *s, uint8_t ch,
+                         FAR b8_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_B8, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_ub16
+ ****************************************************************************/
+
+int nxscope_put_block_ub16(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR ub16_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UB16, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_b16
+ ****************************************************************************/
+
+int nxscope_put_block_b16(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR b16_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_B16, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_ub32
+ ****************************************************************************/
+
+int nxscope_put_block_ub32(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR ub32_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UB32, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_b32
+ ****************************************************************************/
+
+int nxscope_put_block_b32(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR b32_t *val, uint8_t d, uint16_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_B32, ch, val, d, n);
+}
+#endif
@@ -0,0 +1,233 @@
+/****************************************************************************
+ * apps/logging/nxscope/nxscope_idbuf.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nxscope_internals.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_dbuf_thread
+ *
+ * Description:
+ *   Write the in-flight buffer while the other one is being filled
+ *
+ ****************************************************************************/
+
+static FAR void *nxscope_dbuf_thread(FAR void *arg)
+{
+  FAR struct nxscope_dbuf_s *d      = (FAR struct nxscope_dbuf_s *)arg;
+  int                        flight = 0;
+  int                        ret    = OK;
+
+  pthread_mutex_lock(&d->lock);
+
+  while (!d->exit)
+    {
+      if (!d->busy)
+        {
+          pthread_cond_wait(&d->cond, &d->lock);
+          continue;
+        }
+
+      /* The in-flight buffer is always the one not being filled */
+
+      flight = d->fill ^ 1;
+      pthread_mutex_unlock(&d->lock);
+
+      ret = d->write(d->priv, d->buf[flight], d->len[flight]);
+      if (ret < 0)
+        {
+          _err("ERROR: dbuf write failed %d\n", ret);
+        }
+
+      pthread_mutex_lock(&d->lock);
+
+      if (ret < 0)
+        {
+          d->dropped += 1;
+        }
+
+      d->len[flight] = 0;
+
+      /* Hand over the filled buffer right away */
+
+      if (d->len[d->fill] > 0)
+        {
+          d->fill = flight;
+        }
+      else
+        {
+          d->busy = false;
+        }
+    }
+
+  pthread_mutex_unlock(&d->lock);
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_dbuf_init
+ ****************************************************************************/
+
+int nxscope_dbuf_init(FAR struct nxscope_dbuf_s *d, size_t size,
+                      nxscope_dbuf_write_t write, FAR void *priv)
+{
+  int ret = OK;
+  int i   = 0;
+
+  DEBUGASSERT(d);
+  DEBUGASSERT(write);
+  DEBUGASSERT(size > 0);
+
+  memset(d, 0, sizeof(struct nxscope_dbuf_s));
+
+  d->size  = size;
+  d->write = write;
+  d->priv  = priv;
+
+  /* Word aligned buffers, so drivers can DMA straight from them */
+
+  for (i = 0; i < 2; i++)
+    {
+      d->buf[i] = memalign(sizeof(uintptr_t), size);
+      if (d->buf[i] == NULL)
+        {
+          ret = -ENOMEM;
+          _err("ERROR: dbuf alloc failed\n");
+          goto errout;
+        }
+    }
+
+  pthread_mutex_init(&d->lock, NULL);
+  pthread_cond_init(&d->cond, NULL);
+
+  ret = pthread_create(&d->thread, NULL, nxscope_dbuf_thread, d);
+  if (ret != 0)
+    {
+      _err("ERROR: pthread_create failed %d\n", ret);
+      pthread_cond_destroy(&d->cond);
+      pthread_mutex_destroy(&d->lock);
+      ret = -ret;
+      goto errout;
+    }
+
+  pthread_setname_np(d->thread, "nxscope_tx");
+
+  return OK;
+
+errout:
+  free(d->buf[0]);
+  free(d->buf[1]);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxscope_dbuf_deinit
+ *
+ * Description:
+ *   Stop the writer thread.  Data not written yet is dropped.
+ *
+ ****************************************************************************/
+
+void nxscope_dbuf_deinit(FAR struct nxscope_dbuf_s *d)
+{
+  DEBUGASSERT(d);
+
+  pthread_mutex_lock(&d->lock);
+  d->exit = true;
+  pthread_cond_signal(&d->cond);
+  pthread_mutex_unlock(&d->lock);
+
+  pthread_join(d->thread, NULL);
+
+  pthread_cond_destroy(&d->cond);
+  pthread_mutex_destroy(&d->lock);
+
+  free(d->buf[0]);
+  free(d->buf[1]);
+}
+
+/****************************************************************************
+ * Name: nxscope_dbuf_put
+ *
+ * Description:
+ *   Append data to the buffer being filled and wake up the writer if it
+ *   is idle.  Returns len, or -EAGAIN if the data doesn't fit until the
+ *   in-flight buffer is done.  Data is never split between two writes.
+ *
+ ****************************************************************************/
+
+int nxscope_dbuf_put(FAR struct nxscope_dbuf_s *d, FAR const uint8_t *buff,
+                     size_t len)
+{
+  int ret = OK;
+
+  DEBUGASSERT(d);
+  DEBUGASSERT(buff);
+
+  if (len > d->size)
+    {
+      return -E2BIG;
+    }
+
+  pthread_mutex_lock(&d->lock);
+
+  if (d->len[d->fill] + len > d->size)
+    {
+      ret = -EAGAIN;
+      goto errout;
+    }
+
+  memcpy(&d->buf[d->fill][d->len[d->fill]], buff, len);
+  d->len[d->fill] += len;
+  ret = len;
+
+  if (!d->busy)
+    {
+      d->fill ^= 1;
+      d->busy  = true;
+      pthread_cond_signal(&d->cond);
+    }
+
+errout:
+  pthread_mutex_unlock(&d->lock);
+
+  return ret;
+}
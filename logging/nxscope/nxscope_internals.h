@@ -29,6 +29,13 @@
 
 #include <logging/nxscope/nxscope.h>
 
+#include <stdbool.h>
+
+#if defined(CONFIG_LOGGING_NXSCOPE_INTF_UDP) || \
+    defined(CONFIG_LOGGING_NXSCOPE_INTF_USB)
+#  include <pthread.h>
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -37,6 +44,17 @@
 
 #define CHAN_NAMELEN_MAX (32)
 
+/* Producer ring record header: a 16-bit little-endian sample length.
+ * NXSCOPE_RING_SKIP marks the unused end of the ring before a wrap.
+ */
+
+#define NXSCOPE_RING_HDR  (2)
+#define NXSCOPE_RING_SKIP (0xffff)
+
+/* Block frame header: flags, channel, count and timestamp */
+
+#define NXSCOPE_BLOCK_HDR_LEN (8)
+
 /* Helpers */
 
 #define PROTO_FRAME_FINAL(s, proto, id, buff, i)     \
@@ -49,6 +67,40 @@
 #define INTF_RECV(s, intf, buff, i)             \
   (s)->intf_stream->ops->recv(intf, buff, i)
 
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+#if defined(CONFIG_LOGGING_NXSCOPE_INTF_UDP) || \
+    defined(CONFIG_LOGGING_NXSCOPE_INTF_USB)
+/* Double buffered TX path.
+ *
+ * Senders append to buf[fill] while a writer thread pushes
+ * buf[fill ^ 1] to the device.  When the write completes the buffers
+ * swap, so one write covers everything queued in the meantime.
+ */
+
+typedef CODE int (*nxscope_dbuf_write_t)(FAR void *priv,
+                                         FAR const uint8_t *buff,
+                                         size_t len);
+
+struct nxscope_dbuf_s
+{
+  FAR uint8_t          *buf[2];
+  size_t                len[2];
+  size_t                size;        /* Size of each buffer */
+  int                   fill;        /* Buffer being filled */
+  bool                  busy;        /* The other buffer is in flight */
+  bool                  exit;
+  uint32_t              dropped;     /* Failed writes */
+  nxscope_dbuf_write_t  write;
+  FAR void             *priv;
+  pthread_mutex_t       lock;
+  pthread_cond_t        cond;
+  pthread_t             thread;
+};
+#endif
+
 /****************************************************************************
  * Public Function Puttypes
  ****************************************************************************/
@@ -69,4 +121,71 @@
 int nxscope_stream_send(FAR struct nxscope_s *s, FAR uint8_t *buff,
                         FAR size_t *buff_i);
 
+#ifdef CONFIG_LOGGING_NXSCOPE_TRIGGER
+/****************************************************************************
+ * Name: nxscope_trig_reserve
+ *
+ * Description:
+ *   Reserve size bytes for a sample in the trigger capture buffer.
+ *   Returns NULL if the sample is dropped.
+ *
+ ****************************************************************************/
+
+FAR uint8_t *nxscope_trig_reserve(FAR struct nxscope_s *s, uint8_t ch,
+                                  size_t size);
+
+/****************************************************************************
+ * Name: nxscope_trig_check
+ *
+ * Description:
+ *   Evaluate the trigger on a captured sample
+ *
+ ****************************************************************************/
+
+void nxscope_trig_check(FAR struct nxscope_s *s, uint8_t type, uint8_t ch,
+                        FAR const void *val);
+
+/****************************************************************************
+ * Name: nxscope_trig_drain
+ *
+ * Description:
+ *   Move a captured window to the stream buffer.  Returns true if data
+ *   is left.
+ *
+ ****************************************************************************/
+
+bool nxscope_trig_drain(FAR struct nxscope_s *s);
+#endif
+
+#if defined(CONFIG_LOGGING_NXSCOPE_INTF_UDP) || \
+    defined(CONFIG_LOGGING_NXSCOPE_INTF_USB)
+/****************************************************************************
+ * Name: nxscope_dbuf_init
+ *
+ * Description:
+ *   Allocate two TX buffers of size bytes and start the writer thread
+ *
+ ****************************************************************************/
+
+int nxscope_dbuf_init(FAR struct nxscope_dbuf_s *d, size_t size,
+                      nxscope_dbuf_write_t write, FAR void *priv);
+
+/****************************************************************************
+ * Name: nxscope_dbuf_deinit
+ ****************************************************************************/
+
+void nxscope_dbuf_deinit(FAR struct nxscope_dbuf_s *d);
+
+/****************************************************************************
+ * Name: nxscope_dbuf_put
+ *
+ * Description:
+ *   Queue data for the writer thread without waiting for the device
+ *
+ ****************************************************************************/
+
+int nxscope_dbuf_put(FAR struct nxscope_dbuf_s *d, FAR const uint8_t *buff,
+                     size_t len);
+#endif
+
 #endif  /* __APPS_LOGGING_NXSCOPE_NXSCOPE_INTERNALS_H */
@@ -0,0 +1,328 @@
+/****************************************************************************
+ * apps/logging/nxscope/nxscope_iudp.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/socket.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <logging/nxscope/nxscope.h>
+
+#include "nxscope_internals.h"
+
+/****************************************************************************
+ * Private Type Definition
+ ****************************************************************************/
+
+struct nxscope_intf_udp_s
+{
+  FAR struct nxscope_udp_cfg_s *cfg;
+  int                           sd;
+  struct nxscope_dbuf_s         dbuf;
+
+  /* Peer that gets the data, set by cfg->raddr or by the last request */
+
+  struct sockaddr_in            peer;
+  bool                          peer_valid;
+  pthread_mutex_t               peer_lock;
+};
+
+/****************************************************************************
+ * Private Function Protototypes
+ ****************************************************************************/
+
+static int nxscope_udp_send(FAR struct nxscope_intf_s *intf,
+                            FAR uint8_t *buff, int len);
+static int nxscope_udp_recv(FAR struct nxscope_intf_s *intf,
+                            FAR uint8_t *buff, int len);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct nxscope_intf_ops_s g_nxscope_udp_ops =
+{
+  nxscope_udp_send,
+  nxscope_udp_recv
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_udp_write
+ *
+ * Description:
+ *   Writer thread callback, one datagram per buffer
+ *
+ ****************************************************************************/
+
+static int nxscope_udp_write(FAR void *arg, FAR const uint8_t *buff,
+                             size_t len)
+{
+  FAR struct nxscope_intf_udp_s *priv = (FAR struct nxscope_intf_udp_s *)arg;
+  struct sockaddr_in             peer;
+  bool                           valid = false;
+  int                            ret   = OK;
+
+  pthread_mutex_lock(&priv->peer_lock);
+  peer  = priv->peer;
+  valid = priv->peer_valid;
+  pthread_mutex_unlock(&priv->peer_lock);
+
+  /* Nobody to send to yet */
+
+  if (!valid)
+    {
+      return OK;
+    }
+
+  ret = sendto(priv->sd, buff, len, 0, (FAR struct sockaddr *)&peer,
+               sizeof(peer));
+  if (ret < 0)
+    {
+      ret = -errno;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxscope_udp_send
+ ****************************************************************************/
+
+static int nxscope_udp_send(FAR struct nxscope_intf_s *intf,
+                            FAR uint8_t *buff, int len)
+{
+  FAR struct nxscope_intf_udp_s *priv = NULL;
+
+  DEBUGASSERT(intf);
+  DEBUGASSERT(intf->priv);
+
+  /* Get priv data */
+
+  priv = (FAR struct nxscope_intf_udp_s *)intf->priv;
+
+  /* Queue data, the writer thread sends it */
+
+  return nxscope_dbuf_put(&priv->dbuf, buff, len);
+}
+
+/****************************************************************************
+ * Name: nxscope_udp_recv
+ ****************************************************************************/
+
+static int nxscope_udp_recv(FAR struct nxscope_intf_s *intf,
+                            FAR uint8_t *buff, int len)
+{
+  FAR struct nxscope_intf_udp_s *priv    = NULL;
+  struct sockaddr_in             from;
+  socklen_t                      fromlen = sizeof(from);
+  int                            ret     = OK;
+
+  DEBUGASSERT(intf);
+  DEBUGASSERT(intf->priv);
+
+  /* Get priv data */
+
+  priv = (FAR struct nxscope_intf_udp_s *)intf->priv;
+
+  /* Read data */
+
+  ret = recvfrom(priv->sd, buff, len, MSG_DONTWAIT,
+                 (FAR struct sockaddr *)&from, &fromlen);
+  if (ret < 0)
+    {
+      if (errno == EAGAIN)
+        {
+          ret = 0;
+        }
+
+      return ret;
+    }
+
+  /* Answer whoever talks to us unless the peer is fixed */
+
+  if (priv->cfg->raddr == NULL)
+    {
+      pthread_mutex_lock(&priv->peer_lock);
+      priv->peer       = from;
+      priv->peer_valid = true;
+      pthread_mutex_unlock(&priv->peer_lock);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_udp_init
+ ****************************************************************************/
+
+int nxscope_udp_init(FAR struct nxscope_intf_s *intf,
+                     FAR struct nxscope_udp_cfg_s *cfg)
+{
+  FAR struct nxscope_intf_udp_s *priv = NULL;
+  struct sockaddr_in             addr;
+  int                            ret  = OK;
+
+  DEBUGASSERT(intf);
+  DEBUGASSERT(cfg);
+
+  /* Allocate priv data */
+
+  intf->priv = zalloc(sizeof(struct nxscope_intf_udp_s));
+  if (intf->priv == NULL)
+    {
+      _err("ERROR: intf->priv alloc failed %d\n", errno);
+      ret = -errno;
+      goto errout;
+    }
+
+  /* Get priv data */
+
+  priv = (FAR struct nxscope_intf_udp_s *)intf->priv;
+
+  /* Connect configuration */
+
+  priv->cfg = cfg;
+  priv->sd  = -1;
+
+  pthread_mutex_init(&priv->peer_lock, NULL);
+
+  /* Fixed peer */
+
+  if (cfg->raddr != NULL)
+    {
+      priv->peer.sin_family = AF_INET;
+      priv->peer.sin_port   = htons(cfg->rport);
+
+      if (inet_pton(AF_INET, cfg->raddr, &priv->peer.sin_addr) != 1)
+        {
+          _err("ERROR: invalid address %s\n", cfg->raddr);
+          ret = -EINVAL;
+          goto errout;
+        }
+
+      priv->peer_valid = true;
+    }
+
+  /* Bind to the local port */
+
+  priv->sd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (priv->sd < 0)
+    {
+      _err("ERROR: socket failed %d\n", errno);
+      ret = -errno;
+      goto errout;
+    }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(cfg->port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  ret = bind(priv->sd, (FAR struct sockaddr *)&addr, sizeof(addr));
+  if (ret < 0)
+    {
+      _err("ERROR: bind failed %d\n", errno);
+      ret = -errno;
+      goto errout;
+    }
+
+  /* Double buffered TX */
+
+  ret = nxscope_dbuf_init(&priv->dbuf, cfg->txbuf_len, nxscope_udp_write,
+                          priv);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  /* Connect ops */
+
+  intf->ops = &g_nxscope_udp_ops;
+
+  /* Initialized */
+
+  intf->initialized = true;
+
+  return OK;
+
+errout:
+  if (priv != NULL)
+    {
+      if (priv->sd >= 0)
+        {
+          close(priv->sd);
+        }
+
+      pthread_mutex_destroy(&priv->peer_lock);
+      free(priv);
+      intf->priv = NULL;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxscope_udp_deinit
+ ****************************************************************************/
+
+void nxscope_udp_deinit(FAR struct nxscope_intf_s *intf)
+{
+  FAR struct nxscope_intf_udp_s *priv = NULL;
+
+  DEBUGASSERT(intf);
+
+  /* Get priv data */
+
+  priv = (FAR struct nxscope_intf_udp_s *)intf->priv;
+
+  if (priv != NULL)
+    {
+      nxscope_dbuf_deinit(&priv->dbuf);
+      close(priv->sd);
+      pthread_mutex_destroy(&priv->peer_lock);
+      free(priv);
+    }
+
+  /* Reset structure */
+
+  memset(intf, 0, sizeof(struct nxscope_intf_s));
+}
@@ -0,0 +1,294 @@
+/****************************************************************************
+ * apps/logging/nxscope/nxscope_iusb.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <logging/nxscope/nxscope.h>
+
+#include "nxscope_internals.h"
+
+/****************************************************************************
+ * Private Type Definition
+ ****************************************************************************/
+
+struct nxscope_intf_usb_s
+{
+  FAR struct nxscope_usb_cfg_s *cfg;
+  int                           fd;   /* Blocking, for the writer thread */
+  int                           rfd;  /* Non-blocking, for recv() */
+  struct nxscope_dbuf_s         dbuf;
+};
+
+/****************************************************************************
+ * Private Function Protototypes
+ ****************************************************************************/
+
+static int nxscope_usb_send(FAR struct nxscope_intf_s *intf,
+                            FAR uint8_t *buff, int len);
+static int nxscope_usb_recv(FAR struct nxscope_intf_s *intf,
+                            FAR uint8_t *buff, int len);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct nxscope_intf_ops_s g_nxscope_usb_ops =
+{
+  nxscope_usb_send,
+  nxscope_usb_recv
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_usb_write
+ *
+ * Description:
+ *   Writer thread callback.  The driver splits the buffer into bulk
+ *   packets of the endpoint size.
+ *
+ ****************************************************************************/
+
+static int nxscope_usb_write(FAR void *arg, FAR const uint8_t *buff,
+                             size_t len)
+{
+  FAR struct nxscope_intf_usb_s *priv = (FAR struct nxscope_intf_usb_s *)arg;
+  ssize_t                        ret  = 0;
+  size_t                         i    = 0;
+
+  while (i < len)
+    {
+      ret = write(priv->fd, &buff[i], len - i);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      i += ret;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxscope_usb_send
+ ****************************************************************************/
+
+static int nxscope_usb_send(FAR struct nxscope_intf_s *intf,
+                            FAR uint8_t *buff, int len)
+{
+  FAR struct nxscope_intf_usb_s *priv = NULL;
+
+  DEBUGASSERT(intf);
+  DEBUGASSERT(intf->priv);
+
+  /* Get priv data */
+
+  priv = (FAR struct nxscope_intf_usb_s *)intf->priv;
+
+  /* Queue data, the writer thread sends it */
+
+  return nxscope_dbuf_put(&priv->dbuf, buff, len);
+}
+
+/****************************************************************************
+ * Name: nxscope_usb_recv
+ ****************************************************************************/
+
+static int nxscope_usb_recv(FAR struct nxscope_intf_s *intf,
+                            FAR uint8_t *buff, int len)
+{
+  FAR struct nxscope_intf_usb_s *priv = NULL;
+  int                            ret  = OK;
+
+  DEBUGASSERT(intf);
+  DEBUGASSERT(intf->priv);
+
+  /* Get priv data */
+
+  priv = (FAR struct nxscope_intf_usb_s *)intf->priv;
+
+  /* Read data from the OUT endpoint, never blocks */
+
+  ret = read(priv->rfd, buff, len);
+  if (ret < 0 && errno == EAGAIN)
+    {
+      ret = 0;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_usb_init
+ ****************************************************************************/
+
+int nxscope_usb_init(FAR struct nxscope_intf_s *intf,
+                     FAR struct nxscope_usb_cfg_s *cfg)
+{
+  FAR struct nxscope_intf_usb_s *priv = NULL;
+  int                            ret  = OK;
+
+  DEBUGASSERT(intf);
+  DEBUGASSERT(cfg);
+
+  /* Allocate priv data */
+
+  intf->priv = zalloc(sizeof(struct nxscope_intf_usb_s));
+  if (intf->priv == NULL)
+    {
+      _err("ERROR: intf->priv alloc failed %d\n", errno);
+      ret = -errno;
+      goto errout;
+    }
+
+  /* Get priv data */
+
+  priv = (FAR struct nxscope_intf_usb_s *)intf->priv;
+
+  /* Connect configuration */
+
+  priv->cfg = cfg;
+  priv->fd  = -1;
+  priv->rfd = -1;
+
+  /* The writer thread blocks on its own descriptor, recv() polls a
+   * non-blocking one.  ENOTCONN means the host has not configured the
+   * device yet.
+   */
+
+  do
+    {
+      priv->fd = open(cfg->path, O_WRONLY);
+      if (priv->fd < 0)
+        {
+          if (errno != ENOTCONN)
+            {
+              break;
+            }
+
+          sleep(1);
+        }
+    }
+  while (priv->fd < 0);
+
+  if (priv->fd < 0)
+    {
+      _err("ERROR: failed to open %s %d\n", cfg->path, errno);
+      ret = -errno;
+      goto errout;
+    }
+
+  priv->rfd = open(cfg->path, O_RDONLY | O_NONBLOCK);
+  if (priv->rfd < 0)
+    {
+      _err("ERROR: failed to open %s %d\n", cfg->path, errno);
+      ret = -errno;
+      goto errout;
+    }
+
+  /* Double buffered TX */
+
+  ret = nxscope_dbuf_init(&priv->dbuf, cfg->txbuf_len, nxscope_usb_write,
+                          priv);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  /* Connect ops */
+
+  intf->ops = &g_nxscope_usb_ops;
+
+  /* Initialized */
+
+  intf->initialized = true;
+
+  return OK;
+
+errout:
+  if (priv != NULL)
+    {
+      if (priv->fd >= 0)
+        {
+          close(priv->fd);
+        }
+
+      if (priv->rfd >= 0)
+        {
+          close(priv->rfd);
+        }
+
+      free(priv);
+      intf->priv = NULL;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxscope_usb_deinit
+ ****************************************************************************/
+
+void nxscope_usb_deinit(FAR struct nxscope_intf_s *intf)
+{
+  FAR struct nxscope_intf_usb_s *priv = NULL;
+
+  DEBUGASSERT(intf);
+
+  /* Get priv data */
+
+  priv = (FAR struct nxscope_intf_usb_s *)intf->priv;
+
+  if (priv != NULL)
+    {
+      nxscope_dbuf_deinit(&priv->dbuf);
+      close(priv->fd);
+      close(priv->rfd);
+      free(priv);
+    }
+
+  /* Reset structure */
+
+  memset(intf, 0, sizeof(struct nxscope_intf_s));
+}
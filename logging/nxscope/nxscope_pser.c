@@ -59,6 +59,11 @@
  *
  * [1] - always little-endian
  * [2] - always big-endian
+ *
+ * Stream data goes in NXSCOPE_HDRID_STREAM frames (one channel id per
+ * sample) and in NXSCOPE_HDRID_BLOCK frames (n samples of one channel
+ * after a single header, see struct nxscope_block_s).  Several block
+ * frames can follow each other in one interface write.
  */
 
 /* Nxscope header */
@@ -0,0 +1,543 @@
+/****************************************************************************
+ * apps/logging/nxscope/nxscope_trig.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <logging/nxscope/nxscope.h>
+
+#include "nxscope_internals.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_trig_value
+ *
+ * Description:
+ *   Get element idx of a sample vector as float
+ *
+ ****************************************************************************/
+
+static float nxscope_trig_value(uint8_t type, FAR const void *val,
+                                uint8_t idx)
+{
+  switch (type)
+    {
+      case NXSCOPE_TYPE_UINT8:
+        return ((FAR const uint8_t *)val)[idx];
+      case NXSCOPE_TYPE_INT8:
+        return ((FAR const int8_t *)val)[idx];
+      case NXSCOPE_TYPE_UINT16:
+        return ((FAR const uint16_t *)val)[idx];
+      case NXSCOPE_TYPE_INT16:
+        return ((FAR const int16_t *)val)[idx];
+      case NXSCOPE_TYPE_UINT32:
+        return ((FAR const uint32_t *)val)[idx];
+      case NXSCOPE_TYPE_INT32:
+        return ((FAR const int32_t *)val)[idx];
+      case NXSCOPE_TYPE_FLOAT:
+        return ((FAR const float *)val)[idx];
+      case NXSCOPE_TYPE_UB8:
+        return ((FAR const ub8_t *)val)[idx] / 256.0f;
+      case NXSCOPE_TYPE_B8:
+        return ((FAR const b8_t *)val)[idx] / 256.0f;
+      case NXSCOPE_TYPE_UB16:
+        return ((FAR const ub16_t *)val)[idx] / 65536.0f;
+      case NXSCOPE_TYPE_B16:
+        return ((FAR const b16_t *)val)[idx] / 65536.0f;
+#ifdef CONFIG_HAVE_LONG_LONG
+      case NXSCOPE_TYPE_UINT64:
+        return ((FAR const uint64_t *)val)[idx];
+      case NXSCOPE_TYPE_INT64:
+        return ((FAR const int64_t *)val)[idx];
+      case NXSCOPE_TYPE_DOUBLE:
+        return ((FAR const double *)val)[idx];
+      case NXSCOPE_TYPE_UB32:
+        return ((FAR const ub32_t *)val)[idx] / 4294967296.0;
+      case NXSCOPE_TYPE_B32:
+        return ((FAR const b32_t *)val)[idx] / 4294967296.0;
+#endif
+      default:
+        return 0.0f;
+    }
+}
+
+/****************************************************************************
+ * Name: nxscope_trig_evict
+ *
+ * Description:
+ *   Drop the oldest record from the capture buffer.  Returns false if
+ *   the buffer is empty.
+ *
+ ****************************************************************************/
+
+static bool nxscope_trig_evict(FAR struct nxscope_s *s)
+{
+  FAR struct nxscope_trig_s *t    = &s->trig;
+  size_t                     len  = t->mask + 1;
+  size_t                     off  = 0;
+  size_t                     size = 0;
+
+  while (t->tail != t->head)
+    {
+      off = t->tail & t->mask;
+
+      /* Unused end of the buffer */
+
+      if (len - off < NXSCOPE_RING_HDR)
+        {
+          t->tail += len - off;
+          continue;
+        }
+
+      size = t->buf[off] | (t->buf[off + 1] << 8);
+      if (size == NXSCOPE_RING_SKIP)
+        {
+          t->tail += len - off;
+          continue;
+        }
+
+      if (t->buf[off + NXSCOPE_RING_HDR] == t->cfg.chan)
+        {
+          t->pre_n -= 1;
+        }
+
+      t->tail += NXSCOPE_RING_HDR + size;
+      return true;
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: nxscope_trig_reset
+ ****************************************************************************/
+
+static void nxscope_trig_reset(FAR struct nxscope_s *s, uint8_t state)
+{
+  FAR struct nxscope_trig_s *t = &s->trig;
+
+  t->state      = state;
+  t->head       = 0;
+  t->tail       = 0;
+  t->pre_n      = 0;
+  t->post_n     = 0;
+  t->fire       = false;
+  t->first      = false;
+  t->prev_valid = false;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_trig_reserve
+ *
+ * Description:
+ *   Reserve space for a sample in the capture buffer.  While armed, the
+ *   oldest records make room and at most cfg.pre samples of the trigger
+ *   channel are kept.  After the trigger nothing is dropped, so the
+ *   sample is refused if the buffer is full.
+ *
+ * NOTE: This function assumes that we have exclusive access to the nxscope
+ *       instance
+ *
+ ****************************************************************************/
+
+FAR uint8_t *nxscope_trig_reserve(FAR struct nxscope_s *s, uint8_t ch,
+                                  size_t size)
+{
+  FAR struct nxscope_trig_s *t     = &s->trig;
+  size_t                     len   = t->mask + 1;
+  size_t                     need  = NXSCOPE_RING_HDR + size;
+  size_t                     skip  = 0;
+  size_t                     off   = 0;
+
+  DEBUGASSERT(s);
+
+  if (t->state != NXSCOPE_TRIG_STATE_ARMED &&
+      t->state != NXSCOPE_TRIG_STATE_TRIGGERED)
+    {
+      return NULL;
+    }
+
+  /* Records are contiguous */
+
+  off = t->head & t->mask;
+  if (len - off < need)
+    {
+      skip = len - off;
+    }
+
+  if (skip + need > len)
+    {
+      return NULL;
+    }
+
+  if (t->state == NXSCOPE_TRIG_STATE_ARMED)
+    {
+      while (t->head + skip + need - t->tail > len ||
+             (ch == t->cfg.chan && t->pre_n > t->cfg.pre))
+        {
+          if (!nxscope_trig_evict(s))
+            {
+              break;
+            }
+        }
+    }
+  else if (t->head + skip + need - t->tail > len)
+    {
+      s->streambuf[s->proto_stream->hdrlen] |=
+        NXSCOPE_STREAM_FLAGS_OVERFLOW;
+      return NULL;
+    }
+
+  if (skip >= NXSCOPE_RING_HDR)
+    {
+      t->buf[off]     = NXSCOPE_RING_SKIP & 0xff;
+      t->buf[off + 1] = NXSCOPE_RING_SKIP >> 8;
+    }
+
+  off = (t->head + skip) & t->mask;
+
+  t->buf[off]     = size & 0xff;
+  t->buf[off + 1] = size >> 8;
+  t->head        += skip + need;
+
+  if (t->state == NXSCOPE_TRIG_STATE_ARMED && ch == t->cfg.chan)
+    {
+      t->pre_n += 1;
+    }
+
+  return &t->buf[off + NXSCOPE_RING_HDR];
+}
+
+/****************************************************************************
+ * Name: nxscope_trig_check
+ *
+ * Description:
+ *   Evaluate the trigger on a sample stored with nxscope_trig_reserve()
+ *   and count the post-trigger samples.
+ *
+ * NOTE: This function assumes that we have exclusive access to the nxscope
+ *       instance
+ *
+ ****************************************************************************/
+
+void nxscope_trig_check(FAR struct nxscope_s *s, uint8_t type, uint8_t ch,
+                        FAR const void *val)
+{
+  FAR struct nxscope_trig_s *t   = &s->trig;
+  bool                       hit = false;
+  float                      v   = 0.0f;
+
+  DEBUGASSERT(s);
+
+  if (t->state == NXSCOPE_TRIG_STATE_TRIGGERED)
+    {
+      if (ch == t->cfg.chan && ++t->post_n >= t->cfg.post)
+        {
+          t->state = NXSCOPE_TRIG_STATE_DONE;
+        }
+
+      return;
+    }
+
+  if (t->state != NXSCOPE_TRIG_STATE_ARMED)
+    {
+      return;
+    }
+
+  if (t->cfg.mode == NXSCOPE_TRIG_EXT)
+    {
+      hit = t->fire;
+    }
+  else if (ch == t->cfg.chan && val != NULL)
+    {
+      v = nxscope_trig_value(type, val, t->cfg.idx);
+
+      switch (t->cfg.mode)
+        {
+          case NXSCOPE_TRIG_RISING:
+            {
+              hit = t->prev_valid && t->prev < t->cfg.level &&
+                    v >= t->cfg.level;
+              break;
+            }
+
+          case NXSCOPE_TRIG_FALLING:
+            {
+              hit = t->prev_valid && t->prev > t->cfg.level &&
+                    v <= t->cfg.level;
+              break;
+            }
+
+          case NXSCOPE_TRIG_ABOVE:
+            {
+              hit = v >= t->cfg.level;
+              break;
+            }
+
+          case NXSCOPE_TRIG_BELOW:
+            {
+              hit = v <= t->cfg.level;
+              break;
+            }
+
+          default:
+            {
+              break;
+            }
+        }
+
+      t->prev       = v;
+      t->prev_valid = true;
+    }
+
+  if (hit)
+    {
+      _info("trigger on %d\n", ch);
+
+      t->fire   = false;
+      t->first  = true;
+      t->post_n = 0;
+      t->state  = (t->cfg.post > 0 ? NXSCOPE_TRIG_STATE_TRIGGERED :
+                   NXSCOPE_TRIG_STATE_DONE);
+    }
+}
+
+/****************************************************************************
+ * Name: nxscope_trig_drain
+ *
+ * Description:
+ *   Move the captured window to the stream buffer once the trigger hit.
+ *   Returns true if some samples are left because the stream buffer is
+ *   full.
+ *
+ * NOTE: This function assumes that we have exclusive access to the nxscope
+ *       instance
+ *
+ ****************************************************************************/
+
+bool nxscope_trig_drain(FAR struct nxscope_s *s)
+{
+  FAR struct nxscope_trig_s *t    = &s->trig;
+  size_t                     len  = t->mask + 1;
+  size_t                     off  = 0;
+  size_t                     size = 0;
+
+  DEBUGASSERT(s);
+
+  if (t->state != NXSCOPE_TRIG_STATE_TRIGGERED &&
+      t->state != NXSCOPE_TRIG_STATE_DONE)
+    {
+      return false;
+    }
+
+  /* Mark the frame that starts a window */
+
+  if (t->first)
+    {
+      s->streambuf[s->proto_stream->hdrlen] |=
+        NXSCOPE_STREAM_FLAGS_TRIGGER;
+      t->first = false;
+    }
+
+  while (t->tail != t->head)
+    {
+      off = t->tail & t->mask;
+
+      if (len - off < NXSCOPE_RING_HDR)
+        {
+          t->tail += len - off;
+          continue;
+        }
+
+      size = t->buf[off] | (t->buf[off + 1] << 8);
+      if (size == NXSCOPE_RING_SKIP)
+        {
+          t->tail += len - off;
+          continue;
+        }
+
+      if (s->stream_i + size + s->proto_stream->footlen > s->streambuf_len)
+        {
+          return true;
+        }
+
+      memcpy(&s->streambuf[s->stream_i], &t->buf[off + NXSCOPE_RING_HDR],
+             size);
+      s->stream_i += size;
+      t->tail     += NXSCOPE_RING_HDR + size;
+    }
+
+  /* Window sent */
+
+  if (t->state == NXSCOPE_TRIG_STATE_DONE)
+    {
+      nxscope_trig_reset(s, t->cfg.rearm ? NXSCOPE_TRIG_STATE_ARMED :
+                         NXSCOPE_TRIG_STATE_IDLE);
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: nxscope_trig_set
+ *
+ * Description:
+ *   Configure and arm the trigger.  NXSCOPE_TRIG_OFF goes back to
+ *   continuous streaming.
+ *
+ * Input Parameters:
+ *   s   - a pointer to a nxscope instance
+ *   cfg - a pointer to the trigger configuration
+ *
+ ****************************************************************************/
+
+int nxscope_trig_set(FAR struct nxscope_s *s,
+                     FAR const struct nxscope_trig_cfg_s *cfg)
+{
+  int ret = OK;
+
+  DEBUGASSERT(s);
+  DEBUGASSERT(cfg);
+
+  nxscope_lock(s);
+
+  if (cfg->mode > NXSCOPE_TRIG_EXT || cfg->chan >= s->cmninfo.chmax)
+    {
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  if (cfg->mode != NXSCOPE_TRIG_OFF && s->trig.buf == NULL)
+    {
+      _err("ERROR: no trigger buffer\n");
+      ret = -ENOBUFS;
+      goto errout;
+    }
+
+  if (cfg->mode != NXSCOPE_TRIG_OFF && cfg->mode != NXSCOPE_TRIG_EXT &&
+      cfg->idx >= s->chinfo[cfg->chan].vdim)
+    {
+      _err("ERROR: invalid trigger vector index %d\n", cfg->idx);
+      ret = -EINVAL;
+      goto errout;
+    }
+
+  s->trig.cfg = *cfg;
+  nxscope_trig_reset(s, cfg->mode == NXSCOPE_TRIG_OFF ?
+                     NXSCOPE_TRIG_STATE_IDLE : NXSCOPE_TRIG_STATE_ARMED);
+
+errout:
+  nxscope_unlock(s);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxscope_trig_arm
+ *
+ * Description:
+ *   Re-arm a trigger that captured its window
+ *
+ * Input Parameters:
+ *   s - a pointer to a nxscope instance
+ *
+ ****************************************************************************/
+
+int nxscope_trig_arm(FAR struct nxscope_s *s)
+{
+  int ret = OK;
+
+  DEBUGASSERT(s);
+
+  nxscope_lock(s);
+
+  if (s->trig.cfg.mode == NXSCOPE_TRIG_OFF)
+    {
+      ret = -EINVAL;
+    }
+  else if (s->trig.state == NXSCOPE_TRIG_STATE_IDLE)
+    {
+      nxscope_trig_reset(s, NXSCOPE_TRIG_STATE_ARMED);
+    }
+
+  nxscope_unlock(s);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxscope_trig_fire
+ *
+ * Description:
+ *   Signal the external event of a NXSCOPE_TRIG_EXT trigger.  The window
+ *   is aligned to the next put on any channel.
+ *
+ * Input Parameters:
+ *   s - a pointer to a nxscope instance
+ *
+ ****************************************************************************/
+
+void nxscope_trig_fire(FAR struct nxscope_s *s)
+{
+  DEBUGASSERT(s);
+
+  nxscope_lock(s);
+
+  if (s->trig.state == NXSCOPE_TRIG_STATE_ARMED)
+    {
+      s->trig.fire = true;
+    }
+
+  nxscope_unlock(s);
+}
+
+/****************************************************************************
+ * Name: nxscope_trig_state
+ *
+ * Description:
+ *   Get the trigger state (enum nxscope_trig_state_e)
+ *
+ * Input Parameters:
+ *   s - a pointer to a nxscope instance
+ *
+ ****************************************************************************/
+
+int nxscope_trig_state(FAR struct nxscope_s *s)
+{
+  DEBUGASSERT(s);
+
+  return s->trig.state;
+}
@@ -114,6 +114,8 @@ struct alt1250_s
   bool is_usockrcvd;  /* A flag indicates that daemon has already read
                        * usrsock request */
   bool recvfrom_processing;
+  bool select_batch;   /* Postpone restart_select() to select_commit() */
+  bool select_pending; /* restart_select() was postponed */
 
   uint8_t tx_buff[_TX_BUFF_SIZE];
   uint8_t rx_buff[_RX_BUFF_SIZE];
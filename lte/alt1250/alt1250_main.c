@@ -136,6 +136,61 @@ static void finalize_daemon(FAR struct alt1250_s *dev)
   alt1250_evttask_stop(dev);
 }
 
+/****************************************************************************
+ * Name: perform_usockrequests
+ *
+ * Description:
+ *   Handle the usrsock request that woke the daemon up and, while the
+ *   daemon can take more, the requests already queued behind it, up to
+ *   CONFIG_LTE_ALT1250_USOCK_BATCH in one round of the main loop.
+ *
+ * Returned Value:
+ *   false if the daemon is to terminate.
+ *
+ ****************************************************************************/
+
+static bool perform_usockrequests(FAR struct alt1250_s *dev)
+{
+  struct pollfd fds;
+  int n;
+
+  for (n = 0; n < CONFIG_LTE_ALT1250_USOCK_BATCH; n++)
+    {
+      switch (perform_usockrequest(dev))
+        {
+          case REP_SEND_TERM:
+            return false;
+
+          case REP_NO_CONTAINER:
+
+            /* Do nothing because request could
+             * not send to modem driver because of
+             * no more container. To wait for empty container.
+             */
+
+            return true;
+
+          default:
+            dev->is_usockrcvd = false;
+            break;
+        }
+
+      if (!ACCEPT_USOCK_REQUEST(dev))
+        {
+          break;
+        }
+
+      memset(&fds, 0, sizeof(fds));
+      SET_POLLIN(fds, dev->usockfd);
+      if (poll(&fds, 1, 0) <= 0 || !IS_POLLIN(fds))
+        {
+          break;
+        }
+    }
+
+  return true;
+}
+
 /****************************************************************************
  * Name: alt1250_loop
  ****************************************************************************/
@@ -190,6 +245,8 @@ static int alt1250_loop(FAR struct alt1250_s *dev)
       ASSERT(ret > 0);
       ret = OK;
 
+      select_batch(dev);
+
       if (IS_POLLIN(fds[ALTFDNO]))
         {
           ret = perform_alt1250events(dev);
@@ -203,26 +260,10 @@ static int alt1250_loop(FAR struct alt1250_s *dev)
       if ((ret != REP_MODEM_RESET) && (!dev->recvfrom_processing)
           && (IS_POLLIN(fds[USOCKFDNO]) || dev->is_usockrcvd))
         {
-          switch (perform_usockrequest(dev))
-            {
-              case REP_SEND_TERM:
-                is_running = false;
-                break;
-
-              case REP_NO_CONTAINER:
-
-                /* Do nothing because request could
-                 * not send to modem driver because of
-                 * no more container. To wait for empty container.
-                 */
-
-                break;
-
-              default:
-                dev->is_usockrcvd = false;
-                break;
-            }
+          is_running = perform_usockrequests(dev);
         }
+
+      select_commit(dev);
     }
 
   finalize_daemon(dev);
@@ -363,6 +363,48 @@ void init_selectcontainer(FAR struct alt1250_s *dev)
 
 void restart_select(FAR struct alt1250_s *dev)
 {
+  if (dev->select_batch)
+    {
+      dev->select_pending = true;
+      return;
+    }
+
   select_cancel(dev);
   select_start(dev);
 }
+
+/****************************************************************************
+ * name: select_batch
+ *
+ * Description:
+ *   Postpone the select restarts requested while a round of modem events
+ *   and usrsock requests is handled.  Each restart costs a cancel and a
+ *   new select command to the modem, while only the socket states at the
+ *   end of the round matter.
+ *
+ ****************************************************************************/
+
+void select_batch(FAR struct alt1250_s *dev)
+{
+  dev->select_batch = true;
+}
+
+/****************************************************************************
+ * name: select_commit
+ *
+ * Description:
+ *   End a round started with select_batch() and restart the select once
+ *   if it was requested during the round.
+ *
+ ****************************************************************************/
+
+void select_commit(FAR struct alt1250_s *dev)
+{
+  dev->select_batch = false;
+
+  if (dev->select_pending)
+    {
+      dev->select_pending = false;
+      restart_select(dev);
+    }
+}
@@ -36,5 +36,7 @@
 void init_selectcontainer(FAR struct alt1250_s *dev);
 uint64_t perform_select_event(FAR struct alt1250_s *dev, uint64_t bitmap);
 void restart_select(FAR struct alt1250_s *dev);
+void select_batch(FAR struct alt1250_s *dev);
+void select_commit(FAR struct alt1250_s *dev);
 
 #endif  /* __APPS_LTE_ALT1250_ALT1250_SELECT_H */
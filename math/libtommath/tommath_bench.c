@@ -0,0 +1,389 @@
+/****************************************************************************
+ * apps/math/libtommath/tommath_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <tommath.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_MAXSIZES    8
+
+/* Default number of runs of each measure.  The cheap operations run this
+ * many times more.
+ */
+
+#define BENCH_RUNS        4
+#define BENCH_FAST_FACTOR 256
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const int g_default_bits[] =
+{
+  1024, 2048, 3072
+};
+
+static uint32_t g_seed = 0x2545f491;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_rand
+ *
+ * Description:
+ *   A xorshift source for mp_rand(), so that the operands, and then the
+ *   timings of mp_exptmod(), are the same from a run to the next.
+ *
+ ****************************************************************************/
+
+static mp_err bench_rand(FAR void *out, size_t size)
+{
+  FAR uint8_t *ptr = out;
+
+  while (size-- > 0)
+    {
+      g_seed ^= g_seed << 13;
+      g_seed ^= g_seed >> 17;
+      g_seed ^= g_seed << 5;
+      *ptr++ = (uint8_t)g_seed;
+    }
+
+  return MP_OKAY;
+}
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static uint64_t bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_number
+ *
+ * Description:
+ *   Make a random number of exactly bits bits, odd if odd is set.
+ *
+ ****************************************************************************/
+
+static mp_err bench_number(FAR mp_int *a, int bits, bool odd)
+{
+  mp_int top;
+  mp_err err;
+
+  err = mp_init(&top);
+  if (err != MP_OKAY)
+    {
+      return err;
+    }
+
+  err = mp_rand(a, (bits + MP_DIGIT_BIT - 1) / MP_DIGIT_BIT);
+  if (err == MP_OKAY)
+    {
+      err = mp_mod_2d(a, bits - 1, a);
+    }
+
+  if (err == MP_OKAY)
+    {
+      err = mp_2expt(&top, bits - 1);
+    }
+
+  if (err == MP_OKAY)
+    {
+      err = mp_add(a, &top, a);
+    }
+
+  if (err == MP_OKAY && odd && mp_iseven(a))
+    {
+      err = mp_add_d(a, 1, a);
+    }
+
+  mp_clear(&top);
+  return err;
+}
+
+/****************************************************************************
+ * Name: bench_report
+ ****************************************************************************/
+
+static void bench_report(FAR const char *name, uint64_t ns, int runs)
+{
+  uint64_t us = ns / runs / 1000;
+
+  if (us >= 10000)
+    {
+      printf("  %-24s %8" PRIu64 " ms\n", name, us / 1000);
+    }
+  else
+    {
+      printf("  %-24s %8" PRIu64 " us\n", name, us);
+    }
+}
+
+/****************************************************************************
+ * Name: bench_size
+ *
+ * Description:
+ *   Measure the operations of a modular exponentiation with a bits bits
+ *   odd modulus, the case of RSA and of the usual DH groups, which
+ *   mp_exptmod() reduces with Montgomery.
+ *
+ ****************************************************************************/
+
+static mp_err bench_size(int bits, int runs)
+{
+  mp_int m;
+  mp_int a;
+  mp_int b;
+  mp_int c;
+  mp_int x;
+  mp_int e;
+  mp_digit rho;
+  uint64_t start;
+  mp_err err;
+  int fast = runs * BENCH_FAST_FACTOR;
+  int i;
+
+  err = mp_init_multi(&m, &a, &b, &c, &x, &e, NULL);
+  if (err != MP_OKAY)
+    {
+      return err;
+    }
+
+  /* A modulus, two operands below it, a private sized exponent */
+
+  err = bench_number(&m, bits, true);
+  if (err == MP_OKAY)
+    {
+      err = bench_number(&a, bits - 1, false);
+    }
+
+  if (err == MP_OKAY)
+    {
+      err = bench_number(&b, bits - 1, false);
+    }
+
+  if (err == MP_OKAY)
+    {
+      err = bench_number(&e, bits - 1, true);
+    }
+
+  if (err == MP_OKAY)
+    {
+      err = mp_montgomery_setup(&m, &rho);
+    }
+
+  if (err != MP_OKAY)
+    {
+      goto out;
+    }
+
+  printf("%d bits, %d digits of %d bits\n", bits, m.used, MP_DIGIT_BIT);
+
+  start = bench_now();
+  for (i = 0; i < fast && err == MP_OKAY; i++)
+    {
+      err = mp_mul(&a, &b, &c);
+    }
+
+  bench_report("mp_mul", bench_now() - start, fast);
+
+  start = bench_now();
+  for (i = 0; i < fast && err == MP_OKAY; i++)
+    {
+      err = mp_sqr(&a, &c);
+    }
+
+  bench_report("mp_sqr", bench_now() - start, fast);
+
+  start = bench_now();
+  for (i = 0; i < fast && err == MP_OKAY; i++)
+    {
+      err = mp_copy(&c, &x);
+      if (err == MP_OKAY)
+        {
+          err = mp_montgomery_reduce(&x, &m, rho);
+        }
+    }
+
+  bench_report("mp_montgomery_reduce", bench_now() - start, fast);
+
+  start = bench_now();
+  for (i = 0; i < runs && err == MP_OKAY; i++)
+    {
+      err = mp_exptmod(&a, &e, &m, &c);
+    }
+
+  bench_report("mp_exptmod private", bench_now() - start, runs);
+
+  mp_set_u32(&e, 65537);
+
+  start = bench_now();
+  for (i = 0; i < fast && err == MP_OKAY; i++)
+    {
+      err = mp_exptmod(&a, &e, &m, &c);
+    }
+
+  bench_report("mp_exptmod e=65537", bench_now() - start, fast);
+
+out:
+  mp_clear_multi(&m, &a, &b, &c, &x, &e, NULL);
+  return err;
+}
+
+/****************************************************************************
+ * Name: bench_usage
+ ****************************************************************************/
+
+static void bench_usage(FAR const char *progname)
+{
+  fprintf(stderr, "Usage: %s [-b bits]... [-n runs]"
+#ifndef MP_FIXED_CUTOFFS
+          " [-k karatsuba_mul] [-s karatsuba_sqr]"
+          " [-t toom_mul] [-q toom_sqr]"
+#endif
+          "\n", progname);
+  fprintf(stderr, "  -b bits  Size of the modulus, repeatable "
+          "(default 1024, 2048 and 3072)\n");
+  fprintf(stderr, "  -n runs  Number of private exponentiations (default "
+          "%d)\n", BENCH_RUNS);
+#ifndef MP_FIXED_CUTOFFS
+  fprintf(stderr, "  -k -s -t -q  Cutoffs, in digits, from which the "
+          "Karatsuba and Toom-Cook\n"
+          "               multiplication and squaring are used\n");
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  int bits[BENCH_MAXSIZES];
+  int nbits = 0;
+  int runs = BENCH_RUNS;
+  mp_err err;
+  int opt;
+  int i;
+
+  while ((opt = getopt(argc, argv, "b:n:k:s:t:q:")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'b':
+            if (nbits < BENCH_MAXSIZES)
+              {
+                bits[nbits++] = atoi(optarg);
+              }
+            break;
+
+          case 'n':
+            runs = atoi(optarg);
+            break;
+
+#ifndef MP_FIXED_CUTOFFS
+          case 'k':
+            KARATSUBA_MUL_CUTOFF = atoi(optarg);
+            break;
+
+          case 's':
+            KARATSUBA_SQR_CUTOFF = atoi(optarg);
+            break;
+
+          case 't':
+            TOOM_MUL_CUTOFF = atoi(optarg);
+            break;
+
+          case 'q':
+            TOOM_SQR_CUTOFF = atoi(optarg);
+            break;
+#endif
+
+          default:
+            bench_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (runs <= 0)
+    {
+      bench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  for (i = 0; i < nbits; i++)
+    {
+      if (bits[i] < 2 * MP_DIGIT_BIT)
+        {
+          bench_usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+
+  if (nbits == 0)
+    {
+      nbits = sizeof(g_default_bits) / sizeof(g_default_bits[0]);
+      memcpy(bits, g_default_bits, sizeof(g_default_bits));
+    }
+
+#ifndef MP_FIXED_CUTOFFS
+  printf("Cutoffs: karatsuba mul %d sqr %d, toom mul %d sqr %d\n",
+         KARATSUBA_MUL_CUTOFF, KARATSUBA_SQR_CUTOFF,
+         TOOM_MUL_CUTOFF, TOOM_SQR_CUTOFF);
+#endif
+
+  mp_rand_source(bench_rand);
+
+  for (i = 0; i < nbits; i++)
+    {
+      err = bench_size(bits[i], runs);
+      if (err != MP_OKAY)
+        {
+          fprintf(stderr, "ERROR: %s\n", mp_error_to_string(err));
+          return EXIT_FAILURE;
+        }
+    }
+
+  return EXIT_SUCCESS;
+}
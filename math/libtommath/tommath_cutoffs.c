@@ -0,0 +1,43 @@
+/****************************************************************************
+ * apps/math/libtommath/tommath_cutoffs.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include "tommath_private.h"
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/* These replace the ones of bn_cutoffs.c, which come from the build host
+ * tuning of tommath_cutoffs.h.  They stay variables so that they can be
+ * tuned at run time, see tommath_bench.
+ */
+
+#ifndef MP_FIXED_CUTOFFS
+int KARATSUBA_MUL_CUTOFF = CONFIG_LIBTOMMATH_KARATSUBA_MUL_CUTOFF;
+int KARATSUBA_SQR_CUTOFF = CONFIG_LIBTOMMATH_KARATSUBA_SQR_CUTOFF;
+int TOOM_MUL_CUTOFF      = CONFIG_LIBTOMMATH_TOOM_MUL_CUTOFF;
+int TOOM_SQR_CUTOFF      = CONFIG_LIBTOMMATH_TOOM_SQR_CUTOFF;
+#endif
@@ -0,0 +1,269 @@
+/****************************************************************************
+ * apps/mlearning/libnnablart/nnablart_planner.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include "mlearning/nnablart_planner.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Lists and structures of an .nnb network are offsets from its start */
+
+#define PLAN_GET(n, offset) ((FAR void *)((FAR uint8_t *)(n) + (offset)))
+
+/* A negative data index of a variable refers to an activation buffer */
+
+#define PLAN_ISBUFFER(v)    ((v)->data_index < 0)
+#define PLAN_BUFFER(v)      (-(v)->data_index - 1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct plan_buffer_s
+{
+  int first;                 /* First function using the buffer */
+  int last;                  /* Last function using the buffer */
+  int slot;                  /* Planned buffer */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* For qsort(), which has no context argument */
+
+static FAR const int *g_plan_sizes;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: plan_variable
+ ****************************************************************************/
+
+static FAR nn_variable_t *plan_variable(FAR nn_network_t *network, int id)
+{
+  FAR int *list = PLAN_GET(network, network->variables.list);
+
+  return PLAN_GET(network, list[id]);
+}
+
+/****************************************************************************
+ * Name: plan_use
+ *
+ * Description:
+ *   Extend the lifetime of the buffer of the variables in list to the
+ *   function index.
+ *
+ ****************************************************************************/
+
+static void plan_use(FAR nn_network_t *network, FAR nn_list_t *vars,
+                     FAR struct plan_buffer_s *buffers, int index)
+{
+  FAR nn_variable_t *var;
+  FAR int *ids = PLAN_GET(network, vars->list);
+  int b;
+  int i;
+
+  for (i = 0; i < vars->size; i++)
+    {
+      var = plan_variable(network, ids[i]);
+      if (!PLAN_ISBUFFER(var))
+        {
+          continue;
+        }
+
+      b = PLAN_BUFFER(var);
+      if (index < buffers[b].first)
+        {
+          buffers[b].first = index;
+        }
+
+      if (index > buffers[b].last)
+        {
+          buffers[b].last = index;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: plan_compare
+ *
+ * Description:
+ *   Sort the buffers by decreasing size, so that each planned buffer gets
+ *   the size of the first one placed in it.
+ *
+ ****************************************************************************/
+
+static int plan_compare(FAR const void *a, FAR const void *b)
+{
+  int x = g_plan_sizes[*(FAR const int *)a];
+  int y = g_plan_sizes[*(FAR const int *)b];
+
+  return y < x ? -1 : y > x;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nnablart_plan
+ ****************************************************************************/
+
+int nnablart_plan(FAR nn_network_t *network,
+                  FAR struct nnablart_plan_s *plan)
+{
+  FAR struct plan_buffer_s *buffers;
+  FAR nn_function_t *func;
+  FAR nn_variable_t *var;
+  FAR int *functions;
+  FAR int *variables;
+  FAR int *slotsize;
+  FAR int *sizes;
+  FAR int *order;
+  int nbuffers = network->buffers.size;
+  int nslots = 0;
+  int nfuncs = network->functions.size;
+  size_t size = 0;
+  size_t planned = 0;
+  int b;
+  int i;
+  int j;
+  int s;
+
+  if (nbuffers <= 0)
+    {
+      return -EINVAL;
+    }
+
+  buffers  = malloc(nbuffers * (sizeof(*buffers) + 2 * sizeof(int)));
+  if (buffers == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  order    = (FAR int *)&buffers[nbuffers];
+  slotsize = &order[nbuffers];
+  sizes    = PLAN_GET(network, network->buffers.list);
+
+  for (b = 0; b < nbuffers; b++)
+    {
+      buffers[b].first = INT_MAX;
+      buffers[b].last  = -1;
+      order[b]         = b;
+      size            += sizes[b];
+    }
+
+  /* The lifetime of each buffer, the inputs of the network live from
+   * before the first function and the outputs after the last one.
+   */
+
+  functions = PLAN_GET(network, network->functions.list);
+  for (i = 0; i < nfuncs; i++)
+    {
+      func = PLAN_GET(network, functions[i]);
+      plan_use(network, &func->inputs, buffers, i);
+      plan_use(network, &func->outputs, buffers, i);
+    }
+
+  plan_use(network, &network->inputs, buffers, -1);
+  plan_use(network, &network->outputs, buffers, nfuncs);
+
+  /* Place each buffer, largest first, in the first planned buffer where
+   * it does not overlap the lifetime of the buffers already there.
+   */
+
+  g_plan_sizes = sizes;
+  qsort(order, nbuffers, sizeof(int), plan_compare);
+
+  for (i = 0; i < nbuffers; i++)
+    {
+      b = order[i];
+      for (s = 0; s < nslots; s++)
+        {
+          for (j = 0; j < i; j++)
+            {
+              FAR struct plan_buffer_s *o = &buffers[order[j]];
+
+              if (o->slot == s && o->first <= buffers[b].last &&
+                  buffers[b].first <= o->last)
+                {
+                  break;
+                }
+            }
+
+          if (j == i)
+            {
+              break;
+            }
+        }
+
+      if (s == nslots)
+        {
+          slotsize[nslots++] = sizes[b];
+          planned += sizes[b];
+        }
+
+      buffers[b].slot = s;
+    }
+
+  /* Rewrite the network with the planned buffers */
+
+  variables = PLAN_GET(network, network->variables.list);
+  for (i = 0; i < network->variables.size; i++)
+    {
+      var = PLAN_GET(network, variables[i]);
+      if (PLAN_ISBUFFER(var))
+        {
+          var->data_index = -buffers[PLAN_BUFFER(var)].slot - 1;
+        }
+    }
+
+  for (s = 0; s < nslots; s++)
+    {
+      sizes[s] = slotsize[s];
+    }
+
+  network->buffers.size = nslots;
+  free(buffers);
+
+  if (plan != NULL)
+    {
+      plan->nbuffers        = nbuffers;
+      plan->planned_buffers = nslots;
+      plan->size            = size;
+      plan->planned_size    = planned;
+    }
+
+  return OK;
+}
@@ -382,6 +382,15 @@ eMBException eMBMasterFuncReadHoldingRegister(uint8_t *pucFrame,
       if ((usRegCount >= 1) &&
           (2 * usRegCount == pucFrame[MB_PDU_FUNC_READ_BYTECNT_OFF]))
         {
+#ifdef CONFIG_MB_MASTER_SCHEDULER
+          /* Keep the registers requested by the scheduler. */
+
+          vMBMasterSchedUpdate(ucMBMasterGetDestAddress(),
+                               MB_SCHED_REG_HOLDING, usRegAddress - 1,
+                               usRegCount,
+                               &pucFrame[MB_PDU_FUNC_READ_VALUES_OFF]);
+#endif
+
           /* Make callback to fill the buffer. */
 
           eRegStatus =
@@ -92,6 +92,10 @@ bool(*pxMBFrameCBTransmitterEmpty)(void);
 bool(*pxMBPortCBTimerExpired)(void);
 
 bool(*pxMBFrameCBReceiveFSMCur)(void);
+
+#ifdef CONFIG_MB_RTU_FRAME_RX
+bool(*pxMBFrameCBFrameReceived)(uint8_t *pucFrame, uint16_t usLen);
+#endif
 bool(*pxMBFrameCBTransmitFSMCur)(void);
 
 /* An array of Modbus functions handlers which associates Modbus function
@@ -164,6 +168,9 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
           pxMBFrameCBByteReceived = xMBRTUReceiveFSM;
           pxMBFrameCBTransmitterEmpty = xMBRTUTransmitFSM;
           pxMBPortCBTimerExpired = xMBRTUTimerT35Expired;
+#ifdef CONFIG_MB_RTU_FRAME_RX
+          pxMBFrameCBFrameReceived = xMBRTUReceiveFrame;
+#endif
 
           eStatus = eMBRTUInit(ucMBAddress, ucPort, ulBaudRate, eParity);
           break;
@@ -178,6 +185,9 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
           pxMBFrameCBByteReceived = xMBASCIIReceiveFSM;
           pxMBFrameCBTransmitterEmpty = xMBASCIITransmitFSM;
           pxMBPortCBTimerExpired = xMBASCIITimerT1SExpired;
+#ifdef CONFIG_MB_RTU_FRAME_RX
+          pxMBFrameCBFrameReceived = NULL;
+#endif
 
           eStatus = eMBASCIIInit(ucMBAddress, ucPort, ulBaudRate, eParity);
           break;
@@ -103,6 +103,10 @@ bool(*pxMBMasterFrameCBTransmitterEmpty) (void);
 bool(*pxMBMasterPortCBTimerExpired) (void);
 
 bool(*pxMBMasterFrameCBReceiveFSMCur) (void);
+
+#ifdef CONFIG_MB_RTU_FRAME_RX
+bool(*pxMBMasterFrameCBFrameReceived) (uint8_t *pucFrame, uint16_t usLen);
+#endif
 bool(*pxMBMasterFrameCBTransmitFSMCur) (void);
 
 /* An array of Modbus functions handlers which associates Modbus function
@@ -167,6 +171,9 @@ eMBErrorCode eMBMasterInit(eMBMode eMode, uint8_t ucPort,
       pxMBMasterFrameCBByteReceived = xMBMasterRTUReceiveFSM;
       pxMBMasterFrameCBTransmitterEmpty = xMBMasterRTUTransmitFSM;
       pxMBMasterPortCBTimerExpired = xMBMasterRTUTimerExpired;
+#ifdef CONFIG_MB_RTU_FRAME_RX
+      pxMBMasterFrameCBFrameReceived = xMBMasterRTUReceiveFrame;
+#endif
 
       eStatus = eMBMasterRTUInit(ucPort, ulBaudRate, eParity);
       break;
@@ -181,6 +188,9 @@ eMBErrorCode eMBMasterInit(eMBMode eMode, uint8_t ucPort,
       pxMBMasterFrameCBByteReceived = xMBMasterASCIIReceiveFSM;
       pxMBMasterFrameCBTransmitterEmpty = xMBMasterASCIITransmitFSM;
       pxMBMasterPortCBTimerExpired = xMBMasterASCIITimerT1SExpired;
+#ifdef CONFIG_MB_RTU_FRAME_RX
+      pxMBMasterFrameCBFrameReceived = NULL;
+#endif
 
       eStatus = eMBMasterASCIIInit(ucPort, ulBaudRate, eParity);
       break;
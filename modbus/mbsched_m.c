@@ -0,0 +1,486 @@
+/****************************************************************************
+ * apps/modbus/mbsched_m.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "port.h"
+
+#include "modbus/mb.h"
+#include "modbus/mb_m.h"
+
+#ifdef CONFIG_MB_MASTER_SCHEDULER
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Most registers a read request can ask for */
+
+#define MB_SCHED_REGCNT_MAX     (0x007D)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Registers of one slave read by a single request: the merged range of
+ * all the tags that overlap or are next to each other.  The tags are
+ * pointers to the sorted table, their values are in pusRegs.
+ */
+
+typedef struct
+{
+  uint8_t ucSlaveAddr;
+  eMBMasterSchedRegType eRegType;
+  uint16_t usRegAddr;
+  uint16_t usNRegs;
+  uint16_t usFirstTag;
+  uint16_t usNTags;
+  uint16_t *pusRegs;
+} xMBMasterSchedBlock;
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static pthread_mutex_t xSchedLock = PTHREAD_MUTEX_INITIALIZER;
+
+static xMBMasterSchedTag **ppxSchedTags;
+static uint16_t usSchedNTags;
+static xMBMasterSchedBlock *pxSchedBlocks;
+static uint16_t usSchedNBlocks;
+static uint16_t *pusSchedCache;
+
+/* Request in progress, only its response is stored in the cache */
+
+static xMBMasterSchedBlock *pxSchedCur;
+static uint16_t usSchedCurAddr;
+static uint16_t usSchedCurNRegs;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint32_t prvulMBMasterSchedNow(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static int prviMBMasterSchedCompare(const void *pvA, const void *pvB)
+{
+  const xMBMasterSchedTag *pxA = *(xMBMasterSchedTag * const *)pvA;
+  const xMBMasterSchedTag *pxB = *(xMBMasterSchedTag * const *)pvB;
+
+  if (pxA->ucSlaveAddr != pxB->ucSlaveAddr)
+    {
+      return (int)pxA->ucSlaveAddr - (int)pxB->ucSlaveAddr;
+    }
+
+  if (pxA->eRegType != pxB->eRegType)
+    {
+      return (int)pxA->eRegType - (int)pxB->eRegType;
+    }
+
+  return (int)pxA->usRegAddr - (int)pxB->usRegAddr;
+}
+
+/* Merge the sorted tags into blocks: a tag joins the previous block if it
+ * is the same table of the same slave, starts at most
+ * CONFIG_MB_MASTER_SCHED_MAX_GAP registers after its end and the block
+ * still fits in one request.
+ */
+
+static uint32_t prvulMBMasterSchedMerge(void)
+{
+  xMBMasterSchedBlock *pxBlock = NULL;
+  xMBMasterSchedTag *pxTag;
+  uint32_t ulBlockEnd = 0;
+  uint32_t ulTagEnd;
+  uint32_t ulNRegs = 0;
+  uint16_t usTag;
+
+  usSchedNBlocks = 0;
+  for (usTag = 0; usTag < usSchedNTags; usTag++)
+    {
+      pxTag = ppxSchedTags[usTag];
+      ulTagEnd = (uint32_t)pxTag->usRegAddr + pxTag->usNRegs;
+
+      if (pxBlock != NULL &&
+          pxBlock->ucSlaveAddr == pxTag->ucSlaveAddr &&
+          pxBlock->eRegType == pxTag->eRegType &&
+          pxTag->usRegAddr <= ulBlockEnd + CONFIG_MB_MASTER_SCHED_MAX_GAP &&
+          (ulTagEnd > ulBlockEnd ? ulTagEnd : ulBlockEnd) -
+          pxBlock->usRegAddr <= MB_SCHED_REGCNT_MAX)
+        {
+          if (ulTagEnd > ulBlockEnd)
+            {
+              ulBlockEnd = ulTagEnd;
+            }
+
+          pxBlock->usNTags++;
+        }
+      else
+        {
+          if (pxBlock != NULL)
+            {
+              pxBlock->usNRegs = ulBlockEnd - pxBlock->usRegAddr;
+              ulNRegs += pxBlock->usNRegs;
+            }
+
+          pxBlock = &pxSchedBlocks[usSchedNBlocks++];
+          pxBlock->ucSlaveAddr = pxTag->ucSlaveAddr;
+          pxBlock->eRegType = pxTag->eRegType;
+          pxBlock->usRegAddr = pxTag->usRegAddr;
+          pxBlock->usFirstTag = usTag;
+          pxBlock->usNTags = 1;
+          ulBlockEnd = ulTagEnd;
+        }
+
+      pxTag->usBlock = usSchedNBlocks - 1;
+    }
+
+  if (pxBlock != NULL)
+    {
+      pxBlock->usNRegs = ulBlockEnd - pxBlock->usRegAddr;
+      ulNRegs += pxBlock->usNRegs;
+    }
+
+  return ulNRegs;
+}
+
+/* Read the part of a block that covers all of its due tags, the tags in
+ * between are refreshed by the same request.
+ */
+
+static void prvvMBMasterSchedRead(xMBMasterSchedBlock *pxBlock,
+                                  uint32_t ulNow)
+{
+  eMBMasterReqErrCode eErrStatus;
+  xMBMasterSchedTag *pxTag;
+  uint32_t ulStart = UINT32_MAX;
+  uint32_t ulEnd = 0;
+  uint16_t usTag;
+
+  for (usTag = 0; usTag < pxBlock->usNTags; usTag++)
+    {
+      pxTag = ppxSchedTags[pxBlock->usFirstTag + usTag];
+      if ((int32_t)(ulNow - pxTag->ulDueMs) >= 0)
+        {
+          if (pxTag->usRegAddr < ulStart)
+            {
+              ulStart = pxTag->usRegAddr;
+            }
+
+          if ((uint32_t)pxTag->usRegAddr + pxTag->usNRegs > ulEnd)
+            {
+              ulEnd = (uint32_t)pxTag->usRegAddr + pxTag->usNRegs;
+            }
+        }
+    }
+
+  if (ulEnd == 0)
+    {
+      return;
+    }
+
+  pthread_mutex_lock(&xSchedLock);
+  pxSchedCur = pxBlock;
+  usSchedCurAddr = ulStart;
+  usSchedCurNRegs = ulEnd - ulStart;
+  pthread_mutex_unlock(&xSchedLock);
+
+  if (pxBlock->eRegType == MB_SCHED_REG_HOLDING)
+    {
+      eErrStatus = eMBMasterReqReadHoldingRegister(pxBlock->ucSlaveAddr,
+                                                   ulStart, ulEnd - ulStart,
+                                                   -1);
+    }
+  else
+    {
+      eErrStatus = eMBMasterReqReadInputRegister(pxBlock->ucSlaveAddr,
+                                                 ulStart, ulEnd - ulStart,
+                                                 -1);
+    }
+
+  pthread_mutex_lock(&xSchedLock);
+  pxSchedCur = NULL;
+
+  for (usTag = 0; usTag < pxBlock->usNTags; usTag++)
+    {
+      pxTag = ppxSchedTags[pxBlock->usFirstTag + usTag];
+      if (pxTag->usRegAddr >= ulStart &&
+          (uint32_t)pxTag->usRegAddr + pxTag->usNRegs <= ulEnd)
+        {
+          pxTag->eStatus = eErrStatus;
+          pxTag->ulDueMs = ulNow + pxTag->ulPeriodMs;
+          if (eErrStatus == MB_MRE_NO_ERR)
+            {
+              pxTag->ulUpdateMs = prvulMBMasterSchedNow();
+              pxTag->xValid = true;
+            }
+        }
+    }
+
+  pthread_mutex_unlock(&xSchedLock);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: eMBMasterSchedInit
+ *
+ * Description:
+ *   Start polling a table of tags.  Tags of the same slave and register
+ *   table that overlap or are next to each other are merged in the
+ *   fewest requests of at most 125 registers, that are all due at the
+ *   first call of ulMBMasterSchedPoll().  The table must stay valid until
+ *   vMBMasterSchedClose().
+ *
+ ****************************************************************************/
+
+eMBMasterReqErrCode eMBMasterSchedInit(xMBMasterSchedTag *pxTags,
+                                       uint16_t usNTags)
+{
+  uint32_t ulNRegs;
+  uint32_t ulNow;
+  uint16_t usBlock;
+  uint16_t usTag;
+
+  if (usNTags == 0)
+    {
+      return MB_MRE_ILL_ARG;
+    }
+
+  for (usTag = 0; usTag < usNTags; usTag++)
+    {
+      if (pxTags[usTag].ucSlaveAddr < MB_ADDRESS_MIN ||
+          pxTags[usTag].ucSlaveAddr > CONFIG_MB_MASTER_TOTAL_SLAVE_NUM ||
+          pxTags[usTag].usNRegs < 1 ||
+          pxTags[usTag].usNRegs > MB_SCHED_REGCNT_MAX ||
+          (uint32_t)pxTags[usTag].usRegAddr + pxTags[usTag].usNRegs >
+          UINT16_MAX + 1)
+        {
+          return MB_MRE_ILL_ARG;
+        }
+    }
+
+  vMBMasterSchedClose();
+
+  ppxSchedTags = malloc(usNTags * sizeof(xMBMasterSchedTag *));
+  pxSchedBlocks = malloc(usNTags * sizeof(xMBMasterSchedBlock));
+  if (ppxSchedTags == NULL || pxSchedBlocks == NULL)
+    {
+      goto errout;
+    }
+
+  ulNow = prvulMBMasterSchedNow();
+  for (usTag = 0; usTag < usNTags; usTag++)
+    {
+      pxTags[usTag].ulDueMs = ulNow;
+      pxTags[usTag].eStatus = MB_MRE_TIMEDOUT;
+      pxTags[usTag].xValid = false;
+      ppxSchedTags[usTag] = &pxTags[usTag];
+    }
+
+  usSchedNTags = usNTags;
+  qsort(ppxSchedTags, usNTags, sizeof(xMBMasterSchedTag *),
+        prviMBMasterSchedCompare);
+
+  ulNRegs = prvulMBMasterSchedMerge();
+  pusSchedCache = calloc(ulNRegs, sizeof(uint16_t));
+  if (pusSchedCache == NULL)
+    {
+      goto errout;
+    }
+
+  ulNRegs = 0;
+  for (usBlock = 0; usBlock < usSchedNBlocks; usBlock++)
+    {
+      pxSchedBlocks[usBlock].pusRegs = &pusSchedCache[ulNRegs];
+      ulNRegs += pxSchedBlocks[usBlock].usNRegs;
+    }
+
+  return MB_MRE_NO_ERR;
+
+errout:
+  vMBMasterSchedClose();
+  return MB_MRE_EXE_FUN;
+}
+
+/****************************************************************************
+ * Name: vMBMasterSchedClose
+ *
+ * Description:
+ *   Stop polling and free the cache.
+ *
+ ****************************************************************************/
+
+void vMBMasterSchedClose(void)
+{
+  pthread_mutex_lock(&xSchedLock);
+  free(pusSchedCache);
+  free(pxSchedBlocks);
+  free(ppxSchedTags);
+  pusSchedCache = NULL;
+  pxSchedBlocks = NULL;
+  ppxSchedTags = NULL;
+  usSchedNBlocks = 0;
+  usSchedNTags = 0;
+  pthread_mutex_unlock(&xSchedLock);
+}
+
+/****************************************************************************
+ * Name: ulMBMasterSchedPoll
+ *
+ * Description:
+ *   Send the requests of all the due tags, one per block, each waiting
+ *   for its response.  Called periodically from the application task,
+ *   not from the task of eMBMasterPoll().
+ *
+ * Returned Value:
+ *   Milliseconds until the next tag is due.
+ *
+ ****************************************************************************/
+
+uint32_t ulMBMasterSchedPoll(void)
+{
+  uint32_t ulWait = UINT32_MAX;
+  uint32_t ulNow;
+  int32_t lLeft;
+  uint16_t usBlock;
+  uint16_t usTag;
+
+  ulNow = prvulMBMasterSchedNow();
+  for (usBlock = 0; usBlock < usSchedNBlocks; usBlock++)
+    {
+      prvvMBMasterSchedRead(&pxSchedBlocks[usBlock], ulNow);
+    }
+
+  ulNow = prvulMBMasterSchedNow();
+  for (usTag = 0; usTag < usSchedNTags; usTag++)
+    {
+      lLeft = (int32_t)(ppxSchedTags[usTag]->ulDueMs - ulNow);
+      if (lLeft <= 0)
+        {
+          return 0;
+        }
+
+      if ((uint32_t)lLeft < ulWait)
+        {
+          ulWait = lLeft;
+        }
+    }
+
+  return ulWait;
+}
+
+/****************************************************************************
+ * Name: eMBMasterSchedGet
+ *
+ * Description:
+ *   Copy the cached registers of a tag.
+ *
+ * Input Parameters:
+ *   pxTag A tag of the table given to eMBMasterSchedInit().
+ *   pusRegs Receives usNRegs values, if the tag was read at least once.
+ *   pulAgeMs Receives the age of the values, may be NULL.
+ *
+ * Returned Value:
+ *   The result of the last request that read the tag.  After an error,
+ *   the values and their age are still those of the last good response.
+ *
+ ****************************************************************************/
+
+eMBMasterReqErrCode eMBMasterSchedGet(const xMBMasterSchedTag *pxTag,
+                                      uint16_t *pusRegs,
+                                      uint32_t *pulAgeMs)
+{
+  xMBMasterSchedBlock *pxBlock;
+  eMBMasterReqErrCode eErrStatus;
+
+  pthread_mutex_lock(&xSchedLock);
+  if (pxTag->xValid && pxTag->usBlock < usSchedNBlocks)
+    {
+      pxBlock = &pxSchedBlocks[pxTag->usBlock];
+      memcpy(pusRegs, &pxBlock->pusRegs[pxTag->usRegAddr -
+                                        pxBlock->usRegAddr],
+             pxTag->usNRegs * sizeof(uint16_t));
+
+      if (pulAgeMs != NULL)
+        {
+          *pulAgeMs = prvulMBMasterSchedNow() - pxTag->ulUpdateMs;
+        }
+    }
+
+  eErrStatus = pxTag->eStatus;
+  pthread_mutex_unlock(&xSchedLock);
+  return eErrStatus;
+}
+
+/****************************************************************************
+ * Name: vMBMasterSchedUpdate
+ *
+ * Description:
+ *   Store the registers of a read response in the cache, if it answers
+ *   the request of the scheduler.  Called by the master read functions
+ *   before the register callback of the application.
+ *
+ ****************************************************************************/
+
+void vMBMasterSchedUpdate(uint8_t ucSlaveAddr,
+                          eMBMasterSchedRegType eRegType,
+                          uint16_t usRegAddr, uint16_t usNRegs,
+                          const uint8_t *pucRegBuffer)
+{
+  xMBMasterSchedBlock *pxBlock;
+  uint16_t *pusRegs;
+  uint16_t usReg;
+
+  pthread_mutex_lock(&xSchedLock);
+  pxBlock = pxSchedCur;
+  if (pxBlock != NULL && pxBlock->ucSlaveAddr == ucSlaveAddr &&
+      pxBlock->eRegType == eRegType && usSchedCurAddr == usRegAddr &&
+      usSchedCurNRegs == usNRegs)
+    {
+      pusRegs = &pxBlock->pusRegs[usRegAddr - pxBlock->usRegAddr];
+      for (usReg = 0; usReg < usNRegs; usReg++)
+        {
+          pusRegs[usReg] = (uint16_t)(pucRegBuffer[0] << 8) |
+                           pucRegBuffer[1];
+          pucRegBuffer += 2;
+        }
+    }
+
+  pthread_mutex_unlock(&xSchedLock);
+}
+
+#endif /* CONFIG_MB_MASTER_SCHEDULER */
@@ -83,6 +83,12 @@ bool xMBPortEventGet(eMBEventType * eEvent)
 
       xMBPortSerialPoll();
 
+#ifdef CONFIG_MB_TCP_ENABLED
+      /* Serve the requests of the TCP clients, one at a time. */
+
+      xMBTCPPortPoll();
+#endif
+
       /* Check if any of the timers have expired. */
 
       vMBPortTimerPoll();
@@ -71,6 +71,9 @@ static bool     bRxEnabled;
 static bool     bTxEnabled;
 
 static uint32_t ulTimeoutMs;
+#ifdef CONFIG_MB_RTU_FRAME_RX
+static uint32_t ulTimeoutT35Us;
+#endif
 static uint8_t  ucBuffer[BUF_SIZE];
 static int      uiRxBufferPos;
 static int      uiTxBufferPos;
@@ -82,7 +85,8 @@ static struct termios xOldTIO;
  ****************************************************************************/
 
 static bool prvbMBPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                 uint16_t *usNBytesRead);
+                                 uint16_t *usNBytesRead,
+                                 uint32_t ulTimeoutUs);
 static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes);
 
 /****************************************************************************
@@ -90,7 +94,8 @@ static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes);
  ****************************************************************************/
 
 static bool prvbMBPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                 uint16_t *usNBytesRead)
+                                 uint16_t *usNBytesRead,
+                                 uint32_t ulTimeoutUs)
 {
   bool            bResult = true;
   ssize_t         res;
@@ -98,7 +103,7 @@ static bool prvbMBPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
   struct timeval  tv;
 
   tv.tv_sec = 0;
-  tv.tv_usec = 50000;
+  tv.tv_usec = ulTimeoutUs;
   FD_ZERO(&rfds);
   FD_SET(iSerialFd, &rfds);
 
@@ -138,6 +143,66 @@ static bool prvbMBPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
   return bResult;
 }
 
+#ifdef CONFIG_MB_RTU_FRAME_RX
+/* Read a whole RTU frame into ucBuffer: wait for its first characters,
+ * then read until the line is silent for t3.5.  A frame too long for the
+ * buffer is read to its end and dropped.
+ */
+
+static bool prvbMBPortSerialReadFrame(uint16_t *usNBytesRead)
+{
+  uint8_t  ucDiscard[16];
+  uint8_t *pucNext = &ucBuffer[0];
+  uint16_t usFree = BUF_SIZE;
+  uint16_t usLen = 0;
+  uint16_t usRead;
+  uint32_t ulTimeoutUs = 50000;
+  bool     bOverflow = false;
+
+  *usNBytesRead = 0;
+
+  do
+    {
+      if (!prvbMBPortSerialRead(pucNext, usFree, &usRead, ulTimeoutUs))
+        {
+          return false;
+        }
+
+      if (pucNext == ucDiscard)
+        {
+          bOverflow |= usRead > 0;
+        }
+      else
+        {
+          usLen += usRead;
+        }
+
+      if (usLen < BUF_SIZE)
+        {
+          pucNext = &ucBuffer[usLen];
+          usFree = BUF_SIZE - usLen;
+        }
+      else
+        {
+          pucNext = ucDiscard;
+          usFree = sizeof(ucDiscard);
+        }
+
+      ulTimeoutUs = ulTimeoutT35Us;
+    }
+  while (usRead > 0);
+
+  if (bOverflow)
+    {
+      vMBPortLog(MB_LOG_WARN, "SER-POLL", "frame too long, dropped\n");
+      return true;
+    }
+
+  *usNBytesRead = usLen;
+  return true;
+}
+#endif
+
 static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes)
 {
   ssize_t res;
@@ -255,6 +320,14 @@ bool xMBPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
             bStatus = false;
         }
 
+#ifdef CONFIG_MB_RTU_FRAME_RX
+      /* t3.5 is fixed to 1750us above 19200 baud, else it is 3.5
+       * characters of 11 bits.
+       */
+
+      ulTimeoutT35Us = ulBaudRate > 19200 ? 1750 : 38500000UL / ulBaudRate;
+#endif
+
       if (bStatus)
         {
           /* Set the new baud.  The following might be compatible with other
@@ -325,7 +398,32 @@ bool xMBPortSerialPoll(void)
 
   while (bRxEnabled)
     {
-      if (prvbMBPortSerialRead(&ucBuffer[0], BUF_SIZE, &usBytesRead))
+#ifdef CONFIG_MB_RTU_FRAME_RX
+      /* RTU frames are passed whole, instead of one character at a time
+       * with the t3.5 timer restarted after each one.
+       */
+
+      if (pxMBFrameCBFrameReceived != NULL)
+        {
+          if (!prvbMBPortSerialReadFrame(&usBytesRead))
+            {
+              vMBPortLog(MB_LOG_ERROR, "SER-POLL",
+                         "read failed on serial device: %d\n", errno);
+              bStatus = false;
+              break;
+            }
+
+          if (usBytesRead > 0)
+            {
+              pxMBFrameCBFrameReceived(&ucBuffer[0], usBytesRead);
+            }
+
+          break;
+        }
+#endif
+
+      if (prvbMBPortSerialRead(&ucBuffer[0], BUF_SIZE, &usBytesRead,
+                               50000))
         {
           if (usBytesRead == 0)
             {
@@ -75,6 +75,9 @@ static bool     bRxEnabled;
 static bool     bTxEnabled;
 
 static uint32_t ulTimeoutMs;
+#ifdef CONFIG_MB_RTU_FRAME_RX
+static uint32_t ulTimeoutT35Us;
+#endif
 static uint8_t  ucBuffer[BUF_SIZE];
 static int      uiRxBufferPos;
 static int      uiTxBufferPos;
@@ -86,7 +89,8 @@ static struct termios xOldTIO;
  ****************************************************************************/
 
 static bool prvbMBMasterPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                       uint16_t *usNBytesRead);
+                                       uint16_t *usNBytesRead,
+                                       uint32_t ulTimeoutUs);
 static bool prvbMBMasterPortSerialWrite(uint8_t *pucBuffer,
                                         uint16_t usNBytes);
 
@@ -95,7 +99,8 @@ static bool prvbMBMasterPortSerialWrite(uint8_t *pucBuffer,
  ****************************************************************************/
 
 static bool prvbMBMasterPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                       uint16_t *usNBytesRead)
+                                       uint16_t *usNBytesRead,
+                                       uint32_t ulTimeoutUs)
 {
   bool            bResult = true;
   ssize_t         res;
@@ -103,7 +108,7 @@ static bool prvbMBMasterPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
   struct timeval  tv;
 
   tv.tv_sec = 0;
-  tv.tv_usec = 5000;
+  tv.tv_usec = ulTimeoutUs;
   FD_ZERO(&rfds);
   FD_SET(iSerialFd, &rfds);
 
@@ -143,6 +148,66 @@ static bool prvbMBMasterPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
   return bResult;
 }
 
+#ifdef CONFIG_MB_RTU_FRAME_RX
+/* Read a whole RTU frame into ucBuffer: wait for its first characters,
+ * then read until the line is silent for t3.5.  A frame too long for the
+ * buffer is read to its end and dropped.
+ */
+
+static bool prvbMBMasterPortSerialReadFrame(uint16_t *usNBytesRead)
+{
+  uint8_t  ucDiscard[16];
+  uint8_t *pucNext = &ucBuffer[0];
+  uint16_t usFree = BUF_SIZE;
+  uint16_t usLen = 0;
+  uint16_t usRead;
+  uint32_t ulTimeoutUs = 5000;
+  bool     bOverflow = false;
+
+  *usNBytesRead = 0;
+
+  do
+    {
+      if (!prvbMBMasterPortSerialRead(pucNext, usFree, &usRead, ulTimeoutUs))
+        {
+          return false;
+        }
+
+      if (pucNext == ucDiscard)
+        {
+          bOverflow |= usRead > 0;
+        }
+      else
+        {
+          usLen += usRead;
+        }
+
+      if (usLen < BUF_SIZE)
+        {
+          pucNext = &ucBuffer[usLen];
+          usFree = BUF_SIZE - usLen;
+        }
+      else
+        {
+          pucNext = ucDiscard;
+          usFree = sizeof(ucDiscard);
+        }
+
+      ulTimeoutUs = ulTimeoutT35Us;
+    }
+  while (usRead > 0);
+
+  if (bOverflow)
+    {
+      vMBMasterPortLog(MB_LOG_WARN, "SER-POLL", "frame too long, dropped\n");
+      return true;
+    }
+
+  *usNBytesRead = usLen;
+  return true;
+}
+#endif
+
 static bool prvbMBMasterPortSerialWrite(uint8_t *pucBuffer,
                                         uint16_t usNBytes)
 {
@@ -263,6 +328,14 @@ bool xMBMasterPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
             bStatus = false;
         }
 
+#ifdef CONFIG_MB_RTU_FRAME_RX
+      /* t3.5 is fixed to 1750us above 19200 baud, else it is 3.5
+       * characters of 11 bits.
+       */
+
+      ulTimeoutT35Us = ulBaudRate > 19200 ? 1750 : 38500000UL / ulBaudRate;
+#endif
+
       if (bStatus)
         {
           /* Set the new baud.  The following might be compatible with other
@@ -333,7 +406,32 @@ bool xMBMasterPortSerialPoll(void)
 
   while (bRxEnabled)
     {
-      if (prvbMBMasterPortSerialRead(&ucBuffer[0], BUF_SIZE, &usBytesRead))
+#ifdef CONFIG_MB_RTU_FRAME_RX
+      /* RTU frames are passed whole, instead of one character at a time
+       * with the t3.5 timer restarted after each one.
+       */
+
+      if (pxMBMasterFrameCBFrameReceived != NULL)
+        {
+          if (!prvbMBMasterPortSerialReadFrame(&usBytesRead))
+            {
+              vMBMasterPortLog(MB_LOG_ERROR, "SER-POLL",
+                               "read failed on serial device: %d\n", errno);
+              bStatus = false;
+              break;
+            }
+
+          if (usBytesRead > 0)
+            {
+              pxMBMasterFrameCBFrameReceived(&ucBuffer[0], usBytesRead);
+            }
+
+          break;
+        }
+#endif
+
+      if (prvbMBMasterPortSerialRead(&ucBuffer[0], BUF_SIZE, &usBytesRead,
+                                     5000))
         {
           if (usBytesRead == 0)
             {
@@ -0,0 +1,439 @@
+/****************************************************************************
+ * apps/modbus/nuttx/porttcp.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "port.h"
+
+#include "modbus/mb.h"
+#include "modbus/mbport.h"
+
+#ifdef CONFIG_MB_TCP_ENABLED
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MB_TCP_DEFAULT_PORT  502
+#define MB_TCP_POLL_MS       50
+
+/* MBAP header: transaction, protocol, length and unit identifiers.  The
+ * length counts the unit identifier and the PDU, up to 253 bytes.
+ */
+
+#define MB_TCP_LEN           4
+#define MB_TCP_FUNC          7
+#define MB_TCP_ADU_MAX       (MB_TCP_FUNC + 253)
+
+#define MB_TCP_QUEUE_SIZE    (CONFIG_MB_TCP_QUEUE_DEPTH * MB_TCP_ADU_MAX)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A client connection.  Its pipelined requests wait in rxbuf and are
+ * served in order, the responses wait in txbuf until the socket takes
+ * them.
+ */
+
+typedef struct
+{
+  int      iSocket;
+  uint16_t usRxLen;
+  uint16_t usTxLen;
+  uint8_t  ucRxBuf[MB_TCP_QUEUE_SIZE];
+  uint8_t  ucTxBuf[MB_TCP_QUEUE_SIZE];
+} xMBTCPConn;
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static int         iListenSocket = -1;
+static xMBTCPConn *pxConns[CONFIG_MB_TCP_MAX_CONNECTIONS];
+static int         iNextConn;
+
+/* The request being served: the stack builds its response in place, so
+ * the MBAP header and its transaction identifier are sent back as is.
+ */
+
+static xMBTCPConn *pxCurConn;
+static uint8_t     ucTCPFrame[MB_TCP_ADU_MAX];
+static uint16_t    usTCPFrameLen;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void prvvMBTCPConnClose(xMBTCPConn *pxConn)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CONNECTIONS; i++)
+    {
+      if (pxConns[i] == pxConn)
+        {
+          pxConns[i] = NULL;
+        }
+    }
+
+  if (pxConn == pxCurConn)
+    {
+      pxCurConn = NULL;
+    }
+
+  close(pxConn->iSocket);
+  free(pxConn);
+}
+
+static void prvvMBTCPAccept(void)
+{
+  xMBTCPConn *pxConn;
+  int iSocket;
+  int iOne = 1;
+  int i;
+
+  iSocket = accept(iListenSocket, NULL, NULL);
+  if (iSocket < 0)
+    {
+      return;
+    }
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CONNECTIONS; i++)
+    {
+      if (pxConns[i] == NULL)
+        {
+          break;
+        }
+    }
+
+  pxConn = NULL;
+  if (i < CONFIG_MB_TCP_MAX_CONNECTIONS)
+    {
+      pxConn = malloc(sizeof(xMBTCPConn));
+    }
+
+  if (pxConn == NULL)
+    {
+      vMBPortLog(MB_LOG_WARN, "TCP", "Connection refused\n");
+      close(iSocket);
+      return;
+    }
+
+  fcntl(iSocket, F_SETFL, fcntl(iSocket, F_GETFL) | O_NONBLOCK);
+  setsockopt(iSocket, IPPROTO_TCP, TCP_NODELAY, &iOne, sizeof(iOne));
+
+  pxConn->iSocket = iSocket;
+  pxConn->usRxLen = 0;
+  pxConn->usTxLen = 0;
+  pxConns[i]      = pxConn;
+}
+
+static bool prvbMBTCPFlush(xMBTCPConn *pxConn)
+{
+  ssize_t res;
+
+  while (pxConn->usTxLen > 0)
+    {
+      res = send(pxConn->iSocket, pxConn->ucTxBuf, pxConn->usTxLen, 0);
+      if (res < 0)
+        {
+          return errno == EAGAIN || errno == EINTR;
+        }
+
+      pxConn->usTxLen -= res;
+      memmove(pxConn->ucTxBuf, &pxConn->ucTxBuf[res], pxConn->usTxLen);
+    }
+
+  return true;
+}
+
+/* Return the length of the first request queued, 0 if it is not complete
+ * yet or -1 if the stream is not Modbus TCP.
+ */
+
+static int prviMBTCPRequestLen(xMBTCPConn *pxConn)
+{
+  uint16_t usLen;
+
+  if (pxConn->usRxLen < MB_TCP_FUNC)
+    {
+      return 0;
+    }
+
+  usLen = pxConn->ucRxBuf[MB_TCP_LEN] << 8 | pxConn->ucRxBuf[MB_TCP_LEN + 1];
+  if (usLen < 2 || MB_TCP_LEN + 2 + usLen > MB_TCP_ADU_MAX)
+    {
+      return -1;
+    }
+
+  usLen += MB_TCP_LEN + 2;
+  return pxConn->usRxLen >= usLen ? usLen : 0;
+}
+
+/* Take the next request, in turn from each connection whose responses
+ * have room, and signal it to the stack.
+ */
+
+static bool prvbMBTCPDispatch(void)
+{
+  xMBTCPConn *pxConn;
+  int iLen;
+  int i;
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CONNECTIONS; i++)
+    {
+      pxConn    = pxConns[iNextConn];
+      iNextConn = (iNextConn + 1) % CONFIG_MB_TCP_MAX_CONNECTIONS;
+
+      if (pxConn == NULL ||
+          pxConn->usTxLen + MB_TCP_ADU_MAX > MB_TCP_QUEUE_SIZE)
+        {
+          continue;
+        }
+
+      iLen = prviMBTCPRequestLen(pxConn);
+      if (iLen > 0)
+        {
+          memcpy(ucTCPFrame, pxConn->ucRxBuf, iLen);
+          pxConn->usRxLen -= iLen;
+          memmove(pxConn->ucRxBuf, &pxConn->ucRxBuf[iLen], pxConn->usRxLen);
+
+          pxCurConn     = pxConn;
+          usTCPFrameLen = iLen;
+          return xMBPortEventPost(EV_FRAME_RECEIVED);
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+bool xMBTCPPortInit(uint16_t usTCPPort)
+{
+  struct sockaddr_in xAddr;
+  int iOne = 1;
+
+  iListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+  if (iListenSocket < 0)
+    {
+      vMBPortLog(MB_LOG_ERROR, "TCP", "socket failed: %d\n", errno);
+      return false;
+    }
+
+  setsockopt(iListenSocket, SOL_SOCKET, SO_REUSEADDR, &iOne, sizeof(iOne));
+
+  memset(&xAddr, 0, sizeof(xAddr));
+  xAddr.sin_family      = AF_INET;
+  xAddr.sin_port        = htons(usTCPPort == MB_TCP_PORT_USE_DEFAULT ?
+                                MB_TCP_DEFAULT_PORT : usTCPPort);
+  xAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  if (bind(iListenSocket, (struct sockaddr *)&xAddr, sizeof(xAddr)) < 0 ||
+      listen(iListenSocket, CONFIG_MB_TCP_MAX_CONNECTIONS) < 0)
+    {
+      vMBPortLog(MB_LOG_ERROR, "TCP", "bind/listen failed: %d\n", errno);
+      close(iListenSocket);
+      iListenSocket = -1;
+      return false;
+    }
+
+  fcntl(iListenSocket, F_SETFL,
+        fcntl(iListenSocket, F_GETFL) | O_NONBLOCK);
+  return true;
+}
+
+void vMBTCPPortDisable(void)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CONNECTIONS; i++)
+    {
+      if (pxConns[i] != NULL)
+        {
+          prvvMBTCPConnClose(pxConns[i]);
+        }
+    }
+}
+
+#ifdef CONFIG_MB_HAVE_CLOSE
+void vMBTCPPortClose(void)
+{
+  vMBTCPPortDisable();
+
+  if (iListenSocket != -1)
+    {
+      close(iListenSocket);
+      iListenSocket = -1;
+    }
+}
+#endif
+
+bool xMBTCPPortGetRequest(uint8_t **ppucMBTCPFrame, uint16_t *usTCPLength)
+{
+  *ppucMBTCPFrame = ucTCPFrame;
+  *usTCPLength    = usTCPFrameLen;
+  return true;
+}
+
+bool xMBTCPPortSendResponse(const uint8_t *pucMBTCPFrame,
+                            uint16_t usTCPLength)
+{
+  xMBTCPConn *pxConn = pxCurConn;
+
+  /* The client may have gone while its request was served */
+
+  pxCurConn = NULL;
+  if (pxConn == NULL)
+    {
+      return false;
+    }
+
+  memcpy(&pxConn->ucTxBuf[pxConn->usTxLen], pucMBTCPFrame, usTCPLength);
+  pxConn->usTxLen += usTCPLength;
+
+  if (!prvbMBTCPFlush(pxConn))
+    {
+      prvvMBTCPConnClose(pxConn);
+      return false;
+    }
+
+  return true;
+}
+
+/* Called from the event loop: serve the requests already queued, else
+ * wait for the connections for a while.
+ */
+
+bool xMBTCPPortPoll(void)
+{
+  struct pollfd xFds[CONFIG_MB_TCP_MAX_CONNECTIONS + 1];
+  xMBTCPConn *pxFdConns[CONFIG_MB_TCP_MAX_CONNECTIONS + 1];
+  xMBTCPConn *pxConn;
+  ssize_t res;
+  int nFds = 0;
+  int i;
+
+  if (iListenSocket < 0)
+    {
+      return false;
+    }
+
+  if (prvbMBTCPDispatch())
+    {
+      return true;
+    }
+
+  xFds[nFds].fd     = iListenSocket;
+  xFds[nFds].events = POLLIN;
+  nFds++;
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CONNECTIONS; i++)
+    {
+      pxConn = pxConns[i];
+      if (pxConn == NULL)
+        {
+          continue;
+        }
+
+      /* A full queue is left in the socket, the client has to wait */
+
+      xFds[nFds].fd     = pxConn->iSocket;
+      xFds[nFds].events = 0;
+      if (pxConn->usRxLen < MB_TCP_QUEUE_SIZE)
+        {
+          xFds[nFds].events |= POLLIN;
+        }
+
+      if (pxConn->usTxLen > 0)
+        {
+          xFds[nFds].events |= POLLOUT;
+        }
+
+      pxFdConns[nFds] = pxConn;
+      nFds++;
+    }
+
+  if (poll(xFds, nFds, MB_TCP_POLL_MS) <= 0)
+    {
+      return false;
+    }
+
+  for (i = 1; i < nFds; i++)
+    {
+      pxConn = pxFdConns[i];
+      if (xFds[i].revents & POLLOUT)
+        {
+          if (!prvbMBTCPFlush(pxConn))
+            {
+              prvvMBTCPConnClose(pxConn);
+              continue;
+            }
+        }
+
+      if ((xFds[i].revents & (POLLIN | POLLHUP | POLLERR)) &&
+          pxConn->usRxLen < MB_TCP_QUEUE_SIZE)
+        {
+          res = recv(pxConn->iSocket, &pxConn->ucRxBuf[pxConn->usRxLen],
+                     MB_TCP_QUEUE_SIZE - pxConn->usRxLen, 0);
+          if (res == 0 || (res < 0 && errno != EAGAIN && errno != EINTR))
+            {
+              prvvMBTCPConnClose(pxConn);
+              continue;
+            }
+
+          if (res > 0)
+            {
+              pxConn->usRxLen += res;
+            }
+
+          if (prviMBTCPRequestLen(pxConn) < 0)
+            {
+              vMBPortLog(MB_LOG_WARN, "TCP", "Invalid MBAP header\n");
+              prvvMBTCPConnClose(pxConn);
+            }
+        }
+    }
+
+  if (xFds[0].revents & POLLIN)
+    {
+      prvvMBTCPAccept();
+    }
+
+  return prvbMBTCPDispatch();
+}
+
+#endif /* CONFIG_MB_TCP_ENABLED */
@@ -33,6 +33,8 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include "port.h"
 
 /****************************************************************************
@@ -91,6 +93,44 @@ static const uint8_t aucCRCLo[] =
   0x41, 0x81, 0x80, 0x40
 };
 
+#ifdef CONFIG_MB_CRC16_SLICING
+/* Tables for 8 bytes at a time, built from the byte tables on first use.
+ * ausCRCSlice[k][i] is the CRC of byte i followed by k zero bytes.
+ */
+
+static uint16_t ausCRCSlice[8][256];
+static volatile bool bCRCSliceReady;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_MB_CRC16_SLICING
+static void prvvMBCRC16InitSlices(void)
+{
+  uint16_t usCRC;
+  int i;
+  int k;
+
+  for (i = 0; i < 256; i++)
+    {
+      ausCRCSlice[0][i] = (uint16_t)(aucCRCLo[i] << 8 | aucCRCHi[i]);
+    }
+
+  for (k = 1; k < 8; k++)
+    {
+      for (i = 0; i < 256; i++)
+        {
+          usCRC = ausCRCSlice[k - 1][i];
+          ausCRCSlice[k][i] = (usCRC >> 8) ^ ausCRCSlice[0][usCRC & 0xff];
+        }
+    }
+
+  bCRCSliceReady = true;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -101,6 +141,32 @@ uint16_t usMBCRC16(uint8_t * pucFrame, uint16_t usLen)
   uint8_t ucCRCLo = 0xff;
   int iIndex;
 
+#ifdef CONFIG_MB_CRC16_SLICING
+  uint16_t usCRC = 0xffff;
+
+  if (!bCRCSliceReady)
+    {
+      prvvMBCRC16InitSlices();
+    }
+
+  while (usLen >= 8)
+    {
+      usCRC = ausCRCSlice[7][(usCRC ^ pucFrame[0]) & 0xff] ^
+              ausCRCSlice[6][(usCRC >> 8) ^ pucFrame[1]] ^
+              ausCRCSlice[5][pucFrame[2]] ^
+              ausCRCSlice[4][pucFrame[3]] ^
+              ausCRCSlice[3][pucFrame[4]] ^
+              ausCRCSlice[2][pucFrame[5]] ^
+              ausCRCSlice[1][pucFrame[6]] ^
+              ausCRCSlice[0][pucFrame[7]];
+      pucFrame += 8;
+      usLen -= 8;
+    }
+
+  ucCRCHi = (uint8_t)(usCRC >> 8);
+  ucCRCLo = (uint8_t)usCRC;
+#endif
+
   while(usLen--)
     {
       iIndex = ucCRCLo ^ *(pucFrame++);
@@ -315,6 +315,42 @@ bool xMBRTUReceiveFSM(void)
   return xTaskNeedSwitch;
 }
 
+#ifdef CONFIG_MB_RTU_FRAME_RX
+bool xMBRTUReceiveFrame(uint8_t *pucFrame, uint16_t usLen)
+{
+  bool xNeedPoll = false;
+
+  DEBUGASSERT(eSndState == STATE_TX_IDLE);
+
+  /* The port already waited for t3.5 after the last character, so this
+   * does at once what the receive FSM and the t3.5 timer do.
+   */
+
+  switch (eRcvState)
+    {
+      /* The bus was not free at start-up, wait for t3.5 again. */
+
+      case STATE_RX_INIT:
+        vMBPortTimersEnable();
+        break;
+
+      case STATE_RX_IDLE:
+        if (usLen <= MB_SER_PDU_SIZE_MAX)
+          {
+            memcpy((uint8_t *)ucRTUBuf, pucFrame, usLen);
+            usRcvBufferPos = usLen;
+            xNeedPoll = xMBPortEventPost(EV_FRAME_RECEIVED);
+          }
+        break;
+
+      default:
+        break;
+    }
+
+  return xNeedPoll;
+}
+#endif
+
 bool xMBRTUTransmitFSM(void)
 {
   bool xNeedPoll = false;
@@ -50,6 +50,9 @@ eMBErrorCode eMBRTUReceive(uint8_t *pucRcvAddress, uint8_t **pucFrame,
 eMBErrorCode eMBRTUSend(uint8_t slaveAddress, const uint8_t *pucFrame,
                         uint16_t usLength);
 bool xMBRTUReceiveFSM(void);
+#ifdef CONFIG_MB_RTU_FRAME_RX
+bool xMBRTUReceiveFrame(uint8_t *pucFrame, uint16_t usLen);
+#endif
 bool xMBRTUTransmitFSM(void);
 bool xMBRTUTimerT15Expired(void);
 bool xMBRTUTimerT35Expired(void);
@@ -343,6 +343,53 @@ bool xMBMasterRTUReceiveFSM(void)
   return xTaskNeedSwitch;
 }
 
+#ifdef CONFIG_MB_RTU_FRAME_RX
+bool xMBMasterRTUReceiveFrame(uint8_t *pucFrame, uint16_t usLen)
+{
+  bool xNeedPoll = false;
+
+  DEBUGASSERT((eSndState == STATE_M_TX_IDLE) ||
+         (eSndState == STATE_M_TX_XFWR));
+
+  /* The port already waited for t3.5 after the last character, so this
+   * does at once what the receive FSM and the t3.5 timer do.
+   */
+
+  switch (eRcvState)
+    {
+      /* The bus was not free at start-up, wait for t3.5 again. */
+
+    case STATE_M_RX_INIT:
+      vMBMasterPortTimersT35Enable();
+      break;
+
+      /* The respond timeout is over, a frame was received. */
+
+    case STATE_M_RX_IDLE:
+      vMBMasterPortTimersDisable();
+      eSndState = STATE_M_TX_IDLE;
+
+      if (usLen <= MB_SER_PDU_SIZE_MAX)
+        {
+          memcpy((uint8_t *)ucMasterRTURcvBuf, pucFrame, usLen);
+          usMasterRcvBufferPos = usLen;
+          xNeedPoll = xMBMasterPortEventPost(EV_MASTER_FRAME_RECEIVED);
+        }
+      else
+        {
+          vMBMasterSetErrorType(EV_ERROR_RECEIVE_DATA);
+          xNeedPoll = xMBMasterPortEventPost(EV_MASTER_ERROR_PROCESS);
+        }
+      break;
+
+    default:
+      break;
+    }
+
+  return xNeedPoll;
+}
+#endif
+
 bool xMBMasterRTUTransmitFSM(void)
 {
   bool xNeedPoll = false;
@@ -50,6 +50,9 @@ eMBErrorCode eMBMasterRTUReceive(uint8_t *pucRcvAddress, uint8_t **pucFrame,
 eMBErrorCode eMBMasterRTUSend(uint8_t slaveAddress, const uint8_t *pucFrame,
                               uint16_t usLength);
 bool xMBMasterRTUReceiveFSM(void);
+#ifdef CONFIG_MB_RTU_FRAME_RX
+bool xMBMasterRTUReceiveFrame(uint8_t *pucFrame, uint16_t usLen);
+#endif
 bool xMBMasterRTUTransmitFSM(void);
 bool xMBMasterRTUTimerExpired(void);
 
@@ -0,0 +1,212 @@
+/****************************************************************************
+ * apps/netutils/cjson/cjson_arena.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "netutils/cjson_arena.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Nodes hold a double */
+
+#define ARENA_ALIGN          sizeof(double)
+#define ARENA_ALIGN_UP(x)    (((x) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* cJSON hooks are global, so parses are serialized and the hooks only
+ * allocate from the arena for the thread that owns it.
+ */
+
+static pthread_mutex_t g_cjson_arena_lock = PTHREAD_MUTEX_INITIALIZER;
+static FAR struct cjson_arena_s *g_cjson_arena;
+static pid_t g_cjson_arena_owner;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: cjson_arena_malloc
+ ****************************************************************************/
+
+static FAR void *cjson_arena_malloc(size_t size)
+{
+  FAR struct cjson_arena_s *arena = g_cjson_arena;
+  FAR void *ptr;
+
+  if (arena == NULL || g_cjson_arena_owner != gettid())
+    {
+      return malloc(size);
+    }
+
+  size = ARENA_ALIGN_UP(size);
+  if (size > arena->size - arena->used)
+    {
+      return NULL;
+    }
+
+  ptr          = arena->base + arena->used;
+  arena->used += size;
+  if (arena->used > arena->peak)
+    {
+      arena->peak = arena->used;
+    }
+
+  return ptr;
+}
+
+/****************************************************************************
+ * Name: cjson_arena_dealloc
+ ****************************************************************************/
+
+static void cjson_arena_dealloc(FAR void *ptr)
+{
+  FAR struct cjson_arena_s *arena = g_cjson_arena;
+
+  /* Memory of the arena is only released with the arena */
+
+  if (arena != NULL && (FAR uint8_t *)ptr >= arena->base &&
+      (FAR uint8_t *)ptr < arena->base + arena->size)
+    {
+      return;
+    }
+
+  free(ptr);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: cjson_arena_init
+ ****************************************************************************/
+
+int cjson_arena_init(FAR struct cjson_arena_s *arena, FAR void *buf,
+                     size_t size)
+{
+  uintptr_t pad;
+
+  if (size == 0)
+    {
+      size = CONFIG_NETUTILS_CJSON_ARENA_SIZE;
+    }
+
+  if (buf == NULL)
+    {
+      buf = malloc(size);
+      if (buf == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      arena->allocated = true;
+    }
+  else
+    {
+      /* Align a buffer of the caller for the nodes */
+
+      pad  = ARENA_ALIGN_UP((uintptr_t)buf) - (uintptr_t)buf;
+      size = size > pad ? size - pad : 0;
+      buf  = (FAR uint8_t *)buf + pad;
+      arena->allocated = false;
+    }
+
+  arena->base = (FAR uint8_t *)buf;
+  arena->size = size;
+  arena->used = 0;
+  arena->peak = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: cjson_arena_parse
+ ****************************************************************************/
+
+FAR cJSON *cjson_arena_parse(FAR struct cjson_arena_s *arena,
+                             FAR const char *value)
+{
+  cJSON_Hooks hooks;
+  FAR cJSON *json;
+  size_t mark;
+
+  hooks.malloc_fn = cjson_arena_malloc;
+  hooks.free_fn   = cjson_arena_dealloc;
+
+  pthread_mutex_lock(&g_cjson_arena_lock);
+
+  mark                = arena->used;
+  g_cjson_arena_owner = gettid();
+  g_cjson_arena       = arena;
+  cJSON_InitHooks(&hooks);
+
+  json = cJSON_Parse(value);
+
+  cJSON_InitHooks(NULL);
+  g_cjson_arena = NULL;
+
+  pthread_mutex_unlock(&g_cjson_arena_lock);
+
+  if (json == NULL)
+    {
+      arena->used = mark;
+    }
+
+  return json;
+}
+
+/****************************************************************************
+ * Name: cjson_arena_reset
+ ****************************************************************************/
+
+void cjson_arena_reset(FAR struct cjson_arena_s *arena)
+{
+  arena->used = 0;
+}
+
+/****************************************************************************
+ * Name: cjson_arena_free
+ ****************************************************************************/
+
+void cjson_arena_free(FAR struct cjson_arena_s *arena)
+{
+  if (arena->allocated)
+    {
+      free(arena->base);
+    }
+
+  arena->base = NULL;
+  arena->size = 0;
+  arena->used = 0;
+}
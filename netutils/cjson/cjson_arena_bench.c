@@ -0,0 +1,258 @@
+/****************************************************************************
+ * apps/netutils/cjson/cjson_arena_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "netutils/cjson_arena.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_SENSORS     200
+#define BENCH_ITERATIONS  50
+
+/* Header in front of each counted allocation, keeps the alignment */
+
+#define BENCH_HDRSIZE     sizeof(double)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static size_t g_heap_used;
+static size_t g_heap_peak;
+static size_t g_heap_count;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static double bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/****************************************************************************
+ * Name: bench_malloc
+ *
+ * Description:
+ *   malloc() that counts the bytes requested by cJSON.
+ *
+ ****************************************************************************/
+
+static FAR void *bench_malloc(size_t size)
+{
+  FAR size_t *ptr = malloc(BENCH_HDRSIZE + size);
+
+  if (ptr == NULL)
+    {
+      return NULL;
+    }
+
+  *ptr         = size;
+  g_heap_used += size;
+  g_heap_count++;
+  if (g_heap_used > g_heap_peak)
+    {
+      g_heap_peak = g_heap_used;
+    }
+
+  return (FAR uint8_t *)ptr + BENCH_HDRSIZE;
+}
+
+/****************************************************************************
+ * Name: bench_free
+ ****************************************************************************/
+
+static void bench_free(FAR void *ptr)
+{
+  FAR size_t *hdr;
+
+  if (ptr != NULL)
+    {
+      hdr          = (FAR size_t *)((FAR uint8_t *)ptr - BENCH_HDRSIZE);
+      g_heap_used -= *hdr;
+      free(hdr);
+    }
+}
+
+/****************************************************************************
+ * Name: bench_load
+ *
+ * Description:
+ *   Read a JSON file, or generate a telemetry configuration of about
+ *   20 KB if there is none.
+ *
+ ****************************************************************************/
+
+static FAR char *bench_load(FAR const char *path)
+{
+  FAR FILE *stream;
+  FAR char *text;
+  struct stat st;
+  size_t size;
+  size_t len;
+  int i;
+
+  if (path != NULL)
+    {
+      if (stat(path, &st) < 0 || (stream = fopen(path, "r")) == NULL)
+        {
+          fprintf(stderr, "ERROR: Can't open %s\n", path);
+          return NULL;
+        }
+
+      text = malloc(st.st_size + 1);
+      if (text != NULL)
+        {
+          len       = fread(text, 1, st.st_size, stream);
+          text[len] = '\0';
+        }
+
+      fclose(stream);
+      return text;
+    }
+
+  size = 128 * BENCH_SENSORS + 128;
+  text = malloc(size);
+  if (text == NULL)
+    {
+      return NULL;
+    }
+
+  len = snprintf(text, size, "{\"device\":\"rtu-01\",\"period\":100,"
+                 "\"sensors\":[");
+  for (i = 0; i < BENCH_SENSORS; i++)
+    {
+      len += snprintf(text + len, size - len,
+                      "%s{\"id\":%d,\"name\":\"sensor-%03d\","
+                      "\"unit\":\"degC\",\"offset\":%d.25,"
+                      "\"limits\":[-40,125],\"enabled\":%s}",
+                      i > 0 ? "," : "", i, i, i % 7,
+                      i % 3 ? "true" : "false");
+    }
+
+  snprintf(text + len, size - len, "]}");
+  return text;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct cjson_arena_s arena;
+  cJSON_Hooks hooks;
+  FAR cJSON *json;
+  FAR char *text;
+  double start;
+  double elapsed;
+  int ret = EXIT_FAILURE;
+  int i;
+
+  text = bench_load(argc > 1 ? argv[1] : NULL);
+  if (text == NULL)
+    {
+      return EXIT_FAILURE;
+    }
+
+  if (cjson_arena_init(&arena, NULL, 0) < 0)
+    {
+      fprintf(stderr, "ERROR: No memory for the arena\n");
+      goto errout;
+    }
+
+  printf("%zu bytes of JSON, %d parses\n", strlen(text),
+         BENCH_ITERATIONS);
+
+  /* Heap: the peak is measured once, apart from the timing */
+
+  hooks.malloc_fn = bench_malloc;
+  hooks.free_fn   = bench_free;
+  cJSON_InitHooks(&hooks);
+  json = cJSON_Parse(text);
+  cJSON_Delete(json);
+  cJSON_InitHooks(NULL);
+
+  if (json == NULL)
+    {
+      fprintf(stderr, "ERROR: Invalid JSON\n");
+      goto errout_with_arena;
+    }
+
+  start = bench_now();
+  for (i = 0; i < BENCH_ITERATIONS; i++)
+    {
+      cJSON_Delete(cJSON_Parse(text));
+    }
+
+  elapsed = bench_now() - start;
+  printf("heap   %8.1f us/parse, peak %zu bytes in %zu allocations\n",
+         elapsed * 1e6 / BENCH_ITERATIONS, g_heap_peak, g_heap_count);
+
+  /* Arena */
+
+  start = bench_now();
+  for (i = 0; i < BENCH_ITERATIONS; i++)
+    {
+      if (cjson_arena_parse(&arena, text) == NULL)
+        {
+          fprintf(stderr, "ERROR: Arena of %zu bytes too small\n",
+                  arena.size);
+          goto errout_with_arena;
+        }
+
+      cjson_arena_reset(&arena);
+    }
+
+  elapsed = bench_now() - start;
+  printf("arena  %8.1f us/parse, peak %zu of %zu bytes\n",
+         elapsed * 1e6 / BENCH_ITERATIONS, arena.peak, arena.size);
+  ret = EXIT_SUCCESS;
+
+errout_with_arena:
+  cjson_arena_free(&arena);
+errout:
+  free(text);
+  return ret;
+}
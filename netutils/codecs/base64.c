@@ -53,6 +53,7 @@
  * Included Files
  ****************************************************************************/
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
@@ -61,6 +62,45 @@
 
 #ifdef CONFIG_CODECS_BASE64
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define XX 0xff  /* Not in the alphabet */
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Value of each 7-bit character, XX if it is not in the alphabet.  The
+ * web safe alphabet maps both of its '_' to 62, as the table search that
+ * this replaces did.
+ */
+
+static const uint8_t g_base64_dec[128] =
+{
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, 62, XX, XX, XX, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, XX, XX, XX, XX, XX, XX,
+  XX,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, XX, XX, XX, XX, XX,
+  XX, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, XX, XX, XX, XX, XX
+};
+
+static const uint8_t g_base64w_dec[128] =
+{
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, XX, XX, XX, XX, XX, XX,
+  XX,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, XX, XX, XX, XX, 62,
+  XX, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, XX, XX, XX, XX, XX
+};
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -79,6 +119,94 @@ static FAR const char *base64_tab(bool websafe)
   return websafe ? _tab_w : _tab;
 }
 
+/****************************************************************************
+ * Name: base64_value
+ *
+ * Description:
+ *   Return the value of the character c, XX if it is not in the alphabet.
+ *
+ ****************************************************************************/
+
+static inline uint8_t base64_value(FAR const uint8_t *dec, unsigned char c)
+{
+  return c < 128 ? dec[c] : XX;
+}
+
+/****************************************************************************
+ * Name: base64_encode_blocks
+ *
+ * Description:
+ *   Encode the len / 3 complete blocks of src, each block as one 24-bit
+ *   word split in four table lookups.
+ *
+ * Returned Value:
+ *   The number of characters written to dst
+ *
+ ****************************************************************************/
+
+static size_t base64_encode_blocks(FAR const char *tab,
+                                   FAR const unsigned char *src,
+                                   size_t len, FAR unsigned char *dst)
+{
+  FAR unsigned char *pos = dst;
+  uint32_t v;
+
+  for (; len >= 3; len -= 3, src += 3, pos += 4)
+    {
+      v = (uint32_t)src[0] << 16 | (uint32_t)src[1] << 8 | src[2];
+      pos[0] = tab[v >> 18];
+      pos[1] = tab[(v >> 12) & 0x3f];
+      pos[2] = tab[(v >> 6) & 0x3f];
+      pos[3] = tab[v & 0x3f];
+    }
+
+  return pos - dst;
+}
+
+/****************************************************************************
+ * Name: base64_decode_blocks
+ *
+ * Description:
+ *   Decode complete four character blocks of src as long as they are all
+ *   in the alphabet.  The four values are looked up and checked together
+ *   and written as three bytes.
+ *
+ * Returned Value:
+ *   The number of characters of src consumed, a multiple of four.  The
+ *   number of bytes written to dst is three quarters of it.
+ *
+ ****************************************************************************/
+
+static size_t base64_decode_blocks(FAR const uint8_t *dec,
+                                   FAR const unsigned char *src,
+                                   size_t len, FAR unsigned char *dst)
+{
+  FAR const unsigned char *in = src;
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+  uint32_t d;
+
+  for (; len >= 4; len -= 4, in += 4, dst += 3)
+    {
+      a = base64_value(dec, in[0]);
+      b = base64_value(dec, in[1]);
+      c = base64_value(dec, in[2]);
+      d = base64_value(dec, in[3]);
+      if (((a | b | c | d) & 0x80) != 0)
+        {
+          break;
+        }
+
+      a = a << 18 | b << 12 | c << 6 | d;
+      dst[0] = a >> 16;
+      dst[1] = a >> 8;
+      dst[2] = a;
+    }
+
+  return in - src;
+}
+
 /****************************************************************************
  * Name: _base64_encode
  *
@@ -138,14 +266,8 @@ static FAR unsigned char *_base64_encode(FAR const unsigned char *src,
         }
     }
 
-  while (end - in >= 3)
-    {
-      *pos++ = base64_table[in[0] >> 2];
-      *pos++ = base64_table[((in[0] & 0x03) << 4) | (in[1] >> 4)];
-      *pos++ = base64_table[((in[1] & 0x0f) << 2) | (in[2] >> 6)];
-      *pos++ = base64_table[in[2] & 0x3f];
-      in += 3;
-    }
+  pos += base64_encode_blocks(base64_table, in, len, pos);
+  in  += len / 3 * 3;
 
   if (end - in != 0)
     {
@@ -199,10 +321,11 @@ static unsigned char *_base64_decode(FAR const unsigned char *src,
   FAR unsigned char *out;
   FAR unsigned char *pos;
   FAR unsigned char block[4];
-  FAR const char *base64_table;
+  FAR const uint8_t *dec;
   char ch = '=';
-  FAR char *tmp;
   size_t count;
+  uint8_t v;
+  size_t n;
   size_t i;
 
   if (websafe)
@@ -210,7 +333,7 @@ static unsigned char *_base64_decode(FAR const unsigned char *src,
       ch = '.';
     }
 
-  base64_table = base64_tab(websafe);
+  dec = websafe ? g_base64w_dec : g_base64_dec;
 
   if (dst)
     {
@@ -228,8 +351,23 @@ static unsigned char *_base64_decode(FAR const unsigned char *src,
   count = 0;
   for (i = 0; i < len; i++)
     {
-      tmp = strchr(base64_table, src[i]);
-      block[count] = tmp ? tmp - base64_table : 0;
+      /* Whole blocks without padding or foreign characters go through the
+       * fast path, the others one character at a time.
+       */
+
+      if (count == 0)
+        {
+          n    = base64_decode_blocks(dec, &src[i], len - i, pos);
+          pos += n / 4 * 3;
+          i   += n;
+          if (i == len)
+            {
+              break;
+            }
+        }
+
+      v = base64_value(dec, src[i]);
+      block[count] = v != XX ? v : 0;
       count++;
 
       if (count == 4)
@@ -317,4 +455,210 @@ FAR void *base64w_decode(FAR const void *src, size_t len, FAR void *dst,
   return _base64_decode(src, len, dst, out_len, true);
 }
 
+/****************************************************************************
+ * Name: base64_encode_init
+ *
+ * Description:
+ *   Start a streaming encode with the standard or the web safe alphabet.
+ *
+ ****************************************************************************/
+
+void base64_encode_init(FAR struct base64_context_s *ctx, bool websafe)
+{
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->websafe = websafe;
+}
+
+/****************************************************************************
+ * Name: base64_encode_update
+ *
+ * Description:
+ *   Encode the next len bytes of the data.  Up to two bytes that don't
+ *   make a whole block are kept in the context for the next call.  dst
+ *   must hold base64_encode_length(len) characters, no NUL terminator is
+ *   written.
+ *
+ * Returned Value:
+ *   The number of characters written to dst
+ *
+ ****************************************************************************/
+
+size_t base64_encode_update(FAR struct base64_context_s *ctx,
+                            FAR const void *src, size_t len,
+                            FAR void *dst)
+{
+  FAR const unsigned char *in = src;
+  FAR const char *tab = base64_tab(ctx->websafe);
+  FAR unsigned char *out = dst;
+  size_t n = 0;
+
+  /* Complete the block started by the last call */
+
+  if (ctx->len > 0)
+    {
+      while (ctx->len < 3 && len > 0)
+        {
+          ctx->buf[ctx->len++] = *in++;
+          len--;
+        }
+
+      if (ctx->len < 3)
+        {
+          return 0;
+        }
+
+      n = base64_encode_blocks(tab, ctx->buf, 3, out);
+      ctx->len = 0;
+    }
+
+  n  += base64_encode_blocks(tab, in, len, &out[n]);
+  in += len / 3 * 3;
+  len %= 3;
+
+  memcpy(ctx->buf, in, len);
+  ctx->len = len;
+  return n;
+}
+
+/****************************************************************************
+ * Name: base64_encode_final
+ *
+ * Description:
+ *   Encode the bytes left in the context with padding.  dst must hold four
+ *   characters, no NUL terminator is written.
+ *
+ * Returned Value:
+ *   The number of characters written to dst
+ *
+ ****************************************************************************/
+
+size_t base64_encode_final(FAR struct base64_context_s *ctx, FAR void *dst)
+{
+  unsigned char out[5];
+  size_t n = 0;
+
+  if (ctx->len > 0)
+    {
+      _base64_encode(ctx->buf, ctx->len, out, &n, ctx->websafe);
+      memcpy(dst, out, n);
+      ctx->len = 0;
+    }
+
+  return n;
+}
+
+/****************************************************************************
+ * Name: base64_decode_init
+ *
+ * Description:
+ *   Start a streaming decode with the standard or the web safe alphabet.
+ *
+ ****************************************************************************/
+
+void base64_decode_init(FAR struct base64_context_s *ctx, bool websafe)
+{
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->websafe = websafe;
+}
+
+/****************************************************************************
+ * Name: base64_decode_update
+ *
+ * Description:
+ *   Decode the next len characters.  Characters that are not in the
+ *   alphabet, such as line breaks, are skipped, and everything after the
+ *   padding is ignored.  Up to three characters that don't make a whole
+ *   block are kept in the context for the next call.  dst must hold
+ *   base64_decode_length(len) + 3 bytes.
+ *
+ * Returned Value:
+ *   The number of bytes written to dst
+ *
+ ****************************************************************************/
+
+size_t base64_decode_update(FAR struct base64_context_s *ctx,
+                            FAR const void *src, size_t len,
+                            FAR void *dst)
+{
+  FAR const unsigned char *in = src;
+  FAR const uint8_t *dec;
+  FAR unsigned char *out = dst;
+  FAR unsigned char *pos = out;
+  char ch = ctx->websafe ? '.' : '=';
+  uint8_t v;
+  size_t n;
+  size_t i;
+
+  dec = ctx->websafe ? g_base64w_dec : g_base64_dec;
+
+  for (i = 0; i < len && !ctx->done; i++)
+    {
+      if (ctx->len == 0)
+        {
+          n    = base64_decode_blocks(dec, &in[i], len - i, pos);
+          pos += n / 4 * 3;
+          i   += n;
+          if (i == len)
+            {
+              break;
+            }
+        }
+
+      v = base64_value(dec, in[i]);
+      if (v != XX)
+        {
+          ctx->buf[ctx->len++] = v;
+          if (ctx->len == 4)
+            {
+              *pos++ = (ctx->buf[0] << 2) | (ctx->buf[1] >> 4);
+              *pos++ = (ctx->buf[1] << 4) | (ctx->buf[2] >> 2);
+              *pos++ = (ctx->buf[2] << 6) | ctx->buf[3];
+              ctx->len = 0;
+            }
+        }
+      else if (in[i] == ch)
+        {
+          /* Padding ends the data: the partial block holds one byte for
+           * two characters, two bytes for three.
+           */
+
+          pos += base64_decode_final(ctx, pos);
+          ctx->done = true;
+        }
+    }
+
+  return pos - out;
+}
+
+/****************************************************************************
+ * Name: base64_decode_final
+ *
+ * Description:
+ *   Decode the characters left in the context, for data that ends without
+ *   padding.  dst must hold two bytes.
+ *
+ * Returned Value:
+ *   The number of bytes written to dst
+ *
+ ****************************************************************************/
+
+size_t base64_decode_final(FAR struct base64_context_s *ctx, FAR void *dst)
+{
+  FAR unsigned char *pos = dst;
+  size_t n = 0;
+
+  if (ctx->len >= 2)
+    {
+      pos[n++] = (ctx->buf[0] << 2) | (ctx->buf[1] >> 4);
+    }
+
+  if (ctx->len >= 3)
+    {
+      pos[n++] = (ctx->buf[1] << 4) | (ctx->buf[2] >> 2);
+    }
+
+  ctx->len = 0;
+  return n;
+}
+
 #endif /* CONFIG_CODECS_BASE64 */
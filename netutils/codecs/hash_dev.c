@@ -0,0 +1,117 @@
+/****************************************************************************
+ * apps/netutils/codecs/hash_dev.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+
+#include <sys/ioctl.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <crypto/cryptodev.h>
+
+#include "hash_dev.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: hash_dev_start
+ ****************************************************************************/
+
+int hash_dev_start(int mac, FAR uint32_t *ses)
+{
+  struct session_op session;
+  int devfd;
+  int fd = -1;
+  int ret;
+
+  devfd = open("/dev/crypto", O_RDWR);
+  if (devfd < 0)
+    {
+      return -1;
+    }
+
+  ret = ioctl(devfd, CRIOGET, &fd);
+  close(devfd);
+  if (ret < 0)
+    {
+      return -1;
+    }
+
+  memset(&session, 0, sizeof(session));
+  session.mac = mac;
+  if (ioctl(fd, CIOCGSESSION, &session) < 0)
+    {
+      close(fd);
+      return -1;
+    }
+
+  *ses = session.ses;
+  return fd;
+}
+
+/****************************************************************************
+ * Name: hash_dev_update
+ ****************************************************************************/
+
+int hash_dev_update(int fd, uint32_t ses, FAR const void *buf, size_t len)
+{
+  struct crypt_op cryp;
+
+  memset(&cryp, 0, sizeof(cryp));
+  cryp.ses   = ses;
+  cryp.op    = COP_ENCRYPT;
+  cryp.flags = COP_FLAG_UPDATE;
+  cryp.src   = (caddr_t)buf;
+  cryp.len   = len;
+
+  return ioctl(fd, CIOCCRYPT, &cryp) < 0 ? -errno : OK;
+}
+
+/****************************************************************************
+ * Name: hash_dev_finish
+ ****************************************************************************/
+
+int hash_dev_finish(int fd, uint32_t ses, FAR unsigned char *digest)
+{
+  struct crypt_op cryp;
+  int ret;
+
+  memset(&cryp, 0, sizeof(cryp));
+  cryp.ses = ses;
+  cryp.op  = COP_ENCRYPT;
+  cryp.mac = (caddr_t)digest;
+
+  ret = ioctl(fd, CIOCCRYPT, &cryp) < 0 ? -errno : OK;
+  ioctl(fd, CIOCFSESSION, &ses);
+  close(fd);
+  return ret;
+}
+
+#endif /* CONFIG_CODECS_HASH_CRYPTODEV */
@@ -0,0 +1,75 @@
+/****************************************************************************
+ * apps/netutils/codecs/hash_dev.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_NETUTILS_CODECS_HASH_DEV_H
+#define __APPS_NETUTILS_CODECS_HASH_DEV_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: hash_dev_start
+ *
+ * Description:
+ *   Open a /dev/crypto hash session for the algorithm mac (CRYPTO_MD5,
+ *   CRYPTO_SHA1, ...).
+ *
+ * Returned Value:
+ *   The session file descriptor, or -1 if there is no engine for mac and
+ *   the hash must be computed in software.
+ *
+ ****************************************************************************/
+
+int hash_dev_start(int mac, FAR uint32_t *ses);
+
+/****************************************************************************
+ * Name: hash_dev_update
+ *
+ * Description:
+ *   Add len bytes to the hash of the session.
+ *
+ ****************************************************************************/
+
+int hash_dev_update(int fd, uint32_t ses, FAR const void *buf, size_t len);
+
+/****************************************************************************
+ * Name: hash_dev_finish
+ *
+ * Description:
+ *   Get the digest, then free the session and close fd.
+ *
+ ****************************************************************************/
+
+int hash_dev_finish(int fd, uint32_t ses, FAR unsigned char *digest);
+
+#endif /* CONFIG_CODECS_HASH_CRYPTODEV */
+#endif /* __APPS_NETUTILS_CODECS_HASH_DEV_H */
@@ -66,7 +66,12 @@
 #include <stdint.h>
 #include <fcntl.h>
 
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+#  include <crypto/cryptodev.h>
+#endif
+
 #include "netutils/md5.h"
+#include "hash_dev.h"
 
 #ifdef CONFIG_CODECS_HASH_MD5
 
@@ -128,7 +133,9 @@ static void byte_reverse(FAR unsigned char *buf, unsigned longs)
  *
  * Description:
  *   Start MD5 accumulation.  Set bit count to 0 and buffer to mysterious
- *   initialization constants.
+ *   initialization constants.  With CONFIG_CODECS_HASH_CRYPTODEV the hash
+ *   is computed by a /dev/crypto engine if there is one for MD5, the
+ *   session is released by md5_final().
  *
  ****************************************************************************/
 
@@ -141,6 +148,10 @@ void md5_init(struct md5_context_s *ctx)
 
   ctx->bits[0] = 0;
   ctx->bits[1] = 0;
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  ctx->fd = hash_dev_start(CRYPTO_MD5, &ctx->ses);
+#endif
 }
 
 /****************************************************************************
@@ -157,6 +168,14 @@ void md5_update(struct md5_context_s *ctx, unsigned char const *buf,
 {
   uint32_t t;
 
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  if (ctx->fd >= 0)
+    {
+      hash_dev_update(ctx->fd, ctx->ses, buf, len);
+      return;
+    }
+#endif
+
   /* Update bitcount */
 
   t = ctx->bits[0];
@@ -193,7 +212,19 @@ void md5_update(struct md5_context_s *ctx, unsigned char const *buf,
       len -= t;
     }
 
-  /* Process data in 64-byte chunks */
+  /* Process data in 64-byte chunks, straight from buf when it is already
+   * in the layout of md5_transform().
+   */
+
+#ifndef CONFIG_ENDIAN_BIG
+  if (((uintptr_t)buf & 3) == 0)
+    {
+      for (; len >= 64; buf += 64, len -= 64)
+        {
+          md5_transform(ctx->buf, (FAR const uint32_t *)buf);
+        }
+    }
+#endif
 
   while (len >= 64)
     {
@@ -223,6 +254,19 @@ void md5_final(unsigned char digest[16], struct md5_context_s *ctx)
   unsigned count;
   unsigned char *p;
 
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  if (ctx->fd >= 0)
+    {
+      if (hash_dev_finish(ctx->fd, ctx->ses, digest) < 0)
+        {
+          memset(digest, 0, 16);
+        }
+
+      memset(ctx, 0, sizeof(struct md5_context_s));
+      return;
+    }
+#endif
+
   /* Compute number of bytes mod 64 */
 
   count = (ctx->bits[0] >> 3) & 0x3f;
@@ -0,0 +1,349 @@
+/****************************************************************************
+ * apps/netutils/codecs/sha1.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+#  include <crypto/cryptodev.h>
+#endif
+
+#include "netutils/sha1.h"
+#include "hash_dev.h"
+
+#ifdef CONFIG_CODECS_HASH_SHA1
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define ROL(x, n)    (((x) << (n)) | ((x) >> (32 - (n))))
+
+/* Message schedule kept in a circular 16 word window */
+
+#define W(i)         (w[(i) & 15] = ROL(w[((i) + 13) & 15] ^ \
+                                        w[((i) + 8) & 15] ^ \
+                                        w[((i) + 2) & 15] ^ \
+                                        w[(i) & 15], 1))
+
+#define SHA_BUFSIZE  1024
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sha1_blocks
+ *
+ * Description:
+ *   Process nblocks whole 64-byte blocks, read straight from data.
+ *
+ ****************************************************************************/
+
+static void sha1_blocks(FAR uint32_t *state, FAR const uint8_t *data,
+                        size_t nblocks)
+{
+  uint32_t w[16];
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+  uint32_t d;
+  uint32_t e;
+  uint32_t f;
+  uint32_t k;
+  uint32_t t;
+  int i;
+
+  for (; nblocks > 0; nblocks--, data += 64)
+    {
+      for (i = 0; i < 16; i++)
+        {
+          w[i] = (uint32_t)data[4 * i] << 24 |
+                 (uint32_t)data[4 * i + 1] << 16 |
+                 (uint32_t)data[4 * i + 2] << 8 |
+                 (uint32_t)data[4 * i + 3];
+        }
+
+      a = state[0];
+      b = state[1];
+      c = state[2];
+      d = state[3];
+      e = state[4];
+
+      for (i = 0; i < 80; i++)
+        {
+          if (i < 20)
+            {
+              f = d ^ (b & (c ^ d));
+              k = 0x5a827999;
+            }
+          else if (i < 40)
+            {
+              f = b ^ c ^ d;
+              k = 0x6ed9eba1;
+            }
+          else if (i < 60)
+            {
+              f = (b & c) | (d & (b | c));
+              k = 0x8f1bbcdc;
+            }
+          else
+            {
+              f = b ^ c ^ d;
+              k = 0xca62c1d6;
+            }
+
+          t = ROL(a, 5) + f + e + k + (i < 16 ? w[i] : W(i));
+          e = d;
+          d = c;
+          c = ROL(b, 30);
+          b = a;
+          a = t;
+        }
+
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+      state[4] += e;
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sha1_init
+ *
+ * Description:
+ *   Start a SHA-1 hash.  With CONFIG_CODECS_HASH_CRYPTODEV the hash is
+ *   computed by a /dev/crypto engine if there is one for SHA-1, the
+ *   session is released by sha1_final().
+ *
+ ****************************************************************************/
+
+void sha1_init(FAR struct sha1_context_s *ctx)
+{
+  ctx->state[0] = 0x67452301;
+  ctx->state[1] = 0xefcdab89;
+  ctx->state[2] = 0x98badcfe;
+  ctx->state[3] = 0x10325476;
+  ctx->state[4] = 0xc3d2e1f0;
+  ctx->count = 0;
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  ctx->fd = hash_dev_start(CRYPTO_SHA1, &ctx->ses);
+#endif
+}
+
+/****************************************************************************
+ * Name: sha1_update
+ *
+ * Description:
+ *   Add len bytes to the hash.  Whole blocks are hashed straight from buf,
+ *   only a partial block at either end is copied to the context.
+ *
+ ****************************************************************************/
+
+void sha1_update(FAR struct sha1_context_s *ctx, FAR const void *buf,
+                 size_t len)
+{
+  FAR const uint8_t *data = buf;
+  size_t used;
+  size_t n;
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  if (ctx->fd >= 0)
+    {
+      hash_dev_update(ctx->fd, ctx->ses, buf, len);
+      return;
+    }
+#endif
+
+  used        = ctx->count & 63;
+  ctx->count += len;
+
+  /* Complete the partial block of the last update */
+
+  if (used > 0)
+    {
+      n = 64 - used;
+      if (len < n)
+        {
+          memcpy(&ctx->buffer[used], data, len);
+          return;
+        }
+
+      memcpy(&ctx->buffer[used], data, n);
+      sha1_blocks(ctx->state, ctx->buffer, 1);
+      data += n;
+      len  -= n;
+    }
+
+  sha1_blocks(ctx->state, data, len / 64);
+  memcpy(ctx->buffer, &data[len & ~63], len & 63);
+}
+
+/****************************************************************************
+ * Name: sha1_final
+ *
+ * Description:
+ *   Pad the message with its length in bits and output the digest, big
+ *   endian.  The context is cleared.
+ *
+ ****************************************************************************/
+
+void sha1_final(FAR uint8_t digest[SHA1_DIGEST_SIZE],
+                FAR struct sha1_context_s *ctx)
+{
+  uint64_t bits;
+  size_t used;
+  int i;
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  if (ctx->fd >= 0)
+    {
+      if (hash_dev_finish(ctx->fd, ctx->ses, digest) < 0)
+        {
+          memset(digest, 0, SHA1_DIGEST_SIZE);
+        }
+
+      memset(ctx, 0, sizeof(*ctx));
+      return;
+    }
+#endif
+
+  bits = ctx->count << 3;
+  used = ctx->count & 63;
+
+  ctx->buffer[used++] = 0x80;
+  if (used > 56)
+    {
+      memset(&ctx->buffer[used], 0, 64 - used);
+      sha1_blocks(ctx->state, ctx->buffer, 1);
+      used = 0;
+    }
+
+  memset(&ctx->buffer[used], 0, 56 - used);
+  for (i = 0; i < 8; i++)
+    {
+      ctx->buffer[63 - i] = (uint8_t)(bits >> (8 * i));
+    }
+
+  sha1_blocks(ctx->state, ctx->buffer, 1);
+
+  for (i = 0; i < 5; i++)
+    {
+      digest[4 * i]     = (uint8_t)(ctx->state[i] >> 24);
+      digest[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+      digest[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+      digest[4 * i + 3] = (uint8_t)ctx->state[i];
+    }
+
+  memset(ctx, 0, sizeof(*ctx));  /* In case it's sensitive */
+}
+
+/****************************************************************************
+ * Name: sha1_sum
+ *
+ * Description:
+ *   SHA-1 hash for a data block
+ *
+ * Input Parameters:
+ *   addr: Pointers to the data area
+ *   len: Lengths of the data block
+ *   mac: Buffer for the hash
+ *
+ ****************************************************************************/
+
+void sha1_sum(FAR const uint8_t *addr, size_t len, FAR uint8_t *mac)
+{
+  struct sha1_context_s ctx;
+
+  sha1_init(&ctx);
+  sha1_update(&ctx, addr, len);
+  sha1_final(mac, &ctx);
+}
+
+/****************************************************************************
+ * Name: sha1_file
+ *
+ * Description:
+ *   SHA-1 hash for a file
+ *
+ * Input Parameters:
+ *   path: File Path
+ *   mac : Buffer for the hash
+ *
+ ****************************************************************************/
+
+int sha1_file(FAR const char *path, FAR uint8_t *mac)
+{
+  struct sha1_context_s ctx;
+  FAR unsigned char *buf;
+  int ret;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  buf = malloc(SHA_BUFSIZE);
+  if (buf == NULL)
+    {
+      ret = -ENOMEM;
+      goto out;
+    }
+
+  sha1_init(&ctx);
+
+  while (1)
+    {
+      ret = read(fd, buf, SHA_BUFSIZE);
+      if (ret <= 0)
+        {
+          ret = ret < 0 ? -errno : 0;
+          break;
+        }
+
+      sha1_update(&ctx, buf, ret);
+    }
+
+  sha1_final(mac, &ctx);
+  free(buf);
+out:
+  close(fd);
+  return ret;
+}
+
+#endif /* CONFIG_CODECS_HASH_SHA1 */
@@ -0,0 +1,355 @@
+/****************************************************************************
+ * apps/netutils/codecs/sha256.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+#  include <crypto/cryptodev.h>
+#endif
+
+#include "netutils/sha256.h"
+#include "hash_dev.h"
+
+#ifdef CONFIG_CODECS_HASH_SHA256
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define ROR(x, n)    (((x) >> (n)) | ((x) << (32 - (n))))
+
+#define S0(x)        (ROR(x, 2) ^ ROR(x, 13) ^ ROR(x, 22))
+#define S1(x)        (ROR(x, 6) ^ ROR(x, 11) ^ ROR(x, 25))
+#define G0(x)        (ROR(x, 7) ^ ROR(x, 18) ^ ((x) >> 3))
+#define G1(x)        (ROR(x, 17) ^ ROR(x, 19) ^ ((x) >> 10))
+
+/* Message schedule kept in a circular 16 word window */
+
+#define W(i)         (w[(i) & 15] += G1(w[((i) + 14) & 15]) + \
+                                     w[((i) + 9) & 15] + \
+                                     G0(w[((i) + 1) & 15]))
+
+#define SHA_BUFSIZE  1024
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const uint32_t g_sha256_k[64] =
+{
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sha256_blocks
+ *
+ * Description:
+ *   Process nblocks whole 64-byte blocks, read straight from data.
+ *
+ ****************************************************************************/
+
+static void sha256_blocks(FAR uint32_t *state, FAR const uint8_t *data,
+                          size_t nblocks)
+{
+  uint32_t w[16];
+  uint32_t s[8];
+  uint32_t t1;
+  uint32_t t2;
+  int i;
+
+  for (; nblocks > 0; nblocks--, data += 64)
+    {
+      for (i = 0; i < 16; i++)
+        {
+          w[i] = (uint32_t)data[4 * i] << 24 |
+                 (uint32_t)data[4 * i + 1] << 16 |
+                 (uint32_t)data[4 * i + 2] << 8 |
+                 (uint32_t)data[4 * i + 3];
+        }
+
+      memcpy(s, state, sizeof(s));
+
+      for (i = 0; i < 64; i++)
+        {
+          t1 = s[7] + S1(s[4]) + (s[6] ^ (s[4] & (s[5] ^ s[6]))) +
+               g_sha256_k[i] + (i < 16 ? w[i] : W(i));
+          t2 = S0(s[0]) + ((s[0] & s[1]) | (s[2] & (s[0] | s[1])));
+
+          s[7] = s[6];
+          s[6] = s[5];
+          s[5] = s[4];
+          s[4] = s[3] + t1;
+          s[3] = s[2];
+          s[2] = s[1];
+          s[1] = s[0];
+          s[0] = t1 + t2;
+        }
+
+      for (i = 0; i < 8; i++)
+        {
+          state[i] += s[i];
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sha256_init
+ *
+ * Description:
+ *   Start a SHA-256 hash.  With CONFIG_CODECS_HASH_CRYPTODEV the hash is
+ *   computed by a /dev/crypto engine if there is one for SHA-256, the
+ *   session is released by sha256_final().
+ *
+ ****************************************************************************/
+
+void sha256_init(FAR struct sha256_context_s *ctx)
+{
+  ctx->state[0] = 0x6a09e667;
+  ctx->state[1] = 0xbb67ae85;
+  ctx->state[2] = 0x3c6ef372;
+  ctx->state[3] = 0xa54ff53a;
+  ctx->state[4] = 0x510e527f;
+  ctx->state[5] = 0x9b05688c;
+  ctx->state[6] = 0x1f83d9ab;
+  ctx->state[7] = 0x5be0cd19;
+  ctx->count = 0;
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  ctx->fd = hash_dev_start(CRYPTO_SHA2_256, &ctx->ses);
+#endif
+}
+
+/****************************************************************************
+ * Name: sha256_update
+ *
+ * Description:
+ *   Add len bytes to the hash.  Whole blocks are hashed straight from buf,
+ *   only a partial block at either end is copied to the context.
+ *
+ ****************************************************************************/
+
+void sha256_update(FAR struct sha256_context_s *ctx, FAR const void *buf,
+                   size_t len)
+{
+  FAR const uint8_t *data = buf;
+  size_t used;
+  size_t n;
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  if (ctx->fd >= 0)
+    {
+      hash_dev_update(ctx->fd, ctx->ses, buf, len);
+      return;
+    }
+#endif
+
+  used        = ctx->count & 63;
+  ctx->count += len;
+
+  /* Complete the partial block of the last update */
+
+  if (used > 0)
+    {
+      n = 64 - used;
+      if (len < n)
+        {
+          memcpy(&ctx->buffer[used], data, len);
+          return;
+        }
+
+      memcpy(&ctx->buffer[used], data, n);
+      sha256_blocks(ctx->state, ctx->buffer, 1);
+      data += n;
+      len  -= n;
+    }
+
+  sha256_blocks(ctx->state, data, len / 64);
+  memcpy(ctx->buffer, &data[len & ~63], len & 63);
+}
+
+/****************************************************************************
+ * Name: sha256_final
+ *
+ * Description:
+ *   Pad the message with its length in bits and output the digest, big
+ *   endian.  The context is cleared.
+ *
+ ****************************************************************************/
+
+void sha256_final(FAR uint8_t digest[SHA256_DIGEST_SIZE],
+                  FAR struct sha256_context_s *ctx)
+{
+  uint64_t bits;
+  size_t used;
+  int i;
+
+#ifdef CONFIG_CODECS_HASH_CRYPTODEV
+  if (ctx->fd >= 0)
+    {
+      if (hash_dev_finish(ctx->fd, ctx->ses, digest) < 0)
+        {
+          memset(digest, 0, SHA256_DIGEST_SIZE);
+        }
+
+      memset(ctx, 0, sizeof(*ctx));
+      return;
+    }
+#endif
+
+  bits = ctx->count << 3;
+  used = ctx->count & 63;
+
+  ctx->buffer[used++] = 0x80;
+  if (used > 56)
+    {
+      memset(&ctx->buffer[used], 0, 64 - used);
+      sha256_blocks(ctx->state, ctx->buffer, 1);
+      used = 0;
+    }
+
+  memset(&ctx->buffer[used], 0, 56 - used);
+  for (i = 0; i < 8; i++)
+    {
+      ctx->buffer[63 - i] = (uint8_t)(bits >> (8 * i));
+    }
+
+  sha256_blocks(ctx->state, ctx->buffer, 1);
+
+  for (i = 0; i < 8; i++)
+    {
+      digest[4 * i]     = (uint8_t)(ctx->state[i] >> 24);
+      digest[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+      digest[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+      digest[4 * i + 3] = (uint8_t)ctx->state[i];
+    }
+
+  memset(ctx, 0, sizeof(*ctx));  /* In case it's sensitive */
+}
+
+/****************************************************************************
+ * Name: sha256_sum
+ *
+ * Description:
+ *   SHA-256 hash for a data block
+ *
+ * Input Parameters:
+ *   addr: Pointers to the data area
+ *   len: Lengths of the data block
+ *   mac: Buffer for the hash
+ *
+ ****************************************************************************/
+
+void sha256_sum(FAR const uint8_t *addr, size_t len, FAR uint8_t *mac)
+{
+  struct sha256_context_s ctx;
+
+  sha256_init(&ctx);
+  sha256_update(&ctx, addr, len);
+  sha256_final(mac, &ctx);
+}
+
+/****************************************************************************
+ * Name: sha256_file
+ *
+ * Description:
+ *   SHA-256 hash for a file
+ *
+ * Input Parameters:
+ *   path: File Path
+ *   mac : Buffer for the hash
+ *
+ ****************************************************************************/
+
+int sha256_file(FAR const char *path, FAR uint8_t *mac)
+{
+  struct sha256_context_s ctx;
+  FAR unsigned char *buf;
+  int ret;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  buf = malloc(SHA_BUFSIZE);
+  if (buf == NULL)
+    {
+      ret = -ENOMEM;
+      goto out;
+    }
+
+  sha256_init(&ctx);
+
+  while (1)
+    {
+      ret = read(fd, buf, SHA_BUFSIZE);
+      if (ret <= 0)
+        {
+          ret = ret < 0 ? -errno : 0;
+          break;
+        }
+
+      sha256_update(&ctx, buf, ret);
+    }
+
+  sha256_final(mac, &ctx);
+  free(buf);
+out:
+  close(fd);
+  return ret;
+}
+
+#endif /* CONFIG_CODECS_HASH_SHA256 */
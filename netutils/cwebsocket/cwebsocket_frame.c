@@ -0,0 +1,305 @@
+/****************************************************************************
+ * apps/netutils/cwebsocket/cwebsocket_frame.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+
+#ifdef __ARM_NEON
+#  include <arm_neon.h>
+#endif
+
+#include "cwebsocket/src/cwebsocket/client.h"
+#include "netutils/cwebsocket_frame.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: cwebsocket_header
+ *
+ * Description:
+ *   Build the header of a masked client frame in hdr and return its length.
+ *
+ ****************************************************************************/
+
+static size_t cwebsocket_header(FAR uint8_t *hdr, uint64_t len, int code,
+                                FAR const uint8_t *key)
+{
+  size_t n = 2;
+  int i;
+
+  hdr[0] = code | 0x80;
+
+  if (len <= 125)
+    {
+      hdr[1] = len | 0x80;
+    }
+  else if (len <= 0xffff)
+    {
+      hdr[1] = 126 | 0x80;
+      hdr[n++] = len >> 8;
+      hdr[n++] = len;
+    }
+  else
+    {
+      hdr[1] = 127 | 0x80;
+      for (i = 56; i >= 0; i -= 8)
+        {
+          hdr[n++] = len >> i;
+        }
+    }
+
+  memcpy(&hdr[n], key, 4);
+  return n + 4;
+}
+
+/****************************************************************************
+ * Name: cwebsocket_write_all
+ ****************************************************************************/
+
+static int cwebsocket_write_all(FAR cwebsocket_client *websocket,
+                                FAR uint8_t *buf, size_t len)
+{
+  ssize_t ret;
+  size_t off = 0;
+
+  while (off < len)
+    {
+      ret = cwebsocket_client_write(websocket, buf + off, len - off);
+      if (ret <= 0)
+        {
+          return -1;
+        }
+
+      off += ret;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: cwebsocket_txq_elapsed
+ ****************************************************************************/
+
+static bool cwebsocket_txq_elapsed(FAR struct cwebsocket_txq_s *txq)
+{
+  struct timespec now;
+  int64_t ms;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  ms = (int64_t)(now.tv_sec - txq->first.tv_sec) * 1000 +
+       (now.tv_nsec - txq->first.tv_nsec) / 1000000;
+
+  return ms >= txq->interval;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: cwebsocket_mask
+ ****************************************************************************/
+
+void cwebsocket_mask(FAR uint8_t *dst, FAR const uint8_t *src, size_t len,
+                     FAR const uint8_t *key, uint64_t offset)
+{
+  uint8_t k[4];
+  uint32_t k32;
+  uint32_t w;
+  size_t i;
+
+  /* Rotate the key so that k[0] applies to src[0]; memcpy() keeps its byte
+   * order in k32 whatever the endianness.
+   */
+
+  for (i = 0; i < 4; i++)
+    {
+      k[i] = key[(offset + i) & 3];
+    }
+
+  memcpy(&k32, k, 4);
+
+#ifdef __ARM_NEON
+  if (len >= 16)
+    {
+      uint8x16_t vk = vreinterpretq_u8_u32(vdupq_n_u32(k32));
+
+      for (; len >= 16; len -= 16, src += 16, dst += 16)
+        {
+          vst1q_u8(dst, veorq_u8(vld1q_u8(src), vk));
+        }
+    }
+#endif
+
+  for (; len >= 4; len -= 4, src += 4, dst += 4)
+    {
+      memcpy(&w, src, 4);
+      w ^= k32;
+      memcpy(dst, &w, 4);
+    }
+
+  for (i = 0; i < len; i++)
+    {
+      dst[i] = src[i] ^ k[i];
+    }
+}
+
+/****************************************************************************
+ * Name: cwebsocket_client_write_frame
+ ****************************************************************************/
+
+int cwebsocket_client_write_frame(FAR struct _cwebsocket *websocket,
+                                  FAR const char *data, uint64_t len,
+                                  int code, FAR const uint8_t *key)
+{
+  uint8_t buf[CWEBSOCKET_HDRLEN_MAX + CONFIG_CWEBSOCKET_TXBUFSIZE];
+  uint64_t off = 0;
+  size_t pos;
+  size_t n;
+  int total;
+
+  pos = cwebsocket_header(buf, len, code, key);
+  total = pos + len;
+
+  do
+    {
+      n = MIN(len - off, sizeof(buf) - pos);
+      cwebsocket_mask(buf + pos, (FAR const uint8_t *)data + off, n, key,
+                      off);
+
+      if (cwebsocket_write_all(websocket, buf, pos + n) < 0)
+        {
+          return -1;
+        }
+
+      off += n;
+      pos = 0;
+    }
+  while (off < len);
+
+  return total;
+}
+
+/****************************************************************************
+ * Name: cwebsocket_txq_init
+ ****************************************************************************/
+
+void cwebsocket_txq_init(FAR struct cwebsocket_txq_s *txq,
+                         FAR struct _cwebsocket *websocket,
+                         FAR uint8_t *buf, size_t size,
+                         unsigned int interval)
+{
+  memset(txq, 0, sizeof(*txq));
+  txq->websocket = websocket;
+  txq->buf       = buf;
+  txq->size      = size;
+  txq->interval  = interval;
+}
+
+/****************************************************************************
+ * Name: cwebsocket_txq_write
+ ****************************************************************************/
+
+int cwebsocket_txq_write(FAR struct cwebsocket_txq_s *txq,
+                         FAR const char *data, size_t len, int code)
+{
+  FAR cwebsocket_client *websocket = txq->websocket;
+  uint8_t key[4];
+  uint32_t r;
+  size_t hdrlen;
+
+  if ((websocket->state & WEBSOCKET_STATE_OPEN) == 0)
+    {
+      return -1;
+    }
+
+  r = random() ^ ((uint32_t)random() << 16);
+  memcpy(key, &r, 4);
+
+  if (txq->len > 0 &&
+      (txq->len + CWEBSOCKET_HDRLEN_MAX + len > txq->size ||
+       (txq->interval > 0 && cwebsocket_txq_elapsed(txq))))
+    {
+      if (cwebsocket_txq_flush(txq) < 0)
+        {
+          return -1;
+        }
+    }
+
+  if (CWEBSOCKET_HDRLEN_MAX + len > txq->size)
+    {
+      return cwebsocket_client_write_frame(websocket, data, len, code,
+                                           key) < 0 ? -1 : (int)len;
+    }
+
+  if (txq->len == 0)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &txq->first);
+    }
+
+  hdrlen = cwebsocket_header(txq->buf + txq->len, len, code, key);
+  txq->len += hdrlen;
+  cwebsocket_mask(txq->buf + txq->len, (FAR const uint8_t *)data, len,
+                  key, 0);
+  txq->len += len;
+
+  return len;
+}
+
+/****************************************************************************
+ * Name: cwebsocket_txq_poll
+ ****************************************************************************/
+
+int cwebsocket_txq_poll(FAR struct cwebsocket_txq_s *txq)
+{
+  if (txq->len > 0 && cwebsocket_txq_elapsed(txq))
+    {
+      return cwebsocket_txq_flush(txq);
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: cwebsocket_txq_flush
+ ****************************************************************************/
+
+int cwebsocket_txq_flush(FAR struct cwebsocket_txq_s *txq)
+{
+  size_t len = txq->len;
+
+  txq->len = 0;
+  if (len > 0)
+    {
+      return cwebsocket_write_all(txq->websocket, txq->buf, len);
+    }
+
+  return 0;
+}
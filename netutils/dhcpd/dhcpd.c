@@ -46,11 +46,14 @@
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 
+#include <fcntl.h>
+#include <stdio.h>
 #include <inttypes.h>
 #include <sched.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <time.h>
 #include <errno.h>
@@ -188,6 +191,23 @@
 #  define HAVE_LEASE_TIME 1
 #endif
 
+#undef HAVE_LEASE_JOURNAL
+#if defined(CONFIG_NETUTILS_DHCPD_PERSIST) && defined(HAVE_LEASE_TIME)
+#  define HAVE_LEASE_JOURNAL 1
+#  define DHCPD_JOURNAL_MAGIC   0x44484a31  /* "DHJ1" */
+#  define DHCPD_JOURNAL_TMPFILE CONFIG_NETUTILS_DHCPD_LEASEFILE ".tmp"
+#endif
+
+#if CONFIG_NETUTILS_DHCPD_MAXLEASES >= 0xffff
+#  error "CONFIG_NETUTILS_DHCPD_MAXLEASES too large"
+#endif
+
+/* Lease table indexes */
+
+#define DHCPD_NOLEASE      0xffff   /* End of hash chain / not in heap */
+#define DHCPD_FREEMAP_WORDS \
+  ((CONFIG_NETUTILS_DHCPD_MAXLEASES + 31) / 32)
+
 #define g_state  (*g_dhcpd_daemon.ds_data)
 
 /****************************************************************************
@@ -205,9 +225,26 @@ struct lease_s
   bool     allocated;               /* true: IP address is allocated */
 #ifdef HAVE_LEASE_TIME
   time_t   expiry;                  /* Lease expiration time (seconds past Epoch) */
+  uint16_t heapndx;                 /* Position in the expiry heap */
 #endif
+  uint16_t next;                    /* Next lease in the MAC hash chain */
 };
 
+#ifdef HAVE_LEASE_JOURNAL
+/* One record of the lease journal.  The file starts with
+ * DHCPD_JOURNAL_MAGIC and is only read back by the same device, so the
+ * fields are in host byte order.
+ */
+
+struct dhcpd_journal_s
+{
+  uint8_t  mac[DHCP_HLEN_ETHERNET]; /* Client MAC address */
+  uint8_t  reserved[2];
+  uint32_t ipaddr;                  /* Leased address (host order) */
+  uint32_t expiry;                  /* Seconds past Epoch, 0: released */
+};
+#endif
+
 struct dhcpmsg_s
 {
   uint8_t  op;
@@ -265,6 +302,24 @@ struct dhcpd_state_s
   /* Leases */
 
   struct lease_s   ds_leases[CONFIG_NETUTILS_DHCPD_MAXLEASES];
+
+  /* Lease indexes: MAC hash chain heads, a bitmap of the free addresses
+   * (bit set: free) and a min-heap of the allocated leases by expiry.
+   * Leases that expired stay in the MAC hash, so a returning client gets
+   * its old address back unless it was given to someone else meanwhile.
+   */
+
+  uint16_t         ds_machash[CONFIG_NETUTILS_DHCPD_MAXLEASES];
+  uint32_t         ds_freemap[DHCPD_FREEMAP_WORDS];
+#ifdef HAVE_LEASE_TIME
+  uint16_t         ds_heap[CONFIG_NETUTILS_DHCPD_MAXLEASES];
+  uint16_t         ds_nheap;
+#endif
+
+#ifdef HAVE_LEASE_JOURNAL
+  int              ds_journalfd;    /* Lease journal opened for append */
+  int              ds_nrecords;     /* Appended since compaction */
+#endif
 };
 
 /* This type describes the state of the DHCPD client daemon.  Only one
@@ -387,6 +442,299 @@ static time_t dhcpd_time(void)
 #  define dhcpd_time() (0)
 #endif
 
+/****************************************************************************
+ * Name: dhcpd_usable
+ *
+ * Description:
+ *   Check if the address at this lease table index may be handed out
+ *   (addresses ending in 0 or 255 are skipped)
+ *
+ ****************************************************************************/
+
+static inline bool dhcpd_usable(int ndx)
+{
+  in_addr_t ipaddr = g_dhcpd_config.ds_startip + ndx;
+
+  return (ipaddr & 0xff) != 0 && (ipaddr & 0xff) != 0xff;
+}
+
+/****************************************************************************
+ * Name: dhcpd_setfree
+ ****************************************************************************/
+
+static inline void dhcpd_setfree(int ndx, bool isfree)
+{
+  if (isfree)
+    {
+      g_state.ds_freemap[ndx / 32] |= UINT32_C(1) << (ndx % 32);
+    }
+  else
+    {
+      g_state.ds_freemap[ndx / 32] &= ~(UINT32_C(1) << (ndx % 32));
+    }
+}
+
+/****************************************************************************
+ * Name: dhcpd_firstfree
+ *
+ * Description:
+ *   Return the index of the lowest free address, or -1 if there is none
+ *
+ ****************************************************************************/
+
+static int dhcpd_firstfree(void)
+{
+  int i;
+
+  for (i = 0; i < DHCPD_FREEMAP_WORDS; i++)
+    {
+      if (g_state.ds_freemap[i] != 0)
+        {
+          return i * 32 + ffs(g_state.ds_freemap[i]) - 1;
+        }
+    }
+
+  return -1;
+}
+
+/****************************************************************************
+ * Name: dhcpd_machash
+ ****************************************************************************/
+
+static inline unsigned int dhcpd_machash(FAR const uint8_t *mac)
+{
+  uint32_t hash = 2166136261u;
+  int i;
+
+  /* FNV-1a */
+
+  for (i = 0; i < DHCP_HLEN_ETHERNET; i++)
+    {
+      hash ^= mac[i];
+      hash *= 16777619u;
+    }
+
+  return hash % CONFIG_NETUTILS_DHCPD_MAXLEASES;
+}
+
+/****************************************************************************
+ * Name: dhcpd_hashadd
+ ****************************************************************************/
+
+static void dhcpd_hashadd(FAR struct lease_s *lease)
+{
+  unsigned int hash = dhcpd_machash(lease->mac);
+
+  lease->next = g_state.ds_machash[hash];
+  g_state.ds_machash[hash] = lease - g_state.ds_leases;
+}
+
+/****************************************************************************
+ * Name: dhcpd_hashdel
+ ****************************************************************************/
+
+static void dhcpd_hashdel(FAR struct lease_s *lease)
+{
+  FAR uint16_t *link = &g_state.ds_machash[dhcpd_machash(lease->mac)];
+  uint16_t ndx = lease - g_state.ds_leases;
+
+  while (*link != DHCPD_NOLEASE)
+    {
+      if (*link == ndx)
+        {
+          *link = lease->next;
+          break;
+        }
+
+      link = &g_state.ds_leases[*link].next;
+    }
+
+  lease->next = DHCPD_NOLEASE;
+}
+
+#ifdef HAVE_LEASE_TIME
+/****************************************************************************
+ * Name: dhcpd_heapswap
+ ****************************************************************************/
+
+static void dhcpd_heapswap(int a, int b)
+{
+  FAR uint16_t *heap = g_state.ds_heap;
+  uint16_t tmp = heap[a];
+
+  heap[a] = heap[b];
+  heap[b] = tmp;
+  g_state.ds_leases[heap[a]].heapndx = a;
+  g_state.ds_leases[heap[b]].heapndx = b;
+}
+
+/****************************************************************************
+ * Name: dhcpd_heapfix
+ *
+ * Description:
+ *   Move the heap entry at pos up or down to its place
+ *
+ ****************************************************************************/
+
+static void dhcpd_heapfix(int pos)
+{
+  FAR const uint16_t *heap = g_state.ds_heap;
+  FAR const struct lease_s *leases = g_state.ds_leases;
+  int child;
+
+  while (pos > 0 &&
+         leases[heap[pos]].expiry < leases[heap[(pos - 1) / 2]].expiry)
+    {
+      dhcpd_heapswap(pos, (pos - 1) / 2);
+      pos = (pos - 1) / 2;
+    }
+
+  for (; ; )
+    {
+      child = 2 * pos + 1;
+      if (child >= g_state.ds_nheap)
+        {
+          break;
+        }
+
+      if (child + 1 < g_state.ds_nheap &&
+          leases[heap[child + 1]].expiry < leases[heap[child]].expiry)
+        {
+          child++;
+        }
+
+      if (leases[heap[pos]].expiry <= leases[heap[child]].expiry)
+        {
+          break;
+        }
+
+      dhcpd_heapswap(pos, child);
+      pos = child;
+    }
+}
+
+/****************************************************************************
+ * Name: dhcpd_heapset
+ *
+ * Description:
+ *   Add a lease to the expiry heap, or reorder it after its expiry changed
+ *
+ ****************************************************************************/
+
+static void dhcpd_heapset(FAR struct lease_s *lease)
+{
+  if (lease->heapndx == DHCPD_NOLEASE)
+    {
+      lease->heapndx = g_state.ds_nheap;
+      g_state.ds_heap[g_state.ds_nheap++] = lease - g_state.ds_leases;
+    }
+
+  dhcpd_heapfix(lease->heapndx);
+}
+
+/****************************************************************************
+ * Name: dhcpd_heapdel
+ ****************************************************************************/
+
+static void dhcpd_heapdel(FAR struct lease_s *lease)
+{
+  int pos = lease->heapndx;
+
+  if (pos == DHCPD_NOLEASE)
+    {
+      return;
+    }
+
+  if (pos != --g_state.ds_nheap)
+    {
+      dhcpd_heapswap(pos, g_state.ds_nheap);
+      dhcpd_heapfix(pos);
+    }
+
+  lease->heapndx = DHCPD_NOLEASE;
+}
+
+/****************************************************************************
+ * Name: dhcpd_expireleases
+ *
+ * Description:
+ *   Return the addresses of all the expired leases to the free bitmap
+ *
+ ****************************************************************************/
+
+static void dhcpd_expireleases(void)
+{
+  FAR struct lease_s *lease;
+  time_t now = dhcpd_time();
+  int ndx;
+
+  while (g_state.ds_nheap > 0)
+    {
+      ndx   = g_state.ds_heap[0];
+      lease = &g_state.ds_leases[ndx];
+      if (lease->expiry > now)
+        {
+          break;
+        }
+
+      dhcpd_heapdel(lease);
+      if (dhcpd_usable(ndx))
+        {
+          dhcpd_setfree(ndx, true);
+        }
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: dhcpd_freelease
+ ****************************************************************************/
+
+static void dhcpd_freelease(FAR struct lease_s *lease)
+{
+  int ndx = lease - g_state.ds_leases;
+
+  dhcpd_hashdel(lease);
+#ifdef HAVE_LEASE_TIME
+  dhcpd_heapdel(lease);
+#endif
+
+  memset(lease, 0, sizeof(struct lease_s));
+  lease->next = DHCPD_NOLEASE;
+#ifdef HAVE_LEASE_TIME
+  lease->heapndx = DHCPD_NOLEASE;
+#endif
+
+  if (dhcpd_usable(ndx))
+    {
+      dhcpd_setfree(ndx, true);
+    }
+}
+
+/****************************************************************************
+ * Name: dhcpd_initleases
+ ****************************************************************************/
+
+static void dhcpd_initleases(void)
+{
+  int ndx;
+
+  /* The state is zeroed, only the links and the bitmap need setting */
+
+  for (ndx = 0; ndx < CONFIG_NETUTILS_DHCPD_MAXLEASES; ndx++)
+    {
+      g_state.ds_machash[ndx] = DHCPD_NOLEASE;
+      g_state.ds_leases[ndx].next = DHCPD_NOLEASE;
+#ifdef HAVE_LEASE_TIME
+      g_state.ds_leases[ndx].heapndx = DHCPD_NOLEASE;
+#endif
+      if (dhcpd_usable(ndx))
+        {
+          dhcpd_setfree(ndx, true);
+        }
+    }
+}
+
 /****************************************************************************
  * Name: dhcpd_leaseexpired
  ****************************************************************************/
@@ -400,7 +748,7 @@ static inline bool dhcpd_leaseexpired(struct lease_s *lease)
     }
   else
     {
-      memset(lease, 0, sizeof(struct lease_s));
+      dhcpd_freelease(lease);
       return true;
     }
 }
@@ -408,6 +756,30 @@ static inline bool dhcpd_leaseexpired(struct lease_s *lease)
 #  define dhcpd_leaseexpired(lease) (false)
 #endif
 
+/****************************************************************************
+ * Name: dhcpd_findbymac
+ ****************************************************************************/
+
+static FAR struct lease_s *dhcpd_findbymac(FAR const uint8_t *mac)
+{
+  FAR struct lease_s *lease;
+  uint16_t ndx;
+
+  ndx = g_state.ds_machash[dhcpd_machash(mac)];
+  while (ndx != DHCPD_NOLEASE)
+    {
+      lease = &g_state.ds_leases[ndx];
+      if (memcmp(lease->mac, mac, DHCP_HLEN_ETHERNET) == 0)
+        {
+          return lease;
+        }
+
+      ndx = lease->next;
+    }
+
+  return NULL;
+}
+
 /****************************************************************************
  * Name: dhcpd_setlease
  ****************************************************************************/
@@ -421,6 +793,7 @@ struct lease_s *dhcpd_setlease(const uint8_t *mac,
 
   int ndx = ipaddr - g_dhcpd_config.ds_startip;
   struct lease_s *ret = NULL;
+  struct lease_s *old;
 
   ninfo("ipaddr: %08" PRIx32 " ipaddr: %08" PRIx32 " ndx: %d MAX: %d\n",
         (uint32_t)ipaddr, (uint32_t)g_dhcpd_config.ds_startip, ndx,
@@ -431,10 +804,27 @@ struct lease_s *dhcpd_setlease(const uint8_t *mac,
   if (ndx >= 0 && ndx < CONFIG_NETUTILS_DHCPD_MAXLEASES)
     {
        ret = &g_state.ds_leases[ndx];
-       memcpy(ret->mac, mac, DHCP_HLEN_ETHERNET);
+
+       /* A client holds a single lease, drop any other one */
+
+       old = dhcpd_findbymac(mac);
+       if (old != NULL && old != ret)
+         {
+           dhcpd_freelease(old);
+         }
+
+       if (old != ret)
+         {
+           dhcpd_hashdel(ret);
+           memcpy(ret->mac, mac, DHCP_HLEN_ETHERNET);
+           dhcpd_hashadd(ret);
+         }
+
        ret->allocated = true;
+       dhcpd_setfree(ndx, false);
 #ifdef HAVE_LEASE_TIME
        ret->expiry = dhcpd_time() + expiry;
+       dhcpd_heapset(ret);
 #endif
     }
 
@@ -453,25 +843,6 @@ static inline in_addr_t dhcp_leaseipaddr(FAR struct lease_s *lease)
          g_dhcpd_config.ds_startip;
 }
 
-/****************************************************************************
- * Name: dhcpd_findbymac
- ****************************************************************************/
-
-static FAR struct lease_s *dhcpd_findbymac(FAR const uint8_t *mac)
-{
-  int i;
-
-  for (i = 0; i < CONFIG_NETUTILS_DHCPD_MAXLEASES; i++)
-    {
-      if (memcmp(g_state.ds_leases[i].mac, mac, DHCP_HLEN_ETHERNET) == 0)
-        {
-          return &(g_state.ds_leases[i]);
-        }
-    }
-
-  return NULL;
-}
-
 /****************************************************************************
  * Name: dhcpd_findbyipaddr
  ****************************************************************************/
@@ -498,43 +869,222 @@ static FAR struct lease_s *dhcpd_findbyipaddr(in_addr_t ipaddr)
 
 static in_addr_t dhcpd_allocipaddr(void)
 {
-  struct lease_s *lease = NULL;
-  in_addr_t ipaddr, startaddr;
+  struct lease_s *lease;
+  int ndx;
 
-  ipaddr = startaddr = g_dhcpd_config.ds_startip;
-  for (; ipaddr <= g_dhcpd_config.ds_endip; ipaddr++)
-    {
-      /* Skip over address ending in 0 or 255 */
+#ifdef HAVE_LEASE_TIME
+  dhcpd_expireleases();
+#endif
 
-      if ((ipaddr & 0xff) == 0 || (ipaddr & 0xff) == 0xff)
-        {
-          continue;
-        }
+  /* Take the lowest address that is not leased or whose lease expired */
 
-      /* Is there already a lease on this address?  If so, has it expired? */
+  ndx = dhcpd_firstfree();
+  if (ndx < 0)
+    {
+      return 0;
+    }
 
-      lease = dhcpd_findbyipaddr(ipaddr);
-      if ((!lease || dhcpd_leaseexpired(lease)))
-        {
 #ifdef CONFIG_CPP_HAVE_WARNING
 #  warning "FIXME: Should check if anything responds to an ARP request or ping"
 #  warning "       to verify that there is no other user of this IP address"
 #endif
-          memset(g_state.ds_leases[ipaddr - startaddr].mac,
-          0, DHCP_HLEN_ETHERNET);
-          g_state.ds_leases[ipaddr - startaddr].allocated = true;
+
+  /* Forget the client of the expired lease */
+
+  lease = &g_state.ds_leases[ndx];
+  dhcpd_freelease(lease);
+
+  lease->allocated = true;
+  dhcpd_setfree(ndx, false);
 #ifdef HAVE_LEASE_TIME
-          g_state.ds_leases[ipaddr - startaddr].expiry =
-            dhcpd_time() + CONFIG_NETUTILS_DHCPD_OFFERTIME;
+  lease->expiry = dhcpd_time() + CONFIG_NETUTILS_DHCPD_OFFERTIME;
+  dhcpd_heapset(lease);
 #endif
-          /* Return the address in host order */
 
-          return ipaddr;
+  /* Return the address in host order */
+
+  return g_dhcpd_config.ds_startip + ndx;
+}
+
+#ifdef HAVE_LEASE_JOURNAL
+/****************************************************************************
+ * Name: dhcpd_journal_compact
+ *
+ * Description:
+ *   Rewrite the lease journal with one record per active lease and reopen
+ *   it for appending.  The new file replaces the old one by rename(), so a
+ *   reset during the compaction leaves either of them complete.
+ *
+ ****************************************************************************/
+
+static void dhcpd_journal_compact(void)
+{
+  struct dhcpd_journal_s rec;
+  FAR struct lease_s *lease;
+  uint32_t magic = DHCPD_JOURNAL_MAGIC;
+  time_t now = dhcpd_time();
+  int fd;
+  int ndx;
+
+  if (g_state.ds_journalfd >= 0)
+    {
+      close(g_state.ds_journalfd);
+      g_state.ds_journalfd = -1;
+    }
+
+  fd = open(DHCPD_JOURNAL_TMPFILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      nerr("ERROR: Failed to create %s: %d\n", DHCPD_JOURNAL_TMPFILE,
+           errno);
+      return;
+    }
+
+  if (write(fd, &magic, sizeof(magic)) != sizeof(magic))
+    {
+      goto errout;
+    }
+
+  memset(&rec, 0, sizeof(rec));
+  for (ndx = 0; ndx < CONFIG_NETUTILS_DHCPD_MAXLEASES; ndx++)
+    {
+      lease = &g_state.ds_leases[ndx];
+
+      /* Only leases bound to a client, which are in the MAC hash */
+
+      if (!lease->allocated || lease->expiry <= now ||
+          dhcpd_findbymac(lease->mac) != lease)
+        {
+          continue;
+        }
+
+      memcpy(rec.mac, lease->mac, DHCP_HLEN_ETHERNET);
+      rec.ipaddr = dhcp_leaseipaddr(lease);
+      rec.expiry = lease->expiry;
+      if (write(fd, &rec, sizeof(rec)) != sizeof(rec))
+        {
+          goto errout;
+        }
+    }
+
+  if (fsync(fd) < 0)
+    {
+      goto errout;
+    }
+
+  close(fd);
+  if (rename(DHCPD_JOURNAL_TMPFILE,
+             CONFIG_NETUTILS_DHCPD_LEASEFILE) < 0)
+    {
+      nerr("ERROR: Failed to rename %s: %d\n", DHCPD_JOURNAL_TMPFILE,
+           errno);
+      unlink(DHCPD_JOURNAL_TMPFILE);
+      return;
+    }
+
+  g_state.ds_journalfd = open(CONFIG_NETUTILS_DHCPD_LEASEFILE,
+                              O_WRONLY | O_APPEND);
+  g_state.ds_nrecords  = 0;
+  return;
+
+errout:
+  nerr("ERROR: Failed to write %s: %d\n", DHCPD_JOURNAL_TMPFILE, errno);
+  close(fd);
+  unlink(DHCPD_JOURNAL_TMPFILE);
+}
+
+/****************************************************************************
+ * Name: dhcpd_journal
+ *
+ * Description:
+ *   Append a binding (or its release, with expiry 0) to the lease journal
+ *
+ ****************************************************************************/
+
+static void dhcpd_journal(FAR const uint8_t *mac, in_addr_t ipaddr,
+                          time_t expiry)
+{
+  struct dhcpd_journal_s rec;
+
+  if (g_state.ds_journalfd < 0)
+    {
+      return;
+    }
+
+  memset(&rec, 0, sizeof(rec));
+  memcpy(rec.mac, mac, DHCP_HLEN_ETHERNET);
+  rec.ipaddr = ipaddr;
+  rec.expiry = expiry;
+
+  if (write(g_state.ds_journalfd, &rec, sizeof(rec)) != sizeof(rec))
+    {
+      nerr("ERROR: Failed to append to %s: %d\n",
+           CONFIG_NETUTILS_DHCPD_LEASEFILE, errno);
+    }
+
+  if (++g_state.ds_nrecords >= CONFIG_NETUTILS_DHCPD_JOURNAL_MAX)
+    {
+      dhcpd_journal_compact();
+    }
+}
+
+/****************************************************************************
+ * Name: dhcpd_journal_load
+ *
+ * Description:
+ *   Restore the leases from the journal, then compact it
+ *
+ ****************************************************************************/
+
+static void dhcpd_journal_load(void)
+{
+  struct dhcpd_journal_s rec;
+  FAR struct lease_s *lease;
+  uint32_t magic;
+  time_t now = dhcpd_time();
+  int fd;
+
+  g_state.ds_journalfd = -1;
+
+  fd = open(CONFIG_NETUTILS_DHCPD_LEASEFILE, O_RDONLY);
+  if (fd >= 0)
+    {
+      if (read(fd, &magic, sizeof(magic)) == sizeof(magic) &&
+          magic == DHCPD_JOURNAL_MAGIC)
+        {
+          /* Replay the records, a truncated last one is ignored */
+
+          while (read(fd, &rec, sizeof(rec)) == sizeof(rec))
+            {
+              if (rec.expiry == 0)
+                {
+                  lease = dhcpd_findbymac(rec.mac);
+                  if (lease != NULL &&
+                      dhcp_leaseipaddr(lease) == rec.ipaddr)
+                    {
+                      dhcpd_freelease(lease);
+                    }
+                }
+              else if (rec.expiry > now)
+                {
+                  dhcpd_setlease(rec.mac, rec.ipaddr, rec.expiry - now);
+                }
+            }
         }
+      else
+        {
+          ninfo("Ignoring %s, bad format\n",
+                  CONFIG_NETUTILS_DHCPD_LEASEFILE);
+        }
+
+      close(fd);
     }
 
-  return 0;
+  dhcpd_journal_compact();
 }
+#else
+#  define dhcpd_journal(mac, ipaddr, expiry)
+#endif
 
 /****************************************************************************
  * Name: dhcpd_parseoptions
@@ -1150,7 +1700,12 @@ int dhcpd_sendack(int sockfd, in_addr_t ipaddr)
       return ERROR;
     }
 
-  dhcpd_setlease(g_state.ds_inpacket.chaddr, ipaddr, leasetime);
+  if (dhcpd_setlease(g_state.ds_inpacket.chaddr, ipaddr, leasetime))
+    {
+      dhcpd_journal(g_state.ds_inpacket.chaddr, ipaddr,
+                    dhcpd_time() + leasetime);
+    }
+
   return OK;
 }
 
@@ -1409,10 +1964,14 @@ static inline int dhcpd_decline(void)
        * address for a period of time.
        */
 
+      dhcpd_hashdel(lease);
       memset(lease->mac, 0, DHCP_HLEN_ETHERNET);
 #ifdef HAVE_LEASE_TIME
       lease->expiry = dhcpd_time() + CONFIG_NETUTILS_DHCPD_DECLINETIME;
+      dhcpd_heapset(lease);
 #endif
+      dhcpd_journal(g_state.ds_inpacket.chaddr, dhcp_leaseipaddr(lease),
+                    0);
     }
 
   return OK;
@@ -1429,7 +1988,9 @@ static inline int dhcpd_release(void)
     {
       /* Release the IP address now */
 
-      memset(lease, 0, sizeof(struct lease_s));
+      dhcpd_journal(g_state.ds_inpacket.chaddr, dhcp_leaseipaddr(lease),
+                    0);
+      dhcpd_freelease(lease);
     }
 
   return OK;
@@ -1531,6 +2092,10 @@ int dhcpd_run(FAR const char *interface)
     }
 
   memset(g_dhcpd_daemon.ds_data, 0, sizeof(struct dhcpd_state_s));
+  dhcpd_initleases();
+#ifdef HAVE_LEASE_JOURNAL
+  dhcpd_journal_load();
+#endif
 
   /* Update the pid if running in daemon mode */
 
@@ -1625,6 +2190,13 @@ int dhcpd_run(FAR const char *interface)
         }
     }
 
+#ifdef HAVE_LEASE_JOURNAL
+  if (g_state.ds_journalfd >= 0)
+    {
+      close(g_state.ds_journalfd);
+    }
+#endif
+
   free(g_dhcpd_daemon.ds_data);
   g_dhcpd_daemon.ds_data = NULL;
   g_dhcpd_daemon.ds_pid   = -1;
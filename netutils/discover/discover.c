@@ -24,11 +24,14 @@
 
 #include <debug.h>
 #include <errno.h>
+#include <poll.h>
 #include <sched.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <sys/ioctl.h>
@@ -70,6 +73,14 @@
 #  define CONFIG_DISCOVER_DESCR CONFIG_ARCH_BOARD
 #endif
 
+#ifndef CONFIG_DISCOVER_JITTER_MS
+#  define CONFIG_DISCOVER_JITTER_MS 0
+#endif
+
+#ifndef CONFIG_DISCOVER_PENDING
+#  define CONFIG_DISCOVER_PENDING 1
+#endif
+
 /* Internal Definitions *****************************************************/
 
 /* Discover request packet format:
@@ -103,12 +114,23 @@
 typedef uint8_t request_t[DISCOVER_REQUEST_SIZE];
 typedef uint8_t response_t[DISCOVER_RESPONSE_SIZE];
 
+/* A reply waiting for its randomized delay */
+
+struct discover_pending_s
+{
+  in_addr_t ipaddr;
+  uint32_t due;
+};
+
 struct discover_state_s
 {
   struct discover_info_s info;
   in_addr_t serverip;
   request_t request;
   response_t response;
+  int respfd;
+  int npending;
+  struct discover_pending_s pending[CONFIG_DISCOVER_PENDING];
 };
 
 /****************************************************************************
@@ -131,6 +153,11 @@ static inline int discover_openresponder(void);
 static inline int discover_parse(request_t packet);
 static inline int discover_respond(in_addr_t *ipaddr);
 static inline void discover_initresponse(void);
+static inline int discover_getaddr(int sockfd);
+static inline uint32_t discover_now(void);
+static inline void discover_schedule(in_addr_t ipaddr);
+static inline int discover_timeout(void);
+static inline void discover_flush(void);
 
 /****************************************************************************
  * Private Functions
@@ -157,16 +184,109 @@ static inline void discover_initresponse(void)
   g_state.response[DISCOVER_RESPONSE_SIZE - 1] = chk & 0xff;
 }
 
+static inline uint32_t discover_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Queue a reply to ipaddr after a random delay, so that the devices of a
+ * subnet don't all answer a broadcast at the same time.  Repeated
+ * requests from a host already waiting for the reply are ignored.
+ */
+
+static inline void discover_schedule(in_addr_t ipaddr)
+{
+  uint32_t due = discover_now();
+  int i;
+
+  for (i = 0; i < g_state.npending; i++)
+    {
+      if (g_state.pending[i].ipaddr == ipaddr)
+        {
+          return;
+        }
+    }
+
+  if (g_state.npending >= CONFIG_DISCOVER_PENDING)
+    {
+      nwarn("WARNING: Too many requests, dropped %08" PRIx32 "\n", ipaddr);
+      return;
+    }
+
+#if CONFIG_DISCOVER_JITTER_MS > 0
+  due += random() % (CONFIG_DISCOVER_JITTER_MS + 1);
+#endif
+
+  g_state.pending[g_state.npending].ipaddr = ipaddr;
+  g_state.pending[g_state.npending].due    = due;
+  g_state.npending++;
+}
+
+/* Milliseconds until the next reply is due, 0 if one is due, -1 if there
+ * is none.
+ */
+
+static inline int discover_timeout(void)
+{
+  uint32_t now = discover_now();
+  int32_t delay;
+  int timeout = -1;
+  int i;
+
+  for (i = 0; i < g_state.npending; i++)
+    {
+      delay = (int32_t)(g_state.pending[i].due - now);
+      if (delay < 0)
+        {
+          delay = 0;
+        }
+
+      if (timeout < 0 || delay < timeout)
+        {
+          timeout = delay;
+        }
+    }
+
+  return timeout;
+}
+
+/* Send the replies that are due */
+
+static inline void discover_flush(void)
+{
+  uint32_t now = discover_now();
+  int i = 0;
+
+  while (i < g_state.npending)
+    {
+      if ((int32_t)(g_state.pending[i].due - now) <= 0)
+        {
+          discover_respond(&g_state.pending[i].ipaddr);
+          g_state.pending[i] = g_state.pending[--g_state.npending];
+        }
+      else
+        {
+          i++;
+        }
+    }
+}
+
 static int discover_daemon(int argc, char *argv[])
 {
   int sockfd = -1;
   int nbytes;
   socklen_t addrlen = sizeof(struct sockaddr_in);
   struct sockaddr_in srcaddr;
+  struct pollfd pfd;
+  in_addr_t serverip;
 
-  /* memset(&g_state, 0, sizeof(struct discover_state_s)); */
+  /* The response doesn't depend on the address, it is built once */
 
   discover_initresponse();
+  g_state.respfd = -1;
 
   ninfo("Started\n");
 
@@ -182,35 +302,70 @@ static int discover_daemon(int argc, char *argv[])
                 nerr("ERROR: Failed to create socket\n");
                 break;
             }
+
+          /* Devices pick different delays */
+
+          srandom(g_state.serverip ^ discover_now());
         }
 
-      /* Read the next packet */
+      /* Wait for the next packet or for the next reply to send */
 
-      nbytes = recvfrom(sockfd, &g_state.request, sizeof(g_state.request), 0,
-                        (struct sockaddr *)&srcaddr, &addrlen);
-      if (nbytes < 0)
+      pfd.fd     = sockfd;
+      pfd.events = POLLIN;
+      if (poll(&pfd, 1, discover_timeout()) > 0)
         {
-          /* On errors (other EINTR), close the socket and try again */
+          /* Read the next packet */
 
-          nerr("ERROR: recv failed: %d\n", errno);
-          if (errno != EINTR)
+          nbytes = recvfrom(sockfd, &g_state.request,
+                            sizeof(g_state.request), 0,
+                            (struct sockaddr *)&srcaddr, &addrlen);
+          if (nbytes < 0)
             {
-              close(sockfd);
-              sockfd = -1;
+              /* On errors (other EINTR), close the socket and try again */
+
+              nerr("ERROR: recv failed: %d\n", errno);
+              if (errno != EINTR)
+                {
+                  close(sockfd);
+                  sockfd = -1;
+                }
+
+              continue;
             }
 
-          continue;
+          if (discover_parse(g_state.request) == OK)
+            {
+              ninfo("Received discover from %08" PRIx32 "\n",
+                    srcaddr.sin_addr.s_addr);
+
+              discover_schedule(srcaddr.sin_addr.s_addr);
+            }
         }
 
-      if (discover_parse(g_state.request) != OK)
+      if (discover_timeout() != 0)
         {
           continue;
         }
 
-      ninfo("Received discover from %08" PRIx32 "\n",
-            srcaddr.sin_addr.s_addr);
+      /* The sockets are kept open, and opened again only if the address
+       * of the interface changed.
+       */
 
-      discover_respond(&srcaddr.sin_addr.s_addr);
+      serverip = g_state.serverip;
+      if (discover_getaddr(sockfd) == OK && g_state.serverip != serverip)
+        {
+          ninfo("Address changed\n");
+          close(sockfd);
+          sockfd = -1;
+
+          if (g_state.respfd >= 0)
+            {
+              close(g_state.respfd);
+              g_state.respfd = -1;
+            }
+        }
+
+      discover_flush();
     }
 
   return OK;
@@ -255,14 +410,16 @@ static inline int discover_parse(request_t packet)
 static inline int discover_respond(in_addr_t *ipaddr)
 {
   struct sockaddr_in addr;
-  int sockfd;
   int ret;
 
-  sockfd = discover_openresponder();
-  if (sockfd < 0)
+  if (g_state.respfd < 0)
     {
-      nerr("ERROR: discover_openresponder failed\n");
-      return ERROR;
+      g_state.respfd = discover_openresponder();
+      if (g_state.respfd < 0)
+        {
+          nerr("ERROR: discover_openresponder failed\n");
+          return ERROR;
+        }
     }
 
   /* Then send the response to the DHCP client port at that address */
@@ -272,14 +429,18 @@ static inline int discover_respond(in_addr_t *ipaddr)
   addr.sin_port        = HTONS(CONFIG_DISCOVER_PORT);
   addr.sin_addr.s_addr = *ipaddr;
 
-  ret = sendto(sockfd, &g_state.response, sizeof(g_state.response), 0,
+  ret = sendto(g_state.respfd, &g_state.response,
+               sizeof(g_state.response), 0,
                (struct sockaddr *)&addr, sizeof(struct sockaddr_in));
   if (ret < 0)
     {
+      /* Open the socket again for the next response */
+
       nerr("ERROR: Could not send discovery response: %d\n", errno);
+      close(g_state.respfd);
+      g_state.respfd = -1;
     }
 
-  close(sockfd);
   return ret;
 }
 
@@ -329,10 +490,32 @@ static inline int discover_socket(void)
   return sockfd;
 }
 
+static inline int discover_getaddr(int sockfd)
+{
+  struct ifreq req;
+  int ret;
+
+  /* Get the IP address of the selected device */
+
+  strlcpy(req.ifr_name, CONFIG_DISCOVER_INTERFACE, IFNAMSIZ);
+  ret = ioctl(sockfd, SIOCGIFADDR, (unsigned long)&req);
+  if (ret < 0)
+    {
+      nerr("ERROR: setsockopt SIOCGIFADDR failed: %d\n", errno);
+      return ERROR;
+    }
+
+  g_state.serverip = ((struct sockaddr_in *)&req.ifr_addr)->sin_addr.s_addr;
+  ninfo("serverip: %08" PRIx32 "\n", ntohl(g_state.serverip));
+  return OK;
+}
+
 static inline int discover_openlistener(void)
 {
   struct sockaddr_in addr;
-  struct ifreq req;
+#ifdef CONFIG_DISCOVER_MULTICAST
+  struct ip_mreq mreq;
+#endif
   int sockfd;
   int ret;
 
@@ -347,18 +530,12 @@ static inline int discover_openlistener(void)
 
   /* Get the IP address of the selected device */
 
-  strlcpy(req.ifr_name, CONFIG_DISCOVER_INTERFACE, IFNAMSIZ);
-  ret = ioctl(sockfd, SIOCGIFADDR, (unsigned long)&req);
-  if (ret < 0)
+  if (discover_getaddr(sockfd) < 0)
     {
-      nerr("ERROR: setsockopt SIOCGIFADDR failed: %d\n", errno);
       close(sockfd);
       return ERROR;
     }
 
-  g_state.serverip = ((struct sockaddr_in *)&req.ifr_addr)->sin_addr.s_addr;
-  ninfo("serverip: %08" PRIx32 "\n", ntohl(g_state.serverip));
-
   /* Bind the socket to a local port. We have to bind to INADDRY_ANY to
    * receive broadcast messages.
    */
@@ -376,6 +553,22 @@ static inline int discover_openlistener(void)
       return ERROR;
     }
 
+#ifdef CONFIG_DISCOVER_MULTICAST
+  /* Also receive the requests sent to the discovery group */
+
+  mreq.imr_multiaddr.s_addr = inet_addr(CONFIG_DISCOVER_MULTICAST_GROUP);
+  mreq.imr_interface.s_addr = g_state.serverip;
+
+  ret = setsockopt(sockfd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq,
+                   sizeof(struct ip_mreq));
+  if (ret < 0)
+    {
+      nerr("ERROR: setsockopt IP_ADD_MEMBERSHIP failed: %d\n", errno);
+      close(sockfd);
+      return ERROR;
+    }
+#endif
+
   return sockfd;
 }
 
@@ -88,9 +88,22 @@
 
 /* Must be a power of 2 */
 
-#define SOCKET_FIFO_SIZE              2048
+#define SOCKET_FIFO_SIZE              CONFIG_NETUTILS_ESP8266_SOCKET_FIFO_SIZE
 #define SOCKET_NBR                    4
 
+#if (SOCKET_FIFO_SIZE & (SOCKET_FIFO_SIZE - 1)) != 0
+#  error "CONFIG_NETUTILS_ESP8266_SOCKET_FIFO_SIZE must be a power of 2"
+#endif
+
+/* Answer lines waiting to be read, and largest AT+CIPSEND payload */
+
+#define LESP_LINE_NBR                 CONFIG_NETUTILS_ESP8266_LINE_NBR
+#define LESP_SEND_MAX                 2048
+
+#ifndef MIN
+#  define MIN(a,b)                    (((a) < (b)) ? (a) : (b))
+#endif
+
 #define FLAGS_SOCK_USED               (1 << 0)
 #define FLAGS_SOCK_CONNECTED          (1 << 1)
 
@@ -120,16 +133,26 @@ typedef struct
   uint8_t         rxbuf[SOCKET_FIFO_SIZE];
 } lesp_socket_t;
 
+typedef struct
+{
+  lesp_ans_t      and;                 /* OK, FAIL or ERROR, or LESP_NONE */
+  char            line[BUF_ANS_LEN];   /* Line received */
+} lesp_line_t;
+
 typedef struct
 {
   bool            running;
   pthread_t       thread;
 
-  char            rxbuf[BUF_WORKER_LEN];
+  char            rxbuf[BUF_WORKER_LEN];   /* Line being received */
+  uint8_t         chunk[BUF_WORKER_LEN];   /* Last read on serial port */
+  int             chunklen;
+  int             chunkpos;
 
-  sem_t           sem;              /* Inform that something is received */
-  char            buf[BUF_ANS_LEN]; /* Last complete line received */
-  lesp_ans_t      and;              /* Last and received (OK,FAIL or ERROR) */
+  sem_t           sem;                     /* Posted for each queued line */
+  lesp_line_t     lines[LESP_LINE_NBR];    /* Answers not read yet */
+  uint8_t         lineout;
+  uint8_t         nlines;
   pthread_mutex_t mutex;
 } lesp_worker_t;
 
@@ -137,6 +160,7 @@ typedef struct
 {
   pthread_mutex_t mutex;
   bool            is_initialized;
+  bool            synced;       /* All answers of last command were read */
   int             fd;
   lesp_worker_t   worker;
   lesp_socket_t   sockets[SOCKET_NBR];
@@ -168,9 +192,9 @@ lesp_state_t g_lesp_state =
 {
   .mutex          = PTHREAD_MUTEX_INITIALIZER,
   .is_initialized = false,
+  .synced         = false,
   .fd             = -1,
   .worker.running = false,
-  .worker.and     = LESP_NONE,
   .worker.mutex   = PTHREAD_MUTEX_INITIALIZER,
   .and            = LESP_NONE,
 };
@@ -440,12 +464,72 @@ static int lesp_low_level_read(uint8_t *buf, int size)
   return ret;
 }
 
+/****************************************************************************
+ * Name: lesp_sock_put
+ *
+ * Description:
+ *   Copy received data to the circular buffer of a socket.
+ *
+ * Note:
+ *  g_lesp_state.worker.mutex should be locked.
+ *
+ * Input Parameters:
+ *   sock : socket to put received data.
+ *   buf  : received data.
+ *   size : size of data.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+static void lesp_sock_put(lesp_socket_t *sock, const uint8_t *buf, int size)
+{
+  int space;
+  int n;
+
+  while (size > 0 && (sock->flags & FLAGS_SOCK_USED) != 0)
+    {
+      /* One byte is always left free so that a full buffer is not seen as
+       * an empty one.
+       */
+
+      space = (sock->outndx - sock->inndx - 1) & (SOCKET_FIFO_SIZE - 1);
+      if (space == 0)
+        {
+          if (sock->sem)
+            {
+              sem_post(sock->sem);
+            }
+
+          pthread_mutex_unlock(&g_lesp_state.worker.mutex);
+          usleep(100); /* leave time of aplicative to read buffer */
+          pthread_mutex_lock(&g_lesp_state.worker.mutex);
+
+          space = (sock->outndx - sock->inndx - 1) & (SOCKET_FIFO_SIZE - 1);
+          if (space == 0)
+            {
+              nwarn("overflow socket, %d bytes lost\n", size);
+              return;
+            }
+        }
+
+      n = MIN(MIN(size, space), SOCKET_FIFO_SIZE - sock->inndx);
+      memcpy(&sock->rxbuf[sock->inndx], buf, n);
+      sock->inndx = (sock->inndx + n) & (SOCKET_FIFO_SIZE - 1);
+      buf  += n;
+      size -= n;
+    }
+}
+
 /****************************************************************************
  * Name: lesp_read_ipd
  *
  * Description:
  *   Try to treat an '+IPD' command in worker buffer.  Worker buffer should
- *   already contain '+IPD,<id>,<len>:'
+ *   already contain '+IPD,<id>,<len>:'.  The data already read with the
+ *   header are taken from the worker chunk, the rest is read on the serial
+ *   port by blocks.
  *
  * Note:
  *  g_lesp_state.worker.mutex should be locked.
@@ -461,7 +545,9 @@ static int lesp_low_level_read(uint8_t *buf, int size)
 
 static inline int lesp_read_ipd(int sockfd, int len)
 {
+  lesp_worker_t *worker = &g_lesp_state.worker;
   lesp_socket_t *sock;
+  int size;
 
   sock = get_sock(sockfd);
 
@@ -472,18 +558,23 @@ static inline int lesp_read_ipd(int sockfd, int len)
       nwarn("socket not opened: drop all data.\n");
     }
 
-  while (len)
+  size = MIN(len, worker->chunklen - worker->chunkpos);
+  if (sock != NULL)
     {
-      int size;
-      uint8_t *buf = (uint8_t *)g_lesp_state.worker.rxbuf;
+      lesp_sock_put(sock, &worker->chunk[worker->chunkpos], size);
+    }
 
-      size = len;
-      if (size >= BUF_WORKER_LEN)
-        {
-          size = BUF_WORKER_LEN;
-        }
+  worker->chunkpos += size;
+  len -= size;
 
-      size = lesp_low_level_read(buf, size);
+  /* The chunk is empty, use it to read the rest */
+
+  while (len > 0)
+    {
+      worker->chunklen = 0;
+      worker->chunkpos = 0;
+
+      size = lesp_low_level_read(worker->chunk, MIN(len, BUF_WORKER_LEN));
       if (size <= 0)
         {
           return -1;
@@ -493,60 +584,16 @@ static inline int lesp_read_ipd(int sockfd, int len)
 
       if (sock != NULL)
         {
-          while (size--)
-            {
-              int next;
-              uint8_t b;
-
-              /* Read the next byte from the buffer */
-
-              b = *buf++;
-
-              /* Pre-calculate the next 'inndx'.  We do this so that we can
-               * check if the FIFO is full.
-               */
-
-              next = sock->inndx + 1;
-              if (next >= SOCKET_FIFO_SIZE)
-                {
-                  next -= SOCKET_FIFO_SIZE;
-                }
-
-              /* Is there space in the circular buffer for another byte?  If
-               * the next 'inndx' would be equal to the 'outndx', then the
-               * circular buffer is full.
-               */
-
-              if (next == sock->outndx)
-                {
-                  pthread_mutex_unlock(&g_lesp_state.worker.mutex);
-                  usleep(100); /* leave time of aplicative to read buffer */
-                  pthread_mutex_lock(&g_lesp_state.worker.mutex);
-                }
-
-              if (next != sock->outndx)
-                {
-                  /* Yes.. add the byte to the circular buffer */
-
-                  sock->rxbuf[sock->inndx] = b;
-                  sock->inndx = next;
-                }
-              else
-                {
-                  /* No.. the we have lost data */
-
-                  nwarn("overflow socket 0x%02X\n", b);
-                }
-            }
-
-          if (sock->sem)
-            {
-              ninfo("post %p\n", sock->sem);
-              sem_post(sock->sem);
-            }
+          lesp_sock_put(sock, worker->chunk, size);
         }
     }
 
+  if (sock != NULL && sock->sem)
+    {
+      ninfo("post %p\n", sock->sem);
+      sem_post(sock->sem);
+    }
+
   return 1;
 }
 
@@ -666,26 +713,38 @@ static int lesp_read(int timeout_ms)
     {
       if (sem_timedwait(&g_lesp_state.worker.sem, &ts) < 0)
         {
+          /* An answer may still come, it must be flushed */
+
+          g_lesp_state.synced = false;
           return -1;
         }
 
       pthread_mutex_lock(&g_lesp_state.worker.mutex);
 
-      if (g_lesp_state.worker.and != LESP_NONE)
+      ret = 0;
+      if (g_lesp_state.worker.nlines > 0)
         {
-          g_lesp_state.and = g_lesp_state.worker.and;
-          g_lesp_state.worker.and = LESP_NONE;
-        }
+          lesp_line_t *line;
+
+          line = &g_lesp_state.worker.lines[g_lesp_state.worker.lineout];
+          if (line->and != LESP_NONE)
+            {
+              g_lesp_state.and = line->and;
+            }
 
-      ret = strlen(g_lesp_state.worker.buf);
-      if (ret > 0)
-        {
           /* +1 to copy null */
 
-          memcpy(g_lesp_state.bufans, g_lesp_state.worker.buf, ret + 1);
+          ret = strlen(line->line);
+          memcpy(g_lesp_state.bufans, line->line, ret + 1);
+
+          if (++g_lesp_state.worker.lineout >= LESP_LINE_NBR)
+            {
+              g_lesp_state.worker.lineout = 0;
+            }
+
+          g_lesp_state.worker.nlines--;
         }
 
-      g_lesp_state.worker.buf[0] = '\0'; /* buffer is read */
       pthread_mutex_unlock(&g_lesp_state.worker.mutex);
     }
   while ((ret <= 0) && (g_lesp_state.and == LESP_NONE));
@@ -749,6 +808,11 @@ int lesp_read_ans_ok(int timeout_ms)
       if ((ret < 0) || (g_lesp_state.and == LESP_ERR) ||
           (time(NULL) > end))
         {
+          if (g_lesp_state.and != LESP_ERR)
+            {
+              g_lesp_state.synced = false;
+            }
+
           ret = -1;
           break;
         }
@@ -798,7 +862,8 @@ static int lesp_ask_ans_ok(int timeout_ms, FAR const IPTR char *format, ...)
  * Name: lesp_check
  *
  * Description:
- *   check if esp is ready (initialized and AT return OK)
+ *   check if esp is ready (initialized and AT return OK).  The AT is only
+ *   sent after a command that did not get all of its answers.
  *
  * Input Parameters:
  *   None
@@ -816,6 +881,15 @@ static int lesp_check(void)
       return -1;
     }
 
+  /* The answers of the last command were all read, there is nothing to
+   * flush and no need of an AT round trip before the next command.
+   */
+
+  if (g_lesp_state.synced)
+    {
+      return 0;
+    }
+
   lesp_flush();
 
   if (lesp_ask_ans_ok(LESP_TIMEOUT_MS, "AT\r\n") < 0)
@@ -824,6 +898,7 @@ static int lesp_check(void)
       return -1;
     }
 
+  g_lesp_state.synced = true;
   return 0;
 }
 
@@ -1226,11 +1301,157 @@ static int lesp_parse_cwlap_ans_line(char *ptr, lesp_ap_t *ap)
   return 0;
 }
 
+/****************************************************************************
+ * Name: lesp_push_line
+ *
+ * Description:
+ *   Queue an answer line for lesp_read.
+ *
+ * Note:
+ *  g_lesp_state.worker.mutex should be locked.
+ *
+ * Input Parameters:
+ *   and  : LESP_OK or LESP_ERR if the line ends the command, else LESP_NONE
+ *   line : null terminated line.
+ *   len  : length of line.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+static void lesp_push_line(lesp_ans_t and, const char *line, int len)
+{
+  lesp_worker_t *worker = &g_lesp_state.worker;
+  lesp_line_t *entry;
+  int ndx;
+
+  if (len >= BUF_ANS_LEN)
+    {
+      nerr("Worker and line is too long:%s\n", line);
+      return;
+    }
+
+  if (worker->nlines >= LESP_LINE_NBR)
+    {
+      pthread_mutex_unlock(&worker->mutex);
+      usleep(100); /* leave time of aplicative to read lines */
+      pthread_mutex_lock(&worker->mutex);
+
+      if (worker->nlines >= LESP_LINE_NBR)
+        {
+          nerr("ERROR: Answer queue full, line lost:%s\n", line);
+          return;
+        }
+    }
+
+  ndx = worker->lineout + worker->nlines;
+  if (ndx >= LESP_LINE_NBR)
+    {
+      ndx -= LESP_LINE_NBR;
+    }
+
+  entry      = &worker->lines[ndx];
+  entry->and = and;
+  memcpy(entry->line, line, len + 1);
+  worker->nlines++;
+
+  sem_post(&worker->sem);
+}
+
+/****************************************************************************
+ * Name: lesp_worker_line
+ *
+ * Description:
+ *   Treat a complete line received by the worker.  Unsolicited results
+ *   (connection state of sockets and Wi-Fi, send progress) are handled
+ *   here, everything else is queued for the command waiting for it.
+ *
+ * Note:
+ *  g_lesp_state.worker.mutex should be locked.
+ *
+ * Input Parameters:
+ *   line : null terminated line.
+ *   len  : length of line.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+static void lesp_worker_line(const char *line, int len)
+{
+  unsigned int sockid;
+
+  /* The AT+CIPSEND prompt is not followed by a line return */
+
+  if (line[0] == '>')
+    {
+      do
+        {
+          line++;
+          len--;
+        }
+      while (line[0] == ' ');
+
+      if (len == 0)
+        {
+          return;
+        }
+    }
+
+  sockid = line[0] - '0';
+
+  if ((strcmp(line, "OK") == 0) || (strcmp(line, "SEND OK") == 0))
+    {
+      lesp_push_line(LESP_OK, line, len);
+    }
+  else if ((strcmp(line, "FAIL") == 0) ||
+           (strcmp(line, "ERROR") == 0) ||
+           (strcmp(line, "SEND FAIL") == 0))
+    {
+      lesp_push_line(LESP_ERR, line, len);
+    }
+  else if ((sockid < SOCKET_NBR) && (line[1] == ','))
+    {
+      /* <id>,CONNECT  <id>,CONNECT FAIL  <id>,CLOSED */
+
+      if (strcmp(line + 2, "CLOSED") == 0)
+        {
+          set_sock_closed(sockid);
+        }
+      else if ((strcmp(line + 2, "CONNECT") == 0) &&
+               (g_lesp_state.sockets[sockid].flags & FLAGS_SOCK_USED))
+        {
+          g_lesp_state.sockets[sockid].flags |= FLAGS_SOCK_CONNECTED;
+        }
+      else
+        {
+          ninfo("Socket %d:%s\n", sockid, line + 2);
+        }
+    }
+  else if ((strncmp(line, "WIFI ", 5) == 0) ||
+           (strncmp(line, "Recv ", 5) == 0) ||
+           (strncmp(line, "busy ", 5) == 0))
+    {
+      /* Wi-Fi state changes and send progress, the answer of the command
+       * follows.
+       */
+
+      ninfo("Unsolicited:%s\n", line);
+    }
+  else
+    {
+      lesp_push_line(LESP_NONE, line, len);
+    }
+}
+
 /****************************************************************************
  * Name: lesp_worker
  *
  * Description:
- *      Esp8266 worker thread.
+ *      Esp8266 worker thread.  Reads the serial port by blocks, splits the
+ *      answers in lines and stores the '+IPD' data in socket buffers.
  *
  * Input Parameters:
  *   args  : unused
@@ -1253,76 +1474,37 @@ static void *lesp_worker(void *args)
 
   while (worker->running)
     {
-      uint8_t c;
-
-      ret = lesp_low_level_read(&c, 1);
+      ret = lesp_low_level_read(worker->chunk, BUF_WORKER_LEN);
 
       if (ret < 0)
         {
           nerr("ERROR: worker read data Error %d\n", ret);
+          continue;
         }
-      else if (ret > 0)
+
+      pthread_mutex_lock(&(worker->mutex));
+
+      worker->chunklen = ret;
+      worker->chunkpos = 0;
+
+      while (worker->chunkpos < worker->chunklen)
         {
-          /* ninfo("c:0x%02X (%c)\n", c); */
+          uint8_t c = worker->chunk[worker->chunkpos++];
 
-          pthread_mutex_lock(&(worker->mutex));
           if (c == '\n')
             {
-              if (worker->rxbuf[rxlen - 1] == '\r')
+              if ((rxlen > 0) && (worker->rxbuf[rxlen - 1] == '\r'))
                 {
                   rxlen--;
                 }
 
-              DEBUGASSERT(rxlen >= 0);
               DEBUGASSERT(rxlen < BUF_WORKER_LEN);
 
               worker->rxbuf[rxlen] = '\0';
 
               if (rxlen != 0)
                 {
-                  if (strcmp(worker->rxbuf, "OK") == 0)
-                    {
-                      worker->and = LESP_OK;
-                    }
-                  else if ((strcmp(worker->rxbuf, "FAIL") == 0) ||
-                           (strcmp(worker->rxbuf, "ERROR") == 0)
-                          )
-                    {
-                      worker->and = LESP_ERR;
-                    }
-                  else if ((rxlen == 8) &&
-                            (memcmp(worker->rxbuf + 1, ",CLOSED", 7) == 0))
-                    {
-                      unsigned int sockid = worker->rxbuf[0] - '0';
-                      if (sockid < SOCKET_NBR)
-                        {
-                          set_sock_closed(sockid);
-                        }
-                    }
-                  else
-                    {
-                      if (worker->buf[0] != '\0')
-                        {
-                          pthread_mutex_unlock(&(worker->mutex));
-                          usleep(100); /* leave time of aplicative to read buffer */
-                          pthread_mutex_lock(&(worker->mutex));
-                        }
-
-                      /* ninfo("Worker Read data:%s\n", worker->rxbuf); */
-
-                      if (rxlen + 1 <= BUF_ANS_LEN)
-                        {
-                          memcpy(worker->buf, worker->rxbuf, rxlen + 1);
-                        }
-                      else
-                        {
-                          nerr("Worker and line is too long:%s\n",
-                               worker->rxbuf);
-                        }
-                    }
-
-                  sem_post(&worker->sem);
-                  worker->rxbuf[0] = '\0';
+                  lesp_worker_line(worker->rxbuf, rxlen);
                   rxlen = 0;
                 }
             }
@@ -1335,6 +1517,8 @@ static void *lesp_worker(void *args)
                   int len;
                   char *ptr = worker->rxbuf + 5;
 
+                  worker->rxbuf[rxlen] = '\0';
+
                   sockfd = lesp_str_to_unsigned(&ptr, ',');
                   if (sockfd >= 0)
                     {
@@ -1352,9 +1536,9 @@ static void *lesp_worker(void *args)
             {
               nerr("Read char overflow:%c\n", c);
             }
-
-          pthread_mutex_unlock(&(worker->mutex));
         }
+
+      pthread_mutex_unlock(&(worker->mutex));
     }
 
   return NULL;
@@ -2454,6 +2638,8 @@ ssize_t lesp_send(int sockfd, FAR const uint8_t *buf, size_t len, int flags)
 {
   int ret = 0;
   lesp_socket_t *sock = NULL;
+  size_t sent;
+  int size;
 
   UNUSED(flags);
 
@@ -2472,37 +2658,31 @@ ssize_t lesp_send(int sockfd, FAR const uint8_t *buf, size_t len, int flags)
         }
     }
 
-  if (ret >= 0)
-    {
-      ret = lesp_ask_ans_ok(LESP_TIMEOUT_MS,
-                            "AT+CIPSEND=%d,%d\r\n", sockfd, len);
-    }
-
-  if (ret >= 0)
-    {
-      ninfo("Sending in socket %d, %d bytes\n", sockfd, len);
-      ret = write(g_lesp_state.fd, buf, len);
-    }
+  /* The firmware takes at most LESP_SEND_MAX bytes by AT+CIPSEND and
+   * ignores commands until "SEND OK".
+   */
 
-  while (ret >= 0)
+  for (sent = 0; (ret >= 0) && (sent < len); sent += size)
     {
-      char * ptr = g_lesp_state.bufans;
-      ret = lesp_read(LESP_TIMEOUT_MS);
+      size = MIN(len - sent, LESP_SEND_MAX);
 
-      if (ret < 0)
-        {
-          break;
-        }
+      ret = lesp_ask_ans_ok(LESP_TIMEOUT_MS,
+                            "AT+CIPSEND=%d,%d\r\n", sockfd, size);
 
-      while ((*ptr != 0) && (*ptr != 'S'))
+      if (ret >= 0)
         {
-          ptr++;
+          ninfo("Sending in socket %d, %d bytes\n", sockfd, size);
+          ret = write(g_lesp_state.fd, buf + sent, size);
+          if (ret != size)
+            {
+              g_lesp_state.synced = false;
+              ret = -1;
+            }
         }
 
-      if (*ptr == 'S')
+      if (ret >= 0)
         {
-          if (strcmp(ptr, "SEND OK") == 0)
-              break;
+          ret = lesp_read_ans_ok(LESP_TIMEOUT_MS_SEND);
         }
     }
 
@@ -2594,23 +2774,21 @@ ssize_t lesp_recv(int sockfd, FAR uint8_t *buf, size_t len, int flags)
       ret = 0;
       while (ret < len && sock->outndx != sock->inndx)
         {
-          /* Remove one byte from the circular buffer */
+          /* Copy up to 'inndx' or up to the end of the circular buffer */
 
-          int ndx = sock->outndx;
-          *buf++  = sock->rxbuf[ndx];
+          int n = (sock->inndx > sock->outndx) ? sock->inndx :
+                  SOCKET_FIFO_SIZE;
 
-          /* Increment the circular buffer 'outndx' */
+          n = MIN(n - sock->outndx, len - ret);
+          memcpy(buf + ret, &sock->rxbuf[sock->outndx], n);
 
-          if (++ndx >= SOCKET_FIFO_SIZE)
-            {
-              ndx -= SOCKET_FIFO_SIZE;
-            }
+          /* Increment the circular buffer 'outndx' */
 
-          sock->outndx = ndx;
+          sock->outndx = (sock->outndx + n) & (SOCKET_FIFO_SIZE - 1);
 
           /* Increment the count of bytes returned */
 
-          ret++;
+          ret += n;
         }
     }
 
@@ -36,49 +36,6 @@
  * Private Functions
  ****************************************************************************/
 
-/****************************************************************************
- * Name: ftpc_restore
- *
- * Description:
- *   Restore the connection to the server and log in again.
- *
- ****************************************************************************/
-
-#ifdef CONFIG_FTP_AUTORECONNECT
-static int ftpc_restore(struct ftpc_session_s *session)
-{
-  int ret;
-
-  if (session)
-    {
-      /* Set the initial directory to the last valid current directory */
-
-      free(session->initrdir);
-      session->initrdir = ftpc_dequote(session->currdir);
-
-      /* Reconnect to the server */
-
-      ret = ftpc_reconnect(session);
-      if (ret == 0)
-        {
-          /* Log into the server */
-
-          ret = ftpc_relogin(session);
-        }
-      else
-        {
-          /* Failed to reconnect to the server */
-
-          ftpc_reset(session);
-        }
-
-      return ret;
-    }
-
-  return ERROR;
-}
-#endif
-
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -175,7 +132,7 @@ int ftpc_cmd(struct ftpc_session_s *session, const char *cmd, ...)
 
                   ninfo("Reconnecting...\n");
                   reconnect = true;
-                  ret = ftpc_restore();
+                  ret = ftpc_restore(session);
                   if (ret < 0)
                     {
                       nwarn("WARNING: Failed to restore the connection");
@@ -283,3 +283,49 @@ errout:
 
   return ERROR;
 }
+
+/****************************************************************************
+ * Name: ftpc_restore
+ *
+ * Description:
+ *   Restore the connection to the server after it was lost, log in again
+ *   and go back to the last valid current directory.  The login parameters
+ *   are kept on failure so that the caller may try again.
+ *
+ ****************************************************************************/
+
+int ftpc_restore(FAR struct ftpc_session_s *session)
+{
+  int ret;
+
+  /* Set the initial directory to the last valid current directory */
+
+  if (session->currdir != NULL)
+    {
+      free(session->initrdir);
+      session->initrdir = ftpc_dequote(session->currdir);
+    }
+
+  free(session->homerdir);
+  session->homerdir = NULL;
+  free(session->currdir);
+  session->currdir  = NULL;
+
+  /* Drop what is left of the old connection */
+
+  ftpc_sockclose(&session->data);
+  ftpc_sockclose(&session->dacceptor);
+  ftpc_sockclose(&session->cmd);
+  FTPC_CLR_CONNECTED(session);
+  FTPC_CLR_LOGGEDIN(session);
+
+  /* Reconnect to the server and log in */
+
+  ret = ftpc_reconnect(session);
+  if (ret == OK)
+    {
+      ret = ftpc_relogin(session);
+    }
+
+  return ret;
+}
@@ -0,0 +1,408 @@
+/****************************************************************************
+ * apps/netutils/ftpc/ftpc_getsegments.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "ftpc_config.h"
+
+#include <sys/stat.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+
+#include "netutils/ftpc.h"
+
+#include "ftpc_internal.h"
+
+#ifdef CONFIG_FTPC_SEGMENTED
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One byte range of the file, received over its own session */
+
+struct ftpc_segment_s
+{
+  FAR struct ftpc_session_s *parent;  /* Session that started the transfer */
+  FAR struct ftpc_session_s *session; /* Session of this segment */
+  FAR const char *path;               /* Absolute remote path */
+  pthread_t thread;                   /* Receiving thread */
+  off_t pos;                          /* Next byte to receive */
+  off_t end;                          /* End of the range */
+  int fd;                             /* Local file */
+  int result;                         /* OK once the range is complete */
+  bool failed;                        /* Local error, don't retry */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftpc_segopen
+ *
+ * Description:
+ *   Connect and log in a session for a segment with the credentials and
+ *   the host capabilities of the parent session.
+ *
+ ****************************************************************************/
+
+static int ftpc_segopen(FAR struct ftpc_segment_s *seg)
+{
+  FAR struct ftpc_session_s *parent = seg->parent;
+  FAR struct ftpc_session_s *session;
+
+  session = (FAR struct ftpc_session_s *)ftpc_connect(&parent->server);
+  if (session == NULL)
+    {
+      return ERROR;
+    }
+
+  /* Timeouts signal the thread that waits, not the parent task */
+
+  session->pid    = gettid();
+  session->flags &= ~(FTPC_HOSTCAP_FLAGS | FTPC_FLAG_PASSIVE);
+  session->flags |= parent->flags & (FTPC_HOSTCAP_FLAGS |
+                                     FTPC_FLAG_PASSIVE);
+  session->uname  = strdup(parent->uname);
+  session->pwd    = strdup(parent->pwd);
+  seg->session    = session;
+
+  if (session->uname == NULL || session->pwd == NULL)
+    {
+      errno = ENOMEM;
+      return ERROR;
+    }
+
+  return ftpc_relogin(session);
+}
+
+/****************************************************************************
+ * Name: ftpc_segrecv
+ *
+ * Description:
+ *   Start a RETR at the current position of the segment and receive until
+ *   the end of its range.
+ *
+ ****************************************************************************/
+
+static int ftpc_segrecv(FAR struct ftpc_segment_s *seg)
+{
+  FAR struct ftpc_session_s *session = seg->session;
+  ssize_t nread;
+  ssize_t nwritten;
+  size_t len;
+  int ret;
+
+  ftpc_xfrreset(session);
+  ret = ftpc_xfrinit(session);
+  if (ret != OK)
+    {
+      return ERROR;
+    }
+
+  ret = ftpc_xfrmode(session, FTPC_XFRMODE_BINARY);
+  if (ret == OK && seg->pos > 0)
+    {
+      ret = ftpc_cmd(session, "REST %" PRIdOFF, seg->pos);
+    }
+
+  if (ret == OK)
+    {
+      ret = ftpc_cmd(session, "RETR %s", seg->path);
+    }
+
+  if (ret == OK && !FTPC_IS_PASSIVE(session))
+    {
+      ret = ftpc_sockaccept(&session->dacceptor, &session->data);
+    }
+
+  if (ret != OK)
+    {
+      return ERROR;
+    }
+
+  /* Receive up to the end of the range, which is before the end of the
+   * file for all segments but the last.
+   */
+
+  while (seg->pos < seg->end)
+    {
+      len = CONFIG_FTP_BUFSIZE;
+      if (seg->end - seg->pos < len)
+        {
+          len = seg->end - seg->pos;
+        }
+
+      nread = fread(session->buffer, 1, len, session->data.instream);
+      if (nread <= 0)
+        {
+          nwarn("WARNING: Segment ended at %" PRIdOFF "\n", seg->pos);
+          return ERROR;
+        }
+
+      nwritten = pwrite(seg->fd, session->buffer, nread, seg->pos);
+      if (nwritten != nread)
+        {
+          nerr("ERROR: pwrite failed: %d\n", errno);
+          seg->failed = true;
+          return ERROR;
+        }
+
+      seg->pos      += nwritten;
+      session->size += nwritten;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftpc_segthread
+ *
+ * Description:
+ *   Receive one segment.  After a failure the session is connected and
+ *   logged in again, and the transfer restarts where it stopped.
+ *
+ ****************************************************************************/
+
+static FAR void *ftpc_segthread(FAR void *arg)
+{
+  FAR struct ftpc_segment_s *seg = (FAR struct ftpc_segment_s *)arg;
+  off_t start;
+  int retry = 0;
+  int ret;
+
+  ret = ftpc_segopen(seg);
+  for (; ; )
+    {
+      if (ret == OK)
+        {
+          start = seg->pos;
+          ret   = ftpc_segrecv(seg);
+          if (ret == OK)
+            {
+              break;
+            }
+
+          /* Only count the failures that made no progress */
+
+          if (seg->pos > start)
+            {
+              retry = 0;
+            }
+        }
+
+      if (seg->failed || ++retry > CONFIG_FTPC_SEGMENT_RETRIES)
+        {
+          break;
+        }
+
+      nwarn("WARNING: Resuming segment at %" PRIdOFF "\n", seg->pos);
+      if (seg->session == NULL)
+        {
+          ret = ftpc_segopen(seg);
+        }
+      else
+        {
+          ret = ftpc_restore(seg->session);
+        }
+    }
+
+  /* The server is still sending the rest of the file, closing both
+   * connections is the fastest way to stop it.
+   */
+
+  seg->result = ret == OK && seg->pos == seg->end ? OK : ERROR;
+  ftpc_disconnect(seg->session);
+  seg->session = NULL;
+  return NULL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ftpc_getsegments
+ *
+ * Description:
+ *   Get a file from the remote host in binary mode, split in nsegments
+ *   byte ranges received in parallel over their own connections.  The
+ *   local file is created at its final size and each range is written at
+ *   its offset.  A segment that loses its connection connects again and
+ *   resumes with REST.
+ *
+ *   The server must support SIZE and REST.  Without SIZE, or for small
+ *   files, this is a normal ftpc_getfile().
+ *
+ * Input Parameters:
+ *   handle    - The session, logged in
+ *   rname     - The remote file
+ *   lname     - The local file, rname if NULL
+ *   nsegments - Number of parallel connections, or 0 for
+ *               CONFIG_FTPC_SEGMENTS
+ *
+ ****************************************************************************/
+
+int ftpc_getsegments(SESSION handle, FAR const char *rname,
+                     FAR const char *lname, int nsegments)
+{
+  FAR struct ftpc_session_s *session = (FAR struct ftpc_session_s *)handle;
+  FAR struct ftpc_segment_s *segs;
+  pthread_attr_t attr;
+  FAR char *absrpath;
+  FAR char *abslpath;
+  off_t filesize;
+  off_t segsize;
+  int result = ERROR;
+  int started;
+  int fd;
+  int i;
+
+  DEBUGASSERT(rname);
+
+  if (!ftpc_loggedin(session))
+    {
+      nerr("ERROR: Not logged in\n");
+      errno = ENOTCONN;
+      return ERROR;
+    }
+
+  if (!lname)
+    {
+      lname = rname;
+    }
+
+  if (nsegments <= 0)
+    {
+      nsegments = CONFIG_FTPC_SEGMENTS;
+    }
+
+  filesize = ftpc_filesize(session, rname);
+  if (filesize == (off_t)ERROR)
+    {
+      nwarn("WARNING: No size for %s, single transfer\n", rname);
+      return ftpc_getfile(handle, rname, lname, FTPC_GET_NORMAL,
+                          FTPC_XFRMODE_BINARY);
+    }
+
+  /* Don't open more connections than there are minimum size ranges */
+
+  if (filesize / CONFIG_FTPC_SEGMENT_MINSIZE < nsegments)
+    {
+      nsegments = filesize / CONFIG_FTPC_SEGMENT_MINSIZE;
+    }
+
+  if (nsegments <= 1)
+    {
+      return ftpc_getfile(handle, rname, lname, FTPC_GET_NORMAL,
+                          FTPC_XFRMODE_BINARY);
+    }
+
+  absrpath = ftpc_absrpath(session, rname);
+  abslpath = ftpc_abslpath(session, lname);
+  segs     = (FAR struct ftpc_segment_s *)
+             zalloc(nsegments * sizeof(struct ftpc_segment_s));
+  if (absrpath == NULL || abslpath == NULL || segs == NULL)
+    {
+      errno = ENOMEM;
+      goto errout;
+    }
+
+  /* Create the file at its final size so that each segment can write
+   * anywhere in it.
+   */
+
+  fd = open(abslpath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    {
+      nerr("ERROR: open(%s) failed: %d\n", abslpath, errno);
+      goto errout;
+    }
+
+  if (ftruncate(fd, filesize) < 0)
+    {
+      nerr("ERROR: ftruncate failed: %d\n", errno);
+      goto errout_with_fd;
+    }
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_FTPC_SEGMENT_STACKSIZE);
+
+  segsize = filesize / nsegments;
+  for (i = 0; i < nsegments; i++)
+    {
+      segs[i].parent = session;
+      segs[i].path   = absrpath;
+      segs[i].fd     = fd;
+      segs[i].pos    = i * segsize;
+      segs[i].end    = i == nsegments - 1 ? filesize : (i + 1) * segsize;
+      segs[i].result = ERROR;
+
+      if (pthread_create(&segs[i].thread, &attr, ftpc_segthread,
+                         &segs[i]) != 0)
+        {
+          nerr("ERROR: pthread_create failed\n");
+          break;
+        }
+    }
+
+  pthread_attr_destroy(&attr);
+
+  /* Wait for all of the segments that were started */
+
+  started       = i;
+  result        = started == nsegments ? OK : ERROR;
+  session->size = 0;
+  for (i = 0; i < started; i++)
+    {
+      pthread_join(segs[i].thread, NULL);
+      if (segs[i].result != OK)
+        {
+          nerr("ERROR: Segment %d stopped at %" PRIdOFF "\n",
+               i, segs[i].pos);
+          result = ERROR;
+        }
+    }
+
+  if (result == OK)
+    {
+      session->size = filesize;
+    }
+
+errout_with_fd:
+  close(fd);
+errout:
+  free(segs);
+  free(abslpath);
+  free(absrpath);
+  return result;
+}
+
+#endif /* CONFIG_FTPC_SEGMENTED */
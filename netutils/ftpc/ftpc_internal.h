@@ -222,6 +222,7 @@ EXTERN FAR char *ftpc_dequote(FAR const char *hostname);
 
 EXTERN int ftpc_reconnect(FAR struct ftpc_session_s *session);
 EXTERN int ftpc_relogin(FAR struct ftpc_session_s *session);
+EXTERN int ftpc_restore(FAR struct ftpc_session_s *session);
 
 /* FTP helpers */
 
@@ -391,12 +391,14 @@ static int ftpc_sendfile(struct ftpc_session_s *session, const char *path,
   ftpc_sockflush(&session->data);
   ftpc_sockclose(&session->data);
 
-  if (ret == 0)
+  /* The server tells whether the whole file was stored */
+
+  if (ret == OK && (fptc_getreply(session) < 0 || session->code >= 400))
     {
-      fptc_getreply(session);
+      ret = ERROR;
     }
 
-  return OK;
+  return ret;
 }
 
 /****************************************************************************
@@ -418,6 +420,9 @@ int ftp_putfile(SESSION handle, const char *lname, const char *rname,
   FAR char *abslpath;
   struct stat statbuf;
   FILE *finstream;
+#if CONFIG_FTPC_PUT_RETRIES > 0
+  int retry;
+#endif
   int ret;
 
   /* Don't call this with a NULL local file name */
@@ -501,6 +506,46 @@ int ftp_putfile(SESSION handle, const char *lname, const char *rname,
   /* Send the file */
 
   ret = ftpc_sendfile(session, rname, finstream, how, xfrmode);
+
+#if CONFIG_FTPC_PUT_RETRIES > 0
+  /* If the transfer was interrupted, connect again and resume after what
+   * the server has already stored.  Only a binary file that replaces the
+   * remote one can be resumed that way.
+   */
+
+  for (retry = 0;
+       ret != OK && retry < CONFIG_FTPC_PUT_RETRIES &&
+       xfrmode == FTPC_XFRMODE_BINARY &&
+       (how == FTPC_PUT_NORMAL || how == FTPC_PUT_RESUME);
+       retry++)
+    {
+      nwarn("WARNING: Transfer interrupted, resuming\n");
+
+      if (ftpc_restore(session) != OK)
+        {
+          continue;
+        }
+
+      session->offset = ftpc_filesize(session, rname);
+      if (session->offset == (off_t)ERROR)
+        {
+          nwarn("WARNING: Failed to get size of remote file: %s\n",
+                rname);
+          break;
+        }
+
+      ret = fseek(finstream, session->offset, SEEK_SET);
+      if (ret != OK)
+        {
+          nerr("ERROR: fseek failed: %d\n", errno);
+          break;
+        }
+
+      ret = ftpc_sendfile(session, rname, finstream, FTPC_PUT_NORMAL,
+                          xfrmode);
+    }
+#endif
+
   if (ret == OK)
     {
       fclose(finstream);
@@ -83,10 +83,10 @@ FAR char *ftpc_rpwd(SESSION handle)
    *   Reply: 257 "/home/gnutt"
    *               ^start     ^end
    *
-   *   len = end - start + 1 = 11 (+ NUL terminator)
+   *   len = end - start = 11 (+ NUL terminator)
    */
 
-  len = end - start + 1;
+  len = end - start;
   pwd = (char *)malloc(len + 1);
   if (!pwd)
     {
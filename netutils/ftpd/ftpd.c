@@ -47,11 +47,17 @@
 
 #include <sys/socket.h>
 #include <sys/stat.h>
+#ifdef CONFIG_FTPD_SENDFILE
+#  include <sys/sendfile.h>
+#endif
 
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <malloc.h>
+#include <time.h>
 #include <dirent.h>
 #include <strings.h>
 #include <ctype.h>
@@ -137,12 +143,40 @@ static int ftpd_getpath(FAR struct ftpd_session_s *session,
 static int ftpd_changedir(FAR struct ftpd_session_s *session,
                           FAR const char *rempath);
 static off_t ftpd_offsatoi(FAR const char *filename, off_t offset);
+static uint32_t ftpd_msecs(void);
+static int ftpd_copystream(FAR struct ftpd_session_s *session, int cmdtype,
+                           FAR off_t *nbytes);
+#ifdef CONFIG_FTPD_SENDFILE
+static int ftpd_sendstream(FAR struct ftpd_session_s *session,
+                           FAR off_t *nbytes);
+#endif
+#ifdef CONFIG_FTPD_STOR_DOUBLEBUFFER
+static FAR void *ftpd_dbufwriter(FAR void *arg);
+static int ftpd_recvstream(FAR struct ftpd_session_s *session,
+                           FAR off_t *nbytes);
+#endif
 static int ftpd_stream(FAR struct ftpd_session_s *session, int cmdtype);
 static uint8_t ftpd_listoption(FAR char **param);
 static int ftpd_listbuffer(FAR struct ftpd_session_s *session,
                            FAR char *path, FAR struct stat *st,
                            FAR char *buffer, size_t buflen,
                            unsigned int opton);
+#ifdef CONFIG_FTPD_LISTCACHE
+static void ftpd_listentry_free(FAR struct ftpd_listentry_s *entry);
+static FAR struct ftpd_listentry_s *
+ftpd_listcache_get(FAR struct ftpd_listcache_s *cache, FAR const char *path,
+                   unsigned int opton, time_t mtime);
+static void ftpd_listcache_put(FAR struct ftpd_listcache_s *cache,
+                               FAR struct ftpd_listentry_s *entry);
+static void ftpd_listcache_add(FAR struct ftpd_listcache_s *cache,
+                               FAR const char *path, unsigned int opton,
+                               time_t mtime, FAR char *text, size_t len);
+static void ftpd_listcache_drop(FAR struct ftpd_listcache_s *cache,
+                                int index);
+static void ftpd_listcache_free(FAR struct ftpd_listcache_s *cache);
+#endif
+static void ftpd_listinvalidate(FAR struct ftpd_session_s *session,
+                                FAR const char *path);
 static int fptd_listscan(FAR struct ftpd_session_s *session,
                          FAR char *path, unsigned int opton);
 static int ftpd_list(FAR struct ftpd_session_s *session,
@@ -192,8 +226,24 @@ static int ftpd_startworker(pthread_startroutine_t handler, FAR void *arg,
                             size_t stacksize);
 static void ftpd_freesession(FAR struct ftpd_session_s *session);
 static void ftpd_workersetup(FAR struct ftpd_session_s *session);
+static int ftpd_greeting(FAR struct ftpd_session_s *session);
+static int ftpd_process(FAR struct ftpd_session_s *session);
 static FAR void *ftpd_worker(FAR void *arg);
 
+/* Session multiplexer */
+
+#ifdef CONFIG_FTPD_MUX
+static void ftpd_muxwakeup(FAR struct ftpd_mux_s *mux);
+static void ftpd_muxremove(FAR struct ftpd_mux_s *mux,
+                           FAR struct ftpd_session_s *session);
+static FAR void *ftpd_muxthread(FAR void *arg);
+static FAR void *ftpd_muxworker(FAR void *arg);
+static int ftpd_muxstart(FAR struct ftpd_server_s *server);
+static int ftpd_muxadd(FAR struct ftpd_server_s *server,
+                       FAR struct ftpd_session_s *session);
+static void ftpd_muxstop(FAR struct ftpd_server_s *server);
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -1168,6 +1218,17 @@ static FAR struct ftpd_server_s *ftpd_openserver(int port,
   server->head = NULL;
   server->tail = NULL;
 
+#ifdef CONFIG_FTPD_LISTCACHE
+  /* The listing cache is optional; without it listings are just slower */
+
+  server->listcache = (FAR struct ftpd_listcache_s *)
+    zalloc(sizeof(struct ftpd_listcache_s));
+  if (server->listcache != NULL)
+    {
+      pthread_mutex_init(&server->listcache->lock, NULL);
+    }
+#endif
+
   /* Create the server listen socket */
 
 #ifdef CONFIG_NET_IPv6
@@ -1759,159 +1820,37 @@ static off_t ftpd_offsatoi(FAR const char *filename, off_t offset)
 }
 
 /****************************************************************************
- * Name: ftpd_stream
+ * Name: ftpd_msecs
  ****************************************************************************/
 
-static int ftpd_stream(FAR struct ftpd_session_s *session, int cmdtype)
+static uint32_t ftpd_msecs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/****************************************************************************
+ * Name: ftpd_copystream
+ *
+ * Description:
+ *   Move data between the open file and the data connection through the
+ *   session data buffer.  This handles ASCII conversion and is used for
+ *   all transfers that have no faster path.
+ *
+ ****************************************************************************/
+
+static int ftpd_copystream(FAR struct ftpd_session_s *session, int cmdtype,
+                           FAR off_t *nbytes)
 {
-  FAR char *abspath;
-  FAR char *path;
-  bool isnew;
-  int oflags;
   FAR char *buffer;
   size_t buflen;
   size_t wantsize;
   ssize_t rdbytes;
   ssize_t wrbytes;
   int errval = 0;
-  int ret;
-
-  ret = ftpd_getpath(session, session->param, &abspath, NULL);
-  if (ret < 0)
-    {
-      ftpd_response(session->cmd.sd, session->txtimeout,
-                    g_respfmt1, 550, ' ', "Stream error !");
-      goto errout;
-    }
-
-  path = abspath;
-
-  ret = ftpd_dataopen(session);
-  if (ret < 0)
-    {
-      goto errout_with_path;
-    }
-
-  switch (cmdtype)
-    {
-      case 0: /* retr */
-        oflags = O_RDONLY;
-        break;
-
-      case 1: /* stor */
-        oflags = O_CREAT | O_WRONLY;
-         break;
-
-      case 2: /* appe */
-        oflags = O_CREAT | O_WRONLY | O_APPEND;
-        break;
-
-      default:
-        oflags = O_RDONLY;
-        break;
-    }
-
-#if defined(O_LARGEFILE)
-  oflags |= O_LARGEFILE;
-#endif
-
-  /* Are we creating the file? */
-
-  if ((oflags & O_CREAT) != 0)
-    {
-      int mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH;
-
-      if (session->restartpos <= 0)
-        {
-          oflags |= O_TRUNC;
-        }
-
-      isnew = true;
-      session->fd = open(path, oflags | O_EXCL, mode);
-      if (session->fd < 0)
-        {
-          isnew = false;
-          session->fd = open(path, oflags, mode);
-        }
-    }
-  else
-    {
-      /* No.. we are opening an existing file */
-
-      isnew = false;
-      session->fd = open(path, oflags);
-    }
-
-  if (session->fd < 0)
-    {
-      ret = -errno;
-      ftpd_response(session->cmd.sd, session->txtimeout,
-                    g_respfmt1, 550, ' ', "Can not open file !");
-      goto errout_with_data;
-    }
-
-  /* Restart position */
-
-  if (session->restartpos > 0)
-    {
-      off_t seekoffs = (off_t)-1;
-      off_t seekpos;
-
-      /* Get the seek position */
-
-      if (session->type == FTPD_SESSIONTYPE_A)
-        {
-          seekpos = ftpd_offsatoi(path, session->restartpos);
-          if (seekpos < 0)
-            {
-              nerr("ERROR: ftpd_offsatoi failed: %jd\n", (intmax_t)seekpos);
-              errval = -seekpos;
-            }
-        }
-      else
-        {
-          seekpos = session->restartpos;
-          if (seekpos < 0)
-            {
-              nerr("ERROR: Bad restartpos: %jd\n", (intmax_t)seekpos);
-              errval = EINVAL;
-            }
-        }
-
-      /* Seek to the request position */
-
-      if (seekpos >= 0)
-        {
-          seekoffs = lseek(session->fd, seekpos, SEEK_SET);
-          if (seekoffs < 0)
-            {
-              errval = errno;
-              nerr("ERROR: lseek failed: %d\n", errval);
-            }
-        }
-
-      /* Report errors.  If an error occurred, seekoffs will be negative and
-       * errval will hold the (positive) error code.
-       */
-
-      if (seekoffs < 0)
-        {
-          ftpd_response(session->cmd.sd, session->txtimeout,
-                        g_respfmt1, 550, ' ', "Can not seek file !");
-          ret = -errval;
-          goto errout_with_session;
-        }
-    }
-
-  /* Send success message */
-
-  ret = ftpd_response(session->cmd.sd, session->txtimeout,
-                      g_respfmt1, 150, ' ', "Opening data connection");
-  if (ret < 0)
-    {
-      nerr("ERROR: ftpd_response failed: %d\n", ret);
-      goto errout_with_session;
-    }
+  int ret = 0;
 
   for (; ; )
     {
@@ -2063,93 +2002,566 @@ static int ftpd_stream(FAR struct ftpd_session_s *session, int cmdtype)
           ret = -errval;
           break;
         }
-    }
-
-errout_with_session:;
-    close(session->fd);
-    session->fd = -1;
-
-    if (isnew && ret < 0)
-      {
-        unlink(path);
-      }
-
-errout_with_data:;
-    ftpd_dataclose(session);
 
-errout_with_path:
-    free(abspath);
+      *nbytes += wrbytes;
+    }
 
-errout:
-    return ret;
+  return ret;
 }
 
+#ifdef CONFIG_FTPD_SENDFILE
 /****************************************************************************
- * Name: ftpd_listoption
+ * Name: ftpd_sendstream
+ *
+ * Description:
+ *   Send the remainder of the open file (from the current file position,
+ *   so REST is honoured) with sendfile().  Falls back to the buffered copy
+ *   if sendfile() is not supported for this file or socket.
+ *
  ****************************************************************************/
 
-static uint8_t ftpd_listoption(FAR char **param)
+static int ftpd_sendstream(FAR struct ftpd_session_s *session,
+                           FAR off_t *nbytes)
 {
-  FAR char *ptr = *param;
-  uint8_t ret = 0;
+  struct stat st;
+  off_t remaining;
+  off_t pos;
+  ssize_t nsent;
+  int errval = 0;
 
-  while (*ptr == '-')
+  pos = lseek(session->fd, 0, SEEK_CUR);
+  if (pos < 0 || fstat(session->fd, &st) < 0)
     {
-      while (*ptr != '\0' && !isspace(*ptr))
+      return ftpd_copystream(session, 0, nbytes);
+    }
+
+  remaining = st.st_size - pos;
+  while (remaining > 0)
+    {
+      nsent = sendfile(session->data.sd, session->fd, NULL, remaining);
+      if (nsent < 0)
         {
-          switch (*ptr)
+          errval = errno;
+          if (errval == EINTR)
             {
-              case 'a':
-              case 'A':
-                ret |= FTPD_LISTOPTION_A;
-                break;
-
-              case 'l':
-              case 'L':
-                ret |= FTPD_LISTOPTION_L;
-                break;
-
-              case 'f':
-              case 'F':
-                ret |= FTPD_LISTOPTION_F;
-                break;
-
-              case 'r':
-              case 'R':
-                ret |= FTPD_LISTOPTION_R;
-                break;
-
-              default:
-                ret |= FTPD_LISTOPTION_UNKNOWN;
-                break;
+              continue;
             }
 
-          ptr++;
+          break;
         }
+      else if (nsent == 0)
+        {
+          /* The file was truncated while we were sending it */
 
-      if (*ptr != '\0')
+          break;
+        }
+
+      remaining -= nsent;
+      *nbytes   += nsent;
+    }
+
+  if (errval != 0 && errval != EINTR)
+    {
+      if (*nbytes == 0 && (errval == ENOSYS || errval == EINVAL))
         {
-          while (*ptr != '\0' && isspace(*ptr))
-            {
-              ptr++;
-            }
+          return ftpd_copystream(session, 0, nbytes);
         }
+
+      nerr("ERROR: sendfile() failed: %d\n", errval);
+      ftpd_response(session->cmd.sd, session->txtimeout,
+                    g_respfmt1, 550, ' ', "Data send error !");
+      return -errval;
     }
 
-  *param = ptr;
-  return ret;
+  ftpd_response(session->cmd.sd, session->txtimeout,
+                g_respfmt1, 226, ' ', "Transfer complete");
+  return 0;
 }
+#endif
 
+#ifdef CONFIG_FTPD_STOR_DOUBLEBUFFER
 /****************************************************************************
- * Name: fptd_listscan
+ * Name: ftpd_dbufwriter
+ *
+ * Description:
+ *   Writes the buffers filled by ftpd_recvstream() to the file so that the
+ *   next buffer can be received from the network while the previous one
+ *   is being committed to storage.
+ *
  ****************************************************************************/
 
-static int ftpd_listbuffer(FAR struct ftpd_session_s *session,
-                           FAR char *path,
-                           FAR struct stat *st, FAR char *buffer,
-                           size_t buflen, unsigned int opton)
+static FAR void *ftpd_dbufwriter(FAR void *arg)
 {
-  UNUSED(session);
+  FAR struct ftpd_dbuf_s *dbuf = (FAR struct ftpd_dbuf_s *)arg;
+  FAR const char *next;
+  size_t remaining;
+  ssize_t nwritten;
+  int index = 0;
+  int errval = 0;
+
+  pthread_mutex_lock(&dbuf->lock);
+  for (; ; )
+    {
+      while (dbuf->buflen[index] == 0 && !dbuf->eof)
+        {
+          pthread_cond_wait(&dbuf->cond, &dbuf->lock);
+        }
+
+      /* Done when the receiver has finished and everything is written */
+
+      if (dbuf->buflen[index] == 0)
+        {
+          break;
+        }
+
+      next      = dbuf->buffer[index];
+      remaining = dbuf->buflen[index];
+      pthread_mutex_unlock(&dbuf->lock);
+
+      while (remaining > 0)
+        {
+          nwritten = write(dbuf->fd, next, remaining);
+          if (nwritten < 0)
+            {
+              errval = errno;
+              if (errval == EINTR)
+                {
+                  errval = 0;
+                  continue;
+                }
+
+              break;
+            }
+
+          remaining -= nwritten;
+          next      += nwritten;
+        }
+
+      pthread_mutex_lock(&dbuf->lock);
+      if (errval != 0)
+        {
+          nerr("ERROR: write() failed: %d\n", errval);
+          dbuf->errval = errval;
+          pthread_cond_signal(&dbuf->cond);
+          break;
+        }
+
+      dbuf->buflen[index] = 0;
+      pthread_cond_signal(&dbuf->cond);
+      index ^= 1;
+    }
+
+  pthread_mutex_unlock(&dbuf->lock);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: ftpd_recvstream
+ *
+ * Description:
+ *   Receive a binary upload with two large, aligned buffers: while the
+ *   writer thread writes one buffer to the file, the next one is filled
+ *   from the data connection.
+ *
+ ****************************************************************************/
+
+static int ftpd_recvstream(FAR struct ftpd_session_s *session,
+                           FAR off_t *nbytes)
+{
+  struct ftpd_dbuf_s dbuf;
+  pthread_attr_t attr;
+  pthread_t writer;
+  FAR char *buffer;
+  size_t nrecvd;
+  ssize_t ret;
+  bool eof = false;
+  int rxerr = 0;
+  int wrerr;
+  int index = 0;
+
+  buffer = memalign(CONFIG_FTPD_STOR_BUFALIGN,
+                    2 * CONFIG_FTPD_STOR_BUFSIZE);
+  if (buffer == NULL)
+    {
+      /* Not fatal, just slower */
+
+      return ftpd_copystream(session, 1, nbytes);
+    }
+
+  memset(&dbuf, 0, sizeof(struct ftpd_dbuf_s));
+  dbuf.buffer[0] = buffer;
+  dbuf.buffer[1] = buffer + CONFIG_FTPD_STOR_BUFSIZE;
+  dbuf.fd        = session->fd;
+  pthread_mutex_init(&dbuf.lock, NULL);
+  pthread_cond_init(&dbuf.cond, NULL);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_FTPD_WORKERSTACKSIZE);
+  ret = pthread_create(&writer, &attr, ftpd_dbufwriter, &dbuf);
+  pthread_attr_destroy(&attr);
+
+  if (ret != 0)
+    {
+      nerr("ERROR: pthread_create() failed: %zd\n", ret);
+      pthread_cond_destroy(&dbuf.cond);
+      pthread_mutex_destroy(&dbuf.lock);
+      free(buffer);
+      return ftpd_copystream(session, 1, nbytes);
+    }
+
+  while (!eof && rxerr == 0)
+    {
+      /* Wait until the writer is done with this buffer */
+
+      pthread_mutex_lock(&dbuf.lock);
+      while (dbuf.buflen[index] != 0 && dbuf.errval == 0)
+        {
+          pthread_cond_wait(&dbuf.cond, &dbuf.lock);
+        }
+
+      wrerr = dbuf.errval;
+      pthread_mutex_unlock(&dbuf.lock);
+
+      if (wrerr != 0)
+        {
+          break;
+        }
+
+      /* Fill the whole buffer so that the file system sees large writes */
+
+      for (nrecvd = 0; nrecvd < CONFIG_FTPD_STOR_BUFSIZE; nrecvd += ret)
+        {
+          ret = ftpd_recv(session->data.sd, dbuf.buffer[index] + nrecvd,
+                          CONFIG_FTPD_STOR_BUFSIZE - nrecvd,
+                          session->rxtimeout);
+          if (ret <= 0)
+            {
+              eof   = (ret == 0);
+              rxerr = (ret < 0) ? (int)-ret : 0;
+              break;
+            }
+        }
+
+      if (nrecvd > 0)
+        {
+          pthread_mutex_lock(&dbuf.lock);
+          dbuf.buflen[index] = nrecvd;
+          pthread_cond_signal(&dbuf.cond);
+          pthread_mutex_unlock(&dbuf.lock);
+
+          *nbytes += nrecvd;
+          index   ^= 1;
+        }
+    }
+
+  /* Let the writer drain the remaining data and exit */
+
+  pthread_mutex_lock(&dbuf.lock);
+  dbuf.eof = true;
+  pthread_cond_signal(&dbuf.cond);
+  pthread_mutex_unlock(&dbuf.lock);
+  pthread_join(writer, NULL);
+
+  pthread_cond_destroy(&dbuf.cond);
+  pthread_mutex_destroy(&dbuf.lock);
+  free(buffer);
+
+  if (dbuf.errval != 0)
+    {
+      ftpd_response(session->cmd.sd, session->txtimeout,
+                    g_respfmt1, 550, ' ', "Data write error !");
+      return -dbuf.errval;
+    }
+
+  if (rxerr != 0)
+    {
+      nerr("ERROR: ftpd_recv() failed: %d\n", rxerr);
+      ftpd_response(session->cmd.sd, session->txtimeout,
+                    g_respfmt1, 550, ' ', "Data read error !");
+      return -rxerr;
+    }
+
+  ftpd_response(session->cmd.sd, session->txtimeout,
+                g_respfmt1, 226, ' ', "Transfer complete");
+  return 0;
+}
+#endif
+
+/****************************************************************************
+ * Name: ftpd_stream
+ ****************************************************************************/
+
+static int ftpd_stream(FAR struct ftpd_session_s *session, int cmdtype)
+{
+  FAR char *abspath;
+  FAR char *path;
+  bool isnew;
+  int oflags;
+  uint32_t start;
+  off_t nbytes;
+  int errval = 0;
+  int ret;
+
+  ret = ftpd_getpath(session, session->param, &abspath, NULL);
+  if (ret < 0)
+    {
+      ftpd_response(session->cmd.sd, session->txtimeout,
+                    g_respfmt1, 550, ' ', "Stream error !");
+      goto errout;
+    }
+
+  path = abspath;
+
+  ret = ftpd_dataopen(session);
+  if (ret < 0)
+    {
+      goto errout_with_path;
+    }
+
+  switch (cmdtype)
+    {
+      case 0: /* retr */
+        oflags = O_RDONLY;
+        break;
+
+      case 1: /* stor */
+        oflags = O_CREAT | O_WRONLY;
+         break;
+
+      case 2: /* appe */
+        oflags = O_CREAT | O_WRONLY | O_APPEND;
+        break;
+
+      default:
+        oflags = O_RDONLY;
+        break;
+    }
+
+#if defined(O_LARGEFILE)
+  oflags |= O_LARGEFILE;
+#endif
+
+  /* Are we creating the file? */
+
+  if ((oflags & O_CREAT) != 0)
+    {
+      int mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH;
+
+      if (session->restartpos <= 0)
+        {
+          oflags |= O_TRUNC;
+        }
+
+      isnew = true;
+      session->fd = open(path, oflags | O_EXCL, mode);
+      if (session->fd < 0)
+        {
+          isnew = false;
+          session->fd = open(path, oflags, mode);
+        }
+    }
+  else
+    {
+      /* No.. we are opening an existing file */
+
+      isnew = false;
+      session->fd = open(path, oflags);
+    }
+
+  if (session->fd < 0)
+    {
+      ret = -errno;
+      ftpd_response(session->cmd.sd, session->txtimeout,
+                    g_respfmt1, 550, ' ', "Can not open file !");
+      goto errout_with_data;
+    }
+
+  /* Restart position */
+
+  if (session->restartpos > 0)
+    {
+      off_t seekoffs = (off_t)-1;
+      off_t seekpos;
+
+      /* Get the seek position */
+
+      if (session->type == FTPD_SESSIONTYPE_A)
+        {
+          seekpos = ftpd_offsatoi(path, session->restartpos);
+          if (seekpos < 0)
+            {
+              nerr("ERROR: ftpd_offsatoi failed: %jd\n", (intmax_t)seekpos);
+              errval = -seekpos;
+            }
+        }
+      else
+        {
+          seekpos = session->restartpos;
+          if (seekpos < 0)
+            {
+              nerr("ERROR: Bad restartpos: %jd\n", (intmax_t)seekpos);
+              errval = EINVAL;
+            }
+        }
+
+      /* Seek to the request position */
+
+      if (seekpos >= 0)
+        {
+          seekoffs = lseek(session->fd, seekpos, SEEK_SET);
+          if (seekoffs < 0)
+            {
+              errval = errno;
+              nerr("ERROR: lseek failed: %d\n", errval);
+            }
+        }
+
+      /* Report errors.  If an error occurred, seekoffs will be negative and
+       * errval will hold the (positive) error code.
+       */
+
+      if (seekoffs < 0)
+        {
+          ftpd_response(session->cmd.sd, session->txtimeout,
+                        g_respfmt1, 550, ' ', "Can not seek file !");
+          ret = -errval;
+          goto errout_with_session;
+        }
+    }
+
+  /* Send success message */
+
+  ret = ftpd_response(session->cmd.sd, session->txtimeout,
+                      g_respfmt1, 150, ' ', "Opening data connection");
+  if (ret < 0)
+    {
+      nerr("ERROR: ftpd_response failed: %d\n", ret);
+      goto errout_with_session;
+    }
+
+  /* Move the data */
+
+  start  = ftpd_msecs();
+  nbytes = 0;
+
+#ifdef CONFIG_FTPD_SENDFILE
+  if (cmdtype == 0 && session->type != FTPD_SESSIONTYPE_A)
+    {
+      ret = ftpd_sendstream(session, &nbytes);
+    }
+  else
+#endif
+#ifdef CONFIG_FTPD_STOR_DOUBLEBUFFER
+  if (cmdtype != 0 && session->type != FTPD_SESSIONTYPE_A)
+    {
+      ret = ftpd_recvstream(session, &nbytes);
+    }
+  else
+#endif
+    {
+      ret = ftpd_copystream(session, cmdtype, &nbytes);
+    }
+
+  /* Remember the throughput of the transfer for SITE STAT */
+
+  if (ret >= 0)
+    {
+      session->xfercmd   = cmdtype == 0 ? "RETR" :
+                           cmdtype == 1 ? "STOR" : "APPE";
+      session->xferbytes = nbytes;
+      session->xfermsecs = ftpd_msecs() - start;
+    }
+
+errout_with_session:;
+    close(session->fd);
+    session->fd = -1;
+
+    if (isnew && ret < 0)
+      {
+        unlink(path);
+      }
+
+    if (cmdtype != 0)
+      {
+        ftpd_listinvalidate(session, path);
+      }
+
+errout_with_data:;
+    ftpd_dataclose(session);
+
+errout_with_path:
+    free(abspath);
+
+errout:
+    return ret;
+}
+
+/****************************************************************************
+ * Name: ftpd_listoption
+ ****************************************************************************/
+
+static uint8_t ftpd_listoption(FAR char **param)
+{
+  FAR char *ptr = *param;
+  uint8_t ret = 0;
+
+  while (*ptr == '-')
+    {
+      while (*ptr != '\0' && !isspace(*ptr))
+        {
+          switch (*ptr)
+            {
+              case 'a':
+              case 'A':
+                ret |= FTPD_LISTOPTION_A;
+                break;
+
+              case 'l':
+              case 'L':
+                ret |= FTPD_LISTOPTION_L;
+                break;
+
+              case 'f':
+              case 'F':
+                ret |= FTPD_LISTOPTION_F;
+                break;
+
+              case 'r':
+              case 'R':
+                ret |= FTPD_LISTOPTION_R;
+                break;
+
+              default:
+                ret |= FTPD_LISTOPTION_UNKNOWN;
+                break;
+            }
+
+          ptr++;
+        }
+
+      if (*ptr != '\0')
+        {
+          while (*ptr != '\0' && isspace(*ptr))
+            {
+              ptr++;
+            }
+        }
+    }
+
+  *param = ptr;
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fptd_listscan
+ ****************************************************************************/
+
+static int ftpd_listbuffer(FAR struct ftpd_session_s *session,
+                           FAR char *path,
+                           FAR struct stat *st, FAR char *buffer,
+                           size_t buflen, unsigned int opton)
+{
+  UNUSED(session);
 
   FAR char *name;
   size_t offset = 0;
@@ -2313,59 +2725,312 @@ static int ftpd_listbuffer(FAR struct ftpd_session_s *session,
       now = time(0);
       if ((now - st->st_mtime) > (time_t)(60 * 60 * 24 * 180))
         {
-          offset += snprintf(&buffer[offset], buflen - offset, " %5u",
-                             tm.tm_year + 1900);
+          offset += snprintf(&buffer[offset], buflen - offset, " %5u",
+                             tm.tm_year + 1900);
+        }
+      else
+        {
+          offset += snprintf(&buffer[offset], buflen - offset, " %02u:%02u",
+                             tm.tm_hour, tm.tm_min);
+        }
+
+      /* basename */
+
+      offset += snprintf(&buffer[offset], buflen - offset, " %s", name);
+
+      /* linkname */
+
+#ifndef __NuttX__
+      if (S_ISLNK(st->st_mode) != 0)
+        {
+          FAR char *temp;
+          int namelen;
+
+          temp = (FAR char *)malloc(PATH_MAX + 1);
+          if (temp != NULL)
+            {
+              namelen = readlink(path, temp, PATH_MAX);
+              if (namelen != -1)
+                {
+                  temp[namelen] = '\0';
+                }
+
+              offset += snprintf(&buffer[offset], buflen - offset,
+                                 " -> %s", temp);
+              free(temp);
+            }
+        }
+#endif
+
+      /* end */
+
+      offset += snprintf(&buffer[offset], buflen - offset, "\r\n");
+    }
+  else
+    {
+      /* basename */
+
+      offset += snprintf(&buffer[offset], buflen - offset, "%s\r\n", name);
+    }
+
+  return 0;
+}
+
+#ifdef CONFIG_FTPD_LISTCACHE
+/****************************************************************************
+ * Name: ftpd_listentry_free
+ ****************************************************************************/
+
+static void ftpd_listentry_free(FAR struct ftpd_listentry_s *entry)
+{
+  free(entry->path);
+  free(entry->text);
+  free(entry);
+}
+
+/****************************************************************************
+ * Name: ftpd_listcache_get
+ *
+ * Description:
+ *   Look up the listing of a directory.  The directory modification time
+ *   is compared as well so that changes made behind the server's back are
+ *   noticed on file systems that maintain it.  Returns an entry with a
+ *   reference held or NULL.
+ *
+ ****************************************************************************/
+
+static FAR struct ftpd_listentry_s *
+ftpd_listcache_get(FAR struct ftpd_listcache_s *cache, FAR const char *path,
+                   unsigned int opton, time_t mtime)
+{
+  FAR struct ftpd_listentry_s *entry;
+  int i;
+
+  pthread_mutex_lock(&cache->lock);
+  for (i = 0; i < CONFIG_FTPD_LISTCACHE_ENTRIES; i++)
+    {
+      entry = cache->entries[i];
+      if (entry != NULL && entry->opton == opton &&
+          strcmp(entry->path, path) == 0)
+        {
+          if (entry->mtime != mtime)
+            {
+              ftpd_listcache_drop(cache, i);
+              break;
+            }
+
+          entry->lastuse = ++cache->clock;
+          entry->refs++;
+          pthread_mutex_unlock(&cache->lock);
+          return entry;
+        }
+    }
+
+  pthread_mutex_unlock(&cache->lock);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: ftpd_listcache_put
+ ****************************************************************************/
+
+static void ftpd_listcache_put(FAR struct ftpd_listcache_s *cache,
+                               FAR struct ftpd_listentry_s *entry)
+{
+  bool release;
+
+  pthread_mutex_lock(&cache->lock);
+  release = (--entry->refs == 0 && entry->orphan);
+  pthread_mutex_unlock(&cache->lock);
+
+  if (release)
+    {
+      ftpd_listentry_free(entry);
+    }
+}
+
+/****************************************************************************
+ * Name: ftpd_listcache_add
+ *
+ * Description:
+ *   Add a freshly scanned listing, replacing the least recently used
+ *   entry if the cache is full.  Ownership of text passes to the cache.
+ *
+ ****************************************************************************/
+
+static void ftpd_listcache_add(FAR struct ftpd_listcache_s *cache,
+                               FAR const char *path, unsigned int opton,
+                               time_t mtime, FAR char *text, size_t len)
+{
+  FAR struct ftpd_listentry_s *entry;
+  int victim = -1;
+  int i;
+
+  entry = (FAR struct ftpd_listentry_s *)
+    zalloc(sizeof(struct ftpd_listentry_s));
+  if (entry == NULL)
+    {
+      free(text);
+      return;
+    }
+
+  entry->path = strdup(path);
+  if (entry->path == NULL)
+    {
+      free(text);
+      free(entry);
+      return;
+    }
+
+  entry->opton = opton;
+  entry->mtime = mtime;
+  entry->text  = text;
+  entry->len   = len;
+
+  pthread_mutex_lock(&cache->lock);
+
+  /* Another session may have scanned the same directory meanwhile */
+
+  for (i = 0; i < CONFIG_FTPD_LISTCACHE_ENTRIES; i++)
+    {
+      if (cache->entries[i] != NULL && cache->entries[i]->opton == opton &&
+          strcmp(cache->entries[i]->path, path) == 0)
+        {
+          ftpd_listcache_drop(cache, i);
+        }
+    }
+
+  for (i = 0; i < CONFIG_FTPD_LISTCACHE_ENTRIES; i++)
+    {
+      if (cache->entries[i] == NULL)
+        {
+          victim = i;
+          break;
         }
-      else
+
+      if (victim < 0 ||
+          (int32_t)(cache->entries[i]->lastuse -
+                    cache->entries[victim]->lastuse) < 0)
         {
-          offset += snprintf(&buffer[offset], buflen - offset, " %02u:%02u",
-                             tm.tm_hour, tm.tm_min);
+          victim = i;
         }
+    }
 
-      /* basename */
+  if (cache->entries[victim] != NULL)
+    {
+      ftpd_listcache_drop(cache, victim);
+    }
 
-      offset += snprintf(&buffer[offset], buflen - offset, " %s", name);
+  entry->lastuse          = ++cache->clock;
+  cache->entries[victim] = entry;
+  pthread_mutex_unlock(&cache->lock);
+}
 
-      /* linkname */
+/****************************************************************************
+ * Name: ftpd_listcache_drop
+ *
+ * Description:
+ *   Remove an entry from the cache.  Called with the cache lock held.
+ *
+ ****************************************************************************/
 
-#ifndef __NuttX__
-      if (S_ISLNK(st->st_mode) != 0)
-        {
-          FAR char *temp;
-          int namelen;
+static void ftpd_listcache_drop(FAR struct ftpd_listcache_s *cache,
+                                int index)
+{
+  FAR struct ftpd_listentry_s *entry = cache->entries[index];
 
-          temp = (FAR char *)malloc(PATH_MAX + 1);
-          if (temp != NULL)
-            {
-              namelen = readlink(path, temp, PATH_MAX);
-              if (namelen != -1)
-                {
-                  temp[namelen] = '\0';
-                }
+  cache->entries[index] = NULL;
+  if (entry->refs > 0)
+    {
+      entry->orphan = true;
+    }
+  else
+    {
+      ftpd_listentry_free(entry);
+    }
+}
 
-              offset += snprintf(&buffer[offset], buflen - offset,
-                                 " -> %s", temp);
-              free(temp);
-            }
+/****************************************************************************
+ * Name: ftpd_listcache_free
+ ****************************************************************************/
+
+static void ftpd_listcache_free(FAR struct ftpd_listcache_s *cache)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_FTPD_LISTCACHE_ENTRIES; i++)
+    {
+      if (cache->entries[i] != NULL)
+        {
+          ftpd_listcache_drop(cache, i);
         }
-#endif
+    }
 
-      /* end */
+  pthread_mutex_destroy(&cache->lock);
+  free(cache);
+}
+#endif /* CONFIG_FTPD_LISTCACHE */
 
-      offset += snprintf(&buffer[offset], buflen - offset, "\r\n");
+/****************************************************************************
+ * Name: ftpd_listinvalidate
+ *
+ * Description:
+ *   Forget the cached listings affected by a change to path: the listing
+ *   of path itself (if it is a directory) and that of its parent.
+ *
+ ****************************************************************************/
+
+static void ftpd_listinvalidate(FAR struct ftpd_session_s *session,
+                                FAR const char *path)
+{
+#ifdef CONFIG_FTPD_LISTCACHE
+  FAR struct ftpd_listcache_s *cache = session->server->listcache;
+  FAR char *parent;
+  FAR char *copy;
+  int i;
+
+  if (cache == NULL)
+    {
+      return;
     }
-  else
+
+  copy = strdup(path);
+  parent = copy != NULL ? dirname(copy) : NULL;
+
+  pthread_mutex_lock(&cache->lock);
+  for (i = 0; i < CONFIG_FTPD_LISTCACHE_ENTRIES; i++)
     {
-      /* basename */
+      FAR struct ftpd_listentry_s *entry = cache->entries[i];
 
-      offset += snprintf(&buffer[offset], buflen - offset, "%s\r\n", name);
+      /* Without the parent name, be conservative and drop everything */
+
+      if (entry != NULL &&
+          (parent == NULL || strcmp(entry->path, path) == 0 ||
+           strcmp(entry->path, parent) == 0))
+        {
+          ftpd_listcache_drop(cache, i);
+        }
     }
 
-  return 0;
+  pthread_mutex_unlock(&cache->lock);
+  free(copy);
+#else
+  UNUSED(session);
+  UNUSED(path);
+#endif
 }
 
 /****************************************************************************
  * Name: fptd_listscan
+ *
+ * Description:
+ *   Send the listing of path over the data connection.  Lines are batched
+ *   in the session data buffer and sent whenever it fills up, so that the
+ *   client sees the first entries long before a large directory has been
+ *   completely scanned.  With CONFIG_FTPD_LISTCACHE the formatted listing
+ *   is also kept so that repeated listings need neither readdir() nor
+ *   stat().
+ *
  ****************************************************************************/
 
 static int fptd_listscan(FAR struct ftpd_session_s *session, FAR char *path,
@@ -2375,7 +3040,17 @@ static int fptd_listscan(FAR struct ftpd_session_s *session, FAR char *path,
   DIR *dir;
   struct dirent *entry;
   struct stat st;
+  size_t used = 0;
+  size_t len;
   int ret;
+#ifdef CONFIG_FTPD_LISTCACHE
+  FAR struct ftpd_listcache_s *cache = session->server->listcache;
+  FAR struct ftpd_listentry_s *cached;
+  FAR char *text = NULL;
+  size_t textlen = 0;
+  size_t textsize = 0;
+  time_t mtime;
+#endif
 
   ret = stat(path, &st);
   if (ret < 0)
@@ -2396,6 +3071,21 @@ static int fptd_listscan(FAR struct ftpd_session_s *session, FAR char *path,
       return ret;
     }
 
+#ifdef CONFIG_FTPD_LISTCACHE
+  mtime = st.st_mtime;
+  if (cache != NULL)
+    {
+      cached = ftpd_listcache_get(cache, path, opton, mtime);
+      if (cached != NULL)
+        {
+          ret = ftpd_send(session->data.sd, cached->text, cached->len,
+                          session->txtimeout);
+          ftpd_listcache_put(cache, cached);
+          return ret < 0 ? ret : 0;
+        }
+    }
+#endif
+
   dir = opendir(path);
   if (dir == NULL)
     {
@@ -2423,6 +3113,7 @@ static int fptd_listscan(FAR struct ftpd_session_s *session, FAR char *path,
       ret = asprintf(&temp, "%s/%s", path, entry->d_name);
       if (ret < 0)
         {
+          ret = 0;
           continue;
         }
 
@@ -2430,15 +3121,29 @@ static int fptd_listscan(FAR struct ftpd_session_s *session, FAR char *path,
       if (ret < 0)
         {
           free(temp);
+          ret = 0;
           continue;
         }
 
-      ret = ftpd_listbuffer(session, temp, &st, session->data.buffer,
-                            session->data.buflen, opton);
-      if (ret >= 0)
+      /* Format the line behind the ones already batched.  If it might not
+       * fit, send the batch first and format it again at the start.
+       */
+
+      ret = ftpd_listbuffer(session, temp, &st, &session->data.buffer[used],
+                            session->data.buflen - used, opton);
+      len = strlen(&session->data.buffer[used]);
+      if (ret >= 0 && used > 0 && used + len + 1 >= session->data.buflen)
         {
-          ret = ftpd_response(session->data.sd, session->txtimeout,
-                              "%s", session->data.buffer);
+          ret = ftpd_send(session->data.sd, session->data.buffer, used,
+                          session->txtimeout);
+          used = 0;
+          if (ret >= 0)
+            {
+              ret = ftpd_listbuffer(session, temp, &st,
+                                    session->data.buffer,
+                                    session->data.buflen, opton);
+              len = strlen(session->data.buffer);
+            }
         }
 
       free(temp);
@@ -2446,10 +3151,75 @@ static int fptd_listscan(FAR struct ftpd_session_s *session, FAR char *path,
         {
           break;
         }
+
+#ifdef CONFIG_FTPD_LISTCACHE
+      /* Keep a copy of the line unless the listing has grown too large */
+
+      if (cache != NULL && textsize != SIZE_MAX)
+        {
+          if (textlen + len > CONFIG_FTPD_LISTCACHE_MAXSIZE)
+            {
+              free(text);
+              text     = NULL;
+              textsize = SIZE_MAX;
+            }
+          else if (textlen + len > textsize)
+            {
+              FAR char *newtext;
+              size_t newsize = textsize > 0 ? 2 * textsize : 512;
+
+              while (newsize < textlen + len)
+                {
+                  newsize *= 2;
+                }
+
+              newtext = (FAR char *)realloc(text, newsize);
+              if (newtext == NULL)
+                {
+                  free(text);
+                  text     = NULL;
+                  textsize = SIZE_MAX;
+                }
+              else
+                {
+                  text     = newtext;
+                  textsize = newsize;
+                }
+            }
+
+          if (text != NULL)
+            {
+              memcpy(&text[textlen], &session->data.buffer[used], len);
+              textlen += len;
+            }
+        }
+#endif
+
+      used += len;
     }
 
   closedir(dir);
-  return ret;
+
+  /* Send whatever is still batched */
+
+  if (ret >= 0 && used > 0)
+    {
+      ret = ftpd_send(session->data.sd, session->data.buffer, used,
+                      session->txtimeout);
+    }
+
+#ifdef CONFIG_FTPD_LISTCACHE
+  if (ret >= 0 && text != NULL)
+    {
+      ftpd_listcache_add(cache, path, opton, mtime, text, textlen);
+    }
+  else
+    {
+      free(text);
+    }
+#endif
+
+  return ret < 0 ? ret : 0;
 }
 
 /****************************************************************************
@@ -3048,6 +3818,7 @@ static int ftpd_command_rmd(FAR struct ftpd_session_s *session)
       return ret;
     }
 
+  ftpd_listinvalidate(session, abspath);
   free(abspath);
   free(workpath);
 
@@ -3085,6 +3856,7 @@ static int ftpd_command_mkd(FAR struct ftpd_session_s *session)
       return ret;
     }
 
+  ftpd_listinvalidate(session, abspath);
   free(abspath);
   return ftpd_response(session->cmd.sd, session->txtimeout,
                        g_respfmt1, 250, ' ', "MKD command successful");
@@ -3142,6 +3914,7 @@ static int ftpd_command_dele(FAR struct ftpd_session_s *session)
       return ret;
     }
 
+  ftpd_listinvalidate(session, abspath);
   free(abspath);
   free(workpath);
 
@@ -3699,6 +4472,8 @@ static int ftpd_command_rnto(FAR struct ftpd_session_s *session)
       return ret;
     }
 
+  ftpd_listinvalidate(session, session->renamefrom);
+  ftpd_listinvalidate(session, abspath);
   free(abspath);
   return ftpd_response(session->cmd.sd, session->txtimeout,
                        g_respfmt1, 250, ' ', "Rename successful");
@@ -3882,9 +4657,36 @@ static int ftpd_command_opts(FAR struct ftpd_session_s *session)
 
 static int ftpd_command_site(FAR struct ftpd_session_s *session)
 {
+  uint32_t msecs;
+  uint32_t rate;
+
+  if (strcasecmp(session->param, "STAT") != 0)
+    {
+      return ftpd_response(session->cmd.sd, session->txtimeout,
+                           g_respfmt1, 502, ' ',
+                           "SITE command not implemented !");
+    }
+
+  /* SITE STAT: Report the throughput of the last completed transfer */
+
+  if (session->xfercmd == NULL)
+    {
+      return ftpd_response(session->cmd.sd, session->txtimeout,
+                           g_respfmt1, 211, ' ', "No transfer completed");
+    }
+
+  /* Rate in units of 10KB/s (1MB = 1000000 bytes) */
+
+  msecs = session->xfermsecs > 0 ? session->xfermsecs : 1;
+  rate  = (uint32_t)(((uint64_t)session->xferbytes * 1000 / msecs) / 10000);
+
   return ftpd_response(session->cmd.sd, session->txtimeout,
-                       g_respfmt1, 502, ' ',
-                       "SITE command not implemented !");
+                       "%03u%c%s %jd bytes in %" PRIu32 ".%03" PRIu32
+                       " s (%" PRIu32 ".%02" PRIu32 " MB/s)\r\n",
+                       211, ' ', session->xfercmd,
+                       (intmax_t)session->xferbytes,
+                       session->xfermsecs / 1000, session->xfermsecs % 1000,
+                       rate / 100, rate % 100);
 }
 
 /****************************************************************************
@@ -4061,191 +4863,574 @@ static void ftpd_freesession(FAR struct ftpd_session_s *session)
       free(session->user);
     }
 
-  if (session->fd >= 0)
+  if (session->fd >= 0)
+    {
+      close(session->fd);
+    }
+
+  if (session->data.buffer != NULL)
+    {
+      free(session->data.buffer);
+    }
+
+  ftpd_dataclose(session);
+
+  if (session->cmd.buffer != NULL)
+    {
+      free(session->cmd.buffer);
+    }
+
+  if (session->cmd.sd >= 0)
+    {
+      close(session->cmd.sd);
+    }
+
+  free(session);
+}
+
+/****************************************************************************
+ * Name: ftpd_workersetup
+ ****************************************************************************/
+
+static void ftpd_workersetup(FAR struct ftpd_session_s *session)
+{
+  UNUSED(session);
+
+#if defined(CONFIG_NET_HAVE_IPTOS) || defined(CONFIG_NET_HAVE_OOBINLINE)
+  int temp;
+#endif
+#ifdef CONFIG_NET_SOLINGER
+  struct linger ling;
+#endif
+
+#ifdef CONFIG_NET_HAVE_IPTOS
+  temp = IPTOS_LOWDELAY;
+  setsockopt(session->cmd.sd, IPPROTO_IP, IP_TOS, &temp, sizeof(temp));
+#endif
+
+#ifdef CONFIG_NET_HAVE_OOBINLINE
+  temp = 1;
+  setsockopt(session->cmd.sd, SOL_SOCKET, SO_OOBINLINE, &temp, sizeof(temp));
+#endif
+
+#ifdef CONFIG_NET_SOLINGER
+  memset(&ling, 0, sizeof(ling));
+  ling.l_onoff = 1;
+  ling.l_linger = 4;
+  setsockopt(session->cmd.sd, SOL_SOCKET, SO_LINGER, &ling, sizeof(ling));
+#endif
+}
+
+/****************************************************************************
+ * Name: ftpd_greeting
+ *
+ * Description:
+ *   Configure the session sockets and send the welcoming message.
+ *
+ ****************************************************************************/
+
+static int ftpd_greeting(FAR struct ftpd_session_s *session)
+{
+  int ret;
+
+  /* Configure the session sockets */
+
+  ftpd_workersetup(session);
+
+  /* Send the welcoming message */
+
+  ret = ftpd_response(session->cmd.sd, session->txtimeout,
+                      g_respfmt1, 220, ' ', CONFIG_FTPD_SERVERID);
+  if (ret < 0)
+    {
+      nerr("ERROR: ftpd_response() failed: %d\n", ret);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: ftpd_process
+ *
+ * Description:
+ *   Receive one chunk of the command stream from the control connection
+ *   and execute the command that it contains.
+ *
+ * Returned Value:
+ *   Zero if the session should continue; a negated errno value if the
+ *   connection was lost or the command handler asked to disconnect.
+ *
+ ****************************************************************************/
+
+static int ftpd_process(FAR struct ftpd_session_s *session)
+{
+  ssize_t recvbytes;
+  size_t offset;
+  uint8_t ch;
+  int ret;
+
+  /* Receive the next command */
+
+  recvbytes = ftpd_recv(session->cmd.sd, session->cmd.buffer,
+                        session->cmd.buflen - 1, session->rxtimeout);
+
+  /* recbytes < 0 is a receive failure (posibily a timeout);
+   * recbytes == 0 indicates that we have lost the connection.
+   */
+
+  if (recvbytes <= 0)
+    {
+      return recvbytes < 0 ? (int)recvbytes : -ENOTCONN;
+    }
+
+  /* Make sure that the received string is NUL terminated */
+
+  session->cmd.buffer[recvbytes] = '\0';
+
+  /* TELNET protocol (RFC854)
+   *   IAC   255(FFH) interpret as command:
+   *   IP    244(F4H) interrupt process--permanently
+   *   DM    242(F2H) data mark--for connect. cleaning
+   */
+
+  offset = 0;
+  while (recvbytes > 0)
+    {
+      ch = session->cmd.buffer[offset];
+      if (ch != 0xff && ch != 0xf4 && ch != 0xf2)
+        {
+          break;
+        }
+
+      ftpd_send(session->cmd.sd, &session->cmd.buffer[offset], 1,
+                session->txtimeout);
+
+      offset++;
+      recvbytes--;
+    }
+
+  /* Just continue if there was nothing of interest in the packet */
+
+  if (recvbytes <= 0)
     {
-      close(session->fd);
+      return OK;
     }
 
-  if (session->data.buffer != NULL)
+  /* Make command message */
+
+  session->command = &session->cmd.buffer[offset];
+  while (session->cmd.buffer[offset] != '\0')
     {
-      free(session->data.buffer);
+      if (session->cmd.buffer[offset] == '\r' &&
+          session->cmd.buffer[offset + ((ssize_t)1)] == '\n')
+        {
+          session->cmd.buffer[offset] = '\0';
+          break;
+        }
+
+      offset++;
     }
 
-  ftpd_dataclose(session);
+  /* Parse command and param tokens */
 
-  if (session->cmd.buffer != NULL)
+  session->param   = session->command;
+  session->command = ftpd_strtok(true, " \t", &session->param);
+
+  /* Unlike the "real" strtok, ftpd_strtok does not NUL-terminate
+   * the returned string.
+   */
+
+  if (session->param[0] != '\0')
     {
-      free(session->cmd.buffer);
+      session->param[0] = '\0';
+      session->param++;
     }
 
-  if (session->cmd.sd >= 0)
+  /* Dispatch the FTP command */
+
+  ret = ftpd_command(session);
+  if (ret < 0)
     {
-      close(session->cmd.sd);
+      nerr("ERROR: Disconnected by the command handler: %d\n", ret);
+      return ret;
     }
 
-  free(session);
+  return OK;
 }
 
 /****************************************************************************
- * Name: ftpd_workersetup
+ * Name: ftpd_worker
  ****************************************************************************/
 
-static void ftpd_workersetup(FAR struct ftpd_session_s *session)
+static FAR void *ftpd_worker(FAR void *arg)
 {
-  UNUSED(session);
+  FAR struct ftpd_session_s *session = (FAR struct ftpd_session_s *)arg;
 
-#if defined(CONFIG_NET_HAVE_IPTOS) || defined(CONFIG_NET_HAVE_OOBINLINE)
-  int temp;
-#endif
-#ifdef CONFIG_NET_SOLINGER
-  struct linger ling;
-#endif
+  ninfo("Worker started\n");
+  DEBUGASSERT(session);
 
-#ifdef CONFIG_NET_HAVE_IPTOS
-  temp = IPTOS_LOWDELAY;
-  setsockopt(session->cmd.sd, IPPROTO_IP, IP_TOS, &temp, sizeof(temp));
-#endif
+  if (ftpd_greeting(session) >= 0)
+    {
+      /* Then loop processing FTP commands */
 
-#ifdef CONFIG_NET_HAVE_OOBINLINE
-  temp = 1;
-  setsockopt(session->cmd.sd, SOL_SOCKET, SO_OOBINLINE, &temp, sizeof(temp));
-#endif
+      while (ftpd_process(session) >= 0);
+    }
 
-#ifdef CONFIG_NET_SOLINGER
-  memset(&ling, 0, sizeof(ling));
-  ling.l_onoff = 1;
-  ling.l_linger = 4;
-  setsockopt(session->cmd.sd, SOL_SOCKET, SO_LINGER, &ling, sizeof(ling));
-#endif
+  ftpd_freesession(session);
+  return NULL;
 }
 
+#ifdef CONFIG_FTPD_MUX
 /****************************************************************************
- * Name: ftpd_worker
+ * Name: ftpd_muxwakeup
+ *
+ * Description:
+ *   Make the multiplexer thread rebuild its poll set.  Called with the mux
+ *   lock held.
+ *
  ****************************************************************************/
 
-static FAR void *ftpd_worker(FAR void *arg)
+static void ftpd_muxwakeup(FAR struct ftpd_mux_s *mux)
 {
-  FAR struct ftpd_session_s *session = (FAR struct ftpd_session_s *)arg;
-  ssize_t recvbytes;
-  size_t offset;
-  uint8_t ch;
-  int ret;
-
-  ninfo("Worker started\n");
-  DEBUGASSERT(session);
+  char ch = 0;
 
-  /* Configure the session sockets */
+  write(mux->pipefd[1], &ch, 1);
+}
 
-  ftpd_workersetup(session);
+/****************************************************************************
+ * Name: ftpd_muxremove
+ *
+ * Description:
+ *   Remove a session from the session table.  Called with the mux lock
+ *   held.
+ *
+ ****************************************************************************/
 
-  /* Send the welcoming message */
+static void ftpd_muxremove(FAR struct ftpd_mux_s *mux,
+                           FAR struct ftpd_session_s *session)
+{
+  int i;
 
-  ret = ftpd_response(session->cmd.sd, session->txtimeout,
-                      g_respfmt1, 220, ' ', CONFIG_FTPD_SERVERID);
-  if (ret < 0)
+  for (i = 0; i < mux->nsessions; i++)
     {
-      nerr("ERROR: ftpd_response() failed: %d\n", ret);
-      ftpd_freesession(session);
-      return NULL;
+      if (mux->sessions[i] == session)
+        {
+          mux->sessions[i] = mux->sessions[--mux->nsessions];
+          break;
+        }
     }
+}
+
+/****************************************************************************
+ * Name: ftpd_muxthread
+ *
+ * Description:
+ *   Wait for command traffic on the control connections of all idle
+ *   sessions with a single poll() and hand the sessions that have input to
+ *   the worker pool.  The first poll entry is the wakeup pipe that workers
+ *   use to return sessions to the poll set.
+ *
+ ****************************************************************************/
+
+static FAR void *ftpd_muxthread(FAR void *arg)
+{
+  FAR struct ftpd_mux_s *mux = (FAR struct ftpd_mux_s *)arg;
+  FAR struct ftpd_session_s *polled[CONFIG_FTPD_MUX_MAXSESSIONS];
+  char drain[8];
+  int npolled;
+  int ret;
+  int i;
 
-  /* Then loop processing FTP commands */
+  ninfo("Multiplexer started\n");
 
-  for (; ; )
+  pthread_mutex_lock(&mux->lock);
+  while (!mux->stop)
     {
-      /* Receive the next command */
+      /* Build the poll set from the sessions that are not being served */
 
-      recvbytes = ftpd_recv(session->cmd.sd, session->cmd.buffer,
-                            session->cmd.buflen - 1, session->rxtimeout);
-
-      /* recbytes < 0 is a receive failure (posibily a timeout);
-       * recbytes == 0 indicates that we have lost the connection.
-       */
+      mux->pollfds[0].fd     = mux->pipefd[0];
+      mux->pollfds[0].events = POLLIN;
 
-      if (recvbytes <= 0)
+      for (i = 0, npolled = 0; i < mux->nsessions; i++)
         {
-          /* Break out of the server loop */
-
-          break;
+          if (!mux->sessions[i]->busy)
+            {
+              polled[npolled] = mux->sessions[i];
+              mux->pollfds[npolled + 1].fd      = mux->sessions[i]->cmd.sd;
+              mux->pollfds[npolled + 1].events  = POLLIN;
+              mux->pollfds[npolled + 1].revents = 0;
+              npolled++;
+            }
         }
 
-      /* Make sure that the received string is NUL terminated */
+      mux->pollfds[0].revents = 0;
+      pthread_mutex_unlock(&mux->lock);
 
-      session->cmd.buffer[recvbytes] = '\0';
+      ret = poll(mux->pollfds, npolled + 1, -1);
 
-      /* TELNET protocol (RFC854)
-       *   IAC   255(FFH) interpret as command:
-       *   IP    244(F4H) interrupt process--permanently
-       *   DM    242(F2H) data mark--for connect. cleaning
-       */
-
-      offset = 0;
-      while (recvbytes > 0)
+      pthread_mutex_lock(&mux->lock);
+      if (ret < 0)
         {
-          ch = session->cmd.buffer[offset];
-          if (ch != 0xff && ch != 0xf4 && ch != 0xf2)
+          if (errno != EINTR)
             {
+              nerr("ERROR: poll() failed: %d\n", errno);
               break;
             }
 
-          ftpd_send(session->cmd.sd, &session->cmd.buffer[offset], 1,
-                    session->txtimeout);
-
-          offset++;
-          recvbytes--;
+          continue;
         }
 
-      /* Just continue if there was nothing of interest in the packet */
-
-      if (recvbytes <= 0)
+      if (mux->pollfds[0].revents & POLLIN)
         {
-          continue;
+          read(mux->pipefd[0], drain, sizeof(drain));
         }
 
-      /* Make command message */
+      /* Queue every session with input (or a hang-up) for the workers */
 
-      session->command = &session->cmd.buffer[offset];
-      while (session->cmd.buffer[offset] != '\0')
+      for (i = 0; i < npolled; i++)
         {
-          if (session->cmd.buffer[offset] == '\r' &&
-              session->cmd.buffer[offset + ((ssize_t)1)] == '\n')
+          if (mux->pollfds[i + 1].revents != 0)
             {
-              session->cmd.buffer[offset] = '\0';
-              break;
+              polled[i]->busy = true;
+              mux->queue[(mux->qhead + mux->qcount) %
+                         CONFIG_FTPD_MUX_MAXSESSIONS] = polled[i];
+              mux->qcount++;
+              pthread_cond_signal(&mux->cond);
             }
-
-          offset++;
         }
+    }
 
-      /* Parse command and param tokens */
+  mux->stop = true;
+  pthread_cond_broadcast(&mux->cond);
+  pthread_mutex_unlock(&mux->lock);
+  return NULL;
+}
 
-      session->param   = session->command;
-      session->command = ftpd_strtok(true, " \t", &session->param);
+/****************************************************************************
+ * Name: ftpd_muxworker
+ *
+ * Description:
+ *   One thread of the worker pool.  Takes sessions with pending commands
+ *   from the queue, executes one command and returns the session to the
+ *   multiplexer (or frees it if the session ended).
+ *
+ ****************************************************************************/
 
-      /* Unlike the "real" strtok, ftpd_strtok does not NUL-terminate
-       * the returned string.
-       */
+static FAR void *ftpd_muxworker(FAR void *arg)
+{
+  FAR struct ftpd_mux_s *mux = (FAR struct ftpd_mux_s *)arg;
+  FAR struct ftpd_session_s *session;
+  int ret;
 
-      if (session->param[0] != '\0')
+  pthread_mutex_lock(&mux->lock);
+  for (; ; )
+    {
+      while (mux->qcount == 0 && !mux->stop)
         {
-          session->param[0] = '\0';
-          session->param++;
+          pthread_cond_wait(&mux->cond, &mux->lock);
+        }
+
+      if (mux->stop)
+        {
+          break;
         }
 
-      /* Dispatch the FTP command */
+      session    = mux->queue[mux->qhead];
+      mux->qhead = (mux->qhead + 1) % CONFIG_FTPD_MUX_MAXSESSIONS;
+      mux->qcount--;
+      pthread_mutex_unlock(&mux->lock);
 
-      ret = ftpd_command(session);
+      ret = ftpd_process(session);
+
+      pthread_mutex_lock(&mux->lock);
       if (ret < 0)
         {
-          nerr("ERROR: Disconnected by the command handler: %d\n", ret);
-          break;
+          ftpd_muxremove(mux, session);
+          pthread_mutex_unlock(&mux->lock);
+          ftpd_freesession(session);
+          pthread_mutex_lock(&mux->lock);
+        }
+      else
+        {
+          session->busy = false;
+          ftpd_muxwakeup(mux);
         }
     }
 
-  ftpd_freesession(session);
+  pthread_mutex_unlock(&mux->lock);
   return NULL;
 }
 
+/****************************************************************************
+ * Name: ftpd_muxstart
+ *
+ * Description:
+ *   Create the multiplexer and its worker pool the first time that a
+ *   session is added.
+ *
+ ****************************************************************************/
+
+static int ftpd_muxstart(FAR struct ftpd_server_s *server)
+{
+  FAR struct ftpd_mux_s *mux;
+  pthread_attr_t attr;
+  int ret;
+  int i;
+
+  mux = (FAR struct ftpd_mux_s *)zalloc(sizeof(struct ftpd_mux_s));
+  if (mux == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ret = pipe(mux->pipefd);
+  if (ret < 0)
+    {
+      ret = -errno;
+      nerr("ERROR: pipe() failed: %d\n", ret);
+      free(mux);
+      return ret;
+    }
+
+  pthread_mutex_init(&mux->lock, NULL);
+  pthread_cond_init(&mux->cond, NULL);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_FTPD_WORKERSTACKSIZE);
+
+  ret = pthread_create(&mux->muxtid, &attr, ftpd_muxthread, mux);
+  if (ret != 0)
+    {
+      nerr("ERROR: pthread_create() failed: %d\n", ret);
+      goto errout;
+    }
+
+  for (i = 0; i < CONFIG_FTPD_MUX_NWORKERS; i++)
+    {
+      ret = pthread_create(&mux->workers[i], &attr, ftpd_muxworker, mux);
+      if (ret != 0)
+        {
+          nerr("ERROR: pthread_create() failed: %d\n", ret);
+          break;
+        }
+
+      mux->nworkers++;
+    }
+
+  pthread_attr_destroy(&attr);
+  server->mux = mux;
+
+  /* Sessions would never be served without at least one worker */
+
+  if (mux->nworkers == 0)
+    {
+      ftpd_muxstop(server);
+      return -ret;
+    }
+
+  return OK;
+
+errout:
+  pthread_attr_destroy(&attr);
+  pthread_cond_destroy(&mux->cond);
+  pthread_mutex_destroy(&mux->lock);
+  close(mux->pipefd[0]);
+  close(mux->pipefd[1]);
+  free(mux);
+  return -ret;
+}
+
+/****************************************************************************
+ * Name: ftpd_muxadd
+ *
+ * Description:
+ *   Greet a newly accepted session and hand it to the multiplexer.
+ *
+ ****************************************************************************/
+
+static int ftpd_muxadd(FAR struct ftpd_server_s *server,
+                       FAR struct ftpd_session_s *session)
+{
+  FAR struct ftpd_mux_s *mux;
+  int ret;
+
+  if (server->mux == NULL)
+    {
+      ret = ftpd_muxstart(server);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  mux = server->mux;
+
+  pthread_mutex_lock(&mux->lock);
+  if (mux->nsessions >= CONFIG_FTPD_MUX_MAXSESSIONS)
+    {
+      pthread_mutex_unlock(&mux->lock);
+      ftpd_response(session->cmd.sd, session->txtimeout,
+                    g_respfmt1, 421, ' ', "Too many users");
+      return -EBUSY;
+    }
+
+  pthread_mutex_unlock(&mux->lock);
+
+  ret = ftpd_greeting(session);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  pthread_mutex_lock(&mux->lock);
+  session->busy = false;
+  mux->sessions[mux->nsessions++] = session;
+  ftpd_muxwakeup(mux);
+  pthread_mutex_unlock(&mux->lock);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftpd_muxstop
+ *
+ * Description:
+ *   Stop the multiplexer and the worker pool and free all sessions.
+ *
+ ****************************************************************************/
+
+static void ftpd_muxstop(FAR struct ftpd_server_s *server)
+{
+  FAR struct ftpd_mux_s *mux = server->mux;
+  int i;
+
+  pthread_mutex_lock(&mux->lock);
+  mux->stop = true;
+  ftpd_muxwakeup(mux);
+  pthread_cond_broadcast(&mux->cond);
+  pthread_mutex_unlock(&mux->lock);
+
+  /* Workers finish the command they are executing before they exit */
+
+  pthread_join(mux->muxtid, NULL);
+  for (i = 0; i < mux->nworkers; i++)
+    {
+      pthread_join(mux->workers[i], NULL);
+    }
+
+  for (i = 0; i < mux->nsessions; i++)
+    {
+      ftpd_freesession(mux->sessions[i]);
+    }
+
+  pthread_cond_destroy(&mux->cond);
+  pthread_mutex_destroy(&mux->lock);
+  close(mux->pipefd[0]);
+  close(mux->pipefd[1]);
+  free(mux);
+  server->mux = NULL;
+}
+#endif /* CONFIG_FTPD_MUX */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -4458,6 +5643,16 @@ int ftpd_session(FTPD_SESSION handle, int timeout)
       goto errout_with_session;
     }
 
+#ifdef CONFIG_FTPD_MUX
+  /* Let the multiplexer service the session */
+
+  ret = ftpd_muxadd(server, session);
+  if (ret < 0)
+    {
+      nerr("ERROR: ftpd_muxadd() failed: %d\n", ret);
+      goto errout_with_session;
+    }
+#else
   /* And create a worker thread to service the session */
 
   ret = ftpd_startworker(ftpd_worker, (FAR void *)session,
@@ -4467,6 +5662,7 @@ int ftpd_session(FTPD_SESSION handle, int timeout)
       nerr("ERROR: ftpd_startworker() failed: %d\n", ret);
       goto errout_with_session;
     }
+#endif
 
   /* Successfully connected an launched the worker thread */
 
@@ -4498,11 +5694,26 @@ void ftpd_close(FTPD_SESSION handle)
   DEBUGASSERT(handle);
 
   server = (struct ftpd_server_s *)handle;
+
+#ifdef CONFIG_FTPD_MUX
+  if (server->mux != NULL)
+    {
+      ftpd_muxstop(server);
+    }
+#endif
+
   if (server->head != NULL)
     {
       ftpd_account_free(server->head);
     }
 
+#ifdef CONFIG_FTPD_LISTCACHE
+  if (server->listcache != NULL)
+    {
+      ftpd_listcache_free(server->listcache);
+    }
+#endif
+
   if (server->sd >= 0)
     {
       close(server->sd);
@@ -29,6 +29,8 @@
 
 #include <sys/types.h>
 #include <stdbool.h>
+#include <poll.h>
+#include <pthread.h>
 
 #include <netinet/in.h>
 
@@ -97,6 +99,56 @@ struct ftpd_account_s
   FAR char                  *home;     /* Home directory path */
 };
 
+#ifdef CONFIG_FTPD_MUX
+/* The session multiplexer.  One thread polls the control connections of all
+ * idle sessions and a small pool of workers executes the commands.
+ */
+
+struct ftpd_session_s;
+
+struct ftpd_mux_s
+{
+  pthread_mutex_t            lock;      /* Protects everything below */
+  pthread_cond_t             cond;      /* Signals work for the pool */
+  pthread_t                  muxtid;    /* The polling thread */
+  pthread_t                  workers[CONFIG_FTPD_MUX_NWORKERS];
+  int                        nworkers;  /* Number of workers started */
+  int                        pipefd[2]; /* Wakes up the polling thread */
+  bool                       stop;      /* Shut down requested */
+  int                        nsessions; /* Number of sessions[] in use */
+  int                        qhead;     /* First session in queue[] */
+  int                        qcount;    /* Number of sessions in queue[] */
+  FAR struct ftpd_session_s *sessions[CONFIG_FTPD_MUX_MAXSESSIONS];
+  FAR struct ftpd_session_s *queue[CONFIG_FTPD_MUX_MAXSESSIONS];
+  struct pollfd              pollfds[CONFIG_FTPD_MUX_MAXSESSIONS + 1];
+};
+#endif
+
+#ifdef CONFIG_FTPD_LISTCACHE
+/* One cached directory listing.  Entries that are invalidated while a
+ * session is still sending them are orphaned and freed by the last user.
+ */
+
+struct ftpd_listentry_s
+{
+  FAR char                  *path;     /* Absolute directory path */
+  unsigned int               opton;    /* FTPD_LISTOPTION_* used */
+  time_t                     mtime;    /* Directory st_mtime when scanned */
+  FAR char                  *text;     /* Formatted listing */
+  size_t                     len;      /* Length of text */
+  uint32_t                   lastuse;  /* LRU stamp */
+  int                        refs;     /* Sessions currently sending */
+  bool                       orphan;   /* No longer in the cache */
+};
+
+struct ftpd_listcache_s
+{
+  pthread_mutex_t            lock;
+  uint32_t                   clock;    /* LRU clock */
+  FAR struct ftpd_listentry_s *entries[CONFIG_FTPD_LISTCACHE_ENTRIES];
+};
+#endif
+
 /* This structures describes an FTP session a list of associated accounts */
 
 struct ftpd_server_s
@@ -105,6 +157,12 @@ struct ftpd_server_s
   union ftpd_sockaddr_u      addr;   /* Listen address */
   FAR struct ftpd_account_s *head;   /* Head of a list of accounts */
   FAR struct ftpd_account_s *tail;   /* Tail of a list of accounts */
+#ifdef CONFIG_FTPD_MUX
+  FAR struct ftpd_mux_s     *mux;    /* Session multiplexer */
+#endif
+#ifdef CONFIG_FTPD_LISTCACHE
+  FAR struct ftpd_listcache_s *listcache; /* Shared by all sessions */
+#endif
 };
 
 struct ftpd_stream_s
@@ -124,6 +182,9 @@ struct ftpd_session_s
   uint8_t                          flags;   /* See TPD_SESSIONFLAG_* definitions */
   int                              rxtimeout;
   int                              txtimeout;
+#ifdef CONFIG_FTPD_MUX
+  bool                             busy;    /* Owned by a pool worker */
+#endif
 
   /* Command */
 
@@ -147,7 +208,28 @@ struct ftpd_session_s
   FAR char                  *home;
   FAR char                  *work;
   FAR char                  *renamefrom;
+
+  /* Last completed transfer (SITE STAT) */
+
+  FAR const char            *xfercmd;  /* "RETR", "STOR" or "APPE" */
+  off_t                      xferbytes;
+  uint32_t                   xfermsecs;
+};
+
+#ifdef CONFIG_FTPD_STOR_DOUBLEBUFFER
+/* Hand-off between the receiver and the file writer of an upload */
+
+struct ftpd_dbuf_s
+{
+  pthread_mutex_t            lock;
+  pthread_cond_t             cond;
+  FAR char                  *buffer[2];
+  size_t                     buflen[2]; /* Bytes to write, 0 = free */
+  bool                       eof;       /* Receiver is done */
+  int                        errval;    /* Write error, if any */
+  int                        fd;        /* File being written */
 };
+#endif
 
 typedef int (*ftpd_cmdhandler_t)(FAR struct ftpd_session_s *);
 
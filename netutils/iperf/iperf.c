@@ -22,21 +22,30 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+#include <nuttx/clock.h>
+
 #include <arpa/inet.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <net/if.h>
 #include <netinet/in.h>
 #include <netpacket/rpmsg.h>
+#include <poll.h>
 #include <pthread.h>
 #include <sched.h>
 #include <stdbool.h>
+#include <sys/param.h>
 #include <sys/prctl.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/un.h>
 #include <unistd.h>
 
 #include "iperf.h"
+#include "iperf3.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -57,10 +66,23 @@
 #define IPERF_MAX_DELAY              64
 #define IPERF_SOCKET_RX_TIMEOUT      10
 
+#define IPERF_LAT_BUCKETS            240
+#define IPERF3_POLL_MS               100
+
+#ifdef CONFIG_SMP
+#  define IPERF_NCPUS                CONFIG_SMP_NCPUS
+#else
+#  define IPERF_NCPUS                1
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+/* One control block per stream.  The streams of a run are allocated as
+ * an array, the first one (leader) owns the report task.
+ */
+
 struct iperf_ctrl_t
 {
   FAR struct iperf_ctrl_t *flink;
@@ -69,7 +91,18 @@ struct iperf_ctrl_t
   uintmax_t total_len;
   uint32_t buffer_len;
   FAR uint8_t *buffer;
-  uint32_t sockfd;
+  int sockfd;
+  FAR struct iperf_ctrl_t *leader;
+  uint16_t nstreams;
+  pthread_t thread;
+  pthread_t rxthread;
+  bool report;
+  pthread_t report_thread;
+  int cpu;
+  FAR struct iperf_lat_t *lat;
+#ifdef CONFIG_NETUTILS_IPERF3
+  FAR struct iperf3_s *iperf3;
+#endif
 };
 
 struct iperf_udp_pkt_t
@@ -79,6 +112,18 @@ struct iperf_udp_pkt_t
   uint32_t usec;
 };
 
+/* UDP server latency statistics, cumulative since the first packet */
+
+struct iperf_lat_t
+{
+  uint32_t hist[IPERF_LAT_BUCKETS]; /* one-way delay histogram */
+  uint32_t count;                   /* packets received */
+  uint32_t max;                     /* max delay in us */
+  int32_t last_id;                  /* highest packet id seen */
+  int64_t transit;                  /* last transit time in us */
+  double jitter;                    /* interarrival jitter in us */
+};
+
 typedef CODE int (*iperf_client_func_t)(FAR struct iperf_ctrl_t *ctrl,
                                         FAR struct sockaddr *addr,
                                         socklen_t addrlen);
@@ -106,6 +151,9 @@ static int iperf_get_socket_error_code(int sockfd);
 static int iperf_show_socket_error_reason(FAR const char *str, int sockfd);
 static void iperf_report_task(FAR void *arg);
 static int iperf_start_report(FAR struct iperf_ctrl_t *ctrl);
+static int iperf_start_traffic(FAR struct iperf_ctrl_t *ctrl,
+                               pthread_startroutine_t entry,
+                               FAR pthread_t *thread);
 static int iperf_run_tcp_server(FAR struct iperf_ctrl_t *ctrl);
 static int iperf_run_udp_server(FAR struct iperf_ctrl_t *ctrl);
 static int iperf_run_udp_client(FAR struct iperf_ctrl_t *ctrl);
@@ -273,6 +321,290 @@ static double ts_diff(const struct timespec *a, const struct timespec *b)
   return ts_sec(a) - ts_sec(b);
 }
 
+/****************************************************************************
+ * Name: iperf_lat_index
+ *
+ * Description:
+ *   Histogram bucket of a delay: 1 us buckets below 16 us, then 8 buckets
+ *   per power of two (12.5% resolution).
+ *
+ ****************************************************************************/
+
+static int iperf_lat_index(uint32_t us)
+{
+  int e;
+
+  if (us < 16)
+    {
+      return us;
+    }
+
+  e = 31 - __builtin_clz(us);
+  return 16 + (e - 4) * 8 + ((us >> (e - 3)) & 7);
+}
+
+/****************************************************************************
+ * Name: iperf_lat_value
+ *
+ * Description:
+ *   Upper bound of a histogram bucket in us
+ *
+ ****************************************************************************/
+
+static uint32_t iperf_lat_value(int idx)
+{
+  int e;
+
+  if (idx < 16)
+    {
+      return idx;
+    }
+
+  e = (idx - 16) / 8 + 4;
+  return ((uint32_t)(8 + (idx - 16) % 8) << (e - 3)) +
+         ((uint32_t)1 << (e - 3)) - 1;
+}
+
+/****************************************************************************
+ * Name: iperf_lat_update
+ *
+ * Description:
+ *   Account a received UDP packet.  The one-way delay needs the clocks of
+ *   both ends to be synchronized (e.g. with ptpd), a clock offset that
+ *   makes it negative is clamped to zero.
+ *
+ ****************************************************************************/
+
+static void iperf_lat_update(FAR struct iperf_lat_t *lat,
+                             FAR const struct iperf_udp_pkt_t *pkt)
+{
+  struct timespec now;
+  int64_t transit;
+  int64_t d;
+  int32_t id;
+
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  /* The sender stamps 32-bit seconds, compare modulo 2^32 */
+
+  transit = (int64_t)(int32_t)((uint32_t)now.tv_sec - ntohl(pkt->sec)) *
+            1000000 + (now.tv_nsec / 1000 - (int64_t)ntohl(pkt->usec));
+
+  lat->hist[iperf_lat_index(transit < 0 ? 0 :
+                            (uint32_t)MIN(transit, UINT32_MAX))]++;
+  lat->max = MAX(lat->max, (uint32_t)MIN(MAX(transit, 0), UINT32_MAX));
+
+  /* RFC 3550 interarrival jitter */
+
+  if (lat->count > 0)
+    {
+      d = transit - lat->transit;
+      lat->jitter += ((d < 0 ? -d : d) - lat->jitter) / 16.0;
+    }
+
+  lat->transit = transit;
+  lat->count++;
+
+  id = ntohl(pkt->id);
+  if (id > lat->last_id)
+    {
+      lat->last_id = id;
+    }
+}
+
+/****************************************************************************
+ * Name: iperf_lat_percentile
+ *
+ * Description:
+ *   Delay in us below which permille of the packets received between the
+ *   prev and cur snapshots fall
+ *
+ ****************************************************************************/
+
+static uint32_t iperf_lat_percentile(FAR const struct iperf_lat_t *cur,
+                                     FAR const struct iperf_lat_t *prev,
+                                     int permille)
+{
+  uint32_t count = cur->count - prev->count;
+  uint32_t want = (uint32_t)(((uint64_t)count * permille + 999) / 1000);
+  uint32_t sum = 0;
+  int i;
+
+  for (i = 0; i < IPERF_LAT_BUCKETS; i++)
+    {
+      sum += cur->hist[i] - prev->hist[i];
+      if (sum >= want && sum > 0)
+        {
+          return iperf_lat_value(i);
+        }
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: iperf_print_latency
+ *
+ * Description:
+ *   Print latency, jitter and loss of the packets between two snapshots
+ *
+ ****************************************************************************/
+
+static void iperf_print_latency(FAR const struct iperf_lat_t *cur,
+                                FAR const struct iperf_lat_t *prev,
+                                uint32_t max)
+{
+  uint32_t count = cur->count - prev->count;
+  int32_t expected = cur->last_id - prev->last_id;
+  int32_t lost = expected - (int32_t)count;
+
+  if (count == 0)
+    {
+      printf("%24s no packets\n", "latency:");
+      return;
+    }
+
+  printf("%24s p50 %" PRIu32 " us, p99 %" PRIu32 " us, max %" PRIu32
+         " us, jitter %.3f ms, lost %" PRId32 "/%" PRId32 "\n",
+         "latency:", iperf_lat_percentile(cur, prev, 500),
+         iperf_lat_percentile(cur, prev, 990), max,
+         cur->jitter / 1000.0, MAX(lost, 0), MAX(expected, 0));
+}
+
+/****************************************************************************
+ * Name: iperf_total_len
+ *
+ * Description:
+ *   Sum of the bytes transferred by all streams
+ *
+ ****************************************************************************/
+
+static uintmax_t iperf_total_len(FAR struct iperf_ctrl_t *leader)
+{
+  uintmax_t len = 0;
+  int i;
+
+  for (i = 0; i < leader->nstreams; i++)
+    {
+      len += leader[i].total_len;
+    }
+
+  return len;
+}
+
+/****************************************************************************
+ * Name: iperf_is_finished
+ *
+ * Description:
+ *   Check if all streams are finished
+ *
+ ****************************************************************************/
+
+static bool iperf_is_finished(FAR struct iperf_ctrl_t *leader)
+{
+  int i;
+
+  for (i = 0; i < leader->nstreams; i++)
+    {
+      if (!leader[i].finish)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: iperf_finish
+ *
+ * Description:
+ *   Stop all streams
+ *
+ ****************************************************************************/
+
+static void iperf_finish(FAR struct iperf_ctrl_t *leader)
+{
+  int i;
+
+  for (i = 0; i < leader->nstreams; i++)
+    {
+      leader[i].finish = true;
+    }
+}
+
+#ifndef CONFIG_SCHED_CPULOAD_NONE
+/****************************************************************************
+ * Name: iperf_cpu_load
+ *
+ * Description:
+ *   Return the CPU utilization since prev in per mille, or -1 if it is
+ *   not available, and update prev.  The idle task of CPU n has pid n.
+ *   The scheduler halves the counters at its time constant, that is
+ *   undone on the old snapshot before taking the difference.
+ *
+ ****************************************************************************/
+
+static int iperf_cpu_load(FAR struct cpuload_s *prev)
+{
+  struct cpuload_s cur;
+  clock_t pactive;
+  clock_t ptotal;
+  clock_t total = 0;
+  clock_t idle = 0;
+  int i;
+
+  for (i = 0; i < IPERF_NCPUS; i++)
+    {
+      if (clock_cpuload(i, &cur) < 0)
+        {
+          return -1;
+        }
+
+      ptotal  = prev[i].total;
+      pactive = prev[i].active;
+      while (ptotal > cur.total)
+        {
+          ptotal  >>= 1;
+          pactive >>= 1;
+        }
+
+      total = cur.total - ptotal;
+      idle += cur.active > pactive ? cur.active - pactive : 0;
+      prev[i] = cur;
+    }
+
+  if (total == 0)
+    {
+      return -1;
+    }
+
+  return 1000 - (int)MIN(idle * 1000 / total, 1000);
+}
+#endif
+
+/****************************************************************************
+ * Name: iperf_print_interval
+ *
+ * Description:
+ *   Print one report line, cpu is in per mille or negative if unknown
+ *
+ ****************************************************************************/
+
+static void iperf_print_interval(FAR const char *tag, double start,
+                                 double end, uintmax_t len, int cpu)
+{
+  printf("%s%7.2lf-%7.2lf sec %10ju Bytes %7.2f Mbits/sec",
+         tag, start, end, len, ((len * 8) / 1000000.0) / (end - start));
+
+  if (cpu >= 0)
+    {
+      printf(" %5.1f%% CPU", cpu / 10.0);
+    }
+
+  printf("\n");
+}
+
 /****************************************************************************
  * Name: iperf_report_task
  *
@@ -286,14 +618,63 @@ static void iperf_report_task(FAR void *arg)
   FAR struct iperf_ctrl_t *ctrl = arg;
   uint32_t interval = ctrl->cfg.interval;
   uint32_t time = ctrl->cfg.time;
+  FAR uintmax_t *stream_len;
+  FAR uintmax_t *delta;
+  bool json = false;
   struct timespec now;
   struct timespec start;
   uintmax_t now_len;
+  double cpu_sum = 0.0;
+  double cpu_time = 0.0;
+  int cpu = -1;
+  char tag[8];
   int ret;
+  int i;
+  FAR struct iperf_lat_t *lat = NULL;
+#ifndef CONFIG_SCHED_CPULOAD_NONE
+  struct cpuload_s cpuload[IPERF_NCPUS];
+#endif
 
   prctl(PR_SET_NAME, IPERF_REPORT_TASK_NAME);
 
-  now_len = ctrl->total_len;
+#ifdef CONFIG_NETUTILS_IPERF3
+  json = ctrl->iperf3 != NULL && ctrl->iperf3->output != NULL;
+#endif
+
+  /* Bytes of each stream at the previous report and in the interval */
+
+  stream_len = calloc(2 * ctrl->nstreams, sizeof(uintmax_t));
+  if (stream_len == NULL)
+    {
+      fprintf(stderr, "report: not enough memory\n");
+      iperf_finish(ctrl);
+      pthread_exit(NULL);
+    }
+
+  delta = stream_len + ctrl->nstreams;
+
+  /* Latency snapshots: zero, at the previous report and now */
+
+  if (ctrl->lat != NULL)
+    {
+      lat = calloc(3, sizeof(struct iperf_lat_t));
+      if (lat == NULL)
+        {
+          fprintf(stderr, "report: not enough memory\n");
+        }
+    }
+
+#ifndef CONFIG_SCHED_CPULOAD_NONE
+  memset(cpuload, 0, sizeof(cpuload));
+  iperf_cpu_load(cpuload);
+#endif
+
+  now_len = iperf_total_len(ctrl);
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      stream_len[i] = ctrl[i].total_len;
+    }
+
   ret = clock_gettime(CLOCK_MONOTONIC, &now);
   if (ret != 0)
     {
@@ -302,8 +683,13 @@ static void iperf_report_task(FAR void *arg)
     }
 
   start = now;
-  printf("\n%19s %16s %18s\n", "Interval", "Transfer", "Bandwidth\n");
-  while (!ctrl->finish)
+  if (!json)
+    {
+      printf("\n%19s %16s %18s\n", "Interval", "Transfer",
+             "Bandwidth\n");
+    }
+
+  while (!iperf_is_finished(ctrl))
     {
       uintmax_t last_len;
       struct timespec last;
@@ -311,7 +697,7 @@ static void iperf_report_task(FAR void *arg)
       sleep(interval);
       last_len = now_len;
       last = now;
-      now_len = ctrl->total_len;
+      now_len = iperf_total_len(ctrl);
       ret = clock_gettime(CLOCK_MONOTONIC, &now);
       if (ret != 0)
         {
@@ -319,31 +705,99 @@ static void iperf_report_task(FAR void *arg)
           exit(EXIT_FAILURE);
         }
 
-      printf("%7.2lf-%7.2lf sec %10ju Bytes %7.2f Mbits/sec\n",
-             ts_diff(&last, &start),
-             ts_diff(&now, &start),
-             now_len -last_len,
-             (((now_len - last_len) * 8) / 1000000.0) /
-             ts_diff(&now, &last)
-             );
+#ifndef CONFIG_SCHED_CPULOAD_NONE
+      cpu = iperf_cpu_load(cpuload);
+      if (cpu >= 0)
+        {
+          cpu_sum  += cpu * ts_diff(&now, &last);
+          cpu_time += ts_diff(&now, &last);
+          ctrl->cpu = cpu_sum / cpu_time;
+        }
+#endif
+
+      for (i = 0; i < ctrl->nstreams; i++)
+        {
+          uintmax_t len = ctrl[i].total_len;
+
+          delta[i] = len - stream_len[i];
+          stream_len[i] = len;
+        }
+
+#ifdef CONFIG_NETUTILS_IPERF3
+      if (json)
+        {
+          iperf3_output_interval(ctrl->iperf3->output, ctrl->nstreams,
+                                 delta, ts_diff(&last, &start),
+                                 ts_diff(&now, &start),
+                                 !(ctrl->cfg.flag & IPERF_FLAG_CLIENT) ==
+                                 ctrl->iperf3->params.reverse);
+        }
+      else
+#endif
+        {
+          for (i = 0; ctrl->nstreams > 1 && i < ctrl->nstreams; i++)
+            {
+              snprintf(tag, sizeof(tag), "[%3d] ", i + 1);
+              iperf_print_interval(tag, ts_diff(&last, &start),
+                                   ts_diff(&now, &start), delta[i], -1);
+            }
+
+          iperf_print_interval(ctrl->nstreams > 1 ? "[SUM] " : "",
+                               ts_diff(&last, &start),
+                               ts_diff(&now, &start),
+                               now_len - last_len, cpu);
+        }
+
+      if (lat != NULL)
+        {
+          uint32_t max = 0;
+
+          memcpy(&lat[2], ctrl->lat, sizeof(struct iperf_lat_t));
+          for (i = IPERF_LAT_BUCKETS - 1; i >= 0; i--)
+            {
+              if (lat[2].hist[i] != lat[1].hist[i])
+                {
+                  max = MIN(iperf_lat_value(i), lat[2].max);
+                  break;
+                }
+            }
+
+          iperf_print_latency(&lat[2], &lat[1], max);
+          memcpy(&lat[1], &lat[2], sizeof(struct iperf_lat_t));
+        }
+
       if (time != 0 && ts_diff(&now, &start) >= time)
         {
           break;
         }
     }
 
-  if (ts_diff(&now, &start) > 0)
+  if (!json && ts_diff(&now, &start) > 0)
     {
-      printf("%7.2lf-%7.2lf sec %10ju Bytes %7.2f Mbits/sec\n",
-             ts_diff(&start, &start),
-             ts_diff(&now, &start),
-             now_len,
-             ((now_len * 8) / 1000000.0) /
-             ts_diff(&now, &start)
-             );
+      if (ctrl->nstreams > 1)
+        {
+          for (i = 0; i < ctrl->nstreams; i++)
+            {
+              snprintf(tag, sizeof(tag), "[%3d] ", i + 1);
+              iperf_print_interval(tag, 0, ts_diff(&now, &start),
+                                   ctrl[i].total_len, -1);
+            }
+        }
+
+      iperf_print_interval(ctrl->nstreams > 1 ? "[SUM] " : "",
+                           0, ts_diff(&now, &start), now_len,
+                           cpu_time > 0 ? (int)(cpu_sum / cpu_time) : -1);
+
+      if (lat != NULL)
+        {
+          memcpy(&lat[2], ctrl->lat, sizeof(struct iperf_lat_t));
+          iperf_print_latency(&lat[2], &lat[0], lat[2].max);
+        }
     }
 
-  ctrl->finish = true;
+  iperf_finish(ctrl);
+  free(stream_len);
+  free(lat);
 
   pthread_exit(NULL);
 }
@@ -352,32 +806,72 @@ static void iperf_report_task(FAR void *arg)
  * Name: iperf_start_report
  *
  * Description:
- *   Start iperf report
+ *   Start iperf report, once for all streams
  *
  ****************************************************************************/
 
 static int iperf_start_report(FAR struct iperf_ctrl_t *ctrl)
 {
+  FAR struct iperf_ctrl_t *leader = ctrl->leader;
   struct sched_param param;
   pthread_attr_t attr;
-  pthread_t thread;
   int ret;
 
+  pthread_mutex_lock(&g_iperf_ctrl_mutex);
+  if (leader->report)
+    {
+      pthread_mutex_unlock(&g_iperf_ctrl_mutex);
+      return 0;
+    }
+
+  leader->report = true;
+  pthread_mutex_unlock(&g_iperf_ctrl_mutex);
+
   pthread_attr_init(&attr);
   param.sched_priority = IPERF_REPORT_TASK_PRIORITY;
   pthread_attr_setschedparam(&attr, &param);
   pthread_attr_setstacksize(&attr, IPERF_REPORT_TASK_STACK);
 
-  ret = pthread_create(&thread, &attr, (FAR void *)iperf_report_task,
-                       ctrl);
+  ret = pthread_create(&leader->report_thread, &attr,
+                       (FAR void *)iperf_report_task, leader);
   if (ret != 0)
     {
       printf("iperf_thread: pthread_create failed: %d, %s\n",
              ret, IPERF_REPORT_TASK_NAME);
+      leader->report = false;
       return -1;
     }
 
-  pthread_detach(thread);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: iperf_start_traffic
+ *
+ * Description:
+ *   Start the traffic thread of a stream
+ *
+ ****************************************************************************/
+
+static int iperf_start_traffic(FAR struct iperf_ctrl_t *ctrl,
+                               pthread_startroutine_t entry,
+                               FAR pthread_t *thread)
+{
+  struct sched_param param;
+  pthread_attr_t attr;
+  int ret;
+
+  pthread_attr_init(&attr);
+  param.sched_priority = IPERF_TRAFFIC_TASK_PRIORITY;
+  pthread_attr_setschedparam(&attr, &param);
+  pthread_attr_setstacksize(&attr, IPERF_TRAFFIC_TASK_STACK);
+
+  ret = pthread_create(thread, &attr, entry, ctrl);
+  if (ret != 0)
+    {
+      printf("iperf_task_traffic: create task failed: %d\n", ret);
+      return -1;
+    }
 
   return 0;
 }
@@ -473,24 +967,88 @@ static int iperf_run_client(FAR struct iperf_ctrl_t *ctrl,
 }
 
 /****************************************************************************
- * Name: iperf_tcp_server
+ * Name: iperf_tcp_recv
  *
  * Description:
- *   The main tcp server logic
+ *   Receive on an accepted connection.  Returns 0 if it was closed by the
+ *   peer.
  *
  ****************************************************************************/
 
-static int iperf_tcp_server(FAR struct iperf_ctrl_t *ctrl,
-                            FAR struct sockaddr *addr, socklen_t addrlen,
-                            FAR struct sockaddr *remote_addr)
+static int iperf_tcp_recv(FAR struct iperf_ctrl_t *ctrl, int sockfd)
 {
   int actual_recv = 0;
-  int want_recv = 0;
-  FAR uint8_t *buffer;
+
+  while (!ctrl->finish)
+    {
+      actual_recv = recv(sockfd, ctrl->buffer, ctrl->buffer_len, 0);
+      if (actual_recv == 0)
+        {
+          /* Note: unlike the original iperf, this implementation
+           * exits after finishing a single connection.
+           */
+
+          ctrl->finish = true;
+          break;
+        }
+      else if (actual_recv < 0)
+        {
+          iperf_show_socket_error_reason("tcp server recv", sockfd);
+          ctrl->finish = true;
+          break;
+        }
+      else
+        {
+          ctrl->total_len += actual_recv;
+        }
+    }
+
+  return actual_recv;
+}
+
+/****************************************************************************
+ * Name: iperf_tcp_stream
+ *
+ * Description:
+ *   Receive one of the parallel connections
+ *
+ ****************************************************************************/
+
+static FAR void *iperf_tcp_stream(FAR void *arg)
+{
+  FAR struct iperf_ctrl_t *ctrl = arg;
+
+  prctl(PR_SET_NAME, IPERF_TRAFFIC_TASK_NAME);
+
+  if (iperf_tcp_recv(ctrl, ctrl->sockfd) == 0)
+    {
+      printf("[%3d] closed by the peer\n", (int)(ctrl - ctrl->leader) + 1);
+    }
+
+  ctrl->finish = true;
+  close(ctrl->sockfd);
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: iperf_tcp_server
+ *
+ * Description:
+ *   The main tcp server logic
+ *
+ ****************************************************************************/
+
+static int iperf_tcp_server(FAR struct iperf_ctrl_t *ctrl,
+                            FAR struct sockaddr *addr, socklen_t addrlen,
+                            FAR struct sockaddr *remote_addr)
+{
   int listen_socket;
   struct timeval t;
+  int accepted = 0;
   int sockfd;
   int opt;
+  int i;
 
   listen_socket = socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
   if (listen_socket < 0)
@@ -507,16 +1065,14 @@ static int iperf_tcp_server(FAR struct iperf_ctrl_t *ctrl,
       return -1;
     }
 
-  if (listen(listen_socket, 5) < 0)
+  if (listen(listen_socket, MAX(ctrl->nstreams, 5)) < 0)
     {
       iperf_show_socket_error_reason("tcp server listen", listen_socket);
       close(listen_socket);
       return -1;
     }
 
-  buffer = ctrl->buffer;
-  want_recv = ctrl->buffer_len;
-  while (!ctrl->finish)
+  while (!ctrl->finish && accepted < ctrl->nstreams)
     {
       /* TODO need to change to non-block mode */
 
@@ -524,50 +1080,46 @@ static int iperf_tcp_server(FAR struct iperf_ctrl_t *ctrl,
       if (sockfd < 0)
         {
           iperf_show_socket_error_reason("tcp server listen", listen_socket);
-          close(listen_socket);
-          return -1;
+          break;
         }
-      else
-        {
-          iperf_print_addr("accept", remote_addr);
-          iperf_start_report(ctrl);
 
-          t.tv_sec = IPERF_SOCKET_RX_TIMEOUT;
-          t.tv_usec = 0;
-          setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
-        }
+      iperf_print_addr("accept", remote_addr);
+      iperf_start_report(ctrl);
+
+      t.tv_sec = IPERF_SOCKET_RX_TIMEOUT;
+      t.tv_usec = 0;
+      setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
 
-      while (!ctrl->finish)
+      if (ctrl->nstreams == 1)
         {
-          actual_recv = recv(sockfd, buffer, want_recv, 0);
-          if (actual_recv == 0)
+          if (iperf_tcp_recv(ctrl, sockfd) == 0)
             {
               iperf_print_addr("closed by the peer", remote_addr);
+            }
 
-              /* Note: unlike the original iperf, this implementation
-               * exits after finishing a single connection.
-               */
+          close(sockfd);
+          continue;
+        }
 
-              ctrl->finish = true;
-              break;
-            }
-          else if (actual_recv < 0)
-            {
-              iperf_show_socket_error_reason("tcp server recv",
-                                             listen_socket);
-              ctrl->finish = true;
-              break;
-            }
-          else
-            {
-              ctrl->total_len += actual_recv;
-            }
+      /* With parallel streams every connection gets its own thread */
+
+      ctrl[accepted].sockfd = sockfd;
+      if (iperf_start_traffic(&ctrl[accepted], iperf_tcp_stream,
+                              &ctrl[accepted].rxthread) < 0)
+        {
+          close(sockfd);
+          break;
         }
 
-      close(sockfd);
+      accepted++;
     }
 
-  ctrl->finish = true;
+  for (i = 0; ctrl->nstreams > 1 && i < accepted; i++)
+    {
+      pthread_join(ctrl[i].rxthread, NULL);
+    }
+
+  iperf_finish(ctrl);
   close(listen_socket);
 
   return 0;
@@ -646,6 +1198,13 @@ static int iperf_udp_server(FAR struct iperf_ctrl_t *ctrl,
               udp_recv_start = false;
             }
 
+          if (ctrl->lat != NULL &&
+              actual_recv >= sizeof(struct iperf_udp_pkt_t))
+            {
+              iperf_lat_update(ctrl->lat,
+                               (FAR struct iperf_udp_pkt_t *)buffer);
+            }
+
           ctrl->total_len += actual_recv;
         }
     }
@@ -681,6 +1240,7 @@ static int iperf_udp_client(FAR struct iperf_ctrl_t *ctrl,
                             FAR struct sockaddr *addr, socklen_t addrlen)
 {
   FAR struct iperf_udp_pkt_t *udp;
+  struct timespec ts;
   int actual_send = 0;
   bool retry = false;
   uint32_t delay = 1;
@@ -713,6 +1273,12 @@ static int iperf_udp_client(FAR struct iperf_ctrl_t *ctrl,
           id++;
           udp->id = htonl(id);
           delay = 1;
+
+          /* Send time for the one-way delay on the server */
+
+          clock_gettime(CLOCK_REALTIME, &ts);
+          udp->sec = htonl((uint32_t)ts.tv_sec);
+          udp->usec = htonl(ts.tv_nsec / 1000);
         }
 
       retry = false;
@@ -763,6 +1329,57 @@ static int iperf_run_udp_client(FAR struct iperf_ctrl_t *ctrl)
   return iperf_run_client(ctrl, iperf_udp_client);
 }
 
+/****************************************************************************
+ * Name: iperf_tcp_send
+ *
+ * Description:
+ *   Send on a connection until the stream is finished, with sendfile()
+ *   if filefd is valid
+ *
+ ****************************************************************************/
+
+static void iperf_tcp_send(FAR struct iperf_ctrl_t *ctrl, int sockfd,
+                           int filefd)
+{
+  FAR uint8_t *buffer = ctrl->buffer;
+  int want_send = ctrl->buffer_len;
+  int actual_send;
+  off_t offset;
+
+  while (!ctrl->finish)
+    {
+      if (filefd >= 0)
+        {
+          /* The file holds one buffer, the stack takes the data straight
+           * from it without a copy through user memory.
+           */
+
+          offset = 0;
+          actual_send = sendfile(sockfd, filefd, &offset, want_send);
+        }
+      else
+        {
+          actual_send = send(sockfd, buffer, want_send, 0);
+        }
+
+      if (actual_send <= 0)
+        {
+          if (!ctrl->finish)
+            {
+              iperf_show_socket_error_reason("tcp client send", sockfd);
+            }
+
+          break;
+        }
+      else
+        {
+          ctrl->total_len += actual_send;
+        }
+    }
+
+  ctrl->finish = true;
+}
+
 /****************************************************************************
  * Name: iperf_tcp_client
  *
@@ -774,46 +1391,100 @@ static int iperf_run_udp_client(FAR struct iperf_ctrl_t *ctrl)
 static int iperf_tcp_client(FAR struct iperf_ctrl_t *ctrl,
                             FAR struct sockaddr *addr, socklen_t addrlen)
 {
-  FAR uint8_t *buffer;
-  int actual_send = 0;
-  int want_send = 0;
+#ifdef CONFIG_NETUTILS_IPERF3
+  FAR struct iperf3_s *test = ctrl->leader->iperf3;
+  struct timeval t;
+#endif
+  int filefd = -1;
   int sockfd;
 
+  if (ctrl->cfg.sendfile != NULL)
+    {
+      filefd = open(ctrl->cfg.sendfile, O_RDONLY);
+      if (filefd < 0)
+        {
+          printf("tcp client open %s error: %d\n", ctrl->cfg.sendfile,
+                 errno);
+          return -1;
+        }
+    }
+
   sockfd = socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
   if (sockfd < 0)
     {
       iperf_show_socket_error_reason("tcp client create", sockfd);
-      return -1;
+      goto errout;
     }
 
   if (connect(sockfd, addr, addrlen) < 0)
     {
       iperf_show_socket_error_reason("tcp client connect", sockfd);
-      return -1;
+      close(sockfd);
+      goto errout;
     }
 
-  iperf_start_report(ctrl);
-  buffer = ctrl->buffer;
-  want_send = ctrl->buffer_len;
-
-  while (!ctrl->finish)
+#ifdef CONFIG_NETUTILS_IPERF3
+  if (test != NULL)
     {
-      actual_send = send(sockfd, buffer, want_send, 0);
-      if (actual_send <= 0)
+      /* The stream identifies itself with the cookie and waits for the
+       * server to start the test.  The socket stays open until the end
+       * of the test, it is closed by the control connection.
+       */
+
+      ctrl->sockfd = sockfd;
+      if (iperf3_send(sockfd, test->cookie, IPERF3_COOKIE_SIZE) < 0)
         {
-          iperf_show_socket_error_reason("tcp client send", sockfd);
-          break;
+          iperf_show_socket_error_reason("tcp client cookie", sockfd);
+          goto errout;
+        }
+
+      sem_wait(&test->start);
+      if (ctrl->finish)
+        {
+          goto errout;
+        }
+
+      iperf_start_report(ctrl);
+      if (test->params.reverse)
+        {
+          t.tv_sec = IPERF_SOCKET_RX_TIMEOUT;
+          t.tv_usec = 0;
+          setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
+          iperf_tcp_recv(ctrl, sockfd);
         }
       else
         {
-          ctrl->total_len += actual_send;
+          iperf_tcp_send(ctrl, sockfd, filefd);
         }
+
+      ctrl->finish = true;
+      goto out;
     }
+#endif
 
-  ctrl->finish = true;
+  iperf_start_report(ctrl);
+  iperf_tcp_send(ctrl, sockfd, filefd);
   close(sockfd);
 
+#ifdef CONFIG_NETUTILS_IPERF3
+out:
+#endif
+
+  if (filefd >= 0)
+    {
+      close(filefd);
+    }
+
   return 0;
+
+errout:
+  ctrl->finish = true;
+  if (filefd >= 0)
+    {
+      close(filefd);
+    }
+
+  return -1;
 }
 
 /****************************************************************************
@@ -866,20 +1537,61 @@ static void iperf_task_traffic(FAR void *arg)
       assert(false);
     }
 
-  if (ctrl->buffer)
+  if (!(ctrl->cfg.flag & IPERF_FLAG_JSON))
     {
-      free(ctrl->buffer);
-      ctrl->buffer = NULL;
+      printf("iperf exit\n");
     }
 
-  printf("iperf exit\n");
-
   pthread_exit(NULL);
 }
 
+/****************************************************************************
+ * Name: iperf_create_sendfile
+ *
+ * Description:
+ *   Fill the file the TCP client sends from with one buffer.  It should
+ *   be on a RAM backed file system, so only the network stack is measured.
+ *
+ ****************************************************************************/
+
+static int iperf_create_sendfile(FAR struct iperf_ctrl_t *ctrl)
+{
+  ssize_t nwritten;
+  size_t len = 0;
+  int fd;
+
+  fd = open(ctrl->cfg.sendfile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      printf("create %s error: %d\n", ctrl->cfg.sendfile, errno);
+      return -1;
+    }
+
+  while (len < ctrl->buffer_len)
+    {
+      nwritten = write(fd, ctrl->buffer + len, ctrl->buffer_len - len);
+      if (nwritten <= 0)
+        {
+          printf("write %s error: %d\n", ctrl->cfg.sendfile, errno);
+          close(fd);
+          unlink(ctrl->cfg.sendfile);
+          return -1;
+        }
+
+      len += nwritten;
+    }
+
+  close(fd);
+  return 0;
+}
+
 static uint32_t iperf_get_buffer_len(FAR struct iperf_ctrl_t *ctrl)
 {
-  if (iperf_is_udp_client(ctrl))
+  if (ctrl->cfg.buffer_len != 0)
+    {
+      return ctrl->cfg.buffer_len;
+    }
+  else if (iperf_is_udp_client(ctrl))
     {
       return IPERF_UDP_TX_LEN;
     }
@@ -900,69 +1612,795 @@ static uint32_t iperf_get_buffer_len(FAR struct iperf_ctrl_t *ctrl)
 }
 
 /****************************************************************************
- * Public Functions
+ * Name: iperf_free
+ *
+ * Description:
+ *   Free the streams of a run
+ *
  ****************************************************************************/
 
+static void iperf_free(FAR struct iperf_ctrl_t *ctrl)
+{
+  int i;
+
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      free(ctrl[i].buffer);
+    }
+
+  free(ctrl->lat);
+  free(ctrl);
+}
+
 /****************************************************************************
- * Name: iperf_start
+ * Name: iperf_create
  *
  * Description:
- *   Start iperf task.
+ *   Allocate the streams of a run and make them visible to iperf_stop()
  *
  ****************************************************************************/
 
-int iperf_start(FAR struct iperf_cfg_t *cfg)
+static FAR struct iperf_ctrl_t *iperf_create(FAR struct iperf_cfg_t *cfg,
+                                             uint16_t nstreams)
 {
-  struct iperf_ctrl_t ctrl;
-  struct sched_param param;
-  pthread_attr_t attr;
-  pthread_t thread;
-  FAR void *retval;
-  int ret;
+  FAR struct iperf_ctrl_t *ctrl;
+  int i;
 
-  if (!cfg)
+  ctrl = calloc(nstreams, sizeof(struct iperf_ctrl_t));
+  if (ctrl == NULL)
     {
-      return -1;
+      printf("create ctrl: not enough memory\n");
+      return NULL;
     }
 
-  memset(&ctrl, 0, sizeof(ctrl));
-  memcpy(&ctrl.cfg, cfg, sizeof(*cfg));
-  ctrl.finish = false;
-  ctrl.buffer_len = iperf_get_buffer_len(&ctrl);
-  ctrl.buffer = (FAR uint8_t *)malloc(ctrl.buffer_len);
-  if (ctrl.buffer == NULL)
+  for (i = 0; i < nstreams; i++)
     {
-      printf("create buffer: not enough memory\n");
-      return -1;
+      memcpy(&ctrl[i].cfg, cfg, sizeof(*cfg));
+      ctrl[i].finish = false;
+      ctrl[i].leader = ctrl;
+      ctrl[i].nstreams = nstreams;
+      ctrl[i].sockfd = -1;
+      ctrl[i].cpu = -1;
+      ctrl[i].buffer_len = iperf_get_buffer_len(&ctrl[i]);
+      ctrl[i].buffer = (FAR uint8_t *)calloc(1, ctrl[i].buffer_len);
+      if (ctrl[i].buffer == NULL)
+        {
+          printf("create buffer: not enough memory\n");
+          goto errout;
+        }
     }
 
-  memset(ctrl.buffer, 0, ctrl.buffer_len);
-  pthread_attr_init(&attr);
-  param.sched_priority = IPERF_TRAFFIC_TASK_PRIORITY;
-  pthread_attr_setschedparam(&attr, &param);
-  pthread_attr_setstacksize(&attr, IPERF_TRAFFIC_TASK_STACK);
-  ret = pthread_create(&thread, &attr, (FAR void *)iperf_task_traffic,
-                       &ctrl);
+  if (cfg->flag & IPERF_FLAG_LATENCY)
+    {
+      ctrl->lat = calloc(1, sizeof(struct iperf_lat_t));
+      if (ctrl->lat == NULL)
+        {
+          printf("create latency: not enough memory\n");
+          goto errout;
+        }
+    }
 
-  if (ret != 0)
+  if (iperf_is_tcp_client(ctrl) && cfg->sendfile != NULL)
     {
-      printf("iperf_task_traffic: create task failed: %d\n", ret);
-      free(ctrl.buffer);
-      ctrl.buffer = NULL;
-      return -1;
+      if (iperf_create_sendfile(ctrl) < 0)
+        {
+          goto errout;
+        }
     }
 
   pthread_mutex_lock(&g_iperf_ctrl_mutex);
-  sq_addlast((FAR sq_entry_t *)&ctrl, &g_iperf_ctrl_list);
+  for (i = 0; i < nstreams; i++)
+    {
+      sq_addlast((FAR sq_entry_t *)&ctrl[i], &g_iperf_ctrl_list);
+    }
+
   pthread_mutex_unlock(&g_iperf_ctrl_mutex);
+  return ctrl;
+
+errout:
+  iperf_free(ctrl);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: iperf_destroy
+ *
+ * Description:
+ *   Release the streams allocated by iperf_create()
+ *
+ ****************************************************************************/
 
-  pthread_join(thread, &retval);
+static void iperf_destroy(FAR struct iperf_ctrl_t *ctrl)
+{
+  int i;
 
   pthread_mutex_lock(&g_iperf_ctrl_mutex);
-  sq_rem((FAR sq_entry_t *)&ctrl, &g_iperf_ctrl_list);
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      sq_rem((FAR sq_entry_t *)&ctrl[i], &g_iperf_ctrl_list);
+    }
+
   pthread_mutex_unlock(&g_iperf_ctrl_mutex);
 
-  return 0;
+  if (iperf_is_tcp_client(ctrl) && ctrl->cfg.sendfile != NULL)
+    {
+      unlink(ctrl->cfg.sendfile);
+    }
+
+  iperf_free(ctrl);
+}
+
+#ifdef CONFIG_NETUTILS_IPERF3
+/****************************************************************************
+ * Name: iperf3_expect
+ *
+ * Description:
+ *   Receive the next state of the control connection and check it
+ *
+ ****************************************************************************/
+
+static int iperf3_expect(FAR struct iperf3_s *test, int expected)
+{
+  int state;
+
+  if (iperf3_recv_state(test->ctrlfd, &state) < 0)
+    {
+      iperf_show_socket_error_reason("iperf3 control", test->ctrlfd);
+      return -1;
+    }
+
+  if (state != expected)
+    {
+      printf("iperf3: unexpected state %d, waiting for %d%s\n",
+             state, expected, state == IPERF3_ACCESS_DENIED ?
+             " (access denied, server busy or test not supported)" : "");
+      return -1;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: iperf3_wait
+ *
+ * Description:
+ *   Wait until all streams are finished or the peer changes the state.
+ *   Returns 1 if the streams finished, 0 with the new state, or -1 if the
+ *   control connection failed.
+ *
+ ****************************************************************************/
+
+static int iperf3_wait(FAR struct iperf_ctrl_t *ctrl, FAR int *state)
+{
+  struct pollfd fds;
+  int ret;
+
+  fds.fd = ctrl->iperf3->ctrlfd;
+  fds.events = POLLIN;
+
+  while (!iperf_is_finished(ctrl))
+    {
+      ret = poll(&fds, 1, IPERF3_POLL_MS);
+      if (ret > 0)
+        {
+          return iperf3_recv_state(fds.fd, state);
+        }
+      else if (ret < 0 && errno != EINTR)
+        {
+          return -1;
+        }
+    }
+
+  return 1;
+}
+
+/****************************************************************************
+ * Name: iperf3_stream
+ *
+ * Description:
+ *   Traffic of one stream accepted by the iperf3 server
+ *
+ ****************************************************************************/
+
+static FAR void *iperf3_stream(FAR void *arg)
+{
+  FAR struct iperf_ctrl_t *ctrl = arg;
+
+  prctl(PR_SET_NAME, IPERF_TRAFFIC_TASK_NAME);
+
+  if (ctrl->leader->iperf3->params.reverse)
+    {
+      iperf_tcp_send(ctrl, ctrl->sockfd, -1);
+    }
+  else
+    {
+      iperf_tcp_recv(ctrl, ctrl->sockfd);
+    }
+
+  ctrl->finish = true;
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: iperf3_results
+ *
+ * Description:
+ *   Print the totals of the peer, or the -J document
+ *
+ ****************************************************************************/
+
+static void iperf3_results(FAR struct iperf_ctrl_t *ctrl,
+                           FAR const uintmax_t *local, double seconds)
+{
+  FAR struct iperf3_s *test = ctrl->iperf3;
+  uintmax_t total = 0;
+  bool sender;
+  int i;
+
+  sender = !(ctrl->cfg.flag & IPERF_FLAG_CLIENT) == test->params.reverse;
+  if (test->output != NULL)
+    {
+      iperf3_output_end(test->output, ctrl->nstreams,
+                        sender ? local : test->remote_bytes,
+                        sender ? test->remote_bytes : local,
+                        seconds, ctrl->cpu, test->remote_cpu);
+      test->output = NULL;
+      return;
+    }
+
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      total += test->remote_bytes[i];
+    }
+
+  printf("remote %s:\n", sender ? "receiver" : "sender");
+  iperf_print_interval("[RMT] ", 0, seconds, total, test->remote_cpu);
+}
+
+/****************************************************************************
+ * Name: iperf3_end
+ *
+ * Description:
+ *   Stop the streams of a test and free them.  The results are printed
+ *   after the report summary if bytes is not NULL.
+ *
+ ****************************************************************************/
+
+static void iperf3_end(FAR struct iperf_ctrl_t *ctrl, int started,
+                       FAR const uintmax_t *bytes, double seconds)
+{
+  int i;
+
+  /* Streams still waiting for the test to start give up */
+
+  iperf_finish(ctrl);
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      sem_post(&ctrl->iperf3->start);
+      if (ctrl[i].sockfd >= 0)
+        {
+          shutdown(ctrl[i].sockfd, SHUT_RDWR);
+        }
+    }
+
+  while (started-- > 0)
+    {
+      pthread_join(ctrl[started].thread, NULL);
+    }
+
+  if (ctrl->report)
+    {
+      pthread_join(ctrl->report_thread, NULL);
+      ctrl->report = false;
+    }
+
+  if (bytes != NULL)
+    {
+      iperf3_results(ctrl, bytes, seconds);
+    }
+
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      if (ctrl[i].sockfd >= 0)
+        {
+          close(ctrl[i].sockfd);
+        }
+    }
+
+  iperf_destroy(ctrl);
+}
+
+/****************************************************************************
+ * Name: iperf3_client
+ *
+ * Description:
+ *   Run a test against an iperf3 server.  The streams are the usual tcp
+ *   client traffic threads, they only add the cookie and wait for the
+ *   server to start the test.
+ *
+ ****************************************************************************/
+
+static int iperf3_client(FAR struct iperf_cfg_t *cfg)
+{
+  FAR struct iperf_ctrl_t *ctrl = NULL;
+  FAR uintmax_t *bytes = NULL;
+  struct sockaddr_in addr;
+  struct iperf3_s test;
+  struct timespec now;
+  FAR cJSON *json;
+  double seconds = 0.0;
+  int started = 0;
+  int state;
+  int ret = -1;
+  int i;
+
+  memset(&test, 0, sizeof(test));
+  test.ctrlfd = -1;
+  sem_init(&test.start, 0, 0);
+  iperf3_make_cookie(test.cookie);
+  test.params.tcp = true;
+  test.params.reverse = !!(cfg->flag & IPERF_FLAG_REVERSE);
+  test.params.time = cfg->time;
+  test.params.parallel = MAX(cfg->parallel, 1);
+  test.params.len = cfg->buffer_len != 0 ?
+                    cfg->buffer_len : IPERF_TCP_TX_LEN;
+
+  bytes = calloc(2 * test.params.parallel, sizeof(uintmax_t));
+  if (bytes == NULL)
+    {
+      printf("create results: not enough memory\n");
+      goto out;
+    }
+
+  test.remote_bytes = bytes + test.params.parallel;
+
+  test.ctrlfd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (test.ctrlfd < 0)
+    {
+      iperf_show_socket_error_reason("iperf3 control", test.ctrlfd);
+      goto out;
+    }
+
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(cfg->dport);
+  addr.sin_addr.s_addr = cfg->dip;
+
+  if (connect(test.ctrlfd, (FAR struct sockaddr *)&addr,
+              sizeof(addr)) < 0)
+    {
+      iperf_show_socket_error_reason("iperf3 connect", test.ctrlfd);
+      goto out;
+    }
+
+  if (iperf3_send(test.ctrlfd, test.cookie, IPERF3_COOKIE_SIZE) < 0 ||
+      iperf3_expect(&test, IPERF3_PARAM_EXCHANGE) < 0 ||
+      iperf3_send_params(test.ctrlfd, &test.params) < 0 ||
+      iperf3_expect(&test, IPERF3_CREATE_STREAMS) < 0)
+    {
+      goto out;
+    }
+
+  ctrl = iperf_create(cfg, test.params.parallel);
+  if (ctrl == NULL)
+    {
+      iperf3_send_state(test.ctrlfd, IPERF3_CLIENT_TERMINATE);
+      goto out;
+    }
+
+  ctrl->iperf3 = &test;
+  if (cfg->flag & IPERF_FLAG_JSON)
+    {
+      test.output = iperf3_output_create(&test, cfg->host, cfg->dport);
+    }
+
+  for (started = 0; started < ctrl->nstreams; started++)
+    {
+      if (iperf_start_traffic(&ctrl[started],
+                              (pthread_startroutine_t)iperf_task_traffic,
+                              &ctrl[started].thread) < 0)
+        {
+          iperf3_send_state(test.ctrlfd, IPERF3_CLIENT_TERMINATE);
+          goto out;
+        }
+    }
+
+  if (iperf3_expect(&test, IPERF3_TEST_START) < 0 ||
+      iperf3_expect(&test, IPERF3_TEST_RUNNING) < 0)
+    {
+      goto out;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &test.start_time);
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      sem_post(&test.start);
+    }
+
+  /* The report task ends the test after cfg->time */
+
+  if (iperf3_wait(ctrl, &state) != 1)
+    {
+      printf("iperf3: test ended by the server\n");
+      goto out;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  seconds = ts_diff(&now, &test.start_time);
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      bytes[i] = ctrl[i].total_len;
+    }
+
+  if (iperf3_send_state(test.ctrlfd, IPERF3_TEST_END) < 0 ||
+      iperf3_expect(&test, IPERF3_EXCHANGE_RESULTS) < 0 ||
+      iperf3_send_results(test.ctrlfd, ctrl->cpu, ctrl->nstreams, bytes,
+                          seconds) < 0)
+    {
+      goto out;
+    }
+
+  json = iperf3_recv_json(test.ctrlfd);
+  if (json == NULL ||
+      iperf3_parse_results(json, &test.remote_cpu, ctrl->nstreams,
+                           test.remote_bytes) < 0)
+    {
+      printf("iperf3: bad results from the server\n");
+      cJSON_Delete(json);
+      goto out;
+    }
+
+  cJSON_Delete(json);
+  if (iperf3_expect(&test, IPERF3_DISPLAY_RESULTS) < 0)
+    {
+      goto out;
+    }
+
+  iperf3_send_state(test.ctrlfd, IPERF3_IPERF_DONE);
+  ret = 0;
+
+out:
+  if (ctrl != NULL)
+    {
+      iperf3_end(ctrl, started, ret == 0 ? bytes : NULL, seconds);
+    }
+
+  if (test.output != NULL)
+    {
+      cJSON_Delete(test.output);
+    }
+
+  if (test.ctrlfd >= 0)
+    {
+      close(test.ctrlfd);
+    }
+
+  sem_destroy(&test.start);
+  free(bytes);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: iperf3_server
+ *
+ * Description:
+ *   Serve one test of an iperf3 client.  The control connection and the
+ *   streams arrive on the same port, the streams are told apart by the
+ *   cookie they send first.
+ *
+ ****************************************************************************/
+
+static int iperf3_server(FAR struct iperf_cfg_t *cfg)
+{
+  FAR struct iperf_ctrl_t *ctrl = NULL;
+  FAR uintmax_t *bytes = NULL;
+  char cookie[IPERF3_COOKIE_SIZE];
+  struct sockaddr_in remote_addr;
+  struct sockaddr_in addr;
+  struct iperf_cfg_t scfg;
+  struct iperf3_s test;
+  struct timespec now;
+  struct timeval t;
+  socklen_t addrlen;
+  FAR cJSON *json;
+  double seconds = 0.0;
+  int listenfd;
+  int started = 0;
+  int state;
+  int ret = -1;
+  int opt = 1;
+  int fd;
+  int i;
+
+  memset(&test, 0, sizeof(test));
+  test.ctrlfd = -1;
+  sem_init(&test.start, 0, 0);
+
+  listenfd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (listenfd < 0)
+    {
+      iperf_show_socket_error_reason("iperf3 server create", listenfd);
+      goto out;
+    }
+
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(cfg->sport);
+  addr.sin_addr.s_addr = cfg->sip;
+
+  setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+  if (bind(listenfd, (FAR struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(listenfd, 5) < 0)
+    {
+      iperf_show_socket_error_reason("iperf3 server listen", listenfd);
+      goto out;
+    }
+
+  addrlen = sizeof(remote_addr);
+  test.ctrlfd = accept(listenfd, (FAR struct sockaddr *)&remote_addr,
+                       &addrlen);
+  if (test.ctrlfd < 0)
+    {
+      iperf_show_socket_error_reason("iperf3 server accept", listenfd);
+      goto out;
+    }
+
+  if (!(cfg->flag & IPERF_FLAG_JSON))
+    {
+      iperf_print_addr("accept", (FAR struct sockaddr *)&remote_addr);
+    }
+
+  if (iperf3_recv(test.ctrlfd, test.cookie, IPERF3_COOKIE_SIZE) < 0 ||
+      iperf3_send_state(test.ctrlfd, IPERF3_PARAM_EXCHANGE) < 0)
+    {
+      goto out;
+    }
+
+  test.cookie[IPERF3_COOKIE_SIZE - 1] = '\0';
+  json = iperf3_recv_json(test.ctrlfd);
+  ret = json != NULL ? iperf3_parse_params(json, &test.params) : -EINVAL;
+  cJSON_Delete(json);
+  if (ret < 0)
+    {
+      printf("iperf3: test refused: %d\n", ret);
+      iperf3_send_state(test.ctrlfd, IPERF3_ACCESS_DENIED);
+      ret = -1;
+      goto out;
+    }
+
+  ret = -1;
+
+  /* The report runs until the client ends the test */
+
+  memcpy(&scfg, cfg, sizeof(scfg));
+  scfg.time = 0;
+  if (test.params.len != 0)
+    {
+      scfg.buffer_len = test.params.len;
+    }
+
+  bytes = calloc(2 * test.params.parallel, sizeof(uintmax_t));
+  if (bytes != NULL)
+    {
+      test.remote_bytes = bytes + test.params.parallel;
+      ctrl = iperf_create(&scfg, test.params.parallel);
+    }
+
+  if (ctrl == NULL)
+    {
+      iperf3_send_state(test.ctrlfd, IPERF3_ACCESS_DENIED);
+      goto out;
+    }
+
+  ctrl->iperf3 = &test;
+  if (cfg->flag & IPERF_FLAG_JSON)
+    {
+      test.output = iperf3_output_create(&test, NULL, 0);
+    }
+
+  if (iperf3_send_state(test.ctrlfd, IPERF3_CREATE_STREAMS) < 0)
+    {
+      goto out;
+    }
+
+  for (i = 0; i < ctrl->nstreams; )
+    {
+      fd = accept(listenfd, NULL, NULL);
+      if (fd < 0)
+        {
+          iperf_show_socket_error_reason("iperf3 server accept", listenfd);
+          goto out;
+        }
+
+      if (iperf3_recv(fd, cookie, IPERF3_COOKIE_SIZE) < 0 ||
+          memcmp(cookie, test.cookie, IPERF3_COOKIE_SIZE - 1) != 0)
+        {
+          printf("iperf3: connection of another test refused\n");
+          close(fd);
+          continue;
+        }
+
+      t.tv_sec = IPERF_SOCKET_RX_TIMEOUT;
+      t.tv_usec = 0;
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
+      ctrl[i++].sockfd = fd;
+    }
+
+  if (iperf3_send_state(test.ctrlfd, IPERF3_TEST_START) < 0 ||
+      iperf3_send_state(test.ctrlfd, IPERF3_TEST_RUNNING) < 0)
+    {
+      goto out;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &test.start_time);
+  iperf_start_report(ctrl);
+  for (started = 0; started < ctrl->nstreams; started++)
+    {
+      if (iperf_start_traffic(&ctrl[started], iperf3_stream,
+                              &ctrl[started].thread) < 0)
+        {
+          iperf3_send_state(test.ctrlfd, IPERF3_SERVER_TERMINATE);
+          goto out;
+        }
+    }
+
+  ret = iperf3_wait(ctrl, &state);
+  if (ret != 0 || state != IPERF3_TEST_END)
+    {
+      printf("iperf3: test aborted\n");
+      if (ret == 1)
+        {
+          iperf3_send_state(test.ctrlfd, IPERF3_SERVER_TERMINATE);
+        }
+
+      ret = -1;
+      goto out;
+    }
+
+  ret = -1;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  seconds = ts_diff(&now, &test.start_time);
+  iperf_finish(ctrl);
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      bytes[i] = ctrl[i].total_len;
+    }
+
+  if (iperf3_send_state(test.ctrlfd, IPERF3_EXCHANGE_RESULTS) < 0)
+    {
+      goto out;
+    }
+
+  json = iperf3_recv_json(test.ctrlfd);
+  if (json == NULL ||
+      iperf3_parse_results(json, &test.remote_cpu, ctrl->nstreams,
+                           test.remote_bytes) < 0)
+    {
+      printf("iperf3: bad results from the client\n");
+      cJSON_Delete(json);
+      goto out;
+    }
+
+  cJSON_Delete(json);
+  if (iperf3_send_results(test.ctrlfd, ctrl->cpu, ctrl->nstreams, bytes,
+                          seconds) < 0 ||
+      iperf3_send_state(test.ctrlfd, IPERF3_DISPLAY_RESULTS) < 0)
+    {
+      goto out;
+    }
+
+  /* The client closes the connections after IPERF_DONE */
+
+  iperf3_recv_state(test.ctrlfd, &state);
+  ret = 0;
+
+out:
+  if (ctrl != NULL)
+    {
+      iperf3_end(ctrl, started, ret == 0 ? bytes : NULL, seconds);
+    }
+
+  if (test.output != NULL)
+    {
+      cJSON_Delete(test.output);
+    }
+
+  if (test.ctrlfd >= 0)
+    {
+      close(test.ctrlfd);
+    }
+
+  if (listenfd >= 0)
+    {
+      close(listenfd);
+    }
+
+  sem_destroy(&test.start);
+  free(bytes);
+  return ret;
+}
+#endif /* CONFIG_NETUTILS_IPERF3 */
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iperf_start
+ *
+ * Description:
+ *   Start iperf task.
+ *
+ ****************************************************************************/
+
+int iperf_start(FAR struct iperf_cfg_t *cfg)
+{
+  FAR struct iperf_ctrl_t *ctrl;
+  uint16_t nstreams;
+  int ret = 0;
+  int i;
+
+  if (!cfg)
+    {
+      return -1;
+    }
+
+#ifdef CONFIG_NETUTILS_IPERF3
+  if (cfg->flag & IPERF_FLAG_IPERF3)
+    {
+      return (cfg->flag & IPERF_FLAG_CLIENT) ?
+             iperf3_client(cfg) : iperf3_server(cfg);
+    }
+#endif
+
+  /* All parallel streams of the UDP server arrive on the same socket */
+
+  nstreams = MAX(cfg->parallel, 1);
+  if ((cfg->flag & IPERF_FLAG_SERVER) && (cfg->flag & IPERF_FLAG_UDP))
+    {
+      nstreams = 1;
+    }
+
+  ctrl = iperf_create(cfg, nstreams);
+  if (ctrl == NULL)
+    {
+      return -1;
+    }
+
+  /* Each client stream runs its own connection, the server accepts all
+   * of them from the first stream.
+   */
+
+  if (!(cfg->flag & IPERF_FLAG_CLIENT))
+    {
+      nstreams = 1;
+    }
+
+  for (i = 0; i < nstreams; i++)
+    {
+      if (iperf_start_traffic(&ctrl[i],
+                              (pthread_startroutine_t)iperf_task_traffic,
+                              &ctrl[i].thread) < 0)
+        {
+          iperf_finish(ctrl);
+          ret = -1;
+          break;
+        }
+    }
+
+  while (i-- > 0)
+    {
+      pthread_join(ctrl[i].thread, NULL);
+    }
+
+  /* Let the report print the summary before the streams go away */
+
+  iperf_finish(ctrl);
+  if (ctrl->report)
+    {
+      pthread_join(ctrl->report_thread, NULL);
+    }
+
+  iperf_destroy(ctrl);
+  return ret;
 }
 
 /****************************************************************************
@@ -44,12 +44,16 @@ extern "C"
  * Pre-processor Definitions
  ****************************************************************************/
 
-#define IPERF_FLAG_CLIENT (1 << 0)
-#define IPERF_FLAG_SERVER (1 << 1)
-#define IPERF_FLAG_TCP    (1 << 2)
-#define IPERF_FLAG_UDP    (1 << 3)
-#define IPERF_FLAG_LOCAL  (1 << 4)
-#define IPERF_FLAG_RPMSG  (1 << 5)
+#define IPERF_FLAG_CLIENT  (1 << 0)
+#define IPERF_FLAG_SERVER  (1 << 1)
+#define IPERF_FLAG_TCP     (1 << 2)
+#define IPERF_FLAG_UDP     (1 << 3)
+#define IPERF_FLAG_LOCAL   (1 << 4)
+#define IPERF_FLAG_RPMSG   (1 << 5)
+#define IPERF_FLAG_LATENCY (1 << 6)
+#define IPERF_FLAG_IPERF3  (1 << 7)
+#define IPERF_FLAG_REVERSE (1 << 8)
+#define IPERF_FLAG_JSON    (1 << 9)
 
 /****************************************************************************
  * Public Types
@@ -64,8 +68,11 @@ struct iperf_cfg_t
   uint16_t sport;
   uint32_t interval;
   uint32_t time;
+  uint16_t parallel;    /* number of parallel streams */
+  uint32_t buffer_len;  /* read/write length, 0 for the default */
   FAR const char *host; /* host name (dip) or rpmsg cpu */
   FAR const char *path; /* local path or rpmsg name */
+  FAR const char *sendfile; /* tcp client sends from this file */
 };
 
 /****************************************************************************
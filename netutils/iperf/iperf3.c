@@ -0,0 +1,604 @@
+/****************************************************************************
+ * apps/netutils/iperf/iperf3.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include <sys/socket.h>
+
+#include "iperf3.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define IPERF3_VERSION             "3.1 (NuttX)"
+#define IPERF3_MAX_JSON            (64 * 1024)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const char g_cookie_chars[] = "abcdefghijklmnopqrstuvwxyz234567";
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iperf3_get_number
+ *
+ * Description:
+ *   Get a number member of an object, def if it is missing
+ *
+ ****************************************************************************/
+
+static double iperf3_get_number(FAR cJSON *json, FAR const char *name,
+                                double def)
+{
+  FAR cJSON *item = cJSON_GetObjectItem(json, name);
+
+  return cJSON_IsNumber(item) ? item->valuedouble : def;
+}
+
+/****************************************************************************
+ * Name: iperf3_add_sum
+ *
+ * Description:
+ *   Add an interval or total object as iperf3 reports them
+ *
+ ****************************************************************************/
+
+static FAR cJSON *iperf3_add_sum(FAR cJSON *parent, FAR const char *name,
+                                 int id, uintmax_t bytes, double start,
+                                 double end, bool sender)
+{
+  FAR cJSON *sum = cJSON_CreateObject();
+
+  if (sum == NULL)
+    {
+      return NULL;
+    }
+
+  if (id > 0)
+    {
+      cJSON_AddNumberToObject(sum, "socket", id);
+    }
+
+  cJSON_AddNumberToObject(sum, "start", start);
+  cJSON_AddNumberToObject(sum, "end", end);
+  cJSON_AddNumberToObject(sum, "seconds", end - start);
+  cJSON_AddNumberToObject(sum, "bytes", bytes);
+  cJSON_AddNumberToObject(sum, "bits_per_second",
+                          end > start ? bytes * 8 / (end - start) : 0);
+  if (sender)
+    {
+      cJSON_AddNumberToObject(sum, "retransmits", 0);
+    }
+
+  cJSON_AddBoolToObject(sum, "omitted", false);
+  cJSON_AddBoolToObject(sum, "sender", sender);
+
+  if (name != NULL)
+    {
+      cJSON_AddItemToObject(parent, name, sum);
+    }
+  else
+    {
+      cJSON_AddItemToArray(parent, sum);
+    }
+
+  return sum;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iperf3_make_cookie
+ ****************************************************************************/
+
+void iperf3_make_cookie(FAR char *cookie)
+{
+  int i;
+
+  for (i = 0; i < IPERF3_COOKIE_SIZE - 1; i++)
+    {
+      cookie[i] = g_cookie_chars[arc4random_uniform(
+                                   sizeof(g_cookie_chars) - 1)];
+    }
+
+  cookie[i] = '\0';
+}
+
+/****************************************************************************
+ * Name: iperf3_send
+ ****************************************************************************/
+
+int iperf3_send(int fd, FAR const void *buf, size_t len)
+{
+  FAR const uint8_t *ptr = buf;
+  ssize_t ret;
+
+  while (len > 0)
+    {
+      ret = send(fd, ptr, len, 0);
+      if (ret < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      else if (ret <= 0)
+        {
+          return -1;
+        }
+
+      ptr += ret;
+      len -= ret;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: iperf3_recv
+ ****************************************************************************/
+
+int iperf3_recv(int fd, FAR void *buf, size_t len)
+{
+  FAR uint8_t *ptr = buf;
+  ssize_t ret;
+
+  while (len > 0)
+    {
+      ret = recv(fd, ptr, len, 0);
+      if (ret < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      else if (ret <= 0)
+        {
+          return -1;
+        }
+
+      ptr += ret;
+      len -= ret;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: iperf3_send_state
+ ****************************************************************************/
+
+int iperf3_send_state(int fd, int state)
+{
+  int8_t value = state;
+
+  return iperf3_send(fd, &value, sizeof(value));
+}
+
+/****************************************************************************
+ * Name: iperf3_recv_state
+ ****************************************************************************/
+
+int iperf3_recv_state(int fd, FAR int *state)
+{
+  int8_t value;
+
+  if (iperf3_recv(fd, &value, sizeof(value)) < 0)
+    {
+      return -1;
+    }
+
+  *state = value;
+  return 0;
+}
+
+/****************************************************************************
+ * Name: iperf3_send_json
+ ****************************************************************************/
+
+int iperf3_send_json(int fd, FAR cJSON *json)
+{
+  FAR char *str;
+  uint32_t len;
+  int ret = -1;
+
+  str = cJSON_PrintUnformatted(json);
+  if (str == NULL)
+    {
+      return -1;
+    }
+
+  len = htonl(strlen(str));
+  if (iperf3_send(fd, &len, sizeof(len)) == 0 &&
+      iperf3_send(fd, str, strlen(str)) == 0)
+    {
+      ret = 0;
+    }
+
+  cJSON_free(str);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: iperf3_recv_json
+ ****************************************************************************/
+
+FAR cJSON *iperf3_recv_json(int fd)
+{
+  FAR cJSON *json = NULL;
+  FAR char *str;
+  uint32_t len;
+
+  if (iperf3_recv(fd, &len, sizeof(len)) < 0)
+    {
+      return NULL;
+    }
+
+  len = ntohl(len);
+  if (len == 0 || len > IPERF3_MAX_JSON)
+    {
+      return NULL;
+    }
+
+  str = malloc(len + 1);
+  if (str == NULL)
+    {
+      return NULL;
+    }
+
+  if (iperf3_recv(fd, str, len) == 0)
+    {
+      str[len] = '\0';
+      json = cJSON_Parse(str);
+    }
+
+  free(str);
+  return json;
+}
+
+/****************************************************************************
+ * Name: iperf3_send_params
+ ****************************************************************************/
+
+int iperf3_send_params(int fd, FAR const struct iperf3_params_s *params)
+{
+  FAR cJSON *json;
+  int ret;
+
+  json = cJSON_CreateObject();
+  if (json == NULL)
+    {
+      return -1;
+    }
+
+  cJSON_AddBoolToObject(json, params->tcp ? "tcp" : "udp", true);
+  cJSON_AddNumberToObject(json, "omit", 0);
+  cJSON_AddNumberToObject(json, "time", params->time);
+  cJSON_AddNumberToObject(json, "num", 0);
+  cJSON_AddNumberToObject(json, "blockcount", 0);
+  cJSON_AddNumberToObject(json, "parallel", params->parallel);
+  cJSON_AddNumberToObject(json, "len", params->len);
+  if (params->reverse)
+    {
+      cJSON_AddBoolToObject(json, "reverse", true);
+    }
+
+  cJSON_AddNumberToObject(json, "pacing_timer", 1000);
+  cJSON_AddStringToObject(json, "client_version", IPERF3_VERSION);
+
+  ret = iperf3_send_json(fd, json);
+  cJSON_Delete(json);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: iperf3_parse_params
+ ****************************************************************************/
+
+int iperf3_parse_params(FAR cJSON *json,
+                        FAR struct iperf3_params_s *params)
+{
+  double value;
+
+  memset(params, 0, sizeof(*params));
+
+  params->tcp = cJSON_IsTrue(cJSON_GetObjectItem(json, "tcp"));
+  params->reverse = cJSON_IsTrue(cJSON_GetObjectItem(json, "reverse"));
+  params->time = iperf3_get_number(json, "time", 10);
+  params->len = iperf3_get_number(json, "len", 0);
+
+  /* Byte or block limited tests and bidirectional mode are not
+   * supported, the client is refused and reports so.
+   */
+
+  if (iperf3_get_number(json, "num", 0) != 0 ||
+      iperf3_get_number(json, "blockcount", 0) != 0 ||
+      cJSON_IsTrue(cJSON_GetObjectItem(json, "bidirectional")))
+    {
+      return -ENOTSUP;
+    }
+
+  value = iperf3_get_number(json, "parallel", 1);
+  if (value < 1 || value > IPERF3_MAX_STREAMS)
+    {
+      return -EINVAL;
+    }
+
+  params->parallel = value;
+  return params->tcp ? 0 : -EPROTONOSUPPORT;
+}
+
+/****************************************************************************
+ * Name: iperf3_send_results
+ ****************************************************************************/
+
+int iperf3_send_results(int fd, int cpu, int nstreams,
+                        FAR const uintmax_t *bytes, double seconds)
+{
+  FAR cJSON *streams;
+  FAR cJSON *stream;
+  FAR cJSON *json;
+  double load = cpu >= 0 ? cpu / 10.0 : 0.0;
+  int ret;
+  int i;
+
+  json = cJSON_CreateObject();
+  if (json == NULL)
+    {
+      return -1;
+    }
+
+  /* The load is not split into user and system time here */
+
+  cJSON_AddNumberToObject(json, "cpu_util_total", load);
+  cJSON_AddNumberToObject(json, "cpu_util_user", load);
+  cJSON_AddNumberToObject(json, "cpu_util_system", 0);
+  cJSON_AddNumberToObject(json, "sender_has_retransmits", 0);
+
+  streams = cJSON_AddArrayToObject(json, "streams");
+  for (i = 0; streams != NULL && i < nstreams; i++)
+    {
+      stream = cJSON_CreateObject();
+      if (stream == NULL)
+        {
+          break;
+        }
+
+      cJSON_AddNumberToObject(stream, "id", i + 1);
+      cJSON_AddNumberToObject(stream, "bytes", bytes[i]);
+      cJSON_AddNumberToObject(stream, "retransmits", 0);
+      cJSON_AddNumberToObject(stream, "jitter", 0);
+      cJSON_AddNumberToObject(stream, "errors", 0);
+      cJSON_AddNumberToObject(stream, "packets", 0);
+      cJSON_AddNumberToObject(stream, "start_time", 0);
+      cJSON_AddNumberToObject(stream, "end_time", seconds);
+      cJSON_AddItemToArray(streams, stream);
+    }
+
+  ret = iperf3_send_json(fd, json);
+  cJSON_Delete(json);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: iperf3_parse_results
+ ****************************************************************************/
+
+int iperf3_parse_results(FAR cJSON *json, FAR int *cpu, int nstreams,
+                         FAR uintmax_t *bytes)
+{
+  FAR cJSON *streams;
+  FAR cJSON *stream;
+  int id;
+  int i;
+
+  *cpu = iperf3_get_number(json, "cpu_util_total", -0.1) * 10;
+
+  streams = cJSON_GetObjectItem(json, "streams");
+  if (!cJSON_IsArray(streams))
+    {
+      return -EINVAL;
+    }
+
+  for (i = 0; i < cJSON_GetArraySize(streams); i++)
+    {
+      stream = cJSON_GetArrayItem(streams, i);
+      id = iperf3_get_number(stream, "id", 0);
+      if (id < 1 || id > nstreams)
+        {
+          return -EINVAL;
+        }
+
+      bytes[id - 1] = iperf3_get_number(stream, "bytes", 0);
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: iperf3_output_create
+ ****************************************************************************/
+
+FAR cJSON *iperf3_output_create(FAR const struct iperf3_s *test,
+                                FAR const char *host, uint16_t port)
+{
+  FAR cJSON *output;
+  FAR cJSON *start;
+  FAR cJSON *item;
+
+  output = cJSON_CreateObject();
+  if (output == NULL)
+    {
+      return NULL;
+    }
+
+  start = cJSON_AddObjectToObject(output, "start");
+  if (start == NULL || cJSON_AddArrayToObject(output, "intervals") == NULL)
+    {
+      cJSON_Delete(output);
+      return NULL;
+    }
+
+  cJSON_AddStringToObject(start, "version", "iperf " IPERF3_VERSION);
+
+  item = cJSON_AddObjectToObject(start, "timestamp");
+  if (item != NULL)
+    {
+      cJSON_AddNumberToObject(item, "timesecs", time(NULL));
+    }
+
+  if (host != NULL)
+    {
+      item = cJSON_AddObjectToObject(start, "connecting_to");
+      if (item != NULL)
+        {
+          cJSON_AddStringToObject(item, "host", host);
+          cJSON_AddNumberToObject(item, "port", port);
+        }
+    }
+
+  cJSON_AddStringToObject(start, "cookie", test->cookie);
+
+  item = cJSON_AddObjectToObject(start, "test_start");
+  if (item != NULL)
+    {
+      cJSON_AddStringToObject(item, "protocol", "TCP");
+      cJSON_AddNumberToObject(item, "num_streams", test->params.parallel);
+      cJSON_AddNumberToObject(item, "blksize", test->params.len);
+      cJSON_AddNumberToObject(item, "omit", 0);
+      cJSON_AddNumberToObject(item, "duration", test->params.time);
+      cJSON_AddNumberToObject(item, "bytes", 0);
+      cJSON_AddNumberToObject(item, "blocks", 0);
+      cJSON_AddNumberToObject(item, "reverse", test->params.reverse);
+    }
+
+  return output;
+}
+
+/****************************************************************************
+ * Name: iperf3_output_interval
+ ****************************************************************************/
+
+void iperf3_output_interval(FAR cJSON *output, int nstreams,
+                            FAR const uintmax_t *bytes, double start,
+                            double end, bool sender)
+{
+  FAR cJSON *interval;
+  FAR cJSON *streams;
+  uintmax_t sum = 0;
+  int i;
+
+  interval = cJSON_CreateObject();
+  if (interval == NULL)
+    {
+      return;
+    }
+
+  cJSON_AddItemToArray(cJSON_GetObjectItem(output, "intervals"), interval);
+  streams = cJSON_AddArrayToObject(interval, "streams");
+  for (i = 0; streams != NULL && i < nstreams; i++)
+    {
+      iperf3_add_sum(streams, NULL, i + 1, bytes[i], start, end, sender);
+      sum += bytes[i];
+    }
+
+  iperf3_add_sum(interval, "sum", 0, sum, start, end, sender);
+}
+
+/****************************************************************************
+ * Name: iperf3_output_end
+ ****************************************************************************/
+
+void iperf3_output_end(FAR cJSON *output, int nstreams,
+                       FAR const uintmax_t *sent,
+                       FAR const uintmax_t *received, double seconds,
+                       int local_cpu, int remote_cpu)
+{
+  FAR cJSON *streams;
+  FAR cJSON *stream;
+  FAR cJSON *item;
+  FAR cJSON *end;
+  uintmax_t total_sent = 0;
+  uintmax_t total_received = 0;
+  FAR char *str;
+  int i;
+
+  end = cJSON_AddObjectToObject(output, "end");
+  streams = end != NULL ? cJSON_AddArrayToObject(end, "streams") : NULL;
+  for (i = 0; streams != NULL && i < nstreams; i++)
+    {
+      stream = cJSON_CreateObject();
+      if (stream == NULL)
+        {
+          break;
+        }
+
+      cJSON_AddItemToArray(streams, stream);
+      iperf3_add_sum(stream, "sender", i + 1, sent[i], 0, seconds, true);
+      iperf3_add_sum(stream, "receiver", i + 1, received[i], 0, seconds,
+                     false);
+      total_sent += sent[i];
+      total_received += received[i];
+    }
+
+  if (end != NULL)
+    {
+      iperf3_add_sum(end, "sum_sent", 0, total_sent, 0, seconds, true);
+      iperf3_add_sum(end, "sum_received", 0, total_received, 0, seconds,
+                     false);
+
+      item = cJSON_AddObjectToObject(end, "cpu_utilization_percent");
+      if (item != NULL)
+        {
+          cJSON_AddNumberToObject(item, "host_total",
+                                  MAX(local_cpu, 0) / 10.0);
+          cJSON_AddNumberToObject(item, "host_user",
+                                  MAX(local_cpu, 0) / 10.0);
+          cJSON_AddNumberToObject(item, "host_system", 0);
+          cJSON_AddNumberToObject(item, "remote_total",
+                                  MAX(remote_cpu, 0) / 10.0);
+          cJSON_AddNumberToObject(item, "remote_user",
+                                  MAX(remote_cpu, 0) / 10.0);
+          cJSON_AddNumberToObject(item, "remote_system", 0);
+        }
+    }
+
+  str = cJSON_Print(output);
+  if (str != NULL)
+    {
+      printf("%s\n", str);
+      cJSON_free(str);
+    }
+
+  cJSON_Delete(output);
+}
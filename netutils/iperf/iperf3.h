@@ -0,0 +1,202 @@
+/****************************************************************************
+ * apps/netutils/iperf/iperf3.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_NETUTILS_IPERF_IPERF3_H
+#define __APPS_NETUTILS_IPERF_IPERF3_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef CONFIG_NETUTILS_IPERF3
+
+#include "netutils/cJSON.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define IPERF3_DEFAULT_PORT        5201
+#define IPERF3_COOKIE_SIZE         37   /* 36 characters and the NUL */
+#define IPERF3_MAX_STREAMS         128
+
+/* Control channel states, one signed byte on the wire */
+
+#define IPERF3_TEST_START          1
+#define IPERF3_TEST_RUNNING        2
+#define IPERF3_TEST_END            4
+#define IPERF3_PARAM_EXCHANGE      9
+#define IPERF3_CREATE_STREAMS      10
+#define IPERF3_SERVER_TERMINATE    11
+#define IPERF3_CLIENT_TERMINATE    12
+#define IPERF3_EXCHANGE_RESULTS    13
+#define IPERF3_DISPLAY_RESULTS     14
+#define IPERF3_IPERF_DONE          16
+#define IPERF3_ACCESS_DENIED       (-1)
+#define IPERF3_SERVER_ERROR        (-2)
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Test parameters sent by the client */
+
+struct iperf3_params_s
+{
+  bool tcp;
+  bool reverse;
+  uint32_t time;
+  uint16_t parallel;
+  uint32_t len;
+};
+
+/* State of one test, shared by the control and the stream threads */
+
+struct iperf3_s
+{
+  int ctrlfd;                         /* Control connection */
+  char cookie[IPERF3_COOKIE_SIZE];    /* Identifies the test's streams */
+  struct iperf3_params_s params;
+  sem_t start;                        /* Released at TEST_RUNNING */
+  struct timespec start_time;
+  FAR cJSON *output;                  /* -J document, NULL for text */
+  FAR uintmax_t *remote_bytes;        /* Bytes counted by the peer */
+  int remote_cpu;                     /* Peer CPU load in per mille */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: iperf3_make_cookie
+ *
+ * Description:
+ *   Generate a random test cookie
+ *
+ ****************************************************************************/
+
+void iperf3_make_cookie(FAR char *cookie);
+
+/****************************************************************************
+ * Name: iperf3_send / iperf3_recv
+ *
+ * Description:
+ *   Transfer exactly len bytes on a blocking socket
+ *
+ ****************************************************************************/
+
+int iperf3_send(int fd, FAR const void *buf, size_t len);
+int iperf3_recv(int fd, FAR void *buf, size_t len);
+
+/****************************************************************************
+ * Name: iperf3_send_state / iperf3_recv_state
+ *
+ * Description:
+ *   Transfer a control channel state
+ *
+ ****************************************************************************/
+
+int iperf3_send_state(int fd, int state);
+int iperf3_recv_state(int fd, FAR int *state);
+
+/****************************************************************************
+ * Name: iperf3_send_json / iperf3_recv_json
+ *
+ * Description:
+ *   Transfer a JSON object prefixed by its length in network order.  The
+ *   object returned by iperf3_recv_json() is freed with cJSON_Delete().
+ *
+ ****************************************************************************/
+
+int iperf3_send_json(int fd, FAR cJSON *json);
+FAR cJSON *iperf3_recv_json(int fd);
+
+/****************************************************************************
+ * Name: iperf3_send_params / iperf3_parse_params
+ *
+ * Description:
+ *   Send the test parameters from the client, parse them on the server
+ *
+ ****************************************************************************/
+
+int iperf3_send_params(int fd, FAR const struct iperf3_params_s *params);
+int iperf3_parse_params(FAR cJSON *json,
+                        FAR struct iperf3_params_s *params);
+
+/****************************************************************************
+ * Name: iperf3_send_results / iperf3_parse_results
+ *
+ * Description:
+ *   Exchange the per stream byte counts and the CPU load (in per mille,
+ *   negative if unknown) at the end of a test
+ *
+ ****************************************************************************/
+
+int iperf3_send_results(int fd, int cpu, int nstreams,
+                        FAR const uintmax_t *bytes, double seconds);
+int iperf3_parse_results(FAR cJSON *json, FAR int *cpu, int nstreams,
+                         FAR uintmax_t *bytes);
+
+/****************************************************************************
+ * Name: iperf3_output_create
+ *
+ * Description:
+ *   Create the -J document with the "start" section
+ *
+ ****************************************************************************/
+
+FAR cJSON *iperf3_output_create(FAR const struct iperf3_s *test,
+                                FAR const char *host, uint16_t port);
+
+/****************************************************************************
+ * Name: iperf3_output_interval
+ *
+ * Description:
+ *   Append one report interval to the -J document
+ *
+ ****************************************************************************/
+
+void iperf3_output_interval(FAR cJSON *output, int nstreams,
+                            FAR const uintmax_t *bytes, double start,
+                            double end, bool sender);
+
+/****************************************************************************
+ * Name: iperf3_output_end
+ *
+ * Description:
+ *   Add the "end" section, print the -J document and free it
+ *
+ ****************************************************************************/
+
+void iperf3_output_end(FAR cJSON *output, int nstreams,
+                       FAR const uintmax_t *sent,
+                       FAR const uintmax_t *received, double seconds,
+                       int local_cpu, int remote_cpu);
+
+#endif /* CONFIG_NETUTILS_IPERF3 */
+#endif /* __APPS_NETUTILS_IPERF_IPERF3_H */
@@ -31,6 +31,7 @@
 
 #include "argtable3.h"
 #include "iperf.h"
+#include "iperf3.h"
 #include "netutils/netlib.h"
 
 /****************************************************************************
@@ -46,6 +47,8 @@
 #define IPERF_DEFAULT_PORT     5001
 #define IPERF_DEFAULT_INTERVAL 3
 #define IPERF_DEFAULT_TIME     30
+#define IPERF_MAX_PARALLEL     64
+#define IPERF_MAX_UDP_LEN      65507
 
 /****************************************************************************
  * Private Types
@@ -62,6 +65,15 @@ struct wifi_iperf_t
   FAR struct arg_int *port;
   FAR struct arg_int *interval;
   FAR struct arg_int *time;
+  FAR struct arg_int *parallel;
+  FAR struct arg_int *len;
+  FAR struct arg_str *sendfile;
+  FAR struct arg_lit *latency;
+#ifdef CONFIG_NETUTILS_IPERF3
+  FAR struct arg_lit *iperf3;
+  FAR struct arg_lit *reverse;
+  FAR struct arg_lit *json;
+#endif
   FAR struct arg_lit *abort;
   FAR struct arg_end *end;
 };
@@ -82,7 +94,12 @@ static void iperf_showusage(FAR const char *progname,
                             FAR struct wifi_iperf_t *args, int exitcode)
 {
   printf("USAGE: %s [-sua] [-c <ip|cpu>] [-p <port>] [-i <interval>] "
-         "[-t <time>] [--local <path>] [--rpmsg <name>]\n", progname);
+         "[-t <time>] [-P <streams>] [-l <len>] [--sendfile <path>] "
+         "[--latency] [--local <path>] [--rpmsg <name>]"
+#ifdef CONFIG_NETUTILS_IPERF3
+         " [-3RJ]"
+#endif
+         "\n", progname);
   printf("iperf command:\n");
   arg_print_glossary(stdout, (FAR void **)args, NULL);
 
@@ -102,7 +119,8 @@ static void iperf_printcfg(FAR struct iperf_cfg_t *cfg)
 {
   printf("\n mode=%s%s-%s ",
          cfg->flag & IPERF_FLAG_LOCAL ? "local-":
-           cfg->flag & IPERF_FLAG_RPMSG ? "rpmsg-":"",
+           cfg->flag & IPERF_FLAG_RPMSG ? "rpmsg-":
+           cfg->flag & IPERF_FLAG_IPERF3 ? "iperf3-":"",
          cfg->flag & IPERF_FLAG_TCP ? "tcp":"udp",
          cfg->flag & IPERF_FLAG_SERVER ? "server":"client");
 
@@ -124,8 +142,25 @@ static void iperf_printcfg(FAR struct iperf_cfg_t *cfg)
              (cfg->dip >> 16) & 0xff, (cfg->dip >> 24) & 0xff, cfg->dport);
     }
 
-  printf("interval=%" PRId32 ", time=%" PRId32 "\n",
-         cfg->interval, cfg->time);
+  printf("interval=%" PRId32 ", time=%" PRId32 ", parallel=%d",
+         cfg->interval, cfg->time, cfg->parallel);
+
+  if (cfg->buffer_len != 0)
+    {
+      printf(", len=%" PRIu32, cfg->buffer_len);
+    }
+
+  if (cfg->sendfile != NULL)
+    {
+      printf(", sendfile=%s", cfg->sendfile);
+    }
+
+  if (cfg->flag & IPERF_FLAG_REVERSE)
+    {
+      printf(", reverse");
+    }
+
+  printf("\n");
 }
 
 /****************************************************************************
@@ -137,6 +172,7 @@ int main(int argc, FAR char *argv[])
   struct wifi_iperf_t iperf_args;
   struct iperf_cfg_t cfg;
   struct in_addr addr;
+  uint16_t port = IPERF_DEFAULT_PORT;
   int nerrors;
   char inetaddr[INET_ADDRSTRLEN];
 
@@ -156,6 +192,24 @@ int main(int argc, FAR char *argv[])
                             "seconds between periodic bandwidth reports");
   iperf_args.time = arg_int0("t", "time", "<time>",
                         "time in seconds to transmit for (default 10 secs)");
+  iperf_args.parallel = arg_int0("P", "parallel", "<streams>",
+                        "number of parallel TCP streams (default 1)");
+  iperf_args.len = arg_int0("l", "len", "<len>",
+                        "length of each read/write, accepts KB/MB suffix");
+  iperf_args.sendfile = arg_str0(NULL, "sendfile", "<path>",
+                        "tcp client sends with sendfile() from <path>, "
+                        "created on a RAM backed fs such as /tmp");
+  iperf_args.latency = arg_lit0(NULL, "latency",
+                        "udp server reports one-way delay percentiles, "
+                        "needs synchronized clocks (ptpd)");
+#ifdef CONFIG_NETUTILS_IPERF3
+  iperf_args.iperf3 = arg_lit0("3", "iperf3",
+                        "speak the iperf3 protocol (tcp, default port "
+                        "5201)");
+  iperf_args.reverse = arg_lit0("R", "reverse",
+                        "iperf3 client receives, the server sends");
+  iperf_args.json = arg_lit0("J", "json", "iperf3 results in JSON");
+#endif
   iperf_args.abort = arg_lit0("a", "abort", "abort running iperf");
   iperf_args.end = arg_end(1);
 
@@ -243,7 +297,13 @@ int main(int argc, FAR char *argv[])
             }
         }
 
-      printf("     IP: %s\n", inet_ntoa_r(addr, inetaddr, sizeof(inetaddr)));
+#ifdef CONFIG_NETUTILS_IPERF3
+      if (iperf_args.json->count == 0)
+#endif
+        {
+          printf("     IP: %s\n",
+                 inet_ntoa_r(addr, inetaddr, sizeof(inetaddr)));
+        }
 
       cfg.sip = addr.s_addr;
     }
@@ -257,21 +317,57 @@ int main(int argc, FAR char *argv[])
       cfg.flag |= IPERF_FLAG_UDP;
     }
 
+#ifdef CONFIG_NETUTILS_IPERF3
+  if (iperf_args.iperf3->count > 0)
+    {
+      if (!(cfg.flag & IPERF_FLAG_TCP) ||
+          (cfg.flag & (IPERF_FLAG_LOCAL | IPERF_FLAG_RPMSG)))
+        {
+          printf("ERROR: iperf3 mode supports tcp over ip only\n");
+          goto out;
+        }
+
+      cfg.flag |= IPERF_FLAG_IPERF3;
+      port = IPERF3_DEFAULT_PORT;
+    }
+
+  if (iperf_args.reverse->count > 0 || iperf_args.json->count > 0)
+    {
+      if (!(cfg.flag & IPERF_FLAG_IPERF3) ||
+          (iperf_args.reverse->count > 0 &&
+           !(cfg.flag & IPERF_FLAG_CLIENT)))
+        {
+          printf("ERROR: -R is an iperf3 client option, -J needs -3\n");
+          goto out;
+        }
+
+      if (iperf_args.reverse->count > 0)
+        {
+          cfg.flag |= IPERF_FLAG_REVERSE;
+        }
+
+      if (iperf_args.json->count > 0)
+        {
+          cfg.flag |= IPERF_FLAG_JSON;
+        }
+    }
+#endif
+
   if (iperf_args.port->count == 0)
     {
-      cfg.sport = IPERF_DEFAULT_PORT;
-      cfg.dport = IPERF_DEFAULT_PORT;
+      cfg.sport = port;
+      cfg.dport = port;
     }
   else
     {
       if (cfg.flag & IPERF_FLAG_SERVER)
         {
           cfg.sport = iperf_args.port->ival[0];
-          cfg.dport = IPERF_DEFAULT_PORT;
+          cfg.dport = port;
         }
       else
         {
-          cfg.sport = IPERF_DEFAULT_PORT;
+          cfg.sport = port;
           cfg.dport = iperf_args.port->ival[0];
         }
     }
@@ -311,7 +407,65 @@ int main(int argc, FAR char *argv[])
         }
     }
 
-  iperf_printcfg(&cfg);
+  if (iperf_args.parallel->count == 0)
+    {
+      cfg.parallel = 1;
+    }
+  else
+    {
+      if (iperf_args.parallel->ival[0] <= 0 ||
+          iperf_args.parallel->ival[0] > IPERF_MAX_PARALLEL)
+        {
+          printf("ERROR: parallel streams should be 1..%d\n",
+                 IPERF_MAX_PARALLEL);
+          goto out;
+        }
+
+      cfg.parallel = iperf_args.parallel->ival[0];
+    }
+
+  if (iperf_args.len->count > 0)
+    {
+      if (iperf_args.len->ival[0] < (int)(3 * sizeof(uint32_t)) ||
+          ((cfg.flag & IPERF_FLAG_UDP) &&
+           iperf_args.len->ival[0] > IPERF_MAX_UDP_LEN))
+        {
+          printf("ERROR: invalid length %d\n", iperf_args.len->ival[0]);
+          goto out;
+        }
+
+      cfg.buffer_len = iperf_args.len->ival[0];
+    }
+
+  if (iperf_args.sendfile->count > 0)
+    {
+      if ((cfg.flag & (IPERF_FLAG_CLIENT | IPERF_FLAG_TCP)) !=
+          (IPERF_FLAG_CLIENT | IPERF_FLAG_TCP))
+        {
+          printf("ERROR: sendfile is a tcp client option\n");
+          goto out;
+        }
+
+      cfg.sendfile = iperf_args.sendfile->sval[0];
+    }
+
+  if (iperf_args.latency->count > 0)
+    {
+      if ((cfg.flag & (IPERF_FLAG_SERVER | IPERF_FLAG_UDP)) !=
+          (IPERF_FLAG_SERVER | IPERF_FLAG_UDP))
+        {
+          printf("ERROR: latency is a udp server option\n");
+          goto out;
+        }
+
+      cfg.flag |= IPERF_FLAG_LATENCY;
+    }
+
+  if (!(cfg.flag & IPERF_FLAG_JSON))
+    {
+      iperf_printcfg(&cfg);
+    }
+
   iperf_start(&cfg);
 
 out:
@@ -75,6 +75,14 @@
 /* Define to 1 to build with Unix socket support. */
 #define COAP_AF_UNIX_SUPPORT 1
 
+/* Largest CoAP message over UDP, the size of the blocks of block-wise
+ * transfers (RFC 7959) is the largest power of two that fits.
+ */
+
+#ifdef CONFIG_NETUTILS_LIBCOAP_MTU
+#define COAP_DEFAULT_MTU CONFIG_NETUTILS_LIBCOAP_MTU
+#endif
+
 /* Define to 1 to build with Q-Block (RFC 9177) support. */
 #define COAP_Q_BLOCK_SUPPORT 1
 
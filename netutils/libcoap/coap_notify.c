@@ -0,0 +1,187 @@
+/****************************************************************************
+ * apps/netutils/libcoap/coap_notify.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "netutils/coap_notify.h"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A published payload, referenced by the resource and by each response
+ * that still sends it.
+ */
+
+struct coap_notify_payload_s
+{
+  int refs;
+  size_t len;
+  uint8_t data[1];
+};
+
+struct coap_notify_s
+{
+  FAR struct coap_notify_payload_s *payload;
+  uint64_t etag;
+  uint16_t media_type;
+  int maxage;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: coap_notify_release
+ *
+ * Description:
+ *   Drop a reference to a payload, called by libcoap once a response has
+ *   been sent.
+ *
+ ****************************************************************************/
+
+static void coap_notify_release(FAR coap_session_t *session,
+                                FAR void *app_ptr)
+{
+  FAR struct coap_notify_payload_s *payload = app_ptr;
+
+  if (--payload->refs == 0)
+    {
+      free(payload);
+    }
+}
+
+/****************************************************************************
+ * Name: coap_notify_get
+ *
+ * Description:
+ *   GET handler, used for the requests and for each of the notifications.
+ *
+ ****************************************************************************/
+
+static void coap_notify_get(FAR coap_resource_t *resource,
+                            FAR coap_session_t *session,
+                            FAR const coap_pdu_t *request,
+                            FAR const coap_string_t *query,
+                            FAR coap_pdu_t *response)
+{
+  FAR struct coap_notify_s *notify = coap_resource_get_userdata(resource);
+  FAR struct coap_notify_payload_s *payload = notify->payload;
+
+  if (payload == NULL)
+    {
+      coap_pdu_set_code(response, COAP_RESPONSE_CODE_SERVICE_UNAVAILABLE);
+      return;
+    }
+
+  /* The response references the payload instead of copying it, libcoap
+   * releases it once all of the blocks are sent, or on failure.
+   */
+
+  payload->refs++;
+  coap_pdu_set_code(response, COAP_RESPONSE_CODE_CONTENT);
+  coap_add_data_large_response(resource, session, request, response,
+                               query, notify->media_type, notify->maxage,
+                               notify->etag, payload->len, payload->data,
+                               coap_notify_release, payload);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: coap_notify_resource
+ ****************************************************************************/
+
+FAR coap_resource_t *coap_notify_resource(FAR coap_context_t *ctx,
+                                          FAR const char *path,
+                                          uint16_t media_type, int maxage)
+{
+  FAR struct coap_notify_s *notify;
+  FAR coap_resource_t *resource;
+
+  notify = calloc(1, sizeof(*notify));
+  if (notify == NULL)
+    {
+      return NULL;
+    }
+
+  resource = coap_resource_init(coap_make_str_const(path),
+                                COAP_RESOURCE_FLAGS_NOTIFY_NON);
+  if (resource == NULL)
+    {
+      free(notify);
+      return NULL;
+    }
+
+  notify->media_type = media_type;
+  notify->maxage     = maxage;
+
+  coap_context_set_block_mode(ctx, COAP_BLOCK_USE_LIBCOAP |
+                                   COAP_BLOCK_SINGLE_BODY);
+  coap_resource_set_userdata(resource, notify);
+  coap_resource_set_get_observable(resource, 1);
+  coap_register_request_handler(resource, COAP_REQUEST_GET,
+                                coap_notify_get);
+  coap_add_resource(ctx, resource);
+  return resource;
+}
+
+/****************************************************************************
+ * Name: coap_notify_publish
+ ****************************************************************************/
+
+int coap_notify_publish(FAR coap_resource_t *resource,
+                        FAR const void *data, size_t len)
+{
+  FAR struct coap_notify_s *notify = coap_resource_get_userdata(resource);
+  FAR struct coap_notify_payload_s *payload;
+
+  payload = malloc(sizeof(*payload) + len);
+  if (payload == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  payload->refs = 1;
+  payload->len  = len;
+  memcpy(payload->data, data, len);
+
+  if (notify->payload != NULL)
+    {
+      coap_notify_release(NULL, notify->payload);
+    }
+
+  notify->payload = payload;
+  notify->etag++;
+
+  coap_resource_notify_observers(resource, NULL);
+  return OK;
+}
@@ -0,0 +1,231 @@
+/****************************************************************************
+ * apps/netutils/libcoap/coap_pool.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "coap_pool.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define POOL_ALIGN(x)  (((x) + sizeof(uintptr_t) - 1) & \
+                        ~(sizeof(uintptr_t) - 1))
+
+#define SMALL_SIZE     POOL_ALIGN(CONFIG_NETUTILS_LIBCOAP_POOL_SMALL_SIZE)
+#define MEDIUM_SIZE    POOL_ALIGN(CONFIG_NETUTILS_LIBCOAP_POOL_MEDIUM_SIZE)
+#define LARGE_SIZE     POOL_ALIGN(CONFIG_NETUTILS_LIBCOAP_POOL_LARGE_SIZE)
+
+#define NPOOLS         3
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Blocks of one size.  Blocks are handed out in order the first time,
+ * then from the list of freed ones, linked through their first word.
+ */
+
+struct coap_pool_s
+{
+  FAR uint8_t *base;
+  size_t blksize;
+  unsigned int nblocks;
+  unsigned int nfresh;
+  FAR void *freelist;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static uintptr_t g_small[CONFIG_NETUTILS_LIBCOAP_POOL_SMALL_COUNT *
+                         SMALL_SIZE / sizeof(uintptr_t)];
+static uintptr_t g_medium[CONFIG_NETUTILS_LIBCOAP_POOL_MEDIUM_COUNT *
+                          MEDIUM_SIZE / sizeof(uintptr_t)];
+static uintptr_t g_large[CONFIG_NETUTILS_LIBCOAP_POOL_LARGE_COUNT *
+                         LARGE_SIZE / sizeof(uintptr_t)];
+
+static struct coap_pool_s g_pools[NPOOLS] =
+{
+  {
+    (FAR uint8_t *)g_small, SMALL_SIZE,
+    CONFIG_NETUTILS_LIBCOAP_POOL_SMALL_COUNT, 0, NULL
+  },
+  {
+    (FAR uint8_t *)g_medium, MEDIUM_SIZE,
+    CONFIG_NETUTILS_LIBCOAP_POOL_MEDIUM_COUNT, 0, NULL
+  },
+  {
+    (FAR uint8_t *)g_large, LARGE_SIZE,
+    CONFIG_NETUTILS_LIBCOAP_POOL_LARGE_COUNT, 0, NULL
+  }
+};
+
+static pthread_mutex_t g_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: coap_pool_find
+ *
+ * Description:
+ *   Return the pool that holds ptr, or NULL for a heap block.
+ *
+ ****************************************************************************/
+
+static FAR struct coap_pool_s *coap_pool_find(FAR void *ptr)
+{
+  FAR struct coap_pool_s *pool;
+  int i;
+
+  for (i = 0; i < NPOOLS; i++)
+    {
+      pool = &g_pools[i];
+      if ((FAR uint8_t *)ptr >= pool->base &&
+          (FAR uint8_t *)ptr < pool->base + pool->nblocks * pool->blksize)
+        {
+          return pool;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: coap_pool_malloc
+ *
+ * Description:
+ *   Allocate from the smallest pool with a free block large enough.
+ *   Objects larger than the largest blocks, the context and the endpoints,
+ *   are allocated once at start up and come from the heap.
+ *
+ ****************************************************************************/
+
+FAR void *coap_pool_malloc(size_t size)
+{
+  FAR struct coap_pool_s *pool;
+  FAR void *ptr = NULL;
+  int i;
+
+  if (size > LARGE_SIZE)
+    {
+      return malloc(size);
+    }
+
+  pthread_mutex_lock(&g_pool_lock);
+  for (i = 0; i < NPOOLS && ptr == NULL; i++)
+    {
+      pool = &g_pools[i];
+      if (size > pool->blksize)
+        {
+          continue;
+        }
+
+      if (pool->freelist != NULL)
+        {
+          ptr            = pool->freelist;
+          pool->freelist = *(FAR void **)ptr;
+        }
+      else if (pool->nfresh < pool->nblocks)
+        {
+          ptr = pool->base + pool->nfresh++ * pool->blksize;
+        }
+    }
+
+  pthread_mutex_unlock(&g_pool_lock);
+  return ptr;
+}
+
+/****************************************************************************
+ * Name: coap_pool_realloc
+ ****************************************************************************/
+
+FAR void *coap_pool_realloc(FAR void *ptr, size_t size)
+{
+  FAR struct coap_pool_s *pool;
+  FAR void *newptr;
+
+  if (ptr == NULL)
+    {
+      return coap_pool_malloc(size);
+    }
+
+  pool = coap_pool_find(ptr);
+  if (pool == NULL)
+    {
+      return realloc(ptr, size);
+    }
+
+  if (size <= pool->blksize)
+    {
+      return ptr;
+    }
+
+  newptr = coap_pool_malloc(size);
+  if (newptr != NULL)
+    {
+      memcpy(newptr, ptr, pool->blksize);
+      coap_pool_free(ptr);
+    }
+
+  return newptr;
+}
+
+/****************************************************************************
+ * Name: coap_pool_free
+ ****************************************************************************/
+
+void coap_pool_free(FAR void *ptr)
+{
+  FAR struct coap_pool_s *pool;
+
+  if (ptr == NULL)
+    {
+      return;
+    }
+
+  pool = coap_pool_find(ptr);
+  if (pool == NULL)
+    {
+      free(ptr);
+      return;
+    }
+
+  pthread_mutex_lock(&g_pool_lock);
+  *(FAR void **)ptr = pool->freelist;
+  pool->freelist    = ptr;
+  pthread_mutex_unlock(&g_pool_lock);
+}
@@ -0,0 +1,48 @@
+/****************************************************************************
+ * apps/netutils/libcoap/coap_pool.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_NETUTILS_LIBCOAP_COAP_POOL_H
+#define __APPS_NETUTILS_LIBCOAP_COAP_POOL_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+
+#ifdef CONFIG_NETUTILS_LIBCOAP_STATIC_MEMORY
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/* libcoap/src/coap_mem.c is built with malloc(), realloc() and free()
+ * renamed to these, so that all of the objects of libcoap come from the
+ * pools.
+ */
+
+FAR void *coap_pool_malloc(size_t size);
+FAR void *coap_pool_realloc(FAR void *ptr, size_t size);
+void coap_pool_free(FAR void *ptr);
+
+#endif /* CONFIG_NETUTILS_LIBCOAP_STATIC_MEMORY */
+#endif /* __APPS_NETUTILS_LIBCOAP_COAP_POOL_H */
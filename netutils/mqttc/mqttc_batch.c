@@ -0,0 +1,290 @@
+/****************************************************************************
+ * apps/netutils/mqttc/mqttc_batch.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/uio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <poll.h>
+#include <errno.h>
+
+#include "netutils/mqttc_batch.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Fixed header, remaining length and topic length of a PUBLISH */
+
+#define MQTTC_HDRSIZE            (1 + 4 + 2)
+#define MQTTC_MAXREMAINING       268435455
+
+#define MQTTC_BATCH_IOVMAX       (2 * CONFIG_NETUTILS_MQTTC_BATCH_MAX)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Packets waiting for the next write: headers and small payloads are
+ * copied in buf, large payloads are referenced in place.
+ */
+
+struct mqttc_batch_s
+{
+  struct iovec iov[MQTTC_BATCH_IOVMAX];
+  int niov;
+  size_t buflen;
+  uint8_t buf[CONFIG_NETUTILS_MQTTC_BATCH_BUFSIZE];
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mqttc_batch_add
+ *
+ * Description:
+ *   Add data to the batch, copied to buf and merged with the previous
+ *   segment if it is contiguous, or referenced by a new segment.
+ *
+ ****************************************************************************/
+
+static void mqttc_batch_add(FAR struct mqttc_batch_s *batch,
+                            FAR const void *data, size_t len, bool copy)
+{
+  FAR struct iovec *last;
+  FAR uint8_t *dest;
+
+  if (copy)
+    {
+      dest = &batch->buf[batch->buflen];
+      memcpy(dest, data, len);
+      batch->buflen += len;
+
+      if (batch->niov > 0)
+        {
+          last = &batch->iov[batch->niov - 1];
+          if ((FAR uint8_t *)last->iov_base + last->iov_len == dest)
+            {
+              last->iov_len += len;
+              return;
+            }
+        }
+
+      data = dest;
+    }
+
+  batch->iov[batch->niov].iov_base = (FAR void *)data;
+  batch->iov[batch->niov].iov_len  = len;
+  batch->niov++;
+}
+
+/****************************************************************************
+ * Name: mqttc_batch_flush
+ *
+ * Description:
+ *   Write the whole batch, waiting for the non-blocking socket of the
+ *   client when it is full.  Called with the client mutex held.
+ *
+ ****************************************************************************/
+
+static enum MQTTErrors mqttc_batch_flush(FAR struct mqtt_client *client,
+                                         FAR struct mqttc_batch_s *batch)
+{
+  FAR struct iovec *iov = batch->iov;
+  struct pollfd pfd;
+  int niov = batch->niov;
+  ssize_t n;
+
+  while (niov > 0)
+    {
+      n = writev(client->socketfd, iov, niov);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          pfd.fd     = client->socketfd;
+          pfd.events = POLLOUT;
+          if (errno == EAGAIN &&
+              poll(&pfd, 1, client->response_timeout * 1000) > 0)
+            {
+              continue;
+            }
+
+          client->error = MQTT_ERROR_SOCKET_ERROR;
+          return MQTT_ERROR_SOCKET_ERROR;
+        }
+
+      /* Skip what was written, a packet may be cut anywhere */
+
+      while (niov > 0 && (size_t)n >= iov->iov_len)
+        {
+          n -= iov->iov_len;
+          iov++;
+          niov--;
+        }
+
+      if (niov > 0)
+        {
+          iov->iov_base = (FAR uint8_t *)iov->iov_base + n;
+          iov->iov_len -= n;
+        }
+    }
+
+  batch->niov   = 0;
+  batch->buflen = 0;
+
+  /* Postpone the next PINGREQ like any other packet */
+
+  client->time_of_last_send = MQTT_PAL_TIME();
+  return MQTT_OK;
+}
+
+/****************************************************************************
+ * Name: mqttc_pack_header
+ *
+ * Description:
+ *   Pack the fixed header of a QoS 0 PUBLISH and the length of its topic.
+ *
+ ****************************************************************************/
+
+static size_t mqttc_pack_header(FAR uint8_t *buf,
+                                FAR const struct mqttc_pubmsg_s *msg,
+                                size_t topiclen)
+{
+  size_t remaining = 2 + topiclen + msg->len;
+  size_t n = 0;
+
+  buf[n++] = (MQTT_CONTROL_PUBLISH << 4) |
+             (msg->flags & MQTT_PUBLISH_RETAIN);
+
+  do
+    {
+      buf[n] = remaining & 0x7f;
+      remaining >>= 7;
+      if (remaining > 0)
+        {
+          buf[n] |= 0x80;
+        }
+
+      n++;
+    }
+  while (remaining > 0);
+
+  buf[n++] = topiclen >> 8;
+  buf[n++] = topiclen & 0xff;
+  return n;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mqttc_publish_batch
+ ****************************************************************************/
+
+enum MQTTErrors mqttc_publish_batch(FAR struct mqtt_client *client,
+                                    FAR const struct mqttc_pubmsg_s *msgs,
+                                    int nmsgs)
+{
+  struct mqttc_batch_s batch;
+  enum MQTTErrors ret = MQTT_OK;
+  uint8_t hdr[MQTTC_HDRSIZE];
+  size_t topiclen;
+  size_t hdrlen;
+  size_t need;
+  bool copy;
+  int i;
+
+  if (client->error < 0)
+    {
+      return client->error;
+    }
+
+  /* Keep the order with the packets already queued */
+
+  if (__mqtt_send(client) < 0)
+    {
+      return client->error;
+    }
+
+  batch.niov   = 0;
+  batch.buflen = 0;
+
+  MQTT_PAL_MUTEX_LOCK(&client->mutex);
+
+  for (i = 0; i < nmsgs && ret == MQTT_OK; i++)
+    {
+      if ((msgs[i].flags & MQTT_PUBLISH_QOS_MASK) != MQTT_PUBLISH_QOS_0)
+        {
+          ret = MQTT_ERROR_PUBLISH_FORBIDDEN_QOS;
+          break;
+        }
+
+      topiclen = strlen(msgs[i].topic);
+      copy     = msgs[i].len < CONFIG_NETUTILS_MQTTC_ZEROCOPY_THRESHOLD;
+      need     = MQTTC_HDRSIZE + topiclen + (copy ? msgs[i].len : 0);
+
+      if (topiclen > UINT16_MAX ||
+          2 + topiclen + msgs[i].len > MQTTC_MAXREMAINING ||
+          need > sizeof(batch.buf))
+        {
+          ret = MQTT_ERROR_SEND_BUFFER_IS_FULL;
+          break;
+        }
+
+      if (batch.niov + 2 > MQTTC_BATCH_IOVMAX ||
+          batch.buflen + need > sizeof(batch.buf))
+        {
+          ret = mqttc_batch_flush(client, &batch);
+          if (ret != MQTT_OK)
+            {
+              break;
+            }
+        }
+
+      hdrlen = mqttc_pack_header(hdr, &msgs[i], topiclen);
+      mqttc_batch_add(&batch, hdr, hdrlen, true);
+      mqttc_batch_add(&batch, msgs[i].topic, topiclen, true);
+
+      if (msgs[i].len > 0)
+        {
+          mqttc_batch_add(&batch, msgs[i].payload, msgs[i].len, copy);
+        }
+    }
+
+  if (ret == MQTT_OK)
+    {
+      ret = mqttc_batch_flush(client, &batch);
+    }
+
+  MQTT_PAL_MUTEX_UNLOCK(&client->mutex);
+  return ret;
+}
@@ -25,11 +25,15 @@
 
 #include <nuttx/config.h>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
 
 #include <sys/sendfile.h>
 #include <sys/socket.h>
@@ -44,6 +48,26 @@
 #  define NETCAT_PORT 31337
 #endif
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_NETCAT_RELAY
+/* One direction of the relay */
+
+struct netcat_dir_s
+{
+  int       infd;
+  int       outfd;
+  FAR char *buf;
+  size_t    head;    /* First byte not yet written */
+  size_t    tail;    /* End of the buffered data */
+  size_t    total;   /* Bytes forwarded */
+  bool      eof;     /* infd has been closed by the peer */
+  bool      done;    /* All forwarded, outfd shut down */
+};
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -108,6 +132,296 @@ int do_io_over_sendfile(int infd, int outfd, ssize_t len)
 }
 #endif
 
+#ifdef CONFIG_NETUTILS_NETCAT_RELAY
+static int netcat_connect(FAR const char *host, int port)
+{
+  struct sockaddr_in server;
+  int id;
+
+  id = socket(AF_INET, SOCK_STREAM, 0);
+  if (0 > id)
+    {
+      perror("error: net: Failed to create socket");
+      return -1;
+    }
+
+  server.sin_family = AF_INET;
+  server.sin_port = htons(port);
+  if (1 != inet_pton(AF_INET, host, &server.sin_addr))
+    {
+      fprintf(stderr, "error: net: Invalid host %s\n", host);
+      close(id);
+      return -1;
+    }
+
+  if (connect(id, (struct sockaddr *)&server, sizeof(server)) < 0)
+    {
+      perror("error: net: Failed to connect");
+      close(id);
+      return -1;
+    }
+
+  return id;
+}
+
+/* Move data of one direction as far as the sockets allow without
+ * blocking.  Returns -1 on error.
+ */
+
+static int do_relay_dir(FAR struct netcat_dir_s *dir, bool readable,
+                        bool writable)
+{
+  ssize_t n;
+
+  if (readable && !dir->eof &&
+      dir->tail < CONFIG_NETUTILS_NETCAT_RELAY_BUFSIZE)
+    {
+      n = read(dir->infd, dir->buf + dir->tail,
+               CONFIG_NETUTILS_NETCAT_RELAY_BUFSIZE - dir->tail);
+      if (n > 0)
+        {
+          dir->tail += n;
+          writable = true;
+        }
+      else if (n == 0)
+        {
+          dir->eof = true;
+        }
+      else if (errno != EAGAIN && errno != EINTR)
+        {
+          perror("do_relay: read error");
+          return -1;
+        }
+    }
+
+  if (writable && dir->head < dir->tail)
+    {
+      n = send(dir->outfd, dir->buf + dir->head, dir->tail - dir->head,
+               MSG_NOSIGNAL);
+      if (n > 0)
+        {
+          dir->head  += n;
+          dir->total += n;
+        }
+      else if (n < 0 && errno != EAGAIN && errno != EINTR)
+        {
+          perror("do_relay: write error");
+          return -1;
+        }
+    }
+
+  if (dir->head == dir->tail)
+    {
+      dir->head = 0;
+      dir->tail = 0;
+    }
+
+  if (dir->eof && dir->tail == 0 && !dir->done)
+    {
+      /* Pass the end of stream on, the other direction may go on */
+
+      shutdown(dir->outfd, SHUT_WR);
+      dir->done = true;
+    }
+
+  return 0;
+}
+
+/* Forward both directions between two connected sockets until both peers
+ * have closed their side.  Neither direction waits for the other one.
+ */
+
+int do_relay(int fda, int fdb, FAR char *buf)
+{
+  struct netcat_dir_s dir[2];
+  struct pollfd fds[2];
+  struct timespec start;
+  struct timespec end;
+  double elapsed;
+  int i;
+
+  memset(dir, 0, sizeof(dir));
+  dir[0].infd  = fda;
+  dir[0].outfd = fdb;
+  dir[0].buf   = buf;
+  dir[1].infd  = fdb;
+  dir[1].outfd = fda;
+  dir[1].buf   = buf + CONFIG_NETUTILS_NETCAT_RELAY_BUFSIZE;
+
+  fcntl(fda, F_SETFL, fcntl(fda, F_GETFL) | O_NONBLOCK);
+  fcntl(fdb, F_SETFL, fcntl(fdb, F_GETFL) | O_NONBLOCK);
+
+  fds[0].fd = fda;
+  fds[1].fd = fdb;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (!dir[0].done || !dir[1].done)
+    {
+      /* fds[i] is the input of dir[i] and the output of the other one */
+
+      for (i = 0; i < 2; i++)
+        {
+          fds[i].events  = 0;
+          fds[i].revents = 0;
+
+          if (!dir[i].eof &&
+              dir[i].tail < CONFIG_NETUTILS_NETCAT_RELAY_BUFSIZE)
+            {
+              fds[i].events |= POLLIN;
+            }
+
+          if (dir[1 - i].head < dir[1 - i].tail)
+            {
+              fds[i].events |= POLLOUT;
+            }
+        }
+
+      if (poll(fds, 2, -1) < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          perror("do_relay: poll error");
+          return 5;
+        }
+
+      for (i = 0; i < 2; i++)
+        {
+          if (do_relay_dir(&dir[i],
+                           (fds[i].revents & (POLLIN | POLLHUP |
+                                              POLLERR)) != 0,
+                           (fds[1 - i].revents & (POLLOUT |
+                                                  POLLERR)) != 0) < 0)
+            {
+              return 6;
+            }
+        }
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  elapsed = (end.tv_sec - start.tv_sec) +
+            (end.tv_nsec - start.tv_nsec) / 1e9;
+  if (elapsed <= 0)
+    {
+      elapsed = 1e-9;
+    }
+
+  fprintf(stderr,
+          "log: relay: %zu bytes forward, %zu bytes back in %.3f s, "
+          "%.1f + %.1f kbit/s\n",
+          dir[0].total, dir[1].total, elapsed,
+          dir[0].total * 8 / elapsed / 1000,
+          dir[1].total * 8 / elapsed / 1000);
+
+  return EXIT_SUCCESS;
+}
+
+int netcat_relay(int argc, char * argv[])
+{
+  struct sockaddr_in server;
+  struct sockaddr_in client;
+  socklen_t addrlen;
+  int port = NETCAT_PORT;
+  int result = EXIT_SUCCESS;
+  int id = -1;
+  int conn = -1;
+  int peer = -1;
+  char *buf = NULL;
+  char *colon;
+
+  if (argc < 3 || (colon = strrchr(argv[2], ':')) == NULL)
+    {
+      fprintf(stderr, "error: relay: Expected host:port\n");
+      return 1;
+    }
+
+  *colon = '\0';
+  if (argc > 3)
+    {
+      port = atoi(argv[3]);
+    }
+
+  buf = (char *)malloc(2 * CONFIG_NETUTILS_NETCAT_RELAY_BUFSIZE);
+  if (buf == NULL)
+    {
+      perror("error: malloc: Failed to allocate I/O buffer\n");
+      result = 2;
+      goto out;
+    }
+
+  id = socket(AF_INET , SOCK_STREAM , 0);
+  if (0 > id)
+    {
+      perror("error: net: Failed to create socket");
+      result = 2;
+      goto out;
+    }
+
+  server.sin_family = AF_INET;
+  server.sin_addr.s_addr = INADDR_ANY;
+  server.sin_port = htons(port);
+  if (0 > bind(id, (struct sockaddr *)&server , sizeof(server)))
+    {
+      perror("error: net: Failed to bind");
+      result = 3;
+      goto out;
+    }
+
+  fprintf(stderr, "log: net: relaying :%d to %s:%s\n",
+          port, argv[2], colon + 1);
+  if (listen(id , 3) == -1)
+    {
+      perror("error: net: Failed to listen");
+      result = 7;
+      goto out;
+    }
+
+  addrlen = sizeof(struct sockaddr_in);
+  conn = accept(id, (struct sockaddr *)&client, &addrlen);
+  if (0 > conn)
+    {
+      perror("accept failed");
+      result = 4;
+      goto out;
+    }
+
+  peer = netcat_connect(argv[2], atoi(colon + 1));
+  if (0 > peer)
+    {
+      result = 4;
+      goto out;
+    }
+
+  result = do_relay(conn, peer, buf);
+
+out:
+  if (peer != -1)
+    {
+      close(peer);
+    }
+
+  if (conn != -1)
+    {
+      close(conn);
+    }
+
+  if (id != -1)
+    {
+      close(id);
+    }
+
+  if (buf != NULL)
+    {
+      free(buf);
+    }
+
+  return result;
+}
+#endif
+
 int netcat_server(int argc, char * argv[])
 {
   int id = -1;
@@ -327,8 +641,18 @@ int main(int argc, FAR char *argv[])
     {
       fprintf(stderr,
               "Usage: netcat <destination> [port] [file]\n"
-              "Usage: netcat -l [port] [file]\n");
+              "Usage: netcat -l [port] [file]\n"
+#ifdef CONFIG_NETUTILS_NETCAT_RELAY
+              "Usage: netcat -r <host:port> [port]\n"
+#endif
+              );
     }
+#ifdef CONFIG_NETUTILS_NETCAT_RELAY
+  else if (0 == strcmp("-r", argv[1]))
+    {
+      status = netcat_relay(argc, argv);
+    }
+#endif
   else if ((1 < argc) && (0 == strcmp("-l", argv[1])))
     {
       status = netcat_server(argc, argv);
@@ -36,6 +36,8 @@
 #include <arpa/inet.h>
 #include <assert.h>
 #include <debug.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <net/if.h>
 #include <netinet/in.h>
 #include <pthread.h>
@@ -45,6 +47,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <nuttx/net/mii.h>
@@ -228,6 +231,14 @@ static sem_t g_notify_sem;
 bool g_use_dhcpc;
 #endif
 
+#ifdef CONFIG_NETINIT_THREAD
+/* Network readiness, see netinit_wait() */
+
+static pthread_mutex_t g_ready_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_ready_cond = PTHREAD_COND_INITIALIZER;
+static bool g_ready;
+#endif
+
 #if defined(CONFIG_NET_IPv6) && !defined(CONFIG_NET_ICMPv6_AUTOCONF) && \
    !defined(CONFIG_NET_6LOWPAN)
 /* Host IPv6 address */
@@ -277,6 +288,30 @@ static const uint16_t g_ipv6_netmask[8] =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: netinit_set_ready
+ *
+ * Description:
+ *   Record whether the network is usable and wake up netinit_wait().
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETINIT_THREAD
+static void netinit_set_ready(bool ready)
+{
+  pthread_mutex_lock(&g_ready_lock);
+  g_ready = ready;
+  if (ready)
+    {
+      pthread_cond_broadcast(&g_ready_cond);
+    }
+
+  pthread_mutex_unlock(&g_ready_lock);
+}
+#else
+#  define netinit_set_ready(ready)
+#endif
+
 /****************************************************************************
  * Name: netinit_set_macaddr
  *
@@ -616,6 +651,98 @@ static void netinit_set_ipaddrs(void)
 #  define netinit_set_ipaddrs()
 #endif
 
+/****************************************************************************
+ * Name: netinit_set_lease
+ *
+ * Description:
+ *   Apply the addresses of a DHCP lease.
+ *
+ ****************************************************************************/
+
+#if defined(NETINIT_HAVE_NETDEV) && !defined(CONFIG_NETINIT_NETLOCAL) && \
+    defined(CONFIG_NETUTILS_DHCPC)
+static void netinit_set_lease(FAR const struct dhcpc_state *ds)
+{
+  netlib_set_ipv4addr(NET_DEVNAME, &ds->ipaddr);
+
+  if (ds->netmask.s_addr != 0)
+    {
+      netlib_set_ipv4netmask(NET_DEVNAME, &ds->netmask);
+    }
+
+  if (ds->default_router.s_addr != 0)
+    {
+      netlib_set_dripv4addr(NET_DEVNAME, &ds->default_router);
+    }
+
+  if (ds->dnsaddr.s_addr != 0)
+    {
+      netlib_set_ipv4dnsaddr(&ds->dnsaddr);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: netinit_load_lease and netinit_save_lease
+ *
+ * Description:
+ *   Keep the last DHCP lease in CONFIG_NETINIT_DHCPC_LEASE_PATH, so that
+ *   the next boot can use its addresses at once and leave DHCP to confirm
+ *   or replace them in the background.  The file is only rewritten when
+ *   the lease changes.
+ *
+ ****************************************************************************/
+
+#if defined(NETINIT_HAVE_NETDEV) && !defined(CONFIG_NETINIT_NETLOCAL) && \
+    defined(CONFIG_NETINIT_DHCPC_LEASE)
+static bool netinit_load_lease(FAR struct dhcpc_state *ds)
+{
+  ssize_t nread;
+  int fd;
+
+  fd = open(CONFIG_NETINIT_DHCPC_LEASE_PATH, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    {
+      return false;
+    }
+
+  nread = read(fd, ds, sizeof(*ds));
+  close(fd);
+
+  return nread == sizeof(*ds) && ds->ipaddr.s_addr != 0;
+}
+
+static void netinit_save_lease(FAR const struct dhcpc_state *ds)
+{
+  struct dhcpc_state old;
+  int fd;
+
+  if (netinit_load_lease(&old) &&
+      old.ipaddr.s_addr == ds->ipaddr.s_addr &&
+      old.netmask.s_addr == ds->netmask.s_addr &&
+      old.default_router.s_addr == ds->default_router.s_addr &&
+      old.dnsaddr.s_addr == ds->dnsaddr.s_addr)
+    {
+      return;
+    }
+
+  fd = open(CONFIG_NETINIT_DHCPC_LEASE_PATH,
+            O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+    {
+      nerr("ERROR: Failed to save the lease: %d\n", errno);
+      return;
+    }
+
+  if (write(fd, ds, sizeof(*ds)) != sizeof(*ds))
+    {
+      nerr("ERROR: Failed to save the lease: %d\n", errno);
+    }
+
+  close(fd);
+}
+#endif
+
 /****************************************************************************
  * Name: netinit_net_bringup()
  *
@@ -656,6 +783,21 @@ static void netinit_net_bringup(void)
 #endif
 
 #ifdef CONFIG_NETUTILS_DHCPC
+  if (!g_use_dhcpc)
+    {
+      netinit_set_ready(true);
+    }
+#ifdef CONFIG_NETINIT_DHCPC_LEASE
+  else if (netinit_load_lease(&ds))
+    {
+      /* Use the last lease until DHCP answers */
+
+      ninfo("Using the cached lease\n");
+      netinit_set_lease(&ds);
+      netinit_set_ready(true);
+    }
+#endif
+
   if (g_use_dhcpc)
     {
       /* Get the MAC address of the NIC */
@@ -677,26 +819,17 @@ static void netinit_net_bringup(void)
 
       if (dhcpc_request(handle, &ds) == OK)
         {
-          netlib_set_ipv4addr(NET_DEVNAME, &ds.ipaddr);
-
-          if (ds.netmask.s_addr != 0)
-            {
-              netlib_set_ipv4netmask(NET_DEVNAME, &ds.netmask);
-            }
-
-          if (ds.default_router.s_addr != 0)
-            {
-              netlib_set_dripv4addr(NET_DEVNAME, &ds.default_router);
-            }
-
-          if (ds.dnsaddr.s_addr != 0)
-            {
-              netlib_set_ipv4dnsaddr(&ds.dnsaddr);
-            }
+          netinit_set_lease(&ds);
+#ifdef CONFIG_NETINIT_DHCPC_LEASE
+          netinit_save_lease(&ds);
+#endif
+          netinit_set_ready(true);
         }
 
       dhcpc_close(handle);
     }
+#else
+  netinit_set_ready(true);
 #endif
 
 #ifdef CONFIG_NETUTILS_NTPCLIENT
@@ -735,6 +868,10 @@ static void netinit_configure(void)
 
   netinit_net_bringup();
 #endif
+#else
+  /* There is no device to wait for, usrsock for example */
+
+  netinit_set_ready(true);
 #endif /* NETINIT_HAVE_NETDEV */
 }
 
@@ -918,6 +1055,8 @@ static int netinit_monitor(void)
                   goto errout_with_notification;
                 }
 
+              netinit_set_ready(true);
+
 #ifdef CONFIG_NET_ICMPv6_AUTOCONF
               /* Perform ICMPv6 auto-configuration */
 
@@ -949,6 +1088,7 @@ static int netinit_monitor(void)
                */
 
               ninfo("Taking the link down\n");
+              netinit_set_ready(false);
 
               ifr.ifr_flags = IFF_DOWN;
               ret = ioctl(sd, SIOCSIFFLAGS, (unsigned long)&ifr);
@@ -1034,6 +1174,48 @@ static pthread_addr_t netinit_thread(pthread_addr_t arg)
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: netinit_wait
+ *
+ * Description:
+ *   Wait until the network brought up by the netinit thread is usable.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NETINIT_THREAD
+int netinit_wait(int timeout_ms)
+{
+  struct timespec abstime;
+  int ret = OK;
+
+  clock_gettime(CLOCK_REALTIME, &abstime);
+  abstime.tv_sec  += timeout_ms / 1000;
+  abstime.tv_nsec += (timeout_ms % 1000) * 1000000;
+  if (abstime.tv_nsec >= 1000000000)
+    {
+      abstime.tv_sec++;
+      abstime.tv_nsec -= 1000000000;
+    }
+
+  pthread_mutex_lock(&g_ready_lock);
+  while (!g_ready && ret == OK)
+    {
+      if (timeout_ms < 0)
+        {
+          ret = -pthread_cond_wait(&g_ready_cond, &g_ready_lock);
+        }
+      else
+        {
+          ret = -pthread_cond_timedwait(&g_ready_cond, &g_ready_lock,
+                                        &abstime);
+        }
+    }
+
+  pthread_mutex_unlock(&g_ready_lock);
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Name: netinit_bringup
  *
@@ -102,18 +102,21 @@ netlib_ipt_entry_by_rulenum(FAR struct ipt_replace *repl,
  * Name: netlib_ipt_insert_internal
  *
  * Description:
- *   Insert an entry into config at insert_point.
+ *   Insert entries into config at insert_point.
  *
  * Input Parameters:
  *   repl         - The config (to set into kernel later).
- *   entry        - The entry to insert.
- *   hook         - The hook of the entry.
- *   insert_point - The offset to put the entry.
+ *   entries      - The entries to insert, back to back.
+ *   size         - The total size of the entries.
+ *   nentries     - The number of entries.
+ *   hook         - The hook of the entries.
+ *   insert_point - The offset to put the entries.
  *
  ****************************************************************************/
 
 static int netlib_ipt_insert_internal(FAR struct ipt_replace **replace,
-                                      FAR const struct ipt_entry *entry,
+                                      FAR const void *entries, size_t size,
+                                      unsigned int nentries,
                                       enum nf_inet_hooks hook,
                                       unsigned int insert_point)
 {
@@ -121,34 +124,34 @@ static int netlib_ipt_insert_internal(FAR struct ipt_replace **replace,
   FAR uint8_t *base;
   size_t new_size;
 
-  new_size = sizeof(*repl) + repl->size + entry->next_offset;
+  new_size = sizeof(*repl) + repl->size + size;
   repl = realloc(repl, new_size);
   if (repl == NULL)
     {
       return -ENOMEM;
     }
 
-  /* Insert new entry into entry table. */
+  /* Insert new entries into entry table. */
 
   base = (FAR uint8_t *)repl->entries;
-  memmove(base + insert_point + entry->next_offset, base + insert_point,
+  memmove(base + insert_point + size, base + insert_point,
           repl->size - insert_point);
-  memcpy(base + insert_point, entry, entry->next_offset);
+  memcpy(base + insert_point, entries, size);
 
   /* Adjust metadata. */
 
-  repl->num_entries++;
-  repl->size += entry->next_offset;
+  repl->num_entries += nentries;
+  repl->size += size;
 
   /* Adjust hook_entry and underflow. */
 
-  repl->underflow[hook++] += entry->next_offset;
+  repl->underflow[hook++] += size;
   for (; hook < NF_INET_NUMHOOKS; hook++)
     {
       if (repl->valid_hooks & (1 << hook))
         {
-          repl->hook_entry[hook] += entry->next_offset;
-          repl->underflow[hook] += entry->next_offset;
+          repl->hook_entry[hook] += size;
+          repl->underflow[hook] += size;
         }
     }
 
@@ -329,56 +332,109 @@ int netlib_ipt_commit(FAR const struct ipt_replace *repl)
 }
 
 /****************************************************************************
- * Name: netlib_ipt_flush
+ * Name: netlib_ipt_clear
  *
  * Description:
- *   Flush all config in the table.
+ *   Remove all user entries of a chain from config, each chain with a
+ *   single move of the entries behind it.
  *
  * Input Parameters:
- *   table  - The table name to flush.
- *   hook   - The hook to flush, NF_INET_NUMHOOKS for all.
+ *   repl   - The config (to set into kernel later).
+ *   hook   - The hook to clear, NF_INET_NUMHOOKS for all.
  *
  ****************************************************************************/
 
-int netlib_ipt_flush(FAR const char *table, enum nf_inet_hooks hook)
+int netlib_ipt_clear(FAR struct ipt_replace *repl, enum nf_inet_hooks hook)
 {
-  FAR struct ipt_replace *repl = netlib_ipt_prepare(table);
+  FAR struct ipt_entry *e;
+  FAR uint8_t *head;
   unsigned int cur_hook;
-  int ret;
+  unsigned int other;
+  unsigned int count;
+  unsigned int size;
 
   if (repl == NULL)
     {
-      fprintf(stderr, "Failed to read table %s from kernel!\n", table);
-      return -EIO;
+      return -EINVAL;
     }
 
   if (hook != NF_INET_NUMHOOKS && (repl->valid_hooks & (1 << hook)) == 0)
     {
-      fprintf(stderr, "Invalid hook number %d for table %s!\n", hook, table);
+      fprintf(stderr, "Invalid hook number %d for table %s!\n",
+              hook, repl->name);
       return -EINVAL;
     }
 
   for (cur_hook = 0; cur_hook < NF_INET_NUMHOOKS; cur_hook++)
     {
-      if ((repl->valid_hooks & (1 << cur_hook)) != 0 &&
-          (hook == NF_INET_NUMHOOKS || hook == cur_hook))
+      if ((repl->valid_hooks & (1 << cur_hook)) == 0 ||
+          (hook != NF_INET_NUMHOOKS && hook != cur_hook))
+        {
+          continue;
+        }
+
+      head  = (FAR uint8_t *)repl->entries + repl->hook_entry[cur_hook];
+      size  = repl->underflow[cur_hook] - repl->hook_entry[cur_hook];
+      count = 0;
+
+      ipt_entry_for_every(e, head, size)
         {
-          /* Remove all user entries in current hook. */
+          count++;
+        }
 
-          while (repl->underflow[cur_hook] > repl->hook_entry[cur_hook])
+      if (count == 0)
+        {
+          continue;
+        }
+
+      memmove(head, head + size, repl->size - repl->underflow[cur_hook]);
+
+      repl->num_entries -= count;
+      repl->size -= size;
+
+      repl->underflow[cur_hook] -= size;
+      for (other = cur_hook + 1; other < NF_INET_NUMHOOKS; other++)
+        {
+          if (repl->valid_hooks & (1 << other))
             {
-              ret = netlib_ipt_delete(repl, NULL, cur_hook, 1);
-              if (ret < 0)
-                {
-                  goto errout;
-                }
+              repl->hook_entry[other] -= size;
+              repl->underflow[other] -= size;
             }
         }
     }
 
-  ret = netlib_ipt_commit(repl);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: netlib_ipt_flush
+ *
+ * Description:
+ *   Flush all config in the table.
+ *
+ * Input Parameters:
+ *   table  - The table name to flush.
+ *   hook   - The hook to flush, NF_INET_NUMHOOKS for all.
+ *
+ ****************************************************************************/
+
+int netlib_ipt_flush(FAR const char *table, enum nf_inet_hooks hook)
+{
+  FAR struct ipt_replace *repl = netlib_ipt_prepare(table);
+  int ret;
+
+  if (repl == NULL)
+    {
+      fprintf(stderr, "Failed to read table %s from kernel!\n", table);
+      return -EIO;
+    }
+
+  ret = netlib_ipt_clear(repl, hook);
+  if (ret == OK)
+    {
+      ret = netlib_ipt_commit(repl);
+    }
 
-errout:
   free(repl);
   return ret;
 }
@@ -412,7 +468,48 @@ int netlib_ipt_append(FAR struct ipt_replace **repl,
       return -EINVAL;
     }
 
-  return netlib_ipt_insert_internal(repl, entry, hook,
+  return netlib_ipt_insert_internal(repl, entry, entry->next_offset, 1,
+                                    hook, (*repl)->underflow[hook]);
+}
+
+/****************************************************************************
+ * Name: netlib_ipt_append_entries
+ *
+ * Description:
+ *   Append several entries at once at the end of the chain corresponding
+ * to hook, growing and moving the config only once.
+ *
+ * Input Parameters:
+ *   repl     - The config (to set into kernel later).
+ *   entries  - The entries to append, back to back.
+ *   size     - The total size of the entries.
+ *   nentries - The number of entries.
+ *   hook     - The hook of the entries.
+ *
+ ****************************************************************************/
+
+int netlib_ipt_append_entries(FAR struct ipt_replace **repl,
+                              FAR const void *entries, size_t size,
+                              unsigned int nentries,
+                              enum nf_inet_hooks hook)
+{
+  if (repl == NULL || *repl == NULL || (entries == NULL && size > 0))
+    {
+      return -EINVAL;
+    }
+
+  if (((*repl)->valid_hooks & (1 << hook)) == 0)
+    {
+      fprintf(stderr, "Not valid hook %d for this table!\n", hook);
+      return -EINVAL;
+    }
+
+  if (size == 0)
+    {
+      return OK;
+    }
+
+  return netlib_ipt_insert_internal(repl, entries, size, nentries, hook,
                                     (*repl)->underflow[hook]);
 }
 
@@ -457,8 +554,9 @@ int netlib_ipt_insert(FAR struct ipt_replace **repl,
       return -EINVAL;
     }
 
-  return netlib_ipt_insert_internal(repl, entry, hook,
-                                (uintptr_t)e - (uintptr_t)(*repl)->entries);
+  return netlib_ipt_insert_internal(repl, entry, entry->next_offset, 1,
+                                    hook, (uintptr_t)e -
+                                          (uintptr_t)(*repl)->entries);
 }
 
 /****************************************************************************
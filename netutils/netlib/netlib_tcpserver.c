@@ -0,0 +1,833 @@
+/****************************************************************************
+ * apps/netutils/netlib/netlib_tcpserver.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <time.h>
+#include <errno.h>
+#include <debug.h>
+
+#include "netutils/netlib.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_SMP
+#  define TCPSERVER_NCPUS   CONFIG_SMP_NCPUS
+#else
+#  define TCPSERVER_NCPUS   1
+#endif
+
+/* Longest sleep of the server threads, they check for
+ * netlib_tcpserver_stop() at least this often.
+ */
+
+#define TCPSERVER_POLL_MS   1000
+
+/* Events handled by one epoll_wait() */
+
+#define TCPSERVER_NEVENTS   8
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct netlib_tcploop_s;
+
+/* A connection of an event loop */
+
+struct netlib_tcpconn_s
+{
+  FAR struct netlib_tcpconn_s *flink;
+  FAR struct netlib_tcploop_s *loop;
+  FAR void                    *priv;     /* Owned by the callbacks */
+  uint64_t                     deadline; /* Timer expiry in ms, 0 if off */
+  int                          sd;       /* -1 once closed */
+};
+
+/* An event loop */
+
+struct netlib_tcploop_s
+{
+  FAR struct netlib_tcpserver_s *srv;
+  FAR struct netlib_tcpconn_s   *conns;
+  int                            epfd;
+  bool                           listening; /* Listener is in epfd */
+};
+
+struct netlib_tcpserver_s
+{
+  struct netlib_tcpserver_cfg_s  cfg;
+  int                            listensd;
+  int                            nthreads;
+  atomic_int                     nconns;   /* Accepted, not yet closed */
+  atomic_bool                    stop;
+  FAR pthread_t                 *threads;
+
+  /* NETLIB_TCPSERVER_EVENT */
+
+  FAR struct netlib_tcploop_s   *loops;
+
+  /* NETLIB_TCPSERVER_POOL: the acceptor queues the sockets */
+
+  pthread_t                      acceptor;
+  pthread_mutex_t                lock;
+  sem_t                          slots;    /* Free queue entries */
+  sem_t                          items;    /* Queued sockets */
+  FAR int                       *queue;
+  int                            qsize;
+  int                            head;
+  int                            count;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcpserver_now
+ ****************************************************************************/
+
+static uint64_t tcpserver_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/****************************************************************************
+ * Name: tcpserver_semwait
+ ****************************************************************************/
+
+static void tcpserver_semwait(FAR sem_t *sem)
+{
+  while (sem_wait(sem) < 0)
+    {
+    }
+}
+
+/****************************************************************************
+ * Name: tcpserver_worker
+ *
+ * Description:
+ *   A thread of NETLIB_TCPSERVER_POOL.  Serves the queued connections one
+ *   at a time.
+ *
+ ****************************************************************************/
+
+static FAR void *tcpserver_worker(FAR void *arg)
+{
+  FAR struct netlib_tcpserver_s *srv = arg;
+  int sd;
+
+  for (; ; )
+    {
+      tcpserver_semwait(&srv->items);
+
+      pthread_mutex_lock(&srv->lock);
+      if (srv->count == 0)
+        {
+          /* Nothing queued: the server is stopping */
+
+          pthread_mutex_unlock(&srv->lock);
+          break;
+        }
+
+      sd = srv->queue[srv->head];
+      srv->head = (srv->head + 1) % srv->qsize;
+      srv->count--;
+      pthread_mutex_unlock(&srv->lock);
+
+      srv->cfg.handler(sd, srv->cfg.arg);
+
+      close(sd);
+      atomic_fetch_sub(&srv->nconns, 1);
+      sem_post(&srv->slots);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: tcpserver_acceptor
+ *
+ * Description:
+ *   The accepting thread of NETLIB_TCPSERVER_POOL.  It accepts only when
+ *   there is room in the queue, further connections wait in the listen
+ *   backlog.
+ *
+ ****************************************************************************/
+
+static FAR void *tcpserver_acceptor(FAR void *arg)
+{
+  FAR struct netlib_tcpserver_s *srv = arg;
+  struct pollfd fds;
+  bool slot = false;
+  int tail;
+  int sd;
+
+  fds.fd     = srv->listensd;
+  fds.events = POLLIN;
+
+  while (!atomic_load(&srv->stop))
+    {
+      if (!slot)
+        {
+          struct timespec abstime;
+
+          clock_gettime(CLOCK_REALTIME, &abstime);
+          abstime.tv_sec += TCPSERVER_POLL_MS / 1000;
+          if (sem_timedwait(&srv->slots, &abstime) < 0)
+            {
+              continue;
+            }
+
+          slot = true;
+        }
+
+      if (poll(&fds, 1, TCPSERVER_POLL_MS) <= 0)
+        {
+          continue;
+        }
+
+      sd = accept4(srv->listensd, NULL, NULL, SOCK_CLOEXEC);
+      if (sd < 0)
+        {
+          if (errno != EINTR && errno != EAGAIN)
+            {
+              nerr("ERROR: accept failure: %d\n", errno);
+            }
+
+          continue;
+        }
+
+      atomic_fetch_add(&srv->nconns, 1);
+
+      pthread_mutex_lock(&srv->lock);
+      tail = (srv->head + srv->count) % srv->qsize;
+      srv->queue[tail] = sd;
+      srv->count++;
+      pthread_mutex_unlock(&srv->lock);
+
+      sem_post(&srv->items);
+      slot = false;
+    }
+
+  if (slot)
+    {
+      sem_post(&srv->slots);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: tcpserver_close
+ *
+ * Description:
+ *   Close a connection of an event loop.  The structure itself is freed
+ *   at the end of the loop iteration, an event for it may still be
+ *   pending.
+ *
+ ****************************************************************************/
+
+static void tcpserver_close(FAR struct netlib_tcpconn_s *conn)
+{
+  FAR struct netlib_tcpserver_s *srv = conn->loop->srv;
+
+  if (conn->sd < 0)
+    {
+      return;
+    }
+
+  if (srv->cfg.on_close != NULL)
+    {
+      srv->cfg.on_close(conn, srv->cfg.arg);
+    }
+
+  epoll_ctl(conn->loop->epfd, EPOLL_CTL_DEL, conn->sd, NULL);
+  close(conn->sd);
+  conn->sd = -1;
+  atomic_fetch_sub(&srv->nconns, 1);
+}
+
+/****************************************************************************
+ * Name: tcpserver_reap
+ *
+ * Description:
+ *   Free the closed connections of an event loop
+ *
+ ****************************************************************************/
+
+static void tcpserver_reap(FAR struct netlib_tcploop_s *loop)
+{
+  FAR struct netlib_tcpconn_s **link = &loop->conns;
+  FAR struct netlib_tcpconn_s *conn;
+
+  while ((conn = *link) != NULL)
+    {
+      if (conn->sd < 0)
+        {
+          *link = conn->flink;
+          free(conn);
+        }
+      else
+        {
+          link = &conn->flink;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: tcpserver_accept
+ *
+ * Description:
+ *   Accept the pending connections of an event loop, up to the connection
+ *   limit
+ *
+ ****************************************************************************/
+
+static void tcpserver_accept(FAR struct netlib_tcploop_s *loop)
+{
+  FAR struct netlib_tcpserver_s *srv = loop->srv;
+  FAR struct netlib_tcpconn_s *conn;
+  struct epoll_event ev;
+  int limit = srv->cfg.maxconns > 0 ? srv->cfg.maxconns : INT_MAX;
+  int sd;
+
+  for (; ; )
+    {
+      if (atomic_fetch_add(&srv->nconns, 1) >= limit)
+        {
+          atomic_fetch_sub(&srv->nconns, 1);
+          return;
+        }
+
+      /* Every loop polls the listener, another one may have taken the
+       * connection.
+       */
+
+      sd = accept4(srv->listensd, NULL, NULL,
+                   SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (sd < 0)
+        {
+          atomic_fetch_sub(&srv->nconns, 1);
+          if (errno != EAGAIN && errno != EINTR)
+            {
+              nerr("ERROR: accept failure: %d\n", errno);
+            }
+
+          return;
+        }
+
+      conn = zalloc(sizeof(struct netlib_tcpconn_s));
+      if (conn == NULL)
+        {
+          close(sd);
+          atomic_fetch_sub(&srv->nconns, 1);
+          return;
+        }
+
+      conn->loop = loop;
+      conn->sd   = sd;
+      if (srv->cfg.idle_ms > 0)
+        {
+          conn->deadline = tcpserver_now() + srv->cfg.idle_ms;
+        }
+
+      ev.events   = EPOLLIN;
+      ev.data.ptr = conn;
+      if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, sd, &ev) < 0)
+        {
+          nerr("ERROR: epoll_ctl failure: %d\n", errno);
+          close(sd);
+          free(conn);
+          atomic_fetch_sub(&srv->nconns, 1);
+          return;
+        }
+
+      conn->flink = loop->conns;
+      loop->conns = conn;
+
+      if (srv->cfg.on_open != NULL && srv->cfg.on_open(conn,
+                                                       srv->cfg.arg) < 0)
+        {
+          /* Rejected, on_close() is not called */
+
+          epoll_ctl(loop->epfd, EPOLL_CTL_DEL, sd, NULL);
+          close(sd);
+          conn->sd = -1;
+          atomic_fetch_sub(&srv->nconns, 1);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: tcpserver_timers
+ *
+ * Description:
+ *   Run the expired timers of an event loop and return the time to the
+ *   next one
+ *
+ ****************************************************************************/
+
+static int tcpserver_timers(FAR struct netlib_tcploop_s *loop)
+{
+  FAR struct netlib_tcpserver_s *srv = loop->srv;
+  FAR struct netlib_tcpconn_s *conn;
+  uint64_t now = tcpserver_now();
+  int timeout = TCPSERVER_POLL_MS;
+
+  for (conn = loop->conns; conn != NULL; conn = conn->flink)
+    {
+      if (conn->sd < 0 || conn->deadline == 0)
+        {
+          continue;
+        }
+
+      if (conn->deadline <= now)
+        {
+          conn->deadline = 0;
+          if (srv->cfg.on_timer == NULL ||
+              srv->cfg.on_timer(conn, srv->cfg.arg) < 0)
+            {
+              tcpserver_close(conn);
+              continue;
+            }
+
+          if (conn->deadline == 0)
+            {
+              continue;
+            }
+        }
+
+      if (conn->deadline - now < (uint64_t)timeout)
+        {
+          timeout = conn->deadline - now;
+        }
+    }
+
+  return timeout;
+}
+
+/****************************************************************************
+ * Name: tcpserver_loop
+ *
+ * Description:
+ *   A thread of NETLIB_TCPSERVER_EVENT.  All the loops poll the same
+ *   listening socket and serve the connections they accepted.
+ *
+ ****************************************************************************/
+
+static FAR void *tcpserver_loop(FAR void *arg)
+{
+  FAR struct netlib_tcploop_s *loop = arg;
+  FAR struct netlib_tcpserver_s *srv = loop->srv;
+  struct epoll_event events[TCPSERVER_NEVENTS];
+  FAR struct netlib_tcpconn_s *conn;
+  struct epoll_event ev;
+  bool room;
+  int timeout;
+  int nev;
+  int i;
+
+  while (!atomic_load(&srv->stop))
+    {
+      /* Stop polling the listener at the connection limit */
+
+      room = srv->cfg.maxconns <= 0 ||
+             atomic_load(&srv->nconns) < srv->cfg.maxconns;
+      if (room != loop->listening)
+        {
+          ev.events   = EPOLLIN;
+          ev.data.ptr = NULL;
+          epoll_ctl(loop->epfd, room ? EPOLL_CTL_ADD : EPOLL_CTL_DEL,
+                    srv->listensd, &ev);
+          loop->listening = room;
+        }
+
+      timeout = tcpserver_timers(loop);
+      tcpserver_reap(loop);
+
+      nev = epoll_wait(loop->epfd, events, TCPSERVER_NEVENTS, timeout);
+      for (i = 0; i < nev; i++)
+        {
+          conn = events[i].data.ptr;
+          if (conn == NULL)
+            {
+              tcpserver_accept(loop);
+            }
+          else if (conn->sd >= 0)
+            {
+              if (srv->cfg.idle_ms > 0)
+                {
+                  conn->deadline = tcpserver_now() + srv->cfg.idle_ms;
+                }
+
+              if (srv->cfg.on_read(conn, srv->cfg.arg) < 0)
+                {
+                  tcpserver_close(conn);
+                }
+            }
+        }
+
+      tcpserver_reap(loop);
+    }
+
+  for (conn = loop->conns; conn != NULL; conn = conn->flink)
+    {
+      tcpserver_close(conn);
+    }
+
+  tcpserver_reap(loop);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: tcpserver_free
+ ****************************************************************************/
+
+static void tcpserver_free(FAR struct netlib_tcpserver_s *srv)
+{
+  int i;
+
+  if (srv->loops != NULL)
+    {
+      for (i = 0; i < srv->nthreads; i++)
+        {
+          if (srv->loops[i].epfd >= 0)
+            {
+              close(srv->loops[i].epfd);
+            }
+        }
+
+      free(srv->loops);
+    }
+
+  if (srv->queue != NULL)
+    {
+      pthread_mutex_destroy(&srv->lock);
+      sem_destroy(&srv->items);
+      sem_destroy(&srv->slots);
+      free(srv->queue);
+    }
+
+  free(srv->threads);
+  close(srv->listensd);
+  free(srv);
+}
+
+/****************************************************************************
+ * Name: tcpserver_join
+ *
+ * Description:
+ *   Stop and join the first n threads
+ *
+ ****************************************************************************/
+
+static void tcpserver_join(FAR struct netlib_tcpserver_s *srv, int n,
+                           bool acceptor)
+{
+  int i;
+
+  atomic_store(&srv->stop, true);
+
+  if (acceptor)
+    {
+      pthread_join(srv->acceptor, NULL);
+    }
+
+  if (srv->queue != NULL)
+    {
+      /* Wake up the workers, they leave once the queue is empty */
+
+      for (i = 0; i < n; i++)
+        {
+          sem_post(&srv->items);
+        }
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      pthread_join(srv->threads[i], NULL);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: netlib_tcpserver_start
+ *
+ * Description:
+ *   Start a TCP server with the threading model selected by cfg->model.
+ *   See struct netlib_tcpserver_cfg_s.
+ *
+ * Parameters:
+ *   cfg  The server configuration, it is copied
+ *
+ * Return:
+ *   The server to pass to netlib_tcpserver_stop(), or NULL with errno set
+ *   on failure.
+ *
+ ****************************************************************************/
+
+FAR struct netlib_tcpserver_s *
+netlib_tcpserver_start(FAR const struct netlib_tcpserver_cfg_s *cfg)
+{
+  FAR struct netlib_tcpserver_s *srv;
+  pthread_attr_t attr;
+#ifdef CONFIG_SMP
+  cpu_set_t cpuset;
+#endif
+  int ret = OK;
+  int i;
+
+  if ((cfg->model == NETLIB_TCPSERVER_POOL && cfg->handler == NULL) ||
+      (cfg->model == NETLIB_TCPSERVER_EVENT && cfg->on_read == NULL) ||
+      cfg->model > NETLIB_TCPSERVER_EVENT)
+    {
+      errno = EINVAL;
+      return NULL;
+    }
+
+  srv = zalloc(sizeof(struct netlib_tcpserver_s));
+  if (srv == NULL)
+    {
+      errno = ENOMEM;
+      return NULL;
+    }
+
+  memcpy(&srv->cfg, cfg, sizeof(struct netlib_tcpserver_cfg_s));
+  srv->nthreads = cfg->nthreads > 0 ? cfg->nthreads : TCPSERVER_NCPUS;
+
+  srv->listensd = netlib_listenon(cfg->portno);
+  if (srv->listensd < 0)
+    {
+      free(srv);
+      return NULL;
+    }
+
+  srv->threads = calloc(srv->nthreads, sizeof(pthread_t));
+  if (srv->threads == NULL)
+    {
+      ret = ENOMEM;
+      goto errout;
+    }
+
+  if (cfg->model == NETLIB_TCPSERVER_POOL)
+    {
+      /* The queue holds the connections being served and those waiting
+       * for a thread.
+       */
+
+      srv->qsize = cfg->maxconns > srv->nthreads ?
+                   cfg->maxconns : srv->nthreads;
+      srv->queue = calloc(srv->qsize, sizeof(int));
+      if (srv->queue == NULL)
+        {
+          ret = ENOMEM;
+          goto errout;
+        }
+
+      pthread_mutex_init(&srv->lock, NULL);
+      sem_init(&srv->slots, 0, srv->qsize);
+      sem_init(&srv->items, 0, 0);
+    }
+  else
+    {
+      /* The listener is polled by all the loops */
+
+      fcntl(srv->listensd, F_SETFL,
+            fcntl(srv->listensd, F_GETFL) | O_NONBLOCK);
+
+      srv->loops = calloc(srv->nthreads, sizeof(struct netlib_tcploop_s));
+      if (srv->loops == NULL)
+        {
+          ret = ENOMEM;
+          goto errout;
+        }
+
+      for (i = 0; i < srv->nthreads; i++)
+        {
+          srv->loops[i].srv  = srv;
+          srv->loops[i].epfd = -1;
+        }
+
+      for (i = 0; i < srv->nthreads; i++)
+        {
+          srv->loops[i].epfd = epoll_create1(EPOLL_CLOEXEC);
+          if (srv->loops[i].epfd < 0)
+            {
+              ret = errno;
+              goto errout;
+            }
+        }
+    }
+
+  for (i = 0; i < srv->nthreads; i++)
+    {
+      pthread_attr_init(&attr);
+      if (cfg->stacksize > 0)
+        {
+          pthread_attr_setstacksize(&attr, cfg->stacksize);
+        }
+
+      if (cfg->model == NETLIB_TCPSERVER_POOL)
+        {
+          ret = pthread_create(&srv->threads[i], &attr,
+                               tcpserver_worker, srv);
+        }
+      else
+        {
+#ifdef CONFIG_SMP
+          /* One event loop per CPU */
+
+          CPU_ZERO(&cpuset);
+          CPU_SET(i % CONFIG_SMP_NCPUS, &cpuset);
+          pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+#endif
+          ret = pthread_create(&srv->threads[i], &attr,
+                               tcpserver_loop, &srv->loops[i]);
+        }
+
+      pthread_attr_destroy(&attr);
+      if (ret != 0)
+        {
+          tcpserver_join(srv, i, false);
+          goto errout;
+        }
+    }
+
+  if (cfg->model == NETLIB_TCPSERVER_POOL)
+    {
+      pthread_attr_init(&attr);
+      if (cfg->stacksize > 0)
+        {
+          pthread_attr_setstacksize(&attr, cfg->stacksize);
+        }
+
+      ret = pthread_create(&srv->acceptor, &attr, tcpserver_acceptor, srv);
+      pthread_attr_destroy(&attr);
+      if (ret != 0)
+        {
+          tcpserver_join(srv, srv->nthreads, false);
+          goto errout;
+        }
+    }
+
+  ninfo("Serving port %d with %d threads\n",
+        ntohs(cfg->portno), srv->nthreads);
+  return srv;
+
+errout:
+  nerr("ERROR: Failed to start the server: %d\n", ret);
+  tcpserver_free(srv);
+  errno = ret;
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: netlib_tcpserver_stop
+ *
+ * Description:
+ *   Stop a server started by netlib_tcpserver_start().  The pool model
+ *   serves the queued connections before it returns, the event model
+ *   closes all its connections.  May take up to a second.
+ *
+ ****************************************************************************/
+
+void netlib_tcpserver_stop(FAR struct netlib_tcpserver_s *srv)
+{
+  tcpserver_join(srv, srv->nthreads,
+                 srv->cfg.model == NETLIB_TCPSERVER_POOL);
+  tcpserver_free(srv);
+}
+
+/****************************************************************************
+ * Name: netlib_tcpconn_fd
+ *
+ * Description:
+ *   Return the (non-blocking) socket of an event model connection
+ *
+ ****************************************************************************/
+
+int netlib_tcpconn_fd(FAR struct netlib_tcpconn_s *conn)
+{
+  return conn->sd;
+}
+
+/****************************************************************************
+ * Name: netlib_tcpconn_priv / netlib_tcpconn_setpriv
+ *
+ * Description:
+ *   Get and set the private data of an event model connection
+ *
+ ****************************************************************************/
+
+FAR void *netlib_tcpconn_priv(FAR struct netlib_tcpconn_s *conn)
+{
+  return conn->priv;
+}
+
+void netlib_tcpconn_setpriv(FAR struct netlib_tcpconn_s *conn,
+                            FAR void *priv)
+{
+  conn->priv = priv;
+}
+
+/****************************************************************************
+ * Name: netlib_tcpconn_settimer
+ *
+ * Description:
+ *   Arm the timer of an event model connection to expire in ms
+ *   milliseconds, or disarm it if ms is zero.  cfg->on_timer() is called
+ *   at expiry, the connection is closed if it is NULL.  With an idle
+ *   timeout the timer is re-armed before each on_read().
+ *
+ ****************************************************************************/
+
+void netlib_tcpconn_settimer(FAR struct netlib_tcpconn_s *conn,
+                             unsigned int ms)
+{
+  conn->deadline = ms > 0 ? tcpserver_now() + ms : 0;
+}
@@ -24,6 +24,7 @@
 
 #include <nuttx/config.h>
 
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -51,6 +52,9 @@
 #include <nuttx/clock.h>
 
 #include "netutils/ntpclient.h"
+#ifdef CONFIG_NETUTILS_NTPCLIENT_SAVE_FREQ
+#  include "system/settings.h"
+#endif
 
 #include "ntpv3.h"
 
@@ -101,6 +105,26 @@
 
 #define MAX_SERVER_SELECTION_RETRIES 3
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+#  define NTP_FILTER_LEN     8       /* Clock filter stages */
+#  define NTP_MIN_CLOCK      3       /* Minimum survivors of clustering */
+#  define NTP_MAX_PEERS      CONFIG_NETUTILS_NTPCLIENT_NUM_SAMPLES
+#  define NTP_PHI_PPB        15000   /* Dispersion growth rate, 15 PPM */
+#  define NTP_MAX_DISP_NS    (16ll * NSEC_PER_SEC)
+#  define NTP_MAX_FREQ_PPB   500000  /* Frequency tolerance, 500 PPM */
+#  define NTP_FLL_GAIN       4       /* Frequency update divider */
+#  define NTP_POLL_GATE      4       /* Offset/jitter ratio to back off */
+#  define NTP_POLL_LIMIT     4       /* Good updates before backing off */
+#  define NTP_FREQ_SAVE_PPB  50      /* Change that is worth persisting */
+#  define NTP_STEP_NS \
+          ((int64_t)CONFIG_NETUTILS_NTPCLIENT_STEP_MS * NSEC_PER_MSEC)
+#  define NTP_SLEW_PERIOD_NS \
+          ((int64_t)CONFIG_CLOCK_ADJTIME_PERIOD_MS * NSEC_PER_MSEC)
+#  define NTP_SLEW_MAX_NS \
+          ((int64_t)CONFIG_CLOCK_ADJTIME_SLEWLIMIT_PPM * \
+           CONFIG_CLOCK_ADJTIME_PERIOD_MS)
+#endif
+
 #ifndef STR
 #  define STR2(x) #x
 #  define STR(x) STR2(x)
@@ -154,6 +178,10 @@ struct ntp_sample_s
   int64_t offset;
   int64_t delay;
   union ntp_addr_u srv_addr;
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+  int64_t rootdelay;   /* Server root delay in nanoseconds */
+  int64_t rootdisp;    /* Server root dispersion in nanoseconds */
+#endif
 } packet_struct;
 
 /* Server address list. */
@@ -177,6 +205,54 @@ struct ntp_kod_exclude_s
   union ntp_addr_u addr;
 };
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+/* One stage of the clock filter, times in nanoseconds. */
+
+struct ntp_filter_s
+{
+  int64_t offset;
+  int64_t delay;
+  int64_t disp;
+  time_t time;         /* CLOCK_MONOTONIC seconds of the sample */
+};
+
+/* Per server state. */
+
+struct ntp_peer_s
+{
+  union ntp_addr_u addr;
+  struct ntp_filter_s filter[NTP_FILTER_LEN];
+  uint8_t head;        /* Next filter stage to write */
+  uint8_t count;       /* Valid filter stages */
+  uint8_t reach;       /* Shift register of answered polls */
+  bool fresh;          /* Filter output is from the latest poll */
+  bool has_drift;      /* drift is valid */
+  int64_t rootdelay;
+  int64_t rootdisp;
+  int64_t offset;      /* Clock filter output */
+  int64_t delay;
+  int64_t disp;
+  int64_t jitter;
+  int64_t drift;       /* Residual frequency error in PPB */
+};
+
+/* Clock discipline state. */
+
+struct ntp_discipline_s
+{
+  struct ntp_peer_s peers[NTP_MAX_PEERS];
+  bool freq_valid;             /* freq has been measured or loaded */
+  int64_t freq;                /* Frequency correction in PPB */
+  int64_t slew;                /* Offset still to be slewed in ns */
+  int64_t applied;             /* Offset slewed since the last poll */
+  int poll;                    /* Current poll interval in seconds */
+  int poll_count;
+#ifdef CONFIG_NETUTILS_NTPCLIENT_SAVE_FREQ
+  int32_t saved_freq;
+#endif
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -1167,6 +1243,15 @@ static int ntpc_get_ntp_sample(FAR struct ntp_servers_s *srvs,
                             xmit_time, recv_time, recv.recvtimestamp,
                             recv.xmittimestamp);
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+      /* Root delay and dispersion are in NTP short format (16.16). */
+
+      sample->rootdelay = ((uint64_t)ntpc_getuint32(recv.rootdelay) *
+                           NSEC_PER_SEC) >> 16;
+      sample->rootdisp = ((uint64_t)ntpc_getuint32(recv.rootdispersion) *
+                          NSEC_PER_SEC) >> 16;
+#endif
+
       return OK;
     }
   else
@@ -1198,6 +1283,734 @@ sock_error:
   return ERROR;
 }
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+
+/****************************************************************************
+ * Name: ntpc_ntp2ns
+ *
+ * Description:
+ *   Convert a signed NTP 32.32 fixed point interval to nanoseconds
+ *
+ ****************************************************************************/
+
+static int64_t ntpc_ntp2ns(int64_t value)
+{
+  uint64_t absval = int64abs(value);
+  int64_t ns;
+
+  ns = (int64_t)ntp_secpart(absval) * NSEC_PER_SEC + ntp_nsecpart(absval);
+  return value < 0 ? -ns : ns;
+}
+
+/****************************************************************************
+ * Name: ntpc_ns2ntp
+ *
+ * Description:
+ *   Convert nanoseconds to a signed NTP 32.32 fixed point interval
+ *
+ ****************************************************************************/
+
+static int64_t ntpc_ns2ntp(int64_t ns)
+{
+  uint64_t absval = int64abs(ns);
+  uint64_t value;
+
+  value  = (absval / NSEC_PER_SEC) << 32;
+  value += ((absval % NSEC_PER_SEC) << 32) / NSEC_PER_SEC;
+  return ns < 0 ? -(int64_t)value : (int64_t)value;
+}
+
+/****************************************************************************
+ * Name: ntpc_isqrt
+ ****************************************************************************/
+
+static uint64_t ntpc_isqrt(uint64_t value)
+{
+  uint64_t result = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+
+  while (bit > value)
+    {
+      bit >>= 2;
+    }
+
+  while (bit != 0)
+    {
+      if (value >= result + bit)
+        {
+          value -= result + bit;
+          result = (result >> 1) + bit;
+        }
+      else
+        {
+          result >>= 1;
+        }
+
+      bit >>= 2;
+    }
+
+  return result;
+}
+
+/****************************************************************************
+ * Name: ntpc_sqr_us
+ *
+ * Description:
+ *   Square of an interval in microseconds, clamped to 100 seconds so that
+ *   the sums used for the jitter cannot overflow.
+ *
+ ****************************************************************************/
+
+static int64_t ntpc_sqr_us(int64_t ns)
+{
+  int64_t us = int64abs(ns) / NSEC_PER_USEC;
+
+  us = MIN(us, 100 * (int64_t)USEC_PER_SEC);
+  return us * us;
+}
+
+/****************************************************************************
+ * Name: ntpc_adjtime
+ ****************************************************************************/
+
+static int ntpc_adjtime(int64_t delta_ns)
+{
+  struct timeval delta;
+
+  delta.tv_sec  = delta_ns / NSEC_PER_SEC;
+  delta.tv_usec = (delta_ns % NSEC_PER_SEC) / NSEC_PER_USEC;
+  return adjtime(&delta, NULL);
+}
+
+/****************************************************************************
+ * Name: ntpc_add_sample
+ *
+ * Description:
+ *   Shift a new sample into the clock filter of its server, allocating a
+ *   peer for servers that are not tracked yet.
+ *
+ ****************************************************************************/
+
+static void ntpc_add_sample(FAR struct ntp_discipline_s *disc,
+                            FAR const struct ntp_sample_s *sample,
+                            time_t now)
+{
+  FAR struct ntp_peer_s *peer = NULL;
+  FAR struct ntp_filter_s *stage;
+  int i;
+
+  for (i = 0; i < NTP_MAX_PEERS; i++)
+    {
+      if (disc->peers[i].count > 0 &&
+          memcmp(&disc->peers[i].addr, &sample->srv_addr,
+                 sizeof(union ntp_addr_u)) == 0)
+        {
+          peer = &disc->peers[i];
+          break;
+        }
+
+      if (peer == NULL && disc->peers[i].count == 0)
+        {
+          peer = &disc->peers[i];
+        }
+    }
+
+  if (peer == NULL)
+    {
+      ninfo("No free peer, sample dropped\n");
+      return;
+    }
+
+  if (peer->count == 0)
+    {
+      peer->addr = sample->srv_addr;
+    }
+
+  /* The sample dispersion starts at the clock precision plus the
+   * frequency tolerance over the round trip.
+   */
+
+  stage         = &peer->filter[peer->head];
+  stage->offset = ntpc_ntp2ns(sample->offset);
+  stage->delay  = MAX(ntpc_ntp2ns(sample->delay), (int64_t)NSEC_PER_TICK);
+  stage->disp   = NSEC_PER_TICK + NTP_PHI_PPB * stage->delay / NSEC_PER_SEC;
+  stage->time   = now;
+
+  peer->head = (peer->head + 1) % NTP_FILTER_LEN;
+  if (peer->count < NTP_FILTER_LEN)
+    {
+      peer->count++;
+    }
+
+  peer->reach    |= 1;
+  peer->rootdelay = sample->rootdelay;
+  peer->rootdisp  = sample->rootdisp;
+}
+
+/****************************************************************************
+ * Name: ntpc_clock_filter
+ *
+ * Description:
+ *   Select the filter stage with the lowest delay, which is the one least
+ *   affected by queueing, and compute the peer dispersion and jitter.
+ *
+ ****************************************************************************/
+
+static void ntpc_clock_filter(FAR struct ntp_peer_s *peer, time_t now)
+{
+  uint8_t order[NTP_FILTER_LEN];
+  FAR const struct ntp_filter_s *best;
+  FAR const struct ntp_filter_s *stage;
+  int64_t jitter = 0;
+  int64_t disp;
+  int i;
+  int j;
+  int k;
+
+  /* Sort the stages by delay, the newest first among equal delays. */
+
+  for (i = 0; i < peer->count; i++)
+    {
+      k = (peer->head + NTP_FILTER_LEN - 1 - i) % NTP_FILTER_LEN;
+      for (j = i; j > 0 && peer->filter[order[j - 1]].delay >
+                           peer->filter[k].delay; j--)
+        {
+          order[j] = order[j - 1];
+        }
+
+      order[j] = k;
+    }
+
+  best         = &peer->filter[order[0]];
+  peer->offset = best->offset;
+  peer->delay  = best->delay;
+  peer->fresh  = order[0] == (peer->head + NTP_FILTER_LEN - 1) %
+                             NTP_FILTER_LEN;
+
+  /* The stage offsets are corrected for the offset slewed since they
+   * were taken, so the change from the next best stage to a new best one
+   * is what the frequency correction did not compensate.
+   */
+
+  peer->has_drift = false;
+  if (peer->fresh && peer->count > 1)
+    {
+      stage = &peer->filter[order[1]];
+      if (best->time > stage->time)
+        {
+          peer->drift = (best->offset - stage->offset) /
+                        (int64_t)(best->time - stage->time);
+          peer->has_drift = true;
+        }
+    }
+
+  /* Aged stage dispersions weighted by 1/2^(i+1) in delay order. */
+
+  peer->disp = 0;
+  for (i = 0; i < peer->count; i++)
+    {
+      stage = &peer->filter[order[i]];
+      disp  = stage->disp + NTP_PHI_PPB * (int64_t)(now - stage->time);
+      peer->disp += MIN(disp, NTP_MAX_DISP_NS) >> (i + 1);
+
+      if (i > 0)
+        {
+          jitter += ntpc_sqr_us(stage->offset - best->offset);
+        }
+    }
+
+  if (peer->count > 1)
+    {
+      jitter /= peer->count - 1;
+    }
+
+  peer->jitter = MAX((int64_t)ntpc_isqrt(jitter) * NSEC_PER_USEC,
+                     (int64_t)NSEC_PER_TICK);
+}
+
+/****************************************************************************
+ * Name: ntpc_rootdist
+ *
+ * Description:
+ *   Root synchronization distance of a peer, the maximum error of its
+ *   offset relative to the primary reference.
+ *
+ ****************************************************************************/
+
+static int64_t ntpc_rootdist(FAR const struct ntp_peer_s *peer, time_t now)
+{
+  FAR const struct ntp_filter_s *last;
+
+  last = &peer->filter[(peer->head + NTP_FILTER_LEN - 1) % NTP_FILTER_LEN];
+  return (peer->rootdelay + peer->delay) / 2 + peer->rootdisp +
+         peer->disp + peer->jitter +
+         NTP_PHI_PPB * (int64_t)(now - last->time);
+}
+
+/****************************************************************************
+ * Name: ntpc_select
+ *
+ * Description:
+ *   Find the servers whose correctness intervals [offset - rootdist,
+ *   offset + rootdist] intersect for a majority, prune the outliers until
+ *   their selection jitter is below the peer jitter and combine the
+ *   survivors weighted by their root distance.
+ *
+ * Returned Value:
+ *   The number of survivors, ERROR if there is no majority.  syspeer is
+ *   set to the survivor with the lowest root distance.
+ *
+ ****************************************************************************/
+
+static int ntpc_select(FAR struct ntp_discipline_s *disc, time_t now,
+                       FAR int64_t *offset, FAR int64_t *jitter,
+                       FAR struct ntp_peer_s **syspeer)
+{
+  struct
+  {
+    int64_t value;
+    int type;
+  } edge[3 * NTP_MAX_PEERS];
+
+  FAR struct ntp_peer_s *cand[NTP_MAX_PEERS];
+  int64_t dist[NTP_MAX_PEERS];
+  int64_t value;
+  int64_t low;
+  int64_t high;
+  int64_t wsum;
+  int64_t osum;
+  int64_t sel;
+  int64_t maxsel;
+  int64_t minjit;
+  int nedges = 0;
+  int allow;
+  int found;
+  int chime;
+  int type;
+  int worst;
+  int n = 0;
+  int i;
+  int j;
+
+  /* Candidates sorted by root distance. */
+
+  for (i = 0; i < NTP_MAX_PEERS; i++)
+    {
+      FAR struct ntp_peer_s *peer = &disc->peers[i];
+
+      if (peer->reach == 0 || peer->count == 0)
+        {
+          continue;
+        }
+
+      value = ntpc_rootdist(peer, now);
+      for (j = n; j > 0 && dist[j - 1] > value; j--)
+        {
+          cand[j] = cand[j - 1];
+          dist[j] = dist[j - 1];
+        }
+
+      cand[j] = peer;
+      dist[j] = value;
+      n++;
+    }
+
+  if (n == 0)
+    {
+      return ERROR;
+    }
+
+  /* Sorted lower ends, midpoints and upper ends of the intervals. */
+
+  for (i = 0; i < n; i++)
+    {
+      for (type = -1; type <= 1; type++)
+        {
+          value = cand[i]->offset + type * dist[i];
+          for (j = nedges; j > 0 && edge[j - 1].value > value; j--)
+            {
+              edge[j] = edge[j - 1];
+            }
+
+          edge[j].value = value;
+          edge[j].type  = type;
+          nedges++;
+        }
+    }
+
+  /* Intersection algorithm: find the smallest interval containing
+   * points from n - allow intervals and at most allow midpoints outside
+   * of it, allowing for as few falsetickers as possible.
+   */
+
+  low  = INT64_MAX;
+  high = INT64_MIN;
+  for (allow = 0; 2 * allow < n; allow++)
+    {
+      low   = INT64_MAX;
+      high  = INT64_MIN;
+      found = 0;
+      chime = 0;
+
+      for (i = 0; i < nedges; i++)
+        {
+          chime -= edge[i].type;
+          if (chime >= n - allow)
+            {
+              low = edge[i].value;
+              break;
+            }
+
+          if (edge[i].type == 0)
+            {
+              found++;
+            }
+        }
+
+      chime = 0;
+      for (i = nedges - 1; i >= 0; i--)
+        {
+          chime += edge[i].type;
+          if (chime >= n - allow)
+            {
+              high = edge[i].value;
+              break;
+            }
+
+          if (edge[i].type == 0)
+            {
+              found++;
+            }
+        }
+
+      if (found <= allow && high > low)
+        {
+          break;
+        }
+    }
+
+  if (2 * allow >= n)
+    {
+      nwarn("WARNING: no majority of the %d servers agree\n", n);
+      return ERROR;
+    }
+
+  /* Discard the falsetickers. */
+
+  for (i = 0, j = 0; i < n; i++)
+    {
+      if (cand[i]->offset + dist[i] >= low &&
+          cand[i]->offset - dist[i] <= high)
+        {
+          cand[j] = cand[i];
+          dist[j] = dist[i];
+          j++;
+        }
+    }
+
+  n = j;
+
+  /* Clustering: drop the survivor with the largest selection jitter
+   * while that is above the smallest peer jitter.
+   */
+
+  while (n > NTP_MIN_CLOCK)
+    {
+      maxsel = -1;
+      minjit = INT64_MAX;
+      worst  = 0;
+
+      for (i = 0; i < n; i++)
+        {
+          sel = 0;
+          for (j = 0; j < n; j++)
+            {
+              sel += ntpc_sqr_us(cand[i]->offset - cand[j]->offset);
+            }
+
+          sel = ntpc_isqrt(sel / (n - 1)) * NSEC_PER_USEC;
+          if (sel > maxsel)
+            {
+              maxsel = sel;
+              worst  = i;
+            }
+
+          minjit = MIN(minjit, cand[i]->jitter);
+        }
+
+      if (maxsel <= minjit)
+        {
+          break;
+        }
+
+      for (i = worst; i < n - 1; i++)
+        {
+          cand[i] = cand[i + 1];
+          dist[i] = dist[i + 1];
+        }
+
+      n--;
+    }
+
+  /* The first survivor is the system peer.  A step is taken from it
+   * alone, a slew from the weighted average of all survivors.
+   */
+
+  *offset  = cand[0]->offset;
+  *syspeer = cand[0];
+
+  if (int64abs(*offset) < NTP_STEP_NS)
+    {
+      wsum = 0;
+      osum = 0;
+      for (i = 0; i < n; i++)
+        {
+          value = MAX((1 << 24) / (dist[i] / NSEC_PER_USEC + 1), 1);
+          wsum += value;
+          osum += cand[i]->offset * value;
+        }
+
+      *offset = osum / wsum;
+    }
+
+  sel = 0;
+  for (i = 0; i < n; i++)
+    {
+      sel += ntpc_sqr_us(cand[i]->offset - cand[0]->offset);
+    }
+
+  *jitter = ntpc_isqrt(sel / n + ntpc_sqr_us(cand[0]->jitter)) *
+            NSEC_PER_USEC;
+  return n;
+}
+
+#ifdef CONFIG_NETUTILS_NTPCLIENT_SAVE_FREQ
+/****************************************************************************
+ * Name: ntpc_load_freq
+ ****************************************************************************/
+
+static void ntpc_load_freq(FAR struct ntp_discipline_s *disc)
+{
+  int freq = 0;
+  int ret;
+
+  ret = settings_create((FAR char *)CONFIG_NETUTILS_NTPCLIENT_FREQ_KEY,
+                        SETTING_INT, 0);
+  if (ret >= 0)
+    {
+      ret = settings_get((FAR char *)CONFIG_NETUTILS_NTPCLIENT_FREQ_KEY,
+                         SETTING_INT, &freq);
+    }
+
+  if (ret < 0)
+    {
+      nwarn("WARNING: cannot load the frequency: %d\n", ret);
+      return;
+    }
+
+  if (freq != 0)
+    {
+      ninfo("Frequency correction %d ppb\n", freq);
+      disc->freq       = freq;
+      disc->freq_valid = true;
+    }
+
+  disc->saved_freq = freq;
+}
+
+/****************************************************************************
+ * Name: ntpc_save_freq
+ ****************************************************************************/
+
+static void ntpc_save_freq(FAR struct ntp_discipline_s *disc)
+{
+  int ret;
+
+  if (int64abs(disc->freq - disc->saved_freq) < NTP_FREQ_SAVE_PPB)
+    {
+      return;
+    }
+
+  ret = settings_set((FAR char *)CONFIG_NETUTILS_NTPCLIENT_FREQ_KEY,
+                     SETTING_INT, (int)disc->freq);
+  if (ret < 0)
+    {
+      nwarn("WARNING: cannot save the frequency: %d\n", ret);
+      return;
+    }
+
+  disc->saved_freq = disc->freq;
+}
+#endif
+
+/****************************************************************************
+ * Name: ntpc_discipline
+ *
+ * Description:
+ *   Run the new samples through the clock filters and the selection, then
+ *   step the clock or set up the slew and update the frequency estimate
+ *   and the poll interval.
+ *
+ ****************************************************************************/
+
+static void ntpc_discipline(FAR struct ntp_discipline_s *disc,
+                            FAR const struct ntp_sample_s *samples,
+                            int nsamples,
+                            FAR struct timespec *start_realtime,
+                            FAR struct timespec *start_monotonic)
+{
+  const int64_t max_freq = MIN(NTP_MAX_FREQ_PPB,
+                               CONFIG_CLOCK_ADJTIME_SLEWLIMIT_PPM * 500);
+  FAR struct ntp_peer_s *syspeer;
+  FAR struct ntp_peer_s *peer;
+  struct timespec now;
+  int64_t offset;
+  int64_t jitter;
+  int ret;
+  int i;
+  int j;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  /* The stored offsets were measured before the offset slewed since the
+   * last poll.  The frequency correction only compensates the drift, so
+   * it does not change them.
+   */
+
+  for (i = 0; i < NTP_MAX_PEERS; i++)
+    {
+      peer = &disc->peers[i];
+      for (j = 0; j < peer->count; j++)
+        {
+          peer->filter[j].offset -= disc->applied;
+        }
+
+      peer->reach <<= 1;
+    }
+
+  disc->applied = 0;
+
+  for (i = 0; i < nsamples; i++)
+    {
+      ntpc_add_sample(disc, &samples[i], now.tv_sec);
+    }
+
+  /* Forget the servers that did not answer the last 8 polls. */
+
+  for (i = 0; i < NTP_MAX_PEERS; i++)
+    {
+      peer = &disc->peers[i];
+      if (peer->reach == 0)
+        {
+          memset(peer, 0, sizeof(*peer));
+        }
+      else if ((peer->reach & 1) != 0)
+        {
+          ntpc_clock_filter(peer, now.tv_sec);
+        }
+      else
+        {
+          peer->fresh = false;
+        }
+    }
+
+  ret = ntpc_select(disc, now.tv_sec, &offset, &jitter, &syspeer);
+  if (ret < 0)
+    {
+      return;
+    }
+
+  ninfo("%d survivors, offset %" PRId64 " ns, jitter %" PRId64 " ns\n",
+        ret, offset, jitter);
+
+  if ((syspeer->reach & 1) == 0)
+    {
+      ninfo("No new sample from the system peer\n");
+      return;
+    }
+
+  if (int64abs(offset) >= NTP_STEP_NS)
+    {
+      ntpc_settime(ntpc_ns2ntp(offset), start_realtime, start_monotonic);
+
+      /* The filters hold offsets from before the step, and the frequency
+       * measurement starts over.
+       */
+
+      memset(disc->peers, 0, sizeof(disc->peers));
+      disc->slew       = 0;
+      disc->poll       = CONFIG_NETUTILS_NTPCLIENT_POLLDELAYSEC;
+      disc->poll_count = 0;
+      return;
+    }
+
+  if (syspeer->has_drift)
+    {
+      disc->freq += syspeer->drift / (disc->freq_valid ? NTP_FLL_GAIN : 1);
+      disc->freq  = MIN(MAX(disc->freq, -max_freq), max_freq);
+      disc->freq_valid = true;
+    }
+
+  disc->slew = offset;
+
+  ninfo("Slew %" PRId64 " ns, frequency %" PRId64 " ppb\n",
+        offset, disc->freq);
+
+  /* Back off the poll interval while the offsets stay in the noise. */
+
+  if (int64abs(offset) < NTP_POLL_GATE * jitter)
+    {
+      if (disc->freq_valid && ++disc->poll_count >= NTP_POLL_LIMIT)
+        {
+          disc->poll_count = 0;
+          disc->poll = MIN(disc->poll * 2,
+                           CONFIG_NETUTILS_NTPCLIENT_MAXPOLLSEC);
+#ifdef CONFIG_NETUTILS_NTPCLIENT_SAVE_FREQ
+          ntpc_save_freq(disc);
+#endif
+        }
+    }
+  else
+    {
+      disc->poll_count = 0;
+      disc->poll = MAX(disc->poll / 2,
+                       CONFIG_NETUTILS_NTPCLIENT_POLLDELAYSEC);
+    }
+}
+
+/****************************************************************************
+ * Name: ntpc_discipline_wait
+ *
+ * Description:
+ *   Wait for the next poll, applying the frequency correction and slewing
+ *   the remaining offset each CLOCK_ADJTIME_PERIOD_MS.
+ *
+ ****************************************************************************/
+
+static void ntpc_discipline_wait(FAR struct ntp_discipline_s *disc)
+{
+  int64_t freq_ns = disc->freq * NTP_SLEW_PERIOD_NS / NSEC_PER_SEC;
+  int64_t limit = NTP_SLEW_MAX_NS - int64abs(freq_ns);
+  int64_t step;
+  int periods;
+
+  ninfo("Waiting for %d seconds\n", disc->poll);
+
+  periods = disc->poll * MSEC_PER_SEC / CONFIG_CLOCK_ADJTIME_PERIOD_MS;
+  while (periods-- > 0 && g_ntpc_daemon.state == NTP_RUNNING)
+    {
+      step = MIN(MAX(disc->slew, -limit), limit);
+      if (ntpc_adjtime(freq_ns + step) == OK)
+        {
+          disc->slew    -= step;
+          disc->applied += step;
+        }
+
+      usleep(CONFIG_CLOCK_ADJTIME_PERIOD_MS * USEC_PER_MSEC);
+    }
+}
+#endif /* CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE */
+
 /****************************************************************************
  * Name: ntpc_daemon
  *
@@ -1212,6 +2025,9 @@ static int ntpc_daemon(int argc, FAR char **argv)
 {
   FAR struct ntp_sample_s *samples;
   FAR struct ntp_servers_s *srvs;
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+  FAR struct ntp_discipline_s *disc;
+#endif
   int exitcode = EXIT_SUCCESS;
   int retries = 0;
   int nsamples;
@@ -1235,6 +2051,21 @@ static int ntpc_daemon(int argc, FAR char **argv)
       return EXIT_FAILURE;
     }
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+  disc = calloc(1, sizeof(*disc));
+  if (disc == NULL)
+    {
+      free(srvs);
+      free(samples);
+      return EXIT_FAILURE;
+    }
+
+  disc->poll = CONFIG_NETUTILS_NTPCLIENT_POLLDELAYSEC;
+#ifdef CONFIG_NETUTILS_NTPCLIENT_SAVE_FREQ
+  ntpc_load_freq(disc);
+#endif
+#endif
+
   /* Indicate that we have started */
 
   g_ntpc_daemon.state = NTP_RUNNING;
@@ -1305,7 +2136,9 @@ static int ntpc_daemon(int argc, FAR char **argv)
 
       if (nsamples > 0)
         {
+#ifndef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
           int64_t offset;
+#endif
 
           /* Select median offset of samples. */
 
@@ -1326,6 +2159,10 @@ static int ntpc_daemon(int argc, FAR char **argv)
                       / NSEC_PER_MSEC);
             }
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+          ntpc_discipline(disc, samples, nsamples, &start_realtime,
+                          &start_monotonic);
+#else
           if ((nsamples % 2) == 1)
             {
               offset = samples[nsamples / 2].offset;
@@ -1359,6 +2196,7 @@ static int ntpc_daemon(int argc, FAR char **argv)
           /* Adjust system time. */
 
           ntpc_settime(offset, &start_realtime, &start_monotonic);
+#endif
 
           /* Save samples for ntpc_status() */
 
@@ -1381,10 +2219,14 @@ static int ntpc_daemon(int argc, FAR char **argv)
 
           if (g_ntpc_daemon.state == NTP_RUNNING)
             {
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+              ntpc_discipline_wait(disc);
+#else
               ninfo("Waiting for %d seconds\n",
                     CONFIG_NETUTILS_NTPCLIENT_POLLDELAYSEC);
 
               sleep(CONFIG_NETUTILS_NTPCLIENT_POLLDELAYSEC);
+#endif
               retries = 0;
             }
 
@@ -1420,6 +2262,9 @@ static int ntpc_daemon(int argc, FAR char **argv)
   free(srvs->hostlist_str);
   free(srvs);
   free(samples);
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+  free(disc);
+#endif
   return exitcode;
 }
 
@@ -65,8 +65,9 @@ struct ping_priv_s
   struct icmp_hdr_s outhdr;
   struct pollfd recvfd;
   socklen_t addrlen;
-  clock_t kickoff;
-  clock_t start;
+  uint64_t kickoff;
+  uint64_t start;
+  uint32_t interval;
   ssize_t nsent;
   ssize_t nrecvd;
   long elapsed;
@@ -109,6 +110,22 @@ static inline uint16_t ping_newid(void)
   return ++g_pingid;
 }
 
+/****************************************************************************
+ * Name: ping_gettime
+ *
+ * Description:
+ *   Monotonic time in microseconds, as fine grained as the system clock.
+ *
+ ****************************************************************************/
+
+static uint64_t ping_gettime(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
 /****************************************************************************
  * Name: ping_gethostip
  *
@@ -230,7 +247,9 @@ void icmp_ping(FAR const struct ping_info_s *info)
       return;
     }
 
-  priv->kickoff = clock();
+  priv->kickoff = ping_gettime();
+  priv->interval = info->interval > 0 ? info->interval :
+                   (uint32_t)info->delay * USEC_PER_MSEC;
 
   memset(&priv->destaddr, 0, sizeof(struct sockaddr_in));
   priv->destaddr.sin_family      = AF_INET;
@@ -269,7 +288,7 @@ void icmp_ping(FAR const struct ping_info_s *info)
             }
         }
 
-      priv->start = clock();
+      priv->start = ping_gettime();
       priv->nsent = sendto(priv->sockfd, iobuffer, result.outsize, 0,
                            (FAR struct sockaddr *)&priv->destaddr,
                            sizeof(struct sockaddr_in));
@@ -325,7 +344,7 @@ void icmp_ping(FAR const struct ping_info_s *info)
               goto done;
             }
 
-          priv->elapsed = TICK2USEC(clock() - priv->start);
+          priv->elapsed = ping_gettime() - priv->start;
           inhdr         = (FAR struct icmp_hdr_s *)iobuffer;
 
           if (inhdr->type == ICMP_ECHO_REPLY)
@@ -397,25 +416,23 @@ void icmp_ping(FAR const struct ping_info_s *info)
               icmp_callback(&result, ICMP_W_TYPE, inhdr->type);
             }
         }
-      while (priv->retry && info->delay > priv->elapsed / USEC_PER_MSEC &&
+      while (priv->retry &&
+             (priv->interval == 0 || priv->interval > priv->elapsed) &&
              info->timeout > priv->elapsed / USEC_PER_MSEC);
 
-      /* Wait if necessary to preserved the requested ping rate */
+      /* Wait if necessary to preserved the requested ping rate.  With no
+       * interval the next request goes out as soon as the reply is in.
+       */
 
-      priv->elapsed = TICK2MSEC(clock() - priv->start);
-      if (priv->elapsed < info->delay)
+      priv->elapsed = ping_gettime() - priv->start;
+      if (priv->elapsed < priv->interval)
         {
           struct timespec rqt;
-          unsigned int remaining;
-          unsigned int sec;
-          unsigned int frac;  /* In deciseconds */
-
-          remaining   = info->delay - priv->elapsed;
-          sec         = remaining / MSEC_PER_SEC;
-          frac        = remaining - MSEC_PER_SEC * sec;
+          unsigned long remaining;
 
-          rqt.tv_sec  = sec;
-          rqt.tv_nsec = frac * NSEC_PER_MSEC;
+          remaining   = priv->interval - priv->elapsed;
+          rqt.tv_sec  = remaining / USEC_PER_SEC;
+          rqt.tv_nsec = remaining % USEC_PER_SEC * NSEC_PER_USEC;
 
           nanosleep(&rqt, NULL);
         }
@@ -424,7 +441,8 @@ void icmp_ping(FAR const struct ping_info_s *info)
     }
 
 done:
-  icmp_callback(&result, ICMP_I_FINISH, TICK2USEC(clock() - priv->kickoff));
+  icmp_callback(&result, ICMP_I_FINISH,
+                ping_gettime() - priv->kickoff);
   close(priv->sockfd);
   free(priv);
 }
@@ -86,6 +86,22 @@ static inline uint16_t ping6_newid(void)
   return ++g_ping6_id;
 }
 
+/****************************************************************************
+ * Name: ping6_gettime
+ *
+ * Description:
+ *   Monotonic time in microseconds, as fine grained as the system clock.
+ *
+ ****************************************************************************/
+
+static uint64_t ping6_gettime(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
 /****************************************************************************
  * Name: ping6_gethostip
  *
@@ -173,8 +189,9 @@ void icmp6_ping(FAR const struct ping6_info_s *info)
   FAR uint8_t *iobuffer;
   FAR uint8_t *ptr;
   long elapsed;
-  clock_t kickoff;
-  clock_t start;
+  uint64_t kickoff;
+  uint64_t start;
+  uint32_t interval;
   socklen_t addrlen;
   ssize_t nsent;
   ssize_t nrecvd;
@@ -216,7 +233,9 @@ void icmp6_ping(FAR const struct ping6_info_s *info)
       return;
     }
 
-  kickoff = clock();
+  kickoff  = ping6_gettime();
+  interval = info->interval > 0 ? info->interval :
+             (uint32_t)info->delay * USEC_PER_MSEC;
 
   memset(&destaddr, 0, sizeof(struct sockaddr_in6));
   destaddr.sin6_family     = AF_INET6;
@@ -255,7 +274,7 @@ void icmp6_ping(FAR const struct ping6_info_s *info)
             }
         }
 
-      start = clock();
+      start = ping6_gettime();
       nsent = sendto(sockfd, iobuffer, result.outsize, 0,
                      (FAR struct sockaddr *)&destaddr,
                      sizeof(struct sockaddr_in6));
@@ -309,7 +328,7 @@ void icmp6_ping(FAR const struct ping6_info_s *info)
               goto done;
             }
 
-          elapsed = TICK2USEC(clock() - start);
+          elapsed = ping6_gettime() - start;
           inhdr   = (FAR struct icmpv6_echo_reply_s *)iobuffer;
 
           if (inhdr->type == ICMPv6_ECHO_REPLY)
@@ -382,25 +401,22 @@ void icmp6_ping(FAR const struct ping6_info_s *info)
               icmp6_callback(&result, ICMPv6_W_TYPE, inhdr->type);
             }
         }
-      while (retry && info->delay > elapsed / USEC_PER_MSEC &&
+      while (retry && (interval == 0 || interval > elapsed) &&
              info->timeout > elapsed / USEC_PER_MSEC);
 
-      /* Wait if necessary to preserved the requested ping rate */
+      /* Wait if necessary to preserved the requested ping rate.  With no
+       * interval the next request goes out as soon as the reply is in.
+       */
 
-      elapsed = TICK2MSEC(clock() - start);
-      if (elapsed < info->delay)
+      elapsed = ping6_gettime() - start;
+      if (elapsed < interval)
         {
           struct timespec rqt;
-          unsigned int remaining;
-          unsigned int sec;
-          unsigned int frac;  /* In deciseconds */
-
-          remaining   = info->delay - elapsed;
-          sec         = remaining / MSEC_PER_SEC;
-          frac        = remaining - MSEC_PER_SEC * sec;
+          unsigned long remaining;
 
-          rqt.tv_sec  = sec;
-          rqt.tv_nsec = frac * NSEC_PER_MSEC;
+          remaining   = interval - elapsed;
+          rqt.tv_sec  = remaining / USEC_PER_SEC;
+          rqt.tv_nsec = remaining % USEC_PER_SEC * NSEC_PER_USEC;
 
           nanosleep(&rqt, NULL);
         }
@@ -409,7 +425,7 @@ void icmp6_ping(FAR const struct ping6_info_s *info)
     }
 
 done:
-  icmp6_callback(&result, ICMPv6_I_FINISH, TICK2USEC(clock() - kickoff));
+  icmp6_callback(&result, ICMPv6_I_FINISH, ping6_gettime() - kickoff);
   close(sockfd);
   free(iobuffer);
 }
@@ -0,0 +1,154 @@
+/****************************************************************************
+ * apps/netutils/ping/ping_hist.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "netutils/ping_hist.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ping_hist_index
+ ****************************************************************************/
+
+static int ping_hist_index(uint32_t usec)
+{
+  int e;
+
+  if (usec < 16)
+    {
+      return usec;
+    }
+
+  e = 31 - __builtin_clz(usec);
+  return 16 + (e - 4) * 8 + ((usec >> (e - 3)) & 7);
+}
+
+/****************************************************************************
+ * Name: ping_hist_value
+ *
+ * Description:
+ *   Upper bound of a bucket in microseconds
+ *
+ ****************************************************************************/
+
+static uint32_t ping_hist_value(int idx)
+{
+  int e;
+
+  if (idx < 16)
+    {
+      return idx;
+    }
+
+  e = (idx - 16) / 8 + 4;
+  return ((uint32_t)(8 + (idx - 16) % 8) << (e - 3)) +
+         ((uint32_t)1 << (e - 3)) - 1;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ping_hist_add
+ ****************************************************************************/
+
+void ping_hist_add(FAR struct ping_hist_s *hist, uint32_t usec)
+{
+  hist->bucket[ping_hist_index(usec)]++;
+  hist->count++;
+}
+
+/****************************************************************************
+ * Name: ping_hist_percentile
+ ****************************************************************************/
+
+uint32_t ping_hist_percentile(FAR const struct ping_hist_s *hist,
+                              unsigned int permille)
+{
+  uint32_t want = (uint32_t)(((uint64_t)hist->count * permille + 999) /
+                             1000);
+  uint32_t sum = 0;
+  int i;
+
+  for (i = 0; i < PING_HIST_BUCKETS; i++)
+    {
+      sum += hist->bucket[i];
+      if (sum >= want && sum > 0)
+        {
+          return ping_hist_value(i);
+        }
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: ping_hist_print
+ ****************************************************************************/
+
+void ping_hist_print(FAR const struct ping_hist_s *hist, bool verbose)
+{
+  uint32_t lower = 0;
+  int i;
+
+  if (hist->count == 0)
+    {
+      return;
+    }
+
+  printf("rtt p50/p90/p99/p99.9 = %" PRIu32 "/%" PRIu32 "/%" PRIu32
+         "/%" PRIu32 " us\n",
+         ping_hist_percentile(hist, 500),
+         ping_hist_percentile(hist, 900),
+         ping_hist_percentile(hist, 990),
+         ping_hist_percentile(hist, 999));
+
+  if (!verbose)
+    {
+      return;
+    }
+
+  for (i = 0; i < PING_HIST_BUCKETS; i++)
+    {
+      if (hist->bucket[i] > 0)
+        {
+          uint32_t permille = (uint64_t)hist->bucket[i] * 1000 /
+                              hist->count;
+
+          printf("  %8" PRIu32 " - %8" PRIu32 " us: %8" PRIu32
+                 " %3" PRIu32 ".%" PRIu32 "%%\n",
+                 lower, ping_hist_value(i), hist->bucket[i],
+                 permille / 10, permille % 10);
+        }
+
+      lower = ping_hist_value(i) + 1;
+    }
+}
@@ -42,6 +42,9 @@
  * Included Files
  ****************************************************************************/
 
+#include <stdbool.h>
+#include <string.h>
+
 #include "ppp_conf.h"
 #include "ppp.h"
 
@@ -57,6 +60,60 @@
 #  define PACKET_TX_DEBUG 0
 #endif
 
+/* Word at a time tests, true if any byte of the 32-bit word x is zero or
+ * is less than n (n <= 0x80).
+ */
+
+#define AHDLC_ONES          0x01010101u
+#define AHDLC_HIGHS         0x80808080u
+#define AHDLC_HASLESS(x, n) \
+  ((((x) - AHDLC_ONES * (n)) & ~(x) & AHDLC_HIGHS) != 0)
+#define AHDLC_HASZERO(x)    AHDLC_HASLESS(x, 1)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+/* FCS-16 lookup table, polynomial x^16 + x^12 + x^5 + 1 (RFC 1662) */
+
+static const uint16_t g_fcstab[256] =
+{
+  0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+  0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+  0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+  0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+  0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+  0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+  0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+  0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+  0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+  0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+  0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+  0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+  0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+  0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+  0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+  0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+  0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+  0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+  0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+  0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+  0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+  0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+  0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+  0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+  0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+  0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+  0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+  0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+  0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+  0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+  0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+  0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
+};
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -86,6 +143,92 @@ static uint16_t crcadd(uint16_t crcvalue, uint8_t c)
   return ((crcvalue >> 8) ^ b);
 }
 
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+/****************************************************************************
+ * Name: ahdlc_span
+ *
+ * Description:
+ *   Return the length of the leading run of buf that goes through AHDLC
+ *   unchanged: no flag (0x7e), no escape (0x7d) and, if ctrl is set, no
+ *   control character.  Four bytes are tested at a time.
+ *
+ ****************************************************************************/
+
+static size_t ahdlc_span(FAR const uint8_t *buf, size_t len, bool ctrl)
+{
+  size_t i = 0;
+  uint32_t x;
+
+  for (; i + 4 <= len; i += 4)
+    {
+      memcpy(&x, &buf[i], 4);
+      if (AHDLC_HASZERO(x ^ 0x7e7e7e7eu) || AHDLC_HASZERO(x ^ 0x7d7d7d7du) ||
+          (ctrl && AHDLC_HASLESS(x, 0x20)))
+        {
+          break;
+        }
+    }
+
+  for (; i < len; i++)
+    {
+      if (buf[i] == 0x7e || buf[i] == 0x7d || (ctrl && buf[i] < 0x20))
+        {
+          break;
+        }
+    }
+
+  return i;
+}
+
+/****************************************************************************
+ * Name: ahdlc_tx_escape
+ *
+ * Description:
+ *   Escape len bytes of buf into the transmit buffer out, writing out to
+ *   the serial device each time it fills up.
+ *
+ ****************************************************************************/
+
+static void ahdlc_tx_escape(FAR struct ppp_context_s *ctx,
+                            FAR uint8_t *out, FAR size_t *outlen,
+                            FAR const uint8_t *buf, size_t len, bool ctrl)
+{
+  size_t n;
+
+  while (len > 0)
+    {
+      if (*outlen + 2 > AHDLC_TX_BUFFER_SIZE)
+        {
+          ppp_arch_write(ctx, out, *outlen);
+          *outlen = 0;
+        }
+
+      /* Copy the run of plain bytes that fits, then escape one byte */
+
+      n = ahdlc_span(buf, len, ctrl);
+      if (n > AHDLC_TX_BUFFER_SIZE - *outlen)
+        {
+          n = AHDLC_TX_BUFFER_SIZE - *outlen;
+        }
+
+      if (n > 0)
+        {
+          memcpy(&out[*outlen], buf, n);
+          *outlen += n;
+        }
+      else
+        {
+          out[(*outlen)++] = 0x7d;
+          out[(*outlen)++] = *buf ^ 0x20;
+          n = 1;
+        }
+
+      buf += n;
+      len -= n;
+    }
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -102,6 +245,11 @@ void ahdlc_init(struct ppp_context_s *ctx)
   ctx->ahdlc_rx_count = 0;
   ctx->ahdlc_tx_offline = 0;
 
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+  ctx->ahdlc_rx_chunkpos = 0;
+  ctx->ahdlc_rx_chunklen = 0;
+#endif
+
 #ifdef PPP_STATISTICS
   ctx->ahdlc_crc_error = 0;
   ctx->ahdlc_rx_tobig_error = 0;
@@ -297,6 +445,96 @@ uint8_t ahdlc_rx(FAR struct ppp_context_s *ctx, uint8_t c)
   return 0;
 }
 
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+/****************************************************************************
+ * Name: ahdlc_fcs
+ *
+ * Description:
+ *   Add len bytes to the running FCS-16 fcs, one table lookup per byte.
+ *
+ ****************************************************************************/
+
+uint16_t ahdlc_fcs(uint16_t fcs, FAR const uint8_t *buf, size_t len)
+{
+  while (len-- > 0)
+    {
+      fcs = (fcs >> 8) ^ g_fcstab[(fcs ^ *buf++) & 0xff];
+    }
+
+  return fcs;
+}
+
+/****************************************************************************
+ * Name: ahdlc_rx_buffer
+ *
+ * Description:
+ *   Process a buffer of bytes received from the serial device.  Runs of
+ *   bytes that need no unescaping are added to the frame with one copy
+ *   and one FCS update, the other bytes go through ahdlc_rx().
+ *
+ *   Processing stops after each flag byte so that the caller can handle a
+ *   frame that was passed up before the next one overwrites it.
+ *
+ * Returned Value:
+ *   The number of bytes of buf consumed
+ *
+ ****************************************************************************/
+
+size_t ahdlc_rx_buffer(FAR struct ppp_context_s *ctx,
+                       FAR const uint8_t *buf, size_t len)
+{
+  size_t room;
+  size_t i = 0;
+  size_t n;
+
+  if ((ctx->ahdlc_flags & PPP_RX_READY) == 0)
+    {
+      /* Busy, discard like ahdlc_rx() does */
+
+      return len;
+    }
+
+  while (i < len)
+    {
+      /* The start of a frame (address and control field compression) and
+       * escaped bytes are left to ahdlc_rx().
+       */
+
+      n = 0;
+      if (ctx->ahdlc_rx_count > 0 &&
+          (ctx->ahdlc_flags & PPP_ESCAPED) == 0)
+        {
+          n = ahdlc_span(&buf[i], len - i,
+                         (ctx->ahdlc_flags & PPP_RX_ASYNC_MAP) == 0);
+          room = PPP_RX_BUFFER_SIZE - ctx->ahdlc_rx_count;
+          if (n > room)
+            {
+              n = room;
+            }
+        }
+
+      if (n > 0)
+        {
+          ctx->ahdlc_rx_crc = ahdlc_fcs(ctx->ahdlc_rx_crc, &buf[i], n);
+          memcpy(&ctx->ahdlc_rx_buffer[ctx->ahdlc_rx_count], &buf[i], n);
+          ctx->ahdlc_rx_count += n;
+          i += n;
+        }
+      else if (buf[i] == 0x7e)
+        {
+          ahdlc_rx(ctx, buf[i]);
+          return i + 1;
+        }
+      else
+        {
+          ahdlc_rx(ctx, buf[i++]);
+        }
+    }
+
+  return i;
+}
+#endif
+
 /****************************************************************************
  * ahdlc_tx_char(char) - write a character to the serial device,
  * escape if necessary.
@@ -331,53 +569,20 @@ void ahdlc_tx_char(struct ppp_context_s *ctx, uint16_t protocol, uint8_t c)
 }
 
 /****************************************************************************
- * ahdlc_tx(protocol,buffer,len) - Transmit a PPP frame.
+ * Name: ahdlc_tx_bytes
  *
- *    Buffer contains protocol data, ahdlc_tx adds address, control and
- *    protocol data.
- *
- * Relies on local global vars    :    ahdlc_tx_crc, ahdlc_flags.
- * Modifies local global vars    :    ahdlc_tx_crc.
+ * Description:
+ *   Write one frame to the serial device a character at a time.
  *
  ****************************************************************************/
 
-uint8_t ahdlc_tx(struct ppp_context_s *ctx, uint16_t protocol,
-                 FAR uint8_t * header, FAR uint8_t * buffer,
-                 uint16_t headerlen, uint16_t datalen)
+void ahdlc_tx_bytes(FAR struct ppp_context_s *ctx, uint16_t protocol,
+                    FAR const uint8_t *header, FAR const uint8_t *buffer,
+                    uint16_t headerlen, uint16_t datalen)
 {
   uint16_t i;
   uint8_t c;
 
-  DEBUG1(("\nAHDLC_TX - transmit frame, protocol 0x%04x, length %d "
-          "offline %d\n",
-         protocol, datalen + headerlen, ctx->ahdlc_tx_offline));
-
-  if (AHDLC_TX_OFFLINE && (ctx->ahdlc_tx_offline++ > AHDLC_TX_OFFLINE))
-    {
-      ctx->ahdlc_tx_offline = 0;
-      DEBUG1(("\nAHDLC_TX to many outstanding TX packets => "
-              "ppp_reconnect()\n"));
-      ppp_reconnect(ctx);
-      return 0;
-    }
-
-#if PACKET_TX_DEBUG
-  DEBUG1(("\n"));
-  for (i = 0; i < headerlen; ++i)
-    {
-      DEBUG1(("0x%02x ", header[i]));
-    }
-
-  for (i = 0; i < datalen; ++i)
-    {
-      DEBUG1(("0x%02x ", buffer[i]));
-    }
-
-  DEBUG1(("\n\n"));
-#endif
-
-  /* Check to see that physical layer is up, we can assume is some cases */
-
   /* Write leading 0x7e */
 
   ppp_arch_putchar(ctx, 0x7e);
@@ -438,6 +643,124 @@ uint8_t ahdlc_tx(struct ppp_context_s *ctx, uint16_t protocol,
   /* Write trailing 0x7e, probably not needed but it doesn't hurt */
 
   ppp_arch_putchar(ctx, 0x7e);
+}
+
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+/****************************************************************************
+ * Name: ahdlc_tx_buffer
+ *
+ * Description:
+ *   Write one frame to the serial device.  The FCS is computed over whole
+ *   buffers and the frame is escaped into a local buffer that is written
+ *   out AHDLC_TX_BUFFER_SIZE bytes at a time.
+ *
+ ****************************************************************************/
+
+void ahdlc_tx_buffer(FAR struct ppp_context_s *ctx, uint16_t protocol,
+                     FAR const uint8_t *header, FAR const uint8_t *buffer,
+                     uint16_t headerlen, uint16_t datalen)
+{
+  uint8_t out[AHDLC_TX_BUFFER_SIZE];
+  uint8_t head[4];
+  uint8_t fcs[2];
+  size_t outlen = 0;
+  size_t headlen = 0;
+  uint16_t crc;
+  bool ctrl;
+
+  /* Escape control characters unless the peer's ACCM says otherwise */
+
+  ctrl = protocol == LCP || (ctx->ahdlc_flags & PPP_TX_ASYNC_MAP) == 0;
+
+  /* HDLC address and control unless compressed, then the protocol */
+
+  if ((ctx->ahdlc_flags & PPP_ACFC) == 0 || protocol == LCP)
+    {
+      head[headlen++] = 0xff;
+      head[headlen++] = 0x03;
+    }
+
+  head[headlen++] = (uint8_t)(protocol >> 8);
+  head[headlen++] = (uint8_t)(protocol & 0xff);
+
+  crc = ahdlc_fcs(0xffff, head, headlen);
+  crc = ahdlc_fcs(crc, header, headerlen);
+  crc = ahdlc_fcs(crc, buffer, datalen) ^ 0xffff;
+
+  fcs[0] = (uint8_t)(crc & 0xff);
+  fcs[1] = (uint8_t)(crc >> 8);
+
+  out[outlen++] = 0x7e;
+  ahdlc_tx_escape(ctx, out, &outlen, head, headlen, ctrl);
+  ahdlc_tx_escape(ctx, out, &outlen, header, headerlen, ctrl);
+  ahdlc_tx_escape(ctx, out, &outlen, buffer, datalen, ctrl);
+  ahdlc_tx_escape(ctx, out, &outlen, fcs, 2, ctrl);
+
+  if (outlen == AHDLC_TX_BUFFER_SIZE)
+    {
+      ppp_arch_write(ctx, out, outlen);
+      outlen = 0;
+    }
+
+  out[outlen++] = 0x7e;
+  ppp_arch_write(ctx, out, outlen);
+}
+#endif
+
+/****************************************************************************
+ * ahdlc_tx(protocol,buffer,len) - Transmit a PPP frame.
+ *
+ *    Buffer contains protocol data, ahdlc_tx adds address, control and
+ *    protocol data.
+ *
+ * Relies on local global vars    :    ahdlc_tx_crc, ahdlc_flags.
+ * Modifies local global vars    :    ahdlc_tx_crc.
+ *
+ ****************************************************************************/
+
+uint8_t ahdlc_tx(struct ppp_context_s *ctx, uint16_t protocol,
+                 FAR uint8_t * header, FAR uint8_t * buffer,
+                 uint16_t headerlen, uint16_t datalen)
+{
+#if PACKET_TX_DEBUG
+  uint16_t i;
+#endif
+
+  DEBUG1(("\nAHDLC_TX - transmit frame, protocol 0x%04x, length %d "
+          "offline %d\n",
+         protocol, datalen + headerlen, ctx->ahdlc_tx_offline));
+
+  if (AHDLC_TX_OFFLINE && (ctx->ahdlc_tx_offline++ > AHDLC_TX_OFFLINE))
+    {
+      ctx->ahdlc_tx_offline = 0;
+      DEBUG1(("\nAHDLC_TX to many outstanding TX packets => "
+              "ppp_reconnect()\n"));
+      ppp_reconnect(ctx);
+      return 0;
+    }
+
+#if PACKET_TX_DEBUG
+  DEBUG1(("\n"));
+  for (i = 0; i < headerlen; ++i)
+    {
+      DEBUG1(("0x%02x ", header[i]));
+    }
+
+  for (i = 0; i < datalen; ++i)
+    {
+      DEBUG1(("0x%02x ", buffer[i]));
+    }
+
+  DEBUG1(("\n\n"));
+#endif
+
+  /* Check to see that physical layer is up, we can assume is some cases */
+
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+  ahdlc_tx_buffer(ctx, protocol, header, buffer, headerlen, datalen);
+#else
+  ahdlc_tx_bytes(ctx, protocol, header, buffer, headerlen, datalen);
+#endif
 
 #if PPP_STATISTICS
   /* Update statistics */
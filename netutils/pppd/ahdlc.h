@@ -70,6 +70,18 @@ uint8_t ahdlc_rx(FAR struct ppp_context_s *ctx, uint8_t);
 uint8_t ahdlc_tx(FAR struct ppp_context_s *ctx, uint16_t protocol,
                  FAR uint8_t *header, FAR uint8_t *buffer, uint16_t headerlen,
                  uint16_t datalen);
+void ahdlc_tx_bytes(FAR struct ppp_context_s *ctx, uint16_t protocol,
+                    FAR const uint8_t *header, FAR const uint8_t *buffer,
+                    uint16_t headerlen, uint16_t datalen);
+
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+uint16_t ahdlc_fcs(uint16_t fcs, FAR const uint8_t *buf, size_t len);
+size_t ahdlc_rx_buffer(FAR struct ppp_context_s *ctx,
+                       FAR const uint8_t *buf, size_t len);
+void ahdlc_tx_buffer(FAR struct ppp_context_s *ctx, uint16_t protocol,
+                     FAR const uint8_t *header, FAR const uint8_t *buffer,
+                     uint16_t headerlen, uint16_t datalen);
+#endif
 
 #undef EXTERN
 #ifdef __cplusplus
@@ -0,0 +1,249 @@
+/****************************************************************************
+ * apps/netutils/pppd/ahdlc_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ppp.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DATALEN     1000
+#define BENCH_FRAMELEN    (2 * (BENCH_DATALEN + 6) + 2)
+#define BENCH_ITERATIONS  200
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static double bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/****************************************************************************
+ * Name: bench_report
+ ****************************************************************************/
+
+static void bench_report(FAR const char *name, double elapsed, int n)
+{
+  printf("%-12s %8.3f s %10.1f KiB/s\n", name, elapsed,
+         elapsed > 0 ? n * (double)BENCH_DATALEN / 1024 / elapsed : 0);
+}
+
+/****************************************************************************
+ * Name: bench_encode
+ *
+ * Description:
+ *   Frame an IPv4 packet as the peer would, all control characters
+ *   escaped.
+ *
+ ****************************************************************************/
+
+static size_t bench_encode(FAR const uint8_t *data, size_t len,
+                           FAR uint8_t *frame)
+{
+  uint8_t head[4] =
+  {
+    0xff, 0x03, IPV4 >> 8, IPV4 & 0xff
+  };
+
+  uint8_t fcs[2];
+  uint16_t crc;
+  size_t n = 0;
+  size_t i;
+
+  crc = ahdlc_fcs(0xffff, head, 4);
+  crc = ahdlc_fcs(crc, data, len) ^ 0xffff;
+  fcs[0] = crc & 0xff;
+  fcs[1] = crc >> 8;
+
+  frame[n++] = 0x7e;
+  for (i = 0; i < 4 + len + 2; i++)
+    {
+      uint8_t c = i < 4 ? head[i] : i < 4 + len ? data[i - 4] :
+                  fcs[i - 4 - len];
+
+      if (c == 0x7e || c == 0x7d || c < 0x20)
+        {
+          frame[n++] = 0x7d;
+          c ^= 0x20;
+        }
+
+      frame[n++] = c;
+    }
+
+  frame[n++] = 0x7e;
+  return n;
+}
+
+/****************************************************************************
+ * Name: bench_check
+ ****************************************************************************/
+
+static int bench_check(FAR struct ppp_context_s *ctx,
+                       FAR const uint8_t *data)
+{
+  if (ctx->ip_len != BENCH_DATALEN ||
+      memcmp(ctx->ip_buf, data, BENCH_DATALEN) != 0)
+    {
+      fprintf(stderr, "ERROR: Frame not received\n");
+      return -1;
+    }
+
+  ctx->ip_len = 0;
+  return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR struct ppp_context_s *ctx;
+  FAR uint8_t *frame;
+  FAR uint8_t *data;
+  size_t framelen;
+  size_t pos;
+  double start;
+  int ret = EXIT_FAILURE;
+  int n = BENCH_ITERATIONS;
+  int i;
+
+  if (argc > 1)
+    {
+      n = atoi(argv[1]);
+    }
+
+  ctx   = (FAR struct ppp_context_s *)zalloc(sizeof(*ctx));
+  data  = (FAR uint8_t *)malloc(BENCH_DATALEN);
+  frame = (FAR uint8_t *)malloc(BENCH_FRAMELEN);
+  if (ctx == NULL || data == NULL || frame == NULL)
+    {
+      fprintf(stderr, "ERROR: Out of memory\n");
+      goto errout;
+    }
+
+  /* Transmitted frames are discarded, received frames are IPv4 packets
+   * that are only copied to ip_buf.
+   */
+
+  ctx->ctl.fd = open("/dev/null", O_WRONLY);
+  if (ctx->ctl.fd < 0)
+    {
+      fprintf(stderr, "ERROR: open /dev/null failed\n");
+      goto errout;
+    }
+
+  ahdlc_init(ctx);
+  ahdlc_rx_ready(ctx);
+  ctx->ppp_flags = PPP_RX_READY;
+
+  srand(1);
+  for (i = 0; i < BENCH_DATALEN; i++)
+    {
+      data[i] = rand() & 0xff;
+    }
+
+  framelen = bench_encode(data, BENCH_DATALEN, frame);
+  printf("%d frames of %d bytes, %zu bytes escaped\n",
+         n, BENCH_DATALEN, framelen);
+
+  start = bench_now();
+  for (i = 0; i < n; i++)
+    {
+      ahdlc_tx_bytes(ctx, IPV4, NULL, data, 0, BENCH_DATALEN);
+    }
+
+  bench_report("tx char", bench_now() - start, n);
+
+  start = bench_now();
+  for (i = 0; i < n; i++)
+    {
+      ahdlc_tx_buffer(ctx, IPV4, NULL, data, 0, BENCH_DATALEN);
+    }
+
+  bench_report("tx buffer", bench_now() - start, n);
+
+  start = bench_now();
+  for (i = 0; i < n; i++)
+    {
+      for (pos = 0; pos < framelen; pos++)
+        {
+          ahdlc_rx(ctx, frame[pos]);
+        }
+
+      if (bench_check(ctx, data) < 0)
+        {
+          goto errout_with_fd;
+        }
+    }
+
+  bench_report("rx char", bench_now() - start, n);
+
+  start = bench_now();
+  for (i = 0; i < n; i++)
+    {
+      for (pos = 0; pos < framelen; )
+        {
+          pos += ahdlc_rx_buffer(ctx, &frame[pos], framelen - pos);
+        }
+
+      if (bench_check(ctx, data) < 0)
+        {
+          goto errout_with_fd;
+        }
+    }
+
+  bench_report("rx buffer", bench_now() - start, n);
+  ret = EXIT_SUCCESS;
+
+errout_with_fd:
+  close(ctx->ctl.fd);
+errout:
+  free(frame);
+  free(data);
+  free(ctx);
+  return ret;
+}
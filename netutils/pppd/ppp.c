@@ -214,7 +214,11 @@ void ppp_send(FAR struct ppp_context_s *ctx)
 
 void ppp_poll(FAR struct ppp_context_s *ctx)
 {
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+  ssize_t ret;
+#else
   uint8_t c;
+#endif
 
   ctx->ip_len = 0;
 
@@ -230,10 +234,36 @@ void ppp_poll(FAR struct ppp_context_s *ctx)
       return;
     }
 
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+  /* Bytes left over from the last poll come first, they follow the frame
+   * that was passed up then.
+   */
+
+  while (ctx->ip_len == 0)
+    {
+      if (ctx->ahdlc_rx_chunkpos == ctx->ahdlc_rx_chunklen)
+        {
+          ret = ppp_arch_read(ctx, ctx->ahdlc_rx_chunk,
+                              AHDLC_RX_CHUNK_SIZE);
+          if (ret <= 0)
+            {
+              break;
+            }
+
+          ctx->ahdlc_rx_chunkpos = 0;
+          ctx->ahdlc_rx_chunklen = ret;
+        }
+
+      ctx->ahdlc_rx_chunkpos +=
+        ahdlc_rx_buffer(ctx, &ctx->ahdlc_rx_chunk[ctx->ahdlc_rx_chunkpos],
+                        ctx->ahdlc_rx_chunklen - ctx->ahdlc_rx_chunkpos);
+    }
+#else
   while (ctx->ip_len == 0 && ppp_arch_getchar(ctx, &c))
     {
       ahdlc_rx(ctx, c);
     }
+#endif
 
   /* If IPCP came up then our link should be up. */
 
@@ -169,6 +169,11 @@ struct ppp_context_s
   uint16_t ahdlc_rx_count;   /* Number of rx bytes processed, cur frame */
   uint8_t  ahdlc_flags;      /* ahdlc state flags, see above */
   uint8_t  ahdlc_tx_offline;
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+  uint8_t  ahdlc_rx_chunk[AHDLC_RX_CHUNK_SIZE]; /* Read, not processed */
+  uint16_t ahdlc_rx_chunkpos;
+  uint16_t ahdlc_rx_chunklen;
+#endif
 
   /* Statistics counters */
 
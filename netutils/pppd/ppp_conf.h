@@ -60,6 +60,13 @@
 
 #define AHDLC_TX_OFFLINE        5
 
+/* Bytes read from and written to the serial device at a time by the
+ * buffer oriented AHDLC.
+ */
+
+#define AHDLC_RX_CHUNK_SIZE     256
+#define AHDLC_TX_BUFFER_SIZE    256
+
 #define IPCP_GET_PEER_IP        1
 
 #define PPP_STATISTICS          1
@@ -311,6 +311,58 @@ int ppp_arch_putchar(FAR struct ppp_context_s *ctx, uint8_t c)
   return ret == 1 ? ret : 0;
 }
 
+#ifdef CONFIG_NETUTILS_PPPD_FAST_AHDLC
+/****************************************************************************
+ * Name: ppp_arch_read
+ ****************************************************************************/
+
+ssize_t ppp_arch_read(FAR struct ppp_context_s *ctx, FAR uint8_t *buf,
+                      size_t len)
+{
+  ssize_t ret;
+
+  ret = read(ctx->ctl.fd, buf, len);
+  return ret > 0 ? ret : 0;
+}
+
+/****************************************************************************
+ * Name: ppp_arch_write
+ ****************************************************************************/
+
+ssize_t ppp_arch_write(FAR struct ppp_context_s *ctx,
+                       FAR const uint8_t *buf, size_t len)
+{
+  struct pollfd fds;
+  size_t nwritten = 0;
+  ssize_t ret;
+
+  while (nwritten < len)
+    {
+      ret = write(ctx->ctl.fd, &buf[nwritten], len - nwritten);
+      if (ret < 0 && errno == EAGAIN)
+        {
+          fds.fd = ctx->ctl.fd;
+          fds.events = POLLOUT;
+          fds.revents = 0;
+
+          if (poll(&fds, 1, 1000) > 0)
+            {
+              continue;
+            }
+        }
+
+      if (ret <= 0)
+        {
+          break;
+        }
+
+      nwritten += ret;
+    }
+
+  return nwritten;
+}
+#endif
+
 /****************************************************************************
  * Name: pppd
  ****************************************************************************/
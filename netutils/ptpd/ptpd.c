@@ -25,6 +25,7 @@
 #include <nuttx/config.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <sys/socket.h>
@@ -65,6 +66,18 @@ struct ptpd_statusreq_s
   FAR struct ptpd_status_s *dest;
 };
 
+/* Unicast client granted messages by a server */
+
+#if defined(CONFIG_NETUTILS_PTPD_UNICAST) && \
+    defined(CONFIG_NETUTILS_PTPD_SERVER)
+struct ptp_unicast_client_s
+{
+  struct in_addr addr;
+  uint16_t granted;          /* Bit per granted message type */
+  struct timespec expiry;    /* End of the grant (CLOCK_MONOTONIC) */
+};
+#endif
+
 /* Main PTPD state storage */
 
 struct ptp_state_s
@@ -78,6 +91,15 @@ struct ptp_state_s
 
   struct sockaddr_in interface_addr;
 
+  /* Role of this port, and for the master port of a boundary clock the
+   * slave port whose clock source is announced.
+   */
+
+  uint8_t role;
+#ifdef CONFIG_NETUTILS_PTPD_BOUNDARY
+  FAR struct ptp_state_s *upstream;
+#endif
+
   /* Socket bound to interface for transmission */
 
   int tx_socket;
@@ -87,6 +109,12 @@ struct ptp_state_s
   int event_socket;
   int info_socket;
 
+  /* True if the tx socket reports hardware transmit timestamps */
+
+#ifdef CONFIG_NETUTILS_PTPD_HWTIMESTAMP
+  bool hwtxstamp;
+#endif
+
   /* Our own identity as a clock source */
 
   struct ptp_announce_s own_identity;
@@ -105,6 +133,12 @@ struct ptp_state_s
   long drift_avg_total_ms;
   long drift_ppb;
 
+  /* Measurements taken by the PI servo since the last clock jump */
+
+#ifdef CONFIG_NETUTILS_PTPD_SERVO_PI
+  int servo_count;
+#endif
+
   /* Identity of currently selected clock source,
    * from the latest announcement message.
    *
@@ -127,6 +161,36 @@ struct ptp_state_s
   struct timespec last_transmitted_delayresp;
   struct timespec last_transmitted_delayreq;
 
+  /* Unicast negotiation: the server we request messages from (zero if
+   * none) and when to renew the request (CLOCK_MONOTONIC), and as a
+   * server the clients we have granted messages to.
+   */
+
+#ifdef CONFIG_NETUTILS_PTPD_UNICAST
+  uint16_t signaling_seq;
+  struct in_addr unicast_server;
+  struct timespec unicast_renew;
+#ifdef CONFIG_NETUTILS_PTPD_SERVER
+  struct ptp_unicast_client_s
+    unicast_clients[CONFIG_NETUTILS_PTPD_UNICAST_MAX_CLIENTS];
+#endif
+#endif
+
+  /* Peer delay measurement (CLOCK_REALTIME): our request was sent at t1
+   * and received by the peer at t2, the response was sent at t3 and
+   * received at t4.
+   */
+
+#ifdef CONFIG_NETUTILS_PTPD_PDELAY
+  uint16_t pdelay_req_seq;
+  struct timespec last_transmitted_pdelayreq;
+  bool pdelay_resp_valid;
+  uint8_t pdelay_responder[8];
+  struct timespec pdelay_t1;
+  struct timespec pdelay_t2;
+  struct timespec pdelay_t4;
+#endif
+
   /* Timestamps related to path delay calculation (CLOCK_REALTIME) */
 
   bool can_send_delayreq;
@@ -135,8 +199,17 @@ struct ptp_state_s
   long path_delay_ns;
   long delayreq_interval;
 
-  /* Latest received packet and its timestamp (CLOCK_REALTIME) */
+  /* Latest path delay measurements for the median filter */
+
+#if CONFIG_NETUTILS_PTPD_DELAY_FILTER_LEN > 1
+  long path_delay_window[CONFIG_NETUTILS_PTPD_DELAY_FILTER_LEN];
+  int path_delay_nsamples;
+  int path_delay_head;
+#endif
+
+  /* Latest received packet, its source and timestamp (CLOCK_REALTIME) */
 
+  struct sockaddr_in rxaddr;
   struct timespec rxtime;
   union
   {
@@ -146,10 +219,23 @@ struct ptp_state_s
     struct ptp_follow_up_s  follow_up;
     struct ptp_delay_req_s  delay_req;
     struct ptp_delay_resp_s delay_resp;
+#ifdef CONFIG_NETUTILS_PTPD_PDELAY
+    struct ptp_pdelay_req_s pdelay_req;
+    struct ptp_pdelay_resp_s pdelay_resp;
+    struct ptp_pdelay_resp_follow_up_s pdelay_resp_follow_up;
+#endif
+#ifdef CONFIG_NETUTILS_PTPD_UNICAST
+    struct ptp_signaling_s  signaling;
+#endif
     uint8_t                 raw[128];
   } rxbuf;
 
+#ifdef CONFIG_NETUTILS_PTPD_HWTIMESTAMP
+  uint8_t rxcmsg[CMSG_SPACE(sizeof(struct timeval)) +
+                 CMSG_SPACE(3 * sizeof(struct timespec))];
+#else
   uint8_t rxcmsg[CMSG_LEN(sizeof(struct timeval))];
+#endif
 
   /* Buffered sync packet for two-step clock setting where server sends
    * the accurate timestamp in a separate follow-up message.
@@ -165,6 +251,39 @@ struct ptp_state_s
 #  define PTPD_POLL_INTERVAL CONFIG_NETUTILS_PTPD_TIMEOUT_MS
 #endif
 
+/* Port roles, a boundary clock has one port of each kind */
+
+#define PTP_ROLE_ORDINARY 0  /* Master or slave by best master selection */
+#define PTP_ROLE_SLAVE    1  /* Boundary clock port towards grandmaster */
+#define PTP_ROLE_MASTER   2  /* Boundary clock port serving a segment */
+
+#ifdef CONFIG_NETUTILS_PTPD_BOUNDARY
+#  define PTPD_MAX_PORTS 2
+#else
+#  define PTPD_MAX_PORTS 1
+#endif
+
+/* Seconds between unicast requests until the server grants them */
+
+#define PTPD_UNICAST_RETRY_S 2
+
+/* Unicast and peer delay messages do not arrive on sockets bound to the
+ * PTP multicast address, and the ports of a boundary clock share the
+ * PTP ports, so these bind to any address instead.
+ */
+
+#if defined(CONFIG_NETUTILS_PTPD_UNICAST) || \
+    defined(CONFIG_NETUTILS_PTPD_PDELAY) || \
+    defined(CONFIG_NETUTILS_PTPD_BOUNDARY)
+#  define PTPD_BIND_ANY 1
+#endif
+
+/* Hardware timestamps need SO_TIMESTAMPING from the network stack */
+
+#if defined(CONFIG_NETUTILS_PTPD_HWTIMESTAMP) && defined(SO_TIMESTAMPING)
+#  define PTPD_HWTIMESTAMP 1
+#endif
+
 /* PTP debug messages are enabled by either CONFIG_DEBUG_NET_INFO
  * or separately by CONFIG_NETUTILS_PTPD_DEBUG. This simplifies
  * debugging without having excessive amount of logging from net.
@@ -286,6 +405,21 @@ static int64_t timespec_delta_ns(FAR const struct timespec *ts1,
   return delta_s * NSEC_PER_SEC + (ts1->tv_nsec - ts2->tv_nsec);
 }
 
+/* Add positive or negative nanoseconds to timespec value */
+
+static void timespec_add_ns(FAR struct timespec *ts, int64_t delta_ns)
+{
+  delta_ns += ts->tv_nsec;
+  ts->tv_sec += delta_ns / NSEC_PER_SEC;
+  ts->tv_nsec = delta_ns % NSEC_PER_SEC;
+
+  if (ts->tv_nsec < 0)
+    {
+      ts->tv_nsec += NSEC_PER_SEC;
+      ts->tv_sec--;
+    }
+}
+
 /* Check if the currently selected source is still valid */
 
 static bool is_selected_source_valid(FAR struct ptp_state_s *state)
@@ -331,6 +465,35 @@ static uint16_t ptp_get_sequence(FAR const struct ptp_header_s *hdr)
   return ((uint16_t)hdr->sequenceid[0] << 8) | hdr->sequenceid[1];
 }
 
+/* Get correction field, added by transparent clocks on the path */
+
+static int64_t ptp_get_correction_ns(FAR const struct ptp_header_s *hdr)
+{
+  uint64_t correction = 0;
+  int i;
+
+  for (i = 0; i < sizeof(hdr->correction); i++)
+    {
+      correction = (correction << 8) | hdr->correction[i];
+    }
+
+  /* The field is in units of 2^-16 ns */
+
+  return (int64_t)correction / 65536;
+}
+
+/* Fill in destination address: the PTP multicast group, or the given
+ * address for unicast.
+ */
+
+static void ptp_setdest(FAR struct sockaddr_in *addr,
+                        FAR const struct in_addr *dest, uint16_t port)
+{
+  addr->sin_family = AF_INET;
+  addr->sin_addr.s_addr = dest ? dest->s_addr : HTONL(PTP_MULTICAST_ADDR);
+  addr->sin_port = HTONS(port);
+}
+
 /* Get current system timestamp as a timespec
  * TODO: Possibly add support for selecting different clock or using
  *       architecture-specific interface for clock access.
@@ -364,6 +527,117 @@ static int ptp_adjtime(FAR struct ptp_state_s *state, int64_t delta_ns)
   return adjtime(&delta, NULL);
 }
 
+#ifdef PTPD_HWTIMESTAMP
+/* Get the raw hardware timestamp from SO_TIMESTAMPING cmsg */
+
+static int ptp_gethwtime(FAR struct msghdr *hdr, FAR struct timespec *ts)
+{
+  FAR struct cmsghdr *cmsg;
+  FAR struct timespec *stamps;
+
+  for_each_cmsghdr(cmsg, hdr)
+    {
+      if (cmsg->cmsg_level == SOL_SOCKET &&
+          cmsg->cmsg_type == SO_TIMESTAMPING &&
+          cmsg->cmsg_len >= CMSG_LEN(3 * sizeof(struct timespec)))
+        {
+          /* The third timestamp is the raw hardware one */
+
+          stamps = (FAR struct timespec *)CMSG_DATA(cmsg);
+          if (stamps[2].tv_sec > 0 || stamps[2].tv_nsec > 0)
+            {
+              *ts = stamps[2];
+              return OK;
+            }
+        }
+    }
+
+  return ERROR;
+}
+
+/* Discard transmit timestamps of packets we do not need them for, so that
+ * the next one read belongs to the event message being sent.
+ */
+
+static void ptp_flushtxtime(FAR struct ptp_state_s *state)
+{
+  struct msghdr hdr;
+  struct iovec iov;
+  uint8_t buf[sizeof(state->rxbuf)];
+  uint8_t control[128];
+
+  if (!state->hwtxstamp)
+    {
+      return;
+    }
+
+  do
+    {
+      memset(&hdr, 0, sizeof(hdr));
+      iov.iov_base = buf;
+      iov.iov_len = sizeof(buf);
+      hdr.msg_iov = &iov;
+      hdr.msg_iovlen = 1;
+      hdr.msg_control = control;
+      hdr.msg_controllen = sizeof(control);
+    }
+  while (recvmsg(state->tx_socket, &hdr, MSG_ERRQUEUE | MSG_DONTWAIT) >= 0);
+}
+#endif /* PTPD_HWTIMESTAMP */
+
+/* Get transmit timestamp of the event message that was just sent */
+
+static int ptp_gettxtime(FAR struct ptp_state_s *state,
+                         FAR struct timespec *ts)
+{
+#ifdef PTPD_HWTIMESTAMP
+  struct pollfd pfd;
+  struct msghdr hdr;
+  struct iovec iov;
+  uint8_t buf[sizeof(state->rxbuf)];
+  uint8_t control[128];
+
+  if (state->hwtxstamp)
+    {
+      /* The timestamp is queued to the error queue when the MAC has sent
+       * the packet, which also reports POLLERR.
+       */
+
+      pfd.fd = state->tx_socket;
+      pfd.events = 0;
+      pfd.revents = 0;
+
+      while (poll(&pfd, 1, CONFIG_NETUTILS_PTPD_TXTIMESTAMP_TIMEOUT_MS) > 0)
+        {
+          memset(&hdr, 0, sizeof(hdr));
+          iov.iov_base = buf;
+          iov.iov_len = sizeof(buf);
+          hdr.msg_iov = &iov;
+          hdr.msg_iovlen = 1;
+          hdr.msg_control = control;
+          hdr.msg_controllen = sizeof(control);
+
+          if (recvmsg(state->tx_socket, &hdr,
+                      MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            {
+              break;
+            }
+
+          if (ptp_gethwtime(&hdr, ts) == OK)
+            {
+              return OK;
+            }
+        }
+
+      ptpwarn("Did not get hardware tx timestamp\n");
+    }
+#endif
+
+  /* Fall back to current timestamp */
+
+  return ptp_gettime(state, ts);
+}
+
 /* Get timestamp of latest received packet */
 
 static int ptp_getrxtime(FAR struct ptp_state_s *state,
@@ -375,6 +649,13 @@ static int ptp_getrxtime(FAR struct ptp_state_s *state,
 #ifdef CONFIG_NET_TIMESTAMP
   struct cmsghdr *cmsg;
 
+#ifdef PTPD_HWTIMESTAMP
+  if (ptp_gethwtime(rxhdr, ts) == OK)
+    {
+      return OK;
+    }
+#endif
+
   for_each_cmsghdr(cmsg, rxhdr)
     {
       if (cmsg->cmsg_level == SOL_SOCKET &&
@@ -400,6 +681,56 @@ static int ptp_getrxtime(FAR struct ptp_state_s *state,
   return ptp_gettime(state, ts);
 }
 
+/* Join or leave the multicast groups used on the interface */
+
+static int ptp_subscribe(FAR struct ptp_state_s *state, int mode)
+{
+  struct in_addr mcast_addr;
+
+#ifdef CONFIG_NETUTILS_PTPD_PDELAY
+  int ret;
+
+  mcast_addr.s_addr = HTONL(PTP_PDELAY_MULTICAST_ADDR);
+  ret = ipmsfilter(&state->interface_addr.sin_addr, &mcast_addr, mode);
+  if (ret < 0)
+    {
+      return ret;
+    }
+#endif
+
+#ifdef CONFIG_NETUTILS_PTPD_UNICAST
+  if (state->unicast_server.s_addr != 0)
+    {
+      return OK; /* Unicast clients only listen to their server */
+    }
+#endif
+
+  mcast_addr.s_addr = HTONL(PTP_MULTICAST_ADDR);
+  return ipmsfilter(&state->interface_addr.sin_addr, &mcast_addr, mode);
+}
+
+#ifdef CONFIG_NETUTILS_PTPD_BOUNDARY
+/* Let the ports of a boundary clock bind the same PTP ports, each socket
+ * receiving only from its own interface.
+ */
+
+static int ptp_bindtodevice(int sockfd, FAR const char *interface)
+{
+  int optval = 1;
+  int ret;
+
+  ret = setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval,
+                   sizeof(optval));
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  return setsockopt(sockfd, SOL_SOCKET, SO_BINDTODEVICE, interface,
+                    strlen(interface));
+}
+#endif
+
 /* Initialize PTP client/server state and create sockets */
 
 static int ptp_initialize_state(FAR struct ptp_state_s *state,
@@ -412,6 +743,9 @@ static int ptp_initialize_state(FAR struct ptp_state_s *state,
 #ifdef CONFIG_NET_TIMESTAMP
   int arg;
 #endif
+#ifdef PTPD_HWTIMESTAMP
+  int flags;
+#endif
 
   /* Create sockets */
 
@@ -493,15 +827,27 @@ static int ptp_initialize_state(FAR struct ptp_state_s *state,
 
   clock_gettime(CLOCK_MONOTONIC, &state->last_received_multicast);
 
-  ret = ipmsfilter(&state->interface_addr.sin_addr,
-                   &bind_addr.sin_addr,
-                   MCAST_INCLUDE);
+  ret = ptp_subscribe(state, MCAST_INCLUDE);
   if (ret < 0)
     {
       ptperr("Failed to bind multicast address: %d\n", errno);
       return ERROR;
     }
 
+#ifdef PTPD_BIND_ANY
+  bind_addr.sin_addr.s_addr = HTONL(INADDR_ANY);
+#endif
+
+#ifdef CONFIG_NETUTILS_PTPD_BOUNDARY
+  if (state->role != PTP_ROLE_ORDINARY &&
+      (ptp_bindtodevice(state->event_socket, interface) < 0 ||
+       ptp_bindtodevice(state->info_socket, interface) < 0))
+    {
+      ptperr("Failed to bind sockets to %s: %d\n", interface, errno);
+      return ERROR;
+    }
+#endif
+
   /* Bind socket for events */
 
   bind_addr.sin_port = HTONS(PTP_UDP_PORT_EVENT);
@@ -526,6 +872,31 @@ static int ptp_initialize_state(FAR struct ptp_state_s *state,
     }
 #endif
 
+#ifdef PTPD_HWTIMESTAMP
+  /* Receive timestamps of event messages and transmit timestamps of
+   * everything sent, as both are needed for the delay request-response
+   * mechanism. Software timestamps are used if this fails.
+   */
+
+  flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+  ret = setsockopt(state->event_socket, SOL_SOCKET, SO_TIMESTAMPING,
+                   &flags, sizeof(flags));
+  if (ret < 0)
+    {
+      ptperr("Failed to enable rx SO_TIMESTAMPING: %s\n", strerror(errno));
+    }
+
+  flags = SOF_TIMESTAMPING_TX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+  ret = setsockopt(state->tx_socket, SOL_SOCKET, SO_TIMESTAMPING,
+                   &flags, sizeof(flags));
+  if (ret < 0)
+    {
+      ptperr("Failed to enable tx SO_TIMESTAMPING: %s\n", strerror(errno));
+    }
+
+  state->hwtxstamp = (ret == OK);
+#endif
+
   /* Bind socket for announcements */
 
   bind_addr.sin_port = HTONS(PTP_UDP_PORT_INFO);
@@ -540,6 +911,9 @@ static int ptp_initialize_state(FAR struct ptp_state_s *state,
   /* Bind TX socket to interface address (local addr cannot be multicast) */
 
   bind_addr.sin_addr = state->interface_addr.sin_addr;
+#ifdef PTPD_BIND_ANY
+  bind_addr.sin_port = 0; /* The PTP ports are bound to any address */
+#endif
   ret = bind(state->tx_socket, (struct sockaddr *)&bind_addr,
              sizeof(bind_addr));
   if (ret < 0)
@@ -555,12 +929,7 @@ static int ptp_initialize_state(FAR struct ptp_state_s *state,
 
 static int ptp_destroy_state(FAR struct ptp_state_s *state)
 {
-  struct in_addr mcast_addr;
-
-  mcast_addr.s_addr = HTONL(PTP_MULTICAST_ADDR);
-  ipmsfilter(&state->interface_addr.sin_addr,
-              &mcast_addr,
-              MCAST_EXCLUDE);
+  ptp_subscribe(state, MCAST_EXCLUDE);
 
   if (state->tx_socket > 0)
     {
@@ -591,7 +960,6 @@ static int ptp_destroy_state(FAR struct ptp_state_s *state)
 static int ptp_check_multicast_status(FAR struct ptp_state_s *state)
 {
 #if CONFIG_NETUTILS_PTPD_MULTICAST_TIMEOUT_MS > 0
-  struct in_addr mcast_addr;
   struct timespec time_now;
   struct timespec delta;
 
@@ -605,14 +973,8 @@ static int ptp_check_multicast_status(FAR struct ptp_state_s *state)
 
       state->last_received_multicast = time_now;
 
-      mcast_addr.s_addr = HTONL(PTP_MULTICAST_ADDR);
-      ipmsfilter(&state->interface_addr.sin_addr,
-                 &mcast_addr,
-                 MCAST_EXCLUDE);
-
-      return ipmsfilter(&state->interface_addr.sin_addr,
-                        &mcast_addr,
-                        MCAST_INCLUDE);
+      ptp_subscribe(state, MCAST_EXCLUDE);
+      return ptp_subscribe(state, MCAST_INCLUDE);
     }
 
 #else
@@ -624,22 +986,45 @@ static int ptp_check_multicast_status(FAR struct ptp_state_s *state)
 
 /* Send PTP server announcement packet */
 
-static int ptp_send_announce(FAR struct ptp_state_s *state)
+static int ptp_send_announce(FAR struct ptp_state_s *state,
+                             FAR const struct in_addr *dest)
 {
   struct ptp_announce_s msg;
   struct sockaddr_in addr;
   struct timespec ts;
   int ret;
 
-  addr.sin_family      = AF_INET;
-  addr.sin_addr.s_addr = HTONL(PTP_MULTICAST_ADDR);
-  addr.sin_port        = HTONS(PTP_UDP_PORT_INFO);
+  ptp_setdest(&addr, dest, PTP_UDP_PORT_INFO);
 
   memset(&msg, 0, sizeof(msg));
   msg = state->own_identity;
   msg.header.messagetype = PTP_MSGTYPE_ANNOUNCE;
   msg.header.messagelength[1] = sizeof(msg);
 
+#ifdef CONFIG_NETUTILS_PTPD_BOUNDARY
+  /* The master port of a boundary clock announces the grandmaster that
+   * the slave port is synchronized to, one step further away.
+   */
+
+  if (state->upstream != NULL && state->upstream->selected_source_valid)
+    {
+      FAR struct ptp_announce_s *gm = &state->upstream->selected_source;
+      uint16_t steps;
+
+      steps = (((uint16_t)gm->stepsremoved[0] << 8) |
+               gm->stepsremoved[1]) + 1;
+
+      memcpy(msg.utcoffset, gm->utcoffset, sizeof(msg.utcoffset));
+      msg.gm_priority1 = gm->gm_priority1;
+      memcpy(msg.gm_quality, gm->gm_quality, sizeof(msg.gm_quality));
+      msg.gm_priority2 = gm->gm_priority2;
+      memcpy(msg.gm_identity, gm->gm_identity, sizeof(msg.gm_identity));
+      msg.stepsremoved[0] = steps >> 8;
+      msg.stepsremoved[1] = steps & 0xff;
+      msg.timesource = gm->timesource;
+    }
+#endif
+
   ptp_increment_sequence(&state->announce_seq, &msg.header);
   ptp_gettime(state, &ts);
   timespec_to_ptp_format(&ts, msg.origintimestamp);
@@ -662,7 +1047,8 @@ static int ptp_send_announce(FAR struct ptp_state_s *state)
 
 /* Send PTP server synchronization packet */
 
-static int ptp_send_sync(FAR struct ptp_state_s *state)
+static int ptp_send_sync(FAR struct ptp_state_s *state,
+                         FAR const struct in_addr *dest)
 {
   struct msghdr txhdr;
   struct iovec txiov;
@@ -675,9 +1061,7 @@ static int ptp_send_sync(FAR struct ptp_state_s *state)
   memset(&txhdr, 0, sizeof(txhdr));
   memset(&txiov, 0, sizeof(txiov));
 
-  addr.sin_family      = AF_INET;
-  addr.sin_addr.s_addr = HTONL(PTP_MULTICAST_ADDR);
-  addr.sin_port        = HTONS(PTP_UDP_PORT_EVENT);
+  ptp_setdest(&addr, dest, PTP_UDP_PORT_EVENT);
 
   memset(&msg, 0, sizeof(msg));
   msg.header = state->own_identity.header;
@@ -703,6 +1087,10 @@ static int ptp_send_sync(FAR struct ptp_state_s *state)
   ptp_gettime(state, &ts);
   timespec_to_ptp_format(&ts, msg.origintimestamp);
 
+#ifdef PTPD_HWTIMESTAMP
+  ptp_flushtxtime(state);
+#endif
+
   ret = sendmsg(state->tx_socket, &txhdr, 0);
   if (ret < 0)
     {
@@ -711,12 +1099,9 @@ static int ptp_send_sync(FAR struct ptp_state_s *state)
     }
 
 #ifdef CONFIG_NETUTILS_PTPD_TWOSTEP_SYNC
-  /* Get timestamp after send completes and send follow-up message
-   *
-   * TODO: Implement SO_TIMESTAMPING and use the actual tx timestamp here.
-   */
+  /* Get timestamp after send completes and send follow-up message */
 
-  ptp_gettime(state, &ts);
+  ptp_gettxtime(state, &ts);
   timespec_to_ptp_format(&ts, msg.origintimestamp);
   msg.header.messagetype = PTP_MSGTYPE_FOLLOW_UP;
   msg.header.flags[0] = 0;
@@ -748,9 +1133,16 @@ static int ptp_send_delay_req(FAR struct ptp_state_s *state)
   struct sockaddr_in addr;
   int ret;
 
-  addr.sin_family      = AF_INET;
-  addr.sin_addr.s_addr = HTONL(PTP_MULTICAST_ADDR);
-  addr.sin_port        = HTONS(PTP_UDP_PORT_EVENT);
+#ifdef CONFIG_NETUTILS_PTPD_UNICAST
+  if (state->unicast_server.s_addr != 0)
+    {
+      ptp_setdest(&addr, &state->unicast_server, PTP_UDP_PORT_EVENT);
+    }
+  else
+#endif
+    {
+      ptp_setdest(&addr, NULL, PTP_UDP_PORT_EVENT);
+    }
 
   memset(&req, 0, sizeof(req));
   req.header = state->own_identity.header;
@@ -761,14 +1153,23 @@ static int ptp_send_delay_req(FAR struct ptp_state_s *state)
   ptp_gettime(state, &state->delayreq_time);
   timespec_to_ptp_format(&state->delayreq_time, req.origintimestamp);
 
+#ifdef PTPD_HWTIMESTAMP
+  ptp_flushtxtime(state);
+#endif
+
   ret = sendto(state->tx_socket, &req, sizeof(req), 0,
                (FAR struct sockaddr *)&addr, sizeof(addr));
 
-  /* Get timestamp after send completes.
-   * TODO: Implement SO_TIMESTAMPING and use the actual tx timestamp here.
-   */
+  /* Get timestamp after send completes */
 
-  ptp_gettime(state, &state->delayreq_time);
+  if (ret >= 0)
+    {
+      ptp_gettxtime(state, &state->delayreq_time);
+    }
+  else
+    {
+      ptp_gettime(state, &state->delayreq_time);
+    }
 
   if (ret < 0)
     {
@@ -784,54 +1185,395 @@ static int ptp_send_delay_req(FAR struct ptp_state_s *state)
   return ret;
 }
 
-/* Check if we need to send packets */
+#ifdef CONFIG_NETUTILS_PTPD_UNICAST
+/* Fill in a unicast negotiation TLV */
 
-static int ptp_periodic_send(FAR struct ptp_state_s *state)
+static void ptp_set_unicast_tlv(FAR struct ptp_tlv_unicast_s *tlv,
+                                uint16_t type, uint8_t msgtype,
+                                int8_t loginterval, uint32_t duration)
 {
-#ifdef CONFIG_NETUTILS_PTPD_SERVER
-  /* If there is no better master clock on the network,
-   * act as the reference source and send server packets.
-   */
+  uint16_t length = type == PTP_TLV_GRANT_UNICAST ? 8 : 6;
+
+  memset(tlv, 0, sizeof(*tlv));
+  tlv->header.type[0] = type >> 8;
+  tlv->header.type[1] = type & 0xff;
+  tlv->header.length[0] = length >> 8;
+  tlv->header.length[1] = length & 0xff;
+  tlv->messagetype = msgtype << 4;
+  tlv->logmessageinterval = (uint8_t)loginterval;
+  tlv->duration[0] = duration >> 24;
+  tlv->duration[1] = duration >> 16;
+  tlv->duration[2] = duration >> 8;
+  tlv->duration[3] = duration & 0xff;
+}
 
-  if (!state->selected_source_valid)
-    {
-      struct timespec time_now;
-      struct timespec delta;
+static uint32_t ptp_get_tlv_duration(FAR const struct ptp_tlv_unicast_s *tlv)
+{
+  return ((uint32_t)tlv->duration[0] << 24) |
+         ((uint32_t)tlv->duration[1] << 16) |
+         ((uint32_t)tlv->duration[2] << 8) | tlv->duration[3];
+}
 
-      clock_gettime(CLOCK_MONOTONIC, &time_now);
-      clock_timespec_subtract(&time_now,
-        &state->last_transmitted_announce, &delta);
-      if (timespec_to_ms(&delta)
-          > CONFIG_NETUTILS_PTPD_ANNOUNCE_INTERVAL_MSEC)
-        {
-          state->last_transmitted_announce = time_now;
-          ptp_send_announce(state);
-        }
+/* Send signaling message carrying unicast negotiation TLVs */
 
-      clock_timespec_subtract(&time_now,
-        &state->last_transmitted_sync, &delta);
-      if (timespec_to_ms(&delta) > CONFIG_NETUTILS_PTPD_SYNC_INTERVAL_MSEC)
-        {
-          state->last_transmitted_sync = time_now;
-          ptp_send_sync(state);
-        }
-    }
-#endif /* CONFIG_NETUTILS_PTPD_SERVER */
+static int ptp_send_signaling(FAR struct ptp_state_s *state,
+                              FAR const struct in_addr *dest,
+                              FAR const struct ptp_tlv_unicast_s *tlvs,
+                              int ntlvs)
+{
+  struct ptp_signaling_s msg;
+  struct sockaddr_in addr;
+  size_t length;
+  size_t tlvlen;
+  int ret;
+  int i;
 
-#ifdef CONFIG_NETUTILS_PTPD_SEND_DELAYREQ
-  if (state->selected_source_valid && state->can_send_delayreq)
+  memset(&msg, 0, sizeof(msg));
+  msg.header = state->own_identity.header;
+  msg.header.messagetype = PTP_MSGTYPE_SIGNALING;
+  msg.header.logmessageinterval = 0x7f;
+  memset(msg.targetidentity, 0xff, sizeof(msg.targetidentity));
+  memset(msg.targetportindex, 0xff, sizeof(msg.targetportindex));
+  ptp_increment_sequence(&state->signaling_seq, &msg.header);
+
+  length = offsetof(struct ptp_signaling_s, tlvs);
+  for (i = 0; i < ntlvs; i++)
     {
-      struct timespec time_now;
-      struct timespec delta;
+      tlvlen = sizeof(struct ptp_tlv_header_s) + tlvs[i].header.length[1];
+      memcpy((FAR uint8_t *)&msg + length, &tlvs[i], tlvlen);
+      length += tlvlen;
+    }
 
-      clock_gettime(CLOCK_MONOTONIC, &time_now);
-      clock_timespec_subtract(&time_now,
-                              &state->last_transmitted_delayreq, &delta);
+  msg.header.messagelength[0] = length >> 8;
+  msg.header.messagelength[1] = length & 0xff;
 
-      if (timespec_to_ms(&delta) > state->delayreq_interval * MSEC_PER_SEC)
-        {
-          ptp_send_delay_req(state);
-        }
+  ptp_setdest(&addr, dest, PTP_UDP_PORT_INFO);
+  ret = sendto(state->tx_socket, &msg, length, 0,
+               (FAR struct sockaddr *)&addr, sizeof(addr));
+  if (ret < 0)
+    {
+      ptperr("sendto for signaling message failed: %d\n", errno);
+    }
+
+  return ret;
+}
+
+#ifdef CONFIG_NETUTILS_PTPD_CLIENT
+/* Request announce, sync and delay response messages from the server */
+
+static int ptp_send_unicast_request(FAR struct ptp_state_s *state)
+{
+  struct ptp_tlv_unicast_s tlvs[PTP_SIGNALING_MAX_TLVS];
+
+  ptp_set_unicast_tlv(&tlvs[0], PTP_TLV_REQUEST_UNICAST,
+                      PTP_MSGTYPE_ANNOUNCE, 0,
+                      CONFIG_NETUTILS_PTPD_UNICAST_DURATION_S);
+  ptp_set_unicast_tlv(&tlvs[1], PTP_TLV_REQUEST_UNICAST,
+                      PTP_MSGTYPE_SYNC, 0,
+                      CONFIG_NETUTILS_PTPD_UNICAST_DURATION_S);
+  ptp_set_unicast_tlv(&tlvs[2], PTP_TLV_REQUEST_UNICAST,
+                      PTP_MSGTYPE_DELAY_RESP, 0,
+                      CONFIG_NETUTILS_PTPD_UNICAST_DURATION_S);
+
+  ptpinfo("Requesting unicast from %s\n",
+          inet_ntoa(state->unicast_server));
+  return ptp_send_signaling(state, &state->unicast_server, tlvs, 3);
+}
+#endif
+
+#ifdef CONFIG_NETUTILS_PTPD_SERVER
+/* Find the grant of a client, or a free entry for it */
+
+static FAR struct ptp_unicast_client_s *
+ptp_find_unicast_client(FAR struct ptp_state_s *state,
+                        FAR const struct in_addr *addr, bool allocate)
+{
+  FAR struct ptp_unicast_client_s *client;
+  FAR struct ptp_unicast_client_s *unused = NULL;
+  int i;
+
+  for (i = 0; i < CONFIG_NETUTILS_PTPD_UNICAST_MAX_CLIENTS; i++)
+    {
+      client = &state->unicast_clients[i];
+      if (client->granted == 0)
+        {
+          if (unused == NULL)
+            {
+              unused = client;
+            }
+        }
+      else if (client->addr.s_addr == addr->s_addr)
+        {
+          return client;
+        }
+    }
+
+  if (allocate && unused != NULL)
+    {
+      unused->addr = *addr;
+      return unused;
+    }
+
+  return NULL;
+}
+
+/* Send announce or sync message to every client granted it */
+
+static void ptp_send_unicast(FAR struct ptp_state_s *state, int msgtype,
+                             FAR const struct timespec *time_now)
+{
+  FAR struct ptp_unicast_client_s *client;
+  int i;
+
+  for (i = 0; i < CONFIG_NETUTILS_PTPD_UNICAST_MAX_CLIENTS; i++)
+    {
+      client = &state->unicast_clients[i];
+      if ((client->granted & (1 << msgtype)) == 0)
+        {
+          continue;
+        }
+
+      if (time_now->tv_sec >= client->expiry.tv_sec)
+        {
+          ptpinfo("Unicast grant of %s expired\n",
+                  inet_ntoa(client->addr));
+          client->granted = 0;
+          continue;
+        }
+
+      if (msgtype == PTP_MSGTYPE_ANNOUNCE)
+        {
+          ptp_send_announce(state, &client->addr);
+        }
+      else
+        {
+          ptp_send_sync(state, &client->addr);
+        }
+    }
+}
+
+/* Log2 of a message interval, as used in the message headers */
+
+static int8_t ptp_log_interval(int interval_ms)
+{
+  int8_t loginterval = 0;
+
+  while (interval_ms >= 2 * MSEC_PER_SEC)
+    {
+      interval_ms /= 2;
+      loginterval++;
+    }
+
+  while (interval_ms > 0 && interval_ms < MSEC_PER_SEC)
+    {
+      interval_ms *= 2;
+      loginterval--;
+    }
+
+  return loginterval;
+}
+
+/* Grant or deny one request TLV from the latest received packet */
+
+static void ptp_grant_unicast(FAR struct ptp_state_s *state,
+                              FAR const struct ptp_tlv_unicast_s *req,
+                              FAR struct ptp_tlv_unicast_s *grant)
+{
+  FAR struct ptp_unicast_client_s *client = NULL;
+  uint8_t msgtype = req->messagetype >> 4;
+  uint32_t duration = ptp_get_tlv_duration(req);
+  int8_t loginterval = (int8_t)req->logmessageinterval;
+  struct timespec time_now;
+
+  if (duration > CONFIG_NETUTILS_PTPD_UNICAST_DURATION_S)
+    {
+      duration = CONFIG_NETUTILS_PTPD_UNICAST_DURATION_S;
+    }
+
+  if (msgtype == PTP_MSGTYPE_ANNOUNCE)
+    {
+      loginterval =
+        ptp_log_interval(CONFIG_NETUTILS_PTPD_ANNOUNCE_INTERVAL_MSEC);
+    }
+  else if (msgtype == PTP_MSGTYPE_SYNC)
+    {
+      loginterval =
+        ptp_log_interval(CONFIG_NETUTILS_PTPD_SYNC_INTERVAL_MSEC);
+    }
+  else if (msgtype != PTP_MSGTYPE_DELAY_RESP)
+    {
+      duration = 0; /* Not a message type we send by unicast */
+    }
+
+  /* Only serve while acting as the master */
+
+  if (duration > 0 && !state->selected_source_valid &&
+      state->role != PTP_ROLE_SLAVE)
+    {
+      client = ptp_find_unicast_client(state, &state->rxaddr.sin_addr,
+                                       true);
+    }
+
+  if (client != NULL)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &time_now);
+      client->granted |= 1 << msgtype;
+      client->expiry.tv_sec = time_now.tv_sec + duration;
+      ptpinfo("Granted unicast type %d to %s for %lu s\n",
+              msgtype, inet_ntoa(client->addr), (unsigned long)duration);
+    }
+  else
+    {
+      duration = 0;
+      ptpwarn("Denied unicast type %d to %s\n",
+              msgtype, inet_ntoa(state->rxaddr.sin_addr));
+    }
+
+  ptp_set_unicast_tlv(grant, PTP_TLV_GRANT_UNICAST, msgtype, loginterval,
+                      duration);
+  grant->renewal = 1;
+}
+#endif /* CONFIG_NETUTILS_PTPD_SERVER */
+#endif /* CONFIG_NETUTILS_PTPD_UNICAST */
+
+#if defined(CONFIG_NETUTILS_PTPD_PDELAY) && \
+    defined(CONFIG_NETUTILS_PTPD_CLIENT)
+/* Send peer delay request to the neighbouring node */
+
+static int ptp_send_pdelay_req(FAR struct ptp_state_s *state)
+{
+  struct ptp_pdelay_req_s req;
+  struct sockaddr_in addr;
+  int ret;
+
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = HTONL(PTP_PDELAY_MULTICAST_ADDR);
+  addr.sin_port        = HTONS(PTP_UDP_PORT_EVENT);
+
+  memset(&req, 0, sizeof(req));
+  req.header = state->own_identity.header;
+  req.header.messagetype = PTP_MSGTYPE_PDELAY_REQ;
+  req.header.messagelength[1] = sizeof(req);
+  req.header.logmessageinterval = 0x7f;
+  ptp_increment_sequence(&state->pdelay_req_seq, &req.header);
+
+  ptp_gettime(state, &state->pdelay_t1);
+  timespec_to_ptp_format(&state->pdelay_t1, req.origintimestamp);
+  state->pdelay_resp_valid = false;
+
+#ifdef PTPD_HWTIMESTAMP
+  ptp_flushtxtime(state);
+#endif
+
+  clock_gettime(CLOCK_MONOTONIC, &state->last_transmitted_pdelayreq);
+
+  ret = sendto(state->tx_socket, &req, sizeof(req), 0,
+               (FAR struct sockaddr *)&addr, sizeof(addr));
+  if (ret < 0)
+    {
+      ptperr("sendto for pdelay req failed: %d\n", errno);
+      return ret;
+    }
+
+  ptp_gettxtime(state, &state->pdelay_t1);
+  ptpinfo("Sent pdelay req, seq %ld\n",
+          (long)ptp_get_sequence(&req.header));
+  return OK;
+}
+#endif
+
+/* Check if we need to send packets */
+
+static int ptp_periodic_send(FAR struct ptp_state_s *state)
+{
+#ifdef CONFIG_NETUTILS_PTPD_SERVER
+  /* If there is no better master clock on the network,
+   * act as the reference source and send server packets.
+   */
+
+  if (!state->selected_source_valid && state->role != PTP_ROLE_SLAVE)
+    {
+      struct timespec time_now;
+      struct timespec delta;
+
+      clock_gettime(CLOCK_MONOTONIC, &time_now);
+      clock_timespec_subtract(&time_now,
+        &state->last_transmitted_announce, &delta);
+      if (timespec_to_ms(&delta)
+          > CONFIG_NETUTILS_PTPD_ANNOUNCE_INTERVAL_MSEC)
+        {
+          state->last_transmitted_announce = time_now;
+          ptp_send_announce(state, NULL);
+#ifdef CONFIG_NETUTILS_PTPD_UNICAST
+          ptp_send_unicast(state, PTP_MSGTYPE_ANNOUNCE, &time_now);
+#endif
+        }
+
+      clock_timespec_subtract(&time_now,
+        &state->last_transmitted_sync, &delta);
+      if (timespec_to_ms(&delta) > CONFIG_NETUTILS_PTPD_SYNC_INTERVAL_MSEC)
+        {
+          state->last_transmitted_sync = time_now;
+          ptp_send_sync(state, NULL);
+#ifdef CONFIG_NETUTILS_PTPD_UNICAST
+          ptp_send_unicast(state, PTP_MSGTYPE_SYNC, &time_now);
+#endif
+        }
+    }
+#endif /* CONFIG_NETUTILS_PTPD_SERVER */
+
+#if defined(CONFIG_NETUTILS_PTPD_UNICAST) && \
+    defined(CONFIG_NETUTILS_PTPD_CLIENT)
+  /* Request unicast messages until granted, and renew the grant */
+
+  if (state->unicast_server.s_addr != 0)
+    {
+      struct timespec time_now;
+
+      clock_gettime(CLOCK_MONOTONIC, &time_now);
+      if (time_now.tv_sec >= state->unicast_renew.tv_sec)
+        {
+          state->unicast_renew.tv_sec = time_now.tv_sec +
+                                        PTPD_UNICAST_RETRY_S;
+          ptp_send_unicast_request(state);
+        }
+    }
+#endif
+
+#if defined(CONFIG_NETUTILS_PTPD_PDELAY) && \
+    defined(CONFIG_NETUTILS_PTPD_CLIENT)
+  /* Measure link delay independent of clock synchronization */
+
+  if (state->role != PTP_ROLE_MASTER)
+    {
+      struct timespec time_now;
+      struct timespec delta;
+
+      clock_gettime(CLOCK_MONOTONIC, &time_now);
+      clock_timespec_subtract(&time_now,
+                              &state->last_transmitted_pdelayreq, &delta);
+      if (timespec_to_ms(&delta) >
+          CONFIG_NETUTILS_PTPD_PDELAY_INTERVAL_MSEC)
+        {
+          ptp_send_pdelay_req(state);
+        }
+    }
+#endif
+
+#ifdef CONFIG_NETUTILS_PTPD_SEND_DELAYREQ
+  if (state->selected_source_valid && state->can_send_delayreq)
+    {
+      struct timespec time_now;
+      struct timespec delta;
+
+      clock_gettime(CLOCK_MONOTONIC, &time_now);
+      clock_timespec_subtract(&time_now,
+                              &state->last_transmitted_delayreq, &delta);
+
+      if (timespec_to_ms(&delta) > state->delayreq_interval * MSEC_PER_SEC)
+        {
+          ptp_send_delay_req(state);
+        }
     }
 #endif
 
@@ -843,6 +1585,11 @@ static int ptp_periodic_send(FAR struct ptp_state_s *state)
 static int ptp_process_announce(FAR struct ptp_state_s *state,
                                 FAR struct ptp_announce_s *msg)
 {
+  if (state->role == PTP_ROLE_MASTER)
+    {
+      return OK; /* Boundary clock master port never follows its segment */
+    }
+
   clock_gettime(CLOCK_MONOTONIC, &state->last_received_announce);
 
   if (is_better_clock(msg, &state->own_identity))
@@ -856,6 +1603,10 @@ static int ptp_process_announce(FAR struct ptp_state_s *state,
           state->last_received_sync = state->last_received_announce;
           state->path_delay_avgcount = 0;
           state->path_delay_ns = 0;
+#if CONFIG_NETUTILS_PTPD_DELAY_FILTER_LEN > 1
+          state->path_delay_nsamples = 0;
+          state->path_delay_head = 0;
+#endif
           state->delayreq_time.tv_sec = 0;
         }
     }
@@ -863,6 +1614,99 @@ static int ptp_process_announce(FAR struct ptp_state_s *state,
   return OK;
 }
 
+#ifdef CONFIG_NETUTILS_PTPD_SERVO_PI
+/* PI servo: estimate the frequency error from the first two measurements
+ * after a clock jump, then correct it with the integral term and the
+ * remaining offset with the proportional term. Returns the value for
+ * adjtime() that gives the resulting rate over CLOCK_ADJTIME_PERIOD_MS.
+ */
+
+static int64_t ptp_servo_pi(FAR struct ptp_state_s *state, int64_t delta_ns,
+                            FAR struct timespec *local_timestamp)
+{
+  const int64_t max_ppb = CONFIG_CLOCK_ADJTIME_SLEWLIMIT_PPM * 1000;
+  struct timespec interval;
+  int64_t drift_ppb;
+  int64_t ki_term;
+  int64_t ppb;
+  int interval_ms;
+
+  clock_timespec_subtract(local_timestamp, &state->last_delta_timestamp,
+                          &interval);
+  interval_ms = timespec_to_ms(&interval);
+
+  if (interval_ms <= 0 || interval_ms >= CONFIG_NETUTILS_PTPD_TIMEOUT_MS)
+    {
+      /* Too far from the previous measurement to estimate anything */
+
+      state->servo_count = 0;
+    }
+
+  switch (state->servo_count)
+    {
+      case 0:
+
+        /* Only correct the offset until the frequency is known */
+
+        state->servo_count = 1;
+        return state->drift_ppb * CONFIG_CLOCK_ADJTIME_PERIOD_MS
+               / MSEC_PER_SEC + delta_ns;
+
+      case 1:
+
+        /* Frequency error is the change of offset, not counting the
+         * adjustment that was made in between.
+         */
+
+        drift_ppb = (delta_ns - state->last_delta_ns) * MSEC_PER_SEC
+                    / interval_ms;
+        drift_ppb += state->last_adjtime_ns * MSEC_PER_SEC
+                     / CONFIG_CLOCK_ADJTIME_PERIOD_MS;
+
+        if (drift_ppb > -max_ppb && drift_ppb < max_ppb)
+          {
+            state->drift_ppb = drift_ppb;
+            state->servo_count = 2;
+          }
+        else
+          {
+            ptpwarn("Drift estimate out of range: %lld\n",
+                    (long long)drift_ppb);
+          }
+
+        break;
+
+      default:
+        break;
+    }
+
+  /* The gains are per measurement, scale the offset (ns) by the interval
+   * to get a rate (ppb).
+   */
+
+  ki_term = delta_ns * CONFIG_NETUTILS_PTPD_SERVO_KI / interval_ms;
+  ppb = delta_ns * CONFIG_NETUTILS_PTPD_SERVO_KP / interval_ms +
+        state->drift_ppb + ki_term;
+
+  if (state->servo_count > 1)
+    {
+      drift_ppb = state->drift_ppb + ki_term;
+      if (drift_ppb > max_ppb)
+        {
+          drift_ppb = max_ppb;
+        }
+      else if (drift_ppb < -max_ppb)
+        {
+          drift_ppb = -max_ppb;
+        }
+
+      state->drift_ppb = drift_ppb;
+    }
+
+  return ppb * CONFIG_CLOCK_ADJTIME_PERIOD_MS / MSEC_PER_SEC;
+}
+#endif /* CONFIG_NETUTILS_PTPD_SERVO_PI */
+
 /* Update local clock either by smooth adjustment or by jumping.
  * Remote time was remote_timestamp at local_timestamp.
  */
@@ -906,6 +1750,9 @@ static int ptp_update_local_clock(FAR struct ptp_state_s *state,
       state->last_adjtime_ns = 0;
       state->drift_avg_total_ms = 0;
       state->drift_ppb = 0;
+#ifdef CONFIG_NETUTILS_PTPD_SERVO_PI
+      state->servo_count = 0;
+#endif
 
       if (ret == OK)
         {
@@ -919,6 +1766,10 @@ static int ptp_update_local_clock(FAR struct ptp_state_s *state,
     }
   else
     {
+      int64_t adjustment_ns;
+#ifdef CONFIG_NETUTILS_PTPD_SERVO_PI
+      adjustment_ns = ptp_servo_pi(state, delta_ns, local_timestamp);
+#else
       /* Track drift rate based on two consecutive measurements and
        * the adjustment that was made previously.
        */
@@ -927,7 +1778,6 @@ static int ptp_update_local_clock(FAR struct ptp_state_s *state,
       struct timespec interval;
       int interval_ms;
       int max_avg_period_ms;
-      int64_t adjustment_ns;
 
       clock_timespec_subtract(local_timestamp,
                               &state->last_delta_timestamp,
@@ -1004,6 +1854,7 @@ static int ptp_update_local_clock(FAR struct ptp_state_s *state,
         {
           adjustment_ns += delta_ns;
         }
+#endif /* CONFIG_NETUTILS_PTPD_SERVO_PI */
 
       /* Apply adjustment and store information for next time */
 
@@ -1064,9 +1915,12 @@ static int ptp_process_sync(FAR struct ptp_state_s *state,
       return OK;
     }
 
-  /* Update local clock */
+  /* Update local clock, including the residence time added to the
+   * correction field by transparent clocks.
+   */
 
   ptp_format_to_timespec(msg->origintimestamp, &remote_time);
+  timespec_add_ns(&remote_time, ptp_get_correction_ns(&msg->header));
   return ptp_update_local_clock(state, &remote_time, &state->rxtime);
 }
 
@@ -1097,6 +1951,9 @@ static int ptp_process_followup(FAR struct ptp_state_s *state,
    */
 
   ptp_format_to_timespec(msg->origintimestamp, &remote_time);
+  timespec_add_ns(&remote_time,
+                  ptp_get_correction_ns(&state->twostep_packet.header) +
+                  ptp_get_correction_ns(&msg->header));
   return ptp_update_local_clock(state, &remote_time, &state->twostep_rxtime);
 }
 
@@ -1105,18 +1962,32 @@ static int ptp_process_delay_req(FAR struct ptp_state_s *state,
 {
   struct ptp_delay_resp_s resp;
   struct sockaddr_in addr;
+#if defined(CONFIG_NETUTILS_PTPD_UNICAST) && \
+    defined(CONFIG_NETUTILS_PTPD_SERVER)
+  FAR struct ptp_unicast_client_s *client;
+#endif
   int ret;
 
-  if (state->selected_source_valid)
+  if (state->selected_source_valid || state->role == PTP_ROLE_SLAVE)
     {
       /* We are operating as a client, ignore delay requests */
 
       return OK;
     }
 
-  addr.sin_family      = AF_INET;
-  addr.sin_addr.s_addr = HTONL(PTP_MULTICAST_ADDR);
-  addr.sin_port        = HTONS(PTP_UDP_PORT_INFO);
+  ptp_setdest(&addr, NULL, PTP_UDP_PORT_INFO);
+
+#if defined(CONFIG_NETUTILS_PTPD_UNICAST) && \
+    defined(CONFIG_NETUTILS_PTPD_SERVER)
+  /* Answer only the requester if it has negotiated unicast */
+
+  client = ptp_find_unicast_client(state, &state->rxaddr.sin_addr, false);
+  if (client != NULL &&
+      (client->granted & (1 << PTP_MSGTYPE_DELAY_RESP)) != 0)
+    {
+      addr.sin_addr = client->addr;
+    }
+#endif
 
   memset(&resp, 0, sizeof(resp));
   resp.header = state->own_identity.header;
@@ -1148,47 +2019,54 @@ static int ptp_process_delay_req(FAR struct ptp_state_s *state,
   return ret;
 }
 
-static int ptp_process_delay_resp(FAR struct ptp_state_s *state,
-                                  FAR struct ptp_delay_resp_s *msg)
+#if CONFIG_NETUTILS_PTPD_DELAY_FILTER_LEN > 1
+/* Add a path delay measurement to the window and return the median */
+
+static long ptp_filter_path_delay(FAR struct ptp_state_s *state,
+                                  long path_delay)
 {
-  int64_t path_delay;
-  int64_t sync_delay;
-  struct timespec remote_rxtime;
-  uint16_t sequence;
-  int interval;
+  long sorted[CONFIG_NETUTILS_PTPD_DELAY_FILTER_LEN];
+  long value;
+  int i;
+  int j;
 
-  if (!state->selected_source_valid ||
-      memcmp(msg->header.sourceidentity,
-             state->selected_source.header.sourceidentity,
-             sizeof(msg->header.sourceidentity)) != 0 ||
-      memcmp(msg->reqidentity,
-             state->own_identity.header.sourceidentity,
-             sizeof(msg->reqidentity)) != 0)
+  state->path_delay_window[state->path_delay_head] = path_delay;
+  state->path_delay_head = (state->path_delay_head + 1)
+                           % CONFIG_NETUTILS_PTPD_DELAY_FILTER_LEN;
+
+  if (state->path_delay_nsamples < CONFIG_NETUTILS_PTPD_DELAY_FILTER_LEN)
     {
-      return OK; /* This packet wasn't for us */
+      state->path_delay_nsamples++;
     }
 
-  sequence = ptp_get_sequence(&msg->header);
+  /* Insertion sort, the window is short */
 
-  if (sequence != state->delay_req_seq)
+  for (i = 0; i < state->path_delay_nsamples; i++)
     {
-      ptpwarn("Ignoring out-of-sequence delay resp (%d vs. expected %d)\n",
-              (int)sequence, (int)state->delay_req_seq);
-      return OK;
-    }
-
-  /* Path delay is calculated as the average between delta for sync
-   * message and delta for delay req message.
-   * (IEEE-1588 section 11.3: Delay request-response mechanism)
-   */
+      value = state->path_delay_window[i];
+      for (j = i; j > 0 && sorted[j - 1] > value; j--)
+        {
+          sorted[j] = sorted[j - 1];
+        }
 
-  ptp_format_to_timespec(msg->receivetimestamp, &remote_rxtime);
-  path_delay = timespec_delta_ns(&remote_rxtime, &state->delayreq_time);
-  sync_delay = state->path_delay_ns - state->last_delta_ns;
-  path_delay = (path_delay + sync_delay) / 2;
+      sorted[j] = value;
+    }
+
+  return sorted[state->path_delay_nsamples / 2];
+}
+#endif
 
+/* Filter and average a new path delay measurement */
+
+static void ptp_update_path_delay(FAR struct ptp_state_s *state,
+                                  int64_t path_delay)
+{
   if (path_delay >= 0 && path_delay < CONFIG_NETUTILS_PTPD_MAX_PATH_DELAY_NS)
     {
+#if CONFIG_NETUTILS_PTPD_DELAY_FILTER_LEN > 1
+      path_delay = ptp_filter_path_delay(state, path_delay);
+#endif
+
       if (state->path_delay_avgcount <
           CONFIG_NETUTILS_PTPD_DELAYREQ_AVGCOUNT)
         {
@@ -1206,6 +2084,48 @@ static int ptp_process_delay_resp(FAR struct ptp_state_s *state,
       ptpwarn("Path delay out of range: %lld ns\n",
               (long long)path_delay);
     }
+}
+
+static int ptp_process_delay_resp(FAR struct ptp_state_s *state,
+                                  FAR struct ptp_delay_resp_s *msg)
+{
+  int64_t path_delay;
+  int64_t sync_delay;
+  struct timespec remote_rxtime;
+  uint16_t sequence;
+  int interval;
+
+  if (!state->selected_source_valid ||
+      memcmp(msg->header.sourceidentity,
+             state->selected_source.header.sourceidentity,
+             sizeof(msg->header.sourceidentity)) != 0 ||
+      memcmp(msg->reqidentity,
+             state->own_identity.header.sourceidentity,
+             sizeof(msg->reqidentity)) != 0)
+    {
+      return OK; /* This packet wasn't for us */
+    }
+
+  sequence = ptp_get_sequence(&msg->header);
+
+  if (sequence != state->delay_req_seq)
+    {
+      ptpwarn("Ignoring out-of-sequence delay resp (%d vs. expected %d)\n",
+              (int)sequence, (int)state->delay_req_seq);
+      return OK;
+    }
+
+  /* Path delay is calculated as the average between delta for sync
+   * message and delta for delay req message.
+   * (IEEE-1588 section 11.3: Delay request-response mechanism)
+   */
+
+  ptp_format_to_timespec(msg->receivetimestamp, &remote_rxtime);
+  path_delay = timespec_delta_ns(&remote_rxtime, &state->delayreq_time);
+  sync_delay = state->path_delay_ns - state->last_delta_ns;
+  path_delay = (path_delay + sync_delay) / 2;
+
+  ptp_update_path_delay(state, path_delay);
 
   /* Calculate interval until next packet */
 
@@ -1225,6 +2145,270 @@ static int ptp_process_delay_resp(FAR struct ptp_state_s *state,
   return OK;
 }
 
+#ifdef CONFIG_NETUTILS_PTPD_PDELAY
+/* Answer peer delay request with the two-step response */
+
+static int ptp_process_pdelay_req(FAR struct ptp_state_s *state,
+                                  FAR struct ptp_pdelay_req_s *msg)
+{
+  struct ptp_pdelay_resp_follow_up_s followup;
+  struct ptp_pdelay_resp_s resp;
+  struct sockaddr_in addr;
+  struct timespec ts;
+  int ret;
+
+  if (memcmp(msg->header.sourceidentity,
+             state->own_identity.header.sourceidentity,
+             sizeof(msg->header.sourceidentity)) == 0)
+    {
+      return OK; /* Our own request */
+    }
+
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = HTONL(PTP_PDELAY_MULTICAST_ADDR);
+  addr.sin_port        = HTONS(PTP_UDP_PORT_EVENT);
+
+  memset(&resp, 0, sizeof(resp));
+  resp.header = state->own_identity.header;
+  resp.header.messagetype = PTP_MSGTYPE_PDELAY_RESP;
+  resp.header.messagelength[1] = sizeof(resp);
+  resp.header.flags[0] = PTP_FLAGS0_TWOSTEP;
+  resp.header.logmessageinterval = 0x7f;
+  memcpy(resp.header.sequenceid, msg->header.sequenceid,
+         sizeof(resp.header.sequenceid));
+  timespec_to_ptp_format(&state->rxtime, resp.requestreceipttimestamp);
+  memcpy(resp.reqidentity, msg->header.sourceidentity,
+         sizeof(resp.reqidentity));
+  memcpy(resp.reqportindex, msg->header.sourceportindex,
+         sizeof(resp.reqportindex));
+
+#ifdef PTPD_HWTIMESTAMP
+  ptp_flushtxtime(state);
+#endif
+
+  ret = sendto(state->tx_socket, &resp, sizeof(resp), 0,
+               (FAR struct sockaddr *)&addr, sizeof(addr));
+  if (ret < 0)
+    {
+      ptperr("sendto for pdelay resp failed: %d\n", errno);
+      return ret;
+    }
+
+  /* Send the actual transmit time of the response in the follow-up */
+
+  ptp_gettxtime(state, &ts);
+
+  memset(&followup, 0, sizeof(followup));
+  followup.header = resp.header;
+  followup.header.messagetype = PTP_MSGTYPE_PDELAY_RESP_FOLLOW_UP;
+  followup.header.messagelength[1] = sizeof(followup);
+  followup.header.flags[0] = 0;
+  timespec_to_ptp_format(&ts, followup.responseorigintimestamp);
+  memcpy(followup.reqidentity, resp.reqidentity,
+         sizeof(followup.reqidentity));
+  memcpy(followup.reqportindex, resp.reqportindex,
+         sizeof(followup.reqportindex));
+
+  addr.sin_port = HTONS(PTP_UDP_PORT_INFO);
+  ret = sendto(state->tx_socket, &followup, sizeof(followup), 0,
+               (FAR struct sockaddr *)&addr, sizeof(addr));
+  if (ret < 0)
+    {
+      ptperr("sendto for pdelay follow-up failed: %d\n", errno);
+      return ret;
+    }
+
+  ptpinfo("Sent pdelay resp, seq %ld\n",
+          (long)ptp_get_sequence(&msg->header));
+  return OK;
+}
+
+#ifdef CONFIG_NETUTILS_PTPD_CLIENT
+/* Check that a peer delay response is for our latest request */
+
+static bool ptp_is_own_pdelay(FAR struct ptp_state_s *state,
+                              FAR const struct ptp_header_s *hdr,
+                              FAR const uint8_t *reqidentity,
+                              FAR const uint8_t *reqportindex)
+{
+  return memcmp(reqidentity, state->own_identity.header.sourceidentity,
+                sizeof(state->own_identity.header.sourceidentity)) == 0 &&
+         memcmp(reqportindex,
+                state->own_identity.header.sourceportindex,
+                sizeof(state->own_identity.header.sourceportindex)) == 0 &&
+         ptp_get_sequence(hdr) == state->pdelay_req_seq;
+}
+
+static int ptp_process_pdelay_resp(FAR struct ptp_state_s *state,
+                                   FAR struct ptp_pdelay_resp_s *msg)
+{
+  int64_t turnaround;
+
+  if (!ptp_is_own_pdelay(state, &msg->header, msg->reqidentity,
+                         msg->reqportindex))
+    {
+      return OK;
+    }
+
+  state->pdelay_t4 = state->rxtime;
+
+  if (msg->header.flags[0] & PTP_FLAGS0_TWOSTEP)
+    {
+      /* Wait for the follow-up with the transmit time of the response */
+
+      ptp_format_to_timespec(msg->requestreceipttimestamp,
+                             &state->pdelay_t2);
+      memcpy(state->pdelay_responder, msg->header.sourceidentity,
+             sizeof(state->pdelay_responder));
+      state->pdelay_resp_valid = true;
+      return OK;
+    }
+
+  /* One-step responder puts its turnaround time in the correction */
+
+  turnaround = ptp_get_correction_ns(&msg->header);
+  ptp_update_path_delay(state,
+    (timespec_delta_ns(&state->pdelay_t4, &state->pdelay_t1) -
+     turnaround) / 2);
+  return OK;
+}
+
+static int ptp_process_pdelay_followup(FAR struct ptp_state_s *state,
+  FAR struct ptp_pdelay_resp_follow_up_s *msg)
+{
+  struct timespec t3;
+  int64_t path_delay;
+
+  if (!state->pdelay_resp_valid ||
+      !ptp_is_own_pdelay(state, &msg->header, msg->reqidentity,
+                         msg->reqportindex) ||
+      memcmp(msg->header.sourceidentity, state->pdelay_responder,
+             sizeof(state->pdelay_responder)) != 0)
+    {
+      return OK;
+    }
+
+  state->pdelay_resp_valid = false;
+
+  /* Link delay is half of the round trip, less the time the peer
+   * held the request (IEEE-1588 section 11.4: Peer delay mechanism).
+   */
+
+  ptp_format_to_timespec(msg->responseorigintimestamp, &t3);
+  path_delay = timespec_delta_ns(&state->pdelay_t4, &state->pdelay_t1) -
+               timespec_delta_ns(&t3, &state->pdelay_t2) -
+               ptp_get_correction_ns(&msg->header);
+  ptp_update_path_delay(state, path_delay / 2);
+  return OK;
+}
+#endif /* CONFIG_NETUTILS_PTPD_CLIENT */
+#endif /* CONFIG_NETUTILS_PTPD_PDELAY */
+
+#ifdef CONFIG_NETUTILS_PTPD_UNICAST
+#ifdef CONFIG_NETUTILS_PTPD_CLIENT
+/* Schedule renewal of the grant from our unicast server */
+
+static void ptp_process_grant(FAR struct ptp_state_s *state,
+                              FAR const struct ptp_tlv_unicast_s *grant)
+{
+  uint32_t duration = ptp_get_tlv_duration(grant);
+  struct timespec time_now;
+
+  if (state->unicast_server.s_addr != state->rxaddr.sin_addr.s_addr ||
+      (grant->messagetype >> 4) != PTP_MSGTYPE_SYNC)
+    {
+      return;
+    }
+
+  if (duration == 0)
+    {
+      ptpwarn("Unicast request denied by %s\n",
+              inet_ntoa(state->unicast_server));
+      return;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &time_now);
+  state->unicast_renew.tv_sec = time_now.tv_sec + duration / 2;
+  ptpinfo("Unicast granted for %lu s\n", (unsigned long)duration);
+}
+#endif
+
+/* Process the unicast negotiation TLVs of a signaling message */
+
+static int ptp_process_signaling(FAR struct ptp_state_s *state,
+                                 ssize_t length)
+{
+#ifdef CONFIG_NETUTILS_PTPD_SERVER
+  struct ptp_tlv_unicast_s grants[PTP_SIGNALING_MAX_TLVS];
+  FAR struct ptp_unicast_client_s *client;
+  int ngrants = 0;
+#endif
+  FAR struct ptp_tlv_unicast_s *tlv;
+  size_t offset;
+  uint16_t type;
+  uint16_t tlvlen;
+
+  offset = offsetof(struct ptp_signaling_s, tlvs);
+  while (offset + sizeof(struct ptp_tlv_header_s) <= length)
+    {
+      tlv = (FAR struct ptp_tlv_unicast_s *)&state->rxbuf.raw[offset];
+      type = ((uint16_t)tlv->header.type[0] << 8) | tlv->header.type[1];
+      tlvlen = ((uint16_t)tlv->header.length[0] << 8) |
+               tlv->header.length[1];
+
+      offset += sizeof(struct ptp_tlv_header_s) + tlvlen;
+      if (offset > length)
+        {
+          break;
+        }
+
+      switch (type)
+        {
+#ifdef CONFIG_NETUTILS_PTPD_SERVER
+          case PTP_TLV_REQUEST_UNICAST:
+            if (tlvlen >= 6 && ngrants < PTP_SIGNALING_MAX_TLVS)
+              {
+                ptp_grant_unicast(state, tlv, &grants[ngrants++]);
+              }
+            break;
+
+          case PTP_TLV_CANCEL_UNICAST:
+            client = ptp_find_unicast_client(state,
+                                             &state->rxaddr.sin_addr,
+                                             false);
+            if (client != NULL && tlvlen >= 2)
+              {
+                client->granted &= ~(1 << (tlv->messagetype >> 4));
+              }
+            break;
+#endif
+
+#ifdef CONFIG_NETUTILS_PTPD_CLIENT
+          case PTP_TLV_GRANT_UNICAST:
+            if (tlvlen >= 8)
+              {
+                ptp_process_grant(state, tlv);
+              }
+            break;
+#endif
+
+          default:
+            break;
+        }
+    }
+
+#ifdef CONFIG_NETUTILS_PTPD_SERVER
+  if (ngrants > 0)
+    {
+      return ptp_send_signaling(state, &state->rxaddr.sin_addr, grants,
+                                ngrants);
+    }
+#endif
+
+  return OK;
+}
+#endif /* CONFIG_NETUTILS_PTPD_UNICAST */
+
 /* Determine received packet type and process it */
 
 static int ptp_process_rx_packet(FAR struct ptp_state_s *state,
@@ -1277,6 +2461,33 @@ static int ptp_process_rx_packet(FAR struct ptp_state_s *state,
       return ptp_process_delay_req(state, &state->rxbuf.delay_req);
 #endif
 
+#ifdef CONFIG_NETUTILS_PTPD_PDELAY
+    case PTP_MSGTYPE_PDELAY_REQ:
+      ptpinfo("Got pdelay req, seq %ld\n",
+              (long)ptp_get_sequence(&state->rxbuf.header));
+      return ptp_process_pdelay_req(state, &state->rxbuf.pdelay_req);
+
+#ifdef CONFIG_NETUTILS_PTPD_CLIENT
+    case PTP_MSGTYPE_PDELAY_RESP:
+      ptpinfo("Got pdelay resp, seq %ld\n",
+              (long)ptp_get_sequence(&state->rxbuf.header));
+      return ptp_process_pdelay_resp(state, &state->rxbuf.pdelay_resp);
+
+    case PTP_MSGTYPE_PDELAY_RESP_FOLLOW_UP:
+      ptpinfo("Got pdelay follow-up, seq %ld\n",
+              (long)ptp_get_sequence(&state->rxbuf.header));
+      return ptp_process_pdelay_followup(state,
+                                         &state->rxbuf.pdelay_resp_follow_up);
+#endif
+#endif
+
+#ifdef CONFIG_NETUTILS_PTPD_UNICAST
+    case PTP_MSGTYPE_SIGNALING:
+      ptpinfo("Got signaling, seq %ld\n",
+              (long)ptp_get_sequence(&state->rxbuf.header));
+      return ptp_process_signaling(state, length);
+#endif
+
     default:
       ptpinfo("Ignoring unknown PTP packet type: 0x%02x\n",
               state->rxbuf.header.messagetype);
@@ -1386,105 +2597,177 @@ static void ptp_process_statusreq(FAR struct ptp_state_s *state)
   state->status_req.dest = NULL;
 }
 
-/* Main PTPD task */
+/* Receive and process packets of one port */
 
-static int ptp_daemon(int argc, FAR char** argv)
+static void ptp_process_port(FAR struct ptp_state_s *state,
+                             FAR struct pollfd *pollfds)
 {
-  FAR const char *interface = "eth0";
-  FAR struct ptp_state_s *state;
-  struct pollfd pollfds[2];
   struct msghdr rxhdr;
   struct iovec rxiov;
+  socklen_t addrlen;
   int ret;
 
   memset(&rxhdr, 0, sizeof(rxhdr));
   memset(&rxiov, 0, sizeof(rxiov));
 
-  state = calloc(1, sizeof(struct ptp_state_s));
+  rxhdr.msg_name = &state->rxaddr;
+  rxhdr.msg_namelen = sizeof(state->rxaddr);
+  rxhdr.msg_iov = &rxiov;
+  rxhdr.msg_iovlen = 1;
+  rxhdr.msg_control = &state->rxcmsg;
+  rxhdr.msg_controllen = sizeof(state->rxcmsg);
+  rxhdr.msg_flags = 0;
+  rxiov.iov_base = &state->rxbuf;
+  rxiov.iov_len = sizeof(state->rxbuf);
+
+  if (pollfds[0].revents)
+    {
+      /* Receive time-critical packet, potentially with cmsg
+       * indicating the timestamp.
+       */
 
-  if (argc > 1)
+      ret = recvmsg(state->event_socket, &rxhdr, MSG_DONTWAIT);
+      if (ret > 0)
+        {
+          ptp_getrxtime(state, &rxhdr, &state->rxtime);
+          ptp_process_rx_packet(state, ret);
+        }
+    }
+
+  if (pollfds[1].revents)
     {
-      interface = argv[1];
+      /* Receive non-time-critical packet. */
+
+      addrlen = sizeof(state->rxaddr);
+      ret = recvfrom(state->info_socket, &state->rxbuf,
+                     sizeof(state->rxbuf), MSG_DONTWAIT,
+                     (FAR struct sockaddr *)&state->rxaddr, &addrlen);
+      if (ret > 0)
+        {
+          ptp_process_rx_packet(state, ret);
+        }
     }
 
-  if (ptp_initialize_state(state, interface) != OK)
+  if (pollfds[0].revents == 0 && pollfds[1].revents == 0)
     {
-      ptperr("Failed to initialize PTP state, exiting\n");
+      /* No packets received, check for multicast timeout */
 
-      ptp_destroy_state(state);
-      free(state);
+      ptp_check_multicast_status(state);
+    }
+}
 
+/* Main PTPD task
+ *
+ * argv[1] is the interface, argv[2] the unicast server address and
+ * argv[3] the master port of a boundary clock, empty if not used.
+ */
+
+static int ptp_daemon(int argc, FAR char** argv)
+{
+  FAR const char *interface = "eth0";
+  FAR const char *master_port = NULL;
+  FAR struct ptp_state_s *state;
+  struct pollfd pollfds[2 * PTPD_MAX_PORTS];
+  int nports = 1;
+  int ret = ERROR;
+  int i;
+
+  state = calloc(PTPD_MAX_PORTS, sizeof(struct ptp_state_s));
+  if (state == NULL)
+    {
       return ERROR;
     }
 
-  ptp_setup_sighandlers(state);
+  if (argc > 1)
+    {
+      interface = argv[1];
+    }
 
-  pollfds[0].events = POLLIN;
-  pollfds[0].fd = state->event_socket;
-  pollfds[1].events = POLLIN;
-  pollfds[1].fd = state->info_socket;
+#ifdef CONFIG_NETUTILS_PTPD_UNICAST
+  if (argc > 2 && argv[2][0] != '\0' &&
+      inet_pton(AF_INET, argv[2], &state->unicast_server) != 1)
+    {
+      ptperr("Invalid unicast server address %s\n", argv[2]);
+      goto errout;
+    }
+#endif
 
-  while (!state->stop)
+#ifdef CONFIG_NETUTILS_PTPD_BOUNDARY
+  if (argc > 3 && argv[3][0] != '\0')
     {
-      state->can_send_delayreq = false;
+      master_port = argv[3];
+      nports = 2;
+      state[0].role = PTP_ROLE_SLAVE;
+      state[1].role = PTP_ROLE_MASTER;
+      state[1].upstream = &state[0];
+    }
+#endif
 
-      rxhdr.msg_name = NULL;
-      rxhdr.msg_namelen = 0;
-      rxhdr.msg_iov = &rxiov;
-      rxhdr.msg_iovlen = 1;
-      rxhdr.msg_control = &state->rxcmsg;
-      rxhdr.msg_controllen = sizeof(state->rxcmsg);
-      rxhdr.msg_flags = 0;
-      rxiov.iov_base = &state->rxbuf;
-      rxiov.iov_len = sizeof(state->rxbuf);
+  for (i = 0; i < nports; i++)
+    {
+      if (ptp_initialize_state(&state[i],
+                               i == 0 ? interface : master_port) != OK)
+        {
+          ptperr("Failed to initialize PTP state, exiting\n");
+          goto errout;
+        }
+    }
 
-      pollfds[0].revents = 0;
-      pollfds[1].revents = 0;
-      ret = poll(pollfds, 2, PTPD_POLL_INTERVAL);
+  if (nports > 1)
+    {
+      /* Both ports of a boundary clock belong to the same clock */
+
+      memcpy(state[1].own_identity.header.sourceidentity,
+             state[0].own_identity.header.sourceidentity,
+             sizeof(state[1].own_identity.header.sourceidentity));
+      memcpy(state[1].own_identity.gm_identity,
+             state[0].own_identity.gm_identity,
+             sizeof(state[1].own_identity.gm_identity));
+      state[1].own_identity.header.sourceportindex[1] = 2;
+    }
 
-      if (pollfds[0].revents)
-        {
-          /* Receive time-critical packet, potentially with cmsg
-           * indicating the timestamp.
-           */
+  ptp_setup_sighandlers(state);
 
-          ret = recvmsg(state->event_socket, &rxhdr, MSG_DONTWAIT);
-          if (ret > 0)
-            {
-              ptp_getrxtime(state, &rxhdr, &state->rxtime);
-              ptp_process_rx_packet(state, ret);
-            }
-        }
+  for (i = 0; i < nports; i++)
+    {
+      pollfds[2 * i].events = POLLIN;
+      pollfds[2 * i].fd = state[i].event_socket;
+      pollfds[2 * i + 1].events = POLLIN;
+      pollfds[2 * i + 1].fd = state[i].info_socket;
+    }
 
-      if (pollfds[1].revents)
+  while (!state->stop)
+    {
+      for (i = 0; i < nports; i++)
         {
-          /* Receive non-time-critical packet. */
-
-          ret = recv(state->info_socket, &state->rxbuf, sizeof(state->rxbuf),
-                    MSG_DONTWAIT);
-          if (ret > 0)
-            {
-              ptp_process_rx_packet(state, ret);
-            }
+          state[i].can_send_delayreq = false;
+          pollfds[2 * i].revents = 0;
+          pollfds[2 * i + 1].revents = 0;
         }
 
-      if (pollfds[0].revents == 0 && pollfds[1].revents == 0)
-        {
-          /* No packets received, check for multicast timeout */
+      poll(pollfds, 2 * nports, PTPD_POLL_INTERVAL);
 
-          ptp_check_multicast_status(state);
+      for (i = 0; i < nports; i++)
+        {
+          ptp_process_port(&state[i], &pollfds[2 * i]);
+          ptp_periodic_send(&state[i]);
+          state[i].selected_source_valid =
+            is_selected_source_valid(&state[i]);
         }
 
-      ptp_periodic_send(state);
-
-      state->selected_source_valid = is_selected_source_valid(state);
       ptp_process_statusreq(state);
     }
 
-  ptp_destroy_state(state);
-  free(state);
+  ret = 0;
+
+errout:
+  for (i = 0; i < nports; i++)
+    {
+      ptp_destroy_state(&state[i]);
+    }
 
-  return 0;
+  free(state);
+  return ret;
 }
 
 /****************************************************************************
@@ -1507,13 +2790,53 @@ static int ptp_daemon(int argc, FAR char** argv)
  ****************************************************************************/
 
 int ptpd_start(FAR const char *interface)
+{
+  struct ptpd_config_s config;
+
+  memset(&config, 0, sizeof(config));
+  config.interface = interface;
+  return ptpd_start_config(&config);
+}
+
+/****************************************************************************
+ * Name: ptpd_start_config
+ *
+ * Description:
+ *   Start the PTP daemon with unicast or boundary clock options.
+ *
+ * Input Parameters:
+ *   config - Start options, only needed during the call
+ *
+ * Returned Value:
+ *   On success, the non-negative task ID of the PTP daemon is returned;
+ *   On failure, a negated errno value is returned.
+ *
+ ****************************************************************************/
+
+int ptpd_start_config(FAR const struct ptpd_config_s *config)
 {
   int pid;
   FAR char *task_argv[] = {
-    (FAR char *)interface,
+    (FAR char *)config->interface,
+    (FAR char *)(config->unicast_server ? config->unicast_server : ""),
+    (FAR char *)(config->master_port ? config->master_port : ""),
     NULL
   };
 
+#ifndef CONFIG_NETUTILS_PTPD_UNICAST
+  if (config->unicast_server != NULL)
+    {
+      return -ENOSYS;
+    }
+#endif
+
+#ifndef CONFIG_NETUTILS_PTPD_BOUNDARY
+  if (config->master_port != NULL)
+    {
+      return -ENOSYS;
+    }
+#endif
+
   pid = task_create("PTPD", CONFIG_NETUTILS_PTPD_SERVERPRIO,
     CONFIG_NETUTILS_PTPD_STACKSIZE, ptp_daemon, task_argv);
 
@@ -42,14 +42,29 @@
 
 #define PTP_MULTICAST_ADDR ((in_addr_t)0xE0000181)
 
+/* Multicast address for peer delay messages: 224.0.0.107 */
+
+#define PTP_PDELAY_MULTICAST_ADDR ((in_addr_t)0xE000006B)
+
 /* Message types */
 
 #define PTP_MSGTYPE_MASK       0x0F
 #define PTP_MSGTYPE_SYNC          0
 #define PTP_MSGTYPE_DELAY_REQ     1
+#define PTP_MSGTYPE_PDELAY_REQ    2
+#define PTP_MSGTYPE_PDELAY_RESP   3
 #define PTP_MSGTYPE_FOLLOW_UP     8
 #define PTP_MSGTYPE_DELAY_RESP    9
+#define PTP_MSGTYPE_PDELAY_RESP_FOLLOW_UP 10
 #define PTP_MSGTYPE_ANNOUNCE     11
+#define PTP_MSGTYPE_SIGNALING    12
+
+/* TLV types for unicast negotiation in signaling messages */
+
+#define PTP_TLV_REQUEST_UNICAST        0x0004
+#define PTP_TLV_GRANT_UNICAST          0x0005
+#define PTP_TLV_CANCEL_UNICAST         0x0006
+#define PTP_TLV_ACK_CANCEL_UNICAST     0x0007
 
 /* Message flags */
 
@@ -132,4 +147,63 @@ struct ptp_delay_resp_s
   uint8_t reqportindex[2];
 };
 
+/* PdelayReq: request peer delay measurement */
+
+struct ptp_pdelay_req_s
+{
+  struct ptp_header_s header;
+  uint8_t origintimestamp[10];
+  uint8_t reserved[10];
+};
+
+/* PdelayResp: response to PdelayReq with its receive timestamp */
+
+struct ptp_pdelay_resp_s
+{
+  struct ptp_header_s header;
+  uint8_t requestreceipttimestamp[10];
+  uint8_t reqidentity[8];
+  uint8_t reqportindex[2];
+};
+
+/* PdelayRespFollowUp: actual timestamp of when PdelayResp was sent */
+
+struct ptp_pdelay_resp_follow_up_s
+{
+  struct ptp_header_s header;
+  uint8_t responseorigintimestamp[10];
+  uint8_t reqidentity[8];
+  uint8_t reqportindex[2];
+};
+
+/* Unicast negotiation TLVs carried in signaling messages */
+
+struct ptp_tlv_header_s
+{
+  uint8_t type[2];
+  uint8_t length[2];               /* Length of the following value */
+};
+
+struct ptp_tlv_unicast_s
+{
+  struct ptp_tlv_header_s header;
+  uint8_t messagetype;             /* Message type in the upper nibble */
+  uint8_t logmessageinterval;
+  uint8_t duration[4];             /* Seconds, not in cancel TLVs */
+  uint8_t reserved;                /* Only in grant TLVs */
+  uint8_t renewal;                 /* Only in grant TLVs */
+};
+
+/* Signaling: header and target port followed by TLVs */
+
+#define PTP_SIGNALING_MAX_TLVS 3
+
+struct ptp_signaling_s
+{
+  struct ptp_header_s header;
+  uint8_t targetidentity[8];
+  uint8_t targetportindex[2];
+  uint8_t tlvs[PTP_SIGNALING_MAX_TLVS * sizeof(struct ptp_tlv_unicast_s)];
+};
+
 #endif /* __APPS_NETUTILS_PTPD_PTPV2_H */
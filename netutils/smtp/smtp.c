@@ -50,12 +50,16 @@
 #include <nuttx/config.h>
 
 #include <sys/socket.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <strings.h>
 #include <semaphore.h>
 
 #include <arpa/inet.h>
@@ -63,12 +67,27 @@
 #include <nuttx/net/ip.h>
 #include "netutils/smtp.h"
 
+#ifdef CONFIG_NETUTILS_SMTP_ATTACHMENT
+#  include "netutils/base64.h"
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
 #define SMTP_INPUT_BUFFER_SIZE 512
 
+/* An attachment is read by chunks of a multiple of 57 bytes, which encode
+ * into 76 characters lines.
+ */
+
+#define SMTP_ATTACH_LINE       57
+#define SMTP_ATTACH_CHUNK      (4 * SMTP_ATTACH_LINE)
+
+/* Separator of the MIME parts of a message with attachments */
+
+#define SMTP_BOUNDARY          "=_NuttX_smtp_part_"
+
 #define ISO_nl 0x0a
 #define ISO_cr 0x0d
 
@@ -88,8 +107,11 @@
 struct smtp_state
 {
   uint8_t      state;
-  bool         connected;
+  bool         connected;   /* smtp_connect() keeps the session open */
+  bool         pipelining;  /* The server advertised PIPELINING */
+  bool         broken;      /* The connection failed */
   sem_t        sem;
+  int          sockfd;      /* Socket of the session, -1 if none */
   in_addr_t    smtpserver;
   in_port_t    port;
   const char  *hostname;
@@ -102,178 +124,595 @@ struct smtp_state
   int          sentlen;
   int          textlen;
   int          sendptr;
+  size_t       txlen;       /* Commands in buffer not sent yet */
+  size_t       rxlen;       /* Replies in rxbuf not read yet */
+  unsigned int nreply;      /* Replies read in this transaction */
   char         buffer[SMTP_INPUT_BUFFER_SIZE];
+  char         rxbuf[SMTP_INPUT_BUFFER_SIZE];
 };
 
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
-static const char g_smtp220[]            = "220";
+static const char g_smtpcc[]             = "Cc: ";
 static const char g_smtpcrnlperiodcrnl[] = "\r\n.\r\n";
-static const char g_smtpdata[]           = "DATA\r\n";
+static const char g_smtpdata[]           = "DATA";
+static const char g_smtpehlo[]           = "EHLO ";
 static const char g_smtpfrom[]           = "From: ";
 static const char g_smtphelo[]           = "HELO ";
 static const char g_smtpmailfrom[]       = "MAIL FROM: ";
+static const char g_smtpperiodcrnl[]     = ".\r\n";
+static const char g_smtppipelining[]     = "PIPELINING";
 static const char g_smtpquit[]           = "QUIT\r\n";
 static const char g_smtprcptto[]         = "RCPT TO: ";
+static const char g_smtprset[]           = "RSET\r\n";
 static const char g_smtpsubject[]        = "Subject: ";
 static const char g_smtpto[]             = "To: ";
 
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
-static inline int smtp_send_message(int sockfd, struct smtp_state *psmtp)
+/****************************************************************************
+ * Name: smtp_write
+ *
+ * Description:
+ *   Send all of buf, marking the session broken on failure.
+ *
+ ****************************************************************************/
+
+static int smtp_write(FAR struct smtp_state *psmtp, FAR const void *buf,
+                      size_t len)
 {
-  if (recv(sockfd, psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, 0) < 0)
+  FAR const char *ptr = buf;
+  ssize_t nsent;
+
+  while (len > 0)
     {
-      return ERROR;
+      nsent = send(psmtp->sockfd, ptr, len, 0);
+      if (nsent < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          psmtp->broken = true;
+          return ERROR;
+        }
+
+      ptr += nsent;
+      len -= nsent;
     }
 
-  if (strncmp(psmtp->buffer, g_smtp220, strlen(g_smtp220)) != 0)
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smtp_flush
+ *
+ * Description:
+ *   Send the commands queued by smtp_queue().
+ *
+ ****************************************************************************/
+
+static int smtp_flush(FAR struct smtp_state *psmtp)
+{
+  size_t len = psmtp->txlen;
+
+  psmtp->txlen = 0;
+  return smtp_write(psmtp, psmtp->buffer, len);
+}
+
+/****************************************************************************
+ * Name: smtp_queue
+ *
+ * Description:
+ *   Queue the line "<cmd><arg>\r\n" in the send buffer.  The buffer is sent
+ *   first if the line does not fit.
+ *
+ ****************************************************************************/
+
+static int smtp_queue(FAR struct smtp_state *psmtp, FAR const char *cmd,
+                      FAR const char *arg)
+{
+  size_t avail;
+  int len;
+
+  for (; ; )
     {
-      return ERROR;
+      avail = SMTP_INPUT_BUFFER_SIZE - psmtp->txlen;
+      len = snprintf(&psmtp->buffer[psmtp->txlen], avail, "%s%s\r\n",
+                     cmd, arg != NULL ? arg : "");
+      if (len < (int)avail)
+        {
+          psmtp->txlen += len;
+          return OK;
+        }
+
+      if (psmtp->txlen == 0)
+        {
+          return ERROR;  /* Longer than the buffer */
+        }
+
+      if (smtp_flush(psmtp) < 0)
+        {
+          return ERROR;
+        }
     }
+}
+
+/****************************************************************************
+ * Name: smtp_reply
+ *
+ * Description:
+ *   Receive the next reply of the server, which may be made of several
+ *   lines and may arrive with the following replies when commands are
+ *   pipelined.  The lines of the reply to EHLO are checked for
+ *   PIPELINING.
+ *
+ * Returned Value:
+ *   The three digits reply code, or ERROR.
+ *
+ ****************************************************************************/
 
-  snprintf(psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, "%s%s\r\n",
-           g_smtphelo, psmtp->hostname);
-  if (send(sockfd, psmtp->buffer, strlen(psmtp->buffer), 0) < 0)
+static int smtp_reply(FAR struct smtp_state *psmtp, bool ehlo)
+{
+  FAR char *rx = psmtp->rxbuf;
+  FAR char *nl;
+  ssize_t nrecv;
+  size_t len;
+  bool skip = false;
+  bool last = false;
+  int code = ERROR;
+
+  for (; ; )
     {
-      return ERROR;
+      nl = memchr(rx, ISO_nl, psmtp->rxlen);
+      if (nl == NULL && psmtp->rxlen < SMTP_INPUT_BUFFER_SIZE)
+        {
+          nrecv = recv(psmtp->sockfd, rx + psmtp->rxlen,
+                       SMTP_INPUT_BUFFER_SIZE - psmtp->rxlen, 0);
+          if (nrecv <= 0)
+            {
+              if (nrecv < 0 && errno == EINTR)
+                {
+                  continue;
+                }
+
+              psmtp->broken = true;
+              return ERROR;
+            }
+
+          psmtp->rxlen += nrecv;
+          continue;
+        }
+
+      /* A whole line, or the start of a line longer than the buffer whose
+       * rest is skipped.
+       */
+
+      len = nl != NULL ? nl - rx + 1 : psmtp->rxlen;
+      if (!skip)
+        {
+          if (len < 3 || !isdigit(rx[0]) || !isdigit(rx[1]) ||
+              !isdigit(rx[2]))
+            {
+              psmtp->broken = true;
+              return ERROR;
+            }
+
+          code = (rx[0] - '0') * 100 + (rx[1] - '0') * 10 + rx[2] - '0';
+          psmtp->nreply++;
+          last = len < 4 || rx[3] != '-';
+
+          if (ehlo && len >= 4 + sizeof(g_smtppipelining) - 1 &&
+              strncasecmp(&rx[4], g_smtppipelining,
+                          sizeof(g_smtppipelining) - 1) == 0)
+            {
+              psmtp->pipelining = true;
+            }
+        }
+
+      skip = nl == NULL;
+      psmtp->rxlen -= len;
+      memmove(rx, rx + len, psmtp->rxlen);
+
+      if (last && !skip)
+        {
+          return code;
+        }
     }
+}
+
+/****************************************************************************
+ * Name: smtp_session_close
+ ****************************************************************************/
 
-  if (recv(sockfd, psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, 0) < 0)
+static void smtp_session_close(FAR struct smtp_state *psmtp)
+{
+  if (psmtp->sockfd >= 0)
     {
-      return ERROR;
+      if (!psmtp->broken)
+        {
+          smtp_write(psmtp, g_smtpquit, strlen(g_smtpquit));
+        }
+
+      close(psmtp->sockfd);
+      psmtp->sockfd = -1;
     }
+}
 
-  if (psmtp->buffer[0] != ISO_2)
+/****************************************************************************
+ * Name: smtp_session_open
+ *
+ * Description:
+ *   Connect to the server and greet it.  EHLO is tried first to learn
+ *   whether the server supports PIPELINING, then HELO.
+ *
+ ****************************************************************************/
+
+static int smtp_session_open(FAR struct smtp_state *psmtp)
+{
+  struct sockaddr_in server;
+  int code;
+
+  psmtp->broken     = false;
+  psmtp->pipelining = false;
+  psmtp->txlen      = 0;
+  psmtp->rxlen      = 0;
+
+  /* Create a socket */
+
+  psmtp->sockfd = socket(AF_INET, SOCK_STREAM, 0);
+  if (psmtp->sockfd < 0)
     {
       return ERROR;
     }
 
-  snprintf(psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, "%s%s\r\n",
-           g_smtpmailfrom, psmtp->from);
-  if (send(sockfd, psmtp->buffer, strlen(psmtp->buffer), 0) < 0)
+  /* Connect to server.  First we have to set some fields in the
+   * 'server' structure.  The system will assign me an arbitrary
+   * local port that is not in use.
+   */
+
+  server.sin_family = AF_INET;
+  net_ipv4addr_copy(server.sin_addr.s_addr, psmtp->smtpserver);
+  server.sin_port = psmtp->port;
+
+  if (connect(psmtp->sockfd, (FAR struct sockaddr *)&server,
+              sizeof(struct sockaddr_in)) < 0)
+    {
+      goto errout;
+    }
+
+  if (smtp_reply(psmtp, false) != 220)
     {
-      return ERROR;
+      goto errout;
     }
 
-  if (recv(sockfd, psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, 0) < 0)
+#ifdef CONFIG_NETUTILS_SMTP_PIPELINING
+  if (smtp_queue(psmtp, g_smtpehlo, psmtp->hostname) < 0 ||
+      smtp_flush(psmtp) < 0)
     {
-      return ERROR;
+      goto errout;
     }
 
-  if (psmtp->buffer[0] != ISO_2)
+  code = smtp_reply(psmtp, true);
+  if (code / 100 == 2)
     {
-      return ERROR;
+      return OK;
+    }
+  else if (code / 100 != 5)
+    {
+      goto errout;
     }
 
-  snprintf(psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, "%s%s\r\n",
-           g_smtprcptto, psmtp->to);
-  if (send(sockfd, psmtp->buffer, strlen(psmtp->buffer), 0) < 0)
+  /* The server does not know EHLO */
+#endif
+
+  if (smtp_queue(psmtp, g_smtphelo, psmtp->hostname) < 0 ||
+      smtp_flush(psmtp) < 0)
     {
-      return ERROR;
+      goto errout;
     }
 
-  if (recv(sockfd, psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, 0) < 0)
+  code = smtp_reply(psmtp, false);
+  if (code / 100 == 2)
     {
-      return ERROR;
+      return OK;
     }
 
-  if (psmtp->buffer[0] != ISO_2)
+errout:
+  psmtp->broken = true;
+  smtp_session_close(psmtp);
+  return ERROR;
+}
+
+#ifdef CONFIG_NETUTILS_SMTP_ATTACHMENT
+/****************************************************************************
+ * Name: smtp_send_attachment
+ *
+ * Description:
+ *   Send a file as a base64 encoded MIME part.  The file is read and
+ *   encoded by chunks, so that its size is not limited by the memory.
+ *
+ ****************************************************************************/
+
+static int smtp_send_attachment(FAR struct smtp_state *psmtp,
+                                FAR const struct smtp_attachment_s *attach)
+{
+  struct base64_context_s ctx;
+  uint8_t in[SMTP_ATTACH_CHUNK];
+  char enc[(SMTP_ATTACH_CHUNK + 2) / 3 * 4 + 4];
+  FAR const char *name;
+  FAR char *out = psmtp->buffer;
+  ssize_t nread;
+  size_t col = 0;
+  size_t outlen;
+  size_t enclen;
+  size_t i;
+  int ret = ERROR;
+  int fd;
+
+  fd = open(attach->path, O_RDONLY);
+  if (fd < 0)
     {
       return ERROR;
     }
 
-  if (psmtp->cc != 0)
+  name = attach->name;
+  if (name == NULL)
     {
-      snprintf(psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, "%s%s\r\n",
-               g_smtprcptto, psmtp->cc);
-      if (send(sockfd, psmtp->buffer, strlen(psmtp->buffer), 0) < 0)
+      name = strrchr(attach->path, '/');
+      name = name != NULL ? name + 1 : attach->path;
+    }
+
+  snprintf(out, SMTP_INPUT_BUFFER_SIZE,
+           "\r\n--" SMTP_BOUNDARY "\r\n"
+           "Content-Type: %s; name=\"%s\"\r\n"
+           "Content-Transfer-Encoding: base64\r\n"
+           "Content-Disposition: attachment; filename=\"%s\"\r\n\r\n",
+           attach->type != NULL ? attach->type : "application/octet-stream",
+           name, name);
+  if (smtp_write(psmtp, out, strlen(out)) < 0)
+    {
+      goto errout;
+    }
+
+  base64_encode_init(&ctx, false);
+
+  for (; ; )
+    {
+      nread = read(fd, in, sizeof(in));
+      if (nread < 0)
         {
-          return ERROR;
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          goto errout;
         }
 
-      if (recv(sockfd, psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, 0) < 0)
+      if (nread > 0)
         {
-          return ERROR;
+          enclen = base64_encode_update(&ctx, in, nread, enc);
+        }
+      else
+        {
+          enclen = base64_encode_final(&ctx, enc);
+        }
+
+      /* Break the output into lines of 76 characters */
+
+      for (i = 0, outlen = 0; i < enclen; i++)
+        {
+          out[outlen++] = enc[i];
+          if (++col == 4 * SMTP_ATTACH_LINE / 3)
+            {
+              out[outlen++] = ISO_cr;
+              out[outlen++] = ISO_nl;
+              col = 0;
+            }
         }
 
-      if (psmtp->buffer[0] != ISO_2)
+      if (nread == 0 && col > 0)
         {
-          return ERROR;
+          out[outlen++] = ISO_cr;
+          out[outlen++] = ISO_nl;
+        }
+
+      if (smtp_write(psmtp, out, outlen) < 0)
+        {
+          goto errout;
+        }
+
+      if (nread == 0)
+        {
+          break;
         }
     }
 
-  if (send(sockfd, g_smtpdata, strlen(g_smtpdata), 0) < 0)
+  ret = OK;
+
+errout:
+  close(fd);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: smtp_send_message
+ *
+ * Description:
+ *   Send one message on an open session.  MAIL, RCPT and DATA are sent
+ *   together when the server supports PIPELINING, saving two or three
+ *   round trips per message.
+ *
+ ****************************************************************************/
+
+static int smtp_send_message(FAR struct smtp_state *psmtp,
+                             FAR const struct smtp_attachment_s *attach,
+                             int nattach)
+{
+  FAR const char *cmds[4][2];
+  int ncmds = 0;
+  int first = 0;
+  int code = 0;
+  bool failed = false;
+  int i;
+  int j;
+
+  psmtp->nreply    = 0;
+
+  cmds[ncmds][0]   = g_smtpmailfrom;
+  cmds[ncmds++][1] = psmtp->from;
+  cmds[ncmds][0]   = g_smtprcptto;
+  cmds[ncmds++][1] = psmtp->to;
+
+  if (psmtp->cc != NULL)
     {
-      return ERROR;
+      cmds[ncmds][0]   = g_smtprcptto;
+      cmds[ncmds++][1] = psmtp->cc;
     }
 
-  if (recv(sockfd, psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, 0) < 0)
+  cmds[ncmds][0]   = g_smtpdata;
+  cmds[ncmds++][1] = NULL;
+
+  for (i = 0; i < ncmds; i++)
     {
-      return ERROR;
+      if (smtp_queue(psmtp, cmds[i][0], cmds[i][1]) < 0)
+        {
+          return ERROR;
+        }
+
+      if (psmtp->pipelining && i < ncmds - 1)
+        {
+          continue;
+        }
+
+      if (smtp_flush(psmtp) < 0)
+        {
+          return ERROR;
+        }
+
+      /* Collect the replies of all the commands sent, in order */
+
+      for (j = first; j <= i; j++)
+        {
+          code = smtp_reply(psmtp, false);
+          if (code < 0)
+            {
+              return ERROR;
+            }
+
+          if (code / 100 != (j == ncmds - 1 ? 3 : 2))
+            {
+              failed = true;
+            }
+        }
+
+      first = i + 1;
+      if (failed)
+        {
+          break;
+        }
     }
 
-  if (psmtp->buffer[0] != ISO_3)
+  if (failed)
     {
+      /* A pipelined DATA may have been accepted anyway: end the empty
+       * message, then forget the transaction so that the session can be
+       * reused.
+       */
+
+      if (code / 100 == 3 &&
+          (smtp_write(psmtp, g_smtpperiodcrnl,
+                      strlen(g_smtpperiodcrnl)) < 0 ||
+           smtp_reply(psmtp, false) < 0))
+        {
+          return ERROR;
+        }
+
+      if (smtp_write(psmtp, g_smtprset, strlen(g_smtprset)) == OK)
+        {
+          smtp_reply(psmtp, false);
+        }
+
       return ERROR;
     }
 
-  snprintf(psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, "%s%s\r\n",
-           g_smtpto, psmtp->to);
-  if (send(sockfd, psmtp->buffer, strlen(psmtp->buffer), 0) < 0)
+  /* The header */
+
+  if (smtp_queue(psmtp, g_smtpto, psmtp->to) < 0 ||
+      (psmtp->cc != NULL && smtp_queue(psmtp, g_smtpcc, psmtp->cc) < 0) ||
+      smtp_queue(psmtp, g_smtpfrom, psmtp->from) < 0 ||
+      smtp_queue(psmtp, g_smtpsubject, psmtp->subject) < 0)
     {
       return ERROR;
     }
 
-  if (psmtp->cc != 0)
+#ifdef CONFIG_NETUTILS_SMTP_ATTACHMENT
+  if (nattach > 0)
     {
-      snprintf(psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, "%s%s\r\n",
-               g_smtpto, psmtp->cc);
-      if (send(sockfd, psmtp->buffer, strlen(psmtp->buffer), 0) < 0)
+      if (smtp_queue(psmtp, "MIME-Version: 1.0", NULL) < 0 ||
+          smtp_queue(psmtp, "Content-Type: multipart/mixed; "
+                     "boundary=\"" SMTP_BOUNDARY "\"", NULL) < 0 ||
+          smtp_queue(psmtp, "", NULL) < 0 ||
+          smtp_queue(psmtp, "--" SMTP_BOUNDARY, NULL) < 0 ||
+          smtp_queue(psmtp, "Content-Type: text/plain", NULL) < 0)
         {
           return ERROR;
         }
     }
+#endif
 
-  snprintf(psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, "%s%s\r\n",
-           g_smtpfrom, psmtp->from);
-  if (send(sockfd, psmtp->buffer, strlen(psmtp->buffer), 0) < 0)
+  if (smtp_queue(psmtp, "", NULL) < 0 || smtp_flush(psmtp) < 0)
     {
       return ERROR;
     }
 
-  snprintf(psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, "%s%s\r\n\r\n",
-           g_smtpsubject, psmtp->subject);
-  if (send(sockfd, psmtp->buffer, strlen(psmtp->buffer), 0) < 0)
-    {
-      return ERROR;
-    }
+  /* The body */
 
-  if (send(sockfd, psmtp->msg, psmtp->msglen, 0) < 0)
+  if (smtp_write(psmtp, psmtp->msg, psmtp->msglen) < 0)
     {
       return ERROR;
     }
 
-  if (send(sockfd, g_smtpcrnlperiodcrnl, strlen(g_smtpcrnlperiodcrnl), 0) < 0)
+#ifdef CONFIG_NETUTILS_SMTP_ATTACHMENT
+  if (nattach > 0)
     {
-      return ERROR;
-    }
+      for (i = 0; i < nattach; i++)
+        {
+          if (smtp_send_attachment(psmtp, &attach[i]) < 0)
+            {
+              /* The message can not be ended without sending it
+               * incomplete.  Drop the session instead.
+               */
+
+              psmtp->broken = true;
+              return ERROR;
+            }
+        }
 
-  if (recv(sockfd, psmtp->buffer, SMTP_INPUT_BUFFER_SIZE, 0) < 0)
-    {
-      return ERROR;
+      if (smtp_write(psmtp, "\r\n--" SMTP_BOUNDARY "--",
+                     strlen("\r\n--" SMTP_BOUNDARY "--")) < 0)
+        {
+          return ERROR;
+        }
     }
+#endif
 
-  if (psmtp->buffer[0] != ISO_2)
+  if (smtp_write(psmtp, g_smtpcrnlperiodcrnl,
+                 strlen(g_smtpcrnlperiodcrnl)) < 0)
     {
       return ERROR;
     }
 
-  if (send(sockfd, g_smtpquit, strlen(g_smtpquit), 0) < 0)
+  code = smtp_reply(psmtp, false);
+  if (code / 100 != 2)
     {
       return ERROR;
     }
@@ -305,7 +744,35 @@ void smtp_configure(FAR void *handle, FAR const char *hostname,
   psmtp->port = *port;
 }
 
-/* Send an e-mail.
+/* Open a session with the server, which the following calls to smtp_send()
+ * use until smtp_disconnect() or smtp_close().  Without it, each message
+ * is sent on a session of its own.
+ */
+
+int smtp_connect(FAR void *handle)
+{
+  FAR struct smtp_state *psmtp = (FAR struct smtp_state *)handle;
+
+  if (psmtp->sockfd < 0 && smtp_session_open(psmtp) < 0)
+    {
+      return ERROR;
+    }
+
+  psmtp->connected = true;
+  return OK;
+}
+
+/* End the session opened by smtp_connect() */
+
+void smtp_disconnect(FAR void *handle)
+{
+  FAR struct smtp_state *psmtp = (FAR struct smtp_state *)handle;
+
+  psmtp->connected = false;
+  smtp_session_close(psmtp);
+}
+
+/* Send an e-mail with files attached.
  *
  *   to      - The e-mail address of the receiver of the e-mail.
  *   cc      - The e-mail address of the CC: receivers of the e-mail.
@@ -313,55 +780,83 @@ void smtp_configure(FAR void *handle, FAR const char *hostname,
  *   subject - The subject of the e-mail.
  *   msg     - The actual e-mail message.
  *   msglen  - The length of the e-mail message.
+ *   attach  - The files to attach, sent base64 encoded as they are read.
+ *   nattach - The number of files to attach.
  */
 
-int smtp_send(void *handle, const char *to, const char *cc, const char *from,
-              const char *subject, const char *msg, int msglen)
+int smtp_send_attachments(FAR void *handle, FAR const char *to,
+                          FAR const char *cc, FAR const char *from,
+                          FAR const char *subject, FAR const char *msg,
+                          int msglen,
+                          FAR const struct smtp_attachment_s *attach,
+                          int nattach)
 {
-  struct smtp_state *psmtp = (struct smtp_state *)handle;
-  struct sockaddr_in server;
-  int sockfd;
+  FAR struct smtp_state *psmtp = (FAR struct smtp_state *)handle;
+  bool reused;
   int ret;
 
-  /* Setup */
+#ifndef CONFIG_NETUTILS_SMTP_ATTACHMENT
+  if (nattach > 0)
+    {
+      return ERROR;
+    }
+#endif
 
-  psmtp->connected = true;
-  psmtp->to        = to;
-  psmtp->cc        = cc;
-  psmtp->from      = from;
-  psmtp->subject   = subject;
-  psmtp->msg       = msg;
-  psmtp->msglen    = msglen;
+  /* Setup */
 
-  /* Create a socket */
+  psmtp->to      = to;
+  psmtp->cc      = cc;
+  psmtp->from    = from;
+  psmtp->subject = subject;
+  psmtp->msg     = msg;
+  psmtp->msglen  = msglen;
 
-  sockfd = socket(AF_INET, SOCK_STREAM, 0);
-  if (sockfd < 0)
+  reused = psmtp->sockfd >= 0;
+  if (!reused && smtp_session_open(psmtp) < 0)
     {
       return ERROR;
     }
 
-  /* Connect to server.  First we have to set some fields in the
-   * 'server' structure.  The system will assign me an arbitrary
-   * local port that is not in use.
+  /* Send the message.  A session kept open may have been closed by the
+   * server in the meantime: if it failed before any reply, the message is
+   * sent again on a new one.
    */
 
-  server.sin_family = AF_INET;
-  net_ipv4addr_copy(server.sin_addr.s_addr, psmtp->smtpserver);
-  server.sin_port = psmtp->port;
+  ret = smtp_send_message(psmtp, attach, nattach);
+  if (ret < 0 && reused && psmtp->broken && psmtp->nreply == 0)
+    {
+      smtp_session_close(psmtp);
+      if (smtp_session_open(psmtp) < 0)
+        {
+          return ERROR;
+        }
+
+      ret = smtp_send_message(psmtp, attach, nattach);
+    }
 
-  if (connect(sockfd, (struct sockaddr *)&server, sizeof(struct sockaddr_in)) < 0)
+  if (!psmtp->connected || psmtp->broken)
     {
-      close(sockfd);
-      return ERROR;
+      smtp_session_close(psmtp);
     }
 
-  /* Send the message */
+  return ret;
+}
 
-  ret = smtp_send_message(sockfd, psmtp);
+/* Send an e-mail.
+ *
+ *   to      - The e-mail address of the receiver of the e-mail.
+ *   cc      - The e-mail address of the CC: receivers of the e-mail.
+ *   from    - The e-mail address of the sender of the e-mail.
+ *   subject - The subject of the e-mail.
+ *   msg     - The actual e-mail message.
+ *   msglen  - The length of the e-mail message.
+ */
 
-  close(sockfd);
-  return ret;
+int smtp_send(void *handle, const char *to, const char *cc, const char *from,
+              const char *subject, const char *msg, int msglen)
+{
+  return smtp_send_attachments(handle, to, cc, from, subject, msg, msglen,
+                               NULL, 0);
 }
 
 void *smtp_open(void)
@@ -375,6 +870,7 @@ void *smtp_open(void)
 
       memset(psmtp, 0, sizeof(struct smtp_state));
       sem_init(&psmtp->sem, 0, 0);
+      psmtp->sockfd = -1;
     }
 
   return (FAR void *)psmtp;
@@ -385,6 +881,7 @@ void smtp_close(void *handle)
   struct smtp_state *psmtp = (struct smtp_state *)handle;
   if (psmtp)
     {
+      smtp_session_close(psmtp);
       sem_destroy(&psmtp->sem);
       free(psmtp);
     }
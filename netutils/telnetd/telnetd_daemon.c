@@ -34,12 +34,284 @@
 #include <spawn.h>
 #include <errno.h>
 #include <debug.h>
+#include <limits.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <nuttx/net/telnet.h>
 
 #include "netutils/telnetd.h"
 #include "netutils/netlib.h"
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+/* The session task pool.  Accepted connections are queued by the path of
+ * their telnet driver and picked up by the first free session task.
+ */
+
+struct telnetd_pool_s
+{
+  main_t          session;   /* Session entry point */
+  sem_t           slots;     /* Free queue entries */
+  sem_t           items;     /* Queued connections */
+  pthread_mutex_t lock;      /* Protects the fields below */
+  bool            closing;   /* The daemon has stopped */
+  uint8_t         ntasks;    /* Running session tasks */
+  uint8_t         head;      /* Oldest queued connection */
+  uint8_t         count;     /* Number of queued connections */
+  char            queue[CONFIG_NETUTILS_TELNETD_POOL_BACKLOG]
+                       [TELNET_DEVPATH_MAX];
+};
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+/****************************************************************************
+ * Name: telnetd_pool_free
+ ****************************************************************************/
+
+static void telnetd_pool_free(FAR struct telnetd_pool_s *pool)
+{
+  pthread_mutex_destroy(&pool->lock);
+  sem_destroy(&pool->items);
+  sem_destroy(&pool->slots);
+  free(pool);
+}
+
+/****************************************************************************
+ * Name: telnetd_pool_exit
+ *
+ * Description:
+ *   on_exit() handler of a session task.  The daemon creates a new task
+ *   to replace it before accepting the next connection.
+ *
+ ****************************************************************************/
+
+static void telnetd_pool_exit(int status, FAR void *arg)
+{
+  FAR struct telnetd_pool_s *pool = arg;
+  bool last;
+
+  pthread_mutex_lock(&pool->lock);
+  last = --pool->ntasks == 0 && pool->closing;
+  pthread_mutex_unlock(&pool->lock);
+
+  if (last)
+    {
+      telnetd_pool_free(pool);
+    }
+}
+
+/****************************************************************************
+ * Name: telnetd_pool_task
+ *
+ * Description:
+ *   A pooled session task.  Runs the session of each connection taken from
+ *   the queue on stdin, stdout and stderr.
+ *
+ ****************************************************************************/
+
+static int telnetd_pool_task(int argc, FAR char *argv[])
+{
+  FAR struct telnetd_pool_s *pool =
+    (FAR struct telnetd_pool_s *)((uintptr_t)strtoul(argv[1], NULL, 16));
+  FAR char *sargv[2];
+  char devpath[TELNET_DEVPATH_MAX];
+  char cwd[PATH_MAX];
+  int drvrfd;
+
+  if (on_exit(telnetd_pool_exit, pool) != 0)
+    {
+      /* Without the handler the daemon could not replace this task */
+
+      return EXIT_FAILURE;
+    }
+
+  if (getcwd(cwd, sizeof(cwd)) == NULL)
+    {
+      strlcpy(cwd, "/", sizeof(cwd));
+    }
+
+  sargv[0] = argv[0];
+  sargv[1] = NULL;
+
+  for (; ; )
+    {
+      while (sem_wait(&pool->items) < 0)
+        {
+        }
+
+      pthread_mutex_lock(&pool->lock);
+      if (pool->count == 0)
+        {
+          /* Nothing queued: the daemon has stopped */
+
+          pthread_mutex_unlock(&pool->lock);
+          break;
+        }
+
+      strlcpy(devpath, pool->queue[pool->head], sizeof(devpath));
+      pool->head = (pool->head + 1) % CONFIG_NETUTILS_TELNETD_POOL_BACKLOG;
+      pool->count--;
+      pthread_mutex_unlock(&pool->lock);
+      sem_post(&pool->slots);
+
+      /* Use the driver as stdin, stdout, and stderror */
+
+      ninfo("Opening the telnet driver at %s\n", devpath);
+      drvrfd = open(devpath, O_RDWR);
+      if (drvrfd < 0)
+        {
+          nerr("ERROR: Failed to open %s: %d\n", devpath, errno);
+          continue;
+        }
+
+      dup2(drvrfd, 0);
+      dup2(drvrfd, 1);
+      dup2(drvrfd, 2);
+
+      if (drvrfd > 2)
+        {
+          close(drvrfd);
+        }
+
+      /* Run the session from the same directory every time */
+
+      chdir(cwd);
+      pool->session(1, sargv);
+
+      /* Closing the last reference releases the driver and the socket */
+
+      close(0);
+      close(1);
+      close(2);
+    }
+
+  return EXIT_SUCCESS;
+}
+
+/****************************************************************************
+ * Name: telnetd_pool_fill
+ *
+ * Description:
+ *   Create the missing session tasks.  Returns the number of running
+ *   session tasks.
+ *
+ ****************************************************************************/
+
+static int telnetd_pool_fill(FAR struct telnetd_pool_s *pool,
+                             FAR const struct telnetd_config_s *config)
+{
+  FAR char *argv[2];
+  char arg[2 * sizeof(uintptr_t) + 3];
+  int ntasks;
+
+  snprintf(arg, sizeof(arg), "%p", pool);
+  argv[0] = arg;
+  argv[1] = NULL;
+
+  pthread_mutex_lock(&pool->lock);
+  while (pool->ntasks < CONFIG_NETUTILS_TELNETD_POOL_SIZE)
+    {
+      pid_t pid = task_create("Telnet session",
+                              config->t_priority, config->t_stacksize,
+                              telnetd_pool_task, argv);
+      if (pid < 0)
+        {
+          nerr("ERROR: Failed to create a session task: %d\n", errno);
+          break;
+        }
+
+      pool->ntasks++;
+    }
+
+  ntasks = pool->ntasks;
+  pthread_mutex_unlock(&pool->lock);
+  return ntasks;
+}
+
+/****************************************************************************
+ * Name: telnetd_pool_create
+ ****************************************************************************/
+
+static FAR struct telnetd_pool_s *
+telnetd_pool_create(FAR const struct telnetd_config_s *config)
+{
+  FAR struct telnetd_pool_s *pool;
+
+  pool = zalloc(sizeof(struct telnetd_pool_s));
+  if (pool == NULL)
+    {
+      errno = ENOMEM;
+      return NULL;
+    }
+
+  pool->session = config->t_session;
+  sem_init(&pool->slots, 0, CONFIG_NETUTILS_TELNETD_POOL_BACKLOG);
+  sem_init(&pool->items, 0, 0);
+  pthread_mutex_init(&pool->lock, NULL);
+  return pool;
+}
+
+/****************************************************************************
+ * Name: telnetd_pool_stop
+ *
+ * Description:
+ *   Let the session tasks exit once the queued connections are served.
+ *   The last one frees the pool.
+ *
+ ****************************************************************************/
+
+static void telnetd_pool_stop(FAR struct telnetd_pool_s *pool)
+{
+  int i;
+
+  pthread_mutex_lock(&pool->lock);
+  if (pool->ntasks == 0)
+    {
+      pthread_mutex_unlock(&pool->lock);
+      telnetd_pool_free(pool);
+      return;
+    }
+
+  pool->closing = true;
+  for (i = 0; i < pool->ntasks; i++)
+    {
+      sem_post(&pool->items);
+    }
+
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/****************************************************************************
+ * Name: telnetd_pool_queue
+ ****************************************************************************/
+
+static void telnetd_pool_queue(FAR struct telnetd_pool_s *pool,
+                               FAR const char *devpath)
+{
+  int tail;
+
+  pthread_mutex_lock(&pool->lock);
+  tail = (pool->head + pool->count) % CONFIG_NETUTILS_TELNETD_POOL_BACKLOG;
+  strlcpy(pool->queue[tail], devpath, TELNET_DEVPATH_MAX);
+  pool->count++;
+  pthread_mutex_unlock(&pool->lock);
+  sem_post(&pool->items);
+}
+#endif /* CONFIG_NETUTILS_TELNETD_POOL */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -82,6 +354,10 @@ int telnetd_daemon(FAR const struct telnetd_config_s *config)
 #ifdef CONFIG_NET_SOCKOPTS
   int optval;
 #endif
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+  FAR struct telnetd_pool_s *pool = NULL;
+  bool slot = false;
+#endif
 
 #ifdef CONFIG_SCHED_HAVE_PARENT
   /* Call sigaction with the SA_NOCLDWAIT flag so that we do not transform
@@ -178,6 +454,18 @@ int telnetd_daemon(FAR const struct telnetd_config_s *config)
       goto errout_with_socket;
     }
 
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+  if (config->t_session != NULL)
+    {
+      pool = telnetd_pool_create(config);
+      if (pool == NULL)
+        {
+          nerr("ERROR: Failed to create the session pool\n");
+          goto errout_with_socket;
+        }
+    }
+#endif
+
   /* Begin accepting connections */
 
   for (; ; )
@@ -194,6 +482,28 @@ int telnetd_daemon(FAR const struct telnetd_config_s *config)
       close(1);
       close(2);
 
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+      if (pool != NULL && !slot)
+        {
+          /* Replace the session tasks that have exited, then wait for room
+           * in the queue.  Meanwhile new connections wait in the listen
+           * backlog.
+           */
+
+          if (telnetd_pool_fill(pool, config) == 0)
+            {
+              errno = ENOMEM;
+              goto errout_with_socket;
+            }
+
+          while (sem_wait(&pool->slots) < 0)
+            {
+            }
+
+          slot = true;
+        }
+#endif
+
       ninfo("Accepting connections on port %d\n", ntohs(config->d_port));
 
       addrlen = sizeof(addr);
@@ -254,6 +564,20 @@ int telnetd_daemon(FAR const struct telnetd_config_s *config)
 
       close(drvrfd);
 
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+      if (pool != NULL)
+        {
+          /* The driver holds its own reference to the socket.  Hand the
+           * driver over to the first free session task.
+           */
+
+          close(acceptsd);
+          telnetd_pool_queue(pool, session.ts_devpath);
+          slot = false;
+          continue;
+        }
+#endif
+
       /* Open the driver */
 
       ninfo("Opening the telnet driver at %s\n", session.ts_devpath);
@@ -328,6 +652,13 @@ errout_with_acceptsd:
   close(acceptsd);
 
 errout_with_socket:
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+  if (pool != NULL)
+    {
+      telnetd_pool_stop(pool);
+    }
+
+#endif
   close(listensd);
 errout:
   return errno;
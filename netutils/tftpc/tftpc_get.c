@@ -54,27 +54,44 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: tftp_parsedatapacket
+ * Name: tftp_sendrrq
+ *
+ * Description:
+ *   Send the read request to the well-known port.  The server answers from
+ *   the port it selected for the transfer, which is unknown until then.
+ *
  ****************************************************************************/
 
-static inline int tftp_parsedatapacket(FAR const uint8_t *packet,
-                                       FAR uint16_t *opcode,
-                                       FAR uint16_t *blockno)
+static int tftp_sendrrq(int sd, FAR uint8_t *packet,
+                        FAR struct sockaddr_in *server,
+                        FAR const char *remote, bool binary,
+                        FAR const struct tftp_options_s *opts)
 {
-  *opcode = (uint16_t)packet[0] << 8 | (uint16_t)packet[1];
-  if (*opcode == TFTP_DATA)
-    {
-      *blockno = (uint16_t)packet[2] << 8 | (uint16_t)packet[3];
-      return OK;
-    }
-#ifdef CONFIG_DEBUG_NET_WARN
-  else if (*opcode == TFTP_ERR)
-    {
-      tftp_parseerrpacket(packet);
-    }
-#endif
+  int len;
+  int ret;
+
+  len              = tftp_mkreqpacket(packet, TFTP_IOBUFSIZE, TFTP_RRQ,
+                                      remote, binary, opts);
+  server->sin_port = HTONS(CONFIG_NETUTILS_TFTP_PORT);
+  ret              = tftp_sendto(sd, packet, len, server);
+  server->sin_port = 0;
 
-  return ERROR;
+  return ret == len ? OK : ERROR;
+}
+
+/****************************************************************************
+ * Name: tftp_sendack
+ ****************************************************************************/
+
+static int tftp_sendack(int sd, uint16_t blockno,
+                        FAR struct sockaddr_in *server)
+{
+  uint8_t packet[TFTP_ACKHEADERSIZE];
+  int len;
+
+  ninfo("ACK blockno %d\n", blockno);
+  len = tftp_mkackpacket(packet, blockno);
+  return tftp_sendto(sd, packet, len, server) == len ? OK : ERROR;
 }
 
 /****************************************************************************
@@ -84,6 +101,13 @@ static inline int tftp_parsedatapacket(FAR const uint8_t *packet,
 /****************************************************************************
  * Name: tftpget_cb
  *
+ * Description:
+ *   Receive a file, negotiating the block size and the window size with
+ *   the server.  Blocks are ACKed once per window; when a block is lost
+ *   the last block received in order is ACKed so that the server resends
+ *   what follows it (RFC 7440).  Servers that do not know the options get
+ *   a plain RFC 1350 transfer.
+ *
  * Input Parameters:
  *   remote - The name of the file on the TFTP server.
  *   addr   - The IP address of the server in network order
@@ -97,19 +121,22 @@ static inline int tftp_parsedatapacket(FAR const uint8_t *packet,
 int tftpget_cb(FAR const char *remote, in_addr_t addr, bool binary,
                tftp_callback_t tftp_cb, FAR void *ctx)
 {
+  struct tftp_options_s opts; /* Requested, then negotiated options */
   struct sockaddr_in server;  /* The address of the TFTP server */
   struct sockaddr_in from;    /* The address the last UDP message recv'd from */
   FAR uint8_t *packet;        /* Allocated memory to hold one packet */
-  uint16_t blockno = 0;       /* The current transfer block number */
+  bool options;               /* Options are sent with the request */
+  bool resync = false;        /* Lost block reported, waiting for resend */
+  uint16_t blockno = 0;       /* The last block received in order */
   uint16_t opcode;            /* Received opcode */
   uint16_t rblockno;          /* Received block number */
   int len;                    /* Generic length */
   int sd;                     /* Socket descriptor for socket I/O */
-  int retry;                  /* Retry counter */
-  int nbytesrecvd = 0;        /* The number of bytes received in the packet */
+  int retry = 0;              /* Retry counter */
+  int inwindow = 0;           /* Blocks received since the last ACK */
+  int nbytesrecvd;            /* The number of bytes received in the packet */
   int ndatabytes;             /* The number of data bytes received */
   int result = ERROR;         /* Assume failure */
-  int ret;                    /* Generic return status */
 
   /* Allocate the buffer to used for socket/disk I/O */
 
@@ -129,122 +156,185 @@ int tftpget_cb(FAR const char *remote, in_addr_t addr, bool binary,
       goto errout;
     }
 
+  tftp_initoptions(&opts, true);
+  options = opts.blksize != TFTP_DEFBLKSIZE || opts.windowsize != 1;
+
+  if (tftp_sendrrq(sd, packet, &server, remote, binary,
+                   options ? &opts : NULL) < 0)
+    {
+      goto errout_with_sd;
+    }
+
   /* Then enter the transfer loop.  Loop until the entire file has
    * been received or until an error occurs.
    */
 
-  do
+  for (; ; )
     {
-      /* Increment the TFTP block number for the next transfer */
-
-      blockno++;
-
-      /* Send the next block if the file within a loop.  We will
-       * retry up to TFTP_RETRIES times before giving up on the
-       * transfer.
-       */
+      /* Get the next packet from the server */
 
-      for (retry = 0; retry < TFTP_RETRIES; retry++)
+      nbytesrecvd = tftp_recvfrom(sd, packet, TFTP_IOBUFSIZE, &from);
+      if (nbytesrecvd < 0)
         {
-          /* Send the read request using the well-known port number before
-           * receiving the first block.  Each retry of the first block will
-           * re-send the request.
+          if (++retry >= TFTP_RETRIES)
+            {
+              ninfo("Retry limit exceeded\n");
+              goto errout_with_sd;
+            }
+
+          /* Re-send the request until the server answers, then the ACK
+           * of the last block received in order.
            */
 
-          if (blockno == 1)
+          if (!server.sin_port)
             {
-              len             = tftp_mkreqpacket(packet, TFTP_IOBUFSIZE,
-                                                 TFTP_RRQ, remote, binary);
-              server.sin_port = HTONS(CONFIG_NETUTILS_TFTP_PORT);
-              ret             = tftp_sendto(sd, packet, len, &server);
-              if (ret != len)
-                {
-                  goto errout_with_sd;
-                }
-
-              /* Subsequent sendto will use the port number selected by the
-               * TFTP server in the DATA packet.  Setting the server port to
-               * zero here indicates that we have not yet received the server
-               * port number.
-               */
+              len = tftp_sendrrq(sd, packet, &server, remote, binary,
+                                 options ? &opts : NULL);
+            }
+          else
+            {
+              len = tftp_sendack(sd, blockno, &server);
+            }
 
-              server.sin_port = 0;
+          if (len < 0)
+            {
+              goto errout_with_sd;
             }
 
-          /* Get the next packet from the server */
+          inwindow = 0;
+          continue;
+        }
 
-          nbytesrecvd = tftp_recvfrom(sd, packet, TFTP_IOBUFSIZE, &from);
+      /* Verify the sender address and port number */
 
-          /* Check if anything valid was received */
+      if (server.sin_addr.s_addr != from.sin_addr.s_addr)
+        {
+          ninfo("Invalid address in DATA\n");
+          continue;
+        }
 
-          if (nbytesrecvd > 0)
-            {
-              /* Verify the sender address and port number */
+      if (server.sin_port && server.sin_port != from.sin_port)
+        {
+          ninfo("Invalid port in DATA\n");
+          len = tftp_mkerrpacket(packet, TFTP_ERR_UNKID,
+                                 TFTP_ERRST_UNKID);
+          tftp_sendto(sd, packet, len, &from);
+          continue;
+        }
 
-              if (server.sin_addr.s_addr != from.sin_addr.s_addr)
-                {
-                  ninfo("Invalid address in DATA\n");
-                  retry--;
-                  continue;
-                }
+      /* Parse the incoming packet */
 
-              if (server.sin_port && server.sin_port != from.sin_port)
-                {
-                  ninfo("Invalid port in DATA\n");
-                  len = tftp_mkerrpacket(packet, TFTP_ERR_UNKID,
-                                         TFTP_ERRST_UNKID);
-                  ret = tftp_sendto(sd, packet, len, &from);
-                  retry--;
-                  continue;
-                }
+      if (nbytesrecvd < TFTP_DATAHEADERSIZE)
+        {
+          /* Packet is not big enough to be parsed */
 
-              /* Parse the incoming DATA packet */
+          ninfo("Tiny data packet ignored\n");
+          continue;
+        }
 
-              if (nbytesrecvd < TFTP_DATAHEADERSIZE)
-                {
-                  /* Packet is not big enough to be parsed */
+      opcode   = (uint16_t)packet[0] << 8 | (uint16_t)packet[1];
+      rblockno = (uint16_t)packet[2] << 8 | (uint16_t)packet[3];
 
-                  ninfo("Tiny data packet ignored\n");
-                  continue;
-                }
+      if (opcode == TFTP_ERR)
+        {
+#ifdef CONFIG_DEBUG_NET_WARN
+          tftp_parseerrpacket(packet);
+#endif
 
-              if (tftp_parsedatapacket(packet, &opcode, &rblockno) != OK ||
-                  blockno != rblockno)
-                {
-                  /* Opcode is not TFTP_DATA or the block number is
-                   * unexpected.
-                   */
-
-                  ninfo("Parse failure\n");
-                  if (opcode > TFTP_MAXRFC1350)
-                    {
-                      len = tftp_mkerrpacket(packet, TFTP_ERR_ILLEGALOP,
-                                             TFTP_ERRST_ILLEGALOP);
-                      ret = tftp_sendto(sd, packet, len, &from);
-                    }
-
-                  continue;
-                }
+          /* Some old servers reject requests with options instead of
+           * ignoring them.  Try once more without.
+           */
+
+          if (server.sin_port || !options)
+            {
+              goto errout_with_sd;
+            }
+
+          nwarn("WARNING: Retrying without options\n");
+          options = false;
+          tftp_initoptions(&opts, false);
+          if (tftp_sendrrq(sd, packet, &server, remote, binary,
+                           NULL) < 0)
+            {
+              goto errout_with_sd;
+            }
+
+          continue;
+        }
 
-              /* Replace the server port to the one in the good response */
+      if (opcode == TFTP_OACK && blockno == 0)
+        {
+          /* The server accepted the options, ACK block 0 to start.  An
+           * OACK that comes again means that this ACK was lost.
+           */
 
-              if (!server.sin_port)
+          if (!server.sin_port)
+            {
+              if (!options ||
+                  tftp_parseoack(packet, nbytesrecvd, &opts) != OK)
                 {
-                  server.sin_port = from.sin_port;
+                  nerr("ERROR: Option negotiation failed\n");
+                  len = tftp_mkerrpacket(packet, TFTP_ERR_NEGOTIATE,
+                                         TFTP_ERRST_NEGOTIATE);
+                  tftp_sendto(sd, packet, len, &from);
+                  goto errout_with_sd;
                 }
 
-              /* Then break out of the loop */
+              ninfo("blksize %u windowsize %u\n",
+                    opts.blksize, opts.windowsize);
+              server.sin_port = from.sin_port;
+              retry           = 0;
+            }
+
+          if (tftp_sendack(sd, 0, &server) < 0)
+            {
+              goto errout_with_sd;
+            }
+
+          continue;
+        }
 
-              break;
+      if (opcode != TFTP_DATA)
+        {
+          ninfo("Parse failure\n");
+          if (opcode > TFTP_MAXRFC1350)
+            {
+              len = tftp_mkerrpacket(packet, TFTP_ERR_ILLEGALOP,
+                                     TFTP_ERRST_ILLEGALOP);
+              tftp_sendto(sd, packet, len, &from);
             }
+
+          continue;
         }
 
-      /* Did we exhaust all of the retries? */
+      if (!server.sin_port)
+        {
+          /* DATA without OACK, the server ignored the options */
+
+          tftp_initoptions(&opts, false);
+          server.sin_port = from.sin_port;
+        }
 
-      if (retry == TFTP_RETRIES)
+      if (rblockno != (uint16_t)(blockno + 1))
         {
-          ninfo("Retry limit exceeded\n");
-          goto errout_with_sd;
+          /* A duplicate means that our last ACK was lost, ACK it again
+           * when its block comes back.  A block after a gap means that
+           * one was lost: ACK the last block received in order once and
+           * ignore the rest of the window until the server resends.
+           */
+
+          if (rblockno == blockno ||
+              (!resync && (int16_t)(rblockno - blockno) > 0))
+            {
+              resync   = rblockno != blockno;
+              inwindow = 0;
+              if (tftp_sendack(sd, blockno, &server) < 0)
+                {
+                  goto errout_with_sd;
+                }
+            }
+
+          continue;
         }
 
       /* Write the received data chunk to the file */
@@ -257,18 +347,28 @@ int tftpget_cb(FAR const char *remote, in_addr_t addr, bool binary,
           goto errout_with_sd;
         }
 
-      /* Send the acknowledgment */
+      blockno++;
+      retry  = 0;
+      resync = false;
+
+      /* Send the acknowledgment at the end of each window and after the
+       * last block, which is the first one shorter than blksize.
+       */
 
-      len = tftp_mkackpacket(packet, blockno);
-      ret = tftp_sendto(sd, packet, len, &server);
-      if (ret != len)
+      if (++inwindow >= opts.windowsize || ndatabytes < opts.blksize)
         {
-          goto errout_with_sd;
+          inwindow = 0;
+          if (tftp_sendack(sd, blockno, &server) < 0)
+            {
+              goto errout_with_sd;
+            }
         }
 
-      ninfo("ACK blockno %d\n", blockno);
+      if (ndatabytes < opts.blksize)
+        {
+          break;
+        }
     }
-  while (ndatabytes >= TFTP_DATASIZE);
 
   /* Return success */
 
@@ -63,6 +63,18 @@
 #  define CONFIG_NETUTILS_TFTP_TIMEOUT 10 /* One second */
 #endif
 
+/* Block size requested with the blksize option (RFC 2348) */
+
+#ifndef CONFIG_NETUTILS_TFTP_BLKSIZE
+#  define CONFIG_NETUTILS_TFTP_BLKSIZE 512
+#endif
+
+/* Blocks sent per ACK requested with the windowsize option (RFC 7440) */
+
+#ifndef CONFIG_NETUTILS_TFTP_WINDOWSIZE
+#  define CONFIG_NETUTILS_TFTP_WINDOWSIZE 1
+#endif
+
 /* Dump received buffers */
 
 #undef CONFIG_NETUTILS_TFTP_DUMPBUFFERS
@@ -73,8 +85,9 @@
 #define TFTP_ERRHEADERSIZE    4
 #define TFTP_DATAHEADERSIZE   4
 
-/* The maximum size for TFTP data is determined by the configured UDP packet
- * payload size (UDP_MSS), but cannot exceed 512 + sizeof(TFTP_DATA header).
+/* RFC 1350 blocks are always 512 bytes.  Larger blocks may be negotiated
+ * with the blksize option, but a block must fit in one UDP packet payload
+ * (UDP_MSS) to avoid IP fragmentation.
  *
  * In the case where there are multiple network devices with different
  * link layer protocols, each network device may support a different UDP MSS
@@ -83,29 +96,35 @@
  * enabled interfaces, we (arbitrarily) select the minimum MSS.
  */
 
-#define TFTP_DATAHEADERSIZE   4
-#define TFTP_MAXPACKETSIZE    (TFTP_DATAHEADERSIZE+512)
+#define TFTP_DEFBLKSIZE       512
 
 #if defined(CONFIG_NET_ETHERNET)
-#  if ETH_UDP_MSS(IPv4_HDRLEN) < TFTP_MAXPACKETSIZE
-#    define TFTP_PACKETSIZE   ETH_UDP_MSS(IPv4_HDRLEN)
-#    ifdef CONFIG_CPP_HAVE_WARNING
-#      warning "Ethernet MSS is too small for TFTP"
-#    endif
-#  else
-#    define TFTP_PACKETSIZE   TFTP_MAXPACKETSIZE
-#  endif
-#elif MIN_UDP_MSS < TFTP_MAXPACKETSIZE
-#  define TFTP_PACKETSIZE     MIN_UDP_MSS
+#  define TFTP_UDP_MSS        ETH_UDP_MSS(IPv4_HDRLEN)
+#else
+#  define TFTP_UDP_MSS        MIN_UDP_MSS
+#endif
+
+#if TFTP_UDP_MSS < TFTP_DATAHEADERSIZE + TFTP_DEFBLKSIZE
 #  ifdef CONFIG_CPP_HAVE_WARNING
-#    warning "Minimum MSS is too small for TFTP"
+#    warning "UDP MSS is too small for TFTP"
 #  endif
+#endif
+
+#if TFTP_UDP_MSS < TFTP_DATAHEADERSIZE + CONFIG_NETUTILS_TFTP_BLKSIZE
+#  define TFTP_MAXBLKSIZE     (TFTP_UDP_MSS - TFTP_DATAHEADERSIZE)
 #else
-#  define TFTP_PACKETSIZE     TFTP_MAXPACKETSIZE
+#  define TFTP_MAXBLKSIZE     CONFIG_NETUTILS_TFTP_BLKSIZE
 #endif
 
-#define TFTP_DATASIZE         (TFTP_PACKETSIZE-TFTP_DATAHEADERSIZE)
-#define TFTP_IOBUFSIZE        (TFTP_PACKETSIZE+8)
+/* The I/O buffer holds the largest block that may be negotiated, or a
+ * RFC 1350 block if the server does not accept the option.
+ */
+
+#if TFTP_MAXBLKSIZE > TFTP_DEFBLKSIZE
+#  define TFTP_IOBUFSIZE      (TFTP_DATAHEADERSIZE + TFTP_MAXBLKSIZE + 8)
+#else
+#  define TFTP_IOBUFSIZE      (TFTP_DATAHEADERSIZE + TFTP_DEFBLKSIZE + 8)
+#endif
 
 /* TFTP Opcodes *************************************************************/
 
@@ -147,6 +166,14 @@
  * Public Type Definitions
  ****************************************************************************/
 
+/* Transfer options, RFC 2347 */
+
+struct tftp_options_s
+{
+  uint16_t blksize;     /* Data bytes per block (RFC 2348) */
+  uint16_t windowsize;  /* Blocks sent per ACK (RFC 7440) */
+};
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -158,8 +185,13 @@
 /* Defined in tftp_packet.c *************************************************/
 
 extern int tftp_sockinit(struct sockaddr_in *server, in_addr_t addr);
+extern void tftp_initoptions(FAR struct tftp_options_s *opts,
+                             bool negotiate);
 extern int tftp_mkreqpacket(uint8_t *buffer, size_t len, int opcode,
-                            const char *path, bool binary);
+                            const char *path, bool binary,
+                            FAR const struct tftp_options_s *opts);
+extern int tftp_parseoack(FAR const uint8_t *packet, size_t len,
+                          FAR struct tftp_options_s *opts);
 extern int tftp_mkackpacket(uint8_t *buffer, uint16_t blockno);
 extern int tftp_mkerrpacket(uint8_t *buffer, uint16_t errorcode,
                             const char *errormsg);
@@ -30,7 +30,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <errno.h>
 #include <debug.h>
 
@@ -105,6 +107,29 @@ int tftp_sockinit(struct sockaddr_in *server, in_addr_t addr)
   return sd;
 }
 
+/****************************************************************************
+ * Name: tftp_initoptions
+ *
+ * Description:
+ *   Set the options to the configured values to be negotiated, or to the
+ *   RFC 1350 values used when the server does not accept options.
+ *
+ ****************************************************************************/
+
+void tftp_initoptions(FAR struct tftp_options_s *opts, bool negotiate)
+{
+  if (negotiate)
+    {
+      opts->blksize    = TFTP_MAXBLKSIZE;
+      opts->windowsize = CONFIG_NETUTILS_TFTP_WINDOWSIZE;
+    }
+  else
+    {
+      opts->blksize    = TFTP_DEFBLKSIZE;
+      opts->windowsize = 1;
+    }
+}
+
 /****************************************************************************
  * Name: tftp_mkreqpacket
  *
@@ -117,13 +142,17 @@ int tftp_sockinit(struct sockaddr_in *server, in_addr_t addr)
  *     N bytes: mode
  *     1 byte:  0
  *
+ *   followed, if opts is not NULL, by a name and a value (both NUL
+ *   terminated strings) for each option that differs from RFC 1350.
+ *
  * Return
  *  Then number of bytes in the request packet (never fails)
  *
  ****************************************************************************/
 
 int tftp_mkreqpacket(uint8_t *buffer, size_t len, int opcode,
-                     const char *path, bool binary)
+                     const char *path, bool binary,
+                     FAR const struct tftp_options_s *opts)
 {
   int ret;
 
@@ -131,9 +160,96 @@ int tftp_mkreqpacket(uint8_t *buffer, size_t len, int opcode,
   buffer[1] = opcode & 0xff;
   ret = snprintf((char *)&buffer[2], len - 2, "%s%c%s", path, 0,
                  tftp_mode(binary)) + 3;
+
+  if (opts != NULL && opts->blksize != TFTP_DEFBLKSIZE && ret < len)
+    {
+      ret += snprintf((FAR char *)&buffer[ret], len - ret, "blksize%c%u",
+                      0, (unsigned int)opts->blksize) + 1;
+    }
+
+  if (opts != NULL && opts->windowsize != 1 && ret < len)
+    {
+      ret += snprintf((FAR char *)&buffer[ret], len - ret,
+                      "windowsize%c%u", 0,
+                      (unsigned int)opts->windowsize) + 1;
+    }
+
   return ret < len ? ret : len;
 }
 
+/****************************************************************************
+ * Name: tftp_parseoack
+ *
+ * Description:
+ *   OACK message format:
+ *
+ *     2 bytes: Opcode (network order == big-endian)
+ *     N bytes: Option name
+ *     1 byte:  0
+ *     N bytes: Option value
+ *     1 byte:  0
+ *     ...
+ *
+ *   On entry opts holds the requested values.  The server may only lower
+ *   them, options it does not acknowledge take their RFC 1350 value.
+ *
+ * Return
+ *   OK if the options were accepted, ERROR if the transfer must be
+ *   terminated with TFTP_ERR_NEGOTIATE.
+ *
+ ****************************************************************************/
+
+int tftp_parseoack(FAR const uint8_t *packet, size_t len,
+                   FAR struct tftp_options_s *opts)
+{
+  FAR const char *name = (FAR const char *)&packet[2];
+  FAR const char *end  = (FAR const char *)&packet[len];
+  FAR const char *value;
+  FAR const char *next;
+  struct tftp_options_s acked;
+  unsigned long num;
+
+  tftp_initoptions(&acked, false);
+
+  while (name < end)
+    {
+      value = memchr(name, '\0', end - name);
+      if (value == NULL)
+        {
+          return ERROR;
+        }
+
+      value++;
+      next = memchr(value, '\0', end - value);
+      if (next == NULL)
+        {
+          return ERROR;
+        }
+
+      num = strtoul(value, NULL, 10);
+      if (strcasecmp(name, "blksize") == 0 &&
+          num >= 8 && num <= opts->blksize)
+        {
+          acked.blksize = num;
+        }
+      else if (strcasecmp(name, "windowsize") == 0 &&
+               num >= 1 && num <= opts->windowsize)
+        {
+          acked.windowsize = num;
+        }
+      else
+        {
+          nwarn("WARNING: Bad option %s=%s\n", name, value);
+          return ERROR;
+        }
+
+      name = next + 1;
+    }
+
+  *opts = acked;
+  return OK;
+}
+
 /****************************************************************************
  * Name: tftp_mkackpacket
  *
@@ -63,22 +63,25 @@
  *
  *     2 bytes: Opcode (network order == big-endian)
  *     2 bytes: Block number (network order == big-endian)
- *     N bytes: Data (where N <= 512)
+ *     N bytes: Data (where N <= blksize)
  *
  * Input Parameters:
- *   fd      - File descriptor used to read from the file
  *   offset  - File offset to read from
  *   packet  - Buffer to write the data packet into
  *   blockno - The block number of the packet
+ *   blksize - The negotiated block size
+ *   tftp_cb - Callback used to read from the file
+ *   ctx     - Pointer passed to the callback
  *
  * Return Value:
- *   Number of bytes read into the packet. <TFTP_PACKETSIZE means end of
- *   file; <1 if an error occurs.
+ *   Number of bytes in the packet. Less than blksize plus the header
+ *   means end of file; <0 if an error occurs.
  *
  ****************************************************************************/
 
-int tftp_mkdatapacket(off_t offset, FAR uint8_t *packet, uint16_t blockno,
-                      tftp_callback_t tftp_cb, FAR void *ctx)
+static int tftp_mkdatapacket(off_t offset, FAR uint8_t *packet,
+                             uint16_t blockno, uint16_t blksize,
+                             tftp_callback_t tftp_cb, FAR void *ctx)
 {
   int nbytesread;
 
@@ -90,7 +93,7 @@ int tftp_mkdatapacket(off_t offset, FAR uint8_t *packet, uint16_t blockno,
   packet[3] = blockno & 0xff;
 
   nbytesread = tftp_cb(ctx, offset, &packet[TFTP_DATAHEADERSIZE],
-                       TFTP_DATASIZE);
+                       blksize);
   if (nbytesread < 0)
     {
       return ERROR;
@@ -108,21 +111,27 @@ int tftp_mkdatapacket(off_t offset, FAR uint8_t *packet, uint16_t blockno,
  *     2 bytes: Opcode (network order == big-endian)
  *     2 bytes: Block number (network order == big-endian)
  *
+ *   While waiting for the answer to a write request with options (opts
+ *   not NULL), an OACK is accepted too and its options are returned.
+ *
  * Input Parameters:
  *   sd      - Socket descriptor to use in in the transfer
  *   packet   - buffer to use for the transfers
  *   server  - The address of the server
  *   port    - The port number of the server (0 if not yet known)
  *   blockno - Location to return block number in the received ACK
+ *   opts    - Requested options on entry, negotiated options on return
  *
  * Returned Value:
- *   OK:success and blockno valid, ERROR:failure.
+ *   TFTP_ACK with blockno valid, TFTP_OACK with opts valid, TFTP_ERR if
+ *   the server sent an error or rejected the options, ERROR on timeout.
  *
  ****************************************************************************/
 
 static int tftp_rcvack(int sd, FAR uint8_t *packet,
                        FAR struct sockaddr_in *server, FAR uint16_t *port,
-                       FAR uint16_t *blockno)
+                       FAR uint16_t *blockno,
+                       FAR struct tftp_options_s *opts)
 {
   struct sockaddr_in from;     /* The address the last UDP msg recv'd from */
   ssize_t nbytes;              /* The number of bytes received. */
@@ -203,17 +212,34 @@ static int tftp_rcvack(int sd, FAR uint8_t *packet,
                * expected block number.
                */
 
-              if (opcode != TFTP_ACK)
+              if (opcode == TFTP_OACK && opts != NULL)
                 {
-                  nwarn("WARNING: Bad opcode\n");
-
-#ifdef CONFIG_DEBUG_NET_WARN
-                  if (opcode == TFTP_ERR)
+                  if (tftp_parseoack(packet, nbytes, opts) != OK)
                     {
-                      tftp_parseerrpacket(packet);
+                      packetlen = tftp_mkerrpacket(packet,
+                                                   TFTP_ERR_NEGOTIATE,
+                                                   TFTP_ERRST_NEGOTIATE);
+                      tftp_sendto(sd, packet, packetlen, server);
+                      return TFTP_ERR;
                     }
-                  else
+
+                  ninfo("blksize %u windowsize %u\n",
+                        opts->blksize, opts->windowsize);
+                  return TFTP_OACK;
+                }
+
+              if (opcode == TFTP_ERR)
+                {
+#ifdef CONFIG_DEBUG_NET_WARN
+                  tftp_parseerrpacket(packet);
 #endif
+                  return TFTP_ERR;
+                }
+
+              if (opcode != TFTP_ACK)
+                {
+                  nwarn("WARNING: Bad opcode\n");
+
                   if (opcode > TFTP_MAXRFC1350)
                     {
                       packetlen = tftp_mkerrpacket(packet,
@@ -231,7 +257,7 @@ static int tftp_rcvack(int sd, FAR uint8_t *packet,
 
               ninfo("Received ACK for block %d\n", rblockno);
               *blockno = rblockno;
-              return OK;
+              return TFTP_ACK;
             }
         }
     }
@@ -249,6 +275,13 @@ static int tftp_rcvack(int sd, FAR uint8_t *packet,
 /****************************************************************************
  * Name: tftpput_cb
  *
+ * Description:
+ *   Send a file, negotiating the block size and the window size with the
+ *   server.  A window of blocks is sent, then the next window starts after
+ *   the last block ACKed, so a window is resent from the first lost block
+ *   (RFC 7440).  Servers that do not know the options get a plain RFC 1350
+ *   transfer.
+ *
  * Input Parameters:
  *   remote - The name of the file on the TFTP server.
  *   addr   - The IP address of the server in network order
@@ -262,12 +295,17 @@ static int tftp_rcvack(int sd, FAR uint8_t *packet,
 int tftpput_cb(FAR const char *remote, in_addr_t addr, bool binary,
                tftp_callback_t cb, FAR void *ctx)
 {
+  struct tftp_options_s opts;        /* Requested, then negotiated options */
   struct sockaddr_in server;         /* The address of the TFTP server */
   FAR uint8_t *packet;               /* Allocated memory to hold one packet */
-  off_t offset;                      /* Offset into source file */
-  uint16_t blockno;                  /* The current transfer block number */
+  uint32_t acked = 0;                /* Blocks ACKed by the server */
+  uint32_t lastblock = UINT32_MAX;   /* Last block of the file, once read */
+  uint32_t blockno;                  /* The current transfer block number */
   uint16_t rblockno;                 /* The ACK'ed block number */
+  uint16_t delta;                    /* Blocks newly ACK'ed */
   uint16_t port = 0;                 /* This is the port nbr for the transfer */
+  uint16_t nsent;                    /* Blocks sent in the current window */
+  bool options;                      /* Options are sent with the request */
   int packetlen;                     /* The length of the data packet */
   int sd;                            /* Socket descriptor for socket I/O */
   int retry;                         /* Retry counter */
@@ -292,32 +330,63 @@ int tftpput_cb(FAR const char *remote, in_addr_t addr, bool binary,
       goto errout_with_packet;
     }
 
+  tftp_initoptions(&opts, true);
+  options = opts.blksize != TFTP_DEFBLKSIZE || opts.windowsize != 1;
+
   /* Send the write request using the well known port.  This may need
    * to be done several times because (1) UDP is inherenly unreliable
    * and packets may be lost normally, and (2) uIP has a nasty habit
    * of droppying packets if there is nothing hit in the ARP table.
    */
 
-  blockno = 1;
-  retry   = 0;
+  retry = 0;
   for (; ; )
     {
-      packetlen = tftp_mkreqpacket(packet, TFTP_IOBUFSIZE,
-                                   TFTP_WRQ, remote, binary);
+      server.sin_port = HTONS(CONFIG_NETUTILS_TFTP_PORT);
+      port            = 0;
+
+      packetlen = tftp_mkreqpacket(packet, TFTP_IOBUFSIZE, TFTP_WRQ,
+                                   remote, binary, options ? &opts : NULL);
       ret = tftp_sendto(sd, packet, packetlen, &server);
       if (ret != packetlen)
         {
           goto errout_with_sd;
         }
 
-      /* Receive the ACK for the write request */
+      /* Receive the OACK, or the ACK of block 0 if the server ignored
+       * the options.
+       */
 
-      if (tftp_rcvack(sd, packet, &server, &port, NULL) == 0)
+      ret = tftp_rcvack(sd, packet, &server, &port, &rblockno,
+                        options ? &opts : NULL);
+      if (ret == TFTP_OACK)
         {
           break;
         }
+      else if (ret == TFTP_ACK && rblockno == 0)
+        {
+          tftp_initoptions(&opts, false);
+          break;
+        }
+      else if (ret == TFTP_ERR)
+        {
+          /* Some old servers reject requests with options instead of
+           * ignoring them.  Try once more without.
+           */
+
+          if (!options)
+            {
+              goto errout_with_sd;
+            }
 
-      nwarn("WARNING: Re-sending request\n");
+          nwarn("WARNING: Retrying without options\n");
+          options = false;
+          tftp_initoptions(&opts, false);
+        }
+      else
+        {
+          nwarn("WARNING: Re-sending request\n");
+        }
 
       /* We are going to loop and re-send the request packet. Check the
        * retry count so that we do not loop forever.
@@ -331,62 +400,89 @@ int tftpput_cb(FAR const char *remote, in_addr_t addr, bool binary,
         }
     }
 
-  /* Then loop sending the entire file to the server in chunks */
+  /* Then loop sending the entire file to the server in windows of
+   * blocks.
+   */
 
-  offset     = 0;
-  retry      = 0;
+  retry = 0;
 
   for (; ; )
     {
-      /* Construct the next data packet */
+      /* Send the blocks that follow the last one ACK'ed, up to the window
+       * size or to the end of the file.
+       */
 
-      packetlen = tftp_mkdatapacket(offset, packet, blockno, cb, ctx);
-      if (packetlen < 0)
+      for (nsent = 0; nsent < opts.windowsize && acked + nsent < lastblock;
+           nsent++)
         {
-          goto errout_with_sd;
-        }
+          blockno   = acked + nsent + 1;
+          packetlen = tftp_mkdatapacket((off_t)(blockno - 1) * opts.blksize,
+                                        packet, blockno, opts.blksize,
+                                        cb, ctx);
+          if (packetlen < 0)
+            {
+              goto errout_with_sd;
+            }
 
-      /* Send the next data chunk */
+          if (packetlen < TFTP_DATAHEADERSIZE + opts.blksize)
+            {
+              lastblock = blockno;
+            }
 
-      ret = tftp_sendto(sd, packet, packetlen, &server);
-      if (ret != packetlen)
-        {
-          goto errout_with_sd;
+          ret = tftp_sendto(sd, packet, packetlen, &server);
+          if (ret != packetlen)
+            {
+              goto errout_with_sd;
+            }
         }
 
-      /* Check for an ACK for the data chunk */
+      /* Wait for an ACK of one of these blocks.  A duplicate ACK of the
+       * block before the window reports a lost block, the window is then
+       * sent again at once.  In lockstep transfers it is ignored instead,
+       * resending on it would double every block (Sorcerer's Apprentice).
+       */
 
-      if (tftp_rcvack(sd, packet, &server, &port, &rblockno) == OK)
+      delta = 0;
+      for (; ; )
         {
-          /* Check if the packet that we just sent was ACK'ed.  If not,
-           * we just loop to resend the same packet (same blockno, same
-           * file offset).
-           */
-
-          if (rblockno == blockno)
+          ret = tftp_rcvack(sd, packet, &server, &port, &rblockno, NULL);
+          if (ret != TFTP_ACK)
             {
-              /* Yes.. If we are at the end of the file and if all of the
-               * packets have been ACKed, then we are done.
-               */
+              break;
+            }
 
-              if (packetlen < TFTP_PACKETSIZE)
-                {
-                  break;
-                }
+          delta = rblockno - (uint16_t)acked;
+          if ((delta > 0 && delta <= nsent) ||
+              (delta == 0 && opts.windowsize > 1))
+            {
+              break;
+            }
 
-              /* Not the last block.. set up for the next block */
+          ninfo("Ignoring ACK for block %d\n", rblockno);
+        }
 
-              blockno += 1;
-              offset  += TFTP_DATASIZE;
-              retry    = 0;
+      if (ret == TFTP_ERR)
+        {
+          goto errout_with_sd;
+        }
 
-              /* Skip the retry test */
+      if (ret == TFTP_ACK && delta > 0)
+        {
+          /* If all of the packets of the file have been ACKed, then we are
+           * done.  Otherwise set up for the next window.
+           */
 
-              continue;
+          acked += delta;
+          if (acked == lastblock)
+            {
+              break;
             }
+
+          retry = 0;
+          continue;
         }
 
-      /* We are going to loop and re-send the data packet. Check the retry
+      /* We are going to loop and re-send the window. Check the retry
        * count so that we do not loop forever.
        */
 
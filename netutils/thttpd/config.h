@@ -198,6 +198,13 @@
 #    define CONFIG_THTTPD_OCCASIONAL_MSEC 120 /* Two minutes */
 #  endif
 
+/* Resolution of the timer wheel in milliseconds
+ */
+
+#  ifndef CONFIG_THTTPD_TIMER_TICK_MSEC
+#    define CONFIG_THTTPD_TIMER_TICK_MSEC 10
+#  endif
+
 /* How many seconds to allow for reading the initial request on a new
  * connection.
  */
@@ -43,6 +43,10 @@
 #include <nuttx/config.h>
 #include <stdint.h>
 
+#ifdef CONFIG_THTTPD_FDWATCH_EPOLL
+#  include <sys/epoll.h>
+#endif
+
 /****************************************************************************
  * Pre-Processor Definitions
  ****************************************************************************/
@@ -59,6 +63,35 @@
  * Public Types
  ****************************************************************************/
 
+#ifdef CONFIG_THTTPD_FDWATCH_EPOLL
+/* One registered descriptor.  The address of the slot is what is stored in
+ * the epoll_event data so that ready events map back to a slot in O(1).
+ */
+
+struct fdwatch_slot_s
+{
+  FAR struct fdwatch_slot_s *flink;   /* Next free slot */
+  FAR void                  *client;  /* Client data */
+  int                        fd;      /* Watched fd, -1 if free */
+  uint32_t                   revents; /* Events returned by the last wait */
+  uint32_t                   gen;     /* Wait generation of revents */
+};
+
+struct fdwatch_s
+{
+  FAR struct fdwatch_slot_s  *slots;    /* Slot storage (allocated) */
+  FAR struct fdwatch_slot_s  *freelist; /* List of unused slots */
+  FAR struct fdwatch_slot_s **fdmap;    /* fd -> slot map (allocated) */
+  FAR struct epoll_event     *events;   /* Ready events (allocated) */
+  int                         epfd;     /* The epoll instance */
+  int                         mapsize;  /* Number of entries in fdmap */
+  uint32_t                    gen;      /* Incremented on each wait */
+  uint8_t                     nfds;     /* Configured maximum number of fds */
+  uint8_t                     nwatched; /* Number of fds currently watched */
+  uint8_t                     nactive;  /* The number of ready events */
+  uint8_t                     next;     /* The index to the next ready event */
+};
+#else
 struct fdwatch_s
 {
   struct pollfd *pollfds;          /* Poll data (allocated) */
@@ -69,6 +102,7 @@ struct fdwatch_s
   uint8_t        nactive;          /* The number of fds with activity */
   uint8_t        next;             /* The index to the next client data */
 };
+#endif
 
 /****************************************************************************
  * Public Function Prototypes
@@ -102,7 +136,9 @@ extern int fdwatch(struct fdwatch_s *fw, long timeout_msecs);
 extern int fdwatch_check_fd(struct fdwatch_s *fw, int fd);
 
 /* Get the client data for the next returned event.  Returns -1 when there
- * are no more events.
+ * are no more events.  With the poll() engine every watched descriptor is
+ * returned and the caller must use fdwatch_check_fd(); with the epoll()
+ * engine only the descriptors that had activity are returned.
  */
 
 extern void *fdwatch_get_next_client_data(struct fdwatch_s *fw);
@@ -0,0 +1,406 @@
+/****************************************************************************
+ * apps/netutils/thttpd/fdwatch_epoll.c
+ * FD watcher routines for epoll()
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <debug.h>
+#include <poll.h>
+#include <sys/epoll.h>
+
+#include "config.h"
+#include "thttpd_alloc.h"
+#include "fdwatch.h"
+
+#ifdef CONFIG_THTTPD
+
+/****************************************************************************
+ * Pre-Processor Definitions
+ ****************************************************************************/
+
+/* Debug output from this file is normally suppressed.  If enabled, be aware
+ * that output to stdout will interfere with CGI programs.
+ */
+
+#ifdef CONFIG_THTTPD_FDWATCH_DEBUG
+#  define fwerr    nerr
+#  define fwinfo   ninfo
+#else
+#  define fwerr    _none
+#  define fwinfo   _none
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_THTTPD_FDWATCH_DEBUG
+static void fdwatch_dump(const char *msg, FAR struct fdwatch_s *fw)
+{
+  FAR struct fdwatch_slot_s *slot;
+  int i;
+
+  fwinfo("%s\n", msg);
+  fwinfo("nwatched: %d nfds: %d gen: %" PRIu32 "\n",
+         fw->nwatched, fw->nfds, fw->gen);
+
+  fwinfo("nactive: %d next: %d\n", fw->nactive, fw->next);
+  for (i = 0; i < fw->nactive; i++)
+    {
+      slot = (FAR struct fdwatch_slot_s *)fw->events[i].data.ptr;
+      fwinfo("%2d. fd: %d revents: %08" PRIx32 " client: %p\n",
+             i, slot->fd, slot->revents, slot->client);
+    }
+}
+#else
+#  define fdwatch_dump(m,f)
+#endif
+
+/* Return the slot that holds fd, or NULL if fd is not being watched */
+
+static inline FAR struct fdwatch_slot_s *
+fdwatch_slot(FAR struct fdwatch_s *fw, int fd)
+{
+  if (fd < 0 || fd >= fw->mapsize)
+    {
+      return NULL;
+    }
+
+  return fw->fdmap[fd];
+}
+
+/* Make sure that the fd -> slot map can hold fd.  Descriptor numbers are
+ * small and dense so the map only grows a few times over the life of the
+ * server.
+ */
+
+static int fdwatch_growmap(FAR struct fdwatch_s *fw, int fd)
+{
+  FAR struct fdwatch_slot_s **fdmap;
+  int mapsize;
+
+  if (fd < fw->mapsize)
+    {
+      return OK;
+    }
+
+  mapsize = fw->mapsize;
+  while (mapsize <= fd)
+    {
+      mapsize <<= 1;
+    }
+
+  fdmap = RENEW(fw->fdmap, FAR struct fdwatch_slot_s *,
+                fw->mapsize, mapsize);
+  if (!fdmap)
+    {
+      fwerr("ERROR: Failed to grow fd map to %d\n", mapsize);
+      return -ENOMEM;
+    }
+
+  memset(&fdmap[fw->mapsize], 0,
+         sizeof(FAR struct fdwatch_slot_s *) * (mapsize - fw->mapsize));
+
+  fw->fdmap   = fdmap;
+  fw->mapsize = mapsize;
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* Initialize the fdwatch data structures.  Returns -1 on failure. */
+
+struct fdwatch_s *fdwatch_initialize(int nfds)
+{
+  FAR struct fdwatch_s *fw;
+  int i;
+
+  /* Allocate the fdwatch data structure */
+
+  fw = (struct fdwatch_s *)zalloc(sizeof(struct fdwatch_s));
+  if (!fw)
+    {
+      fwerr("ERROR: Failed to allocate fdwatch\n");
+      return NULL;
+    }
+
+  /* Initialize the fdwatch data structures. */
+
+  fw->nfds = nfds;
+
+  fw->epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (fw->epfd < 0)
+    {
+      fwerr("ERROR: epoll_create1 failed: %d\n", errno);
+      httpd_free(fw);
+      return NULL;
+    }
+
+  fw->slots = (FAR struct fdwatch_slot_s *)
+    httpd_malloc(sizeof(struct fdwatch_slot_s) * nfds);
+  if (!fw->slots)
+    {
+      goto errout_with_allocations;
+    }
+
+  fw->events = (FAR struct epoll_event *)
+    httpd_malloc(sizeof(struct epoll_event) * nfds);
+  if (!fw->events)
+    {
+      goto errout_with_allocations;
+    }
+
+  /* Start with a map sized for the configured number of descriptors plus
+   * stdin/stdout/stderr.  It will be grown if larger fd numbers show up.
+   */
+
+  fw->mapsize = nfds + 3;
+  fw->fdmap   = (FAR struct fdwatch_slot_s **)
+    zalloc(sizeof(FAR struct fdwatch_slot_s *) * fw->mapsize);
+  if (!fw->fdmap)
+    {
+      goto errout_with_allocations;
+    }
+
+  /* Put all slots in the free list */
+
+  for (i = 0; i < nfds; i++)
+    {
+      fw->slots[i].fd     = -1;
+      fw->slots[i].client = NULL;
+      fw->slots[i].gen    = 0;
+      fw->slots[i].flink  = (i + 1 < nfds) ? &fw->slots[i + 1] : NULL;
+    }
+
+  fw->freelist = fw->slots;
+
+  fdwatch_dump("Initial state:", fw);
+  return fw;
+
+errout_with_allocations:
+  fdwatch_uninitialize(fw);
+  return NULL;
+}
+
+/* Uninitialize the fwdatch data structure */
+
+void fdwatch_uninitialize(struct fdwatch_s *fw)
+{
+  if (fw)
+    {
+      fdwatch_dump("Uninitializing:", fw);
+      if (fw->epfd >= 0)
+        {
+          close(fw->epfd);
+        }
+
+      if (fw->slots)
+        {
+          httpd_free(fw->slots);
+        }
+
+      if (fw->events)
+        {
+          httpd_free(fw->events);
+        }
+
+      if (fw->fdmap)
+        {
+          httpd_free(fw->fdmap);
+        }
+
+      httpd_free(fw);
+    }
+}
+
+/* Add a descriptor to the watch list. */
+
+void fdwatch_add_fd(struct fdwatch_s *fw, int fd, void *client_data)
+{
+  FAR struct fdwatch_slot_s *slot;
+  struct epoll_event ev;
+
+  fwinfo("fd: %d client_data: %p\n", fd, client_data);
+
+  slot = fw->freelist;
+  if (!slot)
+    {
+      fwerr("ERROR: too many fds\n");
+      return;
+    }
+
+  if (fdwatch_growmap(fw, fd) < 0)
+    {
+      return;
+    }
+
+  /* A recycled slot must not report the events of its previous owner if
+   * the previous owner was removed while the ready list was being walked.
+   */
+
+  slot->fd      = fd;
+  slot->client  = client_data;
+  slot->revents = 0;
+  slot->gen     = 0;
+
+  ev.events   = EPOLLIN;
+  ev.data.ptr = slot;
+  if (epoll_ctl(fw->epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+      fwerr("ERROR: EPOLL_CTL_ADD fd %d failed: %d\n", fd, errno);
+      slot->fd = -1;
+      return;
+    }
+
+  fw->freelist  = slot->flink;
+  slot->flink   = NULL;
+  fw->fdmap[fd] = slot;
+  fw->nwatched++;
+}
+
+/* Remove a descriptor from the watch list. */
+
+void fdwatch_del_fd(struct fdwatch_s *fw, int fd)
+{
+  FAR struct fdwatch_slot_s *slot;
+
+  fwinfo("fd: %d\n", fd);
+
+  slot = fdwatch_slot(fw, fd);
+  if (!slot)
+    {
+      fwerr("ERROR: No slot for fd %d\n", fd);
+      return;
+    }
+
+  epoll_ctl(fw->epfd, EPOLL_CTL_DEL, fd, NULL);
+
+  /* The slot may still be referenced from the current ready list.  Marking
+   * it free is enough for fdwatch_get_next_client_data() to skip it.
+   */
+
+  fw->fdmap[fd] = NULL;
+  slot->fd      = -1;
+  slot->client  = NULL;
+  slot->gen     = 0;
+  slot->flink   = fw->freelist;
+  fw->freelist  = slot;
+  fw->nwatched--;
+}
+
+/* Do the watch.  Return value is the number of descriptors that are ready,
+ * or 0 if the timeout expired, or -1 on errors.  A timeout of INFTIM means
+ * wait indefinitely.
+ */
+
+int fdwatch(struct fdwatch_s *fw, long timeout_msecs)
+{
+  FAR struct fdwatch_slot_s *slot;
+  int ret;
+  int i;
+
+  fwinfo("Waiting... (timeout %ld)\n", timeout_msecs);
+  fw->nactive = 0;
+  fw->next    = 0;
+
+  /* A new generation invalidates all revents recorded by the previous
+   * wait without having to touch every slot.  Zero is reserved for
+   * "never ready".
+   */
+
+  if (++fw->gen == 0)
+    {
+      fw->gen = 1;
+    }
+
+  ret = epoll_wait(fw->epfd, fw->events, fw->nfds, (int)timeout_msecs);
+  fwinfo("Awakened: %d\n", ret);
+
+  /* Record the returned events in the slots so that fdwatch_check_fd() can
+   * answer without searching the ready list.
+   */
+
+  for (i = 0; i < ret; i++)
+    {
+      slot          = (FAR struct fdwatch_slot_s *)fw->events[i].data.ptr;
+      slot->revents = fw->events[i].events;
+      slot->gen     = fw->gen;
+    }
+
+  if (ret > 0)
+    {
+      fw->nactive = ret;
+    }
+
+  fdwatch_dump("After wakeup:", fw);
+  return ret;
+}
+
+/* Check if a descriptor was ready. */
+
+int fdwatch_check_fd(struct fdwatch_s *fw, int fd)
+{
+  FAR struct fdwatch_slot_s *slot;
+
+  fwinfo("fd: %d\n", fd);
+
+  slot = fdwatch_slot(fw, fd);
+  if (slot && slot->gen == fw->gen && (slot->revents & EPOLLERR) == 0)
+    {
+      return slot->revents & (EPOLLIN | EPOLLHUP | POLLNVAL);
+    }
+
+  return 0;
+}
+
+void *fdwatch_get_next_client_data(struct fdwatch_s *fw)
+{
+  FAR struct fdwatch_slot_s *slot;
+
+  /* Only walk the ready list.  Skip events whose slot was released (or
+   * released and reused) since the wait returned.
+   */
+
+  while (fw->next < fw->nactive)
+    {
+      slot = (FAR struct fdwatch_slot_s *)fw->events[fw->next++].data.ptr;
+      if (slot->fd >= 0 && slot->gen == fw->gen)
+        {
+          fwinfo("client_data[%d]: %p\n", fw->next - 1, slot->client);
+          return slot->client;
+        }
+    }
+
+  fwinfo("All client data returned: %d\n", fw->next);
+  return (void *)(uintptr_t)-1;
+}
+
+#endif /* CONFIG_THTTPD */
@@ -71,6 +71,7 @@
 #include "thttpd_strings.h"
 #include "thttpd_cgi.h"
 #include "tdate_parse.h"
+#include "thttpd_filecache.h"
 #include "fdwatch.h"
 
 #ifdef CONFIG_THTTPD
@@ -153,6 +154,10 @@ static char *bufgets(httpd_conn *hc);
 static void de_dotdot(char *file);
 static void init_mime(void);
 static void figure_mime(httpd_conn *hc);
+#ifdef CONFIG_THTTPD_GZIP_STATIC
+static bool accepts_gzip(const char *accepte);
+static void figure_gzip(httpd_conn *hc);
+#endif
 #ifdef CONFIG_THTTPD_GENERATE_INDICES
 static void ls_child(int argc, char **argv);
 static int  ls(httpd_conn *hc);
@@ -376,6 +381,13 @@ static void send_mime(httpd_conn *hc, int status, const char *title,
           add_response(hc, buf);
         }
 
+#ifdef CONFIG_THTTPD_GZIP_STATIC
+      if (hc->gzipped)
+        {
+          add_response(hc, "Vary: Accept-Encoding\r\n");
+        }
+#endif
+
       if (partial_content)
         {
           snprintf(buf, sizeof(buf), "Content-Range: bytes %ld-%ld/%ld\r\n",
@@ -1577,6 +1589,75 @@ done:
     }
 }
 
+#ifdef CONFIG_THTTPD_GZIP_STATIC
+/* Check whether an Accept-Encoding list allows gzip, which it doesn't if
+ * it is absent or has a quality value of zero.
+ */
+
+static bool accepts_gzip(const char *accepte)
+{
+  const char *cp = accepte;
+  size_t len;
+
+  while (*cp != '\0')
+    {
+      cp += strspn(cp, " \t,");
+      len = strcspn(cp, " \t,;");
+      if (len == 4 && strncasecmp(cp, "gzip", 4) == 0)
+        {
+          cp += len;
+          cp += strspn(cp, " \t");
+          if (*cp != ';')
+            {
+              return true;
+            }
+
+          cp++;
+          cp += strspn(cp, " \t");
+          return strncasecmp(cp, "q=", 2) != 0 || strtod(cp + 2, NULL) > 0;
+        }
+
+      cp += len;
+      cp += strcspn(cp, ",");
+    }
+
+  return false;
+}
+
+/* Serve the precompressed file name.gz in place of name if the client
+ * accepts gzip and name.gz is at least as recent as name.  figure_mime()
+ * then derives the type from name and the encoding from .gz.
+ */
+
+static void figure_gzip(httpd_conn *hc)
+{
+  struct stat sb;
+  size_t len;
+
+  hc->gzipped = false;
+  len = strlen(hc->expnfilename);
+  if ((len > 3 && strcasecmp(&hc->expnfilename[len - 3], ".gz") == 0) ||
+      !accepts_gzip(hc->accepte))
+    {
+      return;
+    }
+
+  httpd_realloc_str(&hc->expnfilename, &hc->maxexpnfilename, len + 3);
+  strlcpy(&hc->expnfilename[len], ".gz", hc->maxexpnfilename + 1 - len);
+
+  if (stat(hc->expnfilename, &sb) == 0 && S_ISREG(sb.st_mode) &&
+      (sb.st_mode & S_IROTH) != 0 && (sb.st_mode & S_IXOTH) == 0 &&
+      sb.st_mtime >= hc->sb.st_mtime)
+    {
+      hc->sb      = sb;
+      hc->gzipped = true;
+      return;
+    }
+
+  hc->expnfilename[len] = '\0';
+}
+#endif
+
 /* qsort comparison routine. */
 
 #ifdef CONFIG_THTTPD_GENERATE_INDICES
@@ -2187,6 +2268,9 @@ void httpd_terminate(httpd_server * hs)
 {
   httpd_unlisten(hs);
   free_httpd_server(hs);
+#ifdef CONFIG_THTTPD_FILECACHE
+  httpd_fcache_flush();
+#endif
 }
 
 void httpd_unlisten(httpd_server * hs)
@@ -2400,6 +2484,10 @@ int httpd_get_conn(httpd_server *hs, int listen_fd, httpd_conn *hc)
   hc->accepte[0]        = '\0';
   hc->acceptl           = "";
   hc->cookie            = "";
+#ifdef CONFIG_THTTPD_FILECACHE
+  hc->ifnonematch       = "";
+  hc->fcentry           = NULL;
+#endif
   hc->contenttype       = "";
   hc->reqhost[0]        = '\0';
   hc->hdrhost           = "";
@@ -2426,6 +2514,9 @@ int httpd_get_conn(httpd_server *hs, int listen_fd, httpd_conn *hc)
   hc->range_end         = -1;
   hc->keep_alive        = false;
   hc->should_linger     = false;
+#ifdef CONFIG_THTTPD_GZIP_STATIC
+  hc->gzipped           = false;
+#endif
   hc->file_fd           = -1;
 
   ninfo("New connection accepted on %d\n", hc->conn_fd);
@@ -2921,6 +3012,14 @@ int httpd_parse_request(httpd_conn *hc)
                   nerr("ERROR: unparsable time: %s\n", cp);
                 }
             }
+#ifdef CONFIG_THTTPD_FILECACHE
+          else if (strncasecmp(buf, "If-None-Match:", 14) == 0)
+            {
+              cp = &buf[14];
+              cp += strspn(cp, " \t");
+              hc->ifnonematch = cp;
+            }
+#endif
           else if (strncasecmp(buf, "Cookie:", 7) == 0)
             {
               cp = &buf[7];
@@ -3174,6 +3273,14 @@ void httpd_close_conn(httpd_conn *hc)
       hc->file_fd = -1;
     }
 
+#ifdef CONFIG_THTTPD_FILECACHE
+  if (hc->fcentry != NULL)
+    {
+      httpd_fcache_put(hc->fcentry);
+      hc->fcentry = NULL;
+    }
+#endif
+
   if (hc->conn_fd >= 0)
     {
       close(hc->conn_fd);
@@ -3496,6 +3603,10 @@ int httpd_start_request(httpd_conn *hc, struct timeval *nowp)
       return -1;
     }
 
+#ifdef CONFIG_THTTPD_GZIP_STATIC
+  figure_gzip(hc);
+#endif
+
   /* Fill in range_end, if necessary. */
 
   if (hc->got_range &&
@@ -3506,6 +3617,42 @@ int httpd_start_request(httpd_conn *hc, struct timeval *nowp)
 
   figure_mime(hc);
 
+#ifdef CONFIG_THTTPD_FILECACHE
+  /* Small files are served from the cache.  The ETag header only depends
+   * on the file, so it is precomputed in the cache entry.
+   */
+
+  if (hc->method == METHOD_GET)
+    {
+      hc->fcentry = httpd_fcache_get(hc->expnfilename, &hc->sb);
+    }
+
+  if (hc->fcentry != NULL)
+    {
+      FAR const char *etag = &hc->fcentry->etaghdr[6];
+      size_t etaglen = strlen(etag) - 2;
+
+      if (strncmp(hc->ifnonematch, etag, etaglen) == 0 ||
+          (hc->if_modified_since != (time_t) - 1 &&
+           hc->if_modified_since >= hc->sb.st_mtime))
+        {
+          send_mime(hc, 304, err304title, hc->encodings,
+                    hc->fcentry->etaghdr, hc->type, (off_t) - 1,
+                    hc->sb.st_mtime);
+          httpd_fcache_put(hc->fcentry);
+          hc->fcentry = NULL;
+        }
+      else
+        {
+          send_mime(hc, 200, ok200title, hc->encodings,
+                    hc->fcentry->etaghdr, hc->type, hc->sb.st_size,
+                    hc->sb.st_mtime);
+        }
+
+      return 0;
+    }
+#endif
+
   if (hc->method == METHOD_HEAD)
     {
       send_mime(hc, 200, ok200title, hc->encodings, "", hc->type,
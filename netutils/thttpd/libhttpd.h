@@ -198,6 +198,9 @@ typedef struct
   char *accepte;
   char *acceptl;
   char *cookie;
+#ifdef CONFIG_THTTPD_FILECACHE
+  char *ifnonematch;           /* not malloc()ed */
+#endif
   char *contenttype;
   char *reqhost;
   char *hdrhost;
@@ -233,11 +236,17 @@ typedef struct
   bool tildemapped;            /* this connection got tilde-mapped */
   bool keep_alive;
   bool should_linger;
+#ifdef CONFIG_THTTPD_GZIP_STATIC
+  bool gzipped;                /* serving the precompressed .gz file */
+#endif
   int conn_fd;                 /* Connection to the client */
   int file_fd;                 /* Descriptor for open, outgoing file */
   off_t range_start;           /* File range start from Range= */
   off_t range_end;             /* File range end from Range= */
   struct stat sb;
+#ifdef CONFIG_THTTPD_FILECACHE
+  FAR struct httpd_fcentry_s *fcentry; /* Cached file being sent, if any */
+#endif
 
   /* This is the I/O buffer that is used to buffer portions of
    * outgoing files
@@ -56,6 +56,10 @@
 
 #include <arpa/inet.h>
 
+#ifdef CONFIG_THTTPD_SENDFILE
+#  include <sys/sendfile.h>
+#endif
+
 #include <nuttx/compiler.h>
 #include "netutils/thttpd.h"
 
@@ -64,6 +68,7 @@
 #include "libhttpd.h"
 #include "thttpd_alloc.h"
 #include "thttpd_strings.h"
+#include "thttpd_filecache.h"
 #include "timers.h"
 
 #ifdef CONFIG_THTTPD
@@ -170,6 +175,10 @@ static void shut_down(void)
 
   tmr_destroy();
   httpd_free(connects);
+#ifdef CONFIG_THTTPD_SLAB
+  httpd_memstats();
+  httpd_slab_uninitialize();
+#endif
 }
 
 static int handle_newconnect(FAR struct timeval *tv, int listen_fd)
@@ -205,7 +214,11 @@ static int handle_newconnect(FAR struct timeval *tv, int listen_fd)
 
       if (!conn->hc)
         {
+#ifdef CONFIG_THTTPD_SLAB
+          conn->hc = (FAR httpd_conn *)httpd_slab_conn();
+#else
           conn->hc = NEW(httpd_conn, 1);
+#endif
           if (conn->hc == NULL)
             {
               nerr("ERROR: out of memory allocating an httpd_conn\n");
@@ -355,6 +368,22 @@ static void handle_read(struct connect_s *conn, struct timeval *tv)
         }
     }
 
+#ifdef CONFIG_THTTPD_FILECACHE
+  /* A file served from the cache needs no file descriptor */
+
+  if (hc->fcentry != NULL)
+    {
+      if (conn->offset >= conn->end_offset)
+        {
+          goto errout_with_connection;
+        }
+
+      conn->conn_state = CNST_SENDING;
+      fdwatch_del_fd(fw, hc->conn_fd);
+      return;
+    }
+#endif
+
   /* Check if it's already handled */
 
   if (hc->file_fd < 0)
@@ -422,12 +451,123 @@ static inline int read_buffer(struct connect_s *conn)
   return nread;
 }
 
+#if defined(CONFIG_THTTPD_SENDFILE) || defined(CONFIG_THTTPD_FILECACHE)
+/* Send the response headers that send_mime() left in the I/O buffer when
+ * the body does not go through that buffer.
+ */
+
+static inline int send_headers(httpd_conn *hc)
+{
+  int nwritten = 0;
+
+  if (hc->buflen > 0)
+    {
+      nwritten = httpd_write(hc->conn_fd, hc->buffer, hc->buflen);
+      hc->buflen = 0;
+    }
+
+  return nwritten;
+}
+#endif
+
+#ifdef CONFIG_THTTPD_FILECACHE
+/* Send the requested range of a cached file straight from memory */
+
+static inline int send_cached(struct connect_s *conn, struct timeval *tv)
+{
+  httpd_conn *hc = conn->hc;
+  int nwritten;
+
+  nwritten = httpd_write(hc->conn_fd, &hc->fcentry->data[conn->offset],
+                         conn->end_offset - conn->offset);
+  if (nwritten > 0)
+    {
+      conn->active_at  = tv->tv_sec;
+      conn->offset    += nwritten;
+      hc->bytes_sent  += nwritten;
+    }
+
+  return nwritten;
+}
+#endif
+
+#ifdef CONFIG_THTTPD_SENDFILE
+/* Let the kernel move file data to the socket without copying it through
+ * user space.  sendfile() advances conn->offset itself.
+ */
+
+static inline int send_file(struct connect_s *conn, struct timeval *tv)
+{
+  httpd_conn *hc = conn->hc;
+  off_t start = conn->offset;
+  ssize_t nsent;
+
+  while (conn->offset < conn->end_offset)
+    {
+      nsent = sendfile(hc->conn_fd, hc->file_fd, &conn->offset,
+                       conn->end_offset - conn->offset);
+      if (nsent < 0)
+        {
+          if (errno == EINTR || errno == EAGAIN)
+            {
+              continue;
+            }
+
+          return nsent;
+        }
+      else if (nsent == 0)
+        {
+          /* The file is shorter than expected */
+
+          conn->end_offset = conn->offset;
+          conn->eof        = true;
+        }
+
+      conn->active_at = tv->tv_sec;
+    }
+
+  hc->bytes_sent += conn->offset - start;
+  ninfo("Sent %jd bytes\n", (intmax_t)(conn->offset - start));
+  return OK;
+}
+#endif
+
 static void handle_send(struct connect_s *conn, struct timeval *tv)
 {
   httpd_conn *hc = conn->hc;
   int nwritten;
   int nread;
 
+#if defined(CONFIG_THTTPD_SENDFILE) || defined(CONFIG_THTTPD_FILECACHE)
+  if (send_headers(hc) < 0)
+    {
+      nerr("ERROR: Error sending headers for %s: %d\n",
+           hc->encodedurl, errno);
+      goto errout_clear_connection;
+    }
+#endif
+
+#ifdef CONFIG_THTTPD_FILECACHE
+  if (hc->fcentry != NULL)
+    {
+      if (send_cached(conn, tv) < 0)
+        {
+          nerr("ERROR: Error sending %s: %d\n", hc->encodedurl, errno);
+          goto errout_clear_connection;
+        }
+
+      goto done;
+    }
+#endif
+
+#ifdef CONFIG_THTTPD_SENDFILE
+  if (send_file(conn, tv) < 0)
+    {
+      nerr("ERROR: Error sending %s: %d\n", hc->encodedurl, errno);
+      goto errout_clear_connection;
+    }
+#endif
+
   /* Read until the entire file is sent -- this could take awhile!! */
 
   while (conn->offset < conn->end_offset)
@@ -481,6 +621,9 @@ static void handle_send(struct connect_s *conn, struct timeval *tv)
 
   /* The file transfer is complete -- finish the connection */
 
+#ifdef CONFIG_THTTPD_FILECACHE
+done:
+#endif
   ninfo("Finish connection\n");
   finish_connection(conn, tv);
   return;
@@ -643,6 +786,9 @@ static void linger_clear_connection(ClientData client_data,
 static void occasional(ClientData client_data, struct timeval *nowp)
 {
   tmr_cleanup();
+#ifdef CONFIG_THTTPD_SLAB
+  httpd_memstats();
+#endif
 }
 
 /****************************************************************************
@@ -689,6 +835,16 @@ int thttpd_main(int argc, char **argv)
   sa.sin_addr.s_addr = HTONL(CONFIG_THTTPD_IPADDR);
 #endif
 
+#ifdef CONFIG_THTTPD_SLAB
+  /* Set up the memory pools before anything else allocates */
+
+  if (httpd_slab_initialize(sizeof(httpd_conn)) < 0)
+    {
+      nerr("ERROR: memory pool initialization failure\n");
+      exit(1);
+    }
+#endif
+
   /* Initialize the fdwatch package to handle all of the configured
    * socket descriptors
    */
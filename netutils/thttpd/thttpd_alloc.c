@@ -26,7 +26,10 @@
 
 #include <sys/param.h>
 #include <sys/types.h>
+#include <inttypes.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <malloc.h>
 #include <debug.h>
 #include <errno.h>
@@ -36,6 +39,41 @@
 
 #ifdef CONFIG_THTTPD
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_THTTPD_SLAB
+/* Pool indices.  The string classes must stay sorted by block size. */
+
+#  define SLAB_CONN        0
+#  define SLAB_SMALL       1
+#  define SLAB_MEDIUM      2
+#  define SLAB_LARGE       3
+#  define SLAB_NPOOLS      4
+
+#  define SLAB_ALIGN(n)    (((n) + sizeof(uintptr_t) - 1) & \
+                            ~(sizeof(uintptr_t) - 1))
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_THTTPD_SLAB
+struct httpd_slab_s
+{
+  FAR void    *freelist;  /* Singly linked list of free blocks */
+  FAR uint8_t *base;      /* First block of the pool */
+  FAR uint8_t *end;       /* One past the last block of the pool */
+  size_t       blksize;   /* Size of one block */
+  uint16_t     nblocks;   /* Number of blocks in the pool */
+  uint16_t     nused;     /* Blocks currently allocated */
+  uint16_t     hiwater;   /* Largest value of nused so far */
+  uint32_t     nfallback; /* Requests for this class served by the heap */
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -46,17 +84,76 @@ static int    g_nfreed       = 0;
 static size_t g_allocated    = 0;
 #endif
 
+#ifdef CONFIG_THTTPD_SLAB
+static struct httpd_slab_s g_slabs[SLAB_NPOOLS];
+static FAR uint8_t *g_slabheap;     /* The one allocation backing all pools */
+static uint32_t     g_slaboversize; /* Requests larger than any class */
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+#ifdef CONFIG_THTTPD_SLAB
+/* Return the pool that ptr was allocated from, or NULL for heap memory */
+
+static FAR struct httpd_slab_s *slab_lookup(FAR const void *ptr)
+{
+  FAR const uint8_t *addr = (FAR const uint8_t *)ptr;
+  int i;
+
+  for (i = 0; i < SLAB_NPOOLS; i++)
+    {
+      if (addr >= g_slabs[i].base && addr < g_slabs[i].end)
+        {
+          return &g_slabs[i];
+        }
+    }
+
+  return NULL;
+}
+
+static FAR void *slab_take(FAR struct httpd_slab_s *slab)
+{
+  FAR void *blk = slab->freelist;
+
+  if (blk != NULL)
+    {
+      slab->freelist = *(FAR void **)blk;
+      if (++slab->nused > slab->hiwater)
+        {
+          slab->hiwater = slab->nused;
+        }
+    }
+
+  return blk;
+}
+
+static void slab_give(FAR struct httpd_slab_s *slab, FAR void *blk)
+{
+  *(FAR void **)blk = slab->freelist;
+  slab->freelist    = blk;
+  slab->nused--;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
 /* Generate debugging statistics */
 
-#ifdef CONFIG_THTTPD_MEMDEBUG
+#if defined(CONFIG_THTTPD_MEMDEBUG) || defined(CONFIG_THTTPD_SLAB)
 void httpd_memstats(void)
 {
+#ifdef CONFIG_THTTPD_MEMDEBUG
   static struct mallinfo mm;
+#endif
+#ifdef CONFIG_THTTPD_SLAB
+  int i;
+#endif
 
+#ifdef CONFIG_THTTPD_MEMDEBUG
   ninfo("%d allocations (%lu bytes), %d freed\n",
        g_nallocations, (unsigned long)g_allocated, g_nfreed);
 
@@ -67,12 +164,141 @@ void httpd_memstats(void)
   ninfo("arena: %08x ordblks: %08x mxordblk: %08x uordblks: %08x "
         "fordblks: %08x\n",
        mm.arena, mm.ordblks, mm.mxordblk, mm.uordblks, mm.fordblks);
+#endif
+
+#ifdef CONFIG_THTTPD_SLAB
+  for (i = 0; i < SLAB_NPOOLS; i++)
+    {
+      ninfo("pool %d: blksize %zu used %u/%u hiwater %u fallback %"
+            PRIu32 "\n", i, g_slabs[i].blksize, g_slabs[i].nused,
+            g_slabs[i].nblocks, g_slabs[i].hiwater, g_slabs[i].nfallback);
+    }
+
+  ninfo("oversize requests: %" PRIu32 "\n", g_slaboversize);
+#endif
 }
 #endif
 
-/****************************************************************************
- * Public Functions
- ****************************************************************************/
+#ifdef CONFIG_THTTPD_SLAB
+int httpd_slab_initialize(size_t connsize)
+{
+  static const uint16_t nblocks[SLAB_NPOOLS] =
+  {
+    CONFIG_THTTPD_SLAB_NCONN,
+    CONFIG_THTTPD_SLAB_SMALL_COUNT,
+    CONFIG_THTTPD_SLAB_MEDIUM_COUNT,
+    CONFIG_THTTPD_SLAB_LARGE_COUNT
+  };
+
+  FAR uint8_t *blk;
+  size_t total = 0;
+  int i;
+  int j;
+
+  g_slabs[SLAB_CONN].blksize   = SLAB_ALIGN(connsize);
+  g_slabs[SLAB_SMALL].blksize  = SLAB_ALIGN(CONFIG_THTTPD_SLAB_SMALL_SIZE);
+  g_slabs[SLAB_MEDIUM].blksize = SLAB_ALIGN(CONFIG_THTTPD_SLAB_MEDIUM_SIZE);
+  g_slabs[SLAB_LARGE].blksize  = SLAB_ALIGN(CONFIG_THTTPD_SLAB_LARGE_SIZE);
+
+  for (i = 0; i < SLAB_NPOOLS; i++)
+    {
+      g_slabs[i].nblocks = nblocks[i];
+      total += g_slabs[i].blksize * nblocks[i];
+    }
+
+  g_slabheap = malloc(total);
+  if (g_slabheap == NULL)
+    {
+      nerr("ERROR: Failed to allocate %zu bytes of pools\n", total);
+      return -ENOMEM;
+    }
+
+  /* Carve the allocation into pools and thread each pool's free list */
+
+  blk = g_slabheap;
+  for (i = 0; i < SLAB_NPOOLS; i++)
+    {
+      FAR struct httpd_slab_s *slab = &g_slabs[i];
+
+      slab->base     = blk;
+      slab->freelist = NULL;
+      slab->nused    = slab->nblocks;
+
+      for (j = 0; j < slab->nblocks; j++)
+        {
+          slab_give(slab, blk);
+          blk += slab->blksize;
+        }
+
+      slab->end       = blk;
+      slab->hiwater   = 0;
+      slab->nfallback = 0;
+    }
+
+  ninfo("%zu bytes of pools at %p\n", total, g_slabheap);
+  return OK;
+}
+
+void httpd_slab_uninitialize(void)
+{
+  free(g_slabheap);
+  g_slabheap = NULL;
+  memset(g_slabs, 0, sizeof(g_slabs));
+}
+
+FAR void *httpd_slab_conn(void)
+{
+  FAR struct httpd_slab_s *slab = &g_slabs[SLAB_CONN];
+  FAR void *blk;
+
+  blk = slab_take(slab);
+  if (blk == NULL)
+    {
+      slab->nfallback++;
+      blk = httpd_malloc(slab->blksize);
+    }
+
+  return blk;
+}
+
+FAR void *httpd_slab_alloc(size_t nbytes)
+{
+  FAR struct httpd_slab_s *slab;
+  FAR void *blk;
+  int i;
+
+  for (i = SLAB_SMALL; i < SLAB_NPOOLS; i++)
+    {
+      slab = &g_slabs[i];
+      if (nbytes <= slab->blksize)
+        {
+          blk = slab_take(slab);
+          if (blk != NULL)
+            {
+              return blk;
+            }
+
+          /* Exhausted.  Try the next larger class before the heap. */
+
+          slab->nfallback++;
+        }
+    }
+
+  if (nbytes > g_slabs[SLAB_LARGE].blksize)
+    {
+      g_slaboversize++;
+    }
+
+  return httpd_malloc(nbytes);
+}
+
+size_t httpd_slab_blksize(FAR const void *ptr)
+{
+  FAR struct httpd_slab_s *slab = slab_lookup(ptr);
+
+  return slab != NULL ? slab->blksize : 0;
+}
+#endif /* CONFIG_THTTPD_SLAB */
 
 #ifdef CONFIG_THTTPD_MEMDEBUG
 FAR void *httpd_malloc(size_t nbytes)
@@ -94,10 +320,36 @@ FAR void *httpd_malloc(size_t nbytes)
 }
 #endif
 
-#ifdef CONFIG_THTTPD_MEMDEBUG
+#if defined(CONFIG_THTTPD_MEMDEBUG) || defined(CONFIG_THTTPD_SLAB)
 FAR void *httpd_realloc(FAR void *oldptr, size_t oldsize, size_t newsize)
 {
-  void *ptr = realloc(oldptr, newsize);
+  void *ptr;
+
+#ifdef CONFIG_THTTPD_SLAB
+  FAR struct httpd_slab_s *slab = slab_lookup(oldptr);
+
+  if (slab != NULL)
+    {
+      /* Pool blocks cannot be resized in place unless they already fit */
+
+      if (newsize <= slab->blksize)
+        {
+          return oldptr;
+        }
+
+      ptr = httpd_slab_alloc(newsize);
+      if (ptr != NULL)
+        {
+          memcpy(ptr, oldptr, MIN(oldsize, slab->blksize));
+          slab_give(slab, oldptr);
+        }
+
+      return ptr;
+    }
+#endif
+
+  ptr = realloc(oldptr, newsize);
+#ifdef CONFIG_THTTPD_MEMDEBUG
   if (!ptr)
     {
       nerr("ERROR: Re-allocation from %d to %d bytes failed\n",
@@ -111,17 +363,28 @@ FAR void *httpd_realloc(FAR void *oldptr, size_t oldsize, size_t newsize)
     }
 
   httpd_memstats();
+#endif
   return ptr;
 }
-#endif
 
-#ifdef CONFIG_THTTPD_MEMDEBUG
 void httpd_free(FAR void *ptr)
 {
+#ifdef CONFIG_THTTPD_SLAB
+  FAR struct httpd_slab_s *slab = slab_lookup(ptr);
+
+  if (slab != NULL)
+    {
+      slab_give(slab, ptr);
+      return;
+    }
+#endif
+
   free(ptr);
+#ifdef CONFIG_THTTPD_MEMDEBUG
   g_nfreed++;
   ninfo("Freed memory at %p\n", ptr);
   httpd_memstats();
+#endif
 }
 #endif
 
@@ -150,11 +413,19 @@ FAR char *httpd_strdup(const char *str)
 void httpd_realloc_str(char **pstr, size_t *maxsize, size_t size)
 {
   size_t oldsize;
+#ifdef CONFIG_THTTPD_SLAB
+  size_t blksize;
+#endif
+
   if (*maxsize == 0)
     {
       *maxsize = MAX(CONFIG_THTTPD_MINSTRSIZE,
                      size + CONFIG_THTTPD_REALLOCINCR);
+#ifdef CONFIG_THTTPD_SLAB
+      *pstr    = httpd_slab_alloc(*maxsize + 1);
+#else
       *pstr    = NEW(char, *maxsize + 1);
+#endif
     }
   else if (size > *maxsize)
     {
@@ -167,6 +438,16 @@ void httpd_realloc_str(char **pstr, size_t *maxsize, size_t size)
       return;
     }
 
+#ifdef CONFIG_THTTPD_SLAB
+  /* Use all of the block so that later growth is less likely */
+
+  blksize = *pstr ? httpd_slab_blksize(*pstr) : 0;
+  if (blksize > *maxsize + 1)
+    {
+      *maxsize = blksize - 1;
+    }
+#endif
+
   if (!*pstr)
     {
       nerr("ERROR: out of memory reallocating a string to %d bytes\n",
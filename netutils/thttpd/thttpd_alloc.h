@@ -55,14 +55,36 @@
 
 #ifdef CONFIG_THTTPD_MEMDEBUG
 extern FAR void *httpd_malloc(size_t nbytes);
-extern FAR void *httpd_realloc(FAR void *oldptr, size_t oldsize, size_t newsize);
-extern void      httpd_free(FAR void *ptr);
 extern FAR char *httpd_strdup(const char *str);
 #else
 #  define httpd_malloc(n)      malloc(n)
+#  define httpd_strdup(s)      strdup(s)
+#endif
+
+#if defined(CONFIG_THTTPD_MEMDEBUG) || defined(CONFIG_THTTPD_SLAB)
+extern FAR void *httpd_realloc(FAR void *oldptr, size_t oldsize, size_t newsize);
+extern void      httpd_free(FAR void *ptr);
+extern void      httpd_memstats(void);
+#else
 #  define httpd_realloc(p,o,n) realloc(p,n)
 #  define httpd_free(p)        free(p)
-#  define httpd_strdup(s)      strdup(s)
+#endif
+
+/* Fixed-size block pools.  httpd_slab_initialize() carves one allocation
+ * made at start-up into blocks for the httpd_conn objects and three size
+ * classes of strings and buffers.  httpd_slab_conn() hands out a
+ * connection object and httpd_slab_alloc() the smallest fitting string
+ * block; both only fall back to the heap when the pools are exhausted or
+ * the request is larger than the largest class.  Blocks are returned with
+ * httpd_free().
+ */
+
+#ifdef CONFIG_THTTPD_SLAB
+extern int       httpd_slab_initialize(size_t connsize);
+extern void      httpd_slab_uninitialize(void);
+extern FAR void *httpd_slab_conn(void);
+extern FAR void *httpd_slab_alloc(size_t nbytes);
+extern size_t    httpd_slab_blksize(FAR const void *ptr);
 #endif
 
 /* Helpers to support allocations in multiples of a type size */
@@ -0,0 +1,311 @@
+/****************************************************************************
+ * apps/netutils/thttpd/thttpd_filecache.c
+ * Bounded in-RAM cache of small, frequently requested files
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <debug.h>
+
+#include "config.h"
+#include "thttpd_alloc.h"
+#include "thttpd_filecache.h"
+
+#if defined(CONFIG_THTTPD) && defined(CONFIG_THTTPD_FILECACHE)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct httpd_fcentry_s g_fcache[CONFIG_THTTPD_FILECACHE_ENTRIES];
+static size_t   g_fcache_bytes;   /* Bytes of file data currently cached */
+static uint32_t g_fcache_clock;   /* LRU clock */
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* FNV-1a hash of the path so that the lookup only compares strings when
+ * there is a good chance of a match.
+ */
+
+static uint32_t fcache_hash(FAR const char *path)
+{
+  uint32_t hash = 2166136261u;
+
+  while (*path != '\0')
+    {
+      hash ^= (uint8_t)*path++;
+      hash *= 16777619u;
+    }
+
+  return hash;
+}
+
+static void fcache_release(FAR struct httpd_fcentry_s *entry)
+{
+  ninfo("Dropping %s (%jd bytes)\n", entry->path, (intmax_t)entry->size);
+
+  g_fcache_bytes -= entry->size;
+  httpd_free(entry->data);
+  httpd_free(entry->path);
+  memset(entry, 0, sizeof(struct httpd_fcentry_s));
+}
+
+/* Find a free entry, or NULL if all entries are in use */
+
+static FAR struct httpd_fcentry_s *fcache_free_entry(void)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_THTTPD_FILECACHE_ENTRIES; i++)
+    {
+      if (g_fcache[i].path == NULL)
+        {
+          return &g_fcache[i];
+        }
+    }
+
+  return NULL;
+}
+
+/* Find the least recently used entry that is not being sent, or NULL if
+ * every cached entry is busy.
+ */
+
+static FAR struct httpd_fcentry_s *fcache_victim(void)
+{
+  FAR struct httpd_fcentry_s *victim = NULL;
+  int i;
+
+  for (i = 0; i < CONFIG_THTTPD_FILECACHE_ENTRIES; i++)
+    {
+      FAR struct httpd_fcentry_s *entry = &g_fcache[i];
+
+      if (entry->path != NULL && entry->refs == 0 &&
+          (victim == NULL ||
+           (int32_t)(entry->lastuse - victim->lastuse) < 0))
+        {
+          victim = entry;
+        }
+    }
+
+  return victim;
+}
+
+/* Make room for nbytes of new data by evicting idle entries.  Returns the
+ * entry to fill, or NULL if the data cannot be made to fit.
+ */
+
+static FAR struct httpd_fcentry_s *fcache_reserve(size_t nbytes)
+{
+  FAR struct httpd_fcentry_s *entry;
+
+  if (nbytes > CONFIG_THTTPD_FILECACHE_SIZE)
+    {
+      return NULL;
+    }
+
+  for (; ; )
+    {
+      entry = fcache_free_entry();
+      if (entry != NULL &&
+          g_fcache_bytes + nbytes <= CONFIG_THTTPD_FILECACHE_SIZE)
+        {
+          return entry;
+        }
+
+      entry = fcache_victim();
+      if (entry == NULL)
+        {
+          return NULL;
+        }
+
+      fcache_release(entry);
+    }
+}
+
+static FAR struct httpd_fcentry_s *fcache_load(FAR const char *path,
+                                               FAR const struct stat *sb,
+                                               uint32_t hash)
+{
+  FAR struct httpd_fcentry_s *entry;
+  FAR uint8_t *data;
+  off_t nread;
+  ssize_t ret;
+  int fd;
+
+  entry = fcache_reserve(sb->st_size);
+  if (entry == NULL)
+    {
+      return NULL;
+    }
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      return NULL;
+    }
+
+  /* Allocate at least one byte so that empty files are cacheable too */
+
+  data = httpd_malloc(sb->st_size > 0 ? sb->st_size : 1);
+  if (data == NULL)
+    {
+      close(fd);
+      return NULL;
+    }
+
+  for (nread = 0; nread < sb->st_size; nread += ret)
+    {
+      ret = read(fd, &data[nread], sb->st_size - nread);
+      if (ret <= 0)
+        {
+          if (ret < 0 && errno == EINTR)
+            {
+              ret = 0;
+              continue;
+            }
+
+          nerr("ERROR: read %s failed: %d\n", path, errno);
+          close(fd);
+          httpd_free(data);
+          return NULL;
+        }
+    }
+
+  close(fd);
+
+  entry->path = httpd_strdup(path);
+  if (entry->path == NULL)
+    {
+      httpd_free(data);
+      return NULL;
+    }
+
+  entry->data    = data;
+  entry->size    = sb->st_size;
+  entry->mtime   = sb->st_mtime;
+  entry->hash    = hash;
+  entry->refs    = 0;
+  httpd_fcache_etag(entry->etaghdr, entry->size, entry->mtime);
+
+  g_fcache_bytes += entry->size;
+  ninfo("Cached %s (%jd bytes, %zu total)\n",
+        path, (intmax_t)entry->size, g_fcache_bytes);
+  return entry;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void httpd_fcache_etag(FAR char *buf, off_t size, time_t mtime)
+{
+  snprintf(buf, HTTPD_ETAG_HDRLEN, "ETag: \"%jx-%jx\"\r\n",
+           (uintmax_t)size, (uintmax_t)mtime);
+}
+
+FAR struct httpd_fcentry_s *httpd_fcache_get(FAR const char *path,
+                                             FAR const struct stat *sb)
+{
+  FAR struct httpd_fcentry_s *entry = NULL;
+  uint32_t hash;
+  int i;
+
+  if (!S_ISREG(sb->st_mode) || sb->st_size > CONFIG_THTTPD_FILECACHE_MAXFILE)
+    {
+      return NULL;
+    }
+
+  hash = fcache_hash(path);
+  for (i = 0; i < CONFIG_THTTPD_FILECACHE_ENTRIES; i++)
+    {
+      if (g_fcache[i].path != NULL && g_fcache[i].hash == hash &&
+          strcmp(g_fcache[i].path, path) == 0)
+        {
+          entry = &g_fcache[i];
+          break;
+        }
+    }
+
+  if (entry != NULL &&
+      (entry->size != sb->st_size || entry->mtime != sb->st_mtime))
+    {
+      /* The file changed underneath us.  Drop the stale copy unless some
+       * connection is still sending it, in which case just bypass the
+       * cache for this request.
+       */
+
+      if (entry->refs > 0)
+        {
+          return NULL;
+        }
+
+      fcache_release(entry);
+      entry = NULL;
+    }
+
+  if (entry == NULL)
+    {
+      entry = fcache_load(path, sb, hash);
+      if (entry == NULL)
+        {
+          return NULL;
+        }
+    }
+
+  entry->lastuse = ++g_fcache_clock;
+  entry->refs++;
+  return entry;
+}
+
+void httpd_fcache_put(FAR struct httpd_fcentry_s *entry)
+{
+  DEBUGASSERT(entry != NULL && entry->refs > 0);
+  entry->refs--;
+}
+
+void httpd_fcache_flush(void)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_THTTPD_FILECACHE_ENTRIES; i++)
+    {
+      if (g_fcache[i].path != NULL && g_fcache[i].refs == 0)
+        {
+          fcache_release(&g_fcache[i]);
+        }
+    }
+}
+
+#endif /* CONFIG_THTTPD && CONFIG_THTTPD_FILECACHE */
@@ -0,0 +1,95 @@
+/****************************************************************************
+ * apps/netutils/thttpd/thttpd_filecache.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_NETUTILS_THTTPD_THTTPD_FILECACHE_H
+#define __APPS_NETUTILS_THTTPD_THTTPD_FILECACHE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "config.h"
+
+#if defined(CONFIG_THTTPD) && defined(CONFIG_THTTPD_FILECACHE)
+
+/****************************************************************************
+ * Pre-Processor Definitions
+ ****************************************************************************/
+
+/* Room for "ETag: \"<size>-<mtime>\"\r\n" with both values in hex */
+
+#define HTTPD_ETAG_HDRLEN 48
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* One cached file.  The body is kept in memory together with the headers
+ * that depend only on the file itself so that a hit needs neither open()
+ * nor read() nor any per-request formatting of those headers.
+ */
+
+struct httpd_fcentry_s
+{
+  FAR char    *path;                     /* Expanded file name (allocated) */
+  FAR uint8_t *data;                     /* File contents (allocated) */
+  off_t        size;                     /* st_size when loaded */
+  time_t       mtime;                    /* st_mtime when loaded */
+  uint32_t     hash;                     /* Hash of path */
+  uint32_t     lastuse;                  /* LRU stamp */
+  int          refs;                     /* Connections currently sending */
+  char         etaghdr[HTTPD_ETAG_HDRLEN]; /* Precomputed ETag header */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/* Look up a file in the cache, loading it on a miss if it is small enough.
+ * sb must be the result of a stat() of path made for the current request;
+ * stale entries are detected by comparing size and modification time.
+ * Returns an entry with a reference held, or NULL if the file is not (and
+ * cannot be) cached.
+ */
+
+FAR struct httpd_fcentry_s *httpd_fcache_get(FAR const char *path,
+                                             FAR const struct stat *sb);
+
+/* Drop a reference obtained from httpd_fcache_get() */
+
+void httpd_fcache_put(FAR struct httpd_fcentry_s *entry);
+
+/* Release all unreferenced entries */
+
+void httpd_fcache_flush(void);
+
+/* Format the ETag header for a file into buf (HTTPD_ETAG_HDRLEN bytes) */
+
+void httpd_fcache_etag(FAR char *buf, off_t size, time_t mtime);
+
+#endif /* CONFIG_THTTPD && CONFIG_THTTPD_FILECACHE */
+#endif /* __APPS_NETUTILS_THTTPD_THTTPD_FILECACHE_H */
@@ -40,10 +40,14 @@
 
 #include <sys/time.h>
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <strings.h>
 #include <debug.h>
 
+#include "config.h"
 #include "thttpd_alloc.h"
 #include "timers.h"
 
@@ -51,13 +55,51 @@
  * Pre-Processor Definitions
  ****************************************************************************/
 
-#define HASH_SIZE 67
+/* Timers are kept in a hierarchical timing wheel.  Level 0 has one slot per
+ * tick, each slot of level n covers TMR_SLOTS^n ticks.  A timer is placed
+ * in the lowest level that can represent its distance from the current
+ * tick and moves down one level ("cascades") whenever the lower level
+ * wraps around.  Adding, cancelling and expiring a timer are O(1); an
+ * occupancy bitmap per level lets the next deadline be found without
+ * scanning any slots.
+ */
+
+#define TMR_BITS          5
+#define TMR_SLOTS         (1 << TMR_BITS)
+#define TMR_MASK          (TMR_SLOTS - 1)
+#define TMR_LEVELS        5
+
+/* Largest distance (in ticks) that the wheel can represent.  Timers that
+ * are further away are parked in the top level and re-placed each time
+ * they cascade.
+ */
+
+#define TMR_MAXDELTA      ((uint32_t)1 << (TMR_BITS * TMR_LEVELS))
+
+#define TMR_SHIFT(l)      ((l) * TMR_BITS)
+#define TMR_INDEX(t,l)    (((t) >> TMR_SHIFT(l)) & TMR_MASK)
+#define TMR_SLOTNDX(l,s)  ((l) * TMR_SLOTS + (s))
+
+/* Timer states */
+
+#define TMR_STATE_FREE    0  /* On the free list */
+#define TMR_STATE_PENDING 1  /* In a wheel slot */
+#define TMR_STATE_RUNNING 2  /* Expired, callback in progress */
+
+/* Slot number used for expired timers waiting for their callback */
+
+#define TMR_SLOT_EXPIRED  0xff
+
+#define TMR_TICK          CONFIG_THTTPD_TIMER_TICK_MSEC
 
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
-static Timer *timers[HASH_SIZE];
+static struct tmr_link_s g_wheel[TMR_LEVELS][TMR_SLOTS];
+static uint32_t g_bitmap[TMR_LEVELS];  /* Non-empty slots of each level */
+static uint32_t g_tick;                /* Next tick to be processed */
+static unsigned int g_npending;        /* Number of timers in the wheel */
 static Timer *free_timers;
 
 /****************************************************************************
@@ -70,107 +112,224 @@ ClientData JunkClientData;
  * Private Functions
  ****************************************************************************/
 
-static unsigned int hash(Timer *tmr)
+static inline void l_init(FAR struct tmr_link_s *head)
 {
-  /* We can hash on the trigger time, even though it can change over the
-   * life of a timer via the periodic bit.
-   * This is because both of those guys call l_resort(), which  * recomputes
-   * the hash and moves the timer to the appropriate list.
-   */
-
-  return ((unsigned int)tmr->time.tv_sec ^
-          (unsigned int)tmr->time.tv_usec) % HASH_SIZE;
+  head->prev = head;
+  head->next = head;
 }
 
-static void l_add(Timer *tmr)
+static inline bool l_empty(FAR struct tmr_link_s *head)
 {
-  int h = tmr->hash;
-  register Timer *tmr2;
-  register Timer *tmr2prev;
+  return head->next == head;
+}
 
-  tmr2 = timers[h];
-  if (tmr2 == NULL)
-    {
-      /* The list is empty. */
+static inline void l_append(FAR struct tmr_link_s *head,
+                            FAR struct tmr_link_s *node)
+{
+  node->prev       = head->prev;
+  node->next       = head;
+  head->prev->next = node;
+  head->prev       = node;
+}
+
+static inline void l_unlink(FAR struct tmr_link_s *node)
+{
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  node->prev       = node;
+  node->next       = node;
+}
+
+/* Move all nodes of src to the (empty) list dest */
 
-      timers[h] = tmr;
-      tmr->prev = tmr->next = NULL;
+static inline void l_move(FAR struct tmr_link_s *dest,
+                          FAR struct tmr_link_s *src)
+{
+  if (l_empty(src))
+    {
+      l_init(dest);
     }
   else
     {
-      if (tmr->time.tv_sec < tmr2->time.tv_sec ||
-          (tmr->time.tv_sec == tmr2->time.tv_sec &&
-           tmr->time.tv_usec <= tmr2->time.tv_usec))
-        {
-          /* The new timer goes at the head of the list. */
+      dest->next       = src->next;
+      dest->prev       = src->prev;
+      dest->next->prev = dest;
+      dest->prev->next = dest;
+      l_init(src);
+    }
+}
 
-          timers[h] = tmr;
-          tmr->prev = NULL;
-          tmr->next = tmr2;
-          tmr2->prev = tmr;
-        }
-      else
-        {
-          /* Walk the list to find the insertion point. */
+/* Convert a timeval to wheel ticks, rounding down */
 
-          for (tmr2prev = tmr2, tmr2 = tmr2->next; tmr2 != NULL;
-               tmr2prev = tmr2, tmr2 = tmr2->next)
-            {
-              if (tmr->time.tv_sec < tmr2->time.tv_sec ||
-                  (tmr->time.tv_sec == tmr2->time.tv_sec &&
-                   tmr->time.tv_usec <= tmr2->time.tv_usec))
-                {
-                  /* Found it. */
+static uint32_t tv2tick(FAR const struct timeval *tv)
+{
+  uint64_t msecs = (uint64_t)tv->tv_sec * 1000 + tv->tv_usec / 1000;
 
-                  tmr2prev->next = tmr;
-                  tmr->prev = tmr2prev;
-                  tmr->next = tmr2;
-                  tmr2->prev = tmr;
-                  return;
-                }
-            }
+  return (uint32_t)(msecs / TMR_TICK);
+}
 
-          /* Oops, got to the end of the list.  Add to tail. */
+/* Convert a timeval to wheel ticks, rounding up so that no timer fires
+ * before its time.
+ */
 
-          tmr2prev->next = tmr;
-          tmr->prev = tmr2prev;
-          tmr->next = NULL;
-        }
+static uint32_t tv2tick_up(FAR const struct timeval *tv)
+{
+  uint64_t msecs = (uint64_t)tv->tv_sec * 1000 +
+                   (tv->tv_usec + 999) / 1000;
+
+  return (uint32_t)((msecs + TMR_TICK - 1) / TMR_TICK);
+}
+
+static void tv_add_msecs(FAR struct timeval *tv, long msecs)
+{
+  tv->tv_sec  += msecs / 1000L;
+  tv->tv_usec += (msecs % 1000L) * 1000L;
+  if (tv->tv_usec >= 1000000L)
+    {
+      tv->tv_sec  += tv->tv_usec / 1000000L;
+      tv->tv_usec %= 1000000L;
     }
 }
 
-static void l_remove(Timer *tmr)
+/* Put a timer in the wheel slot matching its expiration tick */
+
+static void w_add(Timer *tmr)
 {
-  int h = tmr->hash;
+  uint32_t expires = tmr->expires;
+  uint32_t delta   = expires - g_tick;
+  int level;
+  int slot;
 
-  if (tmr->prev == NULL)
+  if ((int32_t)delta < 0)
     {
-      timers[h] = tmr->next;
+      /* Already due: run it with the tick being processed */
+
+      expires = g_tick;
+      delta   = 0;
     }
-  else
+  else if (delta >= TMR_MAXDELTA)
+    {
+      /* Too far away: park it as far as the wheel reaches */
+
+      expires = g_tick + TMR_MAXDELTA - 1;
+      delta   = TMR_MAXDELTA - 1;
+    }
+
+  for (level = 0; level < TMR_LEVELS - 1; level++)
+    {
+      if (delta < ((uint32_t)1 << TMR_SHIFT(level + 1)))
+        {
+          break;
+        }
+    }
+
+  slot = TMR_INDEX(expires, level);
+  l_append(&g_wheel[level][slot], &tmr->link);
+  g_bitmap[level] |= (uint32_t)1 << slot;
+
+  tmr->slot  = TMR_SLOTNDX(level, slot);
+  tmr->state = TMR_STATE_PENDING;
+  g_npending++;
+}
+
+/* Take a timer out of the wheel (or off the expired list) */
+
+static void w_remove(Timer *tmr)
+{
+  int level;
+  int slot;
+
+  l_unlink(&tmr->link);
+
+  if (tmr->slot != TMR_SLOT_EXPIRED)
     {
-      tmr->prev->next = tmr->next;
+      level = tmr->slot / TMR_SLOTS;
+      slot  = tmr->slot % TMR_SLOTS;
+      if (l_empty(&g_wheel[level][slot]))
+        {
+          g_bitmap[level] &= ~((uint32_t)1 << slot);
+        }
+
+      g_npending--;
     }
+}
+
+/* Re-place all timers of one slot of a higher level into lower levels */
+
+static void w_cascade(int level, int slot)
+{
+  struct tmr_link_s list;
+  Timer *tmr;
+
+  l_move(&list, &g_wheel[level][slot]);
+  g_bitmap[level] &= ~((uint32_t)1 << slot);
 
-  if (tmr->next != NULL)
+  while (!l_empty(&list))
     {
-      tmr->next->prev = tmr->prev;
+      tmr = (Timer *)list.next;
+      l_unlink(&tmr->link);
+      g_npending--;
+      w_add(tmr);
     }
 }
 
-static void l_resort(Timer *tmr)
+/* Distance from bit 'index' to the first set bit of 'bitmap' at or after
+ * it, wrapping around.  Returns -1 if bitmap is empty.
+ */
+
+static int w_nextbit(uint32_t bitmap, int index)
 {
-  /* Remove the timer from its old list. */
+  uint32_t rot;
 
-  l_remove(tmr);
+  if (bitmap == 0)
+    {
+      return -1;
+    }
 
-  /* Recompute the hash. */
+  rot = index ? (bitmap >> index) | (bitmap << (TMR_SLOTS - index))
+              : bitmap;
+  return ffs((int)rot) - 1;
+}
 
-  tmr->hash = hash(tmr);
+/* Return the earliest tick at which something has to be done: either a
+ * level 0 slot with timers becomes current or a non-empty slot of a higher
+ * level has to be cascaded.  This is exact for level 0 and a lower bound
+ * otherwise.  Must only be called when timers are pending.
+ */
 
-  /* And add it back in to its new list, sorted correctly. */
+static uint32_t w_nextevent(void)
+{
+  uint32_t next = g_tick + TMR_MAXDELTA;
+  uint32_t boundary;
+  uint32_t t;
+  int level;
+  int d;
+
+  d = w_nextbit(g_bitmap[0], TMR_INDEX(g_tick, 0));
+  if (d >= 0)
+    {
+      next = g_tick + d;
+    }
+
+  for (level = 1; level < TMR_LEVELS; level++)
+    {
+      /* First tick >= g_tick at which this level can cascade */
 
-  l_add(tmr);
+      boundary = (g_tick + ((uint32_t)1 << TMR_SHIFT(level)) - 1) >>
+                 TMR_SHIFT(level);
+
+      d = w_nextbit(g_bitmap[level], boundary & TMR_MASK);
+      if (d >= 0)
+        {
+          t = (boundary + d) << TMR_SHIFT(level);
+          if ((int32_t)(t - next) < 0)
+            {
+              next = t;
+            }
+        }
+    }
+
+  return next;
 }
 
 /****************************************************************************
@@ -179,13 +338,23 @@ static void l_resort(Timer *tmr)
 
 void tmr_init(void)
 {
-  int h;
+  struct timeval now;
+  int level;
+  int slot;
 
-  for (h = 0; h < HASH_SIZE; ++h)
+  for (level = 0; level < TMR_LEVELS; level++)
     {
-      timers[h] = NULL;
+      for (slot = 0; slot < TMR_SLOTS; slot++)
+        {
+          l_init(&g_wheel[level][slot]);
+        }
+
+      g_bitmap[level] = 0;
     }
 
+  gettimeofday(&now, NULL);
+  g_tick      = tv2tick(&now);
+  g_npending  = 0;
   free_timers = NULL;
 }
 
@@ -197,7 +366,7 @@ Timer *tmr_create(struct timeval *now, TimerProc *timer_proc,
   if (free_timers != NULL)
     {
       tmr = free_timers;
-      free_timers = tmr->next;
+      free_timers = (Timer *)tmr->link.next;
     }
   else
     {
@@ -222,106 +391,120 @@ Timer *tmr_create(struct timeval *now, TimerProc *timer_proc,
       gettimeofday(&tmr->time, NULL);
     }
 
-  tmr->time.tv_sec  += msecs / 1000L;
-  tmr->time.tv_usec += (msecs % 1000L) * 1000L;
-  if (tmr->time.tv_usec >= 1000000L)
-    {
-      tmr->time.tv_sec  += tmr->time.tv_usec / 1000000L;
-      tmr->time.tv_usec %= 1000000L;
-    }
-
-  tmr->hash = hash(tmr);
+  tv_add_msecs(&tmr->time, msecs);
+  tmr->expires = tv2tick_up(&tmr->time);
 
-  /* Add the new timer to the proper active list. */
+  /* Add the new timer to the wheel. */
 
-  l_add(tmr);
+  w_add(tmr);
   return tmr;
 }
 
 long tmr_mstimeout(struct timeval *now)
 {
-  int h;
-  int gotone;
+  uint32_t nowtick;
+  uint32_t next;
   long msecs;
-  long m;
-  register Timer *tmr;
-
-  gotone = 0;
-  msecs  = 0;
-
-  /* Since the lists are sorted, we only need to look at the first timer
-   * on each one.
-   */
-
-  for (h = 0; h < HASH_SIZE; ++h)
-    {
-      tmr = timers[h];
-      if (tmr != NULL)
-        {
-          m = (tmr->time.tv_sec - now->tv_sec) * 1000L +
-            (tmr->time.tv_usec - now->tv_usec) / 1000L;
-          if (!gotone)
-            {
-              msecs = m;
-              gotone = 1;
-            }
-          else if (m < msecs)
-            {
-              msecs = m;
-            }
-        }
-    }
 
-  if (!gotone)
+  if (g_npending == 0)
     {
       return INFTIM;
     }
 
-  if (msecs <= 0)
+  nowtick = tv2tick(now);
+  next    = w_nextevent();
+  if ((int32_t)(next - nowtick) <= 0)
     {
-      msecs = 0;
+      return 0;
     }
 
-  return msecs;
+  msecs = (long)(next - nowtick) * TMR_TICK -
+          (long)(((uint64_t)now->tv_sec * 1000 + now->tv_usec / 1000) %
+                 TMR_TICK);
+
+  return msecs > 0 ? msecs : 0;
 }
 
 void tmr_run(struct timeval *now)
 {
-  int h;
+  struct tmr_link_s expired;
+  uint32_t nowtick = tv2tick(now);
+  uint32_t next;
   Timer *tmr;
-  Timer *next;
+  int level;
+  int slot;
 
-  for (h = 0; h < HASH_SIZE; ++h)
+  while ((int32_t)(nowtick - g_tick) >= 0)
     {
-      for (tmr = timers[h]; tmr != NULL; tmr = next)
+      /* Skip straight to the next tick that has any work */
+
+      if (g_npending == 0)
         {
-          next = tmr->next;
+          g_tick = nowtick + 1;
+          break;
+        }
 
-          /* Since the lists are sorted, as soon as we find a timer that
-           * isn't ready yet, we can go on to the next list.
-           */
+      next = w_nextevent();
+      if ((int32_t)(next - nowtick) > 0)
+        {
+          g_tick = nowtick + 1;
+          break;
+        }
+
+      g_tick = next;
+
+      /* Cascade the higher levels if level 0 wrapped around */
 
-          if (tmr->time.tv_sec > now->tv_sec ||
-              (tmr->time.tv_sec == now->tv_sec &&
-               tmr->time.tv_usec > now->tv_usec))
+      slot = TMR_INDEX(g_tick, 0);
+      if (slot == 0)
+        {
+          for (level = 1; level < TMR_LEVELS; level++)
             {
-              break;
+              int index = TMR_INDEX(g_tick, level);
+
+              w_cascade(level, index);
+              if (index != 0)
+                {
+                  break;
+                }
             }
+        }
+
+      /* Detach the expired slot before running any callback: callbacks
+       * may create and cancel timers, including ones on this list.
+       */
+
+      l_move(&expired, &g_wheel[0][slot]);
+      g_bitmap[0] &= ~((uint32_t)1 << slot);
+      g_tick++;
+
+      while (!l_empty(&expired))
+        {
+          tmr = (Timer *)expired.next;
+          l_unlink(&tmr->link);
+          g_npending--;
+
+          tmr->slot  = TMR_SLOT_EXPIRED;
+          tmr->state = TMR_STATE_RUNNING;
 
           (tmr->timer_proc)(tmr->client_data, now);
+
+          /* The callback may have cancelled (and even re-created) the
+           * timer.  Only touch it if it is still ours.
+           */
+
+          if (tmr->state != TMR_STATE_RUNNING)
+            {
+              continue;
+            }
+
           if (tmr->periodic)
             {
               /* Reschedule. */
 
-              tmr->time.tv_sec += tmr->msecs / 1000L;
-              tmr->time.tv_usec += (tmr->msecs % 1000L) * 1000L;
-              if (tmr->time.tv_usec >= 1000000L)
-                {
-                  tmr->time.tv_sec += tmr->time.tv_usec / 1000000L;
-                  tmr->time.tv_usec %= 1000000L;
-                }
-
-              l_resort(tmr);
+              tv_add_msecs(&tmr->time, tmr->msecs);
+              tmr->expires = tv2tick_up(&tmr->time);
+              w_add(tmr);
             }
           else
             {
@@ -333,15 +516,21 @@ void tmr_run(struct timeval *now)
 
 void tmr_cancel(Timer *tmr)
 {
-  /* Remove it from its active list. */
+  if (tmr->state == TMR_STATE_FREE)
+    {
+      return;
+    }
+
+  /* Remove it from its wheel slot. */
 
-  l_remove(tmr);
+  w_remove(tmr);
 
   /* And put it on the free list. */
 
-  tmr->next   = free_timers;
-  free_timers = tmr;
-  tmr->prev   = NULL;
+  tmr->state     = TMR_STATE_FREE;
+  tmr->link.next = (FAR struct tmr_link_s *)free_timers;
+  tmr->link.prev = NULL;
+  free_timers    = tmr;
 }
 
 void tmr_cleanup(void)
@@ -351,20 +540,24 @@ void tmr_cleanup(void)
   while (free_timers != NULL)
     {
       tmr = free_timers;
-      free_timers = tmr->next;
+      free_timers = (Timer *)tmr->link.next;
       httpd_free((void*)tmr);
     }
 }
 
 void tmr_destroy(void)
 {
-  int h;
+  int level;
+  int slot;
 
-  for (h = 0; h < HASH_SIZE; ++h)
+  for (level = 0; level < TMR_LEVELS; level++)
     {
-      while (timers[h] != NULL)
+      for (slot = 0; slot < TMR_SLOTS; slot++)
         {
-          tmr_cancel(timers[h]);
+          while (!l_empty(&g_wheel[level][slot]))
+            {
+              tmr_cancel((Timer *)g_wheel[level][slot].next);
+            }
         }
     }
 
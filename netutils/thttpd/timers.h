@@ -42,6 +42,7 @@
  ****************************************************************************/
 
 #include <sys/time.h>
+#include <stdint.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -74,18 +75,30 @@ typedef union
 
 typedef void TimerProc(ClientData client_data, struct timeval *nowp);
 
+/* Doubly linked, circular list node.  Each slot of the timing wheel has a
+ * sentinel node so that a timer can be unlinked in O(1) without knowing
+ * which list it is on.
+ */
+
+struct tmr_link_s
+{
+  struct tmr_link_s *prev;
+  struct tmr_link_s *next;
+};
+
 /* The Timer struct. */
 
 typedef struct TimerStruct
 {
+  struct tmr_link_s   link;        /* Must be first */
   TimerProc          *timer_proc;
   ClientData          client_data;
   long                msecs;
   int                 periodic;
-  struct timeval      time;
-  struct TimerStruct *prev;
-  struct TimerStruct *next;
-  int hash;
+  struct timeval      time;        /* Absolute expiration time */
+  uint32_t            expires;     /* Expiration time in wheel ticks */
+  uint8_t             slot;        /* Wheel slot holding the timer */
+  uint8_t             state;       /* See TMR_STATE_* in timers.c */
 } Timer;
 
 /****************************************************************************
@@ -111,7 +124,9 @@ extern Timer *tmr_create(struct timeval *nowp, TimerProc *timer_proc,
 
 /* Returns a timeout in milliseconds indicating how long until the next timer
  * triggers.  You can just put the call to this routine right in your poll().
- * Returns INFTIM (-1) if no timers are pending.
+ * Returns INFTIM (-1) if no timers are pending.  The value may be shorter
+ * than the time to the next timer when a timing wheel level has to be
+ * cascaded first; it is never longer.
  */
 
 extern long tmr_mstimeout(struct timeval *nowp);
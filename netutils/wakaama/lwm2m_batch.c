@@ -0,0 +1,159 @@
+/****************************************************************************
+ * apps/netutils/wakaama/lwm2m_batch.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "netutils/lwm2m_batch.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: lwm2m_batch_covers
+ *
+ * Description:
+ *   Return true if a change of outer implies a change of inner: each level
+ *   set in outer is set to the same value in inner.
+ *
+ ****************************************************************************/
+
+static bool lwm2m_batch_covers(FAR const lwm2m_uri_t *outer,
+                               FAR const lwm2m_uri_t *inner)
+{
+  if (outer->objectId != inner->objectId)
+    {
+      return false;
+    }
+
+  if (outer->instanceId == LWM2M_MAX_ID)
+    {
+      return true;
+    }
+
+  if (outer->instanceId != inner->instanceId)
+    {
+      return false;
+    }
+
+  return outer->resourceId == LWM2M_MAX_ID ||
+         outer->resourceId == inner->resourceId;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: lwm2m_batch_init
+ ****************************************************************************/
+
+void lwm2m_batch_init(FAR struct lwm2m_batch_s *batch,
+                      FAR lwm2m_context_t *ctx, time_t window)
+{
+  memset(batch, 0, sizeof(*batch));
+  batch->ctx    = ctx;
+  batch->window = window;
+}
+
+/****************************************************************************
+ * Name: lwm2m_batch_changed
+ ****************************************************************************/
+
+void lwm2m_batch_changed(FAR struct lwm2m_batch_s *batch,
+                         FAR const lwm2m_uri_t *uri)
+{
+  int i;
+
+  for (i = 0; i < batch->count; i++)
+    {
+      if (lwm2m_batch_covers(&batch->uris[i], uri))
+        {
+          return;
+        }
+
+      /* A wider change replaces the narrower ones it covers. */
+
+      if (lwm2m_batch_covers(uri, &batch->uris[i]))
+        {
+          batch->uris[i--] = batch->uris[--batch->count];
+        }
+    }
+
+  if (batch->count == CONFIG_WAKAAMA_BATCH_SIZE)
+    {
+      lwm2m_batch_flush(batch);
+    }
+
+  if (batch->count == 0)
+    {
+      batch->first = lwm2m_gettime();
+    }
+
+  batch->uris[batch->count++] = *uri;
+}
+
+/****************************************************************************
+ * Name: lwm2m_batch_step
+ ****************************************************************************/
+
+void lwm2m_batch_step(FAR struct lwm2m_batch_s *batch,
+                      FAR time_t *timeout)
+{
+  time_t left;
+
+  if (batch->count == 0)
+    {
+      return;
+    }
+
+  left = batch->first + batch->window - lwm2m_gettime();
+  if (left <= 0)
+    {
+      lwm2m_batch_flush(batch);
+    }
+  else if (left < *timeout)
+    {
+      *timeout = left;
+    }
+}
+
+/****************************************************************************
+ * Name: lwm2m_batch_flush
+ ****************************************************************************/
+
+void lwm2m_batch_flush(FAR struct lwm2m_batch_s *batch)
+{
+  int i;
+
+  for (i = 0; i < batch->count; i++)
+    {
+      lwm2m_resource_value_changed(batch->ctx, &batch->uris[i]);
+    }
+
+  batch->count = 0;
+}
@@ -55,6 +55,7 @@
 
 #include <assert.h>
 #include <fcntl.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <stdint.h>
@@ -67,6 +68,9 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -79,6 +83,10 @@
 #include "netutils/netlib.h"
 #include "netutils/webclient.h"
 
+#ifdef CONFIG_WEBCLIENT_GZIP
+#  include "system/zstream.h"
+#endif
+
 #if defined(CONFIG_NETUTILS_CODECS)
 #  if defined(CONFIG_CODECS_URLCODE)
 #    include "netutils/urldecode.h"
@@ -169,6 +177,13 @@ enum webclient_state_e
 #define WGET_FLAG_GOT_CONTENT_LENGTH 1U
 #define WGET_FLAG_CHUNKED            2U
 #define WGET_FLAG_GOT_LOCATION       4U
+#define WGET_FLAG_CONN_CLOSE         8U  /* Server sent "Connection: close" */
+#define WGET_FLAG_HTTP10            16U  /* Server replied with HTTP/1.0 */
+#define WGET_FLAG_GZIP              32U  /* Body is gzip or deflate encoded */
+
+/* Size of the pieces of an encoded body handed to the sink */
+
+#define WGET_ZBUFSIZE              256
 
 struct wget_target_s
 {
@@ -213,6 +228,9 @@ struct wget_s
   struct wget_target_s proxy;
 
   bool need_conn_close;
+  bool keepalive;    /* Request sent without "Connection: close" */
+  bool reused;       /* conn was taken from the connection pool */
+  bool complete;     /* Response fully received on a kept-alive conn */
   struct webclient_conn_s *conn;
   unsigned int nredirect;
   int redirected;
@@ -224,9 +242,35 @@ struct wget_s
   FAR const void *data_buffer;
   size_t data_len;
 
+  /* Position in webclient_context::body_iov */
+
+  unsigned int body_iovidx;
+
   FAR struct webclient_context *tunnel;
+
+#ifdef CONFIG_WEBCLIENT_GZIP
+  struct zstream_s zs;         /* Inflater of an encoded body */
+  char zbuf[WGET_ZBUFSIZE];    /* Inflated data for the sink */
+#endif
 };
 
+#ifdef CONFIG_WEBCLIENT_CONNPOOL
+/* An idle connection kept open for reuse by a later request to the same
+ * server.
+ */
+
+struct wget_pool_entry_s
+{
+  FAR struct webclient_conn_s *conn;   /* NULL if the slot is free */
+  FAR const struct webclient_tls_ops *tls_ops;
+  FAR void *tls_ctx;
+  time_t idle_since;                   /* Monotonic seconds */
+  uint16_t port;
+  bool nonblock;                       /* Used with NON_BLOCKING */
+  char hostname[CONFIG_WEBCLIENT_MAXHOSTNAME];
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -239,6 +283,13 @@ static const char g_httpcontenttype[]      = "content-type: ";
 static const char g_httphost[]             = "host: ";
 static const char g_httplocation[]         = "location: ";
 static const char g_httptransferencoding[] = "transfer-encoding: ";
+#ifdef CONFIG_WEBCLIENT_GZIP
+static const char g_httpcontentencoding[]  = "content-encoding: ";
+static const char g_httpacceptencoding[]   = "Accept-Encoding: gzip, deflate";
+#endif
+#ifdef CONFIG_WEBCLIENT_CONNPOOL
+static const char g_httpconnection[]       = "connection: ";
+#endif
 
 static const char g_httpuseragentfields[] =
   "User-Agent: "
@@ -256,6 +307,11 @@ static const char g_httpconn[]       = "Connection: Keep-Alive";
 static const char g_httpcache[]      = "Cache-Control: no-cache";
 #endif
 
+#ifdef CONFIG_WEBCLIENT_CONNPOOL
+static struct wget_pool_entry_s g_wget_pool[CONFIG_WEBCLIENT_CONNPOOL_SIZE];
+static pthread_mutex_t g_wget_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -271,6 +327,10 @@ static void free_ws(FAR struct wget_s *ws)
       webclient_conn_free(ws->conn);
     }
 
+#ifdef CONFIG_WEBCLIENT_GZIP
+  zstream_deinit(&ws->zs);
+#endif
+
   free(ws->tunnel);
   free(ws);
 }
@@ -419,6 +479,12 @@ static inline int wget_parsestatus(struct webclient_context *ctx,
            */
 
           ws->line[ndx] = '\0';
+          ws->internal_flags &= ~WGET_FLAG_HTTP10;
+          if (strncmp(ws->line, g_http10, strlen(g_http10)) == 0)
+            {
+              ws->internal_flags |= WGET_FLAG_HTTP10;
+            }
+
           if ((strncmp(ws->line, g_http10, strlen(g_http10)) == 0) ||
               (strncmp(ws->line, g_http11, strlen(g_http11)) == 0))
             {
@@ -496,7 +562,12 @@ static inline int wget_parsestatus(struct webclient_context *ctx,
           ws->state = WEBCLIENT_STATE_HEADERS;
           ws->internal_flags &= ~(WGET_FLAG_GOT_CONTENT_LENGTH |
                                   WGET_FLAG_CHUNKED |
-                                  WGET_FLAG_GOT_LOCATION);
+                                  WGET_FLAG_GOT_LOCATION |
+                                  WGET_FLAG_CONN_CLOSE |
+                                  WGET_FLAG_GZIP);
+#ifdef CONFIG_WEBCLIENT_GZIP
+          zstream_deinit(&ws->zs);
+#endif
           ndx = 0;
           break;
         }
@@ -752,6 +823,46 @@ static inline int wget_parseheaders(struct webclient_context *ctx,
                   ninfo("transfer encodings: '%s'\n", encodings);
                   ws->internal_flags |= WGET_FLAG_CHUNKED;
                 }
+#ifdef CONFIG_WEBCLIENT_GZIP
+              else if ((ctx->flags & WEBCLIENT_FLAG_GZIP) != 0 &&
+                       strncasecmp(ws->line, g_httpcontentencoding,
+                                   strlen(g_httpcontentencoding)) == 0)
+                {
+                  FAR const char *encodings =
+                      ws->line + strlen(g_httpcontentencoding);
+
+                  found = true;
+                  zstream_deinit(&ws->zs);
+                  if (strcasecmp(encodings, "gzip") == 0 ||
+                      strcasecmp(encodings, "x-gzip") == 0 ||
+                      strcasecmp(encodings, "deflate") == 0)
+                    {
+                      ret = zstream_init(&ws->zs, ZSTREAM_INFLATE, NULL);
+                      if (ret < 0)
+                        {
+                          goto exit;
+                        }
+
+                      ws->internal_flags |= WGET_FLAG_GZIP;
+                    }
+                  else if (strcasecmp(encodings, "identity") != 0)
+                    {
+                      nerr("unknown content encodings: '%s'\n", encodings);
+                      return -EPROTO;
+                    }
+                }
+#endif
+#ifdef CONFIG_WEBCLIENT_CONNPOOL
+              else if (strncasecmp(ws->line, g_httpconnection,
+                                   strlen(g_httpconnection)) == 0)
+                {
+                  if (strcasestr(ws->line + strlen(g_httpconnection),
+                                 "close") != NULL)
+                    {
+                      ws->internal_flags |= WGET_FLAG_CONN_CLOSE;
+                    }
+                }
+#endif
             }
 
           if (found && !got_nl)
@@ -1012,6 +1123,481 @@ static inline int wget_parsechunktrailer(struct webclient_context *ctx,
   return ret;
 }
 
+/****************************************************************************
+ * Name: wget_body_complete
+ *
+ * Description:
+ *   On a persistent connection the end of the response can not be
+ *   detected by the server closing the connection.  Return true once the
+ *   whole response has been received.
+ *
+ ****************************************************************************/
+
+static bool wget_body_complete(FAR struct webclient_context *ctx,
+                               FAR struct wget_s *ws)
+{
+  if (ws->state == WEBCLIENT_STATE_WAIT_CLOSE)
+    {
+      /* The last chunk and the trailer of a chunked body were received */
+
+      return true;
+    }
+
+  if (ws->state != WEBCLIENT_STATE_DATA)
+    {
+      return false;
+    }
+
+  /* Responses that never have a body */
+
+  if (strcmp(ctx->method, "HEAD") == 0 || ctx->http_status / 100 == 1 ||
+      ctx->http_status == 204 || ctx->http_status == 304)
+    {
+      return true;
+    }
+
+  return (ws->internal_flags & WGET_FLAG_GOT_CONTENT_LENGTH) != 0 &&
+         ws->received_body_len >= ws->expected_resp_body_len;
+}
+
+#ifdef CONFIG_WEBCLIENT_CONNPOOL
+/****************************************************************************
+ * Name: wget_pool_now
+ ****************************************************************************/
+
+static time_t wget_pool_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+/****************************************************************************
+ * Name: wget_pool_eligible
+ *
+ * Description:
+ *   Only HTTP/1.1 requests without a proxy use pooled connections.  The
+ *   request body must be replayable because a request on a pooled
+ *   connection is retried on a fresh one if the server has dropped the
+ *   idle connection in the meantime.
+ *
+ ****************************************************************************/
+
+static bool wget_pool_eligible(FAR struct webclient_context *ctx)
+{
+  return ctx->protocol_version == WEBCLIENT_PROTOCOL_VERSION_HTTP_1_1 &&
+         (ctx->flags & WEBCLIENT_FLAG_TUNNEL) == 0 &&
+         ctx->proxy == NULL &&
+#if defined(CONFIG_WEBCLIENT_NET_LOCAL)
+         ctx->unix_socket_path == NULL &&
+#endif
+         (ctx->bodylen == 0 || ctx->body_iov != NULL ||
+          ctx->body_callback == webclient_static_body_func);
+}
+
+/****************************************************************************
+ * Name: wget_pool_release
+ *
+ * Description:
+ *   Close and forget a pooled connection.  Called with the pool locked.
+ *
+ ****************************************************************************/
+
+static void wget_pool_release(FAR struct wget_pool_entry_s *entry)
+{
+  webclient_conn_close(entry->conn);
+  webclient_conn_free(entry->conn);
+  entry->conn = NULL;
+}
+
+/****************************************************************************
+ * Name: wget_pool_expire
+ *
+ * Description:
+ *   Close the connections that have been idle for too long.  Called with
+ *   the pool locked.
+ *
+ ****************************************************************************/
+
+static void wget_pool_expire(time_t now)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_WEBCLIENT_CONNPOOL_SIZE; i++)
+    {
+      if (g_wget_pool[i].conn != NULL &&
+          now - g_wget_pool[i].idle_since >=
+          CONFIG_WEBCLIENT_CONNPOOL_IDLE_SEC)
+        {
+          ninfo("Closing idle connection to %s:%u\n",
+                g_wget_pool[i].hostname, g_wget_pool[i].port);
+          wget_pool_release(&g_wget_pool[i]);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: wget_pool_take
+ *
+ * Description:
+ *   Move an idle connection to the current target into conn.  Returns
+ *   true if one was found.
+ *
+ ****************************************************************************/
+
+static bool wget_pool_take(FAR struct webclient_context *ctx,
+                           FAR struct wget_s *ws,
+                           FAR struct webclient_conn_s *conn)
+{
+  FAR struct wget_pool_entry_s *entry;
+  struct pollfd pfd;
+  bool nonblock = (ctx->flags & WEBCLIENT_FLAG_NON_BLOCKING) != 0;
+  bool found = false;
+  int i;
+
+  pthread_mutex_lock(&g_wget_pool_lock);
+  wget_pool_expire(wget_pool_now());
+
+  for (i = 0; i < CONFIG_WEBCLIENT_CONNPOOL_SIZE && !found; i++)
+    {
+      entry = &g_wget_pool[i];
+      if (entry->conn == NULL || entry->conn->tls != conn->tls ||
+          entry->port != ws->target.port ||
+          strcmp(entry->hostname, ws->target.hostname) != 0 ||
+          (conn->tls && (entry->tls_ops != ctx->tls_ops ||
+                         entry->tls_ctx != ctx->tls_ctx ||
+                         entry->nonblock != nonblock)))
+        {
+          continue;
+        }
+
+      /* An idle plain socket must not be readable: that would mean the
+       * server closed it or sent something unsolicited.
+       */
+
+      if (!entry->conn->tls)
+        {
+          pfd.fd      = entry->conn->sockfd;
+          pfd.events  = POLLIN;
+          pfd.revents = 0;
+          if (poll(&pfd, 1, 0) != 0)
+            {
+              wget_pool_release(entry);
+              continue;
+            }
+        }
+
+      *conn = *entry->conn;
+      webclient_conn_free(entry->conn);
+      entry->conn = NULL;
+      found = true;
+    }
+
+  pthread_mutex_unlock(&g_wget_pool_lock);
+
+  if (found)
+    {
+      ninfo("Reusing connection to %s:%u\n",
+            ws->target.hostname, ws->target.port);
+
+      if (!conn->tls)
+        {
+          struct timeval tv;
+          int flags;
+
+          /* The previous user may have used the other I/O mode.  A TLS
+           * connection is only handed to a user of the same mode since
+           * its I/O mode is up to the TLS implementation.
+           */
+
+          flags = fcntl(conn->sockfd, F_GETFL, 0);
+          fcntl(conn->sockfd, F_SETFL,
+                nonblock ? flags | O_NONBLOCK : flags & ~O_NONBLOCK);
+
+          /* The timeouts of the previous user may differ */
+
+          tv.tv_sec  = nonblock ? 0 : ctx->timeout_sec;
+          tv.tv_usec = 0;
+          setsockopt(conn->sockfd, SOL_SOCKET, SO_RCVTIMEO,
+                     &tv, sizeof(struct timeval));
+          setsockopt(conn->sockfd, SOL_SOCKET, SO_SNDTIMEO,
+                     &tv, sizeof(struct timeval));
+        }
+    }
+
+  return found;
+}
+
+/****************************************************************************
+ * Name: wget_pool_put
+ *
+ * Description:
+ *   Keep the connection of a completed request for later reuse.  If the
+ *   pool is full, the connection that has been idle the longest is closed.
+ *   Returns false (and leaves conn alone) if the connection could not be
+ *   pooled.
+ *
+ ****************************************************************************/
+
+static bool wget_pool_put(FAR struct webclient_context *ctx,
+                          FAR struct wget_s *ws,
+                          FAR struct webclient_conn_s *conn)
+{
+  FAR struct wget_pool_entry_s *victim = NULL;
+  FAR struct webclient_conn_s *pooled;
+  time_t now;
+  int i;
+
+  pooled = malloc(sizeof(struct webclient_conn_s));
+  if (pooled == NULL)
+    {
+      return false;
+    }
+
+  *pooled = *conn;
+  now     = wget_pool_now();
+
+  pthread_mutex_lock(&g_wget_pool_lock);
+  wget_pool_expire(now);
+
+  for (i = 0; i < CONFIG_WEBCLIENT_CONNPOOL_SIZE; i++)
+    {
+      if (g_wget_pool[i].conn == NULL)
+        {
+          victim = &g_wget_pool[i];
+          break;
+        }
+
+      if (victim == NULL || g_wget_pool[i].idle_since < victim->idle_since)
+        {
+          victim = &g_wget_pool[i];
+        }
+    }
+
+  if (victim->conn != NULL)
+    {
+      wget_pool_release(victim);
+    }
+
+  victim->conn       = pooled;
+  victim->tls_ops    = conn->tls_ops;
+  victim->tls_ctx    = conn->tls_ctx;
+  victim->idle_since = now;
+  victim->port       = ws->target.port;
+  victim->nonblock   = (ctx->flags & WEBCLIENT_FLAG_NON_BLOCKING) != 0;
+  strlcpy(victim->hostname, ws->target.hostname, sizeof(victim->hostname));
+
+  pthread_mutex_unlock(&g_wget_pool_lock);
+  return true;
+}
+#endif /* CONFIG_WEBCLIENT_CONNPOOL */
+
+/****************************************************************************
+ * Name: wget_retry_stale
+ *
+ * Description:
+ *   A pooled connection can be closed by the server at any time while it
+ *   is idle.  If the request on it failed before any part of the response
+ *   arrived, close it and start over with a new connection.
+ *
+ ****************************************************************************/
+
+static bool wget_retry_stale(FAR struct wget_s *ws,
+                             FAR struct webclient_conn_s *conn)
+{
+  if (!ws->reused || ws->ndx != 0 ||
+      (ws->state != WEBCLIENT_STATE_SEND_REQUEST &&
+       ws->state != WEBCLIENT_STATE_SEND_REQUEST_BODY &&
+       ws->state != WEBCLIENT_STATE_STATUSLINE))
+    {
+      return false;
+    }
+
+  ninfo("Pooled connection was closed by the server, reconnecting\n");
+  webclient_conn_close(conn);
+  ws->need_conn_close = false;
+  ws->reused          = false;
+  ws->state           = WEBCLIENT_STATE_SOCKET;
+  return true;
+}
+
+/****************************************************************************
+ * Name: wget_next_body
+ *
+ * Description:
+ *   Provide the next piece of a request body given with body_iov or
+ *   body_fd in ws->data_buffer/data_len.  iovec bodies are sent straight
+ *   from the caller's buffers.
+ *
+ ****************************************************************************/
+
+static int wget_next_body(FAR struct webclient_context *ctx,
+                          FAR struct wget_s *ws)
+{
+  size_t len;
+
+  if (ctx->body_iov != NULL)
+    {
+      while (ws->body_iovidx < ctx->body_iovcnt &&
+             ctx->body_iov[ws->body_iovidx].iov_len == 0)
+        {
+          ws->body_iovidx++;
+        }
+
+      if (ws->body_iovidx >= ctx->body_iovcnt)
+        {
+          nerr("ERROR: iovec body is shorter than bodylen\n");
+          return -EINVAL;
+        }
+
+      len = ctx->body_iov[ws->body_iovidx].iov_len;
+      if (len > ws->state_len)
+        {
+          len = ws->state_len;
+        }
+
+      ws->data_buffer = ctx->body_iov[ws->body_iovidx++].iov_base;
+    }
+  else
+    {
+      ssize_t nread;
+
+      len = ws->state_len;
+      if (len > (size_t)ws->buflen)
+        {
+          len = ws->buflen;
+        }
+
+      nread = read(ctx->body_fd, ws->buffer, len);
+      if (nread < 0)
+        {
+          return -errno;
+        }
+      else if (nread == 0)
+        {
+          nerr("ERROR: body file is shorter than bodylen\n");
+          return -EIO;
+        }
+
+      len = nread;
+      ws->data_buffer = ws->buffer;
+    }
+
+  ws->data_len     = len;
+  ws->state_offset = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: wget_write_sink
+ *
+ * Description:
+ *   Write received body data to webclient_context::sink_fd.
+ *
+ ****************************************************************************/
+
+static int wget_write_sink(int fd, FAR const char *data, size_t len)
+{
+  ssize_t nwritten;
+
+  while (len > 0)
+    {
+      nwritten = write(fd, data, len);
+      if (nwritten < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          nerr("ERROR: write to sink_fd failed: %d\n", errno);
+          return -errno;
+        }
+
+      data += nwritten;
+      len  -= nwritten;
+    }
+
+  return OK;
+}
+
+#ifdef CONFIG_WEBCLIENT_GZIP
+/****************************************************************************
+ * Name: wget_inflate
+ *
+ * Description:
+ *   Inflate a piece of an encoded body and hand the result to the sink of
+ *   the context.
+ *
+ ****************************************************************************/
+
+static int wget_inflate(FAR struct webclient_context *ctx,
+                        FAR struct wget_s *ws, FAR const char *data,
+                        size_t len)
+{
+  FAR char *buffer;
+  ssize_t nbytes;
+  int buflen;
+  int ret = OK;
+
+  while (len > 0)
+    {
+      nbytes = zstream_push(&ws->zs, data, len);
+      if (nbytes < 0)
+        {
+          nerr("ERROR: bad encoded body: %zd\n", nbytes);
+          return nbytes;
+        }
+
+      data += nbytes;
+      len  -= nbytes;
+
+      while ((nbytes = zstream_pull(&ws->zs, ws->zbuf,
+                                    sizeof(ws->zbuf))) > 0)
+        {
+          /* The sink can't swap this buffer */
+
+          buffer = ws->zbuf;
+          buflen = sizeof(ws->zbuf);
+
+          if (ctx->sink_fd >= 0)
+            {
+              ret = wget_write_sink(ctx->sink_fd, buffer, nbytes);
+            }
+          else if (ctx->sink_callback)
+            {
+              ret = ctx->sink_callback(&buffer, 0, nbytes, &buflen,
+                                       ctx->sink_callback_arg);
+            }
+          else if (ctx->callback)
+            {
+              ctx->callback(&buffer, 0, nbytes, &buflen,
+                            ctx->sink_callback_arg);
+            }
+
+          if (ret == OK &&
+              (buffer != ws->zbuf || buflen != sizeof(ws->zbuf)))
+            {
+              ret = -EINVAL;
+            }
+
+          if (ret != OK)
+            {
+              return ret;
+            }
+        }
+
+      if (nbytes < 0)
+        {
+          return nbytes;
+        }
+    }
+
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: wget_gethostip
  *
@@ -1315,8 +1901,21 @@ int webclient_perform(FAR struct webclient_context *ctx)
           ws->datend     = 0;
           ws->ndx        = 0;
           ws->redirected = 0;
+          ws->keepalive  = false;
+          ws->complete   = false;
+
+#ifdef CONFIG_WEBCLIENT_CONNPOOL
+          ws->keepalive  = wget_pool_eligible(ctx);
+          ws->reused     = ws->keepalive && wget_pool_take(ctx, ws, conn);
+#endif
 
-          if (conn->tls)
+          if (ws->reused)
+            {
+              /* Already connected */
+
+              ws->need_conn_close = true;
+            }
+          else if (conn->tls)
             {
 #if defined(CONFIG_WEBCLIENT_NET_LOCAL)
               if (ctx->unix_socket_path != NULL)
@@ -1445,7 +2044,8 @@ int webclient_perform(FAR struct webclient_context *ctx)
                 }
             }
 
-          ws->state = WEBCLIENT_STATE_CONNECT;
+          ws->state = ws->reused ? WEBCLIENT_STATE_PREPARE_REQUEST :
+                                   WEBCLIENT_STATE_CONNECT;
         }
 
       if (ws->state == WEBCLIENT_STATE_CONNECT)
@@ -1764,6 +2364,14 @@ int webclient_perform(FAR struct webclient_context *ctx)
                 }
             }
 
+#ifdef CONFIG_WEBCLIENT_GZIP
+          if ((ctx->flags & WEBCLIENT_FLAG_GZIP) != 0)
+            {
+              dest = append(dest, ep, g_httpacceptencoding);
+              dest = append(dest, ep, g_httpcrnl);
+            }
+#endif
+
           if (ctx->bodylen)
             {
               char post_size[sizeof("18446744073709551615")];
@@ -1774,9 +2382,10 @@ int webclient_perform(FAR struct webclient_context *ctx)
               dest = append(dest, ep, g_httpcrnl);
             }
 
-          if (ctx->protocol_version == WEBCLIENT_PROTOCOL_VERSION_HTTP_1_1)
+          if (ctx->protocol_version == WEBCLIENT_PROTOCOL_VERSION_HTTP_1_1 &&
+              !ws->keepalive)
             {
-              /* We don't implement persistect connections. */
+              /* Persistent connections are only used with the pool */
 
               dest = append(dest, ep, g_httpconn_close);
               dest = append(dest, ep, g_httpcrnl);
@@ -1807,6 +2416,11 @@ int webclient_perform(FAR struct webclient_context *ctx)
           if (ssz < 0)
             {
               ret = ssz;
+              if (wget_retry_stale(ws, conn))
+                {
+                  continue;
+                }
+
               nerr("ERROR: send failed: %d\n", -ret);
               goto errout_with_errno;
             }
@@ -1821,6 +2435,7 @@ int webclient_perform(FAR struct webclient_context *ctx)
                   ws->state_offset = 0;
                   ws->state_len = ctx->bodylen;
                   ws->data_buffer = NULL;
+                  ws->body_iovidx = 0;
                   ninfo("Sending %zu bytes request body\n", ws->state_len);
                 }
             }
@@ -1842,6 +2457,36 @@ int webclient_perform(FAR struct webclient_context *ctx)
               ninfo("Finished sending request body\n");
               ws->state = WEBCLIENT_STATE_STATUSLINE;
             }
+          else if (ctx->body_fd >= 0 && !conn->tls)
+            {
+              /* Let the network stack read the file */
+
+              ssize_t ssz = sendfile(conn->sockfd, ctx->body_fd, NULL,
+                                     ws->state_len);
+              if (ssz < 0)
+                {
+                  ret = -errno;
+                  nerr("ERROR: sendfile failed: %d\n", -ret);
+                  goto errout_with_errno;
+                }
+              else if (ssz == 0)
+                {
+                  nerr("ERROR: body file is shorter than bodylen\n");
+                  ret = -EIO;
+                  goto errout_with_errno;
+                }
+
+              ws->state_len -= ssz;
+            }
+          else if (ws->data_buffer == NULL &&
+                   (ctx->body_iov != NULL || ctx->body_fd >= 0))
+            {
+              ret = wget_next_body(ctx, ws);
+              if (ret < 0)
+                {
+                  goto errout_with_errno;
+                }
+            }
           else if (ws->data_buffer == NULL)
             {
               FAR const void *input_buffer;
@@ -1883,6 +2528,11 @@ int webclient_perform(FAR struct webclient_context *ctx)
               if (ssz < 0)
                 {
                   ret = ssz;
+                  if (wget_retry_stale(ws, conn))
+                    {
+                      continue;
+                    }
+
                   nerr("ERROR: send failed: %d\n", -ret);
                   goto errout_with_errno;
                 }
@@ -1935,6 +2585,11 @@ int webclient_perform(FAR struct webclient_context *ctx)
                     }
 
                   ssz = webclient_conn_recv(conn, ws->buffer, want);
+                  if (ssz <= 0 && wget_retry_stale(ws, conn))
+                    {
+                      break;
+                    }
+
                   if (ssz < 0)
                     {
                       ret = ssz;
@@ -2079,6 +2734,28 @@ int webclient_perform(FAR struct webclient_context *ctx)
                         {
                           /* We don't have data to give to the client yet. */
                         }
+#ifdef CONFIG_WEBCLIENT_GZIP
+                      else if ((ws->internal_flags & WGET_FLAG_GZIP) != 0)
+                        {
+                          ret = wget_inflate(ctx, ws,
+                                             ws->buffer + ws->offset,
+                                             received);
+                          if (ret != 0)
+                            {
+                              goto errout_with_errno;
+                            }
+                        }
+#endif
+                      else if (ctx->sink_fd >= 0)
+                        {
+                          ret = wget_write_sink(ctx->sink_fd,
+                                                ws->buffer + ws->offset,
+                                                received);
+                          if (ret != 0)
+                            {
+                              goto errout_with_errno;
+                            }
+                        }
                       else if (ctx->sink_callback)
                         {
                           ret = ctx->sink_callback(&ws->buffer, ws->offset,
@@ -2148,6 +2825,18 @@ int webclient_perform(FAR struct webclient_context *ctx)
                     }
                 }
 
+              /* Without "Connection: close" the server will not close the
+               * connection to mark the end of the response.
+               */
+
+              if (ws->keepalive && wget_body_complete(ctx, ws))
+                {
+                  ws->complete   = true;
+                  ws->state      = WEBCLIENT_STATE_CLOSE;
+                  ws->redirected = 0;
+                  break;
+                }
+
               if (ws->state == WEBCLIENT_STATE_TUNNEL_ESTABLISHED)
                 {
                   break;
@@ -2157,7 +2846,20 @@ int webclient_perform(FAR struct webclient_context *ctx)
 
       if (ws->state == WEBCLIENT_STATE_CLOSE)
         {
-          webclient_conn_close(conn);
+#ifdef CONFIG_WEBCLIENT_CONNPOOL
+          /* Keep the connection if the server agrees and nothing is left
+           * over from the response.
+           */
+
+          if (!ws->complete || ws->offset != ws->datend ||
+              (ws->internal_flags &
+               (WGET_FLAG_CONN_CLOSE | WGET_FLAG_HTTP10)) != 0 ||
+              !wget_pool_put(ctx, ws, conn))
+#endif
+            {
+              webclient_conn_close(conn);
+            }
+
           ws->need_conn_close = false;
           if (ws->redirected)
             {
@@ -2399,6 +3101,32 @@ int wget_post(FAR const char *url, FAR const char *posts, FAR char *buffer,
   return OK;
 }
 
+/****************************************************************************
+ * Name: webclient_pool_flush
+ *
+ * Description:
+ *   Close all idle connections kept by the connection pool.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WEBCLIENT_CONNPOOL
+void webclient_pool_flush(void)
+{
+  int i;
+
+  pthread_mutex_lock(&g_wget_pool_lock);
+  for (i = 0; i < CONFIG_WEBCLIENT_CONNPOOL_SIZE; i++)
+    {
+      if (g_wget_pool[i].conn != NULL)
+        {
+          wget_pool_release(&g_wget_pool[i]);
+        }
+    }
+
+  pthread_mutex_unlock(&g_wget_pool_lock);
+}
+#endif
+
 /****************************************************************************
  * Name: webclient_set_defaults
  ****************************************************************************/
@@ -2409,6 +3137,8 @@ void webclient_set_defaults(FAR struct webclient_context *ctx)
   ctx->protocol_version = WEBCLIENT_PROTOCOL_VERSION_HTTP_1_0;
   ctx->method = "GET";
   ctx->timeout_sec = CONFIG_WEBCLIENT_TIMEOUT;
+  ctx->body_fd = -1;
+  ctx->sink_fd = -1;
   _SET_STATE(ctx, WEBCLIENT_CONTEXT_STATE_INITIALIZED);
 }
 
@@ -2427,6 +3157,52 @@ void webclient_set_static_body(FAR struct webclient_context *ctx,
   ctx->bodylen = bodylen;
 }
 
+/****************************************************************************
+ * Name: webclient_set_iov_body
+ *
+ * Description:
+ *   Send the request body from a list of buffers without copying them.
+ *   The buffers must stay valid until the request completes.
+ *
+ ****************************************************************************/
+
+void webclient_set_iov_body(FAR struct webclient_context *ctx,
+                            FAR const struct iovec *iov,
+                            unsigned int iovcnt)
+{
+  unsigned int i;
+
+  _CHECK_STATE(ctx, WEBCLIENT_CONTEXT_STATE_INITIALIZED);
+
+  ctx->body_callback = NULL;
+  ctx->body_iov = iov;
+  ctx->body_iovcnt = iovcnt;
+  ctx->bodylen = 0;
+  for (i = 0; i < iovcnt; i++)
+    {
+      ctx->bodylen += iov[i].iov_len;
+    }
+}
+
+/****************************************************************************
+ * Name: webclient_set_fd_body
+ *
+ * Description:
+ *   Send bodylen bytes read from fd, starting at its current position, as
+ *   the request body.
+ *
+ ****************************************************************************/
+
+void webclient_set_fd_body(FAR struct webclient_context *ctx,
+                           int fd, size_t bodylen)
+{
+  _CHECK_STATE(ctx, WEBCLIENT_CONTEXT_STATE_INITIALIZED);
+
+  ctx->body_callback = NULL;
+  ctx->body_fd = fd;
+  ctx->bodylen = bodylen;
+}
+
 /****************************************************************************
  * Name: webclient_get_poll_info
  *
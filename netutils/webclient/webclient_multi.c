@@ -0,0 +1,407 @@
+/****************************************************************************
+ * apps/netutils/webclient/webclient_multi.c
+ * Drive many non-blocking webclient requests from one thread
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "netutils/webclient.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: multi_now
+ ****************************************************************************/
+
+static uint32_t multi_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/****************************************************************************
+ * Name: multi_originlen
+ *
+ * Description:
+ *   Return the length of the "scheme://host:port" part of a URL.
+ *
+ ****************************************************************************/
+
+static size_t multi_originlen(FAR const char *url)
+{
+  FAR const char *cp = strstr(url, "://");
+
+  cp = cp != NULL ? cp + 3 : url;
+  return cp - url + strcspn(cp, "/?#");
+}
+
+/****************************************************************************
+ * Name: multi_sameorigin
+ ****************************************************************************/
+
+static bool multi_sameorigin(FAR struct webclient_context *a,
+                             FAR struct webclient_context *b)
+{
+  size_t len;
+
+  if ((a->flags & WEBCLIENT_FLAG_TUNNEL) != 0 ||
+      (b->flags & WEBCLIENT_FLAG_TUNNEL) != 0)
+    {
+      return false;
+    }
+
+  len = multi_originlen(a->url);
+  return len == multi_originlen(b->url) &&
+         strncasecmp(a->url, b->url, len) == 0;
+}
+
+/****************************************************************************
+ * Name: multi_canstart
+ *
+ * Description:
+ *   With WEBCLIENT_MULTI_FLAG_PIPELINE, a request waits until all earlier
+ *   requests to the same server have finished.
+ *
+ ****************************************************************************/
+
+static bool multi_canstart(FAR struct webclient_multi_s *multi,
+                           FAR struct webclient_multi_entry_s *entry)
+{
+  FAR struct webclient_multi_entry_s *other;
+  int i;
+
+  if ((multi->flags & WEBCLIENT_MULTI_FLAG_PIPELINE) == 0)
+    {
+      return true;
+    }
+
+  for (i = 0; i < CONFIG_WEBCLIENT_MULTI_MAX; i++)
+    {
+      other = &multi->entries[i];
+      if (other != entry && other->ctx != NULL &&
+          (other->started || (int32_t)(other->seqno - entry->seqno) < 0) &&
+          multi_sameorigin(other->ctx, entry->ctx))
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: multi_finish
+ *
+ * Description:
+ *   Release the slot of a finished request and notify the user.  The
+ *   callback may add new requests.
+ *
+ ****************************************************************************/
+
+static void multi_finish(FAR struct webclient_multi_s *multi,
+                         FAR struct webclient_multi_entry_s *entry,
+                         int result)
+{
+  FAR struct webclient_context *ctx = entry->ctx;
+  webclient_multi_done_t done = entry->done;
+  FAR void *arg = entry->arg;
+
+  ninfo("Request %s finished: %d\n", ctx->url, result);
+
+  memset(entry, 0, sizeof(*entry));
+  multi->nentries--;
+
+  if (done != NULL)
+    {
+      done(ctx, result, arg);
+    }
+}
+
+/****************************************************************************
+ * Name: multi_perform
+ ****************************************************************************/
+
+static void multi_perform(FAR struct webclient_multi_s *multi,
+                          FAR struct webclient_multi_entry_s *entry)
+{
+  int ret;
+
+  ret = webclient_perform(entry->ctx);
+  if (ret != -EAGAIN)
+    {
+      multi_finish(multi, entry, ret);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: webclient_multi_init
+ *
+ * Description:
+ *   Initialize an empty set of requests.
+ *
+ * Input Parameters:
+ *   multi - The set to initialize
+ *   flags - OR'ed WEBCLIENT_MULTI_FLAG_xxx values
+ *
+ ****************************************************************************/
+
+void webclient_multi_init(FAR struct webclient_multi_s *multi,
+                          unsigned int flags)
+{
+  memset(multi, 0, sizeof(*multi));
+  multi->flags = flags;
+}
+
+/****************************************************************************
+ * Name: webclient_multi_add
+ *
+ * Description:
+ *   Add a request to the set.  ctx must have been prepared as for
+ *   webclient_perform(); WEBCLIENT_FLAG_NON_BLOCKING is set on it.  The
+ *   request is started by the next webclient_multi_run().
+ *
+ * Returned Value:
+ *   0 on success, -ENOSPC if CONFIG_WEBCLIENT_MULTI_MAX requests are
+ *   already in the set.
+ *
+ ****************************************************************************/
+
+int webclient_multi_add(FAR struct webclient_multi_s *multi,
+                        FAR struct webclient_context *ctx,
+                        webclient_multi_done_t done, FAR void *arg)
+{
+  FAR struct webclient_multi_entry_s *entry;
+  int i;
+
+  DEBUGASSERT(multi != NULL && ctx != NULL);
+
+  for (i = 0; i < CONFIG_WEBCLIENT_MULTI_MAX; i++)
+    {
+      entry = &multi->entries[i];
+      if (entry->ctx == NULL)
+        {
+          ctx->flags    |= WEBCLIENT_FLAG_NON_BLOCKING;
+          entry->ctx     = ctx;
+          entry->done    = done;
+          entry->arg     = arg;
+          entry->seqno   = multi->seqno++;
+          entry->started = false;
+          multi->nentries++;
+          return OK;
+        }
+    }
+
+  return -ENOSPC;
+}
+
+/****************************************************************************
+ * Name: webclient_multi_remove
+ *
+ * Description:
+ *   Remove a request from the set, aborting it if it has been started.
+ *   The done callback is not called.
+ *
+ ****************************************************************************/
+
+void webclient_multi_remove(FAR struct webclient_multi_s *multi,
+                            FAR struct webclient_context *ctx)
+{
+  FAR struct webclient_multi_entry_s *entry;
+  int i;
+
+  for (i = 0; i < CONFIG_WEBCLIENT_MULTI_MAX; i++)
+    {
+      entry = &multi->entries[i];
+      if (entry->ctx == ctx)
+        {
+          if (entry->started)
+            {
+              webclient_abort(ctx);
+            }
+
+          memset(entry, 0, sizeof(*entry));
+          multi->nentries--;
+          return;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: webclient_multi_run
+ *
+ * Description:
+ *   Start the requests that can be started, wait up to timeout_ms
+ *   milliseconds (forever if negative) for I/O on the ones in progress
+ *   and advance them.  Requests that finish or time out are removed from
+ *   the set and reported to their done callback.
+ *
+ *   A typical event loop:
+ *
+ *     while (webclient_multi_run(&multi, -1) > 0)
+ *       {
+ *       }
+ *
+ * Returned Value:
+ *   The number of requests still in the set, or a negated errno value if
+ *   poll() failed.
+ *
+ ****************************************************************************/
+
+int webclient_multi_run(FAR struct webclient_multi_s *multi, int timeout_ms)
+{
+  FAR struct webclient_multi_entry_s *entry;
+  struct webclient_poll_info info;
+  struct pollfd pfds[CONFIG_WEBCLIENT_MULTI_MAX];
+  uint8_t slots[CONFIG_WEBCLIENT_MULTI_MAX];
+  uint32_t now;
+  int32_t left;
+  int npfds;
+  int ret;
+  int i;
+
+  /* Start new requests.  A request that does not need to wait for I/O
+   * finishes right here.
+   */
+
+  now = multi_now();
+  for (i = 0; i < CONFIG_WEBCLIENT_MULTI_MAX; i++)
+    {
+      entry = &multi->entries[i];
+      if (entry->ctx != NULL && !entry->started &&
+          multi_canstart(multi, entry))
+        {
+          entry->started  = true;
+          entry->deadline = now + entry->ctx->timeout_sec * 1000;
+          multi_perform(multi, entry);
+        }
+    }
+
+  /* Collect what the requests in progress are waiting for */
+
+  npfds = 0;
+  for (i = 0; i < CONFIG_WEBCLIENT_MULTI_MAX; i++)
+    {
+      entry = &multi->entries[i];
+      if (entry->ctx == NULL || !entry->started)
+        {
+          continue;
+        }
+
+      ret = webclient_get_poll_info(entry->ctx, &info);
+      if (ret < 0)
+        {
+          webclient_abort(entry->ctx);
+          multi_finish(multi, entry, ret);
+          continue;
+        }
+
+      pfds[npfds].fd      = info.fd;
+      pfds[npfds].events  = 0;
+      pfds[npfds].revents = 0;
+      if ((info.flags & WEBCLIENT_POLL_INFO_WANT_READ) != 0)
+        {
+          pfds[npfds].events |= POLLIN;
+        }
+
+      if ((info.flags & WEBCLIENT_POLL_INFO_WANT_WRITE) != 0)
+        {
+          pfds[npfds].events |= POLLOUT;
+        }
+
+      if (entry->ctx->timeout_sec > 0)
+        {
+          left = (int32_t)(entry->deadline - now);
+          if (left < 0)
+            {
+              left = 0;
+            }
+
+          if (timeout_ms < 0 || left < timeout_ms)
+            {
+              timeout_ms = left;
+            }
+        }
+
+      slots[npfds++] = i;
+    }
+
+  if (npfds == 0)
+    {
+      /* Either the set is empty, or requests that were waiting for their
+       * predecessors can be started by the next call.
+       */
+
+      return multi->nentries;
+    }
+
+  ret = poll(pfds, npfds, timeout_ms);
+  if (ret < 0)
+    {
+      ret = -errno;
+      nerr("ERROR: poll failed: %d\n", ret);
+      return ret;
+    }
+
+  now = multi_now();
+  for (i = 0; i < npfds; i++)
+    {
+      entry = &multi->entries[slots[i]];
+
+      /* The done callback of an earlier entry may have reused the slot */
+
+      if (entry->ctx == NULL || !entry->started)
+        {
+          continue;
+        }
+
+      if (pfds[i].revents != 0)
+        {
+          multi_perform(multi, entry);
+        }
+      else if (entry->ctx->timeout_sec > 0 &&
+               (int32_t)(entry->deadline - now) <= 0)
+        {
+          nwarn("WARNING: Request %s timed out\n", entry->ctx->url);
+          webclient_abort(entry->ctx);
+          multi_finish(multi, entry, -ETIMEDOUT);
+        }
+    }
+
+  return multi->nentries;
+}
@@ -56,37 +56,106 @@
 #include <stdio.h>
 #include "netutils/xmlrpc.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define XMLRPC_HEADER1   "HTTP/1.1 200 OK\n" \
+                         "Connection: close\n" \
+                         "Content-length: "
+#define XMLRPC_HEADER2   "\n" \
+                         "Content-Type: text/xml\n" \
+                         "Server: Lightweight XMLRPC\n\n"
+
+/* The Content-length digits are patched in once the body is complete */
+
+#define XMLRPC_HEADER    XMLRPC_HEADER1 "xyza" XMLRPC_HEADER2
+#define LENGTH_OFFSET    (sizeof(XMLRPC_HEADER1) - 1)
+#define BODY_OFFSET      (sizeof(XMLRPC_HEADER) - 1)
+
+#define xmlrpc_putlit(x, s) xmlrpc_put(x, s, sizeof(s) - 1)
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
-static int xmlrpc_insertlength(struct xmlrpc_s *xmlcall)
+/* Append to the response at its tracked length, truncating what doesn't
+ * fit.
+ */
+
+static void xmlrpc_put(FAR struct xmlrpc_s *xmlcall, FAR const char *str,
+                       size_t len)
 {
-  int xdigit = 1000;
-  int i = 0;
-  int len;
-  int digit;
-  char *temp;
+  size_t avail = sizeof(xmlcall->response) - 1 - xmlcall->responselen;
 
-  temp = strstr(xmlcall->response, "<?xml");
-  len = strlen(temp);
+  if (len > avail)
+    {
+      len = avail;
+    }
+
+  memcpy(&xmlcall->response[xmlcall->responselen], str, len);
+  xmlcall->responselen += len;
+  xmlcall->response[xmlcall->responselen] = '\0';
+}
+
+static void xmlrpc_printf(FAR struct xmlrpc_s *xmlcall,
+                          FAR const char *fmt, ...)
+{
+  int avail = sizeof(xmlcall->response) - xmlcall->responselen;
+  va_list ap;
+  int n;
 
-  temp = strstr(xmlcall->response, "xyza");
+  va_start(ap, fmt);
+  n = vsnprintf(&xmlcall->response[xmlcall->responselen], avail, fmt, ap);
+  va_end(ap);
 
-  do
+  if (n > 0)
     {
-      digit = (len / xdigit);
-      len -= (digit * xdigit);
-      xdigit /= 10;
+      xmlcall->responselen += n < avail ? n : avail - 1;
+    }
+}
 
-      if ((digit == 0) && (xdigit > 1))
-        temp[i++] = ' ';
+/* Append a string with the XML markup characters escaped */
+
+static void xmlrpc_putescaped(FAR struct xmlrpc_s *xmlcall,
+                              FAR const char *str)
+{
+  FAR const char *run = str;
+
+  for (; *str != '\0'; str++)
+    {
+      if (*str != '<' && *str != '>' && *str != '&')
+        {
+          continue;
+        }
+
+      xmlrpc_put(xmlcall, run, str - run);
+      if (*str == '<')
+        {
+          xmlrpc_putlit(xmlcall, "&lt;");
+        }
+      else if (*str == '>')
+        {
+          xmlrpc_putlit(xmlcall, "&gt;");
+        }
       else
-        temp[i++] = (0x30 + digit);
+        {
+          xmlrpc_putlit(xmlcall, "&amp;");
+        }
+
+      run = str + 1;
     }
-  while (i < 4);
 
-  return 0;
+  xmlrpc_put(xmlcall, run, str - run);
+}
+
+static void xmlrpc_insertlength(FAR struct xmlrpc_s *xmlcall)
+{
+  char digits[12];
+
+  snprintf(digits, sizeof(digits), "%4d",
+           xmlcall->responselen - (int)BODY_OFFSET);
+  memcpy(&xmlcall->response[LENGTH_OFFSET], digits, 4);
 }
 
 /****************************************************************************
@@ -164,39 +233,28 @@ int xmlrpc_getstring(struct xmlrpc_s *xmlcall, char *arg)
 int xmlrpc_buildresponse(struct xmlrpc_s *xmlcall, char *args, ...)
 {
   va_list argp;
-  int next = 0;
   int index = 0;
   int close = 0;
   int isstruct = 0;
-  int i;
-  double d;
-  char *s;
 
   if ((xmlcall == NULL) || (args == NULL))
     {
       return -1;
     }
 
-  strlcpy(xmlcall->response, "HTTP/1.1 200 OK\n"
-          "Connection: close\n"
-          "Content-length: xyza\n"
-          "Content-Type: text/xml\n"
-          "Server: Lightweight XMLRPC\n\n"
-          "<?xml version=\"1.0\"?>\n" "<methodResponse>\n",
-          sizeof(xmlcall->response));
+  xmlcall->responselen = 0;
+  xmlrpc_putlit(xmlcall, XMLRPC_HEADER
+                "<?xml version=\"1.0\"?>\n" "<methodResponse>\n");
 
   if (xmlcall->error)
     {
-      strlcat(xmlcall->response, "  <fault>\n",
-              sizeof(xmlcall->response));
+      xmlrpc_putlit(xmlcall, "  <fault>\n");
     }
   else
     {
-      strlcat(xmlcall->response, "  <params><param>\n",
-              sizeof(xmlcall->response));
+      xmlrpc_putlit(xmlcall, "  <params><param>\n");
     }
 
-  next = strlen(xmlcall->response);
   va_start(argp, args);
 
   while (args[index])
@@ -205,15 +263,9 @@ int xmlrpc_buildresponse(struct xmlrpc_s *xmlcall, char *args, ...)
         {
           if ((args[index] != '{') && (args[index] != '}'))
             {
-              snprintf(&xmlcall->response[next],
-                       sizeof(xmlcall->response) - next,
-                       "  <member>\n");
-              next += strlen(&xmlcall->response[next]);
-              snprintf(&xmlcall->response[next],
-                       sizeof(xmlcall->response) - next,
-                       "    <name>%s</name>\n",
-                       va_arg(argp, char *));
-              next += strlen(&xmlcall->response[next]);
+              xmlrpc_putlit(xmlcall, "  <member>\n    <name>");
+              xmlrpc_putescaped(xmlcall, va_arg(argp, char *));
+              xmlrpc_putlit(xmlcall, "</name>\n");
               close = 1;
             }
         }
@@ -221,59 +273,46 @@ int xmlrpc_buildresponse(struct xmlrpc_s *xmlcall, char *args, ...)
       switch (args[index])
         {
         case '{':
-          snprintf(&xmlcall->response[next],
-                   sizeof(xmlcall->response) - next,
-                   "  <value><struct>\n");
+          xmlrpc_putlit(xmlcall, "  <value><struct>\n");
           isstruct = 1;
           break;
 
         case '}':
-          snprintf(&xmlcall->response[next],
-                   sizeof(xmlcall->response) - next,
-                   "  </struct></value>\n");
+          xmlrpc_putlit(xmlcall, "  </struct></value>\n");
           isstruct = 0;
           break;
 
         case 'i':
-          i = va_arg(argp, int);
-          snprintf(&xmlcall->response[next],
-                   sizeof(xmlcall->response) - next,
-                   "    <value><int>%d</int></value>\r\n", i);
+          xmlrpc_printf(xmlcall, "    <value><int>%d</int></value>\r\n",
+                        va_arg(argp, int));
           break;
 
         case 'b':
-          i = va_arg(argp, int);
-          snprintf(&xmlcall->response[next],
-                  sizeof(xmlcall->response) - next,
-                  "    <value><boolean>%d</boolean></value>\r\n", i);
+          xmlrpc_printf(xmlcall,
+                        "    <value><boolean>%d</boolean></value>\r\n",
+                        va_arg(argp, int));
           break;
 
         case 'd':
-          d = va_arg(argp, double);
-          snprintf(&xmlcall->response[next],
-                   sizeof(xmlcall->response) - next,
-                   "    <value><double>%f</double></value>\r\n", d);
+          xmlrpc_printf(xmlcall,
+                        "    <value><double>%f</double></value>\r\n",
+                        va_arg(argp, double));
           break;
 
         case 's':
-          s = va_arg(argp, char *);
-          snprintf(&xmlcall->response[next],
-                   sizeof(xmlcall->response) - next,
-                   "    <value><string>%s</string></value>\r\n", s);
+          xmlrpc_putlit(xmlcall, "    <value><string>");
+          xmlrpc_putescaped(xmlcall, va_arg(argp, char *));
+          xmlrpc_putlit(xmlcall, "</string></value>\r\n");
           break;
 
         default:
+          va_end(argp);
           return (XMLRPC_BAD_RESPONSE_ARG);
-          break;
         }
 
-      next += strlen(&xmlcall->response[next]);
       if (close)
         {
-          snprintf(&xmlcall->response[next],
-                   sizeof(xmlcall->response) - next,
-                   "  </member>\n");
-          next += strlen(&xmlcall->response[next]);
+          xmlrpc_putlit(xmlcall, "  </member>\n");
           close = 0;
         }
 
@@ -284,17 +323,14 @@ int xmlrpc_buildresponse(struct xmlrpc_s *xmlcall, char *args, ...)
 
   if (xmlcall->error)
     {
-      strlcat(xmlcall->response, "  </fault>\r\n",
-              sizeof(xmlcall->response));
+      xmlrpc_putlit(xmlcall, "  </fault>\r\n");
     }
   else
     {
-      strlcat(xmlcall->response, "  </param></params>\r\n",
-              sizeof(xmlcall->response));
+      xmlrpc_putlit(xmlcall, "  </param></params>\r\n");
     }
 
-  strlcat(xmlcall->response, "</methodResponse>\r\n",
-          sizeof(xmlcall->response));
+  xmlrpc_putlit(xmlcall, "</methodResponse>\r\n");
 
   xmlrpc_insertlength(xmlcall);
   return 0;
@@ -51,6 +51,7 @@
  ****************************************************************************/
 
 #include <ctype.h>
+#include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -58,19 +59,34 @@
 #include "netutils/xmlrpc.h"
 
 /****************************************************************************
- * Pre-processor Definitions
+ * Private Types
  ****************************************************************************/
 
-#define TAG        0
-#define VALUE      1
-#define DONE       2
+/* The request is parsed in place, in a single pass over the buffer */
+
+struct parsebuf_s
+{
+  FAR const char *pos;
+};
+
+struct xmlrpc_type_s
+{
+  FAR const char *open;
+  FAR const char *close;
+  char type;
+};
+
+struct xmlrpc_entity_s
+{
+  FAR const char *name;
+  char c;
+};
 
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
 static struct xmlrpc_s g_xmlcall;
-static char g_data[CONFIG_XMLRPC_STRINGSIZE + 1];
 static struct xmlrpc_entry_s *g_entries = NULL;
 
 static const char *g_error_strings[] =
@@ -87,13 +103,28 @@ static const char *g_error_strings[] =
 
 #define MAX_ERROR_CODE  (sizeof(g_error_strings)/sizeof(char *))
 
-struct parsebuf_s
+static const struct xmlrpc_type_s g_xmltypes[] =
+{
+  { "<i4>",      "</i4>",      'i' },
+  { "<int>",     "</int>",     'i' },
+  { "<boolean>", "</boolean>", 'b' },
+  { "<double>",  "</double>",  'd' },
+  { "<string>",  "</string>",  's' }
+};
+
+#define NTYPES  (sizeof(g_xmltypes) / sizeof(g_xmltypes[0]))
+
+static const struct xmlrpc_entity_s g_xmlentities[] =
 {
-  char *buf;
-  int len;
-  int index;
+  { "&lt;",   '<'  },
+  { "&gt;",   '>'  },
+  { "&amp;",  '&'  },
+  { "&quot;", '"'  },
+  { "&apos;", '\'' }
 };
 
+#define NENTITIES  (sizeof(g_xmlentities) / sizeof(g_xmlentities[0]))
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -119,227 +150,222 @@ static int xmlrpc_call(struct xmlrpc_s *call)
   return ret;
 }
 
-static int xmlrpc_getelement(struct parsebuf_s *pbuf, char *data, int size)
+static void xmlrpc_skipspace(FAR struct parsebuf_s *pbuf)
 {
-  int j = 0;
-  int ret = XMLRPC_NO_ERROR;
-
-  while (pbuf->index < pbuf->len && !isprint(pbuf->buf[pbuf->index]))
+  while (isspace((unsigned char)*pbuf->pos))
     {
-      pbuf->index++;
+      pbuf->pos++;
     }
+}
 
-  if (pbuf->index >= pbuf->len)
-    {
-      return DONE;
-    }
+/* Consume tag if it is the next element, whitespace before it ignored */
 
-  if (pbuf->buf[pbuf->index] == '<')
-    {
-      ret = TAG;
-    }
-  else
+static bool xmlrpc_tag(FAR struct parsebuf_s *pbuf, FAR const char *tag)
+{
+  size_t len = strlen(tag);
+
+  xmlrpc_skipspace(pbuf);
+  if (strncmp(pbuf->pos, tag, len) == 0)
     {
-      ret = VALUE;
+      pbuf->pos += len;
+      return true;
     }
 
-  data[j++] = pbuf->buf[pbuf->index++];
+  return false;
+}
+
+/* Copy the character data up to the next tag into dest, with the
+ * predefined entities decoded.  Returns the length or XMLRPC_PARSE_ERROR
+ * if the text doesn't fit in size characters.
+ */
 
-  while (j < size)
+static int xmlrpc_text(FAR struct parsebuf_s *pbuf, FAR char *dest,
+                       size_t size)
+{
+  FAR const char *pos = pbuf->pos;
+  size_t len = 0;
+  size_t n;
+  int i;
+
+  while (*pos != '<')
     {
-      if (pbuf->buf[pbuf->index] == '>')
+      if (*pos == '\0' || len >= size)
         {
-          data[j++] = pbuf->buf[pbuf->index++];
-          break;
+          return XMLRPC_PARSE_ERROR;
         }
-      else if ((pbuf->buf[pbuf->index] == '\n') ||
-               (pbuf->buf[pbuf->index] == '<'))
+
+      if (*pos != '&')
         {
-          break;
+          dest[len++] = *pos++;
+          continue;
         }
-      else
+
+      for (i = 0; i < NENTITIES; i++)
         {
-          data[j++] = pbuf->buf[pbuf->index++];
-          if (j >= size)
+          n = strlen(g_xmlentities[i].name);
+          if (strncmp(pos, g_xmlentities[i].name, n) == 0)
             {
-              ret = XMLRPC_PARSE_ERROR;
+              break;
             }
         }
-    }
 
-  data[j] = 0;
-  return ret;
-}
-
-static int xmlrpc_parseparam(struct parsebuf_s *pbuf)
-{
-  int type;
-
-  /* Next, we need a <value> tag */
+      if (i >= NENTITIES)
+        {
+          return XMLRPC_PARSE_ERROR;
+        }
 
-  type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-  if (!((type == TAG) && (!strncmp(g_data, "<value>", 7))))
-    {
-      return XMLRPC_PARSE_ERROR;
+      dest[len++] = g_xmlentities[i].c;
+      pos += n;
     }
 
-  /* Now we get a variable tag, the type of the value */
+  dest[len] = '\0';
+  pbuf->pos = pos;
+  return len;
+}
 
-  type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-  if (type != TAG)
-    {
-      return XMLRPC_PARSE_ERROR;
-    }
+/* Convert a numeric value directly from the request buffer */
 
-  if (!strncmp(g_data, "<i4>", 4))
-    {
-      g_xmlcall.args[g_xmlcall.argsize] = 'i';
-    }
-  else if (!strncmp(g_data, "<int>", 5))
-    {
-      g_xmlcall.args[g_xmlcall.argsize] = 'i';
-    }
-  else if (!strncmp(g_data, "<boolean>", 9))
-    {
-      g_xmlcall.args[g_xmlcall.argsize] = 'b';
-    }
-  else if (!strncmp(g_data, "<double>", 8))
-    {
-      g_xmlcall.args[g_xmlcall.argsize] = 'd';
-    }
-  else if (!strncmp(g_data, "<string>", 8))
+static int xmlrpc_number(FAR struct parsebuf_s *pbuf,
+                         FAR struct xmlrpc_arg_s *arg, char type)
+{
+  FAR char *end;
+
+  if (type == 'd')
     {
-      g_xmlcall.args[g_xmlcall.argsize] = 's';
+      arg->u.d = strtod(pbuf->pos, &end);
     }
   else
     {
-      return XMLRPC_PARSE_ERROR;
+      arg->u.i = (int)strtol(pbuf->pos, &end, 10);
     }
 
-  /* Now, parse the actual value */
-
-  type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-  if (type != VALUE)
+  if (end == pbuf->pos)
     {
       return XMLRPC_PARSE_ERROR;
     }
 
-  switch (g_xmlcall.args[g_xmlcall.argsize])
-    {
-    case 'i':
-    case 'b':
-      g_xmlcall.arguments[g_xmlcall.argsize].u.i = atoi(g_data);
-      break;
+  pbuf->pos = end;
+  return XMLRPC_NO_ERROR;
+}
 
-    case 'd':
-      g_xmlcall.arguments[g_xmlcall.argsize].u.d = atof(g_data);
-      break;
+static int xmlrpc_parseparam(FAR struct parsebuf_s *pbuf,
+                             FAR struct xmlrpc_s *call)
+{
+  FAR const struct xmlrpc_type_s *type = NULL;
+  FAR struct xmlrpc_arg_s *arg;
+  FAR const char *text;
+  int ret;
+  int i;
 
-    case 's':
-      strlcpy(g_xmlcall.arguments[g_xmlcall.argsize].u.string, g_data,
-              sizeof(g_xmlcall.arguments[g_xmlcall.argsize].u.string));
-      break;
+  /* Next, we need a <value> tag */
 
-    default:
+  if (call->argsize >= MAX_ARGS || !xmlrpc_tag(pbuf, "<value>"))
+    {
       return XMLRPC_PARSE_ERROR;
     }
 
-  g_xmlcall.argsize++;
+  /* Now the type of the value, a value without one is a string */
 
-  /* Now we close out the tag, starting with the type */
+  arg  = &call->arguments[call->argsize];
+  text = pbuf->pos;
 
-  type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-  if (!((type == TAG) && (!strncmp(g_data, "</", 2))))
+  for (i = 0; i < NTYPES; i++)
     {
-      return XMLRPC_PARSE_ERROR;
+      if (xmlrpc_tag(pbuf, g_xmltypes[i].open))
+        {
+          type = &g_xmltypes[i];
+          break;
+        }
     }
 
-  /* Next, look for the </value> close */
+  /* Parse the value straight into the argument */
+
+  if (type == NULL)
+    {
+      pbuf->pos = text;
+      ret = xmlrpc_text(pbuf, arg->u.string, CONFIG_XMLRPC_STRINGSIZE);
+    }
+  else if (type->type == 's')
+    {
+      ret = xmlrpc_text(pbuf, arg->u.string, CONFIG_XMLRPC_STRINGSIZE);
+    }
+  else
+    {
+      ret = xmlrpc_number(pbuf, arg, type->type);
+    }
 
-  type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-  if (!((type == TAG) && (!strncmp(g_data, "</value>", 8))))
+  if (ret < 0)
     {
       return XMLRPC_PARSE_ERROR;
     }
 
-  /* Finally, close out the </param> tag */
+  /* Close out the type, the </value> and the </param> tags */
 
-  type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-  if (!((type == TAG) && (!strncmp(g_data, "</param>", 8))))
+  if ((type != NULL && !xmlrpc_tag(pbuf, type->close)) ||
+      !xmlrpc_tag(pbuf, "</value>") || !xmlrpc_tag(pbuf, "</param>"))
     {
       return XMLRPC_PARSE_ERROR;
     }
 
+  call->args[call->argsize++] = type != NULL ? type->type : 's';
   return XMLRPC_NO_ERROR;
 }
 
-static int xmlrpc_parseparams(struct parsebuf_s *pbuf)
+static int xmlrpc_parseparams(FAR struct parsebuf_s *pbuf,
+                              FAR struct xmlrpc_s *call)
 {
-  int ret = XMLRPC_PARSE_ERROR;
-  int type;
+  int ret;
 
-  /* First, look for the params tag */
+  /* The params tag may be omitted if there are no parameters */
 
-  type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-  if ((type == TAG) && (!strncmp(g_data, "<params>", 8)))
+  if (!xmlrpc_tag(pbuf, "<params>"))
     {
-      while (1)
-        {
-          /* Get next tag */
+      return XMLRPC_NO_ERROR;
+    }
 
-          type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-          if ((type == TAG) && (!strncmp(g_data, "<param>", 7)))
-            {
-              ret = xmlrpc_parseparam(pbuf);
-            }
-          else if ((type == TAG) && (!strncmp(g_data, "</params>", 9)))
-            {
-              return XMLRPC_NO_ERROR;
-            }
-          else
-            {
-              return XMLRPC_PARSE_ERROR;
-            }
+  while (xmlrpc_tag(pbuf, "<param>"))
+    {
+      ret = xmlrpc_parseparam(pbuf, call);
+      if (ret != XMLRPC_NO_ERROR)
+        {
+          return ret;
         }
     }
 
-  return ret;
+  return xmlrpc_tag(pbuf, "</params>") ? XMLRPC_NO_ERROR :
+                                          XMLRPC_PARSE_ERROR;
 }
 
-static int xmlrpc_parsemethod(struct parsebuf_s *pbuf)
+static int xmlrpc_parsemethod(FAR struct parsebuf_s *pbuf,
+                              FAR struct xmlrpc_s *call)
 {
-  int ret = XMLRPC_PARSE_ERROR;
-  int type;
+  /* Only the fields of the request need to be reset, the response is
+   * built from the start.
+   */
 
-  memset(&g_xmlcall, 0, sizeof(struct xmlrpc_s));
+  call->name[0]     = '\0';
+  call->argsize     = 0;
+  call->arg         = 0;
+  call->error       = 0;
+  call->responselen = 0;
 
-  /* Look for the methodName tag */
+  /* Get the method name for the call */
 
-  type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-  if ((type == TAG) && (!strncmp(g_data, "<methodName>", 12)))
+  if (!xmlrpc_tag(pbuf, "<methodName>"))
     {
-      /* Get the method name for the call */
-
-      type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-      if (type == VALUE)
-        {
-          /* Save the method name */
-
-          strlcpy(g_xmlcall.name, g_data, sizeof(g_xmlcall.name));
-
-          /* Find the closing /methodCall */
-
-          type = xmlrpc_getelement(pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-          if ((type == TAG) && (!strncmp(g_data, "</methodName>", 13)))
-            {
-              /* Now, it's time to parse the parameters */
+      return XMLRPC_PARSE_ERROR;
+    }
 
-              ret = xmlrpc_parseparams(pbuf);
-            }
-        }
+  xmlrpc_skipspace(pbuf);
+  if (xmlrpc_text(pbuf, call->name, CONFIG_XMLRPC_STRINGSIZE) <= 0 ||
+      !xmlrpc_tag(pbuf, "</methodName>"))
+    {
+      return XMLRPC_PARSE_ERROR;
     }
 
-  return ret;
+  /* Now, it's time to parse the parameters */
+
+  return xmlrpc_parseparams(pbuf, call);
 }
 
 static void xmlrpc_sendfault(int fault)
@@ -361,40 +387,52 @@ static void xmlrpc_sendfault(int fault)
 int xmlrpc_parse(int sock, char *buffer)
 {
   struct parsebuf_s pbuf;
-  int type;
   int ret = XMLRPC_PARSE_ERROR;
 
-  pbuf.buf = buffer;
-  pbuf.len = strlen(buffer);
-  pbuf.index = 0;
+  pbuf.pos = buffer;
 
-  /* Parse the xml header tag */
+  /* Skip the optional xml declaration */
 
-  type = xmlrpc_getelement(&pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-  if ((type == TAG) && (!strncmp(g_data, "<?xml", 5)))
+  xmlrpc_skipspace(&pbuf);
+  if (strncmp(pbuf.pos, "<?xml", 5) == 0)
     {
-      type = xmlrpc_getelement(&pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-      if ((type == TAG) && (!strncmp(g_data, "<methodCall>", 12)))
+      pbuf.pos = strstr(pbuf.pos, "?>");
+      if (pbuf.pos == NULL)
+        {
+          pbuf.pos = "";
+        }
+      else
         {
-          /* Parse the remaining tags within the methodCall tag */
+          pbuf.pos += 2;
+        }
+    }
 
-          xmlrpc_parsemethod(&pbuf);
+  if (xmlrpc_tag(&pbuf, "<methodCall>"))
+    {
+      /* Parse the remaining tags within the methodCall tag */
+
+      ret = xmlrpc_parsemethod(&pbuf, &g_xmlcall);
 
-          /* Check for the closing /methodCall */
+      /* Check for the closing /methodCall */
 
-          type = xmlrpc_getelement(&pbuf, g_data, CONFIG_XMLRPC_STRINGSIZE);
-          if ((type == TAG) && (!strncmp(g_data, "</methodCall>", 13)))
+      if (ret == XMLRPC_NO_ERROR)
+        {
+          if (xmlrpc_tag(&pbuf, "</methodCall>"))
             {
               /* Successful parse, try to call a user function */
 
               ret = xmlrpc_call(&g_xmlcall);
             }
+          else
+            {
+              ret = XMLRPC_PARSE_ERROR;
+            }
         }
     }
 
   if (ret == 0)
     {
-      write(sock, g_xmlcall.response, strlen(g_xmlcall.response));
+      write(sock, g_xmlcall.response, g_xmlcall.responselen);
     }
   else
     {
@@ -402,7 +440,7 @@ int xmlrpc_parse(int sock, char *buffer)
 
       g_xmlcall.error = 1;
       xmlrpc_sendfault(ret);
-      write(sock, g_xmlcall.response, strlen(g_xmlcall.response));
+      write(sock, g_xmlcall.response, g_xmlcall.responselen);
     }
 
   return ret;
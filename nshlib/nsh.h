@@ -54,6 +54,19 @@
 #  endif
 #endif
 
+/* jobs, wait and parallel track background commands */
+
+#ifdef CONFIG_NSH_DISABLEBG
+#  undef CONFIG_NSH_DISABLE_JOBS
+#  define CONFIG_NSH_DISABLE_JOBS 1
+#endif
+
+#ifndef CONFIG_NSH_MAXJOBS
+#  define CONFIG_NSH_MAXJOBS 8
+#endif
+
+#define NSH_JOBNAME_SIZE 16
+
 /* rmdir, mkdir, rm, and mv are only available if mountpoints are enabled
  * AND there is a writeable file system OR if these operations on the
  * pseudo-filesystem are not disabled.
@@ -649,6 +662,16 @@ enum nsh_npflags_e
 };
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_JOBS
+/* A background command started by this session */
+
+struct nsh_job_s
+{
+  pid_t     j_pid;             /* Task or thread ID, 0 if the slot is free */
+  char      j_name[NSH_JOBNAME_SIZE]; /* Command name */
+};
+#endif
+
 /* These structure provides the overall state of the parser */
 
 struct nsh_parser_s
@@ -664,9 +687,17 @@ struct nsh_parser_s
 #ifndef CONFIG_NSH_DISABLEBG
   int      np_nice;     /* "nice" value applied to last background cmd */
 #endif
+#ifndef CONFIG_NSH_DISABLE_JOBS
+  pid_t    np_lastjob;  /* ID of the last background command */
+  struct nsh_job_s np_jobs[CONFIG_NSH_MAXJOBS];
+#endif
 
 #ifndef CONFIG_NSH_DISABLESCRIPT
   int      np_fd;       /* Stream of current script */
+#ifdef CONFIG_NSH_SCRIPT_CACHE
+  FAR struct nsh_script_s *np_script; /* Cached text of current script */
+  long     np_spos;     /* Read position in np_script */
+#endif
 #ifndef CONFIG_NSH_DISABLE_LOOPS
   long     np_foffs;    /* File offset to the beginning of a line */
 #ifndef NSH_DISABLE_SEMICOLON
@@ -849,17 +880,31 @@ int nsh_telnetlogin(FAR struct console_stdio_s *pstate);
 /* Application interface */
 
 int nsh_command(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char *argv[]);
+#ifdef CONFIG_NSH_CMDHASH
+void nsh_cmdhash_initialize(void);
+#endif
 
 #ifdef CONFIG_NSH_BUILTIN_APPS
 int nsh_builtin(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
                 FAR char **argv, FAR const char *redirfile, int oflags);
 #endif
 
+#ifdef CONFIG_NSH_BUILTIN_POOL
+int nsh_poolrun(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+                FAR char * const *argv, FAR const char *redirfile,
+                int oflags);
+#endif
+
 #ifdef CONFIG_NSH_FILE_APPS
 int nsh_fileapp(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
                 FAR char **argv, FAR const char *redirfile, int oflags);
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_JOBS
+void nsh_jobadd(FAR struct nsh_vtbl_s *vtbl, pid_t pid,
+                FAR const char *name);
+#endif
+
 #ifndef CONFIG_DISABLE_ENVIRON
 /* Working directory support */
 
@@ -921,6 +966,9 @@ void nsh_usbtrace(void);
 #ifndef CONFIG_NSH_DISABLE_TIME
   int cmd_time(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
+#ifndef CONFIG_NSH_DISABLE_PERF
+  int cmd_perf(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+#endif
 #ifndef CONFIG_NSH_DISABLE_PS
   int cmd_ps(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
@@ -1175,6 +1223,11 @@ int cmd_switchboot(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
   int cmd_unset(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_JOBS
+  int cmd_jobs(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+  int cmd_wait(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+  int cmd_parallel(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+#endif
 #ifndef CONFIG_NSH_DISABLE_KILL
   int cmd_kill(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
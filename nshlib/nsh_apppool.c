@@ -0,0 +1,476 @@
+/****************************************************************************
+ * apps/nshlib/nsh_apppool.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/ioctl.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nuttx/lib/builtin.h>
+
+#include "nsh.h"
+#include "nsh_console.h"
+
+#ifdef CONFIG_NSH_BUILTIN_POOL
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Worker stacks are allocated in power-of-two size classes */
+
+#define POOL_MIN_STACKSIZE 1024
+
+/* How often a waiting shell checks that its worker is still alive.  A
+ * worker that is killed by a signal does not run its on_exit() handler.
+ */
+
+#define POOL_POLL_SEC      1
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct nsh_poolworker_s
+{
+  pid_t        owner;      /* Shell task that uses the worker */
+  pid_t        pid;        /* Worker task, 0 if the slot is free */
+  size_t       stacksize;  /* Stack size class of the worker */
+  bool         busy;       /* A job has been handed to the worker */
+  bool         exited;     /* The worker has called exit() */
+  sem_t        start;      /* Posted by the shell to start a job */
+  sem_t        done;       /* Posted by the worker when the job is done */
+
+  /* The job.  All of this belongs to the shell that waits for the job */
+
+  FAR const struct builtin_s *builtin;
+  FAR char * const *argv;
+  FAR char **envp;
+  FAR const char *redirfile;
+  int          oflags;
+  int          status;     /* Exit status of the job */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct nsh_poolworker_s g_pool[CONFIG_NSH_BUILTIN_POOL_SIZE];
+static pthread_mutex_t g_poollock = PTHREAD_MUTEX_INITIALIZER;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nsh_poolclass
+ ****************************************************************************/
+
+static size_t nsh_poolclass(size_t stacksize)
+{
+  size_t size = POOL_MIN_STACKSIZE;
+
+  while (size < stacksize)
+    {
+      size <<= 1;
+    }
+
+  return size;
+}
+
+/****************************************************************************
+ * Name: nsh_poolexit
+ *
+ * Description:
+ *   on_exit() handler of a worker.  Called if the application exits with
+ *   exit() instead of returning from its main().
+ *
+ ****************************************************************************/
+
+static void nsh_poolexit(int status, FAR void *arg)
+{
+  FAR struct nsh_poolworker_s *worker = arg;
+
+  worker->status = status;
+  worker->exited = true;
+  sem_post(&worker->done);
+}
+
+/****************************************************************************
+ * Name: nsh_poolrunjob
+ ****************************************************************************/
+
+static int nsh_poolrunjob(FAR struct nsh_poolworker_s *worker)
+{
+  FAR const struct builtin_s *builtin = worker->builtin;
+  struct sched_param param;
+  int saved = -1;
+  int argc;
+  int fd;
+  int ret;
+
+  param.sched_priority = builtin->priority;
+  sched_setparam(0, &param);
+
+#ifndef CONFIG_DISABLE_ENVIRON
+  /* Run with the environment of the shell */
+
+  clearenv();
+  if (worker->envp != NULL)
+    {
+      FAR char **envp;
+
+      for (envp = worker->envp; *envp != NULL; envp++)
+        {
+          putenv(*envp);
+        }
+    }
+#endif
+
+  if (worker->redirfile != NULL)
+    {
+      fd = open(worker->redirfile, worker->oflags, 0644);
+      if (fd < 0)
+        {
+          return EXIT_FAILURE;
+        }
+
+      saved = dup(STDOUT_FILENO);
+      dup2(fd, STDOUT_FILENO);
+      close(fd);
+    }
+
+  for (argc = 0; worker->argv[argc] != NULL; argc++);
+
+  /* The getopt() state of this task outlives the previous application */
+
+  optind = 1;
+
+  ret = builtin->main(argc, (FAR char **)worker->argv);
+
+  fflush(stdout);
+  fflush(stderr);
+
+  if (saved >= 0)
+    {
+      dup2(saved, STDOUT_FILENO);
+      close(saved);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nsh_poolmain
+ *
+ * Description:
+ *   Main loop of a worker task: run the jobs of its shell one at a time.
+ *
+ ****************************************************************************/
+
+static int nsh_poolmain(int argc, FAR char *argv[])
+{
+  FAR struct nsh_poolworker_s *worker = &g_pool[atoi(argv[1])];
+
+  if (on_exit(nsh_poolexit, worker) != 0)
+    {
+      /* exit() of an application could not be detected */
+
+      worker->status = ERROR;
+      sem_post(&worker->done);
+      return EXIT_FAILURE;
+    }
+
+  /* Tell the shell that the worker is ready */
+
+  worker->status = OK;
+  sem_post(&worker->done);
+
+  for (; ; )
+    {
+      while (sem_wait(&worker->start) < 0);
+
+      worker->status = nsh_poolrunjob(worker);
+      sem_post(&worker->done);
+    }
+
+  return EXIT_SUCCESS;
+}
+
+/****************************************************************************
+ * Name: nsh_poolwait
+ *
+ * Description:
+ *   Wait for the worker to post done.  Returns ERROR if the worker died
+ *   without doing so.
+ *
+ ****************************************************************************/
+
+static int nsh_poolwait(FAR struct nsh_poolworker_s *worker)
+{
+  struct timespec abstime;
+
+  for (; ; )
+    {
+      clock_gettime(CLOCK_REALTIME, &abstime);
+      abstime.tv_sec += POOL_POLL_SEC;
+
+      if (sem_timedwait(&worker->done, &abstime) == 0)
+        {
+          return OK;
+        }
+
+      if (errno == ETIMEDOUT && kill(worker->pid, 0) < 0 && errno == ESRCH)
+        {
+          return ERROR;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nsh_poolfree
+ *
+ * Description:
+ *   Release the slot of a worker that is gone.  Called with g_poollock
+ *   held or by the only user of the slot.
+ *
+ ****************************************************************************/
+
+static void nsh_poolfree(FAR struct nsh_poolworker_s *worker)
+{
+  sem_destroy(&worker->start);
+  sem_destroy(&worker->done);
+  memset(worker, 0, sizeof(*worker));
+}
+
+/****************************************************************************
+ * Name: nsh_poolcreate
+ *
+ * Description:
+ *   Start a new worker in a free slot.  The worker is a child of the
+ *   calling shell, so it inherits its standard streams.
+ *
+ ****************************************************************************/
+
+static FAR struct nsh_poolworker_s *
+nsh_poolcreate(FAR struct nsh_poolworker_s *worker, size_t stacksize,
+               int priority)
+{
+  char slot[8];
+  FAR char *argv[2];
+  pid_t pid;
+
+  sem_init(&worker->start, 0, 0);
+  sem_init(&worker->done, 0, 0);
+  worker->owner     = getpid();
+  worker->stacksize = stacksize;
+  worker->busy      = true;
+
+  snprintf(slot, sizeof(slot), "%d", (int)(worker - g_pool));
+  argv[0] = slot;
+  argv[1] = NULL;
+
+  pid = task_create("nsh_pool", priority, stacksize, nsh_poolmain, argv);
+  if (pid < 0)
+    {
+      nsh_poolfree(worker);
+      return NULL;
+    }
+
+  worker->pid = pid;
+  if (nsh_poolwait(worker) < 0 || worker->status != OK)
+    {
+      nsh_poolfree(worker);
+      return NULL;
+    }
+
+  return worker;
+}
+
+/****************************************************************************
+ * Name: nsh_poolget
+ *
+ * Description:
+ *   Reserve an idle worker of the calling shell with the right stack size
+ *   class, creating one if needed.
+ *
+ ****************************************************************************/
+
+static FAR struct nsh_poolworker_s *
+nsh_poolget(FAR const struct builtin_s *builtin)
+{
+  FAR struct nsh_poolworker_s *worker = NULL;
+  FAR struct nsh_poolworker_s *avail = NULL;
+  size_t stacksize = nsh_poolclass(builtin->stacksize);
+  pid_t self = getpid();
+  int i;
+
+  pthread_mutex_lock(&g_poollock);
+
+  for (i = 0; i < CONFIG_NSH_BUILTIN_POOL_SIZE; i++)
+    {
+      FAR struct nsh_poolworker_s *entry = &g_pool[i];
+
+      /* Reclaim the workers of shells that are gone */
+
+      if (entry->pid != 0 && !entry->busy && entry->owner != self &&
+          kill(entry->owner, 0) < 0 && errno == ESRCH)
+        {
+          kill(entry->pid, SIGKILL);
+          nsh_poolfree(entry);
+        }
+
+      if (entry->pid == 0)
+        {
+          if (avail == NULL && !entry->busy)
+            {
+              avail = entry;
+            }
+        }
+      else if (!entry->busy && entry->owner == self &&
+               entry->stacksize == stacksize)
+        {
+          worker = entry;
+          break;
+        }
+    }
+
+  if (worker != NULL)
+    {
+      worker->busy = true;
+    }
+  else if (avail != NULL)
+    {
+      /* Claim the slot, then start the worker without holding the lock */
+
+      avail->busy = true;
+      pthread_mutex_unlock(&g_poollock);
+      return nsh_poolcreate(avail, stacksize, builtin->priority);
+    }
+
+  pthread_mutex_unlock(&g_poollock);
+  return worker;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nsh_poolrun
+ *
+ * Description:
+ *   Run a builtin application in the foreground on a pre-created worker
+ *   task instead of spawning a new task.  The worker stays around, with
+ *   its stack, for the next application of the same stack size class.
+ *
+ * Returned Value:
+ *   0 (OK) if the application ran and returned EXIT_SUCCESS, 1 if it
+ *   returned failure status, or a negated errno value if it could not be
+ *   run on a worker and has to be spawned as usual.
+ *
+ ****************************************************************************/
+
+int nsh_poolrun(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+                FAR char * const *argv, FAR const char *redirfile,
+                int oflags)
+{
+  FAR const struct builtin_s *builtin;
+  FAR struct nsh_poolworker_s *worker;
+  int index;
+  int tc = -1;
+  int ret;
+
+  index = builtin_isavail(cmd);
+  if (index < 0)
+    {
+      return -ENOENT;
+    }
+
+  builtin = builtin_for_index(index);
+  if (builtin == NULL || builtin->main == NULL)
+    {
+      return -ENOENT;
+    }
+
+  worker = nsh_poolget(builtin);
+  if (worker == NULL)
+    {
+      return -EBUSY;
+    }
+
+  worker->builtin   = builtin;
+  worker->argv      = argv;
+#ifndef CONFIG_DISABLE_ENVIRON
+  worker->envp      = environ;
+#endif
+  worker->redirfile = redirfile;
+  worker->oflags    = oflags;
+
+  if (vtbl->isctty)
+    {
+      /* Setup up to receive SIGINT if control-C entered. */
+
+      tc = nsh_ioctl(vtbl, TIOCSCTTY, worker->pid);
+    }
+
+  sem_post(&worker->start);
+  ret = nsh_poolwait(worker);
+
+  if (vtbl->isctty && tc == 0)
+    {
+      nsh_ioctl(vtbl, TIOCNOTTY, 0);
+    }
+
+  pthread_mutex_lock(&g_poollock);
+  if (ret < 0 || worker->exited)
+    {
+      /* The application called exit() or was killed with the worker */
+
+      ret = ret < 0 ? EXIT_FAILURE : worker->status;
+      nsh_poolfree(worker);
+    }
+  else
+    {
+      ret = worker->status;
+      worker->busy = false;
+    }
+
+  pthread_mutex_unlock(&g_poollock);
+
+  return ret == EXIT_SUCCESS ? OK : 1;
+}
+
+#endif /* CONFIG_NSH_BUILTIN_POOL */
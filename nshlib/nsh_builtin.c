@@ -77,6 +77,21 @@ int nsh_builtin(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
 #endif
   int ret = OK;
 
+#ifdef CONFIG_NSH_BUILTIN_POOL
+  /* Foreground applications may run on a pooled worker task */
+
+#  ifndef CONFIG_NSH_DISABLEBG
+  if (vtbl->np.np_bg == false)
+#  endif
+    {
+      ret = nsh_poolrun(vtbl, cmd, argv, redirfile, oflags);
+      if (ret >= 0)
+        {
+          return ret;
+        }
+    }
+#endif
+
   /* Lock the scheduler in an attempt to prevent the application from
    * running until waitpid() has been called.
    */
@@ -234,6 +249,9 @@ int nsh_builtin(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
 #  endif
           struct sched_param param;
           sched_getparam(ret, &param);
+#ifndef CONFIG_NSH_DISABLE_JOBS
+          nsh_jobadd(vtbl, ret, cmd);
+#endif
           nsh_output(vtbl, "%s [%d:%d]\n", cmd, ret, param.sched_priority);
 
           /* Backgrounded commands always 'succeed' as long as we can start
@@ -49,6 +49,14 @@
 #define HELP_TABSIZE  4
 #define NUM_CMDS      ((sizeof(g_cmdmap)/sizeof(struct cmdmap_s)) - 1)
 
+/* Size of the command hash index: a power of two with at least twice as
+ * many slots as there are commands.
+ */
+
+#define CMDHASH_SIZE  (NUM_CMDS < 32 ? 64 : NUM_CMDS < 64 ? 128 : \
+                       NUM_CMDS < 128 ? 256 : 512)
+#define CMDHASH_MASK  (CMDHASH_SIZE - 1)
+
 /* Help marco for nsh command */
 
 #ifdef CONFIG_NSH_DISABLE_HELP
@@ -98,6 +106,7 @@ static int cmd_expr(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 
 static int  cmd_unrecognized(FAR struct nsh_vtbl_s *vtbl, int argc,
                              FAR char **argv);
+static FAR const struct cmdmap_s *nsh_cmdlookup(FAR const char *cmd);
 
 /****************************************************************************
  * Private Data
@@ -169,7 +178,12 @@ static const struct cmdmap_s g_cmdmap[] =
 #endif
 
 #ifndef CONFIG_NSH_DISABLE_CP
+#  ifdef CONFIG_NSH_CMDOPT_CP_BULK
+  CMD_MAP("cp",       cmd_cp,       3, 7,
+    "[-r] [-p] [-j <jobs>] <source-path> <dest-path>"),
+#  else
   CMD_MAP("cp",       cmd_cp,       3, 4, "[-r] <source-path> <dest-path>"),
+#  endif
 #endif
 
 #ifndef CONFIG_NSH_DISABLE_CMP
@@ -186,9 +200,10 @@ static const struct cmdmap_s g_cmdmap[] =
 #endif
 
 #ifndef CONFIG_NSH_DISABLE_DD
-  CMD_MAP("dd",       cmd_dd,       3, 7,
+  CMD_MAP("dd",       cmd_dd,       3, 11,
     "if=<infile> of=<outfile> [bs=<sectsize>] [count=<sectors>] "
-    "[skip=<sectors>] [seek=<sectors>] [verify]"),
+    "[skip=<sectors>] [seek=<sectors>] [verify] [iflag=direct] "
+    "[oflag=direct] [status=progress]"),
 #endif
 
 #if defined(CONFIG_NET) && defined(CONFIG_NET_ROUTE) && !defined(CONFIG_NSH_DISABLE_DELROUTE)
@@ -306,6 +321,10 @@ static const struct cmdmap_s g_cmdmap[] =
   CMD_MAP("irqinfo",  cmd_irqinfo,  1, 1, NULL),
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_JOBS
+  CMD_MAP("jobs",     cmd_jobs,     1, 1, NULL),
+#endif
+
 #ifndef CONFIG_NSH_DISABLE_KILL
   CMD_MAP("kill",     cmd_kill,     2, 3, "[-<signal>] <pid>"),
 #endif
@@ -367,8 +386,8 @@ static const struct cmdmap_s g_cmdmap[] =
 
 #if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FSUTILS_MKFATFS)
 #  ifndef CONFIG_NSH_DISABLE_MKFATFS
-  CMD_MAP("mkfatfs",  cmd_mkfatfs,  2, 6,
-    "[-F <fatsize>] [-r <rootdirentries>] <block-driver>"),
+  CMD_MAP("mkfatfs",  cmd_mkfatfs,  2, 8,
+    "[-F <fatsize>] [-r <rootdirentries>] [-d] [-e] <block-driver>"),
 #  endif
 #endif
 
@@ -445,6 +464,15 @@ static const struct cmdmap_s g_cmdmap[] =
 #  endif
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_JOBS
+  CMD_MAP("parallel", cmd_parallel, 2, CONFIG_NSH_MAXARGUMENTS,
+    "[-j <jobs>] \"<command>\" [\"<command>\" ...]"),
+#endif
+
+#ifndef CONFIG_NSH_DISABLE_PERF
+  CMD_MAP("perf",     cmd_perf,     2, 2, "\"<command>\""),
+#endif
+
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_NSH_DISABLE_PIDOF)
   CMD_MAP("pidof",   cmd_pidof, 2, 2, "<name>"),
 #endif
@@ -653,6 +681,10 @@ static const struct cmdmap_s g_cmdmap[] =
   CMD_MAP("usleep",   cmd_usleep,   2, 2, "<usec>"),
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_JOBS
+  CMD_MAP("wait",     cmd_wait,     1, CONFIG_NSH_MAXARGUMENTS, "[<pid> ...]"),
+#endif
+
 #ifdef CONFIG_NET_TCP
 #  ifndef CONFIG_NSH_DISABLE_WGET
   CMD_MAP("wget",     cmd_wget,     2, 4, "[-o <local-path>] <url>"),
@@ -665,10 +697,83 @@ static const struct cmdmap_s g_cmdmap[] =
   CMD_MAP(NULL,       NULL,         1, 1, NULL)
 };
 
+#ifdef CONFIG_NSH_CMDHASH
+/* 1 + index into g_cmdmap[], 0 for an empty slot */
+
+static uint16_t g_cmdhash[CMDHASH_SIZE];
+static bool g_cmdhash_ready;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+#ifdef CONFIG_NSH_CMDHASH
+/****************************************************************************
+ * Name: nsh_cmdhash
+ *
+ * Description:
+ *   FNV-1a hash of a command name.
+ *
+ ****************************************************************************/
+
+static unsigned int nsh_cmdhash(FAR const char *cmd)
+{
+  uint32_t hash = 2166136261u;
+
+  while (*cmd != '\0')
+    {
+      hash ^= (uint8_t)*cmd++;
+      hash *= 16777619u;
+    }
+
+  return hash & CMDHASH_MASK;
+}
+#endif
+
+/****************************************************************************
+ * Name: nsh_cmdlookup
+ *
+ * Description:
+ *   Find a command in the command table.  Returns NULL if there is no
+ *   such command.
+ *
+ ****************************************************************************/
+
+static FAR const struct cmdmap_s *nsh_cmdlookup(FAR const char *cmd)
+{
+  FAR const struct cmdmap_s *cmdmap;
+
+#ifdef CONFIG_NSH_CMDHASH
+  if (g_cmdhash_ready)
+    {
+      unsigned int slot;
+
+      for (slot = nsh_cmdhash(cmd); g_cmdhash[slot] != 0;
+           slot = (slot + 1) & CMDHASH_MASK)
+        {
+          cmdmap = &g_cmdmap[g_cmdhash[slot] - 1];
+          if (strcmp(cmdmap->cmd, cmd) == 0)
+            {
+              return cmdmap;
+            }
+        }
+
+      return NULL;
+    }
+#endif
+
+  for (cmdmap = g_cmdmap; cmdmap->cmd; cmdmap++)
+    {
+      if (strcmp(cmdmap->cmd, cmd) == 0)
+        {
+          return cmdmap;
+        }
+    }
+
+  return NULL;
+}
+
 /****************************************************************************
  * Name: help_cmdlist
  ****************************************************************************/
@@ -823,18 +928,14 @@ static int help_cmd(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd)
 
   /* Find the command in the command table */
 
-  for (cmdmap = g_cmdmap; cmdmap->cmd; cmdmap++)
+  cmdmap = nsh_cmdlookup(cmd);
+  if (cmdmap != NULL)
     {
-      /* Is this the one we are looking for? */
+      /* Yes... show it */
 
-      if (strcmp(cmdmap->cmd, cmd) == 0)
-        {
-          /* Yes... show it */
-
-          nsh_output(vtbl, "%s usage:", cmd);
-          help_showcmd(vtbl, cmdmap);
-          return OK;
-        }
+      nsh_output(vtbl, "%s usage:", cmd);
+      help_showcmd(vtbl, cmdmap);
+      return OK;
     }
 
   nsh_error(vtbl, g_fmtcmdnotfound, cmd);
@@ -1215,38 +1316,35 @@ int nsh_command(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char *argv[])
 
   /* See if the command is one that we understand */
 
-  for (cmdmap = g_cmdmap; cmdmap->cmd; cmdmap++)
+  cmdmap = nsh_cmdlookup(cmd);
+  if (cmdmap != NULL)
     {
-      if (strcmp(cmdmap->cmd, cmd) == 0)
-        {
-          /* Check if a valid number of arguments was provided.  We
-           * do this simple, imperfect checking here so that it does
-           * not have to be performed in each command.
-           */
+      /* Check if a valid number of arguments was provided.  We
+       * do this simple, imperfect checking here so that it does
+       * not have to be performed in each command.
+       */
 
-          if (argc < cmdmap->minargs)
-            {
-              /* Fewer than the minimum number were provided */
+      if (argc < cmdmap->minargs)
+        {
+          /* Fewer than the minimum number were provided */
 
-              nsh_error(vtbl, g_fmtargrequired, cmd);
-              return ERROR;
-            }
-          else if (argc > cmdmap->maxargs)
-            {
-              /* More than the maximum number were provided */
+          nsh_error(vtbl, g_fmtargrequired, cmd);
+          return ERROR;
+        }
+      else if (argc > cmdmap->maxargs)
+        {
+          /* More than the maximum number were provided */
 
-              nsh_error(vtbl, g_fmttoomanyargs, cmd);
-              return ERROR;
-            }
-          else
-            {
-              /* A valid number of arguments were provided (this does
-               * not mean they are right).
-               */
+          nsh_error(vtbl, g_fmttoomanyargs, cmd);
+          return ERROR;
+        }
+      else
+        {
+          /* A valid number of arguments were provided (this does
+           * not mean they are right).
+           */
 
-              handler = cmdmap->handler;
-              break;
-            }
+          handler = cmdmap->handler;
         }
     }
 
@@ -1254,6 +1352,41 @@ int nsh_command(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char *argv[])
   return ret;
 }
 
+/****************************************************************************
+ * Name: nsh_cmdhash_initialize
+ *
+ * Description:
+ *   Build the hash index of the command table.  Called once from
+ *   nsh_initialize(); until then, commands are looked up linearly.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NSH_CMDHASH
+void nsh_cmdhash_initialize(void)
+{
+  unsigned int slot;
+  int i;
+
+  if (g_cmdhash_ready)
+    {
+      return;
+    }
+
+  for (i = 0; i < (int)NUM_CMDS; i++)
+    {
+      slot = nsh_cmdhash(g_cmdmap[i].cmd);
+      while (g_cmdhash[slot] != 0)
+        {
+          slot = (slot + 1) & CMDHASH_MASK;
+        }
+
+      g_cmdhash[slot] = i + 1;
+    }
+
+  g_cmdhash_ready = true;
+}
+#endif
+
 /****************************************************************************
  * Name: nsh_extmatch_count
  *
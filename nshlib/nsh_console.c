@@ -25,6 +25,7 @@
 #include <nuttx/config.h>
 
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -72,6 +73,9 @@ static void nsh_consoleredirect(FAR struct nsh_vtbl_s *vtbl, int fd,
                                 FAR uint8_t *save);
 static void nsh_consoleundirect(FAR struct nsh_vtbl_s *vtbl,
                                 FAR uint8_t *save);
+#ifdef CONFIG_NSH_OUTPUT_BUFFER
+static void nsh_consoleflush(FAR struct nsh_vtbl_s *vtbl);
+#endif
 static void nsh_consoleexit(FAR struct nsh_vtbl_s *vtbl,
                             int exitstatus) noreturn_function;
 
@@ -104,6 +108,77 @@ static void nsh_closeifnotclosed(struct console_stdio_s *pstate)
   OUTFD(pstate) = -1;
 }
 
+/****************************************************************************
+ * Name: nsh_consolewritev
+ *
+ * Description:
+ *   Write all of the I/O vectors to fd, retrying after short writes.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NSH_OUTPUT_BUFFER
+static int nsh_consolewritev(int fd, FAR struct iovec *iov, int iovcnt)
+{
+  ssize_t ret;
+  int i = 0;
+
+  while (i < iovcnt)
+    {
+      ret = writev(fd, &iov[i], iovcnt - i);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          _err("ERROR: [%d] Failed to send buffer: %d\n", fd, errno);
+          return ERROR;
+        }
+
+      while (i < iovcnt && (size_t)ret >= iov[i].iov_len)
+        {
+          ret -= iov[i].iov_len;
+          i++;
+        }
+
+      if (i < iovcnt)
+        {
+          iov[i].iov_base  = (FAR char *)iov[i].iov_base + ret;
+          iov[i].iov_len  -= ret;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nsh_consoleflush
+ *
+ * Description:
+ *   Write the buffered output to the current output stream.
+ *
+ ****************************************************************************/
+
+static void nsh_consoleflush(FAR struct nsh_vtbl_s *vtbl)
+{
+  FAR struct console_stdio_s *pstate = (FAR struct console_stdio_s *)vtbl;
+  struct iovec iov;
+
+  if (pstate->cn_outlen > 0)
+    {
+      iov.iov_base = pstate->cn_outbuf;
+      iov.iov_len  = pstate->cn_outlen;
+      pstate->cn_outlen = 0;
+
+      if (OUTFD(pstate) >= 0)
+        {
+          nsh_consolewritev(OUTFD(pstate), &iov, 1);
+        }
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: nsh_consolewrite
  *
@@ -120,6 +195,29 @@ static ssize_t nsh_consolewrite(FAR struct nsh_vtbl_s *vtbl,
   FAR struct console_stdio_s *pstate = (FAR struct console_stdio_s *)vtbl;
   ssize_t ret;
 
+#ifdef CONFIG_NSH_OUTPUT_BUFFER
+  struct iovec iov[2];
+
+  /* Small writes are appended to the buffer; larger ones are sent together
+   * with what is buffered in a single writev().
+   */
+
+  if (nbytes <= sizeof(pstate->cn_outbuf) - pstate->cn_outlen)
+    {
+      memcpy(&pstate->cn_outbuf[pstate->cn_outlen], buffer, nbytes);
+      pstate->cn_outlen += nbytes;
+      return nbytes;
+    }
+
+  iov[0].iov_base = pstate->cn_outbuf;
+  iov[0].iov_len  = pstate->cn_outlen;
+  iov[1].iov_base = (FAR void *)buffer;
+  iov[1].iov_len  = nbytes;
+  pstate->cn_outlen = 0;
+
+  ret = nsh_consolewritev(OUTFD(pstate), iov, 2);
+  return ret < 0 ? ret : nbytes;
+#else
   /* Write the data to the output stream */
 
   ret = write(OUTFD(pstate), buffer, nbytes);
@@ -130,6 +228,7 @@ static ssize_t nsh_consolewrite(FAR struct nsh_vtbl_s *vtbl,
     }
 
   return ret;
+#endif
 }
 
 /****************************************************************************
@@ -145,6 +244,7 @@ static int nsh_consoleioctl(FAR struct nsh_vtbl_s *vtbl,
 {
   FAR struct console_stdio_s *pstate = (FAR struct console_stdio_s *)vtbl;
 
+  nsh_flush(vtbl);
   return ioctl(OUTFD(pstate), cmd, arg);
 }
 
@@ -163,9 +263,44 @@ static int nsh_consoleoutput(FAR struct nsh_vtbl_s *vtbl,
   va_list ap;
   int ret;
 
+#ifdef CONFIG_NSH_OUTPUT_BUFFER
+  size_t avail = sizeof(pstate->cn_outbuf) - pstate->cn_outlen;
+
+  /* Format into the free part of the buffer */
+
+  va_start(ap, fmt);
+  ret = vsnprintf(&pstate->cn_outbuf[pstate->cn_outlen], avail, fmt, ap);
+  va_end(ap);
+
+  if (ret < 0 || (size_t)ret < avail)
+    {
+      pstate->cn_outlen += ret < 0 ? 0 : ret;
+      return ret;
+    }
+
+  /* It did not fit.  Make room and format again, or bypass the buffer if
+   * the output is larger than the whole buffer.
+   */
+
+  nsh_consoleflush(vtbl);
+
+  va_start(ap, fmt);
+  if ((size_t)ret < sizeof(pstate->cn_outbuf))
+    {
+      ret = vsnprintf(pstate->cn_outbuf, sizeof(pstate->cn_outbuf), fmt, ap);
+      pstate->cn_outlen = ret;
+    }
+  else
+    {
+      ret = vdprintf(OUTFD(pstate), fmt, ap);
+    }
+
+  va_end(ap);
+#else
   va_start(ap, fmt);
   ret = vdprintf(OUTFD(pstate), fmt, ap);
   va_end(ap);
+#endif
 
   return ret;
 }
@@ -186,6 +321,10 @@ static int nsh_erroroutput(FAR struct nsh_vtbl_s *vtbl,
   va_list ap;
   int ret;
 
+  /* Keep errors in order with the normal output */
+
+  nsh_flush(vtbl);
+
   va_start(ap, fmt);
   ret = vdprintf(ERRFD(pstate), fmt, ap);
   va_end(ap);
@@ -238,6 +377,7 @@ static void nsh_consolerelease(FAR struct nsh_vtbl_s *vtbl)
 
   /* Close the output stream */
 
+  nsh_flush(vtbl);
   nsh_closeifnotclosed(pstate);
 
   /* Close the console stream */
@@ -296,6 +436,10 @@ static void nsh_consoleredirect(FAR struct nsh_vtbl_s *vtbl, int fd,
   FAR struct console_stdio_s *pstate = (FAR struct console_stdio_s *)vtbl;
   FAR struct serialsave_s *ssave  = (FAR struct serialsave_s *)save;
 
+  /* Buffered output belongs to the old stream */
+
+  nsh_flush(vtbl);
+
   /* Redirected foreground commands */
 
   if (ssave)
@@ -327,6 +471,7 @@ static void nsh_consoleundirect(FAR struct nsh_vtbl_s *vtbl,
   FAR struct console_stdio_s *pstate = (FAR struct console_stdio_s *)vtbl;
   FAR struct serialsave_s *ssave = (FAR struct serialsave_s *)save;
 
+  nsh_flush(vtbl);
   nsh_closeifnotclosed(pstate);
   ERRFD(pstate) = ERRFD(ssave);
   OUTFD(pstate) = OUTFD(ssave);
@@ -377,6 +522,9 @@ FAR struct console_stdio_s *nsh_newconsole(bool isctty)
 #endif
       pstate->cn_vtbl.linebuffer  = nsh_consolelinebuffer;
       pstate->cn_vtbl.exit        = nsh_consoleexit;
+#ifdef CONFIG_NSH_OUTPUT_BUFFER
+      pstate->cn_vtbl.flush       = nsh_consoleflush;
+#endif
       pstate->cn_vtbl.isctty      = isctty;
 
 #ifndef CONFIG_NSH_DISABLESCRIPT
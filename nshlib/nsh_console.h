@@ -50,6 +50,12 @@
 #define nsh_undirect(v,s)      (v)->undirect(v,s)
 #define nsh_exit(v,s)          (v)->exit(v,s)
 
+#ifdef CONFIG_NSH_OUTPUT_BUFFER
+#  define nsh_flush(v)         (v)->flush(v)
+#else
+#  define nsh_flush(v)
+#endif
+
 #ifdef CONFIG_CPP_HAVE_VARARGS
 #  define nsh_error(v, ...)    (v)->error(v, ##__VA_ARGS__)
 #  define nsh_output(v, ...)   (v)->output(v, ##__VA_ARGS__)
@@ -124,6 +130,9 @@ struct nsh_vtbl_s
   void (*redirect)(FAR struct nsh_vtbl_s *vtbl, int fd, FAR uint8_t *save);
   void (*undirect)(FAR struct nsh_vtbl_s *vtbl, FAR uint8_t *save);
   void (*exit)(FAR struct nsh_vtbl_s *vtbl, int status) noreturn_function;
+#ifdef CONFIG_NSH_OUTPUT_BUFFER
+  void (*flush)(FAR struct nsh_vtbl_s *vtbl);
+#endif
 
 #ifdef NSH_HAVE_IOBUFFER
   /* Common buffer for file I/O. */
@@ -176,6 +185,13 @@ struct console_stdio_s
   /* Line input buffer */
 
   char   cn_line[CONFIG_NSH_LINELEN];
+
+#ifdef CONFIG_NSH_OUTPUT_BUFFER
+  /* Output not yet written to cn_outfd */
+
+  size_t cn_outlen;
+  char   cn_outbuf[CONFIG_NSH_OUTPUT_BUFSIZE];
+#endif
 };
 
 /****************************************************************************
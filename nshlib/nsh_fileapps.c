@@ -279,6 +279,9 @@ int nsh_fileapp(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
         {
           struct sched_param param;
           sched_getparam(ret, &param);
+#ifndef CONFIG_NSH_DISABLE_JOBS
+          nsh_jobadd(vtbl, pid, cmd);
+#endif
           nsh_output(vtbl, "%s [%d:%d]\n", cmd, ret, param.sched_priority);
 
           /* Backgrounded commands always 'succeed' as long as we can start
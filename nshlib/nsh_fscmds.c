@@ -43,6 +43,12 @@
 #include <errno.h>
 #include <debug.h>
 
+#ifdef CONFIG_NSH_CMDOPT_CP_BULK
+#  include <malloc.h>
+#  include <pthread.h>
+#  include <time.h>
+#endif
+
 #include "nsh.h"
 
 #if !defined(CONFIG_DISABLE_MOUNTPOINT)
@@ -92,18 +98,147 @@
 #define MB                   (1UL << 20)
 #define GB                   (1UL << 30)
 
+/* cp -j needs threads */
+
+#if defined(CONFIG_NSH_CMDOPT_CP_BULK) && \
+    defined(CONFIG_NSH_CMDOPT_CP_MAXJOBS) && CONFIG_NSH_CMDOPT_CP_MAXJOBS > 1
+#  define CP_HAVE_JOBS 1
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_CP
+#ifdef CP_HAVE_JOBS
+/* A file to be copied by one of the cp -j threads */
+
+struct cp_job_s
+{
+  FAR struct cp_job_s *flink;
+  FAR char *srcpath;
+  FAR char *destpath;
+};
+#endif
+
+/* State of one cp command */
+
+struct cp_state_s
+{
+  FAR struct nsh_vtbl_s *vtbl;
+  FAR char *buffer;             /* Copy buffer of the calling thread */
+  size_t    buflen;             /* Size of each copy buffer */
+#ifdef CONFIG_NSH_CMDOPT_CP_BULK
+  bool      progress;           /* -p: Report progress */
+  uint32_t  nfiles;             /* Files copied */
+  uint64_t  nbytes;             /* Bytes copied */
+  uint32_t  start;              /* Start time in msec */
+  uint32_t  lastreport;         /* Time of the last progress report */
+#endif
+#ifdef CP_HAVE_JOBS
+  pthread_mutex_t lock;         /* Protects the fields above and below */
+  pthread_cond_t  cond;         /* Signals queue changes */
+  FAR struct cp_job_s *head;    /* Files waiting to be copied */
+  FAR struct cp_job_s *tail;
+  int       nqueued;            /* Number of files in the queue */
+  int       njobs;              /* Number of copying threads */
+  bool      stop;               /* No more files will be queued */
+  int       ret;                /* First error of a copying thread */
+  pthread_t threads[CONFIG_NSH_CMDOPT_CP_MAXJOBS];
+#endif
+};
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+#ifndef CONFIG_NSH_DISABLE_CP
+/****************************************************************************
+ * Name: cp_msecs
+ ****************************************************************************/
+
+#ifdef CONFIG_NSH_CMDOPT_CP_BULK
+static uint32_t cp_msecs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+/****************************************************************************
+ * Name: cp_report
+ *
+ * Description:
+ *   Print the files and bytes copied so far and the average throughput.
+ *   Called with the state locked when copying in parallel.
+ *
+ ****************************************************************************/
+
+static void cp_report(FAR struct cp_state_s *state, uint32_t now)
+{
+  FAR struct nsh_vtbl_s *vtbl = state->vtbl;
+  uint32_t elapsed = now - state->start;
+
+  nsh_output(vtbl,
+             "cp: %" PRIu32 " files, %" PRIu64 " bytes in %" PRIu32
+             ".%03" PRIu32 " s (%" PRIu64 " KB/s)\n",
+             state->nfiles, state->nbytes, elapsed / 1000, elapsed % 1000,
+             elapsed > 0 ? state->nbytes * 1000 / 1024 / elapsed : 0);
+  nsh_flush(vtbl);
+  state->lastreport = now;
+}
+
+/****************************************************************************
+ * Name: cp_account
+ *
+ * Description:
+ *   Add nbytes (and a completed file if filedone) to the totals and
+ *   report progress about once a second with -p.
+ *
+ ****************************************************************************/
+
+static void cp_account(FAR struct cp_state_s *state, size_t nbytes,
+                       bool filedone)
+{
+  uint32_t now;
+
+#ifdef CP_HAVE_JOBS
+  pthread_mutex_lock(&state->lock);
+#endif
+
+  state->nbytes += nbytes;
+  if (filedone)
+    {
+      state->nfiles++;
+    }
+
+  if (state->progress)
+    {
+      now = cp_msecs();
+      if (now - state->lastreport >= 1000)
+        {
+          cp_report(state, now);
+        }
+    }
+
+#ifdef CP_HAVE_JOBS
+  pthread_mutex_unlock(&state->lock);
+#endif
+}
+#else
+#  define cp_account(s,n,f)
+#endif
+
 /****************************************************************************
  * Name: cp_handler
  ****************************************************************************/
 
-#ifndef CONFIG_NSH_DISABLE_CP
-static int cp_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
-                      FAR const char *destpath)
+static int cp_handler(FAR struct cp_state_s *state, FAR char *buffer,
+                      FAR const char *srcpath, FAR const char *destpath)
 {
+  FAR struct nsh_vtbl_s *vtbl = state->vtbl;
   struct stat buf;
   FAR char *allocpath = NULL;
   int oflags = O_WRONLY | O_CREAT | O_TRUNC;
@@ -165,13 +300,14 @@ static int cp_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
     {
       int nbytesread;
       int nbyteswritten;
-      FAR char *iobuffer = vtbl->iobuffer;
+      FAR char *iobuffer = buffer;
 
-      nbytesread = read(rdfd, iobuffer, IOBUFFERSIZE);
+      nbytesread = read(rdfd, iobuffer, state->buflen);
       if (nbytesread == 0)
         {
           /* End of file */
 
+          cp_account(state, 0, true);
           ret = OK;
           goto errout_with_wrfd;
         }
@@ -194,6 +330,8 @@ static int cp_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
           goto errout_with_wrfd;
         }
 
+      cp_account(state, nbytesread, false);
+
       do
         {
           nbyteswritten = write(wrfd, iobuffer, nbytesread);
@@ -235,16 +373,206 @@ errout_with_rdfd:
 
   return ret;
 }
-#endif
+
+#ifdef CP_HAVE_JOBS
+/****************************************************************************
+ * Name: cp_worker
+ *
+ * Description:
+ *   Copy the files queued by cp_recursive() until the queue is closed.
+ *
+ ****************************************************************************/
+
+static FAR void *cp_worker(FAR void *arg)
+{
+  FAR struct cp_state_s *state = arg;
+  FAR struct nsh_vtbl_s *vtbl = state->vtbl;
+  FAR struct cp_job_s *job;
+  FAR char *buffer;
+  int ret = OK;
+
+  buffer = memalign(CONFIG_NSH_CMDOPT_CP_BUFALIGN, state->buflen);
+  if (buffer == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, "cp");
+      ret = ERROR;
+    }
+
+  pthread_mutex_lock(&state->lock);
+  for (; ; )
+    {
+      while (state->head == NULL && !state->stop)
+        {
+          pthread_cond_wait(&state->cond, &state->lock);
+        }
+
+      job = state->head;
+      if (job == NULL)
+        {
+          break;
+        }
+
+      state->head = job->flink;
+      if (state->head == NULL)
+        {
+          state->tail = NULL;
+        }
+
+      state->nqueued--;
+      pthread_cond_broadcast(&state->cond);
+      pthread_mutex_unlock(&state->lock);
+
+      /* After a failure, just drain the queue */
+
+      if (ret == OK)
+        {
+          ret = cp_handler(state, buffer, job->srcpath, job->destpath);
+        }
+
+      free(job->srcpath);
+      free(job->destpath);
+      free(job);
+
+      pthread_mutex_lock(&state->lock);
+      if (ret != OK && state->ret == OK)
+        {
+          state->ret = ret;
+        }
+    }
+
+  pthread_mutex_unlock(&state->lock);
+  free(buffer);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: cp_queue
+ *
+ * Description:
+ *   Pass a file to the copying threads.  The job takes over the paths.
+ *   Waits while two files per thread are pending already.
+ *
+ ****************************************************************************/
+
+static int cp_queue(FAR struct cp_state_s *state, FAR char *srcpath,
+                    FAR char *destpath)
+{
+  FAR struct nsh_vtbl_s *vtbl = state->vtbl;
+  FAR struct cp_job_s *job;
+  int ret;
+
+  job = malloc(sizeof(struct cp_job_s));
+  if (job == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, "cp");
+      free(srcpath);
+      free(destpath);
+      return ERROR;
+    }
+
+  job->flink    = NULL;
+  job->srcpath  = srcpath;
+  job->destpath = destpath;
+
+  pthread_mutex_lock(&state->lock);
+  while (state->nqueued >= 2 * state->njobs && state->ret == OK)
+    {
+      pthread_cond_wait(&state->cond, &state->lock);
+    }
+
+  if (state->tail != NULL)
+    {
+      state->tail->flink = job;
+    }
+  else
+    {
+      state->head = job;
+    }
+
+  state->tail = job;
+  state->nqueued++;
+  ret = state->ret;
+
+  pthread_cond_broadcast(&state->cond);
+  pthread_mutex_unlock(&state->lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: cp_startjobs
+ ****************************************************************************/
+
+static int cp_startjobs(FAR struct cp_state_s *state, int njobs)
+{
+  pthread_attr_t attr;
+  int ret;
+
+  pthread_mutex_init(&state->lock, NULL);
+  pthread_cond_init(&state->cond, NULL);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_NSH_CMDOPT_CP_STACKSIZE);
+
+  for (state->njobs = 0; state->njobs < njobs; state->njobs++)
+    {
+      ret = pthread_create(&state->threads[state->njobs], &attr,
+                           cp_worker, state);
+      if (ret != 0)
+        {
+          break;
+        }
+    }
+
+  pthread_attr_destroy(&attr);
+
+  if (state->njobs == 0)
+    {
+      pthread_cond_destroy(&state->cond);
+      pthread_mutex_destroy(&state->lock);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: cp_stopjobs
+ *
+ * Description:
+ *   Wait for the queued files to be copied.  Returns the first error of
+ *   any copying thread.
+ *
+ ****************************************************************************/
+
+static int cp_stopjobs(FAR struct cp_state_s *state)
+{
+  int i;
+
+  pthread_mutex_lock(&state->lock);
+  state->stop = true;
+  pthread_cond_broadcast(&state->cond);
+  pthread_mutex_unlock(&state->lock);
+
+  for (i = 0; i < state->njobs; i++)
+    {
+      pthread_join(state->threads[i], NULL);
+    }
+
+  state->njobs = 0;
+  pthread_cond_destroy(&state->cond);
+  pthread_mutex_destroy(&state->lock);
+  return state->ret;
+}
+#endif /* CP_HAVE_JOBS */
 
 /****************************************************************************
  * Name: cp_recursive
  ****************************************************************************/
 
-#ifndef CONFIG_NSH_DISABLE_CP
-static int cp_recursive(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
-                        FAR const char *destpath)
+static int cp_recursive(FAR struct cp_state_s *state,
+                        FAR const char *srcpath, FAR const char *destpath)
 {
+  FAR struct nsh_vtbl_s *vtbl = state->vtbl;
   FAR struct dirent *entry;
   FAR char *allocdestpath;
   FAR char *allocsrcpath;
@@ -300,15 +628,27 @@ static int cp_recursive(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
             }
 #endif
 
-          ret = cp_recursive(vtbl, allocsrcpath, allocdestpath);
+          ret = cp_recursive(state, allocsrcpath, allocdestpath);
           if (ret != OK)
             {
               goto errout_with_allocdestpath;
             }
         }
+#ifdef CP_HAVE_JOBS
+      else if (state->njobs > 0)
+        {
+          /* The directory was created above, so the file can be copied
+           * by any thread from now on.
+           */
+
+          ret = cp_queue(state, allocsrcpath, allocdestpath);
+          continue;
+        }
+#endif
       else
         {
-          ret = cp_handler(vtbl, allocsrcpath, allocdestpath);
+          ret = cp_handler(state, state->buffer, allocsrcpath,
+                           allocdestpath);
           if (ret != OK)
             {
               goto errout_with_allocdestpath;
@@ -849,24 +1189,79 @@ int cmd_dmesg(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 #ifndef CONFIG_NSH_DISABLE_CP
 int cmd_cp(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 {
+  struct cp_state_s state;
   FAR char *srcpath  = NULL;
   FAR char *destpath = NULL;
   bool recursive = false;
+#ifdef CP_HAVE_JOBS
+  int njobs = 1;
+#endif
   int ret = ERROR;
   int option;
 
+  memset(&state, 0, sizeof(state));
+  state.vtbl = vtbl;
+
   /* Get the cp flags */
 
+#ifdef CONFIG_NSH_CMDOPT_CP_BULK
+  while ((option = getopt(argc, argv, "rpj:")) != ERROR)
+#else
   while ((option = getopt(argc, argv, "r")) != ERROR)
+#endif
     {
       switch (option)
         {
           case 'r':
             recursive = true;
             break;
+
+#ifdef CONFIG_NSH_CMDOPT_CP_BULK
+          case 'p':
+            state.progress = true;
+            break;
+
+          case 'j':
+#ifdef CP_HAVE_JOBS
+            njobs = atoi(optarg);
+            if (njobs < 1 || njobs > CONFIG_NSH_CMDOPT_CP_MAXJOBS)
+              {
+                nsh_error(vtbl, g_fmtargrange, argv[0]);
+                return ERROR;
+              }
+#endif
+            break;
+#endif
+
+          default:
+            nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+            return ERROR;
         }
     }
 
+  if (optind + 2 != argc)
+    {
+      nsh_error(vtbl, optind + 2 > argc ? g_fmtargrequired :
+                g_fmttoomanyargs, argv[0]);
+      return ERROR;
+    }
+
+#ifdef CONFIG_NSH_CMDOPT_CP_BULK
+  state.buflen = CONFIG_NSH_CMDOPT_CP_BUFSIZE;
+  state.buffer = memalign(CONFIG_NSH_CMDOPT_CP_BUFALIGN, state.buflen);
+  if (state.buffer == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+      return ERROR;
+    }
+
+  state.start      = cp_msecs();
+  state.lastreport = state.start;
+#else
+  state.buflen = IOBUFFERSIZE;
+  state.buffer = vtbl->iobuffer;
+#endif
+
   /* Get the full path to the source file */
 
   srcpath = nsh_getfullpath(vtbl, argv[optind]);
@@ -895,13 +1290,41 @@ int cmd_cp(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 
   if (recursive)
     {
-      ret = cp_recursive(vtbl, srcpath, destpath);
+#ifdef CP_HAVE_JOBS
+      if (njobs > 1 && cp_startjobs(&state, njobs) < 0)
+        {
+          nsh_error(vtbl, g_fmtcmdfailed, argv[0], "pthread_create",
+                    NSH_ERRNO);
+          goto errout_with_destpath;
+        }
+#endif
+
+      ret = cp_recursive(&state, srcpath, destpath);
+
+#ifdef CP_HAVE_JOBS
+      if (state.njobs > 0)
+        {
+          int jobret = cp_stopjobs(&state);
+
+          if (ret == OK)
+            {
+              ret = jobret;
+            }
+        }
+#endif
     }
   else
     {
-      ret = cp_handler(vtbl, srcpath, destpath);
+      ret = cp_handler(&state, state.buffer, srcpath, destpath);
     }
 
+#ifdef CONFIG_NSH_CMDOPT_CP_BULK
+  if (state.progress)
+    {
+      cp_report(&state, cp_msecs());
+    }
+#endif
+
 errout_with_destpath:
   nsh_freefullpath(destpath);
 
@@ -909,6 +1332,9 @@ errout_with_srcpath:
   nsh_freefullpath(srcpath);
 
 errout:
+#ifdef CONFIG_NSH_CMDOPT_CP_BULK
+  free(state.buffer);
+#endif
   return ret;
 }
 #endif
@@ -1696,13 +2122,23 @@ int cmd_mkfatfs(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
   int rootdirentries;
   int ret = ERROR;
 
-  /* mkfatfs [-F <fatsize>] <block-driver> */
+  /* mkfatfs [-F <fatsize>] [-r <rootdirentries>] [-d] [-e]
+   *         <block-driver>
+   */
 
   badarg = false;
-  while ((option = getopt(argc, argv, ":F:r:")) != ERROR)
+  while ((option = getopt(argc, argv, ":F:r:de")) != ERROR)
     {
       switch (option)
         {
+          case 'd':
+            fmt.ff_flags |= MKFATFS_FLAG_DISCARD;
+            break;
+
+          case 'e':
+            fmt.ff_flags |= MKFATFS_FLAG_ERASED;
+            break;
+
           case 'F':
             fmt.ff_fattype = atoi(optarg);
             if (fmt.ff_fattype != 0  && fmt.ff_fattype != 12 &&
@@ -2140,7 +2576,20 @@ static int unlink_recursive(FAR char *path)
         }
 
       snprintf(&path[len], PATH_MAX - len, "/%s", d->d_name);
-      ret = unlink_recursive(path);
+
+      /* readdir() already tells which entries are directories, so that
+       * plain files can be removed without an lstat() of each one.
+       */
+
+      if (d->d_type != DT_DIR && d->d_type != DT_UNKNOWN)
+        {
+          ret = unlink(path);
+        }
+      else
+        {
+          ret = unlink_recursive(path);
+        }
+
       if (ret < 0)
         {
           closedir(dp);
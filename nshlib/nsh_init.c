@@ -114,6 +114,12 @@ void nsh_initialize(void)
 
   nsh_update_prompt();
 
+#ifdef CONFIG_NSH_CMDHASH
+  /* Index the command table */
+
+  nsh_cmdhash_initialize();
+#endif
+
 #if defined(CONFIG_NSH_READLINE) && defined(CONFIG_READLINE_TABCOMPLETION)
   /* Configure readline prompt */
 
@@ -633,6 +633,10 @@ static int nsh_execute(FAR struct nsh_vtbl_s *vtbl,
    * Note the priority is not effected by nice-ness.
    */
 
+  /* Applications write to the console directly */
+
+  nsh_flush(vtbl);
+
 #ifdef CONFIG_NSH_BUILTIN_APPS
   ret = nsh_builtin(vtbl, argv[0], argv, redirfile, oflags);
   if (ret >= 0)
@@ -816,6 +820,9 @@ static int nsh_execute(FAR struct nsh_vtbl_s *vtbl,
 
       pthread_detach(thread);
 
+#ifndef CONFIG_NSH_DISABLE_JOBS
+      nsh_jobadd(vtbl, thread, argv[0]);
+#endif
       nsh_output(vtbl, "%s [%d:%d]\n", argv[0], thread,
                  param.sched_priority);
     }
@@ -839,6 +846,7 @@ static int nsh_execute(FAR struct nsh_vtbl_s *vtbl,
        */
 
       ret = nsh_command(vtbl, argc, argv);
+      nsh_flush(vtbl);
 
       /* Restore the original output.  Undirect will close the redirection
        * file descriptor.
@@ -2114,9 +2122,20 @@ static int nsh_loop(FAR struct nsh_vtbl_s *vtbl, FAR char **ppcmd,
             {
               /* Set the new file position to the top of the loop offset */
 
-              ret = lseek(np->np_fd,
-                          np->np_lpstate[np->np_lpndx].lp_topoffs,
-                          SEEK_SET);
+#ifdef CONFIG_NSH_SCRIPT_CACHE
+              if (np->np_script != NULL)
+                {
+                  np->np_spos = np->np_lpstate[np->np_lpndx].lp_topoffs;
+                  ret = OK;
+                }
+              else
+#endif
+                {
+                  ret = lseek(np->np_fd,
+                              np->np_lpstate[np->np_lpndx].lp_topoffs,
+                              SEEK_SET);
+                }
+
               if (ret < 0)
                 {
                   nsh_error(vtbl, g_fmtcmdfailed, "done", "lseek",
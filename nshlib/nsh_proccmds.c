@@ -34,6 +34,7 @@
 #include <errno.h>
 #include <signal.h>
 #include <sys/sysinfo.h>
+#include <sys/wait.h>
 #include <sys/param.h>
 #include <time.h>
 
@@ -61,6 +62,10 @@
 #  define PS_SHOW_HEAPSIZE
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_JOBS
+#  define NSH_JOB_POLL_USEC 20000 /* How often to check for finished jobs */
+#endif
+
 #ifndef CONFIG_NSH_DISABLE_PSSTACKUSAGE
 #  define PS_SHOW_STACKSIZE
 #  ifdef CONFIG_STACK_COLORATION
@@ -585,6 +590,88 @@ static int ps_callback(FAR struct nsh_vtbl_s *vtbl, FAR const char *dirpath,
 }
 #endif
 
+/****************************************************************************
+ * Name: nsh_jobpoll
+ *
+ * Description:
+ *   Check if a background command has finished and, if so, get its exit
+ *   status (0 or 1).  The status of NSH commands, which run on detached
+ *   threads, and of tasks whose status was not kept is reported as 0.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_JOBS
+static bool nsh_jobpoll(pid_t pid, FAR int *status)
+{
+#ifdef CONFIG_SCHED_WAITPID
+  pid_t ret;
+  int rc;
+
+  ret = waitpid(pid, &rc, WNOHANG);
+  if (ret == pid)
+    {
+      *status = (rc == 0) ? OK : 1;
+      return true;
+    }
+  else if (ret == 0)
+    {
+      return false;
+    }
+#endif
+
+  if (kill(pid, 0) == 0)
+    {
+      return false;
+    }
+
+  *status = OK;
+  return true;
+}
+#endif
+
+/****************************************************************************
+ * Name: nsh_jobforget
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_JOBS
+static void nsh_jobforget(FAR struct nsh_vtbl_s *vtbl, pid_t pid)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_NSH_MAXJOBS; i++)
+    {
+      if (vtbl->np.np_jobs[i].j_pid == pid)
+        {
+          vtbl->np.np_jobs[i].j_pid = 0;
+        }
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: nsh_jobwait
+ *
+ * Description:
+ *   Wait for a background command to finish, forget it and return its exit
+ *   status.  The command does not have to be in the job list.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_JOBS
+static int nsh_jobwait(FAR struct nsh_vtbl_s *vtbl, pid_t pid)
+{
+  int status;
+
+  while (!nsh_jobpoll(pid, &status))
+    {
+      usleep(NSH_JOB_POLL_USEC);
+    }
+
+  nsh_jobforget(vtbl, pid);
+  return status;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -801,6 +888,262 @@ invalid_arg:
 }
 #endif
 
+/****************************************************************************
+ * Name: nsh_jobadd
+ *
+ * Description:
+ *   Remember a background command so that it can be listed by 'jobs' and
+ *   waited for by 'wait'.  If the list is full, the slot of a command that
+ *   has finished is reused; if there is none, the command is not listed.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_JOBS
+void nsh_jobadd(FAR struct nsh_vtbl_s *vtbl, pid_t pid,
+                FAR const char *name)
+{
+  FAR struct nsh_job_s *job = NULL;
+  int status;
+  int i;
+
+  vtbl->np.np_lastjob = pid;
+
+  for (i = 0; i < CONFIG_NSH_MAXJOBS && job == NULL; i++)
+    {
+      if (vtbl->np.np_jobs[i].j_pid == 0)
+        {
+          job = &vtbl->np.np_jobs[i];
+        }
+    }
+
+  for (i = 0; i < CONFIG_NSH_MAXJOBS && job == NULL; i++)
+    {
+      if (nsh_jobpoll(vtbl->np.np_jobs[i].j_pid, &status))
+        {
+          job = &vtbl->np.np_jobs[i];
+        }
+    }
+
+  if (job != NULL)
+    {
+      job->j_pid = pid;
+      strlcpy(job->j_name, name, sizeof(job->j_name));
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: cmd_jobs
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_JOBS
+int cmd_jobs(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  FAR struct nsh_job_s *job;
+  FAR const char *state;
+  pid_t pid;
+  int status;
+  int i;
+
+  UNUSED(argc);
+  UNUSED(argv);
+
+  for (i = 0; i < CONFIG_NSH_MAXJOBS; i++)
+    {
+      job = &vtbl->np.np_jobs[i];
+      pid = job->j_pid;
+      if (pid == 0)
+        {
+          continue;
+        }
+
+      /* Finished commands are reported once, then forgotten */
+
+      if (!nsh_jobpoll(pid, &status))
+        {
+          state = "Running";
+        }
+      else
+        {
+          state = (status == OK) ? "Done" : "Failed";
+          job->j_pid = 0;
+        }
+
+      nsh_output(vtbl, "[%d] %5d %-7s %s\n", i + 1, (int)pid, state,
+                 job->j_name);
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: cmd_wait
+ *
+ * Description:
+ *   wait [<pid> ...]
+ *
+ *   Wait for the listed background commands, or for all of them if none is
+ *   given.  Fails if the last listed command failed.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_JOBS
+int cmd_wait(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  FAR char *endptr;
+  long pid;
+  int ret = OK;
+  int i;
+
+  if (argc == 1)
+    {
+      for (i = 0; i < CONFIG_NSH_MAXJOBS; i++)
+        {
+          if (vtbl->np.np_jobs[i].j_pid != 0)
+            {
+              nsh_jobwait(vtbl, vtbl->np.np_jobs[i].j_pid);
+            }
+        }
+
+      return OK;
+    }
+
+  for (i = 1; i < argc; i++)
+    {
+      pid = strtol(argv[i], &endptr, 0);
+      if (*argv[i] == '\0' || *endptr != '\0' || pid <= 0)
+        {
+          nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+          return ERROR;
+        }
+
+      ret = nsh_jobwait(vtbl, (pid_t)pid);
+    }
+
+  return (ret == OK) ? OK : ERROR;
+}
+#endif
+
+/****************************************************************************
+ * Name: cmd_parallel
+ *
+ * Description:
+ *   parallel [-j <jobs>] "<command>" ["<command>" ...]
+ *
+ *   Run each command in background, with at most <jobs> (default
+ *   CONFIG_NSH_MAXJOBS) of them running at the same time, and wait for all
+ *   of them.  Fails if any command failed or could not be started.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_JOBS
+int cmd_parallel(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  pid_t pids[CONFIG_NSH_MAXJOBS];
+  FAR char *cmdline;
+  bool bgsave;
+  bool redirsave;
+  bool failed = false;
+  int maxjobs = CONFIG_NSH_MAXJOBS;
+  int njobs = 0;
+  int option;
+  int status;
+  int i;
+  int j;
+
+  while ((option = getopt(argc, argv, "j:")) != ERROR)
+    {
+      if (option != 'j')
+        {
+          nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+          return ERROR;
+        }
+
+      maxjobs = atoi(optarg);
+      if (maxjobs < 1 || maxjobs > CONFIG_NSH_MAXJOBS)
+        {
+          nsh_error(vtbl, g_fmtargrange, argv[0]);
+          return ERROR;
+        }
+    }
+
+  if (optind >= argc)
+    {
+      nsh_error(vtbl, g_fmtargrequired, argv[0]);
+      return ERROR;
+    }
+
+  bgsave    = vtbl->np.np_bg;
+  redirsave = vtbl->np.np_redirect;
+
+  for (i = optind; i <= argc; i++)
+    {
+      /* Wait until a job slot is free, or, after the last command has been
+       * started, until all jobs have finished.
+       */
+
+      while (njobs > 0 && (njobs >= maxjobs || i == argc))
+        {
+          int remaining = njobs;
+
+          for (j = 0; j < njobs; )
+            {
+              if (nsh_jobpoll(pids[j], &status))
+                {
+                  /* Waited for here, no need to list it */
+
+                  nsh_jobforget(vtbl, pids[j]);
+                  failed |= (status != OK);
+                  pids[j] = pids[--njobs];
+                }
+              else
+                {
+                  j++;
+                }
+            }
+
+          if (njobs == remaining)
+            {
+              usleep(NSH_JOB_POLL_USEC);
+            }
+        }
+
+      if (i == argc)
+        {
+          break;
+        }
+
+      /* Start the command in background, like "<command> &" */
+
+      if (asprintf(&cmdline, "%s &", argv[i]) < 0)
+        {
+          nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+          failed = true;
+          continue;
+        }
+
+      vtbl->np.np_lastjob = 0;
+      nsh_parse(vtbl, cmdline);
+      free(cmdline);
+
+      if (vtbl->np.np_lastjob != 0)
+        {
+          pids[njobs++] = vtbl->np.np_lastjob;
+        }
+      else
+        {
+          failed = true;
+        }
+    }
+
+  vtbl->np.np_bg       = bgsave;
+  vtbl->np.np_redirect = redirsave;
+
+  return failed ? ERROR : OK;
+}
+#endif
+
 /****************************************************************************
  * Name: cmd_sleep
  ****************************************************************************/
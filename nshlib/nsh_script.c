@@ -24,8 +24,13 @@
 
 #include <nuttx/config.h>
 
+#include <sys/stat.h>
+#include <ctype.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <sched.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "nsh.h"
@@ -35,10 +40,263 @@
 
 #ifndef CONFIG_NSH_DISABLESCRIPT
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_NSH_SCRIPT_CACHE
+/* The text of a script that was executed recently */
+
+struct nsh_script_s
+{
+  FAR char *path;               /* Full path, NULL if the entry is free */
+  FAR char *text;               /* Content of the file */
+  size_t    len;                /* Size of the file */
+  time_t    mtime;              /* Modification time of the file */
+  uint32_t  lastuse;            /* For LRU replacement */
+  int       refs;               /* Number of scripts executing this text */
+};
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_NSH_SCRIPT_CACHE
+static struct nsh_script_s g_nsh_scripts[CONFIG_NSH_SCRIPT_CACHE_ENTRIES];
+static pthread_mutex_t g_nsh_scriptlock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t g_nsh_scriptclock;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+#ifdef CONFIG_NSH_SCRIPT_CACHE
+/****************************************************************************
+ * Name: nsh_script_free
+ ****************************************************************************/
+
+static void nsh_script_free(FAR struct nsh_script_s *script)
+{
+  free(script->path);
+  free(script->text);
+  memset(script, 0, sizeof(*script));
+}
+
+/****************************************************************************
+ * Name: nsh_script_load
+ *
+ * Description:
+ *   Read the whole script from fd into a free or the least recently used
+ *   idle cache entry.  Called with the cache locked.
+ *
+ ****************************************************************************/
+
+static FAR struct nsh_script_s *nsh_script_load(FAR const char *path,
+                                                int fd,
+                                                FAR const struct stat *st)
+{
+  FAR struct nsh_script_s *script = NULL;
+  FAR char *text;
+  ssize_t nread;
+  size_t len;
+  int i;
+
+  for (i = 0; i < CONFIG_NSH_SCRIPT_CACHE_ENTRIES; i++)
+    {
+      if (g_nsh_scripts[i].path == NULL)
+        {
+          script = &g_nsh_scripts[i];
+          break;
+        }
+
+      if (g_nsh_scripts[i].refs == 0 &&
+          (script == NULL ||
+           (int32_t)(g_nsh_scripts[i].lastuse - script->lastuse) < 0))
+        {
+          script = &g_nsh_scripts[i];
+        }
+    }
+
+  if (script == NULL)
+    {
+      return NULL;
+    }
+
+  text = malloc(st->st_size > 0 ? st->st_size : 1);
+  if (text == NULL)
+    {
+      return NULL;
+    }
+
+  for (len = 0; len < st->st_size; len += nread)
+    {
+      nread = read(fd, &text[len], st->st_size - len);
+      if (nread <= 0)
+        {
+          if (nread < 0 && errno == EINTR)
+            {
+              nread = 0;
+              continue;
+            }
+
+          /* Let the caller read the file as usual */
+
+          lseek(fd, 0, SEEK_SET);
+          free(text);
+          return NULL;
+        }
+    }
+
+  if (script->path != NULL)
+    {
+      nsh_script_free(script);
+    }
+
+  script->path = strdup(path);
+  if (script->path == NULL)
+    {
+      lseek(fd, 0, SEEK_SET);
+      free(text);
+      return NULL;
+    }
+
+  script->text  = text;
+  script->len   = len;
+  script->mtime = st->st_mtime;
+  return script;
+}
+
+/****************************************************************************
+ * Name: nsh_script_get
+ *
+ * Description:
+ *   Return the cached text of the script at path, opened as fd, loading it
+ *   if necessary.  Returns NULL if the script must be read from fd.
+ *
+ ****************************************************************************/
+
+static FAR struct nsh_script_s *nsh_script_get(FAR const char *path, int fd)
+{
+  FAR struct nsh_script_s *script = NULL;
+  struct stat st;
+  int i;
+
+  if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+      st.st_size > CONFIG_NSH_SCRIPT_CACHE_MAXSIZE)
+    {
+      return NULL;
+    }
+
+  pthread_mutex_lock(&g_nsh_scriptlock);
+
+  for (i = 0; i < CONFIG_NSH_SCRIPT_CACHE_ENTRIES; i++)
+    {
+      if (g_nsh_scripts[i].path != NULL &&
+          strcmp(g_nsh_scripts[i].path, path) == 0)
+        {
+          script = &g_nsh_scripts[i];
+          break;
+        }
+    }
+
+  if (script != NULL &&
+      (script->len != st.st_size || script->mtime != st.st_mtime))
+    {
+      /* The script was modified.  If another session is still executing
+       * the old text, read this one from the file.
+       */
+
+      if (script->refs > 0)
+        {
+          pthread_mutex_unlock(&g_nsh_scriptlock);
+          return NULL;
+        }
+
+      nsh_script_free(script);
+      script = NULL;
+    }
+
+  if (script == NULL)
+    {
+      script = nsh_script_load(path, fd, &st);
+    }
+
+  if (script != NULL)
+    {
+      script->lastuse = ++g_nsh_scriptclock;
+      script->refs++;
+    }
+
+  pthread_mutex_unlock(&g_nsh_scriptlock);
+  return script;
+}
+
+/****************************************************************************
+ * Name: nsh_script_put
+ ****************************************************************************/
+
+static void nsh_script_put(FAR struct nsh_script_s *script)
+{
+  pthread_mutex_lock(&g_nsh_scriptlock);
+  DEBUGASSERT(script->refs > 0);
+  script->refs--;
+  pthread_mutex_unlock(&g_nsh_scriptlock);
+}
+#endif
+
+/****************************************************************************
+ * Name: nsh_script_readline
+ *
+ * Description:
+ *   Read the next line of the current script into buffer.  A cached
+ *   script is handled like readline_fd() handles the file: control
+ *   characters other than newline are dropped and the newline is kept.
+ *
+ ****************************************************************************/
+
+static int nsh_script_readline(FAR struct nsh_vtbl_s *vtbl,
+                               FAR char *buffer)
+{
+#ifdef CONFIG_NSH_SCRIPT_CACHE
+  FAR struct nsh_script_s *script = vtbl->np.np_script;
+  size_t nch = 0;
+  int ch;
+
+  if (script != NULL)
+    {
+      if (vtbl->np.np_spos >= script->len)
+        {
+          return EOF;
+        }
+
+      while (vtbl->np.np_spos < script->len)
+        {
+          ch = script->text[vtbl->np.np_spos++];
+          if (ch == '\n')
+            {
+              buffer[nch++] = '\n';
+              break;
+            }
+          else if (!iscntrl(ch & 0xff))
+            {
+              buffer[nch++] = ch;
+              if (nch + 1 >= CONFIG_NSH_LINELEN)
+                {
+                  break;
+                }
+            }
+        }
+
+      buffer[nch] = '\0';
+      return nch;
+    }
+#endif
+
+  return readline_fd(buffer, CONFIG_NSH_LINELEN, vtbl->np.np_fd, -1);
+}
+
 #if defined(CONFIG_ETC_ROMFS) || defined(CONFIG_NSH_ROMFSRC)
 static int nsh_script_redirect(FAR struct nsh_vtbl_s *vtbl,
                                FAR const char *cmd,
@@ -89,6 +347,10 @@ int nsh_script(FAR struct nsh_vtbl_s *vtbl, FAR const FAR char *cmd,
 {
   FAR char *fullpath;
   int savestream;
+#ifdef CONFIG_NSH_SCRIPT_CACHE
+  FAR struct nsh_script_s *savescript;
+  long savespos;
+#endif
   FAR char *buffer;
   int ret = ERROR;
 
@@ -129,6 +391,16 @@ int nsh_script(FAR struct nsh_vtbl_s *vtbl, FAR const FAR char *cmd,
           return ERROR;
         }
 
+#ifdef CONFIG_NSH_SCRIPT_CACHE
+      /* Execute from the cached text if possible */
+
+      savescript = vtbl->np.np_script;
+      savespos   = vtbl->np.np_spos;
+
+      vtbl->np.np_script = nsh_script_get(fullpath, vtbl->np.np_fd);
+      vtbl->np.np_spos   = 0;
+#endif
+
       /* Loop, processing each command line in the script file (or
        * until an error occurs)
        */
@@ -142,7 +414,17 @@ int nsh_script(FAR struct nsh_vtbl_s *vtbl, FAR const FAR char *cmd,
            * script file.  Note that lseek will return -1 on failure.
            */
 
-          vtbl->np.np_foffs = lseek(vtbl->np.np_fd, 0, SEEK_CUR);
+#ifdef CONFIG_NSH_SCRIPT_CACHE
+          if (vtbl->np.np_script != NULL)
+            {
+              vtbl->np.np_foffs = vtbl->np.np_spos;
+            }
+          else
+#endif
+            {
+              vtbl->np.np_foffs = lseek(vtbl->np.np_fd, 0, SEEK_CUR);
+            }
+
           vtbl->np.np_loffs = 0;
 
           if (vtbl->np.np_foffs < 0 && log)
@@ -153,7 +435,7 @@ int nsh_script(FAR struct nsh_vtbl_s *vtbl, FAR const FAR char *cmd,
 
           /* Now read the next line from the script file */
 
-          ret = readline_fd(buffer, CONFIG_NSH_LINELEN, vtbl->np.np_fd, -1);
+          ret = nsh_script_readline(vtbl, buffer);
           if (ret >= 0)
             {
               /* Parse process the command.  NOTE:  this is recursive...
@@ -182,6 +464,16 @@ int nsh_script(FAR struct nsh_vtbl_s *vtbl, FAR const FAR char *cmd,
 
       close(vtbl->np.np_fd);
 
+#ifdef CONFIG_NSH_SCRIPT_CACHE
+      if (vtbl->np.np_script != NULL)
+        {
+          nsh_script_put(vtbl->np.np_script);
+        }
+
+      vtbl->np.np_script = savescript;
+      vtbl->np.np_spos   = savespos;
+#endif
+
       /* Restore the parent script stream */
 
       vtbl->np.np_fd = savestream;
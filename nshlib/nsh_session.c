@@ -201,6 +201,8 @@ int nsh_session(FAR struct console_stdio_s *pstate,
        * on end-of-file or any read failure.
        */
 
+      nsh_flush(vtbl);
+
 #ifdef CONFIG_NSH_CLE
       /* cle() normally returns the number of characters read, but will
        * return a negated errno value on end of file or if an error
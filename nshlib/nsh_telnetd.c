@@ -26,6 +26,10 @@
 
 #include <assert.h>
 #include <debug.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 #include <sys/socket.h>
 
@@ -34,6 +38,77 @@
 
 #ifdef CONFIG_NSH_TELNET
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+/* A session that runs on a pooled task.  exit() would terminate the task,
+ * so nsh_exit() jumps back to nsh_telnetsession() instead.
+ */
+
+struct nsh_telnetjmp_s
+{
+  FAR struct nsh_telnetjmp_s *flink;
+  FAR struct nsh_vtbl_s *vtbl;
+  pid_t tid;
+  int status;
+  jmp_buf env;
+};
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+static FAR struct nsh_telnetjmp_s *g_telnetjmp;
+static pthread_mutex_t g_telnetlock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+/****************************************************************************
+ * Name: nsh_telnetexit
+ *
+ * Description:
+ *   nsh_exit() of a pooled session.  Memory allocated by the command line
+ *   being parsed is lost, for "exit" that is nothing.
+ *
+ ****************************************************************************/
+
+static void nsh_telnetexit(FAR struct nsh_vtbl_s *vtbl, int status)
+{
+  FAR struct nsh_telnetjmp_s *jump;
+  pid_t tid = gettid();
+
+  pthread_mutex_lock(&g_telnetlock);
+  for (jump = g_telnetjmp; jump != NULL; jump = jump->flink)
+    {
+      if (jump->vtbl == vtbl && jump->tid == tid)
+        {
+          break;
+        }
+    }
+
+  pthread_mutex_unlock(&g_telnetlock);
+
+  if (jump != NULL)
+    {
+      jump->status = status;
+      longjmp(jump->env, 1);
+    }
+
+  /* Not called from the session task itself */
+
+  nsh_release(vtbl);
+  exit(status);
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -59,6 +134,57 @@ int nsh_telnetmain(int argc, FAR char *argv[])
   return ret;
 }
 
+/****************************************************************************
+ * Name: nsh_telnetsession
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+int nsh_telnetsession(int argc, FAR char *argv[])
+{
+  FAR struct console_stdio_s *pstate = nsh_newconsole(true);
+  FAR struct nsh_telnetjmp_s **link;
+  struct nsh_telnetjmp_s jump;
+  int ret;
+
+  if (pstate == NULL)
+    {
+      return EXIT_FAILURE;
+    }
+
+  pstate->cn_vtbl.exit = nsh_telnetexit;
+
+  jump.vtbl = &pstate->cn_vtbl;
+  jump.tid  = gettid();
+
+  pthread_mutex_lock(&g_telnetlock);
+  jump.flink  = g_telnetjmp;
+  g_telnetjmp = &jump;
+  pthread_mutex_unlock(&g_telnetlock);
+
+  /* Execute the session, nsh_exit() comes back here */
+
+  if (setjmp(jump.env) == 0)
+    {
+      ret = nsh_session(pstate, NSH_LOGIN_TELNET, argc, argv);
+    }
+  else
+    {
+      ret = jump.status;
+    }
+
+  pthread_mutex_lock(&g_telnetlock);
+  for (link = &g_telnetjmp; *link != &jump; link = &(*link)->flink)
+    {
+    }
+
+  *link = jump.flink;
+  pthread_mutex_unlock(&g_telnetlock);
+
+  nsh_release(&pstate->cn_vtbl);
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Name: nsh_telnetstart
  *
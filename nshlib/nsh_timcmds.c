@@ -25,6 +25,7 @@
 #include <nuttx/config.h>
 
 #include <stdlib.h>
+#include <malloc.h>
 #include <strings.h>
 #include <unistd.h>
 #include <time.h>
@@ -35,6 +36,13 @@
 
 #include <nuttx/timers/rtc.h>
 
+#if !defined(CONFIG_NSH_DISABLE_PERF) && \
+    defined(CONFIG_NSH_CMDOPT_PERF_SAMPLE_MSEC) && \
+    CONFIG_NSH_CMDOPT_PERF_SAMPLE_MSEC > 0
+#  include <pthread.h>
+#  define PERF_HAVE_SAMPLER 1
+#endif
+
 #include "nsh.h"
 #include "nsh_console.h"
 
@@ -44,6 +52,18 @@
 
 #define MAX_TIME_STRING 80
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef PERF_HAVE_SAMPLER
+struct perf_sampler_s
+{
+  volatile bool stop;      /* Set by cmd_perf() to stop the sampler */
+  int           peak;      /* Largest heap usage seen (bytes) */
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -281,6 +301,48 @@ errout_bad_parm:
 }
 #endif
 
+/****************************************************************************
+ * Name: perf_usec
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_PERF
+static uint64_t perf_usec(FAR const struct timespec *start,
+                          FAR const struct timespec *end)
+{
+  return ((uint64_t)end->tv_sec * 1000000 + end->tv_nsec / 1000) -
+         ((uint64_t)start->tv_sec * 1000000 + start->tv_nsec / 1000);
+}
+#endif
+
+/****************************************************************************
+ * Name: perf_sampler
+ *
+ * Description:
+ *   Track the peak heap usage while the profiled command runs.
+ *
+ ****************************************************************************/
+
+#ifdef PERF_HAVE_SAMPLER
+static FAR void *perf_sampler(FAR void *arg)
+{
+  FAR struct perf_sampler_s *sampler = arg;
+  struct mallinfo mm;
+
+  while (!sampler->stop)
+    {
+      mm = mallinfo();
+      if (mm.uordblks > sampler->peak)
+        {
+          sampler->peak = mm.uordblks;
+        }
+
+      usleep(CONFIG_NSH_CMDOPT_PERF_SAMPLE_MSEC * 1000);
+    }
+
+  return NULL;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -360,6 +422,128 @@ int cmd_time(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 }
 #endif
 
+/****************************************************************************
+ * Name: cmd_perf
+ *
+ * Description:
+ *   Like "time", but also report the CPU time used by the shell itself
+ *   (NSH commands are executed by the shell, applications by a new task),
+ *   and the changes in heap usage.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_PERF
+int cmd_perf(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  struct timespec start;
+  struct timespec end;
+#ifdef CONFIG_SCHED_CRITMONITOR
+  struct timespec cpustart;
+  struct timespec cpuend;
+#endif
+#ifdef PERF_HAVE_SAMPLER
+  struct perf_sampler_s sampler;
+  pthread_t thread;
+  bool sampling;
+#endif
+  struct mallinfo mmstart;
+  struct mallinfo mmend;
+  uint64_t usec;
+#ifndef CONFIG_NSH_DISABLEBG
+  bool bgsave;
+#endif
+  bool redirsave;
+  int ret;
+
+  UNUSED(argc);
+
+  mmstart = mallinfo();
+
+#ifdef PERF_HAVE_SAMPLER
+  sampler.stop = false;
+  sampler.peak = mmstart.uordblks;
+  sampling = pthread_create(&thread, NULL, perf_sampler, &sampler) == 0;
+#endif
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpustart);
+#endif
+
+  ret = clock_gettime(CLOCK_MONOTONIC, &start);
+  if (ret < 0)
+    {
+      nsh_error(vtbl, g_fmtcmdfailed, argv[0], "clock_gettime", NSH_ERRNO);
+      ret = ERROR;
+      goto out;
+    }
+
+  /* Save state */
+
+#ifndef CONFIG_NSH_DISABLEBG
+  bgsave    = vtbl->np.np_bg;
+#endif
+  redirsave = vtbl->np.np_redirect;
+
+  /* Execute the command */
+
+  ret = nsh_parse(vtbl, argv[1]);
+
+  /* Restore state */
+
+#ifndef CONFIG_NSH_DISABLEBG
+  vtbl->np.np_bg       = bgsave;
+#endif
+  vtbl->np.np_redirect = redirsave;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+#ifdef CONFIG_SCHED_CRITMONITOR
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuend);
+#endif
+
+out:
+#ifdef PERF_HAVE_SAMPLER
+  if (sampling)
+    {
+      sampler.stop = true;
+      pthread_join(thread, NULL);
+    }
+#endif
+
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  mmend = mallinfo();
+
+  usec = perf_usec(&start, &end);
+  nsh_output(vtbl, "\nwall: %lu.%06lu sec\n",
+             (unsigned long)(usec / 1000000),
+             (unsigned long)(usec % 1000000));
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+  usec = perf_usec(&cpustart, &cpuend);
+  nsh_output(vtbl, "cpu:  %lu.%06lu sec (shell)\n",
+             (unsigned long)(usec / 1000000),
+             (unsigned long)(usec % 1000000));
+#endif
+
+  nsh_output(vtbl, "heap: %+d bytes, %+d chunks in use\n",
+             mmend.uordblks - mmstart.uordblks,
+             mmend.aordblks - mmstart.aordblks);
+
+#ifdef PERF_HAVE_SAMPLER
+  if (sampling)
+    {
+      nsh_output(vtbl, "peak: %+d bytes\n",
+                 sampler.peak - mmstart.uordblks);
+    }
+#endif
+
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Name: cmd_date
  ****************************************************************************/
@@ -0,0 +1,588 @@
+/****************************************************************************
+ * apps/sdr/liquid_dsp/liquid_stream.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/ioctl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+
+#include <nuttx/audio/audio.h>
+
+#include "sdr/liquid_stream.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define LIQUID_STREAM_MQNAMELEN  32
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct liquid_stream_dev_s
+{
+  int fd;
+  int nbufs;
+  FAR struct ap_buffer_s **abufs;
+  uint8_t framesize;            /* Bytes per frame */
+};
+
+struct liquid_stream_s
+{
+  struct liquid_stream_config_s config;
+  struct liquid_stream_dev_s in;
+  struct liquid_stream_dev_s out;
+  mqd_t mq;
+  char mqname[LIQUID_STREAM_MQNAMELEN];
+  pthread_t worker;
+
+  /* Captured buffers waiting for a free playback buffer, and the playback
+   * buffers returned by the driver.  Both only hold pointers, the samples
+   * stay where the DMA put them.
+   */
+
+  FAR struct ap_buffer_s **pending;
+  int pendhead;
+  int npending;
+  FAR struct ap_buffer_s **freebufs;
+  int nfree;
+
+  int nqueued;                  /* Playback buffers queued before start */
+  bool outstarted;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: liquid_stream_enqueue
+ ****************************************************************************/
+
+static int liquid_stream_enqueue(FAR struct liquid_stream_dev_s *dev,
+                                 FAR struct ap_buffer_s *apb)
+{
+  struct audio_buf_desc_s desc;
+
+  apb->curbyte = 0;
+  apb->flags   = 0;
+  desc.numbytes = apb->nbytes;
+  desc.u.buffer = apb;
+
+  if (ioctl(dev->fd, AUDIOIOC_ENQUEUEBUFFER,
+            (unsigned long)(uintptr_t)&desc) < 0)
+    {
+      return -errno;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: liquid_stream_close
+ ****************************************************************************/
+
+static void liquid_stream_close(FAR struct liquid_stream_s *stream,
+                                FAR struct liquid_stream_dev_s *dev)
+{
+  struct audio_buf_desc_s desc;
+  int i;
+
+  if (dev->fd < 0)
+    {
+      return;
+    }
+
+  if (dev->abufs != NULL)
+    {
+      for (i = 0; i < dev->nbufs; i++)
+        {
+          if (dev->abufs[i] != NULL)
+            {
+              desc.u.buffer = dev->abufs[i];
+              ioctl(dev->fd, AUDIOIOC_FREEBUFFER,
+                    (unsigned long)(uintptr_t)&desc);
+            }
+        }
+
+      free(dev->abufs);
+    }
+
+  if (stream->mq != (mqd_t)-1)
+    {
+      ioctl(dev->fd, AUDIOIOC_UNREGISTERMQ, (unsigned long)stream->mq);
+    }
+
+  ioctl(dev->fd, AUDIOIOC_RELEASE, 0);
+  close(dev->fd);
+  dev->fd = -1;
+}
+
+/****************************************************************************
+ * Name: liquid_stream_open
+ *
+ * Description:
+ *   Open and configure one device and let the driver allocate its DMA
+ *   buffers.
+ *
+ ****************************************************************************/
+
+static int liquid_stream_open(FAR struct liquid_stream_s *stream,
+                              FAR struct liquid_stream_dev_s *dev,
+                              FAR const char *devname, uint8_t type,
+                              uint32_t rate, uint8_t channels)
+{
+  struct ap_buffer_info_s info;
+  struct audio_caps_desc_s cap;
+  struct audio_buf_desc_s desc;
+  int ret;
+  int i;
+
+  dev->fd = open(devname, O_RDWR | O_CLOEXEC);
+  if (dev->fd < 0)
+    {
+      return -errno;
+    }
+
+  if (ioctl(dev->fd, AUDIOIOC_RESERVE, 0) < 0)
+    {
+      ret = -errno;
+      close(dev->fd);
+      dev->fd = -1;
+      return ret;
+    }
+
+  memset(&cap, 0, sizeof(cap));
+  cap.caps.ac_len            = sizeof(struct audio_caps_s);
+  cap.caps.ac_type           = type;
+  cap.caps.ac_channels       = channels;
+  cap.caps.ac_controls.hw[0] = rate;
+  cap.caps.ac_controls.b[2]  = 16;
+  cap.caps.ac_controls.b[3]  = rate >> 16;
+
+  if (ioctl(dev->fd, AUDIOIOC_CONFIGURE,
+            (unsigned long)(uintptr_t)&cap) < 0)
+    {
+      goto errout;
+    }
+
+  if (ioctl(dev->fd, AUDIOIOC_GETBUFFERINFO,
+            (unsigned long)(uintptr_t)&info) < 0)
+    {
+      info.nbuffers    = CONFIG_SDR_LIQUID_DSP_STREAM_NBUFFERS;
+      info.buffer_size = CONFIG_SDR_LIQUID_DSP_STREAM_BUFSIZE;
+    }
+
+  dev->framesize = channels * sizeof(int16_t);
+  dev->nbufs     = info.nbuffers;
+  dev->abufs     = calloc(info.nbuffers, sizeof(FAR void *));
+  if (dev->abufs == NULL)
+    {
+      errno = ENOMEM;
+      goto errout;
+    }
+
+  for (i = 0; i < dev->nbufs; i++)
+    {
+      desc.numbytes  = info.buffer_size;
+      desc.u.pbuffer = &dev->abufs[i];
+
+      if (ioctl(dev->fd, AUDIOIOC_ALLOCBUFFER,
+                (unsigned long)(uintptr_t)&desc) < 0)
+        {
+          goto errout;
+        }
+    }
+
+  return OK;
+
+errout:
+  ret = -errno;
+  liquid_stream_close(stream, dev);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: liquid_stream_drain
+ *
+ * Description:
+ *   Run the callback on the pending captured buffers for as long as there
+ *   are playback buffers to write to, then give both back to the drivers.
+ *
+ ****************************************************************************/
+
+static int liquid_stream_drain(FAR struct liquid_stream_s *stream)
+{
+  FAR struct liquid_stream_config_s *config = &stream->config;
+  FAR struct ap_buffer_s *inapb;
+  FAR struct ap_buffer_s *outapb = NULL;
+  FAR int16_t *out = NULL;
+  size_t maxout = 0;
+  int ret;
+
+  while (stream->npending > 0 &&
+         (stream->out.fd < 0 || stream->nfree > 0))
+    {
+      inapb = stream->pending[stream->pendhead];
+      stream->pendhead = (stream->pendhead + 1) % stream->in.nbufs;
+      stream->npending--;
+
+      if (stream->out.fd >= 0)
+        {
+          outapb = stream->freebufs[--stream->nfree];
+          out    = (FAR int16_t *)outapb->samp;
+          maxout = outapb->nmaxbytes / stream->out.framesize;
+        }
+
+      ret = config->process(config->arg, (FAR const int16_t *)inapb->samp,
+                            inapb->nbytes / stream->in.framesize,
+                            out, maxout);
+
+      inapb->nbytes = inapb->nmaxbytes;
+      liquid_stream_enqueue(&stream->in, inapb);
+
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      if (outapb == NULL)
+        {
+          continue;
+        }
+
+      if (ret == 0)
+        {
+          stream->freebufs[stream->nfree++] = outapb;
+          continue;
+        }
+
+      outapb->nbytes = (size_t)ret * stream->out.framesize;
+      liquid_stream_enqueue(&stream->out, outapb);
+
+      /* Start the playback once half of its buffers are queued, so that
+       * jitter of the worker does not immediately underrun it.
+       */
+
+      if (!stream->outstarted &&
+          ++stream->nqueued >= (stream->out.nbufs + 1) / 2)
+        {
+          ioctl(stream->out.fd, AUDIOIOC_START, 0);
+          stream->outstarted = true;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: liquid_stream_isinput
+ ****************************************************************************/
+
+static bool liquid_stream_isinput(FAR struct liquid_stream_s *stream,
+                                  FAR struct ap_buffer_s *apb)
+{
+  int i;
+
+  for (i = 0; i < stream->in.nbufs; i++)
+    {
+      if (stream->in.abufs[i] == apb)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: liquid_stream_worker
+ ****************************************************************************/
+
+static FAR void *liquid_stream_worker(FAR void *arg)
+{
+  FAR struct liquid_stream_s *stream = arg;
+  FAR struct ap_buffer_s *apb;
+  struct audio_msg_s msg;
+  unsigned int prio;
+  ssize_t size;
+  int tail;
+
+  for (; ; )
+    {
+      size = mq_receive(stream->mq, (FAR char *)&msg, sizeof(msg), &prio);
+      if (size != sizeof(msg))
+        {
+          continue;
+        }
+
+      if (msg.msg_id == AUDIO_MSG_STOP || msg.msg_id == AUDIO_MSG_COMPLETE)
+        {
+          break;
+        }
+
+      if (msg.msg_id != AUDIO_MSG_DEQUEUE)
+        {
+          continue;
+        }
+
+      /* Both devices report to the same queue, sort by buffer owner */
+
+      apb = msg.u.ptr;
+      if (liquid_stream_isinput(stream, apb))
+        {
+          tail = (stream->pendhead + stream->npending) % stream->in.nbufs;
+          stream->pending[tail] = apb;
+          stream->npending++;
+        }
+      else
+        {
+          stream->freebufs[stream->nfree++] = apb;
+        }
+
+      if (liquid_stream_drain(stream) < 0)
+        {
+          break;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: liquid_stream_release
+ ****************************************************************************/
+
+static void liquid_stream_release(FAR struct liquid_stream_s *stream)
+{
+  liquid_stream_close(stream, &stream->in);
+  liquid_stream_close(stream, &stream->out);
+  if (stream->mq != (mqd_t)-1)
+    {
+      mq_close(stream->mq);
+      mq_unlink(stream->mqname);
+    }
+
+  free(stream->pending);
+  free(stream->freebufs);
+  free(stream);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: liquid_stream_start
+ ****************************************************************************/
+
+int liquid_stream_start(FAR struct liquid_stream_s **stream,
+                        FAR const struct liquid_stream_config_s *config)
+{
+  FAR struct liquid_stream_s *priv;
+  struct sched_param param;
+  pthread_attr_t attr;
+  struct mq_attr mqattr;
+  int ret;
+  int i;
+
+  if (config->indev == NULL || config->process == NULL)
+    {
+      return -EINVAL;
+    }
+
+  priv = zalloc(sizeof(*priv));
+  if (priv == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  priv->config = *config;
+  priv->in.fd  = -1;
+  priv->out.fd = -1;
+  priv->mq     = (mqd_t)-1;
+
+  ret = liquid_stream_open(priv, &priv->in, config->indev,
+                           AUDIO_TYPE_INPUT, config->inrate,
+                           config->inchannels);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  if (config->outdev != NULL)
+    {
+      ret = liquid_stream_open(priv, &priv->out, config->outdev,
+                               AUDIO_TYPE_OUTPUT, config->outrate,
+                               config->outchannels);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+    }
+
+  /* One queue serves both devices.  It must hold a message for every
+   * buffer in flight plus the stop message.
+   */
+
+  snprintf(priv->mqname, sizeof(priv->mqname), "/liquid_stream%p", priv);
+  mqattr.mq_maxmsg  = priv->in.nbufs + priv->out.nbufs + 8;
+  mqattr.mq_msgsize = sizeof(struct audio_msg_s);
+  mqattr.mq_curmsgs = 0;
+  mqattr.mq_flags   = 0;
+
+  priv->mq = mq_open(priv->mqname, O_RDWR | O_CREAT, 0644, &mqattr);
+  if (priv->mq == (mqd_t)-1 ||
+      ioctl(priv->in.fd, AUDIOIOC_REGISTERMQ, (unsigned long)priv->mq) < 0 ||
+      (priv->out.fd >= 0 &&
+       ioctl(priv->out.fd, AUDIOIOC_REGISTERMQ,
+             (unsigned long)priv->mq) < 0))
+    {
+      ret = -errno;
+      goto errout;
+    }
+
+  priv->pending  = calloc(priv->in.nbufs, sizeof(FAR void *));
+  priv->freebufs = calloc(priv->out.nbufs + 1, sizeof(FAR void *));
+  if (priv->pending == NULL || priv->freebufs == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  /* All playback buffers start free, all capture buffers go to the DMA */
+
+  for (i = 0; i < priv->out.nbufs; i++)
+    {
+      priv->freebufs[priv->nfree++] = priv->out.abufs[i];
+    }
+
+  for (i = 0; i < priv->in.nbufs; i++)
+    {
+      priv->in.abufs[i]->nbytes = priv->in.abufs[i]->nmaxbytes;
+      ret = liquid_stream_enqueue(&priv->in, priv->in.abufs[i]);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+    }
+
+  pthread_attr_init(&attr);
+  param.sched_priority = CONFIG_SDR_LIQUID_DSP_STREAM_PRIORITY;
+  pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+  pthread_attr_setschedparam(&attr, &param);
+  pthread_attr_setstacksize(&attr, CONFIG_SDR_LIQUID_DSP_STREAM_STACKSIZE);
+
+  ret = -pthread_create(&priv->worker, &attr, liquid_stream_worker, priv);
+  pthread_attr_destroy(&attr);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  pthread_setname_np(priv->worker, "liquid_stream");
+
+  if (ioctl(priv->in.fd, AUDIOIOC_START, 0) < 0)
+    {
+      ret = -errno;
+      liquid_stream_stop(priv);
+      return ret;
+    }
+
+  *stream = priv;
+  return OK;
+
+errout:
+  liquid_stream_release(priv);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: liquid_stream_stop
+ ****************************************************************************/
+
+int liquid_stream_stop(FAR struct liquid_stream_s *stream)
+{
+  struct audio_msg_s msg;
+
+  ioctl(stream->in.fd, AUDIOIOC_STOP, 0);
+  if (stream->outstarted)
+    {
+      ioctl(stream->out.fd, AUDIOIOC_STOP, 0);
+    }
+
+  msg.msg_id = AUDIO_MSG_STOP;
+  msg.u.data = 0;
+  mq_send(stream->mq, (FAR const char *)&msg, sizeof(msg), 0);
+
+  pthread_join(stream->worker, NULL);
+  liquid_stream_release(stream);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: liquid_stream_s16tocf
+ ****************************************************************************/
+
+void liquid_stream_s16tocf(FAR const int16_t *in,
+                           FAR liquid_float_complex *out, size_t n)
+{
+  FAR float *f = (FAR float *)out;
+  size_t i;
+
+  /* Written on the float pairs so that the loop vectorizes */
+
+  for (i = 0; i < 2 * n; i++)
+    {
+      f[i] = in[i] * (1.0f / 32768.0f);
+    }
+}
+
+/****************************************************************************
+ * Name: liquid_stream_ftos16
+ ****************************************************************************/
+
+void liquid_stream_ftos16(FAR const float *in, FAR int16_t *out, size_t n)
+{
+  float v;
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    {
+      v = in[i] * 32768.0f;
+      v = v > 32767.0f ? 32767.0f : v < -32768.0f ? -32768.0f : v;
+      out[i] = (int16_t)v;
+    }
+}
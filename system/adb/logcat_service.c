@@ -22,8 +22,14 @@
  * Included Files
  ****************************************************************************/
 
+#include <sys/param.h>
+
 #include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <nuttx/syslog/ramlog.h>
 #include <unistd.h>
@@ -32,15 +38,41 @@
 #include "logcat_service.h"
 #include "hal/hal_uv_priv.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Bytes read from the log device in one go when dropping the newest data */
+
+#define LOGCAT_SCRATCH_SIZE 64
+
 /****************************************************************************
  * Private types
  ****************************************************************************/
 
+/* The log device is drained into the ring as soon as it is readable, so
+ * that the logger never waits for adb.  The ring is sent in frames of up to
+ * CONFIG_ADBD_PAYLOAD_SIZE bytes, one at a time since each frame waits for
+ * its ack.  head and tail are free running byte counters.
+ */
+
 typedef struct logcat_service_s
 {
   adb_service_t service;
+  adb_client_uv_t *client;
   uv_poll_t poll;
+  uv_timer_t timer;
+  int nhandles;       /* Handles to close before freeing the service */
   int wait_ack;
+  bool stats;         /* --stats: report the counters periodically */
+  bool stats_due;
+  size_t head;
+  size_t tail;
+  size_t nread;       /* Bytes read from the log device */
+  size_t nsent;       /* Bytes of log sent to the host */
+  size_t ndropped;    /* Bytes of log dropped because the ring was full */
+  size_t nreported;   /* Value of ndropped at the last report */
+  uint8_t ring[CONFIG_ADBD_LOGCAT_RINGSIZE];
 } logcat_service_t;
 
 /****************************************************************************
@@ -54,6 +86,82 @@ static void logcat_on_data_available(uv_poll_t * handle,
  * Private Functions
  ****************************************************************************/
 
+static size_t logcat_pack_report(logcat_service_t *svc, char *buf,
+                                 size_t size)
+{
+  int ret = 0;
+
+  if (svc->stats_due)
+    {
+      ret = snprintf(buf, size, "--- logcat: %zu bytes read, %zu sent, "
+                     "%zu dropped ---\n", svc->nread, svc->nsent,
+                     svc->ndropped);
+    }
+  else if (svc->ndropped != svc->nreported)
+    {
+      ret = snprintf(buf, size, "--- logcat: %zu bytes dropped ---\n",
+                     svc->ndropped - svc->nreported);
+    }
+
+  if (ret < 0)
+    {
+      return 0;
+    }
+
+  svc->stats_due = false;
+  svc->nreported = svc->ndropped;
+  return (size_t)ret < size ? ret : size - 1;
+}
+
+static void logcat_send(logcat_service_t *svc)
+{
+  apacket_uv_t *ap;
+  size_t len;
+  size_t off;
+  size_t n;
+
+  if (svc->wait_ack || (svc->head == svc->tail && !svc->stats_due &&
+                        svc->ndropped == svc->nreported))
+    {
+      return;
+    }
+
+  /* Retried on the next kick if no frame is free */
+
+  ap = adb_uv_packet_allocate(svc->client, 0);
+  if (ap == NULL)
+    {
+      return;
+    }
+
+  /* Tell the host where log was lost, then coalesce as much of the ring
+   * as fits in the frame.
+   */
+
+  len = logcat_pack_report(svc, (char *)ap->p.data,
+                           CONFIG_ADBD_PAYLOAD_SIZE);
+
+  while (len < CONFIG_ADBD_PAYLOAD_SIZE && svc->head != svc->tail)
+    {
+      off = svc->tail % CONFIG_ADBD_LOGCAT_RINGSIZE;
+      n = CONFIG_ADBD_LOGCAT_RINGSIZE - off;
+      n = MIN(n, svc->head - svc->tail);
+      n = MIN(n, CONFIG_ADBD_PAYLOAD_SIZE - len);
+
+      memcpy(&ap->p.data[len], &svc->ring[off], n);
+      svc->tail  += n;
+      svc->nsent += n;
+      len        += n;
+    }
+
+  svc->wait_ack = 1;
+
+  ap->p.write_len = len;
+  ap->p.msg.arg0 = svc->service.id;
+  ap->p.msg.arg1 = svc->service.peer_id;
+  adb_send_data_frame(&svc->client->client, &ap->p);
+}
+
 static int logcat_on_write(adb_service_t *service, apacket *p)
 {
   UNUSED(p);
@@ -64,12 +172,7 @@ static int logcat_on_write(adb_service_t *service, apacket *p)
 static void logcat_on_kick(struct adb_service_s *service)
 {
   logcat_service_t *svc = container_of(service, logcat_service_t, service);
-  if (!svc->wait_ack)
-    {
-      int ret;
-      ret = uv_poll_start(&svc->poll, UV_READABLE, logcat_on_data_available);
-      assert(ret == 0);
-    }
+  logcat_send(svc);
 }
 
 static int logcat_on_ack(adb_service_t *service, apacket *p)
@@ -77,14 +180,18 @@ static int logcat_on_ack(adb_service_t *service, apacket *p)
   UNUSED(p);
   logcat_service_t *svc = container_of(service, logcat_service_t, service);
   svc->wait_ack = 0;
-  logcat_on_kick(service);
+  logcat_send(svc);
   return 0;
 }
 
 static void close_cb(uv_handle_t *handle)
 {
-  logcat_service_t *service = container_of(handle, logcat_service_t, poll);
-  free(service);
+  logcat_service_t *service = handle->data;
+
+  if (--service->nhandles == 0)
+    {
+      free(service);
+    }
 }
 
 static void logcat_on_close(struct adb_service_s *service)
@@ -97,7 +204,14 @@ static void logcat_on_close(struct adb_service_s *service)
   assert(ret == 0);
 
   close(fd);
+  svc->poll.data = svc;
   uv_close((uv_handle_t *)&svc->poll, close_cb);
+
+  if (svc->stats)
+    {
+      svc->timer.data = svc;
+      uv_close((uv_handle_t *)&svc->timer, close_cb);
+    }
 }
 
 static const adb_service_ops_t g_logcat_ops =
@@ -108,21 +222,96 @@ static const adb_service_ops_t g_logcat_ops =
   .on_close       = logcat_on_close
 };
 
+static void logcat_on_timer(uv_timer_t *handle)
+{
+  logcat_service_t *svc = container_of(handle, logcat_service_t, timer);
+
+  svc->stats_due = true;
+  logcat_send(svc);
+}
+
+/* Read what the log device has, whatever the state of the adb stream */
+
+static int logcat_drain(logcat_service_t *svc, int fd)
+{
+#ifdef CONFIG_ADBD_LOGCAT_DROP_NEWEST
+  uint8_t scratch[LOGCAT_SCRATCH_SIZE];
+#endif
+  size_t budget = CONFIG_ADBD_LOGCAT_RINGSIZE;
+  size_t used;
+  size_t off;
+  size_t n;
+  ssize_t ret;
+
+  /* Bound the work done in one callback, the loop has other clients */
+
+  while (budget > 0)
+    {
+      used = svc->head - svc->tail;
+      off  = svc->head % CONFIG_ADBD_LOGCAT_RINGSIZE;
+      n    = CONFIG_ADBD_LOGCAT_RINGSIZE - off;
+
+#ifdef CONFIG_ADBD_LOGCAT_DROP_NEWEST
+      if (used == CONFIG_ADBD_LOGCAT_RINGSIZE)
+        {
+          /* Full: read and discard the new log */
+
+          ret = read(fd, scratch, sizeof(scratch));
+          if (ret > 0)
+            {
+              svc->nread    += ret;
+              svc->ndropped += ret;
+              budget        -= MIN(budget, (size_t)ret);
+              continue;
+            }
+        }
+      else
+#endif
+        {
+#ifdef CONFIG_ADBD_LOGCAT_DROP_NEWEST
+          n = MIN(n, CONFIG_ADBD_LOGCAT_RINGSIZE - used);
+#endif
+          ret = read(fd, &svc->ring[off], n);
+          if (ret > 0)
+            {
+              svc->head  += ret;
+              svc->nread += ret;
+              budget     -= MIN(budget, (size_t)ret);
+
+              /* Full: the oldest log was overwritten */
+
+              used += ret;
+              if (used > CONFIG_ADBD_LOGCAT_RINGSIZE)
+                {
+                  used -= CONFIG_ADBD_LOGCAT_RINGSIZE;
+                  svc->tail     += used;
+                  svc->ndropped += used;
+                }
+
+              continue;
+            }
+        }
+
+      if (ret == 0 || errno == EAGAIN)
+        {
+          break;
+        }
+      else if (errno != EINTR)
+        {
+          return -errno;
+        }
+    }
+
+  return 0;
+}
+
 static void logcat_on_data_available(uv_poll_t * handle,
                                      int status, int events)
 {
   int ret;
   int fd;
-  apacket_uv_t *ap;
   logcat_service_t *service = container_of(handle, logcat_service_t, poll);
-  adb_client_uv_t *client = (adb_client_uv_t *)handle->data;
-
-  ap = adb_uv_packet_allocate(client, 0);
-  if (ap == NULL)
-    {
-      uv_poll_stop(handle);
-      return;
-    }
+  apacket_uv_t *ap;
 
   if (status)
     {
@@ -136,42 +325,27 @@ static void logcat_on_data_available(uv_poll_t * handle,
   ret = uv_fileno((uv_handle_t *)handle, &fd);
   assert(ret == 0);
 
-  ret = read(fd, ap->p.data, CONFIG_ADBD_PAYLOAD_SIZE);
+  ret = logcat_drain(service, fd);
   if (ret < 0)
     {
-      adb_err("frame read failed %d %d\n", ret, errno);
-      if (errno == EAGAIN)
-        {
-          /* TODO this should never happen */
-
-          goto exit_release_packet;
-        }
+      adb_err("frame read failed %d\n", ret);
 
       /* Fatal error, stop service */
 
       goto exit_stop_service;
     }
 
-  if (ret == 0)
-    {
-      goto exit_release_packet;
-    }
-
-  service->wait_ack = 1;
-  uv_poll_stop(handle);
-
-  ap->p.write_len = ret;
-  ap->p.msg.arg0 = service->service.id;
-  ap->p.msg.arg1 = service->service.peer_id;
-  adb_send_data_frame(&client->client, &ap->p);
-  return;
-
-exit_release_packet:
-  adb_hal_apacket_release(&client->client, &ap->p);
+  logcat_send(service);
   return;
 
 exit_stop_service:
-  adb_service_close(&client->client, &service->service, &ap->p);
+  uv_poll_stop(handle);
+  ap = adb_uv_packet_allocate(service->client, 0);
+  if (ap != NULL)
+    {
+      adb_service_close(&service->client->client, &service->service,
+                        &ap->p);
+    }
 }
 
 /****************************************************************************
@@ -189,12 +363,14 @@ adb_service_t * logcat_service(adb_client_t *client, const char *params)
       return NULL;
     }
 
+  memset(service, 0, sizeof(*service));
   service->service.ops = &g_logcat_ops;
-  service->wait_ack = 0;
+  service->client = (adb_client_uv_t *)client;
+  service->stats = params != NULL && strstr(params, "--stats") != NULL;
 
-  /* TODO parse params string to extract logcat parameters */
+  /* Non-blocking, the ring is filled until the log device is empty */
 
-  ret = open(CONFIG_SYSLOG_DEVPATH, O_RDONLY | O_CLOEXEC);
+  ret = open(CONFIG_SYSLOG_DEVPATH, O_RDONLY | O_CLOEXEC | O_NONBLOCK);
 
   if (ret < 0)
     {
@@ -206,9 +382,22 @@ adb_service_t * logcat_service(adb_client_t *client, const char *params)
   uv_handle_t *handle = adb_uv_get_client_handle(client);
   ret = uv_poll_init(handle->loop, &service->poll, ret);
   assert(ret == 0);
+  service->nhandles++;
 
-  service->poll.data = client;
-  logcat_on_kick(&service->service);
+  if (service->stats)
+    {
+      ret = uv_timer_init(handle->loop, &service->timer);
+      assert(ret == 0);
+      service->nhandles++;
+
+      uv_timer_start(&service->timer, logcat_on_timer,
+                     CONFIG_ADBD_LOGCAT_STATS_INTERVAL * 1000,
+                     CONFIG_ADBD_LOGCAT_STATS_INTERVAL * 1000);
+    }
+
+  ret = uv_poll_start(&service->poll, UV_READABLE,
+                      logcat_on_data_available);
+  assert(ret == 0);
 
   return &service->service;
 }
@@ -30,13 +30,30 @@
 #include <syslog.h>
 #include <dirent.h>
 #include <elf.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #include <nuttx/binfmt/binfmt.h>
 #include <nuttx/streams.h>
 
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+#  include "coredump.h"
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SYSTEM_COREDUMP_RESTORE_BUFSIZE
+#  define CONFIG_SYSTEM_COREDUMP_RESTORE_BUFSIZE 4096
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -44,6 +61,23 @@
 typedef CODE void (*dumpfile_cb_t)(FAR char *path, FAR const char *filename,
                                    FAR void *arg);
 
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+struct coredump_chunkopt_s
+{
+  bool enable;                  /* Write the chunked format */
+  uint32_t start;               /* First chunk to write */
+  FAR const char *crcfile;      /* Checksums of the previous image */
+};
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+static struct coredump_chunkopt_s g_chunk;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -116,10 +150,13 @@ static void coredump_restore(FAR char *savepath, size_t maxfile)
   FAR struct coredump_info_s *info;
   unsigned char *swap;
   char dumppath[PATH_MAX];
+  char scratch[PATH_MAX];
   struct geometry geo;
+  struct stat st;
   ssize_t writesize;
   ssize_t readsize;
   struct tm *dtime;
+  size_t bufsize;
   size_t offset = 0;
   size_t max = 0;
   int dumpfd;
@@ -152,21 +189,6 @@ static void coredump_restore(FAR char *savepath, size_t maxfile)
       goto info_err;
     }
 
-  ret = dumpfile_iterate(savepath, dumpfile_count, &max);
-  if (ret < 0)
-    {
-      goto info_err;
-    }
-
-  if (max >= maxfile)
-    {
-      ret = dumpfile_iterate(savepath, dumpfile_delete, dumppath);
-      if (ret < 0)
-        {
-          goto info_err;
-        }
-    }
-
   ret = snprintf(dumppath, sizeof(dumppath),
                  "%s/core-%s", savepath,
                  info->name.version);
@@ -193,25 +215,63 @@ static void coredump_restore(FAR char *savepath, size_t maxfile)
         }
     }
 
-  dumpfd = open(dumppath, O_CREAT | O_WRONLY | O_TRUNC, 0777);
+  /* The name only depends on the dump, so a restore that was interrupted
+   * left a shorter file of the same name behind: continue it.
+   */
+
+  if (stat(dumppath, &st) == 0 && st.st_size < info->size)
+    {
+      offset = st.st_size - st.st_size % geo.geo_sectorsize;
+      printf("Resume %s at %zu\n", dumppath, offset);
+    }
+  else
+    {
+      ret = dumpfile_iterate(savepath, dumpfile_count, &max);
+      if (ret < 0)
+        {
+          goto info_err;
+        }
+
+      if (max >= maxfile)
+        {
+          ret = dumpfile_iterate(savepath, dumpfile_delete, scratch);
+          if (ret < 0)
+            {
+              goto info_err;
+            }
+        }
+    }
+
+  dumpfd = open(dumppath, O_CREAT | O_WRONLY | (offset ? 0 : O_TRUNC),
+                0777);
   if (dumpfd < 0)
     {
       printf("Open %s fail\n", dumppath);
       goto info_err;
     }
 
-  swap = malloc(geo.geo_sectorsize);
+  /* Copy several sectors at a time */
+
+  bufsize = CONFIG_SYSTEM_COREDUMP_RESTORE_BUFSIZE -
+            CONFIG_SYSTEM_COREDUMP_RESTORE_BUFSIZE % geo.geo_sectorsize;
+  if (bufsize < geo.geo_sectorsize)
+    {
+      bufsize = geo.geo_sectorsize;
+    }
+
+  swap = malloc(bufsize);
   if (swap == NULL)
     {
       printf("Malloc fail\n");
       goto fd_err;
     }
 
-  lseek(blkfd, 0, SEEK_SET);
+  lseek(dumpfd, offset, SEEK_SET);
+  lseek(blkfd, offset, SEEK_SET);
   while (offset < info->size)
     {
-      readsize = read(blkfd, swap, geo.geo_sectorsize);
-      if (readsize < 0)
+      readsize = read(blkfd, swap, bufsize);
+      if (readsize <= 0)
         {
           printf("Read %s fail\n", CONFIG_BOARD_COREDUMP_BLKDEV_PATH);
           break;
@@ -227,10 +287,16 @@ static void coredump_restore(FAR char *savepath, size_t maxfile)
       offset += writesize;
     }
 
-  printf("Coredump finish [%s][%zu]\n", dumppath, info->size);
-  info->magic = 0;
-  lseek(blkfd, (geo.geo_nsectors - 1) * geo.geo_sectorsize, SEEK_SET);
-  write(blkfd, info, geo.geo_sectorsize);
+  /* An incomplete copy is kept, to be resumed by the next restore */
+
+  if (offset >= info->size)
+    {
+      printf("Coredump finish [%s][%zu]\n", dumppath, info->size);
+      info->magic = 0;
+      lseek(blkfd, (geo.geo_nsectors - 1) * geo.geo_sectorsize, SEEK_SET);
+      write(blkfd, info, geo.geo_sectorsize);
+    }
+
   free(swap);
 fd_err:
   close(dumpfd);
@@ -252,6 +318,9 @@ static int coredump_now(int pid, FAR char *filename)
   FAR struct lib_hexdumpstream_s *hstream;
 #ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
   FAR struct lib_lzfoutstream_s *lstream;
+#endif
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+  FAR struct coredump_chunkstream_s *cstream = NULL;
 #endif
   FAR void *stream;
   FAR FILE *file;
@@ -277,6 +346,18 @@ static int coredump_now(int pid, FAR char *filename)
   hstream = malloc(sizeof(*hstream) + sizeof(*outstream));
 #endif
 
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+  if (hstream != NULL && g_chunk.enable)
+    {
+      cstream = malloc(sizeof(*cstream));
+      if (cstream == NULL)
+        {
+          free(hstream);
+          hstream = NULL;
+        }
+    }
+#endif
+
   if (hstream == NULL)
     {
       if (filename != NULL)
@@ -303,24 +384,53 @@ static int coredump_now(int pid, FAR char *filename)
   lib_hexdumpstream(hstream, (FAR void *)outstream);
   stream = hstream;
 
-#ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+  if (cstream != NULL)
+    {
+      /* Chunks compress themselves; a file gets them in binary */
 
-  /* Initialize LZF compression stream */
+      if (filename != NULL)
+        {
+          stream = outstream;
+        }
 
-  lib_lzfoutstream(lstream, stream);
-  stream = lstream;
+      coredump_chunkstream(cstream, stream, g_chunk.start, g_chunk.crcfile);
+      stream = cstream;
+    }
+  else
+#endif
+    {
+#ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
+      /* Initialize LZF compression stream */
 
+      lib_lzfoutstream(lstream, stream);
+      stream = lstream;
 #endif
+    }
 
   /* Do core dump */
 
   core_dump(NULL, stream, pid);
-  setlogmask(logmask);
-#  ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
-  printf("Finish coredump (Compression Enabled).\n");
-#  else
-  printf("Finish coredump.\n");
-#  endif
+
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+  if (cstream != NULL)
+    {
+      uint32_t nchunks = coredump_chunkstream_finish(cstream);
+
+      setlogmask(logmask);
+      printf("Finish coredump (%" PRIu32 " chunks).\n", nchunks);
+      free(cstream);
+    }
+  else
+#endif
+    {
+      setlogmask(logmask);
+#ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
+      printf("Finish coredump (Compression Enabled).\n");
+#else
+      printf("Finish coredump.\n");
+#endif
+    }
 
   free(hstream);
   if (filename != NULL)
@@ -331,6 +441,84 @@ static int coredump_now(int pid, FAR char *filename)
   return 0;
 }
 
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+/****************************************************************************
+ * coredump_send
+ *
+ * Description:
+ *   Write a saved core file in the chunked format, for example to resume
+ *   the transfer of a dump restored with -s from a given chunk.
+ *
+ ****************************************************************************/
+
+static int coredump_send(FAR const char *corefile, FAR char *filename)
+{
+  FAR struct coredump_chunkstream_s *cstream;
+  struct lib_stdoutstream_s outstream;
+  struct lib_hexdumpstream_s hstream;
+  FAR void *stream = &outstream;
+  uint8_t buf[256];
+  FAR FILE *file = stdout;
+  ssize_t nread;
+  int ret = 0;
+  int fd;
+
+  fd = open(corefile, O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  cstream = malloc(sizeof(*cstream));
+  if (cstream == NULL)
+    {
+      close(fd);
+      return -ENOMEM;
+    }
+
+  if (filename != NULL)
+    {
+      file = fopen(filename, "w");
+      if (file == NULL)
+        {
+          ret = -errno;
+          goto errout;
+        }
+    }
+
+  lib_stdoutstream(&outstream, file);
+  if (filename == NULL)
+    {
+      lib_hexdumpstream(&hstream, (FAR void *)&outstream);
+      stream = &hstream;
+    }
+
+  coredump_chunkstream(cstream, stream, g_chunk.start, g_chunk.crcfile);
+
+  while ((nread = read(fd, buf, sizeof(buf))) > 0)
+    {
+      lib_stream_puts(cstream, buf, nread);
+    }
+
+  if (nread < 0)
+    {
+      ret = -errno;
+    }
+
+  coredump_chunkstream_finish(cstream);
+
+  if (filename != NULL)
+    {
+      fclose(file);
+    }
+
+errout:
+  free(cstream);
+  close(fd);
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * usage
  ****************************************************************************/
@@ -349,6 +537,17 @@ static void usage(FAR const char *progname, int exitcode)
   fprintf(stderr, "\t -s, --savepath <savepath>\n");
   fprintf(stderr, "\t -m, --maxfile <maxfile>,"
                   "Maximum number of coredump files, Default 1\n");
+#endif
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+  fprintf(stderr, "Chunked format, resumable and incremental:\n");
+  fprintf(stderr, "\t -k, --chunked, Write chunks\n");
+  fprintf(stderr, "\t -c, --send <corefile>, "
+                  "Write a saved core file as chunks\n");
+  fprintf(stderr, "\t -o, --offset <chunk>, "
+                  "Start at this chunk, Default 0\n");
+  fprintf(stderr, "\t -i, --incremental <crcfile>, "
+                  "Skip chunks unchanged since the image of crcfile,\n"
+                  "\t    the checksums of this image go to crcfile.new\n");
 #endif
   exit(exitcode);
 }
@@ -366,6 +565,9 @@ int main(int argc, FAR char *argv[])
 #ifdef CONFIG_BOARD_COREDUMP_BLKDEV
   FAR char *savepath = NULL;
   size_t maxfile = 1;
+#endif
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+  FAR char *corefile = NULL;
 #endif
   char *name = NULL;
   int pid = INVALID_PROCESS_ID;
@@ -378,11 +580,17 @@ int main(int argc, FAR char *argv[])
 #ifdef CONFIG_BOARD_COREDUMP_BLKDEV
       {"savepath", 1, NULL, 's'},
       {"maxfile", 1, NULL, 'm'},
+#endif
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+      {"chunked", 0, NULL, 'k'},
+      {"send", 1, NULL, 'c'},
+      {"offset", 1, NULL, 'o'},
+      {"incremental", 1, NULL, 'i'},
 #endif
       {"help", 0, NULL, 'h'}
     };
 
-  while ((ret = getopt_long(argc, argv, "p:f:s:m:h", options, NULL))
+  while ((ret = getopt_long(argc, argv, "p:f:s:m:kc:o:i:h", options, NULL))
          != ERROR)
     {
       switch (ret)
@@ -400,6 +608,20 @@ int main(int argc, FAR char *argv[])
           case 'm':
             maxfile = atoi(optarg);
             break;
+#endif
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+          case 'k':
+            g_chunk.enable = true;
+            break;
+          case 'c':
+            corefile = optarg;
+            break;
+          case 'o':
+            g_chunk.start = strtoul(optarg, NULL, 0);
+            break;
+          case 'i':
+            g_chunk.crcfile = optarg;
+            break;
 #endif
           case 'h':
           default:
@@ -408,6 +630,18 @@ int main(int argc, FAR char *argv[])
         }
     }
 
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNKED
+  if (corefile != NULL)
+    {
+      ret = coredump_send(corefile, name);
+      if (ret < 0)
+        {
+          fprintf(stderr, "Send %s failed: %d\n", corefile, ret);
+          return EXIT_FAILURE;
+        }
+    }
+  else
+#endif
 #ifdef CONFIG_BOARD_COREDUMP_BLKDEV
   if (savepath != NULL)
     {
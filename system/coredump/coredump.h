@@ -0,0 +1,123 @@
+/****************************************************************************
+ * apps/system/coredump/coredump.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_SYSTEM_COREDUMP_COREDUMP_H
+#define __APPS_SYSTEM_COREDUMP_COREDUMP_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+
+#include <nuttx/streams.h>
+
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNK_LZF
+#  include <lzf.h>
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SYSTEM_COREDUMP_CHUNKSIZE
+#  define CONFIG_SYSTEM_COREDUMP_CHUNKSIZE 1024
+#endif
+
+/* Chunked core format.  The core image is cut into chunks of
+ * CONFIG_SYSTEM_COREDUMP_CHUNKSIZE bytes; chunk n holds the bytes at
+ * n * CONFIG_SYSTEM_COREDUMP_CHUNKSIZE.  Each chunk is sent as a 16 byte
+ * header followed by plen payload bytes, all numbers little endian:
+ *
+ *   "CK" type reserved 4-byte-seq 2-byte-len 2-byte-plen 4-byte-crc32
+ *
+ * len is the size of the chunk in the image and crc32 its checksum.  The
+ * chunks can be sent from any chunk on, so that an interrupted transfer
+ * can be resumed.
+ */
+
+#define COREDUMP_CHUNK_HDRSIZE  16
+
+#define COREDUMP_CHUNK_DATA     0  /* Payload is the chunk */
+#define COREDUMP_CHUNK_LZF      1  /* Payload is one lzf block */
+#define COREDUMP_CHUNK_ZERO     2  /* All zeroes, no payload */
+#define COREDUMP_CHUNK_SAME     3  /* As in the previous image, no payload */
+#define COREDUMP_CHUNK_END      4  /* seq is the number of chunks */
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct coredump_chunkstream_s
+{
+  struct lib_outstream_s common;
+  FAR struct lib_outstream_s *next;     /* Where the chunks go */
+  uint32_t seq;                         /* Chunk being collected */
+  uint32_t start;                       /* First chunk to send */
+  size_t   len;                         /* Bytes collected */
+  int      oldcrc;                      /* Checksums of the previous image */
+  int      newcrc;                      /* Checksums of this image */
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNK_LZF
+  lzf_state_t htab;
+  uint8_t  zbuf[LZF_MAX_HDR_SIZE + CONFIG_SYSTEM_COREDUMP_CHUNKSIZE + 16];
+  uint8_t  buf[LZF_MAX_HDR_SIZE + CONFIG_SYSTEM_COREDUMP_CHUNKSIZE];
+#else
+  uint8_t  buf[CONFIG_SYSTEM_COREDUMP_CHUNKSIZE];
+#endif
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: coredump_chunkstream
+ *
+ * Description:
+ *   Initialize a stream that writes the data written to it as chunks to
+ *   next.  Chunks before start are only checksummed.  If crcfile is not
+ *   NULL, chunks whose checksum is as in crcfile are sent as
+ *   COREDUMP_CHUNK_SAME, and the checksums of this image are written to
+ *   crcfile.new.  Once the receiver has the image, crcfile.new can
+ *   replace crcfile for the next one.
+ *
+ ****************************************************************************/
+
+void coredump_chunkstream(FAR struct coredump_chunkstream_s *stream,
+                          FAR struct lib_outstream_s *next, uint32_t start,
+                          FAR const char *crcfile);
+
+/****************************************************************************
+ * Name: coredump_chunkstream_finish
+ *
+ * Description:
+ *   Send the last partial chunk and the end chunk.
+ *
+ * Returned Value:
+ *   The number of chunks in the image.
+ *
+ ****************************************************************************/
+
+uint32_t
+coredump_chunkstream_finish(FAR struct coredump_chunkstream_s *stream);
+
+#endif /* __APPS_SYSTEM_COREDUMP_COREDUMP_H */
@@ -0,0 +1,295 @@
+/****************************************************************************
+ * apps/system/coredump/coredump_chunk.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <nuttx/crc32.h>
+
+#include "coredump.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNK_LZF
+#  define CHUNK_DATA(s) (&(s)->buf[LZF_MAX_HDR_SIZE])
+#else
+#  define CHUNK_DATA(s) ((s)->buf)
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: chunk_header
+ ****************************************************************************/
+
+static void chunk_header(FAR struct coredump_chunkstream_s *stream,
+                         uint8_t type, size_t plen, uint32_t crc)
+{
+  uint8_t hdr[COREDUMP_CHUNK_HDRSIZE];
+
+  hdr[0]  = 'C';
+  hdr[1]  = 'K';
+  hdr[2]  = type;
+  hdr[3]  = 0;
+  hdr[4]  = stream->seq;
+  hdr[5]  = stream->seq >> 8;
+  hdr[6]  = stream->seq >> 16;
+  hdr[7]  = stream->seq >> 24;
+  hdr[8]  = stream->len;
+  hdr[9]  = stream->len >> 8;
+  hdr[10] = plen;
+  hdr[11] = plen >> 8;
+  hdr[12] = crc;
+  hdr[13] = crc >> 8;
+  hdr[14] = crc >> 16;
+  hdr[15] = crc >> 24;
+
+  lib_stream_puts(stream->next, hdr, sizeof(hdr));
+}
+
+/****************************************************************************
+ * Name: chunk_iszero
+ ****************************************************************************/
+
+static bool chunk_iszero(FAR const uint8_t *data, size_t len)
+{
+  while (len-- > 0)
+    {
+      if (*data++ != 0)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: chunk_emit
+ ****************************************************************************/
+
+static void chunk_emit(FAR struct coredump_chunkstream_s *stream)
+{
+  FAR uint8_t *data = CHUNK_DATA(stream);
+  uint32_t oldcrc;
+  uint32_t crc;
+  uint8_t type;
+
+  crc  = crc32(data, stream->len);
+  type = COREDUMP_CHUNK_DATA;
+
+  if (chunk_iszero(data, stream->len))
+    {
+      type = COREDUMP_CHUNK_ZERO;
+    }
+  else if (stream->oldcrc >= 0 &&
+           read(stream->oldcrc, &oldcrc, sizeof(oldcrc)) ==
+           sizeof(oldcrc) && oldcrc == crc)
+    {
+      type = COREDUMP_CHUNK_SAME;
+    }
+
+  if (type == COREDUMP_CHUNK_ZERO && stream->oldcrc >= 0)
+    {
+      /* Keep the previous checksums in step */
+
+      lseek(stream->oldcrc, sizeof(oldcrc), SEEK_CUR);
+    }
+
+  if (stream->newcrc >= 0 &&
+      write(stream->newcrc, &crc, sizeof(crc)) != sizeof(crc))
+    {
+      close(stream->newcrc);
+      stream->newcrc = -1;
+    }
+
+  if (stream->seq >= stream->start)
+    {
+      if (type != COREDUMP_CHUNK_DATA)
+        {
+          chunk_header(stream, type, 0, crc);
+        }
+      else
+        {
+#ifdef CONFIG_SYSTEM_COREDUMP_CHUNK_LZF
+          FAR struct lzf_header_s *header;
+          size_t len;
+
+          len = lzf_compress(data, stream->len,
+                             &stream->zbuf[LZF_MAX_HDR_SIZE],
+                             stream->len > 4 ? stream->len - 4 : stream->len,
+                             stream->htab, &header);
+          if (((FAR uint8_t *)header)[2] != 0)
+            {
+              chunk_header(stream, COREDUMP_CHUNK_LZF, len, crc);
+              lib_stream_puts(stream->next, header, len);
+            }
+          else
+#endif
+            {
+              chunk_header(stream, COREDUMP_CHUNK_DATA, stream->len, crc);
+              lib_stream_puts(stream->next, data, stream->len);
+            }
+        }
+    }
+
+  stream->seq++;
+  stream->len = 0;
+}
+
+/****************************************************************************
+ * Name: chunkstream_puts
+ ****************************************************************************/
+
+static ssize_t chunkstream_puts(FAR struct lib_outstream_s *self,
+                                FAR const void *buf, size_t len)
+{
+  FAR struct coredump_chunkstream_s *stream =
+    (FAR struct coredump_chunkstream_s *)self;
+  FAR const uint8_t *src = buf;
+  size_t remain = len;
+  size_t nbytes;
+
+  while (remain > 0)
+    {
+      nbytes = CONFIG_SYSTEM_COREDUMP_CHUNKSIZE - stream->len;
+      if (nbytes > remain)
+        {
+          nbytes = remain;
+        }
+
+      memcpy(CHUNK_DATA(stream) + stream->len, src, nbytes);
+      stream->len += nbytes;
+      src         += nbytes;
+      remain      -= nbytes;
+
+      if (stream->len == CONFIG_SYSTEM_COREDUMP_CHUNKSIZE)
+        {
+          chunk_emit(stream);
+        }
+    }
+
+  self->nput += len;
+  return len;
+}
+
+/****************************************************************************
+ * Name: chunkstream_putc
+ ****************************************************************************/
+
+static void chunkstream_putc(FAR struct lib_outstream_s *self, int ch)
+{
+  uint8_t byte = ch;
+
+  chunkstream_puts(self, &byte, 1);
+}
+
+/****************************************************************************
+ * Name: chunkstream_flush
+ *
+ * Description:
+ *   A partial chunk is kept: the chunk boundaries have to stay at the same
+ *   offsets for the checksums to be comparable between images.
+ *
+ ****************************************************************************/
+
+static int chunkstream_flush(FAR struct lib_outstream_s *self)
+{
+  FAR struct coredump_chunkstream_s *stream =
+    (FAR struct coredump_chunkstream_s *)self;
+
+  return lib_stream_flush(stream->next);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: coredump_chunkstream
+ ****************************************************************************/
+
+void coredump_chunkstream(FAR struct coredump_chunkstream_s *stream,
+                          FAR struct lib_outstream_s *next, uint32_t start,
+                          FAR const char *crcfile)
+{
+  char path[PATH_MAX];
+
+  memset(&stream->common, 0, sizeof(stream->common));
+  stream->common.putc  = chunkstream_putc;
+  stream->common.puts  = chunkstream_puts;
+  stream->common.flush = chunkstream_flush;
+  stream->next         = next;
+  stream->seq          = 0;
+  stream->start        = start;
+  stream->len          = 0;
+  stream->oldcrc       = -1;
+  stream->newcrc       = -1;
+
+  if (crcfile != NULL)
+    {
+      snprintf(path, sizeof(path), "%s.new", crcfile);
+      stream->oldcrc = open(crcfile, O_RDONLY);
+      stream->newcrc = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    }
+}
+
+/****************************************************************************
+ * Name: coredump_chunkstream_finish
+ ****************************************************************************/
+
+uint32_t
+coredump_chunkstream_finish(FAR struct coredump_chunkstream_s *stream)
+{
+  if (stream->len > 0)
+    {
+      chunk_emit(stream);
+    }
+
+  chunk_header(stream, COREDUMP_CHUNK_END, 0, 0);
+  lib_stream_flush(stream->next);
+
+  if (stream->oldcrc >= 0)
+    {
+      close(stream->oldcrc);
+    }
+
+  if (stream->newcrc >= 0)
+    {
+      close(stream->newcrc);
+    }
+
+  return stream->seq;
+}
@@ -26,6 +26,8 @@
 
 #include <sys/types.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -59,6 +61,33 @@
 #  define CONFIG_SYSTEM_CRITMONITOR_MOUNTPOINT "/proc"
 #endif
 
+#ifdef CONFIG_SYSTEM_CRITMONITOR_HISTOGRAM
+
+#ifndef CONFIG_SYSTEM_CRITMONITOR_MAXTASKS
+#  define CONFIG_SYSTEM_CRITMONITOR_MAXTASKS 32
+#endif
+
+#ifdef CONFIG_SMP
+#  define CRITMON_NCPUS      CONFIG_SMP_NCPUS
+#else
+#  define CRITMON_NCPUS      1
+#endif
+
+/* Each power of two of nanoseconds is split into CRITMON_NSUB buckets, so
+ * a bucket is at most 1 / CRITMON_NSUB wider than its lower bound.
+ */
+
+#define CRITMON_SUBBITS      2
+#define CRITMON_NSUB         (1 << CRITMON_SUBBITS)
+#define CRITMON_NBUCKETS     (32 * CRITMON_NSUB)
+
+/* /proc/critmon has one line per CPU */
+
+#define CRITMON_BUFSIZE      (32 * CRITMON_NCPUS + 64)
+#define CRITMON_PATHSIZE     64
+
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -67,16 +96,55 @@ struct critmon_state_s
 {
   volatile bool started;
   volatile bool stop;
+#ifdef CONFIG_SYSTEM_CRITMONITOR_HISTOGRAM
+  volatile bool report;       /* Print all entries on the next sample */
+#endif
   pid_t pid;
   char line[80];
+#ifdef CONFIG_SYSTEM_CRITMONITOR_HISTOGRAM
+  char buf[CRITMON_BUFSIZE];
+#endif
 };
 
+#ifdef CONFIG_SYSTEM_CRITMONITOR_HISTOGRAM
+/* Distribution of the maximum times reported for each sample interval.
+ * procfs resets the maximum when it is read, so each sample is the worst
+ * case of one interval.
+ */
+
+struct critmon_hist_s
+{
+  uint32_t nsamples;
+  uint32_t max;                       /* In nanoseconds */
+  uint32_t bucket[CRITMON_NBUCKETS];
+};
+
+struct critmon_entry_s
+{
+  pid_t pid;                          /* 0: unused slot */
+  bool  seen;                         /* Found by the last scan */
+  bool  changed;                      /* Statistics changed since printed */
+  uint32_t shown[6];                  /* Statistics as last printed */
+#if CONFIG_TASK_NAME_SIZE > 0
+  char  name[CONFIG_TASK_NAME_SIZE + 1];
+#endif
+  struct critmon_hist_s preemp;
+  struct critmon_hist_s crit;
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
 static struct critmon_state_s g_critmon;
 
+#ifdef CONFIG_SYSTEM_CRITMONITOR_HISTOGRAM
+static struct critmon_entry_s g_critmon_cpus[CRITMON_NCPUS];
+static struct critmon_entry_s
+g_critmon_tasks[CONFIG_SYSTEM_CRITMONITOR_MAXTASKS];
+#endif
+
 #if CONFIG_TASK_NAME_SIZE > 0
 static const char g_name[] = "Name:";
 #endif
@@ -478,6 +546,409 @@ static int critmon_list_once(void)
   return exitcode;
 }
 
+#ifdef CONFIG_SYSTEM_CRITMONITOR_HISTOGRAM
+/****************************************************************************
+ * Name: critmon_bucket
+ ****************************************************************************/
+
+static int critmon_bucket(uint32_t ns)
+{
+  int msb;
+
+  if (ns < CRITMON_NSUB)
+    {
+      return ns;
+    }
+
+  for (msb = 31; (ns & (UINT32_C(1) << msb)) == 0; msb--);
+
+  return (msb - CRITMON_SUBBITS + 1) * CRITMON_NSUB +
+         ((ns >> (msb - CRITMON_SUBBITS)) & (CRITMON_NSUB - 1));
+}
+
+/****************************************************************************
+ * Name: critmon_bucket_limit
+ *
+ * Description:
+ *   Return the largest value that falls into a bucket.
+ *
+ ****************************************************************************/
+
+static uint32_t critmon_bucket_limit(int bucket)
+{
+  uint64_t limit;
+  int shift;
+
+  if (bucket < CRITMON_NSUB)
+    {
+      return bucket;
+    }
+
+  shift = bucket / CRITMON_NSUB - 1;
+  limit = ((uint64_t)(CRITMON_NSUB + bucket % CRITMON_NSUB + 1) << shift) - 1;
+  return limit > UINT32_MAX ? UINT32_MAX : limit;
+}
+
+/****************************************************************************
+ * Name: critmon_hist_add
+ ****************************************************************************/
+
+static void critmon_hist_add(FAR struct critmon_hist_s *hist, uint32_t ns)
+{
+  hist->bucket[critmon_bucket(ns)]++;
+  hist->nsamples++;
+  if (ns > hist->max)
+    {
+      hist->max = ns;
+    }
+}
+
+/****************************************************************************
+ * Name: critmon_hist_percentile
+ *
+ * Description:
+ *   Return an upper bound of the given per mille of the samples.
+ *
+ ****************************************************************************/
+
+static uint32_t
+critmon_hist_percentile(FAR const struct critmon_hist_s *hist,
+                        uint32_t permille)
+{
+  uint64_t target;
+  uint64_t count = 0;
+  uint32_t limit;
+  int i;
+
+  target = ((uint64_t)hist->nsamples * permille + 999) / 1000;
+  for (i = 0; i < CRITMON_NBUCKETS; i++)
+    {
+      count += hist->bucket[i];
+      if (count >= target && count > 0)
+        {
+          limit = critmon_bucket_limit(i);
+          return limit < hist->max ? limit : hist->max;
+        }
+    }
+
+  return hist->max;
+}
+
+/****************************************************************************
+ * Name: critmon_parse_time
+ *
+ * Description:
+ *   Convert one X.XXXXXXXXX field to nanoseconds and step over the comma
+ *   that follows it.
+ *
+ ****************************************************************************/
+
+static uint32_t critmon_parse_time(FAR char **ptr)
+{
+  FAR char *str = *ptr;
+  uint64_t ns;
+  int ndigits;
+
+  ns = strtoul(str, &str, 10) * UINT64_C(1000000000);
+  if (*str == '.')
+    {
+      uint32_t frac = 0;
+
+      for (str++, ndigits = 0; isdigit(*str); str++)
+        {
+          if (ndigits++ < 9)
+            {
+              frac = frac * 10 + (*str - '0');
+            }
+        }
+
+      for (; ndigits < 9; ndigits++)
+        {
+          frac *= 10;
+        }
+
+      ns += frac;
+    }
+
+  if (*str == ',')
+    {
+      str++;
+    }
+
+  *ptr = str;
+  return ns > UINT32_MAX ? UINT32_MAX : ns;
+}
+
+/****************************************************************************
+ * Name: critmon_read_file
+ *
+ * Description:
+ *   Read a small procfs file into g_critmon.buf without stdio or heap.
+ *
+ ****************************************************************************/
+
+static ssize_t critmon_read_file(FAR const char *path)
+{
+  ssize_t nread;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  nread = read(fd, g_critmon.buf, sizeof(g_critmon.buf) - 1);
+  if (nread < 0)
+    {
+      nread = -errno;
+    }
+  else
+    {
+      g_critmon.buf[nread] = '\0';
+    }
+
+  close(fd);
+  return nread;
+}
+
+/****************************************************************************
+ * Name: critmon_hist_task
+ ****************************************************************************/
+
+static void critmon_hist_task(FAR const char *dirname)
+{
+  FAR struct critmon_entry_s *entry = NULL;
+  FAR struct critmon_entry_s *avail = NULL;
+  char path[CRITMON_PATHSIZE];
+  FAR char *ptr;
+  pid_t pid = atoi(dirname);
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_CRITMONITOR_MAXTASKS; i++)
+    {
+      if (g_critmon_tasks[i].pid == pid)
+        {
+          entry = &g_critmon_tasks[i];
+          break;
+        }
+
+      if (avail == NULL && g_critmon_tasks[i].pid == 0)
+        {
+          avail = &g_critmon_tasks[i];
+        }
+    }
+
+  if (entry == NULL)
+    {
+      if (avail == NULL)
+        {
+          return;
+        }
+
+      /* A new task: the name is read only once */
+
+      entry = avail;
+      memset(entry, 0, sizeof(*entry));
+      entry->pid = pid;
+
+#if CONFIG_TASK_NAME_SIZE > 0
+      snprintf(path, sizeof(path),
+               CONFIG_SYSTEM_CRITMONITOR_MOUNTPOINT "/%s/status", dirname);
+      if (critmon_read_file(path) > 0)
+        {
+          ptr = strstr(g_critmon.buf, g_name);
+          if (ptr != NULL)
+            {
+              ptr = critmon_isolate_value(ptr + strlen(g_name));
+              strlcpy(entry->name, ptr, sizeof(entry->name));
+            }
+        }
+#endif
+    }
+
+  entry->seen = true;
+
+  /* Format: X.XXXXXXXXX,X.XXXXXXXXX,X.XXXXXXXXX,X.XXXXXXXXX */
+
+  snprintf(path, sizeof(path),
+           CONFIG_SYSTEM_CRITMONITOR_MOUNTPOINT "/%s/critmon", dirname);
+  if (critmon_read_file(path) > 0)
+    {
+      ptr = g_critmon.buf;
+      critmon_hist_add(&entry->preemp, critmon_parse_time(&ptr));
+      critmon_hist_add(&entry->crit, critmon_parse_time(&ptr));
+    }
+}
+
+/****************************************************************************
+ * Name: critmon_hist_sample
+ *
+ * Description:
+ *   Add the maximum times of the last interval to the histograms of each
+ *   CPU and task.
+ *
+ ****************************************************************************/
+
+static int critmon_hist_sample(void)
+{
+  FAR struct dirent *entryp;
+  FAR char *ptr;
+  DIR *dirp;
+  int cpu;
+  int i;
+
+  /* Format: X,X.XXXXXXXXX,X.XXXXXXXXX for each CPU */
+
+  if (critmon_read_file(CONFIG_SYSTEM_CRITMONITOR_MOUNTPOINT "/critmon") > 0)
+    {
+      ptr = g_critmon.buf;
+      while (*ptr != '\0')
+        {
+          cpu = strtoul(ptr, &ptr, 10);
+          if (*ptr++ != ',' || cpu >= CRITMON_NCPUS)
+            {
+              break;
+            }
+
+          g_critmon_cpus[cpu].pid = cpu;
+          critmon_hist_add(&g_critmon_cpus[cpu].preemp,
+                           critmon_parse_time(&ptr));
+          critmon_hist_add(&g_critmon_cpus[cpu].crit,
+                           critmon_parse_time(&ptr));
+
+          ptr += strcspn(ptr, "\n");
+          if (*ptr == '\n')
+            {
+              ptr++;
+            }
+        }
+    }
+
+  dirp = opendir(CONFIG_SYSTEM_CRITMONITOR_MOUNTPOINT);
+  if (dirp == NULL)
+    {
+      fprintf(stderr, "Csection Monitor: Failed to open directory: %s\n",
+              CONFIG_SYSTEM_CRITMONITOR_MOUNTPOINT);
+      return EXIT_FAILURE;
+    }
+
+  for (i = 0; i < CONFIG_SYSTEM_CRITMONITOR_MAXTASKS; i++)
+    {
+      g_critmon_tasks[i].seen = false;
+    }
+
+  while ((entryp = readdir(dirp)) != NULL)
+    {
+      if (DIRENT_ISDIRECTORY(entryp->d_type) &&
+          critmon_check_name(entryp->d_name))
+        {
+          critmon_hist_task(entryp->d_name);
+        }
+    }
+
+  closedir(dirp);
+
+  /* Forget the tasks that have exited */
+
+  for (i = 0; i < CONFIG_SYSTEM_CRITMONITOR_MAXTASKS; i++)
+    {
+      if (!g_critmon_tasks[i].seen)
+        {
+          g_critmon_tasks[i].pid = 0;
+        }
+    }
+
+  return EXIT_SUCCESS;
+}
+
+/****************************************************************************
+ * Name: critmon_hist_show
+ *
+ * Description:
+ *   Print the statistics of an entry if they changed since they were last
+ *   printed, or if all is true.
+ *
+ ****************************************************************************/
+
+static void critmon_hist_show(FAR struct critmon_entry_s *entry,
+                              FAR const char *id, FAR const char *name,
+                              bool all)
+{
+  uint32_t stats[6];
+  int i;
+
+  stats[0] = entry->preemp.max;
+  stats[1] = critmon_hist_percentile(&entry->preemp, 990);
+  stats[2] = critmon_hist_percentile(&entry->preemp, 999);
+  stats[3] = entry->crit.max;
+  stats[4] = critmon_hist_percentile(&entry->crit, 990);
+  stats[5] = critmon_hist_percentile(&entry->crit, 999);
+
+  if (!all && memcmp(stats, entry->shown, sizeof(stats)) == 0)
+    {
+      return;
+    }
+
+  memcpy(entry->shown, stats, sizeof(stats));
+
+  for (i = 0; i < 6; i++)
+    {
+      printf("%2" PRIu32 ".%09" PRIu32 " ",
+             stats[i] / 1000000000, stats[i] % 1000000000);
+    }
+
+  printf("%8" PRIu32 " %-5s %s\n", entry->preemp.nsamples, id, name);
+}
+
+/****************************************************************************
+ * Name: critmon_hist_report
+ ****************************************************************************/
+
+static void critmon_hist_report(bool all)
+{
+  FAR struct critmon_entry_s *entry;
+  FAR const char *name = "";
+  char id[12];
+  int i;
+
+  if (all)
+    {
+      printf("PREEMP MAX   PREEMP P99   PREEMP P999  "
+             "CSECT MAX    CSECT P99    CSECT P999   "
+             "SAMPLES PID   DESCRIPTION\n");
+    }
+
+  for (i = 0; i < CRITMON_NCPUS; i++)
+    {
+      entry = &g_critmon_cpus[i];
+      if (entry->preemp.nsamples > 0)
+        {
+          snprintf(id, sizeof(id), "CPU%d", i);
+          critmon_hist_show(entry, id, "", all);
+        }
+    }
+
+  for (i = 0; i < CONFIG_SYSTEM_CRITMONITOR_MAXTASKS; i++)
+    {
+      entry = &g_critmon_tasks[i];
+      if (entry->pid != 0 && entry->preemp.nsamples > 0)
+        {
+#if CONFIG_TASK_NAME_SIZE > 0
+          name = entry->name;
+#endif
+          snprintf(id, sizeof(id), "%d", (int)entry->pid);
+          critmon_hist_show(entry, id, name, all);
+        }
+    }
+
+  if (all)
+    {
+      fputc('\n', stdout);
+    }
+}
+#endif /* CONFIG_SYSTEM_CRITMONITOR_HISTOGRAM */
+
 /****************************************************************************
  * Name: critmon_daemon
  ****************************************************************************/
@@ -490,9 +961,26 @@ static int critmon_daemon(int argc, char **argv)
 
   /* Loop until we detect that there is a request to stop. */
 
+#ifdef CONFIG_SYSTEM_CRITMONITOR_HISTOGRAM
+  memset(g_critmon_cpus, 0, sizeof(g_critmon_cpus));
+  memset(g_critmon_tasks, 0, sizeof(g_critmon_tasks));
+  g_critmon.report = true;
+#endif
+
   while (!g_critmon.stop)
     {
+#ifdef CONFIG_SYSTEM_CRITMONITOR_HISTOGRAM
+      /* Only the entries whose statistics changed are printed */
+
+      exitcode = critmon_hist_sample();
+      if (exitcode == EXIT_SUCCESS)
+        {
+          critmon_hist_report(g_critmon.report);
+          g_critmon.report = false;
+        }
+#else
       exitcode = critmon_list_once();
+#endif
       if (exitcode != EXIT_SUCCESS)
         {
           break;
@@ -579,6 +1067,17 @@ int critmon_stop_main(int argc, char **argv)
 
 int critmon_main(int argc, char **argv)
 {
+#ifdef CONFIG_SYSTEM_CRITMONITOR_HISTOGRAM
+  /* Reading procfs would reset the maxima the daemon collects */
+
+  if (g_critmon.started)
+    {
+      printf("Csection Monitor: Full report on the next sample\n");
+      g_critmon.report = true;
+      return 0;
+    }
+#endif
+
   return critmon_list_once();
 }
 
@@ -33,6 +33,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <malloc.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <string.h>
@@ -40,6 +41,10 @@
 #include <errno.h>
 #include <time.h>
 
+#ifdef CONFIG_SYSTEM_DD_ASYNC
+#  include <pthread.h>
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -59,6 +64,25 @@
  * Private Types
  ****************************************************************************/
 
+#ifdef CONFIG_SYSTEM_DD_ASYNC
+/* Buffers passed from the reader thread to the writer.  head and tail
+ * count the buffers filled and written; head - tail buffers are in flight.
+ */
+
+struct dd_ring_s
+{
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+  uint32_t        head;    /* Number of buffers filled by the reader */
+  uint32_t        tail;    /* Number of buffers written by the writer */
+  bool            done;    /* true: The reader has stopped */
+  bool            abort;   /* true: The writer has failed */
+  int             result;  /* Result of the reader */
+  size_t          nbytes[CONFIG_SYSTEM_DD_NBUFFERS];
+  FAR uint8_t    *buffer[CONFIG_SYSTEM_DD_NBUFFERS];
+};
+#endif
+
 struct dd_s
 {
   int          infd;       /* File descriptor of the input device */
@@ -66,9 +90,17 @@ struct dd_s
   uint32_t     nsectors;   /* Number of sectors to transfer */
   uint32_t     skip;       /* The number of sectors skipped on input */
   bool         eof;        /* true: The end of the input or output file has been hit */
-  uint16_t     sectsize;   /* Size of one sector */
-  uint16_t     nbytes;     /* Number of valid bytes in the buffer */
+  bool         progress;   /* true: Report the progress once per second */
+  int          iflags;     /* Additional open flags of the input file */
+  int          oflags;     /* Additional open flags of the output file */
+  size_t       sectsize;   /* Size of one sector */
+  size_t       nbytes;     /* Number of valid bytes in the buffer */
   FAR uint8_t *buffer;     /* Buffer of data to write to the output file */
+  uint64_t     start;      /* Start of the transfer (usec) */
+  uint64_t     report;     /* Time of the last progress report (usec) */
+#ifdef CONFIG_SYSTEM_DD_ASYNC
+  struct dd_ring_s ring;   /* Buffers in flight */
+#endif
 };
 
 /****************************************************************************
@@ -79,10 +111,10 @@ struct dd_s
  * Name: dd_write
  ****************************************************************************/
 
-static int dd_write(FAR struct dd_s *dd)
+static int dd_write(FAR struct dd_s *dd, FAR const uint8_t *buffer,
+                    size_t len)
 {
-  FAR uint8_t *buffer = dd->buffer;
-  uint16_t written;
+  size_t written;
   ssize_t nbytes;
 
   /* Is the out buffer full (or is this the last one)? */
@@ -90,7 +122,7 @@ static int dd_write(FAR struct dd_s *dd)
   written = 0;
   do
     {
-      nbytes = write(dd->outfd, buffer, dd->nbytes - written);
+      nbytes = write(dd->outfd, buffer, len - written);
       if (nbytes < 0)
         {
           fprintf(stderr, "%s: failed to write: %s\n",
@@ -101,7 +133,7 @@ static int dd_write(FAR struct dd_s *dd)
       written += nbytes;
       buffer  += nbytes;
     }
-  while (written < dd->nbytes);
+  while (written < len);
 
   return OK;
 }
@@ -134,13 +166,316 @@ static int dd_read(FAR struct dd_s *dd)
   return OK;
 }
 
+/****************************************************************************
+ * Name: dd_now
+ ****************************************************************************/
+
+static uint64_t dd_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+/****************************************************************************
+ * Name: dd_progress
+ *
+ * Description:
+ *   Print the number of bytes copied so far and the average throughput,
+ *   at most once per second unless final is true.
+ *
+ ****************************************************************************/
+
+static void dd_progress(FAR struct dd_s *dd, uint32_t sector, bool final)
+{
+  uint64_t now = dd_now();
+  uint64_t elapsed;
+  uint64_t total;
+
+  if (!final && now - dd->report < USEC_PER_SEC)
+    {
+      return;
+    }
+
+  dd->report = now;
+  elapsed    = now - dd->start;
+  total      = (uint64_t)sector * dd->sectsize;
+
+  fprintf(stderr, "\r%llu bytes, %u KB/s%s",
+          (unsigned long long)total,
+          elapsed > 0 ? (unsigned int)(total * USEC_PER_SEC /
+                                       1024 / elapsed) : 0,
+          final ? "\n" : "");
+}
+
+/****************************************************************************
+ * Name: dd_parseflags
+ *
+ * Description:
+ *   Convert a comma separated iflag=/oflag= list to open() flags.
+ *
+ ****************************************************************************/
+
+static int dd_parseflags(FAR const char *arg, FAR int *flags)
+{
+  size_t len;
+
+  while (*arg != '\0')
+    {
+      len = strcspn(arg, ",");
+      if (len == 6 && strncmp(arg, "direct", 6) == 0)
+        {
+          *flags |= O_DIRECT;
+        }
+      else
+        {
+          fprintf(stderr, "%s: invalid flag '%.*s'\n",
+            g_dd, (int)len, arg);
+          return ERROR;
+        }
+
+      arg += len;
+      if (*arg == ',')
+        {
+          arg++;
+        }
+    }
+
+  return OK;
+}
+
+#ifdef CONFIG_SYSTEM_DD_ASYNC
+/****************************************************************************
+ * Name: dd_reader
+ *
+ * Description:
+ *   Reader thread: fill the free buffers of the ring until the end of the
+ *   input, count= or an error.  dd->buffer, dd->nbytes and dd->eof belong
+ *   to this thread while it runs.
+ *
+ ****************************************************************************/
+
+static FAR void *dd_reader(FAR void *arg)
+{
+  FAR struct dd_s *dd = arg;
+  FAR struct dd_ring_s *ring = &dd->ring;
+  uint32_t sector = 0;
+  bool aborted;
+  int slot;
+  int ret = OK;
+
+  while (sector < dd->nsectors)
+    {
+      pthread_mutex_lock(&ring->lock);
+      while (ring->head - ring->tail >= CONFIG_SYSTEM_DD_NBUFFERS &&
+             !ring->abort)
+        {
+          pthread_cond_wait(&ring->cond, &ring->lock);
+        }
+
+      aborted = ring->abort;
+      pthread_mutex_unlock(&ring->lock);
+
+      if (aborted)
+        {
+          break;
+        }
+
+      /* Only this thread changes head */
+
+      slot       = ring->head % CONFIG_SYSTEM_DD_NBUFFERS;
+      dd->buffer = ring->buffer[slot];
+
+      ret = dd_read(dd);
+      if (ret < 0 || dd->eof)
+        {
+          break;
+        }
+
+      pthread_mutex_lock(&ring->lock);
+      ring->nbytes[slot] = dd->nbytes;
+      ring->head++;
+      pthread_cond_broadcast(&ring->cond);
+      pthread_mutex_unlock(&ring->lock);
+
+      sector++;
+    }
+
+  pthread_mutex_lock(&ring->lock);
+  ring->done   = true;
+  ring->result = ret;
+  pthread_cond_broadcast(&ring->cond);
+  pthread_mutex_unlock(&ring->lock);
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: dd_transfer
+ *
+ * Description:
+ *   Write the buffers filled by dd_reader() while it reads the next ones.
+ *
+ ****************************************************************************/
+
+static int dd_transfer(FAR struct dd_s *dd, FAR uint32_t *psector)
+{
+  FAR struct dd_ring_s *ring = &dd->ring;
+  pthread_attr_t attr;
+  pthread_t reader;
+  size_t nbytes;
+  int slot;
+  int ret = OK;
+  int i;
+
+  /* The caller's buffer is the first one of the ring */
+
+  ring->buffer[0] = dd->buffer;
+  for (i = 1; i < CONFIG_SYSTEM_DD_NBUFFERS; i++)
+    {
+      ring->buffer[i] = memalign(CONFIG_SYSTEM_DD_BUFALIGN, dd->sectsize);
+      if (ring->buffer[i] == NULL)
+        {
+          fprintf(stderr, "%s: failed to malloc: %s\n",
+            g_dd, strerror(errno));
+          ret = ERROR;
+          goto errout_with_buffers;
+        }
+    }
+
+  pthread_mutex_init(&ring->lock, NULL);
+  pthread_cond_init(&ring->cond, NULL);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_SYSTEM_DD_READER_STACKSIZE);
+  ret = pthread_create(&reader, &attr, dd_reader, dd);
+  pthread_attr_destroy(&attr);
+
+  if (ret != 0)
+    {
+      fprintf(stderr, "%s: failed to create reader: %s\n",
+        g_dd, strerror(ret));
+      ret = ERROR;
+      goto errout_with_lock;
+    }
+
+  for (; ; )
+    {
+      pthread_mutex_lock(&ring->lock);
+      while (ring->tail == ring->head && !ring->done)
+        {
+          pthread_cond_wait(&ring->cond, &ring->lock);
+        }
+
+      if (ring->tail == ring->head)
+        {
+          pthread_mutex_unlock(&ring->lock);
+          break;
+        }
+
+      slot   = ring->tail % CONFIG_SYSTEM_DD_NBUFFERS;
+      nbytes = ring->nbytes[slot];
+      pthread_mutex_unlock(&ring->lock);
+
+      ret = dd_write(dd, ring->buffer[slot], nbytes);
+
+      pthread_mutex_lock(&ring->lock);
+      if (ret < 0)
+        {
+          ring->abort = true;
+        }
+      else
+        {
+          ring->tail++;
+        }
+
+      pthread_cond_broadcast(&ring->cond);
+      pthread_mutex_unlock(&ring->lock);
+
+      if (ret < 0)
+        {
+          break;
+        }
+
+      (*psector)++;
+      if (dd->progress)
+        {
+          dd_progress(dd, *psector, false);
+        }
+    }
+
+  pthread_join(reader, NULL);
+  if (ret == OK)
+    {
+      ret = ring->result;
+    }
+
+errout_with_lock:
+  pthread_cond_destroy(&ring->cond);
+  pthread_mutex_destroy(&ring->lock);
+
+errout_with_buffers:
+  dd->buffer = ring->buffer[0];
+  for (i = 1; i < CONFIG_SYSTEM_DD_NBUFFERS; i++)
+    {
+      free(ring->buffer[i]);
+    }
+
+  return ret;
+}
+#else
+/****************************************************************************
+ * Name: dd_transfer
+ ****************************************************************************/
+
+static int dd_transfer(FAR struct dd_s *dd, FAR uint32_t *psector)
+{
+  int ret;
+
+  while (!dd->eof && *psector < dd->nsectors)
+    {
+      /* Read one sector from from the input */
+
+      ret = dd_read(dd);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      /* Has the incoming data stream ended? */
+
+      if (!dd->eof)
+        {
+          /* Write one sector to the output file */
+
+          ret = dd_write(dd, dd->buffer, dd->nbytes);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          /* Increment the sector number */
+
+          (*psector)++;
+          if (dd->progress)
+            {
+              dd_progress(dd, *psector, false);
+            }
+        }
+    }
+
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: dd_infopen
  ****************************************************************************/
 
 static inline int dd_infopen(FAR const char *name, FAR struct dd_s *dd)
 {
-  dd->infd = open(name, O_RDONLY);
+  dd->infd = open(name, O_RDONLY | dd->iflags);
   if (dd->infd < 0)
     {
       fprintf(stderr, "%s: failed to open '%s': %s\n",
@@ -157,7 +492,7 @@ static inline int dd_infopen(FAR const char *name, FAR struct dd_s *dd)
 
 static inline int dd_outfopen(FAR const char *name, FAR struct dd_s *dd)
 {
-  dd->outfd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  dd->outfd = open(name, O_WRONLY | O_CREAT | O_TRUNC | dd->oflags, 0644);
   if (dd->outfd < 0)
     {
       fprintf(stderr, "%s: failed to open '%s': %s\n",
@@ -176,7 +511,8 @@ static void print_usage(void)
 {
   fprintf(stderr, "usage:\n");
   fprintf(stderr, "  %s if=<infile> of=<outfile> [bs=<sectsize>] "
-    "[count=<sectors>] [skip=<sectors>]\n", g_dd);
+    "[count=<sectors>] [skip=<sectors>] [iflag=direct] [oflag=direct] "
+    "[status=progress]\n", g_dd);
 }
 
 /****************************************************************************
@@ -226,6 +562,24 @@ int main(int argc, FAR char **argv)
         {
           dd.skip = atoi(&argv[i][5]);
         }
+      else if (strncmp(argv[i], "iflag=", 6) == 0)
+        {
+          if (dd_parseflags(&argv[i][6], &dd.iflags) < 0)
+            {
+              goto errout_with_paths;
+            }
+        }
+      else if (strncmp(argv[i], "oflag=", 6) == 0)
+        {
+          if (dd_parseflags(&argv[i][6], &dd.oflags) < 0)
+            {
+              goto errout_with_paths;
+            }
+        }
+      else if (strcmp(argv[i], "status=progress") == 0)
+        {
+          dd.progress = true;
+        }
     }
 
   if (infile == NULL || outfile == NULL)
@@ -236,7 +590,7 @@ int main(int argc, FAR char **argv)
 
   /* Allocate the I/O buffer */
 
-  dd.buffer = malloc(dd.sectsize);
+  dd.buffer = memalign(CONFIG_SYSTEM_DD_BUFALIGN, dd.sectsize);
   if (!dd.buffer)
     {
       fprintf(stderr, "%s: failed to malloc: %s\n", g_dd, strerror(errno));
@@ -274,36 +628,19 @@ int main(int argc, FAR char **argv)
   /* Then perform the data transfer */
 
   clock_gettime(CLOCK_MONOTONIC, &ts0);
+  dd.start  = dd_now();
+  dd.report = dd.start;
 
-  while (!dd.eof && sector < dd.nsectors)
+  ret = dd_transfer(&dd, &sector);
+  if (ret < 0)
     {
-      /* Read one sector from from the input */
-
-      ret = dd_read(&dd);
-      if (ret < 0)
-        {
-          goto errout_with_outf;
-        }
-
-      /* Has the incoming data stream ended? */
-
-      if (!dd.eof)
-        {
-          /* Write one sector to the output file */
-
-          ret = dd_write(&dd);
-          if (ret < 0)
-            {
-              goto errout_with_outf;
-            }
-
-          /* Increment the sector number */
-
-          sector++;
-        }
+      goto errout_with_outf;
     }
 
-  ret = OK;
+  if (dd.progress)
+    {
+      dd_progress(&dd, sector, true);
+    }
 
   clock_gettime(CLOCK_MONOTONIC, &ts1);
 
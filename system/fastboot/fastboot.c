@@ -27,11 +27,14 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include <sys/boardctl.h>
 #include <sys/ioctl.h>
@@ -100,16 +103,62 @@ struct fastboot_chunk_header_s
   uint32_t total_sz;        /* in bytes of chunk input file including chunk header and data */
 };
 
+/* Image parser, fed with the downloaded data in pieces of any size */
+
+enum fastboot_sparse_state_e
+{
+  FASTBOOT_STATE_MAGIC = 0,     /* Collecting the first word */
+  FASTBOOT_STATE_HEADER,        /* Collecting the sparse header */
+  FASTBOOT_STATE_CHUNK,         /* Collecting a chunk header */
+  FASTBOOT_STATE_FILL,          /* Collecting the fill word */
+  FASTBOOT_STATE_RAW,           /* Writing the data of a raw chunk */
+  FASTBOOT_STATE_SKIP,          /* Skipping unused chunk data */
+  FASTBOOT_STATE_IMAGE,         /* Writing a non sparse image */
+  FASTBOOT_STATE_DONE           /* All chunks processed */
+};
+
+struct fastboot_sparse_s
+{
+  int fd;
+  int state;
+  off_t offset;                 /* Write position in the partition */
+  size_t remain;                /* Bytes left in a raw or skipped chunk */
+  size_t hdrlen;                /* Bytes collected in hdr */
+  uint32_t chunks;              /* Chunks left */
+  struct fastboot_sparse_header_s header;
+  struct fastboot_chunk_header_s chunk;
+  uint8_t hdr[FASTBOOT_SPARSE_HEADER];
+};
+
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+/* The download buffer split in two, one half is received from USB while
+ * the writer thread flashes the other one.
+ */
+
+struct fastboot_stream_s
+{
+  struct fastboot_sparse_s sparse;
+  pthread_t writer;
+  sem_t empty;
+  sem_t full;
+  FAR uint8_t *buffer[2];
+  size_t len[2];                /* Zero ends the writer */
+  int ret;                      /* First flash error */
+};
+#endif
+
 struct fastboot_ctx_s
 {
   int usbdev_in;
   int usbdev_out;
   size_t download_max;
   size_t download_size;
-  size_t download_offset;
-  size_t total_imgsize;
   FAR void *download_buffer;
   FAR struct fastboot_var_s *varlist;
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+  FAR char *stream_name;        /* Partition to stream to or NULL */
+  bool streamed;                /* Last download is already flashed */
+#endif
 };
 
 struct fastboot_cmd_s
@@ -135,6 +184,10 @@ static void fastboot_reboot(FAR struct fastboot_ctx_s *context,
                             FAR const char *arg);
 static void fastboot_reboot_bootloader(FAR struct fastboot_ctx_s *context,
                                        FAR const char *arg);
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+static void fastboot_oem_stream(FAR struct fastboot_ctx_s *context,
+                                FAR const char *arg);
+#endif
 
 /****************************************************************************
  * Private Data
@@ -146,6 +199,9 @@ static const struct fastboot_cmd_s g_fast_cmd[] =
   { "download:",          fastboot_download         },
   { "erase:",             fastboot_erase            },
   { "flash:",             fastboot_flash            },
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+  { "oem stream",         fastboot_oem_stream       },
+#endif
   { "reboot-bootloader",  fastboot_reboot_bootloader},
   { "reboot",             fastboot_reboot           }
 };
@@ -172,6 +228,25 @@ static ssize_t fastboot_read(int fd, FAR void *buf, size_t len)
   return r < 0 ? -errno : r;
 }
 
+static int fastboot_receive(int fd, FAR void *buf, size_t len)
+{
+  FAR char *data = buf;
+
+  while (len > 0)
+    {
+      ssize_t r = fastboot_read(fd, data, len);
+      if (r < 0)
+        {
+          return r;
+        }
+
+      data += r;
+      len -= r;
+    }
+
+  return OK;
+}
+
 static int fastboot_write(int fd, FAR void *buf, size_t len)
 {
   FAR char *data = buf;
@@ -299,95 +374,372 @@ static int fastboot_flash_erase(int fd)
   return OK;
 }
 
-static int
-fastboot_flash_program(FAR struct fastboot_ctx_s *context, int fd)
+static void fastboot_sparse_init(FAR struct fastboot_sparse_s *sparse,
+                                 int fd)
 {
-  FAR char *chunk_ptr = context->download_buffer;
-  FAR struct fastboot_sparse_header_s *sparse;
-  uint32_t chunk_num;
-  int ret = OK;
+  memset(sparse, 0, sizeof(*sparse));
+  sparse->fd = fd;
+  sparse->state = FASTBOOT_STATE_MAGIC;
+}
 
-  /* No sparse header, write flash directly */
+static void fastboot_sparse_next(FAR struct fastboot_sparse_s *sparse)
+{
+  sparse->hdrlen = 0;
+  sparse->state = sparse->chunks > 0 ? FASTBOOT_STATE_CHUNK :
+                                       FASTBOOT_STATE_DONE;
+}
 
-  sparse = (FAR struct fastboot_sparse_header_s *)chunk_ptr;
-  if (sparse->magic != FASTBOOT_SPARSE_MAGIC)
+static void fastboot_sparse_skip(FAR struct fastboot_sparse_s *sparse,
+                                 size_t size)
+{
+  if (size > 0)
     {
-      return fastboot_flash_write(fd, 0, context->download_buffer,
-                                  context->download_size);
+      sparse->remain = size;
+      sparse->state = FASTBOOT_STATE_SKIP;
     }
-
-  if (context->total_imgsize == 0)
+  else
     {
-      context->total_imgsize = sparse->blk_sz * sparse->total_blks;
+      fastboot_sparse_next(sparse);
     }
+}
 
-  chunk_num = sparse->total_chunks;
+/* Handle a completely collected header or fill word */
 
-  chunk_ptr += FASTBOOT_SPARSE_HEADER;
+static int fastboot_sparse_parse(FAR struct fastboot_sparse_s *sparse)
+{
+  FAR struct fastboot_sparse_header_s *header = &sparse->header;
+  FAR struct fastboot_chunk_header_s *chunk = &sparse->chunk;
+  off_t chunk_size;
+  int ret;
 
-  while (chunk_num--)
+  switch (sparse->state)
     {
-      FAR struct fastboot_chunk_header_s *chunk =
-        (FAR struct fastboot_chunk_header_s *)chunk_ptr;
-
-      chunk_ptr += FASTBOOT_CHUNK_HEADER;
-
-      switch (chunk->chunk_type)
-        {
-          case FASTBOOT_CHUNK_RAW:
-            {
-              uint32_t chunk_size = chunk->chunk_sz * sparse->blk_sz;
-              ret = fastboot_flash_write(fd, context->download_offset,
-                                         chunk_ptr, chunk_size);
-              if (ret < 0)
+      case FASTBOOT_STATE_MAGIC:
+
+        /* No sparse header, write flash directly */
+
+        if (FASTBOOT_GETUINT32(sparse->hdr) != FASTBOOT_SPARSE_MAGIC)
+          {
+            sparse->state = FASTBOOT_STATE_IMAGE;
+            sparse->offset = sparse->hdrlen;
+            return fastboot_flash_write(sparse->fd, 0, sparse->hdr,
+                                        sparse->hdrlen);
+          }
+
+        sparse->state = FASTBOOT_STATE_HEADER;
+        return OK;
+
+      case FASTBOOT_STATE_HEADER:
+        memcpy(header, sparse->hdr, FASTBOOT_SPARSE_HEADER);
+        if (header->major_version != 1 ||
+            header->file_hdr_sz < FASTBOOT_SPARSE_HEADER ||
+            header->chunk_hdr_sz != FASTBOOT_CHUNK_HEADER ||
+            header->blk_sz == 0 || header->blk_sz % 4 != 0)
+          {
+            printf("Unsupported sparse header\n");
+            return -EINVAL;
+          }
+
+        sparse->chunks = header->total_chunks;
+        fastboot_sparse_skip(sparse,
+                             header->file_hdr_sz - FASTBOOT_SPARSE_HEADER);
+        return OK;
+
+      case FASTBOOT_STATE_CHUNK:
+        memcpy(chunk, sparse->hdr, FASTBOOT_CHUNK_HEADER);
+        chunk_size = (off_t)chunk->chunk_sz * header->blk_sz;
+        sparse->chunks--;
+        sparse->hdrlen = 0;
+
+        switch (chunk->chunk_type)
+          {
+            case FASTBOOT_CHUNK_RAW:
+              sparse->remain = chunk_size;
+              sparse->state = FASTBOOT_STATE_RAW;
+              if (chunk_size == 0)
                 {
-                  return ret;
+                  fastboot_sparse_next(sparse);
                 }
+              break;
 
-              context->download_offset += chunk_size;
-              chunk_ptr += chunk_size;
-            }
-            break;
-          case FASTBOOT_CHUNK_FILL:
-            {
-              uint32_t fill_data = FASTBOOT_GETUINT32(chunk_ptr);
-              uint32_t chunk_size = chunk->chunk_sz * sparse->blk_sz;
-              ret = ffastboot_flash_fill(fd, context->download_offset,
-                                         fill_data, sparse->blk_sz,
-                                         chunk->chunk_sz);
-              if (ret < 0)
+            case FASTBOOT_CHUNK_FILL:
+              sparse->state = FASTBOOT_STATE_FILL;
+              break;
+
+            /* Blocks not covered by the image, split images start with
+             * one skipping what the previous parts wrote.
+             */
+
+            case FASTBOOT_CHUNK_DONT_CARE:
+              sparse->offset += chunk_size;
+              fastboot_sparse_next(sparse);
+              break;
+
+            default:
+              printf("Error chunk type:%d, skip\n", chunk->chunk_type);
+
+              /* Fall through */
+
+            case FASTBOOT_CHUNK_CRC32:
+              if (chunk->total_sz < FASTBOOT_CHUNK_HEADER)
                 {
-                  return ret;
+                  return -EINVAL;
                 }
 
-              context->download_offset += chunk_size;
-              chunk_ptr += 4;
-            }
+              fastboot_sparse_skip(sparse,
+                                   chunk->total_sz - FASTBOOT_CHUNK_HEADER);
+              break;
+          }
+
+        return OK;
+
+      case FASTBOOT_STATE_FILL:
+        ret = ffastboot_flash_fill(sparse->fd, sparse->offset,
+                                   FASTBOOT_GETUINT32(sparse->hdr),
+                                   header->blk_sz, chunk->chunk_sz);
+        sparse->offset += (off_t)chunk->chunk_sz * header->blk_sz;
+        fastboot_sparse_next(sparse);
+        return ret;
+
+      default:
+        return -EINVAL;
+    }
+}
+
+/* Write the next piece of the image, which may end anywhere */
+
+static int fastboot_sparse_write(FAR struct fastboot_sparse_s *sparse,
+                                 FAR const uint8_t *data, size_t len)
+{
+  size_t need;
+  size_t n;
+  int ret;
+
+  while (len > 0)
+    {
+      switch (sparse->state)
+        {
+          case FASTBOOT_STATE_RAW:
+          case FASTBOOT_STATE_IMAGE:
+            n = len;
+            if (sparse->state == FASTBOOT_STATE_RAW)
+              {
+                n = MIN(len, sparse->remain);
+              }
+
+            ret = fastboot_flash_write(sparse->fd, sparse->offset,
+                                       (FAR void *)data, n);
+            if (ret < 0)
+              {
+                return ret;
+              }
+
+            sparse->offset += n;
+            if (sparse->state == FASTBOOT_STATE_RAW &&
+                (sparse->remain -= n) == 0)
+              {
+                fastboot_sparse_next(sparse);
+              }
             break;
-          case FASTBOOT_CHUNK_DONT_CARE:
-          case FASTBOOT_CHUNK_CRC32:
+
+          case FASTBOOT_STATE_SKIP:
+            n = MIN(len, sparse->remain);
+            sparse->remain -= n;
+            if (sparse->remain == 0)
+              {
+                fastboot_sparse_next(sparse);
+              }
             break;
+
+          case FASTBOOT_STATE_DONE:
+            return OK;
+
           default:
-            printf("Error chunk type:%d, skip\n", chunk->chunk_type);
+            need = sparse->state == FASTBOOT_STATE_HEADER ?
+                   FASTBOOT_SPARSE_HEADER :
+                   sparse->state == FASTBOOT_STATE_CHUNK ?
+                   FASTBOOT_CHUNK_HEADER : 4;
+            n = MIN(len, need - sparse->hdrlen);
+            memcpy(sparse->hdr + sparse->hdrlen, data, n);
+            sparse->hdrlen += n;
+            if (sparse->hdrlen == need)
+              {
+                ret = fastboot_sparse_parse(sparse);
+                if (ret < 0)
+                  {
+                    return ret;
+                  }
+              }
             break;
         }
+
+      data += n;
+      len -= n;
+    }
+
+  return OK;
+}
+
+static int fastboot_sparse_finish(FAR struct fastboot_sparse_s *sparse)
+{
+  switch (sparse->state)
+    {
+      case FASTBOOT_STATE_MAGIC:
+        return fastboot_flash_write(sparse->fd, 0, sparse->hdr,
+                                    sparse->hdrlen);
+
+      case FASTBOOT_STATE_IMAGE:
+      case FASTBOOT_STATE_DONE:
+        return OK;
+
+      default:
+        printf("Truncated sparse image\n");
+        return -EINVAL;
     }
+}
+
+static int
+fastboot_flash_program(FAR struct fastboot_ctx_s *context, int fd)
+{
+  struct fastboot_sparse_s sparse;
+  int ret;
 
-  if (context->download_offset >= context->total_imgsize)
+  fastboot_sparse_init(&sparse, fd);
+  ret = fastboot_sparse_write(&sparse, context->download_buffer,
+                              context->download_size);
+  if (ret >= 0)
     {
-      context->total_imgsize = 0;
-      context->download_offset = 0;
+      ret = fastboot_sparse_finish(&sparse);
     }
 
   return ret;
 }
 
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+static FAR void *fastboot_stream_writer(FAR void *arg)
+{
+  FAR struct fastboot_stream_s *stream = arg;
+  int i;
+
+  for (i = 0; ; i ^= 1)
+    {
+      sem_wait(&stream->full);
+      if (stream->len[i] == 0)
+        {
+          break;
+        }
+
+      /* After an error keep consuming, the host sends the whole image */
+
+      if (stream->ret >= 0)
+        {
+          stream->ret = fastboot_sparse_write(&stream->sparse,
+                                              stream->buffer[i],
+                                              stream->len[i]);
+        }
+
+      sem_post(&stream->empty);
+    }
+
+  return NULL;
+}
+
+/* Receive the image into one half of the download buffer while the
+ * writer thread flashes the other one.
+ */
+
+static int fastboot_stream(FAR struct fastboot_ctx_s *context, size_t len)
+{
+  struct fastboot_stream_s stream;
+  char blkdev[PATH_MAX];
+  size_t half = context->download_max / 2;
+  size_t n;
+  int ret;
+  int fd;
+  int i;
+
+  snprintf(blkdev, PATH_MAX, FASTBOOT_BLKDEV, context->stream_name);
+  fd = fastboot_flash_open(blkdev);
+  if (fd < 0)
+    {
+      return fd;
+    }
+
+  fastboot_sparse_init(&stream.sparse, fd);
+  stream.buffer[0] = context->download_buffer;
+  stream.buffer[1] = stream.buffer[0] + half;
+  stream.ret = OK;
+  sem_init(&stream.empty, 0, 2);
+  sem_init(&stream.full, 0, 0);
+
+  ret = -pthread_create(&stream.writer, NULL, fastboot_stream_writer,
+                        &stream);
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  for (i = 0; len > 0 && ret >= 0; i ^= 1)
+    {
+      n = MIN(len, half);
+      sem_wait(&stream.empty);
+      ret = fastboot_receive(context->usbdev_in, stream.buffer[i], n);
+      stream.len[i] = ret < 0 ? 0 : n;
+      sem_post(&stream.full);
+      len -= n;
+    }
+
+  if (ret >= 0)
+    {
+      sem_wait(&stream.empty);
+      stream.len[i] = 0;
+      sem_post(&stream.full);
+    }
+
+  pthread_join(stream.writer, NULL);
+
+  if (ret >= 0)
+    {
+      ret = stream.ret;
+    }
+
+  if (ret >= 0)
+    {
+      ret = fastboot_sparse_finish(&stream.sparse);
+    }
+
+out:
+  sem_destroy(&stream.full);
+  sem_destroy(&stream.empty);
+  fastboot_flash_close(fd);
+  context->streamed = ret >= 0;
+  return ret;
+}
+#endif
+
 static void fastboot_flash(FAR struct fastboot_ctx_s *context,
                            FAR const char *arg)
 {
   char blkdev[PATH_MAX];
   int fd;
 
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+  if (context->streamed)
+    {
+      context->streamed = false;
+      if (strcmp(arg, context->stream_name) == 0)
+        {
+          fastboot_okay(context, "");
+        }
+      else
+        {
+          fastboot_fail(context, "Image streamed to another partition");
+        }
+
+      return;
+    }
+#endif
+
   snprintf(blkdev, PATH_MAX, FASTBOOT_BLKDEV, arg);
 
   fd = fastboot_flash_open(blkdev);
@@ -437,16 +789,47 @@ static void fastboot_erase(FAR struct fastboot_ctx_s *context,
   fastboot_flash_close(fd);
 }
 
+static FAR struct fastboot_var_s *
+fastboot_findvar(FAR struct fastboot_ctx_s *context, FAR const char *name)
+{
+  FAR struct fastboot_var_s *var;
+
+  for (var = context->varlist; var != NULL; var = var->next)
+    {
+      if (!strcmp(var->name, name))
+        {
+          break;
+        }
+    }
+
+  return var;
+}
+
+static size_t fastboot_download_max(FAR struct fastboot_ctx_s *context)
+{
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+  if (context->stream_name != NULL)
+    {
+      return CONFIG_SYSTEM_FASTBOOTD_STREAM_MAX;
+    }
+#endif
+
+  return context->download_max;
+}
+
 static void fastboot_download(FAR struct fastboot_ctx_s *context,
                               FAR const char *arg)
 {
-  FAR char *download;
+  FAR struct fastboot_var_s *var;
   char response[FASTBOOT_MSG_LEN];
+  struct timespec start;
+  struct timespec end;
   unsigned long len;
+  uint64_t ms;
   int ret;
 
   len = strtoul(arg, NULL, 16);
-  if (len > context->download_max)
+  if (len > fastboot_download_max(context))
     {
       fastboot_fail(context, "Data too large");
       return;
@@ -460,23 +843,46 @@ static void fastboot_download(FAR struct fastboot_ctx_s *context,
       return;
     }
 
-  download = context->download_buffer;
+  clock_gettime(CLOCK_MONOTONIC, &start);
 
-  while (len > 0)
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+  if (context->stream_name != NULL)
     {
-      ssize_t r = fastboot_read(context->usbdev_in,
-                                download, len);
-      if (r < 0)
+      ret = fastboot_stream(context, len);
+      if (ret < 0)
+        {
+          fastboot_fail(context, "Image stream failure");
+          return;
+        }
+    }
+  else
+#endif
+    {
+      ret = fastboot_receive(context->usbdev_in,
+                             context->download_buffer, len);
+      if (ret < 0)
         {
           printf("fastboot_download usb read error\n");
           return;
         }
 
-      len -= r;
-      download += r;
+      context->download_size = len;
+    }
+
+  /* Throughput of the last download in KiB/s, flashing included when
+   * streamed.
+   */
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  ms = (uint64_t)(end.tv_sec - start.tv_sec) * 1000 +
+       (end.tv_nsec - start.tv_nsec) / 1000000;
+
+  var = fastboot_findvar(context, "download-speed");
+  if (var != NULL)
+    {
+      var->data = (uint64_t)len * 1000 / 1024 / MAX(ms, 1);
     }
 
-  context->download_size = len;
   fastboot_okay(context, "");
 }
 
@@ -486,26 +892,61 @@ static void fastboot_getvar(FAR struct fastboot_ctx_s *context,
   FAR struct fastboot_var_s *var;
   char buffer[FASTBOOT_MSG_LEN];
 
-  for (var = context->varlist; var != NULL; var = var->next)
+  var = fastboot_findvar(context, arg);
+  if (var == NULL)
     {
-      if (!strcmp(var->name, arg))
-        {
-          if (var->string == NULL)
-            {
-              itoa(var->data, buffer, 10);
-              fastboot_okay(context, buffer);
-            }
-          else
-            {
-              fastboot_okay(context, var->string);
-            }
+      fastboot_okay(context, "");
+    }
+  else if (var->string == NULL)
+    {
+      itoa(var->data, buffer, 10);
+      fastboot_okay(context, buffer);
+    }
+  else
+    {
+      fastboot_okay(context, var->string);
+    }
+}
 
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+/* "fastboot oem stream <partition>" makes the following downloads flash
+ * the partition while they are received, "fastboot oem stream" goes back
+ * to buffered downloads.
+ */
+
+static void fastboot_oem_stream(FAR struct fastboot_ctx_s *context,
+                                FAR const char *arg)
+{
+  FAR struct fastboot_var_s *var;
+
+  while (*arg == ' ')
+    {
+      arg++;
+    }
+
+  free(context->stream_name);
+  context->stream_name = NULL;
+  context->streamed = false;
+
+  if (*arg != '\0')
+    {
+      context->stream_name = strdup(arg);
+      if (context->stream_name == NULL)
+        {
+          fastboot_fail(context, "No memory");
           return;
         }
     }
 
+  var = fastboot_findvar(context, "max-download-size");
+  if (var != NULL)
+    {
+      var->data = fastboot_download_max(context);
+    }
+
   fastboot_okay(context, "");
 }
+#endif
 
 static void fastboot_reboot(FAR struct fastboot_ctx_s *context,
                             FAR const char *arg)
@@ -583,6 +1024,7 @@ static void fastboot_create_publish(FAR struct fastboot_ctx_s *context)
   fastboot_publish(context, "slot-count", "1", 0);
   fastboot_publish(context, "max-download-size", NULL,
                    CONFIG_SYSTEM_FASTBOOTD_DOWNLOAD_MAX);
+  fastboot_publish(context, "download-speed", NULL, 0);
 }
 
 static void fastboot_free_publish(FAR struct fastboot_ctx_s *context)
@@ -637,12 +1079,19 @@ int main(int argc, FAR char **argv)
 
   context.download_buffer = buffer;
   context.download_size   = 0;
-  context.download_offset = 0;
   context.download_max    = CONFIG_SYSTEM_FASTBOOTD_DOWNLOAD_MAX;
+  context.varlist         = NULL;
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+  context.stream_name     = NULL;
+  context.streamed        = false;
+#endif
 
   fastboot_create_publish(&context);
   fastboot_command_loop(&context);
   fastboot_free_publish(&context);
+#ifdef CONFIG_SYSTEM_FASTBOOTD_STREAM
+  free(context.stream_name);
+#endif
 
   close(context.usbdev_out);
   context.usbdev_out = -1;
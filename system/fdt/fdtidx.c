@@ -0,0 +1,618 @@
+/****************************************************************************
+ * apps/system/fdt/fdtidx.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libfdt.h>
+
+#include "system/fdtidx.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FDTIDX_FNV_BASIS 2166136261u
+#define FDTIDX_FNV_PRIME 16777619u
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct fdtidx_node_s
+{
+  int      offset;                    /* Offset of the node in the blob */
+  int      parent;                    /* Index of the parent, -1 for root */
+  uint32_t prop;                      /* Index of the first property */
+  uint32_t nprops;
+};
+
+struct fdtidx_prop_s
+{
+  int      offset;                    /* Offset of the property */
+  uint32_t hash;                      /* Hash of the property name */
+};
+
+/* A node is in the hash table under its parent and name and, if the name
+ * has a unit address, a second time under its parent and the name without
+ * it.  The entries of one key follow each other in blob order along the
+ * probe sequence, so the first match is the one libfdt would return.
+ */
+
+struct fdtidx_bucket_s
+{
+  uint32_t hash;
+  uint32_t node;                      /* Node index + 1, 0 if empty */
+};
+
+struct fdtidx_phandle_s
+{
+  uint32_t phandle;
+  int      offset;
+};
+
+struct fdtidx_s
+{
+  FAR struct fdtidx_s          *flink;
+  FAR const void               *fdt;
+  FAR struct fdtidx_node_s     *nodes;
+  FAR struct fdtidx_prop_s     *props;
+  FAR struct fdtidx_bucket_s   *buckets;
+  FAR struct fdtidx_phandle_s  *phandles;
+  uint32_t                      nnodes;
+  uint32_t                      nphandles;
+  uint32_t                      mask;   /* Buckets - 1 */
+  int                           aliases;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static pthread_mutex_t g_fdtidx_lock = PTHREAD_MUTEX_INITIALIZER;
+static FAR struct fdtidx_s *g_fdtidx_list;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint32_t fdtidx_hash(uint32_t seed, FAR const char *s, int len)
+{
+  uint32_t hash = FDTIDX_FNV_BASIS ^ seed;
+
+  while (len-- > 0)
+    {
+      hash = (hash ^ (uint8_t)*s++) * FDTIDX_FNV_PRIME;
+    }
+
+  return hash;
+}
+
+static int fdtidx_phandle_cmp(FAR const void *a, FAR const void *b)
+{
+  uint32_t pa = ((FAR const struct fdtidx_phandle_s *)a)->phandle;
+  uint32_t pb = ((FAR const struct fdtidx_phandle_s *)b)->phandle;
+
+  return pa < pb ? -1 : pa > pb;
+}
+
+static void fdtidx_insert(FAR struct fdtidx_s *idx, uint32_t hash,
+                          uint32_t node)
+{
+  uint32_t i = hash & idx->mask;
+
+  while (idx->buckets[i].node != 0)
+    {
+      i = (i + 1) & idx->mask;
+    }
+
+  idx->buckets[i].hash = hash;
+  idx->buckets[i].node = node + 1;
+}
+
+/* Find the index of the node at nodeoffset: the nodes are in blob order,
+ * so their offsets are sorted.
+ */
+
+static int fdtidx_node(FAR struct fdtidx_s *idx, int nodeoffset)
+{
+  uint32_t lo = 0;
+  uint32_t hi = idx->nnodes;
+
+  while (lo < hi)
+    {
+      uint32_t mid = lo + (hi - lo) / 2;
+
+      if (idx->nodes[mid].offset < nodeoffset)
+        {
+          lo = mid + 1;
+        }
+      else
+        {
+          hi = mid;
+        }
+    }
+
+  if (lo == idx->nnodes || idx->nodes[lo].offset != nodeoffset)
+    {
+      return -FDT_ERR_BADOFFSET;
+    }
+
+  return lo;
+}
+
+static int fdtidx_subnode_namelen(FAR struct fdtidx_s *idx, int parent,
+                                  FAR const char *name, int namelen)
+{
+  uint32_t hash = fdtidx_hash(parent, name, namelen);
+  uint32_t i = hash & idx->mask;
+  bool addr = memchr(name, '@', namelen) != NULL;
+
+  for (; idx->buckets[i].node != 0; i = (i + 1) & idx->mask)
+    {
+      FAR struct fdtidx_node_s *node;
+      FAR const char *nodename;
+      int len;
+
+      if (idx->buckets[i].hash != hash)
+        {
+          continue;
+        }
+
+      node = &idx->nodes[idx->buckets[i].node - 1];
+      if (node->parent != parent)
+        {
+          continue;
+        }
+
+      nodename = fdt_get_name(idx->fdt, node->offset, &len);
+      if (nodename != NULL && len >= namelen &&
+          memcmp(nodename, name, namelen) == 0 &&
+          (len == namelen || (!addr && nodename[namelen] == '@')))
+        {
+          return node->offset;
+        }
+    }
+
+  return -FDT_ERR_NOTFOUND;
+}
+
+static FAR const void *fdtidx_getprop_namelen(FAR struct fdtidx_s *idx,
+                                              int nodeoffset,
+                                              FAR const char *name,
+                                              int namelen, FAR int *lenp)
+{
+  FAR struct fdtidx_node_s *node;
+  uint32_t hash;
+  uint32_t i;
+  int ret;
+
+  ret = fdtidx_node(idx, nodeoffset);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  node = &idx->nodes[ret];
+  hash = fdtidx_hash(0, name, namelen);
+
+  for (i = node->prop; i < node->prop + node->nprops; i++)
+    {
+      FAR const char *propname;
+      FAR const void *data;
+      int len;
+
+      if (idx->props[i].hash != hash)
+        {
+          continue;
+        }
+
+      data = fdt_getprop_by_offset(idx->fdt, idx->props[i].offset,
+                                   &propname, &len);
+      if (data != NULL && strncmp(propname, name, namelen) == 0 &&
+          propname[namelen] == '\0')
+        {
+          if (lenp != NULL)
+            {
+              *lenp = len;
+            }
+
+          return data;
+        }
+    }
+
+  ret = -FDT_ERR_NOTFOUND;
+
+errout:
+  if (lenp != NULL)
+    {
+      *lenp = ret;
+    }
+
+  return NULL;
+}
+
+/* Build the index in two passes over the blob: one to count the nodes,
+ * properties and phandles for a single allocation, one to fill it in.
+ */
+
+static FAR struct fdtidx_s *fdtidx_build(FAR const void *fdt)
+{
+  FAR struct fdtidx_s *idx;
+  FAR uint8_t *depths;
+  uint32_t nnodes = 0;
+  uint32_t nprops = 0;
+  uint32_t nphandles = 0;
+  uint32_t nbuckets;
+  uint32_t n;
+  int offset;
+  int depth;
+  int prop;
+
+  if (fdt_check_header(fdt) != 0)
+    {
+      return NULL;
+    }
+
+  for (depth = 0, offset = 0; offset >= 0;
+       offset = fdt_next_node(fdt, offset, &depth))
+    {
+      if (depth > UINT8_MAX)
+        {
+          return NULL;
+        }
+
+      nnodes++;
+      if (fdt_get_phandle(fdt, offset) != 0)
+        {
+          nphandles++;
+        }
+
+      fdt_for_each_property_offset(prop, fdt, offset)
+        {
+          nprops++;
+        }
+    }
+
+  if (offset != -FDT_ERR_NOTFOUND)
+    {
+      return NULL;
+    }
+
+  /* Two keys per node at most, at a load factor of a half at most */
+
+  for (nbuckets = 4; nbuckets < nnodes * 4; nbuckets <<= 1);
+
+  idx = zalloc(sizeof(*idx) +
+               nnodes * sizeof(struct fdtidx_node_s) +
+               nprops * sizeof(struct fdtidx_prop_s) +
+               nbuckets * sizeof(struct fdtidx_bucket_s) +
+               nphandles * sizeof(struct fdtidx_phandle_s));
+  if (idx == NULL)
+    {
+      return NULL;
+    }
+
+  depths = malloc(nnodes);
+  if (depths == NULL)
+    {
+      free(idx);
+      return NULL;
+    }
+
+  idx->fdt      = fdt;
+  idx->nodes    = (FAR struct fdtidx_node_s *)(idx + 1);
+  idx->props    = (FAR struct fdtidx_prop_s *)(idx->nodes + nnodes);
+  idx->buckets  = (FAR struct fdtidx_bucket_s *)(idx->props + nprops);
+  idx->phandles = (FAR struct fdtidx_phandle_s *)(idx->buckets +
+                                                   nbuckets);
+  idx->nnodes   = nnodes;
+  idx->mask     = nbuckets - 1;
+
+  for (n = 0, nprops = 0, depth = 0, offset = 0; n < nnodes;
+       n++, offset = fdt_next_node(fdt, offset, &depth))
+    {
+      FAR struct fdtidx_node_s *node = &idx->nodes[n];
+      FAR const char *name;
+      FAR const char *at;
+      uint32_t phandle;
+      int parent;
+      int len;
+
+      /* The parent is the closest node before this one that is one level
+       * up: the previous node or one of its ancestors.
+       */
+
+      parent = n - 1;
+      while (parent >= 0 && depths[parent] >= depth)
+        {
+          parent = idx->nodes[parent].parent;
+        }
+
+      depths[n]    = depth;
+      node->offset = offset;
+      node->parent = parent;
+      node->prop   = nprops;
+
+      fdt_for_each_property_offset(prop, fdt, offset)
+        {
+          FAR const char *propname;
+
+          fdt_getprop_by_offset(fdt, prop, &propname, NULL);
+          idx->props[nprops].offset = prop;
+          idx->props[nprops].hash   = fdtidx_hash(0, propname,
+                                                  strlen(propname));
+          nprops++;
+        }
+
+      node->nprops = nprops - node->prop;
+
+      phandle = fdt_get_phandle(fdt, offset);
+      if (phandle != 0)
+        {
+          idx->phandles[idx->nphandles].phandle = phandle;
+          idx->phandles[idx->nphandles].offset  = offset;
+          idx->nphandles++;
+        }
+
+      if (parent < 0)
+        {
+          continue;
+        }
+
+      name = fdt_get_name(fdt, offset, &len);
+      fdtidx_insert(idx, fdtidx_hash(parent, name, len), n);
+
+      at = memchr(name, '@', len);
+      if (at != NULL)
+        {
+          fdtidx_insert(idx, fdtidx_hash(parent, name, at - name), n);
+        }
+    }
+
+  free(depths);
+
+  qsort(idx->phandles, idx->nphandles, sizeof(struct fdtidx_phandle_s),
+        fdtidx_phandle_cmp);
+
+  idx->aliases = fdtidx_subnode_namelen(idx, 0, "aliases", 7);
+  return idx;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fdtidx_get
+ ****************************************************************************/
+
+FAR struct fdtidx_s *fdtidx_get(FAR const void *fdt)
+{
+  FAR struct fdtidx_s *idx;
+
+  pthread_mutex_lock(&g_fdtidx_lock);
+
+  for (idx = g_fdtidx_list; idx != NULL; idx = idx->flink)
+    {
+      if (idx->fdt == fdt)
+        {
+          break;
+        }
+    }
+
+  if (idx == NULL)
+    {
+      idx = fdtidx_build(fdt);
+      if (idx != NULL)
+        {
+          idx->flink    = g_fdtidx_list;
+          g_fdtidx_list = idx;
+        }
+    }
+
+  pthread_mutex_unlock(&g_fdtidx_lock);
+  return idx;
+}
+
+/****************************************************************************
+ * Name: fdtidx_put
+ ****************************************************************************/
+
+void fdtidx_put(FAR const void *fdt)
+{
+  FAR struct fdtidx_s **pidx;
+  FAR struct fdtidx_s *idx;
+
+  pthread_mutex_lock(&g_fdtidx_lock);
+
+  for (pidx = &g_fdtidx_list; (idx = *pidx) != NULL; pidx = &idx->flink)
+    {
+      if (idx->fdt == fdt)
+        {
+          *pidx = idx->flink;
+          free(idx);
+          break;
+        }
+    }
+
+  pthread_mutex_unlock(&g_fdtidx_lock);
+}
+
+/****************************************************************************
+ * Name: fdtidx_path_offset
+ ****************************************************************************/
+
+int fdtidx_path_offset(FAR struct fdtidx_s *idx, FAR const char *path)
+{
+  FAR const char *end = path + strlen(path);
+  FAR const char *p = path;
+  int offset = 0;
+
+  /* A path not starting with '/' starts with an alias */
+
+  if (*path != '/')
+    {
+      FAR const char *q = strchr(path, '/');
+      FAR const char *alias;
+
+      if (q == NULL)
+        {
+          q = end;
+        }
+
+      if (idx->aliases < 0)
+        {
+          return -FDT_ERR_BADPATH;
+        }
+
+      alias = fdtidx_getprop_namelen(idx, idx->aliases, path, q - path,
+                                     NULL);
+      if (alias == NULL || *alias != '/')
+        {
+          return -FDT_ERR_BADPATH;
+        }
+
+      offset = fdtidx_path_offset(idx, alias);
+      p = q;
+    }
+
+  while (offset >= 0 && p < end)
+    {
+      FAR const char *q;
+      int node;
+
+      while (*p == '/')
+        {
+          p++;
+        }
+
+      if (*p == '\0')
+        {
+          break;
+        }
+
+      q = strchr(p, '/');
+      if (q == NULL)
+        {
+          q = end;
+        }
+
+      node = fdtidx_node(idx, offset);
+      if (node < 0)
+        {
+          return node;
+        }
+
+      offset = fdtidx_subnode_namelen(idx, node, p, q - p);
+      p = q;
+    }
+
+  return offset;
+}
+
+/****************************************************************************
+ * Name: fdtidx_subnode_offset
+ ****************************************************************************/
+
+int fdtidx_subnode_offset(FAR struct fdtidx_s *idx, int parentoffset,
+                          FAR const char *name)
+{
+  int node = fdtidx_node(idx, parentoffset);
+
+  if (node < 0)
+    {
+      return node;
+    }
+
+  return fdtidx_subnode_namelen(idx, node, name, strlen(name));
+}
+
+/****************************************************************************
+ * Name: fdtidx_parent_offset
+ ****************************************************************************/
+
+int fdtidx_parent_offset(FAR struct fdtidx_s *idx, int nodeoffset)
+{
+  int node = fdtidx_node(idx, nodeoffset);
+
+  if (node < 0)
+    {
+      return node;
+    }
+
+  node = idx->nodes[node].parent;
+  return node < 0 ? -FDT_ERR_NOTFOUND : idx->nodes[node].offset;
+}
+
+/****************************************************************************
+ * Name: fdtidx_node_offset_by_phandle
+ ****************************************************************************/
+
+int fdtidx_node_offset_by_phandle(FAR struct fdtidx_s *idx,
+                                  uint32_t phandle)
+{
+  uint32_t lo = 0;
+  uint32_t hi = idx->nphandles;
+
+  if (phandle == 0 || phandle == (uint32_t)-1)
+    {
+      return -FDT_ERR_BADPHANDLE;
+    }
+
+  while (lo < hi)
+    {
+      uint32_t mid = lo + (hi - lo) / 2;
+
+      if (idx->phandles[mid].phandle < phandle)
+        {
+          lo = mid + 1;
+        }
+      else
+        {
+          hi = mid;
+        }
+    }
+
+  if (lo == idx->nphandles || idx->phandles[lo].phandle != phandle)
+    {
+      return -FDT_ERR_NOTFOUND;
+    }
+
+  return idx->phandles[lo].offset;
+}
+
+/****************************************************************************
+ * Name: fdtidx_getprop
+ ****************************************************************************/
+
+FAR const void *fdtidx_getprop(FAR struct fdtidx_s *idx, int nodeoffset,
+                               FAR const char *name, FAR int *lenp)
+{
+  return fdtidx_getprop_namelen(idx, nodeoffset, name, strlen(name), lenp);
+}
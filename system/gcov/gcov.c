@@ -22,9 +22,55 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include <stdio.h>
 #include <unistd.h>
 
+#ifdef CONFIG_SYSTEM_GCOV_STREAM
+#  include <sys/socket.h>
+#  include <sys/stat.h>
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <dirent.h>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <limits.h>
+#  include <stdint.h>
+#  include <stdlib.h>
+#  include <string.h>
+#  include <zlib.h>
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_GCOV_STREAM
+#  define GCOV_STREAM_MAGIC    "GCOVSTRM"
+#  define GCOV_STREAM_BUFSIZE  512
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_GCOV_STREAM
+struct gcov_stream_s
+{
+  z_stream strm;
+  int fd;
+  unsigned char out[GCOV_STREAM_BUFSIZE];
+};
+#endif
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+void __gcov_dump(void);
+void __gcov_reset(void);
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -35,19 +81,338 @@
 
 static void show_usage(FAR const char *progname)
 {
+#ifdef CONFIG_SYSTEM_GCOV_STREAM
+  printf("\nUsage: %s [-d] [-s <file|tcp:ip:port>] [-r] [-h]\n",
+         progname);
+#else
   printf("\nUsage: %s [-d] [-r] [-h]\n", progname);
+#endif
   printf("\nWhere:\n");
   printf("  -d dump the coverage.\n");
+#ifdef CONFIG_SYSTEM_GCOV_STREAM
+  printf("  -s dump the coverage as one compressed stream to a file or\n"
+         "     to a TCP server, to be split by tools/gcov_split.py.\n");
+#endif
   printf("  -r reset the coverage\n");
   printf("  -h show this text and exits.\n");
 }
 
+#ifdef CONFIG_SYSTEM_GCOV_STREAM
 /****************************************************************************
- * Public Function Prototypes
+ * Name: gcov_stream_deflate
+ *
+ * Description:
+ *   Compress data (or finish the stream if flush is Z_FINISH) and write
+ *   the output to the destination.
+ *
  ****************************************************************************/
 
-void __gcov_dump(void);
-void __gcov_reset(void);
+static int gcov_stream_deflate(FAR struct gcov_stream_s *s,
+                               FAR const void *data, size_t len, int flush)
+{
+  FAR const unsigned char *ptr;
+  ssize_t nwritten;
+  size_t have;
+  int ret;
+
+  s->strm.next_in  = (FAR unsigned char *)data;
+  s->strm.avail_in = len;
+
+  do
+    {
+      s->strm.next_out  = s->out;
+      s->strm.avail_out = sizeof(s->out);
+
+      ret = deflate(&s->strm, flush);
+      if (ret == Z_STREAM_ERROR)
+        {
+          return -EIO;
+        }
+
+      have = sizeof(s->out) - s->strm.avail_out;
+      for (ptr = s->out; have > 0; ptr += nwritten, have -= nwritten)
+        {
+          nwritten = write(s->fd, ptr, have);
+          if (nwritten < 0)
+            {
+              if (errno == EINTR)
+                {
+                  nwritten = 0;
+                  continue;
+                }
+
+              return -errno;
+            }
+        }
+    }
+  while (s->strm.avail_out == 0);
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: gcov_stream_u32
+ ****************************************************************************/
+
+static int gcov_stream_u32(FAR struct gcov_stream_s *s, uint32_t value)
+{
+  uint8_t le[4];
+
+  le[0] = value & 0xff;
+  le[1] = (value >> 8) & 0xff;
+  le[2] = (value >> 16) & 0xff;
+  le[3] = (value >> 24) & 0xff;
+  return gcov_stream_deflate(s, le, sizeof(le), Z_NO_FLUSH);
+}
+
+/****************************************************************************
+ * Name: gcov_stream_file
+ *
+ * Description:
+ *   Append one record: the length and the path of the file as seen by the
+ *   program, then the length and the content of the file, which is
+ *   removed.
+ *
+ ****************************************************************************/
+
+static int gcov_stream_file(FAR struct gcov_stream_s *s,
+                            FAR const char *path, FAR const char *name,
+                            off_t size)
+{
+  char buf[GCOV_STREAM_BUFSIZE];
+  ssize_t nread;
+  int ret;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  ret = gcov_stream_u32(s, strlen(name));
+  if (ret == 0)
+    {
+      ret = gcov_stream_deflate(s, name, strlen(name), Z_NO_FLUSH);
+    }
+
+  if (ret == 0)
+    {
+      ret = gcov_stream_u32(s, size);
+    }
+
+  while (ret == 0 && size > 0)
+    {
+      nread = read(fd, buf, sizeof(buf));
+      if (nread <= 0)
+        {
+          ret = nread < 0 ? -errno : -EIO;
+          break;
+        }
+
+      nread = nread > size ? size : nread;
+      ret   = gcov_stream_deflate(s, buf, nread, Z_NO_FLUSH);
+      size -= nread;
+    }
+
+  close(fd);
+  unlink(path);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: gcov_stream_dir
+ *
+ * Description:
+ *   Stream all of the files below path.  The name of the record is the path
+ *   without the directory that __gcov_dump() used as a prefix.
+ *
+ ****************************************************************************/
+
+static int gcov_stream_dir(FAR struct gcov_stream_s *s, FAR char *path,
+                           size_t prefixlen)
+{
+  FAR struct dirent *entry;
+  struct stat st;
+  FAR DIR *dir;
+  size_t len = strlen(path);
+  int ret = 0;
+
+  dir = opendir(path);
+  if (dir == NULL)
+    {
+      return -errno;
+    }
+
+  while (ret == 0 && (entry = readdir(dir)) != NULL)
+    {
+      if (strcmp(entry->d_name, ".") == 0 ||
+          strcmp(entry->d_name, "..") == 0)
+        {
+          continue;
+        }
+
+      if (len + 1 + strlen(entry->d_name) >= PATH_MAX)
+        {
+          ret = -ENAMETOOLONG;
+          break;
+        }
+
+      path[len] = '/';
+      strlcpy(&path[len + 1], entry->d_name, PATH_MAX - len - 1);
+
+      if (stat(path, &st) < 0)
+        {
+          ret = -errno;
+        }
+      else if (S_ISDIR(st.st_mode))
+        {
+          ret = gcov_stream_dir(s, path, prefixlen);
+          rmdir(path);
+        }
+      else if (S_ISREG(st.st_mode))
+        {
+          ret = gcov_stream_file(s, path, &path[prefixlen], st.st_size);
+        }
+
+      path[len] = '\0';
+    }
+
+  closedir(dir);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: gcov_stream_open
+ *
+ * Description:
+ *   Open the destination: "tcp:<ip>:<port>" connects to a TCP server (e.g.
+ *   "nc -l <port> > cov.gz" on the host), anything else is a file path,
+ *   which may be on a semihosting or hostfs mount.
+ *
+ ****************************************************************************/
+
+static int gcov_stream_open(FAR const char *dest)
+{
+  struct sockaddr_in addr;
+  FAR char *port;
+  char host[INET_ADDRSTRLEN];
+  int fd;
+
+  if (strncmp(dest, "tcp:", 4) != 0)
+    {
+      fd = open(dest, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      return fd < 0 ? -errno : fd;
+    }
+
+  strlcpy(host, dest + 4, sizeof(host));
+  port = strchr(host, ':');
+  if (port == NULL)
+    {
+      return -EINVAL;
+    }
+
+  *port++ = '\0';
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port   = htons(atoi(port));
+  if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+    {
+      return -EINVAL;
+    }
+
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  if (connect(fd, (FAR struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+      int errcode = errno;
+
+      close(fd);
+      return -errcode;
+    }
+
+  return fd;
+}
+
+/****************************************************************************
+ * Name: gcov_stream
+ *
+ * Description:
+ *   Dump the coverage into a scratch directory (ideally on tmpfs), then
+ *   send all of the .gcda files as one gzip stream to dest.
+ *
+ ****************************************************************************/
+
+static int gcov_stream(FAR const char *dest)
+{
+  FAR struct gcov_stream_s *s;
+  FAR char *path;
+  int ret;
+
+  s    = malloc(sizeof(*s));
+  path = malloc(PATH_MAX);
+  if (s == NULL || path == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  strlcpy(path, CONFIG_SYSTEM_GCOV_STREAM_TMPDIR, PATH_MAX);
+  mkdir(path, 0777);
+  setenv("GCOV_PREFIX", path, 1);
+  __gcov_dump();
+
+  s->fd = gcov_stream_open(dest);
+  if (s->fd < 0)
+    {
+      ret = s->fd;
+      goto errout;
+    }
+
+  /* windowBits + 16 selects the gzip format, readable by gzip -d */
+
+  memset(&s->strm, 0, sizeof(s->strm));
+  if (deflateInit2(&s->strm, CONFIG_SYSTEM_GCOV_STREAM_LEVEL, Z_DEFLATED,
+                   15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+      ret = -ENOMEM;
+      goto errout_with_fd;
+    }
+
+  ret = gcov_stream_deflate(s, GCOV_STREAM_MAGIC,
+                            strlen(GCOV_STREAM_MAGIC), Z_NO_FLUSH);
+  if (ret == 0)
+    {
+      ret = gcov_stream_dir(s, path, strlen(path));
+    }
+
+  /* A record with an empty name ends the stream */
+
+  if (ret == 0)
+    {
+      ret = gcov_stream_u32(s, 0);
+    }
+
+  if (ret == 0)
+    {
+      ret = gcov_stream_deflate(s, NULL, 0, Z_FINISH);
+    }
+
+  deflateEnd(&s->strm);
+
+errout_with_fd:
+  close(s->fd);
+
+errout:
+  free(path);
+  free(s);
+  return ret;
+}
+#endif /* CONFIG_SYSTEM_GCOV_STREAM */
 
 /****************************************************************************
  * Public Functions
@@ -56,13 +421,16 @@ void __gcov_reset(void);
 int main(int argc, FAR char *argv[])
 {
   int option;
+#ifdef CONFIG_SYSTEM_GCOV_STREAM
+  int ret;
+#endif
 
   if (argc < 2)
     {
       show_usage(argv[0]);
     }
 
-  while ((option = getopt(argc, argv, "drh")) != ERROR)
+  while ((option = getopt(argc, argv, "ds:rh")) != ERROR)
     {
       switch (option)
         {
@@ -70,6 +438,17 @@ int main(int argc, FAR char *argv[])
             __gcov_dump();
             break;
 
+#ifdef CONFIG_SYSTEM_GCOV_STREAM
+          case 's':
+            ret = gcov_stream(optarg);
+            if (ret < 0)
+              {
+                fprintf(stderr, "ERROR: Coverage stream failed: %d\n", ret);
+                return EXIT_FAILURE;
+              }
+            break;
+
+#endif
           case 'r':
             __gcov_reset();
             break;
@@ -22,14 +22,38 @@
  * Included Files
  ****************************************************************************/
 
+#include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/param.h>
+#include <termios.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 
 #include <nuttx/gdbstub.h>
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The link to gdb.  The stub asks for a few bytes at a time, so the input
+ * is read in blocks of what is available.
+ */
+
+struct gdb_link_s
+{
+  int fd;
+  size_t head;
+  size_t tail;
+  char buf[CONFIG_SYSTEM_GDBSTUB_BUFSIZE];
+};
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -71,14 +95,19 @@ static int gdb_monitor(FAR struct gdb_state_s *state, FAR const char *cmd)
 static ssize_t gdb_send(FAR void *priv, FAR void *buf,
                         size_t len)
 {
-  int fd = *(FAR int *)priv;
+  FAR struct gdb_link_s *link = priv;
   size_t i = 0;
 
   while (i < len)
     {
-      ssize_t ret = write(fd, (FAR char *)buf + i, len - i);
+      ssize_t ret = write(link->fd, (FAR char *)buf + i, len - i);
       if (ret < 0)
         {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
           return -errno;
         }
 
@@ -91,28 +120,73 @@ static ssize_t gdb_send(FAR void *priv, FAR void *buf,
 static ssize_t gdb_recv(FAR void *priv, FAR void *buf,
                         size_t len)
 {
-  int fd = *(FAR int *)priv;
+  FAR struct gdb_link_s *link = priv;
   size_t i = 0;
+  size_t n;
 
   while (i < len)
     {
-      ssize_t ret = read(fd, (FAR char *)buf + i, len - i);
-      if (ret < 0)
+      if (link->head == link->tail)
         {
-          return -errno;
+          ssize_t ret = read(link->fd, link->buf, sizeof(link->buf));
+          if (ret < 0)
+            {
+              if (errno == EINTR)
+                {
+                  continue;
+                }
+
+              return -errno;
+            }
+          else if (ret == 0)
+            {
+              return -ECONNRESET;
+            }
+
+          link->head = ret;
+          link->tail = 0;
         }
 
-      i += ret;
+      n = MIN(len - i, link->head - link->tail);
+      memcpy((FAR char *)buf + i, &link->buf[link->tail], n);
+      link->tail += n;
+      i += n;
     }
 
   return len;
 }
 
+static void gdb_tty_setup(int fd, FAR const char *baud)
+{
+  struct termios tio;
+
+  if (tcgetattr(fd, &tio) < 0)
+    {
+      return;
+    }
+
+#ifdef CONFIG_SERIAL_TERMIOS
+  if (baud != NULL && cfsetspeed(&tio, atoi(baud)) < 0)
+    {
+      fprintf(stderr, "ERROR: Failed to set baud rate %s: %d\n",
+              baud, errno);
+    }
+#endif
+
+  /* Raw mode: binary packets must not be translated or echoed */
+
+  cfmakeraw(&tio);
+  tcsetattr(fd, TCSANOW, &tio);
+}
+
 static void usage(FAR const char *progname)
 {
   fprintf(stderr, "USAGE: %s [tty Options | Net Options] \n", progname);
   fprintf(stderr, "tty Options:\n");
   fprintf(stderr, "   -d [tty device path]  etc:/dev/ttyS0\n");
+#ifdef CONFIG_SERIAL_TERMIOS
+  fprintf(stderr, "   -b [baud rate]  etc:921600\n");
+#endif
   fprintf(stderr, "Net Options:\n");
   fprintf(stderr, "   -p [Port]  etc:1234\n");
   fprintf(stderr, "   -h: show help message and exit\n");
@@ -132,18 +206,23 @@ int main(int argc, FAR char *argv[])
   int sock = 0;
 #endif
   FAR struct gdb_state_s *state;
+  FAR struct gdb_link_s *link;
+  FAR char *baud = NULL;
   FAR char *dev = NULL;
   int ret;
   int fd;
 
 #ifdef CONFIG_NET
-  while ((ret = getopt_long(argc, argv, "d:p:h", NULL, NULL)) != ERROR)
+  while ((ret = getopt_long(argc, argv, "b:d:p:h", NULL, NULL)) != ERROR)
 #else
-  while ((ret = getopt_long(argc, argv, "d:h", NULL, NULL)) != ERROR)
+  while ((ret = getopt_long(argc, argv, "b:d:h", NULL, NULL)) != ERROR)
 #endif
     {
       switch (ret)
       {
+        case 'b':
+          baud = optarg;
+          break;
         case 'd':
           dev = optarg;
           break;
@@ -193,6 +272,11 @@ reconnect:
           fprintf(stderr, "ERROR: Failed to accept socket: %d\n", errno);
           return -errno;
         }
+
+      /* Each packet waits for its ack, do not delay the small ones */
+
+      ret = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &ret, sizeof(ret));
     }
   else
 #endif
@@ -204,19 +288,29 @@ reconnect:
           fprintf(stderr, "ERROR: Failed to open %s: %d\n", dev, errno);
           return -errno;
         }
+
+      gdb_tty_setup(fd, baud);
     }
   else
     {
       usage(argv[0]);
     }
 
-  state = gdb_state_init(gdb_send, gdb_recv, gdb_monitor, &fd);
-  if (state == NULL)
+  link = zalloc(sizeof(*link));
+  if (link == NULL)
     {
       ret = -ENOMEM;
       goto errout;
     }
 
+  link->fd = fd;
+  state = gdb_state_init(gdb_send, gdb_recv, gdb_monitor, link);
+  if (state == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout_with_link;
+    }
+
   do
     {
       ret = gdb_process(state, 0, NULL);
@@ -226,6 +320,8 @@ reconnect:
           if (port)
             {
               close(fd);
+              gdb_state_uninit(state);
+              free(link);
               goto reconnect;
             }
 
@@ -237,6 +333,9 @@ reconnect:
 
   gdb_state_uninit(state);
 
+errout_with_link:
+  free(link);
+
 errout:
   close(fd);
 #ifdef CONFIG_NET
@@ -0,0 +1,213 @@
+/****************************************************************************
+ * apps/system/i2c/i2c_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nuttx/i2c/i2c_master.h>
+
+#include "i2ctool.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DEFAULT_XFERS 100
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Standard, fast and fast-plus mode */
+
+static const uint32_t g_benchfreqs[] =
+{
+  100000, 400000, 1000000
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: i2ctool_bench
+ *
+ * Description:
+ *   Time xfers reads of nbytes at the given frequency.  Returns the
+ *   elapsed time in microseconds or a negated errno value.
+ *
+ ****************************************************************************/
+
+static int64_t i2ctool_bench(FAR struct i2ctool_s *i2ctool, int fd,
+                             uint32_t freq, FAR uint8_t *buf, int nbytes,
+                             long xfers)
+{
+  struct i2ctool_s bench = *i2ctool;
+  struct timespec start;
+  struct timespec end;
+  long i;
+  int ret;
+
+  bench.freq = freq;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < xfers; i++)
+    {
+      ret = i2ctool_dump(&bench, fd, bench.regaddr, buf, nbytes);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (int64_t)(end.tv_sec - start.tv_sec) * 1000000 +
+         (end.tv_nsec - start.tv_nsec) / 1000;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: i2ccmd_bench
+ ****************************************************************************/
+
+int i2ccmd_bench(FAR struct i2ctool_s *i2ctool, int argc, FAR char **argv)
+{
+  uint8_t buf[MAX_DUMP_CNT];
+  FAR char *ptr;
+  int64_t usec;
+  long xfers;
+  int nbytes;
+  int nargs;
+  int argndx;
+  int fd;
+  int i;
+
+  /* Parse any command line arguments */
+
+  for (argndx = 1; argndx < argc; )
+    {
+      /* Break out of the look when the last option has been parsed */
+
+      ptr = argv[argndx];
+      if (*ptr != '-')
+        {
+          break;
+        }
+
+      /* Otherwise, check for common options */
+
+      nargs = i2ctool_common_args(i2ctool, &argv[argndx]);
+      if (nargs < 0)
+        {
+          return ERROR;
+        }
+
+      argndx += nargs;
+    }
+
+  /* The options may be followed by the size of one transfer and by the
+   * number of transfers per bus speed.
+   */
+
+  nbytes = i2ctool->width / 8;
+  if (argndx < argc)
+    {
+      nbytes = atoi(argv[argndx]);
+      if (nbytes < 1 || nbytes > MAX_DUMP_CNT)
+        {
+          i2ctool_printf(i2ctool, g_i2cargrange, argv[0]);
+          return ERROR;
+        }
+
+      argndx++;
+    }
+
+  xfers = BENCH_DEFAULT_XFERS;
+  if (argndx < argc)
+    {
+      xfers = strtol(argv[argndx], NULL, 10);
+      if (xfers < 1)
+        {
+          i2ctool_printf(i2ctool, g_i2cargrange, argv[0]);
+          return ERROR;
+        }
+
+      argndx++;
+    }
+
+  if (argndx != argc)
+    {
+      i2ctool_printf(i2ctool, g_i2ctoomanyargs, argv[0]);
+      return ERROR;
+    }
+
+  /* Get a handle to the I2C bus */
+
+  fd = i2cdev_open(i2ctool->bus);
+  if (fd < 0)
+    {
+      i2ctool_printf(i2ctool, "Failed to get bus %d\n", i2ctool->bus);
+      return ERROR;
+    }
+
+  i2ctool_printf(i2ctool, "BENCH Bus: %d Addr: %02x Bytes: %d "
+                 "Transfers: %ld\n",
+                 i2ctool->bus, i2ctool->addr, nbytes, xfers);
+  i2ctool_printf(i2ctool, "%10s %10s %10s %10s\n",
+                 "Freq", "Xfers/s", "Bytes/s", "us/xfer");
+
+  for (i = 0; i < nitems(g_benchfreqs); i++)
+    {
+      usec = i2ctool_bench(i2ctool, fd, g_benchfreqs[i], buf, nbytes,
+                           xfers);
+      if (usec < 0)
+        {
+          i2ctool_printf(i2ctool, "%10" PRIu32 " transfer failed: %d\n",
+                         g_benchfreqs[i], (int)-usec);
+          continue;
+        }
+
+      if (usec == 0)
+        {
+          usec = 1;
+        }
+
+      i2ctool_printf(i2ctool, "%10" PRIu32 " %10" PRId64 " %10" PRId64
+                     " %10" PRId64 "\n", g_benchfreqs[i],
+                     xfers * INT64_C(1000000) / usec,
+                     xfers * nbytes * INT64_C(1000000) / usec,
+                     usec / xfers);
+    }
+
+  close(fd);
+  return OK;
+}
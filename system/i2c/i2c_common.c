@@ -144,10 +144,18 @@ int i2ctool_common_args(FAR struct i2ctool_s *i2ctool, FAR char **arg)
         i2ctool->autoincr = false;
         return 1;
 
+      case 'm':
+        i2ctool->burst = true;
+        return 1;
+
       case 'n':
         i2ctool->start = false;
         return 1;
 
+      case 'o':
+        i2ctool->burst = false;
+        return 1;
+
       case 'r':
         ret = arg_hex(arg, &value);
         if (value < 0 || value > CONFIG_I2CTOOL_MAXREGADDR)
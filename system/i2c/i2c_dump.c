@@ -37,9 +37,14 @@
 
 /****************************************************************************
  * Name: i2ctool_dump
+ *
+ * Description:
+ *   Read nbytes starting at regaddr in a single combined transfer.  The
+ *   device must auto-increment its register index.
+ *
  ****************************************************************************/
 
-static int i2ctool_dump(FAR struct i2ctool_s *i2ctool, int fd,
+int i2ctool_dump(FAR struct i2ctool_s *i2ctool, int fd,
                         uint8_t regaddr, FAR uint8_t *buf, int nbytes)
 {
   struct i2c_msg_s msg[2];
@@ -24,13 +24,90 @@
 
 #include <nuttx/config.h>
 
+#include <sys/param.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <nuttx/i2c/i2c_master.h>
 
 #include "i2ctool.h"
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: i2ctool_getshow
+ ****************************************************************************/
+
+static void i2ctool_getshow(FAR struct i2ctool_s *i2ctool, uint8_t regaddr,
+                            uint16_t result)
+{
+  i2ctool_printf(i2ctool,
+                 "READ Bus: %d Addr: %02x Subaddr: %02x Value: ",
+                 i2ctool->bus, i2ctool->addr, regaddr);
+
+  if (i2ctool->width == 8)
+    {
+      i2ctool_printf(i2ctool, "%02x\n", result);
+    }
+  else
+    {
+      i2ctool_printf(i2ctool, "%04x\n", result);
+    }
+}
+
+/****************************************************************************
+ * Name: i2ctool_getburst
+ *
+ * Description:
+ *   Read the registers of an auto-incrementing device with one combined
+ *   transfer per MAX_DUMP_CNT bytes instead of one transfer per register.
+ *
+ ****************************************************************************/
+
+static int i2ctool_getburst(FAR struct i2ctool_s *i2ctool, int fd,
+                            FAR const char *cmd, uint8_t regaddr,
+                            long repetitions)
+{
+  uint8_t buf[MAX_DUMP_CNT];
+  uint16_t result;
+  int width = i2ctool->width / 8;
+  int nregs;
+  int ret;
+  int i;
+
+  while (repetitions > 0)
+    {
+      nregs = MIN(repetitions, MAX_DUMP_CNT / width);
+      ret   = i2ctool_dump(i2ctool, fd, regaddr, buf, nregs * width);
+      if (ret < 0)
+        {
+          i2ctool_printf(i2ctool, g_i2cxfrerror, cmd, -ret);
+          return ret;
+        }
+
+      for (i = 0; i < nregs; i++)
+        {
+          if (width == 1)
+            {
+              result = buf[i];
+            }
+          else
+            {
+              memcpy(&result, &buf[2 * i], 2);
+            }
+
+          i2ctool_getshow(i2ctool, regaddr++, result);
+        }
+
+      repetitions -= nregs;
+    }
+
+  return OK;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -106,11 +183,20 @@ int i2ccmd_get(FAR struct i2ctool_s *i2ctool, int argc, FAR char **argv)
       return ERROR;
     }
 
-  /* Loop for the requested number of repetitions */
-
   regaddr = i2ctool->regaddr;
   ret = OK;
 
+  /* Incrementing registers may be read in bursts */
+
+  if (i2ctool->burst && i2ctool->autoincr && i2ctool->hasregindx)
+    {
+      ret = i2ctool_getburst(i2ctool, fd, argv[0], regaddr, repetitions);
+      close(fd);
+      return ret;
+    }
+
+  /* Loop for the requested number of repetitions */
+
   for (i = 0; i < repetitions; i++)
     {
       /* Read from the I2C bus */
@@ -121,18 +207,7 @@ int i2ccmd_get(FAR struct i2ctool_s *i2ctool, int argc, FAR char **argv)
 
       if (ret == OK)
         {
-          i2ctool_printf(i2ctool,
-                         "READ Bus: %d Addr: %02x Subaddr: %02x Value: ",
-                         i2ctool->bus, i2ctool->addr, regaddr);
-
-          if (i2ctool->width == 8)
-            {
-              i2ctool_printf(i2ctool, "%02x\n", result);
-            }
-          else
-            {
-              i2ctool_printf(i2ctool, "%04x\n", result);
-            }
+          i2ctool_getshow(i2ctool, regaddr, result);
         }
       else
         {
@@ -55,6 +55,12 @@ static struct i2ctool_s g_i2ctool;
 static const struct cmdmap_s g_i2ccmds[] =
 {
   { "?",     i2ccmd_help,  "Show help     ", NULL },
+#ifdef CONFIG_I2CTOOL_BENCH
+  {
+    "bench", i2ccmd_bench, "Benchmark bus ",
+      "[OPTIONS] [<num bytes>] [<transfers>]"
+  },
+#endif
   { "bus",   i2ccmd_bus,   "List buses    ", NULL },
 #ifdef CONFIG_I2C_RESET
   { "reset", i2ccmd_reset, "Reset bus     ", NULL },
@@ -140,6 +146,10 @@ static int i2ccmd_help(FAR struct i2ctool_s *i2ctool, int argc,
                  "repetitions."
                  "  Default: NO Current: %s\n",
                  i2ctool->autoincr ? "YES" : "NO");
+  i2ctool_printf(i2ctool,
+                 "  [-m|o], Burst|single register reads with -i."
+                 "  Default: -o Current: %s\n",
+                 i2ctool->burst ? "-m" : "-o");
   i2ctool_printf(i2ctool,
                  "  [-f freq] I2C frequency."
                  "  Default: %d Current: %" PRIu32 "\n",
@@ -128,6 +128,7 @@ struct i2ctool_s
   uint8_t  width;      /* [-w width] is the data width (8 or 16) */
   bool     start;      /* [-s|n], send|don't send start between command and data */
   bool     autoincr;   /* [-i|j], Auto increment|don't increment regaddr on repetitions */
+  bool     burst;      /* [-m|o], Burst|single register reads with -i */
   bool     hasregindx; /* true with the use of -r */
   uint32_t freq;       /* [-f freq] I2C frequency */
 
@@ -184,6 +185,10 @@ int i2ccmd_dump(FAR struct i2ctool_s *i2ctool, int argc, FAR char **argv);
 int i2ccmd_set(FAR struct i2ctool_s *i2ctool, int argc, FAR char **argv);
 int i2ccmd_verf(FAR struct i2ctool_s *i2ctool, int argc, FAR char **argv);
 
+#ifdef CONFIG_I2CTOOL_BENCH
+int i2ccmd_bench(FAR struct i2ctool_s *i2ctool, int argc, FAR char **argv);
+#endif
+
 #ifdef CONFIG_I2C_RESET
 int i2ccmd_reset(FAR struct i2ctool_s *i2ctool, int argc, FAR char **argv);
 #endif
@@ -194,6 +199,8 @@ int i2ctool_get(FAR struct i2ctool_s *i2ctool, int fd, uint8_t regaddr,
                 FAR uint16_t *result);
 int i2ctool_set(FAR struct i2ctool_s *i2ctool, int fd, uint8_t regaddr,
                 uint16_t value);
+int i2ctool_dump(FAR struct i2ctool_s *i2ctool, int fd, uint8_t regaddr,
+                 FAR uint8_t *buf, int nbytes);
 
 /* Common logic */
 
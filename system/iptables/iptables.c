@@ -27,7 +27,9 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <nuttx/net/netfilter/ip_tables.h>
 #include <nuttx/net/netfilter/nf_nat.h>
@@ -35,6 +37,13 @@
 #include "argtable3.h"
 #include "netutils/netlib.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define IPTABLES_RESTORE_LINELEN 256
+#define IPTABLES_RESTORE_MAXARGS 16
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -81,6 +90,29 @@ struct iptables_command_s
   int rulenum;
 };
 
+#ifdef CONFIG_SYSTEM_IPTABLES_RESTORE
+/* Entries appended to a chain during a restore, back to back, which are
+ * put into the table with a single move once another kind of command or
+ * the COMMIT comes.
+ */
+
+struct iptables_pending_s
+{
+  FAR uint8_t *buf;
+  size_t size;
+  size_t capacity;
+  unsigned int count;
+};
+
+struct iptables_restore_s
+{
+  FAR struct ipt_replace *repl;   /* Table being built, NULL outside one */
+  struct iptables_pending_s pending[NF_INET_NUMHOOKS];
+  char table[XT_TABLE_MAXNAMELEN];
+  bool noflush;                   /* Keep the rules already in the table */
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -109,6 +141,9 @@ static void iptables_showusage(FAR const char *progname, FAR void** argtable)
          progname);
   printf("       %s -t table -D chain rulenum\n", progname);
   printf("       %s -t table -[FL] [chain]\n", progname);
+#ifdef CONFIG_SYSTEM_IPTABLES_RESTORE
+  printf("       %s restore [-n] [file]\n", progname);
+#endif
   printf("iptables command:\n");
   arg_print_glossary(stdout, argtable, NULL);
 }
@@ -288,25 +323,62 @@ static int iptables_list(FAR const char *table, enum nf_inet_hooks hook)
 }
 
 /****************************************************************************
- * Name: iptables_nat_command
+ * Name: iptables_nat_check
  *
  * Description:
- *   Do a NAT command
+ *   Check that a command is supported by the NAT table
  *
  ****************************************************************************/
 
-static int iptables_nat_command(FAR const struct iptables_command_s *cmd,
-                                FAR const char *ifname)
+static int iptables_nat_check(FAR const struct iptables_args_s *args,
+                              FAR const struct iptables_command_s *cmd)
 {
-  FAR struct ipt_replace *repl = netlib_ipt_prepare(TABLE_NAME_NAT);
-  FAR struct ipt_entry *entry  = NULL;
-  int ret;
-
-  if (repl == NULL)
+  switch (cmd->cmd)
     {
-      printf("Failed to read table '" TABLE_NAME_NAT "' from kernel!\n");
-      return -EIO;
+      case COMMAND_FLUSH:
+      case COMMAND_LIST:
+        return OK;
+
+      case COMMAND_APPEND:
+      case COMMAND_INSERT:
+      case COMMAND_DELETE:
+        if (args->outifname->count == 0 &&
+            !(cmd->cmd == COMMAND_DELETE && cmd->rulenum > 0))
+          {
+            printf("Table '" TABLE_NAME_NAT "' needs an out interface!\n");
+            return -EINVAL;
+          }
+
+        if (args->target->count > 0 &&
+            strcmp(args->target->sval[0], XT_MASQUERADE_TARGET))
+          {
+            printf("Only target '" XT_MASQUERADE_TARGET
+                  "' is supported for table '" TABLE_NAME_NAT "'!\n");
+            return -EINVAL;
+          }
+
+        return OK;
+
+      default:
+        printf("No supported command specified!\n");
+        return -EINVAL;
     }
+}
+
+/****************************************************************************
+ * Name: iptables_nat_apply
+ *
+ * Description:
+ *   Apply a NAT command to a table read from the kernel
+ *
+ ****************************************************************************/
+
+static int iptables_nat_apply(FAR struct ipt_replace **repl,
+                              FAR const struct iptables_command_s *cmd,
+                              FAR const char *ifname)
+{
+  FAR struct ipt_entry *entry = NULL;
+  int ret;
 
   if (ifname && strlen(ifname) > 0) /* No ifname if we delete with rulenum. */
     {
@@ -314,23 +386,26 @@ static int iptables_nat_command(FAR const struct iptables_command_s *cmd,
       if (entry == NULL)
         {
           printf("Failed to prepare entry for dev %s!\n", ifname);
-          ret = -ENOMEM;
-          goto errout_with_repl;
+          return -ENOMEM;
         }
     }
 
   switch (cmd->cmd)
     {
       case COMMAND_APPEND:
-        ret = netlib_ipt_append(&repl, entry, cmd->hook);
+        ret = netlib_ipt_append(repl, entry, cmd->hook);
         break;
 
       case COMMAND_INSERT:
-        ret = netlib_ipt_insert(&repl, entry, cmd->hook, cmd->rulenum);
+        ret = netlib_ipt_insert(repl, entry, cmd->hook, cmd->rulenum);
         break;
 
       case COMMAND_DELETE:
-        ret = netlib_ipt_delete(repl, entry, cmd->hook, cmd->rulenum);
+        ret = netlib_ipt_delete(*repl, entry, cmd->hook, cmd->rulenum);
+        break;
+
+      case COMMAND_FLUSH:
+        ret = netlib_ipt_clear(*repl, cmd->hook);
         break;
 
       default: /* Other commands should not call into this function. */
@@ -338,17 +413,40 @@ static int iptables_nat_command(FAR const struct iptables_command_s *cmd,
         break;
     }
 
-  if (ret == OK)
+  if (entry)
     {
-      ret = netlib_ipt_commit(repl);
+      free(entry);
     }
 
-  if (entry)
+  return ret;
+}
+
+/****************************************************************************
+ * Name: iptables_nat_command
+ *
+ * Description:
+ *   Do a NAT command
+ *
+ ****************************************************************************/
+
+static int iptables_nat_command(FAR const struct iptables_command_s *cmd,
+                                FAR const char *ifname)
+{
+  FAR struct ipt_replace *repl = netlib_ipt_prepare(TABLE_NAME_NAT);
+  int ret;
+
+  if (repl == NULL)
     {
-      free(entry);
+      printf("Failed to read table '" TABLE_NAME_NAT "' from kernel!\n");
+      return -EIO;
+    }
+
+  ret = iptables_nat_apply(&repl, cmd, ifname);
+  if (ret == OK)
+    {
+      ret = netlib_ipt_commit(repl);
     }
 
-errout_with_repl:
   free(repl);
   return ret;
 }
@@ -364,6 +462,13 @@ errout_with_repl:
 static int iptables_nat(FAR const struct iptables_args_s *args)
 {
   struct iptables_command_s cmd = iptables_command(args);
+  int ret;
+
+  ret = iptables_nat_check(args, &cmd);
+  if (ret < 0)
+    {
+      return ret;
+    }
 
   switch (cmd.cmd)
     {
@@ -373,68 +478,415 @@ static int iptables_nat(FAR const struct iptables_args_s *args)
       case COMMAND_LIST:
         return iptables_list(TABLE_NAME_NAT, cmd.hook);
 
-      case COMMAND_APPEND:
-      case COMMAND_INSERT:
-      case COMMAND_DELETE:
-        if (args->outifname->count == 0 &&
-            !(cmd.cmd == COMMAND_DELETE && cmd.rulenum > 0))
-          {
-            printf("Table '" TABLE_NAME_NAT "' needs an out interface!\n");
-            return -EINVAL;
-          }
+      default:
+        return iptables_nat_command(&cmd, args->outifname->sval[0]);
+    }
+}
 
-        if (args->target->count > 0 &&
-            strcmp(args->target->sval[0], XT_MASQUERADE_TARGET))
-          {
-            printf("Only target '" XT_MASQUERADE_TARGET
-                  "' is supported for table '" TABLE_NAME_NAT "'!\n");
-            return -EINVAL;
-          }
+/****************************************************************************
+ * Name: iptables_args_init
+ *
+ * Description:
+ *   Allocate the argument table
+ *
+ ****************************************************************************/
 
-        return iptables_nat_command(&cmd, args->outifname->sval[0]);
+static void iptables_args_init(FAR struct iptables_args_s *args)
+{
+  args->table        = arg_str1("t", "table", "table",
+                                "table to manipulate");
+
+  args->append_chain = arg_str0("A", "append", "chain",
+                                "Append a rule to chain");
+  args->insert_chain = arg_str0("I", "insert", "chain",
+                                "Insert a rule to chain at rulenum "
+                                "(default = 1)");
+  args->delete_chain = arg_str0("D", "delete", "chain",
+                                "Delete matching rule from chain");
+  args->flush_chain  = arg_str0("F", "flush", "chain",
+                                "Delete all rules in chain or all chains");
+  args->list_chain   = arg_str0("L", "list", "chain",
+                                "List all rules in chain or all chains");
+
+  args->rulenum      = arg_int0(NULL, NULL, "rulenum",
+                                "Rule num (1=first)");
+
+  args->target       = arg_str0("j", "jump", "target", "target for rule");
+  args->outifname    = arg_str0("o", "out-interface", "dev",
+                                "output network interface name");
+
+  args->end          = arg_end(1);
 
-      default:
-        printf("No supported command specified!\n");
-        return -EINVAL;
+  /* The chain of -F or -L is optional. */
+
+  args->flush_chain->hdr.flag |= ARG_HASOPTVALUE;
+  args->list_chain->hdr.flag  |= ARG_HASOPTVALUE;
+}
+
+#ifdef CONFIG_SYSTEM_IPTABLES_RESTORE
+/****************************************************************************
+ * Name: iptables_restore_queue
+ *
+ * Description:
+ *   Queue an entry to append to a chain at the next flush of the pending
+ *   entries
+ *
+ ****************************************************************************/
+
+static int iptables_restore_queue(FAR struct iptables_restore_s *rs,
+                                  enum nf_inet_hooks hook,
+                                  FAR const struct ipt_entry *entry)
+{
+  FAR struct iptables_pending_s *pending = &rs->pending[hook];
+  FAR uint8_t *buf;
+  size_t capacity;
+
+  if ((rs->repl->valid_hooks & (1 << hook)) == 0)
+    {
+      printf("Not valid hook %d for this table!\n", hook);
+      return -EINVAL;
+    }
+
+  if (pending->size + entry->next_offset > pending->capacity)
+    {
+      capacity = MAX(pending->capacity * 2,
+                     pending->size + entry->next_offset);
+      buf = realloc(pending->buf, capacity);
+      if (buf == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      pending->buf      = buf;
+      pending->capacity = capacity;
     }
+
+  memcpy(pending->buf + pending->size, entry, entry->next_offset);
+  pending->size += entry->next_offset;
+  pending->count++;
+  return OK;
 }
 
 /****************************************************************************
- * Public Functions
+ * Name: iptables_restore_flush
+ *
+ * Description:
+ *   Put the pending entries into the table, one move per chain
+ *
  ****************************************************************************/
 
-int main(int argc, FAR char *argv[])
+static int iptables_restore_flush(FAR struct iptables_restore_s *rs)
+{
+  FAR struct iptables_pending_s *pending;
+  unsigned int hook;
+  int ret;
+
+  for (hook = 0; hook < NF_INET_NUMHOOKS; hook++)
+    {
+      pending = &rs->pending[hook];
+      ret = netlib_ipt_append_entries(&rs->repl, pending->buf,
+                                      pending->size, pending->count, hook);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      pending->size  = 0;
+      pending->count = 0;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: iptables_restore_reset
+ *
+ * Description:
+ *   Drop the table being built and the pending entries
+ *
+ ****************************************************************************/
+
+static void iptables_restore_reset(FAR struct iptables_restore_s *rs)
 {
+  unsigned int hook;
+
+  for (hook = 0; hook < NF_INET_NUMHOOKS; hook++)
+    {
+      free(rs->pending[hook].buf);
+    }
+
+  free(rs->repl);
+  memset(rs->pending, 0, sizeof(rs->pending));
+  rs->repl = NULL;
+}
+
+/****************************************************************************
+ * Name: iptables_restore_rule
+ *
+ * Description:
+ *   Apply one rule line, with the syntax of the command line without the
+ *   table, to the table being built
+ *
+ ****************************************************************************/
+
+static int iptables_restore_rule(FAR struct iptables_restore_s *rs,
+                                 FAR char *line)
+{
+  FAR char *argv[IPTABLES_RESTORE_MAXARGS];
   struct iptables_args_s args;
-  int nerrors;
-  int ret = 0;
+  struct iptables_command_s cmd;
+  FAR struct ipt_entry *entry;
+  FAR char *saveptr;
+  FAR char *token;
+  int argc = 0;
+  int ret;
 
-  args.table        = arg_str1("t", "table", "table", "table to manipulate");
+  argv[argc++] = "iptables";
+  argv[argc++] = "-t";
+  argv[argc++] = rs->table;
 
-  args.append_chain = arg_str0("A", "append", "chain",
-                               "Append a rule to chain");
-  args.insert_chain = arg_str0("I", "insert", "chain",
-                               "Insert a rule to chain at rulenum "
-                               "(default = 1)");
-  args.delete_chain = arg_str0("D", "delete", "chain",
-                               "Delete matching rule from chain");
-  args.flush_chain  = arg_str0("F", "flush", "chain",
-                               "Delete all rules in chain or all chains");
-  args.list_chain   = arg_str0("L", "list", "chain",
-                               "List all rules in chain or all chains");
+  for (token = strtok_r(line, " \t", &saveptr); token != NULL;
+       token = strtok_r(NULL, " \t", &saveptr))
+    {
+      if (argc >= IPTABLES_RESTORE_MAXARGS)
+        {
+          printf("Too many arguments\n");
+          return -E2BIG;
+        }
 
-  args.rulenum      = arg_int0(NULL, NULL, "rulenum", "Rule num (1=first)");
+      argv[argc++] = token;
+    }
 
-  args.target       = arg_str0("j", "jump", "target", "target for rule");
-  args.outifname    = arg_str0("o", "out-interface", "dev",
-                               "output network interface name");
+  iptables_args_init(&args);
+  if (arg_parse(argc, argv, (FAR void **)&args) != 0)
+    {
+      arg_print_errors(stdout, args.end, argv[0]);
+      ret = -EINVAL;
+      goto out;
+    }
 
-  args.end          = arg_end(1);
+  cmd = iptables_command(&args);
+  ret = iptables_nat_check(&args, &cmd);
+  if (ret < 0)
+    {
+      goto out;
+    }
 
-  /* The chain of -F or -L is optional. */
+  if (cmd.cmd == COMMAND_APPEND)
+    {
+      entry = netlib_ipt_masquerade_entry(args.outifname->sval[0]);
+      if (entry == NULL)
+        {
+          printf("Failed to prepare entry for dev %s!\n",
+                 args.outifname->sval[0]);
+          ret = -ENOMEM;
+          goto out;
+        }
+
+      ret = iptables_restore_queue(rs, cmd.hook, entry);
+      free(entry);
+    }
+  else if (cmd.cmd == COMMAND_LIST)
+    {
+      printf("Cannot list during a restore!\n");
+      ret = -EINVAL;
+    }
+  else
+    {
+      /* Keep the order of the rules: the appends queued so far go in
+       * before this command sees the table.
+       */
+
+      ret = iptables_restore_flush(rs);
+      if (ret == OK)
+        {
+          ret = iptables_nat_apply(&rs->repl, &cmd,
+                                   args.outifname->count > 0 ?
+                                   args.outifname->sval[0] : NULL);
+        }
+    }
+
+out:
+  arg_freetable((FAR void **)&args, sizeof(args) / sizeof(FAR void *));
+  return ret;
+}
+
+/****************************************************************************
+ * Name: iptables_restore
+ *
+ * Description:
+ *   Read tables in the iptables-save format and commit each of them to the
+ *   kernel at once, on its COMMIT line.  A table with an error is not
+ *   committed at all.
+ *
+ ****************************************************************************/
+
+static int iptables_restore(FAR FILE *stream, bool noflush)
+{
+  struct iptables_restore_s rs;
+  char line[IPTABLES_RESTORE_LINELEN];
+  FAR char *ptr;
+  int lineno = 0;
+  int ret = OK;
+
+  memset(&rs, 0, sizeof(rs));
+  rs.noflush = noflush;
+
+  while (fgets(line, sizeof(line), stream) != NULL)
+    {
+      lineno++;
+      line[strcspn(line, "\r\n")] = '\0';
+
+      ptr = line + strspn(line, " \t");
+      if (*ptr == '\0' || *ptr == '#')
+        {
+          continue;
+        }
+
+      if (*ptr == '*')
+        {
+          if (rs.repl != NULL)
+            {
+              printf("Table %s has no COMMIT\n", rs.table);
+              ret = -EINVAL;
+              break;
+            }
+
+          if (strcmp(ptr + 1, TABLE_NAME_NAT) != 0)
+            {
+              printf("Unknown table: %s\n", ptr + 1);
+              ret = -EINVAL;
+              break;
+            }
+
+          strlcpy(rs.table, ptr + 1, sizeof(rs.table));
+          rs.repl = netlib_ipt_prepare(rs.table);
+          if (rs.repl == NULL)
+            {
+              printf("Failed to read table %s from kernel!\n", rs.table);
+              ret = -EIO;
+              break;
+            }
+
+          if (!rs.noflush)
+            {
+              ret = netlib_ipt_clear(rs.repl, NF_INET_NUMHOOKS);
+            }
+        }
+      else if (rs.repl == NULL)
+        {
+          printf("No table selected\n");
+          ret = -EINVAL;
+        }
+      else if (*ptr == ':')
+        {
+          /* Only the built-in chains exist, their policy is not
+           * configurable.
+           */
+        }
+      else if (strcmp(ptr, "COMMIT") == 0)
+        {
+          ret = iptables_restore_flush(&rs);
+          if (ret == OK)
+            {
+              ret = netlib_ipt_commit(rs.repl);
+            }
+
+          iptables_restore_reset(&rs);
+        }
+      else
+        {
+          ret = iptables_restore_rule(&rs, ptr);
+        }
+
+      if (ret < 0)
+        {
+          break;
+        }
+    }
+
+  if (ret < 0)
+    {
+      printf("iptables restore failed at line %d: %d\n", lineno, ret);
+    }
+  else if (rs.repl != NULL)
+    {
+      printf("Table %s has no COMMIT\n", rs.table);
+      ret = -EINVAL;
+    }
+
+  iptables_restore_reset(&rs);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: iptables_restore_main
+ *
+ * Description:
+ *   Restore tables from a file or from stdin
+ *
+ ****************************************************************************/
+
+static int iptables_restore_main(int argc, FAR char *argv[])
+{
+  FAR FILE *stream = stdin;
+  bool noflush = false;
+  int ret;
+  int i;
+
+  for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+      if (strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--noflush") == 0)
+        {
+          noflush = true;
+        }
+      else
+        {
+          printf("Unknown option: %s\n", argv[i]);
+          return -EINVAL;
+        }
+    }
+
+  if (i < argc)
+    {
+      stream = fopen(argv[i], "r");
+      if (stream == NULL)
+        {
+          ret = -errno;
+          printf("Failed to open %s: %d\n", argv[i], ret);
+          return ret;
+        }
+    }
+
+  ret = iptables_restore(stream, noflush);
+
+  if (stream != stdin)
+    {
+      fclose(stream);
+    }
+
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct iptables_args_s args;
+  int nerrors;
+  int ret = 0;
+
+#ifdef CONFIG_SYSTEM_IPTABLES_RESTORE
+  if (argc > 1 && strcmp(argv[1], "restore") == 0)
+    {
+      return iptables_restore_main(argc - 1, &argv[1]);
+    }
+#endif
 
-  args.flush_chain->hdr.flag |= ARG_HASOPTVALUE;
-  args.list_chain->hdr.flag  |= ARG_HASOPTVALUE;
+  iptables_args_init(&args);
 
   nerrors = arg_parse(argc, argv, (FAR void**)&args);
   if (nerrors != 0)
@@ -57,6 +57,49 @@
 #define BLOCKSIZE     ((1 << CONFIG_SYSTEM_LZF_BLOG) - 1)
 #define MAX_BLOCKSIZE BLOCKSIZE
 
+#ifndef CONFIG_SYSTEM_LZF_MAXJOBS
+#  define CONFIG_SYSTEM_LZF_MAXJOBS 1
+#endif
+
+/* Blocks in flight per worker: one being compressed, one read ahead */
+
+#define SLOTS_PER_JOB 2
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#if CONFIG_SYSTEM_LZF_MAXJOBS > 1
+/* One block on its way through the compression pipeline */
+
+enum lzf_slotstate_e
+{
+  SLOT_FREE = 0,                /* Can be filled by the reader */
+  SLOT_READY,                   /* Filled, waiting for a worker */
+  SLOT_BUSY,                    /* Being compressed */
+  SLOT_DONE                     /* Compressed, waiting to be written */
+};
+
+struct lzf_slot_s
+{
+  enum lzf_slotstate_e state;
+  ssize_t us;                   /* Uncompressed size */
+  ssize_t len;                  /* Size of the block with its header */
+  FAR struct lzf_header_s *header;
+  FAR uint8_t *in;              /* LZF_MAX_HDR_SIZE + g_blocksize */
+  FAR uint8_t *out;
+};
+
+struct lzf_pool_s
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  bool quit;
+  int nslots;
+  struct lzf_slot_s slots[CONFIG_SYSTEM_LZF_MAXJOBS * SLOTS_PER_JOB];
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -76,6 +119,9 @@ static enum
 static bool g_verbose;
 static bool g_force;
 static unsigned long g_blocksize;
+#if CONFIG_SYSTEM_LZF_MAXJOBS > 1
+static int g_njobs;
+#endif
 static lzf_state_t g_htab;
 static uint8_t g_buf1[MAX_BLOCKSIZE + LZF_MAX_HDR_SIZE + 16];
 static uint8_t g_buf2[MAX_BLOCKSIZE + LZF_MAX_HDR_SIZE + 16];
@@ -104,14 +150,21 @@ static void usage(int ret)
           " You can find more info at\n"
           "http://liblzf.plan9.de/\n"
           "\n"
-          "usage: lzf [-dufhvb] [file ...]\n\n"
+          "usage: lzf [-dufhvbj] [file ...]\n\n"
           "-c   Compress\n"
           "-d   Decompress\n"
           "-f   Force overwrite of output file\n"
           "-h   Give this help\n"
           "-v   Verbose mode\n"
           "-b # Set blocksize (max %lu)\n"
-          "\n", (unsigned long)MAX_BLOCKSIZE);
+#if CONFIG_SYSTEM_LZF_MAXJOBS > 1
+          "-j # Compress with # threads (max %d)\n"
+#endif
+          "\n", (unsigned long)MAX_BLOCKSIZE
+#if CONFIG_SYSTEM_LZF_MAXJOBS > 1
+          , CONFIG_SYSTEM_LZF_MAXJOBS
+#endif
+          );
 
   lzf_exit(ret);
 }
@@ -163,6 +216,208 @@ static inline ssize_t wwrite(int fd, void *buf, size_t len)
   return 0;
 }
 
+#if CONFIG_SYSTEM_LZF_MAXJOBS > 1
+/* Worker thread: compress the blocks that the reader has filled.  Each
+ * worker has a hash table of its own, so the blocks are independent and
+ * the output is the same as when compressing on one thread.
+ */
+
+static FAR void *compress_worker(FAR void *arg)
+{
+  FAR struct lzf_pool_s *pool = arg;
+  FAR struct lzf_slot_s *slot;
+  FAR lzf_state_t *htab;
+  int i;
+
+  htab = malloc(sizeof(lzf_state_t));
+  if (htab == NULL)
+    {
+      return NULL;
+    }
+
+  pthread_mutex_lock(&pool->lock);
+  for (; ; )
+    {
+      slot = NULL;
+      for (i = 0; i < pool->nslots; i++)
+        {
+          if (pool->slots[i].state == SLOT_READY)
+            {
+              slot = &pool->slots[i];
+              break;
+            }
+        }
+
+      if (slot == NULL)
+        {
+          if (pool->quit)
+            {
+              break;
+            }
+
+          pthread_cond_wait(&pool->cond, &pool->lock);
+          continue;
+        }
+
+      slot->state = SLOT_BUSY;
+      pthread_mutex_unlock(&pool->lock);
+
+      slot->len = lzf_compress(&slot->in[LZF_MAX_HDR_SIZE], slot->us,
+                               &slot->out[LZF_MAX_HDR_SIZE],
+                               slot->us > 4 ? slot->us - 4 : slot->us,
+                               *htab, &slot->header);
+
+      pthread_mutex_lock(&pool->lock);
+      slot->state = SLOT_DONE;
+      pthread_cond_broadcast(&pool->cond);
+    }
+
+  pthread_mutex_unlock(&pool->lock);
+  free(htab);
+  return NULL;
+}
+
+/* Compress with g_njobs worker threads.  The calling thread reads blocks
+ * ahead into free slots and writes the compressed blocks in their
+ * original order.  Returns 0 if all written, -1 on a write error or 1 if
+ * the workers could not be set up, so that the caller can fall back to
+ * compress_fd().
+ */
+
+static int compress_fd_parallel(int from, int to)
+{
+  FAR struct lzf_pool_s *pool;
+  FAR struct lzf_slot_s *slot;
+  pthread_t workers[CONFIG_SYSTEM_LZF_MAXJOBS];
+  unsigned long nread = 0;
+  unsigned long nwritten = 0;
+  size_t bufsize;
+  bool eof = false;
+  int nworkers = 0;
+  int ret = 1;
+  int i;
+
+  pool = calloc(1, sizeof(*pool));
+  if (pool == NULL)
+    {
+      return 1;
+    }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->cond, NULL);
+
+  pool->nslots = g_njobs * SLOTS_PER_JOB;
+  bufsize      = g_blocksize + LZF_MAX_HDR_SIZE + 16;
+
+  for (i = 0; i < pool->nslots; i++)
+    {
+      pool->slots[i].in  = malloc(bufsize);
+      pool->slots[i].out = malloc(bufsize);
+      if (pool->slots[i].in == NULL || pool->slots[i].out == NULL)
+        {
+          goto errout;
+        }
+    }
+
+  for (i = 0; i < g_njobs; i++)
+    {
+      if (pthread_create(&workers[nworkers], NULL, compress_worker,
+                         pool) == 0)
+        {
+          nworkers++;
+        }
+    }
+
+  if (nworkers == 0)
+    {
+      goto errout;
+    }
+
+  ret = 0;
+  g_nread = g_nwritten = 0;
+
+  for (; ; )
+    {
+      /* Read ahead into the free slots */
+
+      while (!eof && nread - nwritten < (unsigned long)pool->nslots)
+        {
+          slot = &pool->slots[nread % pool->nslots];
+          slot->us = rread(from, &slot->in[LZF_MAX_HDR_SIZE], g_blocksize);
+          if (slot->us <= 0)
+            {
+              eof = true;
+              break;
+            }
+
+          pthread_mutex_lock(&pool->lock);
+          slot->state = SLOT_READY;
+          pthread_cond_broadcast(&pool->cond);
+          pthread_mutex_unlock(&pool->lock);
+          nread++;
+        }
+
+      if (nwritten == nread)
+        {
+          break;
+        }
+
+      /* Write the oldest block once it is compressed */
+
+      slot = &pool->slots[nwritten % pool->nslots];
+
+      pthread_mutex_lock(&pool->lock);
+      while (slot->state != SLOT_DONE)
+        {
+          pthread_cond_wait(&pool->cond, &pool->lock);
+        }
+
+      pthread_mutex_unlock(&pool->lock);
+
+      if (wwrite(to, slot->header, slot->len) == -1)
+        {
+          ret = -1;
+          break;
+        }
+
+      slot->state = SLOT_FREE;
+      nwritten++;
+    }
+
+  /* On a write error, the workers finish the blocks they have */
+
+  pthread_mutex_lock(&pool->lock);
+  pool->quit = true;
+  for (i = 0; i < pool->nslots; i++)
+    {
+      if (pool->slots[i].state == SLOT_READY)
+        {
+          pool->slots[i].state = SLOT_FREE;
+        }
+    }
+
+  pthread_cond_broadcast(&pool->cond);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (i = 0; i < nworkers; i++)
+    {
+      pthread_join(workers[i], NULL);
+    }
+
+errout:
+  for (i = 0; i < pool->nslots; i++)
+    {
+      free(pool->slots[i].in);
+      free(pool->slots[i].out);
+    }
+
+  pthread_cond_destroy(&pool->cond);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool);
+  return ret;
+}
+#endif
+
 /* Anatomy: an lzf file consists of any number of blocks
  *          in the following format:
  *
@@ -178,6 +433,19 @@ static int compress_fd(int from, int to)
   ssize_t us;
   ssize_t len;
 
+#if CONFIG_SYSTEM_LZF_MAXJOBS > 1
+  if (g_njobs > 1)
+    {
+      int ret = compress_fd_parallel(from, to);
+      if (ret <= 0)
+        {
+          return ret;
+        }
+
+      fprintf(stderr, "%s: no threads, compressing on one\n", g_imagename);
+    }
+#endif
+
   g_nread = g_nwritten = 0;
   while ((us = rread(from, &g_buf1[LZF_MAX_HDR_SIZE], g_blocksize)) > 0)
     {
@@ -472,6 +740,9 @@ int main(int argc, FAR char *argv[])
   g_verbose   = false;
   g_force     = 0;
   g_blocksize = BLOCKSIZE;
+#if CONFIG_SYSTEM_LZF_MAXJOBS > 1
+  g_njobs     = 1;
+#endif
 
 #ifndef CONFIG_DISABLE_ENVIRON
   /* Block size may be specified as an environment variable */
@@ -494,7 +765,7 @@ int main(int argc, FAR char *argv[])
 
   /* Handle command line options */
 
-  while ((optc = getopt(argc, argv, "cdfhvb:")) != -1)
+  while ((optc = getopt(argc, argv, "cdfhvb:j:")) != -1)
     {
       switch (optc)
         {
@@ -527,6 +798,17 @@ int main(int argc, FAR char *argv[])
 
             break;
 
+#if CONFIG_SYSTEM_LZF_MAXJOBS > 1
+          case 'j':
+            g_njobs = strtoul(optarg, 0, 0);
+            if (g_njobs < 1 || g_njobs > CONFIG_SYSTEM_LZF_MAXJOBS)
+              {
+                g_njobs = CONFIG_SYSTEM_LZF_MAXJOBS;
+              }
+
+            break;
+#endif
+
           default:
             usage(1);
             break;
@@ -0,0 +1,377 @@
+/****************************************************************************
+ * apps/system/lzf/lzf_stream.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "system/lzfstream.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef MIN
+#  define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: lzf_stream_compress
+ *
+ * Description:
+ *   Compress the collected input block.  The block stays stored if it does
+ *   not get smaller, in which case lzf_compress() puts the header in front
+ *   of the input in inbuf.
+ *
+ ****************************************************************************/
+
+static void lzf_stream_compress(FAR struct lzf_stream_s *stream)
+{
+  FAR struct lzf_header_s *header;
+  size_t us = stream->inlen;
+
+  stream->outlen = lzf_compress(&stream->inbuf[LZF_MAX_HDR_SIZE], us,
+                                &stream->outbuf[LZF_MAX_HDR_SIZE],
+                                us > 4 ? us - 4 : us, *stream->htab,
+                                &header);
+  stream->outptr = (FAR uint8_t *)header;
+  stream->inlen  = 0;
+}
+
+/****************************************************************************
+ * Name: lzf_stream_header
+ *
+ * Description:
+ *   Take one byte of a block header.  Format:
+ *
+ *   \x00   End of stream
+ *   "ZV\0" 2-byte-usize <uncompressed data>
+ *   "ZV\1" 2-byte-csize 2-byte-usize <compressed data>
+ *
+ ****************************************************************************/
+
+static int lzf_stream_header(FAR struct lzf_stream_s *stream, uint8_t ch)
+{
+  size_t hdrsize;
+
+  if (stream->hdrlen == 0 && ch == 0)
+    {
+      stream->eof = true;
+      return OK;
+    }
+
+  if ((stream->hdrlen == 0 && ch != 'Z') ||
+      (stream->hdrlen == 1 && ch != 'V'))
+    {
+      return -EINVAL;
+    }
+
+  stream->hdr[stream->hdrlen++] = ch;
+  if (stream->hdrlen < 3)
+    {
+      return OK;
+    }
+
+  switch (stream->hdr[2])
+    {
+      case 0:
+        hdrsize = LZF_TYPE0_HDR_SIZE;
+        break;
+
+      case 1:
+        hdrsize = LZF_TYPE1_HDR_SIZE;
+        break;
+
+      default:
+        return -EINVAL;
+    }
+
+  if (stream->hdrlen < hdrsize)
+    {
+      return OK;
+    }
+
+  if (hdrsize == LZF_TYPE0_HDR_SIZE)
+    {
+      stream->cs = 0;
+      stream->us = (stream->hdr[3] << 8) | stream->hdr[4];
+    }
+  else
+    {
+      stream->cs = (stream->hdr[3] << 8) | stream->hdr[4];
+      stream->us = (stream->hdr[5] << 8) | stream->hdr[6];
+    }
+
+  if (stream->us > stream->blocksize || stream->cs > stream->blocksize)
+    {
+      return -E2BIG;
+    }
+
+  stream->hdrlen = 0;
+  stream->inlen  = 0;
+  stream->inneed = stream->cs != 0 ? stream->cs : stream->us;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: lzf_stream_decompress
+ ****************************************************************************/
+
+static int lzf_stream_decompress(FAR struct lzf_stream_s *stream)
+{
+  stream->inneed = 0;
+  stream->inlen  = 0;
+
+  if (stream->cs == 0)
+    {
+      stream->outptr = stream->inbuf;
+    }
+  else
+    {
+      if (lzf_decompress(stream->inbuf, stream->cs,
+                         stream->outbuf, stream->us) != stream->us)
+        {
+          return -EINVAL;
+        }
+
+      stream->outptr = stream->outbuf;
+    }
+
+  stream->outlen = stream->us;
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: lzf_stream_memsize
+ ****************************************************************************/
+
+size_t lzf_stream_memsize(int mode, size_t blocksize)
+{
+  if (mode == LZF_STREAM_COMPRESS)
+    {
+      return sizeof(lzf_state_t) +
+             2 * (LZF_MAX_HDR_SIZE + blocksize) + 16;
+    }
+
+  return 2 * blocksize;
+}
+
+/****************************************************************************
+ * Name: lzf_stream_init
+ ****************************************************************************/
+
+int lzf_stream_init(FAR struct lzf_stream_s *stream, int mode,
+                    size_t blocksize, FAR void *mem)
+{
+  FAR uint8_t *ptr;
+
+  if ((mode != LZF_STREAM_COMPRESS && mode != LZF_STREAM_DECOMPRESS) ||
+      blocksize == 0 || blocksize > LZF_STREAM_MAXBLOCK)
+    {
+      return -EINVAL;
+    }
+
+  memset(stream, 0, sizeof(*stream));
+  stream->mode      = mode;
+  stream->blocksize = blocksize;
+
+  if (mem == NULL)
+    {
+      mem = malloc(lzf_stream_memsize(mode, blocksize));
+      if (mem == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      stream->alloc = true;
+    }
+
+  stream->mem = mem;
+  ptr = mem;
+
+  if (mode == LZF_STREAM_COMPRESS)
+    {
+      stream->htab   = (FAR lzf_state_t *)ptr;
+      ptr           += sizeof(lzf_state_t);
+      stream->inbuf  = ptr;
+      stream->outbuf = ptr + LZF_MAX_HDR_SIZE + blocksize;
+    }
+  else
+    {
+      stream->inbuf  = ptr;
+      stream->outbuf = ptr + blocksize;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: lzf_stream_push
+ ****************************************************************************/
+
+ssize_t lzf_stream_push(FAR struct lzf_stream_s *stream,
+                        FAR const void *buf, size_t len)
+{
+  FAR const uint8_t *src = buf;
+  size_t taken = 0;
+  size_t nbytes;
+  int ret;
+
+  if (stream->error < 0)
+    {
+      return stream->error;
+    }
+
+  if (stream->flush)
+    {
+      return -EINVAL;
+    }
+
+  if (stream->mode == LZF_STREAM_COMPRESS)
+    {
+      while (taken < len && stream->outlen == 0)
+        {
+          nbytes = MIN(len - taken, stream->blocksize - stream->inlen);
+          memcpy(&stream->inbuf[LZF_MAX_HDR_SIZE + stream->inlen],
+                 &src[taken], nbytes);
+          stream->inlen += nbytes;
+          taken         += nbytes;
+
+          if (stream->inlen == stream->blocksize)
+            {
+              lzf_stream_compress(stream);
+            }
+        }
+
+      return taken;
+    }
+
+  while (taken < len && stream->outlen == 0)
+    {
+      if (stream->eof)
+        {
+          /* Anything after the end of stream marker is ignored */
+
+          return len;
+        }
+
+      if (stream->inneed == 0)
+        {
+          ret = lzf_stream_header(stream, src[taken++]);
+          if (ret < 0)
+            {
+              stream->error = ret;
+              return ret;
+            }
+
+          continue;
+        }
+
+      nbytes = MIN(len - taken, stream->inneed - stream->inlen);
+      memcpy(&stream->inbuf[stream->inlen], &src[taken], nbytes);
+      stream->inlen += nbytes;
+      taken         += nbytes;
+
+      if (stream->inlen == stream->inneed)
+        {
+          ret = lzf_stream_decompress(stream);
+          if (ret < 0)
+            {
+              stream->error = ret;
+              return ret;
+            }
+        }
+    }
+
+  return taken;
+}
+
+/****************************************************************************
+ * Name: lzf_stream_pull
+ ****************************************************************************/
+
+ssize_t lzf_stream_pull(FAR struct lzf_stream_s *stream,
+                        FAR void *buf, size_t len)
+{
+  size_t nbytes;
+
+  if (stream->error < 0)
+    {
+      return stream->error;
+    }
+
+  if (stream->outlen == 0 && stream->flush && stream->inlen > 0 &&
+      stream->mode == LZF_STREAM_COMPRESS)
+    {
+      lzf_stream_compress(stream);
+    }
+
+  nbytes = MIN(len, stream->outlen);
+  memcpy(buf, stream->outptr, nbytes);
+  stream->outptr += nbytes;
+  stream->outlen -= nbytes;
+
+  return nbytes;
+}
+
+/****************************************************************************
+ * Name: lzf_stream_finish
+ ****************************************************************************/
+
+int lzf_stream_finish(FAR struct lzf_stream_s *stream)
+{
+  stream->flush = true;
+
+  if (stream->mode == LZF_STREAM_DECOMPRESS &&
+      (stream->inneed > 0 || stream->hdrlen > 0))
+    {
+      return -EINVAL;
+    }
+
+  return stream->error;
+}
+
+/****************************************************************************
+ * Name: lzf_stream_deinit
+ ****************************************************************************/
+
+void lzf_stream_deinit(FAR struct lzf_stream_s *stream)
+{
+  if (stream->alloc)
+    {
+      free(stream->mem);
+    }
+
+  memset(stream, 0, sizeof(*stream));
+}
@@ -69,7 +69,7 @@
  * pan_display
  ****************************************************************************/
 
-static void pan_display(int fb_device, FAR struct fb_planeinfo_s *plane_info)
+static bool pan_display(int fb_device, FAR struct fb_planeinfo_s *plane_info)
 {
   struct pollfd pfd;
   int ret;
@@ -81,8 +81,118 @@ static void pan_display(int fb_device, FAR struct fb_planeinfo_s *plane_info)
   if (ret > 0)
     {
       ioctl(fb_device, FBIOPAN_DISPLAY, plane_info);
+      return true;
     }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: nxcamera_qbuf
+ *
+ *   Queue a buffer for capturing, either one mapped from the driver or, in
+ *   zero-copy mode, a framebuffer page.
+ *
+ ****************************************************************************/
+
+static int nxcamera_qbuf(FAR struct nxcamera_s *pcam, int index)
+{
+  struct v4l2_buffer buf;
+
+  memset(&buf, 0, sizeof(buf));
+  buf.type  = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.index = index;
+
+#ifdef CONFIG_NXCAMERA_ZEROCOPY
+  if (pcam->zerocopy)
+    {
+      buf.memory    = V4L2_MEMORY_USERPTR;
+      buf.m.userptr = (uintptr_t)pcam->bufs[index];
+      buf.length    = pcam->buf_sizes[index];
+    }
+  else
+#endif
+    {
+      buf.memory = V4L2_MEMORY_MMAP;
+    }
+
+  if (ioctl(pcam->capture_fd, VIDIOC_QBUF, (uintptr_t)&buf) < 0)
+    {
+      return -errno;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxcamera_showpage
+ *
+ *   Zero-copy display: the frame was captured into a framebuffer page, so
+ *   showing it is panning to it.  The page shown before is handed back to
+ *   the capture driver, the one on screen is kept.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXCAMERA_ZEROCOPY
+static int nxcamera_showpage(FAR struct nxcamera_s *pcam, int index)
+{
+  int requeue;
+
+  if (pcam->nbuffers == 1)
+    {
+      /* A single page is always on screen and captured into */
+
+      return nxcamera_qbuf(pcam, index);
+    }
+
+  pcam->display_pinfo.yoffset = index * pcam->display_vinfo.yres;
+  if (!pan_display(pcam->display_fd, &pcam->display_pinfo))
+    {
+      /* The display is busy, this frame is dropped */
+
+      return nxcamera_qbuf(pcam, index);
+    }
+
+  requeue = pcam->displayed;
+  pcam->displayed = index;
+  return requeue >= 0 ? nxcamera_qbuf(pcam, requeue) : OK;
+}
+
+/****************************************************************************
+ * Name: nxcamera_setzerocopy
+ *
+ *   Decide whether frames in the negotiated format can be captured straight
+ *   into the framebuffer, one framebuffer page per capture buffer.
+ *
+ ****************************************************************************/
+
+static bool nxcamera_setzerocopy(FAR struct nxcamera_s *pcam)
+{
+  FAR struct fb_planeinfo_s *pinfo = &pcam->display_pinfo;
+  size_t pagesize = pinfo->stride * pcam->display_vinfo.yres;
+
+  /* The capture has to be exactly in the layout of the screen */
+
+  if (pcam->fmt.fmt.pix.pixelformat != V4L2_PIX_FMT_RGB565 ||
+      pcam->display_vinfo.fmt != FB_FMT_RGB16_565 ||
+      pcam->fmt.fmt.pix.width * 2 != pinfo->stride ||
+      pcam->fmt.fmt.pix.height > pcam->display_vinfo.yres)
+    {
+      return false;
+    }
+
+  /* The capture DMA wants 32 byte aligned buffers */
+
+  if (((uintptr_t)pinfo->fbmem | pagesize) % 32 != 0)
+    {
+      return false;
+    }
+
+  pcam->fbpages = MAX(pinfo->yres_virtual / pcam->display_vinfo.yres, 1);
+  pcam->fbpages = MIN(pcam->fbpages, pinfo->fblen / pagesize);
+  return pcam->fbpages > 0;
 }
+#endif
 
 static int show_image(FAR struct nxcamera_s *pcam, FAR v4l2_buffer_t *buf)
 {
@@ -124,12 +234,20 @@ static int show_image(FAR struct nxcamera_s *pcam, FAR v4l2_buffer_t *buf)
         }
       else
         {
-          int ret;
-          FAR uint8_t *dst = malloc(pcam->fmt.fmt.pix.width *
-                                    pcam->fmt.fmt.pix.height * 3 / 2);
-          if (!dst)
+          FAR uint8_t *dst = pcam->convbuf;
+
+          /* Kept for the stream, this runs for every frame */
+
+          if (dst == NULL)
             {
-              return -ENOMEM;
+              dst = malloc(pcam->fmt.fmt.pix.width *
+                           pcam->fmt.fmt.pix.height * 3 / 2);
+              if (dst == NULL)
+                {
+                  return -ENOMEM;
+                }
+
+              pcam->convbuf = dst;
             }
 
           ret = ConvertToI420(pcam->bufs[buf->index],
@@ -152,10 +270,10 @@ static int show_image(FAR struct nxcamera_s *pcam, FAR v4l2_buffer_t *buf)
                               pcam->fmt.fmt.pix.pixelformat);
           if (ret < 0)
             {
-              goto err;
+              return ret;
             }
 
-          ret = ConvertFromI420(dst,
+          return ConvertFromI420(dst,
                                 pcam->fmt.fmt.pix.width,
                                 &dst[pcam->fmt.fmt.pix.width *
                                             pcam->fmt.fmt.pix.height],
@@ -168,14 +286,6 @@ static int show_image(FAR struct nxcamera_s *pcam, FAR v4l2_buffer_t *buf)
                                 pcam->fmt.fmt.pix.width,
                                 pcam->fmt.fmt.pix.height,
                                 V4L2_PIX_FMT_RGB565);
-          if (ret < 0)
-            {
-              goto err;
-            }
-
-err:
-          free(dst);
-          return ret;
         }
     }
 
@@ -314,13 +424,9 @@ static void *nxcamera_loopthread(pthread_addr_t pvarg)
   uint32_t                type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
   vinfo("Entry\n");
-  memset(&buf, 0, sizeof(buf));
   for (i = 0; i < pcam->nbuffers; i++)
     {
-      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-      buf.memory = V4L2_MEMORY_MMAP;
-      buf.index = i;
-      ret = ioctl(pcam->capture_fd, VIDIOC_QBUF, (uintptr_t)&buf);
+      ret = nxcamera_qbuf(pcam, i);
       if (ret < 0)
         {
           verr("VIDIOC_QBUF failed: %d\n", ret);
@@ -328,6 +434,16 @@ static void *nxcamera_loopthread(pthread_addr_t pvarg)
         }
     }
 
+  memset(&buf, 0, sizeof(buf));
+  buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = V4L2_MEMORY_MMAP;
+#ifdef CONFIG_NXCAMERA_ZEROCOPY
+  if (pcam->zerocopy)
+    {
+      buf.memory = V4L2_MEMORY_USERPTR;
+    }
+#endif
+
   /* VIDIOC_STREAMON start stream */
 
   ret = ioctl(pcam->capture_fd, VIDIOC_STREAMON, (uintptr_t)&type);
@@ -394,6 +510,20 @@ static void *nxcamera_loopthread(pthread_addr_t pvarg)
           goto err_out;
         }
 
+#ifdef CONFIG_NXCAMERA_ZEROCOPY
+      if (pcam->zerocopy)
+        {
+          ret = nxcamera_showpage(pcam, buf.index);
+          if (ret < 0)
+            {
+              verr("Fail QBUF %d\n", -ret);
+              goto err_out;
+            }
+
+          continue;
+        }
+#endif
+
       ret = show_image(pcam, &buf);
       if (ret < 0)
         {
@@ -430,13 +560,20 @@ err_out:
   mq_close(pcam->mq);                /* Close the message queue */
   mq_unlink(pcam->mqname);           /* Unlink the message queue */
   pcam->loopstate = NXCAMERA_STATE_IDLE;
-  for (i = 0; i < pcam->nbuffers; i++)
+#ifdef CONFIG_NXCAMERA_ZEROCOPY
+  if (!pcam->zerocopy)
+#endif
     {
-      munmap(pcam->bufs[i], pcam->buf_sizes[i]);
+      for (i = 0; i < pcam->nbuffers; i++)
+        {
+          munmap(pcam->bufs[i], pcam->buf_sizes[i]);
+        }
     }
 
   free(pcam->bufs);
   free(pcam->buf_sizes);
+  free(pcam->convbuf);
+  pcam->convbuf = NULL;
   pthread_mutex_unlock(&pcam->mutex);     /* Unlock the mutex */
 
   vinfo("Exit\n");
@@ -726,25 +863,50 @@ int nxcamera_stream(FAR struct nxcamera_s *pcam,
       return ret;
     }
 
-  /* VIDIOC_REQBUFS initiate user pointer I/O */
-
   memset(&req, 0, sizeof(req));
   req.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  req.memory = V4L2_MEMORY_MMAP;
-  req.count  = CONFIG_VIDEO_REQBUFS_COUNT_MAX;
 
-  ret = ioctl(pcam->capture_fd, VIDIOC_REQBUFS, (uintptr_t)&req);
-  if (ret < 0)
+#ifdef CONFIG_NXCAMERA_ZEROCOPY
+  /* VIDIOC_REQBUFS initiate user pointer I/O into the framebuffer, if the
+   * frames can be shown as they are captured and the driver can do it.
+   */
+
+  pcam->zerocopy  = nxcamera_setzerocopy(pcam);
+  pcam->displayed = -1;
+  if (pcam->zerocopy)
     {
-      ret = -errno;
-      verr("VIDIOC_REQBUFS failed: %d\n", ret);
-      return ret;
+      req.memory = V4L2_MEMORY_USERPTR;
+      req.count  = MIN(pcam->fbpages, CONFIG_VIDEO_REQBUFS_COUNT_MAX);
+
+      if (ioctl(pcam->capture_fd, VIDIOC_REQBUFS, (uintptr_t)&req) < 0 ||
+          req.count < 1)
+        {
+          vwarn("No user pointer I/O, capturing to mapped buffers\n");
+          pcam->zerocopy = false;
+        }
     }
 
-  if (req.count < 2)
+  if (!pcam->zerocopy)
+#endif
     {
-      verr("VIDIOC_REQBUFS failed: not enough buffers\n");
-      return -ENOMEM;
+      /* VIDIOC_REQBUFS initiate mapped buffer I/O */
+
+      req.memory = V4L2_MEMORY_MMAP;
+      req.count  = CONFIG_VIDEO_REQBUFS_COUNT_MAX;
+
+      ret = ioctl(pcam->capture_fd, VIDIOC_REQBUFS, (uintptr_t)&req);
+      if (ret < 0)
+        {
+          ret = -errno;
+          verr("VIDIOC_REQBUFS failed: %d\n", ret);
+          return ret;
+        }
+
+      if (req.count < 2)
+        {
+          verr("VIDIOC_REQBUFS failed: not enough buffers\n");
+          return -ENOMEM;
+        }
     }
 
   pcam->nbuffers  = req.count;
@@ -761,6 +923,20 @@ int nxcamera_stream(FAR struct nxcamera_s *pcam,
 
   for (i = 0; i < req.count; i++)
     {
+#ifdef CONFIG_NXCAMERA_ZEROCOPY
+      if (pcam->zerocopy)
+        {
+          /* One page of the framebuffer per buffer */
+
+          pcam->bufs[i]      = (FAR uint8_t *)pcam->display_pinfo.fbmem +
+                               i * pcam->display_pinfo.stride *
+                               pcam->display_vinfo.yres;
+          pcam->buf_sizes[i] = pcam->display_pinfo.stride *
+                               pcam->fmt.fmt.pix.height;
+          continue;
+        }
+#endif
+
       memset(&buf, 0, sizeof(buf));
       buf.type   = req.type;
       buf.memory = V4L2_MEMORY_MMAP;
@@ -839,7 +1015,11 @@ int nxcamera_stream(FAR struct nxcamera_s *pcam,
   return OK;
 
 err_out:
+#ifdef CONFIG_NXCAMERA_ZEROCOPY
+  if (pcam->bufs && !pcam->zerocopy)
+#else
   if (pcam->bufs)
+#endif
     {
       for (i = 0; i < pcam->nbuffers; i++)
         {
@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <time.h>
 #include <sys/ioctl.h>
 #include <sys/param.h>
 #include <sys/types.h>
@@ -57,6 +58,16 @@
 #define AUDIO_APB_RECORD         (1 << 4)
 #define AUDIO_APB_PLAY           (1 << 5)
 
+#define NXLOOPER_LATENCY_IDLE     0
+#define NXLOOPER_LATENCY_REQUEST  1
+#define NXLOOPER_LATENCY_INJECTED 2
+
+/* Frames in the test pulse.  A single sample is smoothed away by the codec
+ * filters.
+ */
+
+#define NXLOOPER_PULSE_FRAMES     8
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -306,6 +317,166 @@ static int nxlooper_enqueueplaybuffer(FAR struct nxlooper_s *plooper,
   return OK;
 }
 
+/****************************************************************************
+ * Name: nxlooper_setbufferinfo
+ *
+ *   Ask the device for period sized buffers, doubling the size until the
+ *   device accepts it.  info is left with what is to be allocated.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+static void nxlooper_setbufferinfo(FAR struct nxlooper_s *plooper, int fd,
+                                   FAR struct ap_buffer_info_s *info)
+{
+  struct ap_buffer_info_s dflt;
+  size_t size;
+
+  if (ioctl(fd, AUDIOIOC_GETBUFFERINFO, (unsigned long)&dflt) != OK)
+    {
+      dflt.buffer_size = CONFIG_AUDIO_BUFFER_NUMBYTES;
+      dflt.nbuffers    = CONFIG_AUDIO_NUM_BUFFERS;
+    }
+
+  info->nbuffers = plooper->nbuffers;
+  for (size = plooper->period * plooper->framesize;
+       size < dflt.buffer_size; size *= 2)
+    {
+      info->buffer_size = size;
+      if (ioctl(fd, AUDIOIOC_SETBUFFERINFO, (unsigned long)info) == OK)
+        {
+          return;
+        }
+      else if (errno == ENOTTY)
+        {
+          /* The driver has no say, it works with what it is given */
+
+          return;
+        }
+    }
+
+  /* Nothing smaller than the default was accepted */
+
+  *info = dflt;
+}
+#endif
+
+/****************************************************************************
+ * Name: nxlooper_putpulse
+ *
+ *   Write the test pulse over the start of a play buffer.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+static void nxlooper_putpulse(FAR struct nxlooper_s *plooper,
+                              FAR struct ap_buffer_s *apb)
+{
+  size_t nsamples = apb->nbytes / (plooper->bpsamp / 8);
+  size_t x;
+
+  nsamples = MIN(nsamples, NXLOOPER_PULSE_FRAMES * plooper->nchannels);
+  for (x = 0; x < nsamples; x++)
+    {
+      if (plooper->bpsamp == 16)
+        {
+          ((FAR int16_t *)apb->samp)[x] = INT16_MAX;
+        }
+      else
+        {
+          ((FAR int32_t *)apb->samp)[x] = INT32_MAX;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxlooper_findpulse
+ *
+ *   Return the frame of a record buffer the test pulse starts in, or -1.
+ *
+ ****************************************************************************/
+
+static int nxlooper_findpulse(FAR struct nxlooper_s *plooper,
+                              FAR struct ap_buffer_s *apb)
+{
+  size_t nsamples = apb->nbytes / (plooper->bpsamp / 8);
+  int32_t threshold;
+  int32_t sample;
+  size_t x;
+
+  threshold = plooper->bpsamp == 16 ? INT16_MAX : INT32_MAX;
+  threshold = threshold / 100 * CONFIG_NXLOOPER_LATENCY_THRESHOLD;
+
+  for (x = 0; x < nsamples; x++)
+    {
+      if (plooper->bpsamp == 16)
+        {
+          sample = ((FAR int16_t *)apb->samp)[x];
+        }
+      else
+        {
+          sample = ((FAR int32_t *)apb->samp)[x];
+        }
+
+      /* Either polarity, the path may invert */
+
+      if (sample > threshold || sample < -threshold)
+        {
+          return x / plooper->nchannels;
+        }
+    }
+
+  return -1;
+}
+
+/****************************************************************************
+ * Name: nxlooper_latencydone
+ ****************************************************************************/
+
+static void nxlooper_latencydone(FAR struct nxlooper_s *plooper,
+                                 int32_t result)
+{
+  plooper->latency       = result;
+  plooper->latency_state = NXLOOPER_LATENCY_IDLE;
+  sem_post(&plooper->latency_sem);
+}
+
+/****************************************************************************
+ * Name: nxlooper_detectpulse
+ *
+ *   Look for the test pulse in a record buffer just dequeued.  The
+ *   latency runs from when the pulse was enqueued for playing to when it
+ *   was captured; the buffer was complete on dequeue, so the frames after
+ *   the pulse were captured later than it was.
+ *
+ ****************************************************************************/
+
+static void nxlooper_detectpulse(FAR struct nxlooper_s *plooper,
+                                 FAR struct ap_buffer_s *apb,
+                                 FAR const struct timespec *inject)
+{
+  struct timespec now;
+  int64_t usec;
+  int frame;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  usec = (int64_t)(now.tv_sec - inject->tv_sec) * 1000000 +
+         (now.tv_nsec - inject->tv_nsec) / 1000;
+
+  frame = nxlooper_findpulse(plooper, apb);
+  if (frame >= 0)
+    {
+      usec -= (int64_t)(apb->nbytes / plooper->framesize - frame) *
+              1000000 / plooper->samprate;
+      nxlooper_latencydone(plooper, usec > 0 ? usec : 0);
+    }
+  else if (usec > CONFIG_NXLOOPER_LATENCY_TIMEOUT * 1000)
+    {
+      nxlooper_latencydone(plooper, -ETIMEDOUT);
+    }
+}
+#endif /* CONFIG_NXLOOPER_LATENCY_TEST */
+
 /****************************************************************************
  * Name: nxlooper_jointhread
  ****************************************************************************/
@@ -358,6 +529,9 @@ static void *nxlooper_loopthread(pthread_addr_t pvarg)
   FAR struct ap_buffer_s  **recordbufs = NULL;
   unsigned int            prio;
   ssize_t                 size;
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+  struct timespec         inject;
+#endif
   int                     running = 2;
   bool                    streaming = true;
   int                     x;
@@ -369,6 +543,13 @@ static void *nxlooper_loopthread(pthread_addr_t pvarg)
 
   /* Query the audio device for it's preferred buffer size / qty */
 
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+  if (plooper->period > 0)
+    {
+      recordbuf_info = plooper->recordinfo;
+    }
+  else
+#endif
   if ((ret = ioctl(plooper->recorddev_fd, AUDIOIOC_GETBUFFERINFO,
                    (unsigned long)&recordbuf_info)) != OK)
     {
@@ -426,6 +607,13 @@ static void *nxlooper_loopthread(pthread_addr_t pvarg)
         }
     }
 
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+  if (plooper->period > 0)
+    {
+      playbuf_info = plooper->playinfo;
+    }
+  else
+#endif
   if ((ret = ioctl(plooper->playdev_fd, AUDIOIOC_GETBUFFERINFO,
                    (unsigned long)&playbuf_info)) != OK)
     {
@@ -537,6 +725,13 @@ static void *nxlooper_loopthread(pthread_addr_t pvarg)
               }
             else if (apb->flags & AUDIO_APB_RECORD)
               {
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+                if (plooper->latency_state == NXLOOPER_LATENCY_INJECTED)
+                  {
+                    nxlooper_detectpulse(plooper, apb, &inject);
+                  }
+#endif
+
                 dq_addlast(&apb->dq_entry, &recorddq);
               }
 
@@ -551,6 +746,15 @@ static void *nxlooper_loopthread(pthread_addr_t pvarg)
                 copy = MIN(apbrec->nbytes - apbrec->curbyte,
                            apb->nmaxbytes - apb->curbyte);
 
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+                if (plooper->latency_state != NXLOOPER_LATENCY_IDLE)
+                  {
+                    /* Silence around the test pulse */
+
+                    memset(apb->samp + apb->curbyte, 0, copy);
+                  }
+                else
+#endif
                 memcpy(apb->samp + apb->curbyte,
                        apbrec->samp + apbrec->curbyte, copy);
                 apbrec->curbyte += copy;
@@ -569,6 +773,16 @@ static void *nxlooper_loopthread(pthread_addr_t pvarg)
                     apb = (FAR struct ap_buffer_s *)dq_remfirst(&playdq);
                     apb->nbytes = apb->nmaxbytes;
                     apb->curbyte = 0;
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+                    if (plooper->latency_state ==
+                        NXLOOPER_LATENCY_REQUEST)
+                      {
+                        nxlooper_putpulse(plooper, apb);
+                        clock_gettime(CLOCK_MONOTONIC, &inject);
+                        plooper->latency_state = NXLOOPER_LATENCY_INJECTED;
+                      }
+#endif
+
                     ret = nxlooper_enqueueplaybuffer(plooper, apb);
                   }
               }
@@ -700,6 +914,13 @@ err_out:
 
   pthread_mutex_lock(&plooper->mutex);
 
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+  if (plooper->latency_state != NXLOOPER_LATENCY_IDLE)
+    {
+      nxlooper_latencydone(plooper, -EAGAIN);
+    }
+#endif
+
   close(plooper->playdev_fd);             /* Close the play device */
   close(plooper->recorddev_fd);           /* Close the record device */
   plooper->playdev_fd = -1;               /* Mark play device as closed */
@@ -961,6 +1182,105 @@ int nxlooper_stop(FAR struct nxlooper_s *plooper)
 }
 #endif /* CONFIG_AUDIO_EXCLUDE_STOP */
 
+/****************************************************************************
+ * Name: nxlooper_setperiod
+ *
+ *   nxlooper_setperiod() sets the period and number of periods the next
+ *   loopback asks the devices for.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+int nxlooper_setperiod(FAR struct nxlooper_s *plooper, uint32_t frames,
+                       uint8_t nbuffers)
+{
+  DEBUGASSERT(plooper != NULL);
+
+  if (plooper->loopstate != NXLOOPER_STATE_IDLE)
+    {
+      return -EBUSY;
+    }
+
+  plooper->period   = frames;
+  plooper->nbuffers = MAX(nbuffers, 2);
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: nxlooper_latency
+ *
+ *   nxlooper_latency() has the loop thread mute the output, play a pulse
+ *   and time it until it comes back on the input.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+int nxlooper_latency(FAR struct nxlooper_s *plooper, FAR uint32_t *usec)
+{
+  struct timespec abstime;
+  int ret = OK;
+
+  DEBUGASSERT(plooper != NULL && usec != NULL);
+
+  pthread_mutex_lock(&plooper->mutex);
+  if (plooper->loopstate != NXLOOPER_STATE_LOOPING)
+    {
+      ret = -EAGAIN;
+    }
+  else if (plooper->bpsamp != 16 && plooper->bpsamp != 32)
+    {
+      ret = -ENOSYS;
+    }
+  else if (plooper->latency_state != NXLOOPER_LATENCY_IDLE)
+    {
+      ret = -EBUSY;
+    }
+  else
+    {
+      /* Drop the result of an earlier measurement given up on */
+
+      while (sem_trywait(&plooper->latency_sem) == 0)
+        {
+        }
+
+      plooper->latency_state = NXLOOPER_LATENCY_REQUEST;
+    }
+
+  pthread_mutex_unlock(&plooper->mutex);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* The loop thread times out itself, this is in case it has gone */
+
+  clock_gettime(CLOCK_REALTIME, &abstime);
+  abstime.tv_sec += CONFIG_NXLOOPER_LATENCY_TIMEOUT / 1000 + 2;
+
+  do
+    {
+      ret = sem_timedwait(&plooper->latency_sem, &abstime);
+    }
+  while (ret < 0 && errno == EINTR);
+
+  if (ret < 0)
+    {
+      ret = -errno;
+      plooper->latency_state = NXLOOPER_LATENCY_IDLE;
+      return ret;
+    }
+
+  if (plooper->latency < 0)
+    {
+      return plooper->latency;
+    }
+
+  *usec = plooper->latency;
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: nxlooper_loopback
  *
@@ -1089,6 +1409,13 @@ int nxlooper_loopback(FAR struct nxlooper_s *plooper, int format,
       goto err_out;
     }
 
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+  plooper->nchannels = cap_desc.caps.ac_channels;
+  plooper->bpsamp    = cap_desc.caps.ac_controls.b[2];
+  plooper->samprate  = samprate ? samprate : 48000;
+  plooper->framesize = plooper->nchannels * plooper->bpsamp / 8;
+#endif
+
 #ifdef CONFIG_AUDIO_MULTI_SESSION
   cap_desc.session = plooper->pplayses;
 #endif
@@ -1104,6 +1431,24 @@ int nxlooper_loopback(FAR struct nxlooper_s *plooper, int format,
 
   /* Query the audio device for its preferred buffer size / qty */
 
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+  if (plooper->period > 0)
+    {
+      nxlooper_setbufferinfo(plooper, plooper->recorddev_fd,
+                             &plooper->recordinfo);
+      nxlooper_setbufferinfo(plooper, plooper->playdev_fd,
+                             &plooper->playinfo);
+      audinfo("Periods: record %d x %lu, play %d x %lu bytes\n",
+              plooper->recordinfo.nbuffers,
+              (unsigned long)plooper->recordinfo.buffer_size,
+              plooper->playinfo.nbuffers,
+              (unsigned long)plooper->playinfo.buffer_size);
+
+      buf_info.nbuffers = plooper->recordinfo.nbuffers +
+                          plooper->playinfo.nbuffers;
+    }
+  else
+#endif
   if ((ioctl(plooper->playdev_fd, AUDIOIOC_GETBUFFERINFO,
              (unsigned long)&buf_info)) != OK)
     {
@@ -1148,6 +1493,17 @@ int nxlooper_loopback(FAR struct nxlooper_s *plooper, int format,
 
   pthread_attr_init(&tattr);
   sparam.sched_priority = sched_get_priority_max(SCHED_FIFO) - 9;
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+  if (plooper->period > 0)
+    {
+      /* Pinned, so that nothing else delays the copy between devices */
+
+      pthread_attr_setinheritsched(&tattr, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy(&tattr, SCHED_FIFO);
+      sparam.sched_priority = CONFIG_NXLOOPER_LOWLATENCY_PRIORITY;
+    }
+#endif
+
   pthread_attr_setschedparam(&tattr, &sparam);
   pthread_attr_setstacksize(&tattr, CONFIG_NXLOOPER_LOOPTHREAD_STACKSIZE);
 
@@ -1245,6 +1601,16 @@ FAR struct nxlooper_s *nxlooper_create(void)
   plooper->precordses = NULL;
 #endif
 
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+  plooper->period = 0;
+  plooper->nbuffers = 2;
+#endif
+
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+  plooper->latency_state = NXLOOPER_LATENCY_IDLE;
+  sem_init(&plooper->latency_sem, 0, 0);
+#endif
+
   pthread_mutex_init(&plooper->mutex, NULL);
 
   return plooper;
@@ -1282,6 +1648,9 @@ void nxlooper_release(FAR struct nxlooper_s *plooper)
 
   if (refcount == 1)
     {
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+      sem_destroy(&plooper->latency_sem);
+#endif
       free(plooper);
     }
 }
@@ -73,6 +73,14 @@ static int nxlooper_cmd_loopback(FAR struct nxlooper_s *plooper, char *parg);
 static int nxlooper_cmd_reset(FAR struct nxlooper_s *plooper, char *parg);
 #endif
 
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+static int nxlooper_cmd_period(FAR struct nxlooper_s *plooper, char *parg);
+#endif
+
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+static int nxlooper_cmd_latency(FAR struct nxlooper_s *plooper, char *parg);
+#endif
+
 #ifdef CONFIG_NXLOOPER_INCLUDE_PREFERRED_DEVICE
 static int nxlooper_cmd_device(FAR struct nxlooper_s *plooper, char *parg);
 #endif
@@ -121,6 +129,14 @@ static const struct mp_cmd_s g_nxlooper_cmds[] =
     nxlooper_cmd_help,
     NXLOOPER_HELP_TEXT("Display help for commands")
   },
+#endif
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+  {
+    "latency",
+    "",
+    nxlooper_cmd_latency,
+    NXLOOPER_HELP_TEXT("Measure the round-trip latency")
+  },
 #endif
   {
     "loopback",
@@ -136,6 +152,14 @@ static const struct mp_cmd_s g_nxlooper_cmds[] =
     NXLOOPER_HELP_TEXT("Pause loopback")
   },
 #endif
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+  {
+    "period",
+    "frames nbuffers",
+    nxlooper_cmd_period,
+    NXLOOPER_HELP_TEXT("Set the period for low latency, 0 for default")
+  },
+#endif
 #ifdef CONFIG_NXLOOPER_INCLUDE_SYSTEM_RESET
   {
     "reset",
@@ -292,6 +316,76 @@ static int nxlooper_cmd_reset(FAR struct nxlooper_s *plooper, char *parg)
 }
 #endif
 
+/****************************************************************************
+ * Name: nxlooper_cmd_period
+ *
+ *   nxlooper_cmd_period() sets the period and number of periods used by
+ *   the next loopback.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXLOOPER_LOWLATENCY
+static int nxlooper_cmd_period(FAR struct nxlooper_s *plooper, char *parg)
+{
+  unsigned int frames = 0;
+  unsigned int nbuffers = 2;
+  int ret;
+
+  sscanf(parg, "%u %u", &frames, &nbuffers);
+
+  ret = nxlooper_setperiod(plooper, frames, nbuffers);
+  if (ret == -EBUSY)
+    {
+      printf("Stop the loopback first\n");
+    }
+
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: nxlooper_cmd_latency
+ *
+ *   nxlooper_cmd_latency() measures and prints the round-trip latency
+ *   of the running loopback.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXLOOPER_LATENCY_TEST
+static int nxlooper_cmd_latency(FAR struct nxlooper_s *plooper, char *parg)
+{
+  uint32_t usec;
+  int ret;
+
+  ret = nxlooper_latency(plooper, &usec);
+  switch (-ret)
+    {
+      case OK:
+        printf("Round-trip latency: %lu.%03lu ms\n",
+               (unsigned long)(usec / 1000), (unsigned long)(usec % 1000));
+        break;
+
+      case EAGAIN:
+        printf("Loopback not running\n");
+        break;
+
+      case ENOSYS:
+        printf("Only 16 and 32 bit samples can be measured\n");
+        break;
+
+      case ETIMEDOUT:
+        printf("No pulse detected, is the output wired to the input?\n");
+        break;
+
+      default:
+        printf("Error measuring latency: %d\n", -ret);
+        break;
+    }
+
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Name: nxlooper_cmd_stop
  *
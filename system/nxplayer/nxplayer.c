@@ -68,6 +68,26 @@
 #  define CONFIG_NXPLAYER_PLAYTHREAD_STACKSIZE    1500
 #endif
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+#  ifndef CONFIG_NXPLAYER_PREFETCH_STACKSIZE
+#    define CONFIG_NXPLAYER_PREFETCH_STACKSIZE    1500
+#  endif
+
+/* Posted by the prefetch thread when a buffer the play thread waited for
+ * has been read.
+ */
+
+#  define NXPLAYER_MSG_PREFETCH  AUDIO_MSG_USER
+#endif
+
+/* The play thread counts the buffers held by the audio device when it
+ * needs to keep the device fed from the prefetched buffers.
+ */
+
+#if defined(CONFIG_DEBUG_FEATURES) || defined(CONFIG_NXPLAYER_PREFETCH)
+#  define NXPLAYER_COUNT_OUTSTANDING 1
+#endif
+
 /****************************************************************************
  * Private Type Declarations
  ****************************************************************************/
@@ -81,6 +101,37 @@ struct nxplayer_ext_fmt_s
 };
 #endif
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+/* A FIFO of audio pipeline buffers */
+
+struct nxplayer_apbq_s
+{
+  FAR struct ap_buffer_s **apb;       /* size slots */
+  int                    size;
+  int                    head;        /* Oldest buffer */
+  int                    count;       /* Number of buffers queued */
+};
+
+/* The read-ahead stage.  The buffers allocated from the audio device go
+ * round empty -> prefetch thread -> ready -> play thread -> audio device
+ * -> empty, so the file is read ahead of the device by up to
+ * CONFIG_NXPLAYER_PREFETCH_DEPTH buffers and nothing is copied.
+ */
+
+struct nxplayer_prefetch_s
+{
+  FAR struct nxplayer_s  *pplayer;
+  pthread_t              thread;
+  pthread_mutex_t        lock;
+  pthread_cond_t         cond;
+  struct nxplayer_apbq_s empty;       /* Buffers to read into */
+  struct nxplayer_apbq_s ready;       /* Buffers read, in file order */
+  bool                   eof;         /* Nothing more to read */
+  bool                   stop;        /* Thread asked to exit */
+  bool                   notify;      /* Play thread waits for a buffer */
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -276,7 +327,13 @@ static int _open_with_http(const char *fullurl)
         }
     }
 
+#ifdef CONFIG_NXPLAYER_HTTP_JITTER_BUFFER
+  /* Play from the jitter buffer rather than straight from the socket */
+
+  return nxplayer_openstream(s);
+#else
   return s;
+#endif
 }
 #endif
 
@@ -690,6 +747,245 @@ static int nxplayer_readbuffer(FAR struct nxplayer_s *pplayer,
   return OK;
 }
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+/****************************************************************************
+ * Name: nxplayer_apbq_put/get
+ ****************************************************************************/
+
+static void nxplayer_apbq_put(FAR struct nxplayer_apbq_s *q,
+                              FAR struct ap_buffer_s *apb)
+{
+  DEBUGASSERT(q->count < q->size);
+  q->apb[(q->head + q->count++) % q->size] = apb;
+}
+
+static FAR struct ap_buffer_s *
+nxplayer_apbq_get(FAR struct nxplayer_apbq_s *q)
+{
+  FAR struct ap_buffer_s *apb;
+
+  DEBUGASSERT(q->count > 0);
+  apb     = q->apb[q->head];
+  q->head = (q->head + 1) % q->size;
+  q->count--;
+  return apb;
+}
+
+/****************************************************************************
+ * Name: nxplayer_prefetchthread
+ *
+ *  Read the media file into the empty buffers, ahead of the audio device.
+ *  The file is only read here while the thread runs.
+ *
+ ****************************************************************************/
+
+static FAR void *nxplayer_prefetchthread(pthread_addr_t pvarg)
+{
+  FAR struct nxplayer_prefetch_s *pf = (FAR struct nxplayer_prefetch_s *)
+                                       pvarg;
+  FAR struct ap_buffer_s *apb;
+  struct audio_msg_s msg;
+  bool notify;
+  int ret;
+
+  pthread_mutex_lock(&pf->lock);
+  while (!pf->stop && !pf->eof)
+    {
+      if (pf->empty.count == 0)
+        {
+          pthread_cond_wait(&pf->cond, &pf->lock);
+          continue;
+        }
+
+      /* Read without holding the lock, so that the play thread is never
+       * held up by the storage.
+       */
+
+      apb = nxplayer_apbq_get(&pf->empty);
+      pthread_mutex_unlock(&pf->lock);
+
+      ret = nxplayer_readbuffer(pf->pplayer, apb);
+
+      pthread_mutex_lock(&pf->lock);
+      if (ret != OK)
+        {
+          nxplayer_apbq_put(&pf->empty, apb);
+          pf->eof = true;
+        }
+      else
+        {
+          nxplayer_apbq_put(&pf->ready, apb);
+        }
+
+      pthread_cond_broadcast(&pf->cond);
+
+      notify     = pf->notify;
+      pf->notify = false;
+      if (notify)
+        {
+          /* Not with the lock held: the play thread drains the queue */
+
+          pthread_mutex_unlock(&pf->lock);
+
+          msg.msg_id = NXPLAYER_MSG_PREFETCH;
+          msg.u.data = 0;
+          mq_send(pf->pplayer->mq, (FAR const char *)&msg, sizeof(msg),
+                  CONFIG_NXPLAYER_MSG_PRIO);
+
+          pthread_mutex_lock(&pf->lock);
+        }
+    }
+
+  pthread_mutex_unlock(&pf->lock);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: nxplayer_prefetch_start
+ *
+ *  Start reading ahead into the nbuffers buffers allocated for the audio
+ *  device.
+ *
+ ****************************************************************************/
+
+static int nxplayer_prefetch_start(FAR struct nxplayer_s *pplayer,
+                                   FAR struct nxplayer_prefetch_s *pf,
+                                   FAR struct ap_buffer_s **buffers,
+                                   int nbuffers)
+{
+  struct sched_param sparam;
+  pthread_attr_t tattr;
+  int ret;
+  int x;
+
+  pf->empty.apb = malloc(2 * nbuffers * sizeof(FAR struct ap_buffer_s *));
+  if (pf->empty.apb == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  pf->empty.size = nbuffers;
+  pf->ready.apb  = pf->empty.apb + nbuffers;
+  pf->ready.size = nbuffers;
+  pf->pplayer    = pplayer;
+
+  for (x = 0; x < nbuffers; x++)
+    {
+      nxplayer_apbq_put(&pf->empty, buffers[x]);
+    }
+
+  pthread_mutex_init(&pf->lock, NULL);
+  pthread_cond_init(&pf->cond, NULL);
+
+  /* Just below the play thread, which must always get to the device */
+
+  pthread_attr_init(&tattr);
+  sparam.sched_priority = sched_get_priority_max(SCHED_FIFO) - 10;
+  pthread_attr_setschedparam(&tattr, &sparam);
+  pthread_attr_setstacksize(&tattr, CONFIG_NXPLAYER_PREFETCH_STACKSIZE);
+
+  ret = pthread_create(&pf->thread, &tattr, nxplayer_prefetchthread,
+                       (pthread_addr_t)pf);
+  pthread_attr_destroy(&tattr);
+  if (ret != OK)
+    {
+      auderr("ERROR: Failed to create prefetch thread: %d\n", ret);
+      pthread_cond_destroy(&pf->cond);
+      pthread_mutex_destroy(&pf->lock);
+      free(pf->empty.apb);
+      pf->empty.apb = NULL;
+      return -ret;
+    }
+
+  pthread_setname_np(pf->thread, "prefetch");
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxplayer_prefetch_stop
+ *
+ *  Stop reading ahead, if we were.  The file may be closed afterwards.
+ *
+ ****************************************************************************/
+
+static void nxplayer_prefetch_stop(FAR struct nxplayer_prefetch_s *pf)
+{
+  FAR void *value;
+
+  if (pf->empty.apb == NULL)
+    {
+      return;
+    }
+
+  pthread_mutex_lock(&pf->lock);
+  pf->stop = true;
+  pthread_cond_broadcast(&pf->cond);
+  pthread_mutex_unlock(&pf->lock);
+
+  pthread_join(pf->thread, &value);
+
+  pthread_cond_destroy(&pf->cond);
+  pthread_mutex_destroy(&pf->lock);
+  free(pf->empty.apb);
+  pf->empty.apb = NULL;
+}
+
+/****************************************************************************
+ * Name: nxplayer_prefetch_get
+ *
+ *  Take the next buffer read ahead.  If wait is false and none has been
+ *  read yet, return -EAGAIN and have NXPLAYER_MSG_PREFETCH posted when one
+ *  is.  Return -ENODATA when there is nothing more to read, like
+ *  nxplayer_readbuffer().
+ *
+ ****************************************************************************/
+
+static int nxplayer_prefetch_get(FAR struct nxplayer_prefetch_s *pf,
+                                 FAR struct ap_buffer_s **apb, bool wait)
+{
+  int ret = OK;
+
+  pthread_mutex_lock(&pf->lock);
+  while (wait && pf->ready.count == 0 && !pf->eof)
+    {
+      pthread_cond_wait(&pf->cond, &pf->lock);
+    }
+
+  if (pf->ready.count > 0)
+    {
+      *apb = nxplayer_apbq_get(&pf->ready);
+    }
+  else if (pf->eof)
+    {
+      ret = -ENODATA;
+    }
+  else
+    {
+      pf->notify = true;
+      ret = -EAGAIN;
+    }
+
+  pthread_mutex_unlock(&pf->lock);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxplayer_prefetch_put
+ *
+ *  Give a buffer returned by the audio device back to be read into.
+ *
+ ****************************************************************************/
+
+static void nxplayer_prefetch_put(FAR struct nxplayer_prefetch_s *pf,
+                                  FAR struct ap_buffer_s *apb)
+{
+  pthread_mutex_lock(&pf->lock);
+  nxplayer_apbq_put(&pf->empty, apb);
+  pthread_cond_broadcast(&pf->cond);
+  pthread_mutex_unlock(&pf->lock);
+}
+#endif /* CONFIG_NXPLAYER_PREFETCH */
+
 /****************************************************************************
  * Name: nxplayer_enqueuebuffer
  *
@@ -795,15 +1091,24 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
   bool                    failed = false;
   struct ap_buffer_info_s buf_info;
   FAR struct ap_buffer_s  **buffers;
+  FAR struct ap_buffer_s  *apb;
   unsigned int            prio;
-#ifdef CONFIG_DEBUG_FEATURES
+#ifdef NXPLAYER_COUNT_OUTSTANDING
   int                     outstanding = 0;
 #endif
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  struct nxplayer_prefetch_s pf;
+#endif
+  int                     nbuffers;
   int                     x;
   int                     ret;
 
   audinfo("Entry\n");
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  memset(&pf, 0, sizeof(pf));
+#endif
+
   /* Query the audio device for its preferred buffer size / qty */
 
   if ((ret = ioctl(pplayer->dev_fd, AUDIOIOC_GETBUFFERINFO,
@@ -815,10 +1120,17 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
       buf_info.nbuffers = CONFIG_AUDIO_NUM_BUFFERS;
     }
 
+  /* The device holds buf_info.nbuffers of them, the others are read ahead */
+
+  nbuffers = buf_info.nbuffers;
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  nbuffers += CONFIG_NXPLAYER_PREFETCH_DEPTH;
+#endif
+
   /* Create array of pointers to buffers */
 
   buffers = (FAR struct ap_buffer_s **)
-    malloc(buf_info.nbuffers * sizeof(FAR void *));
+    malloc(nbuffers * sizeof(FAR void *));
   if (buffers == NULL)
     {
       /* Error allocating memory for buffer storage! */
@@ -830,12 +1142,12 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
 
   /* Create our audio pipeline buffers to use for queueing up data */
 
-  for (x = 0; x < buf_info.nbuffers; x++)
+  for (x = 0; x < nbuffers; x++)
     {
       buffers[x] = NULL;
     }
 
-  for (x = 0; x < buf_info.nbuffers; x++)
+  for (x = 0; x < nbuffers; x++)
     {
       /* Fill in the buffer descriptor struct to issue an alloc request */
 
@@ -858,13 +1170,29 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
         }
     }
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  /* From now on the file is read by the prefetch thread only */
+
+  ret = nxplayer_prefetch_start(pplayer, &pf, buffers, nbuffers);
+  if (ret < 0)
+    {
+      running = false;
+      goto err_out;
+    }
+#endif
+
   /* Fill up the pipeline with enqueued buffers */
 
   for (x = 0; x < buf_info.nbuffers; x++)
     {
       /* Read the next buffer of data */
 
-      ret = nxplayer_readbuffer(pplayer, buffers[x]);
+#ifdef CONFIG_NXPLAYER_PREFETCH
+      ret = nxplayer_prefetch_get(&pf, &apb, true);
+#else
+      apb = buffers[x];
+      ret = nxplayer_readbuffer(pplayer, apb);
+#endif
       if (ret != OK)
         {
           /* nxplayer_readbuffer will return an error if there is no further
@@ -893,7 +1221,7 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
 
       else
         {
-          ret = nxplayer_enqueuebuffer(pplayer, buffers[x]);
+          ret = nxplayer_enqueuebuffer(pplayer, apb);
           if (ret != OK)
             {
               /* Failed to enqueue the buffer.
@@ -907,6 +1235,9 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
                * file so that no further data is read.
                */
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+              nxplayer_prefetch_stop(&pf);
+#endif
               close(pplayer->fd);
               pplayer->fd = -1;
 
@@ -921,7 +1252,7 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
                failed = true;
                break;
             }
-#ifdef CONFIG_DEBUG_FEATURES
+#ifdef NXPLAYER_COUNT_OUTSTANDING
           else
             {
               /* The audio driver has one more buffer */
@@ -1030,9 +1361,62 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
              */
 
             DEBUGASSERT(msg.u.ptr && outstanding > 0);
+#endif
+#ifdef NXPLAYER_COUNT_OUTSTANDING
             outstanding--;
 #endif
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+            /* Give the buffer back to be read into, then keep the device
+             * fed from the buffers already read.
+             */
+
+            nxplayer_prefetch_put(&pf, msg.u.ptr);
+
+            /* Fall through */
+
+          /* A buffer we waited for has been read ahead */
+
+          case NXPLAYER_MSG_PREFETCH:
+            while (streaming && outstanding < buf_info.nbuffers)
+              {
+                ret = nxplayer_prefetch_get(&pf, &apb, false);
+                if (ret == -EAGAIN)
+                  {
+                    /* The storage is behind.  We will be told when the
+                     * buffer is there.
+                     */
+
+                    break;
+                  }
+                else if (ret != OK)
+                  {
+                    /* Out of data.  Stay in the loop until the device sends
+                     * us a COMPLETE message.
+                     */
+
+                    streaming = false;
+                  }
+                else if (nxplayer_enqueuebuffer(pplayer, apb) != OK)
+                  {
+                    /* There is some issue from the audio driver.  Stop
+                     * streaming and wait for the buffers to be returned
+                     * and for the AUDIO_MSG_COMPLETE indication.
+                     */
+
+                    nxplayer_prefetch_stop(&pf);
+                    close(pplayer->fd);
+                    pplayer->fd = -1;
+
+                    streaming = false;
+                    failed = true;
+                  }
+                else
+                  {
+                    outstanding++;
+                  }
+              }
+#else
             /* Read data from the file directly into this buffer and
              * re-enqueue it.  streaming == true means that we have
              * not yet hit the end-of-file.
@@ -1078,7 +1462,7 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
                         streaming = false;
                         failed = true;
                       }
-#ifdef CONFIG_DEBUG_FEATURES
+#ifdef NXPLAYER_COUNT_OUTSTANDING
                     else
                       {
                         /* The audio driver has one more buffer */
@@ -1088,6 +1472,7 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
 #endif
                   }
               }
+#endif
             break;
 
           /* Someone wants to stop the playback. */
@@ -1136,10 +1521,14 @@ static FAR void *nxplayer_playthread(pthread_addr_t pvarg)
 err_out:
   audinfo("Clean-up and exit\n");
 
+#ifdef CONFIG_NXPLAYER_PREFETCH
+  nxplayer_prefetch_stop(&pf);
+#endif
+
   if (buffers != NULL)
     {
       audinfo("Freeing buffers\n");
-      for (x = 0; x < buf_info.nbuffers; x++)
+      for (x = 0; x < nbuffers; x++)
         {
           /* Fill in the buffer descriptor struct to issue a free request */
 
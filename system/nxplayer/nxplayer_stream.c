@@ -0,0 +1,355 @@
+/****************************************************************************
+ * apps/system/nxplayer/nxplayer_stream.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+
+#include <debug.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nuttx/audio/audio.h>
+
+#include "system/nxplayer.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_NXPLAYER_HTTP_BUFSIZE
+#  define CONFIG_NXPLAYER_HTTP_BUFSIZE     32768
+#endif
+
+#ifndef CONFIG_NXPLAYER_HTTP_LOWWATER
+#  define CONFIG_NXPLAYER_HTTP_LOWWATER    1024
+#endif
+
+#ifndef CONFIG_NXPLAYER_HTTP_HIGHWATER
+#  define CONFIG_NXPLAYER_HTTP_HIGHWATER   8192
+#endif
+
+#ifndef CONFIG_NXPLAYER_HTTP_STALLTIME
+#  define CONFIG_NXPLAYER_HTTP_STALLTIME   30
+#endif
+
+#ifndef CONFIG_NXPLAYER_HTTP_STACKSIZE
+#  define CONFIG_NXPLAYER_HTTP_STACKSIZE   2048
+#endif
+
+#if CONFIG_NXPLAYER_HTTP_HIGHWATER > CONFIG_NXPLAYER_HTTP_BUFSIZE
+#  error CONFIG_NXPLAYER_HTTP_HIGHWATER larger than the buffer
+#endif
+
+#if CONFIG_NXPLAYER_HTTP_LOWWATER >= CONFIG_NXPLAYER_HTTP_HIGHWATER
+#  error CONFIG_NXPLAYER_HTTP_LOWWATER must be below the high watermark
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The jitter buffer between the network and the pipe read by the player.
+ * Nothing is passed on while buffering: until the buffer holds highwater
+ * bytes at the start, and again after it has fallen below the low
+ * watermark.  Each rebuffering doubles highwater, up to the buffer size,
+ * so that a jittery network ends up with a deeper buffer.
+ */
+
+struct nxplayer_stream_s
+{
+  int          sockfd;                 /* The http connection */
+  int          pipefd;                 /* Write end of the player's pipe */
+  size_t       head;                   /* Oldest byte in buf */
+  size_t       count;                  /* Bytes in buf */
+  size_t       highwater;              /* Bytes to buffer before playing */
+  bool         buffering;              /* Nothing passed on to the player */
+  bool         eof;                    /* The server is done */
+  time_t       lastrx;                 /* When data was last received */
+  uint8_t      buf[CONFIG_NXPLAYER_HTTP_BUFSIZE];
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxplayer_stream_now
+ ****************************************************************************/
+
+static time_t nxplayer_stream_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+/****************************************************************************
+ * Name: nxplayer_stream_recv
+ *
+ *   Receive what the connection has into the free part of the buffer.
+ *
+ ****************************************************************************/
+
+static void nxplayer_stream_recv(FAR struct nxplayer_stream_s *stream)
+{
+  size_t tail = (stream->head + stream->count) % sizeof(stream->buf);
+  size_t len;
+  ssize_t n;
+
+  len = tail >= stream->head || stream->count == 0 ?
+        sizeof(stream->buf) - tail : stream->head - tail;
+  if (len > sizeof(stream->buf) - stream->count)
+    {
+      len = sizeof(stream->buf) - stream->count;
+    }
+
+  if (len == 0)
+    {
+      /* Full, polled only for an error */
+
+      return;
+    }
+
+  n = read(stream->sockfd, &stream->buf[tail], len);
+  if (n > 0)
+    {
+      stream->count += n;
+      stream->lastrx = nxplayer_stream_now();
+    }
+  else if (n == 0 || (errno != EINTR && errno != EAGAIN))
+    {
+      audinfo("Stream ended: %d\n", n == 0 ? 0 : errno);
+      stream->eof = true;
+    }
+
+  if (stream->buffering &&
+      (stream->count >= stream->highwater || stream->eof))
+    {
+      audinfo("Playing, %zu bytes buffered\n", stream->count);
+      stream->buffering = false;
+    }
+}
+
+/****************************************************************************
+ * Name: nxplayer_stream_send
+ *
+ *   Pass the oldest buffered data on to the player.
+ *
+ ****************************************************************************/
+
+static int nxplayer_stream_send(FAR struct nxplayer_stream_s *stream)
+{
+  size_t len;
+  ssize_t n;
+
+  len = sizeof(stream->buf) - stream->head;
+  if (len > stream->count)
+    {
+      len = stream->count;
+    }
+
+  n = write(stream->pipefd, &stream->buf[stream->head], len);
+  if (n < 0)
+    {
+      /* EPIPE: the player has closed its end */
+
+      return errno == EINTR || errno == EAGAIN ? OK : -errno;
+    }
+
+  stream->head   = (stream->head + n) % sizeof(stream->buf);
+  stream->count -= n;
+
+  if (!stream->eof && stream->count < CONFIG_NXPLAYER_HTTP_LOWWATER)
+    {
+      /* The network is behind.  Hold the player rather than run dry */
+
+      stream->highwater *= 2;
+      if (stream->highwater > sizeof(stream->buf))
+        {
+          stream->highwater = sizeof(stream->buf);
+        }
+
+      audwarn("WARNING: Rebuffering up to %zu bytes\n", stream->highwater);
+      stream->buffering = true;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxplayer_streamthread
+ *
+ *   Move the data from the connection through the jitter buffer to the
+ *   player, until the stream ends or the player closes the pipe.
+ *
+ ****************************************************************************/
+
+static FAR void *nxplayer_streamthread(pthread_addr_t pvarg)
+{
+  FAR struct nxplayer_stream_s *stream =
+    (FAR struct nxplayer_stream_s *)pvarg;
+  struct pollfd fds[2];
+  int ret;
+
+  stream->lastrx = nxplayer_stream_now();
+
+  while (!stream->eof || stream->count > 0)
+    {
+      /* The write end is always polled so that POLLERR tells us when the
+       * player is gone.
+       */
+
+      fds[0].fd      = stream->sockfd;
+      fds[0].events  = !stream->eof && stream->count < sizeof(stream->buf) ?
+                       POLLIN : 0;
+      fds[0].revents = 0;
+      fds[1].fd      = stream->pipefd;
+      fds[1].events  = !stream->buffering && stream->count > 0 ?
+                       POLLOUT : 0;
+      fds[1].revents = 0;
+
+      ret = poll(fds, 2, 1000);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          auderr("ERROR: poll failed: %d\n", errno);
+          break;
+        }
+
+      if ((fds[1].revents & (POLLERR | POLLHUP)) != 0)
+        {
+          break;
+        }
+
+      if (!stream->eof &&
+          (fds[0].revents & (POLLIN | POLLERR | POLLHUP)) != 0)
+        {
+          nxplayer_stream_recv(stream);
+        }
+      else if (!stream->eof && nxplayer_stream_now() - stream->lastrx >
+               CONFIG_NXPLAYER_HTTP_STALLTIME)
+        {
+          auderr("ERROR: Nothing received for %d seconds\n",
+                 CONFIG_NXPLAYER_HTTP_STALLTIME);
+          break;
+        }
+
+      if ((fds[1].revents & POLLOUT) != 0 &&
+          nxplayer_stream_send(stream) < 0)
+        {
+          break;
+        }
+    }
+
+  /* Closing the pipe gives the player its end of file */
+
+  close(stream->pipefd);
+  close(stream->sockfd);
+  free(stream);
+  return NULL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxplayer_openstream
+ *
+ *   nxplayer_openstream() starts receiving the connected http stream sockfd
+ *   on its own thread and returns the read end of a pipe to play from.
+ *
+ ****************************************************************************/
+
+int nxplayer_openstream(int sockfd)
+{
+  FAR struct nxplayer_stream_s *stream;
+  struct sched_param sparam;
+  pthread_attr_t tattr;
+  pthread_t tid;
+  int fds[2];
+  int ret;
+
+  stream = (FAR struct nxplayer_stream_s *)malloc(sizeof(*stream));
+  if (stream == NULL)
+    {
+      goto errout;
+    }
+
+  if (pipe(fds) < 0)
+    {
+      auderr("ERROR: pipe failed: %d\n", errno);
+      goto errout_with_stream;
+    }
+
+  stream->sockfd    = sockfd;
+  stream->pipefd    = fds[1];
+  stream->head      = 0;
+  stream->count     = 0;
+  stream->highwater = CONFIG_NXPLAYER_HTTP_HIGHWATER;
+  stream->buffering = true;
+  stream->eof       = false;
+
+  /* Above the play thread: the network must not be kept waiting */
+
+  pthread_attr_init(&tattr);
+  sparam.sched_priority = sched_get_priority_max(SCHED_FIFO) - 8;
+  pthread_attr_setschedparam(&tattr, &sparam);
+  pthread_attr_setstacksize(&tattr, CONFIG_NXPLAYER_HTTP_STACKSIZE);
+  pthread_attr_setdetachstate(&tattr, PTHREAD_CREATE_DETACHED);
+
+  ret = pthread_create(&tid, &tattr, nxplayer_streamthread,
+                       (pthread_addr_t)stream);
+  pthread_attr_destroy(&tattr);
+  if (ret != OK)
+    {
+      auderr("ERROR: Failed to create stream thread: %d\n", ret);
+      close(fds[0]);
+      close(fds[1]);
+      goto errout_with_stream;
+    }
+
+  pthread_setname_np(tid, "nxstream");
+  return fds[0];
+
+errout_with_stream:
+  free(stream);
+
+errout:
+  close(sockfd);
+  return -1;
+}
@@ -60,6 +60,16 @@
 #  define CONFIG_NXRECORDER_RECORDTHREAD_STACKSIZE    1500
 #endif
 
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+#  ifndef CONFIG_NXRECORDER_WRITETHREAD_STACKSIZE
+#    define CONFIG_NXRECORDER_WRITETHREAD_STACKSIZE   1500
+#  endif
+
+#  ifndef CONFIG_NXRECORDER_PREALLOC
+#    define CONFIG_NXRECORDER_PREALLOC                0
+#  endif
+#endif
+
 /****************************************************************************
  * Private Type Declarations
  ****************************************************************************/
@@ -73,6 +83,42 @@ struct nxrecorder_ext_fmt_s
 };
 #endif
 
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+/* A FIFO of audio pipeline buffers */
+
+struct nxrecorder_apbq_s
+{
+  FAR struct ap_buffer_s **apb;       /* size slots */
+  int                    size;
+  int                    head;        /* Oldest buffer */
+  int                    count;       /* Number of buffers queued */
+};
+
+/* The write stage.  The record thread hands each captured buffer to the
+ * write thread and gives the device a spare one in exchange, so capture
+ * never waits for the storage.  The write thread gathers the captured
+ * data into CONFIG_NXRECORDER_WRITE_SIZE writes at multiples of that size
+ * in the file.
+ */
+
+struct nxrecorder_pipeline_s
+{
+  FAR struct nxrecorder_s *precorder;
+  pthread_t              thread;
+  pthread_mutex_t        lock;
+  pthread_cond_t         cond;
+  struct nxrecorder_apbq_s empty;     /* Spare buffers for the device */
+  struct nxrecorder_apbq_s full;      /* Captured buffers, in order */
+  FAR uint8_t            *wbuf;       /* The write being gathered */
+  size_t                 wlen;        /* Bytes in wbuf */
+  off_t                  pos;         /* File offset of wbuf */
+  bool                   running;     /* The thread has been started */
+  bool                   stop;        /* Thread asked to exit */
+  bool                   failed;      /* A write failed, data is dropped */
+  unsigned int           overruns;    /* Captures dropped, no spare */
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -385,6 +431,313 @@ static int nxrecorder_writebuffer(FAR struct nxrecorder_s *precorder,
   return OK;
 }
 
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+/****************************************************************************
+ * Name: nxrecorder_apbq_put/get
+ ****************************************************************************/
+
+static void nxrecorder_apbq_put(FAR struct nxrecorder_apbq_s *q,
+                                FAR struct ap_buffer_s *apb)
+{
+  DEBUGASSERT(q->count < q->size);
+  q->apb[(q->head + q->count++) % q->size] = apb;
+}
+
+static FAR struct ap_buffer_s *
+nxrecorder_apbq_get(FAR struct nxrecorder_apbq_s *q)
+{
+  FAR struct ap_buffer_s *apb;
+
+  DEBUGASSERT(q->count > 0);
+  apb     = q->apb[q->head];
+  q->head = (q->head + 1) % q->size;
+  q->count--;
+  return apb;
+}
+
+/****************************************************************************
+ * Name: nxrecorder_pipeline_flush
+ *
+ *  Write out the data gathered so far.
+ *
+ ****************************************************************************/
+
+static void nxrecorder_pipeline_flush(FAR struct nxrecorder_pipeline_s *pl)
+{
+  FAR const uint8_t *ptr = pl->wbuf;
+  ssize_t nwritten;
+
+  while (pl->wlen > 0 && !pl->failed)
+    {
+      nwritten = write(pl->precorder->fd, ptr, pl->wlen);
+      if (nwritten < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          auderr("ERROR: precorder write failed: %d\n", errno);
+          pl->failed = true;
+          break;
+        }
+
+      ptr      += nwritten;
+      pl->pos  += nwritten;
+      pl->wlen -= nwritten;
+    }
+
+  pl->wlen = 0;
+}
+
+/****************************************************************************
+ * Name: nxrecorder_pipeline_gather
+ *
+ *  Add a captured buffer to the writes.  A write is issued whenever its
+ *  end reaches a multiple of CONFIG_NXRECORDER_WRITE_SIZE in the file, so
+ *  only the first and the last write are short.
+ *
+ ****************************************************************************/
+
+static void nxrecorder_pipeline_gather(FAR struct nxrecorder_pipeline_s *pl,
+                                       FAR struct ap_buffer_s *apb)
+{
+  FAR const uint8_t *ptr = apb->samp;
+  size_t remaining = apb->nbytes;
+  size_t space;
+  size_t n;
+
+  while (remaining > 0 && !pl->failed)
+    {
+      space = CONFIG_NXRECORDER_WRITE_SIZE -
+              (pl->pos + pl->wlen) % CONFIG_NXRECORDER_WRITE_SIZE;
+      n     = remaining < space ? remaining : space;
+
+      memcpy(&pl->wbuf[pl->wlen], ptr, n);
+      pl->wlen  += n;
+      ptr       += n;
+      remaining -= n;
+
+      if (n == space)
+        {
+          nxrecorder_pipeline_flush(pl);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxrecorder_writethread
+ *
+ *  Write the captured buffers to the file and give them back as spares.
+ *  The file is only written here while the thread runs.
+ *
+ ****************************************************************************/
+
+static FAR void *nxrecorder_writethread(pthread_addr_t pvarg)
+{
+  FAR struct nxrecorder_pipeline_s *pl =
+    (FAR struct nxrecorder_pipeline_s *)pvarg;
+  FAR struct ap_buffer_s *apb;
+
+  pthread_mutex_lock(&pl->lock);
+  for (; ; )
+    {
+      if (pl->full.count == 0)
+        {
+          if (pl->stop)
+            {
+              break;
+            }
+
+          pthread_cond_wait(&pl->cond, &pl->lock);
+          continue;
+        }
+
+      /* Write without holding the lock, so that the record thread is
+       * never held up by the storage.
+       */
+
+      apb = nxrecorder_apbq_get(&pl->full);
+      pthread_mutex_unlock(&pl->lock);
+
+      nxrecorder_pipeline_gather(pl, apb);
+
+      pthread_mutex_lock(&pl->lock);
+      nxrecorder_apbq_put(&pl->empty, apb);
+    }
+
+  pthread_mutex_unlock(&pl->lock);
+
+  /* Everything captured has been gathered, write out the rest */
+
+  nxrecorder_pipeline_flush(pl);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: nxrecorder_pipeline_start
+ *
+ *  Start the write thread with nspares buffers to give the device in
+ *  exchange for the captured ones.  The file is preallocated by
+ *  CONFIG_NXRECORDER_PREALLOC KiB beyond what has been written already.
+ *
+ ****************************************************************************/
+
+static int nxrecorder_pipeline_start(FAR struct nxrecorder_s *precorder,
+                                     FAR struct nxrecorder_pipeline_s *pl,
+                                     FAR struct ap_buffer_s **spares,
+                                     int nspares, int nbuffers)
+{
+  struct sched_param sparam;
+  pthread_attr_t tattr;
+  int ret;
+  int x;
+
+  pl->wbuf = malloc(CONFIG_NXRECORDER_WRITE_SIZE);
+  pl->empty.apb = malloc(2 * nbuffers * sizeof(FAR struct ap_buffer_s *));
+  if (pl->wbuf == NULL || pl->empty.apb == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  pl->empty.size = nbuffers;
+  pl->full.apb   = pl->empty.apb + nbuffers;
+  pl->full.size  = nbuffers;
+  pl->precorder  = precorder;
+  pl->pos        = lseek(precorder->fd, 0, SEEK_CUR);
+  if (pl->pos < 0)
+    {
+      pl->pos = 0;
+    }
+
+  for (x = 0; x < nspares; x++)
+    {
+      nxrecorder_apbq_put(&pl->empty, spares[x]);
+    }
+
+#if CONFIG_NXRECORDER_PREALLOC > 0
+  /* Reserve the space now rather than while recording, the file is cut
+   * back to what was written at the end.
+   */
+
+  if (ftruncate(precorder->fd,
+                pl->pos + CONFIG_NXRECORDER_PREALLOC * 1024) < 0)
+    {
+      audwarn("WARNING: Failed to preallocate the file: %d\n", errno);
+    }
+#endif
+
+  pthread_mutex_init(&pl->lock, NULL);
+  pthread_cond_init(&pl->cond, NULL);
+
+  /* Just below the record thread, which must always get to the device */
+
+  pthread_attr_init(&tattr);
+  sparam.sched_priority = sched_get_priority_max(SCHED_FIFO) - 10;
+  pthread_attr_setschedparam(&tattr, &sparam);
+  pthread_attr_setstacksize(&tattr, CONFIG_NXRECORDER_WRITETHREAD_STACKSIZE);
+
+  ret = pthread_create(&pl->thread, &tattr, nxrecorder_writethread,
+                       (pthread_addr_t)pl);
+  pthread_attr_destroy(&tattr);
+  if (ret != OK)
+    {
+      auderr("ERROR: Failed to create write thread: %d\n", ret);
+      pthread_cond_destroy(&pl->cond);
+      pthread_mutex_destroy(&pl->lock);
+      ret = -ret;
+      goto errout;
+    }
+
+  pthread_setname_np(pl->thread, "recwrite");
+  pl->running = true;
+  return OK;
+
+errout:
+  free(pl->empty.apb);
+  free(pl->wbuf);
+  pl->empty.apb = NULL;
+  pl->wbuf      = NULL;
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxrecorder_pipeline_stop
+ *
+ *  Write out all that has been captured and stop the write thread, if it
+ *  runs.  The file may be closed afterwards.
+ *
+ ****************************************************************************/
+
+static void nxrecorder_pipeline_stop(FAR struct nxrecorder_pipeline_s *pl)
+{
+  FAR void *value;
+
+  if (!pl->running)
+    {
+      return;
+    }
+
+  pthread_mutex_lock(&pl->lock);
+  pl->stop = true;
+  pthread_cond_signal(&pl->cond);
+  pthread_mutex_unlock(&pl->lock);
+
+  pthread_join(pl->thread, &value);
+  pl->running = false;
+
+#if CONFIG_NXRECORDER_PREALLOC > 0
+  ftruncate(pl->precorder->fd, pl->pos);
+#endif
+
+  if (pl->overruns > 0)
+    {
+      audwarn("WARNING: %u buffers dropped, the storage was too slow\n",
+              pl->overruns);
+    }
+
+  pthread_cond_destroy(&pl->cond);
+  pthread_mutex_destroy(&pl->lock);
+  free(pl->empty.apb);
+  free(pl->wbuf);
+  pl->empty.apb = NULL;
+  pl->wbuf      = NULL;
+}
+
+/****************************************************************************
+ * Name: nxrecorder_pipeline_swap
+ *
+ *  Queue a captured buffer for writing and return a spare one to give to
+ *  the device.  If the write thread has no buffer to spare, the capture is
+ *  dropped and the same buffer is returned.
+ *
+ ****************************************************************************/
+
+static FAR struct ap_buffer_s *
+nxrecorder_pipeline_swap(FAR struct nxrecorder_pipeline_s *pl,
+                         FAR struct ap_buffer_s *apb)
+{
+  pthread_mutex_lock(&pl->lock);
+  if (pl->empty.count > 0)
+    {
+      nxrecorder_apbq_put(&pl->full, apb);
+      pthread_cond_signal(&pl->cond);
+      apb = nxrecorder_apbq_get(&pl->empty);
+    }
+  else
+    {
+      pl->overruns++;
+    }
+
+  pthread_mutex_unlock(&pl->lock);
+
+  apb->curbyte = 0;
+  apb->flags   = 0;
+  return apb;
+}
+#endif /* CONFIG_NXRECORDER_WRITETHREAD */
+
 /****************************************************************************
  * Name: nxrecorder_enqueuebuffer
  *
@@ -492,15 +845,24 @@ static FAR void *nxrecorder_recordthread(pthread_addr_t pvarg)
   bool                    failed = false;
   struct ap_buffer_info_s buf_info;
   FAR struct ap_buffer_s  **pbuffers;
+  FAR struct ap_buffer_s  *apb;
   unsigned int            prio;
 #ifdef CONFIG_DEBUG_FEATURES
   int                     outstanding = 0;
 #endif
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+  struct nxrecorder_pipeline_s pl;
+#endif
+  int                     nbuffers;
   int                     x;
   int                     ret;
 
   audinfo("Entry\n");
 
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+  memset(&pl, 0, sizeof(pl));
+#endif
+
   /* Query the audio device for its preferred buffer size / qty */
 
   if ((ret = ioctl(precorder->dev_fd, AUDIOIOC_GETBUFFERINFO,
@@ -512,9 +874,18 @@ static FAR void *nxrecorder_recordthread(pthread_addr_t pvarg)
       buf_info.nbuffers = CONFIG_AUDIO_NUM_BUFFERS;
     }
 
+  /* The device holds buf_info.nbuffers of them, the others are spares
+   * exchanged for the buffers being written.
+   */
+
+  nbuffers = buf_info.nbuffers;
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+  nbuffers += CONFIG_NXRECORDER_WRITETHREAD_DEPTH;
+#endif
+
   /* Create array of pointers to buffers */
 
-  pbuffers = (FAR struct ap_buffer_s **) malloc(buf_info.nbuffers *
+  pbuffers = (FAR struct ap_buffer_s **) malloc(nbuffers *
                                                 sizeof(FAR void *));
   if (pbuffers == NULL)
     {
@@ -527,12 +898,12 @@ static FAR void *nxrecorder_recordthread(pthread_addr_t pvarg)
 
   /* Create our audio pipeline buffers to use for queueing up data */
 
-  for (x = 0; x < buf_info.nbuffers; x++)
+  for (x = 0; x < nbuffers; x++)
     {
       pbuffers[x] = NULL;
     }
 
-  for (x = 0; x < buf_info.nbuffers; x++)
+  for (x = 0; x < nbuffers; x++)
     {
       /* Fill in the buffer descriptor struct to issue an alloc request */
 
@@ -555,6 +926,25 @@ static FAR void *nxrecorder_recordthread(pthread_addr_t pvarg)
         }
     }
 
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+  /* The write thread gathers what nxrecorder_write_common() would write.
+   * Formats with their own write_data are written here, as before.
+   */
+
+  if (precorder->ops->write_data == nxrecorder_write_common)
+    {
+      ret = nxrecorder_pipeline_start(precorder, &pl,
+                                      &pbuffers[buf_info.nbuffers],
+                                      nbuffers - buf_info.nbuffers,
+                                      nbuffers);
+      if (ret < 0)
+        {
+          running = false;
+          goto err_out;
+        }
+    }
+#endif
+
   /* Fill up the pipeline with enqueued buffers */
 
   for (x = 0; x < buf_info.nbuffers; x++)
@@ -574,6 +964,9 @@ static FAR void *nxrecorder_recordthread(pthread_addr_t pvarg)
            * file so that no further data is written.
            */
 
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+          nxrecorder_pipeline_stop(&pl);
+#endif
           close(precorder->fd);
           precorder->fd = -1;
 
@@ -688,9 +1081,26 @@ static FAR void *nxrecorder_recordthread(pthread_addr_t pvarg)
 
             if (streaming)
               {
-                /* Write the next buffer of data */
+                apb = msg.u.ptr;
+
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+                if (pl.running)
+                  {
+                    /* Hand it to the write thread and record on into a
+                     * spare buffer.
+                     */
+
+                    apb = nxrecorder_pipeline_swap(&pl, apb);
+                    ret = OK;
+                  }
+                else
+#endif
+                  {
+                    /* Write the next buffer of data */
+
+                    ret = nxrecorder_writebuffer(precorder, apb);
+                  }
 
-                ret = nxrecorder_writebuffer(precorder, msg.u.ptr);
                 if (ret != OK)
                   {
                     /* Out of data.  Stay in the loop until the device sends
@@ -705,7 +1115,7 @@ static FAR void *nxrecorder_recordthread(pthread_addr_t pvarg)
 
                 else
                   {
-                    ret = nxrecorder_enqueuebuffer(precorder, msg.u.ptr);
+                    ret = nxrecorder_enqueuebuffer(precorder, apb);
                     if (ret != OK)
                       {
                         /* There is some issue from the audio driver.
@@ -715,6 +1125,9 @@ static FAR void *nxrecorder_recordthread(pthread_addr_t pvarg)
                          * Close the file so that no further data is written.
                          */
 
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+                        nxrecorder_pipeline_stop(&pl);
+#endif
                         close(precorder->fd);
                         precorder->fd = -1;
 
@@ -783,10 +1196,14 @@ static FAR void *nxrecorder_recordthread(pthread_addr_t pvarg)
 err_out:
   audinfo("Clean-up and exit\n");
 
+#ifdef CONFIG_NXRECORDER_WRITETHREAD
+  nxrecorder_pipeline_stop(&pl);
+#endif
+
   if (pbuffers != NULL)
     {
       audinfo("Freeing buffers\n");
-      for (x = 0; x < buf_info.nbuffers; x++)
+      for (x = 0; x < nbuffers; x++)
         {
           /* Fill in the buffer descriptor struct to issue a free request */
 
@@ -36,6 +36,7 @@
 #include <nuttx/net/ip.h>
 
 #include "netutils/icmp_ping.h"
+#include "netutils/ping_hist.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -57,6 +58,9 @@ struct ping_priv_s
   long tmax;                     /* Maximum round trip time */
   long long tsum;                /* Sum of all times, for doing average */
   long long tsum2;               /* Sum2 is the sum of the squares of sum ,for doing mean deviation */
+  FAR struct ping_hist_s *hist;  /* Round trip time histogram */
+  bool flood;                    /* No output per reply */
+  bool verbose;                  /* Print the histogram buckets */
 };
 
 /****************************************************************************
@@ -73,7 +77,8 @@ static void show_usage(FAR const char *progname, int exitcode)
 {
 #if defined(CONFIG_LIBC_NETDB) && defined(CONFIG_NETDB_DNSCLIENT)
   printf("\nUsage: %s [-c <count>] [-i <interval>] [-W <timeout>] "
-         "[-s <size>] <hostname>\n", progname);
+         "[-s <size>]\n"
+         "       [-u <usec>] [-f] [-H] <hostname>\n", progname);
   printf("       %s -h\n", progname);
   printf("\nWhere:\n");
   printf("  <hostname> is either an IPv4 address or the name of "
@@ -81,7 +86,8 @@ static void show_usage(FAR const char *progname, int exitcode)
   printf("   that is requested the ICMPv4 ECHO reply.\n");
 #else
   printf("\nUsage: %s [-c <count>] [-i <interval>] [-W <timeout>] "
-         "[-s <size>] <ip-address>\n", progname);
+         "[-s <size>]\n"
+         "       [-u <usec>] [-f] [-H] <ip-address>\n", progname);
   printf("       %s -h\n", progname);
   printf("\nWhere:\n");
   printf("  <ip-address> is the IPv4 address request the ICMP "
@@ -98,6 +104,12 @@ static void show_usage(FAR const char *progname, int exitcode)
   printf("  -s <size> specifies the number of data bytes to be sent.  "
          "Default %u.\n",
          ICMP_PING_DATALEN);
+  printf("  -u <usec> is the delay between pings in microseconds, "
+         "overrides -i.\n");
+  printf("  -f floods: sends each ping as soon as the reply arrives "
+         "and prints\n");
+  printf("    only the summary.\n");
+  printf("  -H prints the round trip time histogram.\n");
   printf("  -h shows this text and exits.\n");
   exit(exitcode);
 }
@@ -201,6 +213,16 @@ static void ping_result(FAR const struct ping_result_s *result)
             priv->tmax = result->extra;
           }
 
+        if (priv->hist != NULL)
+          {
+            ping_hist_add(priv->hist, result->extra);
+          }
+
+        if (priv->flood)
+          {
+            break;
+          }
+
         printf("%u bytes from %u.%u.%u.%u: icmp_seq=%u time=%ld.%ld ms\n",
                result->info->datalen,
                ip4_addr1(result->dest.s_addr),
@@ -264,6 +286,11 @@ static void ping_result(FAR const struct ping_result_s *result)
                        priv->tmax / USEC_PER_MSEC,
                        priv->tmax % USEC_PER_MSEC,
                        tmdev / USEC_PER_MSEC, tmdev % USEC_PER_MSEC);
+
+                if (priv->hist != NULL)
+                  {
+                    ping_hist_print(priv->hist, priv->verbose);
+                  }
               }
           }
         break;
@@ -285,6 +312,7 @@ int main(int argc, FAR char *argv[])
   info.count     = ICMP_NPINGS;
   info.datalen   = ICMP_PING_DATALEN;
   info.delay     = ICMP_POLL_DELAY;
+  info.interval  = 0;
   info.timeout   = ICMP_POLL_DELAY;
   info.callback  = ping_result;
   info.priv      = &priv;
@@ -293,12 +321,15 @@ int main(int argc, FAR char *argv[])
   priv.tmax      = 0;
   priv.tsum      = 0;
   priv.tsum2     = 0;
+  priv.hist      = NULL;
+  priv.flood     = false;
+  priv.verbose   = false;
 
   /* Parse command line options */
 
   exitcode = EXIT_FAILURE;
 
-  while ((option = getopt(argc, argv, ":c:i:W:s:h")) != ERROR)
+  while ((option = getopt(argc, argv, ":c:i:u:W:s:fHh")) != ERROR)
     {
       switch (option)
         {
@@ -330,6 +361,30 @@ int main(int argc, FAR char *argv[])
             }
             break;
 
+          case 'u':
+            {
+              long interval = strtol(optarg, &endptr, 10);
+              if (interval < 1 || interval > INT32_MAX)
+                {
+                  fprintf(stderr, "ERROR: <usec> out of range: %ld\n",
+                          interval);
+                  goto errout_with_usage;
+                }
+
+              info.interval = (uint32_t)interval;
+            }
+            break;
+
+          case 'f':
+            info.delay    = 0;
+            info.interval = 0;
+            priv.flood    = true;
+            break;
+
+          case 'H':
+            priv.verbose = true;
+            break;
+
           case 'W':
             {
               long timeout = strtol(optarg, &endptr, 10);
@@ -382,7 +437,9 @@ int main(int argc, FAR char *argv[])
     }
 
   info.hostname = argv[optind];
+  priv.hist = calloc(1, sizeof(struct ping_hist_s));
   icmp_ping(&info);
+  free(priv.hist);
   return priv.code < 0 ? EXIT_FAILURE: EXIT_SUCCESS;
 
 errout_with_usage:
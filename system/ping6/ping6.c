@@ -36,6 +36,7 @@
 #include <arpa/inet.h>
 
 #include "netutils/icmpv6_ping.h"
+#include "netutils/ping_hist.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -57,6 +58,9 @@ struct ping6_priv_s
   long tmax;                       /* Maximum round trip time */
   long long tsum;                  /* Sum of all times, for doing average */
   long long tsum2;                 /* Sum2 is the sum of the squares of sum ,for doing mean deviation */
+  FAR struct ping_hist_s *hist;    /* Round trip time histogram */
+  bool flood;                      /* No output per reply */
+  bool verbose;                    /* Print the histogram buckets */
 };
 
 /****************************************************************************
@@ -73,7 +77,8 @@ static void show_usage(FAR const char *progname, int exitcode)
 {
 #if defined(CONFIG_LIBC_NETDB) && defined(CONFIG_NETDB_DNSCLIENT)
   printf("\nUsage: %s [-c <count>] [-i <interval>] "
-         "[-W <timeout>] [-s <size>] <hostname>\n", progname);
+         "[-W <timeout>] [-s <size>]\n"
+         "       [-u <usec>] [-f] [-H] <hostname>\n", progname);
   printf("       %s -h\n", progname);
   printf("\nWhere:\n");
   printf("  <hostname> is either an IPv6 address "
@@ -81,7 +86,8 @@ static void show_usage(FAR const char *progname, int exitcode)
   printf("   that is requested the ICMPv6 ECHO reply.\n");
 #else
   printf("\nUsage: %s [-c <count>] [-i <interval>] [-W <timeout>] "
-         "[-s <size>] <ip-address>\n", progname);
+         "[-s <size>]\n"
+         "       [-u <usec>] [-f] [-H] <ip-address>\n", progname);
   printf("       %s -h\n", progname);
   printf("\nWhere:\n");
   printf("  <ip-address> is the IPv6 address request "
@@ -98,6 +104,12 @@ static void show_usage(FAR const char *progname, int exitcode)
   printf("  -s <size> specifies the number of data bytes to be sent. "
          " Default %u.\n",
          ICMPv6_PING6_DATALEN);
+  printf("  -u <usec> is the delay between pings in microseconds, "
+         "overrides -i.\n");
+  printf("  -f floods: sends each ping as soon as the reply arrives "
+         "and prints\n");
+  printf("    only the summary.\n");
+  printf("  -H prints the round trip time histogram.\n");
   printf("  -h shows this text and exits.\n");
   exit(exitcode);
 }
@@ -198,6 +210,16 @@ static void ping6_result(FAR const struct ping6_result_s *result)
             priv->tmax = result->extra;
           }
 
+        if (priv->hist != NULL)
+          {
+            ping_hist_add(priv->hist, result->extra);
+          }
+
+        if (priv->flood)
+          {
+            break;
+          }
+
         inet_ntop(AF_INET6, result->dest.s6_addr16, strbuffer,
                   INET6_ADDRSTRLEN);
         printf("%u bytes from %s icmp_seq=%u time=%ld.%ld ms\n",
@@ -259,6 +281,11 @@ static void ping6_result(FAR const struct ping6_result_s *result)
                        priv->tmax / USEC_PER_MSEC,
                        priv->tmax % USEC_PER_MSEC,
                        tmdev / USEC_PER_MSEC, tmdev % USEC_PER_MSEC);
+
+                if (priv->hist != NULL)
+                  {
+                    ping_hist_print(priv->hist, priv->verbose);
+                  }
               }
           }
         break;
@@ -280,6 +307,7 @@ int main(int argc, FAR char *argv[])
   info.count     = ICMPv6_NPINGS;
   info.datalen   = ICMPv6_PING6_DATALEN;
   info.delay     = ICMPv6_POLL_DELAY;
+  info.interval  = 0;
   info.timeout   = ICMPv6_POLL_DELAY;
   info.callback  = ping6_result;
   info.priv      = &priv;
@@ -288,12 +316,15 @@ int main(int argc, FAR char *argv[])
   priv.tmax      = 0;
   priv.tsum      = 0;
   priv.tsum2     = 0;
+  priv.hist      = NULL;
+  priv.flood     = false;
+  priv.verbose   = false;
 
   /* Parse command line options */
 
   exitcode = EXIT_FAILURE;
 
-  while ((option = getopt(argc, argv, ":c:i:W:s:h")) != ERROR)
+  while ((option = getopt(argc, argv, ":c:i:u:W:s:fHh")) != ERROR)
     {
       switch (option)
         {
@@ -325,6 +356,30 @@ int main(int argc, FAR char *argv[])
             }
             break;
 
+          case 'u':
+            {
+              long interval = strtol(optarg, &endptr, 10);
+              if (interval < 1 || interval > INT32_MAX)
+                {
+                  fprintf(stderr, "ERROR: <usec> out of range: %ld\n",
+                          interval);
+                  goto errout_with_usage;
+                }
+
+              info.interval = (uint32_t)interval;
+            }
+            break;
+
+          case 'f':
+            info.delay    = 0;
+            info.interval = 0;
+            priv.flood    = true;
+            break;
+
+          case 'H':
+            priv.verbose = true;
+            break;
+
           case 'W':
             {
               long timeout = strtol(optarg, &endptr, 10);
@@ -377,7 +432,9 @@ int main(int argc, FAR char *argv[])
     }
 
   info.hostname = argv[optind];
+  priv.hist = calloc(1, sizeof(struct ping_hist_s));
   icmp6_ping(&info);
+  free(priv.hist);
   return priv.code < 0 ? EXIT_FAILURE: EXIT_SUCCESS;
 
 errout_with_usage:
@@ -25,6 +25,7 @@
 #include <nuttx/config.h>
 
 #include <sys/wait.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -34,9 +35,22 @@
 #include <assert.h>
 #include <debug.h>
 #include <fcntl.h>
+#include <errno.h>
+
+#ifdef CONFIG_SYSTEM_POPEN_BUILTIN
+#  include <nuttx/lib/builtin.h>
+#endif
 
 #include "nshlib/nshlib.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Maximum number of arguments of a builtin run without the shell */
+
+#define POPEN_MAXARGS 8
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -52,6 +66,229 @@ struct popen_file_s
   pid_t shell;
 };
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The spawn attributes of the shell are the same for every call */
+
+static posix_spawnattr_t g_popen_attr;
+static bool g_popen_attrvalid;
+
+#ifdef CONFIG_SYSTEM_POPEN_BUILTIN
+/* A command made only of these characters means the same to the shell as
+ * a plain list of words: no quoting, variables, redirection or pipes.
+ */
+
+static const char g_popen_plain[] =
+  "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+  " \t_-+=.,:/@%";
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: popen_initattr
+ *
+ * Description:
+ *   Initialize spawn attributes with the priority and, if not zero, the
+ *   stack size of the new task.
+ *
+ ****************************************************************************/
+
+static int popen_initattr(FAR posix_spawnattr_t *attr, int priority,
+                          size_t stacksize)
+{
+  struct sched_param param;
+  int errcode;
+
+  errcode = posix_spawnattr_init(attr);
+  if (errcode != 0)
+    {
+      return errcode;
+    }
+
+  /* Set the correct stack size and priority */
+
+  param.sched_priority = priority;
+  errcode = posix_spawnattr_setschedparam(attr, &param);
+  if (errcode != 0)
+    {
+      goto errout;
+    }
+
+  if (stacksize > 0)
+    {
+      errcode = posix_spawnattr_setstacksize(attr, stacksize);
+      if (errcode != 0)
+        {
+          goto errout;
+        }
+    }
+
+  /* If robin robin scheduling is enabled, then set the scheduling policy
+   * of the new task to SCHED_RR before it has a chance to run.
+   */
+
+#if CONFIG_RR_INTERVAL > 0
+  errcode = posix_spawnattr_setschedpolicy(attr, SCHED_RR);
+  if (errcode != 0)
+    {
+      goto errout;
+    }
+
+  errcode = posix_spawnattr_setflags(attr,
+                                     POSIX_SPAWN_SETSCHEDPARAM |
+                                     POSIX_SPAWN_SETSCHEDULER);
+#else
+  errcode = posix_spawnattr_setflags(attr, POSIX_SPAWN_SETSCHEDPARAM);
+#endif
+
+  if (errcode == 0)
+    {
+      return 0;
+    }
+
+errout:
+  posix_spawnattr_destroy(attr);
+  return errcode;
+}
+
+/****************************************************************************
+ * Name: popen_shell
+ *
+ * Description:
+ *   Start the shell with the command.  The attributes are set up on the
+ *   first call and reused afterwards.
+ *
+ ****************************************************************************/
+
+static int popen_shell(FAR const char *command,
+                       FAR posix_spawn_file_actions_t *file_actions,
+                       FAR pid_t *pid)
+{
+  FAR char *argv[4];
+  size_t stacksize = 0;
+  int errcode = 0;
+
+#ifndef CONFIG_SYSTEM_POPEN_SHPATH
+  stacksize = CONFIG_SYSTEM_POPEN_STACKSIZE;
+#endif
+
+  sched_lock();
+  if (!g_popen_attrvalid)
+    {
+      errcode = popen_initattr(&g_popen_attr, CONFIG_SYSTEM_POPEN_PRIORITY,
+                               stacksize);
+      g_popen_attrvalid = errcode == 0;
+    }
+
+  sched_unlock();
+  if (errcode != 0)
+    {
+      return errcode;
+    }
+
+  /* Call task_spawn() (or posix_spawn), re-directing stdin or stdout
+   * appropriately.
+   */
+
+  argv[1] = "-c";
+  argv[2] = (FAR char *)command;
+  argv[3] = NULL;
+
+#ifdef CONFIG_SYSTEM_POPEN_SHPATH
+  argv[0] = CONFIG_SYSTEM_POPEN_SHPATH;
+  errcode = posix_spawn(pid, argv[0], file_actions,
+                        &g_popen_attr, argv, NULL);
+#else
+  *pid = task_spawn("popen", nsh_system, file_actions,
+                    &g_popen_attr, argv + 1, NULL);
+  if (*pid < 0)
+    {
+      errcode = -*pid;
+    }
+#endif
+
+  return errcode;
+}
+
+/****************************************************************************
+ * Name: popen_builtin
+ *
+ * Description:
+ *   Start a builtin application directly, without a shell in between, if
+ *   the command is a plain list of words naming one.  Returns ENOENT if
+ *   the command needs the shell.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_POPEN_BUILTIN
+static int popen_builtin(FAR const char *command,
+                         FAR posix_spawn_file_actions_t *file_actions,
+                         FAR pid_t *pid)
+{
+  FAR const struct builtin_s *builtin = NULL;
+  FAR char *argv[POPEN_MAXARGS + 1];
+  posix_spawnattr_t attr;
+  FAR char *cmdline;
+  FAR char *saveptr;
+  FAR char *arg;
+  int errcode = ENOENT;
+  int index;
+  int argc = 0;
+
+  if (command[strspn(command, g_popen_plain)] != '\0')
+    {
+      return ENOENT;
+    }
+
+  cmdline = strdup(command);
+  if (cmdline == NULL)
+    {
+      return ENOMEM;
+    }
+
+  arg = strtok_r(cmdline, " \t", &saveptr);
+  while (arg != NULL && argc < POPEN_MAXARGS)
+    {
+      argv[argc++] = arg;
+      arg = strtok_r(NULL, " \t", &saveptr);
+    }
+
+  argv[argc] = NULL;
+
+  if (arg == NULL && argc > 0)
+    {
+      index = builtin_isavail(argv[0]);
+      if (index >= 0)
+        {
+          builtin = builtin_for_index(index);
+        }
+    }
+
+  if (builtin != NULL && builtin->main != NULL)
+    {
+      errcode = popen_initattr(&attr, builtin->priority,
+                               builtin->stacksize);
+      if (errcode == 0)
+        {
+          *pid = task_spawn(builtin->name, builtin->main, file_actions,
+                            &attr, &argv[1], NULL);
+          errcode = *pid < 0 ? -*pid : 0;
+          posix_spawnattr_destroy(&attr);
+        }
+    }
+
+  /* task_spawn() has copied the arguments */
+
+  free(cmdline);
+  return errcode;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -111,10 +348,7 @@ struct popen_file_s
 FILE *popen(FAR const char *command, FAR const char *mode)
 {
   FAR struct popen_file_s *container;
-  struct sched_param param;
-  posix_spawnattr_t attr;
   posix_spawn_file_actions_t file_actions;
-  FAR char *argv[4];
   int fd[2];
   int oldfd[2];
   int newfd[2];
@@ -196,66 +430,12 @@ FILE *popen(FAR const char *command, FAR const char *mode)
       goto errout_with_pipe;
     }
 
-  /* Initialize attributes for task_spawn() (or posix_spawn()). */
-
-  errcode = posix_spawnattr_init(&attr);
-  if (errcode != 0)
-    {
-      goto errout_with_stream;
-    }
-
   errcode = posix_spawn_file_actions_init(&file_actions);
   if (errcode != 0)
     {
-      goto errout_with_attrs;
-    }
-
-  /* Set the correct stack size and priority */
-
-  param.sched_priority = CONFIG_SYSTEM_POPEN_PRIORITY;
-  errcode = posix_spawnattr_setschedparam(&attr, &param);
-  if (errcode != 0)
-    {
-      goto errout_with_actions;
-    }
-
-#ifndef CONFIG_SYSTEM_POPEN_SHPATH
-  errcode = posix_spawnattr_setstacksize(&attr,
-                                         CONFIG_SYSTEM_POPEN_STACKSIZE);
-  if (errcode != 0)
-    {
-      goto errout_with_actions;
-    }
-#endif
-
-  /* If robin robin scheduling is enabled, then set the scheduling policy
-   * of the new task to SCHED_RR before it has a chance to run.
-   */
-
-#if CONFIG_RR_INTERVAL > 0
-  errcode = posix_spawnattr_setschedpolicy(&attr, SCHED_RR);
-  if (errcode != 0)
-    {
-      goto errout_with_actions;
-    }
-
-  errcode = posix_spawnattr_setflags(&attr,
-                                     POSIX_SPAWN_SETSCHEDPARAM |
-                                     POSIX_SPAWN_SETSCHEDULER);
-  if (errcode != 0)
-    {
-      goto errout_with_actions;
-    }
-
-#else
-  errcode = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSCHEDPARAM);
-  if (errcode != 0)
-    {
-      goto errout_with_actions;
+      goto errout_with_stream;
     }
 
-#endif
-
   /* Redirect input or output as determined by the mode parameter */
 
   errcode = posix_spawn_file_actions_adddup2(&file_actions,
@@ -275,26 +455,17 @@ FILE *popen(FAR const char *command, FAR const char *mode)
         }
     }
 
-  /* Call task_spawn() (or posix_spawn), re-directing stdin or stdout
-   * appropriately.
+  /* Start a builtin application directly if the command allows it,
+   * otherwise start the shell to run the command.
    */
 
-  argv[1] = "-c";
-  argv[2] = (FAR char *)command;
-  argv[3] = NULL;
-
-#ifdef CONFIG_SYSTEM_POPEN_SHPATH
-  argv[0] = CONFIG_SYSTEM_POPEN_SHPATH;
-  errcode = posix_spawn(&container->shell, argv[0], &file_actions,
-                        &attr, argv, NULL);
-#else
-  container->shell = task_spawn("popen", nsh_system, &file_actions,
-                                &attr, argv + 1, NULL);
-  if (container->shell < 0)
+#ifdef CONFIG_SYSTEM_POPEN_BUILTIN
+  errcode = popen_builtin(command, &file_actions, &container->shell);
+  if (errcode == ENOENT)
+#endif
     {
-      errcode = -container->shell;
+      errcode = popen_shell(command, &file_actions, &container->shell);
     }
-#endif
 
   if (errcode != 0)
     {
@@ -313,12 +484,9 @@ FILE *popen(FAR const char *command, FAR const char *mode)
       close(newfd[1]);
     }
 
-  /* Free attributes and file actions.  Ignoring return values in the case
-   * of an error.
-   */
+  /* Free file actions.  Ignoring return values in the case of an error. */
 
   posix_spawn_file_actions_destroy(&file_actions);
-  posix_spawnattr_destroy(&attr);
 
   if (strchr(mode, 'e') == NULL)
     {
@@ -333,9 +501,6 @@ FILE *popen(FAR const char *command, FAR const char *mode)
 errout_with_actions:
   posix_spawn_file_actions_destroy(&file_actions);
 
-errout_with_attrs:
-  posix_spawnattr_destroy(&attr);
-
 errout_with_stream:
   fclose(container->original);
 
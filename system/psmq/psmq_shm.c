@@ -0,0 +1,330 @@
+/****************************************************************************
+ * apps/system/psmq/psmq_shm.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "system/psmq_shm.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define PSMQ_SHM_MAGIC    0x70736d71  /* "psmq" */
+
+/* Set in the reference count while the publisher writes the slot.  A
+ * reader that sees it drops the reference it just took.
+ */
+
+#define PSMQ_SHM_WRITING  0x80000000u
+
+#define PSMQ_SHM_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct psmq_shm_hdr_s
+{
+  atomic_uint magic;                /* Stored last by the creator */
+  uint32_t    nslots;
+  uint32_t    slotsize;             /* Payload bytes per slot */
+  uint32_t    stride;               /* Bytes between two slots */
+  atomic_uint next;                 /* Next slot to allocate, modulo nslots */
+  atomic_uint seq;                  /* Last publish number */
+};
+
+struct psmq_shm_slot_s
+{
+  atomic_uint refs;                 /* Readers, or PSMQ_SHM_WRITING */
+  atomic_uint seq;                  /* Publish number, 0 while written */
+  uint32_t    len;
+  uint32_t    reserved;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static FAR struct psmq_shm_slot_s *
+psmq_shm_slot(FAR const struct psmq_shm_s *shm, uint32_t index)
+{
+  return (FAR struct psmq_shm_slot_s *)
+         (shm->slots + (size_t)index * shm->hdr->stride);
+}
+
+static int psmq_shm_map(FAR struct psmq_shm_s *shm, int fd, size_t size)
+{
+  FAR void *mem;
+
+  mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mem == MAP_FAILED)
+    {
+      return -errno;
+    }
+
+  shm->hdr   = mem;
+  shm->slots = (FAR uint8_t *)mem +
+               PSMQ_SHM_ALIGN(sizeof(struct psmq_shm_hdr_s));
+  shm->size  = size;
+  return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: psmq_shm_create
+ ****************************************************************************/
+
+int psmq_shm_create(FAR struct psmq_shm_s *shm, FAR const char *name,
+                    unsigned int nslots, size_t slotsize)
+{
+  FAR struct psmq_shm_hdr_s *hdr;
+  size_t stride;
+  size_t size;
+  int ret;
+  int fd;
+
+  if (nslots == 0 || slotsize == 0 || slotsize > UINT32_MAX / 2)
+    {
+      return -EINVAL;
+    }
+
+  stride = sizeof(struct psmq_shm_slot_s) + PSMQ_SHM_ALIGN(slotsize);
+  size   = PSMQ_SHM_ALIGN(sizeof(struct psmq_shm_hdr_s)) + nslots * stride;
+
+  fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  if (ftruncate(fd, size) < 0)
+    {
+      ret = -errno;
+      close(fd);
+      shm_unlink(name);
+      return ret;
+    }
+
+  ret = psmq_shm_map(shm, fd, size);
+  if (ret < 0)
+    {
+      shm_unlink(name);
+      return ret;
+    }
+
+  memset(shm->hdr, 0, size);
+
+  hdr           = shm->hdr;
+  hdr->nslots   = nslots;
+  hdr->slotsize = slotsize;
+  hdr->stride   = stride;
+  atomic_store_explicit(&hdr->magic, PSMQ_SHM_MAGIC, memory_order_release);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: psmq_shm_open
+ ****************************************************************************/
+
+int psmq_shm_open(FAR struct psmq_shm_s *shm, FAR const char *name)
+{
+  FAR struct psmq_shm_hdr_s *hdr;
+  struct stat st;
+  int ret;
+  int fd;
+
+  fd = shm_open(name, O_RDWR, 0666);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  if (fstat(fd, &st) < 0 ||
+      (size_t)st.st_size < sizeof(struct psmq_shm_hdr_s))
+    {
+      close(fd);
+      return -EINVAL;
+    }
+
+  ret = psmq_shm_map(shm, fd, st.st_size);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  hdr = shm->hdr;
+  if (atomic_load_explicit(&hdr->magic, memory_order_acquire) !=
+      PSMQ_SHM_MAGIC ||
+      PSMQ_SHM_ALIGN(sizeof(*hdr)) + (size_t)hdr->nslots * hdr->stride >
+      shm->size)
+    {
+      psmq_shm_close(shm);
+      return -EINVAL;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: psmq_shm_close
+ ****************************************************************************/
+
+void psmq_shm_close(FAR struct psmq_shm_s *shm)
+{
+  munmap(shm->hdr, shm->size);
+  shm->hdr = NULL;
+}
+
+/****************************************************************************
+ * Name: psmq_shm_slotsize
+ ****************************************************************************/
+
+size_t psmq_shm_slotsize(FAR const struct psmq_shm_s *shm)
+{
+  return shm->hdr->slotsize;
+}
+
+/****************************************************************************
+ * Name: psmq_shm_alloc
+ ****************************************************************************/
+
+FAR void *psmq_shm_alloc(FAR struct psmq_shm_s *shm,
+                         FAR struct psmq_shm_desc_s *desc)
+{
+  FAR struct psmq_shm_hdr_s *hdr = shm->hdr;
+  FAR struct psmq_shm_slot_s *slot;
+  unsigned int refs;
+  uint32_t index;
+  uint32_t i;
+
+  /* Skip the slots that are being read, at most once around the ring */
+
+  for (i = 0; i < hdr->nslots; i++)
+    {
+      index = atomic_fetch_add_explicit(&hdr->next, 1,
+                                        memory_order_relaxed) % hdr->nslots;
+      slot  = psmq_shm_slot(shm, index);
+      refs  = 0;
+
+      if (atomic_compare_exchange_strong_explicit(&slot->refs, &refs,
+                                                  PSMQ_SHM_WRITING,
+                                                  memory_order_acquire,
+                                                  memory_order_relaxed))
+        {
+          atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+          desc->slot = index;
+          desc->seq  = 0;
+          desc->len  = 0;
+          return slot + 1;
+        }
+    }
+
+  errno = EBUSY;
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: psmq_shm_commit
+ ****************************************************************************/
+
+void psmq_shm_commit(FAR struct psmq_shm_s *shm,
+                     FAR struct psmq_shm_desc_s *desc, size_t len)
+{
+  FAR struct psmq_shm_slot_s *slot = psmq_shm_slot(shm, desc->slot);
+  uint32_t seq;
+
+  /* Zero marks a slot being written, so that no descriptor matches it */
+
+  do
+    {
+      seq = atomic_fetch_add_explicit(&shm->hdr->seq, 1,
+                                      memory_order_relaxed) + 1;
+    }
+  while (seq == 0);
+
+  desc->seq = seq;
+  desc->len = len;
+  slot->len = len;
+
+  atomic_store_explicit(&slot->seq, seq, memory_order_relaxed);
+  atomic_fetch_sub_explicit(&slot->refs, PSMQ_SHM_WRITING,
+                            memory_order_release);
+}
+
+/****************************************************************************
+ * Name: psmq_shm_get
+ ****************************************************************************/
+
+FAR const void *psmq_shm_get(FAR struct psmq_shm_s *shm,
+                             FAR const struct psmq_shm_desc_s *desc)
+{
+  FAR struct psmq_shm_slot_s *slot;
+  unsigned int refs;
+
+  if (desc->slot >= shm->hdr->nslots || desc->len > shm->hdr->slotsize)
+    {
+      errno = EINVAL;
+      return NULL;
+    }
+
+  /* The reference keeps the publisher away from the slot, so that the
+   * publish number checked after it stays valid until psmq_shm_put().
+   */
+
+  slot = psmq_shm_slot(shm, desc->slot);
+  refs = atomic_fetch_add_explicit(&slot->refs, 1, memory_order_acquire);
+  if ((refs & PSMQ_SHM_WRITING) != 0 ||
+      atomic_load_explicit(&slot->seq, memory_order_relaxed) != desc->seq)
+    {
+      atomic_fetch_sub_explicit(&slot->refs, 1, memory_order_relaxed);
+      errno = ESTALE;
+      return NULL;
+    }
+
+  return slot + 1;
+}
+
+/****************************************************************************
+ * Name: psmq_shm_put
+ ****************************************************************************/
+
+void psmq_shm_put(FAR struct psmq_shm_s *shm,
+                  FAR const struct psmq_shm_desc_s *desc)
+{
+  FAR struct psmq_shm_slot_s *slot = psmq_shm_slot(shm, desc->slot);
+
+  atomic_fetch_sub_explicit(&slot->refs, 1, memory_order_release);
+}
@@ -0,0 +1,339 @@
+/****************************************************************************
+ * apps/system/psmq/psmq_shm_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/mman.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <mqueue.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+
+#include "system/psmq_shm.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_MAXSUBS   8
+#define BENCH_QDEPTH    8
+#define BENCH_SHMNAME   "psmq_bench"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Both paths fan a publish out to one queue per subscriber, as psmqd does.
+ * The mqueue path copies the payload into every queue; the shared memory
+ * path writes it once into the pool and queues its descriptor.
+ */
+
+struct bench_sub_s
+{
+  pthread_t     thread;
+  mqd_t         mq;
+  bool          shm;
+  size_t        msgsize;
+  unsigned long count;
+  unsigned long stale;
+  uint32_t      sum;
+  FAR struct psmq_shm_s *pool;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint64_t bench_now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static FAR void *bench_sub(FAR void *arg)
+{
+  FAR struct bench_sub_s *sub = arg;
+  FAR const uint8_t *data;
+  struct psmq_shm_desc_s desc;
+  FAR uint8_t *buf;
+  unsigned long i;
+  ssize_t len;
+
+  buf = malloc(sub->msgsize);
+  if (buf == NULL)
+    {
+      return NULL;
+    }
+
+  for (i = 0; i < sub->count; i++)
+    {
+      len = mq_receive(sub->mq, (FAR char *)buf, sub->msgsize, NULL);
+      if (len < 0)
+        {
+          break;
+        }
+
+      /* Read the payload once on both paths, as a consumer would */
+
+      if (sub->shm)
+        {
+          memcpy(&desc, buf, sizeof(desc));
+          data = psmq_shm_get(sub->pool, &desc);
+          if (data == NULL)
+            {
+              sub->stale++;
+              continue;
+            }
+
+          sub->sum += data[0] + data[desc.len - 1];
+          psmq_shm_put(sub->pool, &desc);
+        }
+      else
+        {
+          sub->sum += buf[0] + buf[len - 1];
+        }
+    }
+
+  free(buf);
+  return NULL;
+}
+
+static int bench_run(bool shm, size_t paylen, int nsubs,
+                     unsigned long count)
+{
+  struct bench_sub_s subs[BENCH_MAXSUBS];
+  struct psmq_shm_desc_s desc;
+  struct psmq_shm_s pool;
+  struct mq_attr attr;
+  FAR uint8_t *payload;
+  FAR uint8_t *buf;
+  unsigned long stale = 0;
+  unsigned long i;
+  char name[16];
+  uint64_t start;
+  uint64_t us;
+  int ret = 0;
+  int n;
+
+  /* More slots than the descriptors that can be in flight, so that no
+   * subscriber should see a reused slot.
+   */
+
+  if (shm)
+    {
+      ret = psmq_shm_create(&pool, BENCH_SHMNAME,
+                            2 * (BENCH_QDEPTH + 1), paylen);
+      if (ret < 0)
+        {
+          fprintf(stderr, "psmq_shm_create failed: %d\n", ret);
+          return ret;
+        }
+    }
+
+  buf = malloc(paylen);
+  if (buf == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout_with_pool;
+    }
+
+  attr.mq_maxmsg  = BENCH_QDEPTH;
+  attr.mq_msgsize = shm ? sizeof(desc) : paylen;
+  attr.mq_flags   = 0;
+
+  for (n = 0; n < nsubs; n++)
+    {
+      snprintf(name, sizeof(name), "/psmqb%d", n);
+      mq_unlink(name);
+
+      subs[n].mq      = mq_open(name, O_RDWR | O_CREAT, 0666, &attr);
+      subs[n].shm     = shm;
+      subs[n].msgsize = attr.mq_msgsize;
+      subs[n].count   = count;
+      subs[n].stale   = 0;
+      subs[n].sum     = 0;
+      subs[n].pool    = &pool;
+
+      if (subs[n].mq == (mqd_t)-1 ||
+          pthread_create(&subs[n].thread, NULL, bench_sub, &subs[n]) != 0)
+        {
+          fprintf(stderr, "subscriber %d failed: %d\n", n, errno);
+          if (subs[n].mq != (mqd_t)-1)
+            {
+              mq_close(subs[n].mq);
+              mq_unlink(name);
+            }
+
+          nsubs = n;
+          count = 0;
+          ret = -ENOMEM;
+          break;
+        }
+    }
+
+  start = bench_now_us();
+
+  for (i = 0; i < count; i++)
+    {
+      if (shm)
+        {
+          payload = psmq_shm_alloc(&pool, &desc);
+          if (payload == NULL)
+            {
+              ret = -errno;
+              break;
+            }
+
+          memset(payload, (int)i, paylen);
+          psmq_shm_commit(&pool, &desc, paylen);
+
+          for (n = 0; n < nsubs; n++)
+            {
+              mq_send(subs[n].mq, (FAR const char *)&desc, sizeof(desc), 0);
+            }
+        }
+      else
+        {
+          memset(buf, (int)i, paylen);
+
+          for (n = 0; n < nsubs; n++)
+            {
+              mq_send(subs[n].mq, (FAR const char *)buf, paylen, 0);
+            }
+        }
+    }
+
+  /* A failed publish leaves the subscribers short of messages; closing
+   * their queues does not wake them, so they are cancelled instead.
+   */
+
+  for (n = 0; n < nsubs; n++)
+    {
+      if (i < subs[n].count)
+        {
+          pthread_cancel(subs[n].thread);
+        }
+
+      pthread_join(subs[n].thread, NULL);
+      stale += subs[n].stale;
+    }
+
+  us = bench_now_us() - start;
+
+  if (ret == 0)
+    {
+      printf("%-6s %6zu bytes %d subs: %8" PRIu64 " us, "
+             "%6" PRIu64 " ns/publish, %lu stale\n",
+             shm ? "shm" : "mqueue", paylen, nsubs, us,
+             us * 1000 / (count ? count : 1), stale);
+    }
+
+  for (n = 0; n < nsubs; n++)
+    {
+      snprintf(name, sizeof(name), "/psmqb%d", n);
+      mq_close(subs[n].mq);
+      mq_unlink(name);
+    }
+
+  free(buf);
+
+errout_with_pool:
+  if (shm)
+    {
+      psmq_shm_close(&pool);
+      shm_unlink(BENCH_SHMNAME);
+    }
+
+  return ret;
+}
+
+static void bench_usage(FAR const char *progname)
+{
+  fprintf(stderr, "Usage: %s [-s paylen] [-n subscribers] [-c count]\n",
+          progname);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: psmq_shm_bench_main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  unsigned long count = 10000;
+  size_t paylen = 64;
+  int nsubs = 4;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "s:n:c:h")) != -1)
+    {
+      switch (opt)
+        {
+          case 's':
+            paylen = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'n':
+            nsubs = atoi(optarg);
+            break;
+
+          case 'c':
+            count = strtoul(optarg, NULL, 0);
+            break;
+
+          default:
+            bench_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (paylen < 1 || nsubs < 1 || nsubs > BENCH_MAXSUBS)
+    {
+      bench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  /* The mqueue path is limited by CONFIG_MQ_MAXMSGSIZE */
+
+  if (bench_run(false, paylen, nsubs, count) < 0)
+    {
+      fprintf(stderr, "mqueue path failed, is paylen above "
+              "CONFIG_MQ_MAXMSGSIZE?\n");
+    }
+
+  return bench_run(true, paylen, nsubs, count) < 0 ?
+         EXIT_FAILURE : EXIT_SUCCESS;
+}
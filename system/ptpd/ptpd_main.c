@@ -26,6 +26,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "netutils/ptpd.h"
 
@@ -33,11 +34,38 @@
  * Private Functions
  ****************************************************************************/
 
-static int do_ptpd_start(FAR const char *interface)
+static int do_ptpd_start(int argc, FAR char *argv[])
 {
+  struct ptpd_config_s config;
   int pid;
+  int i;
 
-  pid = ptpd_start(interface);
+  memset(&config, 0, sizeof(config));
+  config.interface = argv[2];
+
+  for (i = 3; i + 1 < argc; i += 2)
+    {
+      if (strcmp(argv[i], "-u") == 0)
+        {
+          config.unicast_server = argv[i + 1];
+        }
+      else if (strcmp(argv[i], "-b") == 0)
+        {
+          config.master_port = argv[i + 1];
+        }
+      else
+        {
+          break;
+        }
+    }
+
+  if (i != argc)
+    {
+      fprintf(stderr, "ERROR: invalid option %s\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+
+  pid = ptpd_start_config(&config);
   if (pid < 0)
     {
       fprintf(stderr, "ERROR: ptpd_start() failed\n");
@@ -151,9 +179,9 @@ int do_ptpd_stop(int pid)
 
 int main(int argc, FAR char *argv[])
 {
-  if (argc == 3 && strcmp(argv[1], "start") == 0)
+  if (argc >= 3 && strcmp(argv[1], "start") == 0)
     {
-      return do_ptpd_start(argv[2]);
+      return do_ptpd_start(argc, argv);
     }
   else if (argc == 3 && strcmp(argv[1], "status") == 0)
     {
@@ -166,7 +194,8 @@ int main(int argc, FAR char *argv[])
   else
     {
       fprintf(stderr, "Usage: \n"
-                      "ptpd start <interface>\n"
+                      "ptpd start <interface> [-u <server>] "
+                      "[-b <master interface>]\n"
                       "ptpd status <pid>\n"
                       "ptpd stop <pid>\n");
       return EXIT_FAILURE;
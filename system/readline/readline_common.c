@@ -31,6 +31,11 @@
 #include <assert.h>
 #include <debug.h>
 
+#ifdef CONFIG_READLINE_CMD_HISTORY_PERSIST
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
 #include <nuttx/ascii.h>
 #include <nuttx/vt100.h>
 #include <nuttx/lib/builtin.h>
@@ -58,6 +63,10 @@ struct cmdhist_s
   int  head;                                     /* Head of the circular buffer */
   int  offset;                                   /* Offset from head */
   int  len;                                      /* Size of the circular buffer */
+#ifdef CONFIG_READLINE_CMD_HISTORY_PERSIST
+  bool loaded;                                   /* History file has been read */
+  int  unsaved;                                  /* Commands not yet saved */
+#endif
 };
 #endif /* CONFIG_READLINE_CMD_HISTORY */
 
@@ -85,10 +94,341 @@ static FAR const struct extmatch_vtable_s *g_extmatch_vtbl = NULL;
 static struct cmdhist_s g_cmdhist;
 #endif /* CONFIG_READLINE_CMD_HISTORY */
 
+#ifdef CONFIG_READLINE_CMD_HISTORY_SEARCH
+static const char g_searchprompt[] = "(reverse-i-search)'";
+static const char g_failedprompt[] = "(failed reverse-i-search)'";
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: cmdhist_entry
+ *
+ * Description:
+ *   Return the history entry 'age' commands back, 0 being the latest.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_READLINE_CMD_HISTORY
+static FAR char *cmdhist_entry(int age)
+{
+  int idx = g_cmdhist.head - age;
+
+  if (idx < 0)
+    {
+      idx += RL_CMDHIST_LEN;
+    }
+
+  return g_cmdhist.buf[idx];
+}
+
+/****************************************************************************
+ * Name: cmdhist_add
+ *
+ * Description:
+ *   Append a command to the history unless it repeats the latest one.
+ *
+ ****************************************************************************/
+
+static bool cmdhist_add(FAR const char *line, int len)
+{
+  FAR char *entry = g_cmdhist.buf[g_cmdhist.head];
+
+  if (len > RL_CMDHIST_LINELEN - 1)
+    {
+      len = RL_CMDHIST_LINELEN - 1;
+    }
+
+  /* If this command is the one at the top of the circular buffer, don't
+   * save it again.
+   */
+
+  if (g_cmdhist.len > 0 && strncmp(line, entry, len) == 0 &&
+      entry[len] == '\0')
+    {
+      return false;
+    }
+
+  g_cmdhist.head = (g_cmdhist.head + 1) % RL_CMDHIST_LEN;
+  entry = g_cmdhist.buf[g_cmdhist.head];
+  memcpy(entry, line, len);
+  entry[len] = '\0';
+
+  if (g_cmdhist.len < RL_CMDHIST_LEN)
+    {
+      g_cmdhist.len++;
+    }
+
+  return true;
+}
+#endif /* CONFIG_READLINE_CMD_HISTORY */
+
+/****************************************************************************
+ * Name: cmdhist_load
+ *
+ * Description:
+ *   Fill the history from the history file, one command per line, oldest
+ *   first.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_READLINE_CMD_HISTORY_PERSIST
+static void cmdhist_load(void)
+{
+  char line[RL_CMDHIST_LINELEN];
+  char chunk[64];
+  ssize_t nread;
+  ssize_t i;
+  int len = 0;
+  int fd;
+
+  fd = open(CONFIG_READLINE_CMD_HISTORY_FILE, O_RDONLY);
+  if (fd < 0)
+    {
+      return;
+    }
+
+  while ((nread = read(fd, chunk, sizeof(chunk))) > 0)
+    {
+      for (i = 0; i < nread; i++)
+        {
+          if (chunk[i] == '\n')
+            {
+              if (len > 0)
+                {
+                  cmdhist_add(line, len);
+                }
+
+              len = 0;
+            }
+          else if (len < RL_CMDHIST_LINELEN - 1)
+            {
+              line[len++] = chunk[i];
+            }
+        }
+    }
+
+  if (len > 0)
+    {
+      cmdhist_add(line, len);
+    }
+
+  close(fd);
+  g_cmdhist.offset = 1;
+}
+
+/****************************************************************************
+ * Name: cmdhist_save
+ ****************************************************************************/
+
+static void cmdhist_save(void)
+{
+  char line[RL_CMDHIST_LINELEN + 1];
+  size_t len;
+  int age;
+  int fd;
+
+  fd = open(CONFIG_READLINE_CMD_HISTORY_FILE,
+            O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      return;
+    }
+
+  for (age = g_cmdhist.len - 1; age >= 0; age--)
+    {
+      len = strlcpy(line, cmdhist_entry(age), sizeof(line) - 1);
+      line[len++] = '\n';
+      if (write(fd, line, len) != (ssize_t)len)
+        {
+          break;
+        }
+    }
+
+  close(fd);
+  g_cmdhist.unsaved = 0;
+}
+#endif /* CONFIG_READLINE_CMD_HISTORY_PERSIST */
+
+/****************************************************************************
+ * Name: cmdhist_find
+ *
+ * Description:
+ *   Return the age of the first history entry starting at 'age' that
+ *   contains 'query', or -1 if there is none.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_READLINE_CMD_HISTORY_SEARCH
+static int cmdhist_find(FAR const char *query, int age)
+{
+  for (; age < g_cmdhist.len; age++)
+    {
+      if (strstr(cmdhist_entry(age), query) != NULL)
+        {
+          return age;
+        }
+    }
+
+  return -1;
+}
+
+/****************************************************************************
+ * Name: cmdhist_show
+ *
+ * Description:
+ *   Replace the 'shown' characters before the cursor with the search
+ *   prompt, the query and 'text', or with 'text' alone if prompt is NULL.
+ *
+ * Returned Value:
+ *   The number of characters now shown.
+ *
+ ****************************************************************************/
+
+static int cmdhist_show(FAR struct rl_common_s *vtbl, int shown,
+                        FAR const char *prompt, FAR const char *query,
+                        FAR const char *text)
+{
+  size_t len;
+  int i;
+
+  for (i = 0; i < shown; i++)
+    {
+      RL_PUTC(vtbl, ASCII_BS);
+    }
+
+  RL_WRITE(vtbl, g_erasetoeol, sizeof(g_erasetoeol));
+
+  shown = 0;
+  if (prompt != NULL)
+    {
+      len = strlen(prompt);
+      RL_WRITE(vtbl, prompt, len);
+      shown += len;
+
+      len = strlen(query);
+      RL_WRITE(vtbl, query, len);
+      shown += len;
+
+      RL_WRITE(vtbl, "': ", 3);
+      shown += 3;
+    }
+
+  len = strlen(text);
+  RL_WRITE(vtbl, text, len);
+  return shown + len;
+}
+
+/****************************************************************************
+ * Name: cmdhist_search
+ *
+ * Description:
+ *   Ctrl-R reverse incremental search.  The line being edited is kept
+ *   unchanged in buf until a match is accepted.
+ *
+ * Returned Value:
+ *   The key that ended the search, to be processed by the caller, or 0 if
+ *   there is nothing more to do.
+ *
+ ****************************************************************************/
+
+static int cmdhist_search(FAR struct rl_common_s *vtbl, FAR char *buf,
+                          int buflen, FAR int *nch)
+{
+  char query[RL_CMDHIST_LINELEN];
+  FAR const char *entry = "";
+  bool failed = false;
+  int match = -1;
+  int qlen = 0;
+  int shown;
+  int ch;
+
+  buf[*nch] = '\0';
+  query[0]  = '\0';
+  shown     = cmdhist_show(vtbl, *nch, g_searchprompt, query, "");
+
+  for (; ; )
+    {
+      ch = RL_GETC(vtbl);
+      if (ch == ASCII_DC2)
+        {
+          /* Next older match */
+
+          if (qlen > 0)
+            {
+              int next = cmdhist_find(query, match + 1);
+              failed = next < 0;
+              if (!failed)
+                {
+                  match = next;
+                }
+            }
+        }
+      else if (ch == ASCII_BS || ch == ASCII_DEL)
+        {
+          if (qlen > 0)
+            {
+              query[--qlen] = '\0';
+              match  = qlen > 0 ? cmdhist_find(query, 0) : -1;
+              failed = qlen > 0 && match < 0;
+            }
+        }
+      else if (ch == ASCII_BEL)
+        {
+          /* Cancel: restore the line being edited */
+
+          cmdhist_show(vtbl, shown, NULL, NULL, buf);
+          return 0;
+        }
+      else if (ch != EOF && !iscntrl(ch & 0xff))
+        {
+          if (qlen < RL_CMDHIST_LINELEN - 1)
+            {
+              int next;
+
+              query[qlen++] = ch;
+              query[qlen]   = '\0';
+
+              next   = cmdhist_find(query, match < 0 ? 0 : match);
+              failed = next < 0;
+              if (!failed)
+                {
+                  match = next;
+                }
+            }
+        }
+      else
+        {
+          break;
+        }
+
+      entry = match >= 0 ? cmdhist_entry(match) : "";
+      shown = cmdhist_show(vtbl, shown,
+                           failed ? g_failedprompt : g_searchprompt,
+                           query, entry);
+    }
+
+  /* Accept the match as the line being edited */
+
+  if (match >= 0)
+    {
+      *nch = strlcpy(buf, cmdhist_entry(match), buflen - 1);
+      if (*nch > buflen - 2)
+        {
+          *nch = buflen - 2;
+        }
+
+      buf[*nch] = '\0';
+    }
+
+  cmdhist_show(vtbl, shown, NULL, NULL, buf);
+  g_cmdhist.offset = 1;
+  return ch;
+}
+#endif /* CONFIG_READLINE_CMD_HISTORY_SEARCH */
+
 /****************************************************************************
  * Name: count_builtin_matches
  *
@@ -442,6 +782,24 @@ FAR const struct extmatch_vtable_s *
 }
 #endif
 
+/****************************************************************************
+ * Name: readline_history_save
+ *
+ *   Write the command line history to CONFIG_READLINE_CMD_HISTORY_FILE if
+ *   it has changed since it was last saved.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_READLINE_CMD_HISTORY_PERSIST
+void readline_history_save(void)
+{
+  if (g_cmdhist.unsaved > 0)
+    {
+      cmdhist_save();
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: readline_common
  *
@@ -490,6 +848,14 @@ ssize_t readline_common(FAR struct rl_common_s *vtbl, FAR char *buf,
       return 0;
     }
 
+#ifdef CONFIG_READLINE_CMD_HISTORY_PERSIST
+  if (!g_cmdhist.loaded)
+    {
+      g_cmdhist.loaded = true;
+      cmdhist_load();
+    }
+#endif
+
   /* <esc>[K is the VT100 command that erases to the end of the line. */
 
 #ifdef CONFIG_READLINE_ECHO
@@ -512,6 +878,21 @@ ssize_t readline_common(FAR struct rl_common_s *vtbl, FAR char *buf,
 
       int ch = RL_GETC(vtbl);
 
+#ifdef CONFIG_READLINE_CMD_HISTORY_SEARCH
+      /* Ctrl-R starts an incremental search.  The key that ends it is
+       * then handled as usual.
+       */
+
+      if (ch == ASCII_DC2 && !escape)
+        {
+          ch = cmdhist_search(vtbl, buf, buflen, &nch);
+          if (ch == 0)
+            {
+              continue;
+            }
+        }
+#endif
+
       /* Check for end-of-file or read error */
 
       if (ch == EOF)
@@ -675,25 +1056,17 @@ ssize_t readline_common(FAR struct rl_common_s *vtbl, FAR char *buf,
 
           if (nch >= 1)
             {
-              /* If this command is the one at the top of the circular
-               * buffer, don't save it again.
-               */
-
-              if (strncmp(buf, g_cmdhist.buf[g_cmdhist.head], nch + 1) != 0)
+              if (cmdhist_add(buf, nch))
                 {
-                  g_cmdhist.head = (g_cmdhist.head + 1) % RL_CMDHIST_LEN;
-
-                  for (i = 0; (i < nch) && i < (RL_CMDHIST_LINELEN - 1); i++)
-                    {
-                      g_cmdhist.buf[g_cmdhist.head][i] = buf[i];
-                    }
-
-                  g_cmdhist.buf[g_cmdhist.head][i] = '\0';
+#ifdef CONFIG_READLINE_CMD_HISTORY_PERSIST
+                  /* Write the history file in batches */
 
-                  if (g_cmdhist.len < RL_CMDHIST_LEN)
+                  if (++g_cmdhist.unsaved >=
+                      CONFIG_READLINE_CMD_HISTORY_SAVE_COUNT)
                     {
-                      g_cmdhist.len++;
+                      cmdhist_save();
                     }
+#endif
                 }
 
               g_cmdhist.offset = 1;
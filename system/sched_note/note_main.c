@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -41,16 +42,74 @@
  ****************************************************************************/
 
 #  define syslog_time(priority, fmt, ...) \
-            syslog(priority, "%08lx: " fmt, \
-                   (unsigned long)systime, \
+            syslog(priority, "%" PRIu32 ".%09" PRIu32 ": " fmt, \
+                   systime_sec, systime_nsec, \
                    __VA_ARGS__)
 
+/* Notes are read from one device per CPU, or from the shared one */
+
+#ifdef CONFIG_SYSTEM_NOTE_PERCPU
+#  define NOTE_NSOURCES     CONFIG_SMP_NCPUS
+#else
+#  define NOTE_NSOURCES     1
+#endif
+
+#ifdef CONFIG_SMP
+#  define NOTE_NCPUS        CONFIG_SMP_NCPUS
+#  define NOTE_CPU(n)       ((n)->nc_cpu)
+#else
+#  define NOTE_NCPUS        1
+#  define NOTE_CPU(n)       0
+#endif
+
+#define NOTE_MAXENTRIES \
+  (NOTE_NSOURCES * CONFIG_SYSTEM_NOTE_BUFFERSIZE / \
+   sizeof(struct note_common_s))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Notes read from a device, not dumped yet */
+
+struct note_source_s
+{
+  int      fd;
+  size_t   len;                 /* Bytes of notes in buf */
+  bool     more;                /* The device may hold further notes */
+  uint8_t  buf[CONFIG_SYSTEM_NOTE_BUFFERSIZE];
+};
+
+/* A note in one of the source buffers.  The notes of each CPU are linked
+ * in the order they were recorded.
+ */
+
+struct note_entry_s
+{
+  uint64_t time;                /* Time stamp in ns */
+  uint32_t offset;              /* Offset in the source buffer */
+  uint8_t  source;              /* Index in g_note_sources[] */
+  uint8_t  cpu;
+  bool     done;                /* Dumped */
+  int      next;                /* Next note of the same CPU, or -1 */
+};
+
+struct note_cpustat_s
+{
+  unsigned long notes;          /* Notes dumped */
+  unsigned long late;           /* Notes older than one dumped before */
+  unsigned long bad;            /* Malformed notes thrown away */
+};
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
 static bool g_note_daemon_started;
-static uint8_t g_note_buffer[CONFIG_SYSTEM_NOTE_BUFFERSIZE];
+static struct note_source_s g_note_sources[NOTE_NSOURCES];
+static struct note_entry_s g_note_entries[NOTE_MAXENTRIES];
+static struct note_cpustat_s g_note_stats[NOTE_NCPUS];
+static uint64_t g_note_lasttime;
 
 /* Names of task/thread states */
 
@@ -96,703 +155,930 @@ static void trace_dump_unflatten(FAR void *dst,
 }
 
 /****************************************************************************
- * Name: dump_notes
+ * Name: note_time
  ****************************************************************************/
 
-static void dump_notes(size_t nread)
+static uint64_t note_time(FAR struct note_common_s *note)
+{
+  uint32_t systime_sec;
+  uint32_t systime_nsec;
+
+  trace_dump_unflatten(&systime_nsec,
+                       note->nc_systime_nsec, sizeof(systime_nsec));
+  trace_dump_unflatten(&systime_sec,
+                       note->nc_systime_sec, sizeof(systime_sec));
+
+  return (uint64_t)systime_sec * 1000000000 + systime_nsec;
+}
+
+/****************************************************************************
+ * Name: dump_note
+ ****************************************************************************/
+
+static void dump_note(FAR struct note_common_s *note)
 {
-  FAR struct note_common_s *note;
   uint32_t systime_sec;
   uint32_t systime_nsec;
   pid_t pid;
-  off_t offset;
 
-  offset = 0;
-  while (offset < nread)
+  trace_dump_unflatten(&pid, note->nc_pid, sizeof(pid));
+  trace_dump_unflatten(&systime_nsec,
+                       note->nc_systime_nsec, sizeof(systime_nsec));
+  trace_dump_unflatten(&systime_sec,
+                       note->nc_systime_sec, sizeof(systime_sec));
+
+  switch (note->nc_type)
     {
-      note    = (FAR struct note_common_s *)&g_note_buffer[offset];
-      trace_dump_unflatten(&pid, note->nc_pid, sizeof(pid));
-      trace_dump_unflatten(&systime_nsec,
-                           note->nc_systime_nsec, sizeof(systime_nsec));
-      trace_dump_unflatten(&systime_sec,
-                           note->nc_systime_sec, sizeof(systime_sec));
-
-      switch (note->nc_type)
+      case NOTE_START:
         {
-          case NOTE_START:
-            {
-              FAR struct note_start_s *note_start =
-                (FAR struct note_start_s *)note;
+          FAR struct note_start_s *note_start =
+            (FAR struct note_start_s *)note;
 
-              if (note->nc_length < sizeof(struct note_start_s))
-                {
-                  syslog(LOG_ERR,
-                         "Note too small for \"Start\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
+          if (note->nc_length < sizeof(struct note_start_s))
+            {
+              syslog(LOG_ERR,
+                     "Note too small for \"Start\" note: %d\n",
+                     note->nc_length);
+              return;
+            }
 
 #ifdef CONFIG_SMP
 #if CONFIG_TASK_NAME_SIZE > 0
-              syslog_time(LOG_INFO,
-                     "Task %u \"%s\" started, CPU%u, priority %u\n",
-                     (unsigned int)pid,
-                     note_start->nst_name, (unsigned int)note->nc_cpu,
-                     (unsigned int)note->nc_priority);
+          syslog_time(LOG_INFO,
+                 "Task %u \"%s\" started, CPU%u, priority %u\n",
+                 (unsigned int)pid,
+                 note_start->nst_name, (unsigned int)note->nc_cpu,
+                 (unsigned int)note->nc_priority);
 #else
-              syslog_time(LOG_INFO,
-                     "Task %u started, CPU%u, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_cpu,
-                     (unsigned int)note->nc_priority);
+          syslog_time(LOG_INFO,
+                 "Task %u started, CPU%u, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_cpu,
+                 (unsigned int)note->nc_priority);
 #endif
 #else
 #if CONFIG_TASK_NAME_SIZE > 0
-              syslog_time(LOG_INFO,
-                     "Task %u \"%s\" started, priority %u\n",
-                     (unsigned int)pid,
-                     note_start->nst_name, (unsigned int)note->nc_priority);
+          syslog_time(LOG_INFO,
+                 "Task %u \"%s\" started, priority %u\n",
+                 (unsigned int)pid,
+                 note_start->nst_name, (unsigned int)note->nc_priority);
 #else
-              syslog_time(LOG_INFO,
-                     "Task %u started, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_priority);
+          syslog_time(LOG_INFO,
+                 "Task %u started, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_priority);
 #endif
 #endif
-            }
-            break;
+        }
+        break;
 
-          case NOTE_STOP:
+      case NOTE_STOP:
+        {
+          if (note->nc_length != sizeof(struct note_stop_s))
             {
-              if (note->nc_length != sizeof(struct note_stop_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"Stop\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
+              syslog(LOG_ERR,
+                     "Size incorrect for \"Stop\" note: %d\n",
+                     note->nc_length);
+              return;
+            }
 
 #ifdef CONFIG_SMP
-              syslog_time(LOG_INFO,
-                     "Task %u stopped, CPU%u, priority %u\n",
-                     (unsigned int)pid, (unsigned int)note->nc_cpu,
-                     (unsigned int)note->nc_priority);
+          syslog_time(LOG_INFO,
+                 "Task %u stopped, CPU%u, priority %u\n",
+                 (unsigned int)pid, (unsigned int)note->nc_cpu,
+                 (unsigned int)note->nc_priority);
 #else
-              syslog_time(LOG_INFO,
-                     "Task %u stopped, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_priority);
+          syslog_time(LOG_INFO,
+                 "Task %u stopped, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_priority);
 #endif
-            }
-            break;
+        }
+        break;
 
 #ifdef CONFIG_SCHED_INSTRUMENTATION_SWITCH
-          case NOTE_SUSPEND:
+      case NOTE_SUSPEND:
+        {
+          FAR struct note_suspend_s *note_suspend =
+            (FAR struct note_suspend_s *)note;
+          FAR const char *statename;
+
+          if (note->nc_length != sizeof(struct note_suspend_s))
             {
-              FAR struct note_suspend_s *note_suspend =
-                (FAR struct note_suspend_s *)note;
-              FAR const char *statename;
-
-              if (note->nc_length != sizeof(struct note_suspend_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"Suspend\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
-
-              if (note_suspend->nsu_state < NSTATES)
-                {
-                  statename = g_statenames[note_suspend->nsu_state];
-                }
-              else
-                {
-                  statename = "ERROR";
-                }
+              syslog(LOG_ERR,
+                     "Size incorrect for \"Suspend\" note: %d\n",
+                     note->nc_length);
+              return;
+            }
+
+          if (note_suspend->nsu_state < NSTATES)
+            {
+              statename = g_statenames[note_suspend->nsu_state];
+            }
+          else
+            {
+              statename = "ERROR";
+            }
 
 #ifdef CONFIG_SMP
-              syslog_time(LOG_INFO,
-                     "Task %u suspended, CPU%u, priority %u, state \"%s\"\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_cpu,
-                     (unsigned int)note->nc_priority, statename);
+          syslog_time(LOG_INFO,
+                 "Task %u suspended, CPU%u, priority %u, state \"%s\"\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_cpu,
+                 (unsigned int)note->nc_priority, statename);
 #else
-              syslog_time(LOG_INFO,
-                     "Task %u suspended, priority %u, state \"%s\"\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_priority, statename);
+          syslog_time(LOG_INFO,
+                 "Task %u suspended, priority %u, state \"%s\"\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_priority, statename);
 #endif
-            }
-            break;
+        }
+        break;
 
-          case NOTE_RESUME:
+      case NOTE_RESUME:
+        {
+          if (note->nc_length != sizeof(struct note_resume_s))
             {
-              if (note->nc_length != sizeof(struct note_resume_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"Resume\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
+              syslog(LOG_ERR,
+                     "Size incorrect for \"Resume\" note: %d\n",
+                     note->nc_length);
+              return;
+            }
 
 #ifdef CONFIG_SMP
-              syslog_time(LOG_INFO,
-                     "Task %u resumed, CPU%u, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_cpu,
-                     (unsigned int)note->nc_priority);
+          syslog_time(LOG_INFO,
+                 "Task %u resumed, CPU%u, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_cpu,
+                 (unsigned int)note->nc_priority);
 #else
-              syslog_time(LOG_INFO,
-                     "Task %u resumed, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_priority);
+          syslog_time(LOG_INFO,
+                 "Task %u resumed, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_priority);
 #endif
-            }
-            break;
+        }
+        break;
 #endif
 
 #ifdef CONFIG_SMP
-          case NOTE_CPU_START:
-            {
-              FAR struct note_cpu_start_s *note_start =
-                (FAR struct note_cpu_start_s *)note;
-
-              if (note->nc_length != sizeof(struct note_cpu_start_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"CPU Start\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
+      case NOTE_CPU_START:
+        {
+          FAR struct note_cpu_start_s *note_start =
+            (FAR struct note_cpu_start_s *)note;
 
-              syslog_time(LOG_INFO,
-                     "Task %u CPU%u requests CPU%u to start, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_cpu,
-                     (unsigned int)note_start->ncs_target,
-                     (unsigned int)note->nc_priority);
+          if (note->nc_length != sizeof(struct note_cpu_start_s))
+            {
+              syslog(LOG_ERR,
+                     "Size incorrect for \"CPU Start\" note: %d\n",
+                     note->nc_length);
+              return;
             }
-            break;
 
-          case NOTE_CPU_STARTED:
-            {
-              if (note->nc_length != sizeof(struct note_cpu_started_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"CPU started\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
+          syslog_time(LOG_INFO,
+                 "Task %u CPU%u requests CPU%u to start, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_cpu,
+                 (unsigned int)note_start->ncs_target,
+                 (unsigned int)note->nc_priority);
+        }
+        break;
 
-              syslog_time(LOG_INFO,
-                     "Task %u CPU%u has started, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_cpu,
-                     (unsigned int)note->nc_priority);
+      case NOTE_CPU_STARTED:
+        {
+          if (note->nc_length != sizeof(struct note_cpu_started_s))
+            {
+              syslog(LOG_ERR,
+                     "Size incorrect for \"CPU started\" note: %d\n",
+                     note->nc_length);
+              return;
             }
-            break;
 
-#ifdef CONFIG_SCHED_INSTRUMENTATION_SWITCH
-          case NOTE_CPU_PAUSE:
-            {
-              FAR struct note_cpu_pause_s *note_pause =
-                (FAR struct note_cpu_pause_s *)note;
+          syslog_time(LOG_INFO,
+                 "Task %u CPU%u has started, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_cpu,
+                 (unsigned int)note->nc_priority);
+        }
+        break;
 
-              if (note->nc_length != sizeof(struct note_cpu_pause_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"CPU pause\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
+#ifdef CONFIG_SCHED_INSTRUMENTATION_SWITCH
+      case NOTE_CPU_PAUSE:
+        {
+          FAR struct note_cpu_pause_s *note_pause =
+            (FAR struct note_cpu_pause_s *)note;
 
-              syslog_time(LOG_INFO,
-                     "Task %u CPU%u requests CPU%u to pause, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_cpu,
-                     (unsigned int)note_pause->ncp_target,
-                     (unsigned int)note->nc_priority);
+          if (note->nc_length != sizeof(struct note_cpu_pause_s))
+            {
+              syslog(LOG_ERR,
+                     "Size incorrect for \"CPU pause\" note: %d\n",
+                     note->nc_length);
+              return;
             }
-            break;
 
-          case NOTE_CPU_PAUSED:
-            {
-              if (note->nc_length != sizeof(struct note_cpu_paused_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"CPU paused\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
+          syslog_time(LOG_INFO,
+                 "Task %u CPU%u requests CPU%u to pause, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_cpu,
+                 (unsigned int)note_pause->ncp_target,
+                 (unsigned int)note->nc_priority);
+        }
+        break;
 
-              syslog_time(LOG_INFO,
-                     "Task %u CPU%u has paused, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_cpu,
-                     (unsigned int)note->nc_priority);
+      case NOTE_CPU_PAUSED:
+        {
+          if (note->nc_length != sizeof(struct note_cpu_paused_s))
+            {
+              syslog(LOG_ERR,
+                     "Size incorrect for \"CPU paused\" note: %d\n",
+                     note->nc_length);
+              return;
             }
-            break;
 
-          case NOTE_CPU_RESUME:
-            {
-              FAR struct note_cpu_resume_s *note_resume =
-                (FAR struct note_cpu_resume_s *)note;
+          syslog_time(LOG_INFO,
+                 "Task %u CPU%u has paused, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_cpu,
+                 (unsigned int)note->nc_priority);
+        }
+        break;
 
-              if (note->nc_length != sizeof(struct note_cpu_resume_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"CPU resume\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
+      case NOTE_CPU_RESUME:
+        {
+          FAR struct note_cpu_resume_s *note_resume =
+            (FAR struct note_cpu_resume_s *)note;
 
-              syslog_time(LOG_INFO,
-                     "Task %u CPU%u requests CPU%u to resume, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_cpu,
-                     (unsigned int)note_resume->ncr_target,
-                     (unsigned int)note->nc_priority);
+          if (note->nc_length != sizeof(struct note_cpu_resume_s))
+            {
+              syslog(LOG_ERR,
+                     "Size incorrect for \"CPU resume\" note: %d\n",
+                     note->nc_length);
+              return;
             }
-            break;
 
-          case NOTE_CPU_RESUMED:
-            {
-              if (note->nc_length != sizeof(struct note_cpu_resumed_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"CPU resumed\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
+          syslog_time(LOG_INFO,
+                 "Task %u CPU%u requests CPU%u to resume, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_cpu,
+                 (unsigned int)note_resume->ncr_target,
+                 (unsigned int)note->nc_priority);
+        }
+        break;
 
-              syslog_time(LOG_INFO,
-                     "Task %u CPU%u has resumed, priority %u\n",
-                     (unsigned int)pid,
-                     (unsigned int)note->nc_cpu,
-                     (unsigned int)note->nc_priority);
+      case NOTE_CPU_RESUMED:
+        {
+          if (note->nc_length != sizeof(struct note_cpu_resumed_s))
+            {
+              syslog(LOG_ERR,
+                     "Size incorrect for \"CPU resumed\" note: %d\n",
+                     note->nc_length);
+              return;
             }
-            break;
+
+          syslog_time(LOG_INFO,
+                 "Task %u CPU%u has resumed, priority %u\n",
+                 (unsigned int)pid,
+                 (unsigned int)note->nc_cpu,
+                 (unsigned int)note->nc_priority);
+        }
+        break;
 #endif
 #endif
 
 #ifdef CONFIG_SCHED_INSTRUMENTATION_PREEMPTION
-          case NOTE_PREEMPT_LOCK:
-          case NOTE_PREEMPT_UNLOCK:
+      case NOTE_PREEMPT_LOCK:
+      case NOTE_PREEMPT_UNLOCK:
+        {
+          FAR struct note_preempt_s *note_preempt =
+            (FAR struct note_preempt_s *)note;
+          uint16_t count;
+
+          if (note->nc_length != sizeof(struct note_preempt_s))
+            {
+              syslog(LOG_ERR,
+                     "Size incorrect for \"Preemption\" note: %d\n",
+                     note->nc_length);
+              return;
+            }
+
+          trace_dump_unflatten(&count, note_preempt->npr_count,
+                               sizeof(count));
+
+          if (note->nc_type == NOTE_PREEMPT_LOCK)
             {
-              FAR struct note_preempt_s *note_preempt =
-                (FAR struct note_preempt_s *)note;
-              uint16_t count;
-
-              if (note->nc_length != sizeof(struct note_preempt_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"Preemption\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
-
-              trace_dump_unflatten(&count, note_preempt->npr_count,
-                                   sizeof(count));
-
-              if (note->nc_type == NOTE_PREEMPT_LOCK)
-                {
 #ifdef CONFIG_SMP
-                  syslog_time(LOG_INFO,
-                         "Task %u locked, CPU%u, priority %u, count=%u\n",
-                         (unsigned int)pid, (unsigned int)note->nc_cpu,
-                         (unsigned int)note->nc_priority,
-                         (unsigned int)count);
+              syslog_time(LOG_INFO,
+                     "Task %u locked, CPU%u, priority %u, count=%u\n",
+                     (unsigned int)pid, (unsigned int)note->nc_cpu,
+                     (unsigned int)note->nc_priority,
+                     (unsigned int)count);
 #else
-                  syslog_time(LOG_INFO,
-                         "Task %u locked, priority %u, count=%u\n",
-                         (unsigned int)pid,
-                         (unsigned int)note->nc_priority,
-                         (unsigned int)count);
+              syslog_time(LOG_INFO,
+                     "Task %u locked, priority %u, count=%u\n",
+                     (unsigned int)pid,
+                     (unsigned int)note->nc_priority,
+                     (unsigned int)count);
 #endif
-                }
-              else
-                {
+            }
+          else
+            {
 #ifdef CONFIG_SMP
-                  syslog_time(LOG_INFO,
-                         "Task %u unlocked, CPU%u, priority %u, count=%u\n",
-                         (unsigned int)pid, (unsigned int)note->nc_cpu,
-                         (unsigned int)note->nc_priority,
-                         (unsigned int)count);
+              syslog_time(LOG_INFO,
+                     "Task %u unlocked, CPU%u, priority %u, count=%u\n",
+                     (unsigned int)pid, (unsigned int)note->nc_cpu,
+                     (unsigned int)note->nc_priority,
+                     (unsigned int)count);
 #else
-                  syslog_time(LOG_INFO,
-                         "Task %u unlocked, priority %u, count=%u\n",
-                         (unsigned int)pid,
-                         (unsigned int)note->nc_priority,
-                         (unsigned int)count);
+              syslog_time(LOG_INFO,
+                     "Task %u unlocked, priority %u, count=%u\n",
+                     (unsigned int)pid,
+                     (unsigned int)note->nc_priority,
+                     (unsigned int)count);
 #endif
-                }
             }
-            break;
+        }
+        break;
 
 #endif
 
 #ifdef CONFIG_SCHED_INSTRUMENTATION_CSECTION
-          case NOTE_CSECTION_ENTER:
-          case NOTE_CSECTION_LEAVE:
-            {
+      case NOTE_CSECTION_ENTER:
+      case NOTE_CSECTION_LEAVE:
+        {
 #ifdef CONFIG_SMP
-              FAR struct note_csection_s *note_csection =
-                (FAR struct note_csection_s *)note;
-              uint16_t count;
+          FAR struct note_csection_s *note_csection =
+            (FAR struct note_csection_s *)note;
+          uint16_t count;
 #endif
 
-              if (note->nc_length != sizeof(struct note_csection_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"csection\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
+          if (note->nc_length != sizeof(struct note_csection_s))
+            {
+              syslog(LOG_ERR,
+                     "Size incorrect for \"csection\" note: %d\n",
+                     note->nc_length);
+              return;
+            }
 
 #ifdef CONFIG_SMP
-              trace_dump_unflatten(&count, note_csection->ncs_count,
-                                   sizeof(count));
-
-              if (note->nc_type == NOTE_CSECTION_ENTER)
-                {
-                  syslog_time(LOG_INFO,
-                         "Task %u enter csection, CPU%u, priority %u, "
-                         "count=%u\n",
-                         (unsigned int)pid, (unsigned int)note->nc_cpu,
-                         (unsigned int)note->nc_priority,
-                         (unsigned int)count);
-                }
-              else
-                {
-                  syslog_time(LOG_INFO,
-                         "Task %u leave csection, CPU%u, priority %u, "
-                         "count=%u\n",
-                         (unsigned int)pid, (unsigned int)note->nc_cpu,
-                         (unsigned int)note->nc_priority,
-                         (unsigned int)count);
-                }
+          trace_dump_unflatten(&count, note_csection->ncs_count,
+                               sizeof(count));
+
+          if (note->nc_type == NOTE_CSECTION_ENTER)
+            {
+              syslog_time(LOG_INFO,
+                     "Task %u enter csection, CPU%u, priority %u, "
+                     "count=%u\n",
+                     (unsigned int)pid, (unsigned int)note->nc_cpu,
+                     (unsigned int)note->nc_priority,
+                     (unsigned int)count);
+            }
+          else
+            {
+              syslog_time(LOG_INFO,
+                     "Task %u leave csection, CPU%u, priority %u, "
+                     "count=%u\n",
+                     (unsigned int)pid, (unsigned int)note->nc_cpu,
+                     (unsigned int)note->nc_priority,
+                     (unsigned int)count);
+            }
 #else
-              if (note->nc_type == NOTE_CSECTION_ENTER)
-                {
-                  syslog_time(LOG_INFO,
-                         "Task %u enter csection, priority %u\n",
-                         (unsigned int)pid,
-                         (unsigned int)note->nc_priority);
-                }
-              else
-                {
-                  syslog_time(LOG_INFO,
-                         "Task %u leave csection, priority %u\n",
-                         (unsigned int)pid,
-                         (unsigned int)note->nc_priority);
-                }
-#endif
+          if (note->nc_type == NOTE_CSECTION_ENTER)
+            {
+              syslog_time(LOG_INFO,
+                     "Task %u enter csection, priority %u\n",
+                     (unsigned int)pid,
+                     (unsigned int)note->nc_priority);
+            }
+          else
+            {
+              syslog_time(LOG_INFO,
+                     "Task %u leave csection, priority %u\n",
+                     (unsigned int)pid,
+                     (unsigned int)note->nc_priority);
             }
-            break;
+#endif
+        }
+        break;
 #endif
 
 #ifdef CONFIG_SCHED_INSTRUMENTATION_SPINLOCKS
-          case NOTE_SPINLOCK_LOCK:
-          case NOTE_SPINLOCK_LOCKED:
-          case NOTE_SPINLOCK_UNLOCK:
-          case NOTE_SPINLOCK_ABORT:
+      case NOTE_SPINLOCK_LOCK:
+      case NOTE_SPINLOCK_LOCKED:
+      case NOTE_SPINLOCK_UNLOCK:
+      case NOTE_SPINLOCK_ABORT:
+        {
+          FAR struct note_spinlock_s *note_spinlock =
+            (FAR struct note_spinlock_s *)note;
+          FAR void *spinlock;
+
+          if (note->nc_length != sizeof(struct note_spinlock_s))
             {
-              FAR struct note_spinlock_s *note_spinlock =
-                (FAR struct note_spinlock_s *)note;
-              FAR void *spinlock;
-
-              if (note->nc_length != sizeof(struct note_spinlock_s))
-                {
-                  syslog(LOG_ERR,
-                         "Size incorrect for \"Spinlock\" note: %d\n",
-                         note->nc_length);
-                  return;
-                }
-
-              trace_dump_unflatten(&spinlock,
-                                   note_spinlock->nsp_spinlock,
-                                   sizeof(spinlock));
-
-             switch (note->nc_type)
-               {
+              syslog(LOG_ERR,
+                     "Size incorrect for \"Spinlock\" note: %d\n",
+                     note->nc_length);
+              return;
+            }
+
+          trace_dump_unflatten(&spinlock,
+                               note_spinlock->nsp_spinlock,
+                               sizeof(spinlock));
+
+         switch (note->nc_type)
+           {
 #ifdef CONFIG_SMP
-                case NOTE_SPINLOCK_LOCK:
-                  {
-                    syslog_time(LOG_INFO,
-                           "Task %u CPU%u wait for spinlock=%p value=%u "
-                           "priority %u\n",
-                           (unsigned int)pid,
-                           (unsigned int)note->nc_cpu,
-                           spinlock,
-                           (unsigned int)note_spinlock->nsp_value,
-                           (unsigned int)note->nc_priority);
-                  }
-                  break;
+            case NOTE_SPINLOCK_LOCK:
+              {
+                syslog_time(LOG_INFO,
+                       "Task %u CPU%u wait for spinlock=%p value=%u "
+                       "priority %u\n",
+                       (unsigned int)pid,
+                       (unsigned int)note->nc_cpu,
+                       spinlock,
+                       (unsigned int)note_spinlock->nsp_value,
+                       (unsigned int)note->nc_priority);
+              }
+              break;
 
-                case NOTE_SPINLOCK_LOCKED:
-                  {
-                    syslog_time(LOG_INFO,
-                           "Task %u CPU%u has spinlock=%p value=%u "
-                           "priority %u\n",
-                           (unsigned int)pid,
-                           (unsigned int)note->nc_cpu,
-                           spinlock,
-                           (unsigned int)note_spinlock->nsp_value,
-                           (unsigned int)note->nc_priority);
-                  }
-                  break;
+            case NOTE_SPINLOCK_LOCKED:
+              {
+                syslog_time(LOG_INFO,
+                       "Task %u CPU%u has spinlock=%p value=%u "
+                       "priority %u\n",
+                       (unsigned int)pid,
+                       (unsigned int)note->nc_cpu,
+                       spinlock,
+                       (unsigned int)note_spinlock->nsp_value,
+                       (unsigned int)note->nc_priority);
+              }
+              break;
 
-                case NOTE_SPINLOCK_UNLOCK:
-                  {
-                    syslog_time(LOG_INFO,
-                           "Task %u CPU%u unlocking spinlock=%p value=%u "
-                           "priority %u\n",
-                           (unsigned int)pid,
-                           (unsigned int)note->nc_cpu,
-                           spinlock,
-                           (unsigned int)note_spinlock->nsp_value,
-                           (unsigned int)note->nc_priority);
-                  }
-                  break;
+            case NOTE_SPINLOCK_UNLOCK:
+              {
+                syslog_time(LOG_INFO,
+                       "Task %u CPU%u unlocking spinlock=%p value=%u "
+                       "priority %u\n",
+                       (unsigned int)pid,
+                       (unsigned int)note->nc_cpu,
+                       spinlock,
+                       (unsigned int)note_spinlock->nsp_value,
+                       (unsigned int)note->nc_priority);
+              }
+              break;
 
-                case NOTE_SPINLOCK_ABORT:
-                  {
-                    syslog_time(LOG_INFO,
-                           "Task %u CPU%u abort wait on spinlock=%p "
-                           "value=%u priority %u\n",
-                           (unsigned int)pid,
-                           (unsigned int)note->nc_cpu,
-                           spinlock,
-                           (unsigned int)note_spinlock->nsp_value,
-                           (unsigned int)note->nc_priority);
-                  }
-                  break;
+            case NOTE_SPINLOCK_ABORT:
+              {
+                syslog_time(LOG_INFO,
+                       "Task %u CPU%u abort wait on spinlock=%p "
+                       "value=%u priority %u\n",
+                       (unsigned int)pid,
+                       (unsigned int)note->nc_cpu,
+                       spinlock,
+                       (unsigned int)note_spinlock->nsp_value,
+                       (unsigned int)note->nc_priority);
+              }
+              break;
 #else
-                case NOTE_SPINLOCK_LOCK:
-                  {
-                    syslog_time(LOG_INFO,
-                           "Task %u wait for spinlock=%p value=%u "
-                           "priority %u\n",
-                           (unsigned int)pid,
-                           spinlock,
-                           (unsigned int)note_spinlock->nsp_value,
-                           (unsigned int)note->nc_priority);
-                  }
-                  break;
+            case NOTE_SPINLOCK_LOCK:
+              {
+                syslog_time(LOG_INFO,
+                       "Task %u wait for spinlock=%p value=%u "
+                       "priority %u\n",
+                       (unsigned int)pid,
+                       spinlock,
+                       (unsigned int)note_spinlock->nsp_value,
+                       (unsigned int)note->nc_priority);
+              }
+              break;
 
-                case NOTE_SPINLOCK_LOCKED:
-                  {
-                    syslog_time(LOG_INFO,
-                           "Task %u has spinlock=%p value=%u priority %u\n",
-                           (unsigned int)pid,
-                           spinlock,
-                           (unsigned int)note_spinlock->nsp_value,
-                           (unsigned int)note->nc_priority);
-                  }
-                  break;
+            case NOTE_SPINLOCK_LOCKED:
+              {
+                syslog_time(LOG_INFO,
+                       "Task %u has spinlock=%p value=%u priority %u\n",
+                       (unsigned int)pid,
+                       spinlock,
+                       (unsigned int)note_spinlock->nsp_value,
+                       (unsigned int)note->nc_priority);
+              }
+              break;
 
-                case NOTE_SPINLOCK_UNLOCK:
-                  {
-                    syslog_time(LOG_INFO,
-                           "Task %u unlocking spinlock=%p value=%u "
-                           "priority %u\n",
-                           (unsigned int)pid,
-                           spinlock,
-                           (unsigned int)note_spinlock->nsp_value,
-                           (unsigned int)note->nc_priority);
-                  }
-                  break;
+            case NOTE_SPINLOCK_UNLOCK:
+              {
+                syslog_time(LOG_INFO,
+                       "Task %u unlocking spinlock=%p value=%u "
+                       "priority %u\n",
+                       (unsigned int)pid,
+                       spinlock,
+                       (unsigned int)note_spinlock->nsp_value,
+                       (unsigned int)note->nc_priority);
+              }
+              break;
 
-                case NOTE_SPINLOCK_ABORT:
-                  {
-                    syslog_time(LOG_INFO,
-                           "Task %u abort wait on spinlock=%p value=%u "
-                           "priority %u\n",
-                           (unsigned int)pid,
-                           spinlock,
-                           (unsigned int)note_spinlock->nsp_value,
-                           (unsigned int)note->nc_priority);
-                  }
-                  break;
-#endif
-               }
+            case NOTE_SPINLOCK_ABORT:
+              {
+                syslog_time(LOG_INFO,
+                       "Task %u abort wait on spinlock=%p value=%u "
+                       "priority %u\n",
+                       (unsigned int)pid,
+                       spinlock,
+                       (unsigned int)note_spinlock->nsp_value,
+                       (unsigned int)note->nc_priority);
+              }
               break;
-            }
+#endif
+           }
+          break;
+        }
 #endif
 
 #ifdef CONFIG_SCHED_INSTRUMENTATION_SYSCALL
-                case NOTE_SYSCALL_ENTER:
+            case NOTE_SYSCALL_ENTER:
+              {
+                FAR struct note_syscall_enter_s *note_sysenter =
+                  (FAR struct note_syscall_enter_s *)note;
+
+                if (note->nc_length < SIZEOF_NOTE_SYSCALL_ENTER(0))
                   {
-                    FAR struct note_syscall_enter_s *note_sysenter =
-                      (FAR struct note_syscall_enter_s *)note;
-
-                    if (note->nc_length < SIZEOF_NOTE_SYSCALL_ENTER(0))
-                      {
-                        syslog(LOG_ERR,
-                               "Size incorrect for \"SYSCALL enter\" note: "
-                               "%d\n",
-                               note->nc_length);
-                        return;
-                      }
-
-                    syslog_time(LOG_INFO,
-                           "Task %u Enter SYSCALL %d\n",
-                           (unsigned int)pid,
-                           note_sysenter->nsc_nr);
+                    syslog(LOG_ERR,
+                           "Size incorrect for \"SYSCALL enter\" note: "
+                           "%d\n",
+                           note->nc_length);
+                    return;
                   }
-                  break;
 
-                case NOTE_SYSCALL_LEAVE:
+                syslog_time(LOG_INFO,
+                       "Task %u Enter SYSCALL %d\n",
+                       (unsigned int)pid,
+                       note_sysenter->nsc_nr);
+              }
+              break;
+
+            case NOTE_SYSCALL_LEAVE:
+              {
+                FAR struct note_syscall_leave_s *note_sysleave =
+                  (FAR struct note_syscall_leave_s *)note;
+                uintptr_t result;
+
+                if (note->nc_length !=
+                      sizeof(struct note_syscall_leave_s))
                   {
-                    FAR struct note_syscall_leave_s *note_sysleave =
-                      (FAR struct note_syscall_leave_s *)note;
-                    uintptr_t result;
-
-                    if (note->nc_length !=
-                          sizeof(struct note_syscall_leave_s))
-                      {
-                        syslog(LOG_ERR,
-                               "Size incorrect for \"SYSCALL leave\" note: "
-                               "%d\n",
-                               note->nc_length);
-                        return;
-                      }
-
-                    trace_dump_unflatten(&result,
-                                         note_sysleave->nsc_result,
-                                         sizeof(result));
-
-                    syslog_time(LOG_INFO,
-                           "Task %u Leave SYSCALL %d: %" PRIdPTR "\n",
-                           (unsigned int)pid,
-                           note_sysleave->nsc_nr, result);
+                    syslog(LOG_ERR,
+                           "Size incorrect for \"SYSCALL leave\" note: "
+                           "%d\n",
+                           note->nc_length);
+                    return;
                   }
-                  break;
+
+                trace_dump_unflatten(&result,
+                                     note_sysleave->nsc_result,
+                                     sizeof(result));
+
+                syslog_time(LOG_INFO,
+                       "Task %u Leave SYSCALL %d: %" PRIdPTR "\n",
+                       (unsigned int)pid,
+                       note_sysleave->nsc_nr, result);
+              }
+              break;
 #endif
 
 #ifdef CONFIG_SCHED_INSTRUMENTATION_IRQHANDLER
-                case NOTE_IRQ_ENTER:
-                case NOTE_IRQ_LEAVE:
+            case NOTE_IRQ_ENTER:
+            case NOTE_IRQ_LEAVE:
+              {
+                FAR struct note_irqhandler_s *note_irq =
+                  (FAR struct note_irqhandler_s *)note;
+
+                if (note->nc_length != sizeof(struct note_irqhandler_s))
                   {
-                    FAR struct note_irqhandler_s *note_irq =
-                      (FAR struct note_irqhandler_s *)note;
-
-                    if (note->nc_length != sizeof(struct note_irqhandler_s))
-                      {
-                        syslog(LOG_ERR,
-                               "Size incorrect for \"IRQ\" note: %d\n",
-                               note->nc_length);
-                        return;
-                      }
-
-                    syslog_time(LOG_INFO,
-                         "Task %u %s IRQ %d\n",
-                         (unsigned int)pid,
-                         note->nc_type == NOTE_IRQ_ENTER ? "Enter" : "Leave",
-                         note_irq->nih_irq);
+                    syslog(LOG_ERR,
+                           "Size incorrect for \"IRQ\" note: %d\n",
+                           note->nc_length);
+                    return;
                   }
-                  break;
+
+                syslog_time(LOG_INFO,
+                     "Task %u %s IRQ %d\n",
+                     (unsigned int)pid,
+                     note->nc_type == NOTE_IRQ_ENTER ? "Enter" : "Leave",
+                     note_irq->nih_irq);
+              }
+              break;
 #endif
 
 #ifdef CONFIG_SCHED_INSTRUMENTATION_DUMP
-                case NOTE_DUMP_STRING:
+            case NOTE_DUMP_STRING:
+              {
+                FAR struct note_string_s *note_string =
+                  (FAR struct note_string_s *)note;
+
+                if (note->nc_length < sizeof(struct note_string_s))
                   {
-                    FAR struct note_string_s *note_string =
-                      (FAR struct note_string_s *)note;
-
-                    if (note->nc_length < sizeof(struct note_string_s))
-                      {
-                        syslog(LOG_INFO,
-                               "ERROR: note too small for string note: %d\n",
-                               note->nc_length);
-                        return;
-                      }
-
-                    syslog_time(LOG_INFO,
-                           "Task %u priority %u, string:%s\n",
-                           (unsigned int)pid,
-                           (unsigned int)note->nc_priority,
-                           note_string->nst_data);
+                    syslog(LOG_INFO,
+                           "ERROR: note too small for string note: %d\n",
+                           note->nc_length);
+                    return;
                   }
-                  break;
 
-                case NOTE_DUMP_BINARY:
+                syslog_time(LOG_INFO,
+                       "Task %u priority %u, string:%s\n",
+                       (unsigned int)pid,
+                       (unsigned int)note->nc_priority,
+                       note_string->nst_data);
+              }
+              break;
+
+            case NOTE_DUMP_BINARY:
+              {
+                FAR struct note_binary_s *note_binary =
+                  (FAR struct note_binary_s *)note;
+                uintptr_t ip;
+                char out[1280];
+                int count;
+                int ret = 0;
+                int i;
+
+                count =
+                  note->nc_length - sizeof(struct note_binary_s) + 1;
+
+                if (count < 0)
                   {
-                    FAR struct note_binary_s *note_binary =
-                      (FAR struct note_binary_s *)note;
-                    uintptr_t ip;
-                    char out[1280];
-                    int count;
-                    int ret = 0;
-                    int i;
-
-                    count =
-                      note->nc_length - sizeof(struct note_binary_s) + 1;
-
-                    if (count < 0)
-                      {
-                        syslog(LOG_INFO,
-                               "ERROR: note too small for binary note: %d\n",
-                               note->nc_length);
-                        return;
-                      }
-
-                    for (i = 0; i < count; i++)
-                      {
-                        snprintf(&out[ret], sizeof(out) - ret,
-                                 " 0x%x", note_binary->nbi_data[i]);
-                        ret += strlen(&out[ret]);
-                      }
-
-                    trace_dump_unflatten(&ip, note_binary->nbi_ip,
-                                         sizeof(ip));
-
-                    syslog_time(LOG_INFO,
-                           "Task %u priority %u, ip=0x%" PRIdPTR
-                            " event=%u count=%u%s\n",
-                           (unsigned int)pid,
-                           (unsigned int)note->nc_priority,
-                           note_binary->nbi_ip,
-                           note_binary->nbi_event,
-                           count,
-                           out);
+                    syslog(LOG_INFO,
+                           "ERROR: note too small for binary note: %d\n",
+                           note->nc_length);
+                    return;
                   }
-                  break;
+
+                for (i = 0; i < count; i++)
+                  {
+                    snprintf(&out[ret], sizeof(out) - ret,
+                             " 0x%x", note_binary->nbi_data[i]);
+                    ret += strlen(&out[ret]);
+                  }
+
+                trace_dump_unflatten(&ip, note_binary->nbi_ip,
+                                     sizeof(ip));
+
+                syslog_time(LOG_INFO,
+                       "Task %u priority %u, ip=0x%" PRIdPTR
+                        " event=%u count=%u%s\n",
+                       (unsigned int)pid,
+                       (unsigned int)note->nc_priority,
+                       note_binary->nbi_ip,
+                       note_binary->nbi_event,
+                       count,
+                       out);
+              }
+              break;
 #endif
 
-          default:
-            syslog(LOG_INFO, "Unrecognized note type: %d\n", note->nc_type);
-            return;
+      default:
+        syslog(LOG_INFO, "Unrecognized note type: %d\n", note->nc_type);
+        return;
+    }
+}
+
+/****************************************************************************
+ * Name: note_read
+ *
+ * Description:
+ *   Append the notes available from a source to its buffer.  The device
+ *   may hold more notes if reading stopped because the buffer was full.
+ *
+ ****************************************************************************/
+
+static void note_read(FAR struct note_source_s *src)
+{
+  ssize_t nread;
+
+  src->more = false;
+  while (src->len < CONFIG_SYSTEM_NOTE_BUFFERSIZE)
+    {
+      nread = read(src->fd, &src->buf[src->len],
+                   CONFIG_SYSTEM_NOTE_BUFFERSIZE - src->len);
+      if (nread <= 0)
+        {
+          break;
         }
 
-      offset += note->nc_length;
+      src->len += nread;
+      if (src->len > CONFIG_SYSTEM_NOTE_BUFFERSIZE * 3 / 4)
+        {
+          src->more = true;
+          break;
+        }
     }
 }
 
+/****************************************************************************
+ * Name: note_merge
+ *
+ * Description:
+ *   Dump the buffered notes of all sources in time stamp order.  A note of
+ *   a source that may hold more notes is only dumped if it is not newer
+ *   than the last note read from it: the notes still in the device could
+ *   be older than it.  Notes that are not dumped are kept for the next
+ *   round.
+ *
+ ****************************************************************************/
+
+static void note_merge(void)
+{
+  FAR struct note_common_s *note;
+  FAR struct note_source_s *src;
+  FAR struct note_entry_s *entry;
+  int head[NOTE_NCPUS];
+  int tail[NOTE_NCPUS];
+  int first[NOTE_NSOURCES + 1];
+  uint64_t watermark = UINT64_MAX;
+  uint64_t last;
+  size_t offset;
+  size_t len;
+  int nentries = 0;
+  int best;
+  int cpu;
+  int i;
+  int j;
+
+  memset(head, 0xff, sizeof(head));
+  memset(tail, 0xff, sizeof(tail));
+
+  /* Index the notes, linking those of each CPU */
+
+  for (i = 0; i < NOTE_NSOURCES; i++)
+    {
+      src      = &g_note_sources[i];
+      first[i] = nentries;
+      last     = 0;
+      offset   = 0;
+
+      while (offset + sizeof(struct note_common_s) <= src->len)
+        {
+          note = (FAR struct note_common_s *)&src->buf[offset];
+          if (note->nc_length < sizeof(struct note_common_s) ||
+              offset + note->nc_length > src->len ||
+              NOTE_CPU(note) >= NOTE_NCPUS || nentries >= NOTE_MAXENTRIES)
+            {
+              /* The rest of this buffer cannot be trusted */
+
+              g_note_stats[i].bad++;
+              src->len = offset;
+              break;
+            }
+
+          cpu           = NOTE_CPU(note);
+          entry         = &g_note_entries[nentries];
+          entry->time   = note_time(note);
+          entry->offset = offset;
+          entry->source = i;
+          entry->cpu    = cpu;
+          entry->done   = false;
+          entry->next   = -1;
+
+          if (tail[cpu] < 0)
+            {
+              head[cpu] = nentries;
+            }
+          else
+            {
+              g_note_entries[tail[cpu]].next = nentries;
+            }
+
+          tail[cpu] = nentries++;
+          last      = entry->time;
+          offset   += note->nc_length;
+        }
+
+      if (src->more && last < watermark)
+        {
+          watermark = last;
+        }
+    }
+
+  first[NOTE_NSOURCES] = nentries;
+
+  /* Dump the oldest note of all CPUs until the watermark is reached */
+
+  for (; ; )
+    {
+      best = -1;
+      for (cpu = 0; cpu < NOTE_NCPUS; cpu++)
+        {
+          if (head[cpu] >= 0 &&
+              (best < 0 ||
+               g_note_entries[head[cpu]].time < g_note_entries[best].time))
+            {
+              best = head[cpu];
+            }
+        }
+
+      if (best < 0 || g_note_entries[best].time > watermark)
+        {
+          break;
+        }
+
+      entry = &g_note_entries[best];
+      head[entry->cpu] = entry->next;
+      entry->done = true;
+
+      g_note_stats[entry->cpu].notes++;
+      if (entry->time < g_note_lasttime)
+        {
+          g_note_stats[entry->cpu].late++;
+        }
+      else
+        {
+          g_note_lasttime = entry->time;
+        }
+
+      src = &g_note_sources[entry->source];
+      dump_note((FAR struct note_common_s *)&src->buf[entry->offset]);
+    }
+
+  /* Move the notes that are left to the front of their buffers */
+
+  for (i = 0; i < NOTE_NSOURCES; i++)
+    {
+      src    = &g_note_sources[i];
+      offset = 0;
+
+      for (j = first[i]; j < first[i + 1]; j++)
+        {
+          entry = &g_note_entries[j];
+          if (!entry->done)
+            {
+              note = (FAR struct note_common_s *)&src->buf[entry->offset];
+              len  = note->nc_length;
+              memmove(&src->buf[offset], note, len);
+              offset += len;
+            }
+        }
+
+      src->len = offset;
+    }
+}
+
+/****************************************************************************
+ * Name: note_open
+ ****************************************************************************/
+
+static int note_open(void)
+{
+  int nopen = 0;
+  int i;
+
+#ifdef CONFIG_SYSTEM_NOTE_PERCPU
+  char path[32];
+
+  for (i = 0; i < NOTE_NSOURCES; i++)
+    {
+      snprintf(path, sizeof(path), CONFIG_SYSTEM_NOTE_PERCPU_DEVPATH, i);
+      syslog(LOG_INFO, "note_daemon: Opening %s\n", path);
+      g_note_sources[i].fd = open(path, O_RDONLY);
+      if (g_note_sources[i].fd < 0)
+        {
+          syslog(LOG_ERR, "note_daemon: ERROR: Failed to open %s: %d\n",
+                 path, errno);
+          continue;
+        }
+
+      nopen++;
+    }
+#else
+  for (i = 0; i < NOTE_NSOURCES; i++)
+    {
+      syslog(LOG_INFO, "note_daemon: Opening /dev/note/ram\n");
+      g_note_sources[i].fd = open("/dev/note/ram", O_RDONLY);
+      if (g_note_sources[i].fd < 0)
+        {
+          syslog(LOG_ERR, "note_daemon: ERROR: Failed to open "
+                 "/dev/note/ram: %d\n", errno);
+          continue;
+        }
+
+      nopen++;
+    }
+#endif
+
+  return nopen;
+}
+
 /****************************************************************************
  * Name: note_daemon
  ****************************************************************************/
 
 static int note_daemon(int argc, char *argv[])
 {
-  ssize_t nread;
-  int fd;
+  bool more;
+  int i;
 
   /* Indicate that we are running */
 
   g_note_daemon_started = true;
   syslog(LOG_INFO, "note_daemon: Running\n");
 
-  /* Open the note driver */
+  /* Open the note drivers */
 
-  syslog(LOG_INFO, "note_daemon: Opening /dev/note/ram\n");
-  fd = open("/dev/note/ram", O_RDONLY);
-  if (fd < 0)
+  if (note_open() == 0)
     {
-      int errcode = errno;
-      syslog(LOG_ERR, "note_daemon: ERROR: Failed to open /dev/note/ram: "
-            "%d\n",
-             errcode);
       goto errout;
     }
 
@@ -800,16 +1086,33 @@ static int note_daemon(int argc, char *argv[])
 
   for (; ; )
     {
-      nread = read(fd, g_note_buffer, CONFIG_SYSTEM_NOTE_BUFFERSIZE);
-      if (nread > 0)
+      more = false;
+      for (i = 0; i < NOTE_NSOURCES; i++)
         {
-          dump_notes(nread);
+          if (g_note_sources[i].fd >= 0)
+            {
+              note_read(&g_note_sources[i]);
+              more |= g_note_sources[i].more;
+            }
         }
 
-      usleep(CONFIG_SYSTEM_NOTE_DELAY * 1000L);
+      note_merge();
+
+      /* Keep up with the devices if they are filling the buffers */
+
+      if (!more)
+        {
+          usleep(CONFIG_SYSTEM_NOTE_DELAY * 1000L);
+        }
     }
 
-  close(fd);
+  for (i = 0; i < NOTE_NSOURCES; i++)
+    {
+      if (g_note_sources[i].fd >= 0)
+        {
+          close(g_note_sources[i].fd);
+        }
+    }
 
 errout:
   g_note_daemon_started = false;
@@ -818,6 +1121,22 @@ errout:
   return EXIT_FAILURE;
 }
 
+/****************************************************************************
+ * Name: note_showstats
+ ****************************************************************************/
+
+static void note_showstats(void)
+{
+  int cpu;
+
+  printf("CPU      NOTES       LATE        BAD\n");
+  for (cpu = 0; cpu < NOTE_NCPUS; cpu++)
+    {
+      printf("%3d %10lu %10lu %10lu\n", cpu, g_note_stats[cpu].notes,
+             g_note_stats[cpu].late, g_note_stats[cpu].bad);
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -834,6 +1153,7 @@ int main(int argc, FAR char *argv[])
   if (g_note_daemon_started)
     {
       printf("note_main: note_daemon already running\n");
+      note_showstats();
       return EXIT_SUCCESS;
     }
 
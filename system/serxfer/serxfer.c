@@ -0,0 +1,366 @@
+/****************************************************************************
+ * apps/system/serxfer/serxfer.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <syslog.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "system/serxfer.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: serxfer_wait
+ *
+ * Description:
+ *   Wait for input on the line.
+ *
+ ****************************************************************************/
+
+static int serxfer_wait(FAR struct serxfer_s *xfer, int timeout)
+{
+  struct pollfd fds;
+  int ret;
+
+  fds.fd      = xfer->rxfd;
+  fds.events  = POLLIN;
+  fds.revents = 0;
+
+  do
+    {
+      ret = poll(&fds, 1, timeout);
+    }
+  while (ret < 0 && errno == EINTR);
+
+  if (ret < 0)
+    {
+      return -errno;
+    }
+  else if (ret == 0)
+    {
+      xfer->stats.timeouts++;
+      return -ETIMEDOUT;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: serxfer_fill
+ *
+ * Description:
+ *   read() once from the line.
+ *
+ ****************************************************************************/
+
+static ssize_t serxfer_fill(FAR struct serxfer_s *xfer, FAR void *buf,
+                            size_t len)
+{
+  ssize_t nread;
+
+  do
+    {
+      nread = read(xfer->rxfd, buf, len);
+    }
+  while (nread < 0 && errno == EINTR);
+
+  if (nread < 0)
+    {
+      return -errno;
+    }
+
+  if (nread > 0)
+    {
+      xfer->stats.rxbytes += nread;
+      xfer->stats.rxcalls++;
+    }
+
+  return nread;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: serxfer_init
+ ****************************************************************************/
+
+void serxfer_init(FAR struct serxfer_s *xfer, int rxfd, int txfd,
+                  FAR uint8_t *buf, size_t bufsize)
+{
+  memset(xfer, 0, sizeof(*xfer));
+  xfer->rxfd    = rxfd;
+  xfer->txfd    = txfd;
+  xfer->buf     = buf;
+  xfer->bufsize = buf != NULL ? bufsize : 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &xfer->stats.start);
+}
+
+/****************************************************************************
+ * Name: serxfer_read
+ ****************************************************************************/
+
+ssize_t serxfer_read(FAR struct serxfer_s *xfer, FAR void *buf, size_t len,
+                     int timeout)
+{
+  ssize_t nread;
+  int ret;
+
+  if (xfer->head == xfer->tail)
+    {
+      ret = serxfer_wait(xfer, timeout);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      /* Large reads go straight to the caller */
+
+      if (len >= xfer->bufsize)
+        {
+          return serxfer_fill(xfer, buf, len);
+        }
+
+      nread = serxfer_fill(xfer, xfer->buf, xfer->bufsize);
+      if (nread <= 0)
+        {
+          return nread;
+        }
+
+      xfer->head = 0;
+      xfer->tail = nread;
+    }
+
+  if (len > xfer->tail - xfer->head)
+    {
+      len = xfer->tail - xfer->head;
+    }
+
+  memcpy(buf, &xfer->buf[xfer->head], len);
+  xfer->head += len;
+  return len;
+}
+
+/****************************************************************************
+ * Name: serxfer_readall
+ ****************************************************************************/
+
+int serxfer_readall(FAR struct serxfer_s *xfer, FAR void *buf, size_t len,
+                    int timeout)
+{
+  FAR uint8_t *ptr = buf;
+  ssize_t nread;
+
+  while (len > 0)
+    {
+      nread = serxfer_read(xfer, ptr, len, timeout);
+      if (nread < 0)
+        {
+          return nread;
+        }
+      else if (nread == 0)
+        {
+          return -ENOTCONN;
+        }
+
+      ptr += nread;
+      len -= nread;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: serxfer_write
+ ****************************************************************************/
+
+ssize_t serxfer_write(FAR struct serxfer_s *xfer, FAR const void *buf,
+                      size_t len)
+{
+  FAR const uint8_t *ptr = buf;
+  size_t remaining = len;
+  ssize_t nwritten;
+
+  while (remaining > 0)
+    {
+      nwritten = write(xfer->txfd, ptr, remaining);
+      if (nwritten < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      xfer->stats.txbytes += nwritten;
+      xfer->stats.txcalls++;
+      ptr       += nwritten;
+      remaining -= nwritten;
+    }
+
+  return len;
+}
+
+/****************************************************************************
+ * Name: serxfer_discard
+ ****************************************************************************/
+
+void serxfer_discard(FAR struct serxfer_s *xfer)
+{
+  xfer->head = 0;
+  xfer->tail = 0;
+  tcflush(xfer->rxfd, TCIOFLUSH);
+}
+
+/****************************************************************************
+ * Name: serxfer_dumpstats
+ ****************************************************************************/
+
+void serxfer_dumpstats(FAR struct serxfer_s *xfer, FAR const char *name)
+{
+  FAR struct serxfer_stats_s *stats = &xfer->stats;
+  struct timespec now;
+  unsigned long msec;
+  unsigned long rate;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  msec = (now.tv_sec - stats->start.tv_sec) * 1000 +
+         (now.tv_nsec - stats->start.tv_nsec) / 1000000;
+
+  /* Throughput of the busier direction */
+
+  rate = stats->rxbytes > stats->txbytes ? stats->rxbytes : stats->txbytes;
+  rate = msec > 0 ? (unsigned long)((uint64_t)rate * 1000 / msec) : 0;
+
+  syslog(LOG_INFO, "%s: rx %zu bytes/%u reads, tx %zu bytes/%u writes, "
+         "%lu.%03lus, %lu B/s, %u retries, %u timeouts\n",
+         name, stats->rxbytes, stats->rxcalls, stats->txbytes,
+         stats->txcalls, msec / 1000, msec % 1000, rate, stats->retries,
+         stats->timeouts);
+}
+
+/****************************************************************************
+ * Name: serxfer_escinit
+ ****************************************************************************/
+
+void serxfer_escinit(FAR struct serxfer_esc_s *esc, uint8_t escch,
+                     uint8_t lead)
+{
+  memset(esc->map, SERXFER_ESC_NONE, sizeof(esc->map));
+  esc->esc  = escch;
+  esc->lead = lead & 0x7f;
+  esc->last = 0;
+}
+
+/****************************************************************************
+ * Name: serxfer_escape
+ ****************************************************************************/
+
+size_t serxfer_escape(FAR struct serxfer_esc_s *esc, FAR uint8_t *dest,
+                      size_t destlen, FAR const uint8_t *src, size_t len,
+                      FAR size_t *nused)
+{
+  FAR const uint8_t *map = esc->map;
+  FAR const uint8_t *end = src + len;
+  FAR const uint8_t *start = src;
+  FAR uint8_t *ptr = dest;
+  FAR uint8_t *dend = dest + destlen;
+  FAR const uint8_t *run;
+  uint8_t last = esc->last;
+  uint8_t val;
+  size_t nrun;
+
+  while (src < end)
+    {
+      /* Copy the run of characters that need no escaping */
+
+      run = src;
+      while (src < end && map[*src] == SERXFER_ESC_NONE)
+        {
+          src++;
+        }
+
+      nrun = src - run;
+      if (nrun > (size_t)(dend - ptr))
+        {
+          nrun = dend - ptr;
+          src  = run + nrun;
+        }
+
+      if (nrun > 0)
+        {
+          memcpy(ptr, run, nrun);
+          ptr  += nrun;
+          last  = src[-1];
+        }
+
+      if (src == end || ptr == dend)
+        {
+          break;
+        }
+
+      /* Then the character that may need it */
+
+      val = map[*src];
+      if (val == SERXFER_ESC_LEAD)
+        {
+          if ((last & 0x7f) != esc->lead)
+            {
+              last   = *src++;
+              *ptr++ = last;
+              continue;
+            }
+
+          val = *src ^ 0x40;
+        }
+
+      if (dend - ptr < 2)
+        {
+          break;
+        }
+
+      *ptr++ = esc->esc;
+      *ptr++ = val;
+      last   = *src++;
+    }
+
+  esc->last = last;
+  if (nused != NULL)
+    {
+      *nused = src - start;
+    }
+
+  return ptr - dest;
+}
@@ -55,6 +55,10 @@
 #  define CONFIG_SYSTEM_SETTINGS_CACHE_TIME_MS 100
 #endif
 
+/* The key index is an open addressing hash table, at most half full */
+
+#define INDEX_SIZE (2 * CONFIG_SYSTEM_SETTINGS_MAP_SIZE)
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -64,7 +68,12 @@
  ****************************************************************************/
 
 static int      sanity_check(FAR char *str);
+static uint32_t hash_slot(int idx);
 static uint32_t hash_calc(void);
+static uint32_t key_hash(FAR const char *key);
+static int      index_find(FAR const char *key);
+static void     index_add(int idx);
+static void     index_rebuild(void);
 static int      get_setting(FAR char *key, FAR setting_t **setting);
 static size_t   get_string(FAR setting_t *setting, FAR char *buffer,
                          size_t size);
@@ -81,6 +90,9 @@ static int      load(void);
 static void     save(void);
 static void     signotify(void);
 static void     dump_cache(union sigval ptr);
+static int      get_value(FAR setting_t *setting, enum settings_type_e type,
+                          va_list ap);
+static int      set_value(int idx, enum settings_type_e type, va_list ap);
 
 /****************************************************************************
  * Private Data
@@ -90,6 +102,7 @@ static struct
 {
   pthread_mutex_t   mtx;
   uint32_t          hash;
+  uint16_t          gen;    /* Incremented by settings_clear() */
   bool              wrpend;
   bool              initialized;
   storage_t         store[CONFIG_SYSTEM_SETTINGS_MAX_STORAGES];
@@ -103,70 +116,194 @@ static struct
 
 setting_t map[CONFIG_SYSTEM_SETTINGS_MAP_SIZE];
 
+/* Map position + 1 of the setting of each key, 0 if unused */
+
+static uint16_t g_index[INDEX_SIZE];
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: hash_slot
+ *
+ * Description:
+ *    Gets the hash of one position of the map.  The position is part of
+ *    the hash, so that equal settings at different positions do not cancel
+ *    each other out in hash_calc().
+ *
+ * Input Parameters:
+ *    idx        - position in the map
+ *
+ * Returned Value:
+ *   crc32 hash of the setting
+ *
+ ****************************************************************************/
+
+static uint32_t hash_slot(int idx)
+{
+  return crc32part((FAR uint8_t *)&map[idx], sizeof(setting_t),
+                   (uint32_t)idx);
+}
+
 /****************************************************************************
  * Name: hash_calc
  *
  * Description:
- *    Gets a setting for a string value
+ *    Gets the hash of all the settings.  This is the XOR of the hashes of
+ *    all positions, so that a change of one setting can be applied to the
+ *    hash with hash_slot() of that setting only.
  *
  * Input Parameters:
  *    none
  * Returned Value:
- *   crc32 hash of all the settings
+ *   Hash of all the settings
  *
  ****************************************************************************/
 
 static uint32_t hash_calc(void)
 {
-  return crc32((FAR uint8_t *)map, sizeof(map));
+  uint32_t h = 0;
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_SETTINGS_MAP_SIZE; i++)
+    {
+      h ^= hash_slot(i);
+    }
+
+  return h;
 }
 
 /****************************************************************************
- * Name: get_setting
+ * Name: key_hash
  *
  * Description:
- *    Gets a setting for a given key
+ *    FNV-1a hash of a key
+ *
+ ****************************************************************************/
+
+static uint32_t key_hash(FAR const char *key)
+{
+  uint32_t h = 2166136261u;
+
+  while (*key != '\0')
+    {
+      h = (h ^ (uint8_t)*key++) * 16777619u;
+    }
+
+  return h;
+}
+
+/****************************************************************************
+ * Name: index_find
+ *
+ * Description:
+ *    Looks up the map position of a key in the index
  *
  * Input Parameters:
  *    key        - key of the required setting
- *    setting    - pointer to pointer for the setting
  *
  * Returned Value:
- *   The value of the setting for the given key
+ *   The map position of the setting, or -1 if there is none
  *
  ****************************************************************************/
 
-static int get_setting(FAR char *key, FAR setting_t **setting)
+static int index_find(FAR const char *key)
+{
+  uint32_t slot = key_hash(key) % INDEX_SIZE;
+  int idx;
+
+  while (g_index[slot] != 0)
+    {
+      idx = g_index[slot] - 1;
+      if (strcmp(map[idx].key, key) == 0)
+        {
+          return idx;
+        }
+
+      slot = (slot + 1) % INDEX_SIZE;
+    }
+
+  return -1;
+}
+
+/****************************************************************************
+ * Name: index_add
+ *
+ * Description:
+ *    Adds the setting at a map position to the index
+ *
+ * Input Parameters:
+ *    idx        - map position of the setting
+ *
+ ****************************************************************************/
+
+static void index_add(int idx)
+{
+  uint32_t slot = key_hash(map[idx].key) % INDEX_SIZE;
+
+  while (g_index[slot] != 0)
+    {
+      slot = (slot + 1) % INDEX_SIZE;
+    }
+
+  g_index[slot] = idx + 1;
+}
+
+/****************************************************************************
+ * Name: index_rebuild
+ *
+ * Description:
+ *    Rebuilds the index after the map has been changed by a storage
+ *
+ ****************************************************************************/
+
+static void index_rebuild(void)
 {
   int i;
-  int ret = OK;
 
-  assert(*setting == NULL);
+  memset(g_index, 0, sizeof(g_index));
 
   for (i = 0; i < CONFIG_SYSTEM_SETTINGS_MAP_SIZE; i++)
     {
       if (map[i].type == SETTING_EMPTY)
         {
-          ret = -ENOENT;
-          goto exit;
+          break;
         }
 
-      if (strcmp(map[i].key, key) == 0)
-        {
-          *setting = &map[i];
-          goto exit;
-        }
+      index_add(i);
     }
+}
 
-  *setting = NULL;
-  ret = -ENOENT;
+/****************************************************************************
+ * Name: get_setting
+ *
+ * Description:
+ *    Gets a setting for a given key
+ *
+ * Input Parameters:
+ *    key        - key of the required setting
+ *    setting    - pointer to pointer for the setting
+ *
+ * Returned Value:
+ *   The value of the setting for the given key
+ *
+ ****************************************************************************/
 
-exit:
-  return ret;
+static int get_setting(FAR char *key, FAR setting_t **setting)
+{
+  int idx;
+
+  assert(*setting == NULL);
+
+  idx = index_find(key);
+  if (idx < 0)
+    {
+      return -ENOENT;
+    }
+
+  *setting = &map[idx];
+  return OK;
 }
 
 /****************************************************************************
@@ -578,6 +715,8 @@ static int load(void)
         }
     }
 
+  index_rebuild();
+
   if (loadfailed >= CONFIG_SYSTEM_SETTINGS_MAX_STORAGES)
     {
       /* ALL storages failed to load. We have a problem. */
@@ -732,6 +871,161 @@ static int sanity_check(FAR char *str)
   return OK;
 }
 
+/****************************************************************************
+ * Name: get_value
+ *
+ * Description:
+ *    Gets the value of a setting.  Called with the mutex held.
+ *
+ * Input Parameters:
+ *    setting     - the setting
+ *    type        - the type of the setting
+ *    ap          - pointer to store the setting value plus, if a string
+ *                  setting, the length of the string to get
+ *
+ * Returned Value:
+ *    Success or negated failure code
+ *
+ ****************************************************************************/
+
+static int get_value(FAR setting_t *setting, enum settings_type_e type,
+                     va_list ap)
+{
+  int ret = -EINVAL;
+
+  switch (type)
+  {
+    case SETTING_STRING:
+      {
+        FAR char *buf = va_arg(ap, FAR char *);
+        size_t len = va_arg(ap, size_t);
+        ret = (int)get_string(setting, buf, len);
+      }
+      break;
+
+    case SETTING_INT:
+      {
+        FAR int *i = va_arg(ap, FAR int *);
+        ret = get_int(setting, i);
+      }
+      break;
+
+    case SETTING_BOOL:
+      {
+        FAR int *i = va_arg(ap, FAR int *);
+        ret = get_bool(setting, i);
+      }
+      break;
+
+    case SETTING_FLOAT:
+      {
+        FAR double *f = va_arg(ap, FAR double *);
+        ret = get_float(setting, f);
+      }
+      break;
+
+    case SETTING_IP_ADDR:
+      {
+        FAR struct in_addr *ip = va_arg(ap, FAR struct in_addr *);
+        ret = get_ip(setting, ip);
+      }
+      break;
+
+    default:
+      {
+        assert(0);
+      }
+      break;
+  }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: set_value
+ *
+ * Description:
+ *    Sets the value of a setting and, if it changed, updates the hash,
+ *    notifies and saves.  Called with the mutex held.
+ *
+ * Input Parameters:
+ *    idx         - the map position of the setting
+ *    type        - the type of the setting
+ *    ap          - the new value of the setting
+ *
+ * Returned Value:
+ *    Success or negated failure code
+ *
+ ****************************************************************************/
+
+static int set_value(int idx, enum settings_type_e type, va_list ap)
+{
+  FAR setting_t *setting = &map[idx];
+  uint32_t oldh;
+  uint32_t newh;
+  int ret = -EINVAL;
+
+  oldh = hash_slot(idx);
+
+  switch (type)
+  {
+    case SETTING_STRING:
+      {
+        FAR char *str = va_arg(ap, FAR char *);
+        ret = set_string(setting, str);
+      }
+      break;
+
+    case SETTING_INT:
+      {
+        int i = va_arg(ap, int);
+        ret = set_int(setting, i);
+      }
+      break;
+
+    case SETTING_BOOL:
+      {
+        int i = va_arg(ap, int);
+        ret = set_bool(setting, i);
+      }
+      break;
+
+    case SETTING_FLOAT:
+      {
+        double f = va_arg(ap, double);
+        ret = set_float(setting, f);
+      }
+      break;
+
+    case SETTING_IP_ADDR:
+      {
+        FAR struct in_addr *ip = va_arg(ap, FAR struct in_addr *);
+        ret = set_ip(setting, ip);
+      }
+      break;
+
+    default:
+      {
+        assert(0);
+      }
+      break;
+  }
+
+  if (ret >= 0)
+    {
+      newh = hash_slot(idx);
+      if (newh != oldh)
+        {
+          g_settings.hash ^= oldh ^ newh;
+
+          signotify();
+          save();
+        }
+    }
+
+  return ret;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -758,6 +1052,7 @@ void settings_init(void)
   pthread_mutex_init(&g_settings.mtx, &attr);
 
   memset(map, 0, sizeof(map));
+  memset(g_index, 0, sizeof(g_index));
   memset(g_settings.store, 0, sizeof(g_settings.store));
   memset(g_settings.notify, 0, sizeof(g_settings.notify));
 
@@ -858,6 +1153,15 @@ int settings_setstorage(FAR char *file, enum storage_type_e type)
       }
       break;
 
+#ifdef CONFIG_SYSTEM_SETTINGS_LOG
+    case STORAGE_LOG:
+      {
+        storage->load_fn = load_log;
+        storage->save_fn = save_log;
+      }
+      break;
+#endif
+
     default:
       {
         assert(0);
@@ -866,6 +1170,7 @@ int settings_setstorage(FAR char *file, enum storage_type_e type)
   }
 
   ret = storage->load_fn(storage->file);
+  index_rebuild();
 
   h = hash_calc();
 
@@ -1072,7 +1377,9 @@ int settings_clear(void)
     }
 
   memset(map, 0, sizeof(map));
+  memset(g_index, 0, sizeof(g_index));
   g_settings.hash = 0;
+  g_settings.gen++;
 
   save();
 
@@ -1143,17 +1450,17 @@ int settings_create(FAR char *key, enum settings_type_e type, ...)
       return ret;
     }
 
-  for (j = 0; j < CONFIG_SYSTEM_SETTINGS_MAP_SIZE; j++)
+  j = index_find(key);
+  if (j >= 0)
     {
-      if (strcmp(key, map[j].key) == 0)
-        {
-          setting = &map[j];
-
-          /* We found a setting with this key name */
+      /* We found a setting with this key name */
 
-          goto errout;
-        }
+      setting = &map[j];
+      goto errout;
+    }
 
+  for (j = 0; j < CONFIG_SYSTEM_SETTINGS_MAP_SIZE; j++)
+    {
       if (map[j].type == SETTING_EMPTY)
         {
           setting = &map[j];
@@ -1281,6 +1588,7 @@ int settings_create(FAR char *key, enum settings_type_e type, ...)
         }
       else
         {
+          index_add(setting - map);
           g_settings.hash = hash_calc();
           save();
         }
@@ -1310,7 +1618,7 @@ errout:
 int settings_type(FAR char *key, FAR enum settings_type_e *stype)
 {
   int ret;
-  FAR setting_t *setting;
+  FAR setting_t *setting = NULL;
 
   if (!g_settings.initialized)
     {
@@ -1358,7 +1666,8 @@ int settings_type(FAR char *key, FAR enum settings_type_e *stype)
 int settings_get(FAR char *key, enum settings_type_e type, ...)
 {
   int ret;
-  FAR setting_t *setting;
+  FAR setting_t *setting = NULL;
+  va_list ap;
 
   if (!g_settings.initialized)
     {
@@ -1380,54 +1689,8 @@ int settings_get(FAR char *key, enum settings_type_e type, ...)
       goto errout;
     }
 
-  va_list ap;
   va_start(ap, type);
-
-  switch (type)
-  {
-    case SETTING_STRING:
-      {
-        FAR char *buf = va_arg(ap, FAR char *);
-        size_t len = va_arg(ap, size_t);
-        ret = (int)get_string(setting, buf, len);
-      }
-      break;
-
-    case SETTING_INT:
-      {
-        FAR int *i = va_arg(ap, FAR int *);
-        ret = get_int(setting, i);
-      }
-      break;
-
-    case SETTING_BOOL:
-      {
-        FAR int *i = va_arg(ap, FAR int *);
-        ret = get_bool(setting, i);
-      }
-      break;
-
-    case SETTING_FLOAT:
-      {
-        FAR double *f = va_arg(ap, FAR double *);
-        ret = get_float(setting, f);
-      }
-      break;
-
-    case SETTING_IP_ADDR:
-      {
-        FAR struct in_addr *ip = va_arg(ap, FAR struct in_addr *);
-        ret = get_ip(setting, ip);
-      }
-      break;
-
-    default:
-      {
-        assert(0);
-      }
-      break;
-  }
-
+  ret = get_value(setting, type, ap);
   va_end(ap);
 
 errout:
@@ -1456,8 +1719,8 @@ errout:
 int settings_set(FAR char *key, enum settings_type_e type, ...)
 {
   int ret;
-  FAR setting_t *setting;
-  uint32_t h;
+  FAR setting_t *setting = NULL;
+  va_list ap;
 
   if (!g_settings.initialized)
     {
@@ -1479,67 +1742,10 @@ int settings_set(FAR char *key, enum settings_type_e type, ...)
       goto errout;
     }
 
-  va_list ap;
   va_start(ap, type);
-
-  switch (type)
-  {
-    case SETTING_STRING:
-      {
-        FAR char *str = va_arg(ap, FAR char *);
-        ret = set_string(setting, str);
-      }
-      break;
-
-    case SETTING_INT:
-      {
-        int i = va_arg(ap, int);
-        ret = set_int(setting, i);
-      }
-      break;
-
-    case SETTING_BOOL:
-      {
-        int i = va_arg(ap, int);
-        ret = set_bool(setting, i);
-      }
-      break;
-
-    case SETTING_FLOAT:
-      {
-        double f = va_arg(ap, double);
-        ret = set_float(setting, f);
-      }
-      break;
-
-    case SETTING_IP_ADDR:
-      {
-        FAR struct in_addr *ip = va_arg(ap, FAR struct in_addr *);
-        ret = set_ip(setting, ip);
-      }
-      break;
-
-    default:
-      {
-        assert(0);
-      }
-      break;
-  }
-
+  ret = set_value(setting - map, type, ap);
   va_end(ap);
 
-  if (ret >= 0)
-    {
-      h = hash_calc();
-      if (h != g_settings.hash)
-        {
-          g_settings.hash = h;
-
-          signotify();
-          save();
-        }
-    }
-
 errout:
   pthread_mutex_unlock(&g_settings.mtx);
 
@@ -1596,3 +1802,162 @@ int settings_iterate(int idx, FAR setting_t *setting)
 
   return ret;
 }
+
+/****************************************************************************
+ * Name: settings_gethandle
+ *
+ * Description:
+ *    Looks up a setting once, for use with settings_hget() and
+ *    settings_hset().  These do not need to search for the key, which makes
+ *    them the fastest way to access a setting repeatedly.
+ *
+ *    The handle stays valid until settings_clear() is called.
+ *
+ * Input Parameters:
+ *    key         - the key of the setting.
+ *    handle      - pointer to return the handle
+ *
+ * Returned Value:
+ *    Success or negated failure code
+ *
+ ****************************************************************************/
+
+int settings_gethandle(FAR char *key, FAR settings_handle_t *handle)
+{
+  int ret;
+  int idx;
+
+  if (!g_settings.initialized)
+    {
+      assert(0);
+    }
+
+  assert(handle != NULL);
+  assert(key != NULL);
+
+  ret = pthread_mutex_lock(&g_settings.mtx);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  idx = index_find(key);
+  if (idx < 0)
+    {
+      ret = -ENOENT;
+    }
+  else
+    {
+      handle->idx = idx;
+      handle->gen = g_settings.gen;
+    }
+
+  pthread_mutex_unlock(&g_settings.mtx);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: settings_hget
+ *
+ * Description:
+ *    Gets the value of a setting by handle.  Same as settings_get().
+ *
+ * Input Parameters:
+ *    handle      - the handle of the setting.
+ *    type        - the type of the setting
+ *    ...         - pointer to store the setting value plus, if a string
+ *                  setting, the length of the string to get
+ *
+ * Returned Value:
+ *    Success or negated failure code.  -ESTALE if the settings have been
+ *    cleared since the handle was obtained.
+ *
+ ****************************************************************************/
+
+int settings_hget(settings_handle_t handle, enum settings_type_e type, ...)
+{
+  int ret;
+  va_list ap;
+
+  if (!g_settings.initialized)
+    {
+      assert(0);
+    }
+
+  assert(type != SETTING_EMPTY);
+  assert(handle.idx < CONFIG_SYSTEM_SETTINGS_MAP_SIZE);
+
+  ret = pthread_mutex_lock(&g_settings.mtx);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (handle.gen != g_settings.gen)
+    {
+      ret = -ESTALE;
+      goto errout;
+    }
+
+  va_start(ap, type);
+  ret = get_value(&map[handle.idx], type, ap);
+  va_end(ap);
+
+errout:
+  pthread_mutex_unlock(&g_settings.mtx);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: settings_hset
+ *
+ * Description:
+ *    Sets the value of a setting by handle.  Same as settings_set().
+ *
+ * Input Parameters:
+ *    handle      - the handle of the setting.
+ *    type        - the type of the setting
+ *    ...         - the new value of the setting.
+ *
+ * Returned Value:
+ *    Success or negated failure code.  -ESTALE if the settings have been
+ *    cleared since the handle was obtained.
+ *
+ ****************************************************************************/
+
+int settings_hset(settings_handle_t handle, enum settings_type_e type, ...)
+{
+  int ret;
+  va_list ap;
+
+  if (!g_settings.initialized)
+    {
+      assert(0);
+    }
+
+  assert(type != SETTING_EMPTY);
+  assert(handle.idx < CONFIG_SYSTEM_SETTINGS_MAP_SIZE);
+
+  ret = pthread_mutex_lock(&g_settings.mtx);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (handle.gen != g_settings.gen)
+    {
+      ret = -ESTALE;
+      goto errout;
+    }
+
+  va_start(ap, type);
+  ret = set_value(handle.idx, type, ap);
+  va_end(ap);
+
+errout:
+  pthread_mutex_unlock(&g_settings.mtx);
+
+  return ret;
+}
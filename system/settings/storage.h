@@ -54,6 +54,11 @@ int save_text(FAR char *file);
 int load_bin(FAR char *file);
 int save_bin(FAR char *file);
 
+/* Log storage. */
+
+int load_log(FAR char *file);
+int save_log(FAR char *file);
+
 /* EEPROM storage. */
 
 int load_eeprom(FAR char *file);
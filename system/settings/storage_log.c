@@ -0,0 +1,429 @@
+/****************************************************************************
+ * apps/system/settings/storage_log.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "system/settings.h"
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <nuttx/crc32.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <nuttx/config.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "storage.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SYSTEM_SETTINGS_LOG_MAXRECORDS
+#  define CONFIG_SYSTEM_SETTINGS_LOG_MAXRECORDS \
+          (4 * CONFIG_SYSTEM_SETTINGS_MAP_SIZE)
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The log is a sequence of records, each the new value of one setting.
+ * When replayed in order, the last record of each key wins.  A record that
+ * was only partly written (power loss) fails its CRC and ends the log.
+ */
+
+struct log_record_s
+{
+  setting_t setting;
+  uint32_t  crc;                /* crc32 of setting */
+};
+
+/* What is known to be in each log file */
+
+struct log_file_s
+{
+  char     file[CONFIG_SYSTEM_SETTINGS_MAX_FILENAME];
+  int      nrecords;            /* Number of records in the log */
+  uint32_t crc[CONFIG_SYSTEM_SETTINGS_MAP_SIZE]; /* Logged value crc's */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct log_file_s g_logs[CONFIG_SYSTEM_SETTINGS_MAX_STORAGES];
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+extern setting_t map[CONFIG_SYSTEM_SETTINGS_MAP_SIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: log_file
+ *
+ * Description:
+ *    Gets the state of a log file, allocating it on first use.
+ *
+ ****************************************************************************/
+
+static FAR struct log_file_s *log_file(FAR const char *file)
+{
+  FAR struct log_file_s *avail = NULL;
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_SETTINGS_MAX_STORAGES; i++)
+    {
+      if (strcmp(g_logs[i].file, file) == 0)
+        {
+          return &g_logs[i];
+        }
+
+      if (avail == NULL && g_logs[i].file[0] == '\0')
+        {
+          avail = &g_logs[i];
+        }
+    }
+
+  if (avail != NULL)
+    {
+      memset(avail, 0, sizeof(*avail));
+      strlcpy(avail->file, file, sizeof(avail->file));
+    }
+
+  return avail;
+}
+
+/****************************************************************************
+ * Name: log_getslot
+ *
+ * Description:
+ *    Gets the map position for a key: the setting with that key or the
+ *    first empty one.
+ *
+ ****************************************************************************/
+
+static int log_getslot(FAR const char *key)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_SETTINGS_MAP_SIZE; i++)
+    {
+      if (map[i].type == SETTING_EMPTY || strcmp(key, map[i].key) == 0)
+        {
+          return i;
+        }
+    }
+
+  return -1;
+}
+
+/****************************************************************************
+ * Name: log_write
+ *
+ * Description:
+ *    Writes the record of one map position.
+ *
+ ****************************************************************************/
+
+static int log_write(int fd, int idx)
+{
+  struct log_record_s rec;
+  ssize_t nwritten;
+
+  memcpy(&rec.setting, &map[idx], sizeof(setting_t));
+  rec.crc = crc32((FAR uint8_t *)&rec.setting, sizeof(setting_t));
+
+  nwritten = write(fd, &rec, sizeof(rec));
+  if (nwritten != sizeof(rec))
+    {
+      return nwritten < 0 ? -errno : -EIO;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: log_compact
+ *
+ * Description:
+ *    Replaces the log with one record per setting.  The new log is written
+ *    to a temporary file first, so either the old or the new log survives a
+ *    power loss.
+ *
+ ****************************************************************************/
+
+static int log_compact(FAR struct log_file_s *log)
+{
+  char tmpfile[CONFIG_SYSTEM_SETTINGS_MAX_FILENAME + 2];
+  int nrecords = 0;
+  int ret = OK;
+  int fd;
+  int i;
+
+  snprintf(tmpfile, sizeof(tmpfile), "%s~", log->file);
+
+  fd = open(tmpfile, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  for (i = 0; i < CONFIG_SYSTEM_SETTINGS_MAP_SIZE; i++)
+    {
+      if (map[i].type == SETTING_EMPTY)
+        {
+          break;
+        }
+
+      ret = log_write(fd, i);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      nrecords++;
+    }
+
+  if (ret >= 0 && fsync(fd) < 0)
+    {
+      ret = -errno;
+    }
+
+  close(fd);
+
+  if (ret >= 0 && rename(tmpfile, log->file) < 0)
+    {
+      /* Not every file system can rename over an existing file */
+
+      if (errno != EEXIST || unlink(log->file) < 0 ||
+          rename(tmpfile, log->file) < 0)
+        {
+          ret = -errno;
+        }
+    }
+
+  if (ret < 0)
+    {
+      unlink(tmpfile);
+      return ret;
+    }
+
+  log->nrecords = nrecords;
+  for (i = 0; i < CONFIG_SYSTEM_SETTINGS_MAP_SIZE; i++)
+    {
+      log->crc[i] = i < nrecords ?
+                    crc32((FAR uint8_t *)&map[i], sizeof(setting_t)) : 0;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: load_log
+ *
+ * Description:
+ *    Replays a log storage file.  A partly written record at the end of the
+ *    log is cut off.
+ *
+ * Input Parameters:
+ *    file             - the filename of the storage to use
+ *
+ * Returned Value:
+ *   Success or negated failure code
+ *
+ ****************************************************************************/
+
+int load_log(FAR char *file)
+{
+  FAR struct log_file_s *log;
+  struct log_record_s rec;
+  struct stat buf;
+  FAR FILE *stream;
+  off_t good = 0;
+  int idx;
+
+  log = log_file(file);
+  if (log == NULL)
+    {
+      return -ENOSPC;
+    }
+
+  stream = fopen(file, "r");
+  if (stream == NULL)
+    {
+      return -ENOENT;
+    }
+
+  if (fstat(fileno(stream), &buf) < 0)
+    {
+      buf.st_size = 0;
+    }
+
+  memset(log->crc, 0, sizeof(log->crc));
+  log->nrecords = 0;
+
+  while (fread(&rec, sizeof(rec), 1, stream) == 1)
+    {
+      if (rec.crc != crc32((FAR uint8_t *)&rec.setting, sizeof(setting_t)))
+        {
+          break;
+        }
+
+      good += sizeof(rec);
+      log->nrecords++;
+
+      rec.setting.key[CONFIG_SYSTEM_SETTINGS_KEY_SIZE - 1] = '\0';
+      idx = log_getslot(rec.setting.key);
+      if (idx < 0 || rec.setting.type == SETTING_EMPTY)
+        {
+          continue;
+        }
+
+      memcpy(&map[idx], &rec.setting, sizeof(setting_t));
+      log->crc[idx] = rec.crc;
+    }
+
+  fclose(stream);
+
+  /* Drop what follows the last good record, so that appended records are
+   * not lost behind it.
+   */
+
+  if (good < buf.st_size)
+    {
+      truncate(file, good);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: save_log
+ *
+ * Description:
+ *    Appends the settings that changed since they were last logged.  The
+ *    log is compacted when it gets too long, or when settings have been
+ *    removed (settings_clear()).
+ *
+ * Input Parameters:
+ *    file             - the filename of the storage to use
+ *
+ * Returned Value:
+ *   Success or negated failure code
+ *
+ ****************************************************************************/
+
+int save_log(FAR char *file)
+{
+  FAR struct log_file_s *log;
+  uint32_t crc[CONFIG_SYSTEM_SETTINGS_MAP_SIZE];
+  int nchanged = 0;
+  int ret = OK;
+  int fd;
+  int i;
+
+  log = log_file(file);
+  if (log == NULL)
+    {
+      return -ENOSPC;
+    }
+
+  for (i = 0; i < CONFIG_SYSTEM_SETTINGS_MAP_SIZE; i++)
+    {
+      if (map[i].type == SETTING_EMPTY)
+        {
+          crc[i] = 0;
+          if (log->crc[i] != 0)
+            {
+              /* Removed settings can only be dropped by a rewrite */
+
+              return log_compact(log);
+            }
+
+          continue;
+        }
+
+      crc[i] = crc32((FAR uint8_t *)&map[i], sizeof(setting_t));
+      if (crc[i] != log->crc[i])
+        {
+          nchanged++;
+        }
+    }
+
+  if (nchanged == 0)
+    {
+      return OK;
+    }
+
+  if (log->nrecords + nchanged > CONFIG_SYSTEM_SETTINGS_LOG_MAXRECORDS)
+    {
+      return log_compact(log);
+    }
+
+  fd = open(file, O_WRONLY | O_CREAT | O_APPEND, 0666);
+  if (fd < 0)
+    {
+      return -ENODEV;
+    }
+
+  for (i = 0; i < CONFIG_SYSTEM_SETTINGS_MAP_SIZE; i++)
+    {
+      if (map[i].type != SETTING_EMPTY && crc[i] != log->crc[i])
+        {
+          ret = log_write(fd, i);
+          if (ret < 0)
+            {
+              /* The end of the log may be damaged now, rewrite it next
+               * time.
+               */
+
+              log->nrecords = CONFIG_SYSTEM_SETTINGS_LOG_MAXRECORDS;
+              break;
+            }
+
+          log->crc[i] = crc[i];
+          log->nrecords++;
+        }
+    }
+
+  fsync(fd);
+  close(fd);
+
+  return ret;
+}
@@ -0,0 +1,369 @@
+/****************************************************************************
+ * apps/system/spi/spi_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nuttx/spi/spi_transfer.h>
+
+#include "spitool.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DEFAULT_BYTES  4096
+#define BENCH_DEFAULT_XFERS  100
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: spibench_now
+ ****************************************************************************/
+
+static uint64_t spibench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: spibench_load
+ *
+ * Description:
+ *   Fill the transmit buffer from a file, zero padded.
+ *
+ ****************************************************************************/
+
+static int spibench_load(FAR const char *path, FAR uint8_t *buf,
+                         size_t len)
+{
+  ssize_t nbytes;
+  size_t ntotal = 0;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  while (ntotal < len)
+    {
+      nbytes = read(fd, buf + ntotal, len - ntotal);
+      if (nbytes < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          close(fd);
+          return -errno;
+        }
+      else if (nbytes == 0)
+        {
+          break;
+        }
+
+      ntotal += nbytes;
+    }
+
+  memset(buf + ntotal, 0, len - ntotal);
+  close(fd);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: spibench_save
+ ****************************************************************************/
+
+static int spibench_save(FAR const char *path, FAR const uint8_t *buf,
+                         size_t len)
+{
+  ssize_t nbytes;
+  int fd;
+
+  fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  while (len > 0)
+    {
+      nbytes = write(fd, buf, len);
+      if (nbytes < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          close(fd);
+          return -errno;
+        }
+
+      buf += nbytes;
+      len -= nbytes;
+    }
+
+  close(fd);
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: spicmd_bench
+ ****************************************************************************/
+
+int spicmd_bench(FAR struct spitool_s *spitool, int argc, FAR char **argv)
+{
+  FAR struct spi_trans_s *trans = NULL;
+  FAR const char *infile = NULL;
+  FAR const char *outfile = NULL;
+  FAR uint8_t *txdata = NULL;
+  FAR uint8_t *rxdata = NULL;
+  struct spi_sequence_s seq;
+  uint64_t lmin = UINT64_MAX;
+  uint64_t lmax = 0;
+  uint64_t total;
+  uint64_t start;
+  uint64_t lat;
+  uint64_t bps;
+  size_t nbytes = BENCH_DEFAULT_BYTES;
+  size_t wordsize;
+  long xfers = BENCH_DEFAULT_XFERS;
+  long segments = 1;
+  long pattern = 0;
+  FAR char *ptr;
+  int nargs;
+  int argndx;
+  int ret = OK;
+  int fd;
+  long i;
+
+  /* Parse the command line: bench options first, then common options */
+
+  for (argndx = 1; argndx < argc; )
+    {
+      ptr = argv[argndx];
+      if (*ptr != '-')
+        {
+          break;
+        }
+
+      if (ptr[1] != '\0' && strchr("iops", ptr[1]) != NULL &&
+          ptr[2] == '\0')
+        {
+          if (argndx + 1 >= argc)
+            {
+              spitool_printf(spitool, g_spiargrequired, argv[0]);
+              return ERROR;
+            }
+
+          switch (ptr[1])
+            {
+              case 'i':
+                infile = argv[argndx + 1];
+                break;
+
+              case 'o':
+                outfile = argv[argndx + 1];
+                break;
+
+              case 'p':
+                pattern = strtol(argv[argndx + 1], NULL, 16);
+                break;
+
+              case 's':
+                segments = strtol(argv[argndx + 1], NULL, 10);
+                break;
+            }
+
+          argndx += 2;
+          continue;
+        }
+
+      nargs = spitool_common_args(spitool, &argv[argndx]);
+      if (nargs < 0)
+        {
+          return ERROR;
+        }
+
+      argndx += nargs;
+    }
+
+  if (argndx < argc)
+    {
+      nbytes = strtoul(argv[argndx++], NULL, 10);
+    }
+
+  if (argndx < argc)
+    {
+      xfers = strtol(argv[argndx++], NULL, 10);
+    }
+
+  if (argndx != argc)
+    {
+      spitool_printf(spitool, g_spitoomanyargs, argv[0]);
+      return ERROR;
+    }
+
+  wordsize = spitool->width <= 8 ? 1 : spitool->width <= 16 ? 2 : 4;
+  if (nbytes == 0 || nbytes % wordsize != 0 || xfers < 1 ||
+      segments < 1 || segments > UINT8_MAX || pattern < 0 ||
+      pattern > 0xff)
+    {
+      spitool_printf(spitool, g_spiargrange, argv[0]);
+      return ERROR;
+    }
+
+  /* Each segment of a sequence has its own part of the buffers */
+
+  txdata = malloc(nbytes * segments);
+  rxdata = malloc(nbytes * segments);
+  trans  = calloc(segments, sizeof(struct spi_trans_s));
+  if (txdata == NULL || rxdata == NULL || trans == NULL)
+    {
+      spitool_printf(spitool, g_spicmdfailed, argv[0], "malloc", ENOMEM);
+      ret = ERROR;
+      goto errout;
+    }
+
+  if (infile != NULL)
+    {
+      ret = spibench_load(infile, txdata, nbytes * segments);
+      if (ret < 0)
+        {
+          spitool_printf(spitool, g_spicmdfailed, argv[0], infile, -ret);
+          goto errout;
+        }
+    }
+  else
+    {
+      memset(txdata, pattern, nbytes * segments);
+    }
+
+  /* The chip select is held across the segments of one sequence */
+
+  seq.dev       = SPIDEV_ID(spitool->devtype, spitool->csn);
+  seq.mode      = spitool->mode;
+  seq.nbits     = spitool->width;
+  seq.frequency = spitool->freq;
+  seq.ntrans    = segments;
+  seq.trans     = trans;
+
+  for (i = 0; i < segments; i++)
+    {
+      trans[i].deselect = i == segments - 1;
+#ifdef CONFIG_SPI_CMDDATA
+      trans[i].cmd      = spitool->command;
+#endif
+      trans[i].delay    = spitool->udelay;
+      trans[i].nwords   = nbytes / wordsize;
+      trans[i].txbuffer = txdata + i * nbytes;
+      trans[i].rxbuffer = rxdata + i * nbytes;
+    }
+
+  fd = spidev_open(spitool->bus);
+  if (fd < 0)
+    {
+      spitool_printf(spitool, "Failed to get bus %d\n", spitool->bus);
+      ret = ERROR;
+      goto errout;
+    }
+
+  total = 0;
+  for (i = 0; i < xfers; i++)
+    {
+      start = spibench_now();
+      ret   = spidev_transfer(fd, &seq);
+      lat   = spibench_now() - start;
+      if (ret < 0)
+        {
+          spitool_printf(spitool, g_spixfrerror, argv[0], errno);
+          break;
+        }
+
+      lmin   = lat < lmin ? lat : lmin;
+      lmax   = lat > lmax ? lat : lmax;
+      total += lat;
+    }
+
+  close(fd);
+
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  if (outfile != NULL)
+    {
+      ret = spibench_save(outfile, rxdata, nbytes * segments);
+      if (ret < 0)
+        {
+          spitool_printf(spitool, g_spicmdfailed, argv[0], outfile, -ret);
+          goto errout;
+        }
+    }
+
+  /* Report the throughput in MB/s with three decimals */
+
+  if (total == 0)
+    {
+      total = 1;
+    }
+
+  bps = (uint64_t)nbytes * segments * xfers * 1000000 / total;
+
+  spitool_printf(spitool, "BENCH Bus: %d Freq: %" PRIu32 " Bytes: %zu "
+                 "Segments: %ld Sequences: %ld\n",
+                 spitool->bus, spitool->freq, nbytes, segments, xfers);
+  spitool_printf(spitool, "Throughput: %" PRIu64 ".%03" PRIu64
+                 " MB/s (%" PRIu64 " B/s)\n",
+                 bps / 1000000, bps / 1000 % 1000, bps);
+  spitool_printf(spitool, "Latency per sequence (us): min %" PRIu64
+                 " avg %" PRIu64 " max %" PRIu64 "\n",
+                 lmin, total / xfers, lmax);
+
+errout:
+  free(trans);
+  free(rxdata);
+  free(txdata);
+  return ret;
+}
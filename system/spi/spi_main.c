@@ -54,6 +54,13 @@ static struct spitool_s g_spitool;
 static const struct cmdmap_s g_spicmds[] =
 {
   { "?",    spicmd_help,  "Show help     ",  NULL },
+#ifdef CONFIG_SPITOOL_BENCH
+  {
+    "bench", spicmd_bench, "Benchmark bus ",
+      "[OPTIONS] [-i infile|-p hexbyte] [-o outfile] [-s segments] "
+      "[<bytes>] [<sequences>]"
+  },
+#endif
   { "bus",  spicmd_bus,   "List buses    ",  NULL },
   { "exch", spicmd_exch,  "SPI Exchange  ", "[OPTIONS] [<hex senddata>]" },
   { "help", spicmd_help,  "Show help     ", NULL },
@@ -184,6 +184,9 @@ void spitool_flush(FAR struct spitool_s *spitool);
 
 int spicmd_bus(FAR struct spitool_s *spitool, int argc, FAR char **argv);
 int spicmd_exch(FAR struct spitool_s *spitool, int argc, FAR char **argv);
+#ifdef CONFIG_SPITOOL_BENCH
+int spicmd_bench(FAR struct spitool_s *spitool, int argc, FAR char **argv);
+#endif
 
 /* Common logic */
 
@@ -25,6 +25,7 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <stdlib.h>
@@ -34,9 +35,13 @@
 #include <fcntl.h>
 #include <dirent.h>
 #include <sched.h>
+#include <signal.h>
 #include <syslog.h>
+#include <time.h>
 #include <errno.h>
 
+#include "system/stackmonitor.h"
+
 #ifdef CONFIG_SYSTEM_STACKMONITOR
 
 /****************************************************************************
@@ -59,6 +64,22 @@
 #  define CONFIG_SYSTEM_STACKMONITOR_MOUNTPOINT "/proc"
 #endif
 
+#ifndef CONFIG_SYSTEM_STACKMONITOR_ALERT_PERCENT
+#  define CONFIG_SYSTEM_STACKMONITOR_ALERT_PERCENT 80
+#endif
+
+#ifndef CONFIG_SYSTEM_STACKMONITOR_NEAR_PERCENT
+#  define CONFIG_SYSTEM_STACKMONITOR_NEAR_PERCENT 10
+#endif
+
+#ifndef CONFIG_SYSTEM_STACKMONITOR_FAST_INTERVAL
+#  define CONFIG_SYSTEM_STACKMONITOR_FAST_INTERVAL 250
+#endif
+
+#ifndef CONFIG_SYSTEM_STACKMONITOR_SIGNO
+#  define CONFIG_SYSTEM_STACKMONITOR_SIGNO 32
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -67,8 +88,11 @@ struct stkmon_state_s
 {
   volatile bool started;
   volatile bool stop;
+  bool fast;                    /* A task is close to the alert threshold */
   pid_t pid;
   char line[80];
+  FAR struct stackmonitor_table_s *table;
+  bool seen[CONFIG_SYSTEM_STACKMONITOR_MAXTASKS];
 };
 
 /****************************************************************************
@@ -76,6 +100,9 @@ struct stkmon_state_s
  ****************************************************************************/
 
 static struct stkmon_state_s g_stackmonitor;
+#ifndef CONFIG_SYSTEM_STACKMONITOR_SHM
+static struct stackmonitor_table_s g_stackmonitor_table;
+#endif
 #if CONFIG_TASK_NAME_SIZE > 0
 static const char g_name[] = "Name:";
 #endif
@@ -86,6 +113,213 @@ static const char g_stackused[] = "StackUsed:";
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: stkmon_table_open
+ *
+ * Description:
+ *   Create the table of stack usage, in a shared memory object if
+ *   configured.
+ *
+ ****************************************************************************/
+
+static int stkmon_table_open(void)
+{
+  FAR struct stackmonitor_table_s *table;
+
+#ifdef CONFIG_SYSTEM_STACKMONITOR_SHM
+  int ret;
+  int fd;
+
+  fd = shm_open(CONFIG_SYSTEM_STACKMONITOR_SHM_NAME, O_RDWR | O_CREAT,
+                0666);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  ret = ftruncate(fd, sizeof(*table));
+  if (ret < 0)
+    {
+      ret = -errno;
+      close(fd);
+      return ret;
+    }
+
+  table = mmap(NULL, sizeof(*table), PROT_READ | PROT_WRITE, MAP_SHARED,
+               fd, 0);
+  close(fd);
+
+  if (table == MAP_FAILED)
+    {
+      return -errno;
+    }
+#else
+  table = &g_stackmonitor_table;
+#endif
+
+  memset(table, 0, sizeof(*table));
+  table->interval      = CONFIG_SYSTEM_STACKMONITOR_INTERVAL * 1000;
+  table->alert_percent = CONFIG_SYSTEM_STACKMONITOR_ALERT_PERCENT;
+
+  g_stackmonitor.table = table;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: stkmon_table_close
+ ****************************************************************************/
+
+static void stkmon_table_close(void)
+{
+#ifdef CONFIG_SYSTEM_STACKMONITOR_SHM
+  munmap(g_stackmonitor.table, sizeof(*g_stackmonitor.table));
+  shm_unlink(CONFIG_SYSTEM_STACKMONITOR_SHM_NAME);
+#endif
+
+  g_stackmonitor.table = NULL;
+}
+
+/****************************************************************************
+ * Name: stkmon_table_begin
+ *
+ * Description:
+ *   Start an update of the table.  Readers retry while seq is odd.
+ *
+ ****************************************************************************/
+
+static void stkmon_table_begin(void)
+{
+  g_stackmonitor.table->seq++;
+  __sync_synchronize();
+
+  memset(g_stackmonitor.seen, 0, sizeof(g_stackmonitor.seen));
+  g_stackmonitor.fast = false;
+}
+
+/****************************************************************************
+ * Name: stkmon_table_end
+ ****************************************************************************/
+
+static void stkmon_table_end(void)
+{
+  FAR struct stackmonitor_table_s *table = g_stackmonitor.table;
+  int i;
+
+  /* Drop the tasks that have exited */
+
+  for (i = 0; i < CONFIG_SYSTEM_STACKMONITOR_MAXTASKS; i++)
+    {
+      if (!g_stackmonitor.seen[i])
+        {
+          table->entries[i].pid = 0;
+        }
+    }
+
+  table->interval = g_stackmonitor.fast ?
+                    CONFIG_SYSTEM_STACKMONITOR_FAST_INTERVAL :
+                    CONFIG_SYSTEM_STACKMONITOR_INTERVAL * 1000;
+
+  __sync_synchronize();
+  table->seq++;
+}
+
+/****************************************************************************
+ * Name: stkmon_alert
+ ****************************************************************************/
+
+static void stkmon_alert(FAR struct stackmonitor_entry_s *entry)
+{
+  pid_t watcher = g_stackmonitor.table->watcher;
+
+  syslog(LOG_WARNING, "Stack Monitor: PID %d uses %lu of %lu bytes "
+         "(%u%%)\n", (int)entry->pid, (unsigned long)entry->used,
+         (unsigned long)entry->size, entry->percent);
+
+  if (watcher > 0)
+    {
+      union sigval value;
+
+      value.sival_int = entry->pid;
+      if (sigqueue(watcher, CONFIG_SYSTEM_STACKMONITOR_SIGNO, value) < 0 &&
+          errno == ESRCH)
+        {
+          g_stackmonitor.table->watcher = 0;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: stkmon_update
+ *
+ * Description:
+ *   Record the stack usage of a task in the table and check it against the
+ *   alert threshold.
+ *
+ ****************************************************************************/
+
+static void stkmon_update(pid_t pid, unsigned long stack_size,
+                          unsigned long stack_used, FAR const char *name)
+{
+  FAR struct stackmonitor_entry_s *entry = NULL;
+  FAR struct stackmonitor_entry_s *avail = NULL;
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_STACKMONITOR_MAXTASKS; i++)
+    {
+      if (g_stackmonitor.table->entries[i].pid == pid)
+        {
+          entry = &g_stackmonitor.table->entries[i];
+          break;
+        }
+
+      if (avail == NULL && g_stackmonitor.table->entries[i].pid == 0 &&
+          !g_stackmonitor.seen[i])
+        {
+          avail = &g_stackmonitor.table->entries[i];
+        }
+    }
+
+  if (entry == NULL)
+    {
+      if (avail == NULL)
+        {
+          return;
+        }
+
+      entry = avail;
+      memset(entry, 0, sizeof(*entry));
+      entry->pid = pid;
+#if CONFIG_TASK_NAME_SIZE > 0
+      if (name != NULL)
+        {
+          strlcpy(entry->name, name, sizeof(entry->name));
+        }
+#endif
+    }
+
+  g_stackmonitor.seen[entry - g_stackmonitor.table->entries] = true;
+
+  entry->size    = stack_size;
+  entry->used    = stack_used;
+  entry->percent = stack_size > 0 ? stack_used * 100 / stack_size : 0;
+
+  if (entry->percent >= CONFIG_SYSTEM_STACKMONITOR_ALERT_PERCENT)
+    {
+      if (!entry->alerted)
+        {
+          entry->alerted = true;
+          stkmon_alert(entry);
+        }
+    }
+  else if (entry->percent + CONFIG_SYSTEM_STACKMONITOR_NEAR_PERCENT >=
+           CONFIG_SYSTEM_STACKMONITOR_ALERT_PERCENT)
+    {
+      /* Sample faster to catch the crossing before an overflow */
+
+      g_stackmonitor.fast = true;
+    }
+}
+
 /****************************************************************************
  * Name: stkmon_isolate_value
  ****************************************************************************/
@@ -113,7 +347,7 @@ static FAR char *stkmon_isolate_value(FAR char *line)
  * Name: stkmon_process_directory
  ****************************************************************************/
 
-static int stkmon_process_directory(FAR struct dirent *entryp)
+static int stkmon_process_directory(FAR struct dirent *entryp, bool print)
 {
   FAR char *filepath;
   FAR char *endptr;
@@ -251,15 +485,24 @@ static int stkmon_process_directory(FAR struct dirent *entryp)
         }
     }
 
+#if CONFIG_TASK_NAME_SIZE > 0
+  stkmon_update(atoi(entryp->d_name), stack_size, stack_used, name);
+#else
+  stkmon_update(atoi(entryp->d_name), stack_size, stack_used, NULL);
+#endif
+
   /* Finally, output the stack info that we gleaned from the procfs */
 
+  if (print)
+    {
 #if CONFIG_TASK_NAME_SIZE > 0
-  printf("%5s %6lu %6lu %s\n",
-         entryp->d_name, stack_size, stack_used, name);
+      printf("%5s %6lu %6lu %s\n",
+             entryp->d_name, stack_size, stack_used, name);
 #else
-  printf("%5s %6lu %6lu\n",
-         entryp->d_name, stack_size, stack_used);
+      printf("%5s %6lu %6lu\n",
+             entryp->d_name, stack_size, stack_used);
 #endif
+    }
 
   ret = OK;
 
@@ -309,20 +552,48 @@ static bool stackmonitor_check_name(FAR char *name)
 
 static int stackmonitor_daemon(int argc, char **argv)
 {
+  struct timespec now;
+  time_t lastprint = 0;
   DIR *dirp;
   int exitcode = EXIT_SUCCESS;
   int errcount = 0;
+  bool print;
   int ret;
 
   printf("Stack Monitor: Running: %d\n", g_stackmonitor.pid);
 
+  ret = stkmon_table_open();
+  if (ret < 0)
+    {
+      fprintf(stderr, "Stack Monitor: Failed to create the table: %d\n",
+              ret);
+      exitcode = EXIT_FAILURE;
+      goto errout;
+    }
+
   /* Loop until we detect that there is a request to stop. */
 
   while (!g_stackmonitor.stop)
     {
-      /* Wait for the next sample interval */
+      /* Wait for the next sample interval.  The usage is printed at the
+       * normal rate only, even when sampling faster.
+       */
 
-      sleep(CONFIG_SYSTEM_STACKMONITOR_INTERVAL);
+      if (g_stackmonitor.fast)
+        {
+          usleep(CONFIG_SYSTEM_STACKMONITOR_FAST_INTERVAL * 1000);
+        }
+      else
+        {
+          sleep(CONFIG_SYSTEM_STACKMONITOR_INTERVAL);
+        }
+
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      print = now.tv_sec - lastprint >= CONFIG_SYSTEM_STACKMONITOR_INTERVAL;
+      if (print)
+        {
+          lastprint = now.tv_sec;
+        }
 
       /* Open the top-level procfs directory */
 
@@ -341,15 +612,23 @@ static int stackmonitor_daemon(int argc, char **argv)
               exitcode = EXIT_FAILURE;
               break;
             }
+
+          continue;
         }
 
       /* Output the header */
 
+      if (print)
+        {
 #if CONFIG_TASK_NAME_SIZE > 0
-      printf("%-5s %-6s %-6s %s\n", "PID", "SIZE", "USED", "THREAD NAME");
+          printf("%-5s %-6s %-6s %s\n", "PID", "SIZE", "USED",
+                 "THREAD NAME");
 #else
-      printf("%-5s %-6s %-6s\n", "PID", "SIZE", "USED");
+          printf("%-5s %-6s %-6s\n", "PID", "SIZE", "USED");
 #endif
+        }
+
+      stkmon_table_begin();
 
       /* Read each directory entry */
 
@@ -372,7 +651,7 @@ static int stackmonitor_daemon(int argc, char **argv)
             {
               /* Looks good -- process the directory */
 
-              ret = stkmon_process_directory(entryp);
+              ret = stkmon_process_directory(entryp, print);
               if (ret < 0)
                 {
                   /* Failed to process the thread directory */
@@ -392,9 +671,13 @@ static int stackmonitor_daemon(int argc, char **argv)
             }
         }
 
+      stkmon_table_end();
       closedir(dirp);
     }
 
+  stkmon_table_close();
+
+errout:
   /* Stopped */
 
   g_stackmonitor.stop    = false;
@@ -25,77 +25,85 @@
 #include <nuttx/config.h>
 
 #include <sys/wait.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <sched.h>
 #include <spawn.h>
 #include <assert.h>
 #include <debug.h>
 #include <errno.h>
+#include <string.h>
+
+#ifdef CONFIG_SYSTEM_SYSTEM_BUILTIN
+#  include "builtin/builtin.h"
+#endif
 
 #include "nshlib/nshlib.h"
 
 /****************************************************************************
- * Public Functions
+ * Pre-processor Definitions
  ****************************************************************************/
 
+/* Maximum number of arguments of a builtin run without the shell */
+
+#define SYSTEM_MAXARGS 8
+
 /****************************************************************************
- * Name: system
+ * Private Data
+ ****************************************************************************/
+
+/* The spawn attributes of the shell are the same for every call */
+
+static posix_spawnattr_t g_system_attr;
+static bool g_system_attrvalid;
+
+#ifdef CONFIG_SYSTEM_SYSTEM_BUILTIN
+/* A command made only of these characters means the same to the shell as
+ * a plain list of words: no quoting, variables, redirection or pipes.
+ */
+
+static const char g_system_plain[] =
+  "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+  " \t_-+=.,:/@%";
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: system_initattr
  *
  * Description:
- *   Use system to pass a command string to the NSH parser and wait for it
- *   to finish executing.
- *
- *   This is an experimental version with known incompatibilities:
- *
- *   1. It is not a part of libc due to its close association with NSH.  The
- *      function is still prototyped in nuttx/include/stdlib.h, however.
- *   2. It cannot use /bin/sh since that program will not exist in most
- *      embedded configurations.  Rather, it will spawn a shell-specific
- *      system command -- currently only NSH.
- *   3. REVISIT: There may be some issues with returned values.
- *   4. Of course, only NSH commands will be supported so that still means
- *      that many leveraged system() calls will still not be functional.
+ *   Initialize the spawn attributes of the shell.
  *
  ****************************************************************************/
 
-int system(FAR const char *cmd)
+static int system_initattr(FAR posix_spawnattr_t *attr)
 {
-  FAR char *argv[4];
   struct sched_param param;
-  posix_spawnattr_t attr;
-  pid_t pid;
   int errcode;
-  int rc;
-  int ret;
-
-  /* REVISIT: If cmd is NULL, then system() should return a non-zero value to
-   * indicate if the command processor is available or zero if it is not.
-   */
-
-  DEBUGASSERT(cmd != NULL);
-
-  /* Initialize attributes for task_spawn() (or posix_spawn()). */
 
-  errcode = posix_spawnattr_init(&attr);
+  errcode = posix_spawnattr_init(attr);
   if (errcode != 0)
     {
-      goto errout;
+      return errcode;
     }
 
   /* Set the correct stack size and priority */
 
   param.sched_priority = CONFIG_SYSTEM_SYSTEM_PRIORITY;
-  errcode = posix_spawnattr_setschedparam(&attr, &param);
+  errcode = posix_spawnattr_setschedparam(attr, &param);
   if (errcode != 0)
     {
-      goto errout_with_attrs;
+      goto errout;
     }
 
-  errcode = posix_spawnattr_setstacksize(&attr,
+  errcode = posix_spawnattr_setstacksize(attr,
                                          CONFIG_SYSTEM_SYSTEM_STACKSIZE);
   if (errcode != 0)
     {
-      goto errout_with_attrs;
+      goto errout;
     }
 
   /* If robin robin scheduling is enabled, then set the scheduling policy
@@ -103,52 +111,171 @@ int system(FAR const char *cmd)
    */
 
 #if CONFIG_RR_INTERVAL > 0
-  errcode = posix_spawnattr_setschedpolicy(&attr, SCHED_RR);
+  errcode = posix_spawnattr_setschedpolicy(attr, SCHED_RR);
   if (errcode != 0)
     {
-      goto errout_with_attrs;
+      goto errout;
     }
 
-  errcode = posix_spawnattr_setflags(&attr,
+  errcode = posix_spawnattr_setflags(attr,
                                      POSIX_SPAWN_SETSCHEDPARAM |
                                      POSIX_SPAWN_SETSCHEDULER);
-  if (errcode != 0)
+#else
+  errcode = posix_spawnattr_setflags(attr, POSIX_SPAWN_SETSCHEDPARAM);
+#endif
+
+  if (errcode == 0)
     {
-      goto errout_with_attrs;
+      return 0;
     }
 
-#else
-  errcode = posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSCHEDPARAM);
-  if (errcode != 0)
+errout:
+  posix_spawnattr_destroy(attr);
+  return errcode;
+}
+
+/****************************************************************************
+ * Name: system_builtin
+ *
+ * Description:
+ *   Start a builtin application directly, without a shell in between, if
+ *   the command is a plain list of words naming one.  Returns the PID of
+ *   the application, or ERROR if the command needs the shell.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_SYSTEM_BUILTIN
+static pid_t system_builtin(FAR const char *cmd)
+{
+  FAR char *argv[SYSTEM_MAXARGS + 1];
+  FAR char *cmdline;
+  FAR char *saveptr;
+  FAR char *arg;
+  pid_t pid = ERROR;
+  int argc = 0;
+
+  if (cmd[strspn(cmd, g_system_plain)] != '\0')
     {
-      goto errout_with_attrs;
+      return ERROR;
     }
 
-#endif
+  cmdline = strdup(cmd);
+  if (cmdline == NULL)
+    {
+      return ERROR;
+    }
 
-  /* Spawn nsh_system() which will execute the command under the shell. */
+  arg = strtok_r(cmdline, " \t", &saveptr);
+  while (arg != NULL && argc < SYSTEM_MAXARGS)
+    {
+      argv[argc++] = arg;
+      arg = strtok_r(NULL, " \t", &saveptr);
+    }
 
-  argv[1] = "-c";
-  argv[2] = (FAR char *)cmd;
-  argv[3] = NULL;
+  argv[argc] = NULL;
 
-#ifdef CONFIG_SYSTEM_SYSTEM_SHPATH
-  argv[0] = CONFIG_SYSTEM_SYSTEM_SHPATH;
-  errcode = posix_spawn(&pid, argv[0],  NULL, &attr, argv, NULL);
-#else
-  pid = task_spawn("system", nsh_system, NULL, &attr, argv + 1, NULL);
-  if (pid < 0)
+  if (arg == NULL && argc > 0 && builtin_isavail(argv[0]) >= 0)
     {
-      errcode = -pid;
+      pid = exec_builtin(argv[0], argv, NULL, 0);
     }
+
+  /* The arguments have been copied by the spawn */
+
+  free(cmdline);
+  return pid;
+}
 #endif
 
-  /* Release the attributes and check for an error from the spawn operation */
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
 
-  if (errcode != 0)
+/****************************************************************************
+ * Name: system
+ *
+ * Description:
+ *   Use system to pass a command string to the NSH parser and wait for it
+ *   to finish executing.
+ *
+ *   This is an experimental version with known incompatibilities:
+ *
+ *   1. It is not a part of libc due to its close association with NSH.  The
+ *      function is still prototyped in nuttx/include/stdlib.h, however.
+ *   2. It cannot use /bin/sh since that program will not exist in most
+ *      embedded configurations.  Rather, it will spawn a shell-specific
+ *      system command -- currently only NSH.
+ *   3. REVISIT: There may be some issues with returned values.
+ *   4. Of course, only NSH commands will be supported so that still means
+ *      that many leveraged system() calls will still not be functional.
+ *
+ ****************************************************************************/
+
+int system(FAR const char *cmd)
+{
+  FAR char *argv[4];
+  pid_t pid = ERROR;
+  int errcode = 0;
+  int rc;
+  int ret;
+
+  /* REVISIT: If cmd is NULL, then system() should return a non-zero value to
+   * indicate if the command processor is available or zero if it is not.
+   */
+
+  DEBUGASSERT(cmd != NULL);
+
+#ifdef CONFIG_SYSTEM_SYSTEM_BUILTIN
+  /* Start a builtin application directly if the command allows it */
+
+  pid = system_builtin(cmd);
+  if (pid < 0)
+#endif
     {
-      serr("ERROR: Spawn failed: %d\n", errcode);
-      goto errout_with_attrs;
+      /* Initialize the attributes for task_spawn() (or posix_spawn()) on
+       * the first call, they are reused afterwards.
+       */
+
+      sched_lock();
+      if (!g_system_attrvalid)
+        {
+          errcode = system_initattr(&g_system_attr);
+          g_system_attrvalid = errcode == 0;
+        }
+
+      sched_unlock();
+      if (errcode != 0)
+        {
+          goto errout;
+        }
+
+      /* Spawn nsh_system() which will execute the command under the
+       * shell.
+       */
+
+      argv[1] = "-c";
+      argv[2] = (FAR char *)cmd;
+      argv[3] = NULL;
+
+#ifdef CONFIG_SYSTEM_SYSTEM_SHPATH
+      argv[0] = CONFIG_SYSTEM_SYSTEM_SHPATH;
+      errcode = posix_spawn(&pid, argv[0],  NULL, &g_system_attr, argv,
+                            NULL);
+#else
+      pid = task_spawn("system", nsh_system, NULL, &g_system_attr,
+                       argv + 1, NULL);
+      if (pid < 0)
+        {
+          errcode = -pid;
+        }
+#endif
+
+      /* Check for an error from the spawn operation */
+
+      if (errcode != 0)
+        {
+          serr("ERROR: Spawn failed: %d\n", errcode);
+          goto errout;
+        }
     }
 
   /* Wait for the shell to return */
@@ -161,12 +288,8 @@ int system(FAR const char *cmd)
       rc = ERROR;
     }
 
-  posix_spawnattr_destroy(&attr);
   return rc;
 
-errout_with_attrs:
-  posix_spawnattr_destroy(&attr);
-
 errout:
   errno = errcode;
   return ERROR;
@@ -35,6 +35,34 @@
 #include <errno.h>
 #include <string.h>
 
+#ifdef CONFIG_SYSTEM_TASKSET_POLICY
+#  include <ctype.h>
+#  include <dirent.h>
+#  include <fnmatch.h>
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define TASKSET_PATTERN_MAX 32
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TASKSET_POLICY
+/* One line of the rules file: tasks whose name matches the pattern are
+ * placed on the CPUs of the mask.
+ */
+
+struct taskset_rule_s
+{
+  char pattern[TASKSET_PATTERN_MAX];
+  cpu_set_t mask;
+};
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -47,6 +75,14 @@ static void show_usage(FAR const char *progname, int exitcode)
 {
   printf("%s mask command ...\n", progname);
   printf("%s -p [mask] pid\n", progname);
+#ifdef CONFIG_SYSTEM_TASKSET_POLICY
+  printf("%s -f rules [-i seconds] [-r]\n", progname);
+  printf("  -f: Apply the rules of the file, one \"pattern mask\" "
+         "per line\n");
+  printf("  -i: Keep running and apply the rules to new tasks at this "
+         "interval\n");
+  printf("  -r: Report the load of each CPU after applying the rules\n");
+#endif
   exit(exitcode);
 }
 
@@ -74,6 +110,264 @@ static bool get_cpuset(const char *arg, cpu_set_t *cpu_set)
   return ret;
 }
 
+#ifdef CONFIG_SYSTEM_TASKSET_POLICY
+/****************************************************************************
+ * Name: taskset_loadrules
+ *
+ * Description:
+ *   Read the rules file.  Each line holds a task name pattern (fnmatch
+ *   syntax) and a CPU mask; empty lines and lines starting with '#' are
+ *   ignored.  The first matching rule wins.
+ *
+ ****************************************************************************/
+
+static int taskset_loadrules(FAR const char *path,
+                             FAR struct taskset_rule_s *rules, int max)
+{
+  char line[80];
+  char mask[16];
+  FAR FILE *stream;
+  FAR char *end;
+  unsigned long val;
+  int nrules = 0;
+  int lineno = 0;
+
+  stream = fopen(path, "r");
+  if (stream == NULL)
+    {
+      fprintf(stderr, "Failed to open %s: %d\n", path, errno);
+      return -errno;
+    }
+
+  while (fgets(line, sizeof(line), stream) != NULL)
+    {
+      lineno++;
+      if (sscanf(line, "%31s %15s", rules[nrules].pattern, mask) != 2 ||
+          rules[nrules].pattern[0] == '#')
+        {
+          continue;
+        }
+
+      val = strtoul(mask, &end, 0);
+      if (*end != '\0' || val == 0 || val >= (1ul << CONFIG_SMP_NCPUS))
+        {
+          fprintf(stderr, "%s:%d: invalid cpuset %s\n", path, lineno, mask);
+          continue;
+        }
+
+      rules[nrules].mask = (cpu_set_t)val;
+      if (++nrules == max)
+        {
+          fprintf(stderr, "%s: only %d rules are used\n", path, max);
+          break;
+        }
+    }
+
+  fclose(stream);
+  return nrules;
+}
+
+/****************************************************************************
+ * Name: taskset_readname
+ ****************************************************************************/
+
+static int taskset_readname(FAR const char *pid, FAR char *name,
+                            size_t size)
+{
+  char path[32];
+  char line[64];
+  FAR FILE *stream;
+  FAR char *ptr;
+  int ret = -ENOENT;
+
+  snprintf(path, sizeof(path), "/proc/%s/status", pid);
+  stream = fopen(path, "r");
+  if (stream == NULL)
+    {
+      return -errno;
+    }
+
+  /* The first line is "Name:       <name>" */
+
+  while (fgets(line, sizeof(line), stream) != NULL)
+    {
+      if (strncmp(line, "Name:", 5) == 0)
+        {
+          for (ptr = &line[5]; isspace(*ptr); ptr++);
+          ptr[strcspn(ptr, "\r\n")] = '\0';
+          strlcpy(name, ptr, size);
+          ret = OK;
+          break;
+        }
+    }
+
+  fclose(stream);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: taskset_apply
+ *
+ * Description:
+ *   Set the affinity of every task that matches a rule and is not yet
+ *   placed as the rule says.  Returns the number of tasks moved.
+ *
+ ****************************************************************************/
+
+static int taskset_apply(FAR const struct taskset_rule_s *rules,
+                         int nrules)
+{
+  char name[TASKSET_PATTERN_MAX];
+  FAR struct dirent *entry;
+  FAR DIR *dir;
+  cpu_set_t cpuset;
+  int nmoved = 0;
+  pid_t pid;
+  int i;
+
+  dir = opendir("/proc");
+  if (dir == NULL)
+    {
+      fprintf(stderr, "Failed to open /proc: %d\n", errno);
+      return -errno;
+    }
+
+  while ((entry = readdir(dir)) != NULL)
+    {
+      /* Tasks are the numeric entries; the idle tasks stay where they are */
+
+      if (!isdigit(entry->d_name[0]))
+        {
+          continue;
+        }
+
+      pid = atoi(entry->d_name);
+      if (pid < CONFIG_SMP_NCPUS ||
+          taskset_readname(entry->d_name, name, sizeof(name)) < 0)
+        {
+          continue;
+        }
+
+      for (i = 0; i < nrules; i++)
+        {
+          if (fnmatch(rules[i].pattern, name, 0) == 0)
+            {
+              break;
+            }
+        }
+
+      if (i == nrules ||
+          sched_getaffinity(pid, sizeof(cpu_set_t), &cpuset) < 0 ||
+          cpuset == rules[i].mask)
+        {
+          continue;
+        }
+
+      if (sched_setaffinity(pid, sizeof(cpu_set_t), &rules[i].mask) < 0)
+        {
+          fprintf(stderr, "pid %d (%s): sched_setaffinity failed: %d\n",
+                  pid, name, errno);
+          continue;
+        }
+
+      printf("pid %d (%s): affinity %x -> %x\n",
+             pid, name, cpuset, rules[i].mask);
+      nmoved++;
+    }
+
+  closedir(dir);
+  return nmoved;
+}
+
+/****************************************************************************
+ * Name: taskset_report
+ *
+ * Description:
+ *   Print the load of each CPU: 100% less the load of its idle task, the
+ *   idle task of CPU n having PID n.
+ *
+ ****************************************************************************/
+
+static void taskset_report(void)
+{
+  char path[32];
+  char line[16];
+  FAR FILE *stream;
+  int whole;
+  int tenth;
+  int cpu;
+  int busy;
+
+  for (cpu = 0; cpu < CONFIG_SMP_NCPUS; cpu++)
+    {
+      snprintf(path, sizeof(path), "/proc/%d/loadavg", cpu);
+      stream = fopen(path, "r");
+      if (stream == NULL)
+        {
+          printf("CPU%d: load unavailable\n", cpu);
+          continue;
+        }
+
+      if (fgets(line, sizeof(line), stream) != NULL &&
+          sscanf(line, "%d.%d", &whole, &tenth) == 2)
+        {
+          busy = 1000 - (whole * 10 + tenth);
+          printf("CPU%d: %3d.%d%% busy\n", cpu, busy / 10, busy % 10);
+        }
+
+      fclose(stream);
+    }
+}
+
+/****************************************************************************
+ * Name: taskset_policy
+ ****************************************************************************/
+
+static int taskset_policy(FAR const char *path, int interval, bool report)
+{
+  FAR struct taskset_rule_s *rules;
+  int nrules;
+
+  rules = malloc(CONFIG_SYSTEM_TASKSET_MAXRULES * sizeof(*rules));
+  if (rules == NULL)
+    {
+      return EXIT_FAILURE;
+    }
+
+  nrules = taskset_loadrules(path, rules, CONFIG_SYSTEM_TASKSET_MAXRULES);
+  if (nrules <= 0)
+    {
+      free(rules);
+      return EXIT_FAILURE;
+    }
+
+  /* Place the running tasks, then the new ones as they appear */
+
+  for (; ; )
+    {
+      if (taskset_apply(rules, nrules) > 0 && report)
+        {
+          taskset_report();
+        }
+
+      if (interval <= 0)
+        {
+          break;
+        }
+
+      sleep(interval);
+    }
+
+  if (report)
+    {
+      taskset_report();
+    }
+
+  free(rules);
+  return EXIT_SUCCESS;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -87,6 +381,11 @@ int main(int argc, FAR char *argv[])
   cpu_set_t cpuset;
   int rc;
   int i;
+#ifdef CONFIG_SYSTEM_TASKSET_POLICY
+  FAR const char *rules = NULL;
+  bool report = false;
+  int interval = 0;
+#endif
 
   command[0] = '\0';
   CPU_ZERO(&cpuset);
@@ -95,10 +394,24 @@ int main(int argc, FAR char *argv[])
 
   exitcode = EXIT_FAILURE;
 
-  while ((option = getopt(argc, argv, ":p:h")) != ERROR)
+  while ((option = getopt(argc, argv, ":p:f:i:rh")) != ERROR)
     {
       switch (option)
         {
+#ifdef CONFIG_SYSTEM_TASKSET_POLICY
+          case 'f':
+            rules = optarg;
+            break;
+
+          case 'i':
+            interval = atoi(optarg);
+            break;
+
+          case 'r':
+            report = true;
+            break;
+#endif
+
           case 'p':
             {
               pid = (int)atoi(argv[argc -1]);
@@ -111,6 +424,13 @@ int main(int argc, FAR char *argv[])
         }
     }
 
+#ifdef CONFIG_SYSTEM_TASKSET_POLICY
+  if (rules != NULL)
+    {
+      return taskset_policy(rules, interval, report);
+    }
+#endif
+
   if (-1 != pid)
     {
       if (4 == argc)
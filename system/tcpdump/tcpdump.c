@@ -26,18 +26,24 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <net/if.h>
 #include <net/if_arp.h>
 #include <netpacket/packet.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <nuttx/net/netconfig.h>
 
 #include "argtable3.h"
+#include "tcpdump.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -50,10 +56,25 @@
 
 #define DEFAULT_SNAPLEN 262144
 
-/* https://www.tcpdump.org/linktypes.html */
+/* Maximum number of words of the filter expression */
 
-#define LINKTYPE_ETHERNET 1   /* IEEE 802.3 Ethernet */
-#define LINKTYPE_RAW      101 /* Raw IP */
+#define MAX_FILTER_ARGS   32
+
+#ifndef CONFIG_SYSTEM_TCPDUMP_RINGSIZE
+#  define CONFIG_SYSTEM_TCPDUMP_RINGSIZE 65536
+#endif
+
+#ifndef CONFIG_SYSTEM_TCPDUMP_BATCHSIZE
+#  define CONFIG_SYSTEM_TCPDUMP_BATCHSIZE 4096
+#endif
+
+/* Data that waits longer than this in the ring is written anyway */
+
+#define FLUSH_MSEC        1000
+
+/* Maximum number of file changes queued in the ring */
+
+#define MAX_ROTATIONS     4
 
 /****************************************************************************
  * Private Types
@@ -83,15 +104,46 @@ struct tcpdump_args_s
   FAR struct arg_str *interface;
   FAR struct arg_str *file;
   FAR struct arg_int *snaplen;
+  FAR struct arg_int *filesize;
+  FAR struct arg_int *filecount;
+#ifdef CONFIG_SYSTEM_TCPDUMP_FILTER
+  FAR struct arg_str *expr;
+#endif
   FAR struct arg_end *end;
 };
 
+/* Captured data waits in a ring for the writer thread.  The counters only
+ * grow; their value modulo the ring size is the position in the ring.
+ */
+
+struct tcpdump_ring_s
+{
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+  FAR uint8_t    *data;
+  uint64_t        produced;                /* Bytes put into the ring */
+  uint64_t        consumed;                /* Bytes written out */
+  uint64_t        rotate[MAX_ROTATIONS];   /* Where new files start */
+  int             nrotate;
+  bool            done;                    /* No more data will come */
+};
+
 struct tcpdump_cfgs_s
 {
   int fd;
   int sd;
   uint32_t snaplen;
   uint32_t linktype;
+  FAR const char *file;
+  uint64_t filesize;                       /* Rotate after, 0: never */
+  int filecount;                           /* Files to cycle, 0: no limit */
+  int fileno;                              /* Number of the current file */
+  unsigned long captured;
+  unsigned long dropped;
+  struct tcpdump_ring_s ring;
+#ifdef CONFIG_SYSTEM_TCPDUMP_FILTER
+  struct tcpdump_filter_s filter;
+#endif
 };
 
 /****************************************************************************
@@ -114,10 +166,43 @@ static void sigexit(int signo)
 }
 
 /****************************************************************************
- * Name: write_filehdr
+ * Name: ring_put
+ *
+ * Description:
+ *   Copy data into the ring.  The caller has checked that it fits.
+ *
+ ****************************************************************************/
+
+static void ring_put(FAR struct tcpdump_ring_s *ring, FAR const void *buf,
+                     size_t len)
+{
+  size_t pos = ring->produced % CONFIG_SYSTEM_TCPDUMP_RINGSIZE;
+  size_t part = MIN(len, CONFIG_SYSTEM_TCPDUMP_RINGSIZE - pos);
+
+  memcpy(ring->data + pos, buf, part);
+  memcpy(ring->data, (FAR const uint8_t *)buf + part, len - part);
+  ring->produced += len;
+}
+
+/****************************************************************************
+ * Name: ring_space
+ ****************************************************************************/
+
+static size_t ring_space(FAR struct tcpdump_ring_s *ring)
+{
+  return CONFIG_SYSTEM_TCPDUMP_RINGSIZE -
+         (size_t)(ring->produced - ring->consumed);
+}
+
+/****************************************************************************
+ * Name: put_filehdr
+ *
+ * Description:
+ *   Queue the pcap header of a new file.  Called with the ring locked.
+ *
  ****************************************************************************/
 
-static int write_filehdr(int fd, uint32_t snaplen, uint32_t linktype)
+static void put_filehdr(FAR struct tcpdump_cfgs_s *cfgs)
 {
   /* No need to change byte order of any field, reader will swap all fields
    * if magic number is in swapped order.
@@ -130,15 +215,54 @@ static int write_filehdr(int fd, uint32_t snaplen, uint32_t linktype)
       TCPDUMP_VERSION_MINOR, /* version_minor */
       0,                     /* thiszone */
       0,                     /* sigfigs */
-      snaplen,               /* snaplen */
-      linktype               /* linktype */
+      cfgs->snaplen,         /* snaplen */
+      cfgs->linktype         /* linktype */
     };
 
-  /* Write hdr into file. */
+  ring_put(&cfgs->ring, &hdr, sizeof(hdr));
+}
+
+/****************************************************************************
+ * Name: get_filename
+ *
+ * Description:
+ *   Name of the n-th file: the name given with -w, followed by the file
+ *   number for all but the first file, or for all files with -W.
+ *
+ ****************************************************************************/
+
+static void get_filename(FAR const struct tcpdump_cfgs_s *cfgs, int n,
+                         FAR char *buf, size_t size)
+{
+  if (cfgs->filecount > 0)
+    {
+      snprintf(buf, size, "%s%d", cfgs->file, n % cfgs->filecount);
+    }
+  else if (n > 0)
+    {
+      snprintf(buf, size, "%s%d", cfgs->file, n);
+    }
+  else
+    {
+      strlcpy(buf, cfgs->file, size);
+    }
+}
+
+/****************************************************************************
+ * Name: next_file
+ ****************************************************************************/
+
+static int next_file(FAR struct tcpdump_cfgs_s *cfgs)
+{
+  char name[PATH_MAX];
 
-  if (write(fd, &hdr, sizeof(hdr)) < 0)
+  close(cfgs->fd);
+
+  get_filename(cfgs, ++cfgs->fileno, name, sizeof(name));
+  cfgs->fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (cfgs->fd < 0)
     {
-      perror("ERROR: write() failed");
+      perror("ERROR: open() failed");
       return -errno;
     }
 
@@ -146,37 +270,192 @@ static int write_filehdr(int fd, uint32_t snaplen, uint32_t linktype)
 }
 
 /****************************************************************************
- * Name: write_packet
+ * Name: writer_thread
+ *
+ * Description:
+ *   Write the ring to the capture files.  Writes are whole batches that
+ *   start at a multiple of the batch size in the file, except when the
+ *   data has waited for FLUSH_MSEC, at the end of a file and at exit.
+ *
  ****************************************************************************/
 
-static int write_packet(int fd, uint32_t snaplen, uint32_t pkt_len,
-                        FAR const void *buf, FAR const struct timespec *ts)
+static FAR void *writer_thread(FAR void *arg)
 {
-  struct pcap_pkthdr_s hdr =
+  FAR struct tcpdump_cfgs_s *cfgs = arg;
+  FAR struct tcpdump_ring_s *ring = &cfgs->ring;
+  struct timespec abstime;
+  uint64_t fileoff = 0;
+  uint64_t avail;
+  size_t chunk;
+  size_t pos;
+  ssize_t ret;
+  bool flush = false;
+
+  pthread_mutex_lock(&ring->lock);
+
+  for (; ; )
     {
-      ts->tv_sec,            /* ts_sec */
-      ts->tv_nsec,           /* ts_nsec */
-      MIN(snaplen, pkt_len), /* caplen */
-      pkt_len                /* len */
-    };
+      /* Start the next file? */
+
+      if (ring->nrotate > 0 && ring->rotate[0] == ring->consumed)
+        {
+          ring->nrotate--;
+          memmove(ring->rotate, ring->rotate + 1,
+                  ring->nrotate * sizeof(ring->rotate[0]));
+
+          pthread_mutex_unlock(&ring->lock);
+          ret = next_file(cfgs);
+          pthread_mutex_lock(&ring->lock);
+
+          if (ret < 0)
+            {
+              break;
+            }
+
+          fileoff = 0;
+          continue;
+        }
+
+      /* Write up to the end of this file */
+
+      avail = ring->produced - ring->consumed;
+      if (ring->nrotate > 0)
+        {
+          avail = ring->rotate[0] - ring->consumed;
+          flush = true;
+        }
+
+      chunk = CONFIG_SYSTEM_TCPDUMP_BATCHSIZE -
+              (size_t)(fileoff % CONFIG_SYSTEM_TCPDUMP_BATCHSIZE);
+      if (avail < chunk)
+        {
+          if (avail > 0 && (flush || ring->done))
+            {
+              chunk = (size_t)avail;
+            }
+          else if (ring->done)
+            {
+              break;
+            }
+          else
+            {
+              /* Wait for a full batch, or flush what there is if it has
+               * waited too long.
+               */
+
+              clock_gettime(CLOCK_REALTIME, &abstime);
+              abstime.tv_sec  += FLUSH_MSEC / 1000;
+              abstime.tv_nsec += (FLUSH_MSEC % 1000) * 1000000;
+              if (abstime.tv_nsec >= 1000000000)
+                {
+                  abstime.tv_sec++;
+                  abstime.tv_nsec -= 1000000000;
+                }
+
+              flush = pthread_cond_timedwait(&ring->cond, &ring->lock,
+                                             &abstime) == ETIMEDOUT;
+              continue;
+            }
+        }
+
+      pos   = ring->consumed % CONFIG_SYSTEM_TCPDUMP_RINGSIZE;
+      chunk = MIN(chunk, CONFIG_SYSTEM_TCPDUMP_RINGSIZE - pos);
+
+      /* The producer does not touch queued data, write it unlocked */
+
+      pthread_mutex_unlock(&ring->lock);
+      ret = write(cfgs->fd, ring->data + pos, chunk);
+      pthread_mutex_lock(&ring->lock);
+
+      if (ret <= 0)
+        {
+          perror("ERROR: write() failed");
+          break;
+        }
+
+      ring->consumed += ret;
+      fileoff += ret;
+      flush = false;
+      pthread_cond_signal(&ring->cond);
+    }
 
-  /* Write hdr into file. */
+  /* Stop the capture if the writer has failed */
 
-  if (write(fd, &hdr, sizeof(hdr)) < 0)
+  if (!ring->done)
     {
-      perror("ERROR: write() failed");
-      return -errno;
+      g_exiting = true;
     }
 
-  /* Write pkt into file. */
+  pthread_mutex_unlock(&ring->lock);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: put_packet
+ *
+ * Description:
+ *   Queue a packet and its pcap record header.  The packet is dropped if
+ *   the writer is too far behind.
+ *
+ ****************************************************************************/
+
+static void put_packet(FAR struct tcpdump_cfgs_s *cfgs,
+                       FAR uint64_t *filebytes, FAR uint8_t *buf,
+                       uint32_t pkt_len, uint32_t caplen,
+                       FAR const struct timespec *ts)
+{
+  FAR struct tcpdump_ring_s *ring = &cfgs->ring;
+  FAR struct pcap_pkthdr_s *hdr = (FAR struct pcap_pkthdr_s *)buf;
+  size_t reclen;
+  size_t need;
+  bool rotate = false;
+
+  hdr->ts_sec  = ts->tv_sec;
+  hdr->ts_nsec = ts->tv_nsec;
+  hdr->caplen  = MIN(caplen, pkt_len);
+  hdr->len     = pkt_len;
+
+  reclen = sizeof(*hdr) + hdr->caplen;
+  need   = reclen;
 
-  if (write(fd, buf, hdr.caplen) < 0)
+  pthread_mutex_lock(&ring->lock);
+
+  /* Start a new file before this packet if the current one is full */
+
+  if (cfgs->filesize > 0 &&
+      *filebytes + reclen > cfgs->filesize &&
+      *filebytes > sizeof(struct pcap_filehdr_s) &&
+      ring->nrotate < MAX_ROTATIONS)
     {
-      perror("ERROR: write() failed");
-      return -errno;
+      rotate = true;
+      need  += sizeof(struct pcap_filehdr_s);
     }
 
-  return OK;
+  if (ring_space(ring) < need)
+    {
+      cfgs->dropped++;
+      pthread_mutex_unlock(&ring->lock);
+      return;
+    }
+
+  if (rotate)
+    {
+      ring->rotate[ring->nrotate++] = ring->produced;
+      put_filehdr(cfgs);
+      *filebytes = sizeof(struct pcap_filehdr_s);
+    }
+
+  ring_put(ring, buf, reclen);
+  *filebytes += reclen;
+  cfgs->captured++;
+
+  if (rotate || ring->produced - ring->consumed >=
+                CONFIG_SYSTEM_TCPDUMP_BATCHSIZE)
+    {
+      pthread_cond_signal(&ring->cond);
+    }
+
+  pthread_mutex_unlock(&ring->lock);
 }
 
 /****************************************************************************
@@ -235,46 +514,112 @@ static uint32_t get_linktype(FAR const char *ifname)
 
 /****************************************************************************
  * Name: do_capture
+ *
+ * Description:
+ *   Read packets into the ring, while a separate thread writes the ring to
+ *   the capture files.
+ *
  ****************************************************************************/
 
-static void do_capture(FAR const struct tcpdump_cfgs_s *cfgs)
+static void do_capture(FAR struct tcpdump_cfgs_s *cfgs)
 {
-  ssize_t len;
-  uint8_t buf[MAX_NETDEV_PKTSIZE];
+  FAR struct tcpdump_ring_s *ring = &cfgs->ring;
+  FAR uint8_t *buf;
+  uint64_t filebytes;
+  pthread_t writer;
   struct timespec ts;
+  uint32_t caplen;
+  ssize_t len;
+  int ret;
+
+  /* Packets are read behind room for their record header */
+
+  buf = malloc(sizeof(struct pcap_pkthdr_s) + MAX_NETDEV_PKTSIZE);
+  ring->data = malloc(CONFIG_SYSTEM_TCPDUMP_RINGSIZE);
+  if (buf == NULL || ring->data == NULL)
+    {
+      printf("ERROR: Failed to allocate the capture buffers\n");
+      goto errout;
+    }
+
+  pthread_mutex_init(&ring->lock, NULL);
+  pthread_cond_init(&ring->cond, NULL);
+  ring->produced = 0;
+  ring->consumed = 0;
+  ring->nrotate  = 0;
+  ring->done     = false;
 
   /* Write file header */
 
-  if (write_filehdr(cfgs->fd, cfgs->snaplen, cfgs->linktype) < 0)
+  put_filehdr(cfgs);
+  filebytes = sizeof(struct pcap_filehdr_s);
+
+  ret = pthread_create(&writer, NULL, writer_thread, cfgs);
+  if (ret != 0)
     {
-      return;
+      printf("ERROR: pthread_create() failed: %d\n", ret);
+      goto errout_with_sync;
     }
 
   /* Dump packets */
 
-  while ((len = read(cfgs->sd, buf, sizeof(buf))) >= 0 && !g_exiting)
+  while ((len = read(cfgs->sd, buf + sizeof(struct pcap_pkthdr_s),
+                     MAX_NETDEV_PKTSIZE)) >= 0 && !g_exiting)
     {
       if (len == 0)
         {
           continue;
         }
 
-      if (clock_gettime(CLOCK_REALTIME, &ts) < 0)
+      /* Filter before anything else is done with the packet */
+
+      caplen = cfgs->snaplen;
+#ifdef CONFIG_SYSTEM_TCPDUMP_FILTER
+      if (cfgs->filter.ninsns > 0)
         {
-          perror("ERROR: clock_gettime() failed");
-          return;
+          caplen = tcpdump_filter_run(&cfgs->filter,
+                                      buf + sizeof(struct pcap_pkthdr_s),
+                                      len);
+          if (caplen == 0)
+            {
+              continue;
+            }
         }
+#endif
 
-      if (write_packet(cfgs->fd, cfgs->snaplen, len, buf, &ts) < 0)
+      if (clock_gettime(CLOCK_REALTIME, &ts) < 0)
         {
-          return;
+          perror("ERROR: clock_gettime() failed");
+          break;
         }
+
+      put_packet(cfgs, &filebytes, buf, len, caplen, &ts);
     }
 
   if (!g_exiting)
     {
       perror("ERROR: read() failed");
     }
+
+  /* Let the writer write out what is left */
+
+  pthread_mutex_lock(&ring->lock);
+  ring->done = true;
+  pthread_cond_signal(&ring->cond);
+  pthread_mutex_unlock(&ring->lock);
+
+  pthread_join(writer, NULL);
+
+  printf("%lu packets captured\n", cfgs->captured);
+  printf("%lu packets dropped\n", cfgs->dropped);
+
+errout_with_sync:
+  pthread_cond_destroy(&ring->cond);
+  pthread_mutex_destroy(&ring->lock);
+
+errout:
+  free(ring->data);
+  free(buf);
 }
 
 /****************************************************************************
@@ -285,6 +630,7 @@ int main(int argc, FAR char *argv[])
 {
   int ifindex;
   int nerrors;
+  char filename[PATH_MAX];
   struct tcpdump_cfgs_s cfgs;
   struct tcpdump_args_s args;
 
@@ -295,7 +641,16 @@ int main(int argc, FAR char *argv[])
   args.file      = arg_str1("w", NULL, "file", "Path to dump file");
   args.snaplen   = arg_int0("s", "snapshot-length", "snaplen",
                             "Max dump length of each packet");
-  args.end       = arg_end(3);
+  args.filesize  = arg_int0("C", NULL, "file_size",
+                            "Start a new file after file_size MB");
+  args.filecount = arg_int0("W", NULL, "filecount",
+                            "With -C, reuse filecount files in turn");
+#ifdef CONFIG_SYSTEM_TCPDUMP_FILTER
+  args.expr      = arg_strn(NULL, NULL, "expression", 0, MAX_FILTER_ARGS,
+                            "Capture only matching packets, e.g. "
+                            "'udp port 53 or host 10.0.0.1'");
+#endif
+  args.end       = arg_end(6);
 
   nerrors = arg_parse(argc, argv, (FAR void**)&args);
   if (nerrors != 0)
@@ -313,7 +668,22 @@ int main(int argc, FAR char *argv[])
       goto out;
     }
 
-  cfgs.fd = open(args.file->sval[0], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  memset(&cfgs, 0, sizeof(cfgs));
+  cfgs.file = args.file->sval[0];
+
+  if (args.filesize->count > 0 && *args.filesize->ival > 0)
+    {
+      cfgs.filesize = (uint64_t)*args.filesize->ival * 1000000;
+    }
+
+  if (cfgs.filesize > 0 && args.filecount->count > 0 &&
+      *args.filecount->ival > 0)
+    {
+      cfgs.filecount = *args.filecount->ival;
+    }
+
+  get_filename(&cfgs, 0, filename, sizeof(filename));
+  cfgs.fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
   if (cfgs.fd < 0)
     {
       perror("ERROR: open() failed");
@@ -338,10 +708,40 @@ int main(int argc, FAR char *argv[])
 
   cfgs.linktype = get_linktype(args.interface->sval[0]);
 
+#ifdef CONFIG_SYSTEM_TCPDUMP_FILTER
+  if (args.expr->count > 0)
+    {
+      char expr[256];
+      int i;
+
+      expr[0] = '\0';
+      for (i = 0; i < args.expr->count; i++)
+        {
+          if (i > 0)
+            {
+              strlcat(expr, " ", sizeof(expr));
+            }
+
+          strlcat(expr, args.expr->sval[i], sizeof(expr));
+        }
+
+      if (tcpdump_filter_compile(&cfgs.filter, expr, cfgs.linktype,
+                                 cfgs.snaplen) < 0)
+        {
+          close(cfgs.sd);
+          close(cfgs.fd);
+          goto out;
+        }
+    }
+#endif
+
   do_capture(&cfgs);
 
   close(cfgs.sd);
-  close(cfgs.fd);
+  if (cfgs.fd >= 0)
+    {
+      close(cfgs.fd);
+    }
 
 out:
   arg_freetable((FAR void **)&args, 1);
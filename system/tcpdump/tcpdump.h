@@ -0,0 +1,107 @@
+/****************************************************************************
+ * apps/system/tcpdump/tcpdump.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_SYSTEM_TCPDUMP_TCPDUMP_H
+#define __APPS_SYSTEM_TCPDUMP_TCPDUMP_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* https://www.tcpdump.org/linktypes.html */
+
+#define LINKTYPE_ETHERNET 1   /* IEEE 802.3 Ethernet */
+#define LINKTYPE_RAW      101 /* Raw IP */
+
+#ifndef CONFIG_SYSTEM_TCPDUMP_FILTER_MAXINSNS
+#  define CONFIG_SYSTEM_TCPDUMP_FILTER_MAXINSNS 128
+#endif
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* A filter instruction.  Layout and encoding are those of classic BPF
+ * (struct sock_filter), restricted to what the filter compiler emits.
+ */
+
+struct tcpdump_insn_s
+{
+  uint16_t code;
+  uint8_t  jt;    /* Instructions to skip if the condition is true */
+  uint8_t  jf;    /* Instructions to skip if it is false */
+  uint32_t k;
+};
+
+struct tcpdump_filter_s
+{
+  int ninsns;     /* 0: no filter, capture everything */
+  struct tcpdump_insn_s insns[CONFIG_SYSTEM_TCPDUMP_FILTER_MAXINSNS];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TCPDUMP_FILTER
+
+/****************************************************************************
+ * Name: tcpdump_filter_compile
+ *
+ * Description:
+ *   Compile a filter expression, like "udp port 53 or host 10.0.0.1",
+ *   for packets of the given link type.  Accepted packets are truncated
+ *   to snaplen bytes.
+ *
+ * Returned Value:
+ *   0 (OK) on success, or a negated errno value if the expression is not
+ *   valid or too long.  The reason has been printed.
+ *
+ ****************************************************************************/
+
+int tcpdump_filter_compile(FAR struct tcpdump_filter_s *filter,
+                           FAR const char *expr, uint32_t linktype,
+                           uint32_t snaplen);
+
+/****************************************************************************
+ * Name: tcpdump_filter_run
+ *
+ * Description:
+ *   Run a compiled filter on a packet.
+ *
+ * Returned Value:
+ *   The number of bytes of the packet to capture, 0 to drop it.
+ *
+ ****************************************************************************/
+
+uint32_t tcpdump_filter_run(FAR const struct tcpdump_filter_s *filter,
+                            FAR const uint8_t *pkt, uint32_t len);
+
+#endif /* CONFIG_SYSTEM_TCPDUMP_FILTER */
+
+#endif /* __APPS_SYSTEM_TCPDUMP_TCPDUMP_H */
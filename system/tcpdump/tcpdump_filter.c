@@ -0,0 +1,855 @@
+/****************************************************************************
+ * apps/system/tcpdump/tcpdump_filter.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tcpdump.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Instruction codes, as in classic BPF */
+
+#define FILTER_LD_W_ABS   0x20  /* A = word at k */
+#define FILTER_LD_H_ABS   0x28  /* A = half word at k */
+#define FILTER_LD_B_ABS   0x30  /* A = byte at k */
+#define FILTER_LD_H_IND   0x48  /* A = half word at x + k */
+#define FILTER_LDX_B_MSH  0xb1  /* X = 4 * (byte at k & 0xf) */
+#define FILTER_AND_K      0x54  /* A &= k */
+#define FILTER_JEQ_K      0x15  /* Jump on A == k */
+#define FILTER_JSET_K     0x45  /* Jump on (A & k) != 0 */
+#define FILTER_RET_K      0x06  /* Return k */
+
+#define ETHERTYPE_IP      0x0800
+#define ETHERTYPE_ARP     0x0806
+#define ETHERTYPE_IPV6    0x86dd
+
+#define IPPROTO_ICMP_     1
+#define IPPROTO_TCP_      6
+#define IPPROTO_UDP_      17
+#define IPPROTO_ICMPV6_   58
+
+#define DIR_ANY           0
+#define DIR_SRC           1
+#define DIR_DST           2
+
+#define TOKEN_SIZE        40
+#define NO_JUMP           (-1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* A compiled piece of the expression.  Its code starts at 'start' and
+ * ends in jumps that are taken when it is true or false.  Those jumps are
+ * not resolved yet: they are kept in lists, linked through 'chain' of the
+ * compiler, of jump numbers (2 * instruction + 0 for jt, 1 for jf).
+ */
+
+struct filter_frag_s
+{
+  int start;
+  int tlist;
+  int flist;
+};
+
+struct filter_comp_s
+{
+  FAR struct tcpdump_filter_s *filter;
+  FAR const char *next;                  /* Rest of the expression */
+  char token[TOKEN_SIZE];                /* Current token, "" at the end */
+  uint32_t nloff;                        /* Offset of the IP header */
+  bool raw;                              /* No link layer header */
+  int error;
+  int16_t chain[2 * CONFIG_SYSTEM_TCPDUMP_FILTER_MAXINSNS];
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static struct filter_frag_s filter_expr(FAR struct filter_comp_s *c);
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: filter_next
+ *
+ * Description:
+ *   Read the next token: a word, "(", ")", "!", "&&" or "||".
+ *
+ ****************************************************************************/
+
+static void filter_next(FAR struct filter_comp_s *c)
+{
+  FAR const char *cp = c->next;
+  size_t len;
+
+  while (*cp == ' ' || *cp == '\t')
+    {
+      cp++;
+    }
+
+  if (*cp == '(' || *cp == ')' || *cp == '!')
+    {
+      len = 1;
+    }
+  else if ((cp[0] == '&' && cp[1] == '&') || (cp[0] == '|' && cp[1] == '|'))
+    {
+      len = 2;
+    }
+  else
+    {
+      len = strcspn(cp, " \t()!&|");
+      if (len == 0 && *cp != '\0')
+        {
+          len = 1;
+        }
+    }
+
+  if (len >= TOKEN_SIZE)
+    {
+      len = TOKEN_SIZE - 1;
+    }
+
+  memcpy(c->token, cp, len);
+  c->token[len] = '\0';
+  c->next = cp + len;
+}
+
+/****************************************************************************
+ * Name: filter_is
+ ****************************************************************************/
+
+static bool filter_is(FAR struct filter_comp_s *c, FAR const char *word)
+{
+  return strcmp(c->token, word) == 0;
+}
+
+/****************************************************************************
+ * Name: filter_syntax
+ ****************************************************************************/
+
+static void filter_syntax(FAR struct filter_comp_s *c)
+{
+  if (c->error == 0)
+    {
+      if (c->token[0] == '\0')
+        {
+          printf("ERROR: Filter expression ends unexpectedly\n");
+        }
+      else
+        {
+          printf("ERROR: Syntax error in filter near '%s'\n", c->token);
+        }
+
+      c->error = -EINVAL;
+    }
+}
+
+/****************************************************************************
+ * Name: filter_emit
+ ****************************************************************************/
+
+static int filter_emit(FAR struct filter_comp_s *c, uint16_t code,
+                       uint32_t k)
+{
+  FAR struct tcpdump_filter_s *filter = c->filter;
+  FAR struct tcpdump_insn_s *insn;
+
+  if (filter->ninsns >= CONFIG_SYSTEM_TCPDUMP_FILTER_MAXINSNS)
+    {
+      if (c->error == 0)
+        {
+          printf("ERROR: Filter expression is too long\n");
+          c->error = -E2BIG;
+        }
+
+      return 0;
+    }
+
+  insn       = &filter->insns[filter->ninsns];
+  insn->code = code;
+  insn->jt   = 0;
+  insn->jf   = 0;
+  insn->k    = k;
+
+  c->chain[2 * filter->ninsns]     = NO_JUMP;
+  c->chain[2 * filter->ninsns + 1] = NO_JUMP;
+
+  return filter->ninsns++;
+}
+
+/****************************************************************************
+ * Name: filter_merge
+ *
+ * Description:
+ *   Concatenate two lists of jumps.
+ *
+ ****************************************************************************/
+
+static int filter_merge(FAR struct filter_comp_s *c, int a, int b)
+{
+  int last;
+
+  if (c->error != 0 || a == NO_JUMP)
+    {
+      return b;
+    }
+
+  for (last = a; c->chain[last] != NO_JUMP; last = c->chain[last]);
+  c->chain[last] = b;
+  return a;
+}
+
+/****************************************************************************
+ * Name: filter_patch
+ *
+ * Description:
+ *   Point all jumps of a list to an instruction.
+ *
+ ****************************************************************************/
+
+static void filter_patch(FAR struct filter_comp_s *c, int list, int target)
+{
+  FAR struct tcpdump_insn_s *insn;
+  int offset;
+
+  for (; c->error == 0 && list != NO_JUMP; list = c->chain[list])
+    {
+      insn   = &c->filter->insns[list / 2];
+      offset = target - list / 2 - 1;
+      if (offset > UINT8_MAX)
+        {
+          printf("ERROR: Filter expression is too long\n");
+          c->error = -E2BIG;
+          return;
+        }
+
+      if (list % 2 == 0)
+        {
+          insn->jt = offset;
+        }
+      else
+        {
+          insn->jf = offset;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: filter_jump
+ *
+ * Description:
+ *   Emit a conditional jump, the end of every test.
+ *
+ ****************************************************************************/
+
+static struct filter_frag_s filter_jump(FAR struct filter_comp_s *c,
+                                        int start, uint16_t code,
+                                        uint32_t k)
+{
+  struct filter_frag_s frag;
+  int pc = filter_emit(c, code, k);
+
+  frag.start = start < 0 ? pc : start;
+  frag.tlist = 2 * pc;
+  frag.flist = 2 * pc + 1;
+  return frag;
+}
+
+/****************************************************************************
+ * Name: filter_cmp
+ *
+ * Description:
+ *   Test whether the field at an offset, masked if mask is not 0, equals
+ *   a value.
+ *
+ ****************************************************************************/
+
+static struct filter_frag_s filter_cmp(FAR struct filter_comp_s *c,
+                                       uint16_t ldcode, uint32_t offset,
+                                       uint32_t mask, uint32_t value)
+{
+  int start = filter_emit(c, ldcode, offset);
+
+  if (mask != 0)
+    {
+      filter_emit(c, FILTER_AND_K, mask);
+    }
+
+  return filter_jump(c, start, FILTER_JEQ_K, value);
+}
+
+/****************************************************************************
+ * Name: filter_not
+ ****************************************************************************/
+
+static struct filter_frag_s filter_not(struct filter_frag_s a)
+{
+  int list = a.tlist;
+
+  a.tlist = a.flist;
+  a.flist = list;
+  return a;
+}
+
+/****************************************************************************
+ * Name: filter_and
+ *
+ * Description:
+ *   Combine two fragments, b emitted right after a.
+ *
+ ****************************************************************************/
+
+static struct filter_frag_s filter_and(FAR struct filter_comp_s *c,
+                                       struct filter_frag_s a,
+                                       struct filter_frag_s b)
+{
+  filter_patch(c, a.tlist, b.start);
+  a.tlist = b.tlist;
+  a.flist = filter_merge(c, a.flist, b.flist);
+  return a;
+}
+
+/****************************************************************************
+ * Name: filter_or
+ ****************************************************************************/
+
+static struct filter_frag_s filter_or(FAR struct filter_comp_s *c,
+                                      struct filter_frag_s a,
+                                      struct filter_frag_s b)
+{
+  filter_patch(c, a.flist, b.start);
+  a.flist = b.flist;
+  a.tlist = filter_merge(c, a.tlist, b.tlist);
+  return a;
+}
+
+/****************************************************************************
+ * Name: filter_ethertype
+ ****************************************************************************/
+
+static struct filter_frag_s filter_ethertype(FAR struct filter_comp_s *c,
+                                             uint16_t type)
+{
+  if (!c->raw)
+    {
+      return filter_cmp(c, FILTER_LD_H_ABS, 12, 0, type);
+    }
+
+  /* Raw IP: tell IPv4 from IPv6 by the version field */
+
+  switch (type)
+    {
+      case ETHERTYPE_IP:
+        return filter_cmp(c, FILTER_LD_B_ABS, 0, 0xf0, 0x40);
+
+      case ETHERTYPE_IPV6:
+        return filter_cmp(c, FILTER_LD_B_ABS, 0, 0xf0, 0x60);
+
+      default:
+
+        /* Never true: A is 0 */
+
+        return filter_jump(c, -1, FILTER_JSET_K, 0);
+    }
+}
+
+/****************************************************************************
+ * Name: filter_ipproto
+ *
+ * Description:
+ *   Test the protocol of IPv4 (ipv6 false) or IPv6 packets.  proto 0
+ *   stands for TCP or UDP.  Extension headers of IPv6 are not followed.
+ *
+ ****************************************************************************/
+
+static struct filter_frag_s filter_ipproto(FAR struct filter_comp_s *c,
+                                           bool ipv6, uint8_t proto)
+{
+  struct filter_frag_s a;
+  struct filter_frag_s b;
+  uint32_t offset = c->nloff + (ipv6 ? 6 : 9);
+
+  a = filter_ethertype(c, ipv6 ? ETHERTYPE_IPV6 : ETHERTYPE_IP);
+  if (proto != 0)
+    {
+      b = filter_cmp(c, FILTER_LD_B_ABS, offset, 0, proto);
+      return filter_and(c, a, b);
+    }
+
+  b = filter_cmp(c, FILTER_LD_B_ABS, offset, 0, IPPROTO_TCP_);
+  b = filter_or(c, b, filter_jump(c, -1, FILTER_JEQ_K, IPPROTO_UDP_));
+  return filter_and(c, a, b);
+}
+
+/****************************************************************************
+ * Name: filter_anyproto
+ ****************************************************************************/
+
+static struct filter_frag_s filter_anyproto(FAR struct filter_comp_s *c,
+                                            uint8_t proto)
+{
+  struct filter_frag_s a = filter_ipproto(c, false, proto);
+
+  return filter_or(c, a, filter_ipproto(c, true, proto));
+}
+
+/****************************************************************************
+ * Name: filter_field
+ *
+ * Description:
+ *   Test whether a field equals a value.  Indirect loads are relative to
+ *   the IPv4 header length, which is loaded into X first.
+ *
+ ****************************************************************************/
+
+static struct filter_frag_s filter_field(FAR struct filter_comp_s *c,
+                                         uint16_t ldcode, uint32_t offset,
+                                         uint32_t value)
+{
+  int start = -1;
+  int ld;
+
+  if (ldcode == FILTER_LD_H_IND)
+    {
+      start = filter_emit(c, FILTER_LDX_B_MSH, c->nloff);
+    }
+
+  ld = filter_emit(c, ldcode, offset);
+  return filter_jump(c, start < 0 ? ld : start, FILTER_JEQ_K, value);
+}
+
+/****************************************************************************
+ * Name: filter_dir
+ *
+ * Description:
+ *   Compare the source field (at offset) and/or the destination field (at
+ *   offset + dstoff) with a value.
+ *
+ ****************************************************************************/
+
+static struct filter_frag_s filter_dir(FAR struct filter_comp_s *c,
+                                       int dir, uint16_t ldcode,
+                                       uint32_t offset, uint32_t dstoff,
+                                       uint32_t value)
+{
+  struct filter_frag_s a;
+
+  if (dir == DIR_DST)
+    {
+      return filter_field(c, ldcode, offset + dstoff, value);
+    }
+
+  a = filter_field(c, ldcode, offset, value);
+  if (dir == DIR_SRC)
+    {
+      return a;
+    }
+
+  return filter_or(c, a, filter_field(c, ldcode, offset + dstoff, value));
+}
+
+/****************************************************************************
+ * Name: filter_host
+ ****************************************************************************/
+
+static struct filter_frag_s filter_host(FAR struct filter_comp_s *c,
+                                        int dir)
+{
+  struct filter_frag_s a;
+  struct in_addr addr;
+
+  if (inet_pton(AF_INET, c->token, &addr) != 1)
+    {
+      if (c->error == 0)
+        {
+          printf("ERROR: Bad IPv4 address '%s' in filter\n", c->token);
+          c->error = -EINVAL;
+        }
+
+      return filter_jump(c, -1, FILTER_JSET_K, 0);
+    }
+
+  filter_next(c);
+
+  a = filter_ethertype(c, ETHERTYPE_IP);
+  return filter_and(c, a, filter_dir(c, dir, FILTER_LD_W_ABS,
+                                     c->nloff + 12, 4, ntohl(addr.s_addr)));
+}
+
+/****************************************************************************
+ * Name: filter_port
+ ****************************************************************************/
+
+static struct filter_frag_s filter_port(FAR struct filter_comp_s *c,
+                                        uint8_t proto, int dir)
+{
+  struct filter_frag_s a;
+  struct filter_frag_s b;
+  FAR char *end;
+  unsigned long port;
+
+  port = strtoul(c->token, &end, 10);
+  if (c->token[0] == '\0' || *end != '\0' || port > UINT16_MAX)
+    {
+      if (c->error == 0)
+        {
+          printf("ERROR: Bad port '%s' in filter\n", c->token);
+          c->error = -EINVAL;
+        }
+
+      return filter_jump(c, -1, FILTER_JSET_K, 0);
+    }
+
+  filter_next(c);
+
+  /* IPv4: not a fragment other than the first, ports behind the header */
+
+  a = filter_ipproto(c, false, proto);
+  b = filter_jump(c, filter_emit(c, FILTER_LD_H_ABS, c->nloff + 6),
+                  FILTER_JSET_K, 0x1fff);
+  a = filter_and(c, a, filter_not(b));
+  a = filter_and(c, a, filter_dir(c, dir, FILTER_LD_H_IND, c->nloff, 2,
+                                  port));
+
+  /* IPv6 */
+
+  b = filter_ipproto(c, true, proto);
+  b = filter_and(c, b, filter_dir(c, dir, FILTER_LD_H_ABS, c->nloff + 40,
+                                  2, port));
+
+  return filter_or(c, a, b);
+}
+
+/****************************************************************************
+ * Name: filter_primitive
+ *
+ * Description:
+ *   primitive := ip | ip6 | arp | icmp | icmp6
+ *              | [tcp | udp] [src | dst] port NUMBER
+ *              | tcp | udp
+ *              | [src | dst] host ADDRESS
+ *
+ ****************************************************************************/
+
+static struct filter_frag_s filter_primitive(FAR struct filter_comp_s *c)
+{
+  uint8_t proto = 0;
+  int dir = DIR_ANY;
+
+  if (filter_is(c, "ip") || filter_is(c, "ip6") || filter_is(c, "arp"))
+    {
+      uint16_t type = filter_is(c, "ip") ? ETHERTYPE_IP :
+                      filter_is(c, "ip6") ? ETHERTYPE_IPV6 : ETHERTYPE_ARP;
+
+      filter_next(c);
+      return filter_ethertype(c, type);
+    }
+
+  if (filter_is(c, "icmp") || filter_is(c, "icmp6"))
+    {
+      bool ipv6 = filter_is(c, "icmp6");
+
+      filter_next(c);
+      return filter_ipproto(c, ipv6, ipv6 ? IPPROTO_ICMPV6_ :
+                                            IPPROTO_ICMP_);
+    }
+
+  if (filter_is(c, "tcp") || filter_is(c, "udp"))
+    {
+      proto = filter_is(c, "tcp") ? IPPROTO_TCP_ : IPPROTO_UDP_;
+      filter_next(c);
+      if (!filter_is(c, "src") && !filter_is(c, "dst") &&
+          !filter_is(c, "port"))
+        {
+          return filter_anyproto(c, proto);
+        }
+    }
+
+  if (filter_is(c, "src") || filter_is(c, "dst"))
+    {
+      dir = filter_is(c, "src") ? DIR_SRC : DIR_DST;
+      filter_next(c);
+    }
+
+  if (filter_is(c, "port"))
+    {
+      filter_next(c);
+      return filter_port(c, proto, dir);
+    }
+
+  if (filter_is(c, "host") && proto == 0)
+    {
+      filter_next(c);
+      return filter_host(c, dir);
+    }
+
+  filter_syntax(c);
+  return filter_jump(c, -1, FILTER_JSET_K, 0);
+}
+
+/****************************************************************************
+ * Name: filter_factor
+ *
+ * Description:
+ *   factor := (not | !) factor | '(' expr ')' | primitive
+ *
+ ****************************************************************************/
+
+static struct filter_frag_s filter_factor(FAR struct filter_comp_s *c)
+{
+  struct filter_frag_s a;
+
+  if (filter_is(c, "not") || filter_is(c, "!"))
+    {
+      filter_next(c);
+      return filter_not(filter_factor(c));
+    }
+
+  if (filter_is(c, "("))
+    {
+      filter_next(c);
+      a = filter_expr(c);
+      if (!filter_is(c, ")"))
+        {
+          filter_syntax(c);
+        }
+
+      filter_next(c);
+      return a;
+    }
+
+  return filter_primitive(c);
+}
+
+/****************************************************************************
+ * Name: filter_term
+ *
+ * Description:
+ *   term := factor { (and | &&) factor }
+ *
+ ****************************************************************************/
+
+static struct filter_frag_s filter_term(FAR struct filter_comp_s *c)
+{
+  struct filter_frag_s a = filter_factor(c);
+
+  while (c->error == 0 && (filter_is(c, "and") || filter_is(c, "&&")))
+    {
+      filter_next(c);
+      a = filter_and(c, a, filter_factor(c));
+    }
+
+  return a;
+}
+
+/****************************************************************************
+ * Name: filter_expr
+ *
+ * Description:
+ *   expr := term { (or | ||) term }
+ *
+ ****************************************************************************/
+
+static struct filter_frag_s filter_expr(FAR struct filter_comp_s *c)
+{
+  struct filter_frag_s a = filter_term(c);
+
+  while (c->error == 0 && (filter_is(c, "or") || filter_is(c, "||")))
+    {
+      filter_next(c);
+      a = filter_or(c, a, filter_term(c));
+    }
+
+  return a;
+}
+
+/****************************************************************************
+ * Name: filter_load
+ *
+ * Description:
+ *   Load a big-endian field of 'size' bytes.  Returns false if it is
+ *   beyond the end of the packet.
+ *
+ ****************************************************************************/
+
+static bool filter_load(FAR const uint8_t *pkt, uint32_t len, uint32_t k,
+                        uint32_t size, FAR uint32_t *value)
+{
+  uint32_t v = 0;
+  uint32_t i;
+
+  if (k >= len || len - k < size)
+    {
+      return false;
+    }
+
+  for (i = 0; i < size; i++)
+    {
+      v = (v << 8) | pkt[k + i];
+    }
+
+  *value = v;
+  return true;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcpdump_filter_compile
+ ****************************************************************************/
+
+int tcpdump_filter_compile(FAR struct tcpdump_filter_s *filter,
+                           FAR const char *expr, uint32_t linktype,
+                           uint32_t snaplen)
+{
+  FAR struct filter_comp_s *c;
+  struct filter_frag_s a;
+  int ret;
+
+  /* The jump lists are too large for the stack */
+
+  c = calloc(1, sizeof(*c));
+  if (c == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  filter->ninsns = 0;
+  c->filter = filter;
+  c->next   = expr;
+  c->raw    = linktype != LINKTYPE_ETHERNET;
+  c->nloff  = c->raw ? 0 : 14;
+
+  filter_next(c);
+  a = filter_expr(c);
+  if (c->token[0] != '\0')
+    {
+      filter_syntax(c);
+    }
+
+  /* Accepted packets return the number of bytes to capture */
+
+  filter_patch(c, a.tlist, filter_emit(c, FILTER_RET_K, snaplen));
+  filter_patch(c, a.flist, filter_emit(c, FILTER_RET_K, 0));
+
+  ret = c->error;
+  if (ret < 0)
+    {
+      filter->ninsns = 0;
+    }
+
+  free(c);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: tcpdump_filter_run
+ ****************************************************************************/
+
+uint32_t tcpdump_filter_run(FAR const struct tcpdump_filter_s *filter,
+                            FAR const uint8_t *pkt, uint32_t len)
+{
+  FAR const struct tcpdump_insn_s *pc = filter->insns;
+  uint32_t a = 0;
+  uint32_t x = 0;
+
+  /* The compiler only emits forward jumps and ends the program with
+   * returns, so there is no need to check pc.
+   */
+
+  for (; ; pc++)
+    {
+      switch (pc->code)
+        {
+          case FILTER_LD_W_ABS:
+            if (!filter_load(pkt, len, pc->k, 4, &a))
+              {
+                return 0;
+              }
+            break;
+
+          case FILTER_LD_H_ABS:
+            if (!filter_load(pkt, len, pc->k, 2, &a))
+              {
+                return 0;
+              }
+            break;
+
+          case FILTER_LD_B_ABS:
+            if (!filter_load(pkt, len, pc->k, 1, &a))
+              {
+                return 0;
+              }
+            break;
+
+          case FILTER_LD_H_IND:
+            if (!filter_load(pkt, len, x + pc->k, 2, &a))
+              {
+                return 0;
+              }
+            break;
+
+          case FILTER_LDX_B_MSH:
+            if (!filter_load(pkt, len, pc->k, 1, &x))
+              {
+                return 0;
+              }
+
+            x = (x & 0xf) << 2;
+            break;
+
+          case FILTER_AND_K:
+            a &= pc->k;
+            break;
+
+          case FILTER_JEQ_K:
+            pc += a == pc->k ? pc->jt : pc->jf;
+            break;
+
+          case FILTER_JSET_K:
+            pc += (a & pc->k) != 0 ? pc->jt : pc->jf;
+            break;
+
+          case FILTER_RET_K:
+          default:
+            return pc->code == FILTER_RET_K ? pc->k : 0;
+        }
+    }
+}
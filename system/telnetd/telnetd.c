@@ -58,6 +58,9 @@ int main(int argc, FAR char *argv[])
 #ifndef CONFIG_BUILD_KERNEL
     nsh_telnetmain,
 #endif
+#ifdef CONFIG_NETUTILS_TELNETD_POOL
+    nsh_telnetsession,
+#endif
 #ifdef CONFIG_LIBC_EXECFUNCS
     CONFIG_SYSTEM_TELNETD_PROGNAME,
 #endif
@@ -76,6 +76,16 @@ struct tcurses_vt100_s
   int    keycount;
   char   keybuf[16];
   tcflag_t lflag;
+
+  /* Cursor position, row is -1 if unknown */
+
+  int    row;
+  int    col;
+
+  /* Output collected until the screen update is complete */
+
+  size_t outlen;
+  char   outbuf[CONFIG_SYSTEM_TERMCURSES_VT100_OUTBUFSIZE];
 };
 
 /****************************************************************************
@@ -97,6 +107,9 @@ static int tcurses_vt100_getkeycode(FAR struct termcurses_s *dev,
               FAR int *specialkey, FAR int *keymodifers);
 static bool tcurses_vt100_checkkey(FAR struct termcurses_s *dev);
 static int tcurses_vt100_terminate(FAR struct termcurses_s *dev);
+static int tcurses_vt100_write(FAR struct termcurses_s *dev,
+              FAR const char *buffer, size_t len);
+static int tcurses_vt100_flush(FAR struct termcurses_s *dev);
 
 /****************************************************************************
  * Private Data
@@ -112,7 +125,9 @@ static const struct termcurses_ops_s g_vt100_ops =
   tcurses_vt100_setattributes,
   tcurses_vt100_getkeycode,
   tcurses_vt100_checkkey,
-  tcurses_vt100_terminate
+  tcurses_vt100_terminate,
+  tcurses_vt100_write,
+  tcurses_vt100_flush
 };
 
 /* VT100 terminal codes */
@@ -122,9 +137,11 @@ static const char *g_clreos         = "\033[J";       /* Clear to end of screen
 static const char *g_clreol         = "\033[K";       /* Clear to end of line */
 
 static const char *g_movecurs       = "\033[%d;%dH";  /* Move cursor to x,y */
-static const char *g_getwinsize     = "\x1b[s\x1b[999;999H\x1b[6n\x1bu";
+static const char *g_movecol        = "\033[%dC";     /* Move cursor right */
+static const char *g_getwinsize     = "\x1b[s\x1b[999;999H\x1b[6n\x1b[u";
 static const char *g_setfgcolor     = "\x1b[38;5;%dm";
 static const char *g_setbgcolor     = "\x1b[48;5;%dm";
+static const char *g_setcolors      = "\x1b[38;5;%d;48;5;%dm";
 static const char *g_showcursor     = "\x1b[?25h";
 static const char *g_hidecursor     = "\x1b[?25l";
 static const char *g_setbold        = "\x1b[1";
@@ -729,6 +746,75 @@ struct termcurses_dev_s g_vt100_tcurs =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Write all of the data to the terminal
+ ****************************************************************************/
+
+static int tcurses_vt100_writeall(int fd, FAR const char *buffer,
+                                  size_t len)
+{
+  ssize_t ret;
+
+  while (len > 0)
+    {
+      ret = write(fd, buffer, len);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      buffer += ret;
+      len    -= ret;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Send the collected output to the terminal
+ ****************************************************************************/
+
+static int tcurses_vt100_flushout(FAR struct tcurses_vt100_s *priv)
+{
+  size_t len = priv->outlen;
+
+  priv->outlen = 0;
+  return tcurses_vt100_writeall(priv->out_fd, priv->outbuf, len);
+}
+
+/****************************************************************************
+ * Add data to the output buffer, sending the buffer when it is full
+ ****************************************************************************/
+
+static int tcurses_vt100_output(FAR struct tcurses_vt100_s *priv,
+                                FAR const char *buffer, size_t len)
+{
+  int ret;
+
+  if (priv->outlen + len > sizeof(priv->outbuf))
+    {
+      ret = tcurses_vt100_flushout(priv);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      if (len > sizeof(priv->outbuf))
+        {
+          return tcurses_vt100_writeall(priv->out_fd, buffer, len);
+        }
+    }
+
+  memcpy(&priv->outbuf[priv->outlen], buffer, len);
+  priv->outlen += len;
+  return OK;
+}
+
 /****************************************************************************
  * Clear screen / line operations
  ****************************************************************************/
@@ -737,41 +823,32 @@ static int tcurses_vt100_clear(FAR struct termcurses_s *dev, int type)
 {
   FAR struct tcurses_vt100_s *priv;
   int ret = -ENOSYS;
-  int fd;
 
   priv = (FAR struct tcurses_vt100_s *)dev;
-  fd = priv->out_fd;
 
   /* Perform operation based on type */
 
   switch (type)
     {
       case TCURS_CLEAR_SCREEN:
-        ret = write(fd, g_clrscr, strlen(g_clrscr));
+        ret = tcurses_vt100_output(priv, g_clrscr, strlen(g_clrscr));
         break;
 
       case TCURS_CLEAR_LINE:
         break;
 
       case TCURS_CLEAR_EOS:
-        ret = write(fd, g_clrscr, strlen(g_clreos));
+        ret = tcurses_vt100_output(priv, g_clreos, strlen(g_clreos));
         break;
 
       case TCURS_CLEAR_EOL:
-        ret = write(fd, g_clrscr, strlen(g_clreol));
+        ret = tcurses_vt100_output(priv, g_clreol, strlen(g_clreol));
         break;
 
       default:
         return -ENOSYS;
     }
 
-  /* If data written successfully, return OK */
-
-  if (ret > 0)
-    {
-      ret = OK;
-    }
-
   return ret;
 }
 
@@ -784,32 +861,54 @@ static int tcurses_vt100_move(FAR struct termcurses_s *dev, int type,
 {
   FAR struct tcurses_vt100_s *priv;
   int   ret = -ENOSYS;
-  int   fd;
   char  str[32];
 
   priv = (FAR struct tcurses_vt100_s *)dev;
-  fd   = priv->out_fd;
 
   /* Perform operation based on type */
 
   switch (type)
     {
       case TCURS_MOVE_YX:
-        snprintf(str, sizeof(str), g_movecurs, row + 1, col + 1);
-        ret = write(fd, str, strlen(str));
+
+        /* Use the shortest sequence from the known cursor position.  A
+         * cursor left past the last column (waiting to wrap) is never on
+         * a target column, so it always gets a full move.
+         */
+
+        if (row == priv->row && col == priv->col)
+          {
+            return OK;
+          }
+        else if (row == priv->row && col == 0)
+          {
+            strlcpy(str, "\r", sizeof(str));
+          }
+        else if (row == priv->row + 1 && col == 0 && priv->row >= 0)
+          {
+            strlcpy(str, "\r\n", sizeof(str));
+          }
+        else if (row == priv->row && col > priv->col)
+          {
+            snprintf(str, sizeof(str), g_movecol, col - priv->col);
+          }
+        else
+          {
+            snprintf(str, sizeof(str), g_movecurs, row + 1, col + 1);
+          }
+
+        ret = tcurses_vt100_output(priv, str, strlen(str));
+        if (ret == OK)
+          {
+            priv->row = row;
+            priv->col = col;
+          }
         break;
 
       default:
         return -ENOSYS;
     }
 
-  /* If bytes written, return OK */
-
-  if (ret > 0)
-    {
-      ret = OK;
-    }
-
   return ret;
 }
 
@@ -907,21 +1006,18 @@ static int tcurses_vt100_setcolors(FAR struct termcurses_s *dev,
                                    FAR struct termcurses_colors_s *colors)
 {
   FAR struct tcurses_vt100_s *priv;
-  int  ret = -ENOSYS;
-  int  fd;
+  uint8_t fg = 0;
+  uint8_t bg = 0;
   char str[48];
 
   priv = (FAR struct tcurses_vt100_s *)dev;
-  fd   = priv->out_fd;
 
   /* Test if FG color to be set */
 
   if ((colors->color_mask & TCURS_COLOR_FG) != 0)
     {
-      snprintf(str, sizeof(str), g_setfgcolor,
-               tcurses_vt100_getcolorindex(colors->fg_red, colors->fg_green,
-                                           colors->fg_blue));
-      ret = write(fd, str, strlen(str));
+      fg = tcurses_vt100_getcolorindex(colors->fg_red, colors->fg_green,
+                                       colors->fg_blue);
     }
 
   /* Test if BG color to be set */
@@ -934,20 +1030,31 @@ static int tcurses_vt100_setcolors(FAR struct termcurses_s *dev,
           colors->bg_red = 0;
         }
 
-      snprintf(str, sizeof(str), g_setbgcolor,
-               tcurses_vt100_getcolorindex(colors->bg_red, colors->bg_green,
-                                           colors->bg_blue));
-      ret = write(fd, str, strlen(str));
+      bg = tcurses_vt100_getcolorindex(colors->bg_red, colors->bg_green,
+                                       colors->bg_blue);
     }
 
-  /* If bytes written, return OK */
+  /* Set both colors with a single sequence when both change */
 
-  if (ret > 0)
+  switch (colors->color_mask & (TCURS_COLOR_FG | TCURS_COLOR_BG))
     {
-      ret = OK;
+      case TCURS_COLOR_FG:
+        snprintf(str, sizeof(str), g_setfgcolor, fg);
+        break;
+
+      case TCURS_COLOR_BG:
+        snprintf(str, sizeof(str), g_setbgcolor, bg);
+        break;
+
+      case TCURS_COLOR_FG | TCURS_COLOR_BG:
+        snprintf(str, sizeof(str), g_setcolors, fg, bg);
+        break;
+
+      default:
+        return -ENOSYS;
     }
 
-  return ret;
+  return tcurses_vt100_output(priv, str, strlen(str));
 }
 
 /****************************************************************************
@@ -976,10 +1083,18 @@ static int tcurses_vt100_getwinsize(FAR struct termcurses_s *dev,
       return OK;
     }
 
-  /* Write command to get window size */
+  /* Write command to get window size, after any pending output.  The
+   * command moves the cursor.
+   */
 
-  ret = write(fd, g_getwinsize, strlen(g_getwinsize));
-  if (ret <= 0)
+  ret = tcurses_vt100_flushout(priv);
+  if (ret == OK)
+    {
+      ret = tcurses_vt100_writeall(fd, g_getwinsize, strlen(g_getwinsize));
+    }
+
+  priv->row = -1;
+  if (ret < 0)
     {
       return ret;
     }
@@ -1055,12 +1170,9 @@ static int tcurses_vt100_setattributes(FAR struct termcurses_s *dev,
                                        unsigned long attrib)
 {
   FAR struct tcurses_vt100_s *priv;
-  int ret;
-  int fd;
   char str[48];
 
   priv = (FAR struct tcurses_vt100_s *)dev;
-  fd   = priv->out_fd;
 
   /* Test for cursor hide */
 
@@ -1068,16 +1180,14 @@ static int tcurses_vt100_setattributes(FAR struct termcurses_s *dev,
     {
       /* Send sequence to hide the cursor */
 
-      ret = write(fd, g_hidecursor, strlen(g_hidecursor));
-      return ret;
+      return tcurses_vt100_output(priv, g_hidecursor, strlen(g_hidecursor));
     }
 
   if (attrib & TCURS_ATTRIB_CURS_SHOW)
     {
       /* Send sequence to hide the cursor */
 
-      ret = write(fd, g_showcursor, strlen(g_showcursor));
-      return ret;
+      return tcurses_vt100_output(priv, g_showcursor, strlen(g_showcursor));
     }
 
   /* Build attribute string */
@@ -1111,13 +1221,7 @@ static int tcurses_vt100_setattributes(FAR struct termcurses_s *dev,
 
   strlcat(str, "m", sizeof(str));
 
-  ret = write(fd, str, strlen(str));
-
-  /* If bytes written, return OK */
-
-  ret = (ret > 0) ? OK : -ENOSYS;
-
-  return ret;
+  return tcurses_vt100_output(priv, str, strlen(str));
 }
 
 /****************************************************************************
@@ -1160,6 +1264,10 @@ static int tcurses_vt100_getkeycode(FAR struct termcurses_s *dev,
   priv = (FAR struct tcurses_vt100_s *)dev;
   fd   = priv->in_fd;
 
+  /* Complete the screen update before waiting for a key */
+
+  tcurses_vt100_flushout(priv);
+
   /* Watch stdin (fd 0) to see when it has input. */
 
   FD_ZERO(&rfds);
@@ -1429,6 +1537,10 @@ static bool tcurses_vt100_checkkey(FAR struct termcurses_s *dev)
   priv = (FAR struct tcurses_vt100_s *)dev;
   fd   = priv->in_fd;
 
+  /* Complete the screen update before the caller waits for a key */
+
+  tcurses_vt100_flushout(priv);
+
   /* Test for queued characters */
 
   if (priv->keycount > 0)
@@ -1455,6 +1567,48 @@ static bool tcurses_vt100_checkkey(FAR struct termcurses_s *dev)
   return false;
 }
 
+/****************************************************************************
+ * Queue text at the cursor position.  The cursor advances by one column for
+ * each character.  A character set selection (ESC ( x) takes no room, any
+ * other control character leaves the cursor position unknown.
+ ****************************************************************************/
+
+static int tcurses_vt100_write(FAR struct termcurses_s *dev,
+                               FAR const char *buffer, size_t len)
+{
+  FAR struct tcurses_vt100_s *priv;
+  size_t i;
+
+  priv = (FAR struct tcurses_vt100_s *)dev;
+
+  for (i = 0; i < len && priv->row >= 0; i++)
+    {
+      if (buffer[i] == '\033' && i + 2 < len && buffer[i + 1] == '(')
+        {
+          i += 2;
+        }
+      else if ((uint8_t)buffer[i] < 0x20)
+        {
+          priv->row = -1;
+        }
+      else
+        {
+          priv->col++;
+        }
+    }
+
+  return tcurses_vt100_output(priv, buffer, len);
+}
+
+/****************************************************************************
+ * Send the queued output
+ ****************************************************************************/
+
+static int tcurses_vt100_flush(FAR struct termcurses_s *dev)
+{
+  return tcurses_vt100_flushout((FAR struct tcurses_vt100_s *)dev);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -1491,6 +1645,7 @@ FAR struct termcurses_s *tcurses_vt100_initialize(int in_fd, int out_fd)
   priv->in_fd    = in_fd;
   priv->out_fd   = out_fd;
   priv->keycount = 0;
+  priv->row      = -1;
 
       if (isatty(priv->in_fd))
         {
@@ -1533,16 +1688,15 @@ static int tcurses_vt100_terminate(FAR struct termcurses_s *dev)
 {
   FAR struct tcurses_vt100_s *priv;
   struct termios cfg;
-  int  fd;
 
   priv = (FAR struct tcurses_vt100_s *)dev;
-  fd   = priv->out_fd;
 
-  /* Set default foreground and background colors.
-   * (Ignore the return result.)
+  /* Set default foreground and background colors and send all of the
+   * pending output.  (Ignore the return result.)
    */
 
-  write(fd, g_setdefcolors, strlen(g_setdefcolors));
+  tcurses_vt100_output(priv, g_setdefcolors, strlen(g_setdefcolors));
+  tcurses_vt100_flushout(priv);
 
       if (isatty(priv->in_fd))
         {
@@ -279,3 +279,48 @@ bool termcurses_checkkey(FAR struct termcurses_s *term)
 
   return 0;
 }
+
+/****************************************************************************
+ * Name: termcurses_write
+ *
+ * Description:
+ *   Queue text to be displayed at the cursor position.
+ *
+ ****************************************************************************/
+
+int termcurses_write(FAR struct termcurses_s *term, FAR const char *buffer,
+                     size_t len)
+{
+  FAR struct termcurses_dev_s *dev = (FAR struct termcurses_dev_s *)term;
+
+  /* Call the dev function */
+
+  if (dev->ops->write)
+    {
+      return dev->ops->write(term, buffer, len);
+    }
+
+  return -ENOSYS;
+}
+
+/****************************************************************************
+ * Name: termcurses_flush
+ *
+ * Description:
+ *   Send all of the queued output to the terminal.
+ *
+ ****************************************************************************/
+
+int termcurses_flush(FAR struct termcurses_s *term)
+{
+  FAR struct termcurses_dev_s *dev = (FAR struct termcurses_dev_s *)term;
+
+  /* Call the dev function */
+
+  if (dev->ops->flush)
+    {
+      return dev->ops->flush(term);
+    }
+
+  return OK;
+}
@@ -218,6 +218,78 @@ static int trace_cmd_dump(int index, int argc, FAR char **argv,
 }
 #endif
 
+/****************************************************************************
+ * Name: trace_cmd_stream
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+static int trace_cmd_stream(int index, int argc, FAR char **argv,
+                            int notectlfd)
+{
+  FAR const char *dest;
+  FAR char *endptr;
+  int duration = 0;
+  bool changed;
+  bool cont = false;
+  int ret;
+
+  /* Usage: trace stream [-c] <dest> [<duration>] */
+
+  if (index < argc)
+    {
+      if (strcmp(argv[index], "-c") == 0)
+        {
+          cont = true;
+          index++;
+        }
+    }
+
+  if (index >= argc)
+    {
+      /* <dest> parameter is mandatory. */
+
+      fprintf(stderr,
+              "trace stream: no destination\n");
+      return ERROR;
+    }
+
+  dest = argv[index++];
+
+  if (index < argc)
+    {
+      duration = strtoul(argv[index], &endptr, 0);
+      if (!duration || endptr == argv[index] || *endptr != '\0')
+        {
+          fprintf(stderr,
+                  "trace stream: invalid argument '%s'\n", argv[index]);
+          return ERROR;
+        }
+
+      index++;
+    }
+
+  /* Clear the trace buffer, the stream starts now */
+
+  if (!cont)
+    {
+      trace_dump_clear();
+    }
+
+  /* Stream with tracing */
+
+  changed = notectl_enable(true, notectlfd);
+
+  ret = trace_stream(dest, duration);
+
+  if (changed)
+    {
+      notectl_enable(false, notectlfd);
+    }
+
+  return ret < 0 ? ERROR : index;
+}
+#endif
+
 /****************************************************************************
  * Name: trace_cmd_cmd
  ****************************************************************************/
@@ -791,6 +863,12 @@ static void show_usage(void)
           " dump    [-a][-c][<filename>]        :"
                                 " Output the trace result\n"
           "                                       [-a] <Android SysTrace>\n"
+#endif
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+          " stream  [-c] <dest> [<duration>]    :"
+                                " Send the trace while it is recorded\n"
+          "                                       <dest>: tcp:<ip>:<port>,\n"
+          "                                       udp:<ip>:<port> or <path>\n"
 #endif
           " mode    [{+|-}{o|w|s|a|i|d}...]     :"
                                 " Set task trace options\n"
@@ -863,6 +941,12 @@ int main(int argc, FAR char *argv[])
           i = trace_cmd_dump(i + 1, argc, argv, notectlfd);
         }
 #endif
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+      else if (strcmp(argv[i], "stream") == 0)
+        {
+          i = trace_cmd_stream(i + 1, argc, argv, notectlfd);
+        }
+#endif
 #ifdef CONFIG_SYSTEM_SYSTEM
       else if (strcmp(argv[i], "cmd") == 0)
         {
@@ -87,6 +87,20 @@ bool trace_dump_get_overwrite(void);
 
 void trace_dump_set_overwrite(bool mode);
 
+#ifdef CONFIG_SYSTEM_TRACE_STREAM
+
+/****************************************************************************
+ * Name: trace_stream
+ *
+ * Description:
+ *   Stream notes to a TCP/UDP peer or a device while they are recorded
+ *
+ ****************************************************************************/
+
+int trace_stream(FAR const char *dest, int duration);
+
+#endif
+
 #else /* CONFIG_DRIVERS_NOTERAM */
 
 #define trace_dump(type,out)
@@ -0,0 +1,328 @@
+/****************************************************************************
+ * apps/system/trace/trace_stream.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SYSTEM_TRACE_STREAM_FRAMESIZE
+#  define CONFIG_SYSTEM_TRACE_STREAM_FRAMESIZE 1024
+#endif
+
+#ifndef CONFIG_SYSTEM_TRACE_STREAM_INTERVAL
+#  define CONFIG_SYSTEM_TRACE_STREAM_INTERVAL 10
+#endif
+
+#ifndef CONFIG_SYSTEM_TRACE_STREAM_PRIORITY
+#  define CONFIG_SYSTEM_TRACE_STREAM_PRIORITY 50
+#endif
+
+/* Every frame starts with a header of
+ *
+ *   'N' 'T'  magic
+ *   uint8_t  version (TRACE_STREAM_VERSION)
+ *   uint8_t  type of the payload (TRACE_STREAM_TEXT)
+ *   uint16_t length of the payload, little endian
+ *   uint32_t sequence number, little endian
+ *
+ * so that a receiver can find frame boundaries in a byte stream and tell
+ * lost UDP datagrams.  See trace_stream.py for a decoder.
+ */
+
+#define TRACE_STREAM_HDRSIZE   10
+#define TRACE_STREAM_VERSION   1
+#define TRACE_STREAM_TEXT      0  /* Notes, as read from /dev/note/ram */
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static volatile bool g_stream_stop;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: stream_sighandler
+ ****************************************************************************/
+
+static void stream_sighandler(int signo)
+{
+  g_stream_stop = true;
+}
+
+/****************************************************************************
+ * Name: stream_connect
+ *
+ * Description:
+ *   Open the destination: tcp:<addr>:<port>, udp:<addr>:<port>, or the
+ *   path of a file or device (serial port, RTT channel...).
+ *
+ ****************************************************************************/
+
+static int stream_connect(FAR const char *dest)
+{
+#if defined(CONFIG_NET_TCP) || defined(CONFIG_NET_UDP)
+  struct sockaddr_in addr;
+  char host[INET_ADDRSTRLEN];
+  FAR const char *port;
+  size_t len;
+  int type = -1;
+  int fd;
+
+#ifdef CONFIG_NET_TCP
+  if (strncmp(dest, "tcp:", 4) == 0)
+    {
+      type = SOCK_STREAM;
+    }
+#endif
+
+#ifdef CONFIG_NET_UDP
+  if (strncmp(dest, "udp:", 4) == 0)
+    {
+      type = SOCK_DGRAM;
+    }
+#endif
+
+  if (type >= 0)
+    {
+      port = strrchr(dest + 4, ':');
+      len  = port != NULL ? port - (dest + 4) : 0;
+      if (len == 0 || len >= sizeof(host))
+        {
+          fprintf(stderr, "trace stream: bad address '%s'\n", dest);
+          return ERROR;
+        }
+
+      memcpy(host, dest + 4, len);
+      host[len] = '\0';
+
+      memset(&addr, 0, sizeof(addr));
+      addr.sin_family = AF_INET;
+      addr.sin_port   = htons(atoi(port + 1));
+      if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+        {
+          fprintf(stderr, "trace stream: bad address '%s'\n", dest);
+          return ERROR;
+        }
+
+      fd = socket(AF_INET, type | SOCK_CLOEXEC, 0);
+      if (fd < 0)
+        {
+          fprintf(stderr, "trace stream: socket failed: %d\n", errno);
+          return ERROR;
+        }
+
+      if (connect(fd, (FAR struct sockaddr *)&addr, sizeof(addr)) < 0)
+        {
+          fprintf(stderr, "trace stream: cannot connect to '%s': %d\n",
+                  dest, errno);
+          close(fd);
+          return ERROR;
+        }
+
+      return fd;
+    }
+#endif
+
+  if (strncmp(dest, "tcp:", 4) == 0 || strncmp(dest, "udp:", 4) == 0)
+    {
+      fprintf(stderr, "trace stream: '%s' is not supported\n", dest);
+      return ERROR;
+    }
+
+  return open(dest, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+}
+
+/****************************************************************************
+ * Name: stream_write
+ ****************************************************************************/
+
+static int stream_write(int fd, FAR const uint8_t *buf, size_t len)
+{
+  ssize_t ret;
+
+  while (len > 0)
+    {
+      ret = write(fd, buf, len);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      buf += ret;
+      len -= ret;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: trace_stream
+ *
+ * Description:
+ *   Read notes as they are recorded and send them to dest, until the
+ *   duration (in seconds, 0 for no limit) has passed or SIGINT/SIGTERM.
+ *   Runs at CONFIG_SYSTEM_TRACE_STREAM_PRIORITY, so that it only takes
+ *   time that the traced system leaves.
+ *
+ ****************************************************************************/
+
+int trace_stream(FAR const char *dest, int duration)
+{
+  struct sched_param param;
+  struct timespec start;
+  struct timespec now;
+  FAR uint8_t *frame;
+  unsigned long nbytes = 0;
+  uint32_t seqno = 0;
+  ssize_t len;
+  int notefd;
+  int outfd;
+  int ret = OK;
+
+  notefd = open("/dev/note/ram", O_RDONLY);
+  if (notefd < 0)
+    {
+      fprintf(stderr, "trace: cannot open /dev/note/ram\n");
+      return ERROR;
+    }
+
+  outfd = stream_connect(dest);
+  if (outfd < 0)
+    {
+      fprintf(stderr, "trace stream: cannot open '%s'\n", dest);
+      close(notefd);
+      return ERROR;
+    }
+
+  frame = malloc(CONFIG_SYSTEM_TRACE_STREAM_FRAMESIZE);
+  if (frame == NULL)
+    {
+      close(outfd);
+      close(notefd);
+      return ERROR;
+    }
+
+  param.sched_priority = CONFIG_SYSTEM_TRACE_STREAM_PRIORITY;
+  sched_setparam(0, &param);
+
+  g_stream_stop = false;
+  signal(SIGINT, stream_sighandler);
+  signal(SIGTERM, stream_sighandler);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (!g_stream_stop)
+    {
+      if (duration > 0)
+        {
+          clock_gettime(CLOCK_MONOTONIC, &now);
+          if (now.tv_sec - start.tv_sec >= duration)
+            {
+              break;
+            }
+        }
+
+      len = read(notefd, frame + TRACE_STREAM_HDRSIZE,
+                 CONFIG_SYSTEM_TRACE_STREAM_FRAMESIZE -
+                 TRACE_STREAM_HDRSIZE);
+      if (len < 0 && errno != EINTR)
+        {
+          ret = ERROR;
+          break;
+        }
+
+      if (len > 0)
+        {
+          frame[0] = 'N';
+          frame[1] = 'T';
+          frame[2] = TRACE_STREAM_VERSION;
+          frame[3] = TRACE_STREAM_TEXT;
+          frame[4] = len & 0xff;
+          frame[5] = len >> 8;
+          frame[6] = seqno & 0xff;
+          frame[7] = (seqno >> 8) & 0xff;
+          frame[8] = (seqno >> 16) & 0xff;
+          frame[9] = seqno >> 24;
+
+          if (stream_write(outfd, frame, TRACE_STREAM_HDRSIZE + len) < 0)
+            {
+              fprintf(stderr, "trace stream: send failed: %d\n", errno);
+              ret = ERROR;
+              break;
+            }
+
+          seqno++;
+          nbytes += len;
+          continue;
+        }
+
+      /* Caught up with the recorder, let it collect more notes */
+
+      usleep(CONFIG_SYSTEM_TRACE_STREAM_INTERVAL * 1000);
+    }
+
+  signal(SIGINT, SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+
+  printf("trace stream: %" PRIu32 " frames, %lu bytes\n", seqno, nbytes);
+
+  free(frame);
+  close(outfd);
+  close(notefd);
+  return ret;
+}
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+# apps/system/trace/trace_stream.py
+#
+# Licensed to the Apache Software Foundation (ASF) under one or more
+# contributor license agreements.  See the NOTICE file distributed with
+# this work for additional information regarding copyright ownership.  The
+# ASF licenses this file to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance with the
+# License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+# License for the specific language governing permissions and limitations
+# under the License.
+#
+"""Receive the output of 'trace stream' and write it as an ftrace text file,
+which can be opened in Perfetto (ui.perfetto.dev) or converted with
+catapult's trace2html.
+
+  trace_stream.py --tcp 5000 trace.txt    # trace stream tcp:<host>:5000
+  trace_stream.py --udp 5000 trace.txt    # trace stream udp:<host>:5000
+  trace_stream.py --file raw.bin trace.txt  # captured from serial or RTT
+"""
+
+import argparse
+import socket
+import struct
+import sys
+
+MAGIC = b"NT"
+VERSION = 1
+TYPE_TEXT = 0
+HEADER = struct.Struct("<2sBBHI")
+
+
+class Decoder:
+    def __init__(self, out):
+        self.out = out
+        self.buf = b""
+        self.seqno = None
+        self.frames = 0
+        self.lost = 0
+        self.garbage = 0
+
+    def frame(self, seqno, ftype, payload):
+        if self.seqno is not None and seqno != self.seqno:
+            self.lost += (seqno - self.seqno) & 0xFFFFFFFF
+        self.seqno = (seqno + 1) & 0xFFFFFFFF
+        self.frames += 1
+        if ftype == TYPE_TEXT:
+            self.out.write(payload)
+
+    def datagram(self, data):
+        if len(data) < HEADER.size:
+            self.garbage += len(data)
+            return
+        magic, version, ftype, length, seqno = HEADER.unpack_from(data)
+        if magic != MAGIC or version != VERSION or length + HEADER.size != len(data):
+            self.garbage += len(data)
+            return
+        self.frame(seqno, ftype, data[HEADER.size :])
+
+    def stream(self, data):
+        """Feed bytes of a stream; frames may be split or preceded by noise."""
+        self.buf += data
+        while len(self.buf) >= HEADER.size:
+            start = self.buf.find(MAGIC)
+            if start < 0:
+                self.garbage += len(self.buf) - 1
+                self.buf = self.buf[-1:]
+                return
+            if start > 0:
+                self.garbage += start
+                self.buf = self.buf[start:]
+                continue
+            if len(self.buf) < HEADER.size:
+                return
+            magic, version, ftype, length, seqno = HEADER.unpack_from(self.buf)
+            if version != VERSION:
+                self.garbage += 1
+                self.buf = self.buf[1:]
+                continue
+            if len(self.buf) < HEADER.size + length:
+                return
+            self.frame(seqno, ftype, self.buf[HEADER.size : HEADER.size + length])
+            self.buf = self.buf[HEADER.size + length :]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--tcp", type=int, metavar="PORT", help="accept on PORT")
+    source.add_argument("--udp", type=int, metavar="PORT", help="receive on PORT")
+    source.add_argument("--file", metavar="PATH", help="decode a captured stream")
+    parser.add_argument("output", help="ftrace text file to write")
+    args = parser.parse_args()
+
+    with open(args.output, "wb") as out:
+        out.write(b"# tracer: nop\n#\n")
+        decoder = Decoder(out)
+
+        try:
+            if args.file:
+                with open(args.file, "rb") as f:
+                    decoder.stream(f.read())
+            elif args.tcp:
+                server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+                server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+                server.bind(("", args.tcp))
+                server.listen(1)
+                conn, peer = server.accept()
+                print("connection from %s:%d" % peer, file=sys.stderr)
+                while True:
+                    data = conn.recv(65536)
+                    if not data:
+                        break
+                    decoder.stream(data)
+            else:
+                sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+                sock.bind(("", args.udp))
+                while True:
+                    decoder.datagram(sock.recv(65536))
+        except KeyboardInterrupt:
+            pass
+
+    print(
+        "%d frames, %d lost, %d bytes skipped"
+        % (decoder.frames, decoder.lost, decoder.garbage),
+        file=sys.stderr,
+    )
+
+
+if __name__ == "__main__":
+    main()
@@ -28,10 +28,12 @@
 #include <errno.h>
 #include <dirent.h>
 #include <poll.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -44,6 +46,28 @@
 
 #define ORB_MAX_PRINT_NAME 32
 #define ORB_TOP_WAIT_TIME  1000
+#define ORB_HASH_SIZE      64   /* Buckets of the object hash table */
+#define ORB_MAX_EVENTS     16   /* Events taken by one epoll_wait() */
+
+#ifndef CONFIG_UORB_LISTENER_RECORD_BUFSIZE
+#  define CONFIG_UORB_LISTENER_RECORD_BUFSIZE 65536
+#endif
+
+#ifndef CONFIG_UORB_LISTENER_RECORD_BLOCKSIZE
+#  define CONFIG_UORB_LISTENER_RECORD_BLOCKSIZE 4096
+#endif
+
+/* Binary log format: a file header, then records.  A topic record, with
+ * the name of a topic, comes before the first data record of the topic.
+ * Data records carry the time the sample was read and the raw sample.
+ * All fields are in the byte order of the recorder.
+ */
+
+#define ORB_LOG_MAGIC      "uORBlog"
+#define ORB_LOG_VERSION    1
+#define ORB_LOG_TOPIC      'T'
+#define ORB_LOG_DATA       'D'
+#define ORB_LOG_MAX_TOPICS 255
 
 /****************************************************************************
  * Private Types
@@ -52,23 +76,78 @@
 struct listen_object_s
 {
   struct list_node  node;         /* Node of object info list */
+  FAR struct listen_object_s *hash_next; /* Next object in hash bucket */
   struct orb_object object;       /* Object id */
   orb_abstime       timestamp;    /* Time of lastest generation  */
   unsigned long     generation;   /* Latest generation */
+  int               state_fd;     /* Kept open for the state, or -1 */
+
+  /* Statistics of the monitor */
+
+  int               sub_fd;       /* Subscription, or -1 */
+  unsigned long     received;     /* Messages received */
+  uint64_t          start_gen;    /* Generation when subscribed */
+  uint64_t          latency_sum;  /* Sum of message latencies, us */
+  uint64_t          latency_max;  /* Largest message latency, us */
+  unsigned long     latency_cnt;  /* Messages with a timestamp */
+};
+
+#ifdef CONFIG_UORB_LISTENER_RECORD
+struct orb_loghdr_s
+{
+  char     magic[7];              /* ORB_LOG_MAGIC */
+  uint8_t  version;               /* ORB_LOG_VERSION */
+};
+
+struct orb_logrec_s
+{
+  uint16_t size;                  /* Bytes that follow this header */
+  uint8_t  type;                  /* ORB_LOG_TOPIC or ORB_LOG_DATA */
+  uint8_t  id;                    /* Topic number in this log */
+};
+
+/* Followed by the name of the topic, without terminating NUL */
+
+struct orb_logtopic_s
+{
+  uint16_t o_size;                /* Size of a sample */
+  uint8_t  instance;              /* Instance of the topic */
+  uint8_t  reserved;
 };
 
+/* Samples wait in a ring for the writer thread.  The counters only grow;
+ * their value modulo the ring size is the position in the ring.
+ */
+
+struct listen_recorder_s
+{
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+  FAR uint8_t    *data;
+  uint64_t        produced;       /* Bytes put into the ring */
+  uint64_t        consumed;       /* Bytes written to the file */
+  unsigned long   dropped;        /* Samples that found the ring full */
+  int             fd;             /* Log file */
+  bool            done;           /* No more samples will come */
+};
+#endif
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
 
-static int listener_get_state(FAR struct orb_object *object,
+static unsigned int listener_hash(FAR const char *name, int instance);
+static FAR struct listen_object_s *
+listener_find_object(FAR const char *name, size_t len, int instance);
+static int listener_get_state(FAR struct listen_object_s *tmp,
                               FAR struct orb_state *state);
 static int listener_add_object(FAR struct list_node *objlist,
                                FAR struct orb_object *object);
 static void listener_delete_object_list(FAR struct list_node *objlist);
 static int listener_generate_object_list(FAR struct list_node *objlist,
                                          FAR const char *filter);
-static int listener_print(FAR const struct orb_metadata *meta, int fd);
+static int listener_print(FAR const struct orb_metadata *meta, int fd,
+                          FAR orb_abstime *timestamp);
 static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
                              float topic_rate, int topic_latency,
                              int nb_msgs, int timeout);
@@ -77,6 +156,17 @@ static int listener_update(FAR struct list_node *objlist,
 static void listener_top(FAR struct list_node *objlist,
                          FAR const char *filter,
                          bool only_once);
+#ifdef CONFIG_UORB_LISTENER_RECORD
+static int listener_record_put(FAR struct listen_recorder_s *rec,
+                               FAR struct orb_logrec_s *hdr,
+                               FAR const void *prefix, size_t prefixlen,
+                               FAR const void *data, size_t len);
+static FAR void *listener_record_writer(FAR void *arg);
+static int listener_record(FAR struct list_node *objlist, int nb_objects,
+                           FAR const char *path, float topic_rate,
+                           int topic_latency, int nb_msgs, int timeout);
+static int listener_replay(FAR const char *path);
+#endif
 
 /****************************************************************************
  * Private Data
@@ -84,6 +174,12 @@ static void listener_top(FAR struct list_node *objlist,
 
 static bool g_should_exit = false;
 
+/* Objects of the list by name and instance, so that rescans only need to
+ * look at new device nodes.
+ */
+
+static FAR struct listen_object_s *g_object_hash[ORB_HASH_SIZE];
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -122,37 +218,99 @@ listener <command> [arguments...]\n\
 \t[-T       ]  Top, continuously print updating objects\n\
 \t[-l       ]  Top only execute once.\n\
   ");
+#ifdef CONFIG_UORB_LISTENER_RECORD
+  uorbinfo_raw("\
+\t[-w <file>]  Record the topics to a binary log file instead of\n\
+\t             printing them; -n, -r, -b and -t apply\n\
+\t[-p <file>]  Print the contents of a binary log file\n\
+  ");
+#endif
+}
+
+/****************************************************************************
+ * Name: listener_hash
+ *
+ * Description:
+ *   Hash of an object name and instance.
+ *
+ ****************************************************************************/
+
+static unsigned int listener_hash(FAR const char *name, int instance)
+{
+  unsigned int hash = 2166136261u;
+
+  while (*name != '\0')
+    {
+      hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    }
+
+  return (hash ^ instance) % ORB_HASH_SIZE;
+}
+
+/****************************************************************************
+ * Name: listener_find_object
+ *
+ * Description:
+ *   Find an object of the list by its name and instance.
+ *
+ * Input Parameters:
+ *   name       Topic name, not necessarily terminated.
+ *   len        Length of name.
+ *   instance   Instance of the object.
+ *
+ * Returned Value:
+ *   The object, NULL if it is not in the list.
+ ****************************************************************************/
+
+static FAR struct listen_object_s *
+listener_find_object(FAR const char *name, size_t len, int instance)
+{
+  FAR struct listen_object_s *tmp;
+  char key[ORB_PATH_MAX];
+
+  strlcpy(key, name, MIN(len + 1, sizeof(key)));
+  for (tmp = g_object_hash[listener_hash(key, instance)]; tmp != NULL;
+       tmp = tmp->hash_next)
+    {
+      if (tmp->object.instance == instance &&
+          strcmp(tmp->object.meta->o_name, key) == 0)
+        {
+          return tmp;
+        }
+    }
+
+  return NULL;
 }
 
 /****************************************************************************
  * Name: listener_get_state
  *
  * Description:
- *   Get object's current state.
+ *   Get object's current state.  The object stays open, so that refreshes
+ *   of top do not open and close every object.
  *
  * Input Parameters:
- *   object   Given object
+ *   tmp      Given object
  *   state    Returned state.
  *
  * Returned Value:
  *   0 on success, otherwise negative errno.
  ****************************************************************************/
 
-static int listener_get_state(FAR struct orb_object *object,
+static int listener_get_state(FAR struct listen_object_s *tmp,
                               FAR struct orb_state *state)
 {
-  int ret;
-  int fd;
-
-  fd = orb_open(object->meta->o_name, object->instance, 0);
-  if (fd < 0)
+  if (tmp->state_fd < 0)
     {
-      return fd;
+      tmp->state_fd = orb_open(tmp->object.meta->o_name,
+                               tmp->object.instance, 0);
+      if (tmp->state_fd < 0)
+        {
+          return tmp->state_fd;
+        }
     }
 
-  ret = orb_get_state(fd, state);
-  orb_close(fd);
-  return ret;
+  return orb_get_state(tmp->state_fd, state);
 }
 
 /****************************************************************************
@@ -182,12 +340,20 @@ static int listener_add_object(FAR struct list_node *objlist,
       return -ENOMEM;
     }
 
-  ret = listener_get_state(object, &state);
+  memset(tmp, 0, sizeof(*tmp));
   tmp->object.meta     = object->meta;
   tmp->object.instance = object->instance;
+  tmp->state_fd        = -1;
+  tmp->sub_fd          = -1;
+
+  ret = listener_get_state(tmp, &state);
   tmp->timestamp       = orb_absolute_time();
   tmp->generation      = ret < 0 ? 0 : state.generation;
   list_add_tail(objlist, &tmp->node);
+
+  ret = listener_hash(object->meta->o_name, object->instance);
+  tmp->hash_next     = g_object_hash[ret];
+  g_object_hash[ret] = tmp;
   return 0;
 }
 
@@ -208,22 +374,14 @@ static int listener_add_object(FAR struct list_node *objlist,
 static int listener_update(FAR struct list_node *objlist,
                            FAR struct orb_object *object)
 {
-  FAR struct listen_object_s *old = NULL;
-  FAR struct listen_object_s *tmp;
+  FAR struct listen_object_s *old;
   int ret;
 
   /* Check wether object already exist in old list */
 
-  list_for_every_entry(objlist, tmp, struct listen_object_s, node)
-    {
-      if (tmp->object.meta == object->meta &&
-          tmp->object.instance == object->instance)
-        {
-          old = tmp;
-          break;
-        }
-    }
-
+  old = listener_find_object(object->meta->o_name,
+                             strlen(object->meta->o_name),
+                             object->instance);
   if (old)
     {
       /* If object existed in old list, print and update. */
@@ -234,7 +392,7 @@ static int listener_update(FAR struct list_node *objlist,
       unsigned long delta_generation;
 
       now_time = orb_absolute_time();
-      ret = listener_get_state(object, &state);
+      ret = listener_get_state(old, &state);
       if (ret < 0)
         {
           return ret;
@@ -295,11 +453,17 @@ static void listener_delete_object_list(FAR struct list_node *objlist)
 
   list_for_every_entry_safe(objlist, tmp, next, struct listen_object_s, node)
     {
+      if (tmp->state_fd >= 0)
+        {
+          orb_close(tmp->state_fd);
+        }
+
       list_delete(&tmp->node);
       free(tmp);
     }
 
   list_initialize(objlist);
+  memset(g_object_hash, 0, sizeof(g_object_hash));
 }
 
 /****************************************************************************
@@ -320,6 +484,7 @@ static void listener_delete_object_list(FAR struct list_node *objlist)
 static int listener_generate_object_list(FAR struct list_node *objlist,
                                          FAR const char *filter)
 {
+  FAR struct listen_object_s *known;
   FAR struct dirent *entry;
   struct orb_object object;
   char name[ORB_PATH_MAX];
@@ -422,7 +587,11 @@ static int listener_generate_object_list(FAR struct list_node *objlist,
             }
         }
 
-      object.meta = orb_get_meta(entry->d_name);
+      /* Only new nodes need their metadata looked up */
+
+      known = listener_find_object(name, len, object.instance);
+      object.meta = known ? known->object.meta :
+                            orb_get_meta(entry->d_name);
       if (!object.meta)
         {
           continue;
@@ -452,12 +621,15 @@ static int listener_generate_object_list(FAR struct list_node *objlist,
  * Input Parameters:
  *   meta         The uORB metadata.
  *   fd           Subscriber handle.
+ *   timestamp    Returned timestamp of the message, if not NULL.  Messages
+ *                start with their timestamp; smaller ones give 0.
  *
  * Returned Value:
  *   0 on success copy, otherwise -1
  ****************************************************************************/
 
-static int listener_print(FAR const struct orb_metadata *meta, int fd)
+static int listener_print(FAR const struct orb_metadata *meta, int fd,
+                          FAR orb_abstime *timestamp)
 {
   char buffer[meta->o_size];
   int ret;
@@ -470,14 +642,48 @@ static int listener_print(FAR const struct orb_metadata *meta, int fd)
     }
 #endif
 
+  if (timestamp != NULL)
+    {
+      *timestamp = 0;
+      if (ret == OK && meta->o_size >= sizeof(orb_abstime))
+        {
+          memcpy(timestamp, buffer, sizeof(orb_abstime));
+        }
+    }
+
   return ret;
 }
 
+/****************************************************************************
+ * Name: listener_account
+ *
+ * Description:
+ *   Update the statistics of an object for a received message.
+ *
+ ****************************************************************************/
+
+static void listener_account(FAR struct listen_object_s *tmp,
+                             orb_abstime timestamp)
+{
+  orb_abstime now = orb_absolute_time();
+  orb_abstime latency;
+
+  tmp->received++;
+  if (timestamp != 0 && timestamp <= now)
+    {
+      latency = now - timestamp;
+      tmp->latency_sum += latency;
+      tmp->latency_max  = MAX(tmp->latency_max, latency);
+      tmp->latency_cnt++;
+    }
+}
+
 /****************************************************************************
  * Name: listener_monitor
  *
  * Description:
- *   Moniter objects by subscribe and print data.
+ *   Moniter objects by subscribe and print data.  Only objects with data
+ *   are visited, epoll reports them directly.
  *
  * Input Parameters:
  *   objlist        List of objects to subscribe.
@@ -485,7 +691,7 @@ static int listener_print(FAR const struct orb_metadata *meta, int fd)
  *   topic_rate     Subscribe frequency.
  *   topic_latency  Subscribe report latency.
  *   nb_msgs        Subscribe amount of messages.
- *   timeout        Maximum poll waiting time , ms.
+ *   timeout        Maximum poll waiting time , s.
  *
  * Returned Value:
  *   None
@@ -495,28 +701,31 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
                              float topic_rate, int topic_latency,
                              int nb_msgs, int timeout)
 {
-  FAR struct pollfd *fds;
-  FAR int *recv_msgs;
+  struct epoll_event events[ORB_MAX_EVENTS];
+  struct epoll_event ev;
+  struct orb_state state;
   float interval = topic_rate ? (1000000 / topic_rate) : 0;
+  orb_abstime start = orb_absolute_time();
+  orb_abstime elapsed;
+  orb_abstime timestamp;
   int nb_recv_msgs = 0;
-  int i = 0;
+  int epfd = -1;
+  int nevents;
+  int i;
 
   struct listen_object_s *tmp;
 
-  fds = malloc(nb_objects * sizeof(struct pollfd));
-  if (!fds)
-    {
-      return;
-    }
-
-  recv_msgs = calloc(nb_objects, sizeof(int));
-  if (!recv_msgs)
+  if (nb_msgs != 1)
     {
-      free(fds);
-      return;
+      epfd = epoll_create1(EPOLL_CLOEXEC);
+      if (epfd < 0)
+        {
+          uorberr("epoll_create1 failed: %d", errno);
+          return;
+        }
     }
 
-  /* Prepare pollfd for all objects */
+  /* Subscribe all objects */
 
   list_for_every_entry(objlist, tmp, struct listen_object_s, node)
     {
@@ -525,22 +734,18 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
       fd = orb_subscribe_multi(tmp->object.meta, tmp->object.instance);
       if (fd < 0)
         {
-          fds[i].fd     = -1;
-          fds[i].events = 0;
+          tmp->sub_fd = -1;
           continue;
         }
-      else
-        {
-          fds[i].fd     = fd;
-          fds[i].events = POLLIN;
-        }
 
       if (nb_msgs == 1)
         {
-          listener_print(tmp->object.meta, fd);
+          listener_print(tmp->object.meta, fd, NULL);
           orb_unsubscribe(fd);
+          continue;
         }
-      else if (interval != 0)
+
+      if (interval != 0)
         {
           orb_set_interval(fd, (unsigned)interval);
 
@@ -550,44 +755,57 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
             }
         }
 
-      i++;
+      tmp->sub_fd      = fd;
+      tmp->received    = 0;
+      tmp->latency_sum = 0;
+      tmp->latency_max = 0;
+      tmp->latency_cnt = 0;
+      tmp->start_gen   = orb_get_state(fd, &state) < 0 ? 0 :
+                         state.generation;
+
+      ev.events   = EPOLLIN;
+      ev.data.ptr = tmp;
+      if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        {
+          uorberr("epoll_ctl failed: %d", errno);
+        }
     }
 
   if (nb_msgs == 1)
     {
-      free(fds);
-      free(recv_msgs);
       return;
     }
 
-  /* Loop poll and print recieved messages */
+  /* Loop wait and print recieved messages */
 
   while ((!nb_msgs || nb_recv_msgs < nb_msgs) && !g_should_exit)
     {
-      if (poll(&fds[0], nb_objects, timeout * 1000) > 0)
+      nevents = epoll_wait(epfd, events, ORB_MAX_EVENTS, timeout * 1000);
+      if (nevents > 0)
         {
-          i = 0;
-          list_for_every_entry(objlist, tmp, struct listen_object_s, node)
+          for (i = 0; i < nevents; i++)
             {
-              if (fds[i].revents & POLLIN)
+              tmp = events[i].data.ptr;
+              if ((events[i].events & EPOLLIN) == 0)
                 {
-                  nb_recv_msgs++;
-                  recv_msgs[i]++;
-                  if (listener_print(tmp->object.meta, fds[i].fd) != 0)
-                    {
-                      uorberr("Listener callback failed");
-                    }
+                  continue;
+                }
 
-                  if (nb_msgs && nb_recv_msgs >= nb_msgs)
-                    {
-                      break;
-                    }
+              nb_recv_msgs++;
+              if (listener_print(tmp->object.meta, tmp->sub_fd,
+                                 &timestamp) != 0)
+                {
+                  uorberr("Listener callback failed");
                 }
 
-              i++;
+              listener_account(tmp, timestamp);
+              if (nb_msgs && nb_recv_msgs >= nb_msgs)
+                {
+                  break;
+                }
             }
         }
-      else if (errno != EINTR)
+      else if (nevents == 0 || errno != EINTR)
         {
           uorbinfo_raw("Waited for %d seconds without a message. "
                        "Giving up. err:%d", timeout, errno);
@@ -595,15 +813,387 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
         }
     }
 
-  i = 0;
+  elapsed = orb_absolute_time() - start;
+  close(epfd);
+
   list_for_every_entry(objlist, tmp, struct listen_object_s, node)
     {
-      if (fds[i].fd < 0)
+      unsigned long lost = 0;
+
+      if (tmp->sub_fd < 0)
         {
           uorbinfo_raw("Object name:%s%d, subscribe fail",
                        tmp->object.meta->o_name, tmp->object.instance);
+          continue;
+        }
+
+      /* Messages published but not received were lost, unless the rate
+       * was limited on purpose.
+       */
+
+      if (interval == 0 && orb_get_state(tmp->sub_fd, &state) >= 0 &&
+          state.generation - tmp->start_gen > tmp->received)
+        {
+          lost = state.generation - tmp->start_gen - tmp->received;
         }
-      else
+
+      if (topic_latency)
+        {
+          orb_set_batch_interval(tmp->sub_fd, 0);
+        }
+
+      orb_unsubscribe(tmp->sub_fd);
+      tmp->sub_fd = -1;
+
+      uorbinfo_raw("Object name:%s%d, recieved:%lu, rate:%lu Hz, "
+                   "latency avg/max:%" PRIu64 "/%" PRIu64 " us, lost:%lu",
+                   tmp->object.meta->o_name, tmp->object.instance,
+                   tmp->received,
+                   elapsed ? (unsigned long)(tmp->received * 1000000ull /
+                                             elapsed) : 0,
+                   tmp->latency_cnt ? tmp->latency_sum / tmp->latency_cnt
+                                    : 0,
+                   tmp->latency_max, lost);
+    }
+
+  uorbinfo_raw("Total number of received Message:%d/%d",
+               nb_recv_msgs, nb_msgs ? nb_msgs : nb_recv_msgs);
+}
+
+#ifdef CONFIG_UORB_LISTENER_RECORD
+
+/****************************************************************************
+ * Name: listener_record_put
+ *
+ * Description:
+ *   Queue a record for the writer thread.  The record is dropped if it
+ *   does not fit in the ring.
+ *
+ * Input Parameters:
+ *   rec        The recorder.
+ *   hdr        Record header.
+ *   prefix     Data that follows the header (topic info or timestamp).
+ *   prefixlen  Length of prefix.
+ *   data       Payload of the record.
+ *   len        Length of data.
+ *
+ * Returned Value:
+ *   0 on success, -ENOBUFS if the ring is full.
+ ****************************************************************************/
+
+static int listener_record_put(FAR struct listen_recorder_s *rec,
+                               FAR struct orb_logrec_s *hdr,
+                               FAR const void *prefix, size_t prefixlen,
+                               FAR const void *data, size_t len)
+{
+  FAR const void *parts[3];
+  size_t lens[3];
+  size_t total;
+  size_t pos;
+  size_t n;
+  int i;
+
+  hdr->size = prefixlen + len;
+  total = sizeof(*hdr) + hdr->size;
+
+  parts[0] = hdr;
+  lens[0]  = sizeof(*hdr);
+  parts[1] = prefix;
+  lens[1]  = prefixlen;
+  parts[2] = data;
+  lens[2]  = len;
+
+  pthread_mutex_lock(&rec->lock);
+
+  if (CONFIG_UORB_LISTENER_RECORD_BUFSIZE -
+      (size_t)(rec->produced - rec->consumed) < total)
+    {
+      rec->dropped++;
+      pthread_mutex_unlock(&rec->lock);
+      return -ENOBUFS;
+    }
+
+  for (i = 0; i < 3; i++)
+    {
+      pos = rec->produced % CONFIG_UORB_LISTENER_RECORD_BUFSIZE;
+      n   = MIN(lens[i], CONFIG_UORB_LISTENER_RECORD_BUFSIZE - pos);
+      memcpy(rec->data + pos, parts[i], n);
+      memcpy(rec->data, (FAR const uint8_t *)parts[i] + n, lens[i] - n);
+      rec->produced += lens[i];
+    }
+
+  if (rec->produced - rec->consumed >= CONFIG_UORB_LISTENER_RECORD_BLOCKSIZE)
+    {
+      pthread_cond_signal(&rec->cond);
+    }
+
+  pthread_mutex_unlock(&rec->lock);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: listener_record_writer
+ *
+ * Description:
+ *   Writer thread: write the ring to the log file in whole blocks, so
+ *   that the storage sees few, large and aligned writes.  What is left is
+ *   written when recording stops.
+ *
+ ****************************************************************************/
+
+static FAR void *listener_record_writer(FAR void *arg)
+{
+  FAR struct listen_recorder_s *rec = arg;
+  uint64_t avail;
+  size_t chunk;
+  size_t pos;
+  ssize_t ret;
+
+  pthread_mutex_lock(&rec->lock);
+
+  for (; ; )
+    {
+      avail = rec->produced - rec->consumed;
+      chunk = CONFIG_UORB_LISTENER_RECORD_BLOCKSIZE -
+              (size_t)(rec->consumed % CONFIG_UORB_LISTENER_RECORD_BLOCKSIZE);
+      if (avail < chunk)
+        {
+          if (!rec->done)
+            {
+              pthread_cond_wait(&rec->cond, &rec->lock);
+              continue;
+            }
+
+          if (avail == 0)
+            {
+              break;
+            }
+
+          chunk = avail;
+        }
+
+      pos   = rec->consumed % CONFIG_UORB_LISTENER_RECORD_BUFSIZE;
+      chunk = MIN(chunk, CONFIG_UORB_LISTENER_RECORD_BUFSIZE - pos);
+
+      /* Only this thread touches queued data, write it unlocked */
+
+      pthread_mutex_unlock(&rec->lock);
+      ret = write(rec->fd, rec->data + pos, chunk);
+      pthread_mutex_lock(&rec->lock);
+
+      if (ret <= 0)
+        {
+          uorberr("Log write failed: %d", errno);
+          g_should_exit = true;
+          break;
+        }
+
+      rec->consumed += ret;
+    }
+
+  pthread_mutex_unlock(&rec->lock);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: listener_record
+ *
+ * Description:
+ *   Record objects to a binary log file.  Samples are read in batches,
+ *   as many as are queued, and handed to a writer thread.
+ *
+ * Input Parameters:
+ *   objlist        List of objects to subscribe.
+ *   nb_objects     Length of objects list.
+ *   path           Log file.
+ *   topic_rate     Subscribe frequency.
+ *   topic_latency  Subscribe report latency.
+ *   nb_msgs        Record amount of messages, 0 for no limit.
+ *   timeout        Maximum poll waiting time, s.
+ *
+ * Returned Value:
+ *   0 on success, otherwise negative errno.
+ ****************************************************************************/
+
+static int listener_record(FAR struct list_node *objlist, int nb_objects,
+                           FAR const char *path, float topic_rate,
+                           int topic_latency, int nb_msgs, int timeout)
+{
+  struct listen_recorder_s rec;
+  struct orb_loghdr_s filehdr;
+  struct orb_logtopic_s topic;
+  struct orb_logrec_s hdr;
+  struct orb_state state;
+  FAR struct listen_object_s *tmp;
+  FAR struct pollfd *fds;
+  FAR uint8_t *buffer;
+  FAR unsigned long *recv_msgs;
+  unsigned long nb_recv_msgs = 0;
+  unsigned interval = topic_rate ? (unsigned)(1000000 / topic_rate) : 0;
+  size_t bufsize = 0;
+  pthread_t writer;
+  orb_abstime now;
+  ssize_t len;
+  ssize_t off;
+  int ret;
+  int i;
+
+  if (nb_objects > ORB_LOG_MAX_TOPICS)
+    {
+      uorbinfo_raw("Too many objects to record: %d", nb_objects);
+      return -E2BIG;
+    }
+
+  memset(&rec, 0, sizeof(rec));
+  rec.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (rec.fd < 0)
+    {
+      uorbinfo_raw("Failed to open %s: %d", path, errno);
+      return -errno;
+    }
+
+  fds       = calloc(nb_objects, sizeof(struct pollfd));
+  recv_msgs = calloc(nb_objects, sizeof(unsigned long));
+  rec.data  = malloc(CONFIG_UORB_LISTENER_RECORD_BUFSIZE);
+  if (!fds || !recv_msgs || !rec.data)
+    {
+      free(fds);
+      fds = NULL;
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  pthread_mutex_init(&rec.lock, NULL);
+  pthread_cond_init(&rec.cond, NULL);
+
+  for (i = 0; i < nb_objects; i++)
+    {
+      fds[i].fd = -1;
+    }
+
+  /* The file header goes first into the empty ring */
+
+  memcpy(filehdr.magic, ORB_LOG_MAGIC, sizeof(filehdr.magic));
+  filehdr.version = ORB_LOG_VERSION;
+  memcpy(rec.data, &filehdr, sizeof(filehdr));
+  rec.produced = sizeof(filehdr);
+
+  /* Subscribe and describe all objects.  Reads take all queued samples of
+   * an object at once, so size the buffer for the longest queue.
+   */
+
+  i = 0;
+  list_for_every_entry(objlist, tmp, struct listen_object_s, node)
+    {
+      FAR const struct orb_metadata *meta = tmp->object.meta;
+      size_t size;
+
+      fds[i].fd     = orb_subscribe_multi(meta, tmp->object.instance);
+      fds[i].events = fds[i].fd < 0 ? 0 : POLLIN;
+      if (fds[i].fd >= 0 && interval != 0)
+        {
+          orb_set_interval(fds[i].fd, interval);
+          if (topic_latency != 0)
+            {
+              orb_set_batch_interval(fds[i].fd, topic_latency);
+            }
+        }
+
+      size = meta->o_size;
+      if (fds[i].fd >= 0 && orb_get_state(fds[i].fd, &state) >= 0 &&
+          state.queue_size > 1)
+        {
+          size *= state.queue_size;
+        }
+
+      bufsize = MAX(bufsize, size);
+
+      topic.o_size   = meta->o_size;
+      topic.instance = tmp->object.instance;
+      topic.reserved = 0;
+      hdr.type       = ORB_LOG_TOPIC;
+      hdr.id         = i;
+      listener_record_put(&rec, &hdr, &topic, sizeof(topic),
+                          meta->o_name, strlen(meta->o_name));
+      i++;
+    }
+
+  buffer = malloc(bufsize);
+  if (!buffer)
+    {
+      ret = -ENOMEM;
+      goto errout_with_sync;
+    }
+
+  ret = pthread_create(&writer, NULL, listener_record_writer, &rec);
+  if (ret != 0)
+    {
+      ret = -ret;
+      goto errout_with_buffer;
+    }
+
+  uorbinfo_raw("Recording to %s", path);
+
+  /* Loop poll and queue received samples */
+
+  while ((!nb_msgs || nb_recv_msgs < nb_msgs) && !g_should_exit)
+    {
+      if (poll(fds, nb_objects, timeout * 1000) <= 0)
+        {
+          if (errno != EINTR)
+            {
+              uorbinfo_raw("Waited for %d seconds without a message. "
+                           "Giving up. err:%d", timeout, errno);
+              break;
+            }
+
+          continue;
+        }
+
+      i = 0;
+      list_for_every_entry(objlist, tmp, struct listen_object_s, node)
+        {
+          FAR const struct orb_metadata *meta = tmp->object.meta;
+
+          if ((fds[i].revents & POLLIN) == 0)
+            {
+              i++;
+              continue;
+            }
+
+          len = orb_copy_multi(fds[i].fd, buffer, bufsize);
+          now = orb_absolute_time();
+
+          hdr.type = ORB_LOG_DATA;
+          hdr.id   = i;
+          for (off = 0; off + meta->o_size <= len; off += meta->o_size)
+            {
+              if (listener_record_put(&rec, &hdr, &now, sizeof(now),
+                                      buffer + off, meta->o_size) == 0)
+                {
+                  recv_msgs[i]++;
+                }
+
+              nb_recv_msgs++;
+            }
+
+          i++;
+        }
+    }
+
+  /* Let the writer write out what is left */
+
+  pthread_mutex_lock(&rec.lock);
+  rec.done = true;
+  pthread_cond_signal(&rec.cond);
+  pthread_mutex_unlock(&rec.lock);
+
+  pthread_join(writer, NULL);
+
+  i = 0;
+  list_for_every_entry(objlist, tmp, struct listen_object_s, node)
+    {
+      if (fds[i].fd >= 0)
         {
           if (topic_latency)
             {
@@ -611,20 +1201,176 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
             }
 
           orb_unsubscribe(fds[i].fd);
-          uorbinfo_raw("Object name:%s%d, recieved:%d",
-                       tmp->object.meta->o_name, tmp->object.instance,
-                       recv_msgs[i]);
+          fds[i].fd = -1;
         }
 
+      uorbinfo_raw("Object name:%s%d, recorded:%lu",
+                   tmp->object.meta->o_name, tmp->object.instance,
+                   recv_msgs[i]);
       i++;
     }
 
-  uorbinfo_raw("Total number of received Message:%d/%d",
-               nb_recv_msgs, nb_msgs ? nb_msgs : nb_recv_msgs);
-  free(fds);
+  uorbinfo_raw("Total number of received Message:%lu, dropped:%lu",
+               nb_recv_msgs, rec.dropped);
+  ret = 0;
+
+errout_with_buffer:
+  free(buffer);
+
+errout_with_sync:
+  pthread_cond_destroy(&rec.cond);
+  pthread_mutex_destroy(&rec.lock);
+
+errout:
+  if (fds)
+    {
+      for (i = 0; i < nb_objects; i++)
+        {
+          if (fds[i].fd >= 0)
+            {
+              orb_unsubscribe(fds[i].fd);
+            }
+        }
+    }
+
+  free(rec.data);
   free(recv_msgs);
+  free(fds);
+  close(rec.fd);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: listener_replay
+ *
+ * Description:
+ *   Convert a binary log back to text.  Samples are printed by the
+ *   print_message callback of their topic, like the listener does; other
+ *   samples are printed in hex.
+ *
+ * Input Parameters:
+ *   path       Log file.
+ *
+ * Returned Value:
+ *   0 on success, otherwise negative errno.
+ ****************************************************************************/
+
+static int listener_replay(FAR const char *path)
+{
+  FAR const struct orb_metadata *metas[ORB_LOG_MAX_TOPICS];
+  uint8_t instances[ORB_LOG_MAX_TOPICS];
+  struct orb_loghdr_s filehdr;
+  struct orb_logtopic_s topic;
+  struct orb_logrec_s hdr;
+  char name[ORB_PATH_MAX];
+  char line[3 * 16 + 1];
+  FAR uint8_t *buffer;
+  orb_abstime timestamp;
+  unsigned long nrecords = 0;
+  FAR FILE *stream;
+  size_t len;
+  size_t i;
+  int ret = 0;
+
+  stream = fopen(path, "r");
+  if (stream == NULL)
+    {
+      uorbinfo_raw("Failed to open %s: %d", path, errno);
+      return -errno;
+    }
+
+  if (fread(&filehdr, sizeof(filehdr), 1, stream) != 1 ||
+      memcmp(filehdr.magic, ORB_LOG_MAGIC, sizeof(filehdr.magic)) != 0 ||
+      filehdr.version != ORB_LOG_VERSION)
+    {
+      uorbinfo_raw("%s is not a uORB log", path);
+      fclose(stream);
+      return -EINVAL;
+    }
+
+  buffer = malloc(UINT16_MAX);
+  if (buffer == NULL)
+    {
+      fclose(stream);
+      return -ENOMEM;
+    }
+
+  memset(metas, 0, sizeof(metas));
+
+  /* A record cut off at the end of the log ends the replay */
+
+  while (!g_should_exit && fread(&hdr, sizeof(hdr), 1, stream) == 1 &&
+         fread(buffer, 1, hdr.size, stream) == hdr.size)
+    {
+      if (hdr.type == ORB_LOG_TOPIC && hdr.size > sizeof(topic))
+        {
+          memcpy(&topic, buffer, sizeof(topic));
+          len = MIN(hdr.size - sizeof(topic), sizeof(name) - 1);
+          memcpy(name, buffer + sizeof(topic), len);
+          name[len] = '\0';
+
+          metas[hdr.id]     = orb_get_meta(name);
+          instances[hdr.id] = topic.instance;
+          if (metas[hdr.id] == NULL)
+            {
+              uorbinfo_raw("Unknown object %s%d, skipped", name,
+                           topic.instance);
+            }
+          else if (metas[hdr.id]->o_size != topic.o_size)
+            {
+              uorbinfo_raw("Object %s%d changed size, skipped", name,
+                           topic.instance);
+              metas[hdr.id] = NULL;
+            }
+
+          continue;
+        }
+
+      if (hdr.type != ORB_LOG_DATA || hdr.size < sizeof(timestamp) ||
+          metas[hdr.id] == NULL)
+        {
+          continue;
+        }
+
+      memcpy(&timestamp, buffer, sizeof(timestamp));
+      nrecords++;
+
+      uorbinfo_raw("[%" PRIu64 "] %s%d:", timestamp,
+                   metas[hdr.id]->o_name, instances[hdr.id]);
+
+#ifdef CONFIG_DEBUG_UORB
+      if (metas[hdr.id]->o_cb != NULL)
+        {
+          metas[hdr.id]->o_cb(metas[hdr.id], buffer + sizeof(timestamp));
+          continue;
+        }
+#endif
+
+      len = hdr.size - sizeof(timestamp);
+      for (i = 0; i < len; i++)
+        {
+          snprintf(line + 3 * (i % 16), 4, " %02x",
+                   buffer[sizeof(timestamp) + i]);
+          if (i % 16 == 15 || i == len - 1)
+            {
+              uorbinfo_raw("%s", line);
+            }
+        }
+    }
+
+  if (!g_should_exit && !feof(stream))
+    {
+      ret = -EIO;
+    }
+
+  uorbinfo_raw("Total number of replayed Message:%lu", nrecords);
+  free(buffer);
+  fclose(stream);
+  return ret;
 }
 
+#endif /* CONFIG_UORB_LISTENER_RECORD */
+
 /****************************************************************************
  * Name: listener_top
  *
@@ -713,6 +1459,9 @@ int main(int argc, FAR char *argv[])
   bool top          = false;
   bool only_once    = false;
   FAR char *filter  = NULL;
+#ifdef CONFIG_UORB_LISTENER_RECORD
+  FAR char *record  = NULL;
+#endif
   int ret;
   int ch;
 
@@ -724,10 +1473,19 @@ int main(int argc, FAR char *argv[])
 
   /* Pasrse Argument */
 
-  while ((ch = getopt(argc, argv, "r:b:n:t:Tlh")) != EOF)
+  while ((ch = getopt(argc, argv, "r:b:n:t:Tlw:p:h")) != EOF)
     {
       switch (ch)
       {
+#ifdef CONFIG_UORB_LISTENER_RECORD
+        case 'w':
+          record = optarg;
+          break;
+
+        case 'p':
+          return listener_replay(optarg) < 0 ? 1 : 0;
+#endif
+
         case 'r':
           topic_rate = atof(optarg);
           if (topic_rate < 0)
@@ -792,6 +1550,13 @@ int main(int argc, FAR char *argv[])
     {
       listener_top(&objlist, filter, only_once);
     }
+#ifdef CONFIG_UORB_LISTENER_RECORD
+  else if (record)
+    {
+      listener_record(&objlist, ret, record, topic_rate, topic_latency,
+                      nb_msgs, timeout);
+    }
+#endif
   else
     {
       uorbinfo_raw("\nMointor objects num:%d", ret);
@@ -80,6 +80,9 @@
 #define TEXT_GULP_MASK  511  /* Mask for aligning buffer allocation sizes */
 #define ALIGN_GULP(x)   (((x) + TEXT_GULP_MASK) & ~TEXT_GULP_MASK)
 
+#define LINE_INDEX_STRIDE 64 /* Lines between two line index entries */
+#define LINE_INDEX_GULP   64 /* Line index allocation unit (entries) */
+
 #define VI_TABSIZE      8    /* A TAB is eight characters */
 #define TABMASK         7    /* Mask for TAB alignment */
 #define NEXT_TAB(p)     (((p) + VI_TABSIZE) & ~TABMASK)
@@ -310,6 +313,9 @@ struct vi_s
 
   FAR char *text;           /* Dynamically allocated text buffer */
   size_t txtalloc;          /* Current allocated size of the text buffer */
+  FAR off_t *lineidx;       /* Start of every LINE_INDEX_STRIDE'th line */
+  size_t lineidxalloc;      /* Allocated entries of the line index */
+  size_t lineidxcount;      /* Valid entries of the line index */
   FAR char *yank;           /* Dynamically allocated yank buffer */
   size_t yankalloc;         /* Current allocated size of the yank buffer */
   size_t yanksize;          /* Current size of the text in the yank buffer */
@@ -381,6 +387,12 @@ static void     vi_shrinkpos(FAR struct vi_s *vi, off_t delpos,
                   size_t delsize, FAR off_t *pos);
 static void     vi_shrinktext(FAR struct vi_s *vi, off_t pos, size_t size);
 
+/* Line index */
+
+static void     vi_lineinval(FAR struct vi_s *vi, off_t pos);
+static off_t    vi_linestart(FAR struct vi_s *vi, uint32_t line);
+static uint32_t vi_lineno(FAR struct vi_s *vi, off_t pos);
+
 /* File access */
 
 static bool     vi_insertfile(FAR struct vi_s *vi, off_t pos,
@@ -1015,7 +1027,6 @@ static off_t vi_nextline(FAR struct vi_s *vi, off_t pos)
 static bool vi_extendtext(FAR struct vi_s *vi, off_t pos, size_t increment)
 {
   FAR char *alloc;
-  int i;
 
   viinfo("pos=%ld increment=%ld\n", (long)pos, (long)increment);
 
@@ -1023,11 +1034,13 @@ static bool vi_extendtext(FAR struct vi_s *vi, off_t pos, size_t increment)
 
   if (!vi->text || vi->textsize + increment > vi->txtalloc)
     {
-      /* Allocate in chunksize so that we do not have to reallocate so
-       * often.
+      /* Grow by half of the current size at least, so that typing into a
+       * large file does not reallocate (and copy) the whole text every
+       * TEXT_GULP_SIZE bytes.
        */
 
-      size_t allocsize = ALIGN_GULP(vi->textsize + increment);
+      size_t allocsize = ALIGN_GULP(MAX(vi->textsize + increment,
+                                        vi->txtalloc + vi->txtalloc / 2));
       alloc = realloc(vi->text, allocsize);
       if (alloc == NULL)
         {
@@ -1047,14 +1060,16 @@ static bool vi_extendtext(FAR struct vi_s *vi, off_t pos, size_t increment)
    * cursor position
    */
 
-  for (i = vi->textsize - 1; i >= pos; i--)
+  if (pos < vi->textsize)
     {
-      vi->text[i + increment] = vi->text[i];
+      memmove(&vi->text[pos + increment], &vi->text[pos],
+              vi->textsize - pos);
     }
 
   /* Adjust end of file position */
 
   vi->textsize += increment;
+  vi_lineinval(vi, pos);
   vi->modified  = true;
   return true;
 }
@@ -1130,23 +1145,21 @@ static void vi_shrinktext(FAR struct vi_s *vi, off_t pos, size_t size)
 {
   FAR char *alloc;
   size_t allocsize;
-  int i;
 
   viinfo("pos=%ld size=%ld\n", (long)pos, (long)size);
 
-  /* Close up the gap to remove 'size' characters at 'pos' */
+  /* Ensure we are not shrinking more than we have */
 
-  for (i = pos + size; i < vi->textsize; i++)
+  if (pos + size > vi->textsize)
     {
-      vi->text[i - size] = vi->text[i];
+      size = pos < vi->textsize ? vi->textsize - pos : 0;
     }
 
-  /* Ensure we are not shrinking more than we have */
+  /* Close up the gap to remove 'size' characters at 'pos' */
 
-  if (size > vi->textsize)
-    {
-      size = vi->textsize;
-    }
+  memmove(&vi->text[pos], &vi->text[pos + size],
+          vi->textsize - pos - size);
+  vi_lineinval(vi, pos);
 
   /* Adjust sizes and positions */
 
@@ -1156,7 +1169,10 @@ static void vi_shrinktext(FAR struct vi_s *vi, off_t pos, size_t size)
   vi_shrinkpos(vi, pos, size, &vi->winpos);
   vi_shrinkpos(vi, pos, size, &vi->prevpos);
 
-  /* Reallocate the buffer to free up memory no longer in use */
+  /* Reallocate the buffer to free up memory no longer in use.  Only do
+   * it when less than half of the buffer is used; deleting in a large
+   * file must not reallocate (and copy) the whole text every time.
+   */
 
   allocsize = ALIGN_GULP(vi->textsize);
   if (allocsize == 0)
@@ -1164,7 +1180,7 @@ static void vi_shrinktext(FAR struct vi_s *vi, off_t pos, size_t size)
       allocsize = TEXT_GULP_SIZE;
     }
 
-  if (allocsize < vi->txtalloc)
+  if (allocsize < vi->txtalloc / 2)
     {
       alloc = realloc(vi->text, allocsize);
       if (!alloc)
@@ -1180,6 +1196,176 @@ static void vi_shrinktext(FAR struct vi_s *vi, off_t pos, size_t size)
     }
 }
 
+/****************************************************************************
+ * Line index
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: vi_skiplines
+ *
+ * Description:
+ *   Return the start of the line 'nlines' below the line starting at 'pos',
+ *   or the end of the text buffer if there are not so many lines.
+ *
+ ****************************************************************************/
+
+static off_t vi_skiplines(FAR struct vi_s *vi, off_t pos, uint32_t nlines)
+{
+  FAR const char *nl;
+
+  for (; nlines > 0 && pos < vi->textsize; nlines--)
+    {
+      nl = memchr(&vi->text[pos], '\n', vi->textsize - pos);
+      if (nl == NULL)
+        {
+          return vi->textsize;
+        }
+
+      pos = nl - vi->text + 1;
+    }
+
+  return pos;
+}
+
+/****************************************************************************
+ * Name: vi_lineindex
+ *
+ * Description:
+ *   Extend the line index until it holds the entry 'idx' or an entry
+ *   beyond 'pos'.  The index is a cache: if memory runs out, the lookups
+ *   just scan from the last entry.
+ *
+ ****************************************************************************/
+
+static void vi_lineindex(FAR struct vi_s *vi, size_t idx, off_t pos)
+{
+  FAR off_t *alloc;
+  off_t next;
+
+  while (vi->lineidxcount <= idx &&
+         (vi->lineidxcount == 0 ||
+          vi->lineidx[vi->lineidxcount - 1] <= pos))
+    {
+      next = 0;
+      if (vi->lineidxcount > 0)
+        {
+          next = vi_skiplines(vi, vi->lineidx[vi->lineidxcount - 1],
+                              LINE_INDEX_STRIDE);
+          if (next >= vi->textsize)
+            {
+              break;
+            }
+        }
+
+      if (vi->lineidxcount == vi->lineidxalloc)
+        {
+          alloc = realloc(vi->lineidx, (vi->lineidxalloc + LINE_INDEX_GULP)
+                                       * sizeof(off_t));
+          if (alloc == NULL)
+            {
+              break;
+            }
+
+          vi->lineidx       = alloc;
+          vi->lineidxalloc += LINE_INDEX_GULP;
+        }
+
+      vi->lineidx[vi->lineidxcount++] = next;
+    }
+}
+
+/****************************************************************************
+ * Name: vi_lineinval
+ *
+ * Description:
+ *   The text at 'pos' changed.  Drop the index entries of the lines that
+ *   start after it, the others did not move.
+ *
+ ****************************************************************************/
+
+static void vi_lineinval(FAR struct vi_s *vi, off_t pos)
+{
+  while (vi->lineidxcount > 0 &&
+         vi->lineidx[vi->lineidxcount - 1] > pos)
+    {
+      vi->lineidxcount--;
+    }
+}
+
+/****************************************************************************
+ * Name: vi_linestart
+ *
+ * Description:
+ *   Return the start of the line 'line' (zero based), or the end of the
+ *   text buffer if there is no such line.
+ *
+ ****************************************************************************/
+
+static off_t vi_linestart(FAR struct vi_s *vi, uint32_t line)
+{
+  size_t idx = line / LINE_INDEX_STRIDE;
+
+  vi_lineindex(vi, idx, vi->textsize);
+  if (vi->lineidxcount == 0)
+    {
+      return vi_skiplines(vi, 0, line);
+    }
+
+  idx = MIN(idx, vi->lineidxcount - 1);
+  return vi_skiplines(vi, vi->lineidx[idx], line - idx * LINE_INDEX_STRIDE);
+}
+
+/****************************************************************************
+ * Name: vi_lineno
+ *
+ * Description:
+ *   Return the number (zero based) of the line holding 'pos'.
+ *
+ ****************************************************************************/
+
+static uint32_t vi_lineno(FAR struct vi_s *vi, off_t pos)
+{
+  FAR const char *nl;
+  uint32_t line = 0;
+  off_t start = 0;
+  size_t low;
+  size_t high;
+  size_t mid;
+
+  vi_lineindex(vi, SIZE_MAX, pos);
+  if (vi->lineidxcount > 0)
+    {
+      /* Find the last entry at or before pos */
+
+      low  = 0;
+      high = vi->lineidxcount - 1;
+      while (low < high)
+        {
+          mid = (low + high + 1) / 2;
+          if (vi->lineidx[mid] <= pos)
+            {
+              low = mid;
+            }
+          else
+            {
+              high = mid - 1;
+            }
+        }
+
+      line  = low * LINE_INDEX_STRIDE;
+      start = vi->lineidx[low];
+    }
+
+  while (start < pos &&
+         (nl = memchr(&vi->text[start], '\n', pos - start)) != NULL)
+    {
+      start = nl - vi->text + 1;
+      line++;
+    }
+
+  return line;
+}
+
 /****************************************************************************
  * File access
  ****************************************************************************/
@@ -2762,6 +2948,7 @@ static void vi_join(FAR struct vi_s *vi)
   /* Convert the '\n' to a space */
 
   vi->text[++start] = ' ';
+  vi_lineinval(vi, start);
   end = start + 1;
 
   /* Skip all spaces and tabs on next line */
@@ -2793,29 +2980,16 @@ static void vi_join(FAR struct vi_s *vi)
 
 static void vi_gotoline(FAR struct vi_s *vi)
 {
-  viinfo("curpos=%ld value=%ld\n", (long)vi->curpos, vi->value);
-
-  /* Special case the first line */
+  uint32_t line;
+  uint32_t top;
 
-  if (vi->value == 1)
-    {
-      vi->curpos = 0;
-    }
+  viinfo("curpos=%ld value=%ld\n", (long)vi->curpos, vi->value);
 
-  /* Work harder to position to lines in the middle */
+  /* Go to the line == value, found with the line index */
 
-  else if (vi->value > 0)
+  if (vi->value > 0)
     {
-      uint32_t line;
-
-      /* Got to the line == value */
-
-      for (line = vi->value, vi->curpos = 0;
-          --line > 0 && vi->curpos < vi->textsize;
-          )
-        {
-          vi->curpos = vi_nextline(vi, vi->curpos);
-        }
+      vi->curpos = vi_linestart(vi, vi->value - 1);
     }
 
   /* No value means to go to beginning of the last line */
@@ -2827,6 +3001,25 @@ static void vi_gotoline(FAR struct vi_s *vi)
       vi->curpos = vi_linebegin(vi, vi->textsize);
     }
 
+  /* Move the window as vi_scrollcheck() would, without walking it there
+   * line by line: the line ends up at the top when moving up and at the
+   * bottom when moving down.
+   */
+
+  line = vi_lineno(vi, vi->curpos);
+  if (line < vi->vscroll)
+    {
+      vi->winpos  = vi->curpos;
+      vi->vscroll = line;
+    }
+  else if (vi->display.row > 1 &&
+           line >= vi->vscroll + vi->display.row - 1)
+    {
+      top         = line - (vi->display.row - 2);
+      vi->winpos  = vi_linestart(vi, top);
+      vi->vscroll = top;
+    }
+
   vi->fullredraw = true;
 }
 
@@ -4906,6 +5099,7 @@ static void vi_replacech(FAR struct vi_s *vi, char ch)
     {
       /* No, just replace the character and increment the cursor position */
 
+      vi_lineinval(vi, vi->curpos);
       vi->text[vi->curpos++] = ch;
       vi->redrawline = true;
     }
@@ -5460,6 +5654,11 @@ static void vi_release(FAR struct vi_s *vi)
           free(vi->text);
         }
 
+      if (vi->lineidx)
+        {
+          free(vi->lineidx);
+        }
+
       if (vi->yank)
         {
           free(vi->yank);
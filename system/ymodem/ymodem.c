@@ -62,6 +62,10 @@
 
 #define MAX_RETRIES   100
 
+/* One packet with its header and CRC */
+
+#define PACKET_TOTAL(size) (3 + (size) + 2)
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -69,51 +73,64 @@
 static int ymodem_recv_buffer(FAR struct ymodem_ctx_s *ctx, FAR uint8_t *buf,
                               size_t size)
 {
-  size_t i = 0;
+  int ret;
 
   ymodem_debug("recv buffer data, read size is %zu\n", size);
-  while (i < size)
+  ret = serxfer_readall(&ctx->xfer, buf, size, CONFIG_SYSTEM_YMODEM_TIMEOUT);
+  if (ret < 0)
     {
-      ssize_t ret = read(ctx->recvfd, buf + i, size - i);
-      if (ret >= 0)
-        {
-          ymodem_debug("recv buffer data, size %zd\n", ret);
-          i += ret;
-        }
-      else
-        {
-          ymodem_debug("recv buffer error, ret %d\n", -errno);
-          return -errno;
-        }
+      ymodem_debug("recv buffer error, ret %d\n", ret);
     }
 
-  return 0;
+  return ret;
 }
 
 static int ymodem_send_buffer(FAR struct ymodem_ctx_s *ctx,
                               FAR const uint8_t *buf, size_t size)
 {
-  size_t i = 0;
+  ssize_t ret;
 
   ymodem_debug("send buffer data, write size is %zu\n", size);
-  while (i < size)
+  ret = serxfer_write(&ctx->xfer, buf, size);
+  if (ret < 0)
     {
-      ssize_t ret = write(ctx->sendfd, buf, size);
-      if (ret >= 0)
-        {
-          ymodem_debug("send buffer data, size %zd\n", ret);
-          i += ret;
-        }
-      else
-        {
-          ymodem_debug("send buffer error, ret %d\n", -errno);
-          return -errno;
-        }
+      ymodem_debug("send buffer error, ret %zd\n", ret);
+      return ret;
     }
 
   return 0;
 }
 
+static int ymodem_alloc(FAR struct ymodem_ctx_s *ctx)
+{
+  size_t total;
+
+  if (ctx->custom_size != 0)
+    {
+      total = PACKET_TOTAL(ctx->custom_size);
+    }
+  else
+    {
+      total = PACKET_TOTAL(YMODEM_PACKET_1K_SIZE);
+    }
+
+  /* The packet buffer, then the read-ahead buffer of the line which holds
+   * a whole packet, so that receiving one costs a single read().
+   */
+
+  ctx->header = calloc(2, total);
+  if (ctx->header == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ctx->data    = ctx->header + 3;
+  ctx->retries = 0;
+  serxfer_init(&ctx->xfer, ctx->recvfd, ctx->sendfd, ctx->header + total,
+               total);
+  return 0;
+}
+
 static int ymodem_recv_packet(FAR struct ymodem_ctx_s *ctx)
 {
   uint16_t recv_crc;
@@ -215,7 +232,8 @@ recv_packet:
     {
       /* other errors, like ETIMEDOUT, EILSEQ, EBADMSG... */
 
-      tcflush(ctx->recvfd, TCIOFLUSH);
+      serxfer_discard(&ctx->xfer);
+      ctx->xfer.stats.retries++;
       if (++retries > MAX_RETRIES)
         {
           ymodem_debug("recv_file: too many errors, cancel!!\n");
@@ -312,16 +330,24 @@ static int ymodem_recv_cmd(FAR struct ymodem_ctx_s *ctx, uint8_t cmd)
   int ret;
 
   ret = ymodem_recv_buffer(ctx, ctx->header, 1);
-  if (ret < 0)
+  if (ret == -ETIMEDOUT || (ret >= 0 && ctx->header[0] == NAK))
     {
-      ymodem_debug("recv cmd error\n");
-      return ret;
-    }
+      /* Send again, unless the receiver has been gone for too long */
 
-  if (ctx->header[0] == NAK)
-    {
+      if (++ctx->retries > MAX_RETRIES)
+        {
+          ymodem_debug("recv cmd error, too many retries\n");
+          return -ETIMEDOUT;
+        }
+
+      ctx->xfer.stats.retries++;
       return -EAGAIN;
     }
+  else if (ret < 0)
+    {
+      ymodem_debug("recv cmd error\n");
+      return ret;
+    }
 
   if (ctx->header[0] != cmd)
     {
@@ -330,6 +356,7 @@ static int ymodem_recv_cmd(FAR struct ymodem_ctx_s *ctx, uint8_t cmd)
       return -EINVAL;
     }
 
+  ctx->retries = 0;
   return 0;
 }
 
@@ -355,6 +382,10 @@ static int ymodem_send_file(FAR struct ymodem_ctx_s *ctx)
       return -ETIMEDOUT;
     }
 
+  /* Drop the requests the receiver repeated while we were not there */
+
+  serxfer_discard(&ctx->xfer);
+
   ymodem_debug("ymodem send file start\n");
 send_start:
   ctx->packet_type = YMODEM_FILENAME_PACKET;
@@ -377,7 +408,7 @@ send_start:
   ctx->data[ctx->packet_size + 1] = crc;
 
 send_name:
-  ret = ymodem_send_buffer(ctx, ctx->header, 3 + ctx->packet_size + 2);
+  ret = ymodem_send_buffer(ctx, ctx->header, PACKET_TOTAL(ctx->packet_size));
   if (ret < 0)
     {
       ymodem_debug("send name packet error\n");
@@ -441,7 +472,7 @@ send_packet:
   ctx->data[ctx->packet_size] = crc >> 8;
   ctx->data[ctx->packet_size + 1] = crc;
 send_packet_again:
-  ret = ymodem_send_buffer(ctx, ctx->header, 3 + ctx->packet_size + 2);
+  ret = ymodem_send_buffer(ctx, ctx->header, PACKET_TOTAL(ctx->packet_size));
   if (ret < 0)
     {
       ymodem_debug("send data packet error\n");
@@ -515,7 +546,7 @@ send_last:
   ctx->data[ctx->packet_size] = crc >> 8;
   ctx->data[ctx->packet_size + 1] = crc;
 send_last_again:
-  ret = ymodem_send_buffer(ctx, ctx->header, 3 + ctx->packet_size + 2);
+  ret = ymodem_send_buffer(ctx, ctx->header, PACKET_TOTAL(ctx->packet_size));
   if (ret < 0)
     {
       ymodem_debug("send last packet error\n");
@@ -553,21 +584,12 @@ int ymodem_recv(FAR struct ymodem_ctx_s *ctx)
       return -EINVAL;
     }
 
-  if (ctx->custom_size != 0)
-    {
-      ctx->header = calloc(1, 3 + ctx->custom_size + 2);
-    }
-  else
-    {
-      ctx->header = calloc(1, 3 + YMODEM_PACKET_1K_SIZE + 2);
-    }
-
-  if (ctx->header == NULL)
+  ret = ymodem_alloc(ctx);
+  if (ret < 0)
     {
-      return -ENOMEM;
+      return ret;
     }
 
-  ctx->data = ctx->header + 3;
 #ifdef CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH
   ctx->debug_fd = open(CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH,
                        O_CREAT | O_TRUNC | O_WRONLY, 0666);
@@ -581,13 +603,12 @@ int ymodem_recv(FAR struct ymodem_ctx_s *ctx)
   tcgetattr(ctx->recvfd, &term);
   memcpy(&saveterm, &term, sizeof(struct termios));
   cfmakeraw(&term);
-  term.c_cc[VTIME] = 15;
-  term.c_cc[VMIN] = 255;
   tcsetattr(ctx->recvfd, TCSANOW, &term);
 
   ret = ymodem_recv_file(ctx);
 
   tcsetattr(ctx->recvfd, TCSANOW, &saveterm);
+  serxfer_dumpstats(&ctx->xfer, "rb");
 #ifdef CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH
   close(ctx->debug_fd);
 #endif
@@ -607,21 +628,12 @@ int ymodem_send(FAR struct ymodem_ctx_s *ctx)
       return -EINVAL;
     }
 
-  if (ctx->custom_size != 0)
-    {
-      ctx->header = calloc(1, 3 + ctx->custom_size + 2);
-    }
-  else
-    {
-      ctx->header = calloc(1, 3 + YMODEM_PACKET_1K_SIZE + 2);
-    }
-
-  if (ctx->header == NULL)
+  ret = ymodem_alloc(ctx);
+  if (ret < 0)
     {
-      return -ENOMEM;
+      return ret;
     }
 
-  ctx->data = ctx->header + 3;
 #ifdef CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH
   ctx->debug_fd = open(CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH,
                        O_CREAT | O_TRUNC | O_WRONLY, 0666);
@@ -644,6 +656,7 @@ int ymodem_send(FAR struct ymodem_ctx_s *ctx)
     }
 
   tcsetattr(ctx->recvfd, TCSANOW, &saveterm);
+  serxfer_dumpstats(&ctx->xfer, "sb");
 #ifdef CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH
   close(ctx->debug_fd);
 #endif
@@ -27,6 +27,8 @@
 
 #include <stddef.h>
 
+#include "system/serxfer.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -62,6 +64,8 @@ struct ymodem_ctx_s
   /* Private data */
 
   FAR uint8_t *header;
+  struct serxfer_s xfer;
+  int retries;
 #ifdef CONFIG_SYSTEM_YMODEM_DEBUG_FILEPATH
   int debug_fd;
 #endif
@@ -0,0 +1,586 @@
+/****************************************************************************
+ * apps/system/zlib/zstream.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "system/zstream.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef MIN
+#  define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+
+#define ZSTREAM_ALIGN(n)       (((n) + 7) & ~7)
+#define ZSTREAM_BUFSIZE        CONFIG_LIB_ZLIB_STREAM_BUFSIZE
+
+/* The inflater must accept any window, the deflater uses the configured
+ * one.  On top of the window and hash memory, zlib allocates its state
+ * (up to about 7 KiB with 64-bit pointers).
+ */
+
+#define ZSTREAM_INFLATE_WBITS  15
+#define ZSTREAM_DEFLATE_WBITS  CONFIG_LIB_ZLIB_STREAM_WINDOWBITS
+#define ZSTREAM_MEMLEVEL       CONFIG_LIB_ZLIB_STREAM_MEMLEVEL
+#define ZSTREAM_STATESIZE      8192
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: zstream_alloc and zstream_free
+ *
+ * Description:
+ *   zlib memory hooks.  Allocations are carved from the arena of the
+ *   stream, which is released as a whole by zstream_deinit().
+ *
+ ****************************************************************************/
+
+static voidpf zstream_alloc(voidpf opaque, uInt items, uInt size)
+{
+  FAR struct zstream_s *stream = opaque;
+  size_t nbytes = ZSTREAM_ALIGN((size_t)items * size);
+  FAR void *ptr;
+
+  if (nbytes > stream->arenasize - stream->arenaused)
+    {
+      return Z_NULL;
+    }
+
+  ptr = &stream->arena[stream->arenaused];
+  stream->arenaused += nbytes;
+  return ptr;
+}
+
+static void zstream_free(voidpf opaque, voidpf ptr)
+{
+}
+
+/****************************************************************************
+ * Name: zstream_arenasize
+ ****************************************************************************/
+
+static size_t zstream_arenasize(int mode)
+{
+  if ((mode & ZSTREAM_INFLATE) != 0)
+    {
+      return (1 << ZSTREAM_INFLATE_WBITS) + ZSTREAM_STATESIZE;
+    }
+
+  return (1 << (ZSTREAM_DEFLATE_WBITS + 2)) +
+         (1 << (ZSTREAM_MEMLEVEL + 9)) + ZSTREAM_STATESIZE;
+}
+
+/****************************************************************************
+ * Name: zstream_errno
+ ****************************************************************************/
+
+static int zstream_errno(int ret)
+{
+  switch (ret)
+    {
+      case Z_MEM_ERROR:
+        return -ENOMEM;
+
+      case Z_DATA_ERROR:
+      case Z_NEED_DICT:
+        return -EINVAL;
+
+      default:
+        return -EIO;
+    }
+}
+
+/****************************************************************************
+ * Name: zstream_run
+ *
+ * Description:
+ *   Run zlib on the input, appending its output to the output buffer.
+ *
+ * Returned Value:
+ *   The number of bytes of input taken; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static ssize_t zstream_run(FAR struct zstream_s *stream,
+                           FAR const void *buf, size_t len, int flush)
+{
+  FAR z_stream *strm = stream->strm;
+  FAR uint8_t *end;
+  int ret;
+
+  if (stream->outlen == 0)
+    {
+      stream->outptr = stream->outbuf;
+    }
+
+  end             = stream->outptr + stream->outlen;
+  strm->next_in   = (FAR Bytef *)buf;
+  strm->avail_in  = MIN(len, UINT_MAX);
+  strm->next_out  = end;
+  strm->avail_out = &stream->outbuf[ZSTREAM_BUFSIZE] - end;
+
+  if ((stream->mode & ZSTREAM_INFLATE) != 0)
+    {
+      ret = inflate(strm, flush);
+    }
+  else
+    {
+      ret = deflate(strm, flush);
+    }
+
+  stream->outlen += strm->next_out - end;
+
+  /* Z_BUF_ERROR only means that no progress was possible */
+
+  if (ret == Z_STREAM_END)
+    {
+      stream->eof = true;
+    }
+  else if (ret != Z_OK && ret != Z_BUF_ERROR)
+    {
+      stream->error = zstream_errno(ret);
+      return stream->error;
+    }
+
+  return MIN(len, UINT_MAX) - strm->avail_in;
+}
+
+/****************************************************************************
+ * Name: zstream_refill
+ *
+ * Description:
+ *   Produce output without new input once everything was pulled: what the
+ *   inflater could not write yet, or the end of a flush or of the stream.
+ *
+ ****************************************************************************/
+
+static int zstream_refill(FAR struct zstream_s *stream)
+{
+  ssize_t ret = OK;
+
+  if (stream->outlen > 0 || stream->eof)
+    {
+      return OK;
+    }
+
+  if ((stream->mode & ZSTREAM_INFLATE) != 0)
+    {
+      ret = zstream_run(stream, NULL, 0, Z_NO_FLUSH);
+    }
+  else if (stream->finish)
+    {
+      ret = zstream_run(stream, NULL, 0, Z_FINISH);
+    }
+  else if (stream->sync)
+    {
+      ret = zstream_run(stream, NULL, 0, Z_SYNC_FLUSH);
+
+      /* The flush is complete when it did not fill the buffer */
+
+      if (stream->outlen < ZSTREAM_BUFSIZE)
+        {
+          stream->sync = false;
+        }
+    }
+
+  return ret < 0 ? ret : OK;
+}
+
+/****************************************************************************
+ * Name: zstream_write
+ *
+ * Description:
+ *   Write all of the output available to fd.
+ *
+ ****************************************************************************/
+
+static int zstream_write(FAR struct zstream_s *stream, int fd)
+{
+  ssize_t nwritten;
+  int ret;
+
+  for (; ; )
+    {
+      ret = zstream_refill(stream);
+      if (ret < 0 || stream->outlen == 0)
+        {
+          return ret;
+        }
+
+      nwritten = write(fd, stream->outptr, stream->outlen);
+      if (nwritten < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      stream->outptr += nwritten;
+      stream->outlen -= nwritten;
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: zstream_memsize
+ ****************************************************************************/
+
+size_t zstream_memsize(int mode)
+{
+  return ZSTREAM_ALIGN(sizeof(z_stream)) + ZSTREAM_ALIGN(ZSTREAM_BUFSIZE) +
+         zstream_arenasize(mode);
+}
+
+/****************************************************************************
+ * Name: zstream_init
+ ****************************************************************************/
+
+int zstream_init(FAR struct zstream_s *stream, int mode, FAR void *mem)
+{
+  FAR z_stream *strm;
+  FAR uint8_t *ptr;
+  int ret;
+
+  if ((mode & ~(ZSTREAM_INFLATE | ZSTREAM_GZIP)) != 0)
+    {
+      return -EINVAL;
+    }
+
+  memset(stream, 0, sizeof(*stream));
+  stream->mode = mode;
+
+  if (mem == NULL)
+    {
+      mem = malloc(zstream_memsize(mode));
+      if (mem == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      stream->alloc = true;
+    }
+
+  stream->mem       = mem;
+  ptr               = mem;
+  strm              = (FAR z_stream *)ptr;
+  ptr              += ZSTREAM_ALIGN(sizeof(z_stream));
+  stream->outbuf    = ptr;
+  stream->outptr    = ptr;
+  ptr              += ZSTREAM_ALIGN(ZSTREAM_BUFSIZE);
+  stream->arena     = ptr;
+  stream->arenasize = zstream_arenasize(mode);
+
+  memset(strm, 0, sizeof(*strm));
+  strm->zalloc = zstream_alloc;
+  strm->zfree  = zstream_free;
+  strm->opaque = stream;
+
+  if ((mode & ZSTREAM_INFLATE) != 0)
+    {
+      /* Detect a zlib or gzip header */
+
+      ret = inflateInit2(strm, ZSTREAM_INFLATE_WBITS + 32);
+    }
+  else
+    {
+      ret = deflateInit2(strm, CONFIG_LIB_ZLIB_STREAM_LEVEL, Z_DEFLATED,
+                         ZSTREAM_DEFLATE_WBITS +
+                         ((mode & ZSTREAM_GZIP) != 0 ? 16 : 0),
+                         ZSTREAM_MEMLEVEL, Z_DEFAULT_STRATEGY);
+    }
+
+  if (ret != Z_OK)
+    {
+      if (stream->alloc)
+        {
+          free(mem);
+        }
+
+      memset(stream, 0, sizeof(*stream));
+      return zstream_errno(ret);
+    }
+
+  stream->strm = strm;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: zstream_push
+ ****************************************************************************/
+
+ssize_t zstream_push(FAR struct zstream_s *stream,
+                     FAR const void *buf, size_t len)
+{
+  FAR const uint8_t *src = buf;
+  size_t taken = 0;
+  ssize_t ret;
+
+  if (stream->error < 0)
+    {
+      return stream->error;
+    }
+
+  if (stream->finish)
+    {
+      return -EINVAL;
+    }
+
+  /* Finish a flush before compressing more */
+
+  if (stream->sync)
+    {
+      ret = zstream_refill(stream);
+      if (ret < 0 || stream->sync)
+        {
+          return ret;
+        }
+    }
+
+  while (taken < len && !stream->eof &&
+         (stream->outlen == 0 ||
+          stream->outptr + stream->outlen < &stream->outbuf[ZSTREAM_BUFSIZE]))
+    {
+      ret = zstream_run(stream, &src[taken], len - taken, Z_NO_FLUSH);
+      if (ret <= 0)
+        {
+          return ret < 0 ? ret : taken;
+        }
+
+      taken += ret;
+    }
+
+  /* Anything after the end of the compressed stream is ignored */
+
+  return stream->eof ? len : taken;
+}
+
+/****************************************************************************
+ * Name: zstream_pull
+ ****************************************************************************/
+
+ssize_t zstream_pull(FAR struct zstream_s *stream,
+                     FAR void *buf, size_t len)
+{
+  size_t nbytes;
+  int ret;
+
+  if (stream->error < 0)
+    {
+      return stream->error;
+    }
+
+  ret = zstream_refill(stream);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  nbytes = MIN(len, stream->outlen);
+  memcpy(buf, stream->outptr, nbytes);
+  stream->outptr += nbytes;
+  stream->outlen -= nbytes;
+
+  return nbytes;
+}
+
+/****************************************************************************
+ * Name: zstream_flush
+ ****************************************************************************/
+
+int zstream_flush(FAR struct zstream_s *stream)
+{
+  if (stream->finish)
+    {
+      return -EINVAL;
+    }
+
+  if ((stream->mode & ZSTREAM_INFLATE) == 0)
+    {
+      stream->sync = true;
+    }
+
+  return stream->error;
+}
+
+/****************************************************************************
+ * Name: zstream_finish
+ ****************************************************************************/
+
+int zstream_finish(FAR struct zstream_s *stream)
+{
+  stream->finish = true;
+  stream->sync   = false;
+
+  if ((stream->mode & ZSTREAM_INFLATE) != 0 && !stream->eof &&
+      stream->error == 0)
+    {
+      return -EINVAL;
+    }
+
+  return stream->error;
+}
+
+/****************************************************************************
+ * Name: zstream_deinit
+ ****************************************************************************/
+
+void zstream_deinit(FAR struct zstream_s *stream)
+{
+  if (stream->strm != NULL)
+    {
+      if ((stream->mode & ZSTREAM_INFLATE) != 0)
+        {
+          inflateEnd(stream->strm);
+        }
+      else
+        {
+          deflateEnd(stream->strm);
+        }
+    }
+
+  if (stream->alloc)
+    {
+      free(stream->mem);
+    }
+
+  memset(stream, 0, sizeof(*stream));
+}
+
+/****************************************************************************
+ * Name: zstream_gzip_file
+ ****************************************************************************/
+
+int zstream_gzip_file(FAR const char *src, FAR const char *dst)
+{
+  struct zstream_s stream;
+  FAR uint8_t *buf;
+  ssize_t nread;
+  ssize_t taken;
+  ssize_t ret;
+  int infd;
+  int outfd;
+
+  buf = malloc(ZSTREAM_BUFSIZE);
+  if (buf == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ret = zstream_init(&stream, ZSTREAM_DEFLATE | ZSTREAM_GZIP, NULL);
+  if (ret < 0)
+    {
+      goto errout_with_buf;
+    }
+
+  infd = open(src, O_RDONLY | O_CLOEXEC);
+  if (infd < 0)
+    {
+      ret = -errno;
+      goto errout_with_stream;
+    }
+
+  outfd = open(dst, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (outfd < 0)
+    {
+      ret = -errno;
+      goto errout_with_infd;
+    }
+
+  for (; ; )
+    {
+      nread = read(infd, buf, ZSTREAM_BUFSIZE);
+      if (nread < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          ret = -errno;
+          break;
+        }
+
+      if (nread == 0)
+        {
+          zstream_finish(&stream);
+          ret = zstream_write(&stream, outfd);
+          break;
+        }
+
+      /* Empty the output buffer so that each push makes progress */
+
+      for (taken = 0; taken < nread; taken += ret)
+        {
+          ret = zstream_write(&stream, outfd);
+          if (ret < 0)
+            {
+              goto errout_with_outfd;
+            }
+
+          ret = zstream_push(&stream, &buf[taken], nread - taken);
+          if (ret < 0)
+            {
+              goto errout_with_outfd;
+            }
+        }
+    }
+
+errout_with_outfd:
+  if (close(outfd) < 0 && ret >= 0)
+    {
+      ret = -errno;
+    }
+
+  if (ret < 0)
+    {
+      unlink(dst);
+    }
+
+errout_with_infd:
+  close(infd);
+errout_with_stream:
+  zstream_deinit(&stream);
+errout_with_buf:
+  free(buf);
+  return ret < 0 ? ret : OK;
+}
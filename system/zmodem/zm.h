@@ -40,6 +40,7 @@
 #include <nuttx/compiler.h>
 #include <nuttx/ascii.h>
 
+#include "system/serxfer.h"
 #include "system/zmodem.h"
 
 /****************************************************************************
@@ -186,12 +187,10 @@
 #define ZM_FLAG_CRC32     (1 << 0)   /* Use 32-bit CRC */
 #define ZM_FLAG_CRKOK     (1 << 1)   /* CRC is okay */
 #define ZM_FLAG_EOF       (1 << 2)   /* End of file reached */
-#define ZM_FLAG_ATSIGN    (1 << 3)   /* Last char was '@' */
 #define ZM_FLAG_ESCCTRL   (1 << 4)   /* Other end requests ctrl chars be escaped */
 #define ZM_FLAG_ESC       (1 << 5)   /* Next character is escaped */
 #define ZM_FLAG_WAIT      (1 << 6)   /* Next send should wait */
 #define ZM_FLAG_APPEND    (1 << 7)   /* Append to the existing file */
-#define ZM_FLAG_TIMEOUT   (1 << 8)   /* A timeout has been detected */
 #define ZM_FLAG_OO        (1 << 9)   /* "OO" may be received */
 
 /* The Zmodem parser success/error return code definitions:
@@ -329,8 +328,9 @@ struct zm_state_s
   uint16_t pktlen;           /* Number valid bytes in pktbuf[] */
   uint16_t flags;            /* See ZM_FLAG_* definitions */
   uint16_t nerrors;          /* Number of data errors */
-  timer_t  timer;            /* Watchdog timer */
   int      remfd;            /* The R/W file descritor used for communication with remote */
+  struct serxfer_s xfer;     /* I/O and statistics of the remote line */
+  struct serxfer_esc_s esc;  /* ZDLE escaping of data sent */
 
   /* Buffers.
    *
@@ -403,6 +403,9 @@ struct zms_state_s
   FAR const char *rfilename; /* Remote filename */
   off_t offset;              /* Current file offset */
   off_t lastoffs;            /* Last acknowledged file offset */
+#if CONFIG_SYSTEM_ZMODEM_WINDOW > 0
+  off_t qoffs;               /* File offset of the last ZCRCQ */
+#endif
   off_t zrpos;               /* Last offset from ZRPOS */
   off_t filesize;            /* Size of the file to send */
   int infd;                  /* Local input file descriptor */
@@ -536,9 +539,10 @@ ssize_t zm_write(int fd, FAR const uint8_t *buffer, size_t buflen);
  ****************************************************************************/
 
 #ifdef CONFIG_SYSTEM_ZMODEM_DUMPBUFFER
-ssize_t zm_remwrite(int fd, FAR const uint8_t *buffer, size_t buflen);
+ssize_t zm_remwrite(FAR struct zm_state_s *pzm, FAR const uint8_t *buffer,
+                    size_t buflen);
 #else
-#  define zm_remwrite(f,b,s) zm_write(f,b,s)
+#  define zm_remwrite(p,b,s) serxfer_write(&(p)->xfer,b,s)
 #endif
 
 /****************************************************************************
@@ -591,6 +595,16 @@ void zm_rawmode(int fd);
 void zm_flowc(int fd);
 #endif
 
+/****************************************************************************
+ * Name: zm_escinit
+ *
+ * Description:
+ *   Set up ZDLE escaping of the data sent, after ZM_FLAG_ESCCTRL changed.
+ *
+ ****************************************************************************/
+
+void zm_escinit(FAR struct zm_state_s *pzm);
+
 /****************************************************************************
  * Name: zm_putzdle
  *
@@ -753,47 +767,6 @@ int zm_timeout(FAR struct zm_state_s *pzm);
 bool zm_rcvpending(FAR struct zm_state_s *pzm);
 #endif
 
-/****************************************************************************
- * Name:  zm_timerinit
- *
- * Description:
- *   Create the POSIX timer used to manage timeouts and attach the SIGALRM
- *   signal handler to catch the timeout events.
- *
- ****************************************************************************/
-
-int zm_timerinit(FAR struct zm_state_s *pzm);
-
-/****************************************************************************
- * Name:  zm_timerstart
- *
- * Description:
- *   Start, restart, or stop the timer.
- *
- ****************************************************************************/
-
-int zm_timerstart(FAR struct zm_state_s *pzm, unsigned int sec);
-
-/****************************************************************************
- * Name:  zm_timerstop
- *
- * Description:
- *   Stop the timer.
- *
- ****************************************************************************/
-
-#define zm_timerstop(p) zm_timerstart(p,0)
-
-/****************************************************************************
- * Name:  zm_timerrelease
- *
- * Description:
- *   Destroy the timer and and detach the signal handler.
- *
- ****************************************************************************/
-
-int zm_timerrelease(FAR struct zm_state_s *pzm);
-
 /****************************************************************************
  * Name:  zm_dumpbuffer
  *
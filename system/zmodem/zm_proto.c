@@ -70,76 +70,64 @@ const uint8_t g_canistr[CANISTR_SIZE] =
  ****************************************************************************/
 
 /****************************************************************************
- * Name: zm_putzdle
+ * Name: zm_escinit
  *
  * Description:
- *   Transfer a value to a buffer performing ZDLE escaping if necessary.
- *
- * Input Parameters:
- *   pzm - Zmodem session state
- *   buffer - Buffer in which to add the possibly escaped character
- *   ch - The raw, unescaped character to be added
+ *   Set up ZDLE escaping of the data sent, after ZM_FLAG_ESCCTRL changed.
  *
  ****************************************************************************/
 
-FAR uint8_t *zm_putzdle(FAR struct zm_state_s *pzm, FAR uint8_t *buffer,
-                        uint8_t ch)
+void zm_escinit(FAR struct zm_state_s *pzm)
 {
-  uint8_t ch7 = ch & 0x7f;
+  FAR uint8_t *map = pzm->esc.map;
+  int ch;
+
+  serxfer_escinit(&pzm->esc, ZDLE, '@');
 
-  /* Check if this character requires ZDLE escaping.
-   *
-   * The Zmodem protocol requires that CAN(ZDLE), DLE, XON, XOFF and a CR
+  /* The Zmodem protocol requires that CAN(ZDLE), DLE, XON, XOFF and a CR
    * following '@' be escaped.
    */
 
-  if (ch   == ZDLE ||
-      ch7  == ASCII_DLE ||
-      ch7  == ASCII_DC1 ||
-      ch7  == ASCII_DC3 ||
-      ch7  == ASCII_GS ||
-      (ch7 == '\r' && (pzm->flags & ZM_FLAG_ATSIGN)  != 0) ||
-      (ch7 <  ' '  && (pzm->flags & ZM_FLAG_ESCCTRL) != 0) ||
-      ch7  == ASCII_DEL ||
-      ch   == 0xff
-      )
+  for (ch = 0; ch < 256; ch++)
     {
-      /* Yes... save the data link escape the character */
-
-      *buffer++ = ZDLE;
-
-      /* And modify the character itself as appropriate  */
-
-      if (ch == ASCII_DEL)
+      uint8_t ch7 = ch & 0x7f;
+
+      if (ch   == ZDLE ||
+          ch7  == ASCII_DLE ||
+          ch7  == ASCII_DC1 ||
+          ch7  == ASCII_DC3 ||
+          ch7  == ASCII_GS ||
+          (ch7 <  ' '  && (pzm->flags & ZM_FLAG_ESCCTRL) != 0))
         {
-          ch = ZRUB0;
+          map[ch] = ch ^ 0x40;
         }
-      else if (ch == 0xff)
+      else if (ch7 == '\r')
         {
-          ch = ZRUB1;
-        }
-      else
-        {
-          ch ^= 0x40;
+          map[ch] = SERXFER_ESC_LEAD;
         }
     }
 
-  /* Save the possibly escaped character */
-
-  *buffer++ = ch;
-
-  /* Check if the character is the AT sign */
+  map[ASCII_DEL] = ZRUB0;
+  map[0xff]      = ZRUB1;
+}
 
-  if (ch7 == '@')
-    {
-      pzm->flags |= ZM_FLAG_ATSIGN;
-    }
-  else
-    {
-      pzm->flags &= ~ZM_FLAG_ATSIGN;
-    }
+/****************************************************************************
+ * Name: zm_putzdle
+ *
+ * Description:
+ *   Transfer a value to a buffer performing ZDLE escaping if necessary.
+ *
+ * Input Parameters:
+ *   pzm - Zmodem session state
+ *   buffer - Buffer in which to add the possibly escaped character
+ *   ch - The raw, unescaped character to be added
+ *
+ ****************************************************************************/
 
-  return buffer;
+FAR uint8_t *zm_putzdle(FAR struct zm_state_s *pzm, FAR uint8_t *buffer,
+                        uint8_t ch)
+{
+  return buffer + serxfer_escape(&pzm->esc, buffer, 2, &ch, 1, NULL);
 }
 
 /****************************************************************************
@@ -183,21 +171,22 @@ int zm_senddata(FAR struct zm_state_s *pzm, FAR const uint8_t *buffer,
   zmdbg("zbin=%c, buflen=%zu, term=%c flags=%04x\n",
         zbin, buflen, term, pzm->flags);
 
-  /* Transfer the data to the I/O buffer, accumulating the CRC */
+  /* Accumulate the CRC of the data, then transfer the data to the I/O
+   * buffer.
+   */
 
-  while (buflen-- > 0)
+  if (zbin == ZBIN)
     {
-      if (zbin == ZBIN)
-        {
-          crc = (uint32_t)crc16part(buffer, 1, (uint16_t)crc);
-        }
-      else /* zbin = ZBIN32 */
-        {
-          crc = crc32part(buffer, 1, crc);
-        }
-
-      ptr = zm_putzdle(pzm, ptr, *buffer++);
+      crc = (uint32_t)crc16part(buffer, buflen, (uint16_t)crc);
     }
+  else /* zbin = ZBIN32 */
+    {
+      crc = crc32part(buffer, buflen, crc);
+    }
+
+  ptr += serxfer_escape(&pzm->esc, ptr,
+                        &pzm->scratch[CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE] - ptr,
+                        buffer, buflen, NULL);
 
   /* Trasnfer the data link escape character (without updating the CRC) */
 
@@ -234,7 +223,7 @@ int zm_senddata(FAR struct zm_state_s *pzm, FAR const uint8_t *buffer,
 
   /* Send the header */
 
-  nwritten = zm_remwrite(pzm->remfd, pzm->scratch, ptr - pzm->scratch);
+  nwritten = zm_remwrite(pzm, pzm->scratch, ptr - pzm->scratch);
   return nwritten < 0 ? (int)nwritten : OK;
 }
 
@@ -311,7 +300,7 @@ int zm_sendhexhdr(FAR struct zm_state_s *pzm, int type,
 
   /* Send the header */
 
-  nwritten = zm_remwrite(pzm->remfd, pzm->scratch, ptr - pzm->scratch);
+  nwritten = zm_remwrite(pzm, pzm->scratch, ptr - pzm->scratch);
   return nwritten < 0 ? (int)nwritten : OK;
 }
 
@@ -376,7 +365,7 @@ int zm_sendbin16hdr(FAR struct zm_state_s *pzm, int type,
   /* Send the header */
 
   buflen   = ptr - pzm->scratch;
-  nwritten = zm_remwrite(pzm->remfd, pzm->scratch, buflen);
+  nwritten = zm_remwrite(pzm, pzm->scratch, buflen);
   return nwritten < 0 ? (int)nwritten : OK;
 }
 
@@ -444,7 +433,7 @@ int zm_sendbin32hdr(FAR struct zm_state_s *pzm, int type,
   /* Send the header */
 
   buflen   = ptr - pzm->scratch;
-  nwritten = zm_remwrite(pzm->remfd, pzm->scratch, buflen);
+  nwritten = zm_remwrite(pzm, pzm->scratch, buflen);
   return nwritten < 0 ? (int)nwritten : OK;
 }
 
@@ -350,6 +350,8 @@ static int zmr_zsinit(FAR struct zm_state_s *pzm)
       pzm->flags |= ZM_FLAG_ESCCTRL;
     }
 
+  zm_escinit(pzm);
+
   /* Setup to receive a data packet.  Enter PSTATE_DATA */
 
   zm_readstate(pzm);
@@ -720,6 +722,7 @@ static int zmr_filedata(FAR struct zm_state_s *pzm)
       /* No.. increment the count of errors */
 
       pzm->nerrors++;
+      pzm->xfer.stats.retries++;
       zmdbg("%d data errors\n", pzm->nerrors);
 
       /* If the count of errors exceeds the configurable limit, then cancel
@@ -733,7 +736,7 @@ static int zmr_filedata(FAR struct zm_state_s *pzm)
 
           /* Send the cancel string */
 
-          zm_remwrite(pzm->remfd, g_canistr, CANISTR_SIZE);
+          zm_remwrite(pzm, g_canistr, CANISTR_SIZE);
 
           /* Enter PSTATE_DATA */
 
@@ -1534,7 +1537,7 @@ static int zmr_fileerror(FAR struct zmr_state_s *pzmr, uint8_t type,
       *dest++ = '\0';
 
       len = strlen((FAR char *)pzmr->cmn.pktbuf);
-      nwritten = zm_remwrite(pzmr->cmn.remfd, pzmr->cmn.pktbuf, len);
+      nwritten = zm_remwrite(&pzmr->cmn, pzmr->cmn.pktbuf, len);
       if (nwritten < 0)
         {
           zmdbg("ERROR: zm_remwrite failed: %d\n", (int)nwritten);
@@ -1604,7 +1607,6 @@ ZMRHANDLE zmr_initialize(int remfd)
 {
   FAR struct zmr_state_s *pzmr;
   FAR struct zm_state_s *pzm;
-  int ret;
 
   /* Allocate a new Zmodem receive state structure */
 
@@ -1622,15 +1624,8 @@ ZMRHANDLE zmr_initialize(int remfd)
       pzmr->rcaps    = CANFC32 | CANFDX;
       pzmr->outfd    = -1;
 
-      /* Create a timer to handle timeout events */
-
-      ret = zm_timerinit(pzm);
-      if (ret < 0)
-        {
-          zmdbg("ERROR: zm_timerinit failed: %d\n", ret);
-          free(pzmr);
-          return NULL;
-        }
+      serxfer_init(&pzm->xfer, remfd, remfd, NULL, 0);
+      zm_escinit(pzm);
 
       /* Note that no action is taken now... a timeout of zero is set
        * (because of the memset).  If there is nothing pending, ZRINIT
@@ -1700,9 +1695,7 @@ int zmr_release(ZMRHANDLE handle)
   ret = zm_sendhexhdr(&pzmr->cmn, ZFIN, g_zeroes);
   zmdbg("ZMR_STATE %d: Send ZFIN\n", pzmr->cmn.state);
 
-  /* Release the timer resources */
-
-  zm_timerrelease(&pzmr->cmn);
+  serxfer_dumpstats(&pzmr->cmn.xfer, "rz");
 
   /* Clean up any resources that may be held from the last file transfer */
 
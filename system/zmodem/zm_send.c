@@ -137,13 +137,17 @@ static int zms_sendfiledata(FAR struct zm_state_s *pzm);
 static int zms_sendpacket(FAR struct zm_state_s *pzm);
 static int zms_filecrc(FAR struct zm_state_s *pzm);
 static int zms_sendwaitack(FAR struct zm_state_s *pzm);
+static int zms_sendack(FAR struct zm_state_s *pzm);
+static int zms_sendtimeout(FAR struct zm_state_s *pzm);
 static int zms_sendnak(FAR struct zm_state_s *pzm);
 static int zms_sendrpos(FAR struct zm_state_s *pzm);
+static int zms_streamrpos(FAR struct zm_state_s *pzm);
 static int zms_senddoneack(FAR struct zm_state_s *pzm);
 static int zms_resendeof(FAR struct zm_state_s *pzm);
 static int zms_xfrdone(FAR struct zm_state_s *pzm);
 static int zms_finish(FAR struct zm_state_s *pzm);
 static int zms_timeout(FAR struct zm_state_s *pzm);
+static int zms_waittimeout(FAR struct zm_state_s *pzm);
 static int zms_cmdto(FAR struct zm_state_s *pzm);
 static int zms_doneto(FAR struct zm_state_s *pzm);
 static int zms_error(FAR struct zm_state_s *pzm);
@@ -249,14 +253,14 @@ static const struct zm_transition_s g_zms_crcwait[] =
 static const struct zm_transition_s g_zmr_sending[] =
 {
   {ZME_SINIT,     false, ZMS_START,    zms_attention},
-  {ZME_ACK,       false, ZMS_SENDING,  zms_sendpacket},
-  {ZME_RPOS,      true,  ZMS_SENDING,  zms_sendrpos},
+  {ZME_ACK,       false, ZMS_SENDING,  zms_sendack},
+  {ZME_RPOS,      true,  ZMS_SENDING,  zms_streamrpos},
   {ZME_SKIP,      true,  ZMS_FILEWAIT, zms_fileskip},
   {ZME_NAK,       true,  ZMS_SENDING,  zms_sendnak},
   {ZME_RINIT,     true,  ZMS_FILEWAIT, zms_sendfilename},
   {ZME_ABORT,     true,  ZMS_FINISH,   zms_abort},
   {ZME_FERR,      true,  ZMS_FINISH,   zms_abort},
-  {ZME_TIMEOUT,   false, ZMS_SENDING,  zms_sendpacket},
+  {ZME_TIMEOUT,   false, ZMS_SENDING,  zms_sendtimeout},
   {ZME_ERROR,     false, ZMS_SENDING,  zms_error},
 };
 
@@ -272,7 +276,7 @@ static const struct zm_transition_s g_zms_sendwait[] =
   {ZME_RINIT,     true,  ZMS_FILEWAIT, zms_sendfilename},
   {ZME_ABORT,     true,  ZMS_FINISH,   zms_abort},
   {ZME_FERR,      true,  ZMS_FINISH,   zms_abort},
-  {ZME_TIMEOUT,   false, ZMS_SENDWAIT, zms_timeout},
+  {ZME_TIMEOUT,   false, ZMS_SENDWAIT, zms_waittimeout},
   {ZME_ERROR,     false, ZMS_SENDWAIT, zms_error},
 };
 
@@ -421,6 +425,7 @@ static int zms_zrinit(FAR struct zm_state_s *pzm)
   if ((rcaps & ESCCTL) != 0)
     {
       pzm->flags |= ZM_FLAG_ESCCTRL;
+      zm_escinit(pzm);
     }
 
   /* Check if the receiver supports full-duplex streaming
@@ -861,8 +866,13 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
   uint8_t *ptr;
   uint8_t type;
   bool wait = false;
+#ifdef CONFIG_SYSTEM_ZMODEM_SNDFILEBUF
+  ssize_t nread;
+  size_t nused;
+#endif
   int sndsize;
   int pktsize;
+  int nbytes;
   int i;
 
   /* Loop, sending packets while we can if the receiver supports streaming
@@ -896,20 +906,33 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
            * would that exceed recvmax?
            */
 
-          if (sndsize + unacked > pzms->rcvmax)
+          if (sndsize + unacked >= pzms->rcvmax)
             {
-              /* Yes... clip the maximum so that we stay within that limit */
+              /* Yes... clip the maximum so that we stay within that limit.
+               * The subpacket that fills the receiver buffer ends with
+               * ZCRCW.
+               */
 
-              int maximum = pzms->rcvmax - unacked;
-              if (sndsize < maximum)
-                {
-                  sndsize = maximum;
-                }
-
-              wait = true;
+              sndsize = pzms->rcvmax - unacked;
+              wait    = true;
               zmdbg("Clipped sndsize: %d\n", sndsize);
             }
         }
+#if CONFIG_SYSTEM_ZMODEM_WINDOW > 0
+      else if (pzms->dpkttype == ZCRCG &&
+               unacked >= CONFIG_SYSTEM_ZMODEM_WINDOW)
+        {
+          /* The window is full.  Keep the frame open and wait for the ZACK
+           * to one of the ZCRCQ subpackets sent since lastoffs.
+           */
+
+          zmdbg("ZMS_STATE %d: Window full\n", pzm->state);
+
+          pzm->state   = ZMS_SENDING;
+          pzm->timeout = CONFIG_SYSTEM_ZMODEM_RESPTIME;
+          return OK;
+        }
+#endif
 
       /* Can we send anything? */
 
@@ -951,44 +974,96 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
           type = ZCRCW;
           pzm->flags &= ~ZM_FLAG_WAIT;
         }
-      else if (wait)
+      else if (pzms->rcvmax != 0)
         {
-          type = ZCRCW;
+          /* Subpackets stream until the receiver buffer is full */
+
+          type = ZCRCG;
         }
       else
         {
           type = pzms->dpkttype;
         }
 
+#if CONFIG_SYSTEM_ZMODEM_WINDOW > 0
+      /* Ask for a ZACK a few times per window so that the window keeps
+       * moving while streaming.
+       */
+
+      if (type == ZCRCG && pzms->rcvmax == 0 &&
+          pzms->offset - pzms->qoffs >= CONFIG_SYSTEM_ZMODEM_WINDOW / 4)
+        {
+          type         = ZCRCQ;
+          pzms->qoffs  = pzms->offset;
+        }
+#endif
+
+      if (sndsize > CONFIG_SYSTEM_ZMODEM_SUBPKTSIZE)
+        {
+          sndsize = CONFIG_SYSTEM_ZMODEM_SUBPKTSIZE;
+          wait    = false;
+        }
+
       /* Read characters from file and put into buffer until buffer is full
        * or file is exhausted
        */
 
-      bcrc32      = ((pzm->flags & ZM_FLAG_CRC32) != 0);
-      crc         = bcrc32 ? 0xffffffff : 0;
-      pzm->flags &= ~ZM_FLAG_ATSIGN;
+      bcrc32        = ((pzm->flags & ZM_FLAG_CRC32) != 0);
+      crc           = bcrc32 ? 0xffffffff : 0;
+      pzm->esc.last = 0;
 
-      ptr         = pzm->scratch;
-      pktsize     = 0;
+      ptr           = pzm->scratch;
+      pktsize       = 0;
+      nbytes        = 0;
 
 #ifdef CONFIG_SYSTEM_ZMODEM_SNDFILEBUF
       /* Read multiple bytes of file and store into the temporal buffer */
 
-      zm_read(pzms->infd, pzm->filebuf, CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE);
+      nread = zm_read(pzms->infd, pzm->filebuf,
+                      sndsize < CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE ?
+                      sndsize : CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE);
+      if (nread < 0)
+        {
+          return (int)nread;
+        }
 
-      i = 0;
-#endif
+      /* Escape as much of it as fits as one buffer.  Leave room for ZDLE,
+       * the type and an escaped 4-byte CRC.
+       */
+
+      pktsize = serxfer_escape(&pzm->esc, ptr,
+                               CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE - 10,
+                               pzm->filebuf, nread, &nused);
+      ptr          += pktsize;
+      nbytes        = nused;
+      pzms->offset += nbytes;
+
+      /* The CRC of the bytes that went into the subpacket, in one call */
 
-      while (pktsize <= (CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE - 10) &&
-             (pzms->offset < pzms->filesize))
+      if (!bcrc32)
         {
-          /* Add the new value to the accumulated CRC */
+          crc = (uint32_t)crc16part(pzm->filebuf, nbytes, (uint16_t)crc);
+        }
+      else
+        {
+          crc = crc32part(pzm->filebuf, nbytes, crc);
+        }
 
-#ifdef CONFIG_SYSTEM_ZMODEM_SNDFILEBUF
-          uint8_t ch = pzm->filebuf[i++];
+      /* Restore file position to be read next time */
+
+      lseek(pzms->infd, pzms->offset, SEEK_SET);
 #else
+      /* Leave room for one more escaped character, ZDLE, the type and an
+       * escaped 4-byte CRC.
+       */
+
+      while (pktsize < (CONFIG_SYSTEM_ZMODEM_SNDBUFSIZE - 13) &&
+             nbytes < sndsize)
+        {
           uint8_t ch = zm_getc(pzms->infd);
-#endif
+
+          /* Add the new value to the accumulated CRC */
+
           if (!bcrc32)
             {
               crc = (uint32_t)crc16part(&ch, 1, (uint16_t)crc);
@@ -1011,13 +1086,22 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
           /* And increment the file offset */
 
           pzms->offset++;
+          nbytes++;
         }
+#endif
 
-#ifdef CONFIG_SYSTEM_ZMODEM_SNDFILEBUF
-      /* Restore file position to be read next time */
+      /* The subpacket that fills the receiver buffer ends with ZCRCW.
+       * Escaping may have ended this one before it got there.
+       */
 
-      lseek(pzms->infd, pzms->offset, SEEK_SET);
-#endif
+      if (wait && nbytes == sndsize)
+        {
+          type = ZCRCW;
+        }
+      else
+        {
+          wait = false;
+        }
 
       /* If we've reached file end, a ZEOF header will follow.  If there's
        * room in the outgoing buffer for it, end the packet with ZCRCE and
@@ -1084,7 +1168,7 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
       zmdbg("Sending %d bytes. New offset: %ld\n",
             pktsize, (unsigned long)pzms->offset);
 
-      nwritten = zm_remwrite(pzm->remfd, pzm->scratch, pktsize);
+      nwritten = zm_remwrite(pzm, pzm->scratch, pktsize);
       if (nwritten < 0)
         {
           zmdbg("ERROR: zm_remwrite failed: %d\n", (int)nwritten);
@@ -1137,8 +1221,17 @@ static int zms_sendpacket(FAR struct zm_state_s *pzm)
     }
 #ifdef CONFIG_SYSTEM_ZMODEM_RCVSAMPLE
   while (pzm->state == ZMS_SENDING && !zm_rcvpending(pzm));
+
+  if (pzm->state == ZMS_SENDING)
+    {
+      /* Streaming stopped for data from the receiver.  If that does not
+       * make up a header, continue streaming soon.
+       */
+
+      pzm->timeout = 1;
+    }
 #else
-  while (0);
+  while (type == ZCRCG);
 #endif
 
   return OK;
@@ -1187,6 +1280,18 @@ static int zms_sendwaitack(FAR struct zm_state_s *pzm)
 
   offset = zm_bytobe32(pzm->hdrdata + 1);
 
+  /* ZACKs to ZCRCQ subpackets streamed before may still arrive.  The ZACK
+   * to the ZCRCW subpacket has the current offset.
+   */
+
+  if (offset != pzms->offset)
+    {
+      zmdbg("ZMS_STATE %d: Ignore ZACK %ld\n",
+            pzm->state, (unsigned long)offset);
+      pzm->state = ZMS_SENDWAIT;
+      return OK;
+    }
+
   if (offset > pzms->lastoffs)
     {
       pzms->lastoffs = offset;
@@ -1206,6 +1311,66 @@ static int zms_sendwaitack(FAR struct zm_state_s *pzm)
   return zms_sendpacket(pzm);
 }
 
+/****************************************************************************
+ * Name: zms_sendack
+ *
+ * Description:
+ *   An ACK to a ZCRCQ arrived while streaming.  Update last known receiver
+ *   offset and continue the frame.
+ *
+ ****************************************************************************/
+
+static int zms_sendack(FAR struct zm_state_s *pzm)
+{
+  FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
+  off_t offset;
+
+  offset = zm_bytobe32(pzm->hdrdata + 1);
+  if (offset > pzms->lastoffs && offset <= pzms->offset)
+    {
+      pzms->lastoffs = offset;
+    }
+
+  zmdbg("ZMS_STATE %d: offset: %ld\n", pzm->state, (unsigned long)offset);
+  return zms_sendpacket(pzm);
+}
+
+/****************************************************************************
+ * Name: zms_sendtimeout
+ *
+ * Description:
+ *   Timeout while streaming.  Either streaming stopped for data that did
+ *   not make up a header, or no ZACK came to open a full window.  In the
+ *   latter case, end the frame with an empty ZCRCW subpacket: the ZACK to
+ *   it tells where the receiver is.
+ *
+ ****************************************************************************/
+
+static int zms_sendtimeout(FAR struct zm_state_s *pzm)
+{
+#if CONFIG_SYSTEM_ZMODEM_WINDOW > 0
+  FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
+
+  if (pzms->dpkttype == ZCRCG && pzms->rcvmax == 0 &&
+      pzms->offset - pzms->lastoffs >= CONFIG_SYSTEM_ZMODEM_WINDOW)
+    {
+      zmdbg("ZMS_STATE %d: No ZACK, nerrors %d\n",
+            pzm->state, pzm->nerrors);
+
+      if (++pzm->nerrors > CONFIG_SYSTEM_ZMODEM_MAXERRORS)
+        {
+          return -ETIMEDOUT;
+        }
+
+      pzm->state   = ZMS_SENDWAIT;
+      pzm->timeout = CONFIG_SYSTEM_ZMODEM_RESPTIME;
+      return zm_senddata(pzm, NULL, 0);
+    }
+#endif
+
+  return zms_sendpacket(pzm);
+}
+
 /****************************************************************************
  * Name: zms_sendnak
  *
@@ -1217,11 +1382,19 @@ static int zms_sendwaitack(FAR struct zm_state_s *pzm)
 static int zms_sendnak(FAR struct zm_state_s *pzm)
 {
   FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
+  uint8_t by[4];
   off_t offset;
+  int ret;
+
+  pzm->xfer.stats.retries++;
 
   /* Save the ZRPOS file offset */
 
-  pzms->offset = pzms->zrpos;
+  pzms->offset   = pzms->zrpos;
+  pzms->lastoffs = pzms->zrpos;
+#if CONFIG_SYSTEM_ZMODEM_WINDOW > 0
+  pzms->qoffs    = pzms->zrpos;
+#endif
 
   /* TODO: What is the correct thing to do if lseek fails? Send ZEOF? */
 
@@ -1239,6 +1412,19 @@ static int zms_sendnak(FAR struct zm_state_s *pzm)
   zmdbg("ZMS_STATE %d: offset: %ld\n",
         pzm->state, (unsigned long)pzms->offset);
 
+  /* The receiver did not get the ZDATA header, so send it again.  Wait for
+   * the ZACK to the first subpacket before streaming on: the NAK may be for
+   * data that was still on its way.
+   */
+
+  pzm->flags |= ZM_FLAG_WAIT;
+  zm_be32toby(pzms->offset, by);
+  ret = zm_sendbinhdr(pzm, ZDATA, by);
+  if (ret != OK)
+    {
+      return ret;
+    }
+
   return zms_sendpacket(pzm);
 }
 
@@ -1255,10 +1441,34 @@ static int zms_sendrpos(FAR struct zm_state_s *pzm)
   FAR struct zms_state_s *pzms = (FAR struct zms_state_s *)pzm;
 
   pzm->nerrors++;
+  pzm->xfer.stats.retries++;
   pzm->flags |= ZM_FLAG_WAIT;
   return zms_startfiledata(pzms);
 }
 
+/****************************************************************************
+ * Name: zms_streamrpos
+ *
+ * Description:
+ *   Received ZRPOS while streaming.  The frame is still open, end it first:
+ *   a receiver still in step would otherwise take the new ZDATA header as
+ *   data.
+ *
+ ****************************************************************************/
+
+static int zms_streamrpos(FAR struct zm_state_s *pzm)
+{
+  int ret;
+
+  ret = zm_senddata(pzm, NULL, 0);
+  if (ret != OK)
+    {
+      return ret;
+    }
+
+  return zms_sendrpos(pzm);
+}
+
 /****************************************************************************
  * Name: zms_senddoneack
  *
@@ -1354,6 +1564,29 @@ static int zms_timeout(FAR struct zm_state_s *pzm)
   return -ETIMEDOUT;
 }
 
+/****************************************************************************
+ * Name: zms_waittimeout
+ *
+ * Description:
+ *   Timed out waiting for the ZACK to a ZCRCW subpacket.  The end of the
+ *   subpacket may have been lost, so end the frame again.  The receiver
+ *   then either sends the ZACK or finds a bad CRC and sends ZRPOS.
+ *
+ ****************************************************************************/
+
+static int zms_waittimeout(FAR struct zm_state_s *pzm)
+{
+  zmdbg("ZMS_STATE %d: No ZACK, nerrors %d\n", pzm->state, pzm->nerrors);
+
+  if (++pzm->nerrors > CONFIG_SYSTEM_ZMODEM_MAXERRORS)
+    {
+      zmdbg("ERROR: Receiver did not respond\n");
+      return -ETIMEDOUT;
+    }
+
+  return zm_senddata(pzm, NULL, 0);
+}
+
 /****************************************************************************
  * Name: zms_cmdto
  *
@@ -1422,6 +1655,9 @@ static int zms_startfiledata(FAR struct zms_state_s *pzms)
   pzms->zrpos      = zm_bytobe32(pzms->cmn.hdrdata + 1);
   pzms->offset     = pzms->zrpos;
   pzms->lastoffs   = pzms->zrpos;
+#if CONFIG_SYSTEM_ZMODEM_WINDOW > 0
+  pzms->qoffs      = pzms->zrpos;
+#endif
 
   /* See to the requested file position */
 
@@ -1579,14 +1815,8 @@ ZMSHANDLE zms_initialize(int remfd)
       pzm->psubstate = PIDLE_ZPAD;
       pzm->remfd     = remfd;
 
-      /* Create a timer to handle timeout events */
-
-      ret = zm_timerinit(pzm);
-      if (ret < 0)
-        {
-          zmdbg("ERROR: zm_timerinit failed: %d\n", ret);
-          goto errout;
-        }
+      serxfer_init(&pzm->xfer, remfd, remfd, NULL, 0);
+      zm_escinit(pzm);
 
       /* Send "rz\r" to the remote end.
        *
@@ -1596,11 +1826,11 @@ ZMSHANDLE zms_initialize(int remfd)
        * or command if it were not already active.
        */
 
-      nwritten = zm_remwrite(pzm->remfd, (FAR uint8_t *)"rz\r", 3);
+      nwritten = zm_remwrite(pzm, (FAR uint8_t *)"rz\r", 3);
       if (nwritten < 0)
         {
           zmdbg("ERROR: zm_remwrite failed: %d\n", (int)nwritten);
-          goto errout_with_timer;
+          goto errout;
         }
 
       /* Send ZRQINIT
@@ -1614,7 +1844,7 @@ ZMSHANDLE zms_initialize(int remfd)
       if (ret < 0)
         {
           zmdbg("ERROR: zm_sendhexhdr failed: %d\n", ret);
-          goto errout_with_timer;
+          goto errout;
         }
 
       /* Set up a timeout for the response */
@@ -1632,14 +1862,12 @@ ZMSHANDLE zms_initialize(int remfd)
       if (ret < 0)
         {
           zmdbg("ERROR: zm_datapump failed: %d\n", ret);
-          goto errout_with_timer;
+          goto errout;
         }
     }
 
   return (ZMSHANDLE)pzms;
 
-errout_with_timer:
-  zm_timerrelease(&pzms->cmn);
 errout:
   free(pzms);
   return NULL;
@@ -1722,16 +1950,14 @@ int zms_release(ZMSHANDLE handle)
 
   /* Send "OO" */
 
-  nwritten = zm_remwrite(pzms->cmn.remfd, (FAR const uint8_t *)"OO", 2);
+  nwritten = zm_remwrite(&pzms->cmn, (FAR const uint8_t *)"OO", 2);
   if (nwritten < 0)
     {
       zmdbg("ERROR: zm_remwrite failed: %d\n", (int)nwritten);
       ret = (int)nwritten;
     }
 
-  /* Release the timer resources */
-
-  zm_timerrelease(&pzms->cmn);
+  serxfer_dumpstats(&pzms->cmn.xfer, "sz");
 
   /* Make sure that the file is closed */
 
@@ -44,7 +44,6 @@
 #include <ctype.h>
 #include <ctype.h>
 #include <fcntl.h>
-#include <sched.h>
 #include <assert.h>
 #include <errno.h>
 
@@ -645,7 +644,18 @@ static int zm_data(FAR struct zm_state_s *pzm, uint8_t ch)
             pzm->pkttype, pzm->ncrc);
       zmdbg("        rcvlen=%d rcvndx=%d\n",
             pzm->rcvlen, pzm->rcvndx);
-      return -ENOSPC;
+
+      /* When streaming, this is most likely a subpacket whose end was
+       * lost.  Handle it like a CRC failure so that it is sent again.
+       */
+
+      pzm->pstate    = PSTATE_IDLE;
+      pzm->psubstate = PIDLE_ZPAD;
+      pzm->flags    &= ~(ZM_FLAG_CRKOK | ZM_FLAG_ESC);
+      pzm->pktlen    = 0;
+      pzm->ncrc      = 0;
+
+      return zm_event(pzm, ZME_DATARCVD);
     }
 
   /* Handle the escaped character in an escape sequence */
@@ -868,26 +878,17 @@ int zm_datapump(FAR struct zm_state_s *pzm)
 
   do
     {
-      /* Start/restart the timer.  Whenever we read data from the peer we
-       * must anticipate a timeout because we can never be sure that the peer
-       * is still responding.
-       */
-
-      sched_lock();
-      zm_timerstart(pzm, pzm->timeout);
-
-      /* Read a block of data.  read() will return: (1) nread > 0 and nread
-       * <= CONFIG_SYSTEM_ZMODEM_RCVBUFSIZE on success, (2) nread == 0 on end
-       * of file, or (3) nread < 0 on a read error or interruption by a
-       * signal.
+      /* Read a block of data.  Whenever we read data from the peer we must
+       * anticipate a timeout because we can never be sure that the peer is
+       * still responding.  serxfer_read() will return: (1) nread > 0 and
+       * nread <= CONFIG_SYSTEM_ZMODEM_RCVBUFSIZE on success, (2) nread == 0
+       * on end of file, (3) -ETIMEDOUT if nothing arrived within the
+       * timeout, or (4) some other negated errno value on a read error.
        */
 
-      nread = read(pzm->remfd, pzm->rcvbuf, CONFIG_SYSTEM_ZMODEM_RCVBUFSIZE);
-
-      /* Stop the timer */
-
-      zm_timerstop(pzm);
-      sched_unlock();
+      nread = serxfer_read(&pzm->xfer, pzm->rcvbuf,
+                           CONFIG_SYSTEM_ZMODEM_RCVBUFSIZE,
+                           pzm->timeout > 0 ? pzm->timeout * 1000 : -1);
 
       /* EOF from the remote peer can only mean that we lost the connection
        * somehow.
@@ -899,41 +900,19 @@ int zm_datapump(FAR struct zm_state_s *pzm)
           return -ENOTCONN;
         }
 
-      /* Did some error occur? */
+      /* Did the peer not respond in time? */
 
-      else if (nread < 0)
+      else if (nread == -ETIMEDOUT)
         {
-          int errorcode = errno;
-
-          /* EINTR is not an error... it simply means that this read was
-           * interrupted by an signal before it obtained in data.  However,
-           * the signal may be SIGALRM indicating an timeout condition.
-           * We will know in this case because the signal handler will set
-           * ZM_FLAG_TIMEOUT.
-           */
-
-          if (errorcode == EINTR)
-            {
-              /* Check for a timeout */
+          ret = zm_timeout(pzm);
+        }
 
-              if ((pzm->flags & ZM_FLAG_TIMEOUT) != 0)
-                {
-                  /* Yes... a timeout occurred */
+      /* Did some other error occur? */
 
-                  ret = zm_timeout(pzm);
-                }
-
-              /* No.. then just ignore the EINTR. */
-            }
-          else
-            {
-              /* But anything else is bad and we will return the failure
-               * in those cases.
-               */
-
-              zmdbg("ERROR: read failed: %d\n", errorcode);
-              return -errorcode;
-            }
+      else if (nread < 0)
+        {
+          zmdbg("ERROR: read failed: %d\n", (int)nread);
+          return (int)nread;
         }
 
       /* Then provide that data to the state machine via zm_parse().
@@ -24,11 +24,25 @@
 
 #include <nuttx/config.h>
 #include <nuttx/arch.h>
+#include <nuttx/clock.h>
 
-#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/param.h>
+
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+#  include "logging/nxscope/nxscope.h"
+#endif
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -37,6 +51,113 @@
 #define CPULOAD_US          (USEC_PER_SEC / CONFIG_SCHED_CPULOAD_TICKSPERSEC)
 #define CPULOAD_DELAY       (10 * CPULOAD_US)
 
+#ifdef CONFIG_SMP
+#  define CPULOAD_NCPUS     CONFIG_SMP_NCPUS
+#else
+#  define CPULOAD_NCPUS     1
+#endif
+
+/* Profiler defaults: 10 ms samples for 10 s, spikes above 90% */
+
+#define PROF_INTERVAL_MS    10
+#define PROF_DURATION_S     10
+#define PROF_SPIKE_PCT      90
+#define PROF_RESCAN_MS      1000
+
+/* Binary dump: a struct cpuload_filehdr_s followed by nrecords
+ * struct cpuload_rec_s, oldest first, in target byte order.
+ */
+
+#define PROF_MAGIC          0x4c555043 /* "CPUL" */
+#define PROF_VERSION        1
+
+#define PROF_REC_CPU        0
+#define PROF_REC_TASK       1
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One sample of one CPU or task.  Load is in per mille of one CPU. */
+
+begin_packed_struct struct cpuload_rec_s
+{
+  uint32_t time;              /* us since the start of the run */
+  int32_t  id;                /* CPU number or pid */
+  uint16_t load;              /* 0..1000 */
+  uint8_t  type;              /* PROF_REC_CPU or PROF_REC_TASK */
+  uint8_t  res;
+} end_packed_struct;
+
+begin_packed_struct struct cpuload_filehdr_s
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t ncpus;
+  uint32_t interval;          /* us */
+  uint32_t nrecords;
+  uint32_t dropped;           /* Records overwritten in the ring */
+} end_packed_struct;
+
+struct cpuload_stat_s
+{
+  uint64_t sum;
+  uint32_t count;
+  uint16_t max;
+  uint32_t spikes;
+};
+
+struct cpuload_task_s
+{
+  pid_t pid;
+  bool alive;
+  struct cpuload_s prev;
+  struct cpuload_stat_s stat;
+#if CONFIG_TASK_NAME_SIZE > 0
+  char name[CONFIG_TASK_NAME_SIZE + 1];
+#endif
+};
+
+struct cpuload_prof_s
+{
+  uint32_t interval_us;
+  uint32_t duration_ms;
+  uint16_t spike;             /* Per mille */
+  bool tasks;
+  bool verbose;
+  FAR const char *output;
+
+  /* Ring of binary records */
+
+  FAR struct cpuload_rec_s *ring;
+  size_t ringsize;
+  size_t head;
+  size_t count;
+  uint32_t dropped;
+
+  /* Per-CPU state: the idle task of each CPU */
+
+  struct cpuload_s cpuprev[CPULOAD_NCPUS];
+  struct cpuload_stat_s cpustat[CPULOAD_NCPUS];
+
+  struct cpuload_task_s task[CONFIG_TESTING_CPULOAD_MAXTASKS];
+  int ntasks;
+
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+  FAR struct nxscope_s *nxs;
+#endif
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+/* nxscope keeps the channel name pointers */
+
+static char g_cpuname[CPULOAD_NCPUS][8];
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -46,12 +167,534 @@ static void show_usage(FAR const char *progname, int exitcode)
   optind = 0;
 
   printf("\nUsage: %s [-c cpu] -p percent\n", progname);
+  printf("       %s -m [-i ms] [-d sec] [-t] [-s percent] [-r records]"
+         " [-o file] [-v]"
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+         " [-x]"
+#endif
+         "\n", progname);
   printf("\nWhere:\n");
   printf("  -c bind to specific CPU, don't bind CPU if no this option\n");
   printf("  -p process percent[1-100], exectime / (exectime + idletime)\n");
+  printf("  -m profile the per-CPU load instead of generating load\n");
+  printf("  -i sample interval in ms (default %d)\n", PROF_INTERVAL_MS);
+  printf("  -d duration in seconds (default %d)\n", PROF_DURATION_S);
+  printf("  -t sample every task as well\n");
+  printf("  -s count samples above percent as spikes (default %d)\n",
+         PROF_SPIKE_PCT);
+  printf("  -r ring size in records (default %d)\n",
+         CONFIG_TESTING_CPULOAD_RINGSIZE);
+  printf("  -o write the ring to file as binary records\n");
+  printf("  -v print every sample\n");
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+  printf("  -x stream the samples over nxscope (%s)\n",
+         CONFIG_TESTING_CPULOAD_NXSCOPE_PATH);
+#endif
   exit(exitcode);
 }
 
+/****************************************************************************
+ * Name: cpuload_delta
+ *
+ * Description:
+ *   Return the active share of the interval since prev, in per mille of
+ *   the whole system, and update prev.  The scheduler halves total and
+ *   every task's ticks each time total reaches the time constant; that
+ *   shows up as a smaller total and is undone on the old snapshot before
+ *   subtracting.  Returns -1 if no tick was accounted in the interval.
+ *
+ ****************************************************************************/
+
+static int cpuload_delta(FAR struct cpuload_s *prev,
+                         FAR const struct cpuload_s *cur)
+{
+  clock_t total = prev->total;
+  clock_t active = prev->active;
+  clock_t dtotal;
+  clock_t dactive;
+
+  while (total > cur->total)
+    {
+      total >>= 1;
+      active >>= 1;
+    }
+
+  dtotal = cur->total - total;
+  dactive = cur->active > active ? cur->active - active : 0;
+  *prev = *cur;
+
+  if (dtotal == 0)
+    {
+      return -1;
+    }
+
+  return dactive >= dtotal ? 1000 : (int)(dactive * 1000 / dtotal);
+}
+
+static void cpuload_stat_add(FAR struct cpuload_stat_s *stat,
+                             uint16_t load, uint16_t spike)
+{
+  stat->sum += load;
+  stat->count++;
+  if (load > stat->max)
+    {
+      stat->max = load;
+    }
+
+  if (load >= spike)
+    {
+      stat->spikes++;
+    }
+}
+
+static void cpuload_record(FAR struct cpuload_prof_s *prof, uint32_t time,
+                           int32_t id, uint16_t load, uint8_t type)
+{
+  FAR struct cpuload_rec_s *rec = &prof->ring[prof->head];
+
+  rec->time = time;
+  rec->id   = id;
+  rec->load = load;
+  rec->type = type;
+  rec->res  = 0;
+
+  prof->head = (prof->head + 1) % prof->ringsize;
+  if (prof->count < prof->ringsize)
+    {
+      prof->count++;
+    }
+  else
+    {
+      prof->dropped++;
+    }
+
+  if (prof->verbose)
+    {
+      printf("%10" PRIu32 " %s %5" PRId32 " %3u.%u%%\n", time,
+             type == PROF_REC_CPU ? "cpu " : "task", id,
+             load / 10, load % 10);
+    }
+
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+  if (prof->nxs != NULL)
+    {
+      if (type == PROF_REC_CPU)
+        {
+          nxscope_put_uint16(prof->nxs, id, load);
+        }
+      else
+        {
+          nxscope_put_uint16_m(prof->nxs, CPULOAD_NCPUS, load,
+                               (FAR uint8_t *)&id, sizeof(id));
+        }
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: cpuload_scan
+ *
+ * Description:
+ *   Refresh the task list from the pids under /proc.  Only the directory
+ *   names are read; the load itself comes from clock_cpuload().  Tasks
+ *   that went away keep their statistics for the summary.
+ *
+ ****************************************************************************/
+
+static void cpuload_scan(FAR struct cpuload_prof_s *prof)
+{
+  FAR struct dirent *entry;
+  FAR DIR *dir;
+  int i;
+
+  dir = opendir("/proc");
+  if (dir == NULL)
+    {
+      return;
+    }
+
+  while ((entry = readdir(dir)) != NULL)
+    {
+      FAR char *endptr;
+      pid_t pid;
+
+      pid = strtol(entry->d_name, &endptr, 10);
+      if (*endptr != '\0' || pid < CPULOAD_NCPUS)
+        {
+          continue;
+        }
+
+      for (i = 0; i < prof->ntasks; i++)
+        {
+          if (prof->task[i].pid == pid && prof->task[i].alive)
+            {
+              break;
+            }
+        }
+
+      if (i < prof->ntasks ||
+          prof->ntasks >= CONFIG_TESTING_CPULOAD_MAXTASKS)
+        {
+          continue;
+        }
+
+      if (clock_cpuload(pid, &prof->task[i].prev) < 0)
+        {
+          continue;
+        }
+
+      memset(&prof->task[i].stat, 0, sizeof(prof->task[i].stat));
+      prof->task[i].pid   = pid;
+      prof->task[i].alive = true;
+#if CONFIG_TASK_NAME_SIZE > 0
+      if (pthread_getname_np(pid, prof->task[i].name,
+                             sizeof(prof->task[i].name)) != 0)
+        {
+          prof->task[i].name[0] = '\0';
+        }
+#endif
+
+      prof->ntasks++;
+    }
+
+  closedir(dir);
+}
+
+static void cpuload_sample(FAR struct cpuload_prof_s *prof, uint32_t time)
+{
+  struct cpuload_s cur;
+  int load;
+  int i;
+
+  /* The idle task of CPU n has pid n and the total is summed over all
+   * CPUs, so one CPU's busy share is 1 - ncpus * idle / total.
+   */
+
+  for (i = 0; i < CPULOAD_NCPUS; i++)
+    {
+      if (clock_cpuload(i, &cur) < 0)
+        {
+          continue;
+        }
+
+      load = cpuload_delta(&prof->cpuprev[i], &cur);
+      if (load < 0)
+        {
+          continue;
+        }
+
+      load = 1000 - MIN(load * CPULOAD_NCPUS, 1000);
+      cpuload_stat_add(&prof->cpustat[i], load, prof->spike);
+      cpuload_record(prof, time, i, load, PROF_REC_CPU);
+    }
+
+  for (i = 0; i < prof->ntasks; i++)
+    {
+      FAR struct cpuload_task_s *task = &prof->task[i];
+
+      if (!task->alive)
+        {
+          continue;
+        }
+
+      if (clock_cpuload(task->pid, &cur) < 0)
+        {
+          task->alive = false;
+          continue;
+        }
+
+      load = cpuload_delta(&task->prev, &cur);
+      if (load < 0)
+        {
+          continue;
+        }
+
+      load = MIN(load * CPULOAD_NCPUS, 1000);
+      cpuload_stat_add(&task->stat, load, prof->spike);
+      cpuload_record(prof, time, task->pid, load, PROF_REC_TASK);
+    }
+}
+
+static int cpuload_dump(FAR struct cpuload_prof_s *prof)
+{
+  struct cpuload_filehdr_s hdr;
+  size_t first;
+  size_t n;
+  int fd;
+
+  fd = open(prof->output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      printf("ERROR: open %s failed: %d\n", prof->output, errno);
+      return -errno;
+    }
+
+  hdr.magic    = PROF_MAGIC;
+  hdr.version  = PROF_VERSION;
+  hdr.ncpus    = CPULOAD_NCPUS;
+  hdr.interval = prof->interval_us;
+  hdr.nrecords = prof->count;
+  hdr.dropped  = prof->dropped;
+
+  if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+    {
+      goto errout;
+    }
+
+  /* The oldest record sits at head once the ring has wrapped */
+
+  first = prof->count < prof->ringsize ? 0 : prof->head;
+  for (n = 0; n < prof->count; n++)
+    {
+      FAR struct cpuload_rec_s *rec =
+        &prof->ring[(first + n) % prof->ringsize];
+
+      if (write(fd, rec, sizeof(*rec)) != sizeof(*rec))
+        {
+          goto errout;
+        }
+    }
+
+  close(fd);
+  return OK;
+
+errout:
+  printf("ERROR: write %s failed: %d\n", prof->output, errno);
+  close(fd);
+  return -EIO;
+}
+
+static void cpuload_print_stat(FAR const char *label, int32_t id,
+                               FAR const char *name,
+                               FAR const struct cpuload_stat_s *stat)
+{
+  uint32_t avg = stat->count ? stat->sum / stat->count : 0;
+
+  printf("%-4s %5" PRId32 " %-16s %3" PRIu32 ".%" PRIu32 "%% "
+         "%3u.%u%% %6" PRIu32 " %6" PRIu32 "\n",
+         label, id, name, avg / 10, avg % 10, stat->max / 10,
+         stat->max % 10, stat->spikes, stat->count);
+}
+
+static void cpuload_summary(FAR struct cpuload_prof_s *prof)
+{
+  int i;
+
+  printf("\n%-4s %5s %-16s %6s %6s %6s %6s\n",
+         "", "id", "name", "avg", "max", "spikes", "n");
+
+  for (i = 0; i < CPULOAD_NCPUS; i++)
+    {
+      cpuload_print_stat("cpu", i, "", &prof->cpustat[i]);
+    }
+
+  for (i = 0; i < prof->ntasks; i++)
+    {
+      FAR struct cpuload_task_s *task = &prof->task[i];
+
+      if (task->stat.count == 0)
+        {
+          continue;
+        }
+
+#if CONFIG_TASK_NAME_SIZE > 0
+      cpuload_print_stat("task", task->pid, task->name, &task->stat);
+#else
+      cpuload_print_stat("task", task->pid, "", &task->stat);
+#endif
+    }
+
+  printf("\n%zu records in the ring, %" PRIu32 " overwritten\n",
+         prof->count, prof->dropped);
+}
+
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+static int cpuload_nxscope_init(FAR struct nxscope_s *nxs,
+                                FAR struct nxscope_intf_s *intf,
+                                FAR struct nxscope_proto_s *proto)
+{
+  struct nxscope_ser_cfg_s ser_cfg;
+  struct nxscope_cfg_s cfg;
+  union nxscope_chinfo_type_u u;
+  int ret;
+  int i;
+
+  ret = nxscope_proto_ser_init(proto, NULL);
+  if (ret < 0)
+    {
+      printf("ERROR: nxscope_proto_ser_init failed %d\n", ret);
+      return ret;
+    }
+
+  ser_cfg.path     = CONFIG_TESTING_CPULOAD_NXSCOPE_PATH;
+  ser_cfg.nonblock = true;
+  ser_cfg.baud     = CONFIG_TESTING_CPULOAD_NXSCOPE_BAUD;
+
+  ret = nxscope_ser_init(intf, &ser_cfg);
+  if (ret < 0)
+    {
+      printf("ERROR: nxscope_ser_init failed %d\n", ret);
+      goto errout_nointf;
+    }
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.intf_cmd      = intf;
+  cfg.intf_stream   = intf;
+  cfg.proto_cmd     = proto;
+  cfg.proto_stream  = proto;
+  cfg.channels      = CPULOAD_NCPUS + 1;
+  cfg.streambuf_len = CONFIG_TESTING_CPULOAD_NXSCOPE_STREAMBUF_LEN;
+  cfg.rxbuf_len     = 32;
+
+  ret = nxscope_init(nxs, &cfg);
+  if (ret < 0)
+    {
+      printf("ERROR: nxscope_init failed %d\n", ret);
+      goto errout_nonxscope;
+    }
+
+  u.s.dtype = NXSCOPE_TYPE_UINT16;
+  u.s._res  = 0;
+  u.s.cri   = 0;
+
+  for (i = 0; i < CPULOAD_NCPUS; i++)
+    {
+      snprintf(g_cpuname[i], sizeof(g_cpuname[i]), "cpu%d", i);
+      nxscope_chan_init(nxs, i, g_cpuname[i], u.u8, 1, 0);
+      nxscope_chan_en(nxs, i, true);
+    }
+
+  nxscope_chan_init(nxs, CPULOAD_NCPUS, "task", u.u8, 1, sizeof(int32_t));
+  nxscope_chan_en(nxs, CPULOAD_NCPUS, true);
+  nxscope_stream_start(nxs, true);
+
+  return OK;
+
+errout_nonxscope:
+  nxscope_ser_deinit(intf);
+errout_nointf:
+  nxscope_proto_ser_deinit(proto);
+  return ret;
+}
+#endif
+
+static int cpuload_profile(FAR struct cpuload_prof_s *prof, bool scope)
+{
+  struct timespec start;
+  struct timespec next;
+  struct timespec now;
+  uint32_t rescan = 0;
+  uint32_t elapsed = 0;
+  int ret = OK;
+  int i;
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+  struct nxscope_s nxs;
+  struct nxscope_intf_s intf;
+  struct nxscope_proto_s proto;
+#endif
+
+  prof->ring = malloc(prof->ringsize * sizeof(struct cpuload_rec_s));
+  if (prof->ring == NULL)
+    {
+      printf("ERROR: no memory for %zu records\n", prof->ringsize);
+      return -ENOMEM;
+    }
+
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+  if (scope)
+    {
+      ret = cpuload_nxscope_init(&nxs, &intf, &proto);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+
+      prof->nxs = &nxs;
+    }
+#else
+  UNUSED(scope);
+#endif
+
+  /* The load is only accounted once per cpuload tick, so an interval of
+   * a few ticks quantizes heavily.
+   */
+
+  if (prof->interval_us < 10 * CPULOAD_US)
+    {
+      printf("WARNING: %" PRIu32 " us interval, cpuload tick is %d us\n",
+             prof->interval_us, (int)CPULOAD_US);
+    }
+
+  for (i = 0; i < CPULOAD_NCPUS; i++)
+    {
+      clock_cpuload(i, &prof->cpuprev[i]);
+    }
+
+  if (prof->tasks)
+    {
+      cpuload_scan(prof);
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  next = start;
+
+  while (elapsed / USEC_PER_MSEC < prof->duration_ms)
+    {
+      /* Absolute deadlines keep the interval from drifting with the
+       * sampling and output cost.
+       */
+
+      next.tv_nsec += prof->interval_us * NSEC_PER_USEC;
+      while (next.tv_nsec >= NSEC_PER_SEC)
+        {
+          next.tv_nsec -= NSEC_PER_SEC;
+          next.tv_sec++;
+        }
+
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+      clock_gettime(CLOCK_MONOTONIC, &now);
+
+      elapsed = (now.tv_sec - start.tv_sec) * USEC_PER_SEC +
+                (now.tv_nsec - start.tv_nsec) / NSEC_PER_USEC;
+
+      cpuload_sample(prof, elapsed);
+
+      if (prof->tasks && elapsed - rescan >= PROF_RESCAN_MS * USEC_PER_MSEC)
+        {
+          cpuload_scan(prof);
+          rescan = elapsed;
+        }
+
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+      if (prof->nxs != NULL)
+        {
+          nxscope_stream(prof->nxs);
+          nxscope_recv(prof->nxs);
+        }
+#endif
+    }
+
+  cpuload_summary(prof);
+
+  if (prof->output != NULL)
+    {
+      ret = cpuload_dump(prof);
+    }
+
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+  if (prof->nxs != NULL)
+    {
+      nxscope_deinit(prof->nxs);
+      nxscope_ser_deinit(&intf);
+      nxscope_proto_ser_deinit(&proto);
+    }
+
+errout:
+#endif
+  free(prof->ring);
+  return ret;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -62,12 +705,28 @@ static void show_usage(FAR const char *progname, int exitcode)
 
 int main(int argc, FAR char *argv[])
 {
+  FAR struct cpuload_prof_s *prof;
   FAR char *endptr;
+  bool profile = false;
+  bool scope = false;
   int option;
   int cpu = -1;
   int per = 50;
+  int ret;
 
-  while ((option = getopt(argc, argv, "c:p:")) != ERROR)
+  prof = calloc(1, sizeof(*prof));
+  if (prof == NULL)
+    {
+      printf("ERROR: no memory\n");
+      return EXIT_FAILURE;
+    }
+
+  prof->interval_us = PROF_INTERVAL_MS * USEC_PER_MSEC;
+  prof->duration_ms = PROF_DURATION_S * MSEC_PER_SEC;
+  prof->spike       = PROF_SPIKE_PCT * 10;
+  prof->ringsize    = CONFIG_TESTING_CPULOAD_RINGSIZE;
+
+  while ((option = getopt(argc, argv, "c:p:mi:d:ts:r:o:vx")) != ERROR)
     {
       if (option == 'c')
         {
@@ -77,13 +736,68 @@ int main(int argc, FAR char *argv[])
         {
           per = strtol(optarg, &endptr, 10);
         }
+      else if (option == 'm')
+        {
+          profile = true;
+        }
+      else if (option == 'i')
+        {
+          prof->interval_us = strtoul(optarg, &endptr, 10) * USEC_PER_MSEC;
+        }
+      else if (option == 'd')
+        {
+          prof->duration_ms = strtoul(optarg, &endptr, 10) * MSEC_PER_SEC;
+        }
+      else if (option == 't')
+        {
+          prof->tasks = true;
+        }
+      else if (option == 's')
+        {
+          prof->spike = strtoul(optarg, &endptr, 10) * 10;
+        }
+      else if (option == 'r')
+        {
+          prof->ringsize = strtoul(optarg, &endptr, 10);
+        }
+      else if (option == 'o')
+        {
+          prof->output = optarg;
+        }
+      else if (option == 'v')
+        {
+          prof->verbose = true;
+        }
+#ifdef CONFIG_TESTING_CPULOAD_NXSCOPE
+      else if (option == 'x')
+        {
+          scope = true;
+        }
+#endif
       else
         {
           printf("Unrecognized option: '%c'\n", option);
+          free(prof);
           show_usage(argv[0], EXIT_FAILURE);
         }
     }
 
+  if (profile)
+    {
+      if (prof->interval_us == 0 || prof->ringsize == 0)
+        {
+          printf("Invalid interval or ring size\n");
+          free(prof);
+          show_usage(argv[0], EXIT_FAILURE);
+        }
+
+      ret = cpuload_profile(prof, scope);
+      free(prof);
+      return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+  free(prof);
+
   /* There should be two parameters remaining on the command line */
 
   if (per < 1 || per > 100 || optind > argc)
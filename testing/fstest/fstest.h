@@ -0,0 +1,63 @@
+/****************************************************************************
+ * apps/testing/fstest/fstest.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_TESTING_FSTEST_FSTEST_H
+#define __APPS_TESTING_FSTEST_FSTEST_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+
+/****************************************************************************
+ * Name: fstest_bench
+ *
+ * Description:
+ *   Measure the metadata rates, the sequential and random throughput and
+ *   the fsync latency of the file system mounted at mountdir, first with
+ *   one thread and then with 2, 4, ... up to nthreads threads working
+ *   concurrently in their own directory.
+ *
+ * Input Parameters:
+ *   mountdir - The mountpoint to be tested, ending with '/'
+ *   nthreads - The maximum number of concurrent threads
+ *   nfiles   - The number of files of the metadata phases, per thread
+ *   filesize - The size of the file of the I/O phases, per thread
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int fstest_bench(FAR const char *mountdir, int nthreads, int nfiles,
+                 size_t filesize);
+
+#endif /* CONFIG_TESTING_FSTEST_BENCH */
+
+#endif /* __APPS_TESTING_FSTEST_FSTEST_H */
@@ -0,0 +1,582 @@
+/****************************************************************************
+ * apps/testing/fstest/fstest_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/stat.h>
+
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "fstest.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FSTEST_BENCH_IOSIZE  CONFIG_TESTING_FSTEST_BENCH_IOSIZE
+#define FSTEST_BENCH_NSYNC   CONFIG_TESTING_FSTEST_BENCH_NSYNC
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum fstest_phase_e
+{
+  FSTEST_CREATE = 0,
+  FSTEST_OPEN,
+  FSTEST_STAT,
+  FSTEST_UNLINK,
+  FSTEST_SEQWRITE,
+  FSTEST_SEQREAD,
+  FSTEST_RANDWRITE,
+  FSTEST_RANDREAD,
+  FSTEST_FSYNC,
+  FSTEST_NPHASES
+};
+
+/* State shared by all of the threads of one run */
+
+struct fstest_bench_s
+{
+  FAR const char *mountdir;
+  int nthreads;
+  int nfiles;
+  size_t filesize;
+  sem_t go;
+  pthread_barrier_t start;
+  pthread_barrier_t done;
+};
+
+/* State of one thread.  Each thread works in its own directory */
+
+struct fstest_worker_s
+{
+  FAR struct fstest_bench_s *bench;
+  pthread_t thread;
+  unsigned int seed;
+  int result;
+  uint64_t start;
+  uint64_t end;
+  uint32_t sync_min;
+  uint32_t sync_max;
+  uint64_t sync_sum;
+  char dir[PATH_MAX];
+  char path[PATH_MAX];
+  uint8_t buf[FSTEST_BENCH_IOSIZE];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static FAR const char *g_phase_name[FSTEST_NPHASES] =
+{
+  "create", "open", "stat", "unlink",
+  "seqwrite", "seqread", "randwrite", "randread", "fsync"
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fstest_now
+ *
+ * Description:
+ *   Return the monotonic time in microseconds.
+ *
+ ****************************************************************************/
+
+static uint64_t fstest_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: fstest_filename
+ *
+ * Description:
+ *   Return the path of a small file of the metadata phases, or the path of
+ *   the data file of the I/O phases if index is negative.
+ *
+ ****************************************************************************/
+
+static FAR const char *fstest_filename(FAR struct fstest_worker_s *w,
+                                       int index)
+{
+  if (index < 0)
+    {
+      snprintf(w->path, sizeof(w->path), "%s/data", w->dir);
+    }
+  else
+    {
+      snprintf(w->path, sizeof(w->path), "%s/f%d", w->dir, index);
+    }
+
+  return w->path;
+}
+
+/****************************************************************************
+ * Name: fstest_metadata
+ *
+ * Description:
+ *   Create, open, stat or unlink all of the small files of the thread.
+ *
+ ****************************************************************************/
+
+static int fstest_metadata(FAR struct fstest_worker_s *w, int phase)
+{
+  FAR const char *path;
+  struct stat st;
+  int fd;
+  int i;
+
+  for (i = 0; i < w->bench->nfiles; i++)
+    {
+      path = fstest_filename(w, i);
+      switch (phase)
+        {
+          case FSTEST_CREATE:
+          case FSTEST_OPEN:
+            fd = open(path, phase == FSTEST_CREATE ?
+                      O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY, 0666);
+            if (fd < 0)
+              {
+                return -errno;
+              }
+
+            close(fd);
+            break;
+
+          case FSTEST_STAT:
+            if (stat(path, &st) < 0)
+              {
+                return -errno;
+              }
+            break;
+
+          default:
+            if (unlink(path) < 0)
+              {
+                return -errno;
+              }
+            break;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fstest_transfer
+ *
+ * Description:
+ *   Read or write the data file of the thread in FSTEST_BENCH_IOSIZE
+ *   blocks, in order or at random block offsets.  Writes are synced
+ *   before returning so that the data really reached the media.
+ *
+ ****************************************************************************/
+
+static int fstest_transfer(FAR struct fstest_worker_s *w, int phase)
+{
+  size_t nblocks = w->bench->filesize / FSTEST_BENCH_IOSIZE;
+  bool writing = phase == FSTEST_SEQWRITE || phase == FSTEST_RANDWRITE;
+  bool seeking = phase == FSTEST_RANDWRITE || phase == FSTEST_RANDREAD;
+  ssize_t nbytes;
+  size_t i;
+  int ret = OK;
+  int fd;
+
+  fd = open(fstest_filename(w, -1), phase == FSTEST_SEQWRITE ?
+            O_WRONLY | O_CREAT | O_TRUNC : writing ? O_WRONLY : O_RDONLY,
+            0666);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  for (i = 0; i < nblocks; i++)
+    {
+      if (seeking &&
+          lseek(fd, (off_t)(rand_r(&w->seed) % nblocks) *
+                FSTEST_BENCH_IOSIZE, SEEK_SET) < 0)
+        {
+          ret = -errno;
+          break;
+        }
+
+      nbytes = writing ? write(fd, w->buf, FSTEST_BENCH_IOSIZE) :
+                       read(fd, w->buf, FSTEST_BENCH_IOSIZE);
+      if (nbytes != FSTEST_BENCH_IOSIZE)
+        {
+          ret = nbytes < 0 ? -errno : -EIO;
+          break;
+        }
+    }
+
+  if (ret == OK && writing && fsync(fd) < 0)
+    {
+      ret = -errno;
+    }
+
+  close(fd);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fstest_fsync
+ *
+ * Description:
+ *   Measure the latency of fsync after each one block write.
+ *
+ ****************************************************************************/
+
+static int fstest_fsync(FAR struct fstest_worker_s *w)
+{
+  size_t nblocks = w->bench->filesize / FSTEST_BENCH_IOSIZE;
+  uint64_t start;
+  uint32_t delta;
+  ssize_t nbytes;
+  int ret = OK;
+  int fd;
+  int i;
+
+  w->sync_min = UINT32_MAX;
+  w->sync_max = 0;
+  w->sync_sum = 0;
+
+  fd = open(fstest_filename(w, -1), O_WRONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  for (i = 0; i < FSTEST_BENCH_NSYNC; i++)
+    {
+      if (lseek(fd, (off_t)(i % nblocks) * FSTEST_BENCH_IOSIZE,
+                SEEK_SET) < 0)
+        {
+          ret = -errno;
+          break;
+        }
+
+      nbytes = write(fd, w->buf, FSTEST_BENCH_IOSIZE);
+      if (nbytes != FSTEST_BENCH_IOSIZE)
+        {
+          ret = nbytes < 0 ? -errno : -EIO;
+          break;
+        }
+
+      start = fstest_now();
+      if (fsync(fd) < 0)
+        {
+          ret = -errno;
+          break;
+        }
+
+      delta = fstest_now() - start;
+      w->sync_sum += delta;
+      if (delta < w->sync_min)
+        {
+          w->sync_min = delta;
+        }
+
+      if (delta > w->sync_max)
+        {
+          w->sync_max = delta;
+        }
+    }
+
+  close(fd);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fstest_worker
+ *
+ * Description:
+ *   Run all of the phases, in step with the other threads: every phase
+ *   starts and ends on a barrier so that the threads overlap and the main
+ *   thread can report it from the first start to the last end.
+ *
+ ****************************************************************************/
+
+static FAR void *fstest_worker(FAR void *arg)
+{
+  FAR struct fstest_worker_s *w = arg;
+  FAR struct fstest_bench_s *bench = w->bench;
+  int phase;
+
+  sem_wait(&bench->go);
+
+  for (phase = 0; phase < FSTEST_NPHASES; phase++)
+    {
+      pthread_barrier_wait(&bench->start);
+
+      w->start = fstest_now();
+      if (w->result == OK)
+        {
+          if (phase <= FSTEST_UNLINK)
+            {
+              w->result = fstest_metadata(w, phase);
+            }
+          else if (phase < FSTEST_FSYNC)
+            {
+              w->result = fstest_transfer(w, phase);
+            }
+          else
+            {
+              w->result = fstest_fsync(w);
+            }
+        }
+
+      w->end = fstest_now();
+      pthread_barrier_wait(&bench->done);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: fstest_report
+ ****************************************************************************/
+
+static void fstest_report(FAR struct fstest_bench_s *bench,
+                          FAR struct fstest_worker_s *workers, int phase)
+{
+  uint64_t start = UINT64_MAX;
+  uint64_t end = 0;
+  uint64_t elapsed;
+  uint32_t min = UINT32_MAX;
+  uint32_t max = 0;
+  uint64_t sum = 0;
+  uint64_t total;
+  int i;
+
+  for (i = 0; i < bench->nthreads; i++)
+    {
+      if (workers[i].result < 0)
+        {
+          printf("  %-10s FAILED: %d\n", g_phase_name[phase],
+                 workers[i].result);
+          return;
+        }
+
+      start = workers[i].start < start ? workers[i].start : start;
+      end   = workers[i].end > end ? workers[i].end : end;
+    }
+
+  elapsed = end > start ? end - start : 1;
+
+  if (phase <= FSTEST_UNLINK)
+    {
+      total = (uint64_t)bench->nfiles * bench->nthreads;
+      printf("  %-10s %8" PRIu64 " ops/s\n", g_phase_name[phase],
+             total * 1000000 / elapsed);
+    }
+  else if (phase < FSTEST_FSYNC)
+    {
+      total = (uint64_t)bench->filesize * bench->nthreads;
+      printf("  %-10s %8" PRIu64 " KiB/s\n", g_phase_name[phase],
+             total * 1000000 / 1024 / elapsed);
+    }
+  else
+    {
+      for (i = 0; i < bench->nthreads; i++)
+        {
+          min  = workers[i].sync_min < min ? workers[i].sync_min : min;
+          max  = workers[i].sync_max > max ? workers[i].sync_max : max;
+          sum += workers[i].sync_sum;
+        }
+
+      printf("  %-10s min %" PRIu32 " avg %" PRIu64 " max %" PRIu32
+             " us\n", g_phase_name[phase], min,
+             sum / ((uint64_t)FSTEST_BENCH_NSYNC * bench->nthreads), max);
+    }
+}
+
+/****************************************************************************
+ * Name: fstest_run
+ *
+ * Description:
+ *   Run all of the phases once with the given number of threads.
+ *
+ ****************************************************************************/
+
+static int fstest_run(FAR struct fstest_bench_s *bench)
+{
+  FAR struct fstest_worker_s *workers;
+  int nstarted;
+  int phase;
+  int ret = OK;
+  int i;
+
+  workers = calloc(bench->nthreads, sizeof(struct fstest_worker_s));
+  if (workers == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  sem_init(&bench->go, 0, 0);
+
+  for (i = 0; i < bench->nthreads; i++)
+    {
+      workers[i].bench = bench;
+      workers[i].seed  = 0x93846 + i;
+      snprintf(workers[i].dir, sizeof(workers[i].dir), "%sbench%d",
+               bench->mountdir, i);
+      if (mkdir(workers[i].dir, 0777) < 0 && errno != EEXIST)
+        {
+          workers[i].result = -errno;
+        }
+
+      memset(workers[i].buf, 0xa5 ^ i, FSTEST_BENCH_IOSIZE);
+    }
+
+  for (nstarted = 0; nstarted < bench->nthreads; nstarted++)
+    {
+      ret = pthread_create(&workers[nstarted].thread, NULL, fstest_worker,
+                           &workers[nstarted]);
+      if (ret != 0)
+        {
+          printf("ERROR: pthread_create failed: %d\n", ret);
+          ret = -ret;
+          break;
+        }
+    }
+
+  /* The main thread takes part in the barriers to report the phases.  If
+   * not all of the threads could be started, the others still run through
+   * the phases but without doing any work.
+   */
+
+  pthread_barrier_init(&bench->start, NULL, nstarted + 1);
+  pthread_barrier_init(&bench->done, NULL, nstarted + 1);
+
+  for (i = 0; i < nstarted; i++)
+    {
+      if (ret != OK)
+        {
+          workers[i].result = ret;
+        }
+
+      sem_post(&bench->go);
+    }
+
+  printf("\n=== %d THREAD(S) ============================\n",
+         bench->nthreads);
+
+  for (phase = 0; phase < FSTEST_NPHASES; phase++)
+    {
+      pthread_barrier_wait(&bench->start);
+      pthread_barrier_wait(&bench->done);
+
+      if (ret == OK)
+        {
+          fstest_report(bench, workers, phase);
+        }
+    }
+
+  for (i = 0; i < nstarted; i++)
+    {
+      pthread_join(workers[i].thread, NULL);
+      if (workers[i].result < 0)
+        {
+          /* Remove what the failed phase may have left behind */
+
+          for (phase = 0; phase < bench->nfiles; phase++)
+            {
+              unlink(fstest_filename(&workers[i], phase));
+            }
+
+          if (ret == OK)
+            {
+              ret = workers[i].result;
+            }
+        }
+
+      unlink(fstest_filename(&workers[i], -1));
+      rmdir(workers[i].dir);
+    }
+
+  pthread_barrier_destroy(&bench->start);
+  pthread_barrier_destroy(&bench->done);
+  sem_destroy(&bench->go);
+  free(workers);
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fstest_bench
+ ****************************************************************************/
+
+int fstest_bench(FAR const char *mountdir, int nthreads, int nfiles,
+                 size_t filesize)
+{
+  struct fstest_bench_s bench;
+  int ret = OK;
+  int n;
+
+  memset(&bench, 0, sizeof(bench));
+  bench.mountdir = mountdir;
+  bench.nfiles   = nfiles;
+  bench.filesize = filesize - filesize % FSTEST_BENCH_IOSIZE;
+  if (bench.filesize == 0)
+    {
+      bench.filesize = FSTEST_BENCH_IOSIZE;
+    }
+
+  printf("Benchmark %s: %d files, %zu bytes file, %d bytes I/O\n",
+         mountdir, nfiles, bench.filesize, FSTEST_BENCH_IOSIZE);
+
+  /* Double the number of threads up to nthreads to show the scaling */
+
+  for (n = 1; n <= nthreads && ret == OK; n = n < nthreads &&
+       n * 2 > nthreads ? nthreads : n * 2)
+    {
+      bench.nthreads = n;
+      ret = fstest_run(&bench);
+    }
+
+  return ret;
+}
@@ -46,6 +46,8 @@
 
 #include <nuttx/crc32.h>
 
+#include "fstest.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -953,6 +955,14 @@ static void show_useage(void)
          CONFIG_TESTING_FSTEST_MAXOPEN);
   printf("-s    size of every file e.g. [%d]\n",
          CONFIG_TESTING_FSTEST_MAXFILE);
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+  printf("-b    run the benchmark instead of the stress test, -o and -s\n"
+         "      set the files and the file size per thread e.g. "
+         "[%d] [%d]\n", CONFIG_TESTING_FSTEST_BENCH_NFILES,
+         CONFIG_TESTING_FSTEST_BENCH_FILESIZE);
+  printf("-t    max num of benchmark threads e.g. [%d]\n",
+         CONFIG_TESTING_FSTEST_BENCH_NTHREADS);
+#endif
 }
 
 /****************************************************************************
@@ -971,6 +981,12 @@ int main(int argc, FAR char *argv[])
   int ret;
   int loop_num;
   int option;
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+  bool bench = false;
+  int nthreads = CONFIG_TESTING_FSTEST_BENCH_NTHREADS;
+  int nfiles = CONFIG_TESTING_FSTEST_BENCH_NFILES;
+  int filesize = CONFIG_TESTING_FSTEST_BENCH_FILESIZE;
+#endif
 
   tests_ok = tests_err = 0;
 
@@ -994,7 +1010,7 @@ int main(int argc, FAR char *argv[])
 
   /* Opt Parse */
 
-  while ((option = getopt(argc, argv, ":m:hn:o:s:")) != -1)
+  while ((option = getopt(argc, argv, ":bm:hn:o:s:t:")) != -1)
     {
       switch (option)
         {
@@ -1010,10 +1026,24 @@ int main(int argc, FAR char *argv[])
             break;
           case 'o':
             ctx->max_open = atoi(optarg);
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+            nfiles = ctx->max_open;
+#endif
             break;
           case 's':
             ctx->max_file = atoi(optarg);
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+            filesize = ctx->max_file;
+#endif
+            break;
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+          case 'b':
+            bench = true;
+            break;
+          case 't':
+            nthreads = atoi(optarg);
             break;
+#endif
           case ':':
             printf("Error: Missing required argument\n");
             free(ctx);
@@ -1030,6 +1060,17 @@ int main(int argc, FAR char *argv[])
       strlcat(ctx->mountdir, "/", sizeof(ctx->mountdir));
     }
 
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+  if (bench)
+    {
+      ret = fstest_bench(ctx->mountdir, nthreads > 0 ? nthreads : 1,
+                         nfiles, filesize);
+      free(ctx);
+      printf("File system benchmark done: %d\n", ret);
+      return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+#endif
+
   ctx->fileimage = calloc(ctx->max_file, 1);
   if (ctx->fileimage == NULL)
     {
@@ -25,12 +25,18 @@
 #include <nuttx/config.h>
 #include <stdlib.h>
 #include <debug.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stddef.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <sys/param.h>
+#include <nuttx/clock.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -39,6 +45,17 @@
 #define MEMSTRESS_PREFIX "MemoryStress:"
 #define DEBUG_MAGIC 0xaa
 
+/* Benchmark mode: size classes in a profile, and the latency histogram,
+ * exact below 16 ns and then 8 buckets per power of two (within 12.5%).
+ */
+
+#define BENCH_MAX_BUCKETS 64
+#define BENCH_HIST_SUB 8
+#define BENCH_HIST_BUCKETS 256
+#define BENCH_DEFAULT_NODELEN 256
+#define BENCH_DEFAULT_ITERATIONS 100000
+#define BENCH_SAMPLES 10
+
 #define OPTARG_TO_VALUE(value, type) \
   do \
   { \
@@ -95,15 +112,87 @@ struct memorystress_node_s
   size_t size;
 };
 
+struct memorystress_bucket_s
+{
+  size_t size;                /* Largest size of the class */
+  uint32_t weight;            /* Share of the allocations */
+};
+
+struct memorystress_profile_s
+{
+  FAR const char *name;
+  FAR const struct memorystress_bucket_s *buckets;
+  size_t nbuckets;
+};
+
+struct memorystress_hist_s
+{
+  uint32_t buckets[BENCH_HIST_BUCKETS];
+  uint64_t max;
+  size_t count;
+};
+
+struct memorystress_bench_s
+{
+  struct memorystress_bucket_s buckets[BENCH_MAX_BUCKETS];
+  size_t nbuckets;
+  uint32_t total_weight;
+  size_t iterations;
+  int threads;
+};
+
+struct memorystress_worker_s
+{
+  FAR const struct memorystress_bench_s *bench;
+  FAR struct memorystress_node_s *node_array;
+  size_t nodelen;
+  pthread_t thread;
+  uint32_t seed;
+  bool sample;                /* Print the fragmentation as it goes */
+  size_t failures;
+  uint64_t elapsed_ns;
+  struct memorystress_hist_s hist[2];
+};
+
 struct memorystress_context_s
 {
   struct memorystress_node_s *node_array;
   struct memorystress_config_s *config;
   struct memorystress_error_s error;
+  FAR struct memorystress_bench_s *bench;
   uint32_t sleep_us;
   bool debug;
 };
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Sizes up to each class size are equally likely within the class */
+
+static const struct memorystress_bucket_s g_small_profile[] =
+{
+  {16, 30}, {32, 30}, {64, 20}, {128, 15}, {256, 5}
+};
+
+static const struct memorystress_bucket_s g_mixed_profile[] =
+{
+  {32, 20}, {64, 15}, {128, 15}, {256, 10}, {512, 10}, {1600, 25},
+  {4096, 5}
+};
+
+static const struct memorystress_bucket_s g_large_profile[] =
+{
+  {1024, 30}, {4096, 30}, {16384, 25}, {65536, 15}
+};
+
+static const struct memorystress_profile_s g_profiles[] =
+{
+  {"small", g_small_profile, nitems(g_small_profile)},
+  {"mixed", g_mixed_profile, nitems(g_mixed_profile)},
+  {"large", g_large_profile, nitems(g_large_profile)}
+};
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -117,12 +206,19 @@ static void show_usage(FAR const char *progname)
   printf("\nUsage: %s -m <max allocsize> -n <node length> -t <sleep us>"
          " -d [debuger mode]\n",
         progname);
+  printf("       %s -b <profile|file> [-n <node length>] [-i <iterations>]"
+         " [-j <threads>]\n", progname);
   printf("\nWhere:\n");
   printf("  -m <max-allocsize> max alloc size.\n");
   printf("  -n <node length> Number of allocated memory blocks .\n");
   printf("  -t <sleep us> Length of time between each test.\n");
   printf("  -d [debug mode] Helps to localize the problem situation,"
          "there is a lot of information output in this mode.\n");
+  printf("  -b <profile|file> Benchmark malloc/free with the sizes of a"
+         " built-in profile (small, mixed, large) or of a file of"
+         " \"<size> <weight>\" lines, e.g. summed up from memdump.\n");
+  printf("  -i <iterations> Operations per thread in benchmark mode.\n");
+  printf("  -j <threads> Most threads in benchmark mode, runs 1, 2, 4...\n");
   exit(EXIT_FAILURE);
 }
 
@@ -322,6 +418,381 @@ static bool memorystress_iter(FAR struct memorystress_context_s *context)
   return true;
 }
 
+/****************************************************************************
+ * Name: bench_hist_add
+ ****************************************************************************/
+
+static void bench_hist_add(FAR struct memorystress_hist_s *hist,
+                           uint64_t ns)
+{
+  int shift = 0;
+  int index;
+
+  while ((ns >> shift) >= 2 * BENCH_HIST_SUB)
+    {
+      shift++;
+    }
+
+  index = shift == 0 ? ns :
+          (shift + 1) * BENCH_HIST_SUB + (ns >> shift) - BENCH_HIST_SUB;
+
+  hist->buckets[MIN(index, BENCH_HIST_BUCKETS - 1)]++;
+  hist->max = MAX(hist->max, ns);
+  hist->count++;
+}
+
+/****************************************************************************
+ * Name: bench_hist_merge
+ ****************************************************************************/
+
+static void bench_hist_merge(FAR struct memorystress_hist_s *dest,
+                             FAR const struct memorystress_hist_s *src)
+{
+  int i;
+
+  for (i = 0; i < BENCH_HIST_BUCKETS; i++)
+    {
+      dest->buckets[i] += src->buckets[i];
+    }
+
+  dest->max    = MAX(dest->max, src->max);
+  dest->count += src->count;
+}
+
+/****************************************************************************
+ * Name: bench_hist_percentile
+ ****************************************************************************/
+
+static uint64_t bench_hist_percentile(FAR const struct memorystress_hist_s
+                                      *hist, int percent)
+{
+  uint64_t rank = ((uint64_t)hist->count * percent + 99) / 100;
+  uint64_t seen = 0;
+  int i;
+
+  for (i = 0; i < BENCH_HIST_BUCKETS; i++)
+    {
+      seen += hist->buckets[i];
+      if (seen >= rank && seen > 0)
+        {
+          return i < 2 * BENCH_HIST_SUB ? i :
+                 (uint64_t)(BENCH_HIST_SUB + i % BENCH_HIST_SUB) <<
+                 (i / BENCH_HIST_SUB - 1);
+        }
+    }
+
+  return hist->max;
+}
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static uint64_t bench_now(void)
+{
+  struct timespec ts;
+
+  perf_convert(perf_gettime(), &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_size
+ *
+ * Description:
+ *   Draw a size from the profile.
+ *
+ ****************************************************************************/
+
+static size_t bench_size(FAR const struct memorystress_bench_s *bench,
+                         FAR uint32_t *seed)
+{
+  uint32_t weight = randnum(bench->total_weight, seed);
+  size_t lower;
+  size_t span;
+  size_t i;
+
+  for (i = 0; i < bench->nbuckets - 1 &&
+              weight >= bench->buckets[i].weight; i++)
+    {
+      weight -= bench->buckets[i].weight;
+    }
+
+  lower = i > 0 ? bench->buckets[i - 1].size : 0;
+  span  = bench->buckets[i].size - lower;
+  return lower + 1 + (span > 1 ? randnum(span, seed) : 0);
+}
+
+/****************************************************************************
+ * Name: bench_sample
+ *
+ * Description:
+ *   Print how fragmented the heap is: the largest free chunk against all
+ *   that is free.  mallinfo() walks the heap, so it is not timed.
+ *
+ ****************************************************************************/
+
+static void bench_sample(size_t ops)
+{
+  struct mallinfo info = mallinfo();
+
+  printf("  %8zu ops: used %8d free %8d largest %8d frag %3d%%\n", ops,
+         info.uordblks, info.fordblks, info.mxordblk,
+         info.fordblks > 0 ?
+         100 - (int)((int64_t)info.mxordblk * 100 / info.fordblks) : 0);
+}
+
+/****************************************************************************
+ * Name: bench_worker
+ *
+ * Description:
+ *   Replay the profile: pick a random slot of the live set, allocate it
+ *   when empty and free it otherwise, timing each call.
+ *
+ ****************************************************************************/
+
+static FAR void *bench_worker(FAR void *arg)
+{
+  FAR struct memorystress_worker_s *worker = arg;
+  FAR const struct memorystress_bench_s *bench = worker->bench;
+  FAR struct memorystress_node_s *node;
+  uint64_t start = bench_now();
+  uint64_t begin;
+  size_t i;
+
+  for (i = 0; i < bench->iterations; i++)
+    {
+      node = &worker->node_array[randnum(worker->nodelen, &worker->seed)];
+      if (node->buf == NULL)
+        {
+          node->size = bench_size(bench, &worker->seed);
+
+          begin     = bench_now();
+          node->buf = malloc(node->size);
+          bench_hist_add(&worker->hist[0], bench_now() - begin);
+
+          if (node->buf == NULL)
+            {
+              worker->failures++;
+            }
+        }
+      else
+        {
+          begin = bench_now();
+          free(node->buf);
+          bench_hist_add(&worker->hist[1], bench_now() - begin);
+
+          node->buf = NULL;
+        }
+
+      if (worker->sample && (i + 1) % (bench->iterations / BENCH_SAMPLES +
+                                       1) == 0)
+        {
+          begin = bench_now();
+          bench_sample(i + 1);
+          start += bench_now() - begin;
+        }
+    }
+
+  worker->elapsed_ns = bench_now() - start;
+
+  for (i = 0; i < worker->nodelen; i++)
+    {
+      free(worker->node_array[i].buf);
+      worker->node_array[i].buf = NULL;
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: bench_run
+ ****************************************************************************/
+
+static int bench_run(FAR struct memorystress_context_s *context,
+                     FAR struct memorystress_worker_s *workers,
+                     int nthreads)
+{
+  FAR struct memorystress_bench_s *bench = context->bench;
+  size_t nodelen = context->config->nodelen;
+  struct memorystress_hist_s hist[2];
+  uint64_t elapsed = 0;
+  size_t failures = 0;
+  int ret = 0;
+  int n;
+  int i;
+
+  for (n = 0; n < nthreads; n++)
+    {
+      memset(&workers[n], 0, sizeof(workers[n]));
+      workers[n].bench      = bench;
+      workers[n].node_array = &context->node_array[n * nodelen];
+      workers[n].nodelen    = nodelen;
+      workers[n].seed       = rand() | 1;
+      workers[n].sample     = nthreads == 1;
+
+      ret = pthread_create(&workers[n].thread, NULL, bench_worker,
+                           &workers[n]);
+      if (ret != 0)
+        {
+          syslog(LOG_ERR, MEMSTRESS_PREFIX "pthread_create failed: %d\n",
+                 ret);
+          break;
+        }
+    }
+
+  memset(hist, 0, sizeof(hist));
+  for (i = 0; i < n; i++)
+    {
+      pthread_join(workers[i].thread, NULL);
+      bench_hist_merge(&hist[0], &workers[i].hist[0]);
+      bench_hist_merge(&hist[1], &workers[i].hist[1]);
+      elapsed   = MAX(elapsed, workers[i].elapsed_ns);
+      failures += workers[i].failures;
+    }
+
+  if (ret != 0)
+    {
+      return -ret;
+    }
+
+  printf("%2d threads: %8" PRIu64 " ops/s, malloc p50 %" PRIu64
+         " p99 %" PRIu64 " max %" PRIu64 " ns, free p50 %" PRIu64
+         " p99 %" PRIu64 " max %" PRIu64 " ns, %zu failed\n", nthreads,
+         elapsed > 0 ? (uint64_t)(hist[0].count + hist[1].count) *
+         NSEC_PER_SEC / elapsed : 0,
+         bench_hist_percentile(&hist[0], 50),
+         bench_hist_percentile(&hist[0], 99), hist[0].max,
+         bench_hist_percentile(&hist[1], 50),
+         bench_hist_percentile(&hist[1], 99), hist[1].max, failures);
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: bench_main
+ ****************************************************************************/
+
+static int bench_main(FAR struct memorystress_context_s *context)
+{
+  FAR struct memorystress_bench_s *bench = context->bench;
+  FAR struct memorystress_worker_s *workers;
+  int ret = 0;
+  size_t i;
+  int n;
+
+  workers = malloc(bench->threads * sizeof(*workers));
+  if (workers == NULL)
+    {
+      syslog(LOG_ERR, MEMSTRESS_PREFIX "Malloc workers Failed\n");
+      return EXIT_FAILURE;
+    }
+
+  printf(MEMSTRESS_PREFIX " %zu live blocks, %zu ops per thread, sizes",
+         context->config->nodelen, bench->iterations);
+  for (i = 0; i < bench->nbuckets; i++)
+    {
+      printf(" <=%zu:%" PRIu32, bench->buckets[i].size,
+             bench->buckets[i].weight);
+    }
+
+  printf("\n");
+  bench_sample(0);
+
+  for (n = 1; ret == 0; n = MIN(n * 2, bench->threads))
+    {
+      ret = bench_run(context, workers, n);
+      if (n == bench->threads)
+        {
+          break;
+        }
+    }
+
+  free(workers);
+  return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/****************************************************************************
+ * Name: bench_compare
+ ****************************************************************************/
+
+static int bench_compare(FAR const void *a, FAR const void *b)
+{
+  FAR const struct memorystress_bucket_s *x = a;
+  FAR const struct memorystress_bucket_s *y = b;
+
+  return x->size < y->size ? -1 : x->size > y->size;
+}
+
+/****************************************************************************
+ * Name: bench_profile
+ *
+ * Description:
+ *   Take the size classes of a built-in profile, or else read them from
+ *   the file of that name.
+ *
+ ****************************************************************************/
+
+static int bench_profile(FAR struct memorystress_bench_s *bench,
+                         FAR const char *name)
+{
+  unsigned long weight;
+  unsigned long size;
+  char line[64];
+  FAR FILE *fp;
+  size_t i;
+
+  bench->nbuckets = 0;
+  for (i = 0; i < nitems(g_profiles); i++)
+    {
+      if (strcmp(name, g_profiles[i].name) == 0)
+        {
+          memcpy(bench->buckets, g_profiles[i].buckets,
+                 g_profiles[i].nbuckets * sizeof(bench->buckets[0]));
+          bench->nbuckets = g_profiles[i].nbuckets;
+          break;
+        }
+    }
+
+  if (bench->nbuckets == 0)
+    {
+      fp = fopen(name, "r");
+      if (fp == NULL)
+        {
+          return -errno;
+        }
+
+      while (fgets(line, sizeof(line), fp) != NULL &&
+             bench->nbuckets < BENCH_MAX_BUCKETS)
+        {
+          if (sscanf(line, "%lu %lu", &size, &weight) == 2 && size > 0 &&
+              weight > 0)
+            {
+              bench->buckets[bench->nbuckets].size   = size;
+              bench->buckets[bench->nbuckets].weight = weight;
+              bench->nbuckets++;
+            }
+        }
+
+      fclose(fp);
+      if (bench->nbuckets == 0)
+        {
+          return -EINVAL;
+        }
+
+      qsort(bench->buckets, bench->nbuckets, sizeof(bench->buckets[0]),
+            bench_compare);
+    }
+
+  bench->total_weight = 0;
+  for (i = 0; i < bench->nbuckets; i++)
+    {
+      bench->total_weight += bench->buckets[i].weight;
+    }
+
+  return OK;
+}
+
 /****************************************************************************
  * Name: debug_malloc
  ****************************************************************************/
@@ -377,6 +848,9 @@ static void init(FAR struct memorystress_context_s *context, int argc,
 {
   FAR struct memorystress_config_s *config;
   FAR struct memorystress_func_s *func;
+  FAR const char *profile = NULL;
+  size_t iterations = BENCH_DEFAULT_ITERATIONS;
+  int threads = 1;
   int ch;
 
   memset(context, 0, sizeof(struct memorystress_context_s));
@@ -390,7 +864,7 @@ static void init(FAR struct memorystress_context_s *context, int argc,
       exit(EXIT_FAILURE);
     }
 
-  while ((ch = getopt(argc, argv, "dm:n:t:")) != ERROR)
+  while ((ch = getopt(argc, argv, "dm:n:t:b:i:j:")) != ERROR)
     {
       switch (ch)
         {
@@ -406,14 +880,46 @@ static void init(FAR struct memorystress_context_s *context, int argc,
           case 't':
             OPTARG_TO_VALUE(context->sleep_us, uint32_t);
             break;
+          case 'b':
+            profile = optarg;
+            break;
+          case 'i':
+            OPTARG_TO_VALUE(iterations, size_t);
+            break;
+          case 'j':
+            OPTARG_TO_VALUE(threads, int);
+            break;
           default:
             show_usage(argv[0]);
             break;
         }
     }
 
-  if (config->max_allocsize == 0 || config->nodelen == 0 ||
-      context->sleep_us == 0)
+  if (profile != NULL)
+    {
+      /* Benchmark mode, each thread has a live set of nodelen blocks */
+
+      if (config->nodelen == 0)
+        {
+          config->nodelen = BENCH_DEFAULT_NODELEN;
+        }
+
+      context->bench = zalloc(sizeof(struct memorystress_bench_s));
+      if (context->bench == NULL || iterations == 0 || threads <= 0 ||
+          bench_profile(context->bench, profile) < 0)
+        {
+          syslog(LOG_ERR, MEMSTRESS_PREFIX "Bad profile %s\n", profile);
+          free(context->bench);
+          free(config);
+          free(func);
+          show_usage(argv[0]);
+        }
+
+      context->bench->iterations = iterations;
+      context->bench->threads    = threads;
+    }
+  else if (config->max_allocsize == 0 || config->nodelen == 0 ||
+           context->sleep_us == 0)
     {
       free(config);
       free(func);
@@ -442,7 +948,7 @@ static void init(FAR struct memorystress_context_s *context, int argc,
 
   /* init node array */
 
-  context->node_array = zalloc(config->nodelen *
+  context->node_array = zalloc(config->nodelen * threads *
                                sizeof(struct memorystress_node_s));
   if (context->node_array == NULL)
     {
@@ -470,6 +976,11 @@ int main(int argc, FAR char *argv[])
 
   init(&context, argc, argv);
 
+  if (context.bench != NULL)
+    {
+      return bench_main(&context);
+    }
+
   syslog(LOG_INFO, MEMSTRESS_PREFIX "testing...\n");
 
   while (memorystress_iter(&context))
@@ -27,6 +27,7 @@
 #include <string.h>
 #include <inttypes.h>
 #include "monkey.h"
+#include "monkey_bench.h"
 #include "monkey_recorder.h"
 #include "monkey_assert.h"
 #include "monkey_log.h"
@@ -119,6 +120,14 @@ void monkey_delete(FAR struct monkey_s *monkey)
       monkey->recorder = NULL;
     }
 
+#ifdef CONFIG_TESTING_MONKEY_BENCH
+  if (monkey->bench)
+    {
+      monkey_bench_delete(monkey->bench);
+      monkey->bench = NULL;
+    }
+#endif
+
   free(monkey);
   MONKEY_LOG_NOTICE("OK");
 }
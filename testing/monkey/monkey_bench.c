@@ -0,0 +1,227 @@
+/****************************************************************************
+ * apps/testing/monkey/monkey_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/param.h>
+#include "monkey_assert.h"
+#include "monkey_bench.h"
+#include "monkey_log.h"
+
+#ifdef CONFIG_TESTING_MONKEY_BENCH
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: monkey_bench_add
+ ****************************************************************************/
+
+static void monkey_bench_add(FAR struct monkey_bench_s *bench,
+                             uint32_t us)
+{
+  uint32_t index = us / MONKEY_BENCH_BUCKET_US;
+
+  bench->hist[index < MONKEY_BENCH_BUCKETS ?
+              index : MONKEY_BENCH_BUCKETS - 1]++;
+  bench->frames++;
+  if (us > bench->max_us)
+    {
+      bench->max_us = us;
+    }
+}
+
+/****************************************************************************
+ * Name: monkey_bench_drain
+ ****************************************************************************/
+
+static void monkey_bench_drain(FAR struct monkey_bench_s *bench, bool add)
+{
+  struct timespec now;
+  uint32_t us;
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  while (mq_timedreceive(bench->mq, (FAR char *)&us, sizeof(us),
+                         NULL, &now) == sizeof(us))
+    {
+      if (add)
+        {
+          monkey_bench_add(bench, us);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: monkey_bench_percentile
+ *
+ * Description:
+ *   Upper bound of the bucket that holds the pct percentile.
+ *
+ ****************************************************************************/
+
+static uint32_t monkey_bench_percentile(FAR const struct monkey_bench_s
+                                        *bench, int pct)
+{
+  uint32_t target = ((uint64_t)bench->frames * pct + 99) / 100;
+  uint32_t count = 0;
+  int i;
+
+  for (i = 0; i < MONKEY_BENCH_BUCKETS - 1; i++)
+    {
+      count += bench->hist[i];
+      if (count >= target)
+        {
+          return MIN((i + 1) * MONKEY_BENCH_BUCKET_US, bench->max_us);
+        }
+    }
+
+  return bench->max_us;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: monkey_bench_create
+ ****************************************************************************/
+
+FAR struct monkey_bench_s *monkey_bench_create(FAR const char *mq_name,
+                                               int runs)
+{
+  FAR struct monkey_bench_s *bench;
+  struct mq_attr attr;
+
+  MONKEY_ASSERT_NULL(mq_name);
+
+  bench = calloc(1, sizeof(struct monkey_bench_s));
+  MONKEY_ASSERT_NULL(bench);
+
+  /* The same attributes as the LVGL port, whichever opens it first */
+
+  memset(&attr, 0, sizeof(attr));
+  attr.mq_maxmsg = 32;
+  attr.mq_msgsize = sizeof(uint32_t);
+  bench->mq = mq_open(mq_name, O_RDONLY | O_CREAT, 0666, &attr);
+  if (bench->mq == (mqd_t)-1)
+    {
+      MONKEY_LOG_ERROR("open %s failed: %d", mq_name, errno);
+      free(bench);
+      return NULL;
+    }
+
+  bench->runs = runs;
+
+  /* Frames rendered before the playback don't count */
+
+  monkey_bench_drain(bench, false);
+
+  MONKEY_LOG_NOTICE("collecting frame times from %s", mq_name);
+  return bench;
+}
+
+/****************************************************************************
+ * Name: monkey_bench_delete
+ ****************************************************************************/
+
+void monkey_bench_delete(FAR struct monkey_bench_s *bench)
+{
+  MONKEY_ASSERT_NULL(bench);
+  mq_close(bench->mq);
+  free(bench);
+}
+
+/****************************************************************************
+ * Name: monkey_bench_wait
+ ****************************************************************************/
+
+int monkey_bench_wait(FAR struct monkey_bench_s *bench, uint32_t ms)
+{
+  struct timespec deadline;
+  uint32_t us;
+
+  MONKEY_ASSERT_NULL(bench);
+
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += ms / 1000;
+  deadline.tv_nsec += (ms % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000)
+    {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+
+  /* Wait in the queue, so that it never fills up while waiting */
+
+  while (mq_timedreceive(bench->mq, (FAR char *)&us, sizeof(us),
+                         NULL, &deadline) == sizeof(us))
+    {
+      monkey_bench_add(bench, us);
+    }
+
+  return errno == ETIMEDOUT ? 0 : -errno;
+}
+
+/****************************************************************************
+ * Name: monkey_bench_end_run
+ ****************************************************************************/
+
+bool monkey_bench_end_run(FAR struct monkey_bench_s *bench)
+{
+  MONKEY_ASSERT_NULL(bench);
+
+  monkey_bench_drain(bench, true);
+
+  if (bench->frames == 0)
+    {
+      printf("run %d: no frames\n", bench->run + 1);
+    }
+  else
+    {
+      printf("run %d: %" PRIu32 " frames, frame time(us):"
+             " p50 %" PRIu32 " p90 %" PRIu32 " p99 %" PRIu32
+             " max %" PRIu32 "\n",
+             bench->run + 1, bench->frames,
+             monkey_bench_percentile(bench, 50),
+             monkey_bench_percentile(bench, 90),
+             monkey_bench_percentile(bench, 99),
+             bench->max_us);
+    }
+
+  bench->frames = 0;
+  bench->max_us = 0;
+  memset(bench->hist, 0, sizeof(bench->hist));
+
+  bench->run++;
+  return bench->runs == 0 || bench->run < bench->runs;
+}
+
+#endif /* CONFIG_TESTING_MONKEY_BENCH */
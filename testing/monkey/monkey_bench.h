@@ -0,0 +1,112 @@
+/****************************************************************************
+ * apps/testing/monkey/monkey_bench.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_TESTING_MONKEY_MONKEY_BENCH_H
+#define __APPS_TESTING_MONKEY_MONKEY_BENCH_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <mqueue.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Frame time histogram: 100 us buckets up to 100 ms */
+
+#define MONKEY_BENCH_BUCKET_US  100
+#define MONKEY_BENCH_BUCKETS    1000
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Frame times of the runs of a playback, as sent by the LVGL port
+ * (CONFIG_LV_PORT_FBDEV_STATS_MQUEUE), one uint32_t in microseconds per
+ * frame.
+ */
+
+struct monkey_bench_s
+{
+  mqd_t mq;
+  int run;
+  int runs;                     /* Number of runs, 0 for unlimited */
+  uint32_t frames;
+  uint32_t max_us;
+  uint32_t hist[MONKEY_BENCH_BUCKETS];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: monkey_bench_create
+ ****************************************************************************/
+
+FAR struct monkey_bench_s *monkey_bench_create(FAR const char *mq_name,
+                                               int runs);
+
+/****************************************************************************
+ * Name: monkey_bench_delete
+ ****************************************************************************/
+
+void monkey_bench_delete(FAR struct monkey_bench_s *bench);
+
+/****************************************************************************
+ * Name: monkey_bench_wait
+ *
+ * Description:
+ *   Collect frame times for ms milliseconds.  Returns 0 when the time is
+ *   over, or a negated errno value, -EINTR when interrupted.
+ *
+ ****************************************************************************/
+
+int monkey_bench_wait(FAR struct monkey_bench_s *bench, uint32_t ms);
+
+/****************************************************************************
+ * Name: monkey_bench_end_run
+ *
+ * Description:
+ *   Report the frame times of the run that ended and start the next one.
+ *   Returns false when all the runs are done.
+ *
+ ****************************************************************************/
+
+bool monkey_bench_end_run(FAR struct monkey_bench_s *bench);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_TESTING_MONKEY_MONKEY_BENCH_H */
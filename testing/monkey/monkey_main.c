@@ -36,6 +36,7 @@
 #include <string.h>
 #include <sys/ioctl.h>
 #include "monkey.h"
+#include "monkey_bench.h"
 #include "monkey_utils.h"
 #include "monkey_log.h"
 
@@ -132,6 +133,8 @@ struct monkey_param_s
   int period_max;
   int btn_bit;
   int log_level;
+  FAR const char *bench_mq;
+  int bench_runs;
   struct monkey_event_config_s event[MONKEY_EVENT_LAST];
 };
 
@@ -159,7 +162,12 @@ static void show_usage(FAR const char *progname, int exitcode)
          " -p <string>"
          " -s <string>"
          " -b <decimal-value>"
-         " -l <decimal-value>\n"
+         " -l <decimal-value>"
+#ifdef CONFIG_TESTING_MONKEY_BENCH
+         " -m <string>"
+         " -n <decimal-value>"
+#endif
+         "\n"
          " --weight-click <decimal-value>"
          " --weight-longpress <decimal-value>"
          " --weight-drag <decimal-value>\n"
@@ -182,6 +190,11 @@ static void show_usage(FAR const char *progname, int exitcode)
          "<decimal-value hor_res>x<decimal-value ver_res>\n");
   printf("  -b <decimal-value> Button bit: 0 ~ 31\n");
   printf("  -l <decimal-value> Log level: 0 ~ 3\n");
+#ifdef CONFIG_TESTING_MONKEY_BENCH
+  printf("  -m <string> Frame time message queue of the LVGL port:"
+         " report frame time percentiles of each playback run.\n");
+  printf("  -n <decimal-value> Number of playback runs, 0 = endless.\n");
+#endif
 
   printf("  --weight-click <decimal-value> Click event weight.\n");
   printf("  --weight-longpress <decimal-value> Long press event weight.\n");
@@ -302,6 +315,18 @@ static FAR struct monkey_s *monkey_init(
             {
               goto failed;
             }
+
+#ifdef CONFIG_TESTING_MONKEY_BENCH
+          if (param->bench_mq)
+            {
+              monkey->bench = monkey_bench_create(param->bench_mq,
+                                                  param->bench_runs);
+              if (!monkey->bench)
+                {
+                  goto failed;
+                }
+            }
+#endif
         }
       else
         {
@@ -376,7 +401,7 @@ static void parse_commandline(int argc, FAR char **argv,
 {
   int ch;
   int longindex = 0;
-  FAR const char *optstring = "t:f:p:s:b:l:";
+  FAR const char *optstring = "t:f:p:s:b:l:m:n:";
   const struct option longopts[] =
     {
       {"weight-click",       required_argument, NULL, 0 },
@@ -435,6 +460,16 @@ static void parse_commandline(int argc, FAR char **argv,
                                          MONKEY_LOG_LEVEL_LAST - 1);
             break;
 
+#ifdef CONFIG_TESTING_MONKEY_BENCH
+          case 'm':
+            param->bench_mq = optarg;
+            break;
+
+          case 'n':
+            OPTARG_TO_VALUE(param->bench_runs, int, 10);
+            break;
+#endif
+
           case '?':
             MONKEY_LOG_WARN("Unknown option: %c", optopt);
             show_usage(argv[0], EXIT_FAILURE);
@@ -548,7 +583,19 @@ int main(int argc, FAR char *argv[])
           break;
         }
 
-      res = monkey_wait(sleep_ms);
+#ifdef CONFIG_TESTING_MONKEY_BENCH
+      if (monkey->bench)
+        {
+          /* Collect frame times while waiting; no pause in this mode */
+
+          res = monkey_bench_wait(monkey->bench, sleep_ms) < 0 ?
+                MONKEY_WAIT_RES_STOP : MONKEY_WAIT_RES_AGAIN;
+        }
+      else
+#endif
+        {
+          res = monkey_wait(sleep_ms);
+        }
 
       if (res == MONKEY_WAIT_RES_AGAIN)
         {
@@ -28,6 +28,7 @@
 #include <string.h>
 #include "monkey.h"
 #include "monkey_assert.h"
+#include "monkey_bench.h"
 #include "monkey_dev.h"
 #include "monkey_event.h"
 #include "monkey_log.h"
@@ -107,6 +108,9 @@ static int monkey_recorder_get_next(FAR struct monkey_s *monkey,
           MONKEY_LOG_ERROR("read first line failed: %d", res);
           return 0;
         }
+
+      monkey->playback_ctx.base_time_stamp = *cur_time_stamp_p;
+      monkey->playback_ctx.base_tick = monkey_tick_get();
     }
   else
     {
@@ -147,6 +151,7 @@ static bool monkey_update_uinput_playback(FAR struct monkey_s *monkey)
   struct monkey_dev_state_s next_state;
 
   uint32_t tick_elaps;
+  uint32_t elapsed;
   FAR struct monkey_dev_s *dev;
 
   int num_of_get;
@@ -178,8 +183,32 @@ static bool monkey_update_uinput_playback(FAR struct monkey_s *monkey)
             MONKEY_LOG_WARN("unsupport device type: %d", cur_state.type);
           }
 
-        tick_elaps = monkey_tick_elaps(next_time_stamp, cur_time_stamp);
+        /* Time the next event from the first one rather than from this
+         * one, so that the time spent replaying does not add up.
+         */
+
+        tick_elaps = monkey_tick_elaps(next_time_stamp,
+                                       monkey->playback_ctx.base_time_stamp);
+        elapsed = monkey_tick_elaps(monkey_tick_get(),
+                                    monkey->playback_ctx.base_tick);
+        if (num_of_get == 1 || tick_elaps < elapsed)
+          {
+            tick_elaps = 0;
+          }
+        else
+          {
+            tick_elaps -= elapsed;
+          }
+
         monkey_set_period(monkey, tick_elaps);
+
+#ifdef CONFIG_TESTING_MONKEY_BENCH
+        if (num_of_get == 1 && monkey->bench &&
+            !monkey_bench_end_run(monkey->bench))
+          {
+            return false;
+          }
+#endif
         break;
 
       default:
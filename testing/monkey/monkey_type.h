@@ -43,6 +43,7 @@
 
 struct monkey_dev_s;
 struct monkey_recorder_s;
+struct monkey_bench_s;
 
 enum monkey_mode_e
 {
@@ -120,10 +121,13 @@ struct monkey_s
   FAR struct monkey_dev_s *devs[MONKEY_DEV_MAX_NUM];
   int dev_num;
   FAR struct monkey_recorder_s *recorder;
+  FAR struct monkey_bench_s *bench;
   struct
   {
     struct monkey_dev_state_s state;
     uint32_t time_stamp;
+    uint32_t base_time_stamp;   /* Time stamp of the first event */
+    uint32_t base_tick;         /* When the first event was replayed */
   } playback_ctx;
 };
 
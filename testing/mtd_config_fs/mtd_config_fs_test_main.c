@@ -30,6 +30,7 @@
 #include <sys/ioctl.h>
 #include <sys/statfs.h>
 
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,6 +39,7 @@
 #include <fcntl.h>
 #include <dirent.h>
 #include <string.h>
+#include <time.h>
 #include <errno.h>
 #include <nuttx/crc8.h>
 #include <debug.h>
@@ -83,6 +85,23 @@ struct mtdnvs_ctx_s
   uint8_t         erasestate;
 };
 
+#ifdef CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE
+/* Profiling wrapper stacked between mtdconfig and the flash */
+
+struct mtdnvs_prof_s
+{
+  struct mtd_dev_s dev;           /* Must be first */
+  FAR struct mtd_dev_s *under;    /* The real flash */
+  uint32_t blocksize;             /* Size of a bwrite() block */
+  uint64_t nwritten;              /* Bytes programmed */
+  uint32_t nerased;               /* Erase blocks erased */
+  uint64_t lastwritten;           /* nwritten at the last report */
+  uint32_t lasterased;            /* nerased at the last report */
+  uint32_t intervalmax;           /* Slowest write since the last report */
+  int nops;                       /* Config writes */
+};
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -2447,6 +2466,310 @@ test_fail:
   printf("%s: failed\n", __func__);
 }
 
+#ifdef CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE
+
+/****************************************************************************
+ * Name: mtdnvs_now
+ *
+ * Description:
+ *   Return the monotonic time in microseconds.
+ *
+ ****************************************************************************/
+
+static uint64_t mtdnvs_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: mtdnvs_prof_*
+ *
+ * Description:
+ *   MTD methods of the profiling wrapper: count what is programmed and
+ *   erased and forward everything to the real flash.
+ *
+ ****************************************************************************/
+
+static int mtdnvs_prof_erase(FAR struct mtd_dev_s *dev, off_t startblock,
+                             size_t nblocks)
+{
+  FAR struct mtdnvs_prof_s *prof = (FAR struct mtdnvs_prof_s *)dev;
+
+  prof->nerased += nblocks;
+  return MTD_ERASE(prof->under, startblock, nblocks);
+}
+
+static ssize_t mtdnvs_prof_bread(FAR struct mtd_dev_s *dev,
+                                 off_t startblock, size_t nblocks,
+                                 FAR uint8_t *buffer)
+{
+  FAR struct mtdnvs_prof_s *prof = (FAR struct mtdnvs_prof_s *)dev;
+
+  return MTD_BREAD(prof->under, startblock, nblocks, buffer);
+}
+
+static ssize_t mtdnvs_prof_bwrite(FAR struct mtd_dev_s *dev,
+                                  off_t startblock, size_t nblocks,
+                                  FAR const uint8_t *buffer)
+{
+  FAR struct mtdnvs_prof_s *prof = (FAR struct mtdnvs_prof_s *)dev;
+
+  prof->nwritten += (uint64_t)nblocks * prof->blocksize;
+  return MTD_BWRITE(prof->under, startblock, nblocks, buffer);
+}
+
+static ssize_t mtdnvs_prof_read(FAR struct mtd_dev_s *dev, off_t offset,
+                                size_t nbytes, FAR uint8_t *buffer)
+{
+  FAR struct mtdnvs_prof_s *prof = (FAR struct mtdnvs_prof_s *)dev;
+
+  return MTD_READ(prof->under, offset, nbytes, buffer);
+}
+
+#ifdef CONFIG_MTD_BYTE_WRITE
+static ssize_t mtdnvs_prof_write(FAR struct mtd_dev_s *dev, off_t offset,
+                                 size_t nbytes, FAR const uint8_t *buffer)
+{
+  FAR struct mtdnvs_prof_s *prof = (FAR struct mtdnvs_prof_s *)dev;
+
+  prof->nwritten += nbytes;
+  return MTD_WRITE(prof->under, offset, nbytes, buffer);
+}
+#endif
+
+static int mtdnvs_prof_ioctl(FAR struct mtd_dev_s *dev, int cmd,
+                             unsigned long arg)
+{
+  FAR struct mtdnvs_prof_s *prof = (FAR struct mtdnvs_prof_s *)dev;
+
+  return MTD_IOCTL(prof->under, cmd, arg);
+}
+
+/****************************************************************************
+ * Name: mtdnvs_prof_report
+ *
+ * Description:
+ *   Show the write amplification, the garbage collections and the rate of
+ *   the last interval.
+ *
+ ****************************************************************************/
+
+static void mtdnvs_prof_report(FAR struct mtdnvs_prof_s *prof, int nops,
+                               uint64_t elapsed)
+{
+  uint64_t written = prof->nwritten - prof->lastwritten;
+  uint64_t payload = (uint64_t)nops *
+                     CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_VALSIZE;
+
+  printf("%8d %8" PRIu64 " %4" PRIu64 ".%02" PRIu64 " %6" PRIu32
+         " %8" PRIu32 "\n", prof->nops,
+         elapsed > 0 ? nops * UINT64_C(1000000) / elapsed : 0,
+         written / payload, written * 100 / payload % 100,
+         prof->nerased - prof->lasterased, prof->intervalmax);
+
+  prof->lastwritten = prof->nwritten;
+  prof->lasterased  = prof->nerased;
+  prof->intervalmax = 0;
+}
+
+/****************************************************************************
+ * Name: test_nvs_profile
+ * Description: Profile the write amplification, the GC pauses and the
+ *              throughput of a partition under continuous updates.
+ ****************************************************************************/
+
+static void test_nvs_profile(struct mtdnvs_ctx_s *ctx)
+{
+  FAR struct mtdnvs_prof_s *prof;
+  FAR struct inode *sys_node;
+  struct mtd_geometry_s geo;
+  struct config_data_s data;
+  uint8_t buf[CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_VALSIZE];
+  uint64_t intervalstart;
+  uint64_t start;
+  uint32_t delta;
+  uint32_t gcmin = UINT32_MAX;
+  uint32_t gcmax = 0;
+  uint64_t gcsum = 0;
+  uint32_t ngc = 0;
+  uint32_t nerased;
+  int fd = -1;
+  int ret;
+  int i;
+
+  printf("%s: test begin\n", __func__);
+
+  prof = zalloc(sizeof(struct mtdnvs_prof_s));
+  if (prof == NULL)
+    {
+      printf("%s:zalloc failed\n", __func__);
+      goto test_fail;
+    }
+
+  ret = find_mtddriver(CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_MOUNTPT_NAME,
+                       &sys_node);
+  if (ret < 0)
+    {
+      printf("%s:open %s failed: %d\n", __func__,
+             CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_MOUNTPT_NAME, ret);
+      goto test_fail;
+    }
+
+  ret = MTD_IOCTL(sys_node->u.i_mtd, MTDIOC_GEOMETRY,
+                  (unsigned long)((uintptr_t)&geo));
+  if (ret < 0)
+    {
+      printf("%s:MTDIOC_GEOMETRY failed: %d\n", __func__, ret);
+      goto test_fail;
+    }
+
+  ret = MTD_IOCTL(sys_node->u.i_mtd, MTDIOC_ERASESTATE,
+                  (unsigned long)((uintptr_t)&ctx->erasestate));
+  if (ret < 0)
+    {
+      printf("%s:MTDIOC_ERASESTATE failed: %d\n", __func__, ret);
+      goto test_fail;
+    }
+
+  /* Stack the counting wrapper on the real flash */
+
+  prof->under       = sys_node->u.i_mtd;
+  prof->blocksize   = geo.blocksize;
+  prof->dev.erase   = mtdnvs_prof_erase;
+  prof->dev.bread   = mtdnvs_prof_bread;
+  prof->dev.bwrite  = mtdnvs_prof_bwrite;
+  prof->dev.read    = prof->under->read ? mtdnvs_prof_read : NULL;
+#ifdef CONFIG_MTD_BYTE_WRITE
+  prof->dev.write   = prof->under->write ? mtdnvs_prof_write : NULL;
+#endif
+  prof->dev.ioctl   = mtdnvs_prof_ioctl;
+  prof->dev.name    = "mtdnvs_prof";
+
+  ret = mtdconfig_register(&prof->dev);
+  if (ret < 0)
+    {
+      printf("%s:mtdconfig_register failed, ret=%d\n", __func__, ret);
+      goto test_fail;
+    }
+
+  fd = open("/dev/config", 0);
+  if (fd < 0)
+    {
+      printf("%s:open failed, ret=%d\n", __func__, fd);
+      goto test_fail_teardown;
+    }
+
+  printf("%d keys of %d bytes, %" PRIu32 " sectors of %" PRIu32
+         " bytes\n", CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_NKEYS,
+         CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_VALSIZE,
+         geo.neraseblocks, geo.erasesize);
+  printf("  WRITES    OPS/S   WAMP ERASES  MAX(us)\n");
+
+  /* Mounting already wrote to the flash, start from a clean count */
+
+  prof->nwritten    = 0;
+  prof->nerased     = 0;
+  prof->lastwritten = 0;
+  prof->lasterased  = 0;
+
+  intervalstart = mtdnvs_now();
+  for (i = 0; i < CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_NWRITES; i++)
+    {
+      /* Always change the value, identical values are not rewritten */
+
+      memset(buf, i / CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_NKEYS,
+             sizeof(buf));
+      snprintf(data.name, sizeof(data.name), "prof%d",
+               i % CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_NKEYS);
+      data.configdata = buf;
+      data.len = sizeof(buf);
+
+      nerased = prof->nerased;
+      start = mtdnvs_now();
+      ret = ioctl(fd, CFGDIOC_SETCONFIG, &data);
+      delta = mtdnvs_now() - start;
+      if (ret != 0)
+        {
+          printf("%s:CFGDIOC_SETCONFIG failed at %d, ret=%d\n",
+                 __func__, i, ret);
+          goto test_fail_teardown;
+        }
+
+      prof->nops++;
+      if (delta > prof->intervalmax)
+        {
+          prof->intervalmax = delta;
+        }
+
+      /* A write that erased a sector ran a garbage collection */
+
+      if (prof->nerased != nerased)
+        {
+          ngc++;
+          gcsum += delta;
+          gcmin = delta < gcmin ? delta : gcmin;
+          gcmax = delta > gcmax ? delta : gcmax;
+        }
+
+      if (delta > CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_WARN_US)
+        {
+          printf("WARNING: write %d stalled %" PRIu32 " us\n", i, delta);
+        }
+
+      if (prof->nops % CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_INTERVAL
+          == 0)
+        {
+          mtdnvs_prof_report(prof,
+                CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_INTERVAL,
+                mtdnvs_now() - intervalstart);
+          intervalstart = mtdnvs_now();
+        }
+    }
+
+  printf("Total: %" PRIu64 " bytes programmed for %" PRIu64
+         " bytes of config, %" PRIu32 " erases\n", prof->nwritten,
+         (uint64_t)prof->nops *
+         CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE_VALSIZE,
+         prof->nerased);
+  if (ngc > 0)
+    {
+      printf("GC pauses: %" PRIu32 ", min %" PRIu32 " avg %" PRIu64
+             " max %" PRIu32 " us\n", ngc, gcmin, gcsum / ngc, gcmax);
+    }
+
+  close(fd);
+  fd = -1;
+
+  /* at the end of test, erase all blocks */
+
+  ret = teardown();
+  if (ret < 0)
+    {
+      printf("%s:teardown failed, ret=%d\n", __func__, ret);
+      goto test_fail;
+    }
+
+  free(prof);
+  printf("%s: success\n", __func__);
+  return;
+
+test_fail_teardown:
+  if (fd >= 0)
+    {
+      close(fd);
+    }
+
+  teardown();
+
+test_fail:
+  free(prof);
+  printf("%s: failed\n", __func__);
+}
+#endif /* CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE */
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -2515,6 +2838,9 @@ int main(int argc, FAR char *argv[])
   test_nvs_gc_touched_deleted_ate(ctx);
   test_nvs_gc_touched_expired_ate(ctx);
   test_nvs_gc_not_touched_expired_ate(ctx);
+#ifdef CONFIG_TESTING_MTD_CONFIG_FAIL_SAFE_PROFILE
+  test_nvs_profile(ctx);
+#endif
 
   /* Show memory usage */
 
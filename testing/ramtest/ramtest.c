@@ -32,10 +32,13 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sched.h>
 #include <syslog.h>
+#include <time.h>
 #include <errno.h>
 
+#include <nuttx/cache.h>
 #include <nuttx/usb/usbdev_trace.h>
 
 #ifdef CONFIG_TESTING_RAMTEST
@@ -46,6 +49,10 @@
 
 #define RAMTEST_PREFIX "RAMTest: "
 
+/* Slices tested by different threads do not share cache lines */
+
+#define RAMTEST_SLICE_ALIGN 64
+
 #define OPTARG_TO_VALUE(value, type) \
   do \
   { \
@@ -70,6 +77,12 @@ struct ramtest_s
   size_t nxfrs;
   uint32_t mask;
   bool free;
+  bool flush;
+  int nthreads;
+  uint64_t bytes;
+#ifdef CONFIG_SMP
+  int cpu;
+#endif
 };
 
 /****************************************************************************
@@ -94,9 +107,42 @@ static void show_usage(FAR const char *progname, int exitcode)
   printf("  -w Sets the width of a memory location to 32-bits.\n");
   printf("  -h Sets the width of a memory location to 16-bits (default).\n");
   printf("  -b Sets the width of a memory location to 8-bits.\n");
+#ifndef CONFIG_DISABLE_PTHREAD
+  printf("  -t <threads> splits the memory between threads, pinned to\n"
+         "     different CPUs (default 1).\n");
+#endif
+#ifdef CONFIG_ARCH_DCACHE
+  printf("  -c Flushes the data cache after writing, so that the values\n"
+         "     are read back from the memory and not from the cache.\n");
+#endif
   exit(exitcode);
 }
 
+/****************************************************************************
+ * Name: set_nxfrs
+ *
+ * Description:
+ *   Convert the size (in bytes) to the corresponding number of transfers
+ *   of the selected width.
+ *
+ ****************************************************************************/
+
+static void set_nxfrs(FAR struct ramtest_s *info)
+{
+  if (info->width == 8)
+    {
+      info->nxfrs = info->size;
+    }
+  else if (info->width == 32)
+    {
+      info->nxfrs = info->size >> 2;
+    }
+  else
+    {
+      info->nxfrs = info->size >> 1;
+    }
+}
+
 /****************************************************************************
  * Name: parse_commandline
  ****************************************************************************/
@@ -106,7 +152,7 @@ static void parse_commandline(int argc, char **argv,
 {
   int option;
 
-  while ((option = getopt(argc, argv, "whba::s:")) != ERROR)
+  while ((option = getopt(argc, argv, "whbca::s:t:")) != ERROR)
     {
       switch (option)
         {
@@ -128,6 +174,16 @@ static void parse_commandline(int argc, char **argv,
           case 's':
             OPTARG_TO_VALUE(info->size, size_t);
             break;
+#ifdef CONFIG_ARCH_DCACHE
+          case 'c':
+            info->flush = true;
+            break;
+#endif
+#ifndef CONFIG_DISABLE_PTHREAD
+          case 't':
+            OPTARG_TO_VALUE(info->nthreads, int);
+            break;
+#endif
           case '?':
             printf(RAMTEST_PREFIX "Unrecognized option: '%c'\n", option);
             show_usage(argv[0], EXIT_FAILURE);
@@ -160,23 +216,40 @@ static void parse_commandline(int argc, char **argv,
       info->free = true;
     }
 
-  /* Convert the size (in bytes) to the corresponding number of transfers
-   * of the selected width.
-   */
-
-  if (info->width == 8)
+  if (info->nthreads < 1)
     {
-      info->nxfrs = info->size;
+      info->nthreads = 1;
     }
-  else if (info->width == 32)
+
+  if (info->width != 8 && info->width != 32)
     {
-      info->nxfrs = info->size >> 2;
+      info->width = 16;
     }
-  else
+
+  set_nxfrs(info);
+}
+
+/****************************************************************************
+ * Name: flush_memory
+ *
+ * Description:
+ *   Write back and discard the cached copy of the memory under test, so
+ *   that the following verification really reads the memory.
+ *
+ ****************************************************************************/
+
+static void flush_memory(FAR struct ramtest_s *info)
+{
+#ifdef CONFIG_ARCH_DCACHE
+  if (info->flush)
     {
-      info->width = 16;
-      info->nxfrs = info->size >> 1;
+      up_flush_dcache(info->start, info->start + info->size);
     }
+#endif
+
+  /* One pass to write and one pass to verify */
+
+  info->bytes += 2 * (uint64_t)info->size;
 }
 
 /****************************************************************************
@@ -287,6 +360,7 @@ static void marching_ones(FAR struct ramtest_s *info)
   while (pattern != 0)
     {
       write_memory(info, pattern);
+      flush_memory(info);
       verify_memory(info, pattern);
       pattern <<= 1;
       pattern &= info->mask;
@@ -307,6 +381,7 @@ static void marching_zeros(FAR struct ramtest_s *info)
   while (pattern != 0xffffffff)
     {
       write_memory(info, pattern);
+      flush_memory(info);
       verify_memory(info, pattern);
       pattern <<= 1;
       pattern |= 1;
@@ -441,6 +516,7 @@ static void pattern_test(FAR struct ramtest_s *info, uint32_t pattern1,
          info->start, info->size, pattern1, pattern2);
 
   write_memory2(info, pattern1, pattern2);
+  flush_memory(info);
   verify_memory2(info, pattern1, pattern2);
 }
 
@@ -552,9 +628,124 @@ static void addr_in_addr(FAR struct ramtest_s *info)
          info->start, info->size);
 
   write_addrinaddr(info);
+  flush_memory(info);
   verify_addrinaddr(info);
 }
 
+/****************************************************************************
+ * Name: run_tests
+ ****************************************************************************/
+
+static void run_tests(FAR struct ramtest_s *info)
+{
+  marching_ones(info);
+  marching_zeros(info);
+  pattern_test(info, 0x55555555, 0xaaaaaaaa);
+  pattern_test(info, 0x66666666, 0x99999999);
+  pattern_test(info, 0x33333333, 0xcccccccc);
+  addr_in_addr(info);
+}
+
+#ifndef CONFIG_DISABLE_PTHREAD
+/****************************************************************************
+ * Name: thread_main
+ ****************************************************************************/
+
+static FAR void *thread_main(FAR void *arg)
+{
+  FAR struct ramtest_s *info = arg;
+
+#ifdef CONFIG_SMP
+  cpu_set_t cpuset;
+
+  CPU_ZERO(&cpuset);
+  CPU_SET(info->cpu, &cpuset);
+  if (sched_setaffinity(0, sizeof(cpuset), &cpuset) < 0)
+    {
+      printf(RAMTEST_PREFIX "Can't run on CPU%d\n", info->cpu);
+    }
+#endif
+
+  run_tests(info);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: run_threads
+ *
+ * Description:
+ *   Split the memory into one slice per thread and test the slices at the
+ *   same time, on different CPUs.
+ *
+ ****************************************************************************/
+
+static void run_threads(FAR struct ramtest_s *info)
+{
+  FAR struct ramtest_s *slices;
+  FAR pthread_t *tids;
+  size_t slice;
+  int i;
+  int ret;
+
+  slices = calloc(info->nthreads, sizeof(*slices));
+  tids   = calloc(info->nthreads, sizeof(*tids));
+  if (slices == NULL || tids == NULL)
+    {
+      printf(RAMTEST_PREFIX "Out of memory\n");
+      goto out;
+    }
+
+  slice = info->size / info->nthreads & ~(RAMTEST_SLICE_ALIGN - 1);
+  for (i = 0; i < info->nthreads; i++)
+    {
+      slices[i]       = *info;
+      slices[i].bytes = 0;
+      slices[i].start = info->start + i * slice;
+      slices[i].size  = i < info->nthreads - 1 ? slice :
+                        info->size - i * slice;
+#ifdef CONFIG_SMP
+      slices[i].cpu   = i % CONFIG_SMP_NCPUS;
+#endif
+      set_nxfrs(&slices[i]);
+
+      ret = pthread_create(&tids[i], NULL, thread_main, &slices[i]);
+      if (ret != 0)
+        {
+          /* Test what was not given to a thread here */
+
+          printf(RAMTEST_PREFIX "pthread_create failed: %d\n", ret);
+          slices[i].size = info->size - i * slice;
+          set_nxfrs(&slices[i]);
+          run_tests(&slices[i]);
+          info->bytes += slices[i].bytes;
+          break;
+        }
+    }
+
+  while (--i >= 0)
+    {
+      pthread_join(tids[i], NULL);
+      info->bytes += slices[i].bytes;
+    }
+
+out:
+  free(slices);
+  free(tids);
+}
+#endif
+
+/****************************************************************************
+ * Name: get_time_ms
+ ****************************************************************************/
+
+static uint32_t get_time_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -562,24 +753,43 @@ static void addr_in_addr(FAR struct ramtest_s *info)
 int main(int argc, FAR char *argv[])
 {
   struct ramtest_s info;
+  uint32_t elapsed;
 
   /* Setup defaults and parse the command line */
 
-  info.free  = false;
-  info.width = 16;
-  info.mask  = 0x0000ffff;
-  info.size  = 0;
-  info.start = 0;
+  info.free     = false;
+  info.flush    = false;
+  info.nthreads = 1;
+  info.bytes    = 0;
+  info.width    = 16;
+  info.mask     = 0x0000ffff;
+  info.size     = 0;
+  info.start    = 0;
   parse_commandline(argc, argv, &info);
 
   /* Perform the memory tests */
 
-  marching_ones(&info);
-  marching_zeros(&info);
-  pattern_test(&info, 0x55555555, 0xaaaaaaaa);
-  pattern_test(&info, 0x66666666, 0x99999999);
-  pattern_test(&info, 0x33333333, 0xcccccccc);
-  addr_in_addr(&info);
+  elapsed = get_time_ms();
+
+#ifndef CONFIG_DISABLE_PTHREAD
+  if (info.nthreads > 1)
+    {
+      run_threads(&info);
+    }
+  else
+#endif
+    {
+      run_tests(&info);
+    }
+
+  elapsed = get_time_ms() - elapsed;
+
+  /* Every byte was written and read back by each test */
+
+  printf(RAMTEST_PREFIX "%" PRIu64 " bytes in %" PRIu32 " ms, %" PRIu32
+         " KB/s on %d thread(s)\n", info.bytes, elapsed,
+         (uint32_t)(info.bytes / (elapsed > 0 ? elapsed : 1)),
+         info.nthreads);
 
   /* Let's check if we need to do cleanup work at the end */
 
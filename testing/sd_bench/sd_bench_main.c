@@ -39,6 +39,7 @@
  *
  * - Refactoring for NuttX code style.
  * - Test result output has been modified to display total MB written.
+ * - Random and mixed read/write test over several threads.
  */
 
 /****************************************************************************
@@ -47,10 +48,13 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <nuttx/clock.h>
@@ -60,6 +64,17 @@
  ****************************************************************************/
 
 #define BUFFER_ALIGN CONFIG_TESTING_SD_MEM_ALIGN_BYTES
+
+/* Latency histogram: exact below 16 us, then 8 buckets per power of two,
+ * so a percentile is within 12.5% of the real value.
+ */
+
+#define HIST_SUB     8
+#define HIST_BUCKETS 256
+
+#define OP_READ      0
+#define OP_WRITE     1
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -70,9 +85,33 @@ typedef struct sdb_config
   int run_duration;
   bool synchronized;
   bool aligned;
+  bool verify;
+  int num_threads;
+  int read_percent;
   size_t total_blocks_written;
 } sdb_config_t;
 
+typedef struct sdb_hist
+{
+  uint32_t buckets[HIST_BUCKETS];
+  uint64_t max;
+  size_t count;
+} sdb_hist_t;
+
+typedef struct sdb_thread
+{
+  pthread_t thread;
+  int fd;
+  const sdb_config_t *cfg;
+  const uint8_t *pattern;
+  uint8_t *block;
+  int block_size;
+  struct timespec start;
+  uint32_t seed;
+  size_t errors;
+  sdb_hist_t hist[2];
+} sdb_thread_t;
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -92,6 +131,12 @@ const size_t max_duration = 60000;
 const size_t min_duration = 1;
 const size_t default_duration = 2000;
 
+const int max_threads = 16;
+const int min_threads = 1;
+const int default_threads = 1;
+
+const int default_read_percent = 70;
+
 const bool default_keep_test = false;
 const bool default_fsync = false;
 const bool default_verify = true;
@@ -113,6 +158,8 @@ uint64_t time_fsync_us(int fd);
 float ts_to_kb(uint64_t bytes, uint64_t elapsed);
 float block_count_to_mb(size_t blocks, size_t block_size);
 static const char *print_bool(const bool value);
+static int random_test(int fd, sdb_config_t *cfg, uint8_t *block,
+                       int block_size);
 static void usage(void);
 
 /****************************************************************************
@@ -346,17 +393,292 @@ int read_test(int fd, sdb_config_t *cfg, uint8_t *block, int block_size)
   return 0;
 }
 
+static int hist_index(uint64_t us)
+{
+  int shift = 0;
+
+  while ((us >> shift) >= 2 * HIST_SUB)
+    {
+      shift++;
+    }
+
+  if (shift == 0)
+    {
+      return us;
+    }
+
+  shift = (shift + 1) * HIST_SUB + (us >> shift) - HIST_SUB;
+  return shift < HIST_BUCKETS ? shift : HIST_BUCKETS - 1;
+}
+
+static uint64_t hist_value(int index)
+{
+  if (index < 2 * HIST_SUB)
+    {
+      return index;
+    }
+
+  return (uint64_t)(HIST_SUB + index % HIST_SUB) << (index / HIST_SUB - 1);
+}
+
+static void hist_add(sdb_hist_t *hist, uint64_t us)
+{
+  hist->buckets[hist_index(us)]++;
+  hist->count++;
+  if (us > hist->max)
+    {
+      hist->max = us;
+    }
+}
+
+static void hist_merge(sdb_hist_t *dest, const sdb_hist_t *src)
+{
+  for (int i = 0; i < HIST_BUCKETS; i++)
+    {
+      dest->buckets[i] += src->buckets[i];
+    }
+
+  dest->count += src->count;
+  if (src->max > dest->max)
+    {
+      dest->max = src->max;
+    }
+}
+
+/* The value below which permille of the samples are */
+
+static uint64_t hist_percentile(const sdb_hist_t *hist, int permille)
+{
+  uint64_t rank = ((uint64_t)hist->count * permille + 999) / 1000;
+  uint64_t seen = 0;
+
+  for (int i = 0; i < HIST_BUCKETS; i++)
+    {
+      seen += hist->buckets[i];
+      if (seen >= rank && seen > 0)
+        {
+          return hist_value(i);
+        }
+    }
+
+  return hist->max;
+}
+
+static void hist_print(const char *name, const sdb_hist_t *hist)
+{
+  if (hist->count == 0)
+    {
+      return;
+    }
+
+  printf("  %-5s : %zu ops, latency p50 %.3f ms, p90 %.3f ms, "
+         "p99 %.3f ms, p99.9 %.3f ms, max %.3f ms\n", name, hist->count,
+         hist_percentile(hist, 500) / 1e3, hist_percentile(hist, 900) / 1e3,
+         hist_percentile(hist, 990) / 1e3, hist_percentile(hist, 999) / 1e3,
+         hist->max / 1e3);
+}
+
+static uint32_t random_next(uint32_t *seed)
+{
+  *seed ^= *seed << 13;
+  *seed ^= *seed >> 17;
+  *seed ^= *seed << 5;
+  return *seed;
+}
+
+/* Each thread is one outstanding request: pread() or pwrite() of a random
+ * block of the file the write test made.  A block gets its own number as
+ * it did there, so the reads can check it whatever was written last.
+ */
+
+static void *random_thread(void *arg)
+{
+  sdb_thread_t *t = arg;
+  const sdb_config_t *cfg = t->cfg;
+  size_t *blocknumber = (size_t *)(void *)&t->block[0];
+  struct timespec op_start;
+  size_t index;
+  ssize_t ret;
+  off_t offset;
+  int op;
+
+  while (get_elapsed_time_us(&t->start) < cfg->run_duration)
+    {
+      index  = random_next(&t->seed) % cfg->total_blocks_written;
+      offset = (off_t)index * t->block_size;
+      op     = random_next(&t->seed) % 100 < cfg->read_percent ?
+               OP_READ : OP_WRITE;
+
+      if (op == OP_WRITE)
+        {
+          memcpy(t->block, t->pattern, t->block_size);
+          *blocknumber = index;
+        }
+
+      op_start = get_abs_time();
+      if (op == OP_READ)
+        {
+          ret = pread(t->fd, t->block, t->block_size, offset);
+        }
+      else
+        {
+          ret = pwrite(t->fd, t->block, t->block_size, offset);
+          if (ret == t->block_size && cfg->synchronized)
+            {
+              fsync(t->fd);
+            }
+        }
+
+      hist_add(&t->hist[op], get_elapsed_time_us(&op_start));
+
+      if (ret != t->block_size)
+        {
+          printf("%s error at block %zu: %d\n",
+                 op == OP_READ ? "Read" : "Write", index,
+                 ret < 0 ? errno : (int)ret);
+          t->errors++;
+          break;
+        }
+
+      if (op == OP_READ && cfg->verify && *blocknumber != index)
+        {
+          t->errors++;
+        }
+    }
+
+  return NULL;
+}
+
+int random_test(int fd, sdb_config_t *cfg, uint8_t *block, int block_size)
+{
+  sdb_thread_t *threads;
+  sdb_hist_t total[2];
+  sdb_hist_t run_hist[2];
+  size_t errors = 0;
+  uint64_t elapsed;
+  int ret = 0;
+  int n;
+
+  printf("\n");
+  printf("Testing Random I/O, %d thread(s), %d%% reads...\n",
+         cfg->num_threads, cfg->read_percent);
+
+  if (cfg->total_blocks_written == 0)
+    {
+      printf("Nothing written to test on\n");
+      return -1;
+    }
+
+  threads = calloc(cfg->num_threads, sizeof(*threads));
+  if (!threads)
+    {
+      printf("Failed to allocate memory for the threads\n");
+      return -1;
+    }
+
+  for (n = 0; n < cfg->num_threads; n++)
+    {
+      if (cfg->aligned)
+        {
+          threads[n].block = (uint8_t *)memalign(BUFFER_ALIGN, block_size);
+        }
+      else
+        {
+          threads[n].block = (uint8_t *)malloc(block_size);
+        }
+
+      if (!threads[n].block)
+        {
+          printf("Failed to allocate memory block\n");
+          ret = -1;
+          goto out;
+        }
+
+      threads[n].fd         = fd;
+      threads[n].cfg        = cfg;
+      threads[n].pattern    = block;
+      threads[n].block_size = block_size;
+      threads[n].seed       = 2463534242u + n * 0x9e3779b9u;
+    }
+
+  memset(total, 0, sizeof(total));
+
+  for (int run = 0; run < cfg->num_runs && errors == 0; ++run)
+    {
+      struct timespec start = get_abs_time();
+
+      for (n = 0; n < cfg->num_threads; n++)
+        {
+          memset(threads[n].hist, 0, sizeof(threads[n].hist));
+          threads[n].start = start;
+          if (pthread_create(&threads[n].thread, NULL, random_thread,
+                             &threads[n]) != 0)
+            {
+              printf("Failed to start thread %d\n", n);
+              break;
+            }
+        }
+
+      memset(run_hist, 0, sizeof(run_hist));
+      for (int i = 0; i < n; i++)
+        {
+          pthread_join(threads[i].thread, NULL);
+          hist_merge(&run_hist[OP_READ], &threads[i].hist[OP_READ]);
+          hist_merge(&run_hist[OP_WRITE], &threads[i].hist[OP_WRITE]);
+          errors += threads[i].errors;
+        }
+
+      elapsed = get_elapsed_time_us(&start);
+      printf("  Run %2i: %6.0f read IOPS, %6.0f write IOPS, %8.1f KB/s, "
+             "max latency %4.3f ms\n", run + 1,
+             run_hist[OP_READ].count / (elapsed / 1e6),
+             run_hist[OP_WRITE].count / (elapsed / 1e6),
+             ts_to_kb((uint64_t)block_size * (run_hist[OP_READ].count +
+                      run_hist[OP_WRITE].count), elapsed),
+             (run_hist[OP_READ].max > run_hist[OP_WRITE].max ?
+              run_hist[OP_READ].max : run_hist[OP_WRITE].max) / 1e3);
+
+      hist_merge(&total[OP_READ], &run_hist[OP_READ]);
+      hist_merge(&total[OP_WRITE], &run_hist[OP_WRITE]);
+
+      if (n < cfg->num_threads)
+        {
+          ret = -1;
+          break;
+        }
+    }
+
+  hist_print("Read", &total[OP_READ]);
+  hist_print("Write", &total[OP_WRITE]);
+
+  if (errors > 0)
+    {
+      printf("  %zu errors\n", errors);
+      ret = -1;
+    }
+
+out:
+  for (n = 0; n < cfg->num_threads; n++)
+    {
+      free(threads[n].block);
+    }
+
+  free(threads);
+  return ret;
+}
+
 static void usage(void)
 {
   printf("Test the speed of an SD card or mount point\n");
   printf(CONFIG_TESTING_SD_BENCH_PROGNAME
-         ": [-b] [-r] [-d] [-k] [-s] [-a] [-v]\n");
+         ": [-b] [-r] [-d] [-T] [-k] [-s] [-a] [-v] [-R] [-t] [-m]\n");
   printf("  -b   Block size per write (%u-%u), default %u\n",
          min_block, max_block, default_block);
   printf("  -r   Number of runs (%u-%u), default %u\n",
          min_runs, max_runs, default_runs);
   printf("  -d   Max duration of a test (ms) (%u-%u), default %u\n",
          min_duration, max_duration, default_duration);
+  printf("  -T   Run each test this many seconds instead of -r runs\n");
   printf("  -k   Keep test file when finished, default %s\n",
          print_bool(default_keep_test));
   printf("  -s   Call fsync after each block, false calls fsync\n"
@@ -366,6 +688,12 @@ static void usage(void)
          print_bool(default_aligned));
   printf("  -v   Verify data and block number, default %s\n",
          print_bool(default_verify));
+  printf("  -R   Random reads and writes of blocks of the written file\n");
+  printf("  -t   Threads of the random test, each one outstanding\n"
+         "       request (%d-%d), default %d\n",
+         min_threads, max_threads, default_threads);
+  printf("  -m   Percentage of reads in the random test (0-100), "
+         "default %d\n", default_read_percent);
 }
 
 /****************************************************************************
@@ -377,6 +705,8 @@ int main(int argc, char *argv[])
   size_t block_size = default_block;
   bool verify = default_verify;
   bool keep = default_keep_test;
+  bool random = false;
+  int total_duration = 0;
   int ch;
   int bench_fd;
   sdb_config_t cfg;
@@ -386,8 +716,10 @@ int main(int argc, char *argv[])
   cfg.num_runs = default_runs;
   cfg.run_duration = default_duration;
   cfg.aligned = default_aligned;
+  cfg.num_threads = default_threads;
+  cfg.read_percent = default_read_percent;
 
-  while ((ch = getopt(argc, argv, "b:r:d:ksav")) != EOF)
+  while ((ch = getopt(argc, argv, "b:r:d:T:ksavRt:m:")) != EOF)
     {
       switch (ch)
         {
@@ -419,6 +751,22 @@ int main(int argc, char *argv[])
           verify = !default_verify;
           break;
 
+        case 'T':
+          total_duration = strtol(optarg, NULL, 0);
+          break;
+
+        case 'R':
+          random = true;
+          break;
+
+        case 't':
+          cfg.num_threads = strtol(optarg, NULL, 0);
+          break;
+
+        case 'm':
+          cfg.read_percent = strtol(optarg, NULL, 0);
+          break;
+
         default:
           usage();
           return -1;
@@ -440,6 +788,12 @@ int main(int argc, char *argv[])
       exit(EXIT_FAILURE);
     }
 
+  if (total_duration > 0)
+    {
+      cfg.num_runs = ((uint64_t)total_duration * 1000 + cfg.run_duration -
+                      1) / cfg.run_duration;
+    }
+
   if (cfg.num_runs > max_runs || cfg.num_runs < min_runs)
     {
       printf("Runs outside allowable range.\n");
@@ -447,9 +801,26 @@ int main(int argc, char *argv[])
       exit(EXIT_FAILURE);
     }
 
+  if (cfg.num_threads > max_threads || cfg.num_threads < min_threads)
+    {
+      printf("Threads outside allowable range.\n");
+      usage();
+      exit(EXIT_FAILURE);
+    }
+
+  if (cfg.read_percent > 100 || cfg.read_percent < 0)
+    {
+      printf("Read percentage outside allowable range.\n");
+      usage();
+      exit(EXIT_FAILURE);
+    }
+
+  cfg.verify = verify;
+
   cfg.run_duration *= 1000;
   bench_fd = open(BENCHMARK_FILE,
-                  O_CREAT | (verify ? O_RDWR : O_WRONLY) | O_TRUNC);
+                  O_CREAT | (verify || random ? O_RDWR : O_WRONLY) |
+                  O_TRUNC);
 
   if (bench_fd < 0)
     {
@@ -491,6 +862,11 @@ int main(int argc, char *argv[])
       read_test(bench_fd, &cfg, block, block_size);
     }
 
+  if (random)
+    {
+      random_test(bench_fd, &cfg, block, block_size);
+    }
+
   free(block);
   close(bench_fd);
 
@@ -43,6 +43,12 @@
 #define DEVNAME_FMT        "/dev/uorb/sensor_%s"
 #define DEVNAME_MAX        64
 
+/* Buckets of the timestamp jitter histogram of -s: the deviation of the
+ * time between two events from the interval, in percent of the interval.
+ */
+
+#define JITTER_BUCKETS     8
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -56,6 +62,18 @@ struct sensor_info
   FAR const char *name;
 };
 
+struct sensor_stats
+{
+  uint64_t       first;         /* Timestamp of the first event */
+  uint64_t       last;          /* Timestamp of the latest event */
+  uint64_t       min;           /* Shortest time between two events */
+  uint64_t       max;           /* Longest time between two events */
+  unsigned int   reads;
+  unsigned int   events;
+  unsigned int   dropped;       /* Events missing from the timestamps */
+  unsigned int   jitter[JITTER_BUCKETS];
+};
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -81,6 +99,11 @@ static void print_gps_satellite(FAR const char *buffer,
 
 static bool g_should_exit = false;
 
+static const uint8_t g_jitter_limits[JITTER_BUCKETS - 1] =
+{
+  1, 2, 5, 10, 25, 50, 100
+};
+
 static const struct sensor_info g_sensor_info[] =
 {
   {print_vec3,  sizeof(struct sensor_accel), "accel"},
@@ -236,6 +259,95 @@ static void print_gps_satellite(FAR const char *buffer, FAR const char *name)
          name, event->timestamp, event->count, event->satellites);
 }
 
+static void stats_update(FAR struct sensor_stats *stats,
+                         FAR const char *event, unsigned int interval)
+{
+  uint64_t timestamp;
+  uint64_t delta;
+  uint64_t dev;
+  int i;
+
+  /* Every sensor event starts with its timestamp. */
+
+  memcpy(&timestamp, event, sizeof(timestamp));
+  if (stats->events++ == 0)
+    {
+      stats->first = timestamp;
+      stats->last  = timestamp;
+      return;
+    }
+
+  delta = timestamp > stats->last ? timestamp - stats->last : 0;
+  stats->last = timestamp;
+
+  if (stats->events == 2 || delta < stats->min)
+    {
+      stats->min = delta;
+    }
+
+  if (delta > stats->max)
+    {
+      stats->max = delta;
+    }
+
+  if (interval == 0)
+    {
+      return;
+    }
+
+  if (delta > interval + interval / 2)
+    {
+      stats->dropped += (delta + interval / 2) / interval - 1;
+    }
+
+  dev = delta > interval ? delta - interval : interval - delta;
+  dev = dev * 100 / interval;
+  for (i = 0; i < nitems(g_jitter_limits); i++)
+    {
+      if (dev <= g_jitter_limits[i])
+        {
+          break;
+        }
+    }
+
+  stats->jitter[i]++;
+}
+
+static void stats_print(FAR const struct sensor_stats *stats,
+                        FAR const char *name)
+{
+  uint64_t span;
+  uint64_t mhz;
+  int i;
+
+  printf("SensorTest: %s: %u events in %u reads\n",
+         name, stats->events, stats->reads);
+  if (stats->events < 2)
+    {
+      return;
+    }
+
+  span = stats->last - stats->first;
+  mhz  = span ? (uint64_t)(stats->events - 1) * 1000000000 / span : 0;
+  printf("  rate: %" PRIu64 ".%03u Hz, dropped: %u\n",
+         mhz / 1000, (unsigned int)(mhz % 1000), stats->dropped);
+  printf("  interval(us): min %" PRIu64 " avg %" PRIu64 " max %" PRIu64
+         "\n", stats->min, span / (stats->events - 1), stats->max);
+  printf("  jitter, |interval - expected|:\n");
+  for (i = 0; i < JITTER_BUCKETS; i++)
+    {
+      if (i < nitems(g_jitter_limits))
+        {
+          printf("    <=%3u%%: %u\n", g_jitter_limits[i], stats->jitter[i]);
+        }
+      else
+        {
+          printf("     >%3u%%: %u\n", g_jitter_limits[i - 1],
+                 stats->jitter[i]);
+        }
+    }
+}
+
 static void usage(void)
 {
   printf("sensortest [arguments...] <command>\n");
@@ -246,6 +358,11 @@ static void usage(void)
   printf("\t            default: 0\n");
   printf("\t[-n <val>]  The number of output data\n");
   printf("\t            default: 0\n");
+  printf("\t[-f <val>]  The number of events buffered by the driver and\n");
+  printf("\t            read at once\n");
+  printf("\t            default: 1\n");
+  printf("\t[-s      ]  Report rate, drops and timestamp jitter instead\n");
+  printf("\t            of printing each event\n");
 
   printf(" Commands:\n");
   printf("\t<sensor_node_name> ex, accel0(/dev/uorb/sensor_accel0)\n");
@@ -270,11 +387,16 @@ int main(int argc, FAR char *argv[])
   unsigned int received = 0;
   unsigned int latency = 0;
   unsigned int count = 0;
+  unsigned int nevents = 1;
+  struct sensor_stats stats;
+  bool quiet = false;
   char devname[PATH_MAX];
   struct pollfd fds;
   FAR char *buffer;
   FAR char *name;
+  ssize_t nread;
   int len = 0;
+  int off;
   int fd;
   int idx;
   int ret;
@@ -291,7 +413,7 @@ int main(int argc, FAR char *argv[])
     }
 
   g_should_exit = false;
-  while ((ret = getopt(argc, argv, "i:b:n:h")) != EOF)
+  while ((ret = getopt(argc, argv, "i:b:n:f:sh")) != EOF)
     {
       switch (ret)
         {
@@ -307,6 +429,14 @@ int main(int argc, FAR char *argv[])
             count = strtoul(optarg, NULL, 0);
             break;
 
+          case 'f':
+            nevents = MAX(strtoul(optarg, NULL, 0), 1);
+            break;
+
+          case 's':
+            quiet = true;
+            break;
+
           case 'h':
           default:
             usage();
@@ -323,7 +453,7 @@ int main(int argc, FAR char *argv[])
               strlen(g_sensor_info[idx].name)))
             {
               len = g_sensor_info[idx].esize;
-              buffer = calloc(1, len);
+              buffer = calloc(nevents, len);
               break;
             }
         }
@@ -383,26 +513,65 @@ int main(int argc, FAR char *argv[])
         }
     }
 
+  if (nevents > 1)
+    {
+      ret = ioctl(fd, SNIOC_SET_BUFFER_NUMBER, nevents);
+      if (ret < 0)
+        {
+          ret = -errno;
+          printf("Failed to set buffer number for sensor:%s, ret:%s\n",
+                 devname, strerror(errno));
+          goto ctl_err;
+        }
+    }
+
   printf("SensorTest: Test %s with interval(%uus), latency(%uus)\n",
          devname, interval, latency);
 
+  memset(&stats, 0, sizeof(stats));
+
   fds.fd = fd;
   fds.events = POLLIN;
 
   while ((!count || received < count) && !g_should_exit)
     {
-      if (poll(&fds, 1, -1) > 0)
+      if (poll(&fds, 1, -1) <= 0)
+        {
+          continue;
+        }
+
+      nread = read(fd, buffer, nevents * len);
+      if (nread < len)
+        {
+          continue;
+        }
+
+      stats.reads++;
+      for (off = 0; off + len <= nread; off += len)
         {
-          if (read(fd, buffer, len) >= len)
+          received++;
+          if (quiet)
+            {
+              stats_update(&stats, buffer + off, interval);
+            }
+          else
             {
-              received++;
-              g_sensor_info[idx].print(buffer, name);
+              g_sensor_info[idx].print(buffer + off, name);
+            }
+
+          if (count && received >= count)
+            {
+              break;
             }
         }
     }
 
   printf("SensorTest: Received message: %s, number:%d/%d\n",
          name, received, count);
+  if (quiet)
+    {
+      stats_print(&stats, name);
+    }
 
 ctl_err:
   close(fd);
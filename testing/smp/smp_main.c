@@ -23,12 +23,16 @@
  ****************************************************************************/
 
 #include <sched.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <string.h>
 
+#include "smp_parfor.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -37,6 +41,21 @@
 #define YIELD_MSEC     100
 #define IMPOSSIBLE_CPU -1
 
+/* Work-stealing benchmark: about 10us per index by default */
+
+#define PARFOR_COUNT   2048
+#define PARFOR_LOOPS   (CONFIG_BOARD_LOOPSPERMSEC / 100 + 1)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct parfor_load_s
+{
+  size_t count;
+  bool skewed;            /* Index i costs 2 * i / count of the average */
+};
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -186,6 +205,162 @@ static pthread_addr_t barrier_thread(pthread_addr_t parameter)
   return NULL;
 }
 
+/****************************************************************************
+ * Name: parfor_spin
+ ****************************************************************************/
+
+static void parfor_spin(size_t index, FAR void *arg)
+{
+  FAR const struct parfor_load_s *load = arg;
+  volatile unsigned int i;
+  unsigned int loops = PARFOR_LOOPS;
+
+  if (load->skewed)
+    {
+      loops = (uint64_t)loops * 2 * index / load->count;
+    }
+
+  for (i = 0; i < loops; i++)
+    {
+    }
+}
+
+/****************************************************************************
+ * Name: parfor_time
+ *
+ * Description:
+ *   Run the load on the pool and return the time it took in microseconds.
+ *
+ ****************************************************************************/
+
+static uint64_t parfor_time(FAR struct parfor_s *pool,
+                            FAR struct parfor_load_s *load, size_t grain)
+{
+  struct timespec start;
+  struct timespec end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  parfor_run(pool, 0, load->count, grain, parfor_spin, load);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (uint64_t)(end.tv_sec - start.tv_sec) * 1000000 +
+         (end.tv_nsec - start.tv_nsec) / 1000;
+}
+
+/****************************************************************************
+ * Name: parfor_bench
+ *
+ * Description:
+ *   Run a uniform and a skewed parallel for over one worker and then over
+ *   nworkers, at several grains, and print the speedup, how unevenly the
+ *   work ended up spread (the busiest worker against the average), and
+ *   how often work moved: ranges stolen, workers that changed CPU.
+ *
+ ****************************************************************************/
+
+static int parfor_bench(int nworkers, bool pin, size_t count)
+{
+  static const size_t grains[] =
+  {
+    1, 16, 256
+  };
+
+  struct parfor_load_s load;
+  struct parfor_stats_s stats;
+  FAR struct parfor_s *serial;
+  FAR struct parfor_s *pool;
+  uint64_t busy_max;
+  uint64_t busy_sum;
+  uint64_t t1;
+  uint64_t tn;
+  size_t migrations;
+  size_t steals;
+  size_t i;
+  int skew;
+  int w;
+
+  serial = parfor_create(1, pin);
+  pool   = parfor_create(nworkers, pin);
+  if (serial == NULL || pool == NULL)
+    {
+      printf("  Main[0]: Failed to start %d workers\n", nworkers);
+      if (serial != NULL)
+        {
+          parfor_destroy(serial);
+        }
+
+      if (pool != NULL)
+        {
+          parfor_destroy(pool);
+        }
+
+      return EXIT_FAILURE;
+    }
+
+  printf("Work stealing, %d workers%s, %zu indexes of about %d loops\n",
+         nworkers, pin ? " pinned" : "", count, PARFOR_LOOPS);
+  printf("%-8s %6s %10s %10s %8s %9s %7s %10s\n", "load", "grain",
+         "1 (us)", "N (us)", "speedup", "imbalance", "steals",
+         "migrations");
+
+  load.count = count;
+  for (skew = 0; skew < 2; skew++)
+    {
+      load.skewed = skew != 0;
+
+      for (i = 0; i < sizeof(grains) / sizeof(grains[0]); i++)
+        {
+          t1 = parfor_time(serial, &load, grains[i]);
+          tn = parfor_time(pool, &load, grains[i]);
+
+          busy_max   = 0;
+          busy_sum   = 0;
+          steals     = 0;
+          migrations = 0;
+
+          for (w = 0; w < nworkers; w++)
+            {
+              parfor_stats(pool, w, &stats);
+              busy_sum   += stats.busy_ns;
+              steals     += stats.steals;
+              migrations += stats.migrations;
+              if (stats.busy_ns > busy_max)
+                {
+                  busy_max = stats.busy_ns;
+                }
+            }
+
+          printf("%-8s %6zu %10llu %10llu %7llu.%02llu %8llu%% %7zu %10zu\n",
+                 load.skewed ? "skewed" : "uniform", grains[i],
+                 (unsigned long long)t1, (unsigned long long)tn,
+                 (unsigned long long)(tn > 0 ? t1 / tn : 0),
+                 (unsigned long long)(tn > 0 ? t1 * 100 / tn % 100 : 0),
+                 (unsigned long long)(busy_sum > 0 ?
+                                      busy_max * 100 * nworkers / busy_sum :
+                                      0),
+                 steals, migrations);
+        }
+    }
+
+  parfor_destroy(serial);
+  parfor_destroy(pool);
+  return EXIT_SUCCESS;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname)
+{
+  printf("Usage: %s [-w [-n workers] [-i indexes] [-u]]\n", progname);
+  printf("  Without -w, run the barrier test\n");
+  printf("  -w  Benchmark the work-stealing parallel for instead\n");
+  printf("  -n  Number of workers, default %d\n", CONFIG_SMP_NCPUS);
+  printf("  -i  Number of indexes, default %d\n", PARFOR_COUNT);
+  printf("  -u  Let the scheduler place the workers, do not pin them\n");
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -201,9 +376,43 @@ int main(int argc, FAR char *argv[])
   pthread_attr_t attr;
   pthread_barrierattr_t barrierattr;
   int errcode = EXIT_SUCCESS;
+  int nworkers = CONFIG_SMP_NCPUS;
+  size_t count = PARFOR_COUNT;
+  bool parfor = false;
+  bool pin = true;
   int ret;
   int i;
 
+  while ((ret = getopt(argc, argv, "wn:i:uh")) != ERROR)
+    {
+      switch (ret)
+        {
+          case 'w':
+            parfor = true;
+            break;
+          case 'n':
+            nworkers = atoi(optarg);
+            break;
+          case 'i':
+            count = strtoul(optarg, NULL, 0);
+            break;
+          case 'u':
+            pin = false;
+            break;
+          case 'h':
+            show_usage(argv[0]);
+            return EXIT_SUCCESS;
+          default:
+            show_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (parfor)
+    {
+      return parfor_bench(nworkers, pin, count);
+    }
+
   /* Initialize data */
 
   memset(threadid,
@@ -0,0 +1,431 @@
+/****************************************************************************
+ * apps/testing/smp/smp_parfor.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <nuttx/clock.h>
+
+#include "smp_parfor.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Halving a range never leaves more than one entry per bit of its length
+ * in the deque of the worker that split it; a full deque just stops the
+ * splitting.
+ */
+
+#define PARFOR_DEQUE_SIZE 64
+
+#ifdef CONFIG_SMP_NCPUS
+#  define PARFOR_NCPUS CONFIG_SMP_NCPUS
+#else
+#  define PARFOR_NCPUS 1
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct parfor_range_s
+{
+  size_t begin;
+  size_t end;
+};
+
+/* The owner pushes and pops at the tail, thieves take from the head */
+
+struct parfor_deque_s
+{
+  pthread_mutex_t lock;
+  size_t head;
+  size_t tail;
+  struct parfor_range_s ranges[PARFOR_DEQUE_SIZE];
+};
+
+struct parfor_worker_s
+{
+  FAR struct parfor_s *pool;
+  pthread_t thread;
+  sem_t start;
+  int id;
+  int cpu;
+  uint32_t seed;
+  struct parfor_deque_s deque;
+  struct parfor_stats_s stats;
+};
+
+struct parfor_s
+{
+  int nworkers;
+  volatile bool exit;
+  parfor_func_t func;
+  FAR void *arg;
+  size_t grain;
+  atomic_size_t remaining;
+  sem_t done;
+  struct parfor_worker_s workers[1];
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: parfor_push
+ ****************************************************************************/
+
+static bool parfor_push(FAR struct parfor_deque_s *deque,
+                        size_t begin, size_t end)
+{
+  bool pushed = false;
+
+  pthread_mutex_lock(&deque->lock);
+  if (deque->tail - deque->head < PARFOR_DEQUE_SIZE)
+    {
+      deque->ranges[deque->tail % PARFOR_DEQUE_SIZE].begin = begin;
+      deque->ranges[deque->tail % PARFOR_DEQUE_SIZE].end   = end;
+      deque->tail++;
+      pushed = true;
+    }
+
+  pthread_mutex_unlock(&deque->lock);
+  return pushed;
+}
+
+/****************************************************************************
+ * Name: parfor_pop
+ *
+ * Description:
+ *   Take the newest range of the deque, or with steal its oldest.
+ *
+ ****************************************************************************/
+
+static bool parfor_pop(FAR struct parfor_deque_s *deque,
+                       FAR struct parfor_range_s *range, bool steal)
+{
+  bool popped = false;
+
+  pthread_mutex_lock(&deque->lock);
+  if (deque->tail != deque->head)
+    {
+      if (steal)
+        {
+          *range = deque->ranges[deque->head++ % PARFOR_DEQUE_SIZE];
+        }
+      else
+        {
+          *range = deque->ranges[--deque->tail % PARFOR_DEQUE_SIZE];
+        }
+
+      popped = true;
+    }
+
+  pthread_mutex_unlock(&deque->lock);
+  return popped;
+}
+
+/****************************************************************************
+ * Name: parfor_steal
+ *
+ * Description:
+ *   Try every other worker once, starting from a random one.
+ *
+ ****************************************************************************/
+
+static bool parfor_steal(FAR struct parfor_worker_s *worker,
+                         FAR struct parfor_range_s *range)
+{
+  FAR struct parfor_s *pool = worker->pool;
+  int victim;
+  int i;
+
+  worker->seed ^= worker->seed << 13;
+  worker->seed ^= worker->seed >> 17;
+  worker->seed ^= worker->seed << 5;
+  victim = worker->seed % pool->nworkers;
+
+  for (i = 0; i < pool->nworkers; i++, victim = (victim + 1) %
+                                                pool->nworkers)
+    {
+      if (victim != worker->id &&
+          parfor_pop(&pool->workers[victim].deque, range, true))
+        {
+          worker->stats.steals++;
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: parfor_work
+ ****************************************************************************/
+
+static void parfor_work(FAR struct parfor_worker_s *worker)
+{
+  FAR struct parfor_s *pool = worker->pool;
+  struct parfor_range_s range;
+  struct timespec ts;
+  clock_t busy = 0;
+  clock_t start;
+  size_t mid;
+  size_t i;
+  int cpu;
+
+  while (atomic_load(&pool->remaining) > 0)
+    {
+      if (!parfor_pop(&worker->deque, &range, false) &&
+          !parfor_steal(worker, &range))
+        {
+          /* The rest is being run elsewhere */
+
+          sched_yield();
+          continue;
+        }
+
+      /* Leave the upper halves to be stolen */
+
+      while (range.end - range.begin > pool->grain)
+        {
+          mid = range.begin + (range.end - range.begin) / 2;
+          if (!parfor_push(&worker->deque, mid, range.end))
+            {
+              break;
+            }
+
+          range.end = mid;
+        }
+
+      cpu = sched_getcpu();
+      if (cpu != worker->cpu)
+        {
+          worker->stats.migrations += worker->cpu >= 0;
+          worker->cpu = cpu;
+        }
+
+      start = perf_gettime();
+      for (i = range.begin; i < range.end; i++)
+        {
+          pool->func(i, pool->arg);
+        }
+
+      busy += perf_gettime() - start;
+
+      worker->stats.chunks++;
+      worker->stats.iterations += range.end - range.begin;
+      atomic_fetch_sub(&pool->remaining, range.end - range.begin);
+    }
+
+  perf_convert(busy, &ts);
+  worker->stats.busy_ns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: parfor_thread
+ ****************************************************************************/
+
+static FAR void *parfor_thread(FAR void *arg)
+{
+  FAR struct parfor_worker_s *worker = arg;
+  FAR struct parfor_s *pool = worker->pool;
+
+  for (; ; )
+    {
+      sem_wait(&worker->start);
+      if (pool->exit)
+        {
+          break;
+        }
+
+      parfor_work(worker);
+      sem_post(&pool->done);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: parfor_create
+ ****************************************************************************/
+
+FAR struct parfor_s *parfor_create(int nworkers, bool pin)
+{
+  FAR struct parfor_worker_s *worker;
+  FAR struct parfor_s *pool;
+  pthread_attr_t attr;
+#ifdef CONFIG_SMP
+  cpu_set_t cpuset;
+#endif
+  int ret;
+  int i;
+
+  if (nworkers <= 0)
+    {
+      return NULL;
+    }
+
+  pool = calloc(1, sizeof(*pool) + (nworkers - 1) * sizeof(*worker));
+  if (pool == NULL)
+    {
+      return NULL;
+    }
+
+  sem_init(&pool->done, 0, 0);
+
+  for (i = 0; i < nworkers; i++)
+    {
+      worker       = &pool->workers[i];
+      worker->pool = pool;
+      worker->id   = i;
+      worker->cpu  = -1;
+      worker->seed = 2463534242u + i * 0x9e3779b9u;
+      sem_init(&worker->start, 0, 0);
+      pthread_mutex_init(&worker->deque.lock, NULL);
+
+      pthread_attr_init(&attr);
+#ifdef CONFIG_SMP
+      if (pin)
+        {
+          CPU_ZERO(&cpuset);
+          CPU_SET(i % PARFOR_NCPUS, &cpuset);
+          pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+        }
+#endif
+
+      ret = pthread_create(&worker->thread, &attr, parfor_thread, worker);
+      pthread_attr_destroy(&attr);
+      if (ret != 0)
+        {
+          pthread_mutex_destroy(&worker->deque.lock);
+          sem_destroy(&worker->start);
+          break;
+        }
+
+      pool->nworkers++;
+    }
+
+  if (pool->nworkers < nworkers)
+    {
+      parfor_destroy(pool);
+      return NULL;
+    }
+
+  return pool;
+}
+
+/****************************************************************************
+ * Name: parfor_run
+ ****************************************************************************/
+
+void parfor_run(FAR struct parfor_s *pool, size_t begin, size_t end,
+                size_t grain, parfor_func_t func, FAR void *arg)
+{
+  FAR struct parfor_worker_s *worker;
+  size_t len = end - begin;
+  int i;
+
+  if (end <= begin)
+    {
+      return;
+    }
+
+  pool->func  = func;
+  pool->arg   = arg;
+  pool->grain = grain > 0 ? grain : 1;
+  atomic_store(&pool->remaining, len);
+
+  for (i = 0; i < pool->nworkers; i++)
+    {
+      worker = &pool->workers[i];
+      memset(&worker->stats, 0, sizeof(worker->stats));
+      worker->deque.head = 0;
+      worker->deque.tail = 0;
+
+      if (len * (i + 1) / pool->nworkers > len * i / pool->nworkers)
+        {
+          parfor_push(&worker->deque, begin + len * i / pool->nworkers,
+                      begin + len * (i + 1) / pool->nworkers);
+        }
+    }
+
+  for (i = 0; i < pool->nworkers; i++)
+    {
+      sem_post(&pool->workers[i].start);
+    }
+
+  for (i = 0; i < pool->nworkers; i++)
+    {
+      sem_wait(&pool->done);
+    }
+}
+
+/****************************************************************************
+ * Name: parfor_stats
+ ****************************************************************************/
+
+void parfor_stats(FAR struct parfor_s *pool, int worker,
+                  FAR struct parfor_stats_s *stats)
+{
+  *stats = pool->workers[worker].stats;
+}
+
+/****************************************************************************
+ * Name: parfor_destroy
+ ****************************************************************************/
+
+void parfor_destroy(FAR struct parfor_s *pool)
+{
+  int i;
+
+  pool->exit = true;
+  for (i = 0; i < pool->nworkers; i++)
+    {
+      sem_post(&pool->workers[i].start);
+    }
+
+  for (i = 0; i < pool->nworkers; i++)
+    {
+      pthread_join(pool->workers[i].thread, NULL);
+      pthread_mutex_destroy(&pool->workers[i].deque.lock);
+      sem_destroy(&pool->workers[i].start);
+    }
+
+  sem_destroy(&pool->done);
+  free(pool);
+}
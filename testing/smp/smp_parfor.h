@@ -0,0 +1,106 @@
+/****************************************************************************
+ * apps/testing/smp/smp_parfor.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_TESTING_SMP_SMP_PARFOR_H
+#define __APPS_TESTING_SMP_SMP_PARFOR_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Called once for every index of the loop, on any of the workers */
+
+typedef CODE void (*parfor_func_t)(size_t index, FAR void *arg);
+
+/* What one worker did during the last parfor_run() */
+
+struct parfor_stats_s
+{
+  size_t iterations;        /* Indexes it ran */
+  size_t chunks;            /* Ranges of at most grain indexes it ran */
+  size_t steals;            /* Ranges it took from another worker */
+  size_t migrations;        /* Times it was found on another CPU */
+  uint64_t busy_ns;         /* Time spent in func */
+};
+
+struct parfor_s;
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: parfor_create
+ *
+ * Description:
+ *   Start a pool of nworkers threads, each with its own deque of ranges.
+ *   With pin, worker i only runs on CPU i modulo the number of CPUs;
+ *   otherwise the scheduler places them.
+ *
+ * Returned Value:
+ *   The pool, or NULL if it could not be started.
+ *
+ ****************************************************************************/
+
+FAR struct parfor_s *parfor_create(int nworkers, bool pin);
+
+/****************************************************************************
+ * Name: parfor_run
+ *
+ * Description:
+ *   Call func for every index in [begin, end) and return when all are
+ *   done.  The range is first spread evenly over the workers.  A worker
+ *   splits its range in halves until it is at most grain long, keeping
+ *   one half and pushing the other; when its own deque is empty it steals
+ *   the oldest, largest range of another worker.
+ *
+ ****************************************************************************/
+
+void parfor_run(FAR struct parfor_s *pool, size_t begin, size_t end,
+                size_t grain, parfor_func_t func, FAR void *arg);
+
+/****************************************************************************
+ * Name: parfor_stats
+ *
+ * Description:
+ *   Return what worker did in the last parfor_run().
+ *
+ ****************************************************************************/
+
+void parfor_stats(FAR struct parfor_s *pool, int worker,
+                  FAR struct parfor_stats_s *stats);
+
+/****************************************************************************
+ * Name: parfor_destroy
+ ****************************************************************************/
+
+void parfor_destroy(FAR struct parfor_s *pool);
+
+#endif /* __APPS_TESTING_SMP_SMP_PARFOR_H */
@@ -0,0 +1,30 @@
+# ##############################################################################
+# apps/tools/Wasm/WAMR-AOTCache.cmake
+#
+# Licensed to the Apache Software Foundation (ASF) under one or more contributor
+# license agreements.  See the NOTICE file distributed with this work for
+# additional information regarding copyright ownership.  The ASF licenses this
+# file to you under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License.  You may obtain a copy of
+# the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+# License for the specific language governing permissions and limitations under
+# the License.
+#
+# ##############################################################################
+
+# ~~~
+# Script to add a wamrc artifact to the AOT cache, run with "cmake -P".
+#
+# The artifact AOT is copied to CACHE_DIR/<sha256 of WASM>.aot, the name
+# wamr_aotcache_open() looks the module WASM up with at runtime.
+# ~~~
+
+file(SHA256 ${WASM} WASM_HASH)
+file(MAKE_DIRECTORY ${CACHE_DIR})
+configure_file(${AOT} ${CACHE_DIR}/${WASM_HASH}.aot COPYONLY)
@@ -44,6 +44,9 @@ set(CMAKE_SYSTEM_PROCESSOR wasm32)
 set(CMAKE_C_COMPILER ${WASI_SDK_PATH}/bin/clang)
 set(CMAKE_CXX_COMPILER ${WASI_SDK_PATH}/bin/clang++)
 
+# Directory of the helper scripts used by the functions below
+set(WASI_SDK_CMAKE_DIR ${CMAKE_CURRENT_LIST_DIR})
+
 # ~~~
 # Function "wasm_add_application" to add a WebAssembly application to the
 # build system.
@@ -54,7 +57,8 @@ set(CMAKE_CXX_COMPILER ${WASI_SDK_PATH}/bin/clang++)
 #
 # Usage:
 #   wasm_add_application(NAME <name> SRCS <source files>
-#     [STACK_SIZE <stack size>] [INITIAL_MEMORY_SIZE <initial memory size>])
+#     [STACK_SIZE <stack size>] [INITIAL_MEMORY_SIZE <initial memory size>]
+#     [WAMR_MODE <INT|AOT|XIP>])
 #
 # Parameters:
 #   NAME: The name of the application (NAME.wasm).
@@ -62,6 +66,8 @@ set(CMAKE_CXX_COMPILER ${WASI_SDK_PATH}/bin/clang++)
 #   STACK_SIZE: The stack size of the application. Default is 2048.
 #   INITIAL_MEMORY_SIZE: The initial memory size of the application.
 #     Default is 65536 (One page), and must be a multiple of 65536.
+#   WAMR_MODE: INT to run the module in the interpreter (Default), AOT or XIP
+#     to also compile it with wamrc to NAME.aot or NAME.xip.
 # ~~~
 
 function(wasm_add_application)
@@ -71,9 +77,10 @@ function(wasm_add_application)
   set(APP_SRCS "")
   set(APP_STACK_SIZE 2048)
   set(APP_INITIAL_MEMORY_SIZE 65536)
+  set(APP_WAMR_MODE INT)
 
-  cmake_parse_arguments(APP "" "NAME;STACK_SIZE;INITIAL_MEMORY_SIZE" "SRCS"
-                        ${ARGN})
+  cmake_parse_arguments(APP "" "NAME;STACK_SIZE;INITIAL_MEMORY_SIZE;WAMR_MODE"
+                        "SRCS" ${ARGN})
 
   # Check if the APP_NAME (NAME) is provided
   if(NOT APP_NAME)
@@ -91,6 +98,77 @@ function(wasm_add_application)
   # Set the target properties
   set_target_properties(${APP_NAME} PROPERTIES OUTPUT_NAME ${APP_NAME}.wasm)
 
+  if(CONFIG_INTERPRETERS_WAMR_AOT AND APP_WAMR_MODE MATCHES "^(AOT|XIP)$")
+    wasm_aot_compile(${APP_NAME} ${APP_WAMR_MODE})
+  endif()
+
+endfunction()
+
+# ~~~
+# Function "wasm_aot_compile" to compile a WebAssembly application with wamrc.
+#
+# The wamrc target is derived from LLVM_ARCHTYPE, LLVM_CPUTYPE and
+# LLVM_ABITYPE of the NuttX build like interpreters/wamr/Toolchain.defs does.
+# The artifact is also copied to aotcache/<sha256 of the module>.aot when
+# CONFIG_INTERPRETERS_WAMR_AOT_CACHE is enabled.
+#
+# Usage:
+#   wasm_aot_compile(<name> <AOT|XIP>)
+# ~~~
+
+function(wasm_aot_compile name mode)
+
+  find_program(WAMRC wamrc REQUIRED)
+
+  if(CONFIG_ARCH_SIM)
+    set(WAMRC_FLAGS --disable-simd)
+    if(CONFIG_SIM_M32)
+      set(WAMRC_TARGET i386)
+    else()
+      set(WAMRC_TARGET x86_64)
+    endif()
+  else()
+    # target triple of thumb may very complex, such as
+    # thumbv8m.main+dsp+mve.fp+fp.dp, so just use the name before the first
+    # plus sign
+    string(REGEX REPLACE "\\+.*$" "" WAMRC_TARGET "${LLVM_ARCHTYPE}")
+  endif()
+
+  if(LLVM_ABITYPE STREQUAL "eabihf")
+    set(WAMRC_ABI gnueabihf)
+  else()
+    set(WAMRC_ABI ${LLVM_ABITYPE})
+  endif()
+
+  list(APPEND WAMRC_FLAGS --target=${WAMRC_TARGET} --target-abi=${WAMRC_ABI}
+       --cpu=${LLVM_CPUTYPE})
+
+  if(mode STREQUAL "XIP")
+    list(APPEND WAMRC_FLAGS --enable-indirect-mode --disable-llvm-intrinsics)
+    set(ext xip)
+  else()
+    set(ext aot)
+  endif()
+
+  set(wasm ${CMAKE_CURRENT_BINARY_DIR}/${name}.wasm)
+  set(aot ${CMAKE_CURRENT_BINARY_DIR}/${name}.${ext})
+
+  add_custom_command(
+    TARGET ${name}
+    POST_BUILD
+    COMMAND ${WAMRC} ${WAMRC_FLAGS} -o ${aot} ${wasm}
+    COMMENT "Wamrc Generate ${mode}: ${aot}")
+
+  if(CONFIG_INTERPRETERS_WAMR_AOT_CACHE)
+    add_custom_command(
+      TARGET ${name}
+      POST_BUILD
+      COMMAND
+        ${CMAKE_COMMAND} -DWASM=${wasm} -DAOT=${aot}
+        -DCACHE_DIR=${CMAKE_BINARY_DIR}/aotcache -P
+        ${WASI_SDK_CMAKE_DIR}/WAMR-AOTCache.cmake)
+  endif()
+
 endfunction()
 
 # ~~~
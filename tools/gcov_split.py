@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+############################################################################
+# apps/tools/gcov_split.py
+#
+# Licensed to the Apache Software Foundation (ASF) under one or more
+# contributor license agreements.  See the NOTICE file distributed with
+# this work for additional information regarding copyright ownership.  The
+# ASF licenses this file to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance with the
+# License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+# License for the specific language governing permissions and limitations
+# under the License.
+#
+############################################################################
+
+"""
+Split the coverage stream of "gcov -s" into .gcda files.
+
+The stream is gzip compressed.  It starts with the magic "GCOVSTRM" and
+holds one record per file: the length of the path (32 bits, little
+endian), the path, the length of the data and the data.  A record with an
+empty path ends the stream.
+"""
+
+import argparse
+import gzip
+import os
+import struct
+import sys
+
+MAGIC = b"GCOVSTRM"
+
+
+def read_exact(stream, size):
+    data = stream.read(size)
+    if len(data) != size:
+        raise EOFError("truncated coverage stream")
+    return data
+
+
+def split(stream, outdir, strip):
+    if read_exact(stream, len(MAGIC)) != MAGIC:
+        raise ValueError("not a coverage stream")
+
+    count = 0
+    while True:
+        (namelen,) = struct.unpack("<I", read_exact(stream, 4))
+        if namelen == 0:
+            return count
+
+        name = read_exact(stream, namelen).decode()
+        (size,) = struct.unpack("<I", read_exact(stream, 4))
+        data = read_exact(stream, size)
+
+        # Drop the leading components like GCOV_PREFIX_STRIP
+
+        parts = [p for p in name.split("/") if p]
+        parts = parts[strip:]
+        if not parts:
+            continue
+
+        if outdir:
+            path = os.path.join(outdir, *parts)
+        else:
+            path = os.path.join(os.sep, *parts)
+
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        with open(path, "wb") as f:
+            f.write(data)
+        count += 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument("stream", help="coverage stream, or - for stdin")
+    parser.add_argument(
+        "-o",
+        "--outdir",
+        help="write below this directory instead of the recorded paths",
+    )
+    parser.add_argument(
+        "-s",
+        "--strip",
+        type=int,
+        default=0,
+        help="number of leading path components to drop",
+    )
+    args = parser.parse_args()
+
+    if args.stream == "-":
+        source = sys.stdin.buffer
+    else:
+        source = open(args.stream, "rb")
+
+    with gzip.GzipFile(fileobj=source) as stream:
+        count = split(stream, args.outdir, args.strip)
+
+    print("%d files written" % count)
+
+
+if __name__ == "__main__":
+    main()
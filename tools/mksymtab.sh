@@ -51,8 +51,14 @@ fi
 # Now output the symbol table as a structure in a C source file.  All
 # undefined symbols are declared as void* types.  If the toolchain does
 # any kind of checking for function vs. data objects, then this could
-# failed
+# failed.
+#
+# The entries keep the order of sort in the C locale, i.e. the order of
+# strcmp(), so that the table may be searched with
+# CONFIG_SYMTAB_ORDEREDBYNAME.
 
+echo "/* Sorted by name for CONFIG_SYMTAB_ORDEREDBYNAME */"
+echo ""
 echo "#include <nuttx/compiler.h>"
 echo "#include <nuttx/symtab.h>"
 echo ""
@@ -62,6 +62,8 @@
 #define SOCKET_BASE  10000
 #define SOCKET_COUNT 16
 
+#define RXBUF_SIZE   CONFIG_WIRELESS_GS2200M_RXBUFSIZE
+
 /****************************************************************************
  * Private Data Types
  ****************************************************************************/
@@ -81,6 +83,10 @@ struct usock_s
   enum sock_state_e state;
   uint16_t lport;           /* local port */
   struct sockaddr_in raddr; /* remote addr */
+  FAR uint8_t *rxbuf;       /* TCP data fetched but not read yet */
+  uint16_t rxoff;
+  uint16_t rxlen;
+  bool     rxpend;          /* Module event arrived while rxlen > 0 */
 };
 
 struct gs2200m_s
@@ -347,6 +353,10 @@ static int gs2200m_socket_free(FAR struct gs2200m_s *priv, int sockid)
   usock->state = CLOSED;
   usock->cid = 'z'; /* invalid */
 
+  free(usock->rxbuf);
+  usock->rxbuf = NULL;
+  usock->rxlen = 0;
+
   return 0;
 }
 
@@ -895,6 +905,61 @@ prepare:
   return OK;
 }
 
+/****************************************************************************
+ * Name: recv_buffered
+ *
+ * Description:
+ *   Serve a short TCP read from the buffer of the socket, refilling the
+ *   buffer with one GS2200M_IOC_RECV of RXBUF_SIZE bytes when it is empty.
+ *   rmsg->buf is left pointing into the buffer.
+ *
+ ****************************************************************************/
+
+static int recv_buffered(FAR struct gs2200m_s *priv,
+                         FAR struct usock_s *usock,
+                         FAR struct gs2200m_recv_msg *rmsg)
+{
+  uint16_t reqlen = rmsg->reqlen;
+  int flags = rmsg->flags;
+
+  if (0 == usock->rxlen)
+    {
+      if (NULL == usock->rxbuf)
+        {
+          usock->rxbuf = malloc(RXBUF_SIZE);
+          if (NULL == usock->rxbuf)
+            {
+              return -ENOMEM;
+            }
+        }
+
+      rmsg->buf = usock->rxbuf;
+      rmsg->reqlen = RXBUF_SIZE;
+      rmsg->flags = flags & ~MSG_PEEK;
+
+      if (0 > ioctl(priv->gsfd, GS2200M_IOC_RECV, (unsigned long)rmsg))
+        {
+          return -errno;
+        }
+
+      usock->rxoff = 0;
+      usock->rxlen = rmsg->len;
+    }
+
+  rmsg->buf = usock->rxbuf + usock->rxoff;
+  rmsg->len = MIN(usock->rxlen, reqlen);
+  rmsg->reqlen = reqlen;
+  rmsg->flags = flags;
+
+  if (0 == (flags & MSG_PEEK))
+    {
+      usock->rxoff += rmsg->len;
+      usock->rxlen -= rmsg->len;
+    }
+
+  return OK;
+}
+
 /****************************************************************************
  * Name: recvfrom_request
  ****************************************************************************/
@@ -907,6 +972,8 @@ static int recvfrom_request(int fd, FAR struct gs2200m_s *priv,
   struct usrsock_message_req_ack_s resp1;
   struct gs2200m_recv_msg rmsg;
   FAR struct usock_s *usock;
+  bool buffered = false;
+  uint16_t events = 0;
   int ret = 0;
 
   DEBUGASSERT(priv);
@@ -940,22 +1007,46 @@ static int recvfrom_request(int fd, FAR struct gs2200m_s *priv,
   rmsg.is_tcp = (usock->type == SOCK_STREAM) ? true : false;
   rmsg.flags = req->flags;
 
-  if (0 < req->max_buflen)
+  if (rmsg.is_tcp && 0 < req->max_buflen &&
+      (0 < usock->rxlen || req->max_buflen < RXBUF_SIZE))
     {
-      rmsg.buf = calloc(1, req->max_buflen);
-      ASSERT(rmsg.buf);
+      buffered = true;
+      ret = recv_buffered(priv, usock, &rmsg);
 
-      ret = ioctl(priv->gsfd, GS2200M_IOC_RECV,
-                  (unsigned long)&rmsg);
-    }
+      /* Keep the socket readable while data is left in the buffer, and
+       * pass on a module event that was held back while it was in use.
+       */
 
-  if (0 == ret)
-    {
-      ret = rmsg.len;
+      if (0 < usock->rxlen || usock->rxpend)
+        {
+          events = USRSOCK_EVENT_RECVFROM_AVAIL;
+          usock->rxpend = (0 < usock->rxlen) && usock->rxpend;
+        }
+
+      if (0 <= ret)
+        {
+          ret = rmsg.len;
+        }
     }
   else
     {
-      ret = -errno;
+      if (0 < req->max_buflen)
+        {
+          rmsg.buf = calloc(1, req->max_buflen);
+          ASSERT(rmsg.buf);
+
+          ret = ioctl(priv->gsfd, GS2200M_IOC_RECV,
+                      (unsigned long)&rmsg);
+        }
+
+      if (0 == ret)
+        {
+          ret = rmsg.len;
+        }
+      else
+        {
+          ret = -errno;
+        }
     }
 
   if (!rmsg.is_tcp)
@@ -975,7 +1066,7 @@ prepare:
   resp.reqack.xid = req->head.xid;
   resp.reqack.head.msgid  = USRSOCK_MESSAGE_RESPONSE_DATA_ACK;
   resp.reqack.head.flags  = 0;
-  resp.reqack.head.events = 0;
+  resp.reqack.head.events = events;
 
   if (0 <= ret)
     {
@@ -1035,7 +1126,7 @@ prepare:
 err_out:
   gs2200m_printf("%s: *** end ret=%d\n", __func__, ret);
 
-  if (rmsg.buf)
+  if (rmsg.buf && !buffered)
     {
       free(rmsg.buf);
     }
@@ -1759,6 +1850,15 @@ static int gs2200m_loop(FAR struct gs2200m_s *priv)
                   gs2200m_printf("=== %s: cid=%c not found (ignored)\n",
                                 __func__, cid);
                 }
+              else if (0 < usock->rxlen)
+                {
+                  /* The kernel still sees the socket readable because of
+                   * the buffered data: hold the event back until the
+                   * buffer is drained.
+                   */
+
+                  usock->rxpend = true;
+                }
               else
                 {
                   /* send event to call xxxx_request() */
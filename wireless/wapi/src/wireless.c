@@ -39,11 +39,14 @@
  ****************************************************************************/
 
 #include <sys/ioctl.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <strings.h>
 #include <math.h>
 #include <errno.h>
+#include <string.h>
+#include <time.h>
 #include <netinet/arp.h>
 
 #include <nuttx/wireless/wireless.h>
@@ -1463,6 +1466,292 @@ void wapi_scan_coll_free(FAR struct wapi_list_s *list)
     }
 }
 
+/****************************************************************************
+ * Name: wapi_scan_cache_now
+ ****************************************************************************/
+
+static time_t wapi_scan_cache_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+/****************************************************************************
+ * Name: wapi_scan_cache_fresh
+ ****************************************************************************/
+
+static bool wapi_scan_cache_fresh(FAR const struct wapi_scan_cache_s *cache,
+                                  FAR const struct wapi_scan_info_s *info,
+                                  time_t now)
+{
+  return cache->maxage == 0 || now - info->seen <= (time_t)cache->maxage;
+}
+
+/****************************************************************************
+ * Name: wapi_scan_cache_match
+ ****************************************************************************/
+
+static bool wapi_scan_cache_match(FAR const struct wapi_scan_info_s *info,
+                                  FAR const char *essid)
+{
+  return essid == NULL ||
+         (info->has_essid && strcmp(info->essid, essid) == 0);
+}
+
+/****************************************************************************
+ * Name: wapi_scan_cache_init
+ *
+ * Description:
+ *   Initialize an empty scan cache whose entries expire after maxage
+ *   seconds.
+ *
+ ****************************************************************************/
+
+void wapi_scan_cache_init(FAR struct wapi_scan_cache_s *cache,
+                          unsigned int maxage)
+{
+  cache->head   = NULL;
+  cache->maxage = maxage;
+}
+
+/****************************************************************************
+ * Name: wapi_scan_cache_update
+ *
+ * Description:
+ *   Merge the results of wapi_scan_coll() into the cache and drop the
+ *   expired entries.
+ *
+ * Returned Value:
+ *   The number of entries in the cache; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int wapi_scan_cache_update(FAR struct wapi_scan_cache_s *cache,
+                           FAR struct wapi_list_s *aps)
+{
+  FAR struct wapi_scan_info_s **prev;
+  FAR struct wapi_scan_info_s *info;
+  FAR struct wapi_scan_info_s *next;
+  FAR struct wapi_scan_info_s *old;
+  time_t now;
+  int count = 0;
+
+  WAPI_VALIDATE_PTR(cache);
+  WAPI_VALIDATE_PTR(aps);
+
+  now = wapi_scan_cache_now();
+
+  /* Update the BSSs seen by this scan in place and add the new ones. */
+
+  for (info = aps->head.scan; info; info = next)
+    {
+      next = info->next;
+      info->seen = now;
+
+      for (old = cache->head; old; old = old->next)
+        {
+          if (memcmp(&old->ap, &info->ap, sizeof(old->ap)) == 0)
+            {
+              break;
+            }
+        }
+
+      if (old)
+        {
+          info->next = old->next;
+          *old = *info;
+          free(info);
+        }
+      else
+        {
+          info->next  = cache->head;
+          cache->head = info;
+        }
+    }
+
+  aps->head.scan = NULL;
+
+  /* Drop the BSSs that no scan has seen for too long. */
+
+  prev = &cache->head;
+  while ((info = *prev) != NULL)
+    {
+      if (wapi_scan_cache_fresh(cache, info, now))
+        {
+          prev = &info->next;
+          count++;
+        }
+      else
+        {
+          *prev = info->next;
+          free(info);
+        }
+    }
+
+  return count;
+}
+
+/****************************************************************************
+ * Name: wapi_scan_cache_refresh
+ *
+ * Description:
+ *   Merge the results of a scan if it has completed, without waiting.
+ *
+ * Returned Value:
+ *   The number of entries in the cache; 1 if the scan is still running; a
+ *   negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int wapi_scan_cache_refresh(int sock, FAR const char *ifname,
+                            FAR struct wapi_scan_cache_s *cache)
+{
+  struct wapi_list_s list;
+  int ret;
+
+  WAPI_VALIDATE_PTR(cache);
+
+  ret = wapi_scan_stat(sock, ifname);
+  if (ret != 0)
+    {
+      return ret;
+    }
+
+  bzero(&list, sizeof(struct wapi_list_s));
+  ret = wapi_scan_coll(sock, ifname, &list);
+  if (ret < 0)
+    {
+      wapi_scan_coll_free(&list);
+      return ret;
+    }
+
+  return wapi_scan_cache_update(cache, &list);
+}
+
+/****************************************************************************
+ * Name: wapi_scan_cache_best
+ *
+ * Description:
+ *   Return the unexpired entry with the strongest signal for essid, or any
+ *   ESSID if essid is NULL.
+ *
+ ****************************************************************************/
+
+FAR const struct wapi_scan_info_s *
+wapi_scan_cache_best(FAR const struct wapi_scan_cache_s *cache,
+                     FAR const char *essid)
+{
+  FAR const struct wapi_scan_info_s *best = NULL;
+  FAR const struct wapi_scan_info_s *info;
+  time_t now = wapi_scan_cache_now();
+
+  for (info = cache->head; info; info = info->next)
+    {
+      if (!wapi_scan_cache_fresh(cache, info, now) ||
+          !wapi_scan_cache_match(info, essid))
+        {
+          continue;
+        }
+
+      if (best == NULL ||
+          (info->has_rssi && (!best->has_rssi || info->rssi > best->rssi)))
+        {
+          best = info;
+        }
+    }
+
+  return best;
+}
+
+/****************************************************************************
+ * Name: wapi_scan_cache_channels
+ *
+ * Description:
+ *   Fill channels with the channels on which the cache has seen essid, or
+ *   any ESSID if essid is NULL.
+ *
+ * Returned Value:
+ *   The number of channels stored, at most nchannels.
+ *
+ ****************************************************************************/
+
+int wapi_scan_cache_channels(FAR const struct wapi_scan_cache_s *cache,
+                             FAR const char *essid,
+                             FAR uint8_t *channels, int nchannels)
+{
+  FAR const struct wapi_scan_info_s *info;
+  int count = 0;
+  int chan;
+  int i;
+
+  for (info = cache->head; info && count < nchannels; info = info->next)
+    {
+      if (!info->has_freq || !wapi_scan_cache_match(info, essid))
+        {
+          continue;
+        }
+
+      /* The inverse of the channel mapping of wapi_scan_event(). */
+
+      if (info->freq == 2484)
+        {
+          chan = 14;
+        }
+      else if (info->freq < 5000)
+        {
+          chan = ((int)info->freq - 2407) / 5;
+        }
+      else
+        {
+          chan = ((int)info->freq - 5000) / 5;
+        }
+
+      if (chan < 1 || chan > 165)
+        {
+          continue;
+        }
+
+      for (i = 0; i < count; i++)
+        {
+          if (channels[i] == chan)
+            {
+              break;
+            }
+        }
+
+      if (i == count)
+        {
+          channels[count++] = chan;
+        }
+    }
+
+  return count;
+}
+
+/****************************************************************************
+ * Name: wapi_scan_cache_free
+ *
+ * Description:
+ *   Free all the entries of the cache.
+ *
+ ****************************************************************************/
+
+void wapi_scan_cache_free(FAR struct wapi_scan_cache_s *cache)
+{
+  struct wapi_list_s list;
+
+  if (cache == NULL)
+    {
+      return;
+    }
+
+  list.head.scan = cache->head;
+  wapi_scan_coll_free(&list);
+  cache->head = NULL;
+}
+
 /****************************************************************************
  * Name: wapi_set_country
  *